@@ -35,10 +35,13 @@ endif
 
 XCAM_XCORE_SRC_FILES := \
     xcore/buffer_pool.cpp \
+    xcore/calibration_binary.cpp \
     xcore/calibration_parser.cpp \
     xcore/file_handle.cpp \
+    xcore/fisheye_table_cache.cpp \
     xcore/image_file_handle.cpp \
     xcore/image_handler.cpp \
+    xcore/quality_governor.cpp \
     xcore/surview_fisheye_dewarp.cpp \
     xcore/thread_pool.cpp \
     xcore/video_buffer.cpp \
@@ -47,6 +50,7 @@ XCAM_XCORE_SRC_FILES := \
     xcore/xcam_buffer.cpp \
     xcore/xcam_common.cpp \
     xcore/xcam_thread.cpp \
+    xcore/xcam_trace.cpp \
     xcore/xcam_utils.cpp \
     xcore/interface/blender.cpp \
     xcore/interface/feature_match.cpp \
@@ -55,12 +59,14 @@ XCAM_XCORE_SRC_FILES := \
     $(NULL)
 
 XCAM_SOFT_SRC_FILES := \
+    modules/soft/soft_analysis_tap.cpp \
     modules/soft/soft_blender.cpp \
     modules/soft/soft_blender_tasks_priv.cpp \
     modules/soft/soft_copy_task.cpp \
     modules/soft/soft_geo_mapper.cpp \
     modules/soft/soft_geo_tasks_priv.cpp \
     modules/soft/soft_handler.cpp \
+    modules/soft/soft_image_simd.cpp \
     modules/soft/soft_stitcher.cpp \
     modules/soft/soft_video_buf_allocator.cpp \
     modules/soft/soft_worker.cpp \
@@ -19,6 +19,13 @@
  */
 
 #include "context_priv.h"
+#include <dma_video_buffer.h>
+#include <calibration_binary.h>
+#include <soft/soft_video_buf_allocator.h>
+#if HAVE_LIBDRM
+#include <drm_bo_buffer.h>
+#endif
+#if HAVE_LIBCL
 #include <ocl/cl_device.h>
 #include <ocl/cl_image_handler.h>
 #include <ocl/cl_tonemapping_handler.h>
@@ -31,6 +38,16 @@
 #include <ocl/cl_fisheye_handler.h>
 #include <ocl/cl_image_360_stitch.h>
 #include <ocl/cl_utils.h>
+#include <ocl/cl_video_buffer.h>
+#endif
+#if HAVE_GLES
+#include <gles/gl_video_buffer.h>
+#endif
+#if HAVE_VULKAN
+#include <vulkan/vk_device.h>
+#include <vulkan/vk_video_buf_allocator.h>
+#include <vulkan/vk_geomap_handler.h>
+#endif
 
 using namespace XCam;
 
@@ -43,6 +60,14 @@ static const char *HandleNames[] = {
     "Defog",
     "DVS",
     "Stitch",
+    "GeoMap",
+};
+
+static const char *BackendNames[] = {
+    "cl",
+    "soft",
+    "gl",
+    "vk",
 };
 
 bool
@@ -51,22 +76,253 @@ handle_name_equal (const char *name, HandleType type)
     return !strncmp (name, HandleNames[type], strlen(HandleNames[type]));
 }
 
-ContextBase::ContextBase (HandleType type)
+bool
+parse_handle_backend (const char *name, HandleBackend &backend)
+{
+    const char *suffix = strchr (name, ':');
+    uint32_t i = 0;
+
+    backend = HandleBackendCL;
+    if (suffix) {
+        ++suffix;
+        for (; i < sizeof (BackendNames) / sizeof (BackendNames[0]); ++i) {
+            if (!strcasecmp (suffix, BackendNames[i]))
+                break;
+        }
+        XCAM_FAIL_RETURN (
+            ERROR, i < sizeof (BackendNames) / sizeof (BackendNames[0]), false,
+            "handle(%s) unknown backend, use cl, soft, gl or vk", name);
+        backend = (HandleBackend)i;
+    }
+
+    bool supported = true;
+    switch (backend) {
+    case HandleBackendCL:
+        supported = HAVE_LIBCL;
+        break;
+    case HandleBackendGL:
+        supported = HAVE_GLES;
+        break;
+    case HandleBackendVK:
+        supported = HAVE_VULKAN;
+        break;
+    default:
+        break;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, supported, false,
+        "handle(%s) backend(%s) is not built in", name, BackendNames[backend]);
+
+    return true;
+}
+
+class ContextThread
+    : public Thread
+{
+public:
+    explicit ContextThread (ContextBase *context)
+        : Thread (context->get_type_name ())
+        , _context (context)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _context->process_next_job ();
+    }
+
+private:
+    ContextBase   *_context;
+};
+
+HandleJob::HandleJob ()
+    : in_count (0)
+    , buf_out (NULL)
+    , callback (NULL)
+    , user_data (NULL)
+    , kind (Execute)
+    , done (false)
+    , result (XCAM_RETURN_NO_ERROR)
+{
+    xcam_mem_clear (bufs_in);
+}
+
+class HostPtrVideoBuffer
+    : public VideoBuffer
+{
+public:
+    HostPtrVideoBuffer (const VideoBufferInfo &info, uint8_t *ptr)
+        : VideoBuffer (info)
+        , _ptr (ptr)
+    {}
+
+    uint8_t *get_ptr () const {
+        return _ptr;
+    }
+
+    virtual uint8_t *map () {
+        return _ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    XCAM_DEAD_COPY (HostPtrVideoBuffer);
+
+private:
+    uint8_t    *_ptr;
+};
+
+static bool
+import_info_is_valid (const XCamVideoBufferInfo *info)
+{
+    return info && info->width && info->height && info->size && info->components &&
+           info->components <= XCAM_VIDEO_MAX_COMPONENTS;
+}
+
+XCamVideoBuffer *
+import_dma_fd_buffer (const XCamVideoBufferInfo *info, int fd)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, import_info_is_valid (info) && fd >= 0, NULL,
+        "xcam import dma fd:%d failed, invalid buffer info", fd);
+
+    VideoBufferInfo buf_info;
+    *(XCamVideoBufferInfo *)&buf_info = *info;
+    SmartPtr<VideoBuffer> buf = new DmaVideoBuffer (buf_info, fd);
+    return convert_to_external_buffer (buf);
+}
+
+XCamVideoBuffer *
+import_host_ptr_buffer (const XCamVideoBufferInfo *info, uint8_t *ptr)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, import_info_is_valid (info) && ptr, NULL,
+        "xcam import host pointer failed, invalid buffer info or pointer");
+
+    VideoBufferInfo buf_info;
+    *(XCamVideoBufferInfo *)&buf_info = *info;
+    SmartPtr<VideoBuffer> buf = new HostPtrVideoBuffer (buf_info, ptr);
+    return convert_to_external_buffer (buf);
+}
+
+static void
+copy_planes (
+    const XCamVideoBufferInfo &src_info, const uint8_t *src,
+    const XCamVideoBufferInfo &dest_info, uint8_t *dest)
+{
+    for (uint32_t i = 0; i < src_info.components && i < dest_info.components; ++i) {
+        XCamVideoBufferPlanarInfo src_planar, dest_planar;
+        xcam_video_buffer_get_planar_info (&src_info, &src_planar, i);
+        xcam_video_buffer_get_planar_info (&dest_info, &dest_planar, i);
+
+        uint32_t rows = XCAM_MIN (src_planar.height, dest_planar.height);
+        uint32_t row_bytes = XCAM_MIN (src_planar.width, dest_planar.width) * dest_planar.pixel_bytes;
+        const uint8_t *p_src = src + src_info.offsets[i];
+        uint8_t *p_dest = dest + dest_info.offsets[i];
+        for (uint32_t y = 0; y < rows; ++y) {
+            memcpy (p_dest, p_src, row_bytes);
+            p_src += src_info.strides[i];
+            p_dest += dest_info.strides[i];
+        }
+    }
+}
+
+static SmartPtr<VideoBuffer>
+external_buf_to_drm_buf (XCamVideoBuffer *buf)
+{
+#if HAVE_LIBDRM
+    SmartPtr<DrmDisplay> display = DrmDisplay::instance ();
+    SmartPtr<DmaVideoBuffer> dma_buf;
+    SmartPtr<VideoBuffer> drm_buf;
+    SmartPtr<VideoBuffer> video_buf;
+
+    dma_buf = external_buf_to_dma_buf (buf);
+
+    XCAM_FAIL_RETURN (
+        ERROR, dma_buf.ptr (), NULL,
+        "external_buf_to_drm_buf failed");
+
+    video_buf = dma_buf;
+    XCAM_ASSERT (display.ptr ());
+    drm_buf = display->convert_to_drm_bo_buf (display, video_buf);
+    return drm_buf;
+#else
+    XCAM_LOG_ERROR ("VideoBuffer doesn't support drm buf");
+
+    XCAM_UNUSED (buf);
+    return NULL;
+#endif
+}
+
+static SmartPtr<VideoBuffer>
+copy_external_buf_to_pool_buf (const SmartPtr<BufferPool> &buf_pool, XCamVideoBuffer *buf)
+{
+    XCAM_ASSERT (buf_pool.ptr () && buf);
+
+    uint8_t *src = buf->map (buf);
+    XCAM_FAIL_RETURN (
+        WARNING, src, NULL,
+        "xcam handle map buffer failed");
+
+    SmartPtr<VideoBuffer> video_buf = buf_pool->get_buffer (buf_pool);
+    uint8_t *dest = video_buf.ptr () ? video_buf->map () : NULL;
+    if (!dest) {
+        buf->unmap (buf);
+        XCAM_LOG_WARNING ("xcam handle get input buffer from pool failed");
+        return NULL;
+    }
+
+    copy_planes (buf->info, src, video_buf->get_video_info (), dest);
+    video_buf->set_timestamp (buf->timestamp);
+
+    buf->unmap (buf);
+    video_buf->unmap ();
+    return video_buf;
+}
+
+static XCamReturn
+copy_buf_to_external_buf (const SmartPtr<VideoBuffer> &from, XCamVideoBuffer *to)
+{
+    uint8_t *dest = to->map (to);
+    XCAM_FAIL_RETURN (
+        WARNING, dest, XCAM_RETURN_ERROR_MEM,
+        "xcam handle map output buffer failed");
+
+    uint8_t *src = from->map ();
+    if (!src) {
+        to->unmap (to);
+        XCAM_LOG_WARNING ("xcam handle map result buffer failed");
+        return XCAM_RETURN_ERROR_MEM;
+    }
+
+    copy_planes (from->get_video_info (), src, to->info, dest);
+    to->timestamp = from->get_timestamp ();
+
+    from->unmap ();
+    to->unmap (to);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+ContextBase::ContextBase (HandleType type, HandleBackend backend)
     : _type (type)
+    , _backend (backend)
     , _usage (NULL)
     , _image_width (0)
     , _image_height (0)
     , _alloc_out_buf (false)
+    , _inflight_depth (XCAM_HANDLE_DEFAULT_INFLIGHT)
+    , _inflight (0)
 {
-    if (!_inbuf_pool.ptr()) {
-        SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
-        XCAM_ASSERT (pool.ptr ());
-        _inbuf_pool = pool;
-    }
 }
 
 ContextBase::~ContextBase ()
 {
+    // xcam_destroy_handle uninits first, derived handlers are gone by now
+    XCAM_ASSERT (!_thread.ptr ());
     xcam_free (_usage);
 }
 
@@ -89,8 +345,6 @@ find_value (const ContextParams &param_list, const char *name)
 XCamReturn
 ContextBase::set_parameters (ContextParams &param_list)
 {
-    VideoBufferInfo buf_info;
-    uint32_t image_format = V4L2_PIX_FMT_NV12;
     _image_width = 1920;
     _image_height = 1080;
 
@@ -107,24 +361,420 @@ ContextBase::set_parameters (ContextParams &param_list)
         return XCAM_RETURN_ERROR_PARAM;
     }
 
-    buf_info.init (image_format, _image_width, _image_height);
-    _inbuf_pool->set_video_info (buf_info);
-    if (!_inbuf_pool->reserve (DEFAULT_INPUT_BUFFER_POOL_COUNT)) {
-        XCAM_LOG_ERROR ("init buffer pool failed");
-        return XCAM_RETURN_ERROR_MEM;
-    }
-
     const char *flag = find_value (param_list, "alloc-out-buf");
     if (flag && !strncasecmp (flag, "true", strlen("true"))) {
         _alloc_out_buf = true;
     } else {
         _alloc_out_buf = false;
     }
+
+    const char *depth = find_value (param_list, "inflight-depth");
+    if (depth) {
+        int value = atoi (depth);
+        XCAM_FAIL_RETURN (
+            ERROR, value > 0, XCAM_RETURN_ERROR_PARAM,
+            "context(%s) illegal inflight-depth:%s", get_type_name (), depth);
+        _inflight_depth = value;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::create_input_pool ()
+{
+    VideoBufferInfo buf_info;
+    buf_info.init (V4L2_PIX_FMT_NV12, _image_width, _image_height);
+
+    // async jobs hold their input copies until done
+    uint32_t count = (_inflight_depth + 1) * get_input_count ();
+    SmartPtr<BufferPool> pool;
+    switch (_backend) {
+    case HandleBackendCL:
+#if HAVE_LIBCL
+        pool = new CLVideoBufferPool ();
+        count = XCAM_MAX (count, DEFAULT_INPUT_BUFFER_POOL_COUNT);
+#endif
+        break;
+    case HandleBackendSoft:
+        pool = new SoftVideoBufAllocator ();
+        break;
+    case HandleBackendGL:
+#if HAVE_GLES
+        pool = new GLVideoBufferPool ();
+#endif
+        break;
+    case HandleBackendVK:
+#if HAVE_VULKAN
+        pool = new VKVideoBufAllocator (VKDevice::default_device ());
+#endif
+        break;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, pool.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "context(%s) backend(%s) has no buffer pool", get_type_name (), BackendNames[_backend]);
+
+    pool->set_video_info (buf_info);
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
+        XCAM_LOG_ERROR ("init buffer pool failed");
+        return XCAM_RETURN_ERROR_MEM;
+    }
+
+    _inbuf_pool = pool;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ContextBase::init_on_thread ()
+{
+#if HAVE_GLES
+    if (_backend == HandleBackendGL) {
+        _egl = new EGLBase ();
+        XCAM_FAIL_RETURN (
+            ERROR, _egl->init (), XCAM_RETURN_ERROR_GLES,
+            "context(%s) init EGL failed", get_type_name ());
+    }
+#endif
+
+    XCamReturn ret = create_input_pool ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "context(%s) create input buffer pool failed", get_type_name ());
+
+    ret = setup_handler ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "context(%s) create handler failed", get_type_name ());
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+ContextBase::release_on_thread ()
+{
+    release_handler ();
+    _inbuf_pool.release ();
+#if HAVE_GLES
+    _egl.release ();
+#endif
+}
+
+XCamReturn
+ContextBase::run_sync_on_thread (const SmartPtr<HandleJob> &job)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _jobs.push (job), XCAM_RETURN_ERROR_THREAD,
+        "context(%s) push job failed", get_type_name ());
+
+    SmartLock locker (_job_mutex);
+    while (!job->done)
+        _job_cond.wait (_job_mutex);
+    return job->result;
+}
+
 XCamReturn
 ContextBase::init_handler ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "context(%s) init failed, already initialized", get_type_name ());
+
+    _inflight = 0;
+    _jobs.resume_pop ();
+    _thread = new ContextThread (this);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "context(%s) start worker thread failed", get_type_name ());
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_backend == HandleBackendGL) {
+        SmartPtr<HandleJob> job = new HandleJob;
+        job->kind = HandleJob::Init;
+        ret = run_sync_on_thread (job);
+    } else {
+        ret = init_on_thread ();
+    }
+
+    if (!xcam_ret_is_ok (ret))
+        uinit_handler ();
+    return ret;
+}
+
+XCamReturn
+ContextBase::uinit_handler ()
+{
+    if (!_thread.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    {
+        SmartLock locker (_job_mutex);
+        while (_inflight)
+            _job_cond.wait (_job_mutex);
+    }
+
+    if (_backend == HandleBackendGL) {
+        SmartPtr<HandleJob> job = new HandleJob;
+        job->kind = HandleJob::Uninit;
+        run_sync_on_thread (job);
+    } else {
+        release_on_thread ();
+    }
+
+    _jobs.pause_pop ();
+    _thread->stop ();
+    _thread.release ();
+    _jobs.clear ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<VideoBuffer>
+ContextBase::import_to_backend (const SmartPtr<VideoBuffer> &buf)
+{
+    switch (_backend) {
+    case HandleBackendSoft:
+        // soft handlers only map buffers
+        return buf;
+#if HAVE_LIBCL
+    case HandleBackendCL: {
+        if (buf.dynamic_cast_ptr<CLVideoBuffer> ().ptr ())
+            return buf;
+        if (buf.dynamic_cast_ptr<DmaVideoBuffer> ().ptr ())
+            return CLVideoBuffer::import_dma_buffer (buf->get_video_info (), buf);
+
+        SmartPtr<HostPtrVideoBuffer> host_buf = buf.dynamic_cast_ptr<HostPtrVideoBuffer> ();
+        if (host_buf.ptr ())
+            return CLVideoBuffer::import_host_ptr (host_buf->get_video_info (), host_buf->get_ptr ());
+        break;
+    }
+#endif
+    default:
+        // GL and vulkan handlers use their own memory
+        break;
+    }
+
+    return NULL;
+}
+
+SmartPtr<VideoBuffer>
+ContextBase::convert_input (XCamVideoBuffer *buf)
+{
+    // imported or previous output buffers, copy only if backend can't use them
+    SmartPtr<VideoBuffer> video_buf = external_buf_to_video_buf (buf);
+    if (video_buf.ptr ()) {
+        SmartPtr<VideoBuffer> imported = import_to_backend (video_buf);
+        if (imported.ptr ())
+            return imported;
+    }
+
+    if (buf->mem_type == XCAM_MEM_TYPE_GPU) {
+        if (_backend == HandleBackendCL)
+            return external_buf_to_drm_buf (buf);
+        if (_backend == HandleBackendSoft)
+            return external_buf_to_dma_buf (buf);
+    }
+
+    return copy_external_buf_to_pool_buf (_inbuf_pool, buf);
+}
+
+SmartPtr<VideoBuffer>
+ContextBase::convert_output (XCamVideoBuffer *buf)
+{
+    // NULL lets result be copied out if backend can't use imported buffer
+    SmartPtr<VideoBuffer> video_buf = external_buf_to_video_buf (buf);
+    if (video_buf.ptr ())
+        return import_to_backend (video_buf);
+
+    if (_backend == HandleBackendCL)
+        return external_buf_to_drm_buf (buf);
+    if (_backend == HandleBackendSoft && buf->mem_type == XCAM_MEM_TYPE_GPU)
+        return external_buf_to_dma_buf (buf);
+
+    // GL and vulkan render to own buffers, result is copied out
+    return NULL;
+}
+
+XCamReturn
+ContextBase::run_job (const SmartPtr<HandleJob> &job, XCamVideoBuffer **result)
+{
+    VideoBufferList in_bufs;
+    for (uint32_t i = 0; i < job->in_count; ++i) {
+        SmartPtr<VideoBuffer> input = convert_input (job->bufs_in[i]);
+        XCAM_FAIL_RETURN (
+            ERROR, input.ptr (), XCAM_RETURN_ERROR_MEM,
+            "xcam_handle(%s) execute failed, buf_in(idx:%d) convert failed.", get_type_name (), i);
+        in_bufs.push_back (input);
+    }
+
+    SmartPtr<VideoBuffer> output;
+    bool copy_out = false;
+    if (job->buf_out) {
+        output = convert_output (job->buf_out);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            output.ptr () || _backend != HandleBackendCL || external_buf_to_video_buf (job->buf_out).ptr (),
+            XCAM_RETURN_ERROR_MEM,
+            "xcam_handle(%s) execute failed, buf_out set but convert to DRM buffer failed.",
+            get_type_name ());
+        copy_out = !output.ptr ();
+    }
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    {
+        // sync and async calls share the handler
+        SmartLock locker (_exec_mutex);
+        ret = process (in_bufs, output);
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS,
+        ret,
+        "context (%s) failed, handler execute failed", get_type_name ());
+
+    *result = job->buf_out;
+    if (copy_out && output.ptr ()) {
+        XCamReturn copy_ret = copy_buf_to_external_buf (output, job->buf_out);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (copy_ret), copy_ret,
+            "xcam_handle(%s) execute failed, copy result to buf_out failed.", get_type_name ());
+    } else if (!job->buf_out && output.ptr ()) {
+        XCamVideoBuffer *new_buf = convert_to_external_buffer (output);
+        XCAM_FAIL_RETURN (
+            ERROR, new_buf, XCAM_RETURN_ERROR_MEM,
+            "xcam_handle(%s) execute failed, out buffer can't convert to external buffer.",
+            get_type_name ());
+        *result = new_buf;
+    }
+    return ret;
+}
+
+XCamReturn
+ContextBase::execute (XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer **buf_out)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, is_handler_inited (), XCAM_RETURN_ERROR_PARAM,
+        "context (%s) failed, handler was not initialized", get_type_name ());
+    XCAM_FAIL_RETURN (
+        ERROR, in_count == get_input_count () && in_count <= XCAM_HANDLE_MAX_INPUTS, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) execute failed, needs %d input buffers but got %d",
+        get_type_name (), get_input_count (), in_count);
+
+    SmartPtr<HandleJob> job = new HandleJob;
+    for (uint32_t i = 0; i < in_count; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, bufs_in[i], XCAM_RETURN_ERROR_PARAM,
+            "context (%s) execute failed, buf_in(idx:%d) is NULL", get_type_name (), i);
+        job->bufs_in[i] = bufs_in[i];
+    }
+    job->in_count = in_count;
+    job->buf_out = *buf_out;
+
+    if (_backend != HandleBackendGL)
+        return run_job (job, buf_out);
+
+    XCamReturn ret = run_sync_on_thread (job);
+    if (xcam_ret_is_ok (ret))
+        *buf_out = job->buf_out;
+    return ret;
+}
+
+XCamReturn
+ContextBase::execute_async (
+    XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer *buf_out,
+    XCamHandleDoneCallback callback, void *user_data)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, is_handler_inited () && callback, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) execute async failed, %s", get_type_name (),
+        (callback ? "handler was not initialized" : "callback is NULL"));
+    XCAM_FAIL_RETURN (
+        ERROR, in_count == get_input_count () && in_count <= XCAM_HANDLE_MAX_INPUTS, XCAM_RETURN_ERROR_PARAM,
+        "context (%s) execute async failed, needs %d input buffers but got %d",
+        get_type_name (), get_input_count (), in_count);
+    for (uint32_t i = 0; i < in_count; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, bufs_in[i], XCAM_RETURN_ERROR_PARAM,
+            "context (%s) execute async failed, buf_in(idx:%d) is NULL", get_type_name (), i);
+    }
+
+    {
+        SmartLock locker (_job_mutex);
+        if (_inflight >= _inflight_depth) {
+            XCAM_LOG_DEBUG ("context (%s) has %d jobs inflight, try later", get_type_name (), _inflight);
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        }
+        ++_inflight;
+    }
+
+    SmartPtr<HandleJob> job = new HandleJob;
+    for (uint32_t i = 0; i < in_count; ++i) {
+        job->bufs_in[i] = bufs_in[i];
+        xcam_video_buffer_ref (bufs_in[i]);
+    }
+    job->in_count = in_count;
+    job->buf_out = buf_out;
+    if (buf_out)
+        xcam_video_buffer_ref (buf_out);
+    job->callback = callback;
+    job->user_data = user_data;
+
+    if (!_jobs.push (job)) {
+        for (uint32_t i = 0; i < in_count; ++i)
+            xcam_video_buffer_unref (bufs_in[i]);
+        if (buf_out)
+            xcam_video_buffer_unref (buf_out);
+
+        SmartLock locker (_job_mutex);
+        --_inflight;
+        _job_cond.broadcast ();
+        XCAM_LOG_ERROR ("context (%s) push async job failed", get_type_name ());
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+ContextBase::process_next_job ()
+{
+    SmartPtr<HandleJob> job = _jobs.pop (-1);
+    if (!job.ptr ())
+        return false;
+
+    if (!job->callback) {
+        XCamReturn ret = XCAM_RETURN_NO_ERROR;
+        if (job->kind == HandleJob::Init) {
+            ret = init_on_thread ();
+        } else if (job->kind == HandleJob::Uninit) {
+            release_on_thread ();
+        } else {
+            XCamVideoBuffer *result = NULL;
+            ret = run_job (job, &result);
+            job->buf_out = result;
+        }
+
+        SmartLock locker (_job_mutex);
+        job->result = ret;
+        job->done = true;
+        _job_cond.broadcast ();
+        return true;
+    }
+
+    XCamVideoBuffer *result = NULL;
+    XCamReturn ret = run_job (job, &result);
+    for (uint32_t i = 0; i < job->in_count; ++i)
+        xcam_video_buffer_unref (job->bufs_in[i]);
+
+    job->callback (HANDLE_CAST (this), ret, (xcam_ret_is_ok (ret) ? result : NULL), job->user_data);
+    if (job->buf_out)
+        xcam_video_buffer_unref (job->buf_out);
+
+    SmartLock locker (_job_mutex);
+    --_inflight;
+    _job_cond.broadcast ();
+    return true;
+}
+
+#if HAVE_LIBCL
+XCamReturn
+CLContextBase::setup_handler ()
 {
     SmartPtr<CLContext> cl_context = CLDevice::instance()->get_context ();
     XCAM_FAIL_RETURN (
@@ -138,23 +788,22 @@ ContextBase::init_handler ()
         "ContextBase::init_handler(%s) create handler failed", get_type_name ());
 
     handler->disable_buf_pool (!_alloc_out_buf);
-    set_handler (handler);
+    _handler = handler;
     return XCAM_RETURN_NO_ERROR;
 }
 
-XCamReturn
-ContextBase::uinit_handler ()
+void
+CLContextBase::release_handler ()
 {
     if (!_handler.ptr ())
-        return XCAM_RETURN_NO_ERROR;
+        return;
 
     _handler->emit_stop ();
     _handler.release ();
-    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-ContextBase::execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out)
+CLContextBase::process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out)
 {
     if (!_alloc_out_buf) {
         XCAM_FAIL_RETURN (
@@ -166,6 +815,7 @@ ContextBase::execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_
             "context (%s) execute failed, buf_out need NULL.", get_type_name ());
     }
 
+    SmartPtr<VideoBuffer> buf_in = in_bufs.front ();
     return _handler->execute (buf_in, buf_out);
 }
 
@@ -230,3 +880,235 @@ StitchContext::create_handler (SmartPtr<CLContext> &context)
     return image_360;
 }
 
+#endif
+
+SurroundStitchContext::SurroundStitchContext (HandleBackend backend)
+    : ContextBase (HandleTypeStitch, backend)
+    , _camera_num (4)
+    , _out_width (1920)
+    , _out_height (640)
+{
+    xcam_mem_clear (_view_ranges);
+}
+
+XCamReturn
+SurroundStitchContext::set_parameters (ContextParams &param_list)
+{
+    static const float default_ranges[] = {64.0f, 160.0f, 64.0f, 160.0f};
+
+    XCamReturn ret = ContextBase::set_parameters (param_list);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "context(%s) set parameters failed", get_type_name ());
+
+    const char *value = find_value (param_list, "camera-num");
+    if (value)
+        _camera_num = atoi (value);
+    XCAM_FAIL_RETURN (
+        ERROR, _camera_num > 0 && _camera_num <= XCAM_HANDLE_MAX_INPUTS, XCAM_RETURN_ERROR_PARAM,
+        "context(%s) illegal camera-num:%d", get_type_name (), _camera_num);
+
+    value = find_value (param_list, "out-width");
+    if (value)
+        _out_width = atoi (value);
+    value = find_value (param_list, "out-height");
+    if (value)
+        _out_height = atoi (value);
+    XCAM_FAIL_RETURN (
+        ERROR, _out_width && _out_height, XCAM_RETURN_ERROR_PARAM,
+        "context(%s) illegal output size width:%d height:%d", get_type_name (), _out_width, _out_height);
+
+    value = find_value (param_list, "calib-binary");
+    XCAM_FAIL_RETURN (
+        ERROR, value, XCAM_RETURN_ERROR_PARAM,
+        "context(%s) needs calib-binary, see CalibrationBinary::convert_text_files", get_type_name ());
+    _calib_path = value;
+
+    // comma separated horizontal view angle of each camera, in degree
+    value = find_value (param_list, "view-ranges");
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        if (_camera_num == sizeof (default_ranges) / sizeof (default_ranges[0]))
+            _view_ranges[i] = default_ranges[i];
+        else
+            _view_ranges[i] = 360.0f / _camera_num;
+    }
+    for (uint32_t i = 0; value && i < _camera_num; ++i) {
+        _view_ranges[i] = atof (value);
+        value = strchr (value, ',');
+        if (value)
+            ++value;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SurroundStitchContext::setup_handler ()
+{
+    SmartPtr<CalibrationBinary> binary = new CalibrationBinary ();
+    XCamReturn ret = binary->load (_calib_path.c_str ());
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "context(%s) load calibration binary(%s) failed", get_type_name (), _calib_path.c_str ());
+    XCAM_FAIL_RETURN (
+        ERROR, binary->get_camera_count () >= _camera_num, XCAM_RETURN_ERROR_PARAM,
+        "context(%s) calibration binary has %d cameras, need %d",
+        get_type_name (), binary->get_camera_count (), _camera_num);
+
+    SmartPtr<Stitcher> stitcher;
+    switch (_backend) {
+    case HandleBackendSoft:
+        stitcher = Stitcher::create_soft_stitcher ();
+        break;
+    case HandleBackendGL:
+#if HAVE_GLES
+        stitcher = Stitcher::create_gl_stitcher ();
+#endif
+        break;
+    case HandleBackendVK:
+#if HAVE_VULKAN
+        stitcher = Stitcher::create_vk_stitcher ();
+#endif
+        break;
+    default:
+        break;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, stitcher.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "context(%s) create stitcher failed", get_type_name ());
+
+    stitcher->set_camera_num (_camera_num);
+    for (uint32_t i = 0; i < _camera_num; ++i) {
+        CameraInfo info;
+        ret = binary->get_calibration (i, info.calibration);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "context(%s) get calibration(idx:%d) failed", get_type_name (), i);
+        info.angle_range = _view_ranges[i];
+        info.round_angle_start = (i * 360.0f / _camera_num) - info.angle_range / 2.0f;
+        stitcher->set_camera_info (i, info);
+    }
+
+    BowlDataConfig bowl;
+    bowl.wall_height = 3000.0f;
+    bowl.ground_length = 2000.0f;
+    bowl.angle_start = 0.0f;
+    bowl.angle_end = 360.0f;
+    stitcher->set_bowl_config (bowl);
+    stitcher->set_output_size (_out_width, _out_height);
+    stitcher->set_calibration_binary (binary);
+
+    _stitcher = stitcher;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SurroundStitchContext::release_handler ()
+{
+    _stitcher.release ();
+}
+
+XCamReturn
+SurroundStitchContext::process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out)
+{
+    return _stitcher->stitch_buffers (in_bufs, buf_out);
+}
+
+GeoMapContext::GeoMapContext (HandleBackend backend)
+    : ContextBase (HandleTypeGeoMap, backend)
+    , _out_width (0)
+    , _out_height (0)
+    , _lut_width (0)
+    , _lut_height (0)
+{
+}
+
+XCamReturn
+GeoMapContext::set_parameters (ContextParams &param_list)
+{
+    XCamReturn ret = ContextBase::set_parameters (param_list);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "context(%s) set parameters failed", get_type_name ());
+
+    _out_width = _image_width;
+    _out_height = _image_height;
+    const char *value = find_value (param_list, "out-width");
+    if (value)
+        _out_width = atoi (value);
+    value = find_value (param_list, "out-height");
+    if (value)
+        _out_height = atoi (value);
+
+    value = find_value (param_list, "lut-width");
+    if (value)
+        _lut_width = atoi (value);
+    value = find_value (param_list, "lut-height");
+    if (value)
+        _lut_height = atoi (value);
+
+    value = find_value (param_list, "lut-file");
+    XCAM_FAIL_RETURN (
+        ERROR, value && _lut_width && _lut_height && _out_width && _out_height, XCAM_RETURN_ERROR_PARAM,
+        "context(%s) needs lut-file, lut-width and lut-height, output size must be non-zero", get_type_name ());
+    _lut_path = value;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GeoMapContext::setup_handler ()
+{
+    std::vector<PointFloat2> lut (_lut_width * _lut_height);
+    FILE *fp = fopen (_lut_path.c_str (), "rb");
+    XCAM_FAIL_RETURN (
+        ERROR, fp, XCAM_RETURN_ERROR_FILE,
+        "context(%s) open lut-file(%s) failed", get_type_name (), _lut_path.c_str ());
+    size_t count = fread (lut.data (), sizeof (PointFloat2), lut.size (), fp);
+    fclose (fp);
+    XCAM_FAIL_RETURN (
+        ERROR, count == lut.size (), XCAM_RETURN_ERROR_FILE,
+        "context(%s) lut-file(%s) holds less than %dx%d points",
+        get_type_name (), _lut_path.c_str (), _lut_width, _lut_height);
+
+    SmartPtr<GeoMapper> mapper;
+    switch (_backend) {
+    case HandleBackendCL:
+#if HAVE_LIBCL
+        mapper = GeoMapper::create_ocl_geo_mapper ();
+#endif
+        break;
+    case HandleBackendSoft:
+        mapper = GeoMapper::create_soft_geo_mapper ();
+        break;
+    case HandleBackendGL:
+#if HAVE_GLES
+        mapper = GeoMapper::create_gl_geo_mapper ();
+#endif
+        break;
+    case HandleBackendVK:
+#if HAVE_VULKAN
+        mapper = new VKGeoMapHandler (VKDevice::default_device ());
+#endif
+        break;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, mapper.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "context(%s) create geo mapper failed", get_type_name ());
+
+    mapper->set_output_size (_out_width, _out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, mapper->set_lookup_table (lut.data (), _lut_width, _lut_height), XCAM_RETURN_ERROR_PARAM,
+        "context(%s) set lookup table failed", get_type_name ());
+
+    _mapper = mapper;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+GeoMapContext::release_handler ()
+{
+    _mapper.release ();
+}
+
+XCamReturn
+GeoMapContext::process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out)
+{
+    return _mapper->remap (in_bufs.front (), buf_out);
+}
@@ -23,10 +23,22 @@
 
 #include <xcam_utils.h>
 #include <string.h>
+#include <xcam_handle.h>
+#include <buffer_pool.h>
+#include <xcam_thread.h>
+#include <safe_list.h>
+#include <interface/stitcher.h>
+#include <interface/geo_mapper.h>
+#include <map>
+#include <string>
+#if HAVE_GLES
+#include <gles/egl/egl_base.h>
+#endif
+#if HAVE_LIBCL
 #include <ocl/cl_image_handler.h>
 #include <ocl/cl_context.h>
 #include <ocl/cl_blender.h>
-#include <interface/stitcher.h>
+#endif
 
 using namespace XCam;
 
@@ -38,13 +50,30 @@ enum HandleType {
     HandleTypeDefog,
     HandleTypeDVS,
     HandleTypeStitch,
+    HandleTypeGeoMap,
+};
+
+// selected by handle name suffix, e.g. "Stitch:soft", no suffix means OpenCL
+enum HandleBackend {
+    HandleBackendCL = 0,
+    HandleBackendSoft,
+    HandleBackendGL,
+    HandleBackendVK,
 };
 
 #define CONTEXT_CAST(Type, handle) (Type*)(handle)
 #define CONTEXT_BASE_CAST(handle) (ContextBase*)(handle)
 #define HANDLE_CAST(context) (XCamHandle*)(context)
 
+#define XCAM_HANDLE_MAX_INPUTS 8
+#define XCAM_HANDLE_DEFAULT_INFLIGHT 2
+
 bool handle_name_equal (const char *name, HandleType type);
+bool parse_handle_backend (const char *name, HandleBackend &backend);
+
+// wrap caller memory without copy, memory must stay valid till the returned buffer is unref'ed
+XCamVideoBuffer *import_dma_fd_buffer (const XCamVideoBufferInfo *info, int fd);
+XCamVideoBuffer *import_host_ptr_buffer (const XCamVideoBufferInfo *info, uint8_t *ptr);
 
 typedef struct _CompareStr {
     bool operator() (const char* str1, const char* str2) const {
@@ -54,7 +83,36 @@ typedef struct _CompareStr {
 
 typedef std::map<const char*, const char*, CompareStr> ContextParams;
 
+class ContextThread;
+
+// external buffers of one execute call, input buffers are referenced until done
+struct HandleJob {
+    XCamVideoBuffer         *bufs_in[XCAM_HANDLE_MAX_INPUTS];
+    uint32_t                 in_count;
+    XCamVideoBuffer         *buf_out;
+    XCamHandleDoneCallback   callback;
+    void                    *user_data;
+    uint32_t                 kind;
+    bool                     done;
+    XCamReturn               result;
+
+    enum {
+        Execute = 0,
+        Init,
+        Uninit,
+    };
+
+    HandleJob ();
+};
+
+/*
+ * ContextBase, backend independent part of xcam handle.
+ * each initialized handle owns a worker thread running async jobs in order;
+ * GL handles also init and run sync jobs on it since EGL context is current there.
+ */
 class ContextBase {
+    friend class ContextThread;
+
 public:
     virtual ~ContextBase ();
 
@@ -64,11 +122,17 @@ public:
     }
     XCamReturn init_handler ();
     XCamReturn uinit_handler ();
+    virtual bool is_handler_inited () const = 0;
 
-    XCamReturn execute (SmartPtr<VideoBuffer> &buf_in, SmartPtr<VideoBuffer> &buf_out);
+    // bufs_in holds get_input_count () buffers
+    XCamReturn execute (XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer **buf_out);
+    // return XCAM_RETURN_ERROR_TIMEOUT if inflight-depth jobs are pending, retry after a callback
+    XCamReturn execute_async (
+        XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer *buf_out,
+        XCamHandleDoneCallback callback, void *user_data);
 
-    SmartPtr<CLImageHandler> get_handler() const {
-        return  _handler;
+    virtual uint32_t get_input_count () const {
+        return 1;
     }
     SmartPtr<BufferPool> get_input_buffer_pool() const {
         return  _inbuf_pool;
@@ -76,94 +140,146 @@ public:
     HandleType get_type () const {
         return _type;
     }
+    HandleBackend get_backend () const {
+        return _backend;
+    }
     const char* get_type_name () const;
 
 protected:
-    ContextBase (HandleType type);
-    void set_handler (const SmartPtr<CLImageHandler> &ptr) {
-        _handler = ptr;
-    }
+    ContextBase (HandleType type, HandleBackend backend = HandleBackendCL);
 
-    virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context) = 0;
+    virtual XCamReturn setup_handler () = 0;
+    virtual void release_handler () = 0;
+    virtual XCamReturn process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out) = 0;
 
 private:
+    XCamReturn init_on_thread ();
+    void release_on_thread ();
+    XCamReturn create_input_pool ();
+    SmartPtr<VideoBuffer> convert_input (XCamVideoBuffer *buf);
+    SmartPtr<VideoBuffer> convert_output (XCamVideoBuffer *buf);
+    SmartPtr<VideoBuffer> import_to_backend (const SmartPtr<VideoBuffer> &buf);
+    XCamReturn run_job (const SmartPtr<HandleJob> &job, XCamVideoBuffer **result);
+    XCamReturn run_sync_on_thread (const SmartPtr<HandleJob> &job);
+    bool process_next_job ();
+
     XCAM_DEAD_COPY (ContextBase);
 
 protected:
     HandleType                       _type;
+    HandleBackend                    _backend;
     char                            *_usage;
-    SmartPtr<CLImageHandler>         _handler;
     SmartPtr<BufferPool>             _inbuf_pool;
 
     //parameters
     uint32_t                         _image_width;
     uint32_t                         _image_height;
     bool                             _alloc_out_buf;
+    uint32_t                         _inflight_depth;
+
+private:
+    SmartPtr<ContextThread>          _thread;
+    SafeList<HandleJob>              _jobs;
+    Mutex                            _job_mutex;
+    Cond                             _job_cond;
+    uint32_t                         _inflight;
+    Mutex                            _exec_mutex;
+#if HAVE_GLES
+    SmartPtr<EGLBase>                _egl;
+#endif
 };
 
-class NR3DContext
+#if HAVE_LIBCL
+class CLContextBase
     : public ContextBase
 {
+public:
+    virtual bool is_handler_inited () const {
+        return _handler.ptr ();
+    }
+    SmartPtr<CLImageHandler> get_handler() const {
+        return  _handler;
+    }
+
+protected:
+    CLContextBase (HandleType type)
+        : ContextBase (type, HandleBackendCL)
+    {}
+
+    virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context) = 0;
+
+private:
+    virtual XCamReturn setup_handler ();
+    virtual void release_handler ();
+    virtual XCamReturn process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out);
+
+protected:
+    SmartPtr<CLImageHandler>         _handler;
+};
+
+class NR3DContext
+    : public CLContextBase
+{
 public:
     NR3DContext ()
-        : ContextBase (HandleType3DNR)
+        : CLContextBase (HandleType3DNR)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class NRWaveletContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     NRWaveletContext ()
-        : ContextBase (HandleTypeWaveletNR)
+        : CLContextBase (HandleTypeWaveletNR)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class FisheyeContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     FisheyeContext ()
-        : ContextBase (HandleTypeFisheye)
+        : CLContextBase (HandleTypeFisheye)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class DefogContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     DefogContext ()
-        : ContextBase (HandleTypeDefog)
+        : CLContextBase (HandleTypeDefog)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class DVSContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     DVSContext ()
-        : ContextBase (HandleTypeDVS)
+        : CLContextBase (HandleTypeDVS)
     {}
 
     virtual SmartPtr<CLImageHandler> create_handler (SmartPtr<CLContext> &context);
 };
 
 class StitchContext
-    : public ContextBase
+    : public CLContextBase
 {
 public:
     StitchContext ()
-        : ContextBase (HandleTypeStitch)
+        : CLContextBase (HandleTypeStitch)
         , _need_seam (false)
-        , _fisheye_map (false)
+        , _fisheye_map (true)
         , _need_lsc (false)
         , _fm_ocl (false)
         , _scale_mode (CLBlenderScaleLocal)
@@ -180,5 +296,64 @@ private:
     CLBlenderScaleMode    _scale_mode;
     StitchResMode         _res_mode;
 };
+#endif
+
+/*
+ * surround view stitching by soft, GL or vulkan Stitcher,
+ * calibration comes from a CalibrationBinary file, see param "calib-binary".
+ */
+class SurroundStitchContext
+    : public ContextBase
+{
+public:
+    explicit SurroundStitchContext (HandleBackend backend);
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+    virtual bool is_handler_inited () const {
+        return _stitcher.ptr ();
+    }
+    virtual uint32_t get_input_count () const {
+        return _camera_num;
+    }
+
+private:
+    virtual XCamReturn setup_handler ();
+    virtual void release_handler ();
+    virtual XCamReturn process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out);
+
+private:
+    SmartPtr<Stitcher>    _stitcher;
+    uint32_t              _camera_num;
+    uint32_t              _out_width;
+    uint32_t              _out_height;
+    float                 _view_ranges[XCAM_HANDLE_MAX_INPUTS];
+    std::string           _calib_path;
+};
+
+// remaps by a 2D lookup table of PointFloat2 read from param "lut-file"
+class GeoMapContext
+    : public ContextBase
+{
+public:
+    explicit GeoMapContext (HandleBackend backend);
+
+    virtual XCamReturn set_parameters (ContextParams &param_list);
+    virtual bool is_handler_inited () const {
+        return _mapper.ptr ();
+    }
+
+private:
+    virtual XCamReturn setup_handler ();
+    virtual void release_handler ();
+    virtual XCamReturn process (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &buf_out);
+
+private:
+    SmartPtr<GeoMapper>    _mapper;
+    uint32_t               _out_width;
+    uint32_t               _out_height;
+    uint32_t               _lut_width;
+    uint32_t               _lut_height;
+    std::string            _lut_path;
+};
 
 #endif //XCAM_CONTEXT_PRIV_H
@@ -20,12 +20,8 @@
 
 #include <xcam_utils.h>
 #include <xcam_handle.h>
-#include <dma_video_buffer.h>
 #include "context_priv.h"
 #include <stdarg.h>
-#if HAVE_LIBDRM
-#include <drm_bo_buffer.h>
-#endif
 
 using namespace XCam;
 
@@ -33,7 +29,25 @@ XCamHandle *
 xcam_create_handle (const char *name)
 {
     ContextBase *context = NULL;
+    HandleBackend backend = HandleBackendCL;
 
+    XCAM_FAIL_RETURN (
+        ERROR, name && parse_handle_backend (name, backend), NULL,
+        "create handle failed with invalid name:%s", XCAM_STR (name));
+
+    if (backend != HandleBackendCL) {
+        if (handle_name_equal (name, HandleTypeStitch)) {
+            context = new SurroundStitchContext (backend);
+        } else if (handle_name_equal (name, HandleTypeGeoMap)) {
+            context = new GeoMapContext (backend);
+        } else {
+            XCAM_LOG_ERROR ("create handle failed, type:%s only runs on OpenCL", name);
+            return NULL;
+        }
+        return HANDLE_CAST (context);
+    }
+
+#if HAVE_LIBCL
     if (handle_name_equal (name, HandleType3DNR)) {
         context = new NR3DContext;
     } else if (handle_name_equal (name, HandleTypeWaveletNR)) {
@@ -46,10 +60,13 @@ xcam_create_handle (const char *name)
         context = new DVSContext;
     } else if (handle_name_equal (name, HandleTypeStitch)) {
         context = new StitchContext;
+    } else if (handle_name_equal (name, HandleTypeGeoMap)) {
+        context = new GeoMapContext (backend);
     } else {
         XCAM_LOG_ERROR ("create handle failed with unsupported type:%s", name);
         return NULL;
     }
+#endif
 
     return HANDLE_CAST (context);
 }
@@ -57,15 +74,17 @@ xcam_create_handle (const char *name)
 void
 xcam_destroy_handle (XCamHandle *handle)
 {
-    if (handle)
-        delete CONTEXT_BASE_CAST (handle);
+    if (handle) {
+        ContextBase *context = CONTEXT_BASE_CAST (handle);
+        context->uinit_handler ();
+        delete context;
+    }
 }
 
 XCamReturn
 xcam_handle_init (XCamHandle *handle)
 {
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    SmartPtr<CLImageHandler> handler_ptr;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_FAIL_RETURN (
@@ -139,133 +158,51 @@ xcam_handle_set_parameters (
     return context->set_parameters (params);
 }
 
-SmartPtr<VideoBuffer>
-external_buf_to_drm_buf (XCamVideoBuffer *buf)
+XCamReturn
+xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out)
 {
-#if HAVE_LIBDRM
-    SmartPtr<DrmDisplay> display = DrmDisplay::instance ();
-    SmartPtr<DmaVideoBuffer> dma_buf;
-    SmartPtr<VideoBuffer> drm_buf;
-    SmartPtr<VideoBuffer> video_buf;
-
-    dma_buf = external_buf_to_dma_buf (buf);
-
     XCAM_FAIL_RETURN (
-        ERROR, dma_buf.ptr (), NULL,
-        "external_buf_to_drm_buf failed");
-
-    video_buf = dma_buf;
-    XCAM_ASSERT (display.ptr ());
-    drm_buf = display->convert_to_drm_bo_buf (display, video_buf);
-    return drm_buf;
-#else
-    XCAM_LOG_ERROR ("VideoBuffer doesn't support drm buf");
-
-    XCAM_UNUSED (buf);
-    return NULL;
-#endif
+        ERROR, handle && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
+
+    return xcam_handle_execute_multi (handle, &buf_in, 1, buf_out);
 }
 
-SmartPtr<VideoBuffer>
-copy_external_buf_to_drm_buf (XCamHandle *handle, XCamVideoBuffer *buf)
+XCamReturn
+xcam_handle_execute_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer **buf_out)
 {
-    if (!handle || !buf) {
-        XCAM_LOG_WARNING ("xcam handle can NOT be NULL");
-        return NULL;
-    }
-
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    if (!context) {
-        XCAM_LOG_WARNING ("xcam handle context can NOT be NULL");
-        return NULL;
-    }
-
-    const XCamVideoBufferInfo src_info = buf->info;
-    uint8_t* src = buf->map (buf);
-    uint8_t* p_src = src;
-    if (!src) {
-        XCAM_LOG_WARNING ("xcam handle map buffer failed");
-        return NULL;
-    }
-    uint32_t height = src_info.height;
-
-    SmartPtr<BufferPool> buf_pool = context->get_input_buffer_pool();
-    XCAM_ASSERT (buf_pool.ptr ());
-    SmartPtr<VideoBuffer> video_buf = buf_pool->get_buffer (buf_pool);
-    XCAM_ASSERT (video_buf.ptr ());
-    const XCamVideoBufferInfo dest_info = video_buf->get_video_info ();
-
-    uint8_t* dest = video_buf->map ();
-    uint8_t* p_dest = dest;
 
-    for (uint32_t index = 0; index < src_info.components; index++) {
-        src += (int32_t)src_info.offsets[index];
-        p_src = src;
-
-        dest += dest_info.offsets[index];
-        p_dest = dest;
-        if (src_info.format == V4L2_PIX_FMT_NV12) {
-            height = height >> index;
-        }
-        for (uint32_t i = 0; i < height; i++) {
-            memcpy (p_dest, p_src, src_info.strides[index]);
-            p_src += src_info.strides[index];
-            p_dest += dest_info.strides[index];
-        }
-    }
-
-    buf->unmap (buf);
-    video_buf->unmap ();
+    XCAM_FAIL_RETURN (
+        ERROR, context && bufs_in && buf_out, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute failed, either of handle/bufs_in/buf_out can NOT be NULL");
 
-    return video_buf;
+    return context->execute (bufs_in, in_count, buf_out);
 }
 
 XCamReturn
-xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out)
+xcam_handle_execute_async (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer *buf_out,
+    XCamHandleDoneCallback callback, void *user_data)
 {
     ContextBase *context = CONTEXT_BASE_CAST (handle);
-    SmartPtr<VideoBuffer> input, output;
-
-    XCAM_FAIL_RETURN (
-        ERROR, context && buf_in && buf_out, XCAM_RETURN_ERROR_PARAM,
-        "xcam_handle_execute failed, either of handle/buf_in/buf_out can NOT be NULL");
-
-    XCAM_FAIL_RETURN (
-        ERROR, context->get_handler().ptr (), XCAM_RETURN_ERROR_PARAM,
-        "context (%s) failed, handler was not initialized", context->get_type_name ());
 
-    if (buf_in->mem_type == XCAM_MEM_TYPE_GPU) {
-        input = external_buf_to_drm_buf (buf_in);
-    } else {
-        input = copy_external_buf_to_drm_buf (handle, buf_in);
-    }
     XCAM_FAIL_RETURN (
-        ERROR, input.ptr (), XCAM_RETURN_ERROR_MEM,
-        "xcam_handle(%s) execute failed, buf_in convert to DRM buffer failed.",
-        context->get_type_name ());
-
-    if (*buf_out) {
-        output = external_buf_to_drm_buf (*buf_out);
-        XCAM_FAIL_RETURN (
-            ERROR, output.ptr (), XCAM_RETURN_ERROR_MEM,
-            "xcam_handle(%s) execute failed, buf_out set but convert to DRM buffer failed.",
-            context->get_type_name ());
-    }
+        ERROR, context && bufs_in, XCAM_RETURN_ERROR_PARAM,
+        "xcam_handle_execute_async failed, either of handle/bufs_in can NOT be NULL");
 
-    XCamReturn ret = context->execute (input, output);
+    return context->execute_async (bufs_in, in_count, buf_out, callback, user_data);
+}
 
-    XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS,
-        ret,
-        "context (%s) failed, handler execute failed", context->get_type_name ());
+XCamVideoBuffer *
+xcam_video_buffer_import_fd (const XCamVideoBufferInfo *info, int fd)
+{
+    return import_dma_fd_buffer (info, fd);
+}
 
-    if (*buf_out == NULL && output.ptr ()) {
-        XCamVideoBuffer *new_buf = convert_to_external_buffer (output);
-        XCAM_FAIL_RETURN (
-            ERROR, new_buf, XCAM_RETURN_ERROR_MEM,
-            "xcam_handle(%s) execute failed, out buffer can't convert to external buffer.",
-            context->get_type_name ());
-        *buf_out = new_buf;
-    }
-    return ret;
+XCamVideoBuffer *
+xcam_video_buffer_import_ptr (const XCamVideoBufferInfo *info, uint8_t *ptr)
+{
+    return import_host_ptr_buffer (info, ptr);
 }
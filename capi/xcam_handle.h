@@ -29,9 +29,22 @@ XCAM_BEGIN_DECLARE
 
 typedef struct _XCamHandle XCamHandle;
 
+/*! \brief    called on handle worker thread when an async execute is done
+ *
+ * \params[in]    handle       xcam handle
+ * \params[in]    result       XCAM_RETURN_NO_ERROR or XCAM_RETURN_BYPASS on sucess; others on errors.
+ * \params[in]    buf_out      output buffer, NULL on errors; allocated inside if buf_out was NULL,
+ *                             unref it when done
+ * \params[in]    user_data    user data passed to xcam_handle_execute_async
+ */
+typedef void (*XCamHandleDoneCallback) (
+    XCamHandle *handle, XCamReturn result, XCamVideoBuffer *buf_out, void *user_data);
+
 /*! \brief    create xcam handle to process buffer
  *
- * \params[in]    name, filter name
+ * \params[in]    name, filter name, "3DNR", "WaveletNR", "Fisheye", "Defog", "DVS", "Stitch" or "GeoMap",
+ *                optionally followed by backend ":cl", ":soft", ":gl" or ":vk", OpenCL by default.
+ *                "Stitch" and "GeoMap" support all built-in backends, others are OpenCL only.
  * \return        XCamHandle    create correct hanle, else return NULL.
  */
 XCamHandle *xcam_create_handle (const char *name);
@@ -52,6 +65,10 @@ void xcam_destroy_handle (XCamHandle *handle);
 XCamReturn xcam_handle_get_usage (XCamHandle *handle, char *usage_buf, int *usage_len);
 
 /*! \brief set handle parameters before init
+ *
+ * common fields: "width", "height", "alloc-out-buf", "inflight-depth" (async jobs pending at most, default 2)
+ * "Stitch" on soft/gl/vk: "camera-num", "calib-binary", "out-width", "out-height", "view-ranges"
+ * "GeoMap": "lut-file" (PointFloat2 array), "lut-width", "lut-height", "out-width", "out-height"
  *
  * \params[in]    handle       xcam handle
  * \params[in]    field0, value0, field1, value1, ..., fieldN, valueN    field and value in pairs
@@ -67,7 +84,7 @@ XCamReturn xcam_handle_set_parameters (
  */
 XCamReturn xcam_handle_init (XCamHandle *handle);
 
-/*! \brief    xcam handle uninitialize
+/*! \brief    xcam handle uninitialize, waits pending async jobs
  *
  * \params[in]        handle       xcam handle
  * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
@@ -85,6 +102,51 @@ XCamReturn xcam_handle_uinit (XCamHandle *handle);
  */
 XCamReturn xcam_handle_execute (XCamHandle *handle, XCamVideoBuffer *buf_in, XCamVideoBuffer **buf_out);
 
+/*! \brief    xcam handle process buffers of all inputs, e.g. cameras of "Stitch:soft"
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        bufs_in      input buffers
+ * \params[in]        in_count     input buffer count, 1 or "camera-num" of stitch handles
+ * \params[in,out]    buf_out      output buffer, same as xcam_handle_execute
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR on sucess; others on errors.
+ */
+XCamReturn xcam_handle_execute_multi (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer **buf_out);
+
+/*! \brief    xcam handle queues buffers and returns, jobs run in order on handle worker thread
+ *
+ * \params[in]        handle       xcam handle
+ * \params[in]        bufs_in      input buffers, referenced until callback
+ * \params[in]        in_count     input buffer count
+ * \params[in]        buf_out      output buffer or NULL to allocate inside, referenced until callback
+ * \params[in]        callback     called when done, results are not delivered otherwise
+ * \params[in]        user_data    passed to callback
+ * \return            XCamReturn   XCAM_RETURN_NO_ERROR if queued;
+ *                                 XCAM_RETURN_ERROR_TIMEOUT if "inflight-depth" jobs are pending, retry later.
+ */
+XCamReturn xcam_handle_execute_async (
+    XCamHandle *handle, XCamVideoBuffer **bufs_in, uint32_t in_count, XCamVideoBuffer *buf_out,
+    XCamHandleDoneCallback callback, void *user_data);
+
+/*! \brief    wrap a dma-buf fd as buffer without copy, usable as buf_in or buf_out of all handles
+ *
+ * \params[in]    info         layout of the dma-buf, strides and offsets included
+ * \params[in]    fd           dma-buf fd, not closed inside, keep it open till buffer unref'ed
+ * \return        XCamVideoBuffer    buffer with one reference, unref it when done; NULL on errors.
+ */
+XCamVideoBuffer *xcam_video_buffer_import_fd (const XCamVideoBufferInfo *info, int fd);
+
+/*! \brief    wrap host memory as buffer without copy, usable as buf_in or buf_out of all handles
+ *
+ * OpenCL handles use the memory by CL_MEM_USE_HOST_PTR if ptr is page aligned, else copy.
+ * gl and vk handles always copy.
+ *
+ * \params[in]    info         layout of the memory, strides and offsets included
+ * \params[in]    ptr          memory of info->size bytes at least, valid till buffer unref'ed
+ * \return        XCamVideoBuffer    buffer with one reference, unref it when done; NULL on errors.
+ */
+XCamVideoBuffer *xcam_video_buffer_import_ptr (const XCamVideoBufferInfo *info, uint8_t *ptr);
+
 XCAM_END_DECLARE
 
 #endif //C_XCAM_HANDLE_H
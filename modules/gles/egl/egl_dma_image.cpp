@@ -0,0 +1,159 @@
+/*
+ * egl_dma_image.cpp - EGL dma-buf image import
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "egl_dma_image.h"
+#include <GLES2/gl2ext.h>
+
+namespace XCam {
+
+struct EGLDmaFuncs {
+    PFNEGLCREATEIMAGEKHRPROC               create_image;
+    PFNEGLDESTROYIMAGEKHRPROC              destroy_image;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC    image_target_texture;
+
+    EGLDmaFuncs ()
+        : create_image (NULL)
+        , destroy_image (NULL)
+        , image_target_texture (NULL)
+    {}
+};
+
+static const EGLDmaFuncs *
+get_dma_funcs ()
+{
+    static EGLDmaFuncs funcs;
+    static bool queried = false;
+    if (queried)
+        return funcs.create_image ? &funcs : NULL;
+
+    queried = true;
+    EGLDisplay display = eglGetCurrentDisplay ();
+    const char *exts = (display != EGL_NO_DISPLAY) ? eglQueryString (display, EGL_EXTENSIONS) : NULL;
+    const char *gl_exts = (const char *)glGetString (GL_EXTENSIONS);
+    if (!exts || !strstr (exts, "EGL_EXT_image_dma_buf_import") ||
+            !gl_exts || !strstr (gl_exts, "GL_OES_EGL_image")) {
+        XCAM_LOG_WARNING ("EGL_EXT_image_dma_buf_import or GL_OES_EGL_image is not supported");
+        return NULL;
+    }
+
+    funcs.create_image = (PFNEGLCREATEIMAGEKHRPROC) eglGetProcAddress ("eglCreateImageKHR");
+    funcs.destroy_image = (PFNEGLDESTROYIMAGEKHRPROC) eglGetProcAddress ("eglDestroyImageKHR");
+    funcs.image_target_texture =
+        (PFNGLEGLIMAGETARGETTEXTURE2DOESPROC) eglGetProcAddress ("glEGLImageTargetTexture2DOES");
+    if (!funcs.create_image || !funcs.destroy_image || !funcs.image_target_texture) {
+        XCAM_LOG_WARNING ("EGL get dma-buf import functions failed");
+        funcs.create_image = NULL;
+        return NULL;
+    }
+
+    return &funcs;
+}
+
+EGLDmaImage::EGLDmaImage (EGLDisplay display, EGLImageKHR image, GLuint texture, int fd)
+    : _display (display)
+    , _image (image)
+    , _texture (texture)
+    , _fd (fd)
+{
+}
+
+EGLDmaImage::~EGLDmaImage ()
+{
+    if (_texture)
+        glDeleteTextures (1, &_texture);
+
+    const EGLDmaFuncs *funcs = get_dma_funcs ();
+    if (funcs && _image != EGL_NO_IMAGE_KHR)
+        funcs->destroy_image (_display, _image);
+}
+
+bool
+EGLDmaImage::is_supported ()
+{
+    return get_dma_funcs () != NULL;
+}
+
+SmartPtr<EGLDmaImage>
+EGLDmaImage::create_image (
+    int fd, uint32_t drm_format, uint32_t width, uint32_t height, uint32_t offset, uint32_t pitch)
+{
+    const EGLDmaFuncs *funcs = get_dma_funcs ();
+    XCAM_FAIL_RETURN (
+        ERROR, funcs && fd >= 0, NULL,
+        "EGL create dma image failed, dma-buf import unsupported or invalid fd:%d", fd);
+
+    EGLint attribs[] = {
+        EGL_WIDTH, (EGLint)width,
+        EGL_HEIGHT, (EGLint)height,
+        EGL_LINUX_DRM_FOURCC_EXT, (EGLint)drm_format,
+        EGL_DMA_BUF_PLANE0_FD_EXT, fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, (EGLint)offset,
+        EGL_DMA_BUF_PLANE0_PITCH_EXT, (EGLint)pitch,
+        EGL_NONE
+    };
+
+    EGLDisplay display = eglGetCurrentDisplay ();
+    EGLImageKHR image = funcs->create_image (display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, attribs);
+    XCAM_FAIL_RETURN (
+        ERROR, image != EGL_NO_IMAGE_KHR, NULL,
+        "EGL create dma image failed, fd:%d, format:%s, size:%dx%d, error flag: %s",
+        fd, xcam_fourcc_to_string (drm_format), width, height, EGL::error_string (EGL::get_error ()));
+
+    GLuint texture = 0;
+    glGenTextures (1, &texture);
+    SmartPtr<EGLDmaImage> dma_image = new EGLDmaImage (display, image, texture, fd);
+    XCAM_ASSERT (dma_image.ptr ());
+
+    glBindTexture (GL_TEXTURE_2D, texture);
+    funcs->image_target_texture (GL_TEXTURE_2D, (GLeglImageOES)image);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture (GL_TEXTURE_2D, 0);
+
+    GLenum error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, texture && error == GL_NO_ERROR, NULL,
+        "EGL bind dma image to texture failed, fd:%d, error flag: %s", fd, gl_error_string (error));
+
+    return dma_image;
+}
+
+bool
+import_dma_nv12 (const SmartPtr<VideoBuffer> &buf, EGLDmaNV12Image &image)
+{
+    XCAM_ASSERT (buf.ptr ());
+    const VideoBufferInfo &info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12, false,
+        "EGL import dma buffer only support NV12, but format is %s", xcam_fourcc_to_string (info.format));
+
+    int fd = buf->get_fd ();
+    image.y = EGLDmaImage::create_image (
+        fd, XCAM_DRM_FORMAT_R8, info.width, info.height, info.offsets[0], info.strides[0]);
+    image.uv = EGLDmaImage::create_image (
+        fd, XCAM_DRM_FORMAT_GR88, info.width / 2, info.height / 2, info.offsets[1], info.strides[1]);
+    XCAM_FAIL_RETURN (
+        ERROR, image.y.ptr () && image.uv.ptr (), false,
+        "EGL import dma buffer(fd:%d) failed", fd);
+
+    return true;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * egl_dma_image.h - EGL dma-buf image import
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_EGL_DMA_IMAGE_H
+#define XCAM_EGL_DMA_IMAGE_H
+
+#include <gles/egl/egl_utils.h>
+#include <gles/gles_std.h>
+#include <video_buffer.h>
+
+// DRM fourcc of single plane formats used by NV12 planes
+#define XCAM_DRM_FORMAT_R8    v4l2_fourcc ('R', '8', ' ', ' ')
+#define XCAM_DRM_FORMAT_GR88  v4l2_fourcc ('G', 'R', '8', '8')
+
+namespace XCam {
+
+/*
+ * one plane of dma-buf imported through EGL_EXT_image_dma_buf_import,
+ * bound to a GL_TEXTURE_2D which shaders sample with linear filtering.
+ */
+class EGLDmaImage
+{
+public:
+    ~EGLDmaImage ();
+
+    static bool is_supported ();
+    static SmartPtr<EGLDmaImage> create_image (
+        int fd, uint32_t drm_format, uint32_t width, uint32_t height, uint32_t offset, uint32_t pitch);
+
+    GLuint get_texture () const {
+        return _texture;
+    }
+    int get_fd () const {
+        return _fd;
+    }
+
+private:
+    explicit EGLDmaImage (EGLDisplay display, EGLImageKHR image, GLuint texture, int fd);
+
+private:
+    XCAM_DEAD_COPY (EGLDmaImage);
+
+private:
+    EGLDisplay     _display;
+    EGLImageKHR    _image;
+    GLuint         _texture;
+    int            _fd;
+};
+
+struct EGLDmaNV12Image {
+    SmartPtr<EGLDmaImage>    y;
+    SmartPtr<EGLDmaImage>    uv;
+};
+
+// import Y plane as R8 and UV plane as GR88, buf must have a dma fd
+bool import_dma_nv12 (const SmartPtr<VideoBuffer> &buf, EGLDmaNV12Image &image);
+
+}
+
+#endif // XCAM_EGL_DMA_IMAGE_H
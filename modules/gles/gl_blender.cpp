@@ -46,20 +46,20 @@ namespace XCam {
 
 using namespace XCamGLShaders;
 
-DECLARE_WORK_CALLBACK (CbGaussScalePyr, GLBlender, gauss_scale_done);
-DECLARE_WORK_CALLBACK (CbLapTransPyr, GLBlender, lap_trans_done);
+DECLARE_WORK_CALLBACK (CbGaussLapPyr, GLBlender, gauss_lap_done);
 DECLARE_WORK_CALLBACK (CbBlendPyr, GLBlender, blend_done);
 DECLARE_WORK_CALLBACK (CbReconstructPyr, GLBlender, reconstruct_done);
+DECLARE_WORK_CALLBACK (CbBlendFeather, GLBlender, feather_done);
 
 typedef std::map<void*, SmartPtr<GLBlendPyrShader::Args>> MapBlendArgs;
 typedef std::map<void*, SmartPtr<GLReconstructPyrShader::Args>> MapReconstructArgs;
+typedef std::map<void*, SmartPtr<GLBlendReconstructPyrShader::Args>> MapBlendReconstructArgs;
 
 namespace GLBlenderPriv {
 
 struct PyramidResource {
     SmartPtr<BufferPool>                overlap_pool;
-    SmartPtr<GLGaussScalePyrShader>     gauss_scale[GLBlender::BufIdxCount];
-    SmartPtr<GLLapTransPyrShader>       lap_trans[GLBlender::BufIdxCount];
+    SmartPtr<GLGaussLapPyrShader>       gauss_lap[GLBlender::BufIdxCount];
     SmartPtr<GLReconstructPyrShader>    reconstruct;
     SmartPtr<GLBuffer>                  coef_mask;
     MapReconstructArgs                  reconstruct_args;
@@ -71,11 +71,15 @@ public:
     uint32_t                      pyr_levels;
 
     SmartPtr<GLBlendPyrShader>    top_level_blend;
+    // top level blend fused into top level reconstruct, replaces top_level_blend
+    SmartPtr<GLBlendReconstructPyrShader> top_level_reconstruct;
+    SmartPtr<GLBlendFeatherShader> feather_blend;
     SmartPtr<BufferPool>          first_lap_pool;
     SmartPtr<GLBuffer>            first_mask;
 
     Mutex                         map_args_mutex;
     MapBlendArgs                  blend_args;
+    MapBlendReconstructArgs       blend_reconstruct_args;
 
 private:
     GLBlender                    *_blender;
@@ -89,16 +93,11 @@ public:
     XCamReturn init_first_masks (uint32_t width, uint32_t height);
     XCamReturn scale_down_masks (uint32_t level, uint32_t width, uint32_t height);
 
-    XCamReturn start_gauss_scale (
+    XCamReturn start_gauss_lap (
         const SmartPtr<ImageHandler::Parameters> &param,
         const SmartPtr<VideoBuffer> &in_buf,
         uint32_t level, GLBlender::BufIdx idx);
 
-    XCamReturn start_lap_trans (
-        const SmartPtr<ImageHandler::Parameters> &param,
-        const SmartPtr<GLGaussScalePyrShader::Args> &gauss_scale_args,
-        uint32_t level, GLBlender::BufIdx idx);
-
     XCamReturn start_blend (
         const SmartPtr<ImageHandler::Parameters> &param,
         const SmartPtr<VideoBuffer> &buf, GLBlender::BufIdx idx);
@@ -110,7 +109,12 @@ public:
     XCamReturn start_reconstruct_by_gauss (
         const SmartPtr<ImageHandler::Parameters> &param,
         const SmartPtr<VideoBuffer> &prev_blend_buf, uint32_t level);
+    XCamReturn start_blend_reconstruct (
+        const SmartPtr<ImageHandler::Parameters> &param,
+        const SmartPtr<VideoBuffer> &lap, const SmartPtr<VideoBuffer> &gauss,
+        GLBlender::BufIdx idx);
     XCamReturn start_reconstruct (const SmartPtr<GLReconstructPyrShader::Args> &args, uint32_t level);
+    XCamReturn start_feather_blend (const SmartPtr<GLBlender::BlenderParam> &param);
     XCamReturn stop ();
 };
 
@@ -157,6 +161,9 @@ GLBlender::~GLBlender ()
 XCamReturn
 GLBlender::terminate ()
 {
+    if (is_off_executor ())
+        return terminate_on_executor ();
+
     _priv_config->stop ();
     return GLImageHandler::terminate ();
 }
@@ -184,10 +191,8 @@ XCamReturn
 GLBlenderPriv::BlenderPrivConfig::stop ()
 {
     for (uint32_t i = 0; i < pyr_levels; ++i) {
-        pyr_layer[i].gauss_scale[GLBlender::Idx0].release ();
-        pyr_layer[i].gauss_scale[GLBlender::Idx1].release ();
-        pyr_layer[i].lap_trans[GLBlender::Idx0].release ();
-        pyr_layer[i].lap_trans[GLBlender::Idx1].release ();
+        pyr_layer[i].gauss_lap[GLBlender::Idx0].release ();
+        pyr_layer[i].gauss_lap[GLBlender::Idx1].release ();
         pyr_layer[i].reconstruct.release ();
 
         if (pyr_layer[i].overlap_pool.ptr ()) {
@@ -196,6 +201,8 @@ GLBlenderPriv::BlenderPrivConfig::stop ()
     }
 
     top_level_blend.release ();
+    top_level_reconstruct.release ();
+    feather_blend.release ();
     if (first_lap_pool.ptr ()) {
         first_lap_pool->stop ();
     }
@@ -308,7 +315,7 @@ GLBlenderPriv::BlenderPrivConfig::scale_down_masks (uint32_t level, uint32_t wid
 }
 
 XCamReturn
-GLBlenderPriv::BlenderPrivConfig::start_gauss_scale (
+GLBlenderPriv::BlenderPrivConfig::start_gauss_lap (
     const SmartPtr<ImageHandler::Parameters> &param,
     const SmartPtr<VideoBuffer> &in_buf,
     uint32_t level, GLBlender::BufIdx idx)
@@ -316,20 +323,35 @@ GLBlenderPriv::BlenderPrivConfig::start_gauss_scale (
     XCAM_ASSERT (in_buf.ptr ());
     XCAM_ASSERT (level < pyr_levels);
     XCAM_ASSERT (idx < GLBlender::BufIdxCount);
-    XCAM_ASSERT (pyr_layer[level].gauss_scale[idx].ptr ());
+    XCAM_ASSERT (pyr_layer[level].gauss_lap[idx].ptr ());
     XCAM_ASSERT (pyr_layer[level].overlap_pool.ptr ());
 
-    SmartPtr<VideoBuffer> out_buf = pyr_layer[level].overlap_pool->get_buffer ();
+    SmartPtr<VideoBuffer> gauss_buf = pyr_layer[level].overlap_pool->get_buffer ();
     XCAM_FAIL_RETURN (
-        ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
-        "blender(%s) start_gauss_scale failed, output buffer is empty, level:%d, idx:%d",
+        ERROR, gauss_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "blender(%s) start_gauss_lap failed, gauss buffer is empty, level:%d, idx:%d",
+        XCAM_STR (_blender->get_name ()), level, (int)idx);
+
+    SmartPtr<VideoBuffer> lap_buf;
+    if (level == 0) {
+        XCAM_ASSERT (first_lap_pool.ptr ());
+        lap_buf = first_lap_pool->get_buffer ();
+    } else {
+        XCAM_ASSERT (pyr_layer[level - 1].overlap_pool.ptr ());
+        lap_buf = pyr_layer[level - 1].overlap_pool->get_buffer ();
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, lap_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "blender(%s) start_gauss_lap failed, laplace buffer is empty, level:%d, idx:%d",
         XCAM_STR (_blender->get_name ()), level, (int)idx);
 
-    SmartPtr<GLGaussScalePyrShader::Args> args = new GLGaussScalePyrShader::Args (param, level, idx);
+    SmartPtr<GLGaussLapPyrShader::Args> args = new GLGaussLapPyrShader::Args (param, level, idx);
     XCAM_ASSERT (args.ptr ());
     args->in_glbuf = get_glbuffer (in_buf);
-    args->out_glbuf = get_glbuffer (out_buf);
-    args->out_video_buf = out_buf;
+    args->gauss_glbuf = get_glbuffer (gauss_buf);
+    args->lap_glbuf = get_glbuffer (lap_buf);
+    args->gauss_video_buf = gauss_buf;
+    args->lap_video_buf = lap_buf;
 
     if (level == 0) {
         const Rect area = _blender->get_input_merge_area (idx);
@@ -358,41 +380,7 @@ GLBlenderPriv::BlenderPrivConfig::start_gauss_scale (
         args->merge_area = Rect (0, 0, info.width, info.height);
     }
 
-    return pyr_layer[level].gauss_scale[idx]->work (args);
-}
-
-XCamReturn
-GLBlenderPriv::BlenderPrivConfig::start_lap_trans (
-    const SmartPtr<ImageHandler::Parameters> &param,
-    const SmartPtr<GLGaussScalePyrShader::Args> &gauss_scale_args,
-    uint32_t level, GLBlender::BufIdx idx)
-{
-    XCAM_ASSERT (level < pyr_levels);
-    XCAM_ASSERT (pyr_layer[level].lap_trans[idx].ptr ());
-    XCAM_ASSERT (idx < GLBlender::BufIdxCount);
-
-    SmartPtr<VideoBuffer> out_buf;
-    if (level == 0) {
-        XCAM_ASSERT (first_lap_pool.ptr ());
-        out_buf = first_lap_pool->get_buffer ();
-    } else {
-        XCAM_ASSERT (pyr_layer[level - 1].overlap_pool.ptr ());
-        out_buf = pyr_layer[level - 1].overlap_pool->get_buffer ();
-    }
-    XCAM_FAIL_RETURN (
-        ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
-        "blender(%s) start_lap_trans failed, output buffer is empty, level:%d, idx:%d",
-        XCAM_STR (_blender->get_name ()), level, (int)idx);
-
-    SmartPtr<GLLapTransPyrShader::Args> args = new GLLapTransPyrShader::Args (param, level, idx);
-    XCAM_ASSERT (args.ptr ());
-    args->in_glbuf = gauss_scale_args->in_glbuf;
-    args->gaussscale_glbuf = gauss_scale_args->out_glbuf;
-    args->out_glbuf = get_glbuffer (out_buf);
-    args->merge_area = gauss_scale_args->merge_area;
-    args->out_video_buf = out_buf;
-
-    return pyr_layer[level].lap_trans[idx]->work (args);
+    return pyr_layer[level].gauss_lap[idx]->work (args);
 }
 
 XCamReturn
@@ -451,7 +439,7 @@ GLBlenderPriv::BlenderPrivConfig::start_reconstruct (
 {
     XCAM_ASSERT (args.ptr ());
     XCAM_ASSERT (level < pyr_levels);
-    XCAM_ASSERT (pyr_layer[level].reconstruct.ptr ());
+    XCAM_ASSERT (pyr_layer[level].reconstruct.ptr () || level == pyr_levels - 1);
     XCAM_ASSERT (args->lap0_glbuf.ptr () && args->lap1_glbuf.ptr () && args->prev_blend_glbuf.ptr ());
 
     SmartPtr<VideoBuffer> out_buf;
@@ -500,6 +488,9 @@ GLBlenderPriv::BlenderPrivConfig::start_reconstruct (
     args->out_glbuf = get_glbuffer (out_buf);
     args->out_video_buf = out_buf;
 
+    if (level == pyr_levels - 1 && top_level_reconstruct.ptr ())
+        return top_level_reconstruct->work (args);
+
     return pyr_layer[level].reconstruct->work (args);
 }
 
@@ -572,6 +563,69 @@ GLBlenderPriv::BlenderPrivConfig::start_reconstruct_by_lap (
     return start_reconstruct (args, level);
 }
 
+XCamReturn
+GLBlenderPriv::BlenderPrivConfig::start_blend_reconstruct (
+    const SmartPtr<ImageHandler::Parameters> &param,
+    const SmartPtr<VideoBuffer> &lap, const SmartPtr<VideoBuffer> &gauss,
+    GLBlender::BufIdx idx)
+{
+    XCAM_ASSERT (lap.ptr () && gauss.ptr ());
+    XCAM_ASSERT (idx < GLBlender::BufIdxCount);
+    XCAM_ASSERT (top_level_reconstruct.ptr ());
+
+    uint32_t top_level = pyr_levels - 1;
+    XCAM_ASSERT (pyr_layer[top_level].coef_mask.ptr ());
+
+    SmartPtr<GLBlendReconstructPyrShader::Args> args;
+    {
+        SmartLock locker (map_args_mutex);
+        MapBlendReconstructArgs::iterator i = blend_reconstruct_args.find (param.ptr ());
+        if (i == blend_reconstruct_args.end ()) {
+            args = new GLBlendReconstructPyrShader::Args (param, top_level);
+            XCAM_ASSERT (args.ptr ());
+            blend_reconstruct_args.insert (std::make_pair((void*)param.ptr (), args));
+            XCAM_LOG_DEBUG ("blender(%s) init blend reconstruct args, idx:%d", XCAM_STR (_blender->get_name ()), (int)idx);
+        } else {
+            args = (*i).second;
+        }
+
+        if (idx == GLBlender::Idx0) {
+            args->lap0_glbuf = get_glbuffer (lap);
+            args->prev_blend_glbuf = get_glbuffer (gauss);
+        } else {
+            args->lap1_glbuf = get_glbuffer (lap);
+            args->prev1_glbuf = get_glbuffer (gauss);
+        }
+
+        if (!args->lap0_glbuf.ptr () || !args->lap1_glbuf.ptr ())
+            return XCAM_RETURN_BYPASS;
+
+        blend_reconstruct_args.erase (i);
+    }
+
+    args->prev_mask_glbuf = pyr_layer[top_level].coef_mask;
+
+    return start_reconstruct (args, top_level);
+}
+
+XCamReturn
+GLBlenderPriv::BlenderPrivConfig::start_feather_blend (const SmartPtr<GLBlender::BlenderParam> &param)
+{
+    XCAM_ASSERT (feather_blend.ptr () && first_mask.ptr ());
+
+    SmartPtr<GLBlendFeatherShader::Args> args = new GLBlendFeatherShader::Args (param);
+    XCAM_ASSERT (args.ptr ());
+    args->in0_glbuf = get_glbuffer (param->in_buf);
+    args->in1_glbuf = get_glbuffer (param->in1_buf);
+    args->out_glbuf = get_glbuffer (param->out_buf);
+    args->mask_glbuf = first_mask;
+    args->in0_area = _blender->get_input_merge_area (GLBlender::Idx0);
+    args->in1_area = _blender->get_input_merge_area (GLBlender::Idx1);
+    args->out_area = _blender->get_merge_window ();
+
+    return feather_blend->work (args);
+}
+
 XCamReturn
 GLBlender::start_work (const SmartPtr<ImageHandler::Parameters> &base)
 {
@@ -583,17 +637,25 @@ GLBlender::start_work (const SmartPtr<ImageHandler::Parameters> &base)
     dump_level_buf (param->in_buf, "input", 0, 0);
     dump_level_buf (param->in1_buf, "input", 0, 1);
 
-    // start gauss scale level:0 idx:0
-    XCamReturn ret = _priv_config->start_gauss_scale (param, param->in_buf, 0, GLBlender::Idx0);
+    if (get_blend_mode () == BlendModeFeather) {
+        XCamReturn ret = _priv_config->start_feather_blend (param);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "blender(%s) start feather blend failed", XCAM_STR (get_name ()));
+        return ret;
+    }
+
+    // start gauss laplace level:0 idx:0
+    XCamReturn ret = _priv_config->start_gauss_lap (param, param->in_buf, 0, GLBlender::Idx0);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
-        "blender(%s) start gauss scale failed, level:0 idx:0", XCAM_STR (get_name ()));
+        "blender(%s) start gauss laplace failed, level:0 idx:0", XCAM_STR (get_name ()));
 
-    // start gauss scale level:0 idx:1
-    ret = _priv_config->start_gauss_scale (param, param->in1_buf, 0, GLBlender::Idx1);
+    // start gauss laplace level:0 idx:1
+    ret = _priv_config->start_gauss_lap (param, param->in1_buf, 0, GLBlender::Idx1);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
-        "blender(%s) start gauss scale failed, level:0 idx:1", XCAM_STR (get_name ()));
+        "blender(%s) start gauss laplace failed, level:0 idx:1", XCAM_STR (get_name ()));
 
     return ret;
 };
@@ -648,25 +710,43 @@ GLBlender::configure_resource (const SmartPtr<Parameters> &param)
             "blender(%s) invalid merge size, width:%d, height:%d",
             XCAM_STR (get_name ()), merge_size.width, merge_size.height);
 
+    if (get_blend_mode () == BlendModeFeather) {
+        // level 0 mask blends merge areas straight into output, no pyramid buffers
+        XCamReturn ret = _priv_config->init_first_masks (merge_size.width, 1);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "blender(%s) init first masks failed", XCAM_STR (get_name ()));
+
+        SmartPtr<Worker::Callback> feather_cb = new CbBlendFeather (this);
+        XCAM_ASSERT (feather_cb.ptr ());
+        _priv_config->feather_blend = create_blend_feather_shader (feather_cb);
+        XCAM_FAIL_RETURN (
+            ERROR, _priv_config->feather_blend.ptr (), XCAM_RETURN_ERROR_GLES,
+            "blender(%s) create feather blend shader failed", XCAM_STR (get_name ()));
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
     SmartPtr<BufferPool> first_lap_pool = new GLVideoBufferPool (overlap_info);
     XCAM_ASSERT (first_lap_pool.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, first_lap_pool->reserve (LAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
+        ERROR, xcam_ret_is_ok (first_lap_pool->reserve (LAP_POOL_SIZE)), XCAM_RETURN_ERROR_MEM,
         "blender(%s) reserve lap buffer pool failed, overlap size:%dx%d",
         XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
     _priv_config->first_lap_pool = first_lap_pool;
 
-    SmartPtr<Worker::Callback> gauss_scale_cb = new CbGaussScalePyr (this);
-    SmartPtr<Worker::Callback> lap_trans_cb = new CbLapTransPyr (this);
+    SmartPtr<Worker::Callback> gauss_lap_cb = new CbGaussLapPyr (this);
     SmartPtr<Worker::Callback> reconstruct_cb = new CbReconstructPyr (this);
-    XCAM_ASSERT (gauss_scale_cb.ptr () && lap_trans_cb.ptr () && reconstruct_cb.ptr ());
+    XCAM_ASSERT (gauss_lap_cb.ptr () && reconstruct_cb.ptr ());
 
     XCamReturn ret = _priv_config->init_first_masks (merge_size.width, 1);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
         "blender(%s) init first masks failed", XCAM_STR (get_name ()));
 
+    // top level blend runs as a separate pass on drivers with less storage blocks
+    bool fused_top = GLBlendReconstructPyrShader::is_supported ();
+
     for (uint32_t i = 0; i < _priv_config->pyr_levels; ++i) {
         merge_size.width = XCAM_ALIGN_UP ((merge_size.width + 1) / 2, GL_BLENDER_ALIGN_X);
         merge_size.height = XCAM_ALIGN_UP ((merge_size.height + 1) / 2, GL_BLENDER_ALIGN_Y);
@@ -675,7 +755,7 @@ GLBlender::configure_resource (const SmartPtr<Parameters> &param)
         SmartPtr<BufferPool> pool = new GLVideoBufferPool (overlap_info);
         XCAM_ASSERT (pool.ptr ());
         XCAM_FAIL_RETURN (
-            ERROR, pool->reserve (OVERLAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
+            ERROR, xcam_ret_is_ok (pool->reserve (OVERLAP_POOL_SIZE)), XCAM_RETURN_ERROR_MEM,
             "blender(%s) reserve buffer pool failed, overlap size:%dx%d",
             XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
         _priv_config->pyr_layer[i].overlap_pool = pool;
@@ -685,34 +765,37 @@ GLBlender::configure_resource (const SmartPtr<Parameters> &param)
             ERROR, xcam_ret_is_ok (ret), ret,
             "blender(%s) scale down masks failed, level:%d", XCAM_STR (get_name ()), i);
 
-        _priv_config->pyr_layer[i].gauss_scale[GLBlender::Idx0] = create_gauss_scale_pyr_shader (gauss_scale_cb);
-        XCAM_ASSERT (_priv_config->pyr_layer[i].gauss_scale[GLBlender::Idx0].ptr ());
-        _priv_config->pyr_layer[i].gauss_scale[GLBlender::Idx1] = create_gauss_scale_pyr_shader (gauss_scale_cb);
-        XCAM_ASSERT (_priv_config->pyr_layer[i].gauss_scale[GLBlender::Idx1].ptr ());
-        _priv_config->pyr_layer[i].lap_trans[GLBlender::Idx0] = create_lap_trans_pyr_shader (lap_trans_cb);
-        XCAM_ASSERT (_priv_config->pyr_layer[i].lap_trans[GLBlender::Idx0].ptr ());
-        _priv_config->pyr_layer[i].lap_trans[GLBlender::Idx1] = create_lap_trans_pyr_shader (lap_trans_cb);
-        XCAM_ASSERT (_priv_config->pyr_layer[i].lap_trans[GLBlender::Idx1].ptr ());
-        _priv_config->pyr_layer[i].reconstruct = create_reconstruct_pyr_shader (reconstruct_cb);
-        XCAM_ASSERT (_priv_config->pyr_layer[i].reconstruct.ptr ());
+        _priv_config->pyr_layer[i].gauss_lap[GLBlender::Idx0] = create_gauss_lap_pyr_shader (gauss_lap_cb);
+        XCAM_ASSERT (_priv_config->pyr_layer[i].gauss_lap[GLBlender::Idx0].ptr ());
+        _priv_config->pyr_layer[i].gauss_lap[GLBlender::Idx1] = create_gauss_lap_pyr_shader (gauss_lap_cb);
+        XCAM_ASSERT (_priv_config->pyr_layer[i].gauss_lap[GLBlender::Idx1].ptr ());
+        if (i + 1 < _priv_config->pyr_levels || !fused_top) {
+            _priv_config->pyr_layer[i].reconstruct = create_reconstruct_pyr_shader (reconstruct_cb);
+            XCAM_ASSERT (_priv_config->pyr_layer[i].reconstruct.ptr ());
+        }
     }
 
-    SmartPtr<Worker::Callback> blend_cb = new CbBlendPyr (this);
-    XCAM_ASSERT (blend_cb.ptr ());
-    _priv_config->top_level_blend = create_blend_pyr_shader (blend_cb);
-    XCAM_ASSERT (_priv_config->top_level_blend.ptr ());
+    if (fused_top) {
+        _priv_config->top_level_reconstruct = create_blend_reconstruct_pyr_shader (reconstruct_cb);
+        XCAM_ASSERT (_priv_config->top_level_reconstruct.ptr ());
+    } else {
+        SmartPtr<Worker::Callback> blend_cb = new CbBlendPyr (this);
+        XCAM_ASSERT (blend_cb.ptr ());
+        _priv_config->top_level_blend = create_blend_pyr_shader (blend_cb);
+        XCAM_ASSERT (_priv_config->top_level_blend.ptr ());
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 void
-GLBlender::gauss_scale_done (
+GLBlender::gauss_lap_done (
     const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
 {
     XCAM_UNUSED (worker);
     XCAM_ASSERT (base.ptr ());
 
-    SmartPtr<GLGaussScalePyrShader::Args> args = base.dynamic_cast_ptr<GLGaussScalePyrShader::Args> ();
+    SmartPtr<GLGaussLapPyrShader::Args> args = base.dynamic_cast_ptr<GLGaussLapPyrShader::Args> ();
     XCAM_ASSERT (args.ptr ());
     uint32_t level = args->level;
     XCAM_ASSERT (level < _priv_config->pyr_levels);
@@ -722,42 +805,28 @@ GLBlender::gauss_scale_done (
     const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
     XCAM_ASSERT (param.ptr ());
 
-    dump_level_buf (args->out_video_buf, "gauss-scale", level, idx);
-
-    XCamReturn ret = _priv_config->start_lap_trans (param, args, level, idx);
-    CHECK_RET (ret, "execute laplace transformation failed, level:%d idx:%d", level, idx);
+    dump_level_buf (args->gauss_video_buf, "gauss-scale", level, idx);
+    dump_level_buf (args->lap_video_buf, "lap", level, idx);
 
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
     if (next_level == _priv_config->pyr_levels) { // top level
-        ret = _priv_config->start_blend (param, args->out_video_buf, idx);
-        CHECK_RET (ret, "execute blend failed, level:%d idx:%d", next_level, idx);
-    } else {
-        ret = _priv_config->start_gauss_scale (param, args->out_video_buf, next_level, idx);
-        CHECK_RET (ret, "execute gauss scale failed, level:%d idx:%d", next_level, idx);
-    }
-
-    execute_done (param, error);
-}
-
-void
-GLBlender::lap_trans_done (
-    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
-{
-    XCAM_UNUSED (worker);
-    XCAM_ASSERT (base.ptr ());
-
-    SmartPtr<GLLapTransPyrShader::Args> args = base.dynamic_cast_ptr<GLLapTransPyrShader::Args> ();
-    XCAM_ASSERT (args.ptr ());
-    uint32_t level = args->level;
-    XCAM_ASSERT (level < _priv_config->pyr_levels);
-    BufIdx idx = args->idx;
-
-    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
-    XCAM_ASSERT (param.ptr ());
+        if (_priv_config->top_level_reconstruct.ptr ()) {
+            ret = _priv_config->start_blend_reconstruct (param, args->lap_video_buf, args->gauss_video_buf, idx);
+            CHECK_RET (ret, "execute blend reconstruct failed, level:%d idx:%d", level, idx);
+        } else {
+            ret = _priv_config->start_reconstruct_by_lap (param, args->lap_video_buf, level, idx);
+            CHECK_RET (ret, "execute reconstruct by lap failed, level:%d idx:%d", level, idx);
 
-    dump_level_buf (args->out_video_buf, "lap", level, idx);
+            ret = _priv_config->start_blend (param, args->gauss_video_buf, idx);
+            CHECK_RET (ret, "execute blend failed, level:%d idx:%d", next_level, idx);
+        }
+    } else {
+        ret = _priv_config->start_gauss_lap (param, args->gauss_video_buf, next_level, idx);
+        CHECK_RET (ret, "execute gauss laplace failed, level:%d idx:%d", next_level, idx);
 
-    XCamReturn ret = _priv_config->start_reconstruct_by_lap (param, args->out_video_buf, level, idx);
-    CHECK_RET (ret, "execute reconstruct by lap failed, level:%d idx:%d", level, idx);
+        ret = _priv_config->start_reconstruct_by_lap (param, args->lap_video_buf, level, idx);
+        CHECK_RET (ret, "execute reconstruct by lap failed, level:%d idx:%d", level, idx);
+    }
 
     execute_done (param, error);
 }
@@ -810,6 +879,21 @@ GLBlender::reconstruct_done (
     execute_done (param, error);
 }
 
+void
+GLBlender::feather_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (base.ptr ());
+
+    SmartPtr<GLBlendFeatherShader::Args> args = base.dynamic_cast_ptr<GLBlendFeatherShader::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    XCAM_ASSERT (param.ptr ());
+
+    execute_done (param, error);
+}
+
 SmartPtr<GLImageHandler>
 create_gl_blender ()
 {
@@ -65,14 +65,19 @@ public:
     //derived from GLHandler
     virtual XCamReturn terminate ();
 
-    void gauss_scale_done (
-        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
-    void lap_trans_done (
+    void gauss_lap_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
     void blend_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
     void reconstruct_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
+    void feather_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error);
+
+    //derived from Blender interface
+    virtual bool is_feather_supported () const {
+        return true;
+    }
 
 protected:
     explicit GLBlender (const char *name = "GLBlender");
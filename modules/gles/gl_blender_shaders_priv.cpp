@@ -25,23 +25,18 @@ namespace XCam {
 namespace XCamGLShaders {
 
 enum {
-    ShaderGaussScalePyr = 0,
-    ShaderLapTransPyr,
+    ShaderGaussLapPyr = 0,
     ShaderBlendPyr,
-    ShaderReconstructPyr
+    ShaderReconstructPyr,
+    ShaderBlendReconstructPyr,
+    ShaderBlendFeather
 };
 
 static const GLShaderInfo shaders_info[] = {
     {
         GL_COMPUTE_SHADER,
-        "shader_gauss_scale_pyr",
-#include "shader_gauss_scale_pyr.comp.slx"
-        , 0
-    },
-    {
-        GL_COMPUTE_SHADER,
-        "shader_lap_trans_pyr",
-#include "shader_lap_trans_pyr.comp.slx"
+        "shader_gauss_lap_pyr",
+#include "shader_gauss_lap_pyr.comp.slx"
         , 0
     },
     {
@@ -55,150 +50,176 @@ static const GLShaderInfo shaders_info[] = {
         "shader_reconstruct_pyr",
 #include "shader_reconstruct_pyr.comp.slx"
         , 0
+    },
+    {
+        GL_COMPUTE_SHADER,
+        "shader_blend_reconstruct_pyr",
+#include "shader_blend_reconstruct_pyr.comp.slx"
+        , 0
+    },
+    {
+        GL_COMPUTE_SHADER,
+        "shader_blend_feather",
+#include "shader_blend_feather.comp.slx"
+        , 0
     }
 };
 
 bool
-GLGaussScalePyrShader::check_desc (
-    const GLBufferDesc &in_desc, const GLBufferDesc &out_desc, const Rect &merge_area)
+GLGaussLapPyrShader::check_desc (
+    const GLBufferDesc &in_desc, const GLBufferDesc &gauss_desc,
+    const GLBufferDesc &lap_desc, const Rect &merge_area)
 {
     XCAM_FAIL_RETURN (
         ERROR,
         merge_area.pos_y == 0 && merge_area.height == (int32_t)in_desc.height &&
         merge_area.pos_x + merge_area.width <= (int32_t)in_desc.width &&
-        merge_area.width == (int32_t)out_desc.width * 2 &&
-        merge_area.height == (int32_t)out_desc.height * 2,
-        false, "invalid buffer size: input:%dx%d, output:%dx%d, merge_area:%dx%d",
-        in_desc.width, in_desc.height, out_desc.width, out_desc.height, merge_area.width, merge_area.height);
+        merge_area.width == (int32_t)gauss_desc.width * 2 && merge_area.height == (int32_t)gauss_desc.height * 2 &&
+        merge_area.width == (int32_t)lap_desc.width && merge_area.height == (int32_t)lap_desc.height,
+        false,
+        "invalid buffer size: input:%dx%d, gauss:%dx%d, lap:%dx%d, merge_area:%dx%d",
+        in_desc.width, in_desc.height, gauss_desc.width, gauss_desc.height,
+        lap_desc.width, lap_desc.height, merge_area.width, merge_area.height);
 
     return true;
 }
 
 XCamReturn
-GLGaussScalePyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
+GLGaussLapPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
 {
-    SmartPtr<GLGaussScalePyrShader::Args> args = base.dynamic_cast_ptr<GLGaussScalePyrShader::Args> ();
-    XCAM_ASSERT (args.ptr () && args->in_glbuf.ptr () && args->out_glbuf.ptr ());
+    SmartPtr<GLGaussLapPyrShader::Args> args = base.dynamic_cast_ptr<GLGaussLapPyrShader::Args> ();
+    XCAM_ASSERT (args.ptr () && args->in_glbuf.ptr () && args->gauss_glbuf.ptr () && args->lap_glbuf.ptr ());
 
     const GLBufferDesc &in_desc = args->in_glbuf->get_buffer_desc ();
-    const GLBufferDesc &out_desc = args->out_glbuf->get_buffer_desc ();
+    const GLBufferDesc &gauss_desc = args->gauss_glbuf->get_buffer_desc ();
+    const GLBufferDesc &lap_desc = args->lap_glbuf->get_buffer_desc ();
     const Rect &merge_area = args->merge_area;
     XCAM_FAIL_RETURN (
-        ERROR, check_desc (in_desc, out_desc, merge_area), XCAM_RETURN_ERROR_PARAM,
-        "GLGaussScalePyrShader(%s) check buffer description failed, level:%d idx:%d",
+        ERROR, check_desc (in_desc, gauss_desc, lap_desc, merge_area), XCAM_RETURN_ERROR_PARAM,
+        "GLGaussLapPyrShader(%s) check buffer description failed, level:%d idx:%d",
         XCAM_STR (get_name ()), args->level, (int)args->idx);
 
     cmds.push_back (new GLCmdBindBufRange (args->in_glbuf, 0, NV12PlaneYIdx));
     cmds.push_back (new GLCmdBindBufRange (args->in_glbuf, 1, NV12PlaneUVIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 2, NV12PlaneYIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 3, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->gauss_glbuf, 2, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->gauss_glbuf, 3, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->lap_glbuf, 4, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->lap_glbuf, 5, NV12PlaneUVIdx));
 
     size_t unit_bytes = sizeof (uint32_t);
     uint32_t in_img_width = XCAM_ALIGN_UP (in_desc.width, unit_bytes) / unit_bytes;
     uint32_t in_offset_x = XCAM_ALIGN_UP (merge_area.pos_x, unit_bytes) / unit_bytes;
-    uint32_t out_img_width = XCAM_ALIGN_UP (out_desc.width, unit_bytes) / unit_bytes;
     uint32_t merge_width = XCAM_ALIGN_UP (merge_area.width, unit_bytes) / unit_bytes;
+    uint32_t gauss_img_width = XCAM_ALIGN_UP (gauss_desc.width, unit_bytes) / unit_bytes;
+    uint32_t lap_img_width = XCAM_ALIGN_UP (lap_desc.width, unit_bytes * 2) / (unit_bytes * 2);
     cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_width", in_img_width));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_height", in_desc.height));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("in_offset_x", in_offset_x));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("out_img_width", out_img_width));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("merge_width", merge_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("gauss_img_width", gauss_img_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("gauss_img_height", gauss_desc.height));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("lap_img_width", lap_img_width));
 
+    // one invocation for 4 gauss pixels of 2 rows, work group of 8x8 shares gauss tile
     GLGroupsSize groups_size;
-    groups_size.x = XCAM_ALIGN_UP (out_img_width, 8) / 8;
-    groups_size.y = XCAM_ALIGN_UP (out_desc.height, 16) / 16;
+    groups_size.x = XCAM_ALIGN_UP (gauss_img_width, 8) / 8;
+    groups_size.y = XCAM_ALIGN_UP (gauss_desc.height, 16) / 16;
     groups_size.z = 1;
 
     SmartPtr<GLComputeProgram> prog;
     XCAM_FAIL_RETURN (
         ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
-        "GLGaussScalePyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
+        "GLGaussLapPyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
     prog->set_groups_size (groups_size);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 bool
-GLLapTransPyrShader::check_desc (
-    const GLBufferDesc &in_desc, const GLBufferDesc &out_desc,
-    const GLBufferDesc &gs_desc, const Rect &merge_area)
+GLBlendPyrShader::check_desc (
+    const GLBufferDesc &in0_desc, const GLBufferDesc &in1_desc,
+    const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc)
 {
     XCAM_FAIL_RETURN (
         ERROR,
-        merge_area.pos_y == 0 && merge_area.height == (int32_t)in_desc.height &&
-        merge_area.pos_x + merge_area.width <= (int32_t)in_desc.width &&
-        merge_area.width == (int32_t)out_desc.width && merge_area.height == (int32_t)out_desc.height &&
-        merge_area.width == (int32_t)gs_desc.width * 2 && merge_area.height == (int32_t)gs_desc.height * 2,
+        in0_desc.width == in1_desc.width && in0_desc.height == in1_desc.height &&
+        in0_desc.width == out_desc.width && in0_desc.height == out_desc.height &&
+        in0_desc.width == mask_desc.width,
         false,
-        "invalid buffer size: intput:%dx%d, output:%dx%d, gaussscale:%dx%d, in_area:%dx%d",
-        in_desc.width, in_desc.height, out_desc.width, out_desc.height,
-        gs_desc.width, gs_desc.height, merge_area.width, merge_area.height);
+        "invalid buffer size: intput0:%dx%d, intput1:%dx%d, output:%dx%d, mask:%dx%d",
+        in0_desc.width, in0_desc.height, in1_desc.width, in1_desc.height,
+        out_desc.width, out_desc.height, mask_desc.width, mask_desc.height);
+
+    XCAM_FAIL_RETURN (
+        ERROR, mask_desc.height == 1, false,
+        "mask buffer only supports one-dimensional array");
 
     return true;
 }
 
 XCamReturn
-GLLapTransPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
+GLBlendPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
 {
-    SmartPtr<GLLapTransPyrShader::Args> args = base.dynamic_cast_ptr<GLLapTransPyrShader::Args> ();
-    XCAM_ASSERT (args.ptr () && args->in_glbuf.ptr () && args->gaussscale_glbuf.ptr () && args->out_glbuf.ptr ());
+    SmartPtr<GLBlendPyrShader::Args> args = base.dynamic_cast_ptr<GLBlendPyrShader::Args> ();
+    XCAM_ASSERT (args.ptr () && args->in0_glbuf.ptr () && args->in1_glbuf.ptr () && args->out_glbuf.ptr ());
+    XCAM_ASSERT (args->mask_glbuf.ptr ());
 
-    const GLBufferDesc &in_desc = args->in_glbuf->get_buffer_desc ();
-    const GLBufferDesc &gs_desc = args->gaussscale_glbuf->get_buffer_desc ();
+    const GLBufferDesc &in0_desc = args->in0_glbuf->get_buffer_desc ();
+    const GLBufferDesc &in1_desc = args->in1_glbuf->get_buffer_desc ();
     const GLBufferDesc &out_desc = args->out_glbuf->get_buffer_desc ();
-    const Rect &merge_area = args->merge_area;
+    const GLBufferDesc &mask_desc = args->mask_glbuf->get_buffer_desc ();
     XCAM_FAIL_RETURN (
-        ERROR, check_desc (in_desc, out_desc, gs_desc, merge_area), XCAM_RETURN_ERROR_PARAM,
-        "GLLapTransPyrShader(%s) check buffer description failed, level:%d idx:%d",
-        XCAM_STR (get_name ()), args->level, (int)args->idx);
+        ERROR, check_desc (in0_desc, in1_desc, out_desc, mask_desc), XCAM_RETURN_ERROR_PARAM,
+        "GLBlendPyrShader(%s) check buffer description failed", XCAM_STR (get_name ()));
 
-    cmds.push_back (new GLCmdBindBufRange (args->in_glbuf, 0, NV12PlaneYIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->in_glbuf, 1, NV12PlaneUVIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->gaussscale_glbuf, 2, NV12PlaneYIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->gaussscale_glbuf, 3, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->in0_glbuf, 0, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->in0_glbuf, 1, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->in1_glbuf, 2, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->in1_glbuf, 3, NV12PlaneUVIdx));
     cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 4, NV12PlaneYIdx));
     cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 5, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufBase (args->mask_glbuf, 6));
 
     size_t unit_bytes = sizeof (uint32_t) * 2;
-    uint32_t in_img_width = XCAM_ALIGN_UP (in_desc.width, unit_bytes) / unit_bytes;
-    uint32_t in_offset_x = XCAM_ALIGN_UP (merge_area.pos_x, unit_bytes) / unit_bytes;
-    uint32_t gaussscale_img_width = XCAM_ALIGN_UP (gs_desc.width, sizeof (uint32_t)) / sizeof (uint32_t);
-    uint32_t merge_width = XCAM_ALIGN_UP (merge_area.width, unit_bytes) / unit_bytes;
+    uint32_t in_img_width = XCAM_ALIGN_UP (in0_desc.width, unit_bytes) / unit_bytes;
     cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_width", in_img_width));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_height", in_desc.height));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("in_offset_x", in_offset_x));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("gaussscale_img_width", gaussscale_img_width));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("gaussscale_img_height", gs_desc.height));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("merge_width", merge_width));
 
     GLGroupsSize groups_size;
-    groups_size.x = XCAM_ALIGN_UP (merge_width, 8) / 8;
-    groups_size.y = XCAM_ALIGN_UP (merge_area.height, 32) / 32;
+    groups_size.x = XCAM_ALIGN_UP (in_img_width, 8) / 8;
+    groups_size.y = XCAM_ALIGN_UP (in0_desc.height, 16) / 16;
     groups_size.z = 1;
 
     SmartPtr<GLComputeProgram> prog;
     XCAM_FAIL_RETURN (
         ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
-        "GLLapTransPyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
+        "GLBlendPyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
     prog->set_groups_size (groups_size);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 bool
-GLBlendPyrShader::check_desc (
+GLBlendFeatherShader::check_desc (
     const GLBufferDesc &in0_desc, const GLBufferDesc &in1_desc,
-    const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc)
+    const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc,
+    const Rect &in0_area, const Rect &in1_area, const Rect &out_area)
 {
     XCAM_FAIL_RETURN (
         ERROR,
-        in0_desc.width == in1_desc.width && in0_desc.height == in1_desc.height &&
-        in0_desc.width == out_desc.width && in0_desc.height == out_desc.height &&
-        in0_desc.width == mask_desc.width,
+        in0_area.pos_y == 0 && in1_area.pos_y == 0 && out_area.pos_y == 0 &&
+        in0_area.width == out_area.width && in1_area.width == out_area.width &&
+        in0_area.height == out_area.height && in1_area.height == out_area.height &&
+        in0_area.pos_x + in0_area.width <= (int32_t)in0_desc.width &&
+        in1_area.pos_x + in1_area.width <= (int32_t)in1_desc.width &&
+        out_area.pos_x + out_area.width <= (int32_t)out_desc.width &&
+        out_area.height <= (int32_t)in0_desc.height && out_area.height <= (int32_t)in1_desc.height &&
+        out_area.height <= (int32_t)out_desc.height &&
+        out_area.width == (int32_t)mask_desc.width,
         false,
-        "invalid buffer size: intput0:%dx%d, intput1:%dx%d, output:%dx%d, mask:%dx%d",
-        in0_desc.width, in0_desc.height, in1_desc.width, in1_desc.height,
-        out_desc.width, out_desc.height, mask_desc.width, mask_desc.height);
+        "invalid merge areas: input0:%dx%d(x:%d w:%d), input1:%dx%d(x:%d w:%d), output:%dx%d(x:%d w:%d h:%d), mask:%d",
+        in0_desc.width, in0_desc.height, in0_area.pos_x, in0_area.width,
+        in1_desc.width, in1_desc.height, in1_area.pos_x, in1_area.width,
+        out_desc.width, out_desc.height, out_area.pos_x, out_area.width, out_area.height, mask_desc.width);
 
     XCAM_FAIL_RETURN (
         ERROR, mask_desc.height == 1, false,
@@ -208,9 +229,9 @@ GLBlendPyrShader::check_desc (
 }
 
 XCamReturn
-GLBlendPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
+GLBlendFeatherShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
 {
-    SmartPtr<GLBlendPyrShader::Args> args = base.dynamic_cast_ptr<GLBlendPyrShader::Args> ();
+    SmartPtr<GLBlendFeatherShader::Args> args = base.dynamic_cast_ptr<GLBlendFeatherShader::Args> ();
     XCAM_ASSERT (args.ptr () && args->in0_glbuf.ptr () && args->in1_glbuf.ptr () && args->out_glbuf.ptr ());
     XCAM_ASSERT (args->mask_glbuf.ptr ());
 
@@ -219,8 +240,10 @@ GLBlendPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GL
     const GLBufferDesc &out_desc = args->out_glbuf->get_buffer_desc ();
     const GLBufferDesc &mask_desc = args->mask_glbuf->get_buffer_desc ();
     XCAM_FAIL_RETURN (
-        ERROR, check_desc (in0_desc, in1_desc, out_desc, mask_desc), XCAM_RETURN_ERROR_PARAM,
-        "GLBlendPyrShader(%s) check buffer description failed", XCAM_STR (get_name ()));
+        ERROR,
+        check_desc (in0_desc, in1_desc, out_desc, mask_desc, args->in0_area, args->in1_area, args->out_area),
+        XCAM_RETURN_ERROR_PARAM,
+        "GLBlendFeatherShader(%s) check buffer description failed", XCAM_STR (get_name ()));
 
     cmds.push_back (new GLCmdBindBufRange (args->in0_glbuf, 0, NV12PlaneYIdx));
     cmds.push_back (new GLCmdBindBufRange (args->in0_glbuf, 1, NV12PlaneUVIdx));
@@ -231,18 +254,26 @@ GLBlendPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GL
     cmds.push_back (new GLCmdBindBufBase (args->mask_glbuf, 6));
 
     size_t unit_bytes = sizeof (uint32_t) * 2;
-    uint32_t in_img_width = XCAM_ALIGN_UP (in0_desc.width, unit_bytes) / unit_bytes;
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_width", in_img_width));
+    uint32_t merge_width = XCAM_ALIGN_UP (args->out_area.width, unit_bytes) / unit_bytes;
+    uint32_t merge_uv_height = args->out_area.height / 2;
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("in0_img_width", XCAM_ALIGN_UP (in0_desc.width, unit_bytes) / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("in0_offset_x", args->in0_area.pos_x / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("in1_img_width", XCAM_ALIGN_UP (in1_desc.width, unit_bytes) / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("in1_offset_x", args->in1_area.pos_x / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("out_img_width", XCAM_ALIGN_UP (out_desc.width, unit_bytes) / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("out_offset_x", args->out_area.pos_x / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("merge_width", merge_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("merge_uv_height", merge_uv_height));
 
     GLGroupsSize groups_size;
-    groups_size.x = XCAM_ALIGN_UP (in_img_width, 8) / 8;
-    groups_size.y = XCAM_ALIGN_UP (in0_desc.height, 16) / 16;
+    groups_size.x = XCAM_ALIGN_UP (merge_width, 8) / 8;
+    groups_size.y = XCAM_ALIGN_UP (merge_uv_height, 8) / 8;
     groups_size.z = 1;
 
     SmartPtr<GLComputeProgram> prog;
     XCAM_FAIL_RETURN (
         ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
-        "GLBlendPyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
+        "GLBlendFeatherShader(%s) get compute program failed", XCAM_STR (get_name ()));
     prog->set_groups_size (groups_size);
 
     return XCAM_RETURN_NO_ERROR;
@@ -329,34 +360,122 @@ GLReconstructPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &ba
     return XCAM_RETURN_NO_ERROR;
 }
 
-SmartPtr<GLGaussScalePyrShader>
-create_gauss_scale_pyr_shader (SmartPtr<Worker::Callback> &cb)
+bool
+GLBlendReconstructPyrShader::is_supported ()
 {
-    XCAM_ASSERT (cb.ptr ());
+    GLint max_blocks = 0;
+    glGetIntegerv (GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &max_blocks);
+    XCAM_FAIL_RETURN (
+        WARNING, max_blocks >= XCAM_GL_BLEND_RECONSTRUCT_BLOCKS, false,
+        "GLBlendReconstructPyrShader unsupported, max compute storage blocks:%d", max_blocks);
 
-    SmartPtr<GLGaussScalePyrShader> shader = new GLGaussScalePyrShader (cb);
-    XCAM_ASSERT (shader.ptr ());
+    return true;
+}
 
-    XCamReturn ret = shader->create_compute_program (shaders_info[ShaderGaussScalePyr], "gauss_scale_pyr_program");
+bool
+GLBlendReconstructPyrShader::check_desc (
+    const GLBufferDesc &lap0_desc, const GLBufferDesc &lap1_desc, const GLBufferDesc &out_desc,
+    const GLBufferDesc &prev0_desc, const GLBufferDesc &prev1_desc,
+    const GLBufferDesc &mask_desc, const GLBufferDesc &prev_mask_desc, const Rect &merge_area)
+{
     XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR, NULL,
-        "create gauss scale pyramid program failed");
+        ERROR,
+        merge_area.pos_y == 0 && merge_area.height == (int32_t)out_desc.height &&
+        merge_area.pos_x + merge_area.width <= (int32_t)out_desc.width &&
+        merge_area.width == (int32_t)lap0_desc.width && merge_area.height == (int32_t)lap0_desc.height &&
+        lap0_desc.width == lap1_desc.width && lap0_desc.height == lap1_desc.height &&
+        prev0_desc.width == prev1_desc.width && prev0_desc.height == prev1_desc.height &&
+        lap0_desc.width == prev0_desc.width * 2 && lap0_desc.height == prev0_desc.height * 2 &&
+        lap0_desc.width == mask_desc.width && prev0_desc.width == prev_mask_desc.width,
+        false,
+        "invalid buffer size: lap0:%dx%d, lap1:%dx%d, output:%dx%d, prev0:%dx%d, prev1:%dx%d, "
+        "mask:%d, prev_mask:%d, merge_area:%dx%d",
+        lap0_desc.width, lap0_desc.height, lap1_desc.width, lap1_desc.height,
+        out_desc.width, out_desc.height, prev0_desc.width, prev0_desc.height,
+        prev1_desc.width, prev1_desc.height, mask_desc.width, prev_mask_desc.width,
+        merge_area.width, merge_area.height);
 
-    return shader;
+    XCAM_FAIL_RETURN (
+        ERROR, mask_desc.height == 1 && prev_mask_desc.height == 1, false,
+        "mask buffer only supports one-dimensional array");
+
+    return true;
+}
+
+XCamReturn
+GLBlendReconstructPyrShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
+{
+    SmartPtr<GLBlendReconstructPyrShader::Args> args = base.dynamic_cast_ptr<GLBlendReconstructPyrShader::Args> ();
+    XCAM_ASSERT (args.ptr () && args->lap0_glbuf.ptr () && args->lap1_glbuf.ptr () && args->out_glbuf.ptr ());
+    XCAM_ASSERT (args->prev_blend_glbuf.ptr () && args->prev1_glbuf.ptr ());
+    XCAM_ASSERT (args->mask_glbuf.ptr () && args->prev_mask_glbuf.ptr ());
+
+    const GLBufferDesc &lap0_desc = args->lap0_glbuf->get_buffer_desc ();
+    const GLBufferDesc &lap1_desc = args->lap1_glbuf->get_buffer_desc ();
+    const GLBufferDesc &out_desc = args->out_glbuf->get_buffer_desc ();
+    const GLBufferDesc &prev0_desc = args->prev_blend_glbuf->get_buffer_desc ();
+    const GLBufferDesc &prev1_desc = args->prev1_glbuf->get_buffer_desc ();
+    const GLBufferDesc &mask_desc = args->mask_glbuf->get_buffer_desc ();
+    const GLBufferDesc &prev_mask_desc = args->prev_mask_glbuf->get_buffer_desc ();
+    const Rect &merge_area = args->merge_area;
+    XCAM_FAIL_RETURN (
+        ERROR,
+        check_desc (lap0_desc, lap1_desc, out_desc, prev0_desc, prev1_desc, mask_desc, prev_mask_desc, merge_area),
+        XCAM_RETURN_ERROR_PARAM,
+        "GLBlendReconstructPyrShader(%s) check buffer description failed, level:%d",
+        XCAM_STR (get_name ()), args->level);
+
+    cmds.push_back (new GLCmdBindBufRange (args->lap0_glbuf, 0, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->lap0_glbuf, 1, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->lap1_glbuf, 2, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->lap1_glbuf, 3, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 4, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->out_glbuf, 5, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->prev_blend_glbuf, 6, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->prev_blend_glbuf, 7, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->prev1_glbuf, 8, NV12PlaneYIdx));
+    cmds.push_back (new GLCmdBindBufRange (args->prev1_glbuf, 9, NV12PlaneUVIdx));
+    cmds.push_back (new GLCmdBindBufBase (args->mask_glbuf, 10));
+    cmds.push_back (new GLCmdBindBufBase (args->prev_mask_glbuf, 11));
+
+    size_t unit_bytes = sizeof (uint32_t) * 2;
+    uint32_t lap_img_width = XCAM_ALIGN_UP (lap0_desc.width, unit_bytes) / unit_bytes;
+    uint32_t out_img_width = XCAM_ALIGN_UP (out_desc.width, unit_bytes) / unit_bytes;
+    uint32_t out_offset_x = XCAM_ALIGN_UP (merge_area.pos_x, unit_bytes) / unit_bytes;
+    uint32_t prev_blend_img_width = XCAM_ALIGN_UP (prev0_desc.width, sizeof (uint32_t)) / sizeof (uint32_t);
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("lap_img_width", lap_img_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("lap_img_height", lap0_desc.height));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("out_img_width", out_img_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("out_offset_x", out_offset_x));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("prev_blend_img_width", prev_blend_img_width));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("prev_blend_img_height", prev0_desc.height));
+
+    GLGroupsSize groups_size;
+    groups_size.x = XCAM_ALIGN_UP (lap_img_width, 8) / 8;
+    groups_size.y = XCAM_ALIGN_UP (lap0_desc.height, 32) / 32;
+    groups_size.z = 1;
+
+    SmartPtr<GLComputeProgram> prog;
+    XCAM_FAIL_RETURN (
+        ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
+        "GLBlendReconstructPyrShader(%s) get compute program failed", XCAM_STR (get_name ()));
+    prog->set_groups_size (groups_size);
+
+    return XCAM_RETURN_NO_ERROR;
 }
 
-SmartPtr<GLLapTransPyrShader>
-create_lap_trans_pyr_shader (SmartPtr<Worker::Callback> &cb)
+SmartPtr<GLGaussLapPyrShader>
+create_gauss_lap_pyr_shader (SmartPtr<Worker::Callback> &cb)
 {
     XCAM_ASSERT (cb.ptr ());
 
-    SmartPtr<GLLapTransPyrShader> shader = new GLLapTransPyrShader (cb);
+    SmartPtr<GLGaussLapPyrShader> shader = new GLGaussLapPyrShader (cb);
     XCAM_ASSERT (shader.ptr ());
 
-    XCamReturn ret = shader->create_compute_program (shaders_info[ShaderLapTransPyr], "lap_trans_pyr_program");
+    XCamReturn ret = shader->create_compute_program (shaders_info[ShaderGaussLapPyr], "gauss_lap_pyr_program");
     XCAM_FAIL_RETURN (
         ERROR, ret == XCAM_RETURN_NO_ERROR, NULL,
-        "create laplace transformation pyramid program failed");
+        "create gauss laplace pyramid program failed");
 
     return shader;
 }
@@ -377,6 +496,22 @@ create_blend_pyr_shader (SmartPtr<Worker::Callback> &cb)
     return shader;
 }
 
+SmartPtr<GLBlendFeatherShader>
+create_blend_feather_shader (SmartPtr<Worker::Callback> &cb)
+{
+    XCAM_ASSERT (cb.ptr ());
+
+    SmartPtr<GLBlendFeatherShader> shader = new GLBlendFeatherShader (cb);
+    XCAM_ASSERT (shader.ptr ());
+
+    XCamReturn ret = shader->create_compute_program (shaders_info[ShaderBlendFeather], "blend_feather_program");
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR, NULL,
+        "create blend feather program failed");
+
+    return shader;
+}
+
 SmartPtr<GLReconstructPyrShader>
 create_reconstruct_pyr_shader (SmartPtr<Worker::Callback> &cb)
 {
@@ -393,6 +528,23 @@ create_reconstruct_pyr_shader (SmartPtr<Worker::Callback> &cb)
     return shader;
 }
 
+SmartPtr<GLBlendReconstructPyrShader>
+create_blend_reconstruct_pyr_shader (SmartPtr<Worker::Callback> &cb)
+{
+    XCAM_ASSERT (cb.ptr ());
+
+    SmartPtr<GLBlendReconstructPyrShader> shader = new GLBlendReconstructPyrShader (cb);
+    XCAM_ASSERT (shader.ptr ());
+
+    XCamReturn ret = shader->create_compute_program (
+        shaders_info[ShaderBlendReconstructPyr], "blend_reconstruct_pyr_program");
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR, NULL,
+        "create blend reconstruct pyramid program failed");
+
+    return shader;
+}
+
 }
 
 }
@@ -30,22 +30,27 @@
 #define GL_BLENDER_ALIGN_X 8
 #define GL_BLENDER_ALIGN_Y 4
 
+#define XCAM_GL_BLEND_RECONSTRUCT_BLOCKS 12
+
 namespace XCam {
 
 namespace XCamGLShaders {
 
-class GLGaussScalePyrShader
+// gauss of next level and laplace of current level in one pass
+class GLGaussLapPyrShader
     : public GLImageShader
 {
 public:
     struct Args : GLArgs {
         SmartPtr<GLBuffer>         in_glbuf;
-        SmartPtr<GLBuffer>         out_glbuf;
+        SmartPtr<GLBuffer>         gauss_glbuf;
+        SmartPtr<GLBuffer>         lap_glbuf;
         Rect                       merge_area;
 
         const uint32_t             level;
         const GLBlender::BufIdx    idx;
-        SmartPtr<VideoBuffer>      out_video_buf;
+        SmartPtr<VideoBuffer>      gauss_video_buf;
+        SmartPtr<VideoBuffer>      lap_video_buf;
 
         Args (
             const SmartPtr<ImageHandler::Parameters> &param,
@@ -57,51 +62,48 @@ public:
     };
 
 public:
-    explicit GLGaussScalePyrShader (const SmartPtr<Worker::Callback> &cb)
-        : GLImageShader ("GLGaussScalePyrShader", cb)
+    explicit GLGaussLapPyrShader (const SmartPtr<Worker::Callback> &cb)
+        : GLImageShader ("GLGaussLapPyrShader", cb)
     {}
 
 private:
     virtual XCamReturn prepare_arguments (const SmartPtr<Worker::Arguments> &args, GLCmdList &cmds);
-    bool check_desc (const GLBufferDesc &in_desc, const GLBufferDesc &out_desc, const Rect &merge_area);
+    bool check_desc (
+        const GLBufferDesc &in_desc, const GLBufferDesc &gauss_desc,
+        const GLBufferDesc &lap_desc, const Rect &merge_area);
 };
 
-class GLLapTransPyrShader
+class GLBlendPyrShader
     : public GLImageShader
 {
 public:
     struct Args : GLArgs {
-        SmartPtr<GLBuffer>         in_glbuf;
-        SmartPtr<GLBuffer>         out_glbuf;
-        SmartPtr<GLBuffer>         gaussscale_glbuf;
-        Rect                       merge_area;
+        SmartPtr<GLBuffer>       in0_glbuf;
+        SmartPtr<GLBuffer>       in1_glbuf;
+        SmartPtr<GLBuffer>       out_glbuf;
+        SmartPtr<GLBuffer>       mask_glbuf;
 
-        const uint32_t             level;
-        const GLBlender::BufIdx    idx;
-        SmartPtr<VideoBuffer>      out_video_buf;
+        SmartPtr<VideoBuffer>    out_video_buf;
 
-        Args (
-            const SmartPtr<ImageHandler::Parameters> &param,
-            uint32_t l, GLBlender::BufIdx i)
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
             : GLArgs (param)
-            , level (l)
-            , idx (i)
         {}
     };
 
 public:
-    explicit GLLapTransPyrShader (const SmartPtr<Worker::Callback> &cb)
-        : GLImageShader ("GLLapTransPyrShader", cb)
+    explicit GLBlendPyrShader (const SmartPtr<Worker::Callback> &cb)
+        : GLImageShader ("GLBlendPyrShader", cb)
     {}
 
 private:
     virtual XCamReturn prepare_arguments (const SmartPtr<Worker::Arguments> &args, GLCmdList &cmds);
     bool check_desc (
-        const GLBufferDesc &in_desc, const GLBufferDesc &out_desc,
-        const GLBufferDesc &gs_desc, const Rect &merge_area);
+        const GLBufferDesc &in0_desc, const GLBufferDesc &in1_desc,
+        const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc);
 };
 
-class GLBlendPyrShader
+// blends merge areas of full inputs straight into output merge window
+class GLBlendFeatherShader
     : public GLImageShader
 {
 public:
@@ -110,8 +112,7 @@ public:
         SmartPtr<GLBuffer>       in1_glbuf;
         SmartPtr<GLBuffer>       out_glbuf;
         SmartPtr<GLBuffer>       mask_glbuf;
-
-        SmartPtr<VideoBuffer>    out_video_buf;
+        Rect                     in0_area, in1_area, out_area;
 
         Args (const SmartPtr<ImageHandler::Parameters> &param)
             : GLArgs (param)
@@ -119,15 +120,16 @@ public:
     };
 
 public:
-    explicit GLBlendPyrShader (const SmartPtr<Worker::Callback> &cb)
-        : GLImageShader ("GLBlendPyrShader", cb)
+    explicit GLBlendFeatherShader (const SmartPtr<Worker::Callback> &cb)
+        : GLImageShader ("GLBlendFeatherShader", cb)
     {}
 
 private:
     virtual XCamReturn prepare_arguments (const SmartPtr<Worker::Arguments> &args, GLCmdList &cmds);
     bool check_desc (
         const GLBufferDesc &in0_desc, const GLBufferDesc &in1_desc,
-        const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc);
+        const GLBufferDesc &out_desc, const GLBufferDesc &mask_desc,
+        const Rect &in0_area, const Rect &in1_area, const Rect &out_area);
 };
 
 class GLReconstructPyrShader
@@ -163,18 +165,52 @@ private:
         const GLBufferDesc &prev_blend_desc, const GLBufferDesc &mask_desc, const Rect &merge_area);
 };
 
-SmartPtr<GLGaussScalePyrShader>
-create_gauss_scale_pyr_shader (SmartPtr<Worker::Callback> &cb);
+// blends top gauss levels of both inputs while reconstructing top laplace level
+class GLBlendReconstructPyrShader
+    : public GLImageShader
+{
+public:
+    // prev_blend_glbuf is top gauss level of input 0
+    struct Args : GLReconstructPyrShader::Args {
+        SmartPtr<GLBuffer>       prev1_glbuf;
+        SmartPtr<GLBuffer>       prev_mask_glbuf;
 
-SmartPtr<GLLapTransPyrShader>
-create_lap_trans_pyr_shader (SmartPtr<Worker::Callback> &cb);
+        Args (const SmartPtr<ImageHandler::Parameters> &param, uint32_t l)
+            : GLReconstructPyrShader::Args (param, l)
+        {}
+    };
+
+public:
+    explicit GLBlendReconstructPyrShader (const SmartPtr<Worker::Callback> &cb)
+        : GLImageShader ("GLBlendReconstructPyrShader", cb)
+    {}
+
+    // needs XCAM_GL_BLEND_RECONSTRUCT_BLOCKS compute storage blocks
+    static bool is_supported ();
+
+private:
+    virtual XCamReturn prepare_arguments (const SmartPtr<Worker::Arguments> &args, GLCmdList &cmds);
+    bool check_desc (
+        const GLBufferDesc &lap0_desc, const GLBufferDesc &lap1_desc, const GLBufferDesc &out_desc,
+        const GLBufferDesc &prev0_desc, const GLBufferDesc &prev1_desc,
+        const GLBufferDesc &mask_desc, const GLBufferDesc &prev_mask_desc, const Rect &merge_area);
+};
+
+SmartPtr<GLGaussLapPyrShader>
+create_gauss_lap_pyr_shader (SmartPtr<Worker::Callback> &cb);
 
 SmartPtr<GLBlendPyrShader>
 create_blend_pyr_shader (SmartPtr<Worker::Callback> &cb);
 
+SmartPtr<GLBlendFeatherShader>
+create_blend_feather_shader (SmartPtr<Worker::Callback> &cb);
+
 SmartPtr<GLReconstructPyrShader>
 create_reconstruct_pyr_shader (SmartPtr<Worker::Callback> &cb);
 
+SmartPtr<GLBlendReconstructPyrShader>
+create_blend_reconstruct_pyr_shader (SmartPtr<Worker::Callback> &cb);
+
 }
 
 }
@@ -19,9 +19,76 @@
  */
 
 #include "gl_buffer.h"
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
 
 namespace XCam {
 
+static PFNGLBUFFERSTORAGEEXTPROC
+get_buffer_storage_func ()
+{
+    static PFNGLBUFFERSTORAGEEXTPROC func = NULL;
+    static bool queried = false;
+    if (queried)
+        return func;
+
+    queried = true;
+    const char *exts = (const char *)glGetString (GL_EXTENSIONS);
+    if (!exts || !strstr (exts, "GL_EXT_buffer_storage")) {
+        XCAM_LOG_WARNING ("GL_EXT_buffer_storage is not supported, persistent mapping disabled");
+        return NULL;
+    }
+
+    func = (PFNGLBUFFERSTORAGEEXTPROC) eglGetProcAddress ("glBufferStorageEXT");
+    return func;
+}
+
+GLSync::GLSync (GLsync sync)
+    : _sync (sync)
+{
+}
+
+GLSync::~GLSync ()
+{
+    if (_sync)
+        glDeleteSync (_sync);
+}
+
+SmartPtr<GLSync>
+GLSync::create_fence ()
+{
+    GLsync sync = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GLenum error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, sync && (error == GL_NO_ERROR), NULL,
+        "GL create fence sync failed, error flag: %s", gl_error_string (error));
+
+    // make sure the fence reaches GPU, other contexts may wait on it
+    glFlush ();
+    return new GLSync (sync);
+}
+
+XCamReturn
+GLSync::wait (uint64_t timeout)
+{
+    GLenum status = glClientWaitSync (_sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    XCAM_FAIL_RETURN (
+        ERROR, status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED,
+        (status == GL_TIMEOUT_EXPIRED) ? XCAM_RETURN_ERROR_TIMEOUT : XCAM_RETURN_ERROR_GLES,
+        "GL wait fence sync failed, status: 0x%04x, error flag: %s",
+        status, gl_error_string (gl_error ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+GLSync::is_signaled ()
+{
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv (_sync, GL_SYNC_STATUS, sizeof (status), NULL, &status);
+    return status == GL_SIGNALED;
+}
+
 GLBufferDesc::GLBufferDesc ()
     : format (V4L2_PIX_FMT_NV12)
     , width (0)
@@ -63,7 +130,10 @@ GLBuffer::GLBuffer (GLuint id, GLenum target, GLenum usage, uint32_t size)
     , _usage (usage)
     , _buf_id (id)
     , _size (size)
+    , _persistent_ptr (NULL)
+    , _mem_charge (MemoryGL)
 {
+    _mem_charge.charge (size);
 }
 
 XCamReturn
@@ -79,6 +149,7 @@ GLBuffer::bind ()
 
 GLBuffer::~GLBuffer ()
 {
+    _fence.release ();
     if (_buf_id) {
         glDeleteBuffers (1, &_buf_id);
 
@@ -123,12 +194,70 @@ GLBuffer::create_buffer (
     return buf_obj;
 }
 
+SmartPtr<GLBuffer>
+GLBuffer::create_persistent_buffer (GLenum target, uint32_t size)
+{
+    XCAM_ASSERT (size > 0);
+
+    PFNGLBUFFERSTORAGEEXTPROC buffer_storage = get_buffer_storage_func ();
+    if (!buffer_storage)
+        return NULL;
+
+    GLuint buf_id = 0;
+    glGenBuffers (1, &buf_id);
+    GLenum error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, buf_id && (error == GL_NO_ERROR), NULL,
+        "GL persistent buffer creation failed, error flag: %s", gl_error_string (error));
+
+    // buffer is deleted by GLBuffer on failures below
+    SmartPtr<GLBuffer> buf_obj = new GLBuffer (buf_id, target, GL_DYNAMIC_DRAW, size);
+
+    glBindBuffer (target, buf_id);
+    XCAM_FAIL_RETURN (
+        ERROR, (error = gl_error ()) == GL_NO_ERROR, NULL,
+        "GL persistent buffer creation failed when bind buffer:%d, error flag: %s",
+        buf_id, gl_error_string (error));
+
+    GLbitfield flags =
+        GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT | GL_MAP_COHERENT_BIT_EXT;
+    buffer_storage (target, size, NULL, flags);
+    XCAM_FAIL_RETURN (
+        ERROR, (error = gl_error ()) == GL_NO_ERROR, NULL,
+        "GL persistent buffer creation failed in glBufferStorageEXT, id:%d, error flag: %s",
+        buf_id, gl_error_string (error));
+
+    void *ptr = glMapBufferRange (target, 0, size, flags);
+    error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, ptr && (error == GL_NO_ERROR), NULL,
+        "GL persistent buffer map failed, id:%d, error flag: %s",
+        buf_id, gl_error_string (error));
+
+    buf_obj->_persistent_ptr = ptr;
+    return buf_obj;
+}
+
 void *
 GLBuffer::map_range (uint32_t offset, uint32_t length, GLbitfield flags)
 {
     if (length == 0)
         length = _size;
 
+    if (is_persistent ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, offset + length <= _size, NULL,
+            "GL buffer map range out of size, buf_id:%d, offset:%d, len:%d", _buf_id, offset, length);
+
+        if (_fence.ptr ()) {
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (_fence->wait ()), NULL,
+                "GL buffer wait fence failed, buf_id:%d", _buf_id);
+            _fence.release ();
+        }
+        return (uint8_t *)_persistent_ptr + offset;
+    }
+
     if (_mapped_range.is_mapped () &&
             _mapped_range.flags == flags &&
             _mapped_range.offset == offset &&
@@ -160,6 +289,9 @@ GLBuffer::map_range (uint32_t offset, uint32_t length, GLbitfield flags)
 XCamReturn
 GLBuffer::flush_map ()
 {
+    if (is_persistent ())
+        return XCAM_RETURN_NO_ERROR;
+
     if (!_mapped_range.is_mapped ())
         return XCAM_RETURN_ERROR_ORDER;
 
@@ -188,6 +320,9 @@ GLBuffer::flush_map ()
 XCamReturn
 GLBuffer::unmap ()
 {
+    if (is_persistent ())
+        return XCAM_RETURN_NO_ERROR;
+
     if (!_mapped_range.is_mapped ())
         return XCAM_RETURN_ERROR_ORDER;
 
@@ -22,9 +22,11 @@
 #define XCAM_GL_BUFFER_H
 
 #include <gles/gles_std.h>
+#include <memory_accounting.h>
 #include <map>
 
 #define XCAM_GL_MAX_COMPONENTS 4
+#define XCAM_GL_SYNC_TIMEOUT (2000 * 1000 * 1000ULL) // 2s in ns
 
 namespace XCam {
 
@@ -42,6 +44,26 @@ struct GLBufferDesc {
     GLBufferDesc ();
 };
 
+class GLSync
+{
+public:
+    ~GLSync ();
+    static SmartPtr<GLSync> create_fence ();
+
+    XCamReturn wait (uint64_t timeout = XCAM_GL_SYNC_TIMEOUT);
+    // query without blocking or flushing
+    bool is_signaled ();
+
+private:
+    explicit GLSync (GLsync sync);
+
+private:
+    XCAM_DEAD_COPY (GLSync);
+
+private:
+    GLsync        _sync;
+};
+
 class GLBuffer
 {
 public:
@@ -49,6 +71,10 @@ public:
     static SmartPtr<GLBuffer> create_buffer (
         GLenum target, const GLvoid *data = NULL, uint32_t size = 0, GLenum usage = GL_STATIC_DRAW);
 
+    // immutable storage mapped once with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT,
+    // return NULL if GL_EXT_buffer_storage is not supported
+    static SmartPtr<GLBuffer> create_persistent_buffer (GLenum target, uint32_t size);
+
     GLuint get_buffer_id () const {
         return _buf_id;
     }
@@ -61,6 +87,9 @@ public:
     uint32_t get_size () const {
         return _size;
     }
+    bool is_persistent () const {
+        return _persistent_ptr != NULL;
+    }
 
     void set_buffer_desc (const GLBufferDesc &desc) {
         _desc = desc;
@@ -69,6 +98,14 @@ public:
         return _desc;
     }
 
+    // persistent buffers wait for the fence of last GPU access instead of remapping
+    void set_fence (const SmartPtr<GLSync> &fence) {
+        _fence = fence;
+    }
+    bool is_fenced () const {
+        return _fence.ptr () != NULL;
+    }
+
     void *map_range (
         uint32_t offset = 0, uint32_t length = 0,
         GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
@@ -103,6 +140,9 @@ private:
     uint32_t      _size;
     MapRange      _mapped_range;
     GLBufferDesc  _desc;
+    void         *_persistent_ptr;
+    SmartPtr<GLSync>  _fence;
+    MemoryCharge  _mem_charge;
 };
 
 }
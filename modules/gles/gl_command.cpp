@@ -153,6 +153,125 @@ GLenum uniform_mat <GLfloat, 4> (GLint location, const GLfloat *value, GLsizei c
 
 }
 
+Mutex GLUniformCache::_mutex;
+std::map<GLuint, GLUniformCache::Program> GLUniformCache::_programs;
+
+GLint
+GLUniformCache::get_location (GLuint program, const GLchar *name)
+{
+    SmartLock locker (_mutex);
+    std::map<std::string, GLint> &locations = _programs[program].locations;
+    std::map<std::string, GLint>::iterator i = locations.find (name);
+    if (i != locations.end ())
+        return i->second;
+
+    GLint location = glGetUniformLocation (program, name);
+    GLenum error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, error == GL_NO_ERROR, -1,
+        "get_uniform_location failed, name:%s, error flag: %s",
+        XCAM_STR (name), gl_error_string (error));
+
+    if (location < 0) {
+        XCAM_LOG_WARNING (
+            "get_uniform_location invalid or unnecessary parameter, name:%s location:%d",
+            XCAM_STR (name), location);
+    }
+    locations[name] = location;
+    return location;
+}
+
+bool
+GLUniformCache::is_dirty (GLuint program, GLint location, const void *value, uint32_t size)
+{
+    SmartLock locker (_mutex);
+    std::map<GLint, std::vector<uint8_t> > &values = _programs[program].values;
+    std::map<GLint, std::vector<uint8_t> >::iterator i = values.find (location);
+    if (i == values.end ())
+        return true;
+
+    return i->second.size () != size || memcmp (i->second.data (), value, size);
+}
+
+void
+GLUniformCache::set_uploaded (GLuint program, GLint location, const void *value, uint32_t size)
+{
+    SmartLock locker (_mutex);
+    const uint8_t *bytes = (const uint8_t *)value;
+    _programs[program].values[location].assign (bytes, bytes + size);
+}
+
+void
+GLUniformCache::forget (GLuint program, GLint location)
+{
+    SmartLock locker (_mutex);
+    _programs[program].values.erase (location);
+}
+
+XCamReturn
+GLUniformCache::upload_block (
+    GLuint program, const GLchar *name, uint32_t binding, const void *value, uint32_t size)
+{
+    SmartLock locker (_mutex);
+    std::map<std::string, Block> &blocks = _programs[program].blocks;
+    std::map<std::string, Block>::iterator i = blocks.find (name);
+
+    if (i == blocks.end ()) {
+        GLuint index = glGetUniformBlockIndex (program, name);
+        GLenum error = gl_error ();
+        XCAM_FAIL_RETURN (
+            ERROR, error == GL_NO_ERROR && index != GL_INVALID_INDEX, XCAM_RETURN_ERROR_GLES,
+            "get uniform block(%s) index failed, error flag: %s", XCAM_STR (name), gl_error_string (error));
+
+        glUniformBlockBinding (program, index, binding);
+        error = gl_error ();
+        XCAM_FAIL_RETURN (
+            ERROR, error == GL_NO_ERROR, XCAM_RETURN_ERROR_GLES,
+            "uniform block(%s) binding:%d failed, error flag: %s", XCAM_STR (name), binding, gl_error_string (error));
+
+        SmartPtr<GLBuffer> buf = GLBuffer::create_buffer (GL_UNIFORM_BUFFER, value, size, GL_DYNAMIC_DRAW);
+        XCAM_FAIL_RETURN (
+            ERROR, buf.ptr (), XCAM_RETURN_ERROR_GLES,
+            "create buffer of uniform block(%s) failed, size:%d", XCAM_STR (name), size);
+
+        Block &block = blocks[name];
+        block.index = index;
+        block.binding = binding;
+        block.buf = buf;
+        block.data.assign ((const uint8_t *)value, (const uint8_t *)value + size);
+        i = blocks.find (name);
+    } else {
+        Block &block = i->second;
+        XCAM_FAIL_RETURN (
+            ERROR, block.binding == binding && block.data.size () == size, XCAM_RETURN_ERROR_PARAM,
+            "uniform block(%s) changed binding(%d->%d) or size(%d->%d)", XCAM_STR (name),
+            block.binding, binding, (uint32_t)block.data.size (), size);
+
+        if (memcmp (block.data.data (), value, size)) {
+            void *ptr = block.buf->map_range (0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            XCAM_FAIL_RETURN (
+                ERROR, ptr, XCAM_RETURN_ERROR_GLES,
+                "map buffer of uniform block(%s) failed", XCAM_STR (name));
+            memcpy (ptr, value, size);
+            XCamReturn ret = block.buf->unmap ();
+            XCAM_FAIL_RETURN (
+                ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+                "unmap buffer of uniform block(%s) failed", XCAM_STR (name));
+            block.data.assign ((const uint8_t *)value, (const uint8_t *)value + size);
+        }
+    }
+
+    // binding points are context state shared by all programs
+    return i->second.buf->bind_buffer_base (binding);
+}
+
+void
+GLUniformCache::clear (GLuint program)
+{
+    SmartLock locker (_mutex);
+    _programs.erase (program);
+}
+
 GLCmdUniform::GLCmdUniform (const GLchar *name)
 {
     XCAM_ASSERT (name);
@@ -166,33 +285,48 @@ GLCmdUniform::~GLCmdUniform ()
 XCamReturn
 GLCmdUniform::run (GLuint program)
 {
-    GLint location = get_uniform_location (program, _name);
+    GLint location = GLUniformCache::get_location (program, _name);
     XCAM_FAIL_RETURN (ERROR, location >= 0, XCAM_RETURN_ERROR_UNKNOWN, "get_uniform_location failed");
 
+    uint32_t size = 0;
+    const void *value = get_value (size);
+    if (!GLUniformCache::is_dirty (program, location, value, size))
+        return XCAM_RETURN_NO_ERROR;
+
     GLenum error = uniform (location);
-    XCAM_FAIL_RETURN (
-        ERROR, error == GL_NO_ERROR, XCAM_RETURN_ERROR_UNKNOWN,
-        "uniform failed, name:%s, error flag: %s", _name, gl_error_string (error));
+    if (error != GL_NO_ERROR) {
+        GLUniformCache::forget (program, location);
+        XCAM_LOG_ERROR ("uniform failed, name:%s, error flag: %s", _name, gl_error_string (error));
+        return XCAM_RETURN_ERROR_UNKNOWN;
+    }
+    GLUniformCache::set_uploaded (program, location, value, size);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
-GLint
-GLCmdUniform::get_uniform_location (GLuint program, const GLchar *name)
+GLCmdUniformBlock::GLCmdUniformBlock (const GLchar *name, uint32_t binding, const void *value, uint32_t size)
+    : _binding (binding)
 {
-    GLint location = glGetUniformLocation (program, name);
-    GLenum error = gl_error ();
-    XCAM_FAIL_RETURN (
-        ERROR, error == GL_NO_ERROR, -1,
-        "get_uniform_location failed, name:%s, error flag: %s",
-        XCAM_STR (name), gl_error_string (error));
+    XCAM_ASSERT (name && value && size);
+    strncpy (_name, name, XCAM_GL_NAME_LENGTH - 1);
+    _name[XCAM_GL_NAME_LENGTH - 1] = '\0';
+    _value.assign ((const uint8_t *)value, (const uint8_t *)value + size);
+}
 
+GLCmdUniformBlock::~GLCmdUniformBlock ()
+{
+}
+
+XCamReturn
+GLCmdUniformBlock::run (GLuint program)
+{
+    XCamReturn ret = GLUniformCache::upload_block (
+        program, _name, _binding, _value.data (), (uint32_t)_value.size ());
     XCAM_FAIL_RETURN (
-        WARNING, location >= 0, -1,
-        "get_uniform_location invalid or unnecessary parameter, name:%s location:%d",
-        XCAM_STR (name), location);
+        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+        "GLCmdUniformBlock failed, name:%s, binding:%d", _name, _binding);
 
-    return location;
+    return XCAM_RETURN_NO_ERROR;
 }
 
 GLCmdBindBufBase::GLCmdBindBufBase (const SmartPtr<GLBuffer> &buf, uint32_t index)
@@ -219,6 +353,34 @@ GLCmdBindBufBase::run (GLuint program)
     return XCAM_RETURN_NO_ERROR;
 }
 
+GLCmdBindTexture::GLCmdBindTexture (GLuint texture, uint32_t unit, GLenum target)
+    : _texture (texture)
+    , _unit (unit)
+    , _target (target)
+{
+    XCAM_ASSERT (texture);
+}
+
+GLCmdBindTexture::~GLCmdBindTexture ()
+{
+}
+
+XCamReturn
+GLCmdBindTexture::run (GLuint program)
+{
+    XCAM_UNUSED (program);
+
+    glActiveTexture (GL_TEXTURE0 + _unit);
+    glBindTexture (_target, _texture);
+    GLenum error = gl_error ();
+    XCAM_FAIL_RETURN (
+        ERROR, error == GL_NO_ERROR, XCAM_RETURN_ERROR_GLES,
+        "GLCmdBindTexture failed, texture:%d, unit:%d, error flag: %s",
+        _texture, _unit, gl_error_string (error));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 GLCmdBindBufRange::GLCmdBindBufRange (const SmartPtr<GLBuffer> &buf, uint32_t index, uint32_t offset_x)
     : _index (index)
     , _offset (offset_x)
@@ -22,10 +22,16 @@
 #define XCAM_GL_COMMAND_H
 
 #include <list>
+#include <map>
+#include <string>
+#include <vector>
 #include <gles/gles_std.h>
+#include <xcam_mutex.h>
 
 namespace XCam {
 
+class GLBuffer;
+
 namespace UniformOps {
 
 template <typename TType>
@@ -41,6 +47,46 @@ template <typename TType, uint32_t TDim>
 GLenum uniform_mat (GLint location, const TType *value, GLsizei count = 1);
 }
 
+/*
+ * GLUniformCache, uniform locations, uniform block buffers and last uploaded
+ * values of each program. a program keeps its uniform values between
+ * dispatches, so commands skip the upload when the value didn't change.
+ * entries of a program must be cleared once it is relinked or deleted.
+ */
+class GLUniformCache
+{
+    struct Block {
+        GLuint                  index;
+        uint32_t                binding;
+        SmartPtr<GLBuffer>      buf;
+        std::vector<uint8_t>    data;
+    };
+
+    struct Program {
+        std::map<std::string, GLint>            locations;
+        std::map<GLint, std::vector<uint8_t> >  values;
+        std::map<std::string, Block>            blocks;
+    };
+
+public:
+    // -1 if @name is not an active uniform, the answer is cached either way
+    static GLint get_location (GLuint program, const GLchar *name);
+    // true if @value differs from the last one uploaded to @location
+    static bool is_dirty (GLuint program, GLint location, const void *value, uint32_t size);
+    static void set_uploaded (GLuint program, GLint location, const void *value, uint32_t size);
+    static void forget (GLuint program, GLint location);
+
+    // uniform block @name gets @value through its own buffer bound at @binding
+    static XCamReturn upload_block (
+        GLuint program, const GLchar *name, uint32_t binding, const void *value, uint32_t size);
+
+    static void clear (GLuint program);
+
+private:
+    static Mutex                       _mutex;
+    static std::map<GLuint, Program>   _programs;
+};
+
 class GLCommand
 {
 public:
@@ -66,8 +112,8 @@ protected:
     explicit GLCmdUniform (const GLchar *name);
 
 private:
-    GLint get_uniform_location (GLuint program, const GLchar *name);
     virtual GLenum uniform (GLint location) = 0;
+    virtual const void *get_value (uint32_t &size) const = 0;
 
 protected:
     GLchar        _name[XCAM_GL_NAME_LENGTH];
@@ -89,6 +135,10 @@ private:
     virtual GLenum uniform (GLint location) {
         return UniformOps::uniform <TType> (location, _value);
     }
+    virtual const void *get_value (uint32_t &size) const {
+        size = sizeof (_value);
+        return &_value;
+    }
 
 private:
     TType        _value;
@@ -112,6 +162,10 @@ private:
     virtual GLenum uniform (GLint location) {
         return UniformOps::uniform_array <TType> (location, _value, TCount);
     }
+    virtual const void *get_value (uint32_t &size) const {
+        size = sizeof (_value);
+        return &_value[0];
+    }
 
 private:
     TType        _value[TCount];
@@ -135,6 +189,10 @@ private:
     virtual GLenum uniform (GLint location) {
         return UniformOps::uniform_vect <TType, TDim> (location, _value, TCount);
     }
+    virtual const void *get_value (uint32_t &size) const {
+        size = sizeof (_value);
+        return &_value[0];
+    }
 
 private:
     TType        _value[TDim * TCount];
@@ -162,12 +220,43 @@ private:
 
         return UniformOps::uniform_mat <TType, TColumns> (location, _value, TCount);
     }
+    virtual const void *get_value (uint32_t &size) const {
+        size = sizeof (_value);
+        return &_value[0];
+    }
 
 private:
     TType        _value[TColumns * TRows * TCount];
 };
 
-class GLBuffer;
+/*
+ * uniform block parameters: @value is the whole block in std140 layout,
+ * bound at @binding; re-uploaded only when some byte of it changed
+ */
+class GLCmdUniformBlock
+    : public GLCommand
+{
+public:
+    GLCmdUniformBlock (const GLchar *name, uint32_t binding, const void *value, uint32_t size);
+    virtual ~GLCmdUniformBlock ();
+
+    virtual XCamReturn run (GLuint program);
+
+private:
+    GLchar                    _name[XCAM_GL_NAME_LENGTH];
+    uint32_t                  _binding;
+    std::vector<uint8_t>      _value;
+};
+
+template <typename TBlock>
+class GLCmdUniformBlockT
+    : public GLCmdUniformBlock
+{
+public:
+    GLCmdUniformBlockT (const GLchar *name, uint32_t binding, const TBlock &value)
+        : GLCmdUniformBlock (name, binding, &value, sizeof (TBlock))
+    {}
+};
 
 class GLCmdBindBufBase
     : public GLCommand
@@ -183,6 +272,21 @@ private:
     uint32_t                  _index;
 };
 
+class GLCmdBindTexture
+    : public GLCommand
+{
+public:
+    GLCmdBindTexture (GLuint texture, uint32_t unit, GLenum target = GL_TEXTURE_2D);
+    virtual ~GLCmdBindTexture ();
+
+    virtual XCamReturn run (GLuint program);
+
+private:
+    GLuint                    _texture;
+    uint32_t                  _unit;
+    GLenum                    _target;
+};
+
 class GLCmdBindBufRange
     : public GLCommand
 {
@@ -169,6 +169,9 @@ GLCopyHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
 XCamReturn
 GLCopyHandler::terminate ()
 {
+    if (is_off_executor ())
+        return terminate_on_executor ();
+
     if (_copy_shader.ptr ()) {
         _copy_shader.release ();
     }
@@ -0,0 +1,274 @@
+/*
+ * gl_executor.cpp - GL executor thread owning a context
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "gl_executor.h"
+#include "egl/egl_base.h"
+#include <xcam_thread.h>
+#include <sched.h>
+
+namespace XCam {
+
+static __thread GLExecutor *tls_executor = NULL;
+
+class GLExecutorThread
+    : public Thread
+{
+public:
+    GLExecutorThread (GLExecutor *executor, const char *name)
+        : Thread (name)
+        , _executor (executor)
+    {}
+
+protected:
+    virtual bool started () {
+        return _executor->thread_started ();
+    }
+    virtual void stopped () {
+        _executor->thread_stopped ();
+    }
+    virtual bool loop () {
+        return _executor->thread_loop ();
+    }
+
+private:
+    GLExecutor     *_executor;
+};
+
+class GLSyncJob
+    : public GLExecutor::Job
+{
+public:
+    explicit GLSyncJob (const SmartPtr<GLExecutor::Job> &job)
+        : _job (job)
+        , _done (false)
+        , _result (XCAM_RETURN_NO_ERROR)
+    {}
+
+    virtual XCamReturn run () {
+        return _job->run ();
+    }
+
+    virtual void done (XCamReturn error) {
+        _job->done (error);
+
+        SmartLock locker (_mutex);
+        _result = error;
+        _done = true;
+        _cond.broadcast ();
+    }
+
+    XCamReturn wait () {
+        SmartLock locker (_mutex);
+        while (!_done)
+            _cond.wait (_mutex);
+        return _result;
+    }
+
+private:
+    SmartPtr<GLExecutor::Job>    _job;
+    Mutex                        _mutex;
+    Cond                         _cond;
+    bool                         _done;
+    XCamReturn                   _result;
+};
+
+static void
+run_job (const SmartPtr<GLExecutor::Job> &job)
+{
+    XCamReturn ret = job->run ();
+    job->done (ret);
+}
+
+GLExecutor::GLExecutor (const char *name, uint32_t capacity)
+    : _jobs (capacity)
+    , _accepting (false)
+    , _submitting (0)
+    , _init_done (false)
+    , _init_ok (false)
+{
+    _thread = new GLExecutorThread (this, name);
+    XCAM_ASSERT (_thread.ptr ());
+}
+
+GLExecutor::~GLExecutor ()
+{
+    XCAM_ASSERT (!is_current ());
+    stop ();
+}
+
+XCamReturn
+GLExecutor::start ()
+{
+    if (_accepting.load ())
+        return XCAM_RETURN_NO_ERROR;
+
+    {
+        SmartLock locker (_mutex);
+        _init_done = false;
+        _init_ok = false;
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, _thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "GLExecutor(%s) start thread failed", XCAM_STR (_thread->get_name ()));
+
+    bool ok = false;
+    {
+        SmartLock locker (_mutex);
+        while (!_init_done)
+            _ready_cond.wait (_mutex);
+        ok = _init_ok;
+    }
+
+    if (!ok) {
+        _thread->stop ();
+        XCAM_LOG_ERROR ("GLExecutor(%s) init context failed", XCAM_STR (_thread->get_name ()));
+        return XCAM_RETURN_ERROR_GLES;
+    }
+
+    _accepting = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLExecutor::stop ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !is_current (), XCAM_RETURN_ERROR_THREAD,
+        "GLExecutor(%s) can not stop on its own thread", XCAM_STR (_thread->get_name ()));
+
+    if (!_accepting.exchange (false))
+        return XCAM_RETURN_NO_ERROR;
+
+    // jobs of submitters past the running check are pushed before the queue is paused
+    while (_submitting.load ())
+        sched_yield ();
+
+    _jobs.pause_pop ();
+    _thread->stop ();
+    _jobs.resume_pop ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLExecutor::submit (const SmartPtr<Job> &job)
+{
+    XCAM_ASSERT (job.ptr ());
+
+    ++_submitting;
+    if (!_accepting.load ()) {
+        --_submitting;
+        XCAM_LOG_ERROR ("GLExecutor(%s) submit job failed, not running", XCAM_STR (_thread->get_name ()));
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    bool ok = true;
+    if (!is_current ()) {
+        ok = _jobs.push (job);
+    } else if (!_jobs.try_push (job)) {
+        // no one else pops the queue, run the job now instead of blocking
+        --_submitting;
+        run_job (job);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    --_submitting;
+
+    XCAM_FAIL_RETURN (
+        ERROR, ok, XCAM_RETURN_ERROR_THREAD,
+        "GLExecutor(%s) push job failed", XCAM_STR (_thread->get_name ()));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLExecutor::run_sync (const SmartPtr<Job> &job)
+{
+    XCAM_ASSERT (job.ptr ());
+
+    if (is_current ()) {
+        XCamReturn ret = job->run ();
+        job->done (ret);
+        return ret;
+    }
+
+    SmartPtr<GLSyncJob> sync_job = new GLSyncJob (job);
+    XCAM_ASSERT (sync_job.ptr ());
+
+    XCamReturn ret = submit (sync_job);
+    if (!xcam_ret_is_ok (ret))
+        return ret;
+
+    return sync_job->wait ();
+}
+
+bool
+GLExecutor::is_current () const
+{
+    return tls_executor == this;
+}
+
+GLExecutor *
+GLExecutor::get_current ()
+{
+    return tls_executor;
+}
+
+bool
+GLExecutor::thread_started ()
+{
+    tls_executor = this;
+
+    _egl = new EGLBase ();
+    XCAM_ASSERT (_egl.ptr ());
+    bool ok = _egl->init ();
+    if (!ok)
+        _egl.release ();
+
+    SmartLock locker (_mutex);
+    _init_done = true;
+    _init_ok = ok;
+    _ready_cond.broadcast ();
+
+    return ok;
+}
+
+bool
+GLExecutor::thread_loop ()
+{
+    SmartPtr<Job> job = _jobs.pop ();
+    if (!job.ptr ())
+        return _accepting.load ();
+
+    run_job (job);
+    return true;
+}
+
+void
+GLExecutor::thread_stopped ()
+{
+    SmartPtr<Job> job;
+    while ((job = _jobs.try_pop ()).ptr ())
+        run_job (job);
+
+    _egl.release ();
+    tls_executor = NULL;
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * gl_executor.h - GL executor thread owning a context
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_GL_EXECUTOR_H
+#define XCAM_GL_EXECUTOR_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <safe_ring.h>
+#include <atomic>
+
+#define XCAM_GL_EXECUTOR_QUEUE_CAPACITY 64
+
+namespace XCam {
+
+class EGLBase;
+class GLExecutorThread;
+
+/*
+ * GLExecutor, thread owning an EGL context, GL work is posted to it as jobs through
+ * a lock-free queue and run in order there, callers need no current context.
+ * handlers of several pipelines set to one executor share its context.
+ */
+class GLExecutor
+    : public RefObj
+{
+    friend class GLExecutorThread;
+
+public:
+    class Job {
+    public:
+        Job () {}
+        virtual ~Job () {}
+
+        // runs on executor thread with its context current
+        virtual XCamReturn run () = 0;
+        // called on executor thread with result of run
+        virtual void done (XCamReturn error) {
+            XCAM_UNUSED (error);
+        }
+
+    private:
+        XCAM_DEAD_COPY (Job);
+    };
+
+public:
+    explicit GLExecutor (
+        const char *name = "gl-executor", uint32_t capacity = XCAM_GL_EXECUTOR_QUEUE_CAPACITY);
+    // need be released out of executor thread
+    ~GLExecutor ();
+
+    // returns once context is current on executor thread
+    XCamReturn start ();
+    // jobs queued before stop still run
+    XCamReturn stop ();
+    bool is_running () const {
+        return _accepting.load ();
+    }
+
+    // returns at once, blocks only while the queue is full
+    XCamReturn submit (const SmartPtr<Job> &job);
+    // returns result of @job, runs it in place on executor thread
+    XCamReturn run_sync (const SmartPtr<Job> &job);
+
+    bool is_current () const;
+    // executor of calling thread, NULL out of executor threads
+    static GLExecutor *get_current ();
+
+private:
+    bool thread_started ();
+    bool thread_loop ();
+    void thread_stopped ();
+
+    XCAM_DEAD_COPY (GLExecutor);
+
+private:
+    SmartPtr<GLExecutorThread>    _thread;
+    SmartPtr<EGLBase>             _egl;
+    SafeRing<Job>                 _jobs;
+    std::atomic<bool>             _accepting;
+    std::atomic<uint32_t>         _submitting;
+    Mutex                         _mutex;
+    Cond                          _ready_cond;
+    bool                          _init_done;
+    bool                          _init_ok;
+};
+
+}
+
+#endif // XCAM_GL_EXECUTOR_H
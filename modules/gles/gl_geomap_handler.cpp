@@ -20,12 +20,18 @@
 
 #include "gl_geomap_handler.h"
 #include "gl_utils.h"
+#include "gl_buffer.h"
 
 #define XCAM_GL_GEOMAP_ALIGN_X 4
 #define XCAM_GL_GEOMAP_ALIGN_Y 2
 
+// storage buffers of shader_geomap with redirect buffer
+#define XCAM_GL_GEOMAP_REDIRECT_BLOCKS 6
+
 namespace XCam {
 
+static_assert (sizeof (PointFloat2) == 2 * sizeof (float), "look up table is uploaded as float pairs");
+
 DECLARE_WORK_CALLBACK (CbGeoMapShader, GLGeoMapHandler, geomap_shader_done);
 
 const GLShaderInfo shader_info = {
@@ -35,6 +41,158 @@ const GLShaderInfo shader_info = {
     , 0
 };
 
+const GLShaderInfo batch_shader_info = {
+    GL_COMPUTE_SHADER,
+    "shader_geomap_batch",
+#include "shader_geomap_batch.comp.slx"
+    , 0
+};
+
+// std140 layout of CameraParam in shader_geomap_batch
+struct GeoMapCameraParam {
+    uint32_t    in_info[4];
+    uint32_t    out_info[4];
+    uint32_t    lut_info[4];
+    float       lut_step[4];
+    float       lut_std_step[4];
+};
+
+const GLShaderInfo tex_shader_info = {
+    GL_COMPUTE_SHADER,
+    "shader_geomap_tex",
+#include "shader_geomap_tex.comp.slx"
+    , 0
+};
+
+static bool
+is_dma_input (const SmartPtr<VideoBuffer> &buf)
+{
+    if (buf.dynamic_cast_ptr<GLVideoBuffer> ().ptr () || buf->get_fd () < 0)
+        return false;
+
+    return EGLDmaImage::is_supported ();
+}
+
+bool
+GLGeoMapBatchShader::is_supported (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, count > 0 && count <= XCAM_GL_GEOMAP_BATCH_MAX, false,
+        "GLGeoMapBatchShader unsupported camera count:%d, max:%d", count, XCAM_GL_GEOMAP_BATCH_MAX);
+
+    GLint major = 0, minor = 0, max_blocks = 0;
+    glGetIntegerv (GL_MAJOR_VERSION, &major);
+    glGetIntegerv (GL_MINOR_VERSION, &minor);
+    glGetIntegerv (GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &max_blocks);
+    XCAM_FAIL_RETURN (
+        WARNING, (major > 3 || (major == 3 && minor >= 2)) && max_blocks >= 3 * XCAM_GL_GEOMAP_BATCH_MAX, false,
+        "GLGeoMapBatchShader unsupported, GLES version:%d.%d, max compute storage blocks:%d",
+        major, minor, max_blocks);
+
+    return true;
+}
+
+XCamReturn
+GLGeoMapBatchShader::init ()
+{
+    XCamReturn ret = create_compute_program (batch_shader_info, "geomap_batch_program");
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+        "GLGeoMapBatchShader(%s) create compute program failed", XCAM_STR (get_name ()));
+
+    // dewarp outputs are read by blenders and copiers right after
+    SmartPtr<GLComputeProgram> prog;
+    XCAM_FAIL_RETURN (
+        ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
+        "GLGeoMapBatchShader(%s) get compute program failed", XCAM_STR (get_name ()));
+    prog->set_barrier (true);
+
+    uint32_t size = sizeof (GeoMapCameraParam) * XCAM_GL_GEOMAP_BATCH_MAX;
+    _param_buf = GLBuffer::create_buffer (GL_UNIFORM_BUFFER, NULL, size, GL_DYNAMIC_DRAW);
+    XCAM_FAIL_RETURN (
+        ERROR, _param_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "GLGeoMapBatchShader(%s) create param buffer failed", XCAM_STR (get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLGeoMapBatchShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
+{
+    SmartPtr<GLGeoMapBatchShader::Args> args = base.dynamic_cast_ptr<GLGeoMapBatchShader::Args> ();
+    XCAM_ASSERT (args.ptr () && _param_buf.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, args->count > 0 && args->count <= XCAM_GL_GEOMAP_BATCH_MAX, XCAM_RETURN_ERROR_PARAM,
+        "GLGeoMapBatchShader(%s) invalid camera count:%d", XCAM_STR (get_name ()), args->count);
+
+    GeoMapCameraParam params[XCAM_GL_GEOMAP_BATCH_MAX];
+    xcam_mem_clear (params);
+
+    size_t unit_bytes = sizeof (uint32_t);
+    uint32_t max_width = 0, max_height = 0;
+    for (uint32_t i = 0; i < args->count; ++i) {
+        XCAM_ASSERT (args->in_bufs[i].ptr () && args->out_bufs[i].ptr () && args->lut_bufs[i].ptr ());
+        const float *factors = args->factors[i];
+        XCAM_FAIL_RETURN (
+            ERROR,
+            !XCAM_DOUBLE_EQUAL_AROUND (factors[0], 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factors[1], 0.0f) &&
+            !XCAM_DOUBLE_EQUAL_AROUND (factors[2], 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factors[3], 0.0f),
+            XCAM_RETURN_ERROR_PARAM,
+            "GLGeoMapBatchShader(%s) invalid factors of camera(idx:%d): %f, %f, %f, %f",
+            XCAM_STR (get_name ()), i, factors[0], factors[1], factors[2], factors[3]);
+
+        const GLBufferDesc &in_desc = args->in_bufs[i]->get_buffer_desc ();
+        const GLBufferDesc &out_desc = args->out_bufs[i]->get_buffer_desc ();
+        const GLBufferDesc &lut_desc = args->lut_bufs[i]->get_buffer_desc ();
+
+        GeoMapCameraParam &param = params[i];
+        param.in_info[0] = XCAM_ALIGN_UP (in_desc.width, unit_bytes) / unit_bytes;
+        param.in_info[1] = in_desc.height;
+        param.in_info[2] = in_desc.offsets[NV12PlaneUVIdx] / unit_bytes;
+        param.out_info[0] = XCAM_ALIGN_UP (out_desc.width, unit_bytes) / unit_bytes;
+        param.out_info[1] = out_desc.height;
+        param.out_info[2] = out_desc.offsets[NV12PlaneUVIdx] / unit_bytes;
+        param.lut_info[0] = lut_desc.width;
+        param.lut_info[1] = lut_desc.height;
+        for (uint32_t j = 0; j < 4; ++j)
+            param.lut_step[j] = 1.0f / factors[j];
+        param.lut_std_step[0] = args->std_steps[i][0];
+        param.lut_std_step[1] = args->std_steps[i][1];
+
+        max_width = XCAM_MAX (max_width, param.out_info[0]);
+        max_height = XCAM_MAX (max_height, param.out_info[1]);
+    }
+
+    void *ptr = _param_buf->map_range (0, sizeof (params), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr, XCAM_RETURN_ERROR_GLES,
+        "GLGeoMapBatchShader(%s) map param buffer failed", XCAM_STR (get_name ()));
+    memcpy (ptr, params, sizeof (params));
+    _param_buf->unmap ();
+
+    // unused slots alias camera 0, they are never indexed
+    for (uint32_t i = 0; i < XCAM_GL_GEOMAP_BATCH_MAX; ++i) {
+        uint32_t idx = (i < args->count) ? i : 0;
+        cmds.push_back (new GLCmdBindBufBase (args->in_bufs[idx], i));
+        cmds.push_back (new GLCmdBindBufBase (args->out_bufs[idx], XCAM_GL_GEOMAP_BATCH_MAX + i));
+        cmds.push_back (new GLCmdBindBufBase (args->lut_bufs[idx], XCAM_GL_GEOMAP_BATCH_MAX * 2 + i));
+    }
+    cmds.push_back (new GLCmdBindBufBase (_param_buf, 0));
+
+    GLGroupsSize groups_size;
+    groups_size.x = XCAM_ALIGN_UP (max_width, 8) / 8;
+    groups_size.y = XCAM_ALIGN_UP (max_height, 16) / 16;
+    groups_size.z = args->count;
+
+    SmartPtr<GLComputeProgram> prog;
+    XCAM_FAIL_RETURN (
+        ERROR, get_compute_program (prog), XCAM_RETURN_ERROR_PARAM,
+        "GLGeoMapBatchShader(%s) get compute program failed", XCAM_STR (get_name ()));
+    prog->set_groups_size (groups_size);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 bool
 GLGeoMapShader::set_std_step (float factor_x, float factor_y)
 {
@@ -52,7 +210,8 @@ XCamReturn
 GLGeoMapShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCmdList &cmds)
 {
     SmartPtr<GLGeoMapShader::Args> args = base.dynamic_cast_ptr<GLGeoMapShader::Args> ();
-    XCAM_ASSERT (args.ptr () && args->in_buf.ptr () && args->out_buf.ptr () && args->lut_buf.ptr ());
+    XCAM_ASSERT (args.ptr () && args->out_buf.ptr () && args->lut_buf.ptr ());
+    XCAM_ASSERT (args->in_buf.ptr () || (args->in_tex_y && args->in_tex_uv));
     XCAM_FAIL_RETURN (
         ERROR,
         !XCAM_DOUBLE_EQUAL_AROUND (args->factors[0], 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (args->factors[1], 0.0f) &&
@@ -61,24 +220,63 @@ GLGeoMapShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCm
         "GLGeoMapHandler(%s) invalid factors: %f, %f, %f, %f",
         XCAM_STR (get_name ()), args->factors[0], args->factors[1], args->factors[2], args->factors[3]);
 
-    const GLBufferDesc &in_desc = args->in_buf->get_buffer_desc ();
     const GLBufferDesc &out_desc = args->out_buf->get_buffer_desc ();
     const GLBufferDesc &lut_desc = args->lut_buf->get_buffer_desc ();
 
-    cmds.push_back (new GLCmdBindBufRange (args->in_buf, 0, NV12PlaneYIdx));
-    cmds.push_back (new GLCmdBindBufRange (args->in_buf, 1, NV12PlaneUVIdx));
+    uint32_t in_width, in_height;
+    if (args->in_tex_y) {
+        const VideoBufferInfo &in_info = args->get_param ()->in_buf->get_video_info ();
+        in_width = in_info.width;
+        in_height = in_info.height;
+        cmds.push_back (new GLCmdBindTexture (args->in_tex_y, 0));
+        cmds.push_back (new GLCmdBindTexture (args->in_tex_uv, 1));
+    } else {
+        const GLBufferDesc &in_desc = args->in_buf->get_buffer_desc ();
+        in_width = in_desc.width;
+        in_height = in_desc.height;
+        cmds.push_back (new GLCmdBindBufRange (args->in_buf, 0, NV12PlaneYIdx));
+        cmds.push_back (new GLCmdBindBufRange (args->in_buf, 1, NV12PlaneUVIdx));
+    }
     cmds.push_back (new GLCmdBindBufRange (args->out_buf, 2, NV12PlaneYIdx));
     cmds.push_back (new GLCmdBindBufRange (args->out_buf, 3, NV12PlaneUVIdx));
     cmds.push_back (new GLCmdBindBufBase (args->lut_buf, 4));
 
     size_t unit_bytes = sizeof (uint32_t);
-    uint32_t in_img_width = XCAM_ALIGN_UP (in_desc.width, unit_bytes) / unit_bytes;
+    uint32_t in_img_width = XCAM_ALIGN_UP (in_width, unit_bytes) / unit_bytes;
     uint32_t out_img_width = XCAM_ALIGN_UP (out_desc.width, unit_bytes) / unit_bytes;
     cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_width", in_img_width));
-    cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_height", in_desc.height));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("in_img_height", in_height));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("out_img_width", out_img_width));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("out_img_height", out_desc.height));
 
+    // without redirect buffer, out_buf is bound in its place and never written through it
+    uint32_t redirect_count = 0;
+    uint32_t redirect_areas[XCAM_GL_GEOMAP_MAX_REDIRECTS][4];
+    uint32_t redirect_pos[XCAM_GL_GEOMAP_MAX_REDIRECTS][2];
+    xcam_mem_clear (redirect_areas);
+    xcam_mem_clear (redirect_pos);
+
+    const SmartPtr<GLBuffer> &redirect_buf = args->redirect_buf.ptr () ? args->redirect_buf : args->out_buf;
+    const GLBufferDesc &redirect_desc = redirect_buf->get_buffer_desc ();
+    if (args->redirect_buf.ptr ()) {
+        redirect_count = XCAM_MIN (args->redirect_areas.size (), (size_t)XCAM_GL_GEOMAP_MAX_REDIRECTS);
+        for (uint32_t i = 0; i < redirect_count; ++i) {
+            const RedirectArea &area = args->redirect_areas[i];
+            redirect_areas[i][0] = area.in_area.pos_x / unit_bytes;
+            redirect_areas[i][1] = area.in_area.pos_y;
+            redirect_areas[i][2] = (area.in_area.pos_x + area.in_area.width) / unit_bytes;
+            redirect_areas[i][3] = area.in_area.pos_y + area.in_area.height;
+            redirect_pos[i][0] = area.out_x / unit_bytes;
+            redirect_pos[i][1] = area.out_y;
+        }
+    }
+    cmds.push_back (new GLCmdBindBufBase (redirect_buf, 5));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("redirect_count", redirect_count));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("redirect_img_width", redirect_desc.strides[NV12PlaneYIdx] / unit_bytes));
+    cmds.push_back (new GLCmdUniformT<uint32_t> ("redirect_uv_offset", redirect_desc.offsets[NV12PlaneUVIdx] / unit_bytes));
+    cmds.push_back (new GLCmdUniformTVect<uint32_t, 4, XCAM_GL_GEOMAP_MAX_REDIRECTS> ("redirect_areas", &redirect_areas[0][0]));
+    cmds.push_back (new GLCmdUniformTVect<uint32_t, 2, XCAM_GL_GEOMAP_MAX_REDIRECTS> ("redirect_pos", &redirect_pos[0][0]));
+
     cmds.push_back (new GLCmdUniformT<uint32_t> ("lut_width", lut_desc.width));
     cmds.push_back (new GLCmdUniformT<uint32_t> ("lut_height", lut_desc.height));
 
@@ -104,8 +302,38 @@ GLGeoMapShader::prepare_arguments (const SmartPtr<Worker::Arguments> &base, GLCm
     return XCAM_RETURN_NO_ERROR;
 }
 
+class GLLutJob
+    : public GLExecutor::Job
+{
+public:
+    GLLutJob (GLGeoMapHandler *handler, const PointFloat2 *data, uint32_t width, uint32_t height)
+        : _handler (handler)
+        , _data (data)
+        , _width (width)
+        , _height (height)
+    {}
+
+    // NULL @data takes the table shared under the key, bypassed if none
+    virtual XCamReturn run () {
+        if (!_data)
+            return _handler->use_shared_lookup_table () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_BYPASS;
+
+        bool ret = _handler->set_lookup_table (_data, _width, _height);
+        return ret ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_GLES;
+    }
+
+private:
+    GLGeoMapHandler       *_handler;
+    const PointFloat2     *_data;
+    uint32_t               _width;
+    uint32_t               _height;
+};
+
 GLGeoMapHandler::GLGeoMapHandler (const char *name)
     : GLImageHandler (name)
+    , _tex_sampling (true)
+    , _input_mode (InputBuffer)
+    , _table_key (0)
 {
 }
 
@@ -113,6 +341,45 @@ GLGeoMapHandler::~GLGeoMapHandler ()
 {
 }
 
+bool
+GLGeoMapHandler::is_redirect_supported ()
+{
+    GLint max_blocks = 0;
+    glGetIntegerv (GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &max_blocks);
+    XCAM_FAIL_RETURN (
+        WARNING, max_blocks >= XCAM_GL_GEOMAP_REDIRECT_BLOCKS, false,
+        "GLGeoMapHandler redirect unsupported, max compute storage blocks:%d", max_blocks);
+
+    return true;
+}
+
+bool
+GLGeoMapHandler::set_redirect_areas (const RedirectAreas &areas)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, areas.size () <= XCAM_GL_GEOMAP_MAX_REDIRECTS, false,
+        "GLGeoMapHandler(%s) too many redirect areas:%d, max:%d",
+        XCAM_STR (get_name ()), (uint32_t)areas.size (), XCAM_GL_GEOMAP_MAX_REDIRECTS);
+
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const RedirectArea &area = areas[i];
+        XCAM_FAIL_RETURN (
+            ERROR,
+            area.in_area.pos_x >= 0 && area.in_area.pos_y >= 0 && area.in_area.width > 0 && area.in_area.height > 0 &&
+            !(area.in_area.pos_x % XCAM_GL_GEOMAP_ALIGN_X) && !(area.in_area.width % XCAM_GL_GEOMAP_ALIGN_X) &&
+            !(area.out_x % XCAM_GL_GEOMAP_ALIGN_X) &&
+            !(area.in_area.pos_y % XCAM_GL_GEOMAP_ALIGN_Y) && !(area.in_area.height % XCAM_GL_GEOMAP_ALIGN_Y) &&
+            !(area.out_y % XCAM_GL_GEOMAP_ALIGN_Y),
+            false,
+            "GLGeoMapHandler(%s) redirect area(idx:%d) not aligned, in_area(%d, %d, %d, %d) out(%d, %d)",
+            XCAM_STR (get_name ()), i, area.in_area.pos_x, area.in_area.pos_y, area.in_area.width, area.in_area.height,
+            area.out_x, area.out_y);
+    }
+
+    _redirect_areas = areas;
+    return true;
+}
+
 XCamReturn
 GLGeoMapHandler::remap (const SmartPtr<VideoBuffer> &in_buf, SmartPtr<VideoBuffer> &out_buf)
 {
@@ -140,29 +407,84 @@ GLGeoMapHandler::set_lookup_table (const PointFloat2 *data, uint32_t width, uint
         XCAM_STR (get_name ()), data, width, height);
     XCAM_ASSERT (!_lut_buf.ptr ());
 
-    uint32_t lut_size = width * height * 2 * sizeof (float);
-    SmartPtr<GLBuffer> buf = GLBuffer::create_buffer (GL_SHADER_STORAGE_BUFFER, NULL, lut_size);
-    XCAM_ASSERT (buf.ptr ());
+    // table is uploaded in place on executor, @data is kept by the caller meanwhile
+    if (is_off_executor ()) {
+        SmartPtr<GLLutJob> job = new GLLutJob (this, data, width, height);
+        XCAM_ASSERT (job.ptr ());
+        return xcam_ret_is_ok (get_executor ()->run_sync (job));
+    }
+
+    // shader reads x, y float pairs, same layout as PointFloat2, upload @data as is
+    uint32_t lut_size = width * height * sizeof (PointFloat2);
+    SmartPtr<GLBuffer> buf = GLBuffer::create_buffer (GL_SHADER_STORAGE_BUFFER, data, lut_size);
+    XCAM_FAIL_RETURN (
+        ERROR, buf.ptr (), false,
+        "GLGeoMapHandler(%s) create look up table buffer failed", XCAM_STR (get_name ()));
 
     GLBufferDesc desc;
     desc.width = width;
     desc.height = height;
     desc.size = lut_size;
     buf->set_buffer_desc (desc);
+    _lut_buf = SharedTableCache::instance ()->add (SharedGLLookupTable, get_shared_key (), buf, lut_size, _lut_ref);
 
-    float *ptr = (float *) buf->map_range (0, lut_size, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT);
-    XCAM_FAIL_RETURN (ERROR, ptr, false, "GLGeoMapHandler(%s) map range failed", XCAM_STR (get_name ()));
-    for (uint32_t i = 0; i < height; ++i) {
-        float *ret = &ptr[i * width * 2];
-        const PointFloat2 *line = &data[i * width];
+    return true;
+}
 
-        for (uint32_t j = 0; j < width; ++j) {
-            ret[j * 2] = line[j].x;
-            ret[j * 2 + 1] = line[j].y;
-        }
+bool
+GLGeoMapHandler::use_shared_lookup_table ()
+{
+    if (is_off_executor ()) {
+        SmartPtr<GLLutJob> job = new GLLutJob (this, NULL, 0, 0);
+        XCAM_ASSERT (job.ptr ());
+        return get_executor ()->run_sync (job) == XCAM_RETURN_NO_ERROR;
     }
-    buf->unmap ();
+
+    XCAM_ASSERT (!_lut_buf.ptr ());
+    SmartPtr<GLBuffer> buf =
+        SharedTableCache::instance ()->find<GLBuffer> (SharedGLLookupTable, get_shared_key (), _lut_ref);
+    if (!buf.ptr ())
+        return false;
+
     _lut_buf = buf;
+    XCAM_LOG_DEBUG (
+        "GLGeoMapHandler(%s) uses shared look up table(%dx%d)",
+        XCAM_STR (get_name ()), buf->get_buffer_desc ().width, buf->get_buffer_desc ().height);
+    return true;
+}
+
+uint64_t
+GLGeoMapHandler::get_shared_key () const
+{
+    if (!_table_key)
+        return 0;
+
+    // buffers are only valid on the context they are created on
+    EGLContext context = eglGetCurrentContext ();
+    if (context == EGL_NO_CONTEXT)
+        return 0;
+
+    uint64_t key = SharedTableCache::hash (SharedTableCache::HashSeed, &_table_key, sizeof (_table_key));
+    return SharedTableCache::hash (key, &context, sizeof (context));
+}
+
+bool
+GLGeoMapHandler::get_lut_factors (float factors[4], float std_step[2])
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _lut_buf.ptr () && init_factors (), false,
+        "GLGeoMapHandler(%s) get lut factors failed, look up table is empty", XCAM_STR (get_name ()));
+
+    float factor_x, factor_y;
+    get_factors (factor_x, factor_y);
+    XCAM_FAIL_RETURN (
+        ERROR, !XCAM_DOUBLE_EQUAL_AROUND (factor_x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factor_y, 0.0f), false,
+        "GLGeoMapHandler(%s) invalid factors: x:%f, y:%f", XCAM_STR (get_name ()), factor_x, factor_y);
+
+    factors[0] = factors[2] = factor_x;
+    factors[1] = factors[3] = factor_y;
+    std_step[0] = 1.0f / factor_x;
+    std_step[1] = 1.0f / factor_y;
 
     return true;
 }
@@ -205,6 +527,8 @@ GLGeoMapHandler::configure_resource (const SmartPtr<Parameters> &param)
 
     init_factors ();
 
+    _input_mode = select_input_mode (param->in_buf);
+
     XCAM_ASSERT (!_geomap_shader.ptr ());
     _geomap_shader = create_geomap_shader ();
     XCAM_FAIL_RETURN (
@@ -236,9 +560,15 @@ GLGeoMapHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
 XCamReturn
 GLGeoMapHandler::terminate ()
 {
+    if (is_off_executor ())
+        return terminate_on_executor ();
+
     if (_geomap_shader.ptr ()) {
         _geomap_shader.release ();
     }
+    _in_tex_y.release ();
+    _in_tex_uv.release ();
+    _dma_images.clear ();
 
     return GLImageHandler::terminate ();
 }
@@ -251,7 +581,8 @@ GLGeoMapHandler::create_geomap_shader ()
     SmartPtr<GLGeoMapShader> shader = new GLGeoMapShader (cb);
     XCAM_ASSERT (shader.ptr ());
 
-    XCamReturn ret = shader->create_compute_program (shader_info, "geomap_program");
+    XCamReturn ret = shader->create_compute_program (
+        _input_mode == InputBuffer ? shader_info : tex_shader_info, "geomap_program");
     XCAM_FAIL_RETURN (
         ERROR, ret == XCAM_RETURN_NO_ERROR, NULL,
         "GLGeoMapHandler(%s) create compute program failed", XCAM_STR (get_name ()));
@@ -259,6 +590,84 @@ GLGeoMapHandler::create_geomap_shader ()
     return shader;
 }
 
+GLGeoMapHandler::InputMode
+GLGeoMapHandler::select_input_mode (const SmartPtr<VideoBuffer> &in_buf)
+{
+    if (is_dma_input (in_buf)) {
+        XCAM_LOG_INFO ("GLGeoMapHandler(%s) reads dma-buf input without upload copy", XCAM_STR (get_name ()));
+        return InputDmaImage;
+    }
+
+    const VideoBufferInfo &in_info = in_buf->get_video_info ();
+    if (!_tex_sampling || in_info.format != V4L2_PIX_FMT_NV12 ||
+            !GLTexture::is_supported (in_info.width, in_info.height))
+        return InputBuffer;
+
+    _in_tex_y = GLTexture::create_texture (GL_R8, in_info.width, in_info.height);
+    _in_tex_uv = GLTexture::create_texture (GL_RG8, in_info.width / 2, in_info.height / 2);
+    if (!_in_tex_y.ptr () || !_in_tex_uv.ptr ()) {
+        XCAM_LOG_WARNING ("GLGeoMapHandler(%s) create input textures failed, read buffer instead", XCAM_STR (get_name ()));
+        _in_tex_y.release ();
+        _in_tex_uv.release ();
+        return InputBuffer;
+    }
+
+    return InputTexture;
+}
+
+bool
+GLGeoMapHandler::set_input_args (const SmartPtr<VideoBuffer> &in_buf, SmartPtr<GLGeoMapShader::Args> &args)
+{
+    if (_input_mode == InputDmaImage) {
+        int fd = in_buf->get_fd ();
+        DmaImageMap::iterator i = _dma_images.find (fd);
+        if (i == _dma_images.end ()) {
+            EGLDmaNV12Image image;
+            XCAM_FAIL_RETURN (
+                ERROR, import_dma_nv12 (in_buf, image), false,
+                "GLGeoMapHandler(%s) import dma-buf(fd:%d) failed", XCAM_STR (get_name ()), fd);
+            i = _dma_images.insert (DmaImageMap::value_type (fd, image)).first;
+        }
+
+        args->in_tex_y = i->second.y->get_texture ();
+        args->in_tex_uv = i->second.uv->get_texture ();
+        return true;
+    }
+
+    SmartPtr<GLBuffer> buf = get_glbuffer (in_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, buf.ptr (), false,
+        "GLGeoMapHandler(%s) get input buffer failed", XCAM_STR (get_name ()));
+
+    if (_input_mode == InputBuffer) {
+        args->in_buf = buf;
+        return true;
+    }
+
+    const GLBufferDesc &desc = buf->get_buffer_desc ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        xcam_ret_is_ok (_in_tex_y->upload (buf, desc.offsets[0], desc.strides[0])) &&
+        xcam_ret_is_ok (_in_tex_uv->upload (buf, desc.offsets[1], desc.strides[1])),
+        false,
+        "GLGeoMapHandler(%s) upload input textures failed", XCAM_STR (get_name ()));
+
+    args->in_tex_y = _in_tex_y->get_texture_id ();
+    args->in_tex_uv = _in_tex_uv->get_texture_id ();
+    return true;
+}
+
+void
+GLGeoMapHandler::set_redirect_args (const SmartPtr<ImageHandler::Parameters> &param, SmartPtr<GLGeoMapShader::Args> &args)
+{
+    SmartPtr<RedirectParam> redirect = param.dynamic_cast_ptr<RedirectParam> ();
+    if (_redirect_areas.empty () || !redirect.ptr () || !redirect->redirect_buf.ptr ())
+        return;
+
+    args->redirect_buf = get_glbuffer (redirect->redirect_buf);
+    args->redirect_areas = _redirect_areas;
+}
+
 XCamReturn
 GLGeoMapHandler::start_geomap_shader (const SmartPtr<ImageHandler::Parameters> &param)
 {
@@ -271,9 +680,12 @@ GLGeoMapHandler::start_geomap_shader (const SmartPtr<ImageHandler::Parameters> &
 
     SmartPtr<GLGeoMapShader::Args> args = new GLGeoMapShader::Args (param);
     XCAM_ASSERT (args.ptr ());
-    args->in_buf = get_glbuffer (param->in_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, set_input_args (param->in_buf, args), XCAM_RETURN_ERROR_PARAM,
+        "GLGeoMapHandler(%s) set input failed", XCAM_STR (get_name ()));
     args->out_buf = get_glbuffer (param->out_buf);
     args->lut_buf = _lut_buf;
+    set_redirect_args (param, args);
     args->factors[0] = factor_x;
     args->factors[1] = factor_y;
     args->factors[2] = args->factors[0];
@@ -359,6 +771,17 @@ GLDualConstGeoMapHandler::init_factors ()
     return true;
 }
 
+bool
+GLDualConstGeoMapHandler::get_lut_factors (float factors[4], float std_step[2])
+{
+    if (!GLGeoMapHandler::get_lut_factors (factors, std_step))
+        return false;
+
+    get_left_factors (factors[0], factors[1]);
+    get_right_factors (factors[2], factors[3]);
+    return true;
+}
+
 XCamReturn
 GLDualConstGeoMapHandler::start_geomap_shader (const SmartPtr<ImageHandler::Parameters> &param)
 {
@@ -368,9 +791,12 @@ GLDualConstGeoMapHandler::start_geomap_shader (const SmartPtr<ImageHandler::Para
 
     SmartPtr<GLGeoMapShader::Args> args = new GLGeoMapShader::Args (param);
     XCAM_ASSERT (args.ptr ());
-    args->in_buf = get_glbuffer (param->in_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, set_input_args (param->in_buf, args), XCAM_RETURN_ERROR_PARAM,
+        "GLGeoMapHandler(%s) set input failed", XCAM_STR (get_name ()));
     args->out_buf = get_glbuffer (param->out_buf);
     args->lut_buf = _lut_buf;
+    set_redirect_args (param, args);
 
     float factor_x, factor_y;
     get_left_factors (factor_x, factor_y);
@@ -24,6 +24,15 @@
 #include <interface/geo_mapper.h>
 #include <gles/gl_image_shader.h>
 #include <gles/gl_image_handler.h>
+#include <gles/gl_texture.h>
+#include <gles/egl/egl_dma_image.h>
+#include <shared_table_cache.h>
+#include <map>
+#include <vector>
+
+#define XCAM_GL_GEOMAP_BATCH_MAX 4
+// same as MAX_REDIRECTS of geomap shaders
+#define XCAM_GL_GEOMAP_MAX_REDIRECTS 4
 
 namespace XCam {
 
@@ -31,13 +40,29 @@ class GLGeoMapShader
     : public GLImageShader
 {
 public:
+    struct RedirectArea {
+        Rect        in_area;    // area of remapped image
+        uint32_t    out_x;      // position in redirect buffer
+        uint32_t    out_y;
+
+        RedirectArea () : out_x (0), out_y (0) {}
+    };
+    typedef std::vector<RedirectArea> RedirectAreas;
+
     struct Args : GLArgs {
         SmartPtr<GLBuffer>        in_buf, out_buf;
         SmartPtr<GLBuffer>        lut_buf;
+        // Y and UV textures sampled instead of in_buf if set
+        GLuint                    in_tex_y, in_tex_uv;
         float                     factors[4];
+        // pixels inside redirect_areas are written into redirect_buf instead of out_buf
+        SmartPtr<GLBuffer>        redirect_buf;
+        RedirectAreas             redirect_areas;
 
         Args (const SmartPtr<ImageHandler::Parameters> &param)
             : GLArgs (param)
+            , in_tex_y (0)
+            , in_tex_uv (0)
         {}
     };
 
@@ -59,17 +84,93 @@ private:
     float        _lut_std_step[2];
 };
 
+/*
+ * maps all cameras in one dispatch, camera index is the z dimension of work groups,
+ * per-camera sizes and factors are uploaded in one uniform buffer.
+ */
+class GLGeoMapBatchShader
+    : public GLImageShader
+{
+public:
+    struct Args : GLArgs {
+        uint32_t                  count;
+        SmartPtr<GLBuffer>        in_bufs[XCAM_GL_GEOMAP_BATCH_MAX];
+        SmartPtr<GLBuffer>        out_bufs[XCAM_GL_GEOMAP_BATCH_MAX];
+        SmartPtr<GLBuffer>        lut_bufs[XCAM_GL_GEOMAP_BATCH_MAX];
+        float                     factors[XCAM_GL_GEOMAP_BATCH_MAX][4];
+        float                     std_steps[XCAM_GL_GEOMAP_BATCH_MAX][2];
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param = NULL)
+            : GLArgs (param)
+            , count (0)
+        {}
+    };
+
+public:
+    explicit GLGeoMapBatchShader (const SmartPtr<Worker::Callback> &cb = NULL)
+        : GLImageShader ("GLGeoMapBatchShader", cb)
+    {}
+    ~GLGeoMapBatchShader () {}
+
+    // needs GLES 3.2 for dynamically uniform indexing of buffer arrays
+    static bool is_supported (uint32_t count);
+    XCamReturn init ();
+
+private:
+    virtual XCamReturn prepare_arguments (const SmartPtr<Worker::Arguments> &args, GLCmdList &cmds);
+    XCAM_DEAD_COPY (GLGeoMapBatchShader);
+
+private:
+    SmartPtr<GLBuffer>        _param_buf;
+};
+
 class GLGeoMapHandler
     : public GLImageHandler, public GeoMapper
 {
     friend class CbGeoMapShader;
 
+public:
+    typedef GLGeoMapShader::RedirectArea RedirectArea;
+    typedef GLGeoMapShader::RedirectAreas RedirectAreas;
+
+    struct RedirectParam : ImageHandler::Parameters {
+        SmartPtr<VideoBuffer>  redirect_buf;
+    };
+
 public:
     GLGeoMapHandler (const char *name = "GLGeoMapHandler");
     ~GLGeoMapHandler ();
 
+    // redirect needs one more storage buffer in geomap shaders
+    static bool is_redirect_supported ();
+
+    // pixels inside areas are remapped into RedirectParam::redirect_buf directly instead of out_buf,
+    // x positions and widths need be multiples of 4, y positions and heights even
+    bool set_redirect_areas (const RedirectAreas &areas);
+    const RedirectAreas &get_redirect_areas () const {
+        return _redirect_areas;
+    }
+
     bool set_lookup_table (const PointFloat2 *data, uint32_t width, uint32_t height);
 
+    // hash of all the next lookup table is built from, 0 by default.
+    // handlers of the same key on one context share the table buffer
+    void set_table_key (uint64_t key) {
+        _table_key = key;
+    }
+    // sets the buffer shared under the key instead of set_lookup_table, false if none
+    bool use_shared_lookup_table ();
+
+    // sample input by texture units with hardware bilinear filtering, enabled by default
+    void enable_tex_sampling (bool enable) {
+        _tex_sampling = enable;
+    }
+    const SmartPtr<GLBuffer> &get_lookup_table () const {
+        return _lut_buf;
+    }
+    // factors of left and right halves and standard step, as consumed by geomap shaders
+    virtual bool get_lut_factors (float factors[4], float std_step[2]);
+
     XCamReturn remap (const SmartPtr<VideoBuffer> &in_buf, SmartPtr<VideoBuffer> &out_buf);
 
     //derived from ImageHandler
@@ -80,6 +181,9 @@ protected:
     virtual XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     virtual XCamReturn start_work (const SmartPtr<Parameters> &param);
 
+    bool set_input_args (const SmartPtr<VideoBuffer> &in_buf, SmartPtr<GLGeoMapShader::Args> &args);
+    void set_redirect_args (const SmartPtr<ImageHandler::Parameters> &param, SmartPtr<GLGeoMapShader::Args> &args);
+
 private:
     virtual bool init_factors ();
 
@@ -88,11 +192,36 @@ private:
     virtual void geomap_shader_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
 
+    // key of the table on current context, 0 if not shared
+    uint64_t get_shared_key () const;
+
     XCAM_DEAD_COPY (GLGeoMapHandler);
 
 protected:
     SmartPtr<GLBuffer>              _lut_buf;
     SmartPtr<GLGeoMapShader>        _geomap_shader;
+
+private:
+    enum InputMode {
+        InputBuffer = 0,
+        InputTexture,
+        InputDmaImage
+    };
+    typedef std::map<int, EGLDmaNV12Image> DmaImageMap;
+
+    InputMode select_input_mode (const SmartPtr<VideoBuffer> &in_buf);
+
+private:
+    bool                            _tex_sampling;
+    InputMode                       _input_mode;
+    // GL buffer inputs are copied into textures on GPU before sampling
+    SmartPtr<GLTexture>             _in_tex_y;
+    SmartPtr<GLTexture>             _in_tex_uv;
+    // dma-buf inputs are imported once per fd, V4L2 and dma buffers are recycled
+    DmaImageMap                     _dma_images;
+    RedirectAreas                   _redirect_areas;
+    uint64_t                        _table_key;
+    SharedTableRef                  _lut_ref;
 };
 
 class GLDualConstGeoMapHandler
@@ -113,6 +242,8 @@ public:
         y = _right_factor_y;
     }
 
+    virtual bool get_lut_factors (float factors[4], float std_step[2]);
+
 private:
     virtual bool init_factors ();
     virtual XCamReturn start_geomap_shader (const SmartPtr<ImageHandler::Parameters> &param);
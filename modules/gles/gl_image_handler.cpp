@@ -20,11 +20,70 @@
 
 #include "gl_image_handler.h"
 #include "gl_video_buffer.h"
+#include "gl_buffer.h"
 
 namespace XCam {
 
+enum GLHandlerJobType {
+    GLJobExecute = 0,
+    GLJobFinish,
+    GLJobTerminate,
+};
+
+class GLHandlerJob
+    : public GLExecutor::Job
+{
+public:
+    GLHandlerJob (
+        GLImageHandler *handler, GLHandlerJobType type,
+        const SmartPtr<ImageHandler::Parameters> &param = NULL, bool async = false)
+        : _handler (handler)
+        , _type (type)
+        , _param (param)
+        , _async (async)
+        , _mem_owner (MemoryOwnerScope::current ())
+        , _mem_pooled (MemoryOwnerScope::is_pooled ())
+    {
+        // async frames keep the handler until done
+        if (async)
+            _keep = handler;
+    }
+
+    virtual XCamReturn run () {
+        // charged to the owner of posting thread
+        MemoryOwnerScope mem_scope (_mem_owner, _mem_pooled);
+
+        switch (_type) {
+        case GLJobExecute:
+            return _handler->execute_buffer (_param, !_async);
+        case GLJobFinish:
+            return _handler->finish ();
+        default:
+            return _handler->terminate ();
+        }
+    }
+
+    virtual void done (XCamReturn error) {
+        // errors of async frames reach the caller only by the callback
+        if (_async && error != XCAM_RETURN_NO_ERROR)
+            _handler->execute_status_check (_param, error);
+        _keep.release ();
+    }
+
+private:
+    GLImageHandler                      *_handler;
+    SmartPtr<GLImageHandler>             _keep;
+    GLHandlerJobType                     _type;
+    SmartPtr<ImageHandler::Parameters>   _param;
+    bool                                 _async;
+    uint32_t                             _mem_owner;
+    bool                                 _mem_pooled;
+};
+
 GLImageHandler::GLImageHandler (const char* name)
     : ImageHandler (name)
+    , _persistent_map (false)
+    , _max_inflight (XCAM_GL_MAX_INFLIGHT_FRAMES)
 {
 }
 
@@ -35,7 +94,106 @@ GLImageHandler::~GLImageHandler ()
 SmartPtr<BufferPool>
 GLImageHandler::create_allocator ()
 {
-    return new GLVideoBufferPool;
+    SmartPtr<GLVideoBufferPool> pool = new GLVideoBufferPool;
+    XCAM_ASSERT (pool.ptr ());
+    pool->set_persistent_map (_persistent_map);
+    pool->set_executor (_executor);
+    return pool;
+}
+
+bool
+GLImageHandler::set_max_inflight (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count > 0, false,
+        "GLImageHandler(%s) max in-flight frames need be at least 1", XCAM_STR (get_name ()));
+
+    _max_inflight = count;
+    return true;
+}
+
+XCamReturn
+GLImageHandler::fence_frame (SmartPtr<GLSync> &fence)
+{
+    fence = GLSync::create_fence ();
+    XCAM_FAIL_RETURN (
+        ERROR, fence.ptr (), XCAM_RETURN_ERROR_GLES,
+        "GLImageHandler(%s) create frame fence failed", XCAM_STR (get_name ()));
+    _inflight.push_back (fence);
+
+    while (!_inflight.empty () && _inflight.front ()->is_signaled ())
+        _inflight.pop_front ();
+
+    while (_inflight.size () > _max_inflight) {
+        XCamReturn ret = _inflight.front ()->wait ();
+        _inflight.pop_front ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "GLImageHandler(%s) wait frame fence failed", XCAM_STR (get_name ()));
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLImageHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bool sync)
+{
+    if (!is_off_executor ())
+        return ImageHandler::execute_buffer (param, sync);
+
+    XCAM_FAIL_RETURN (
+        ERROR, param.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "GLImageHandler(%s) execute buffer failed, params is null", XCAM_STR (get_name ()));
+
+    // without callback the caller can only learn the result by waiting
+    bool async = !sync && get_callback ().ptr ();
+    SmartPtr<GLHandlerJob> job = new GLHandlerJob (this, GLJobExecute, param, async);
+    XCAM_ASSERT (job.ptr ());
+
+    if (async)
+        return _executor->submit (job);
+    return _executor->run_sync (job);
+}
+
+XCamReturn
+GLImageHandler::terminate_on_executor ()
+{
+    XCAM_ASSERT (_executor.ptr ());
+
+    SmartPtr<GLHandlerJob> job = new GLHandlerJob (this, GLJobTerminate);
+    XCAM_ASSERT (job.ptr ());
+    return _executor->run_sync (job);
+}
+
+XCamReturn
+GLImageHandler::terminate ()
+{
+    if (is_off_executor ())
+        return terminate_on_executor ();
+
+    return ImageHandler::terminate ();
+}
+
+XCamReturn
+GLImageHandler::finish ()
+{
+    if (is_off_executor ()) {
+        SmartPtr<GLHandlerJob> job = new GLHandlerJob (this, GLJobFinish);
+        XCAM_ASSERT (job.ptr ());
+        return _executor->run_sync (job);
+    }
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // fences signal in order, the newest covers all
+    if (!_inflight.empty ())
+        ret = _inflight.back ()->wait ();
+    _inflight.clear ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "GLImageHandler(%s) finish failed", XCAM_STR (get_name ()));
+    return XCAM_RETURN_NO_ERROR;
 }
 
 void
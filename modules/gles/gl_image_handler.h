@@ -23,19 +23,64 @@
 
 #include <image_handler.h>
 #include <gles/gles_std.h>
+#include <gles/gl_executor.h>
+#include <list>
+
+#define XCAM_GL_MAX_INFLIGHT_FRAMES 2
 
 namespace XCam {
 
+class GLSync;
+class GLHandlerJob;
+
 class GLImageHandler
     : public ImageHandler
 {
+    friend class GLHandlerJob;
+
 public:
     explicit GLImageHandler (const char* name);
     ~GLImageHandler ();
 
+    // output buffers are allocated with persistent mapping, see GLVideoBufferPool
+    void set_persistent_map (bool enable) {
+        _persistent_map = enable;
+    }
+    bool is_persistent_map () const {
+        return _persistent_map;
+    }
+
+    // frames left executing on GPU when start_work returns, at least 1
+    bool set_max_inflight (uint32_t count);
+
+    // GL work of the handler is posted to @executor from other threads, set before first frame.
+    // frames run async only with a callback set, called on executor thread, errors included
+    void set_executor (const SmartPtr<GLExecutor> &executor) {
+        _executor = executor;
+    }
+    const SmartPtr<GLExecutor> &get_executor () const {
+        return _executor;
+    }
+
+    // derived from ImageHandler
+    virtual XCamReturn execute_buffer (const SmartPtr<Parameters> &param, bool sync);
+    // waits until GPU completes all frames
+    virtual XCamReturn finish ();
+    virtual XCamReturn terminate ();
+
 protected:
+    // handlers overriding terminate () forward it to executor first if this is true
+    bool is_off_executor () const {
+        return _executor.ptr () && !_executor->is_current ();
+    }
+    XCamReturn terminate_on_executor ();
+
     virtual void execute_done (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err);
 
+    // fences commands of current frame instead of glFinish,
+    // retires completed frames and waits for the oldest ones beyond max in-flight count
+    XCamReturn fence_frame (SmartPtr<GLSync> &fence);
+
 private:
     SmartPtr<BufferPool> create_allocator ();
 
@@ -43,6 +88,10 @@ private:
     XCAM_DEAD_COPY (GLImageHandler);
 
 private:
+    bool                          _persistent_map;
+    uint32_t                      _max_inflight;
+    std::list<SmartPtr<GLSync> >  _inflight;
+    SmartPtr<GLExecutor>          _executor;
 };
 
 }
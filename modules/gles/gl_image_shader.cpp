@@ -19,6 +19,7 @@
  */
 
 #include "gl_image_shader.h"
+#include "xcam_trace.h"
 
 #define ENABLE_DEBUG_SHADER 0
 
@@ -54,6 +55,8 @@ GLImageShader::get_compute_program (SmartPtr<GLComputeProgram> &prog)
 XCamReturn
 GLImageShader::work (const SmartPtr<Worker::Arguments> &args)
 {
+    XCAM_TRACE_SCOPE (get_name (), InvalidTimestamp);
+
     XCamReturn ret = _program->use ();
     XCAM_FAIL_RETURN (
         WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
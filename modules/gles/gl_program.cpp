@@ -19,9 +19,67 @@
  */
 
 #include "gl_program.h"
+#include "gl_command.h"
+#include "file_handle.h"
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define XCAM_GL_PROGRAM_CACHE_MAGIC 0x50474c58 // "XLGP"
 
 namespace XCam {
 
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// FNV-1a
+static uint64_t
+hash_bytes (uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static std::string
+get_binary_file_name (const GLShaderInfoList &infos)
+{
+    const char *cache_path = std::getenv ("XCAM_GL_PROGRAM_CACHE_PATH");
+    std::string path;
+    if (cache_path) {
+        path = cache_path;
+    } else {
+        const char *home_dir = std::getenv ("HOME");
+        path = home_dir ? home_dir : "/tmp";
+        path += "/.xcam";
+    }
+
+    // binaries are only valid for the same driver
+    const char *renderer = (const char *)glGetString (GL_RENDERER);
+    const char *version = (const char *)glGetString (GL_VERSION);
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_bytes (hash, XCAM_STR (renderer), strlen (XCAM_STR (renderer)));
+    hash = hash_bytes (hash, XCAM_STR (version), strlen (XCAM_STR (version)));
+    for (GLShaderInfoList::const_iterator iter = infos.begin (); iter != infos.end (); ++iter) {
+        const GLShaderInfo &info = *(*iter);
+        size_t len = info.len ? info.len : strlen (info.src);
+        hash = hash_bytes (hash, &info.type, sizeof (info.type));
+        hash = hash_bytes (hash, info.src, len);
+    }
+
+    char file_name[XCAM_MAX_STR_SIZE] = {0};
+    snprintf (file_name, XCAM_MAX_STR_SIZE - 1, "%s/gl-program-%016" PRIx64 ".bin", path.c_str (), hash);
+    return file_name;
+}
+
 GLProgram::GLProgram (GLuint id, const char *name)
     : _program_id (id)
     , _state (GLProgram::StateIntiated)
@@ -34,6 +92,7 @@ GLProgram::~GLProgram ()
     disuse ();
     clear_shaders ();
     if (_program_id) {
+        GLUniformCache::clear (_program_id);
         glDeleteProgram (_program_id);
 
         GLenum error = gl_error ();
@@ -126,6 +185,8 @@ GLProgram::link ()
 {
     XCAM_ASSERT (_program_id);
 
+    // relink resets uniforms and locations
+    GLUniformCache::clear (_program_id);
     glLinkProgram (_program_id);
     GLenum error = gl_error ();
 
@@ -153,7 +214,7 @@ GLProgram::use ()
 {
     XCAM_ASSERT (_program_id);
     XCAM_FAIL_RETURN (
-        WARNING, _state == StateLinked && !_shaders.empty (), XCAM_RETURN_ERROR_PARAM,
+        WARNING, _state == StateLinked, XCAM_RETURN_ERROR_PARAM,
         "GL program(:%s) use must be called after link", get_name());
 
     glUseProgram (_program_id);
@@ -186,36 +247,107 @@ GLProgram::disuse ()
 }
 
 XCamReturn
-GLProgram::link_shader (const GLShaderInfo &info)
+GLProgram::load_binary (const std::string &file_name)
 {
-    SmartPtr<GLShader> shader = GLShader::compile_shader (info);
+    FileHandle file;
+    if (!xcam_ret_is_ok (file.open (file_name.c_str (), "rb")))
+        return XCAM_RETURN_BYPASS;
+
+    size_t file_size = 0;
+    ProgramBinaryHeader header;
+    XCAM_FAIL_RETURN (
+        WARNING,
+        xcam_ret_is_ok (file.get_file_size (file_size)) && file_size > sizeof (header) &&
+        xcam_ret_is_ok (file.read_file (&header, sizeof (header))) &&
+        header.magic == XCAM_GL_PROGRAM_CACHE_MAGIC && header.size == file_size - sizeof (header),
+        XCAM_RETURN_ERROR_FILE,
+        "GL program(:%s) binary cache(%s) mismatch, ignored", get_name (), file_name.c_str ());
+
+    std::vector<uint8_t> binary (header.size);
     XCAM_FAIL_RETURN (
-        ERROR, shader->get_shader_id (), XCAM_RETURN_ERROR_GLES,
-        "GLProgram(%s) create shader(%s) failed", get_name (), info.name);
+        WARNING, xcam_ret_is_ok (file.read_file (binary.data (), header.size)), XCAM_RETURN_ERROR_FILE,
+        "GL program(:%s) read binary cache(%s) failed", get_name (), file_name.c_str ());
 
-    XCamReturn ret = attach_shader (shader);
+    glProgramBinary (_program_id, header.format, binary.data (), header.size);
+
+    // driver may reject binaries after update, fall back to compile
+    GLint status = GL_FALSE;
+    glGetProgramiv (_program_id, GL_LINK_STATUS, &status);
+    GLenum error = gl_error ();
     XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-        "GLProgram(%s) attach shader(%s) failed", get_name (), info.name);
+        WARNING, status == GL_TRUE && error == GL_NO_ERROR, XCAM_RETURN_ERROR_GLES,
+        "GL program(:%s) binary cache(%s) rejected by driver, error flag: %s",
+        get_name (), file_name.c_str (), gl_error_string (error));
 
-    ret = link ();
+    _state = StateLinked;
+    XCAM_LOG_DEBUG ("GL program(:%s) loaded from binary cache(%s)", get_name (), file_name.c_str ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GLProgram::save_binary (const std::string &file_name)
+{
+    GLint length = 0;
+    glGetProgramiv (_program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return XCAM_RETURN_BYPASS;
+
+    std::vector<uint8_t> binary (length);
+    GLenum format = 0;
+    glGetProgramBinary (_program_id, length, &length, &format, binary.data ());
+    GLenum error = gl_error ();
     XCAM_FAIL_RETURN (
-        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-        "GLProgram(%s) link program failed", get_name ());
+        WARNING, error == GL_NO_ERROR && length > 0, XCAM_RETURN_ERROR_GLES,
+        "GL program(:%s) get program binary failed, error flag: %s",
+        get_name (), gl_error_string (error));
+
+    std::string dir = file_name.substr (0, file_name.rfind ('/'));
+    if (access (dir.c_str (), F_OK) == -1) {
+        mkdir (dir.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    }
+
+    ProgramBinaryHeader header;
+    header.magic = XCAM_GL_PROGRAM_CACHE_MAGIC;
+    header.format = format;
+    header.size = length;
+    header.reserved = 0;
+
+    FileHandle file;
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.open (file_name.c_str (), "wb")), XCAM_RETURN_ERROR_FILE,
+        "GL program(:%s) open binary cache(%s) failed", get_name (), file_name.c_str ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        xcam_ret_is_ok (file.write_file (&header, sizeof (header))) &&
+        xcam_ret_is_ok (file.write_file (binary.data (), length)),
+        XCAM_RETURN_ERROR_FILE,
+        "GL program(:%s) write binary cache(%s) failed", get_name (), file_name.c_str ());
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+GLProgram::link_shader (const GLShaderInfo &info)
+{
+    GLShaderInfoList infos;
+    infos.push_back (&info);
+    return link_shaders (infos);
+}
+
 XCamReturn
 GLProgram::link_shaders (const GLShaderInfoList &infos)
 {
+    std::string file_name = get_binary_file_name (infos);
+    if (load_binary (file_name) == XCAM_RETURN_NO_ERROR)
+        return XCAM_RETURN_NO_ERROR;
+
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     for (GLShaderInfoList::const_iterator iter = infos.begin (); iter != infos.end (); ++iter) {
         const GLShaderInfo &info = *(*iter);
 
         SmartPtr<GLShader> shader = GLShader::compile_shader (info);
         XCAM_FAIL_RETURN (
-            ERROR, shader->get_shader_id (), XCAM_RETURN_ERROR_GLES,
+            ERROR, shader.ptr () && shader->get_shader_id (), XCAM_RETURN_ERROR_GLES,
             "GLProgram(%s) create shader(%s) failed", get_name (), info.name);
 
         ret = attach_shader (shader);
@@ -224,10 +356,15 @@ GLProgram::link_shaders (const GLShaderInfoList &infos)
             "GLProgram(%s) attach shader(%s) failed", get_name (), info.name);
     }
 
+    glProgramParameteri (_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     ret = link ();
     XCAM_FAIL_RETURN (
         ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-        "GLProgram(%s) link program(%s) failed", get_name ());
+        "GLProgram(%s) link program failed", get_name ());
+
+    if (!xcam_ret_is_ok (save_binary (file_name))) {
+        XCAM_LOG_WARNING ("GLProgram(%s) save binary cache failed", get_name ());
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
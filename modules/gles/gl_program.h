@@ -24,6 +24,7 @@
 #include <gles/gles_std.h>
 #include <gles/gl_shader.h>
 #include <map>
+#include <string>
 
 namespace XCam {
 
@@ -46,6 +47,8 @@ public:
         return _name;
     }
 
+    // linked binaries are cached by hash of shader sources and GL renderer,
+    // XCAM_GL_PROGRAM_CACHE_PATH overrides the default directory $HOME/.xcam
     XCamReturn link_shader (const GLShaderInfo &info);
     XCamReturn link_shaders (const GLShaderInfoList &infos);
 
@@ -63,6 +66,8 @@ private:
     XCamReturn detach_shader (const SmartPtr<GLShader> &shader);
     XCamReturn clear_shaders ();
     XCamReturn link ();
+    XCamReturn load_binary (const std::string &file_name);
+    XCamReturn save_binary (const std::string &file_name);
 
 private:
     XCAM_DEAD_COPY (GLProgram);
@@ -20,11 +20,18 @@
  */
 
 #include "surview_fisheye_dewarp.h"
+#include "fisheye_table_cache.h"
+#include "frame_latency.h"
+#include "memory_accounting.h"
+#include "blend_reuse.h"
 #include "gl_video_buffer.h"
 #include "gl_geomap_handler.h"
 #include "gl_blender.h"
 #include "gl_copy_handler.h"
+#include "gl_utils.h"
 #include "gl_stitcher.h"
+#include <soft/soft_blender.h>
+#include <GLES2/gl2ext.h>
 
 #define GL_STITCHER_ALIGNMENT_X 16
 #define GL_STITCHER_ALIGNMENT_Y 4
@@ -32,6 +39,10 @@
 #define MAP_FACTOR_X  16
 #define MAP_FACTOR_Y  16
 
+// auto blend device, frames timed on each device, first one warms up, and frames between probes
+#define GL_STITCHER_PROBE_FRAMES 4
+#define GL_STITCHER_PROBE_INTERVAL 300
+
 #define DUMP_BUFFER 0
 
 namespace XCam {
@@ -78,7 +89,7 @@ struct BlenderParam
 typedef std::map<void*, SmartPtr<BlenderParam>> BlenderParams;
 
 struct HandlerParam
-    : ImageHandler::Parameters
+    : GLGeoMapHandler::RedirectParam
 {
     SmartPtr<GLStitcher::StitcherParam>    stitch_param;
     uint32_t                               idx;
@@ -100,7 +111,10 @@ struct Factor {
 
 struct Overlap {
     SmartPtr<GLBlender>    blender;
+    SmartPtr<SoftBlender>  soft_blender;
     BlenderParams          param_map;
+    // only frames blended on CPU reuse and keep results
+    BlendReuse             reuse;
 
     SmartPtr<BlenderParam> find_blender_param_in_map (
         const SmartPtr<GLStitcher::StitcherParam> &key,
@@ -114,7 +128,7 @@ struct FisheyeDewarp {
     bool set_dewarp_factor ();
     XCamReturn set_dewarp_geo_table (
         const SmartPtr<GLGeoMapHandler> &mapper, const CameraInfo &cam_info,
-        const Stitcher::RoundViewSlice &view_slice, const BowlDataConfig &bowl);
+        const Stitcher::RoundViewSlice &view_slice, const BowlDataConfig &bowl, bool use_cache);
 };
 
 typedef std::vector<SmartPtr<GLCopyHandler>> Copiers;
@@ -125,10 +139,16 @@ class StitcherImpl {
 public:
     StitcherImpl (GLStitcher *handler)
         : _stitcher (handler)
-    {}
+        , _cpu_blend_ready (false)
+        , _auto_cpu_blend (false)
+        , _blend_frames (0)
+    {
+        _blend_cost[0] = _blend_cost[1] = 0;
+    }
 
     XCamReturn init_config (uint32_t count);
     XCamReturn start_dewarps (const SmartPtr<GLStitcher::StitcherParam> &param);
+    XCamReturn start_batch_dewarp (const SmartPtr<GLStitcher::StitcherParam> &param);
     XCamReturn start_blenders (
         const SmartPtr<GLStitcher::StitcherParam> &param,
         uint32_t idx, const SmartPtr<VideoBuffer> &buf);
@@ -137,8 +157,13 @@ public:
         uint32_t idx, const SmartPtr<VideoBuffer> &buf);
 
     XCamReturn start_single_blender (uint32_t idx, const SmartPtr<BlenderParam> &param);
+    XCamReturn start_soft_blenders (const SmartPtr<GLStitcher::StitcherParam> &param);
     XCamReturn stop ();
 
+    // @timed set if frame time need be reported by end_blend_frame
+    bool choose_cpu_blend (const SmartPtr<GLStitcher::StitcherParam> &param, bool &timed);
+    void end_blend_frame (bool cpu_blend, bool timed, int64_t time);
+
     XCamReturn fisheye_dewarp_to_table ();
 
     const SmartPtr<GLComputeProgram> &get_sync_prog ();
@@ -147,16 +172,25 @@ private:
     SmartPtr<GLGeoMapHandler> create_geo_mapper (const Stitcher::RoundViewSlice &view_slice);
 
     XCamReturn init_fisheye (uint32_t idx);
+    bool init_redirect_areas ();
     bool init_dewarp_factors (uint32_t idx);
+    void config_blender (Blender *blender, uint32_t idx);
 
 private:
     FisheyeDewarp                 _fisheye[XCAM_STITCH_MAX_CAMERAS];
     Overlap                       _overlaps[XCAM_STITCH_MAX_CAMERAS];
     Copiers                       _copiers;
+    SmartPtr<GLGeoMapBatchShader> _batch_dewarp;
 
     Mutex                         _map_mutex;
     GLStitcher                   *_stitcher;
     SmartPtr<GLComputeProgram>    _sync_prog;
+
+    // cost model of blend device, summed probe frame times of GPU and CPU blending
+    bool                          _cpu_blend_ready;
+    bool                          _auto_cpu_blend;
+    uint32_t                      _blend_frames;
+    int64_t                       _blend_cost[2];
 };
 
 const SmartPtr<GLComputeProgram> &
@@ -216,7 +250,7 @@ StitcherImpl::init_dewarp_factors (uint32_t idx)
 XCamReturn
 FisheyeDewarp::set_dewarp_geo_table (
     const SmartPtr<GLGeoMapHandler> &mapper, const CameraInfo &cam_info,
-    const Stitcher::RoundViewSlice &view_slice, const BowlDataConfig &bowl)
+    const Stitcher::RoundViewSlice &view_slice, const BowlDataConfig &bowl, bool use_cache)
 {
     PolyFisheyeDewarp fd;
     fd.set_intrinsic_param (cam_info.calibration.intrinsic);
@@ -226,14 +260,35 @@ FisheyeDewarp::set_dewarp_geo_table (
     table_width = view_slice.width / MAP_FACTOR_X;
     table_height = view_slice.height / MAP_FACTOR_Y;
 
-    SurViewFisheyeDewarp::MapTable map_table(table_width * table_height);
-    fd.fisheye_dewarp (
-        map_table, table_width, table_height,
-        view_slice.width, view_slice.height, bowl);
+    // stitchers of the same calibration and config on one context share one table
+    FisheyeTableCache cache;
+    cache.set_key (
+        cam_info.calibration.intrinsic, cam_info.calibration.extrinsic, bowl,
+        table_width, table_height, view_slice.width, view_slice.height);
+    mapper->set_table_key (cache.get_key ());
+    if (mapper->use_shared_lookup_table ())
+        return XCAM_RETURN_NO_ERROR;
+
+    SurViewFisheyeDewarp::MapTable map_table;
+    const PointFloat2 *table = NULL;
+    if (use_cache) {
+        // uploaded straight from the mapped file, no host copy of the table
+        table = cache.map ();
+    }
+
+    if (!table) {
+        map_table.resize (table_width * table_height);
+        fd.fisheye_dewarp (
+            map_table, table_width, table_height,
+            view_slice.width, view_slice.height, bowl);
+        if (use_cache)
+            cache.save (map_table);
+        table = map_table.data ();
+    }
 
     XCAM_FAIL_RETURN (
         ERROR,
-        mapper->set_lookup_table (map_table.data (), table_width, table_height),
+        mapper->set_lookup_table (table, table_width, table_height),
         XCAM_RETURN_ERROR_UNKNOWN,
         "set fisheye dewarp lookup table failed");
 
@@ -271,20 +326,62 @@ StitcherImpl::init_fisheye (uint32_t idx)
         XCAM_ALIGN_UP (view_slice.width, GL_STITCHER_ALIGNMENT_X),
         XCAM_ALIGN_UP (view_slice.height, GL_STITCHER_ALIGNMENT_Y));
 
-    SmartPtr<BufferPool> pool = new GLVideoBufferPool (buf_info);
+    SmartPtr<GLVideoBufferPool> pool = new GLVideoBufferPool (buf_info);
     XCAM_ASSERT (pool.ptr ());
+    // soft blenders read dewarp buffers in place
+    bool cpu_blend = _stitcher->get_blend_device () != GLStitcher::BlendOnGPU;
+    if (cpu_blend)
+        pool->set_persistent_map (true);
     XCAM_FAIL_RETURN (
-        ERROR, pool->reserve (XCAM_GL_RESERVED_BUF_COUNT), XCAM_RETURN_ERROR_MEM,
+        ERROR, xcam_ret_is_ok (pool->reserve (XCAM_GL_RESERVED_BUF_COUNT)), XCAM_RETURN_ERROR_MEM,
         "gl-stitcher(%s) reserve dewarp buffer pool failed, width:%d, height:%d",
         XCAM_STR (_stitcher->get_name ()), buf_info.width, buf_info.height);
     fisheye.buf_pool = pool;
 
+    if (cpu_blend) {
+        SmartPtr<VideoBuffer> buf = pool->get_buffer ();
+        SmartPtr<GLBuffer> gl_buf = buf.ptr () ? get_glbuffer (buf) : NULL;
+        if (!gl_buf.ptr () || !gl_buf->is_persistent ())
+            _cpu_blend_ready = false;
+    }
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+bool
+StitcherImpl::init_redirect_areas ()
+{
+    if (!GLGeoMapHandler::is_redirect_supported ())
+        return false;
+
+    const Stitcher::CopyAreaArray &areas = _stitcher->get_copy_area ();
+    uint32_t camera_num = _stitcher->get_camera_num ();
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        GLGeoMapHandler::RedirectAreas redirects;
+        for (uint32_t j = 0; j < areas.size (); ++j) {
+            if (areas[j].in_idx != i)
+                continue;
+
+            GLGeoMapHandler::RedirectArea redirect;
+            redirect.in_area = areas[j].in_area;
+            redirect.out_x = areas[j].out_area.pos_x;
+            redirect.out_y = areas[j].out_area.pos_y;
+            redirects.push_back (redirect);
+        }
+
+        if (!_fisheye[i].dewarp->set_redirect_areas (redirects))
+            return false;
+    }
+
+    return true;
+}
+
 XCamReturn
 StitcherImpl::init_config (uint32_t count)
 {
+    _cpu_blend_ready = _stitcher->get_blend_device () != GLStitcher::BlendOnGPU;
+
     for (uint32_t i = 0; i < count; ++i) {
         XCamReturn ret = init_fisheye (i);
         XCAM_FAIL_RETURN (
@@ -296,8 +393,52 @@ StitcherImpl::init_config (uint32_t count)
         SmartPtr<ImageHandler::Callback> blender_cb = new CbBlender (_stitcher);
         XCAM_ASSERT (blender_cb.ptr ());
         _overlaps[i].blender->set_callback (blender_cb);
+        _overlaps[i].blender->set_blend_mode (_stitcher->get_blend_mode ());
         _overlaps[i].param_map.clear ();
 
+        if (_cpu_blend_ready) {
+            _overlaps[i].soft_blender = create_soft_blender ().dynamic_cast_ptr<SoftBlender> ();
+            XCAM_ASSERT (_overlaps[i].soft_blender.ptr ());
+            _overlaps[i].soft_blender->enable_allocator (false);
+            _overlaps[i].soft_blender->set_blend_mode (_stitcher->get_blend_mode ());
+            _overlaps[i].reuse.set_policy (_stitcher->get_blend_reuse ());
+        }
+    }
+
+    if (_stitcher->get_blend_device () != GLStitcher::BlendOnGPU && !_cpu_blend_ready) {
+        XCAM_LOG_WARNING (
+            "gl-stitcher(%s) dewarp buffers can't be mapped persistently, overlaps are blended on GPU",
+            XCAM_STR (_stitcher->get_name ()));
+        for (uint32_t i = 0; i < count; ++i) {
+            _overlaps[i].soft_blender.release ();
+            _overlaps[i].reuse.set_policy (BlendReusePolicy ());
+        }
+    }
+
+    if (_stitcher->is_fused_mode () && !init_redirect_areas ()) {
+        XCAM_LOG_WARNING (
+            "gl-stitcher(%s) copy areas can't be fused into dewarp, fall back to copiers",
+            XCAM_STR (_stitcher->get_name ()));
+
+        for (uint32_t i = 0; i < count; ++i)
+            _fisheye[i].dewarp->set_redirect_areas (GLGeoMapHandler::RedirectAreas ());
+        _stitcher->enable_fused_mode (false);
+    }
+
+    // fused copies need per-camera dewarps and no copiers
+    if (_stitcher->is_fused_mode ())
+        return XCAM_RETURN_NO_ERROR;
+
+    if (_stitcher->is_batch_dewarp_enabled () && GLGeoMapBatchShader::is_supported (count)) {
+        _batch_dewarp = new GLGeoMapBatchShader ();
+        XCAM_ASSERT (_batch_dewarp.ptr ());
+        XCamReturn ret = _batch_dewarp->init ();
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING (
+                "gl-stitcher(%s) init batch dewarp failed, fall back to per-camera dewarps",
+                XCAM_STR (_stitcher->get_name ()));
+            _batch_dewarp.release ();
+        }
     }
 
     Stitcher::CopyAreaArray areas = _stitcher->get_copy_area ();
@@ -347,7 +488,8 @@ StitcherImpl::fisheye_dewarp_to_table ()
             view_slice.hori_angle_start, view_slice.hori_angle_range,
             bowl.angle_start, bowl.angle_end);
 
-        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (_fisheye[i].dewarp, cam_info, view_slice, bowl);
+        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (
+            _fisheye[i].dewarp, cam_info, view_slice, bowl, _stitcher->is_table_cache_enabled ());
 
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
@@ -360,6 +502,15 @@ StitcherImpl::fisheye_dewarp_to_table ()
 XCamReturn
 StitcherImpl::start_dewarps (const SmartPtr<GLStitcher::StitcherParam> &param)
 {
+    // batch shader reads GL buffers only, dma-buf inputs go through per-camera texture path
+    bool batch = _batch_dewarp.ptr () != NULL;
+    for (uint32_t i = 0; batch && i < param->in_buf_num; ++i) {
+        if (!param->in_bufs[i].dynamic_cast_ptr<GLVideoBuffer> ().ptr ())
+            batch = false;
+    }
+    if (batch)
+        return start_batch_dewarp (param);
+
     uint32_t camera_num = _stitcher->get_camera_num ();
 
     for (uint32_t i = 0; i < camera_num; ++i) {
@@ -368,6 +519,8 @@ StitcherImpl::start_dewarps (const SmartPtr<GLStitcher::StitcherParam> &param)
         dewarp_params->in_buf = param->in_bufs[i];
         dewarp_params->out_buf = out_buf;
         dewarp_params->stitch_param = param;
+        if (_stitcher->is_fused_mode ())
+            dewarp_params->redirect_buf = param->out_buf;
 
         init_dewarp_factors (i);
         XCamReturn ret = _fisheye[i].dewarp->execute_buffer (dewarp_params, false);
@@ -380,6 +533,51 @@ StitcherImpl::start_dewarps (const SmartPtr<GLStitcher::StitcherParam> &param)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+StitcherImpl::start_batch_dewarp (const SmartPtr<GLStitcher::StitcherParam> &param)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    XCAM_ASSERT (camera_num <= XCAM_GL_GEOMAP_BATCH_MAX);
+
+    SmartPtr<GLGeoMapBatchShader::Args> args = new GLGeoMapBatchShader::Args ();
+    XCAM_ASSERT (args.ptr ());
+    args->count = camera_num;
+
+    SmartPtr<HandlerParam> dewarp_params[XCAM_GL_GEOMAP_BATCH_MAX];
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        dewarp_params[i] = new HandlerParam (i);
+        dewarp_params[i]->in_buf = param->in_bufs[i];
+        dewarp_params[i]->out_buf = _fisheye[i].buf_pool->get_buffer ();
+        dewarp_params[i]->stitch_param = param;
+        XCAM_FAIL_RETURN (
+            ERROR, dewarp_params[i]->out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+            "gl-stitcher(%s) batch dewarp get output buffer failed, idx:%d",
+            XCAM_STR (_stitcher->get_name ()), i);
+
+        init_dewarp_factors (i);
+        const SmartPtr<GLGeoMapHandler> &dewarp = _fisheye[i].dewarp;
+        XCAM_FAIL_RETURN (
+            ERROR, dewarp->get_lut_factors (args->factors[i], args->std_steps[i]), XCAM_RETURN_ERROR_PARAM,
+            "gl-stitcher(%s) batch dewarp get factors failed, idx:%d", XCAM_STR (_stitcher->get_name ()), i);
+
+        args->in_bufs[i] = get_glbuffer (dewarp_params[i]->in_buf);
+        args->out_bufs[i] = get_glbuffer (dewarp_params[i]->out_buf);
+        args->lut_bufs[i] = dewarp->get_lookup_table ();
+    }
+
+    XCamReturn ret = _batch_dewarp->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "gl-stitcher(%s) batch dewarp failed", XCAM_STR (_stitcher->get_name ()));
+
+    // blenders and copiers of each camera follow as after per-camera dewarps
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        _stitcher->dewarp_done (_fisheye[i].dewarp, dewarp_params[i], ret);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 SmartPtr<BlenderParam>
 Overlap::find_blender_param_in_map (
     const SmartPtr<GLStitcher::StitcherParam> &key, uint32_t idx)
@@ -398,11 +596,9 @@ Overlap::find_blender_param_in_map (
     return param;
 }
 
-XCamReturn
-StitcherImpl::start_single_blender (
-    uint32_t idx, const SmartPtr<BlenderParam> &param)
+void
+StitcherImpl::config_blender (Blender *blender, uint32_t idx)
 {
-    SmartPtr<GLBlender> blender = _overlaps[idx].blender;
     const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (idx);
     uint32_t out_width, out_height;
     _stitcher->get_output_size (out_width, out_height);
@@ -413,10 +609,113 @@ StitcherImpl::start_single_blender (
     blender->set_input_valid_area (overlap_info.right, 1);
     blender->set_input_merge_area (overlap_info.left, 0);
     blender->set_input_merge_area (overlap_info.right, 1);
+}
+
+XCamReturn
+StitcherImpl::start_single_blender (
+    uint32_t idx, const SmartPtr<BlenderParam> &param)
+{
+    SmartPtr<GLBlender> blender = _overlaps[idx].blender;
+    config_blender (blender.ptr (), idx);
 
     return blender->execute_buffer (param, false);
 }
 
+XCamReturn
+StitcherImpl::start_soft_blenders (const SmartPtr<GLStitcher::StitcherParam> &param)
+{
+    // waits the frame fence of output on this thread, soft blender threads make no GL calls
+    SmartPtr<GLBuffer> out_buf = get_glbuffer (param->out_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, out_buf.ptr () && out_buf->map_range (), XCAM_RETURN_ERROR_MEM,
+        "gl-stitcher(%s) map output buffer for soft blenders failed", XCAM_STR (_stitcher->get_name ()));
+
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        SmartPtr<SoftBlender> blender = _overlaps[i].soft_blender;
+        XCAM_ASSERT (blender.ptr ());
+        config_blender (blender.ptr (), i);
+
+        const SmartPtr<VideoBuffer> &left_buf = param->dewarp_bufs[i];
+        const SmartPtr<VideoBuffer> &right_buf = param->dewarp_bufs[(i + 1) % camera_num];
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (i);
+        BlendReuse &reuse = _overlaps[i].reuse;
+        uint32_t ticket = 0;
+        if (reuse.is_enabled () && reuse.try_reuse (
+                    left_buf, overlap_info.left, right_buf, overlap_info.right,
+                    param->out_buf, overlap_info.out_area, ticket))
+            continue;
+
+        SmartPtr<SoftBlender::BlenderParam> blend_param =
+            new SoftBlender::BlenderParam (left_buf, right_buf, param->out_buf);
+        XCamReturn ret = blender->execute_buffer (blend_param, true);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "gl-stitcher(%s) soft blend overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), i);
+
+        if (reuse.is_enabled ())
+            reuse.keep (param->out_buf, overlap_info.out_area, ticket);
+
+        dump_buf (param->out_buf, i, "stitcher-blend");
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+StitcherImpl::choose_cpu_blend (const SmartPtr<GLStitcher::StitcherParam> &param, bool &timed)
+{
+    timed = false;
+    if (!_cpu_blend_ready)
+        return false;
+
+    // output written by copiers and soft blenders at the same time need be mapped persistently
+    SmartPtr<GLVideoBuffer> out_buf = param->out_buf.dynamic_cast_ptr<GLVideoBuffer> ();
+    SmartPtr<GLBuffer> gl_buf = out_buf.ptr () ? out_buf->get_gl_buffer () : NULL;
+    if (!gl_buf.ptr () || !gl_buf->is_persistent ()) {
+        XCAM_LOG_WARNING (
+            "gl-stitcher(%s) output buffer isn't mapped persistently, overlaps are blended on GPU",
+            XCAM_STR (_stitcher->get_name ()));
+        _cpu_blend_ready = false;
+        return false;
+    }
+
+    if (_stitcher->get_blend_device () == GLStitcher::BlendOnCPU)
+        return true;
+
+    uint32_t pos = _blend_frames % GL_STITCHER_PROBE_INTERVAL;
+    if (pos >= 2 * GL_STITCHER_PROBE_FRAMES)
+        return _auto_cpu_blend;
+
+    timed = (pos % GL_STITCHER_PROBE_FRAMES) != 0;
+    return pos >= GL_STITCHER_PROBE_FRAMES;
+}
+
+void
+StitcherImpl::end_blend_frame (bool cpu_blend, bool timed, int64_t time)
+{
+    if (_stitcher->get_blend_device () != GLStitcher::BlendAuto || !_cpu_blend_ready)
+        return;
+
+    uint32_t pos = _blend_frames++ % GL_STITCHER_PROBE_INTERVAL;
+    if (pos == 0)
+        _blend_cost[0] = _blend_cost[1] = 0;
+
+    // failed frames count as the slowest
+    if (timed)
+        _blend_cost[cpu_blend ? 1 : 0] += (time >= 0 ? time : INT32_MAX);
+
+    if (pos + 1 == 2 * GL_STITCHER_PROBE_FRAMES) {
+        _auto_cpu_blend = _blend_cost[1] < _blend_cost[0];
+
+        const int64_t frames = GL_STITCHER_PROBE_FRAMES - 1;
+        XCAM_LOG_INFO (
+            "gl-stitcher(%s) frame time of GPU blending %" PRId64 "us, CPU blending %" PRId64 "us, blend on %s",
+            XCAM_STR (_stitcher->get_name ()), _blend_cost[0] / frames, _blend_cost[1] / frames,
+            _auto_cpu_blend ? "CPU" : "GPU");
+    }
+}
+
 XCamReturn
 StitcherImpl::start_blenders (
     const SmartPtr<GLStitcher::StitcherParam> &param,
@@ -499,6 +798,11 @@ StitcherImpl::start_copier (
 XCamReturn
 StitcherImpl::stop ()
 {
+    if (_batch_dewarp.ptr ()) {
+        _batch_dewarp->stop ();
+        _batch_dewarp.release ();
+    }
+
     uint32_t cam_num = _stitcher->get_camera_num ();
     for (uint32_t i = 0; i < cam_num; ++i) {
         if (_fisheye[i].dewarp.ptr ()) {
@@ -513,6 +817,10 @@ StitcherImpl::stop ()
             _overlaps[i].blender->terminate ();
             _overlaps[i].blender.release ();
         }
+        if (_overlaps[i].soft_blender.ptr ()) {
+            _overlaps[i].soft_blender->terminate ();
+            _overlaps[i].soft_blender.release ();
+        }
     }
 
     for (Copiers::iterator i_copier = _copiers.begin (); i_copier != _copiers.end (); ++i_copier) {
@@ -531,6 +839,9 @@ StitcherImpl::stop ()
 GLStitcher::GLStitcher (const char *name)
     : GLImageHandler (name)
     , Stitcher (GL_STITCHER_ALIGNMENT_X, GL_STITCHER_ALIGNMENT_X)
+    , _batch_dewarp (false)
+    , _fused_mode (false)
+    , _blend_device (BlendOnGPU)
 {
     SmartPtr<GLSitcherPriv::StitcherImpl> impl = new GLSitcherPriv::StitcherImpl (this);
     XCAM_ASSERT (impl.ptr ());
@@ -544,6 +855,10 @@ GLStitcher::~GLStitcher ()
 XCamReturn
 GLStitcher::terminate ()
 {
+    if (is_off_executor ())
+        return terminate_on_executor ();
+
+    finish ();
     _impl->stop ();
     return GLImageHandler::terminate ();
 }
@@ -555,6 +870,9 @@ GLStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer
         ERROR, !in_bufs.empty (), XCAM_RETURN_ERROR_PARAM,
         "gl-stitcher(%s) stitch buffer failed, input buffers is empty", XCAM_STR (get_name ()));
 
+    // handlers of the stitcher are charged under it
+    MemoryOwnerScope mem_scope (get_name ());
+
     SmartPtr<StitcherParam> param = new StitcherParam;
     XCAM_ASSERT (param.ptr ());
     param->out_buf = out_buf;
@@ -571,6 +889,10 @@ GLStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer
     if (!out_buf.ptr () && xcam_ret_is_ok (ret)) {
         out_buf = param->out_buf;
     }
+    if (xcam_ret_is_ok (ret) && out_buf.ptr ()) {
+        FrameLatencyMeta::carry (param->in_bufs[0], out_buf);
+        FrameLatencyMeta::stamp (out_buf, "stitch");
+    }
 
     return ret;
 }
@@ -606,6 +928,10 @@ GLStitcher::configure_resource (const SmartPtr<Parameters> &param)
         ERROR, xcam_ret_is_ok (ret), ret,
         "gl-stitcher(%s) update copy areas failed", XCAM_STR (get_name ()));
 
+    // copiers and soft blenders write the output at the same time
+    if (_blend_device != BlendOnGPU)
+        set_persistent_map (true);
+
     uint32_t camera_count = get_camera_num ();
     ret = _impl->init_config (camera_count);
     XCAM_FAIL_RETURN (
@@ -643,18 +969,73 @@ GLStitcher::start_work (const SmartPtr<Parameters> &base)
         ERROR, param.ptr () && param->in_buf_num > 0 && param->in_bufs[0].ptr (), XCAM_RETURN_ERROR_PARAM,
         "gl-stitcher(%s) start work failed, invalid parameters", XCAM_STR (get_name ()));
 
+    bool timed = false;
+    param->cpu_blend = _impl->choose_cpu_blend (param, timed);
+
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    int64_t start_time = XCAM_TIMEVAL_2_USEC (ts);
+
     XCamReturn ret = _impl->start_dewarps (param);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
         "gl_stitcher(%s) start dewarps failed", XCAM_STR (get_name ()));
 
-    const SmartPtr<GLComputeProgram> prog = _impl->get_sync_prog ();
-    XCAM_ASSERT (prog.ptr ());
-    ret = prog->finish ();
+    if (param->cpu_blend) {
+        // shader writes become visible to persistent mappings after the fence
+        glMemoryBarrier (GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT_EXT);
+        GLenum error = gl_error ();
+        XCAM_FAIL_RETURN (
+            ERROR, error == GL_NO_ERROR, XCAM_RETURN_ERROR_GLES,
+            "gl-stitcher(%s) client mapped buffer barrier failed, error flag: %s",
+            XCAM_STR (get_name ()), gl_error_string (error));
+    }
+
+    // next frame is queued while this one executes, CPU access waits for frame fence or
+    // implicit synchronization of glMapBufferRange
+    SmartPtr<GLSync> fence;
+    ret = fence_frame (fence);
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING ("gl-stitcher(%s) fence frame failed, fall back to finish", XCAM_STR (get_name ()));
+        const SmartPtr<GLComputeProgram> prog = _impl->get_sync_prog ();
+        XCAM_ASSERT (prog.ptr ());
+        ret = prog->finish ();
+    } else {
+        fence_persistent_bufs (param, fence);
+        // soft blenders and timed frames wait for GPU
+        if (param->cpu_blend || timed)
+            ret = fence->wait ();
+    }
+
+    if (xcam_ret_is_ok (ret) && param->cpu_blend)
+        ret = _impl->start_soft_blenders (param);
+
+    gettimeofday (&ts, NULL);
+    _impl->end_blend_frame (param->cpu_blend, timed, xcam_ret_is_ok (ret) ? XCAM_TIMEVAL_2_USEC (ts) - start_time : -1);
 
     return ret;
 }
 
+void
+GLStitcher::fence_persistent_bufs (const SmartPtr<StitcherParam> &param, const SmartPtr<GLSync> &fence)
+{
+    std::vector<SmartPtr<VideoBuffer> > bufs;
+    bufs.push_back (param->out_buf);
+    for (uint32_t i = 0; i < param->in_buf_num; ++i)
+        bufs.push_back (param->in_bufs[i]);
+
+    // persistent buffers are never remapped, they need the fence before CPU access
+    for (size_t i = 0; i < bufs.size (); ++i) {
+        SmartPtr<GLVideoBuffer> gl_video_buf = bufs[i].dynamic_cast_ptr<GLVideoBuffer> ();
+        if (!gl_video_buf.ptr ())
+            continue;
+
+        SmartPtr<GLBuffer> gl_buf = gl_video_buf->get_gl_buffer ();
+        if (gl_buf.ptr () && gl_buf->is_persistent ())
+            gl_buf->set_fence (fence);
+    }
+}
+
 void
 GLStitcher::dewarp_done (
     const SmartPtr<ImageHandler> &handler,
@@ -672,9 +1053,18 @@ GLStitcher::dewarp_done (
     XCAM_LOG_INFO ("gl-stitcher(%s) camera(idx:%d) dewarp done", XCAM_STR (get_name ()), dewarp_param->idx);
     dump_buf (dewarp_param->out_buf, dewarp_param->idx, "stitcher-dewarp");
 
-    XCamReturn ret = _impl->start_blenders (param, dewarp_param->idx, dewarp_param->out_buf);
-    if (!xcam_ret_is_ok (ret))
-        XCAM_LOG_ERROR ("start_blenders failed");
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (param->cpu_blend) {
+        // blended by soft blenders after GPU work of the frame
+        param->dewarp_bufs[dewarp_param->idx] = dewarp_param->out_buf;
+    } else {
+        ret = _impl->start_blenders (param, dewarp_param->idx, dewarp_param->out_buf);
+        if (!xcam_ret_is_ok (ret))
+            XCAM_LOG_ERROR ("start_blenders failed");
+    }
+
+    if (is_fused_mode ())
+        return;
 
     ret = _impl->start_copier (param, dewarp_param->idx, dewarp_param->out_buf);
     if (!xcam_ret_is_ok (ret))
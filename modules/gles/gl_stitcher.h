@@ -50,13 +50,25 @@ public:
     {
         uint32_t in_buf_num;
         SmartPtr<VideoBuffer> in_bufs[XCAM_STITCH_MAX_CAMERAS];
+        // overlaps of the frame go through soft blenders after dewarps
+        bool cpu_blend;
+        SmartPtr<VideoBuffer> dewarp_bufs[XCAM_STITCH_MAX_CAMERAS];
 
         StitcherParam ()
             : Parameters (NULL, NULL)
             , in_buf_num (0)
+            , cpu_blend (false)
         {}
     };
 
+    enum BlendDevice {
+        BlendOnGPU = 0,
+        // dewarps and copies stay on GPU, overlaps are blended by soft blenders
+        BlendOnCPU,
+        // frame times of both are measured now and then, the faster one is taken
+        BlendAuto,
+    };
+
 public:
     explicit GLStitcher (const char *name = "GLStitcher");
     ~GLStitcher ();
@@ -64,6 +76,41 @@ public:
     // derived from GLImageHandler
     virtual XCamReturn terminate ();
 
+    // dewarp all cameras in one dispatch, falls back to per-camera dispatch if unsupported
+    void enable_batch_dewarp (bool enable) {
+        _batch_dewarp = enable;
+    }
+    bool is_batch_dewarp_enabled () const {
+        return _batch_dewarp;
+    }
+
+    // dewarp copy areas into output buffer directly, only overlap areas go through dewarp buffers.
+    // batch dewarp is not used in this mode. need be set before configure
+    void enable_fused_mode (bool enable) {
+        _fused_mode = enable;
+    }
+    bool is_fused_mode () const {
+        return _fused_mode;
+    }
+
+    // CPU blending shares persistent mapped dewarp and output buffers with GPU, no copy,
+    // frames fall back to GPU blending if buffers can't be mapped. need be set before configure
+    void set_blend_device (BlendDevice device) {
+        _blend_device = device;
+    }
+    BlendDevice get_blend_device () const {
+        return _blend_device;
+    }
+
+    // derived from Stitcher
+    virtual bool is_feather_blend_supported () const {
+        return true;
+    }
+    // only with CPU blending, the detector reads persistent mapped dewarp buffers
+    virtual bool is_blend_reuse_supported () const {
+        return _blend_device != BlendOnGPU;
+    }
+
 protected:
     // interface derive from Stitcher
     XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
@@ -73,6 +120,8 @@ protected:
     XCamReturn start_work (const SmartPtr<Parameters> &param);
 
 private:
+    void fence_persistent_bufs (const SmartPtr<StitcherParam> &param, const SmartPtr<GLSync> &fence);
+
     void dewarp_done (
         const SmartPtr<ImageHandler> &handler,
         const SmartPtr<ImageHandler::Parameters> &param, const XCamReturn error);
@@ -85,6 +134,9 @@ private:
 
 private:
     SmartPtr<GLSitcherPriv::StitcherImpl>    _impl;
+    bool                                     _batch_dewarp;
+    bool                                     _fused_mode;
+    BlendDevice                              _blend_device;
 };
 
 }
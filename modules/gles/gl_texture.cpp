@@ -0,0 +1,147 @@
+/*
+ * gl_texture.cpp - GL 2D texture
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "gl_texture.h"
+
+namespace XCam {
+
+static bool
+get_pixel_format (GLenum internal_format, GLenum &format, uint32_t &pixel_bytes)
+{
+    switch (internal_format) {
+    case GL_R8:
+        format = GL_RED;
+        pixel_bytes = 1;
+        break;
+    case GL_RG8:
+        format = GL_RG;
+        pixel_bytes = 2;
+        break;
+    case GL_RGBA8:
+        format = GL_RGBA;
+        pixel_bytes = 4;
+        break;
+    default:
+        XCAM_LOG_ERROR ("GL texture unsupported internal format:0x%04x", internal_format);
+        return false;
+    }
+
+    return true;
+}
+
+GLTexture::GLTexture (GLuint id, GLenum internal_format, uint32_t width, uint32_t height)
+    : _tex_id (id)
+    , _internal_format (internal_format)
+    , _width (width)
+    , _height (height)
+    , _mem_charge (MemoryGL)
+{
+    GLenum format = GL_NONE;
+    uint32_t pixel_bytes = 0;
+    if (get_pixel_format (internal_format, format, pixel_bytes))
+        _mem_charge.charge ((int64_t)pixel_bytes * width * height);
+}
+
+GLTexture::~GLTexture ()
+{
+    if (_tex_id)
+        glDeleteTextures (1, &_tex_id);
+}
+
+bool
+GLTexture::is_supported (uint32_t width, uint32_t height)
+{
+    GLint max_size = 0;
+    glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max_size);
+    XCAM_FAIL_RETURN (
+        WARNING, width <= (uint32_t)max_size && height <= (uint32_t)max_size, false,
+        "GL texture size(%dx%d) exceeds max texture size:%d", width, height, max_size);
+
+    return true;
+}
+
+SmartPtr<GLTexture>
+GLTexture::create_texture (GLenum internal_format, uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, width && height, NULL,
+        "GL create texture failed, invalid size(%dx%d)", width, height);
+
+    GLuint tex_id = 0;
+    glGenTextures (1, &tex_id);
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+    glTexStorage2D (GL_TEXTURE_2D, 1, internal_format, width, height);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture (GL_TEXTURE_2D, 0);
+
+    GLenum error = gl_error ();
+    if (error != GL_NO_ERROR) {
+        XCAM_LOG_ERROR (
+            "GL create texture(%dx%d) failed, format:0x%04x, error flag: %s",
+            width, height, internal_format, gl_error_string (error));
+        glDeleteTextures (1, &tex_id);
+        return NULL;
+    }
+
+    return new GLTexture (tex_id, internal_format, width, height);
+}
+
+XCamReturn
+GLTexture::upload (const SmartPtr<GLBuffer> &buf, uint32_t offset, uint32_t stride)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    GLenum format = GL_NONE;
+    uint32_t pixel_bytes = 0;
+    XCAM_FAIL_RETURN (
+        ERROR, get_pixel_format (_internal_format, format, pixel_bytes), XCAM_RETURN_ERROR_PARAM,
+        "GL texture upload failed, texture:%d", _tex_id);
+    XCAM_FAIL_RETURN (
+        ERROR, stride % pixel_bytes == 0, XCAM_RETURN_ERROR_PARAM,
+        "GL texture upload failed, stride:%d is not aligned to pixel size:%d", stride, pixel_bytes);
+
+    // buffer may be written by a previous shader through SSBO
+    glMemoryBarrier (GL_PIXEL_BUFFER_BARRIER_BIT);
+
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, buf->get_buffer_id ());
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, stride / pixel_bytes);
+    glBindTexture (GL_TEXTURE_2D, _tex_id);
+    glTexSubImage2D (
+        GL_TEXTURE_2D, 0, 0, 0, _width, _height, format, GL_UNSIGNED_BYTE,
+        (const GLvoid *)(uintptr_t)offset);
+
+    GLenum error = gl_error ();
+    glBindTexture (GL_TEXTURE_2D, 0);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
+    XCAM_FAIL_RETURN (
+        ERROR, error == GL_NO_ERROR, XCAM_RETURN_ERROR_GLES,
+        "GL texture upload failed, texture:%d, buffer:%d, error flag: %s",
+        _tex_id, buf->get_buffer_id (), gl_error_string (error));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,70 @@
+/*
+ * gl_texture.h - GL 2D texture
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_GL_TEXTURE_H
+#define XCAM_GL_TEXTURE_H
+
+#include <gles/gles_std.h>
+#include <gles/gl_buffer.h>
+
+namespace XCam {
+
+/*
+ * immutable GL_TEXTURE_2D sampled with linear filtering,
+ * content is copied from a GL buffer on GPU through GL_PIXEL_UNPACK_BUFFER.
+ */
+class GLTexture
+{
+public:
+    ~GLTexture ();
+
+    static bool is_supported (uint32_t width, uint32_t height);
+    static SmartPtr<GLTexture> create_texture (GLenum internal_format, uint32_t width, uint32_t height);
+
+    // stride in bytes, must be a multiple of the pixel size
+    XCamReturn upload (const SmartPtr<GLBuffer> &buf, uint32_t offset, uint32_t stride);
+
+    GLuint get_texture_id () const {
+        return _tex_id;
+    }
+    uint32_t get_width () const {
+        return _width;
+    }
+    uint32_t get_height () const {
+        return _height;
+    }
+
+private:
+    explicit GLTexture (GLuint id, GLenum internal_format, uint32_t width, uint32_t height);
+
+private:
+    XCAM_DEAD_COPY (GLTexture);
+
+private:
+    GLuint          _tex_id;
+    GLenum          _internal_format;
+    uint32_t        _width;
+    uint32_t        _height;
+    MemoryCharge    _mem_charge;
+};
+
+}
+
+#endif // XCAM_GL_TEXTURE_H
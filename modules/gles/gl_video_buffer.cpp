@@ -25,8 +25,10 @@ namespace XCam {
 class GLVideoBufferData
     : public BufferData
 {
+    friend class GLBufferDataJob;
+
 public:
-    explicit GLVideoBufferData (SmartPtr<GLBuffer> &body);
+    explicit GLVideoBufferData (SmartPtr<GLBuffer> &body, const SmartPtr<GLExecutor> &executor);
     ~GLVideoBufferData ();
 
     virtual uint8_t *map ();
@@ -36,28 +38,151 @@ public:
         return _buf;
     }
 
+private:
+    bool is_off_executor () const {
+        return _executor.ptr () && !_executor->is_current () && _executor->is_running ();
+    }
+    uint8_t *map_gl ();
+    bool unmap_gl ();
+
 private:
     uint8_t              *_buf_ptr;
     SmartPtr<GLBuffer>    _buf;
+    SmartPtr<GLExecutor>  _executor;
+};
+
+class GLBufferDataJob
+    : public GLExecutor::Job
+{
+public:
+    GLBufferDataJob (GLVideoBufferData *data, bool map)
+        : _data (data)
+        , _map (map)
+    {}
+
+    virtual XCamReturn run () {
+        if (_map)
+            return _data->map_gl () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_MEM;
+        return _data->unmap_gl () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_GLES;
+    }
+
+private:
+    GLVideoBufferData    *_data;
+    bool                  _map;
+};
+
+class GLReleaseJob
+    : public GLExecutor::Job
+{
+public:
+    GLReleaseJob (const SmartPtr<GLBuffer> &buf, bool mapped)
+        : _buf (buf)
+        , _mapped (mapped)
+    {}
+
+    virtual XCamReturn run () {
+        if (_mapped)
+            _buf->unmap ();
+        _buf.release ();
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    SmartPtr<GLBuffer>    _buf;
+    bool                  _mapped;
+};
+
+class GLAllocateJob
+    : public GLExecutor::Job
+{
+public:
+    GLAllocateJob (GLVideoBufferPool *pool, const VideoBufferInfo &info)
+        : _pool (pool)
+        , _info (info)
+        , _mem_owner (MemoryOwnerScope::current ())
+        , _mem_pooled (MemoryOwnerScope::is_pooled ())
+    {}
+
+    virtual XCamReturn run () {
+        MemoryOwnerScope mem_scope (_mem_owner, _mem_pooled);
+        _data = _pool->allocate_gl_data (_info);
+        return _data.ptr () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_MEM;
+    }
+
+    const SmartPtr<BufferData> &get_data () const {
+        return _data;
+    }
+
+private:
+    GLVideoBufferPool      *_pool;
+    VideoBufferInfo         _info;
+    SmartPtr<BufferData>    _data;
+    uint32_t                _mem_owner;
+    bool                    _mem_pooled;
 };
 
-GLVideoBufferData::GLVideoBufferData (SmartPtr<GLBuffer> &body)
+GLVideoBufferData::GLVideoBufferData (SmartPtr<GLBuffer> &body, const SmartPtr<GLExecutor> &executor)
     : _buf_ptr (NULL)
     , _buf (body)
+    , _executor (executor)
 {
     XCAM_ASSERT (body.ptr ());
 }
 
 GLVideoBufferData::~GLVideoBufferData ()
 {
-    unmap ();
+    // unmapped and deleted on executor after the work queued before
+    if (is_off_executor ()) {
+        SmartPtr<GLReleaseJob> job = new GLReleaseJob (_buf, _buf_ptr != NULL);
+        XCAM_ASSERT (job.ptr ());
+        if (xcam_ret_is_ok (_executor->submit (job))) {
+            _buf_ptr = NULL;
+            _buf.release ();
+            return;
+        }
+    }
+
+    unmap_gl ();
     _buf.release ();
 }
 
 uint8_t *
 GLVideoBufferData::map ()
 {
-    if (_buf_ptr)
+    if (_buf_ptr && !_buf->is_persistent ())
+        return _buf_ptr;
+
+    // persistent buffer without fence makes no GL call
+    if (!is_off_executor () || (_buf->is_persistent () && !_buf->is_fenced ()))
+        return map_gl ();
+
+    SmartPtr<GLBufferDataJob> job = new GLBufferDataJob (this, true);
+    XCAM_ASSERT (job.ptr ());
+    XCamReturn ret = _executor->run_sync (job);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), NULL, "GLVideoBufferData map data on executor failed");
+
+    return _buf_ptr;
+}
+
+bool
+GLVideoBufferData::unmap ()
+{
+    if (!_buf_ptr)
+        return true;
+
+    if (!is_off_executor () || _buf->is_persistent ())
+        return unmap_gl ();
+
+    SmartPtr<GLBufferDataJob> job = new GLBufferDataJob (this, false);
+    XCAM_ASSERT (job.ptr ());
+    return xcam_ret_is_ok (_executor->run_sync (job));
+}
+
+uint8_t *
+GLVideoBufferData::map_gl ()
+{
+    // persistent buffer always goes through map_range to wait for GPU access
+    if (_buf_ptr && !_buf->is_persistent ())
         return _buf_ptr;
 
     uint32_t size = _buf->get_size ();
@@ -68,7 +193,7 @@ GLVideoBufferData::map ()
 }
 
 bool
-GLVideoBufferData::unmap ()
+GLVideoBufferData::unmap_gl ()
 {
     if (!_buf_ptr)
         return true;
@@ -101,11 +226,13 @@ GLVideoBuffer::get_gl_buffer ()
 
 GLVideoBufferPool::GLVideoBufferPool ()
     : _target (GL_SHADER_STORAGE_BUFFER)
+    , _persistent_map (false)
 {
 }
 
 GLVideoBufferPool::GLVideoBufferPool (const VideoBufferInfo &info, GLenum target)
     : _target (target)
+    , _persistent_map (false)
 {
     set_video_info (info);
 }
@@ -116,15 +243,39 @@ GLVideoBufferPool::~GLVideoBufferPool ()
 
 SmartPtr<BufferData>
 GLVideoBufferPool::allocate_data (const VideoBufferInfo &info)
+{
+    if (!_executor.ptr () || _executor->is_current ())
+        return allocate_gl_data (info);
+
+    SmartPtr<GLAllocateJob> job = new GLAllocateJob (this, info);
+    XCAM_ASSERT (job.ptr ());
+    XCamReturn ret = _executor->run_sync (job);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), NULL,
+        "GLVideoBufferPool allocate data on executor failed");
+
+    return job->get_data ();
+}
+
+SmartPtr<BufferData>
+GLVideoBufferPool::allocate_gl_data (const VideoBufferInfo &info)
 {
     XCAM_FAIL_RETURN (
         ERROR, info.format == V4L2_PIX_FMT_NV12, NULL,
         "GLVideoBufferPool unsupported format:%s, try NV12",
         xcam_fourcc_to_string (info.format));
 
-    SmartPtr<GLBuffer> buf =
-        XCam::GLBuffer::create_buffer (_target, NULL, info.size, GL_STATIC_DRAW);
-    XCAM_ASSERT (buf.ptr ());
+    SmartPtr<GLBuffer> buf;
+    if (_persistent_map) {
+        buf = GLBuffer::create_persistent_buffer (_target, info.size);
+        if (!buf.ptr ()) {
+            XCAM_LOG_WARNING ("GLVideoBufferPool create persistent buffer failed, fall back to mapping on demand");
+            _persistent_map = false;
+        }
+    }
+    if (!buf.ptr ())
+        buf = GLBuffer::create_buffer (_target, NULL, info.size, GL_STATIC_DRAW);
+    XCAM_FAIL_RETURN (ERROR, buf.ptr (), NULL, "GLVideoBufferPool create buffer failed");
 
     GLBufferDesc desc;
     desc.format = info.format;
@@ -142,7 +293,10 @@ GLVideoBufferPool::allocate_data (const VideoBufferInfo &info)
 
     buf->set_buffer_desc (desc);
 
-    return new GLVideoBufferData (buf);
+    SmartPtr<GLExecutor> executor = _executor;
+    if (!executor.ptr ())
+        executor = GLExecutor::get_current ();
+    return new GLVideoBufferData (buf, executor);
 }
 
 SmartPtr<BufferProxy>
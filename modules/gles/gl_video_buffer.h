@@ -23,6 +23,7 @@
 
 #include <buffer_pool.h>
 #include <gles/gl_buffer.h>
+#include <gles/gl_executor.h>
 
 namespace XCam {
 
@@ -39,9 +40,13 @@ protected:
     explicit GLVideoBuffer (const VideoBufferInfo &info, const SmartPtr<BufferData> &data);
 };
 
+class GLAllocateJob;
+
 class GLVideoBufferPool
     : public BufferPool
 {
+    friend class GLAllocateJob;
+
 public:
     explicit GLVideoBufferPool ();
     explicit GLVideoBufferPool (const VideoBufferInfo &info, GLenum target = GL_SHADER_STORAGE_BUFFER);
@@ -51,12 +56,28 @@ public:
         _target = target;
     }
 
+    // buffers stay mapped and CPU waits only on fences, reserve 3 or more to keep a ring
+    void set_persistent_map (bool enable) {
+        _persistent_map = enable;
+    }
+
+    // buffers are created, mapped and released on @executor from other threads,
+    // else on the executor allocating them if any
+    void set_executor (const SmartPtr<GLExecutor> &executor) {
+        _executor = executor;
+    }
+
 private:
     virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &info);
     virtual SmartPtr<BufferProxy> create_buffer_from_data (SmartPtr<BufferData> &data);
 
 private:
-    GLenum    _target;
+    SmartPtr<BufferData> allocate_gl_data (const VideoBufferInfo &info);
+
+private:
+    GLenum                  _target;
+    bool                    _persistent_map;
+    SmartPtr<GLExecutor>    _executor;
 };
 
 };
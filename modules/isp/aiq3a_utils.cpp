@@ -21,40 +21,184 @@
 
 #include "aiq3a_utils.h"
 #include "x3a_isp_config.h"
+#include <stddef.h>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#endif
 
 namespace XCam {
 
+// vector path moves whole cells, needs both cells of 8 words in known order
+static bool
+is_isp_output_layout_simd ()
+{
+    return sizeof (XCamGridStat) == 8 * sizeof (uint32_t) &&
+           sizeof (struct atomisp_3a_output) == 8 * sizeof (int32_t) &&
+           offsetof (struct atomisp_3a_output, ae_y) == 0 &&
+           offsetof (struct atomisp_3a_output, awb_cnt) == 4 &&
+           offsetof (struct atomisp_3a_output, awb_gr) == 8 &&
+           offsetof (struct atomisp_3a_output, awb_r) == 12 &&
+           offsetof (struct atomisp_3a_output, awb_b) == 16 &&
+           offsetof (struct atomisp_3a_output, awb_gb) == 20 &&
+           offsetof (struct atomisp_3a_output, af_hpf1) == 24 &&
+           offsetof (struct atomisp_3a_output, af_hpf2) == 28;
+}
+
+static void
+translate_grid_row (
+    const XCamGridStat *from, uint32_t count, uint32_t color_count, struct atomisp_3a_output *to)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        to[i].ae_y = from[i].avg_y * color_count;
+        to[i].awb_cnt = from[i].valid_wb_count;
+        to[i].awb_gr = from[i].avg_gr * color_count;
+        to[i].awb_r = from[i].avg_r * color_count;
+        to[i].awb_b = from[i].avg_b * color_count;
+        to[i].awb_gb = from[i].avg_gb * color_count;
+        to[i].af_hpf1 = from[i].f_value1;
+        to[i].af_hpf2 = from[i].f_value2;
+    }
+}
+
+#if defined (__x86_64__) || defined (__i386__)
+/*
+ * one cell each iteration,
+ *   in  (y, r, gr, gb) (b, cnt, hpf1, hpf2)
+ *   out (y, cnt, gr, r) (b, gb, hpf1, hpf2), colors multiplied by @color_count
+ */
+__attribute__ ((target ("sse4.1")))
+static void
+translate_grid_row_sse4 (
+    const XCamGridStat *from, uint32_t count, uint32_t color_count, struct atomisp_3a_output *to)
+{
+    const __m128i *src = (const __m128i *) from;
+    __m128i *dst = (__m128i *) to;
+    const __m128i mul0 = _mm_setr_epi32 (color_count, 1, color_count, color_count);
+    const __m128i mul1 = _mm_setr_epi32 (color_count, color_count, 1, 1);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        __m128i s0 = _mm_loadu_si128 (src + i * 2);
+        __m128i s1 = _mm_loadu_si128 (src + i * 2 + 1);
+
+        __m128i d0 = _mm_shuffle_epi32 (s0, _MM_SHUFFLE (1, 2, 0, 0));
+        d0 = _mm_blend_epi16 (d0, s1, 0x0C);
+        __m128i d1 = _mm_blend_epi16 (s1, _mm_shuffle_epi32 (s0, _MM_SHUFFLE (3, 3, 3, 3)), 0x0C);
+
+        _mm_storeu_si128 (dst + i * 2, _mm_mullo_epi32 (d0, mul0));
+        _mm_storeu_si128 (dst + i * 2 + 1, _mm_mullo_epi32 (d1, mul1));
+    }
+}
+#endif
+
+static void
+standard_grid_row (
+    const struct atomisp_3a_output *from, uint32_t count, uint32_t pixel_count, uint32_t bit_shift,
+    XCamGridStat *to)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        to[i].avg_y = ((from[i].ae_y / pixel_count) >> bit_shift);
+        to[i].avg_r = ((from[i].awb_r / pixel_count) >> bit_shift);
+        to[i].avg_gr = ((from[i].awb_gr / pixel_count) >> bit_shift);
+        to[i].avg_gb = ((from[i].awb_gb / pixel_count) >> bit_shift);
+        to[i].avg_b = ((from[i].awb_b / pixel_count) >> bit_shift);
+        to[i].valid_wb_count = from[i].awb_cnt;
+        to[i].f_value1 = ((from[i].af_hpf1 / pixel_count) >> bit_shift);
+        to[i].f_value2 = ((from[i].af_hpf2 / pixel_count) >> bit_shift);
+    }
+}
+
+#if defined (__x86_64__) || defined (__i386__)
+/*
+ * reverse of translate_grid_row_sse4, @pixel_count is power of 2,
+ * values are divided as unsigned, so a logical shift is exact.
+ */
+__attribute__ ((target ("sse4.1")))
+static void
+standard_grid_row_sse4 (
+    const struct atomisp_3a_output *from, uint32_t count, uint32_t pixel_count, uint32_t bit_shift,
+    XCamGridStat *to)
+{
+    const __m128i *src = (const __m128i *) from;
+    __m128i *dst = (__m128i *) to;
+    const __m128i shift = _mm_cvtsi32_si128 (__builtin_ctz (pixel_count) + bit_shift);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        __m128i s0 = _mm_loadu_si128 (src + i * 2);
+        __m128i s1 = _mm_loadu_si128 (src + i * 2 + 1);
+
+        __m128i d0 = _mm_shuffle_epi32 (s0, _MM_SHUFFLE (0, 2, 3, 0));
+        d0 = _mm_blend_epi16 (d0, _mm_shuffle_epi32 (s1, _MM_SHUFFLE (1, 1, 1, 1)), 0xC0);
+        __m128i d1 = _mm_blend_epi16 (_mm_srl_epi32 (s1, shift), s0, 0x0C);
+
+        _mm_storeu_si128 (dst + i * 2, _mm_srl_epi32 (d0, shift));
+        _mm_storeu_si128 (dst + i * 2 + 1, d1);
+    }
+}
+#endif
+
+typedef void (*TranslateGridRowFunc) (
+    const XCamGridStat *from, uint32_t count, uint32_t color_count, struct atomisp_3a_output *to);
+typedef void (*StandardGridRowFunc) (
+    const struct atomisp_3a_output *from, uint32_t count, uint32_t pixel_count, uint32_t bit_shift,
+    XCamGridStat *to);
+
+static bool
+is_simd_supported ()
+{
+#if defined (__x86_64__) || defined (__i386__)
+    __builtin_cpu_init ();
+    return is_isp_output_layout_simd () && __builtin_cpu_supports ("sse4.1");
+#else
+    return false;
+#endif
+}
+
+static TranslateGridRowFunc
+get_translate_grid_row ()
+{
+#if defined (__x86_64__) || defined (__i386__)
+    if (is_simd_supported ())
+        return translate_grid_row_sse4;
+#endif
+    return translate_grid_row;
+}
+
+void
+translate_isp_stats_grid (
+    const struct atomisp_3a_output *from, uint32_t count, uint32_t pixel_count, uint32_t bit_shift,
+    XCamGridStat *to)
+{
+#if defined (__x86_64__) || defined (__i386__)
+    static const bool simd = is_simd_supported ();
+    if (simd && pixel_count && !(pixel_count & (pixel_count - 1))) {
+        standard_grid_row_sse4 (from, count, pixel_count, bit_shift, to);
+        return;
+    }
+#endif
+    standard_grid_row (from, count, pixel_count, bit_shift, to);
+}
+
 bool
 translate_3a_stats (XCam3AStats *from, struct atomisp_3a_statistics *to)
 {
     XCAM_ASSERT (from);
     XCAM_ASSERT (to);
 
+    static const TranslateGridRowFunc translate_row = get_translate_grid_row ();
+
     struct atomisp_grid_info &to_info = to->grid_info;
     XCam3AStatsInfo &from_info = from->info;
     uint32_t color_count = (from_info.grid_pixel_size / 2) * (from_info.grid_pixel_size / 2);
 
     XCAM_ASSERT (to_info.bqs_per_grid_cell == 8);
 
-    for (uint32_t i = 0; i < from_info.height; ++i)
-        for (uint32_t j = 0; j < from_info.width; ++j) {
-            to->data [i * to_info.aligned_width + j].ae_y =
-                from->stats [i * from_info.aligned_width + j].avg_y * color_count;
-            to->data [i * to_info.aligned_width + j].awb_gr =
-                from->stats [i * from_info.aligned_width + j].avg_gr * color_count;
-            to->data [i * to_info.aligned_width + j].awb_r =
-                from->stats [i * from_info.aligned_width + j].avg_r * color_count;
-            to->data [i * to_info.aligned_width + j].awb_b =
-                from->stats [i * from_info.aligned_width + j].avg_b * color_count;
-            to->data [i * to_info.aligned_width + j].awb_gb =
-                from->stats [i * from_info.aligned_width + j].avg_gb * color_count;
-            to->data [i * to_info.aligned_width + j].awb_cnt =
-                from->stats [i * from_info.aligned_width + j].valid_wb_count;
-            to->data [i * to_info.aligned_width + j].af_hpf1 =
-                from->stats [i * from_info.aligned_width + j].f_value1;
-            to->data [i * to_info.aligned_width + j].af_hpf2 =
-                from->stats [i * from_info.aligned_width + j].f_value2;
-        }
+    // single pass over rows straight into isp buffer, no staging copy
+    for (uint32_t i = 0; i < from_info.height; ++i) {
+        translate_row (
+            from->stats + i * from_info.aligned_width, from_info.width, color_count,
+            to->data + i * to_info.aligned_width);
+    }
     return true;
 }
 
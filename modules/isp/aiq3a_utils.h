@@ -31,6 +31,10 @@
 
 namespace XCam {
 bool translate_3a_stats (XCam3AStats *from, struct atomisp_3a_statistics *to);
+// one row of isp grid cells to standard cells, averages of @pixel_count reduced by @bit_shift
+void translate_isp_stats_grid (
+    const struct atomisp_3a_output *from, uint32_t count, uint32_t pixel_count, uint32_t bit_shift,
+    XCamGridStat *to);
 uint32_t translate_3a_results_to_xcam (XCam::X3aResultList &list,
                                        XCam3aResultHead *results[], uint32_t max_count);
 
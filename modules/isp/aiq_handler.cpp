@@ -1205,14 +1205,14 @@ AiqCompositor::~AiqCompositor ()
 }
 
 bool
-AiqCompositor::open (ia_binary_data &cpf)
+AiqCompositor::open (ia_binary_data &cpf, ia_binary_data *aiqd)
 {
     CmcParser cmc (cpf);
 
     _ia_mkn = ia_mkn_init (ia_mkn_cfg_compression, 32000, 100000);
     _ia_handle =
         ia_aiq_init (
-            &cpf, NULL, NULL,
+            &cpf, NULL, aiqd,
             MAX_STATISTICS_WIDTH, MAX_STATISTICS_HEIGHT,
             1, //max_num_stats_in
             cmc.get(),
@@ -1239,6 +1239,27 @@ AiqCompositor::open (ia_binary_data &cpf)
     return true;
 }
 
+bool
+AiqCompositor::get_aiqd (std::vector<uint8_t> &aiqd)
+{
+    ia_binary_data data;
+    xcam_mem_clear (data);
+
+    XCAM_FAIL_RETURN (
+        WARNING, _ia_handle, false,
+        "AIQ get aiqd failed, compositor not opened");
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        ia_aiq_get_aiqd_data (_ia_handle, &data) == ia_err_none && data.data && data.size,
+        false,
+        "AIQ get aiqd data failed");
+
+    const uint8_t *bytes = (const uint8_t *)data.data;
+    aiqd.assign (bytes, bytes + data.size);
+    return true;
+}
+
 void
 AiqCompositor::close ()
 {
@@ -30,6 +30,7 @@
 #include "ia_mkn_encoder.h"
 #include "ia_aiq.h"
 #include "ia_coordinate.h"
+#include <vector>
 
 typedef struct ia_isp_t ia_isp;
 
@@ -262,8 +263,11 @@ public:
     double get_framerate () {
         return _framerate;
     }
-    bool open (ia_binary_data &cpf);
+    // @aiqd, AIQ learned data from last run, can be NULL
+    bool open (ia_binary_data &cpf, ia_binary_data *aiqd = NULL);
     void close ();
+    // copy of AIQ learned data, call before close
+    bool get_aiqd (std::vector<uint8_t> &aiqd);
 
     bool set_sensor_mode_data (struct atomisp_sensor_mode_data *sensor_mode);
     bool set_3a_stats (SmartPtr<X3aIspStatistics> &stats);
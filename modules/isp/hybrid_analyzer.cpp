@@ -84,7 +84,7 @@ HybridAnalyzer::setup_stats_pool (const XCam3AStats *stats)
     _stats_pool = stats_pool;
 
     _stats_pool->set_grid_info (grid_info);
-    if (!_stats_pool->reserve (6)) {
+    if (!xcam_ret_is_ok (_stats_pool->reserve (6))) {
         XCAM_LOG_WARNING ("setup_stats_pool failed to reserve stats buffer.");
         return XCAM_RETURN_ERROR_MEM;
     }
@@ -29,7 +29,9 @@ namespace XCam {
 
 IspController::IspController (SmartPtr<V4l2Device> & device)
     : _device (device)
+    , _exposure_applied (false)
 {
+    xcam_mem_clear (_applied_exposure);
 }
 IspController::~IspController ()
 {
@@ -99,9 +101,19 @@ IspController::get_3a_statistics (SmartPtr<X3aIspStatistics> &stats)
 XCamReturn
 IspController::set_3a_config (X3aIspConfig *config)
 {
+    SmartLock locker (_applied_mutex);
+
+    // driver keeps the blocks which are NULL
+    if (!config->drop_unchanged (_applied_config)) {
+        XCAM_LOG_DEBUG ("isp config unchanged, skip setting parameters");
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     struct atomisp_parameters &isp_config = config->get_isp_configs ();
     if ( _device->io_control (ATOMISP_IOC_S_PARAMETERS, &isp_config) < 0) {
         XCAM_LOG_WARNING (" set 3a config failed to ISP");
+        // unknown what ISP took, set all blocks next time
+        _applied_config.clear ();
         return XCAM_RETURN_ERROR_IOCTL;
     }
 
@@ -120,16 +132,33 @@ IspController::set_3a_exposure (X3aIspExposureResult *res)
 XCamReturn
 IspController::set_3a_exposure (const struct atomisp_exposure &exposure)
 {
+    SmartLock locker (_applied_mutex);
+    if (_exposure_applied && !memcmp (&exposure, &_applied_exposure, sizeof (exposure))) {
+        XCAM_LOG_DEBUG ("isp exposure unchanged, skip setting exposure");
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     if ( _device->io_control (ATOMISP_IOC_S_EXPOSURE, (struct atomisp_exposure*)(&exposure)) < 0) {
         XCAM_LOG_WARNING (" set exposure result failed to device");
+        _exposure_applied = false;
         return XCAM_RETURN_ERROR_IOCTL;
     }
+    _applied_exposure = exposure;
+    _exposure_applied = true;
     XCAM_LOG_DEBUG ("isp set exposure result, integration_time:%d, gain code:%d",
                     exposure.integration_time[0], exposure.gain[0]);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+IspController::reset_applied_config ()
+{
+    SmartLock locker (_applied_mutex);
+    _applied_config.clear ();
+    _exposure_applied = false;
+}
+
 XCamReturn
 IspController::set_3a_focus (const XCam3aResultFocus &focus)
 {
@@ -21,6 +21,7 @@
 #define XCAM_ISP_CONTROLLER_H
 
 #include <xcam_std.h>
+#include <xcam_mutex.h>
 #include "x3a_isp_config.h"
 
 namespace XCam {
@@ -43,6 +44,8 @@ public:
     XCamReturn set_3a_exposure (X3aIspExposureResult *res);
     XCamReturn set_3a_exposure (const struct atomisp_exposure &exposure);
     XCamReturn set_3a_focus (const XCam3aResultFocus &focus);
+    // blocks and exposure same as last applied ones are not set again until reset
+    void reset_applied_config ();
 
 private:
 
@@ -50,6 +53,11 @@ private:
 
 private:
     SmartPtr<V4l2Device> _device;
+
+    Mutex                     _applied_mutex;
+    AtomIspConfigContent      _applied_config;
+    struct atomisp_exposure   _applied_exposure;
+    bool                      _exposure_applied;
 };
 
 };
@@ -47,6 +47,14 @@ IspImageProcessor::process_buffer(SmartPtr<VideoBuffer> &input, SmartPtr<VideoBu
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+IspImageProcessor::emit_start ()
+{
+    // ISP may lose parameters while stopped
+    _controller->reset_applied_config ();
+    return ImageProcessor::emit_start ();
+}
+
 bool
 IspImageProcessor::can_process_result (SmartPtr<X3aResult> &result)
 {
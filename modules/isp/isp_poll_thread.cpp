@@ -83,7 +83,7 @@ IspPollThread::init_3a_stats_pool ()
         return XCAM_RETURN_ERROR_ISP;
     }
     _3a_stats_pool.dynamic_cast_ptr<X3aStatisticsQueue>()->set_grid_info (parameters.info);
-    if (!_3a_stats_pool->reserve (6)) {
+    if (!xcam_ret_is_ok (_3a_stats_pool->reserve (6))) {
         XCAM_LOG_WARNING ("init_3a_stats_pool failed to reserve stats buffer.");
         return XCAM_RETURN_ERROR_MEM;
     }
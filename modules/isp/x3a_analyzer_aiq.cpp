@@ -23,6 +23,13 @@
 #include "isp_controller.h"
 #include "xcam_cpf_reader.h"
 #include "ia_types.h"
+#include "file_handle.h"
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define XCAM_AIQ_STATE_MAGIC 0x53514158 // "XAQS"
+#define XCAM_AIQ_STATE_VERSION 1
+#define XCAM_AIQ_STATE_ENV_VAR "XCAM_AIQ_STATE_FILE"
 
 namespace XCam {
 
@@ -65,14 +72,151 @@ bool CpfReader::read (ia_binary_data &binary)
     return true;
 }
 
+/*
+ * state file, header then AIQB record of CPF and AIQD data.
+ * CPF size and mtime are kept to drop state of an updated tuning file.
+ */
+struct AiqStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t cpf_size;
+    int64_t  cpf_mtime;
+    uint32_t aiqb_size;
+    uint32_t aiqd_size;
+};
+
+class AiqStateFile {
+public:
+    explicit AiqStateFile (const char *path, const char *cpf_path);
+
+    bool load (std::vector<uint8_t> &aiqb, std::vector<uint8_t> &aiqd);
+    bool save (const std::vector<uint8_t> &aiqb, const std::vector<uint8_t> &aiqd);
+
+private:
+    XCAM_DEAD_COPY (AiqStateFile);
+
+private:
+    const char  *_path;
+    bool         _cpf_valid;
+    uint64_t     _cpf_size;
+    int64_t      _cpf_mtime;
+};
+
+AiqStateFile::AiqStateFile (const char *path, const char *cpf_path)
+    : _path (path)
+    , _cpf_valid (false)
+    , _cpf_size (0)
+    , _cpf_mtime (0)
+{
+    struct stat cpf_stat;
+    if (cpf_path && stat (cpf_path, &cpf_stat) == 0) {
+        _cpf_valid = true;
+        _cpf_size = cpf_stat.st_size;
+        _cpf_mtime = cpf_stat.st_mtime;
+    }
+}
+
+bool
+AiqStateFile::load (std::vector<uint8_t> &aiqb, std::vector<uint8_t> &aiqd)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _cpf_valid, false,
+        "AIQ state(%s) load failed, CPF file not found", XCAM_STR (_path));
+
+    FileHandle file;
+    if (!xcam_ret_is_ok (file.open (_path, "rb"))) {
+        XCAM_LOG_DEBUG ("AIQ state(%s) not found", XCAM_STR (_path));
+        return false;
+    }
+
+    size_t size = 0;
+    AiqStateHeader header;
+    XCAM_FAIL_RETURN (
+        WARNING,
+        xcam_ret_is_ok (file.get_file_size (size)) && size >= sizeof (header) &&
+        xcam_ret_is_ok (file.read_file (&header, sizeof (header))),
+        false,
+        "AIQ state(%s) read header failed, ignored", XCAM_STR (_path));
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        header.magic == XCAM_AIQ_STATE_MAGIC && header.version == XCAM_AIQ_STATE_VERSION &&
+        header.aiqb_size && size == sizeof (header) + header.aiqb_size + header.aiqd_size,
+        false,
+        "AIQ state(%s) header mismatch, ignored", XCAM_STR (_path));
+
+    if (header.cpf_size != _cpf_size || header.cpf_mtime != _cpf_mtime) {
+        XCAM_LOG_INFO ("AIQ state(%s) made from another CPF, ignored", XCAM_STR (_path));
+        return false;
+    }
+
+    aiqb.resize (header.aiqb_size);
+    aiqd.resize (header.aiqd_size);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        xcam_ret_is_ok (file.read_file (aiqb.data (), aiqb.size ())) &&
+        (aiqd.empty () || xcam_ret_is_ok (file.read_file (aiqd.data (), aiqd.size ()))),
+        false,
+        "AIQ state(%s) read data failed", XCAM_STR (_path));
+
+    XCAM_LOG_INFO ("AIQ state loaded from %s", XCAM_STR (_path));
+    return true;
+}
+
+bool
+AiqStateFile::save (const std::vector<uint8_t> &aiqb, const std::vector<uint8_t> &aiqd)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _cpf_valid && !aiqb.empty (), false,
+        "AIQ state(%s) save failed, CPF file or data not found", XCAM_STR (_path));
+
+    // write to temporary file first, a crash never leaves partial state
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    char temp_name[XCAM_MAX_STR_SIZE] = {0};
+    snprintf (
+        temp_name, XCAM_MAX_STR_SIZE - 1, "%s." XCAM_TIMESTAMP_FORMAT,
+        _path, XCAM_TIMESTAMP_ARGS (XCAM_TIMEVAL_2_USEC (ts)));
+
+    FileHandle file;
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.open (temp_name, "wb")), false,
+        "AIQ state open file(%s) failed", temp_name);
+
+    AiqStateHeader header;
+    header.magic = XCAM_AIQ_STATE_MAGIC;
+    header.version = XCAM_AIQ_STATE_VERSION;
+    header.cpf_size = _cpf_size;
+    header.cpf_mtime = _cpf_mtime;
+    header.aiqb_size = aiqb.size ();
+    header.aiqd_size = aiqd.size ();
+
+    bool ret =
+        xcam_ret_is_ok (file.write_file (&header, sizeof (header))) &&
+        xcam_ret_is_ok (file.write_file (aiqb.data (), aiqb.size ())) &&
+        (aiqd.empty () || xcam_ret_is_ok (file.write_file (aiqd.data (), aiqd.size ())));
+    file.close ();
+
+    if (!ret || rename (temp_name, _path) != 0) {
+        remove (temp_name);
+        XCAM_LOG_WARNING ("AIQ state save to file(%s) failed", XCAM_STR (_path));
+        return false;
+    }
+
+    XCAM_LOG_INFO ("AIQ state saved to %s", XCAM_STR (_path));
+    return true;
+}
+
 X3aAnalyzerAiq::X3aAnalyzerAiq (SmartPtr<IspController> &isp, const char *cpf_path)
     : X3aAnalyzer ("X3aAnalyzerAiq")
     , _isp (isp)
     , _sensor_data_ready (false)
     , _cpf_path (NULL)
+    , _state_path (NULL)
 {
     if (cpf_path)
         _cpf_path = strndup (cpf_path, XCAM_MAX_STR_SIZE);
+    set_state_file (getenv (XCAM_AIQ_STATE_ENV_VAR));
 
     _aiq_compositor = new AiqCompositor ();
     XCAM_ASSERT (_aiq_compositor.ptr());
@@ -86,9 +230,11 @@ X3aAnalyzerAiq::X3aAnalyzerAiq (struct atomisp_sensor_mode_data &sensor_data, co
     , _sensor_mode_data (sensor_data)
     , _sensor_data_ready (true)
     , _cpf_path (NULL)
+    , _state_path (NULL)
 {
     if (cpf_path)
         _cpf_path = strndup (cpf_path, XCAM_MAX_STR_SIZE);
+    set_state_file (getenv (XCAM_AIQ_STATE_ENV_VAR));
 
     _aiq_compositor = new AiqCompositor ();
     XCAM_ASSERT (_aiq_compositor.ptr());
@@ -100,10 +246,21 @@ X3aAnalyzerAiq::~X3aAnalyzerAiq()
 {
     if (_cpf_path)
         xcam_free (_cpf_path);
+    if (_state_path)
+        xcam_free (_state_path);
 
     XCAM_LOG_DEBUG ("~X3aAnalyzerAiq destructed");
 }
 
+bool
+X3aAnalyzerAiq::set_state_file (const char *path)
+{
+    if (_state_path)
+        xcam_free (_state_path);
+    _state_path = path ? strndup (path, XCAM_MAX_STR_SIZE) : NULL;
+    return true;
+}
+
 SmartPtr<AeHandler>
 X3aAnalyzerAiq::create_ae_handler ()
 {
@@ -141,24 +298,37 @@ XCamReturn
 X3aAnalyzerAiq::internal_init (uint32_t width, uint32_t height, double framerate)
 {
     XCAM_ASSERT (_cpf_path);
-    CpfReader reader (_cpf_path);
     ia_binary_data binary;
+    ia_binary_data aiqd_binary;
+    std::vector<uint8_t> aiqd;
 
     XCAM_ASSERT (_aiq_compositor.ptr ());
 
     _aiq_compositor->set_framerate (framerate);
 
     xcam_mem_clear (binary);
-    XCAM_FAIL_RETURN (
-        ERROR,
-        reader.read(binary),
-        XCAM_RETURN_ERROR_AIQ,
-        "read cpf file(%s) failed", _cpf_path);
+    xcam_mem_clear (aiqd_binary);
+    if (!_state_path || !AiqStateFile (_state_path, _cpf_path).load (_aiqb, aiqd)) {
+        CpfReader reader (_cpf_path);
+        XCAM_FAIL_RETURN (
+            ERROR,
+            reader.read(binary),
+            XCAM_RETURN_ERROR_AIQ,
+            "read cpf file(%s) failed", _cpf_path);
+
+        const uint8_t *bytes = (const uint8_t *)binary.data;
+        _aiqb.assign (bytes, bytes + binary.size);
+        aiqd.clear ();
+    }
+    binary.data = _aiqb.data ();
+    binary.size = _aiqb.size ();
+    aiqd_binary.data = aiqd.data ();
+    aiqd_binary.size = aiqd.size ();
 
     _aiq_compositor->set_size (width, height);
     XCAM_FAIL_RETURN (
         ERROR,
-        _aiq_compositor->open (binary),
+        _aiq_compositor->open (binary, aiqd.empty () ? NULL : &aiqd_binary),
         XCAM_RETURN_ERROR_AIQ,
         "AIQ open failed");
 
@@ -168,8 +338,12 @@ X3aAnalyzerAiq::internal_init (uint32_t width, uint32_t height, double framerate
 XCamReturn
 X3aAnalyzerAiq::internal_deinit ()
 {
-    if (_aiq_compositor.ptr ())
+    if (_aiq_compositor.ptr ()) {
+        std::vector<uint8_t> aiqd;
+        if (_state_path && _aiq_compositor->get_aiqd (aiqd))
+            AiqStateFile (_state_path, _cpf_path).save (_aiqb, aiqd);
         _aiq_compositor->close ();
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -24,6 +24,7 @@
 #include <xcam_std.h>
 #include "x3a_analyzer.h"
 #include <linux/atomisp.h>
+#include <vector>
 
 namespace XCam {
 
@@ -38,6 +39,14 @@ public:
     explicit X3aAnalyzerAiq (struct atomisp_sensor_mode_data &sensor_data, const char *cpf_path);
     ~X3aAnalyzerAiq ();
 
+    /*
+     * AIQ tuning data and AIQ learned data (converged AE/AWB history) are saved
+     * to @path on deinit and warm start the next init, skipping CPF parsing.
+     * state made from another CPF file (size or mtime) is ignored.
+     * default from env XCAM_AIQ_STATE_FILE, set before init
+     */
+    bool set_state_file (const char *path);
+
 private:
 
     XCAM_DEAD_COPY (X3aAnalyzerAiq);
@@ -62,6 +71,8 @@ private:
     struct atomisp_sensor_mode_data   _sensor_mode_data;
     bool                              _sensor_data_ready;
     char                             *_cpf_path;
+    char                             *_state_path;
+    std::vector<uint8_t>              _aiqb;
 };
 
 };
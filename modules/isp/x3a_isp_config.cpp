@@ -182,6 +182,70 @@ AtomIspConfigContent::copy (const struct atomisp_parameters &config)
     }
 }
 
+#define XCAM_ISP_BLOCK_DROP_UNCHANGED(config, block)                                  \
+    if (isp_config.config) {                                                        \
+        if (applied.isp_config.config &&                                            \
+                !memcmp (isp_config.config, &applied.block, sizeof (applied.block))) { \
+            isp_config.config = NULL;                                               \
+        } else {                                                                    \
+            applied.block = *isp_config.config;                                     \
+            applied.isp_config.config = &applied.block;                             \
+            ++changed;                                                              \
+        }                                                                           \
+    }
+
+// tables referring to other memory by pointers can't be compared
+#define XCAM_ISP_BLOCK_ALWAYS_CHANGED(config)                                        \
+    if (isp_config.config) {                                                        \
+        ++changed;                                                                  \
+    }
+
+uint32_t
+AtomIspConfigContent::drop_unchanged (AtomIspConfigContent &applied)
+{
+    uint32_t changed = 0;
+
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (wb_config, wb);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (cc_config, cc);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (tnr_config, tnr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ecd_config, ecd_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ynr_config, ynr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (fc_config, fc_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (cnr_config, cnr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (macc_config, macc_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ctc_config, ctc_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (formats_config, formats);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (aa_config, aa);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (baa_config, baa);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ce_config, ce);
+    XCAM_ISP_BLOCK_ALWAYS_CHANGED (dvs_6axis_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ob_config, ob);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (nr_config, nr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (dp_config, dp);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ee_config, ee);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (de_config, de);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (ctc_table, ctc_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (gc_config, gc_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (anr_config, anr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (a3a_config, a3a);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (xnr_config, xnr);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (dz_config, dz_config);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (yuv2rgb_cc_config, yuv2rgb_cc);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (rgb2yuv_cc_config, rgb2yuv_cc);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (macc_table, macc_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (gamma_table, gamma_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (r_gamma_table, r_gamma_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (g_gamma_table, g_gamma_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (b_gamma_table, b_gamma_table);
+    XCAM_ISP_BLOCK_ALWAYS_CHANGED (shading_table);
+    XCAM_ISP_BLOCK_ALWAYS_CHANGED (morph_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (xnr_table, xnr_table);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (anr_thres, anr_thres);
+    XCAM_ISP_BLOCK_DROP_UNCHANGED (motion_vector, motion_vector);
+
+    return changed;
+}
+
 X3aIspConfig::X3aIspConfig ()
 {
 }
@@ -77,6 +77,9 @@ struct AtomIspConfigContent {
 
     void clear ();
     void copy (const struct atomisp_parameters &config);
+    // leaves only blocks differing from applied in isp_config and keeps them in applied,
+    // returns the number of changed blocks
+    uint32_t drop_unchanged (AtomIspConfigContent &applied);
 
     AtomIspConfigContent () {
         clear ();
@@ -109,6 +112,9 @@ public:
     }
     bool clear ();
     bool attach (SmartPtr<X3aResult> &result, IspConfigTranslator *translator);
+    uint32_t drop_unchanged (AtomIspConfigContent &applied) {
+        return _isp_content.drop_unchanged (applied);
+    }
 
 private:
     XCAM_DEAD_COPY (X3aIspConfig);
@@ -19,6 +19,7 @@
  */
 
 #include "x3a_statistics_queue.h"
+#include "aiq3a_utils.h"
 #include <linux/videodev2.h>
 #include <linux/atomisp.h>
 #include <math.h>
@@ -66,24 +67,9 @@ X3aIspStatsData::fill_standard_stats ()
     XCAM_ASSERT (isp_info.width == standard_info.width);
     XCAM_ASSERT (isp_info.height == standard_info.height);
     for (uint32_t i = 0; i < isp_info.height; ++i) {
-        for (uint32_t j = 0; j < isp_info.width; ++j) {
-            standard_data[i * standard_info.aligned_width + j].avg_y =
-                ((isp_data[i * isp_info.aligned_width + j].ae_y / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].avg_r =
-                ((isp_data[i * isp_info.aligned_width + j].awb_r / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].avg_gr =
-                ((isp_data[i * isp_info.aligned_width + j].awb_gr / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].avg_gb =
-                ((isp_data[i * isp_info.aligned_width + j].awb_gb / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].avg_b =
-                ((isp_data[i * isp_info.aligned_width + j].awb_b / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].valid_wb_count =
-                isp_data[i * isp_info.aligned_width + j].awb_cnt;
-            standard_data[i * standard_info.aligned_width + j].f_value1 =
-                ((isp_data[i * isp_info.aligned_width + j].af_hpf1 / pixel_count) >> bit_shift);
-            standard_data[i * standard_info.aligned_width + j].f_value2 =
-                ((isp_data[i * isp_info.aligned_width + j].af_hpf2 / pixel_count) >> bit_shift);
-        }
+        translate_isp_stats_grid (
+            isp_data + i * isp_info.aligned_width, isp_info.width, pixel_count, bit_shift,
+            standard_data + i * standard_info.aligned_width);
     }
 
     if (isp_info.has_histogram) {
@@ -230,16 +216,9 @@ X3aStatisticsQueue::allocate_data (const VideoBufferInfo &buffer_info)
     XCam3AStatsInfo stats_info = get_stats_info ();
     struct atomisp_3a_statistics *isp_stats = alloc_isp_statsictics ();
 
-    stats = (XCam3AStats *) xcam_malloc0 (
-                sizeof (XCam3AStats) +
-                sizeof (XCamHistogram) * stats_info.histogram_bins +
-                sizeof (uint32_t) * stats_info.histogram_bins +
-                sizeof (XCamGridStat) * stats_info.aligned_width * stats_info.aligned_height);
+    stats = (XCam3AStats *) xcam_malloc0 (get_stats_size (stats_info));
     XCAM_ASSERT (isp_stats && stats);
-    stats->info = stats_info;
-    stats->hist_rgb = (XCamHistogram *) (stats->stats +
-                                         stats_info.aligned_width * stats_info.aligned_height);
-    stats->hist_y = (uint32_t *) (stats->hist_rgb + stats_info.histogram_bins);
+    init_stats (stats, stats_info);
 
     return new X3aIspStatsData (isp_stats, stats);
 }
@@ -22,6 +22,7 @@
 #include "cl_csc_handler.h"
 #include "cl_bayer_pipe_handler.h"
 #include "cl_yuv_pipe_handler.h"
+#include "cl_bayer_fused_handler.h"
 #if ENABLE_YEENR_HANDLER
 #include "cl_ee_handler.h"
 #endif
@@ -32,6 +33,12 @@
 
 #define XCAM_CL_3A_IMAGE_MAX_POOL_SIZE 6
 
+// share of frame budget to step profile down or back up, the gap avoids toggling
+#define XCAM_CL_3A_PROFILE_DOWN_RATIO  0.9
+#define XCAM_CL_3A_PROFILE_UP_RATIO    0.6
+// frames to settle after a switch before next decision
+#define XCAM_CL_3A_PROFILE_HOLD_FRAMES 30
+
 namespace XCam {
 
 CL3aImageProcessor::CL3aImageProcessor ()
@@ -39,8 +46,13 @@ CL3aImageProcessor::CL3aImageProcessor ()
     , _output_fourcc (V4L2_PIX_FMT_NV12)
     , _3a_stats_bits (8)
     , _pipeline_profile (BasicPipelineProfile)
+    , _active_profile (BasicPipelineProfile)
+    , _frame_budget (0)
+    , _avg_frame_time (0)
+    , _profile_hold (0)
     , _capture_stage (TonemappingStage)
     , _wdr_mode (WDRdisabled)
+    , _enable_fused_pipe (false)
     , _tnr_mode (0)
     , _enable_gamma (true)
     , _enable_macc (true)
@@ -190,6 +202,10 @@ CL3aImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
             _yuv_pipe->set_rgbtoyuv_matrix (csc_res->get_standard_result ());
             _yuv_pipe->set_3a_result (result);
         }
+        if (_bayer_fused.ptr()) {
+            _bayer_fused->set_rgbtoyuv_matrix (csc_res->get_standard_result ());
+            _bayer_fused->set_3a_result (result);
+        }
         break;
     }
 
@@ -200,6 +216,10 @@ CL3aImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
             _yuv_pipe->set_macc_table (macc_res->get_standard_result ());
             _yuv_pipe->set_3a_result (result);
         }
+        if (_bayer_fused.ptr()) {
+            _bayer_fused->set_macc_table (macc_res->get_standard_result ());
+            _bayer_fused->set_3a_result (result);
+        }
         break;
     }
     case XCAM_3A_RESULT_R_GAMMA:
@@ -331,31 +351,44 @@ CL3aImageProcessor::create_handlers ()
         break;
     }
 
-    /* bayer pipe */
-    image_handler = create_cl_bayer_pipe_image_handler (context);
-    _bayer_pipe = image_handler.dynamic_cast_ptr<CLBayerPipeImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        image_handler.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CL3aImageProcessor create bayer pipe handler failed");
+    if (is_fused_pipe_usable ()) {
+        /* demosaic to NV12 in one pass */
+        image_handler = create_cl_bayer_fused_image_handler (context);
+        _bayer_fused = image_handler.dynamic_cast_ptr<CLBayerFusedImageHandler> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            _bayer_fused.ptr (),
+            XCAM_RETURN_ERROR_CL,
+            "CL3aImageProcessor create bayer fused handler failed");
+        image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
+        add_handler (image_handler);
+    } else {
+        /* bayer pipe */
+        image_handler = create_cl_bayer_pipe_image_handler (context);
+        _bayer_pipe = image_handler.dynamic_cast_ptr<CLBayerPipeImageHandler> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            image_handler.ptr (),
+            XCAM_RETURN_ERROR_CL,
+            "CL3aImageProcessor create bayer pipe handler failed");
 
-    _bayer_pipe->enable_denoise (XCAM_DENOISE_TYPE_BNR & _snr_mode);
-    image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
-    add_handler (image_handler);
-    if(_capture_stage == BasicbayerStage)
-        return XCAM_RETURN_NO_ERROR;
+        _bayer_pipe->enable_denoise (is_bnr_enabled ());
+        image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
+        add_handler (image_handler);
+        if(_capture_stage == BasicbayerStage)
+            return XCAM_RETURN_NO_ERROR;
 
-    image_handler = create_cl_yuv_pipe_image_handler (context);
-    _yuv_pipe = image_handler.dynamic_cast_ptr<CLYuvPipeImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _yuv_pipe.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CL3aImageProcessor create yuv pipe handler failed");
-    _yuv_pipe->set_tnr_enable (_tnr_mode & CL_TNR_TYPE_YUV);
-    image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
-    add_handler (image_handler);
+        image_handler = create_cl_yuv_pipe_image_handler (context);
+        _yuv_pipe = image_handler.dynamic_cast_ptr<CLYuvPipeImageHandler> ();
+        XCAM_FAIL_RETURN (
+            WARNING,
+            _yuv_pipe.ptr (),
+            XCAM_RETURN_ERROR_CL,
+            "CL3aImageProcessor create yuv pipe handler failed");
+        _yuv_pipe->set_tnr_enable (is_tnr_yuv_enabled ());
+        image_handler->set_pool_size (XCAM_CL_3A_IMAGE_MAX_POOL_SIZE * 2);
+        add_handler (image_handler);
+    }
 
 #if ENABLE_YEENR_HANDLER
     /* ee */
@@ -389,14 +422,19 @@ CL3aImageProcessor::post_config ()
     uint32_t swap_y_count = 0;
     bool start_count = false;
     bool ret = true;
+    SmartPtr<CLImageHandler> convert_yuv;
 
-    if (!_yuv_pipe.ptr ())  //not necessary to check
+    // handler giving NV12 out
+    if (_yuv_pipe.ptr ())
+        convert_yuv = _yuv_pipe;
+    else if (_bayer_fused.ptr ())
+        convert_yuv = _bayer_fused;
+    else  //not necessary to check
         return true;
 
     for (; i_handler != end; ++i_handler) {
         if (!start_count) {
-            SmartPtr<CLYuvPipeImageHandler> convert_yuv = (*i_handler).dynamic_cast_ptr<CLYuvPipeImageHandler> ();
-            if (convert_yuv.ptr () && convert_yuv.ptr () == _yuv_pipe.ptr ())
+            if ((*i_handler).ptr () == convert_yuv.ptr ())
                 start_count = true;
             continue;
         }
@@ -407,9 +445,9 @@ CL3aImageProcessor::post_config ()
     }
 
     if (swap_y_count % 2 == 1)
-        ret = _yuv_pipe->enable_buf_pool_swap_flags (SwappedBuffer::SwapY | SwappedBuffer::SwapUV, SwappedBuffer::OrderY1Y0 | SwappedBuffer::OrderUV0UV1);
+        ret = convert_yuv->enable_buf_pool_swap_flags (SwappedBuffer::SwapY | SwappedBuffer::SwapUV, SwappedBuffer::OrderY1Y0 | SwappedBuffer::OrderUV0UV1);
     else
-        ret = _yuv_pipe->enable_buf_pool_swap_flags (SwappedBuffer::SwapY | SwappedBuffer::SwapUV, SwappedBuffer::OrderY0Y1 | SwappedBuffer::OrderUV0UV1);
+        ret = convert_yuv->enable_buf_pool_swap_flags (SwappedBuffer::SwapY | SwappedBuffer::SwapUV, SwappedBuffer::OrderY0Y1 | SwappedBuffer::OrderUV0UV1);
 
     return ret;
 }
@@ -426,9 +464,102 @@ CL3aImageProcessor::set_profile (const CL3aImageProcessor::PipelineProfile value
         _snr_mode |= XCAM_DENOISE_TYPE_BNR;
     }
     STREAM_LOCK;
+    _active_profile = value;
+    _avg_frame_time = 0;
+    _profile_hold = 0;
+    update_profile_stages ();
+
+    return true;
+}
+
+void
+CL3aImageProcessor::set_profile_budget (int64_t frame_budget)
+{
+    STREAM_LOCK;
+    _frame_budget = XCAM_MAX (frame_budget, (int64_t)0);
+    _avg_frame_time = 0;
+    _profile_hold = 0;
+    if (!_frame_budget && _active_profile != _pipeline_profile) {
+        _active_profile = _pipeline_profile;
+        update_profile_stages ();
+    }
+}
+
+// stages added by the set profile are shed while running below it
+bool
+CL3aImageProcessor::is_tnr_yuv_enabled () const
+{
+    if (_active_profile < AdvancedPipelineProfile && _pipeline_profile >= AdvancedPipelineProfile)
+        return false;
+    return (_tnr_mode & CL_TNR_TYPE_YUV);
+}
+
+bool
+CL3aImageProcessor::is_bnr_enabled () const
+{
+    if (_active_profile < ExtremePipelineProfile && _pipeline_profile >= ExtremePipelineProfile)
+        return false;
+    return (_snr_mode & XCAM_DENOISE_TYPE_BNR);
+}
+
+void
+CL3aImageProcessor::update_profile_stages ()
+{
     if (_yuv_pipe.ptr ())
-        _yuv_pipe->set_tnr_enable (_tnr_mode & CL_TNR_TYPE_YUV);
+        _yuv_pipe->set_tnr_enable (is_tnr_yuv_enabled ());
+    if (_bayer_pipe.ptr ())
+        _bayer_pipe->enable_denoise (is_bnr_enabled ());
+}
 
+void
+CL3aImageProcessor::frame_processed (int64_t process_time)
+{
+    STREAM_LOCK;
+    if (!_frame_budget)
+        return;
+
+    // moving average over about 8 frames
+    _avg_frame_time = _avg_frame_time ? (_avg_frame_time * 7 + process_time) / 8 : process_time;
+    if (_profile_hold) {
+        --_profile_hold;
+        return;
+    }
+
+    PipelineProfile profile = _active_profile;
+    if (_avg_frame_time > _frame_budget * XCAM_CL_3A_PROFILE_DOWN_RATIO && profile > BasicPipelineProfile)
+        profile = (PipelineProfile)(profile - 1);
+    else if (_avg_frame_time < _frame_budget * XCAM_CL_3A_PROFILE_UP_RATIO && profile < _pipeline_profile)
+        profile = (PipelineProfile)(profile + 1);
+
+    if (profile == _active_profile)
+        return;
+
+    XCAM_LOG_INFO (
+        "CL3aImageProcessor frame time %" PRId64 "us against budget %" PRId64 "us, profile %d -> %d",
+        _avg_frame_time, _frame_budget, (int)_active_profile, (int)profile);
+    _active_profile = profile;
+    _avg_frame_time = 0;
+    _profile_hold = XCAM_CL_3A_PROFILE_HOLD_FRAMES;
+    update_profile_stages ();
+}
+
+bool
+CL3aImageProcessor::set_fused_pipe (bool enable)
+{
+    _enable_fused_pipe = enable;
+    return true;
+}
+
+// fused pass has neither BNR nor TNR-YUV, nor a RGB stage to capture
+bool
+CL3aImageProcessor::is_fused_pipe_usable () const
+{
+    if (!_enable_fused_pipe || _capture_stage == BasicbayerStage)
+        return false;
+    if ((_tnr_mode & CL_TNR_TYPE_YUV) || (_snr_mode & XCAM_DENOISE_TYPE_BNR)) {
+        XCAM_LOG_INFO ("CL3aImageProcessor fused pipe skipped, BNR or TNR-YUV needs separate passes");
+        return false;
+    }
     return true;
 }
 
@@ -449,7 +580,9 @@ CL3aImageProcessor::set_denoise (uint32_t mode)
 
     STREAM_LOCK;
     if (_bayer_pipe.ptr ())
-        _bayer_pipe->enable_denoise (XCAM_DENOISE_TYPE_BNR & _snr_mode);
+        _bayer_pipe->enable_denoise (is_bnr_enabled ());
+    else if (_bayer_fused.ptr () && (mode & XCAM_DENOISE_TYPE_BNR))
+        XCAM_LOG_WARNING ("CL3aImageProcessor BNR is not applied on fused pipe until restart");
 
     return true;
 }
@@ -481,7 +614,9 @@ CL3aImageProcessor::set_tnr (uint32_t mode, uint8_t level)
 
     STREAM_LOCK;
     if (_yuv_pipe.ptr ())
-        _yuv_pipe->set_tnr_enable (_tnr_mode & CL_TNR_TYPE_YUV);
+        _yuv_pipe->set_tnr_enable (is_tnr_yuv_enabled ());
+    else if (_bayer_fused.ptr () && (mode & CL_TNR_TYPE_YUV))
+        XCAM_LOG_WARNING ("CL3aImageProcessor TNR-YUV is not applied on fused pipe until restart");
 
     return true;
 }
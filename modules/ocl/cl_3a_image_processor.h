@@ -32,6 +32,7 @@ class CLCscImageHandler;
 class CLEeImageHandler;
 class CLBayerBasicImageHandler;
 class CLBayerPipeImageHandler;
+class CLBayerFusedImageHandler;
 class CLYuvPipeImageHandler;
 class CLTonemappingImageHandler;
 class CLNewTonemappingImageHandler;
@@ -70,11 +71,21 @@ public:
     virtual ~CL3aImageProcessor ();
 
     bool set_profile (PipelineProfile value);
+    /*
+     * live switch between profiles without restart, running below the set profile
+     * while frame time goes over @frame_budget us, back up once it drops; 0 disables
+     */
+    void set_profile_budget (int64_t frame_budget);
     void set_stats_callback (const SmartPtr<StatsCallback> &callback);
 
     bool set_output_format (uint32_t fourcc);
     bool set_capture_stage (CaptureStage capture_stage);
     bool set_3a_stats_bits (uint32_t bits);
+    /*
+     * one fused pass from bayer basic output to NV12 in place of bayer pipe and yuv pipe,
+     * taken at start only if neither BNR nor TNR-YUV is on, they need the separate passes
+     */
+    bool set_fused_pipe (bool enable);
 
     virtual bool set_denoise (uint32_t mode);
     virtual bool set_gamma (bool enable);
@@ -85,6 +96,9 @@ public:
     PipelineProfile get_profile () const {
         return _pipeline_profile;
     }
+    PipelineProfile get_active_profile () const {
+        return _active_profile;
+    }
 
 protected:
 
@@ -93,16 +107,27 @@ protected:
     virtual XCamReturn apply_3a_results (X3aResultList &results);
     virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
 
+    //derive from CLImageProcessor
+    virtual void frame_processed (int64_t process_time);
+
 private:
     virtual XCamReturn create_handlers ();
 
     bool post_config ();
+    bool is_tnr_yuv_enabled () const;
+    bool is_bnr_enabled () const;
+    bool is_fused_pipe_usable () const;
+    void update_profile_stages ();
     XCAM_DEAD_COPY (CL3aImageProcessor);
 
 private:
     uint32_t                            _output_fourcc;
     uint32_t                            _3a_stats_bits;
     PipelineProfile                     _pipeline_profile;
+    PipelineProfile                     _active_profile;
+    int64_t                             _frame_budget;
+    int64_t                             _avg_frame_time;
+    uint32_t                            _profile_hold;
     CaptureStage                        _capture_stage;
     CLTonemappingMode                   _wdr_mode;
     SmartPtr<StatsCallback>             _stats_callback;
@@ -117,6 +142,8 @@ private:
     SmartPtr<CLBayerBasicImageHandler>  _bayer_basic_pipe;
     SmartPtr<CLBayerPipeImageHandler>   _bayer_pipe;
     SmartPtr<CLYuvPipeImageHandler>     _yuv_pipe;
+    SmartPtr<CLBayerFusedImageHandler>  _bayer_fused;
+    bool                                _enable_fused_pipe;
 
     uint32_t                            _tnr_mode;
     bool                                _enable_gamma;
@@ -23,12 +23,160 @@
 #include "cl_3a_stats_context.h"
 
 namespace XCam {
+
+enum {
+    Kernel3AStatsReduce = 0,
+    Kernel3AStatsHistogram,
+};
+
+static const XCamKernelInfo kernels_3a_stats_info [] = {
+    {
+        "kernel_3a_stats_reduce",
+#include "kernel_3a_stats.clx"
+        , 0,
+    },
+    {
+        "kernel_3a_stats_histogram",
+#include "kernel_3a_stats.clx"
+        , 0,
+    },
+};
+
+/*
+ * XCam3AStats in a host allocated cl buffer, kernels write grids and histograms behind
+ * the header, then it is mapped and handed out without copy. device writes only while
+ * it is unmapped, the buffer back to pool stays mapped till it is reused.
+ */
+class CL3AStatsData
+    : public X3aStatsData
+{
+public:
+    explicit CL3AStatsData (const SmartPtr<CLBuffer> &buf, const XCam3AStatsInfo &info)
+        : _buf (buf)
+        , _info (info)
+        , _ptr (NULL)
+    {}
+    ~CL3AStatsData () {
+        unmap_stats ();
+    }
+
+    const SmartPtr<CLBuffer> &get_cl_buffer () const {
+        return _buf;
+    }
+    XCamReturn map_stats (CLEventList &events);
+    XCamReturn unmap_stats ();
+
+private:
+    XCAM_DEAD_COPY (CL3AStatsData);
+
+private:
+    SmartPtr<CLBuffer>      _buf;
+    XCam3AStatsInfo         _info;
+    void                   *_ptr;
+};
+
+XCamReturn
+CL3AStatsData::map_stats (CLEventList &events)
+{
+    XCAM_ASSERT (!_ptr);
+
+    // write for the header
+    XCamReturn ret = _buf->enqueue_map (
+                         _ptr, 0, _buf->get_buf_size (), CL_MAP_READ | CL_MAP_WRITE, events);
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, ret, "3a stats enqueue map cl stats failed");
+
+    XCam3AStats *stats = (XCam3AStats *)_ptr;
+    X3aStatsPool::init_stats (stats, _info);
+    set_stats (stats);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CL3AStatsData::unmap_stats ()
+{
+    if (!_ptr)
+        return XCAM_RETURN_NO_ERROR;
+
+    set_stats (NULL);
+    SmartPtr<CLEvent> unmap_event = new CLEvent;
+    XCamReturn ret = _buf->enqueue_unmap (_ptr, CLEvent::EmptyList, unmap_event);
+    _ptr = NULL;
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, ret, "3a stats enqueue unmap cl stats failed");
+
+    return unmap_event->wait ();
+}
+
+class CL3AStats
+    : public X3aStats
+{
+    friend class CL3AStatsPool;
+
+public:
+    SmartPtr<CL3AStatsData> get_cl_stats_data () {
+        return get_buffer_data ().dynamic_cast_ptr<CL3AStatsData> ();
+    }
+
+protected:
+    explicit CL3AStats (const SmartPtr<CL3AStatsData> &data)
+        : X3aStats (SmartPtr<X3aStatsData> (data))
+    {}
+
+private:
+    XCAM_DEAD_COPY (CL3AStats);
+};
+
+class CL3AStatsPool
+    : public X3aStatsPool
+{
+public:
+    explicit CL3AStatsPool (const SmartPtr<CLContext> &context)
+        : _context (context)
+    {}
+
+protected:
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
+    virtual SmartPtr<BufferProxy> create_buffer_from_data (SmartPtr<BufferData> &data);
+
+private:
+    XCAM_DEAD_COPY (CL3AStatsPool);
+
+private:
+    SmartPtr<CLContext>     _context;
+};
+
+SmartPtr<BufferData>
+CL3AStatsPool::allocate_data (const VideoBufferInfo &buffer_info)
+{
+    XCAM_UNUSED (buffer_info);
+    const XCam3AStatsInfo &info = get_stats_info ();
+
+    // default flags allocate host memory, mapping needs no copy
+    SmartPtr<CLBuffer> buf = new CLBuffer (_context, get_stats_size (info));
+    XCAM_FAIL_RETURN (
+        WARNING, buf.ptr () && buf->is_valid (), NULL,
+        "allocate cl 3a stats buffer failed");
+
+    return new CL3AStatsData (buf, info);
+}
+
+SmartPtr<BufferProxy>
+CL3AStatsPool::create_buffer_from_data (SmartPtr<BufferData> &data)
+{
+    SmartPtr<CL3AStatsData> stats_data = data.dynamic_cast_ptr<CL3AStatsData> ();
+    XCAM_ASSERT (stats_data.ptr ());
+
+    return new CL3AStats (stats_data);
+}
+
 CL3AStatsCalculatorContext::CL3AStatsCalculatorContext (const SmartPtr<CLContext> &context)
     : _context (context)
     , _width_factor (1)
     , _height_factor (1)
     , _factor_shift (0)
     , _data_allocated (false)
+    , _bit_depth (0)
+    , _gpu_reduce (true)
+    , _gpu_ready (false)
 {
     SmartPtr<X3aStatsPool> pool = new X3aStatsPool ();
     XCAM_ASSERT (pool.ptr ());
@@ -44,6 +192,7 @@ void
 CL3AStatsCalculatorContext::set_bit_depth (uint32_t bits)
 {
     XCAM_ASSERT (_stats_pool.ptr ());
+    _bit_depth = bits;
     _stats_pool->set_bit_depth (bits);
 }
 
@@ -52,11 +201,23 @@ CL3AStatsCalculatorContext::allocate_data (const VideoBufferInfo &buffer_info, u
 {
     uint32_t multiply_factor = 0;
 
+    _gpu_ready = false;
+    if (_gpu_reduce) {
+        if (init_gpu_reduce ()) {
+            _stats_pool = new CL3AStatsPool (_context);
+            if (_bit_depth)
+                _stats_pool->set_bit_depth (_bit_depth);
+            _gpu_ready = true;
+        } else {
+            XCAM_LOG_WARNING ("3a stats gpu reduction init failed, reduce on cpu");
+        }
+    }
+
     _stats_pool->set_video_info (buffer_info);
 
     XCAM_FAIL_RETURN (
         WARNING,
-        _stats_pool->reserve (32), // need reserve more if as attachement
+        xcam_ret_is_ok (_stats_pool->reserve (32)), // need reserve more if as attachement
         false,
         "reserve cl stats buffer failed");
 
@@ -87,6 +248,7 @@ CL3AStatsCalculatorContext::allocate_data (const VideoBufferInfo &buffer_info, u
             "allocate cl stats buffer failed");
         _stats_cl_buffers.push (buf_new);
     }
+
     _data_allocated = true;
 
     return true;
@@ -111,6 +273,99 @@ CL3AStatsCalculatorContext::clean_up_data ()
     _stats_cl_buffers.clear ();
 }
 
+bool
+CL3AStatsCalculatorContext::init_gpu_reduce ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    if (!_reduce_kernel.ptr ()) {
+        SmartPtr<CLKernel> kernel = new CLKernel (_context, "kernel_3a_stats_reduce");
+        ret = kernel->build_kernel (kernels_3a_stats_info[Kernel3AStatsReduce], NULL);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR && kernel->is_valid (), false,
+            "build kernel(%s) failed", kernels_3a_stats_info[Kernel3AStatsReduce].kernel_name);
+        _reduce_kernel = kernel;
+    }
+    if (!_histogram_kernel.ptr ()) {
+        SmartPtr<CLKernel> kernel = new CLKernel (_context, "kernel_3a_stats_histogram");
+        ret = kernel->build_kernel (kernels_3a_stats_info[Kernel3AStatsHistogram], NULL);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR && kernel->is_valid (), false,
+            "build kernel(%s) failed", kernels_3a_stats_info[Kernel3AStatsHistogram].kernel_name);
+        _histogram_kernel = kernel;
+    }
+
+    return true;
+}
+
+XCamReturn
+CL3AStatsCalculatorContext::reduce_stats (
+    const SmartPtr<CLBuffer> &stats_cl_buf, const SmartPtr<CLBuffer> &out_buf, SmartPtr<CLEvent> &event)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    CLArgList args;
+    CLWorkSize work_size;
+    // grids start behind XCam3AStats header, in uint
+    uint32_t header = sizeof (XCam3AStats) / sizeof (uint32_t);
+
+    args.push_back (new CLMemArgument (stats_cl_buf));
+    args.push_back (new CLMemArgument (out_buf));
+    args.push_back (new CLArgumentT<uint32_t> (header));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.width));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.height));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.aligned_width));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.aligned_height));
+    args.push_back (new CLArgumentT<uint32_t> (_width_factor));
+    args.push_back (new CLArgumentT<uint32_t> (_height_factor));
+    args.push_back (new CLArgumentT<uint32_t> (_factor_shift));
+
+    work_size.dim = 2;
+    work_size.local[0] = 8;
+    work_size.local[1] = 8;
+    work_size.global[0] = XCAM_ALIGN_UP (_stats_info.aligned_width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (_stats_info.aligned_height, work_size.local[1]);
+
+    ret = _reduce_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "3a stats reduce kernel set arguments failed");
+
+    SmartPtr<CLEvent> reduce_event = new CLEvent;
+    ret = _reduce_kernel->execute (_reduce_kernel, false, CLEvent::EmptyList, reduce_event);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "3a stats reduce kernel execute failed");
+
+    args.clear ();
+    args.push_back (new CLMemArgument (out_buf));
+    args.push_back (new CLArgumentT<uint32_t> (header));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.width));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.height));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.aligned_width));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.aligned_height));
+    args.push_back (new CLArgumentT<uint32_t> (_stats_info.histogram_bins));
+
+    work_size.dim = 1;
+    work_size.local[0] = 64;
+    work_size.local[1] = 0;
+    work_size.global[0] = XCAM_ALIGN_UP (_stats_info.histogram_bins, work_size.local[0]);
+    work_size.global[1] = 0;
+
+    ret = _histogram_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "3a stats histogram kernel set arguments failed");
+
+    CLEventList events;
+    events.push_back (reduce_event);
+    ret = _histogram_kernel->execute (_histogram_kernel, false, events, event);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "3a stats histogram kernel execute failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 SmartPtr<CLBuffer>
 CL3AStatsCalculatorContext::get_buffer ()
 {
@@ -185,36 +440,24 @@ void debug_print_histogram (XCam3AStats *stats_ptr)
     printf ("\n");
 }
 
-SmartPtr<X3aStats>
-CL3AStatsCalculatorContext::copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_buf)
+bool
+CL3AStatsCalculatorContext::copy_cell_stats (const SmartPtr<CLBuffer> &stats_cl_buf, XCam3AStats *stats_ptr)
 {
-    SmartPtr<VideoBuffer> buffer;
-    SmartPtr<X3aStats> stats;
     SmartPtr<CLEvent>  event = new CLEvent;
-    XCam3AStats *stats_ptr = NULL;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     void *buf_ptr = NULL;
     const CL3AStatsStruct *cl_buf_ptr = NULL;
 
-    XCAM_ASSERT (stats_cl_buf.ptr ());
-
-    buffer = _stats_pool->get_buffer (_stats_pool);
-    XCAM_FAIL_RETURN (WARNING, buffer.ptr (), NULL, "3a stats pool stopped.");
-
-    stats = buffer.dynamic_cast_ptr<X3aStats> ();
-    XCAM_ASSERT (stats.ptr ());
-    stats_ptr = stats->get_stats ();
-
     ret = stats_cl_buf->enqueue_map (
               buf_ptr,
               0, _stats_mem_size,
               CL_MAP_READ,
               CLEvent::EmptyList,
               event);
-    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, NULL, "3a stats enqueue read buffer failed.");
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, false, "3a stats enqueue read buffer failed.");
     XCAM_ASSERT (event->get_event_id ());
     ret = event->wait ();
-    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, NULL, "3a stats buffer enqueue event wait failed");
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, false, "3a stats buffer enqueue event wait failed");
 
     cl_buf_ptr = (const CL3AStatsStruct*)buf_ptr;
 
@@ -250,14 +493,62 @@ CL3AStatsCalculatorContext::copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_b
 
     SmartPtr<CLEvent>  unmap_event = new CLEvent;
     ret = stats_cl_buf->enqueue_unmap (buf_ptr, CLEvent::EmptyList, unmap_event);
-    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, NULL, "3a stats buffer enqueue unmap failed");
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, false, "3a stats buffer enqueue unmap failed");
     ret = unmap_event->wait ();
-    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, NULL, "3a stats buffer enqueue unmap event wait failed");
+    XCAM_FAIL_RETURN (WARNING, ret == XCAM_RETURN_NO_ERROR, false, "3a stats buffer enqueue unmap event wait failed");
     unmap_event.release ();
     //debug_print_3a_stats (stats_ptr);
     fill_histogram (stats_ptr);
     //debug_print_histogram (stats_ptr);
 
+    return true;
+}
+
+SmartPtr<X3aStats>
+CL3AStatsCalculatorContext::copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_buf)
+{
+    SmartPtr<VideoBuffer> buffer;
+    SmartPtr<X3aStats> stats;
+    XCam3AStats *stats_ptr = NULL;
+
+    XCAM_ASSERT (stats_cl_buf.ptr ());
+
+    buffer = _stats_pool->get_buffer (_stats_pool);
+    XCAM_FAIL_RETURN (WARNING, buffer.ptr (), NULL, "3a stats pool stopped.");
+
+    stats = buffer.dynamic_cast_ptr<X3aStats> ();
+    XCAM_ASSERT (stats.ptr ());
+
+    if (_gpu_ready) {
+        SmartPtr<CL3AStats> cl_stats = buffer.dynamic_cast_ptr<CL3AStats> ();
+        XCAM_ASSERT (cl_stats.ptr ());
+        SmartPtr<CL3AStatsData> data = cl_stats->get_cl_stats_data ();
+        XCAM_FAIL_RETURN (WARNING, data.ptr (), NULL, "3a stats get cl stats data failed");
+
+        XCAM_FAIL_RETURN (
+            WARNING, data->unmap_stats () == XCAM_RETURN_NO_ERROR, NULL,
+            "3a stats unmap reused cl stats failed");
+
+        SmartPtr<CLEvent> reduce_event = new CLEvent;
+        XCAM_FAIL_RETURN (
+            WARNING, reduce_stats (stats_cl_buf, data->get_cl_buffer (), reduce_event) == XCAM_RETURN_NO_ERROR,
+            NULL, "3a stats gpu reduction failed");
+
+        // map waits on reduction only, not on the whole queue
+        CLEventList events;
+        events.push_back (reduce_event);
+        XCAM_FAIL_RETURN (
+            WARNING, data->map_stats (events) == XCAM_RETURN_NO_ERROR, NULL,
+            "3a stats map reduced cl stats failed");
+
+        return stats;
+    }
+
+    stats_ptr = stats->get_stats ();
+    XCAM_ASSERT (stats_ptr);
+    if (!copy_cell_stats (stats_cl_buf, stats_ptr))
+        return NULL;
+
     return stats;
 }
 
@@ -25,6 +25,7 @@
 #include <x3a_stats_pool.h>
 #include <ocl/cl_memory.h>
 #include <ocl/cl_context.h>
+#include <ocl/cl_kernel.h>
 
 #define XCAM_CL_3A_STATS_BUFFER_COUNT 6
 
@@ -60,10 +61,22 @@ public:
     bool release_buffer (SmartPtr<CLBuffer> &buf);
     SmartPtr<X3aStats> copy_stats_out (const SmartPtr<CLBuffer> &stats_cl_buf);
 
+    /*
+     * grids and histograms are reduced by kernels into mapped stats buffers, which are
+     * handed to analyzer without copy. default enabled, set before allocate_data.
+     */
+    void enable_gpu_reduce (bool enable) {
+        _gpu_reduce = enable;
+    }
+
 private:
     XCAM_DEAD_COPY (CL3AStatsCalculatorContext);
 
     bool fill_histogram (XCam3AStats *stats);
+    bool init_gpu_reduce ();
+    XCamReturn reduce_stats (
+        const SmartPtr<CLBuffer> &stats_cl_buf, const SmartPtr<CLBuffer> &out_buf, SmartPtr<CLEvent> &event);
+    bool copy_cell_stats (const SmartPtr<CLBuffer> &stats_cl_buf, XCam3AStats *stats);
 
 private:
     SmartPtr<CLContext>              _context;
@@ -75,6 +88,12 @@ private:
     uint32_t                         _factor_shift;
     XCam3AStatsInfo                  _stats_info;
     bool                             _data_allocated;
+
+    uint32_t                         _bit_depth;
+    bool                             _gpu_reduce;
+    bool                             _gpu_ready;
+    SmartPtr<CLKernel>               _reduce_kernel;
+    SmartPtr<CLKernel>               _histogram_kernel;
 };
 
 }
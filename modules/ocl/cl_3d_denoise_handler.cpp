@@ -19,29 +19,18 @@
  */
 
 #include "cl_utils.h"
+#include "cl_device.h"
 #include "cl_3d_denoise_handler.h"
 
 namespace XCam {
 
-#define CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT  3
 #define CL_3D_DENOISE_REFERENCE_FRAME_COUNT      3
 #define CL_3D_DENOISE_WG_WIDTH   4
 #define CL_3D_DENOISE_WG_HEIGHT  16
 
-#define CL_3D_DENOISE_ENABLE_SUBGROUP 1
 #define CL_3D_DENOISE_IIR_FILTERING   1
 
-#if CL_3D_DENOISE_ENABLE_SUBGROUP
-#define KERNEL_3D_DENOISE_NAME "kernel_3d_denoise"
-#else
-#define KERNEL_3D_DENOISE_NAME "kernel_3d_denoise_slm"
-#endif
-
-enum {
-    Kernel3DDenoise,
-    Kernel3DDenoiseSLM,
-};
-
+// indexed by CL3DDenoiseVariant
 const XCamKernelInfo kernel_3d_denoise_info[] = {
     {
         "kernel_3d_denoise",
@@ -60,12 +49,52 @@ CL3DDenoiseImageKernel::CL3DDenoiseImageKernel (
     const SmartPtr<CLContext> &context,
     const char *name,
     uint32_t channel,
+    bool slm,
     SmartPtr<CL3DDenoiseImageHandler> &handler)
     : CLImageKernel (context, name)
     , _channel (channel)
+    , _slm (slm)
     , _ref_count (CL_3D_DENOISE_REFERENCE_FRAME_COUNT)
     , _handler (handler)
+    , _ref_filled (0)
+    , _ref_head (0)
+    , _gain (0.0f)
+    , _threshold (0.0f)
+{
+    // UV plane has half height
+    uint32_t rows = (channel == CL_IMAGE_CHANNEL_UV) ? 2 : 1;
+    if (!slm)
+        set_roi_block (8, rows);
+    else
+        set_roi_block (4, 8 * rows);
+}
+
+void
+CL3DDenoiseImageKernel::reset_references ()
 {
+    _ref_filled = 0;
+    _out_prev_arg.release ();
+}
+
+void
+CL3DDenoiseImageKernel::push_reference (const SmartPtr<CLImage> &image)
+{
+    SmartPtr<CLArgument> arg = new CLMemArgument (image);
+
+    // first frame or count changed, all references start from this frame
+    if (_ref_filled != _ref_count) {
+        for (uint8_t i = 0; i < _ref_count; ++i)
+            _ref_args[i] = arg;
+        for (uint8_t i = _ref_count; i < CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT; ++i)
+            _ref_args[i].release ();
+        _ref_filled = _ref_count;
+        _ref_head = 0;
+        return;
+    }
+
+    // overwrite the oldest one
+    _ref_head = (_ref_head + 1) % _ref_count;
+    _ref_args[_ref_head] = arg;
 }
 
 XCamReturn
@@ -89,28 +118,28 @@ CL3DDenoiseImageKernel::prepare_arguments (
 
     CLImageDesc cl_desc_in, cl_desc_out;
     cl_desc_in.format.image_channel_order = CL_RGBA;
-#if CL_3D_DENOISE_ENABLE_SUBGROUP
-    cl_desc_in.format.image_channel_data_type = CL_UNSIGNED_INT16;
-    cl_desc_in.width = XCAM_ALIGN_UP (video_info_in.width, 8) / 8;
-#else
-    cl_desc_in.format.image_channel_data_type = CL_UNORM_INT8;
-    cl_desc_in.width = XCAM_ALIGN_UP (video_info_in.width, 4) / 4;
-#endif
+    if (!_slm) {
+        cl_desc_in.format.image_channel_data_type = CL_UNSIGNED_INT16;
+        cl_desc_in.width = XCAM_ALIGN_UP (video_info_in.width, 8) / 8;
+    } else {
+        cl_desc_in.format.image_channel_data_type = CL_UNORM_INT8;
+        cl_desc_in.width = XCAM_ALIGN_UP (video_info_in.width, 4) / 4;
+    }
     cl_desc_in.height = video_info_in.height >> info_index;
     cl_desc_in.row_pitch = video_info_in.strides[info_index];
 
     cl_desc_out.format.image_channel_order = CL_RGBA;
-#if CL_3D_DENOISE_ENABLE_SUBGROUP
-    cl_desc_out.format.image_channel_data_type = CL_UNSIGNED_INT16;
-    cl_desc_out.width = XCAM_ALIGN_UP (video_info_out.width, 8) / 8;
-#else
-    cl_desc_out.format.image_channel_data_type = CL_UNORM_INT8;
-    cl_desc_out.width = XCAM_ALIGN_UP (video_info_out.width, 4) / 4;
-#endif
+    if (!_slm) {
+        cl_desc_out.format.image_channel_data_type = CL_UNSIGNED_INT16;
+        cl_desc_out.width = XCAM_ALIGN_UP (video_info_out.width, 8) / 8;
+    } else {
+        cl_desc_out.format.image_channel_data_type = CL_UNORM_INT8;
+        cl_desc_out.width = XCAM_ALIGN_UP (video_info_out.width, 4) / 4;
+    }
     cl_desc_out.height = video_info_out.height >> info_index;
     cl_desc_out.row_pitch = video_info_out.strides[info_index];
 
-    _ref_count = _handler->get_ref_framecount ();
+    _ref_count = XCAM_CLAMP (_handler->get_ref_framecount (), 1, CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT);
     float gain = 5.0f / (_handler->get_denoise_config ().gain + 0.0001f);
     float threshold = 2.0f * _handler->get_denoise_config ().threshold[info_index];
 
@@ -123,50 +152,53 @@ CL3DDenoiseImageKernel::prepare_arguments (
         XCAM_RETURN_ERROR_MEM,
         "cl image kernel(%s) in/out memory not available", get_kernel_name ());
 
-    if (_image_in_list.size () < _ref_count) {
-        while (_image_in_list.size () < _ref_count) {
-            _image_in_list.push_back (image_in);
-        }
-    } else {
-        _image_in_list.pop_back ();
-        _image_in_list.push_front (image_in);
+    push_reference (image_in);
+    const SmartPtr<CLArgument> &in_arg = _ref_args[_ref_head];
+    if (!_out_prev_arg.ptr ()) {
+        _out_prev_arg = in_arg;
     }
 
-    if (!_image_out_prev.ptr ()) {
-        _image_out_prev = image_in;
+    if (!_gain_arg.ptr () || gain != _gain) {
+        _gain = gain;
+        _gain_arg = new CLArgumentT<float> (gain);
     }
+    if (!_threshold_arg.ptr () || threshold != _threshold) {
+        _threshold = threshold;
+        _threshold_arg = new CLArgumentT<float> (threshold);
+    }
+    SmartPtr<CLArgument> out_arg = new CLMemArgument (image_out);
 
     //set args;
-    args.push_back (new CLArgumentT<float> (gain));
-    args.push_back (new CLArgumentT<float> (threshold));
-    args.push_back (new CLMemArgument (_image_out_prev));
-    args.push_back (new CLMemArgument (image_out));
-
-    uint8_t image_list_count = _image_in_list.size ();
-    for (std::list<SmartPtr<CLImage>>::iterator it = _image_in_list.begin (); it != _image_in_list.end (); it++) {
-        args.push_back (new CLMemArgument (*it));
+    args.push_back (_gain_arg);
+    args.push_back (_threshold_arg);
+    args.push_back (_out_prev_arg);
+    args.push_back (out_arg);
+
+    // newest reference first
+    for (uint8_t i = 0; i < _ref_count; ++i) {
+        args.push_back (_ref_args[(_ref_head + _ref_count - i) % _ref_count]);
     }
 
     //backup enough buffers for kernel
-    for (; image_list_count < CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT; ++image_list_count) {
-        args.push_back (new CLMemArgument (image_in));
+    for (uint8_t i = _ref_count; i < CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT; ++i) {
+        args.push_back (in_arg);
     }
 
     //set worksize
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
-#if CL_3D_DENOISE_ENABLE_SUBGROUP
-    work_size.local[0] = CL_3D_DENOISE_WG_WIDTH;
-    work_size.local[1] = CL_3D_DENOISE_WG_HEIGHT;
-    work_size.global[0] = XCAM_ALIGN_UP (cl_desc_in.width, work_size.local[0]);
-    work_size.global[1] = (cl_desc_in.height +  work_size.local[1] - 1) / work_size.local[1] * work_size.local[1];
-#else
-    work_size.local[0] = 8;
-    work_size.local[1] = 1;
-    work_size.global[0] = XCAM_ALIGN_UP (cl_desc_in.width, work_size.local[0]);
-    work_size.global[1] = XCAM_ALIGN_UP(cl_desc_in.height / 8, 8 * work_size.local[1]);
-#endif
-
-    _image_out_prev = image_out;
+    if (!_slm) {
+        work_size.local[0] = CL_3D_DENOISE_WG_WIDTH;
+        work_size.local[1] = CL_3D_DENOISE_WG_HEIGHT;
+        work_size.global[0] = XCAM_ALIGN_UP (cl_desc_in.width, work_size.local[0]);
+        work_size.global[1] = (cl_desc_in.height +  work_size.local[1] - 1) / work_size.local[1] * work_size.local[1];
+    } else {
+        work_size.local[0] = 8;
+        work_size.local[1] = 1;
+        work_size.global[0] = XCAM_ALIGN_UP (cl_desc_in.width, work_size.local[0]);
+        work_size.global[1] = XCAM_ALIGN_UP(cl_desc_in.height / 8, 8 * work_size.local[1]);
+    }
+
+    _out_prev_arg = out_arg;
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -174,6 +206,8 @@ CL3DDenoiseImageKernel::prepare_arguments (
 CL3DDenoiseImageHandler::CL3DDenoiseImageHandler (const SmartPtr<CLContext> &context, const char *name)
     : CLImageHandler (context, name)
     , _ref_count (CL_3D_DENOISE_REFERENCE_FRAME_COUNT - 2)
+    , _variants ("3d_denoise")
+    , _variant (CL3DDenoiseVariantCount)
 {
     _config.gain = 1.0f;
     _config.threshold[0] = 0.05f;
@@ -196,18 +230,66 @@ CL3DDenoiseImageHandler::set_denoise_config (const XCam3aResultTemporalNoiseRedu
     return true;
 }
 
+bool
+CL3DDenoiseImageHandler::add_variant_kernel (uint32_t variant, const SmartPtr<CL3DDenoiseImageKernel> &kernel)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, variant < CL3DDenoiseVariantCount && kernel.ptr (), false,
+        "3d denoise handler add variant(%d) kernel failed", variant);
+
+    if (_variant_kernels[variant].empty ())
+        _variants.add_variant (kernel_3d_denoise_info[variant].kernel_name);
+    _variant_kernels[variant].push_back (kernel);
+    return add_kernel (kernel);
+}
+
 XCamReturn
 CL3DDenoiseImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     _input_buf = input;
     _output_buf = output;
+
+    const VideoBufferInfo &info = input->get_video_info ();
+    uint32_t index = _variants.begin_frame (get_context (), get_cmd_queue (), info.width, info.height);
+
+    // variants were added in CL3DDenoiseVariant order, skipping unsupported ones
+    uint32_t variant = CL3DDenoiseVariantCount;
+    for (uint32_t i = 0; i < CL3DDenoiseVariantCount; ++i) {
+        if (_variant_kernels[i].empty ())
+            continue;
+        if (!index--) {
+            variant = i;
+            break;
+        }
+    }
+    XCAM_ASSERT (variant < CL3DDenoiseVariantCount);
+
+    if (variant != _variant) {
+        for (uint32_t i = 0; i < CL3DDenoiseVariantCount; ++i) {
+            for (uint32_t k = 0; k < _variant_kernels[i].size (); ++k) {
+                _variant_kernels[i][k]->set_enable (i == variant);
+                if (i == variant)
+                    _variant_kernels[i][k]->reset_references ();
+            }
+        }
+        _variant = variant;
+    }
+
     return XCAM_RETURN_NO_ERROR;
 }
 
-static SmartPtr<CLImageKernel>
+XCamReturn
+CL3DDenoiseImageHandler::execute_done (SmartPtr<VideoBuffer> &output)
+{
+    XCAM_UNUSED (output);
+    _variants.end_frame (true);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static SmartPtr<CL3DDenoiseImageKernel>
 create_3d_denoise_kernel (
     const SmartPtr<CLContext> &context, SmartPtr<CL3DDenoiseImageHandler> handler,
-    uint32_t channel, uint8_t ref_count)
+    uint32_t channel, uint8_t ref_count, uint32_t variant)
 {
     char build_options[1024];
     xcam_mem_clear (build_options);
@@ -222,18 +304,13 @@ create_3d_denoise_kernel (
               CL_3D_DENOISE_WG_HEIGHT,
               CL_3D_DENOISE_IIR_FILTERING);
 
-#if CL_3D_DENOISE_ENABLE_SUBGROUP
-    int kernel_index = Kernel3DDenoise;
-#else
-    int kernel_index = Kernel3DDenoiseSLM;
-#endif
-
-    SmartPtr<CLImageKernel> kernel =
-        new CL3DDenoiseImageKernel (context, KERNEL_3D_DENOISE_NAME, channel, handler);
+    const XCamKernelInfo &info = kernel_3d_denoise_info[variant];
+    SmartPtr<CL3DDenoiseImageKernel> kernel =
+        new CL3DDenoiseImageKernel (context, info.kernel_name, channel, variant == CL3DDenoiseSLM, handler);
     XCAM_ASSERT (kernel.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, kernel->build_kernel (kernel_3d_denoise_info[kernel_index], build_options) == XCAM_RETURN_NO_ERROR,
-        NULL, "build 3d denoise kernel failed");
+        ERROR, kernel->build_kernel (info, build_options) == XCAM_RETURN_NO_ERROR,
+        NULL, "build 3d denoise kernel(%s) failed", info.kernel_name);
     return kernel;
 }
 
@@ -242,27 +319,39 @@ create_cl_3d_denoise_image_handler (
     const SmartPtr<CLContext> &context, uint32_t channel, uint8_t ref_count)
 {
     SmartPtr<CL3DDenoiseImageHandler> denoise_handler;
-    SmartPtr<CLImageKernel> denoise_kernel;
+    SmartPtr<CL3DDenoiseImageKernel> y_kernel, uv_kernel;
 
     denoise_handler = new CL3DDenoiseImageHandler (context, "cl_3d_denoise_handler");
     XCAM_ASSERT (denoise_handler.ptr ());
     denoise_handler->set_ref_framecount (ref_count);
 
-    if (channel & CL_IMAGE_CHANNEL_Y) {
-        denoise_kernel = create_3d_denoise_kernel (context, denoise_handler, CL_IMAGE_CHANNEL_Y, ref_count);
-        XCAM_FAIL_RETURN (
-            ERROR, denoise_kernel.ptr (), NULL, "3D denoise handler create Y channel kernel failed.");
+    // give the same output, the faster one on this device is chosen at first start
+    for (uint32_t variant = 0; variant < CL3DDenoiseVariantCount; ++variant) {
+        if (variant == CL3DDenoiseSubgroup && !CLDevice::instance ()->get_device_info ().subgroups_supported)
+            continue;
+
+        y_kernel.release ();
+        uv_kernel.release ();
+        if (channel & CL_IMAGE_CHANNEL_Y) {
+            y_kernel = create_3d_denoise_kernel (context, denoise_handler, CL_IMAGE_CHANNEL_Y, ref_count, variant);
+            if (!y_kernel.ptr ())
+                continue;
+        }
+        if (channel & CL_IMAGE_CHANNEL_UV) {
+            uv_kernel = create_3d_denoise_kernel (context, denoise_handler, CL_IMAGE_CHANNEL_UV, ref_count, variant);
+            if (!uv_kernel.ptr ())
+                continue;
+        }
 
-        denoise_handler->add_kernel (denoise_kernel);
+        if (y_kernel.ptr ())
+            denoise_handler->add_variant_kernel (variant, y_kernel);
+        if (uv_kernel.ptr ())
+            denoise_handler->add_variant_kernel (variant, uv_kernel);
     }
 
-    if (channel & CL_IMAGE_CHANNEL_UV) {
-        denoise_kernel = create_3d_denoise_kernel (context, denoise_handler, CL_IMAGE_CHANNEL_UV, ref_count);
-        XCAM_FAIL_RETURN (
-            ERROR, denoise_kernel.ptr (), NULL, "3D denoise handler create UV channel kernel failed.");
-
-        denoise_handler->add_kernel (denoise_kernel);
-    }
+    XCAM_FAIL_RETURN (
+        ERROR, denoise_handler->get_variant_count (), NULL,
+        "3D denoise handler create kernels failed.");
 
     return denoise_handler;
 }
@@ -25,42 +25,63 @@
 #include <base/xcam_3a_result.h>
 #include <x3a_stats_pool.h>
 #include <ocl/cl_image_handler.h>
+#include <ocl/cl_kernel_variants.h>
+
+#define CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT  3
 
 namespace XCam {
 
 class CL3DDenoiseImageHandler;
 
+enum CL3DDenoiseVariant {
+    CL3DDenoiseSubgroup = 0,
+    CL3DDenoiseSLM,
+    CL3DDenoiseVariantCount,
+};
+
+/*
+ * reference frames are kept in a ring, each frame overwrites the oldest slot.
+ * arguments of unchanged images and values are reused, only new input and output get new ones.
+ */
 class CL3DDenoiseImageKernel
     : public CLImageKernel
 {
-    typedef std::list<SmartPtr<CLImage>> CLImagePtrList;
-
-private:
-
 public:
     explicit CL3DDenoiseImageKernel (
         const SmartPtr<CLContext> &context,
         const char *name,
         uint32_t channel,
+        bool slm,
         SmartPtr<CL3DDenoiseImageHandler> &handler);
 
-    virtual ~CL3DDenoiseImageKernel () {
-        _image_in_list.clear ();
-    }
+    virtual ~CL3DDenoiseImageKernel () {}
+
+    // references of frames this kernel skipped are dropped
+    void reset_references ();
 
 protected:
     virtual XCamReturn prepare_arguments (
         CLArgList &args, CLWorkSize &work_size);
 
 private:
+    void push_reference (const SmartPtr<CLImage> &image);
+
     XCAM_DEAD_COPY (CL3DDenoiseImageKernel);
 
     uint32_t                           _channel;
+    bool                               _slm;
     uint8_t                            _ref_count;
     SmartPtr<CL3DDenoiseImageHandler>  _handler;
 
-    CLImagePtrList                     _image_in_list;
-    SmartPtr<CLImage>                  _image_out_prev;
+    SmartPtr<CLArgument>               _ref_args[CL_3D_DENOISE_MAX_REFERENCE_FRAME_COUNT];
+    uint8_t                            _ref_filled;
+    uint8_t                            _ref_head;
+    SmartPtr<CLArgument>               _out_prev_arg;
+
+    float                              _gain;
+    float                              _threshold;
+    SmartPtr<CLArgument>               _gain_arg;
+    SmartPtr<CLArgument>               _threshold_arg;
 };
 
 class CL3DDenoiseImageHandler
@@ -86,8 +107,15 @@ public:
         return _output_buf;
     }
 
+    // kernel of Y or UV channel of @variant in CL3DDenoiseVariant
+    bool add_variant_kernel (uint32_t variant, const SmartPtr<CL3DDenoiseImageKernel> &kernel);
+    uint32_t get_variant_count () const {
+        return _variants.get_variant_count ();
+    }
+
 protected:
     virtual XCamReturn prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual XCamReturn execute_done (SmartPtr<VideoBuffer> &output);
 
 private:
     XCAM_DEAD_COPY (CL3DDenoiseImageHandler);
@@ -97,6 +125,10 @@ private:
     XCam3aResultTemporalNoiseReduction  _config;
     SmartPtr<VideoBuffer>               _input_buf;
     SmartPtr<VideoBuffer>               _output_buf;
+
+    CLKernelVariants                    _variants;
+    std::vector<SmartPtr<CL3DDenoiseImageKernel> > _variant_kernels[CL3DDenoiseVariantCount];
+    uint32_t                            _variant;
 };
 
 SmartPtr<CLImageHandler>
@@ -28,6 +28,7 @@ CLWorkSize::CLWorkSize ()
 {
     xcam_mem_clear (global);
     xcam_mem_clear (local);
+    xcam_mem_clear (offset);
 }
 
 CLArgument::CLArgument (uint32_t size)
@@ -34,6 +34,8 @@ struct CLWorkSize
     uint32_t dim;
     size_t global[XCAM_CL_KERNEL_MAX_WORK_DIM];
     size_t local[XCAM_CL_KERNEL_MAX_WORK_DIM];
+    // global id offset, all zero launches from origin
+    size_t offset[XCAM_CL_KERNEL_MAX_WORK_DIM];
     CLWorkSize();
 };
 
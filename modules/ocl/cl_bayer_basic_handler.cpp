@@ -34,6 +34,27 @@
 
 namespace XCam {
 
+// MIPI packed bayer is unpacked in kernel, 0 for 16-bit input
+static uint32_t
+get_packed_bits (uint32_t format)
+{
+    switch (format) {
+    case V4L2_PIX_FMT_SBGGR10P:
+    case V4L2_PIX_FMT_SGBRG10P:
+    case V4L2_PIX_FMT_SGRBG10P:
+    case V4L2_PIX_FMT_SRGGB10P:
+        return 10;
+    case V4L2_PIX_FMT_SBGGR12P:
+    case V4L2_PIX_FMT_SGBRG12P:
+    case V4L2_PIX_FMT_SGRBG12P:
+    case V4L2_PIX_FMT_SRGGB12P:
+        return 12;
+    default:
+        break;
+    }
+    return 0;
+}
+
 static const XCamKernelInfo kernel_bayer_basic_info = {
     "kernel_bayer_basic",
 #include "kernel_bayer_basic.clx"
@@ -320,12 +341,17 @@ CLBayerBasicImageHandler::prepare_parameters (
     out_image_info.height = out_video_info.aligned_height * 4;
     out_image_info.row_pitch = out_video_info.strides[0];
 
+    uint32_t packed_bits = get_packed_bits (in_video_info.format);
 #if ENABLE_IMAGE_2D_INPUT
+    XCAM_FAIL_RETURN (
+        WARNING, !packed_bits, XCAM_RETURN_ERROR_PARAM,
+        "cl image handler(%s) packed input(%s) needs buffer input",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_video_info.format));
     SmartPtr<CLImage> image_in = convert_to_climage (context, input, in_image_info);
 #else
     SmartPtr<CLBuffer> buffer_in = convert_to_clbuffer (context, input);
 #endif
-    uint32_t input_aligned_width = in_video_info.strides[0] / (2 * 8); // ushort8
+    uint32_t input_pitch = in_video_info.strides[0];
     SmartPtr<CLImage> image_out = convert_to_climage (context, output, out_image_info);
 
     uint32_t out_aligned_height = out_video_info.aligned_height;
@@ -354,7 +380,8 @@ CLBayerBasicImageHandler::prepare_parameters (
 #else
     args.push_back (new CLMemArgument (buffer_in));
 #endif
-    args.push_back (new CLArgumentT<uint32_t> (input_aligned_width));
+    args.push_back (new CLArgumentT<uint32_t> (input_pitch));
+    args.push_back (new CLArgumentT<uint32_t> (packed_bits));
     args.push_back (new CLMemArgument (image_out));
     args.push_back (new CLArgumentT<uint32_t> (out_aligned_height));
     args.push_back (new CLArgumentT<CLBLCConfig> (_blc_config));
@@ -0,0 +1,198 @@
+/*
+ * cl_bayer_fused_handler.cpp - CL fused bayer to NV12 handler
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_utils.h"
+#include "cl_bayer_fused_handler.h"
+
+// same tiling as bayer pipe, a work item gives 4x2 pixels
+#define WORKGROUP_PIXEL_WIDTH 128
+#define WORKGROUP_PIXEL_HEIGHT 8
+
+#define FUSED_LOCAL_X_SIZE 64
+#define FUSED_LOCAL_Y_SIZE 2
+
+namespace XCam {
+
+static const XCamKernelInfo kernel_bayer_fused_info = {
+    "kernel_bayer_fused",
+#include "kernel_bayer_fused.clx"
+    , 0,
+};
+
+static const float fused_default_matrix[XCAM_COLOR_MATRIX_SIZE] = {
+    0.299f, 0.587f, 0.114f,
+    -0.14713f, -0.28886f, 0.436f,
+    0.615f, -0.51499f, -0.10001f,
+};
+
+CLBayerFusedImageKernel::CLBayerFusedImageKernel (const SmartPtr<CLContext> &context)
+    : CLImageKernel (context, "kernel_bayer_fused")
+{
+}
+
+CLBayerFusedImageHandler::CLBayerFusedImageHandler (const SmartPtr<CLContext> &context, const char *name)
+    : CLImageHandler (context, name)
+{
+    // identity macc on every axis
+    for (int i = 0; i < XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE; i++)
+        _macc_table[i] = (i % 4 == 0 || i % 4 == 3) ? 1.0f : 0.0f;
+    memcpy (_rgbtoyuv_matrix, fused_default_matrix, sizeof (float) * XCAM_COLOR_MATRIX_SIZE);
+}
+
+bool
+CLBayerFusedImageHandler::set_fused_kernel (SmartPtr<CLBayerFusedImageKernel> &kernel)
+{
+    SmartPtr<CLImageKernel> image_kernel = kernel;
+    add_kernel (image_kernel);
+    _fused_kernel = kernel;
+    return true;
+}
+
+bool
+CLBayerFusedImageHandler::set_macc_table (const XCam3aResultMaccMatrix &macc)
+{
+    for (int i = 0; i < XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE; i++)
+        _macc_table[i] = (float)macc.table[i];
+    return true;
+}
+
+bool
+CLBayerFusedImageHandler::set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix)
+{
+    for (int i = 0; i < XCAM_COLOR_MATRIX_SIZE; i++)
+        _rgbtoyuv_matrix[i] = (float)matrix.matrix[i];
+    return true;
+}
+
+XCamReturn
+CLBayerFusedImageHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    XCAM_FAIL_RETURN (
+        WARNING,
+        input.format == XCAM_PIX_FMT_SGRBG16_planar,
+        XCAM_RETURN_ERROR_PARAM,
+        "CL image handler(%s) input format(%s) unsupported, need GRBG planes",
+        get_name (), xcam_fourcc_to_string (input.format));
+
+    bool format_inited = output.init (V4L2_PIX_FMT_NV12, input.width * 2, input.height * 2);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        format_inited,
+        XCAM_RETURN_ERROR_PARAM,
+        "CL image handler(%s) output format(NV12) unsupported", get_name ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLBayerFusedImageHandler::prepare_parameters (
+    SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    SmartPtr<CLContext> context = get_context ();
+    const VideoBufferInfo & in_video_info = input->get_video_info ();
+    const VideoBufferInfo & out_video_info = output->get_video_info ();
+    CLArgList args;
+    CLWorkSize work_size;
+
+    XCAM_ASSERT (_fused_kernel.ptr ());
+
+    CLImageDesc in_desc;
+    in_desc.format.image_channel_order = CL_RGBA;
+    in_desc.format.image_channel_data_type = CL_UNORM_INT16;
+    in_desc.width = in_video_info.width / 4;
+    in_desc.height = in_video_info.aligned_height * 4;
+    in_desc.row_pitch = in_video_info.strides[0];
+    SmartPtr<CLImage> image_in = convert_to_climage (context, input, in_desc);
+
+    CLImageDesc out_desc;
+    out_desc.format.image_channel_order = CL_RGBA;
+    out_desc.format.image_channel_data_type = CL_UNSIGNED_INT8;
+    out_desc.width = out_video_info.aligned_width / 4;
+    out_desc.height = out_video_info.aligned_height;
+    out_desc.row_pitch = out_video_info.strides[0];
+    SmartPtr<CLImage> image_out_y = convert_to_climage (context, output, out_desc, out_video_info.offsets[0]);
+
+    out_desc.height = out_video_info.aligned_height / 2;
+    out_desc.row_pitch = out_video_info.strides[1];
+    SmartPtr<CLImage> image_out_uv = convert_to_climage (context, output, out_desc, out_video_info.offsets[1]);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        image_in.ptr () && image_in->is_valid () &&
+        image_out_y.ptr () && image_out_y->is_valid () &&
+        image_out_uv.ptr () && image_out_uv->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", _fused_kernel->get_kernel_name ());
+
+    SmartPtr<CLBuffer> matrix_buffer = new CLBuffer (
+        context, sizeof (float) * XCAM_COLOR_MATRIX_SIZE,
+        CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, &_rgbtoyuv_matrix);
+    SmartPtr<CLBuffer> macc_table_buffer = new CLBuffer (
+        context, sizeof (float) * XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE,
+        CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, &_macc_table);
+
+    uint input_height = in_video_info.aligned_height;
+
+    //set args;
+    args.push_back (new CLMemArgument (image_in));
+    args.push_back (new CLArgumentT<uint> (input_height));
+    args.push_back (new CLMemArgument (image_out_y));
+    args.push_back (new CLMemArgument (image_out_uv));
+    args.push_back (new CLMemArgument (matrix_buffer));
+    args.push_back (new CLMemArgument (macc_table_buffer));
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = FUSED_LOCAL_X_SIZE;
+    work_size.local[1] = FUSED_LOCAL_Y_SIZE;
+    work_size.global[0] = (XCAM_ALIGN_UP (out_video_info.width, WORKGROUP_PIXEL_WIDTH) / WORKGROUP_PIXEL_WIDTH) *
+                          work_size.local[0];
+    work_size.global[1] = (XCAM_ALIGN_UP (out_video_info.height, WORKGROUP_PIXEL_HEIGHT) / WORKGROUP_PIXEL_HEIGHT) *
+                          work_size.local[1];
+
+    XCamReturn ret = _fused_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "bayer fused kernel set arguments failed.");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<CLImageHandler>
+create_cl_bayer_fused_image_handler (const SmartPtr<CLContext> &context)
+{
+    SmartPtr<CLBayerFusedImageHandler> fused_handler;
+    SmartPtr<CLBayerFusedImageKernel> fused_kernel;
+
+    fused_kernel = new CLBayerFusedImageKernel (context);
+    XCAM_ASSERT (fused_kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, fused_kernel->build_kernel (kernel_bayer_fused_info, NULL) == XCAM_RETURN_NO_ERROR, NULL,
+        "build bayer-fused kernel(%s) failed", kernel_bayer_fused_info.kernel_name);
+
+    XCAM_ASSERT (fused_kernel->is_valid ());
+    fused_handler = new CLBayerFusedImageHandler (context, "cl_handler_bayer_fused");
+    fused_handler->set_fused_kernel (fused_kernel);
+
+    return fused_handler;
+}
+
+};
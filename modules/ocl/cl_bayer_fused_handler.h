@@ -0,0 +1,71 @@
+/*
+ * cl_bayer_fused_handler.h - CL fused bayer to NV12 handler
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CL_BAYER_FUSED_HANDLER_H
+#define XCAM_CL_BAYER_FUSED_HANDLER_H
+
+#include <xcam_std.h>
+#include <ocl/cl_image_handler.h>
+#include <base/xcam_3a_result.h>
+
+namespace XCam {
+
+class CLBayerFusedImageKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLBayerFusedImageKernel (const SmartPtr<CLContext> &context);
+};
+
+/*
+ * CLBayerFusedImageHandler, demosaic, rgb to yuv and macc of bayer pipe and
+ * yuv pipe in one tile kernel; GRBG planes of bayer basic go in, NV12 comes
+ * out, no RGB48 image in between. neither denoise nor TNR-YUV is supported.
+ */
+class CLBayerFusedImageHandler
+    : public CLImageHandler
+{
+public:
+    explicit CLBayerFusedImageHandler (const SmartPtr<CLContext> &context, const char *name);
+    bool set_fused_kernel (SmartPtr<CLBayerFusedImageKernel> &kernel);
+    bool set_macc_table (const XCam3aResultMaccMatrix &macc);
+    bool set_rgbtoyuv_matrix (const XCam3aResultColorMatrix &matrix);
+
+protected:
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input, VideoBufferInfo &output);
+    virtual XCamReturn prepare_parameters (
+        SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+
+private:
+    XCAM_DEAD_COPY (CLBayerFusedImageHandler);
+
+private:
+    SmartPtr<CLBayerFusedImageKernel>  _fused_kernel;
+    float                              _macc_table[XCAM_CHROMA_AXIS_SIZE * XCAM_CHROMA_MATRIX_SIZE];
+    float                              _rgbtoyuv_matrix[XCAM_COLOR_MATRIX_SIZE];
+};
+
+SmartPtr<CLImageHandler>
+create_cl_bayer_fused_image_handler (const SmartPtr<CLContext> &context);
+
+};
+
+#endif //XCAM_CL_BAYER_FUSED_HANDLER_H
@@ -22,6 +22,7 @@
 #include "cl_context.h"
 #include "cl_kernel.h"
 #include "cl_device.h"
+#include "cl_kernel_profiler.h"
 #include <utility>
 
 #undef XCAM_CL_MAX_EVENT_SIZE
@@ -110,15 +111,16 @@ void
 CLContext::terminate ()
 {
     //_kernel_map.clear ();
+    SmartLock locker (_cmd_queue_mutex);
     _cmd_queue_list.clear ();
 }
 
 XCamReturn
-CLContext::flush ()
+CLContext::flush (SmartPtr<CLCommandQueue> queue)
 {
     cl_int error_code = CL_SUCCESS;
     cl_command_queue cmd_queue_id = NULL;
-    SmartPtr<CLCommandQueue> cmd_queue = get_default_cmd_queue ();
+    SmartPtr<CLCommandQueue> cmd_queue = queue.ptr () ? queue : get_default_cmd_queue ();
 
     XCAM_ASSERT (cmd_queue.ptr ());
     cmd_queue_id = cmd_queue->get_cmd_queue_id ();
@@ -135,11 +137,11 @@ CLContext::flush ()
 
 
 XCamReturn
-CLContext::finish ()
+CLContext::finish (SmartPtr<CLCommandQueue> queue)
 {
     cl_int error_code = CL_SUCCESS;
     cl_command_queue cmd_queue_id = NULL;
-    SmartPtr<CLCommandQueue> cmd_queue = get_default_cmd_queue ();
+    SmartPtr<CLCommandQueue> cmd_queue = queue.ptr () ? queue : get_default_cmd_queue ();
 
     XCAM_ASSERT (cmd_queue.ptr ());
     cmd_queue_id = cmd_queue->get_cmd_queue_id ();
@@ -154,6 +156,42 @@ CLContext::finish ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+uint32_t
+CLContext::ensure_cmd_queues (SmartPtr<CLContext> &self, uint32_t count)
+{
+    XCAM_ASSERT (self.ptr() == this);
+    SmartLock locker (_cmd_queue_mutex);
+
+    while (_cmd_queue_list.size () < count) {
+        SmartPtr<CLCommandQueue> cmd_queue = create_cmd_queue (self, true);
+        if (!cmd_queue.ptr ())
+            break;
+        _cmd_queue_list.push_back (cmd_queue);
+    }
+
+    return _cmd_queue_list.size ();
+}
+
+uint32_t
+CLContext::get_cmd_queue_count ()
+{
+    SmartLock locker (_cmd_queue_mutex);
+    return _cmd_queue_list.size ();
+}
+
+SmartPtr<CLCommandQueue>
+CLContext::get_cmd_queue (uint32_t index)
+{
+    SmartLock locker (_cmd_queue_mutex);
+    if (_cmd_queue_list.empty ())
+        return NULL;
+
+    CLCmdQueueList::iterator iter = _cmd_queue_list.begin ();
+    for (index %= _cmd_queue_list.size (); index > 0; --index)
+        ++iter;
+    return *iter;
+}
+
 bool
 CLContext::init_context ()
 {
@@ -190,6 +228,7 @@ CLContext::init_cmd_queue (SmartPtr<CLContext> &self)
     if (!cmd_queue.ptr ())
         return false;
 
+    SmartLock locker (_cmd_queue_mutex);
     _cmd_queue_list.push_back (cmd_queue);
     return true;
 }
@@ -231,6 +270,7 @@ CLContext::execute_kernel (
     uint32_t num_of_events_wait = 0;
     uint32_t work_group_size = 1;
     const size_t *local_sizes = NULL;
+    const size_t *offsets = NULL;
     cl_kernel kernel_id = kernel->get_kernel_id ();
     CLWorkSize work_size = kernel->get_work_size ();
     SmartPtr<CLCommandQueue> cmd_queue = queue;
@@ -253,10 +293,15 @@ CLContext::execute_kernel (
     else
         local_sizes = NULL;
 
+    for (uint32_t i = 0; i < work_size.dim; ++i) {
+        if (work_size.offset[i])
+            offsets = work_size.offset;
+    }
+
     error_code =
         clEnqueueNDRangeKernel (
             cmd_queue_id, kernel_id,
-            work_size.dim, NULL, work_size.global, local_sizes,
+            work_size.dim, offsets, work_size.global, local_sizes,
             num_of_events_wait, (num_of_events_wait ? events_id_wait : NULL),
             event_out_id);
 
@@ -281,27 +326,73 @@ CLContext::set_event_callback (
     return (error_code == CL_SUCCESS ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_CL);
 }
 
+XCamReturn
+CLContext::enqueue_marker (
+    const SmartPtr<CLCommandQueue> &queue,
+    SmartPtr<CLEvent> &event_out)
+{
+    XCAM_ASSERT (event_out.ptr ());
+    SmartPtr<CLCommandQueue> cmd_queue = queue.ptr () ? queue : get_default_cmd_queue ();
+    XCAM_ASSERT (cmd_queue.ptr ());
+
+#if defined (CL_VERSION_1_2) && (CL_VERSION_1_2 == 1)
+    cl_int error_code = clEnqueueMarkerWithWaitList (
+        cmd_queue->get_cmd_queue_id (), 0, NULL, &event_out->get_event_id ());
+#else
+    cl_int error_code = clEnqueueMarker (cmd_queue->get_cmd_queue_id (), &event_out->get_event_id ());
+#endif
+    XCAM_FAIL_RETURN (
+        WARNING,
+        error_code == CL_SUCCESS,
+        XCAM_RETURN_ERROR_CL,
+        "enqueue marker failed with error_code:%d", error_code);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 SmartPtr<CLCommandQueue>
-CLContext::create_cmd_queue (SmartPtr<CLContext> &self)
+CLContext::create_cmd_queue (SmartPtr<CLContext> &self, bool out_of_order)
 {
     cl_device_id device_id = _device->get_device_id ();
     cl_command_queue cmd_queue_id = NULL;
+    cl_command_queue_properties properties = 0;
+    cl_command_queue_properties supported = 0;
     cl_int err_code = 0;
     SmartPtr<CLCommandQueue> result;
 
     XCAM_ASSERT (self.ptr() == this);
 
+    if (out_of_order) {
+#if defined (CL_VERSION_2_0) && (CL_VERSION_2_0 == 1)
+        err_code = clGetDeviceInfo (
+            device_id, CL_DEVICE_QUEUE_ON_HOST_PROPERTIES, sizeof (supported), &supported, NULL);
+#else
+        err_code = clGetDeviceInfo (
+            device_id, CL_DEVICE_QUEUE_PROPERTIES, sizeof (supported), &supported, NULL);
+#endif
+        if (err_code == CL_SUCCESS && (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE)) {
+            properties |= CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+        } else {
+            XCAM_LOG_DEBUG ("CL device not support out-of-order queue, create in-order one");
+        }
+    }
+
+    if (CLKernelProfiler::instance ()->is_enabled ())
+        properties |= CL_QUEUE_PROFILING_ENABLE;
+
 #if defined (CL_VERSION_2_0) && (CL_VERSION_2_0 == 1)
-    cmd_queue_id = clCreateCommandQueueWithProperties (_context_id, device_id, 0, &err_code);
+    cl_queue_properties queue_props[] = {CL_QUEUE_PROPERTIES, properties, 0};
+    cmd_queue_id = clCreateCommandQueueWithProperties (
+        _context_id, device_id, (properties ? queue_props : NULL), &err_code);
 #else
-    cmd_queue_id = clCreateCommandQueue (_context_id, device_id, 0, &err_code);
+    cmd_queue_id = clCreateCommandQueue (_context_id, device_id, properties, &err_code);
 #endif
     if (err_code != CL_SUCCESS) {
         XCAM_LOG_WARNING ("create CL command queue failed, errcode:%d", err_code);
         return NULL;
     }
 
-    result = new CLCommandQueue (self, cmd_queue_id);
+    result = new CLCommandQueue (self, cmd_queue_id, (properties & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE));
     return result;
 }
 
@@ -567,6 +658,43 @@ CLContext::enqueue_write_buffer (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLContext::enqueue_copy_buffer (
+    cl_mem src_id, cl_mem dst_id,
+    uint32_t src_offset, uint32_t dst_offset, uint32_t size,
+    CLEventList &events_wait,
+    SmartPtr<CLEvent> &event_out)
+{
+    SmartPtr<CLCommandQueue> cmd_queue;
+    cl_command_queue cmd_queue_id = NULL;
+    cl_event *event_out_id = NULL;
+    cl_event events_id_wait[XCAM_CL_MAX_EVENT_SIZE];
+    uint32_t num_of_events_wait = 0;
+    cl_int errcode = CL_SUCCESS;
+
+    cmd_queue = get_default_cmd_queue ();
+    cmd_queue_id = cmd_queue->get_cmd_queue_id ();
+    num_of_events_wait = event_list_2_id_array (events_wait, events_id_wait, XCAM_CL_MAX_EVENT_SIZE);
+    if (event_out.ptr ())
+        event_out_id = &event_out->get_event_id ();
+
+    XCAM_ASSERT (_context_id);
+    XCAM_ASSERT (cmd_queue_id);
+    errcode = clEnqueueCopyBuffer (
+                  cmd_queue_id, src_id, dst_id,
+                  src_offset, dst_offset, size,
+                  num_of_events_wait, (num_of_events_wait ? events_id_wait : NULL),
+                  event_out_id);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        errcode == CL_SUCCESS,
+        XCAM_RETURN_ERROR_CL,
+        "cl enqueue copy buffer failed with error_code:%d", errcode);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLContext::enqueue_map_buffer (
     cl_mem buf_id, void *&ptr,
@@ -699,9 +827,10 @@ CLContext::enqueue_unmap (
     return XCAM_RETURN_NO_ERROR;
 }
 
-CLCommandQueue::CLCommandQueue (SmartPtr<CLContext> &context, cl_command_queue id)
+CLCommandQueue::CLCommandQueue (SmartPtr<CLContext> &context, cl_command_queue id, bool out_of_order)
     : _context (context)
     , _cmd_queue_id (id)
+    , _out_of_order (out_of_order)
 {
     XCAM_ASSERT (context.ptr ());
     XCAM_ASSERT (id);
@@ -22,6 +22,7 @@
 #define XCAM_CL_CONTEXT_H
 
 #include <xcam_std.h>
+#include <xcam_mutex.h>
 #include <map>
 #include <list>
 #include <CL/cl.h>
@@ -47,12 +48,14 @@ class CLContext {
 
     friend class CLDevice;
     friend class CLKernel;
+    friend class CLKernelBatch;
     friend class CLMemory;
     friend class CLBuffer;
     friend class CLSubBuffer;
     friend class CLImage;
     friend class CLImage2D;
     friend class CLImage2DArray;
+    friend class CLMemoryPool;
 
     friend class CLVaBuffer;
     friend class CLVaImage;
@@ -69,11 +72,22 @@ public:
         return _context_id;
     }
 
-    XCamReturn flush ();
-    XCamReturn finish ();
+    // queue NULL means default cmd queue
+    XCamReturn flush (SmartPtr<CLCommandQueue> queue = NULL);
+    XCamReturn finish (SmartPtr<CLCommandQueue> queue = NULL);
 
     void terminate ();
 
+    /*
+     * default cmd queue(index 0) is always in-order, enqueue_* of memory use it.
+     * extra queues are out-of-order if device supports, kernels on them
+     * need to be chained by events.
+     */
+    uint32_t ensure_cmd_queues (SmartPtr<CLContext> &self, uint32_t count);
+    uint32_t get_cmd_queue_count ();
+    // index wraps around queue count
+    SmartPtr<CLCommandQueue> get_cmd_queue (uint32_t index);
+
 private:
     static void context_pfn_notify (
         const char* erro_info, const void *private_info,
@@ -82,7 +96,7 @@ private:
         cl_program program, void *user_data);
 
     explicit CLContext (SmartPtr<CLDevice> &device);
-    SmartPtr<CLCommandQueue> create_cmd_queue (SmartPtr<CLContext> &self);
+    SmartPtr<CLCommandQueue> create_cmd_queue (SmartPtr<CLContext> &self, bool out_of_order = false);
     cl_kernel generate_kernel_id (
         CLKernel *kernel,
         const uint8_t *source,
@@ -98,6 +112,11 @@ private:
         CLEventList &events_wait = CLEvent::EmptyList,
         SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
 
+    // @event_out completes after all commands enqueued before on @queue, NULL means default queue
+    XCamReturn enqueue_marker (
+        const SmartPtr<CLCommandQueue> &queue,
+        SmartPtr<CLEvent> &event_out);
+
     XCamReturn set_event_callback (
         SmartPtr<CLEvent> &event, cl_int status,
         void (*callback) (cl_event, cl_int, void*),
@@ -141,6 +160,13 @@ private:
         CLEventList &events_wait = CLEvent::EmptyList,
         SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
 
+    // device side copy, never blocks
+    XCamReturn enqueue_copy_buffer (
+        cl_mem src_id, cl_mem dst_id,
+        uint32_t src_offset, uint32_t dst_offset, uint32_t size,
+        CLEventList &events_wait = CLEvent::EmptyList,
+        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
+
     XCamReturn enqueue_map_buffer (
         cl_mem buf_id, void *&ptr,
         uint32_t offset, uint32_t size,
@@ -178,6 +204,7 @@ private:
     SmartPtr<CLDevice>          _device;
     //CLKernelMap                 _kernel_map;
     CLCmdQueueList              _cmd_queue_list;
+    Mutex                       _cmd_queue_mutex;
 };
 
 class CLCommandQueue {
@@ -188,15 +215,19 @@ public:
     cl_command_queue get_cmd_queue_id () {
         return _cmd_queue_id;
     }
+    bool is_out_of_order () const {
+        return _out_of_order;
+    }
 
 private:
-    explicit CLCommandQueue (SmartPtr<CLContext> &context, cl_command_queue id);
+    explicit CLCommandQueue (SmartPtr<CLContext> &context, cl_command_queue id, bool out_of_order = false);
     void destroy ();
     XCAM_DEAD_COPY (CLCommandQueue);
 
 private:
     SmartPtr<CLContext>     _context;
     cl_command_queue        _cmd_queue_id;
+    bool                    _out_of_order;
 };
 
 };
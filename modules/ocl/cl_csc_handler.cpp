@@ -46,6 +46,11 @@ static const XCamKernelInfo kernel_csc_info[] = {
     },
     {
         "kernel_csc_nv12torgba",
+#include "kernel_csc.clx"
+        , 0,
+    },
+    {
+        "kernel_csc_nv12scale",
 #include "kernel_csc.clx"
         , 0,
     },
@@ -71,6 +76,8 @@ CLCscImageHandler::CLCscImageHandler (
     : CLImageHandler (context, name)
     , _output_format (V4L2_PIX_FMT_NV12)
     , _csc_type (type)
+    , _out_width (0)
+    , _out_height (0)
 {
     memcpy (_rgbtoyuv_matrix, default_rgbtoyuv_matrix, sizeof (_rgbtoyuv_matrix));
 
@@ -84,6 +91,7 @@ CLCscImageHandler::CLCscImageHandler (
     case CL_CSC_TYPE_RGBA64TORGBA:
     case CL_CSC_TYPE_YUYVTORGBA:
     case CL_CSC_TYPE_NV12TORGBA:
+    case CL_CSC_TYPE_NV12SCALE:
         _output_format = V4L2_PIX_FMT_RGBA32;
         break;
     default:
@@ -111,6 +119,18 @@ CLCscImageHandler::set_matrix (const XCam3aResultColorMatrix &matrix)
 bool
 CLCscImageHandler::set_output_format (uint32_t fourcc)
 {
+    if (_csc_type == CL_CSC_TYPE_NV12SCALE) {
+        XCAM_FAIL_RETURN (
+            WARNING,
+            V4L2_PIX_FMT_XBGR32 == fourcc || V4L2_PIX_FMT_RGBA32 == fourcc || V4L2_PIX_FMT_YUYV == fourcc,
+            false,
+            "CL csc handler(nv12scale) doesn't support format: (%s)",
+            xcam_fourcc_to_string (fourcc));
+
+        _output_format = fourcc;
+        return true;
+    }
+
     XCAM_FAIL_RETURN (
         WARNING,
         V4L2_PIX_FMT_XBGR32 == fourcc || V4L2_PIX_FMT_NV12 == fourcc,
@@ -122,12 +142,42 @@ CLCscImageHandler::set_output_format (uint32_t fourcc)
     return true;
 }
 
+bool
+CLCscImageHandler::set_crop_scale (const Rect &crop, uint32_t out_width, uint32_t out_height)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _csc_type == CL_CSC_TYPE_NV12SCALE, false,
+        "CL csc handler(%s) crop and scale need nv12scale type", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        WARNING, crop.pos_x >= 0 && crop.pos_y >= 0 && crop.width >= 0 && crop.height >= 0, false,
+        "CL csc handler(%s) invalid crop(%d, %d, %d, %d)",
+        XCAM_STR (get_name ()), crop.pos_x, crop.pos_y, crop.width, crop.height);
+
+    _crop = crop;
+    _out_width = XCAM_ALIGN_UP (out_width, 2);
+    _out_height = out_height;
+    return true;
+}
+
 XCamReturn
 CLCscImageHandler::prepare_buffer_pool_video_info (
     const VideoBufferInfo &input,
     VideoBufferInfo &output)
 {
-    bool format_inited = output.init (_output_format, input.width, input.height);
+    uint32_t width = input.width;
+    uint32_t height = input.height;
+    if (_csc_type == CL_CSC_TYPE_NV12SCALE) {
+        if (_crop.width && _crop.height) {
+            width = XCAM_ALIGN_UP (_crop.width, 2);
+            height = _crop.height;
+        }
+        if (_out_width && _out_height) {
+            width = _out_width;
+            height = _out_height;
+        }
+    }
+
+    bool format_inited = output.init (_output_format, width, height);
 
     XCAM_FAIL_RETURN (
         WARNING,
@@ -163,6 +213,9 @@ CLCscImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vi
 
     XCAM_ASSERT (_csc_kernel.ptr ());
 
+    if (_csc_type == CL_CSC_TYPE_NV12SCALE)
+        return prepare_scale_parameters (input, output);
+
     CLImageDesc in_desc, out_desc;
     CLImage::video_info_2_cl_image_desc (in_video_info, in_desc);
     CLImage::video_info_2_cl_image_desc (out_video_info, out_desc);
@@ -229,6 +282,79 @@ CLCscImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vi
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLCscImageHandler::prepare_scale_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    SmartPtr<CLContext> context = get_context ();
+    const VideoBufferInfo &in_info = input->get_video_info ();
+    const VideoBufferInfo &out_info = output->get_video_info ();
+    CLArgList args;
+    CLWorkSize work_size;
+
+    XCAM_FAIL_RETURN (
+        WARNING, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "CL csc handler(nv12scale) input format(%s) unsupported", xcam_fourcc_to_string (in_info.format));
+
+    CLImageDesc y_desc, uv_desc, out_desc;
+    y_desc.format.image_channel_order = CL_R;
+    y_desc.format.image_channel_data_type = CL_UNORM_INT8;
+    y_desc.width = in_info.width;
+    y_desc.height = in_info.height;
+    y_desc.row_pitch = in_info.strides[0];
+    uv_desc.format.image_channel_order = CL_RG;
+    uv_desc.format.image_channel_data_type = CL_UNORM_INT8;
+    uv_desc.width = in_info.width / 2;
+    uv_desc.height = in_info.height / 2;
+    uv_desc.row_pitch = in_info.strides[1];
+
+    // YUYV keeps two pixels in one RGBA texel
+    int32_t out_yuyv = (out_info.format == V4L2_PIX_FMT_YUYV) ? 1 : 0;
+    out_desc.format.image_channel_order = CL_RGBA;
+    out_desc.format.image_channel_data_type = CL_UNORM_INT8;
+    out_desc.width = out_yuyv ? out_info.width / 2 : out_info.width;
+    out_desc.height = out_info.height;
+    out_desc.row_pitch = out_info.strides[0];
+
+    SmartPtr<CLImage> image_y = convert_to_climage (context, input, y_desc, in_info.offsets[0]);
+    SmartPtr<CLImage> image_uv = convert_to_climage (context, input, uv_desc, in_info.offsets[1]);
+    SmartPtr<CLImage> image_out = convert_to_climage (context, output, out_desc, out_info.offsets[0]);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        image_y.ptr () && image_y->is_valid () && image_uv.ptr () && image_uv->is_valid () &&
+        image_out.ptr () && image_out->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", _csc_kernel->get_kernel_name ());
+
+    Rect crop = _crop;
+    if (!crop.width || !crop.height)
+        crop = Rect (0, 0, in_info.width, in_info.height);
+    float crop_norm[4] = {
+        (float)crop.pos_x / in_info.width, (float)crop.pos_y / in_info.height,
+        (float)crop.width / in_info.width, (float)crop.height / in_info.height
+    };
+
+    args.push_back (new CLMemArgument (image_y));
+    args.push_back (new CLMemArgument (image_out));
+    args.push_back (new CLMemArgument (image_uv));
+    args.push_back (new CLArgumentTArray<float, 4> (crop_norm));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)out_info.width));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)out_info.height));
+    args.push_back (new CLArgumentT<int32_t> (out_yuyv));
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 4;
+    work_size.global[0] = XCAM_ALIGN_UP (out_info.width / 2, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (out_info.height, work_size.local[1]);
+
+    XCamReturn ret = _csc_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "csc kernel set arguments failed.");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 SmartPtr<CLImageHandler>
 create_cl_csc_image_handler (const SmartPtr<CLContext> &context, CLCscType type)
 {
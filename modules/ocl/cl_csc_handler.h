@@ -23,6 +23,7 @@
 
 #include <xcam_std.h>
 #include <base/xcam_3a_result.h>
+#include <interface/data_types.h>
 #include <ocl/cl_image_handler.h>
 
 namespace XCam {
@@ -33,6 +34,8 @@ enum CLCscType {
     CL_CSC_TYPE_RGBA64TORGBA,
     CL_CSC_TYPE_YUYVTORGBA,
     CL_CSC_TYPE_NV12TORGBA,
+    // crop, scale and convert NV12 to RGBA or YUYV in one kernel
+    CL_CSC_TYPE_NV12SCALE,
     CL_CSC_TYPE_MAX,
 };
 
@@ -54,6 +57,8 @@ public:
     bool set_csc_kernel (SmartPtr<CLCscImageKernel> &kernel);
     bool set_matrix (const XCam3aResultColorMatrix &matrix);
     bool set_output_format (uint32_t fourcc);
+    // CL_CSC_TYPE_NV12SCALE only, empty crop takes whole input, zero size keeps crop size
+    bool set_crop_scale (const Rect &crop, uint32_t out_width, uint32_t out_height);
 
 protected:
     virtual XCamReturn prepare_buffer_pool_video_info (
@@ -62,6 +67,8 @@ protected:
     virtual XCamReturn prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
 
 private:
+    XCamReturn prepare_scale_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+
     XCAM_DEAD_COPY (CLCscImageHandler);
 
 private:
@@ -69,6 +76,9 @@ private:
     uint32_t                    _output_format;
     CLCscType                   _csc_type;
     SmartPtr<CLCscImageKernel>  _csc_kernel;
+    Rect                        _crop;
+    uint32_t                    _out_width;
+    uint32_t                    _out_height;
 };
 
 SmartPtr<CLImageHandler>
@@ -23,11 +23,19 @@
 #include <algorithm>
 #include "cl_device.h"
 
+// top fraction of low resolution dark channel searched for atmospheric light
+#define XCAM_DEFOG_LIGHT_TOP_PERCENT  0.1f
+// weight of current frame in atmospheric light smoothing
+#define XCAM_DEFOG_LIGHT_SMOOTH       0.1f
+
 enum {
     KernelDarkChannel = 0,
     KernelMinFilter,
     KernelBiFilter,
     KernelDefogRecover,
+    KernelDarkChannelDown,
+    KernelBiFilterDown,
+    KernelDarkUpsample,
 };
 
 const static XCamKernelInfo kernels_info [] = {
@@ -48,6 +56,21 @@ const static XCamKernelInfo kernels_info [] = {
     },
     {
         "kernel_defog_recover",
+#include "kernel_defog_dcp.clx"
+        , 0,
+    },
+    {
+        "kernel_dark_channel_down",
+#include "kernel_defog_dcp.clx"
+        , 0,
+    },
+    {
+        "kernel_bi_filter_down",
+#include "kernel_defog_dcp.clx"
+        , 0,
+    },
+    {
+        "kernel_dark_upsample",
 #include "kernel_defog_dcp.clx"
         , 0,
     },
@@ -182,6 +205,72 @@ CLBiFilterKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     return XCAM_RETURN_NO_ERROR;
 }
 
+CLDarkChannelScaleKernel::CLDarkChannelScaleKernel (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLDefogDcpImageHandler> &defog_handler,
+    Stage stage)
+    : CLImageKernel (context)
+    , _defog_handler (defog_handler)
+    , _stage (stage)
+{
+}
+
+XCamReturn
+CLDarkChannelScaleKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<VideoBuffer> &input = _defog_handler->get_input_buf ();
+    const VideoBufferInfo & video_info_in = input->get_video_info ();
+    SmartPtr<CLImage> image_in_y;
+
+    if (_stage != StageBiFilter) {
+        CLImageDesc cl_desc_in;
+        cl_desc_in.format.image_channel_data_type = CL_UNSIGNED_INT16;
+        cl_desc_in.format.image_channel_order = CL_RGBA;
+        cl_desc_in.width = video_info_in.width / 8;
+        cl_desc_in.height = video_info_in.height;
+        cl_desc_in.row_pitch = video_info_in.strides[0];
+        image_in_y = convert_to_climage (context, input, cl_desc_in, video_info_in.offsets[0]);
+        XCAM_FAIL_RETURN (
+            WARNING, image_in_y.ptr () && image_in_y->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "cl image kernel(%s) input y image not available", get_kernel_name ());
+    }
+
+    SmartPtr<CLImage> &low_map = _defog_handler->get_low_map (XCAM_DEFOG_LOW_ORIGINAL);
+    SmartPtr<CLImage> &low_filtered = _defog_handler->get_low_map (XCAM_DEFOG_LOW_BI_FILTER);
+    const CLImageDesc &low_desc = low_map->get_image_desc ();
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    switch (_stage) {
+    case StageDown:
+        args.push_back (new CLMemArgument (image_in_y));
+        args.push_back (new CLMemArgument (_defog_handler->get_dark_map (XCAM_DEFOG_DC_ORIGINAL)));
+        args.push_back (new CLMemArgument (low_map));
+        break;
+    case StageBiFilter:
+        args.push_back (new CLMemArgument (low_map));
+        args.push_back (new CLMemArgument (low_filtered));
+        break;
+    case StageUpsample:
+        args.push_back (new CLMemArgument (image_in_y));
+        args.push_back (new CLMemArgument (low_filtered));
+        args.push_back (new CLMemArgument (_defog_handler->get_dark_map (XCAM_DEFOG_DC_BI_FILTER)));
+
+        work_size.local[0] = 16;
+        work_size.local[1] = 2;
+        work_size.global[0] = XCAM_ALIGN_UP (video_info_in.width / 8, work_size.local[0]);
+        work_size.global[1] = XCAM_ALIGN_UP (video_info_in.height, work_size.local[1]);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    work_size.local[0] = 8;
+    work_size.local[1] = 4;
+    work_size.global[0] = XCAM_ALIGN_UP (low_desc.width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (low_desc.height, work_size.local[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 CLDefogRecoverKernel::CLDefogRecoverKernel (
     const SmartPtr<CLContext> &context, SmartPtr<CLDefogDcpImageHandler> &defog_handler)
     : CLImageKernel (context)
@@ -191,6 +280,8 @@ CLDefogRecoverKernel::CLDefogRecoverKernel (
     , _max_b (255.0f)
     , _max_i (255.0f)
 {
+    // each item writes 8 pixels of 2 Y rows and 1 UV row
+    set_roi_block (8, 2);
 }
 
 float
@@ -248,6 +339,11 @@ CLDefogRecoverKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     SmartPtr<CLImage> &dark_map = _defog_handler->get_dark_map (XCAM_DEFOG_DC_BI_FILTER);
     get_max_value (input);
 
+    float light = _defog_handler->get_atmospheric_light ();
+    if (light > 0.0f) {
+        _max_i = _max_r = _max_g = _max_b = light;
+    }
+
     args.push_back (new CLMemArgument (dark_map));
     args.push_back (new CLArgumentT<float> (_max_i));
     args.push_back (new CLArgumentT<float> (_max_r));
@@ -287,8 +383,11 @@ CLDefogRecoverKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
 }
 
 CLDefogDcpImageHandler::CLDefogDcpImageHandler (
-    const SmartPtr<CLContext> &context, const char *name)
+    const SmartPtr<CLContext> &context, const char *name, uint32_t downscale)
     : CLImageHandler (context, name)
+    , _downscale (downscale)
+    , _low_map_valid (false)
+    , _atmospheric_light (0.0f)
 {
 }
 
@@ -303,6 +402,8 @@ CLDefogDcpImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartP
         ret,
         "CLDefogDcpImageHandler allocate transmit buffers failed");
 
+    update_atmospheric_light ();
+
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -314,6 +415,9 @@ CLDefogDcpImageHandler::execute_done (SmartPtr<VideoBuffer> &output)
     dump_buffer ();
 #endif
 
+    if (_downscale > 1)
+        _low_map_valid = true;
+
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -324,6 +428,15 @@ CLDefogDcpImageHandler::allocate_transmit_bufs (const VideoBufferInfo &video_inf
     CLImageDesc cl_rgb_desc, cl_dark_desc;
     SmartPtr<CLContext> context = get_context ();
 
+    // keep maps and cached atmospheric light while resolution is unchanged
+    if (_rgb_buf[0].ptr ()) {
+        const CLImageDesc &desc = _rgb_buf[0]->get_image_desc ();
+        if (desc.width == video_info.width / 8 && desc.height == video_info.height)
+            return XCAM_RETURN_NO_ERROR;
+    }
+    _low_map_valid = false;
+    _atmospheric_light = 0.0f;
+
     cl_rgb_desc.format.image_channel_data_type = CL_UNSIGNED_INT16;
     cl_rgb_desc.format.image_channel_order = CL_RGBA;
     cl_rgb_desc.width = video_info.width / 8;
@@ -352,9 +465,83 @@ CLDefogDcpImageHandler::allocate_transmit_bufs (const VideoBufferInfo &video_inf
             "CLDefogDcpImageHandler allocate dark channel buffers failed");
     }
 
+    if (_downscale <= 1)
+        return XCAM_RETURN_NO_ERROR;
+
+    CLImageDesc cl_low_desc;
+    cl_low_desc.format.image_channel_data_type = CL_UNORM_INT8;
+    cl_low_desc.format.image_channel_order = CL_RG;
+    cl_low_desc.width = video_info.width / _downscale;
+    cl_low_desc.height = video_info.height / _downscale;
+
+    for (i = 0; i < XCAM_DEFOG_LOW_MAX_BUF; ++i) {
+        _low_buf[i] = new CLImage2D (context, cl_low_desc);
+        XCAM_FAIL_RETURN(
+            WARNING,
+            _low_buf[i]->is_valid (),
+            XCAM_RETURN_ERROR_MEM,
+            "CLDefogDcpImageHandler allocate low resolution buffers failed");
+    }
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+CLDefogDcpImageHandler::update_atmospheric_light ()
+{
+    if (_downscale <= 1 || !_low_map_valid)
+        return;
+
+    // low map still holds the last frame, mapping only waits for its kernels
+    SmartPtr<CLImage> &image = _low_buf[XCAM_DEFOG_LOW_ORIGINAL];
+    const CLImageDesc &desc = image->get_image_desc ();
+    void *ptr = NULL;
+    size_t origin[3] = {0, 0, 0};
+    size_t region[3] = {desc.width, desc.height, 1};
+    size_t row_pitch;
+    size_t slice_pitch;
+
+    XCamReturn ret = image->enqueue_map (ptr, origin, region, &row_pitch, &slice_pitch, CL_MAP_READ);
+    if (!xcam_ret_is_ok (ret) || !ptr) {
+        XCAM_LOG_WARNING ("CLDefogDcpImageHandler map low resolution dark channel failed");
+        return;
+    }
+
+    uint32_t hist[256];
+    xcam_mem_clear (hist);
+    for (uint32_t y = 0; y < desc.height; ++y) {
+        const uint8_t *line = (const uint8_t *)ptr + row_pitch * y;
+        for (uint32_t x = 0; x < desc.width; ++x)
+            ++hist[line[x * 2]];
+    }
+
+    // brightest luma among the haziest pixels
+    uint32_t top_count = XCAM_MAX ((uint32_t)(desc.width * desc.height * XCAM_DEFOG_LIGHT_TOP_PERCENT / 100.0f), 1u);
+    uint32_t sum_count = 0;
+    int32_t threshold = 255;
+    for (; threshold > 0; --threshold) {
+        sum_count += hist[threshold];
+        if (sum_count >= top_count)
+            break;
+    }
+
+    uint8_t max_luma = 0;
+    for (uint32_t y = 0; y < desc.height; ++y) {
+        const uint8_t *line = (const uint8_t *)ptr + row_pitch * y;
+        for (uint32_t x = 0; x < desc.width; ++x) {
+            if (line[x * 2] >= threshold)
+                max_luma = XCAM_MAX (max_luma, line[x * 2 + 1]);
+        }
+    }
+    image->enqueue_unmap (ptr);
+
+    float light = XCAM_MAX ((float)max_luma, 1.0f);
+    if (_atmospheric_light <= 0.0f)
+        _atmospheric_light = light;
+    else
+        _atmospheric_light += (light - _atmospheric_light) * XCAM_DEFOG_LIGHT_SMOOTH;
+}
+
 void
 CLDefogDcpImageHandler::dump_buffer ()
 {
@@ -427,6 +614,30 @@ create_kernel_bi_filter (
     return kernel;
 }
 
+static SmartPtr<CLDarkChannelScaleKernel>
+create_kernel_dark_channel_scale (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLDefogDcpImageHandler> handler,
+    CLDarkChannelScaleKernel::Stage stage)
+{
+    SmartPtr<CLDarkChannelScaleKernel> kernel;
+    const XCamKernelInfo &info =
+        kernels_info[KernelDarkChannelDown + (int)stage - (int)CLDarkChannelScaleKernel::StageDown];
+
+    char build_options[1024];
+    xcam_mem_clear (build_options);
+    snprintf (build_options, sizeof (build_options), " -DDEFOG_DOWNSCALE=%d ", handler->get_downscale ());
+
+    kernel = new CLDarkChannelScaleKernel (context, handler, stage);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        kernel->build_kernel (info, build_options) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "Defog build kernel(%s) failed", info.kernel_name);
+
+    return kernel;
+}
+
 static SmartPtr<CLDefogRecoverKernel>
 create_kernel_defog_recover (
     const SmartPtr<CLContext> &context, SmartPtr<CLDefogDcpImageHandler> handler)
@@ -443,13 +654,18 @@ create_kernel_defog_recover (
 }
 
 SmartPtr<CLImageHandler>
-create_cl_defog_dcp_image_handler (const SmartPtr<CLContext> &context)
+create_cl_defog_dcp_image_handler (const SmartPtr<CLContext> &context, uint32_t downscale)
 {
     SmartPtr<CLDefogDcpImageHandler> defog_handler;
 
     SmartPtr<CLImageKernel> kernel;
 
-    defog_handler = new CLDefogDcpImageHandler (context, "cl_handler_defog_dcp");
+    if (downscale != 1 && downscale != 4 && downscale != 8) {
+        XCAM_LOG_WARNING ("defog handler downscale(%d) unsupported, use full resolution", downscale);
+        downscale = 1;
+    }
+
+    defog_handler = new CLDefogDcpImageHandler (context, "cl_handler_defog_dcp", downscale);
     kernel = create_kernel_dark_channel (context, defog_handler);
     XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "defog handler create dark channel kernel failed");
     defog_handler->add_kernel (kernel);
@@ -463,9 +679,17 @@ create_cl_defog_dcp_image_handler (const SmartPtr<CLContext> &context)
     }
 #endif
 
-    kernel = create_kernel_bi_filter (context, defog_handler);
-    XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "defog handler create bilateral filter kernel failed");
-    defog_handler->add_kernel (kernel);
+    if (downscale > 1) {
+        for (int i = CLDarkChannelScaleKernel::StageDown; i <= CLDarkChannelScaleKernel::StageUpsample; ++i) {
+            kernel = create_kernel_dark_channel_scale (context, defog_handler, (CLDarkChannelScaleKernel::Stage)i);
+            XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "defog handler create dark channel scale kernel failed");
+            defog_handler->add_kernel (kernel);
+        }
+    } else {
+        kernel = create_kernel_bi_filter (context, defog_handler);
+        XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "defog handler create bilateral filter kernel failed");
+        defog_handler->add_kernel (kernel);
+    }
 
     kernel = create_kernel_defog_recover (context, defog_handler);
     XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "defog handler create defog recover kernel failed");
@@ -33,6 +33,10 @@
 #define XCAM_DEFOG_DC_REFINED       4
 #define XCAM_DEFOG_DC_MAX_BUF       5
 
+// low resolution maps of downscaled mode, dark channel in x and luma in y
+#define XCAM_DEFOG_LOW_ORIGINAL     0
+#define XCAM_DEFOG_LOW_BI_FILTER    1
+#define XCAM_DEFOG_LOW_MAX_BUF      2
 
 #define XCAM_DEFOG_R_CHANNEL    0
 #define XCAM_DEFOG_G_CHANNEL    1
@@ -88,6 +92,35 @@ private:
     SmartPtr<CLDefogDcpImageHandler>   _defog_handler;
 };
 
+/*
+ * downscaled mode, estimates dark channel at 1/downscale resolution,
+ * filters it there and joint bilateral upsamples it to XCAM_DEFOG_DC_BI_FILTER.
+ */
+class CLDarkChannelScaleKernel
+    : public CLImageKernel
+{
+public:
+    enum Stage {
+        StageDown = 0,
+        StageBiFilter,
+        StageUpsample,
+    };
+
+public:
+    explicit CLDarkChannelScaleKernel (
+        const SmartPtr<CLContext> &context, SmartPtr<CLDefogDcpImageHandler> &defog_handler, Stage stage);
+
+protected:
+    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
+
+private:
+    XCAM_DEAD_COPY (CLDarkChannelScaleKernel);
+
+private:
+    SmartPtr<CLDefogDcpImageHandler>   _defog_handler;
+    Stage                              _stage;
+};
+
 class CLDefogRecoverKernel
     : public CLImageKernel
 {
@@ -116,7 +149,7 @@ class CLDefogDcpImageHandler
 {
 public:
     explicit CLDefogDcpImageHandler (
-        const SmartPtr<CLContext> &context, const char *name);
+        const SmartPtr<CLContext> &context, const char *name, uint32_t downscale = 1);
 
     SmartPtr<CLImage> &get_dark_map (uint index) {
         XCAM_ASSERT (index < XCAM_DEFOG_DC_MAX_BUF);
@@ -126,6 +159,18 @@ public:
         XCAM_ASSERT (index < XCAM_DEFOG_MAX_CHANNELS);
         return _rgb_buf[index];
     };
+    SmartPtr<CLImage> &get_low_map (uint index) {
+        XCAM_ASSERT (index < XCAM_DEFOG_LOW_MAX_BUF);
+        return _low_buf[index];
+    };
+
+    uint32_t get_downscale () const {
+        return _downscale;
+    }
+    // smoothed across frames in downscaled mode, 0 until estimated
+    float get_atmospheric_light () const {
+        return _atmospheric_light;
+    }
 
 protected:
     virtual XCamReturn prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
@@ -133,6 +178,7 @@ protected:
 
 private:
     XCamReturn allocate_transmit_bufs (const VideoBufferInfo &video_info);
+    void update_atmospheric_light ();
     void dump_buffer();
 
     XCAM_DEAD_COPY (CLDefogDcpImageHandler);
@@ -140,10 +186,15 @@ private:
 private:
     SmartPtr<CLImage>                 _dark_channel_buf[XCAM_DEFOG_DC_MAX_BUF];
     SmartPtr<CLImage>                 _rgb_buf[XCAM_DEFOG_MAX_CHANNELS];
+    SmartPtr<CLImage>                 _low_buf[XCAM_DEFOG_LOW_MAX_BUF];
+    uint32_t                          _downscale;
+    bool                              _low_map_valid;
+    float                             _atmospheric_light;
 };
 
+// downscale 4 or 8 estimates dark channel at low resolution, 1 keeps full resolution
 SmartPtr<CLImageHandler>
-create_cl_defog_dcp_image_handler (const SmartPtr<CLContext> &context);
+create_cl_defog_dcp_image_handler (const SmartPtr<CLContext> &context, uint32_t downscale = 1);
 
 };
 
@@ -23,6 +23,7 @@
 #if HAVE_LIBDRM
 #include "intel/cl_intel_context.h"
 #endif
+#include <vector>
 
 namespace XCam {
 
@@ -129,12 +130,18 @@ CLDevice::init ()
             "\tmax_work_item_dims:%" PRIu32
             "\tmax_work_item_sizes:{%" PRIuS ", %" PRIuS ", %" PRIuS "}"
             "\tmax_work_group_size:%" PRIuS
-            "\timage_pitch_alignment:%" PRIu32,
+            "\timage_pitch_alignment:%" PRIu32
+            "\tdevice_name:%s"
+            "\tdriver_version:%s"
+            "\tfp16_supported:%s",
             device_info.max_compute_unit,
             device_info.max_work_item_dims,
             device_info.max_work_item_sizes[0], device_info.max_work_item_sizes[1], device_info.max_work_item_sizes[2],
             device_info.max_work_group_size,
-            device_info.image_pitch_alignment);
+            device_info.image_pitch_alignment,
+            device_info.device_name,
+            device_info.driver_version,
+            device_info.fp16_supported ? "yes" : "no");
     }
 
     // get platform name string length
@@ -185,6 +192,20 @@ CLDevice::query_device_info (cl_device_id device_id, CLDevieInfo &info)
         info.image_pitch_alignment = alignment;
     else
         info.image_pitch_alignment = 4;
+
+    XCAM_CL_GET_DEVICE_INFO (CL_DEVICE_NAME, info.device_name);
+    XCAM_CL_GET_DEVICE_INFO (CL_DRIVER_VERSION, info.driver_version);
+    info.device_name[XCAM_CL_MAX_STR_SIZE - 1] = '\0';
+    info.driver_version[XCAM_CL_MAX_STR_SIZE - 1] = '\0';
+
+    size_t ext_size = 0;
+    if (clGetDeviceInfo (device_id, CL_DEVICE_EXTENSIONS, 0, NULL, &ext_size) == CL_SUCCESS && ext_size) {
+        std::vector<char> extensions (ext_size + 1, '\0');
+        if (clGetDeviceInfo (device_id, CL_DEVICE_EXTENSIONS, ext_size, &extensions[0], NULL) == CL_SUCCESS) {
+            info.fp16_supported = (strstr (&extensions[0], "cl_khr_fp16") != NULL);
+            info.subgroups_supported = (strstr (&extensions[0], "cl_intel_subgroups") != NULL);
+        }
+    }
     return true;
 }
 
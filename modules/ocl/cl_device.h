@@ -35,14 +35,22 @@ struct CLDevieInfo {
     size_t    max_work_item_sizes [3];
     size_t    max_work_group_size;
     uint32_t  image_pitch_alignment;
+    char      device_name[XCAM_CL_MAX_STR_SIZE];
+    char      driver_version[XCAM_CL_MAX_STR_SIZE];
+    bool      fp16_supported;
+    bool      subgroups_supported;
 
     CLDevieInfo ()
         : max_compute_unit (0)
         , max_work_item_dims (0)
         , max_work_group_size (0)
         , image_pitch_alignment (4)
+        , fp16_supported (false)
+        , subgroups_supported (false)
     {
         xcam_mem_clear (max_work_item_sizes);
+        xcam_mem_clear (device_name);
+        xcam_mem_clear (driver_version);
     }
 };
 
@@ -0,0 +1,445 @@
+/*
+ * cl_feature_match.cpp - CL feature match of stitching overlaps
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_utils.h"
+#include "cl_feature_match.h"
+#include <algorithm>
+
+// as CVCapiFeatureMatch, goodFeaturesToTrack and calcOpticalFlowPyrLK of 4 levels
+#define XCAM_CL_FM_MAX_CORNERS 300
+#define XCAM_CL_FM_MAX_CANDIDATES 4096
+#define XCAM_CL_FM_QUALITY 0.01f
+#define XCAM_CL_FM_MIN_DISTANCE 5.0f
+#define XCAM_CL_FM_LK_LEVELS 4
+
+// keep same as FM_LOCAL_SIZE in kernel_feature_match.cl
+#define XCAM_CL_FM_LOCAL_SIZE 64
+
+namespace XCam {
+
+enum {
+    KernelFMCornerScore = 0,
+    KernelFMCornerSelect,
+    KernelFMLKTrack,
+};
+
+static const XCamKernelInfo kernel_feature_match_info[] = {
+    {
+        "kernel_fm_corner_score",
+#include "kernel_feature_match.clx"
+        , 0,
+    },
+    {
+        "kernel_fm_corner_select",
+#include "kernel_feature_match.clx"
+        , 0,
+    },
+    {
+        "kernel_fm_lk_track",
+#include "kernel_feature_match.clx"
+        , 0,
+    },
+};
+
+// orders candidate indices by score, higher first
+class CandidateGreater
+{
+public:
+    explicit CandidateGreater (const std::vector<float> &candidates)
+        : _candidates (candidates)
+    {}
+    bool operator () (uint32_t a, uint32_t b) const {
+        return _candidates[a * 4 + 2] > _candidates[b * 4 + 2];
+    }
+
+private:
+    const std::vector<float> &_candidates;
+};
+
+CLFeatureMatch::CLFeatureMatch (const SmartPtr<CLContext> &context)
+    : FeatureMatch ()
+    , _context (context)
+    , _adjust_area (false)
+    , _score_size (0)
+{
+    XCAM_ASSERT (context.ptr ());
+}
+
+void
+CLFeatureMatch::set_pyramids (const SmartPtr<CLGaussPyramid> &left, const SmartPtr<CLGaussPyramid> &right)
+{
+    _left_pyramid = left;
+    _right_pyramid = right;
+}
+
+XCamReturn
+CLFeatureMatch::init_kernels ()
+{
+    char build_options[64];
+    snprintf (build_options, sizeof (build_options), "-DFM_LOCAL_SIZE=%d", XCAM_CL_FM_LOCAL_SIZE);
+
+    SmartPtr<CLKernel> kernels[3];
+    for (uint32_t i = 0; i < 3; ++i) {
+        const XCamKernelInfo &info = kernel_feature_match_info[i];
+        kernels[i] = new CLKernel (_context, info.kernel_name);
+        XCAM_FAIL_RETURN (
+            ERROR, kernels[i]->build_kernel (info, build_options) == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_CL,
+            "FeatureMatch(idx:%d): build kernel(%s) failed", _fm_idx, info.kernel_name);
+    }
+    _score_kernel = kernels[KernelFMCornerScore];
+    _select_kernel = kernels[KernelFMCornerSelect];
+    _track_kernel = kernels[KernelFMLKTrack];
+
+    _max_score_buf = new CLBuffer (_context, sizeof (uint32_t), CL_MEM_READ_WRITE);
+    _count_buf = new CLBuffer (_context, sizeof (uint32_t), CL_MEM_READ_WRITE);
+    _candidate_buf = new CLBuffer (_context, sizeof (float) * 4 * XCAM_CL_FM_MAX_CANDIDATES, CL_MEM_READ_WRITE);
+    _corner_buf = new CLBuffer (_context, sizeof (float) * 2 * XCAM_CL_FM_MAX_CORNERS, CL_MEM_READ_WRITE);
+    _tracked_buf = new CLBuffer (_context, sizeof (float) * 2 * XCAM_CL_FM_MAX_CORNERS, CL_MEM_READ_WRITE);
+    _error_buf = new CLBuffer (_context, sizeof (float) * XCAM_CL_FM_MAX_CORNERS, CL_MEM_READ_WRITE);
+    _status_buf = new CLBuffer (_context, sizeof (int32_t) * XCAM_CL_FM_MAX_CORNERS, CL_MEM_READ_WRITE);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _max_score_buf->is_valid () && _count_buf->is_valid () && _candidate_buf->is_valid () && _corner_buf->is_valid () &&
+        _tracked_buf->is_valid () && _error_buf->is_valid () && _status_buf->is_valid (),
+        XCAM_RETURN_ERROR_MEM, "FeatureMatch(idx:%d): allocate buffers failed", _fm_idx);
+
+    if (!_left_pyramid.ptr ())
+        _left_pyramid = new CLGaussPyramid (_context);
+    if (!_right_pyramid.ptr ())
+        _right_pyramid = new CLGaussPyramid (_context);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLFeatureMatch::ensure_buffers (uint32_t width, uint32_t height)
+{
+    uint32_t size = width * height;
+    if (size <= _score_size)
+        return XCAM_RETURN_NO_ERROR;
+
+    _score_buf = new CLBuffer (_context, sizeof (float) * size, CL_MEM_READ_WRITE);
+    XCAM_FAIL_RETURN (
+        ERROR, _score_buf->is_valid (), XCAM_RETURN_ERROR_MEM,
+        "FeatureMatch(idx:%d): allocate score buffer(%dx%d) failed", _fm_idx, width, height);
+    _score_size = size;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLFeatureMatch::get_levels (
+    SmartPtr<CLGaussPyramid> &pyramid, SmartPtr<VideoBuffer> &frame, uint32_t base,
+    const CLEventList &waits, SmartPtr<CLImage> *levels, CLEventList &events)
+{
+    for (uint32_t i = 0; i < XCAM_CL_FM_LK_LEVELS; ++i) {
+        SmartPtr<CLEvent> event;
+        XCamReturn ret = pyramid->get_level (frame, base + i, levels[i], waits, event);
+        XCAM_FAIL_RETURN (
+            WARNING, xcam_ret_is_ok (ret) && levels[i].ptr () && levels[i]->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "FeatureMatch(idx:%d): get pyramid level(%d) failed", _fm_idx, base + i);
+
+        if (event.ptr () && event->get_event_id ())
+            events.push_back (event);
+    }
+
+    // level 0 is the frame itself
+    if (base == 0)
+        events.insert (events.end (), waits.begin (), waits.end ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLFeatureMatch::detect_corners (
+    const SmartPtr<CLImage> &image, int origin_x, int origin_y, int width, int height,
+    CLEventList &waits)
+{
+    XCamReturn ret = ensure_buffers (width, height);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): ensure buffers failed", _fm_idx);
+
+    uint32_t zero = 0;
+    ret = _max_score_buf->enqueue_write (&zero, 0, sizeof (zero));
+    if (xcam_ret_is_ok (ret))
+        ret = _count_buf->enqueue_write (&zero, 0, sizeof (zero));
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): clear counters failed", _fm_idx);
+
+    CLWorkSize work_size;
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 8;
+    work_size.global[0] = XCAM_ALIGN_UP (width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (height, work_size.local[1]);
+
+    CLArgList args;
+    args.push_back (new CLMemArgument (image));
+    args.push_back (new CLArgumentT<int> (origin_x));
+    args.push_back (new CLArgumentT<int> (origin_y));
+    args.push_back (new CLArgumentT<int> (width));
+    args.push_back (new CLArgumentT<int> (height));
+    args.push_back (new CLMemArgument (_score_buf));
+    args.push_back (new CLMemArgument (_max_score_buf));
+    XCAM_FAIL_RETURN (
+        WARNING, _score_kernel->set_arguments (args, work_size) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL, "FeatureMatch(idx:%d): corner score set arguments failed", _fm_idx);
+    ret = _score_kernel->execute (_score_kernel, false, waits);
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): corner score failed", _fm_idx);
+
+    float quality = XCAM_CL_FM_QUALITY;
+    uint32_t max_count = XCAM_CL_FM_MAX_CANDIDATES;
+    args.clear ();
+    args.push_back (new CLMemArgument (_score_buf));
+    args.push_back (new CLArgumentT<int> (width));
+    args.push_back (new CLArgumentT<int> (height));
+    args.push_back (new CLArgumentT<float> (quality));
+    args.push_back (new CLMemArgument (_max_score_buf));
+    args.push_back (new CLMemArgument (_count_buf));
+    args.push_back (new CLMemArgument (_candidate_buf));
+    args.push_back (new CLArgumentT<uint32_t> (max_count));
+    XCAM_FAIL_RETURN (
+        WARNING, _select_kernel->set_arguments (args, work_size) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL, "FeatureMatch(idx:%d): corner select set arguments failed", _fm_idx);
+    ret = _select_kernel->execute (_select_kernel, false);
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): corner select failed", _fm_idx);
+
+    uint32_t found = 0;
+    ret = _count_buf->enqueue_read (&found, 0, sizeof (found));
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): read corner count failed", _fm_idx);
+
+    if (found > XCAM_CL_FM_MAX_CANDIDATES) {
+        XCAM_LOG_DEBUG (
+            "FeatureMatch(idx:%d): %d corner candidates, only %d kept",
+            _fm_idx, found, XCAM_CL_FM_MAX_CANDIDATES);
+        found = XCAM_CL_FM_MAX_CANDIDATES;
+    }
+
+    _candidates.resize (found * 4);
+    if (found) {
+        ret = _candidate_buf->enqueue_read (&_candidates[0], 0, sizeof (float) * 4 * found);
+        XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): read corners failed", _fm_idx);
+    }
+
+    select_corners (found);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLFeatureMatch::select_corners (uint32_t count)
+{
+    std::vector<uint32_t> order (count);
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+    std::sort (order.begin (), order.end (), CandidateGreater (_candidates));
+
+    // strongest corners first, ones close to a kept corner are dropped
+    const float min_dist2 = XCAM_CL_FM_MIN_DISTANCE * XCAM_CL_FM_MIN_DISTANCE;
+    _corners.clear ();
+    for (uint32_t i = 0; i < count && _corners.size () < XCAM_CL_FM_MAX_CORNERS * 2; ++i) {
+        float x = _candidates[order[i] * 4];
+        float y = _candidates[order[i] * 4 + 1];
+
+        bool close = false;
+        for (uint32_t j = 0; j < _corners.size (); j += 2) {
+            float dx = x - _corners[j];
+            float dy = y - _corners[j + 1];
+            if (dx * dx + dy * dy < min_dist2) {
+                close = true;
+                break;
+            }
+        }
+        if (close)
+            continue;
+
+        _corners.push_back (x);
+        _corners.push_back (y);
+    }
+}
+
+XCamReturn
+CLFeatureMatch::track_corners (
+    SmartPtr<CLImage> *left, SmartPtr<CLImage> *right,
+    float *left_origin, float *right_origin, CLEventList &waits)
+{
+    int32_t count = _corners.size () / 2;
+    XCAM_ASSERT (count > 0 && count <= XCAM_CL_FM_MAX_CORNERS);
+
+    XCamReturn ret = _corner_buf->enqueue_write (&_corners[0], 0, sizeof (float) * 2 * count);
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): write corners failed", _fm_idx);
+
+    CLArgList args;
+    for (uint32_t i = 0; i < XCAM_CL_FM_LK_LEVELS; ++i)
+        args.push_back (new CLMemArgument (left[i]));
+    for (uint32_t i = 0; i < XCAM_CL_FM_LK_LEVELS; ++i)
+        args.push_back (new CLMemArgument (right[i]));
+    args.push_back (new CLArgumentTArray<float, 2> (left_origin));
+    args.push_back (new CLArgumentTArray<float, 2> (right_origin));
+    args.push_back (new CLMemArgument (_corner_buf));
+    args.push_back (new CLArgumentT<int32_t> (count));
+    args.push_back (new CLMemArgument (_tracked_buf));
+    args.push_back (new CLMemArgument (_error_buf));
+    args.push_back (new CLMemArgument (_status_buf));
+
+    // one work group a corner
+    CLWorkSize work_size;
+    work_size.dim = 1;
+    work_size.local[0] = XCAM_CL_FM_LOCAL_SIZE;
+    work_size.global[0] = count * XCAM_CL_FM_LOCAL_SIZE;
+    XCAM_FAIL_RETURN (
+        WARNING, _track_kernel->set_arguments (args, work_size) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL, "FeatureMatch(idx:%d): track set arguments failed", _fm_idx);
+    ret = _track_kernel->execute (_track_kernel, false, waits);
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): track corners failed", _fm_idx);
+
+    _tracked.resize (count * 2);
+    _errors.resize (count);
+    _status.resize (count);
+    ret = _tracked_buf->enqueue_read (&_tracked[0], 0, sizeof (float) * 2 * count);
+    if (xcam_ret_is_ok (ret))
+        ret = _error_buf->enqueue_read (&_errors[0], 0, sizeof (float) * count);
+    if (xcam_ret_is_ok (ret))
+        ret = _status_buf->enqueue_read (&_status[0], 0, sizeof (int32_t) * count);
+    XCAM_FAIL_RETURN (WARNING, xcam_ret_is_ok (ret), ret, "FeatureMatch(idx:%d): read tracked corners failed", _fm_idx);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLFeatureMatch::calc_of_match (float scale, int width)
+{
+    std::vector<float> offsets, offsets_y;
+    float sum = 0.0f, sum_y = 0.0f;
+    int count = 0;
+
+    offsets.reserve (_status.size ());
+    offsets_y.reserve (_status.size ());
+    for (uint32_t i = 0; i < _status.size (); ++i) {
+        if (!_status[i])
+            continue;
+
+        float dx = _tracked[i * 2] - _corners[i * 2];
+        float dy = _tracked[i * 2 + 1] - _corners[i * 2 + 1];
+        if (_errors[i] > _config.max_track_error)
+            continue;
+        if (fabs (dy) * scale >= _config.max_valid_offset_y)
+            continue;
+        if (_tracked[i * 2] < 0.0f || _tracked[i * 2] > width)
+            continue;
+
+        sum += dx * scale;
+        sum_y += dy * scale;
+        ++count;
+        offsets.push_back (dx * scale);
+        offsets_y.push_back (dy * scale);
+    }
+
+    float mean_offset = 0.0f;
+    int valid_count = count;
+    if (get_mean_offset (offsets, sum, valid_count, mean_offset)) {
+        if (fabs (mean_offset - _mean_offset) < _config.delta_mean_offset) {
+            _x_offset = _x_offset * _config.offset_factor + mean_offset * (1.0f - _config.offset_factor);
+            _x_offset = XCAM_CLAMP (_x_offset, -_config.max_adjusted_offset, _config.max_adjusted_offset);
+        }
+    }
+    _valid_count = valid_count;
+    _mean_offset = mean_offset;
+
+    float mean_offset_y = 0.0f;
+    valid_count = count;
+    if (get_mean_offset (offsets_y, sum_y, valid_count, mean_offset_y)) {
+        if (fabs (mean_offset_y - _mean_offset_y) < _config.delta_mean_offset) {
+            _y_offset = _y_offset * _config.offset_factor + mean_offset_y * (1.0f - _config.offset_factor);
+            _y_offset = XCAM_CLAMP (_y_offset, -_config.max_adjusted_offset, _config.max_adjusted_offset);
+        }
+    }
+    _mean_offset_y = mean_offset_y;
+}
+
+void
+CLFeatureMatch::adjust_stitch_area (int dst_width, float &x_offset, Rect &stitch0, Rect &stitch1)
+{
+    if (fabs (x_offset) < 5.0f)
+        return;
+
+    int last_overlap_width = stitch1.pos_x + stitch1.width + (dst_width - (stitch0.pos_x + stitch0.width));
+    if ((stitch0.pos_x - x_offset + stitch0.width) > dst_width)
+        x_offset = dst_width - (stitch0.pos_x + stitch0.width);
+    int final_overlap_width = last_overlap_width + x_offset;
+    final_overlap_width = XCAM_ALIGN_AROUND (final_overlap_width, 8);
+    XCAM_ASSERT (final_overlap_width >= _config.sitch_min_width);
+    int center = final_overlap_width / 2;
+    XCAM_ASSERT (center >= _config.sitch_min_width / 2);
+
+    stitch1.pos_x = XCAM_ALIGN_AROUND (center - _config.sitch_min_width / 2, 8);
+    stitch1.width = _config.sitch_min_width;
+    stitch0.pos_x = dst_width - final_overlap_width + stitch1.pos_x;
+    stitch0.width = _config.sitch_min_width;
+
+    float delta_offset = final_overlap_width - last_overlap_width;
+    x_offset -= delta_offset;
+}
+
+void
+CLFeatureMatch::optical_flow_feature_match (
+    const SmartPtr<VideoBuffer> &left_buf, const SmartPtr<VideoBuffer> &right_buf,
+    Rect &left_crop_rect, Rect &right_crop_rect, int dst_width)
+{
+    if (!_score_kernel.ptr () && !xcam_ret_is_ok (init_kernels ())) {
+        XCAM_LOG_WARNING ("FeatureMatch(idx:%d): init kernels failed", _fm_idx);
+        return;
+    }
+
+    // matches on luma decimated by (1 << scale_level), tracking needs LK levels above it
+    uint32_t base = XCAM_CLAMP (_config.scale_level, 0, XCAM_GAUSS_PYRAMID_MAX_LEVEL - XCAM_CL_FM_LK_LEVELS + 1);
+    float scale = (float)(1 << base);
+    int width = left_crop_rect.width >> base;
+    int height = left_crop_rect.height >> base;
+    if (width <= 0 || height <= 0) {
+        XCAM_LOG_WARNING (
+            "FeatureMatch(idx:%d): crop(%dx%d) too small for scale level:%d",
+            _fm_idx, left_crop_rect.width, left_crop_rect.height, base);
+        return;
+    }
+
+    SmartPtr<VideoBuffer> left = left_buf;
+    SmartPtr<VideoBuffer> right = right_buf;
+    SmartPtr<CLImage> left_levels[XCAM_CL_FM_LK_LEVELS], right_levels[XCAM_CL_FM_LK_LEVELS];
+    CLEventList left_events, right_events;
+    if (!xcam_ret_is_ok (get_levels (_left_pyramid, left, base, _left_waits, left_levels, left_events)) ||
+            !xcam_ret_is_ok (get_levels (_right_pyramid, right, base, _right_waits, right_levels, right_events)))
+        return;
+    _left_waits.clear ();
+    _right_waits.clear ();
+
+    if (!xcam_ret_is_ok (detect_corners (
+                             left_levels[0], left_crop_rect.pos_x >> base, left_crop_rect.pos_y >> base,
+                             width, height, left_events)) || _corners.empty ())
+        return;
+
+    float left_origin[2] = {left_crop_rect.pos_x / scale, left_crop_rect.pos_y / scale};
+    float right_origin[2] = {right_crop_rect.pos_x / scale, right_crop_rect.pos_y / scale};
+    if (!xcam_ret_is_ok (track_corners (left_levels, right_levels, left_origin, right_origin, right_events)))
+        return;
+
+    calc_of_match (scale, width);
+    if (_adjust_area)
+        adjust_stitch_area (dst_width, _x_offset, left_crop_rect, right_crop_rect);
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * cl_feature_match.h - CL feature match of stitching overlaps
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CL_FEATURE_MATCH_H
+#define XCAM_CL_FEATURE_MATCH_H
+
+#include <xcam_std.h>
+#include <interface/feature_match.h>
+#include <ocl/cl_context.h>
+#include <ocl/cl_kernel.h>
+#include <ocl/cl_memory.h>
+#include <ocl/cl_gauss_pyramid.h>
+
+namespace XCam {
+
+/*
+ * CLFeatureMatch, feature match on the stitcher's CL context without OpenCV.
+ * corners are detected and tracked by pyramidal Lucas-Kanade in kernels reading the
+ * gauss pyramid of whole frames, crops are kernel arguments, only corners are read back.
+ * pyramids can be shared with matchers of neighbour overlaps, one per frame.
+ * kernels share arguments with other instances, matchers must run one at a time.
+ */
+class CLFeatureMatch
+    : public FeatureMatch
+{
+public:
+    explicit CLFeatureMatch (const SmartPtr<CLContext> &context);
+
+    // pyramids of left and right frames, created on first match if not set
+    void set_pyramids (const SmartPtr<CLGaussPyramid> &left, const SmartPtr<CLGaussPyramid> &right);
+    // events producing left and right frames of next match
+    void set_wait_events (const CLEventList &left, const CLEventList &right) {
+        _left_waits = left;
+        _right_waits = right;
+    }
+    // move crops to the matched overlap as CVFeatureMatch does, for sphere view
+    void set_adjust_stitch_area (bool adjust) {
+        _adjust_area = adjust;
+    }
+
+    virtual void optical_flow_feature_match (
+        const SmartPtr<VideoBuffer> &left_buf, const SmartPtr<VideoBuffer> &right_buf,
+        Rect &left_crop_rect, Rect &right_crop_rect, int dst_width = 0);
+
+    void set_ocl (bool use_ocl) {
+        XCAM_UNUSED (use_ocl);
+    }
+    bool is_ocl_path () {
+        return true;
+    }
+
+private:
+    XCamReturn init_kernels ();
+    XCamReturn ensure_buffers (uint32_t width, uint32_t height);
+    XCamReturn get_levels (
+        SmartPtr<CLGaussPyramid> &pyramid, SmartPtr<VideoBuffer> &frame, uint32_t base,
+        const CLEventList &waits, SmartPtr<CLImage> *levels, CLEventList &events);
+    XCamReturn detect_corners (
+        const SmartPtr<CLImage> &image, int origin_x, int origin_y, int width, int height,
+        CLEventList &waits);
+    XCamReturn track_corners (
+        SmartPtr<CLImage> *left, SmartPtr<CLImage> *right,
+        float *left_origin, float *right_origin, CLEventList &waits);
+    void select_corners (uint32_t count);
+
+    void calc_of_match (float scale, int width);
+    void adjust_stitch_area (int dst_width, float &x_offset, Rect &stitch0, Rect &stitch1);
+
+    XCAM_DEAD_COPY (CLFeatureMatch);
+
+private:
+    SmartPtr<CLContext>         _context;
+    SmartPtr<CLKernel>          _score_kernel;
+    SmartPtr<CLKernel>          _select_kernel;
+    SmartPtr<CLKernel>          _track_kernel;
+    SmartPtr<CLGaussPyramid>    _left_pyramid;
+    SmartPtr<CLGaussPyramid>    _right_pyramid;
+    bool                        _adjust_area;
+    CLEventList                 _left_waits;
+    CLEventList                 _right_waits;
+
+    SmartPtr<CLBuffer>          _score_buf;
+    SmartPtr<CLBuffer>          _max_score_buf;
+    SmartPtr<CLBuffer>          _count_buf;
+    SmartPtr<CLBuffer>          _candidate_buf;
+    SmartPtr<CLBuffer>          _corner_buf;
+    SmartPtr<CLBuffer>          _tracked_buf;
+    SmartPtr<CLBuffer>          _error_buf;
+    SmartPtr<CLBuffer>          _status_buf;
+    uint32_t                    _score_size;
+
+    // scratch kept across frames, (x, y) pairs in crop of base level
+    std::vector<float>          _candidates;
+    std::vector<float>          _corners;
+    std::vector<float>          _tracked;
+    std::vector<float>          _errors;
+    std::vector<int32_t>        _status;
+};
+
+}
+
+#endif //XCAM_CL_FEATURE_MATCH_H
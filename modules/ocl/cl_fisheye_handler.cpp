@@ -128,7 +128,9 @@ CLFisheye2GPSKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     return XCAM_RETURN_NO_ERROR;
 }
 
-CLFisheyeHandler::CLFisheyeHandler (const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map, bool need_lsc, bool need_scale)
+CLFisheyeHandler::CLFisheyeHandler (
+    const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map, bool need_lsc, bool need_scale,
+    bool need_direct)
     : CLImageHandler (context, "CLFisheyeHandler")
     , _output_width (0)
     , _output_height (0)
@@ -144,8 +146,14 @@ CLFisheyeHandler::CLFisheyeHandler (const SmartPtr<CLContext> &context, Surround
     , _left_scale_factor (1.0f, 1.0f)
     , _right_scale_factor (1.0f, 1.0f)
     , _surround_mode (surround_mode)
+    , _table_dirty (true)
+    , _table_input_width (0)
+    , _table_input_height (0)
+    , _need_direct (need_direct)
 {
     xcam_mem_clear (_gray_threshold);
+    xcam_mem_clear (_direct_range);
+    xcam_mem_clear (_direct_offset);
 }
 
 CLFisheyeHandler::~CLFisheyeHandler()
@@ -157,6 +165,8 @@ CLFisheyeHandler::~CLFisheyeHandler()
 void
 CLFisheyeHandler::set_output_size (uint32_t width, uint32_t height)
 {
+    if (_output_width != width || _output_height != height)
+        _table_dirty = true;
     _output_width = width;
     _output_height = height;
 }
@@ -171,6 +181,9 @@ CLFisheyeHandler::get_output_size (uint32_t &width, uint32_t &height) const
 void
 CLFisheyeHandler::set_dst_range (float longitude, float latitude)
 {
+    if (!XCAM_DOUBLE_EQUAL_AROUND (_range_longitude, longitude) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (_range_latitude, latitude))
+        _table_dirty = true;
     _range_longitude = longitude;
     _range_latitude = latitude;
 }
@@ -185,6 +198,12 @@ CLFisheyeHandler::get_dst_range (float &longitude, float &latitude) const
 void
 CLFisheyeHandler::set_fisheye_info (const FisheyeInfo &info)
 {
+    if (!XCAM_DOUBLE_EQUAL_AROUND (_fisheye_info.center_x, info.center_x) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (_fisheye_info.center_y, info.center_y) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (_fisheye_info.wide_angle, info.wide_angle) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (_fisheye_info.radius, info.radius) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (_fisheye_info.rotate_angle, info.rotate_angle))
+        _table_dirty = true;
     _fisheye_info = info;
 }
 
@@ -198,6 +217,7 @@ CLFisheyeHandler::set_lsc_table (float *table, uint32_t table_size)
     _lsc_array = (float *) xcam_malloc0 (_lsc_array_size * sizeof (float));
     XCAM_ASSERT (_lsc_array);
     memcpy (_lsc_array, table, _lsc_array_size * sizeof (float));
+    _lsc_table.release ();
 }
 
 void
@@ -225,6 +245,53 @@ CLFisheyeHandler::set_right_scale_factor (PointFloat2 factor)
     _right_scale_factor = factor;
 }
 
+bool
+CLFisheyeHandler::set_direct_output (
+    const SmartPtr<VideoBuffer> &buf, const int32_t range[3], const int32_t offset[2])
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _need_direct && _use_map, false,
+        "CLFisheyeHandler(%s) was not created with direct output", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, range[0] <= range[1] && range[1] <= range[2], false,
+        "CLFisheyeHandler direct range(%d, %d, %d) is not in order", range[0], range[1], range[2]);
+
+    for (int i = 0; i < NV12PlaneMax; ++i)
+        _direct_output[i].release ();
+    xcam_mem_clear (_direct_range);
+    if (!buf.ptr () || range[0] == range[2])
+        return true;
+
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<VideoBuffer> out_buf = buf;
+    const VideoBufferInfo &info = out_buf->get_video_info ();
+    CLImageDesc cl_desc;
+    cl_desc.format.image_channel_data_type = CL_UNSIGNED_INT16;
+    cl_desc.format.image_channel_order = CL_RGBA;
+    cl_desc.width = XCAM_ALIGN_DOWN (info.width, 8) / 8;
+    cl_desc.height = XCAM_ALIGN_DOWN (info.height, 2);
+    cl_desc.row_pitch = info.strides[NV12PlaneYIdx];
+    _direct_output[NV12PlaneYIdx] = convert_to_climage (context, out_buf, cl_desc, info.offsets[NV12PlaneYIdx]);
+    cl_desc.height /= 2;
+    cl_desc.row_pitch = info.strides[NV12PlaneUVIdx];
+    _direct_output[NV12PlaneUVIdx] = convert_to_climage (context, out_buf, cl_desc, info.offsets[NV12PlaneUVIdx]);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _direct_output[NV12PlaneYIdx].ptr () && _direct_output[NV12PlaneYIdx]->is_valid () &&
+        _direct_output[NV12PlaneUVIdx].ptr () && _direct_output[NV12PlaneUVIdx]->is_valid (),
+        false, "CLFisheyeHandler convert direct output buffer to cl image failed");
+
+    for (int i = 0; i < 3; ++i) {
+        XCAM_ASSERT (XCAM_ALIGN_DOWN (range[i], 8) == range[i]);
+        _direct_range[i] = range[i];
+    }
+    for (int i = 0; i < 2; ++i) {
+        XCAM_ASSERT (XCAM_ALIGN_DOWN (offset[i], 8) == offset[i]);
+        _direct_offset[i] = offset[i];
+    }
+    return true;
+}
+
 XCamReturn
 CLFisheyeHandler::prepare_buffer_pool_video_info (
     const VideoBufferInfo &input,
@@ -305,12 +372,25 @@ CLFisheyeHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vid
         _output[NV12PlaneYIdx].ptr () && _output[NV12PlaneYIdx]->is_valid () &&
         _output[NV12PlaneUVIdx].ptr () && _output[NV12PlaneUVIdx]->is_valid ());
 
-    if (_use_map && !_geo_table.ptr ()) {
-        generate_fisheye_table (input_image_w, input_image_h, _fisheye_info);
+    if (_use_map && (_table_dirty || !_geo_table.ptr () ||
+                     _table_input_width != input_image_w || _table_input_height != input_image_h)) {
+        XCamReturn ret = generate_fisheye_table (input_image_w, input_image_h, _fisheye_info);
+        XCAM_FAIL_RETURN (
+            WARNING, xcam_ret_is_ok (ret), ret,
+            "CLFisheyeHandler generate fisheye table failed");
+
+        _table_dirty = false;
+        _table_input_width = input_image_w;
+        _table_input_height = input_image_h;
+        _lsc_table.release ();
     }
 
-    if (!_lsc_table.ptr () && _need_lsc)
-        generate_lsc_table (input_image_w, input_image_h, _fisheye_info);
+    if (_use_map && _need_lsc && !_lsc_table.ptr ()) {
+        XCamReturn ret = generate_lsc_table (input_image_w, input_image_h, _fisheye_info);
+        XCAM_FAIL_RETURN (
+            WARNING, xcam_ret_is_ok (ret), ret,
+            "CLFisheyeHandler generate lsc table failed");
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -509,7 +589,6 @@ CLFisheyeHandler::generate_lsc_table (
     SmartPtr<CLBuffer> array_buf = new CLBuffer (
         context, _lsc_array_size * sizeof (float),
         CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, _lsc_array);
-    xcam_free (_lsc_array);
 
     CLImageDesc desc = _geo_table->get_image_desc ();
     _lsc_table = create_cl_image (desc.width, desc.height, CL_R, CL_FLOAT);
@@ -555,7 +634,9 @@ CLFisheyeHandler::execute_done (SmartPtr<VideoBuffer> &output)
     for (int i = 0; i < NV12PlaneMax; ++i) {
         _input[i].release ();
         _output[i].release ();
+        _direct_output[i].release ();
     }
+    xcam_mem_clear (_direct_range);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -595,6 +676,21 @@ CLFisheyeHandler::get_lsc_gray_threshold () {
     return _gray_threshold;
 }
 
+SmartPtr<CLImage>
+CLFisheyeHandler::get_geo_direct_output_image (NV12PlaneIdx index) {
+    XCAM_ASSERT (index < NV12PlaneMax);
+    return _direct_output[index];
+}
+
+void
+CLFisheyeHandler::get_geo_direct_range (int32_t range[3], int32_t offset[2])
+{
+    for (int i = 0; i < 3; ++i)
+        range[i] = _direct_range[i] / 8;
+    for (int i = 0; i < 2; ++i)
+        offset[i] = _direct_offset[i] / 8;
+}
+
 static SmartPtr<CLImageKernel>
 create_fishey_gps_kernel (const SmartPtr<CLContext> &context, SmartPtr<CLFisheyeHandler> handler)
 {
@@ -603,20 +699,27 @@ create_fishey_gps_kernel (const SmartPtr<CLContext> &context, SmartPtr<CLFisheye
     XCAM_FAIL_RETURN (
         ERROR, kernel->build_kernel (kernel_fisheye_info[KernelFisheye2GPS], NULL) == XCAM_RETURN_NO_ERROR,
         NULL, "build fisheye kernel failed");
+    kernel->set_work_size_tunable (true);
     return kernel;
 }
 
 SmartPtr<CLImageHandler>
-create_fisheye_handler (const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map, bool need_lsc, bool need_scale)
+create_fisheye_handler (
+    const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map,
+    bool need_lsc, bool need_scale, bool need_direct)
 {
     SmartPtr<CLFisheyeHandler> handler;
     SmartPtr<CLImageKernel> kernel;
 
-    handler = new CLFisheyeHandler (context, surround_mode, use_map, need_lsc, need_scale);
+    XCAM_FAIL_RETURN (
+        ERROR, use_map || !need_direct, NULL,
+        "Fisheye handler direct output needs geo map table");
+
+    handler = new CLFisheyeHandler (context, surround_mode, use_map, need_lsc, need_scale, need_direct);
     XCAM_ASSERT (handler.ptr ());
 
     if (use_map) {
-        kernel = create_geo_map_kernel (context, handler, need_lsc, need_scale);
+        kernel = create_geo_map_kernel (context, handler, need_lsc, need_scale, need_direct);
     } else {
         kernel = create_fishey_gps_kernel (context, handler);
     }
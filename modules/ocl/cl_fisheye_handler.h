@@ -49,7 +49,9 @@ class CLFisheyeHandler
 {
     friend class CLFisheye2GPSKernel;
 public:
-    explicit CLFisheyeHandler (const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map, bool need_lsc, bool need_scale);
+    explicit CLFisheyeHandler (
+        const SmartPtr<CLContext> &context, SurroundMode surround_mode, bool use_map, bool need_lsc, bool need_scale,
+        bool need_direct = false);
     virtual ~CLFisheyeHandler();
 
     void set_output_size (uint32_t width, uint32_t height);
@@ -82,6 +84,7 @@ public:
 
     void set_bowl_config(const BowlDataConfig bowl_data_config) {
         _bowl_data_config = bowl_data_config;
+        _table_dirty = true;
     }
 
     const BowlDataConfig &get_bowl_config() {
@@ -90,6 +93,7 @@ public:
 
     void set_intrinsic_param(const IntrinsicParameter intrinsic_param) {
         _intrinsic_param = intrinsic_param;
+        _table_dirty = true;
     }
     const IntrinsicParameter &get_intrinsic_param() {
         return _intrinsic_param;
@@ -97,11 +101,19 @@ public:
 
     void set_extrinsic_param(const ExtrinsicParameter extrinsic_param) {
         _extrinsic_param = extrinsic_param;
+        _table_dirty = true;
     }
     const ExtrinsicParameter &get_extrinsic_param() {
         return _extrinsic_param;
     }
 
+    /*
+     * handler created with need_direct only, set after prepare_parameters and used by the coming execution.
+     * output columns [range[0], range[2]) go to @buf at x + offset[0] before range[1],
+     * at x + offset[1] from range[1], all in pixels aligned to 8; others still go to handler output.
+     */
+    bool set_direct_output (const SmartPtr<VideoBuffer> &buf, const int32_t range[3], const int32_t offset[2]);
+
 
 protected:
     // derived from CLImageHandler
@@ -122,6 +134,9 @@ protected:
     virtual SmartPtr<CLImage> get_lsc_table ();
     virtual float* get_lsc_gray_threshold ();
 
+    virtual SmartPtr<CLImage> get_geo_direct_output_image (NV12PlaneIdx index);
+    virtual void get_geo_direct_range (int32_t range[3], int32_t offset[2]);
+
 private:
     SmartPtr<CLImage> &get_input_image (NV12PlaneIdx index) {
         XCAM_ASSERT (index < NV12PlaneMax);
@@ -169,14 +184,25 @@ private:
 
     SurroundMode                     _surround_mode;
 
+    // geo table is generated once and kept until a mapping parameter or input size changes
     SmartPtr<CLImage>                _geo_table;
     SmartPtr<CLImage>                _lsc_table;
+    bool                             _table_dirty;
+    uint32_t                         _table_input_width;
+    uint32_t                         _table_input_height;
     SmartPtr<CLImage>                _input[NV12PlaneMax];
     SmartPtr<CLImage>                _output[NV12PlaneMax];
+
+    bool                             _need_direct;
+    int32_t                          _direct_range[3];
+    int32_t                          _direct_offset[2];
+    SmartPtr<CLImage>                _direct_output[NV12PlaneMax];
 };
 
 SmartPtr<CLImageHandler>
-create_fisheye_handler (const SmartPtr<CLContext> &context, SurroundMode surround_mode = SphereView, bool use_map = false, bool need_lsc = false, bool need_scale = false);
+create_fisheye_handler (
+    const SmartPtr<CLContext> &context, SurroundMode surround_mode = SphereView, bool use_map = true,
+    bool need_lsc = false, bool need_scale = false, bool need_direct = false);
 
 }
 
@@ -27,10 +27,59 @@
 
 namespace XCam {
 
-const static XCamKernelInfo kernel_gauss_info = {
-    "kernel_gauss",
+enum {
+    KernelGaussH = 0,
+    KernelGaussV,
+    KernelGaussIIRH,
+    KernelGaussIIRV,
+};
+
+const static XCamKernelInfo kernel_gauss_info[] = {
+    {
+        "kernel_gauss_h",
+#include "kernel_gauss.clx"
+        , 0,
+    },
+    {
+        "kernel_gauss_v",
+#include "kernel_gauss.clx"
+        , 0,
+    },
+    {
+        "kernel_gauss_iir_h",
+#include "kernel_gauss.clx"
+        , 0,
+    },
+    {
+        "kernel_gauss_iir_v",
 #include "kernel_gauss.clx"
-    , 0,
+        , 0,
+    },
+};
+
+// work group sizes of separable passes, same as kernel_gauss.cl
+#define XCAM_GAUSS_H_LOCAL_X 16
+#define XCAM_GAUSS_H_LOCAL_Y 4
+#define XCAM_GAUSS_V_LOCAL_X 8
+#define XCAM_GAUSS_V_LOCAL_Y 16
+
+class CLGaussVerticalKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLGaussVerticalKernel (const SmartPtr<CLContext> &context, CLGaussImageKernel *gauss)
+        : CLImageKernel (context, "kernel_gauss_v")
+        , _gauss (gauss)
+    {}
+
+protected:
+    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size) {
+        return _gauss->prepare_vertical_arguments (args, work_size);
+    }
+
+private:
+    // owner of this pass, outlives it
+    CLGaussImageKernel  *_gauss;
 };
 
 class CLGaussImageKernelImpl
@@ -74,7 +123,11 @@ CLGaussImageKernel::CLGaussImageKernel (
     : CLImageKernel (context, "kernel_gauss")
     , _g_radius (radius)
     , _g_table (NULL)
+    , _recursive (radius > XCAM_GAUSS_SEPARABLE_MAX_RADIUS)
+    , _tmp_width (0)
+    , _tmp_height (0)
 {
+    xcam_mem_clear (_iir_coeffs);
     set_gaussian(radius, sigma);
 }
 
@@ -86,10 +139,14 @@ CLGaussImageKernel::~CLGaussImageKernel ()
 bool
 CLGaussImageKernel::set_gaussian (uint32_t radius, float sigma)
 {
-    uint32_t i, j;
+    uint32_t i;
     uint32_t scale = XCAM_GAUSS_SCALE (radius);
     float dis = 0.0f, sum = 0.0f;
-    uint32_t scale_size = scale * scale * sizeof (_g_table[0]);
+    uint32_t scale_size = scale * sizeof (_g_table[0]);
+
+    XCAM_FAIL_RETURN (
+        WARNING, !is_valid () || radius == _g_radius, false,
+        "gauss kernel radius(%d) can not change to %d once built", _g_radius, radius);
 
     xcam_free (_g_table);
     _g_table_buffer.release ();
@@ -97,15 +154,14 @@ CLGaussImageKernel::set_gaussian (uint32_t radius, float sigma)
     _g_table = (float*) xcam_malloc0 (scale_size);
     XCAM_ASSERT (_g_table);
 
+    // 2D window normalized over the square is the outer product of this one
     for(i = 0; i < scale; i++)  {
-        for(j = 0; j < scale; j++) {
-            dis = ((float)i - radius) * ((float)i - radius) + ((float)j - radius) * ((float)j - radius);
-            _g_table[i * scale + j] = exp(-dis / (2.0f * sigma * sigma));
-            sum += _g_table[i * scale + j];
-        }
+        dis = ((float)i - radius) * ((float)i - radius);
+        _g_table[i] = exp(-dis / (2.0f * sigma * sigma));
+        sum += _g_table[i];
     }
 
-    for(i = 0; i < scale * scale; i++) {
+    for(i = 0; i < scale; i++) {
         _g_table[i] = _g_table[i] / sum;
     }
 
@@ -113,25 +169,63 @@ CLGaussImageKernel::set_gaussian (uint32_t radius, float sigma)
         get_context (), scale_size,
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR , _g_table);
 
+    // Young / van Vliet recursive gauss coefficients, normalized by b0
+    float s = XCAM_MAX (sigma, 0.5f);
+    float q = (s >= 2.5f) ? (0.98711f * s - 0.96330f) : (3.97156f - 4.14554f * sqrtf (1.0f - 0.26891f * s));
+    float q2 = q * q, q3 = q2 * q;
+    float b0 = 1.57825f + 2.44413f * q + 1.4281f * q2 + 0.422205f * q3;
+    _iir_coeffs[1] = (2.44413f * q + 2.85619f * q2 + 1.26661f * q3) / b0;
+    _iir_coeffs[2] = -(1.4281f * q2 + 1.26661f * q3) / b0;
+    _iir_coeffs[3] = 0.422205f * q3 / b0;
+    _iir_coeffs[0] = 1.0f - (_iir_coeffs[1] + _iir_coeffs[2] + _iir_coeffs[3]);
+
     return true;
 }
 
+XCamReturn
+CLGaussImageKernel::build_gauss_kernels ()
+{
+    char build_options[1024];
+    xcam_mem_clear (build_options);
+    snprintf (build_options, sizeof (build_options), " -DGAUSS_RADIUS=%d ", _g_radius);
+
+    const XCamKernelInfo &info_h = kernel_gauss_info[_recursive ? KernelGaussIIRH : KernelGaussH];
+    const XCamKernelInfo &info_v = kernel_gauss_info[_recursive ? KernelGaussIIRV : KernelGaussV];
+
+    XCAM_FAIL_RETURN (
+        ERROR, build_kernel (info_h, build_options) == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_CL,
+        "build gaussian kernel(%s) failed", info_h.kernel_name);
+
+    _v_kernel = new CLGaussVerticalKernel (get_context (), this);
+    XCAM_FAIL_RETURN (
+        ERROR, _v_kernel->build_kernel (info_v, build_options) == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_CL,
+        "build gaussian kernel(%s) failed", info_v.kernel_name);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLGaussImageKernel::set_gauss_enable (bool enable)
+{
+    set_enable (enable);
+    if (_v_kernel.ptr ())
+        _v_kernel->set_enable (enable);
+}
+
 XCamReturn
 CLGaussImageKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
 {
     SmartPtr<CLContext> context = get_context ();
     SmartPtr<VideoBuffer> input = get_input_buf ();
-    SmartPtr<VideoBuffer> output = get_output_buf ();
 
     XCAM_FAIL_RETURN (
         WARNING,
-        input.ptr () && output.ptr (),
+        input.ptr (),
         XCAM_RETURN_ERROR_MEM,
-        "cl image kernel(%s) get input/output buffer failed", get_kernel_name ());
+        "cl image kernel(%s) get input buffer failed", get_kernel_name ());
 
     const VideoBufferInfo & video_info_in = input->get_video_info ();
-    const VideoBufferInfo & video_info_out = output->get_video_info ();
-    CLImageDesc cl_desc_in, cl_desc_out;
+    CLImageDesc cl_desc_in;
 
     cl_desc_in.format.image_channel_data_type = CL_UNORM_INT8;
     cl_desc_in.format.image_channel_order = CL_R;
@@ -140,6 +234,64 @@ CLGaussImageKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     cl_desc_in.row_pitch = video_info_in.strides[0];
     SmartPtr<CLImage> image_in = convert_to_climage (context, input, cl_desc_in, video_info_in.offsets[0]);
 
+    XCAM_FAIL_RETURN (
+        WARNING,
+        image_in->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in memory not available", get_kernel_name ());
+
+    // horizontal result, kept till resolution changes
+    uint32_t width = XCAM_ALIGN_DOWN (video_info_in.width, 4);
+    uint32_t height = video_info_in.height;
+    if (!_tmp_buf.ptr () || _tmp_width != width || _tmp_height != height) {
+        _tmp_buf = new CLBuffer (context, width * height * sizeof (float));
+        XCAM_FAIL_RETURN (
+            WARNING, _tmp_buf->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "cl image kernel(%s) create temp buffer(%dx%d) failed", get_kernel_name (), width, height);
+        _tmp_width = width;
+        _tmp_height = height;
+    }
+
+    //set args;
+    args.push_back (new CLMemArgument (image_in));
+    args.push_back (new CLMemArgument (_tmp_buf));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)width));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)height));
+
+    if (_recursive) {
+        args.push_back (new CLArgumentTArray<float, 4> (_iir_coeffs));
+
+        work_size.dim = 1;
+        work_size.global[0] = height;
+        work_size.local[0] = 0;
+    } else {
+        args.push_back (new CLMemArgument (_g_table_buffer));
+
+        work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+        work_size.local[0] = XCAM_GAUSS_H_LOCAL_X;
+        work_size.local[1] = XCAM_GAUSS_H_LOCAL_Y;
+        work_size.global[0] = XCAM_ALIGN_UP (width / 4, XCAM_GAUSS_H_LOCAL_X);
+        work_size.global[1] = XCAM_ALIGN_UP (height, XCAM_GAUSS_H_LOCAL_Y);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLGaussImageKernel::prepare_vertical_arguments (CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<VideoBuffer> output = get_output_buf ();
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        output.ptr () && _tmp_buf.ptr (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) get output buffer failed", _v_kernel->get_kernel_name ());
+
+    const VideoBufferInfo & video_info_out = output->get_video_info ();
+    CLImageDesc cl_desc_out;
+
     cl_desc_out.format.image_channel_data_type = CL_UNORM_INT8;
     cl_desc_out.format.image_channel_order = CL_RGBA;
     cl_desc_out.width = video_info_out.width / 4;
@@ -149,20 +301,30 @@ CLGaussImageKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
 
     XCAM_FAIL_RETURN (
         WARNING,
-        image_in->is_valid () && image_out->is_valid (),
+        image_out->is_valid (),
         XCAM_RETURN_ERROR_MEM,
-        "cl image kernel(%s) in/out memory not available", get_kernel_name ());
+        "cl image kernel(%s) out memory not available", _v_kernel->get_kernel_name ());
 
-    //set args;
-    args.push_back (new CLMemArgument (image_in));
+    args.push_back (new CLMemArgument (_tmp_buf));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)_tmp_width));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)_tmp_height));
     args.push_back (new CLMemArgument (image_out));
-    args.push_back (new CLMemArgument (_g_table_buffer));
 
-    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
-    work_size.global[0] = XCAM_ALIGN_UP(cl_desc_out.width, 8);
-    work_size.global[1] = XCAM_ALIGN_UP (cl_desc_out.height / 2, 4);
-    work_size.local[0] = 8;
-    work_size.local[1] = 4;
+    if (_recursive) {
+        args.push_back (new CLArgumentTArray<float, 4> (_iir_coeffs));
+
+        work_size.dim = 1;
+        work_size.global[0] = _tmp_width / 4;
+        work_size.local[0] = 0;
+    } else {
+        args.push_back (new CLMemArgument (_g_table_buffer));
+
+        work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+        work_size.local[0] = XCAM_GAUSS_V_LOCAL_X;
+        work_size.local[1] = XCAM_GAUSS_V_LOCAL_Y;
+        work_size.global[0] = XCAM_ALIGN_UP (_tmp_width / 4, XCAM_GAUSS_V_LOCAL_X);
+        work_size.global[1] = XCAM_ALIGN_UP (_tmp_height, XCAM_GAUSS_V_LOCAL_Y);
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -184,6 +346,7 @@ CLGaussImageHandler::set_gauss_kernel(SmartPtr<CLGaussImageKernel> &kernel)
 {
     SmartPtr<CLImageKernel> image_kernel = kernel;
     add_kernel (image_kernel);
+    add_kernel (kernel->get_vertical_kernel ());
     _gauss_kernel = kernel;
     return true;
 }
@@ -193,17 +356,13 @@ create_cl_gauss_image_handler (const SmartPtr<CLContext> &context, uint32_t radi
 {
     SmartPtr<CLGaussImageHandler> gauss_handler;
     SmartPtr<CLGaussImageKernel> gauss_kernel;
-    char build_options[1024];
-
-    xcam_mem_clear (build_options);
-    snprintf (build_options, sizeof (build_options), " -DGAUSS_RADIUS=%d ", radius);
 
     gauss_handler = new CLGaussImageHandler (context, "cl_handler_gauss");
     gauss_kernel = new CLGaussImageKernelImpl (gauss_handler, context, radius, sigma);
     XCAM_ASSERT (gauss_kernel.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, gauss_kernel->build_kernel (kernel_gauss_info, build_options) == XCAM_RETURN_NO_ERROR, NULL,
-        "build gaussian kernel(%s) failed", kernel_gauss_info.kernel_name);
+        ERROR, gauss_kernel->build_gauss_kernels () == XCAM_RETURN_NO_ERROR, NULL,
+        "build gaussian kernels of radius(%d) failed", radius);
 
     XCAM_ASSERT (gauss_kernel->is_valid ());
     gauss_handler->set_gauss_kernel (gauss_kernel);
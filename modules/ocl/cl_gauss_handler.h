@@ -28,18 +28,40 @@
 
 #define XCAM_GAUSS_DEFAULT_RADIUS 2
 #define XCAM_GAUSS_DEFAULT_SIGMA 2.0f
+#define XCAM_GAUSS_SEPARABLE_MAX_RADIUS 16
 
 namespace XCam {
 
+class CLGaussVerticalKernel;
+
+/*
+ * gauss window as separable horizontal and vertical passes, radius is fixed once built.
+ * radius larger than XCAM_GAUSS_SEPARABLE_MAX_RADIUS switches to recursive gauss,
+ * whose cost does not grow with sigma.
+ */
 class CLGaussImageKernel
     : public CLImageKernel
 {
+    friend class CLGaussVerticalKernel;
+
 public:
     explicit CLGaussImageKernel (
         const SmartPtr<CLContext> &context, uint32_t radius, float sigma);
     virtual ~CLGaussImageKernel ();
     bool set_gaussian(uint32_t radius, float sigma);
 
+    // builds horizontal pass as this kernel and vertical pass
+    XCamReturn build_gauss_kernels ();
+    // vertical pass, need be added to handler right after this kernel
+    SmartPtr<CLImageKernel> &get_vertical_kernel () {
+        return _v_kernel;
+    }
+    bool is_recursive () const {
+        return _recursive;
+    }
+    // enable or disable both passes
+    void set_gauss_enable (bool enable);
+
 protected:
     virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
 
@@ -47,10 +69,21 @@ protected:
     virtual SmartPtr<VideoBuffer> get_input_buf () = 0;
     virtual SmartPtr<VideoBuffer> get_output_buf () = 0;
 
+private:
+    XCamReturn prepare_vertical_arguments (CLArgList &args, CLWorkSize &work_size);
+
 protected:
     SmartPtr<CLBuffer>    _g_table_buffer;
     uint32_t              _g_radius;
     float                *_g_table;
+
+private:
+    bool                     _recursive;
+    float                    _iir_coeffs[4];
+    SmartPtr<CLImageKernel>  _v_kernel;
+    SmartPtr<CLBuffer>       _tmp_buf;
+    uint32_t                 _tmp_width;
+    uint32_t                 _tmp_height;
 };
 
 class CLGaussImageHandler
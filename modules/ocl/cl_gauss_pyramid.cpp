@@ -0,0 +1,190 @@
+/*
+ * cl_gauss_pyramid.cpp - CL gauss pyramid shared by handlers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_utils.h"
+#include "cl_gauss_pyramid.h"
+#include "cl_context.h"
+
+namespace XCam {
+
+const static XCamKernelInfo kernel_gauss_pyramid_info = {
+    "kernel_gauss_pyramid_down",
+#include "kernel_gauss.clx"
+    , 0,
+};
+
+CLGaussPyramid::CLGaussPyramid (const SmartPtr<CLContext> &context)
+    : _context (context)
+    , _width (0)
+    , _height (0)
+    , _built (0)
+{
+    XCAM_ASSERT (context.ptr ());
+}
+
+void
+CLGaussPyramid::invalidate ()
+{
+    SmartLock locker (_mutex);
+    _frame.release ();
+    _built = 0;
+    for (uint32_t i = 0; i <= XCAM_GAUSS_PYRAMID_MAX_LEVEL; ++i)
+        _events[i].release ();
+}
+
+XCamReturn
+CLGaussPyramid::reset_frame (const SmartPtr<VideoBuffer> &frame)
+{
+    const VideoBufferInfo &info = frame->get_video_info ();
+
+    _frame = frame;
+    _built = 0;
+    for (uint32_t i = 0; i <= XCAM_GAUSS_PYRAMID_MAX_LEVEL; ++i)
+        _events[i].release ();
+
+    if (info.width == _width && info.height == _height)
+        return XCAM_RETURN_NO_ERROR;
+
+    if (!_down_kernel.ptr ()) {
+        SmartPtr<CLKernel> kernel = new CLKernel (_context, "kernel_gauss_pyramid_down");
+        XCAM_FAIL_RETURN (
+            ERROR, kernel->build_kernel (kernel_gauss_pyramid_info, NULL) == XCAM_RETURN_NO_ERROR,
+            XCAM_RETURN_ERROR_CL, "gauss pyramid build kernel(%s) failed", kernel_gauss_pyramid_info.kernel_name);
+        _down_kernel = kernel;
+    }
+
+    CLImageDesc desc;
+    desc.format.image_channel_data_type = CL_UNORM_INT8;
+    desc.format.image_channel_order = CL_R;
+    desc.width = info.width;
+    desc.height = info.height;
+    for (uint32_t i = 1; i <= XCAM_GAUSS_PYRAMID_MAX_LEVEL; ++i) {
+        desc.width = XCAM_MAX ((desc.width + 1) / 2, 1u);
+        desc.height = XCAM_MAX ((desc.height + 1) / 2, 1u);
+        _levels[i] = new CLImage2D (_context, desc);
+        XCAM_FAIL_RETURN (
+            ERROR, _levels[i]->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "gauss pyramid allocate level(%d) %dx%d failed", i, (uint32_t)desc.width, (uint32_t)desc.height);
+    }
+
+    _width = info.width;
+    _height = info.height;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLGaussPyramid::build_level (
+    SmartPtr<VideoBuffer> &frame, uint32_t level,
+    const CLEventList &waits, const SmartPtr<CLCommandQueue> &queue)
+{
+    XCAM_ASSERT (level >= 1 && level <= XCAM_GAUSS_PYRAMID_MAX_LEVEL);
+
+    SmartPtr<CLImage> input = _levels[level - 1];
+    if (level == 1) {
+        const VideoBufferInfo &info = frame->get_video_info ();
+        CLImageDesc desc;
+        desc.format.image_channel_data_type = CL_UNORM_INT8;
+        desc.format.image_channel_order = CL_R;
+        desc.width = info.width;
+        desc.height = info.height;
+        desc.row_pitch = info.strides[0];
+        input = convert_to_climage (_context, frame, desc, info.offsets[0]);
+    }
+    SmartPtr<CLImage> &output = _levels[level];
+    XCAM_FAIL_RETURN (
+        ERROR, input.ptr () && input->is_valid (), XCAM_RETURN_ERROR_MEM,
+        "gauss pyramid level(%d) input is invalid", level - 1);
+
+    CLArgList args;
+    args.push_back (new CLMemArgument (input));
+    args.push_back (new CLMemArgument (output));
+
+    const CLImageDesc &out_desc = output->get_image_desc ();
+    CLWorkSize work_size;
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 4;
+    work_size.global[0] = XCAM_ALIGN_UP (out_desc.width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (out_desc.height, work_size.local[1]);
+
+    XCAM_FAIL_RETURN (
+        ERROR, _down_kernel->set_arguments (args, work_size) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL, "gauss pyramid level(%d) set arguments failed", level);
+
+    // each level waits on the one below, level 1 on the frame producers
+    CLEventList events;
+    if (level == 1)
+        events = waits;
+    else if (_events[level - 1].ptr () && _events[level - 1]->get_event_id ())
+        events.push_back (_events[level - 1]);
+
+    SmartPtr<CLEvent> event = new CLEvent;
+    XCamReturn ret = _down_kernel->execute (_down_kernel, false, events, event, queue);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "gauss pyramid level(%d) execute kernel failed", level);
+
+    _events[level] = event;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLGaussPyramid::get_level (
+    SmartPtr<VideoBuffer> &frame, uint32_t level, SmartPtr<CLImage> &image,
+    const CLEventList &waits, SmartPtr<CLEvent> &done_event,
+    const SmartPtr<CLCommandQueue> &queue)
+{
+    done_event.release ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, frame.ptr () && level <= XCAM_GAUSS_PYRAMID_MAX_LEVEL, XCAM_RETURN_ERROR_PARAM,
+        "gauss pyramid get level(%d) failed, max level:%d", level, XCAM_GAUSS_PYRAMID_MAX_LEVEL);
+
+    const VideoBufferInfo &info = frame->get_video_info ();
+    if (level == 0) {
+        CLImageDesc desc;
+        desc.format.image_channel_data_type = CL_UNORM_INT8;
+        desc.format.image_channel_order = CL_R;
+        desc.width = info.width;
+        desc.height = info.height;
+        desc.row_pitch = info.strides[0];
+        image = convert_to_climage (_context, frame, desc, info.offsets[0]);
+        return image.ptr () ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_MEM;
+    }
+
+    SmartLock locker (_mutex);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_frame.ptr () != frame.ptr ()) {
+        ret = reset_frame (frame);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "gauss pyramid reset frame failed");
+    }
+
+    for (uint32_t i = _built + 1; i <= level; ++i) {
+        ret = build_level (frame, i, waits, queue);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "gauss pyramid build level(%d) failed", i);
+        _built = i;
+    }
+
+    image = _levels[level];
+    done_event = _events[level];
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
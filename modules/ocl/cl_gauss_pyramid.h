@@ -0,0 +1,81 @@
+/*
+ * cl_gauss_pyramid.h - CL gauss pyramid shared by handlers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CL_GAUSS_PYRAMID_H
+#define XCAM_CL_GAUSS_PYRAMID_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <video_buffer.h>
+#include <ocl/cl_memory.h>
+#include <ocl/cl_kernel.h>
+#include <ocl/cl_event.h>
+
+#define XCAM_GAUSS_PYRAMID_MAX_LEVEL 6
+
+namespace XCam {
+
+class CLCommandQueue;
+
+/*
+ * luma gauss pyramid of the current frame, level 0 is the input Y plane,
+ * level n is 1/2^n resolution and built on first request of the frame.
+ * handlers processing the same frame share one build.
+ * the last frame stays referenced till the next frame or invalidate ().
+ */
+class CLGaussPyramid
+{
+public:
+    explicit CLGaussPyramid (const SmartPtr<CLContext> &context);
+
+    /*
+     * image is CL_R CL_UNORM_INT8, consumer kernels must wait on done_event.
+     * a build waits on @waits, the events the frame is produced by, and runs on @queue.
+     */
+    XCamReturn get_level (
+        SmartPtr<VideoBuffer> &frame, uint32_t level, SmartPtr<CLImage> &image,
+        const CLEventList &waits, SmartPtr<CLEvent> &done_event,
+        const SmartPtr<CLCommandQueue> &queue = NULL);
+    void invalidate ();
+
+private:
+    XCamReturn reset_frame (const SmartPtr<VideoBuffer> &frame);
+    XCamReturn build_level (
+        SmartPtr<VideoBuffer> &frame, uint32_t level,
+        const CLEventList &waits, const SmartPtr<CLCommandQueue> &queue);
+
+    XCAM_DEAD_COPY (CLGaussPyramid);
+
+private:
+    SmartPtr<CLContext>        _context;
+    SmartPtr<CLKernel>         _down_kernel;
+    SmartPtr<CLImage>          _levels[XCAM_GAUSS_PYRAMID_MAX_LEVEL + 1];
+    SmartPtr<CLEvent>          _events[XCAM_GAUSS_PYRAMID_MAX_LEVEL + 1];
+    uint32_t                   _width;
+    uint32_t                   _height;
+
+    SmartPtr<VideoBuffer>      _frame;
+    uint32_t                   _built;
+    Mutex                      _mutex;
+};
+
+}
+
+#endif //XCAM_CL_GAUSS_PYRAMID_H
@@ -34,11 +34,13 @@ static const XCamKernelInfo kernel_geo_map_info = {
 #define GEO_MAP_CHANNEL 4  /* only use channel_0, channel_1 */
 
 CLGeoMapKernel::CLGeoMapKernel (
-    const SmartPtr<CLContext> &context, const SmartPtr<GeoKernelParamCallback> handler, bool need_lsc, bool need_scale)
+    const SmartPtr<CLContext> &context, const SmartPtr<GeoKernelParamCallback> handler,
+    bool need_lsc, bool need_scale, bool need_direct)
     : CLImageKernel (context)
     , _handler (handler)
     , _need_lsc (need_lsc)
     , _need_scale (need_scale)
+    , _need_direct (need_direct)
 {
     XCAM_ASSERT (handler.ptr ());
 }
@@ -88,6 +90,25 @@ CLGeoMapKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     args.push_back (new CLMemArgument (output_uv));
     args.push_back (new CLArgumentTArray<float, 2> (out_size));
 
+    if (_need_direct) {
+        SmartPtr<CLImage> direct_y = _handler->get_geo_direct_output_image (NV12PlaneYIdx);
+        SmartPtr<CLImage> direct_uv = _handler->get_geo_direct_output_image (NV12PlaneUVIdx);
+        int32_t range[4] = {0, 0, 0, 0};
+        int32_t offset[2];
+        _handler->get_geo_direct_range (range, offset);
+
+        // nothing goes direct this frame, output images stand in for the unused arguments
+        if (!direct_y.ptr () || !direct_uv.ptr ()) {
+            direct_y = output_y;
+            direct_uv = output_uv;
+            range[0] = range[1] = range[2] = 0;
+        }
+        args.push_back (new CLMemArgument (direct_y));
+        args.push_back (new CLMemArgument (direct_uv));
+        args.push_back (new CLArgumentTArray<int32_t, 4> (range));
+        args.push_back (new CLArgumentTArray<int32_t, 2> (offset));
+    }
+
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.local[0] = 16;
     work_size.local[1] = 4;
@@ -330,18 +351,21 @@ CLGeoMapHandler::execute_done (SmartPtr<VideoBuffer> &output)
 
 SmartPtr<CLImageKernel>
 create_geo_map_kernel (
-    const SmartPtr<CLContext> &context, SmartPtr<GeoKernelParamCallback> param_cb, bool need_lsc, bool need_scale)
+    const SmartPtr<CLContext> &context, SmartPtr<GeoKernelParamCallback> param_cb,
+    bool need_lsc, bool need_scale, bool need_direct)
 {
     SmartPtr<CLImageKernel> kernel;
-    kernel = new CLGeoMapKernel (context, param_cb, need_lsc, need_scale);
+    kernel = new CLGeoMapKernel (context, param_cb, need_lsc, need_scale, need_direct);
     XCAM_ASSERT (kernel.ptr ());
 
     char build_options[1024];
-    snprintf (build_options, sizeof(build_options), "-DENABLE_LSC=%d -DENABLE_SCALE=%d", need_lsc ? 1 : 0, need_scale ? 1 : 0);
+    snprintf (build_options, sizeof(build_options), "-DENABLE_LSC=%d -DENABLE_SCALE=%d -DENABLE_DIRECT_OUT=%d",
+              need_lsc ? 1 : 0, need_scale ? 1 : 0, need_direct ? 1 : 0);
     XCAM_FAIL_RETURN (
         ERROR, kernel->build_kernel (kernel_geo_map_info, build_options) == XCAM_RETURN_NO_ERROR,
         NULL, "build geo map kernel failed");
 
+    kernel->set_work_size_tunable (true);
     return kernel;
 }
 
@@ -56,6 +56,16 @@ protected:
     virtual PointFloat2 get_right_scale_factor () = 0;
 
     virtual float get_stable_y_start () = 0;
+
+    // kernels built with direct output only, range and offsets in output texels
+    virtual SmartPtr<CLImage> get_geo_direct_output_image (NV12PlaneIdx index) {
+        XCAM_UNUSED (index);
+        return NULL;
+    }
+    virtual void get_geo_direct_range (int32_t range[3], int32_t offset[2]) {
+        range[0] = range[1] = range[2] = 0;
+        offset[0] = offset[1] = 0;
+    }
 private:
     XCAM_DEAD_COPY (GeoKernelParamCallback);
 };
@@ -68,7 +78,7 @@ public:
     explicit CLGeoMapKernel (
         const SmartPtr<CLContext> &context,
         const SmartPtr<GeoKernelParamCallback> handler,
-        bool need_lsc, bool need_scale);
+        bool need_lsc, bool need_scale, bool need_direct = false);
 
 protected:
     virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
@@ -77,6 +87,7 @@ private:
     SmartPtr<GeoKernelParamCallback>   _handler;
     bool                               _need_lsc;
     bool                               _need_scale;
+    bool                               _need_direct;
 };
 
 class CLGeoMapHandler
@@ -171,7 +182,8 @@ private:
 
 SmartPtr<CLImageKernel>
 create_geo_map_kernel (
-    const SmartPtr<CLContext> &context, SmartPtr<GeoKernelParamCallback> param_cb, bool need_lsc, bool need_scale);
+    const SmartPtr<CLContext> &context, SmartPtr<GeoKernelParamCallback> param_cb,
+    bool need_lsc, bool need_scale, bool need_direct = false);
 
 SmartPtr<CLImageHandler>
 create_geo_map_handler (const SmartPtr<CLContext> &context, bool need_lsc = false, bool need_scale = false);
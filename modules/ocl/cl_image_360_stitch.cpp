@@ -20,12 +20,15 @@
 
 #include "cl_utils.h"
 #include "cl_image_360_stitch.h"
+#include "cl_feature_match.h"
 #if HAVE_OPENCV
 #include "cv_feature_match.h"
 #include "cv_feature_match_cluster.h"
 #endif
 
 #define XCAM_BLENDER_GLOBAL_SCALE_EXT_WIDTH 64
+// columns next to an overlap still go through intermediates, pyramid taps and feature match read beyond merge area
+#define XCAM_STITCH_DIRECT_GUARD 16
 
 #define STITCH_CHECK(ret, msg, ...) \
     if ((ret) != XCAM_RETURN_NO_ERROR) {        \
@@ -109,7 +112,6 @@ CLBlenderGlobalScaleKernel::get_output_info (
     return true;
 }
 
-#if HAVE_OPENCV
 static CVFMConfig
 get_fm_default_config (StitchResMode res_mode)
 {
@@ -159,7 +161,6 @@ get_fm_default_config (StitchResMode res_mode)
 
     return config;
 }
-#endif
 
 static StitchInfo
 get_default_stitch_info (StitchResMode res_mode)
@@ -273,9 +274,10 @@ get_default_stitch_info (StitchResMode res_mode)
 
 CLImage360Stitch::CLImage360Stitch (
     const SmartPtr<CLContext> &context, CLBlenderScaleMode scale_mode, SurroundMode surround_mode,
-    StitchResMode res_mode, int fisheye_num, bool all_in_one_img)
+    StitchResMode res_mode, int fisheye_num, bool all_in_one_img, bool direct_output)
     : CLMultiImageHandler (context, "CLImage360Stitch")
     , _context (context)
+    , _fm_native (true)
     , _output_width (0)
     , _output_height (0)
     , _scale_mode (scale_mode)
@@ -284,19 +286,45 @@ CLImage360Stitch::CLImage360Stitch (
     , _is_stitch_inited (false)
     , _fisheye_num (fisheye_num)
     , _all_in_one_img (all_in_one_img)
+    , _direct_output (direct_output && scale_mode == CLBlenderScaleLocal)
 {
 #if HAVE_OPENCV
+    // OpenCV matchers by default, env XCAM_CL_FEATURE_MATCH=1 selects CLFeatureMatch
+    const char *env = std::getenv ("XCAM_CL_FEATURE_MATCH");
+    _fm_native = env && !strcmp (env, "1");
+#endif
+
+    for (int i = 0; i < fisheye_num && _fm_native; i++)
+        _fm_pyramid[i] = new CLGaussPyramid (context);
+
     for (int i = 0; i < fisheye_num; i++) {
-        if (_surround_mode == SphereView) {
+        if (_fm_native) {
+            SmartPtr<CLFeatureMatch> matcher = new CLFeatureMatch (context);
+            matcher->set_pyramids (_fm_pyramid[i], _fm_pyramid[(i + 1) % fisheye_num]);
+            matcher->set_adjust_stitch_area (_surround_mode == SphereView);
+            _feature_match[i] = matcher;
+        }
+#if HAVE_OPENCV
+        else if (_surround_mode == SphereView) {
             _feature_match[i] = new CVFeatureMatch ();
         } else {
             _feature_match[i] = new CVFeatureMatchCluster ();
         }
+#endif
         XCAM_ASSERT (_feature_match[i].ptr ());
         _feature_match[i]->set_config (get_fm_default_config (res_mode));
         _feature_match[i]->set_fm_index (i);
     }
-#endif
+
+    // CLFeatureMatch kernels share arguments, native matchers run one by one
+    if (fisheye_num > 1 && !_fm_native) {
+        _fm_pool = new ThreadPool ("CLImage360StitchFM");
+        _fm_pool->set_threads (fisheye_num, fisheye_num);
+        if (!xcam_ret_is_ok (_fm_pool->start ())) {
+            XCAM_LOG_WARNING ("CLImage360Stitch feature match thread pool start failed, match serially");
+            _fm_pool.release ();
+        }
+    }
 }
 
 bool
@@ -378,17 +406,11 @@ CLImage360Stitch::set_image_overlap (const int idx, const Rect &overlap0, const
 void
 CLImage360Stitch::set_feature_match_ocl (bool fm_ocl)
 {
-#if HAVE_OPENCV
     for (int i = 0; i < _fisheye_num; i++) {
         _feature_match[i]->set_ocl (fm_ocl);
     }
-#else
-    XCAM_UNUSED (fm_ocl);
-    XCAM_LOG_WARNING ("non-OpenCV mode, failed to set ocl for feature match");
-#endif
 }
 
-#if HAVE_OPENCV
 void
 CLImage360Stitch::init_feature_match_config ()
 {
@@ -421,7 +443,6 @@ CLImage360Stitch::get_feature_match_config (const int idx)
 {
     return _feature_match[idx]->get_config ();
 }
-#endif
 
 void
 CLImage360Stitch::calc_fisheye_initial_info (SmartPtr<VideoBuffer> &output)
@@ -751,7 +772,7 @@ CLImage360Stitch::create_buffer_pool (SmartPtr<BufferPool> &buf_pool, uint32_t w
     SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
     XCAM_ASSERT (pool.ptr ());
     pool->set_video_info (buf_info);
-    if (!pool->reserve (6)) {
+    if (!xcam_ret_is_ok (pool->reserve (6))) {
         XCAM_LOG_ERROR ("CLImage360Stitch init buffer pool failed");
         return false;
     }
@@ -782,14 +803,68 @@ CLImage360Stitch::reset_buffer_info (SmartPtr<VideoBuffer> &input)
     return XCAM_RETURN_NO_ERROR;
 }
 
+/*
+ * copy kernels of blender i move columns of image i right of its middle and columns of
+ * image i+1 left of its middle into output; fisheye kernels take those over here,
+ * blender copy areas shrink to guard bands next to the merge areas.
+ */
+XCamReturn
+CLImage360Stitch::prepare_direct_output (SmartPtr<VideoBuffer> &output)
+{
+    int32_t left_start[XCAM_STITCH_FISHEYE_MAX_NUM], left_offset[XCAM_STITCH_FISHEYE_MAX_NUM];
+    int32_t right_end[XCAM_STITCH_FISHEYE_MAX_NUM], right_offset[XCAM_STITCH_FISHEYE_MAX_NUM];
+    int32_t middle[XCAM_STITCH_FISHEYE_MAX_NUM];
+
+    int idx_next = 1;
+    for (int i = 0; i < _fisheye_num; i++) {
+        idx_next = (i == (_fisheye_num - 1)) ? 0 : (i + 1);
+        const Rect &window = _blender[i]->get_merge_window ();
+
+        Rect area = _blender[i]->get_input_valid_area (0);
+        const Rect &merge0 = _blender[i]->get_input_merge_area (0);
+        int32_t end = merge0.pos_x - XCAM_STITCH_DIRECT_GUARD;
+        middle[i] = area.pos_x;
+        right_end[i] = area.pos_x;
+        right_offset[i] = 0;
+        if (end > area.pos_x) {
+            right_end[i] = end;
+            right_offset[i] = window.pos_x - merge0.pos_x;
+            area.width = area.pos_x + area.width - end;
+            area.pos_x = end;
+            _blender[i]->set_input_valid_area (area, 0);
+        }
+
+        area = _blender[i]->get_input_valid_area (1);
+        const Rect &merge1 = _blender[i]->get_input_merge_area (1);
+        int32_t start = merge1.pos_x + merge1.width + XCAM_STITCH_DIRECT_GUARD;
+        left_start[idx_next] = area.pos_x + area.width;
+        left_offset[idx_next] = 0;
+        if (start < area.pos_x + area.width) {
+            left_start[idx_next] = start;
+            left_offset[idx_next] = window.pos_x + window.width - (merge1.pos_x + merge1.width);
+            area.width = start - area.pos_x;
+            _blender[i]->set_input_valid_area (area, 1);
+        }
+    }
+
+    for (int i = 0; i < _fisheye_num; i++) {
+        XCAM_ASSERT (left_start[i] <= middle[i]);
+        int32_t range[3] = {left_start[i], middle[i], right_end[i]};
+        int32_t offset[2] = {left_offset[i], right_offset[i]};
+        XCAM_FAIL_RETURN (
+            ERROR, _fisheye[i].handler->set_direct_output (output, range, offset),
+            XCAM_RETURN_ERROR_PARAM, "CLImage360Stitch set fisheye(%d) direct output failed", i);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLImage360Stitch::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     if (!_is_stitch_inited) {
-#if HAVE_OPENCV
         init_feature_match_config ();
-#endif
         set_stitch_info (get_default_stitch_info (_res_mode));
     }
 
@@ -811,6 +886,11 @@ CLImage360Stitch::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vid
             STITCH_CHECK (ret, "blender: execute ensure_parameters failed");
             _fisheye[i].buf->detach_buffer (_fisheye[idx_next].buf);
         }
+
+        if (_direct_output) {
+            ret = prepare_direct_output (output);
+            STITCH_CHECK (ret, "prepare direct output failed");
+        }
     } else { //global scale
         const VideoBufferInfo &buf_info = output->get_video_info ();
         if (!_scale_buf_pool.ptr ())
@@ -844,14 +924,12 @@ CLImage360Stitch::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vid
 XCamReturn
 CLImage360Stitch::execute_done (SmartPtr<VideoBuffer> &output)
 {
-#if HAVE_OPENCV
     for (int i = 0; i < _fisheye_num; i++) {
         if (!_feature_match[i]->is_ocl_path ()) {
             get_context ()->finish ();
             break;
         }
     }
-#endif
 
     _scale_global_input.release ();
     _scale_global_output.release ();
@@ -880,43 +958,115 @@ convert_to_xcam_rect (Rect stitch_rect, Rect &xcam_rect)
     xcam_rect.width = stitch_rect.width;
 }
 
+class FMTaskGroup
+{
+public:
+    explicit FMTaskGroup (uint32_t count)
+        : _pending (count)
+    {}
+
+    void finish_one () {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (_pending > 0);
+        if (--_pending == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_pending > 0)
+            _cond.wait (_mutex);
+    }
+
+private:
+    uint32_t     _pending;
+    Mutex        _mutex;
+    Cond         _cond;
+};
+
+class FMTask
+    : public ThreadPool::UserData
+{
+public:
+    FMTask (
+        const SmartPtr<FMTaskGroup> &group, const SmartPtr<FeatureMatch> &matcher,
+        const SmartPtr<VideoBuffer> &left_buf, const SmartPtr<VideoBuffer> &right_buf,
+        Rect *crop_left, Rect *crop_right, int dst_width)
+        : _group (group)
+        , _matcher (matcher)
+        , _left_buf (left_buf)
+        , _right_buf (right_buf)
+        , _crop_left (crop_left)
+        , _crop_right (crop_right)
+        , _dst_width (dst_width)
+    {}
+
+    virtual XCamReturn run () {
+        _matcher->optical_flow_feature_match (_left_buf, _right_buf, *_crop_left, *_crop_right, _dst_width);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn err) {
+        XCAM_UNUSED (err);
+        _group->finish_one ();
+    }
+
+private:
+    SmartPtr<FMTaskGroup>    _group;
+    SmartPtr<FeatureMatch>   _matcher;
+    SmartPtr<VideoBuffer>    _left_buf;
+    SmartPtr<VideoBuffer>    _right_buf;
+    Rect                    *_crop_left;
+    Rect                    *_crop_right;
+    int                      _dst_width;
+};
+
 
 XCamReturn
 CLImage360Stitch::sub_handler_execute_done (SmartPtr<CLImageHandler> &handler)
 {
-#if HAVE_OPENCV
     XCAM_ASSERT (handler.ptr ());
 
     if (handler.ptr () == _fisheye[_fisheye_num - 1].handler.ptr ()) {
         int idx_next = 1;
-        Rect crop_left, crop_right;
+        Rect crop_left[XCAM_STITCH_FISHEYE_MAX_NUM], crop_right[XCAM_STITCH_FISHEYE_MAX_NUM];
+        Rect match_left[XCAM_STITCH_FISHEYE_MAX_NUM], match_right[XCAM_STITCH_FISHEYE_MAX_NUM];
 
+        // overlaps are independent, match them in parallel and apply results in order
+        SmartPtr<FMTaskGroup> group = new FMTaskGroup (_fisheye_num);
         for (int i = 0; i < _fisheye_num; i++) {
             idx_next = (i == (_fisheye_num - 1)) ? 0 : (i + 1);
 
-            convert_to_stitch_rect (_img_merge_info[i].right, crop_left, _surround_mode);
-            convert_to_stitch_rect (_img_merge_info[idx_next].left, crop_right, _surround_mode);
-            if (_surround_mode == SphereView) {
-                _feature_match[i]->optical_flow_feature_match (
-                    _fisheye[i].buf, _fisheye[idx_next].buf, crop_left, crop_right, _fisheye[i].width);
+            convert_to_stitch_rect (_img_merge_info[i].right, crop_left[i], _surround_mode);
+            convert_to_stitch_rect (_img_merge_info[idx_next].left, crop_right[i], _surround_mode);
+            match_left[i] = crop_left[i];
+            match_right[i] = crop_right[i];
+            if (_surround_mode != SphereView)
+                _feature_match[i]->reset_offsets ();
+            if (_fm_native) {
+                SmartPtr<CLFeatureMatch> matcher = _feature_match[i].dynamic_cast_ptr<CLFeatureMatch> ();
+                matcher->set_wait_events (
+                    _fisheye[i].handler->get_done_events (), _fisheye[idx_next].handler->get_done_events ());
+            }
 
-                convert_to_xcam_rect (crop_left, _img_merge_info[i].right);
-                convert_to_xcam_rect (crop_right, _img_merge_info[idx_next].left);
-            } else {
-                Rect tmp_crop_left = crop_left;
-                Rect tmp_crop_right = crop_right;
+            SmartPtr<FMTask> task = new FMTask (
+                group, _feature_match[i], _fisheye[i].buf, _fisheye[idx_next].buf,
+                &match_left[i], &match_right[i], _fisheye[i].width);
+            if (!_fm_pool.ptr () || !xcam_ret_is_ok (_fm_pool->queue (task))) {
+                task->done (task->run ());
+            }
+        }
+        group->wait ();
 
-                _feature_match[i]->reset_offsets ();
-                _feature_match[i]->optical_flow_feature_match (
-                    _fisheye[i].buf, _fisheye[idx_next].buf, tmp_crop_left, tmp_crop_right, _fisheye[i].width);
+        for (int i = 0; i < _fisheye_num; i++) {
+            idx_next = (i == (_fisheye_num - 1)) ? 0 : (i + 1);
 
-                update_scale_factors (i, crop_left, crop_right);
+            if (_surround_mode == SphereView) {
+                convert_to_xcam_rect (match_left[i], _img_merge_info[i].right);
+                convert_to_xcam_rect (match_right[i], _img_merge_info[idx_next].left);
+            } else {
+                update_scale_factors (i, crop_left[i], crop_right[i]);
             }
         }
     }
-#else
-    XCAM_UNUSED (handler);
-#endif
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -952,20 +1102,26 @@ SmartPtr<CLImageHandler>
 create_image_360_stitch (
     const SmartPtr<CLContext> &context, bool need_seam,
     CLBlenderScaleMode scale_mode, bool fisheye_map, bool need_lsc, SurroundMode surround_mode,
-    StitchResMode res_mode, int fisheye_num, bool all_in_one_img)
+    StitchResMode res_mode, int fisheye_num, bool all_in_one_img, bool direct_output)
 {
     const int layer = 2;
     const bool need_uv = true;
     SmartPtr<CLFisheyeHandler> fisheye;
     SmartPtr<CLBlender> blender;
+    if (direct_output && (!fisheye_map || scale_mode != CLBlenderScaleLocal)) {
+        XCAM_LOG_WARNING ("image_360_stitch direct output needs fisheye map and local scale, disabled");
+        direct_output = false;
+    }
+
     SmartPtr<CLImage360Stitch> stitch = new CLImage360Stitch (
-        context, scale_mode, surround_mode, res_mode, fisheye_num, all_in_one_img);
+        context, scale_mode, surround_mode, res_mode, fisheye_num, all_in_one_img, direct_output);
     XCAM_ASSERT (stitch.ptr ());
 
     bool need_scale = (surround_mode == BowlView) ? true : false;
 
     for (int index = 0; index < fisheye_num; ++index) {
-        fisheye = create_fisheye_handler (context, surround_mode, fisheye_map, need_lsc, need_scale).dynamic_cast_ptr<CLFisheyeHandler> ();
+        fisheye = create_fisheye_handler (
+                      context, surround_mode, fisheye_map, need_lsc, need_scale, direct_output).dynamic_cast_ptr<CLFisheyeHandler> ();
         XCAM_FAIL_RETURN (ERROR, fisheye.ptr (), NULL, "image_360_stitch create fisheye handler failed");
         fisheye->disable_buf_pool (true);
         stitch->set_fisheye_handler (fisheye, index);
@@ -27,6 +27,8 @@
 #include <ocl/cl_multi_image_handler.h>
 #include <ocl/cl_fisheye_handler.h>
 #include <ocl/cl_blender.h>
+#include <ocl/cl_gauss_pyramid.h>
+#include <thread_pool.h>
 
 namespace XCam {
 
@@ -64,7 +66,7 @@ class CLImage360Stitch
 public:
     explicit CLImage360Stitch (
         const SmartPtr<CLContext> &context, CLBlenderScaleMode scale_mode, SurroundMode surround_mode,
-        StitchResMode res_mode, int fisheye_num, bool all_in_one_img);
+        StitchResMode res_mode, int fisheye_num, bool all_in_one_img, bool direct_output = false);
 
     bool set_stitch_info (StitchInfo stitch_info);
     StitchInfo get_stitch_info ();
@@ -95,11 +97,9 @@ public:
     }
 
     void set_feature_match_ocl (bool use_ocl);
-#if HAVE_OPENCV
     void init_feature_match_config ();
     void set_feature_match_config (const int idx, CVFMConfig config);
     CVFMConfig get_feature_match_config (const int idx);
-#endif
 
 protected:
     virtual XCamReturn prepare_buffer_pool_video_info (const VideoBufferInfo &input, VideoBufferInfo &output);
@@ -115,6 +115,7 @@ protected:
 
     bool create_buffer_pool (SmartPtr<BufferPool> &buf_pool, uint32_t width, uint32_t height);
     XCamReturn reset_buffer_info (SmartPtr<VideoBuffer> &input);
+    XCamReturn prepare_direct_output (SmartPtr<VideoBuffer> &output);
 
     virtual XCamReturn sub_handler_execute_done (SmartPtr<CLImageHandler> &handler);
 
@@ -130,6 +131,11 @@ private:
     CLFisheyeParams             _fisheye[XCAM_STITCH_FISHEYE_MAX_NUM];
     SmartPtr<CLBlender>         _blender[XCAM_STITCH_FISHEYE_MAX_NUM];
     SmartPtr<FeatureMatch>      _feature_match[XCAM_STITCH_FISHEYE_MAX_NUM];
+    // overlaps are matched in parallel, one thread each, OpenCV matchers only
+    SmartPtr<ThreadPool>        _fm_pool;
+    // CLFeatureMatch matchers, luma pyramid of each fisheye shared by its two overlaps
+    bool                        _fm_native;
+    SmartPtr<CLGaussPyramid>    _fm_pyramid[XCAM_STITCH_FISHEYE_MAX_NUM];
 
     uint32_t                    _output_width;
     uint32_t                    _output_height;
@@ -147,6 +153,8 @@ private:
     bool                        _is_stitch_inited;
     int                         _fisheye_num;
     bool                        _all_in_one_img;
+    // fisheye kernels write columns away from overlaps straight into output, local scale only
+    bool                        _direct_output;
     StitchInfo                  _stitch_info;
 };
 
@@ -155,12 +163,13 @@ create_image_360_stitch (
     const SmartPtr<CLContext> &context,
     bool need_seam = false,
     CLBlenderScaleMode scale_mode = CLBlenderScaleLocal,
-    bool fisheye_map = false,
+    bool fisheye_map = true,
     bool need_lsc = false,
     SurroundMode surround_mode = SphereView,
     StitchResMode res_mode = StitchRes1080P,
     int fisheye_num = 2,
-    bool all_in_one_img = true);
+    bool all_in_one_img = true,
+    bool direct_output = false);
 
 }
 
@@ -26,7 +26,11 @@
 #endif
 #include "cl_device.h"
 #include "cl_video_buffer.h"
+#include "cl_utils.h"
 #include "swapped_buffer.h"
+#include "xcam_trace.h"
+#include "frame_latency.h"
+#include "memory_accounting.h"
 
 namespace XCam {
 
@@ -35,6 +39,8 @@ namespace XCam {
 CLImageKernel::CLImageKernel (const SmartPtr<CLContext> &context, const char *name, bool enable)
     : CLKernel (context, name)
     , _enable (enable)
+    , _roi_block_x (0)
+    , _roi_block_y (0)
 {
 }
 
@@ -62,6 +68,21 @@ CLImageKernel::pre_execute ()
         ERROR, !is_arguments_set (), XCAM_RETURN_ERROR_PARAM,
         "cl image kernel(%s) pre_execute failed since arguments was set somewhere", get_kernel_name ());
 
+    if (get_arg_slot_count ()) {
+        ret = bind_arguments (work_size);
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR, ret,
+            "cl image kernel(%s) bind arguments failed", get_kernel_name ());
+
+        ret = commit_arg_slots (work_size);
+        XCAM_FAIL_RETURN (
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR, ret,
+            "cl image kernel(%s) commit argument slots failed", get_kernel_name ());
+        return ret;
+    }
+
     ret = prepare_arguments (args, work_size);
     XCAM_FAIL_RETURN (
         WARNING,
@@ -90,6 +111,16 @@ CLImageKernel::prepare_arguments (
     return XCAM_RETURN_ERROR_CL;
 }
 
+XCamReturn
+CLImageKernel::bind_arguments (CLWorkSize &work_size)
+{
+    XCAM_UNUSED (work_size);
+
+    XCAM_LOG_ERROR (
+        "cl image kernel(%s) declared argument slots but bind_arguments was not derived", get_kernel_name ());
+    return XCAM_RETURN_ERROR_CL;
+}
+
 CLImageHandler::CLImageHandler (const SmartPtr<CLContext> &context, const char *name)
     : _name (NULL)
     , _enable (true)
@@ -100,11 +131,20 @@ CLImageHandler::CLImageHandler (const SmartPtr<CLContext> &context, const char *
     , _buf_swap_flags ((uint32_t)(SwappedBuffer::OrderY0Y1) | (uint32_t)(SwappedBuffer::OrderUV0UV1))
     , _buf_swap_init_order (SwappedBuffer::OrderY0Y1)
     , _result_timestamp (XCam::InvalidTimestamp)
+    , _roi_active (false)
+    , _event_batching (false)
+    , _batch_frame (false)
+    , _mem_owner (MemoryAccounting::RootOwner)
+    , _mem_parent (UINT32_MAX)
 {
     XCAM_ASSERT (name);
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
 
+    const char *env = std::getenv ("XCAM_CL_EVENT_BATCH");
+    if (env && !strcmp (env, "1"))
+        _event_batching = true;
+
     XCAM_OBJ_PROFILING_INIT;
 }
 
@@ -142,6 +182,17 @@ CLImageHandler::enable_buf_pool_swap_flags (
 #endif
 }
 
+bool
+CLImageHandler::set_buffer_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_buf_pool.ptr (), false,
+        "CLImageHandler(%s) set buffer pool failed, output already started", XCAM_STR (_name));
+
+    _ext_buf_pool = pool;
+    return true;
+}
+
 bool
 CLImageHandler::add_kernel (const SmartPtr<CLImageKernel> &kernel)
 {
@@ -201,7 +252,7 @@ CLImageHandler::create_buffer_pool (const VideoBufferInfo &video_info)
     _buf_pool->set_video_info (video_info);
     XCAM_FAIL_RETURN(
         WARNING,
-        _buf_pool->reserve (_buf_pool_size),
+        xcam_ret_is_ok (_buf_pool->reserve (_buf_pool_size)),
         XCAM_RETURN_ERROR_CL,
         "CLImageHandler(%s) failed to init drm buffer pool", XCAM_STR (_name));
 
@@ -273,12 +324,25 @@ CLImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<Video
             ret,
             "CLImageHandler(%s) prepare output video info failed", XCAM_STR (_name));
 
-        ret = create_buffer_pool (output_video_info);
-        XCAM_FAIL_RETURN(
-            WARNING,
-            ret == XCAM_RETURN_NO_ERROR,
-            ret,
-            "CLImageHandler(%s) ensure drm buffer pool failed", XCAM_STR (_name));
+        if (_ext_buf_pool.ptr ()) {
+            const VideoBufferInfo &pool_info = _ext_buf_pool->get_video_info ();
+            XCAM_FAIL_RETURN (
+                WARNING,
+                pool_info.format == output_video_info.format &&
+                pool_info.width == output_video_info.width && pool_info.height == output_video_info.height,
+                XCAM_RETURN_ERROR_PARAM,
+                "CLImageHandler(%s) external buffer pool(%s, %dx%d) doesn't match output(%s, %dx%d)",
+                XCAM_STR (_name), xcam_fourcc_to_string (pool_info.format), pool_info.width, pool_info.height,
+                xcam_fourcc_to_string (output_video_info.format), output_video_info.width, output_video_info.height);
+            _buf_pool = _ext_buf_pool;
+        } else {
+            ret = create_buffer_pool (output_video_info);
+            XCAM_FAIL_RETURN(
+                WARNING,
+                ret == XCAM_RETURN_NO_ERROR,
+                ret,
+                "CLImageHandler(%s) ensure drm buffer pool failed", XCAM_STR (_name));
+        }
     }
 
     output = _buf_pool->get_buffer (_buf_pool);
@@ -291,6 +355,7 @@ CLImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<Video
     // TODO, need consider output is not sync up with input buffer
     output->set_timestamp (input->get_timestamp ());
     output->copy_attaches (input);
+    FrameLatencyMeta::carry (input, output);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -301,9 +366,11 @@ CLImageHandler::emit_stop ()
     for (KernelList::iterator i_kernel = _kernels.begin ();
             i_kernel != _kernels.end ();  ++i_kernel) {
         (*i_kernel)->pre_stop ();
+        (*i_kernel)->release_arg_slots ();
     }
 
-    if (_buf_pool.ptr ())
+    // external pool is stopped by its owner
+    if (_buf_pool.ptr () && !_ext_buf_pool.ptr ())
         _buf_pool->stop ();
 }
 
@@ -337,8 +404,12 @@ CLImageHandler::execute_kernel (SmartPtr<CLImageKernel> &kernel)
             XCAM_STR (_name), kernel->get_kernel_name ());
     }
 
+    uint32_t block_x = 0, block_y = 0;
+    if (_roi_active && kernel->get_roi_block (block_x, block_y))
+        return execute_kernel_rois (kernel);
+
     CLArgList args = kernel->get_args ();
-    ret = kernel->execute (kernel, false);
+    ret = launch_kernel (kernel);
     XCAM_FAIL_RETURN (
         WARNING, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS, ret,
         "cl_image_handler(%s) execute kernel(%s) failed",
@@ -357,6 +428,172 @@ CLImageHandler::execute_kernel (SmartPtr<CLImageKernel> &kernel)
     return ret;
 }
 
+/*
+ * item range of one dimension covering pixels [begin, end), aligned to work group
+ * and clipped by full frame global size.
+ */
+static bool
+get_roi_range (
+    int32_t begin, int32_t end, uint32_t block,
+    size_t local, size_t global, size_t &offset, size_t &count)
+{
+    if (!local)
+        local = 1;
+
+    begin = XCAM_MAX (begin, 0);
+    if (end <= begin)
+        return false;
+
+    size_t first = begin / block / local * local;
+    size_t last = (end + block - 1) / block;
+    last = XCAM_MIN ((last + local - 1) / local * local, global);
+    if (last <= first)
+        return false;
+
+    offset = first;
+    count = last - first;
+    return true;
+}
+
+XCamReturn
+CLImageHandler::execute_kernel_rois (SmartPtr<CLImageKernel> &kernel)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    uint32_t block_x = 0, block_y = 0;
+    kernel->get_roi_block (block_x, block_y);
+
+    // execute clears arguments, keep them for the rest ROIs
+    CLArgList args = kernel->get_args ();
+    const CLWorkSize full_size = kernel->get_work_size ();
+    XCAM_ASSERT (full_size.dim >= 2);
+
+    std::vector<CLWorkSize> roi_sizes;
+    for (size_t i = 0; i < _roi_list.size (); ++i) {
+        const Rect &roi = _roi_list[i];
+        CLWorkSize work_size = full_size;
+        if (!get_roi_range (
+                    roi.pos_x, roi.pos_x + roi.width, block_x,
+                    full_size.local[0], full_size.global[0], work_size.offset[0], work_size.global[0]) ||
+                !get_roi_range (
+                    roi.pos_y, roi.pos_y + roi.height, block_y,
+                    full_size.local[1], full_size.global[1], work_size.offset[1], work_size.global[1]))
+            continue;
+
+        work_size.offset[0] += full_size.offset[0];
+        work_size.offset[1] += full_size.offset[1];
+        roi_sizes.push_back (work_size);
+    }
+
+    // output out of ROIs was copied, but nothing left to launch, keep full frame correct
+    if (roi_sizes.empty ()) {
+        XCAM_LOG_DEBUG (
+            "cl_image_handler(%s) kernel(%s) ROIs out of frame, process full frame",
+            XCAM_STR (_name), kernel->get_kernel_name ());
+        roi_sizes.push_back (full_size);
+    }
+
+    for (size_t i = 0; i < roi_sizes.size (); ++i) {
+        if (i == 0)
+            ret = kernel->set_work_size (roi_sizes[i]);
+        else if (kernel->get_arg_slot_count ())
+            ret = kernel->commit_arg_slots (roi_sizes[i]);
+        else
+            ret = kernel->set_arguments (args, roi_sizes[i]);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "cl_image_handler(%s) set ROI(%d) work size of kernel(%s) failed",
+            XCAM_STR (_name), (int)i, kernel->get_kernel_name ());
+
+        ret = launch_kernel (kernel);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS, ret,
+            "cl_image_handler(%s) execute kernel(%s) over ROI(%d) failed",
+            XCAM_STR (_name), kernel->get_kernel_name (), (int)i);
+    }
+
+    return ret;
+}
+
+XCamReturn
+CLImageHandler::launch_kernel (SmartPtr<CLImageKernel> &kernel)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    // batched launch waits on chain events only as the first one, the queue orders the rest
+    if (_batch_frame) {
+        ret = kernel->execute (kernel, false, _chain_events, CLEvent::NullEvent, _cmd_queue);
+        if (ret == XCAM_RETURN_NO_ERROR)
+            _chain_events.clear ();
+        return ret;
+    }
+
+    SmartPtr<CLEvent> kernel_event = new CLEvent;
+    ret = kernel->execute (kernel, false, _chain_events, kernel_event, _cmd_queue);
+    if (ret == XCAM_RETURN_NO_ERROR && kernel_event->get_event_id ()) {
+        _chain_events.clear ();
+        _chain_events.push_back (kernel_event);
+        _last_event = kernel_event;
+    }
+    return ret;
+}
+
+XCamReturn
+CLImageHandler::prepare_roi (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    _roi_active = false;
+    if (_roi_list.empty ())
+        return XCAM_RETURN_NO_ERROR;
+
+    uint32_t block_x = 0, block_y = 0;
+    bool roi_kernel = false;
+    for (KernelList::iterator i_kernel = _kernels.begin ();
+            i_kernel != _kernels.end (); ++i_kernel) {
+        if ((*i_kernel)->is_enabled () && (*i_kernel)->get_roi_block (block_x, block_y))
+            roi_kernel = true;
+    }
+    if (!roi_kernel)
+        return XCAM_RETURN_NO_ERROR;
+
+    if (input.ptr () == output.ptr ()) {
+        _roi_active = true;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    const VideoBufferInfo &in_info = input->get_video_info ();
+    const VideoBufferInfo &out_info = output->get_video_info ();
+    bool same_layout = (in_info.format == out_info.format &&
+                        in_info.width == out_info.width && in_info.height == out_info.height &&
+                        in_info.size == out_info.size);
+    for (uint32_t i = 0; same_layout && i < in_info.components; ++i) {
+        same_layout = (in_info.strides[i] == out_info.strides[i] && in_info.offsets[i] == out_info.offsets[i]);
+    }
+    if (!same_layout) {
+        XCAM_LOG_DEBUG ("cl_image_handler(%s) input and output differ, ROI ignored", XCAM_STR (_name));
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    SmartPtr<CLBuffer> in_buf = convert_to_clbuffer (_context, input);
+    SmartPtr<CLBuffer> out_buf = convert_to_clbuffer (_context, output);
+    if (!in_buf.ptr () || !out_buf.ptr () || !in_buf->is_valid () || !out_buf->is_valid ()) {
+        XCAM_LOG_DEBUG ("cl_image_handler(%s) can NOT copy output out of ROI, ROI ignored", XCAM_STR (_name));
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    // whole frame copy is simple and cheap, ROI kernels overwrite their rectangles after it
+    SmartPtr<CLEvent> copy_event = new CLEvent;
+    XCamReturn ret = in_buf->enqueue_copy (out_buf, 0, 0, in_info.size, _chain_events, copy_event);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl_image_handler(%s) copy input out of ROI failed", XCAM_STR (_name));
+
+    if (copy_event->get_event_id ()) {
+        _chain_events.clear ();
+        _chain_events.push_back (copy_event);
+    }
+    _roi_active = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLImageHandler::execute_kernels ()
 {
@@ -383,6 +620,7 @@ XCamReturn
 CLImageHandler::execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    XCAM_TRACE_SCOPE (_name, input.ptr () ? input->get_timestamp () : InvalidTimestamp);
 
     XCAM_FAIL_RETURN (
         WARNING,
@@ -390,11 +628,26 @@ CLImageHandler::execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &ou
         XCAM_RETURN_ERROR_PARAM,
         "cl_image_handler(%s) no image kernel set", XCAM_STR (_name));
 
+    _chain_events.swap (_wait_events);
+    _wait_events.clear ();
+
     if (!is_handler_enabled ()) {
         output = input;
         return XCAM_RETURN_NO_ERROR;
     }
 
+    // serialize with previous frame, internal buffers may be reused
+    if (_last_event.ptr ())
+        _chain_events.push_back (_last_event);
+
+    // buffer pool and memory of kernels are charged to the handler
+    uint32_t mem_parent = MemoryOwnerScope::current ();
+    if (mem_parent != _mem_parent) {
+        _mem_owner = _name ? MemoryAccounting::instance ()->get_owner (mem_parent, _name) : mem_parent;
+        _mem_parent = mem_parent;
+    }
+    MemoryOwnerScope mem_scope (_mem_owner);
+
     XCAM_FAIL_RETURN (
         WARNING,
         (ret = prepare_output_buf (input, output)) == XCAM_RETURN_NO_ERROR,
@@ -410,13 +663,36 @@ CLImageHandler::execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &ou
     if (ret == XCAM_RETURN_BYPASS)
         return ret;
 
+    ret = prepare_roi (input, output);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl_image_handler (%s) prepare ROI failed", XCAM_STR (_name));
+
+    // kernels of this frame are released by one marker
+    SmartPtr<CLKernelBatch> batch;
+    _batch_frame = _event_batching && (!_cmd_queue.ptr () || !_cmd_queue->is_out_of_order ());
+    if (_batch_frame)
+        batch = new CLKernelBatch (_context, _cmd_queue);
+
     XCAM_OBJ_PROFILING_START;
     ret = execute_kernels ();
+    _roi_active = false;
+    _batch_frame = false;
+
+    if (batch.ptr () && batch->get_launch_count ()) {
+        SmartPtr<CLEvent> marker = new CLEvent;
+        if (batch->close (marker) == XCAM_RETURN_NO_ERROR && marker->get_event_id ()) {
+            _chain_events.clear ();
+            _chain_events.push_back (marker);
+            _last_event = marker;
+        }
+    }
+    batch.release ();
 
     reset_buf_cache (NULL, NULL);
 
 #if ENABLE_PROFILING
-    get_context ()->finish ();
+    get_context ()->finish (_cmd_queue);
 #endif
     XCAM_OBJ_PROFILING_END (XCAM_STR (_name), XCAM_OBJ_DUR_FRAME_NUM);
 
@@ -24,6 +24,7 @@
 #include <xcam_std.h>
 #include <swapped_buffer.h>
 #include <x3a_result.h>
+#include <interface/data_types.h>
 #include <ocl/cl_kernel.h>
 #include <ocl/cl_argument.h>
 #include <ocl/cl_memory.h>
@@ -51,16 +52,34 @@ public:
     }
     virtual void pre_stop () {}
 
+    // frame pixels written by one work item, false if kernel can NOT launch over ROI
+    bool get_roi_block (uint32_t &block_x, uint32_t &block_y) const {
+        block_x = _roi_block_x;
+        block_y = _roi_block_y;
+        return _roi_block_x && _roi_block_y;
+    }
+
 protected:
     XCamReturn pre_execute ();
     virtual XCamReturn prepare_arguments (
         CLArgList &args, CLWorkSize &work_size);
+    // kernels with declared argument slots bind them here instead of prepare_arguments,
+    // only changed slots are set again on launch
+    virtual XCamReturn bind_arguments (CLWorkSize &work_size);
+
+    // only for kernels whose output pixels depend on global id, not group id
+    void set_roi_block (uint32_t block_x, uint32_t block_y) {
+        _roi_block_x = block_x;
+        _roi_block_y = block_y;
+    }
 
 private:
     XCAM_DEAD_COPY (CLImageKernel);
 
 private:
     bool                _enable;
+    uint32_t            _roi_block_x;
+    uint32_t            _roi_block_y;
 };
 
 class CLMultiImageHandler;
@@ -100,6 +119,12 @@ public:
         XCAM_ASSERT (size);
         _buf_pool_size = size;
     }
+    // output buffers from @pool owned by caller instead of an own pool, e.g. encoder input
+    // surfaces imported as DrmBoBuffer, need be called before first frame
+    bool set_buffer_pool (const SmartPtr<BufferPool> &pool);
+    bool has_external_buf_pool () const {
+        return _ext_buf_pool.ptr ();
+    }
     void disable_buf_pool (bool flag) {
         _disable_buf_pool = flag;
     }
@@ -114,8 +139,60 @@ public:
 
     bool add_kernel (const SmartPtr<CLImageKernel> &kernel);
     bool enable_handler (bool enable);
+
+    // NULL means default in-order queue of context
+    void set_cmd_queue (const SmartPtr<CLCommandQueue> &queue) {
+        _cmd_queue = queue;
+    }
+    SmartPtr<CLCommandQueue> &get_cmd_queue () {
+        return _cmd_queue;
+    }
+
+    /*
+     * kernels of one execute are chained by events, the first one also waits on
+     * @events set before execute and the last kernel of previous execute.
+     * after execute, get_done_events returns what next stage should wait on.
+     */
+    void set_wait_events (const CLEventList &events) {
+        _wait_events = events;
+    }
+    const CLEventList &get_done_events () const {
+        return _chain_events;
+    }
+    // called in prepare_arguments, the kernel also waits on work enqueued out of this handler
+    void add_chain_event (const SmartPtr<CLEvent> &event) {
+        if (event.ptr () && event->get_event_id ())
+            _chain_events.push_back (event);
+    }
     bool is_handler_enabled () const;
 
+    /*
+     * rectangles of frame to process, ROI capable kernels launch only over them.
+     * pixels out of them are copied from input, handlers with different input and
+     * output formats or without ROI capable kernels still process the full frame.
+     */
+    void set_roi_list (const std::vector<Rect> &rois) {
+        _roi_list = rois;
+    }
+    const std::vector<Rect> &get_roi_list () const {
+        return _roi_list;
+    }
+    void clear_roi_list () {
+        _roi_list.clear ();
+    }
+
+    /*
+     * batched kernels of one execute get no event each, the in-order queue keeps their order
+     * and one marker after them is the done event. ignored on out-of-order queues.
+     * off by default, env XCAM_CL_EVENT_BATCH=1 turns it on for all handlers.
+     */
+    void set_event_batching (bool enable) {
+        _event_batching = enable;
+    }
+    bool is_event_batching () const {
+        return _event_batching;
+    }
+
     virtual bool is_ready ();
     XCamReturn execute (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
     virtual void emit_stop ();
@@ -140,6 +217,9 @@ protected:
 
     XCamReturn ensure_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
     XCamReturn execute_kernel (SmartPtr<CLImageKernel> &kernel);
+    XCamReturn execute_kernel_rois (SmartPtr<CLImageKernel> &kernel);
+    XCamReturn launch_kernel (SmartPtr<CLImageKernel> &kernel);
+    XCamReturn prepare_roi (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
     XCamReturn create_buffer_pool (const VideoBufferInfo &video_info);
     SmartPtr<BufferPool> &get_buffer_pool () {
         return _buf_pool;
@@ -157,6 +237,7 @@ private:
     KernelList                 _kernels;
     SmartPtr<CLContext>        _context;
     SmartPtr<BufferPool>       _buf_pool;
+    SmartPtr<BufferPool>       _ext_buf_pool;
     BufferPoolType             _buf_pool_type;
     bool                       _disable_buf_pool;
     uint32_t                   _buf_pool_size;
@@ -168,6 +249,21 @@ private:
     SmartPtr<VideoBuffer>      _input_buf_cache;
     SmartPtr<VideoBuffer>      _output_buf_cache;
 
+    SmartPtr<CLCommandQueue>   _cmd_queue;
+    CLEventList                _wait_events;
+    CLEventList                _chain_events;
+    SmartPtr<CLEvent>          _last_event;
+
+    std::vector<Rect>          _roi_list;
+    bool                       _roi_active;
+
+    bool                       _event_batching;
+    bool                       _batch_frame;
+
+    // MemoryAccounting owner of this handler under _mem_parent
+    uint32_t                   _mem_owner;
+    uint32_t                   _mem_parent;
+
     XCAM_OBJ_PROFILING_DEFINES;
 };
 
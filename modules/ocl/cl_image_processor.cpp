@@ -26,6 +26,14 @@
 
 namespace XCam {
 
+static int64_t
+get_process_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
 class CLHandlerThread
     : public Thread
 {
@@ -79,6 +87,7 @@ CLImageProcessor::CLImageProcessor (const char* name)
     : ImageProcessor (name ? name : "CLImageProcessor")
     , _seq_num (0)
     , _keep_attached_buffer (false)
+    , _cmd_queue_num (1)
 {
     _context = CLDevice::instance ()->get_context ();
     XCAM_ASSERT (_context.ptr());
@@ -106,6 +115,38 @@ CLImageProcessor::keep_attached_buf(bool flag)
     _keep_attached_buffer = flag;
 }
 
+void
+CLImageProcessor::frame_processed (int64_t process_time)
+{
+    XCAM_UNUSED (process_time);
+}
+
+void
+CLImageProcessor::set_cmd_queue_num (uint32_t num)
+{
+    _cmd_queue_num = XCAM_MAX (num, 1u);
+}
+
+void
+CLImageProcessor::assign_cmd_queues ()
+{
+    if (_cmd_queue_num <= 1)
+        return;
+
+    uint32_t count = _context->ensure_cmd_queues (_context, _cmd_queue_num);
+    if (count < _cmd_queue_num) {
+        XCAM_LOG_WARNING (
+            "CLImageProcessor(%s) only has %d cmd queues, expected %d",
+            XCAM_STR (get_name ()), count, _cmd_queue_num);
+    }
+
+    uint32_t index = 0;
+    for (ImageHandlerList::iterator i_handler = _handlers.begin ();
+            i_handler != _handlers.end (); ++i_handler, ++index) {
+        (*i_handler)->set_cmd_queue (_context->get_cmd_queue (index % _cmd_queue_num));
+    }
+}
+
 bool
 CLImageProcessor::add_handler (SmartPtr<CLImageHandler> &handler)
 {
@@ -114,6 +155,23 @@ CLImageProcessor::add_handler (SmartPtr<CLImageHandler> &handler)
     return true;
 }
 
+bool
+CLImageProcessor::insert_handler (const SmartPtr<CLImageHandler> &next, SmartPtr<CLImageHandler> &handler)
+{
+    XCAM_ASSERT (handler.ptr ());
+
+    ImageHandlerList::iterator i_handler = _handlers.begin ();
+    for (; i_handler != _handlers.end (); ++i_handler) {
+        if ((*i_handler).ptr () == next.ptr ())
+            break;
+    }
+    _handlers.insert (i_handler, handler);
+
+    // round-robin queues follow handler order
+    assign_cmd_queues ();
+    return true;
+}
+
 CLImageProcessor::ImageHandlerList::iterator
 CLImageProcessor::handlers_begin ()
 {
@@ -166,6 +224,8 @@ CLImageProcessor::process_buffer (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBu
 
     if (_handlers.empty()) {
         ret = create_handlers ();
+        if (ret == XCAM_RETURN_NO_ERROR)
+            assign_cmd_queues ();
     }
 
     XCAM_FAIL_RETURN (
@@ -264,6 +324,9 @@ CLImageProcessor::process_cl_buffer_queue ()
             return XCAM_RETURN_BYPASS;
         }
 
+        if (!p_buf->start_time)
+            p_buf->start_time = get_process_time ();
+        handler->set_wait_events (p_buf->events);
         ret = handler->execute (data, out_data);
         XCAM_FAIL_RETURN (
             WARNING,
@@ -274,6 +337,15 @@ CLImageProcessor::process_cl_buffer_queue ()
         if (ret == XCAM_RETURN_BYPASS)
             return ret;
 
+        p_buf->events = handler->get_done_events ();
+        if (_cmd_queue_num > 1) {
+            // events waited by other queues must be flushed
+            _context->flush (handler->get_cmd_queue ());
+            // handlers on other queues may still read input after it returns to pool
+            if (data.ptr () != out_data.ptr ())
+                p_buf->held_bufs.push_back (data);
+        }
+
         // for loop in handler, find next handler
         ImageHandlerList::iterator i_handler = _handlers.begin ();
         while (i_handler != _handlers.end ())
@@ -301,8 +373,14 @@ CLImageProcessor::process_cl_buffer_queue ()
             out_data->clear_attached_buffers ();
 
         XCAM_OBJ_PROFILING_START;
-        CLDevice::instance()->get_context ()->finish ();
+        if (_cmd_queue_num > 1 && !p_buf->events.empty ()) {
+            // only wait for this buffer, later frames keep running on GPU
+            cl_events_wait (p_buf->events);
+            p_buf->held_bufs.clear ();
+        } else
+            CLDevice::instance()->get_context ()->finish ();
         XCAM_OBJ_PROFILING_END (get_name (), XCAM_OBJ_DUR_FRAME_NUM);
+        frame_processed (get_process_time () - p_buf->start_time);
 
         // buffer done, push back
         _done_buffer_queue.push (out_data);
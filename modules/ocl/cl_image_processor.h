@@ -48,7 +48,12 @@ public:
 
     void keep_attached_buf (bool flag);
 
+    // run handlers round-robin on @num cmd queues, set before start
+    void set_cmd_queue_num (uint32_t num);
+
     bool add_handler (SmartPtr<CLImageHandler> &handler);
+    // insert @handler ahead of @next while running, appended if @next not found, need STREAM_LOCK
+    bool insert_handler (const SmartPtr<CLImageHandler> &next, SmartPtr<CLImageHandler> &handler);
     ImageHandlerList::iterator handlers_begin ();
     ImageHandlerList::iterator handlers_end ();
 
@@ -62,10 +67,14 @@ protected:
     virtual XCamReturn emit_start ();
     virtual void emit_stop ();
 
+    // in handler thread, @process_time us from first handler launch till frame finished
+    virtual void frame_processed (int64_t process_time);
+
     SmartPtr<CLContext> get_cl_context ();
 
 private:
     virtual XCamReturn create_handlers ();
+    void assign_cmd_queues ();
 
     XCamReturn process_cl_buffer_queue ();
     XCamReturn process_done_buffer ();
@@ -90,6 +99,7 @@ private:
     SafeList<VideoBuffer>          _done_buffer_queue;
     uint32_t                       _seq_num;
     bool                           _keep_attached_buffer;  //default false
+    uint32_t                       _cmd_queue_num;
     XCAM_OBJ_PROFILING_DEFINES;
 };
 
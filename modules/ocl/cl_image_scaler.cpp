@@ -20,6 +20,7 @@
 
 #include "cl_utils.h"
 #include "cl_image_scaler.h"
+#include <math.h>
 
 namespace XCam {
 
@@ -29,6 +30,19 @@ static const XCamKernelInfo kernel_scale_info = {
     , 0,
 };
 
+static const XCamKernelInfo kernel_polyphase_scale_info[] = {
+    {
+        "kernel_image_scaler_polyphase_h",
+#include "kernel_image_scaler.clx"
+        , 0,
+    },
+    {
+        "kernel_image_scaler_polyphase_v",
+#include "kernel_image_scaler.clx"
+        , 0,
+    },
+};
+
 CLScalerKernel::CLScalerKernel (
     const SmartPtr<CLContext> &context,
     CLImageScalerMemoryLayout mem_layout
@@ -146,25 +160,215 @@ CLImageScalerKernel::get_output_buffer ()
     return _scaler->get_scaler_buf ();
 }
 
-CLImageScaler::CLImageScaler (const SmartPtr<CLContext> &context)
+CLPolyphaseScalerKernel::CLPolyphaseScalerKernel (
+    const SmartPtr<CLContext> &context, const char *name,
+    CLImageScalerMemoryLayout mem_layout, bool vertical, SmartPtr<CLImageScaler> &scaler)
+    : CLImageKernel (context, name)
+    , _mem_layout (mem_layout)
+    , _vertical (vertical)
+    , _scaler (scaler)
+{
+}
+
+XCamReturn
+CLPolyphaseScalerKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<VideoBuffer> input = _scaler->get_input_buf ();
+    uint32_t plane = (_mem_layout == CL_IMAGE_SCALER_NV12_UV) ? 1 : 0;
+    uint32_t count = _scaler->get_scaler_output_count ();
+
+    XCAM_FAIL_RETURN (
+        WARNING, input.ptr (), XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) get input buffer failed", XCAM_STR (get_kernel_name ()));
+    const VideoBufferInfo &in_info = input->get_video_info ();
+
+    CLImageDesc desc;
+    desc.format.image_channel_order = plane ? CL_RG : CL_R;
+    desc.format.image_channel_data_type = CL_UNORM_INT8;
+
+    SmartPtr<CLImage> images_in[XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS];
+    SmartPtr<CLImage> images_out[XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS];
+    int32_t taps[4] = {0, 0, 0, 0};
+    int32_t out_width[4] = {0, 0, 0, 0};
+    int32_t out_height[4] = {0, 0, 0, 0};
+    uint32_t max_width = 0, max_height = 0;
+
+    for (uint32_t i = 0; i < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS; ++i) {
+        // unused outputs repeat the first one, kernel skips them
+        CLImageScaler::ScalerOutput &out = _scaler->_outputs[i < count ? i : 0];
+        XCAM_FAIL_RETURN (
+            WARNING, out.buf.ptr () && out.temp[plane].ptr (), XCAM_RETURN_ERROR_MEM,
+            "cl image kernel(%s) output(%d) buffer not ready", XCAM_STR (get_kernel_name ()), i);
+        const VideoBufferInfo &out_info = out.buf->get_video_info ();
+
+        out_width[i] = plane ? out_info.width / 2 : out_info.width;
+        out_height[i] = plane ? out_info.height / 2 : out_info.height;
+        taps[i] = out.taps[plane][_vertical ? 1 : 0];
+
+        if (_vertical) {
+            desc.width = out_width[i];
+            desc.height = out_height[i];
+            desc.row_pitch = out_info.strides[plane];
+            images_in[i] = out.temp[plane];
+            if (i < count)
+                images_out[i] = convert_to_climage (context, out.buf, desc, out_info.offsets[plane]);
+            else
+                images_out[i] = images_out[0];
+        } else {
+            images_out[i] = out.temp[plane];
+        }
+        XCAM_FAIL_RETURN (
+            WARNING, images_out[i].ptr () && images_out[i]->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "cl image kernel(%s) output(%d) image not available", XCAM_STR (get_kernel_name ()), i);
+
+        max_width = XCAM_MAX (max_width, (uint32_t)out_width[i]);
+        max_height = XCAM_MAX (max_height, (uint32_t)out_height[i]);
+    }
+
+    if (_vertical) {
+        for (uint32_t i = 0; i < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS; ++i)
+            args.push_back (new CLMemArgument (images_in[i]));
+    } else {
+        desc.width = plane ? in_info.width / 2 : in_info.width;
+        desc.height = plane ? in_info.height / 2 : in_info.height;
+        desc.row_pitch = in_info.strides[plane];
+        SmartPtr<CLImage> image_in = convert_to_climage (context, input, desc, in_info.offsets[plane]);
+        XCAM_FAIL_RETURN (
+            WARNING, image_in.ptr () && image_in->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "cl image kernel(%s) input image not available", XCAM_STR (get_kernel_name ()));
+        args.push_back (new CLMemArgument (image_in));
+        max_height = desc.height;
+    }
+
+    for (uint32_t i = 0; i < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS; ++i)
+        args.push_back (new CLMemArgument (images_out[i]));
+    for (uint32_t i = 0; i < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS; ++i) {
+        CLImageScaler::ScalerOutput &out = _scaler->_outputs[i < count ? i : 0];
+        args.push_back (new CLMemArgument (out.table[plane][_vertical ? 1 : 0]));
+    }
+    args.push_back (new CLArgumentTArray<int32_t, 4> (taps));
+    args.push_back (new CLArgumentTArray<int32_t, 4> (out_width));
+    if (_vertical)
+        args.push_back (new CLArgumentTArray<int32_t, 4> (out_height));
+    else
+        args.push_back (new CLArgumentT<int32_t> ((int32_t)max_height));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)count));
+
+    work_size.dim = 3;
+    work_size.local[0] = XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE0;
+    work_size.local[1] = XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE1;
+    work_size.local[2] = 1;
+    work_size.global[0] = XCAM_ALIGN_UP (max_width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (max_height, work_size.local[1]);
+    work_size.global[2] = count;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static double
+scaler_filter_support (CLImageScalerFilter filter)
+{
+    switch (filter) {
+    case CL_IMAGE_SCALER_FILTER_BICUBIC:
+        return 2.0;
+    case CL_IMAGE_SCALER_FILTER_LANCZOS3:
+        return 3.0;
+    default:
+        return 1.0;
+    }
+}
+
+static double
+scaler_filter_weight (CLImageScalerFilter filter, double x)
+{
+    x = fabs (x);
+    switch (filter) {
+    case CL_IMAGE_SCALER_FILTER_BICUBIC: {
+        // Keys cubic, a = -0.5
+        const double a = -0.5;
+        if (x < 1.0)
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        if (x < 2.0)
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+        return 0.0;
+    }
+    case CL_IMAGE_SCALER_FILTER_LANCZOS3: {
+        if (x < 1e-6)
+            return 1.0;
+        if (x >= 3.0)
+            return 0.0;
+        double px = M_PI * x;
+        return 3.0 * sin (px) * sin (px / 3.0) / (px * px);
+    }
+    default:
+        return x < 1.0 ? 1.0 - x : 0.0;
+    }
+}
+
+/*
+ * per output coordinate: first source coordinate and taps weights,
+ * filter widens by the factor on downscaling, taps are capped by XCAM_CL_IMAGE_SCALER_MAX_TAPS.
+ */
+static uint32_t
+calc_polyphase_table (
+    CLImageScalerFilter filter, uint32_t in_len, uint32_t out_len, std::vector<float> &table)
+{
+    double scale = (double)out_len / in_len;
+    double support = scaler_filter_support (filter);
+    double filter_scale = XCAM_MIN (scale, 1.0);
+    uint32_t taps = (uint32_t)ceil (2.0 * support / filter_scale);
+    if (taps > XCAM_CL_IMAGE_SCALER_MAX_TAPS) {
+        taps = XCAM_CL_IMAGE_SCALER_MAX_TAPS;
+        filter_scale = 2.0 * support / taps;
+    }
+
+    table.assign (out_len * (taps + 1), 0.0f);
+    for (uint32_t i = 0; i < out_len; ++i) {
+        float *entry = &table[i * (taps + 1)];
+        double center = (i + 0.5) / scale - 0.5;
+        int32_t start = (int32_t)floor (center - taps / 2.0) + 1;
+        double sum = 0.0;
+        for (uint32_t t = 0; t < taps; ++t) {
+            double w = scaler_filter_weight (filter, (start + (int32_t)t - center) * filter_scale);
+            entry[t + 1] = (float)w;
+            sum += w;
+        }
+        for (uint32_t t = 0; t < taps && sum != 0.0; ++t)
+            entry[t + 1] = (float)(entry[t + 1] / sum);
+        entry[0] = (float)start;
+    }
+    return taps;
+}
+
+CLImageScaler::ScalerOutput::ScalerOutput ()
+    : h_factor (0.5)
+    , v_factor (0.5)
+{
+    xcam_mem_clear (taps);
+}
+
+CLImageScaler::CLImageScaler (const SmartPtr<CLContext> &context, CLImageScalerFilter filter)
     : CLImageHandler (context, "CLImageScaler")
-    , _h_scaler_factor (0.5)
-    , _v_scaler_factor (0.5)
+    , _filter (filter)
+    , _output_count (1)
 {
 }
 
 void
 CLImageScaler::emit_stop ()
 {
-    if (_scaler_buf_pool.ptr ())
-        _scaler_buf_pool->stop ();
+    for (uint32_t i = 0; i < _output_count; ++i) {
+        if (_outputs[i].pool.ptr ())
+            _outputs[i].pool->stop ();
+    }
 }
 
 bool
 CLImageScaler::set_scaler_factor (const double h_factor, const double v_factor)
 {
-    _h_scaler_factor = h_factor;
-    _v_scaler_factor = v_factor;
+    _outputs[0].h_factor = h_factor;
+    _outputs[0].v_factor = v_factor;
 
     return true;
 }
@@ -172,26 +376,51 @@ CLImageScaler::set_scaler_factor (const double h_factor, const double v_factor)
 bool
 CLImageScaler::get_scaler_factor (double &h_factor, double &v_factor) const
 {
-    h_factor = _h_scaler_factor;
-    v_factor = _v_scaler_factor;
+    h_factor = _outputs[0].h_factor;
+    v_factor = _outputs[0].v_factor;
 
     return true;
 };
 
+bool
+CLImageScaler::add_scaler_output (const double h_factor, const double v_factor)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, _filter != CL_IMAGE_SCALER_FILTER_SAMPLER, false,
+        "CLImageScaler add output failed, sampler filter supports one output");
+    XCAM_FAIL_RETURN (
+        WARNING, _output_count < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS, false,
+        "CLImageScaler add output failed, max %d outputs", XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS);
+    XCAM_FAIL_RETURN (
+        WARNING, !_outputs[0].pool.ptr (), false,
+        "CLImageScaler add output failed, scaler already started");
+
+    _outputs[_output_count].h_factor = h_factor;
+    _outputs[_output_count].v_factor = v_factor;
+    ++_output_count;
+
+    return true;
+}
+
 XCamReturn
 CLImageScaler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
     output = input;
 
-    ret = prepare_scaler_buf (input->get_video_info (), _scaler_buf);
-    XCAM_FAIL_RETURN(
-        WARNING,
-        ret == XCAM_RETURN_NO_ERROR,
-        ret,
-        "CLImageScalerKernel prepare scaled video buf failed");
-
-    _scaler_buf->set_timestamp (input->get_timestamp ());
+    for (uint32_t i = 0; i < _output_count; ++i) {
+        ret = prepare_scaler_buf (input->get_video_info (), _outputs[i]);
+        XCAM_FAIL_RETURN(
+            WARNING,
+            ret == XCAM_RETURN_NO_ERROR,
+            ret,
+            "CLImageScalerKernel prepare scaled video buf(%d) failed", i);
+
+        _outputs[i].buf->set_timestamp (input->get_timestamp ());
+        if (!_outputs[i].meta.ptr ())
+            _outputs[i].meta = new CLScalerOutputMeta (i);
+        _outputs[i].buf->add_metadata (_outputs[i].meta);
+    }
 
     return ret;
 }
@@ -199,22 +428,29 @@ CLImageScaler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPtr<VideoB
 XCamReturn
 CLImageScaler::execute_done (SmartPtr<VideoBuffer> &output)
 {
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
     XCAM_UNUSED (output);
     get_context ()->finish();
-    XCAM_ASSERT (_scaler_buf.ptr ());
 
-    //post buffer out
-    return post_buffer (_scaler_buf);
+    //post buffers out
+    for (uint32_t i = 0; i < _output_count; ++i) {
+        XCAM_ASSERT (_outputs[i].buf.ptr ());
+        ret = post_buffer (_outputs[i].buf);
+        if (!xcam_ret_is_ok (ret))
+            break;
+    }
+    return ret;
 }
 
 XCamReturn
-CLImageScaler::prepare_scaler_buf (const VideoBufferInfo &video_info, SmartPtr<VideoBuffer> &output)
+CLImageScaler::prepare_scaler_buf (const VideoBufferInfo &video_info, ScalerOutput &output)
 {
-    if (!_scaler_buf_pool.ptr ()) {
+    if (!output.pool.ptr ()) {
         VideoBufferInfo scaler_video_info;
-        uint32_t new_width = XCAM_ALIGN_UP ((uint32_t)(video_info.width * _h_scaler_factor),
+        uint32_t new_width = XCAM_ALIGN_UP ((uint32_t)(video_info.width * output.h_factor),
                                             2 * XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE0);
-        uint32_t new_height = XCAM_ALIGN_UP ((uint32_t)(video_info.height * _v_scaler_factor),
+        uint32_t new_height = XCAM_ALIGN_UP ((uint32_t)(video_info.height * output.v_factor),
                                              2 * XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE1);
 
         scaler_video_info.init (video_info.format, new_width, new_height);
@@ -223,15 +459,66 @@ CLImageScaler::prepare_scaler_buf (const VideoBufferInfo &video_info, SmartPtr<V
         XCAM_ASSERT (pool.ptr ());
         pool->set_video_info (scaler_video_info);
         pool->reserve (6);
-        _scaler_buf_pool = pool;
+        output.pool = pool;
+
+        if (_filter != CL_IMAGE_SCALER_FILTER_SAMPLER) {
+            XCamReturn ret = prepare_polyphase_table (video_info, output);
+            XCAM_FAIL_RETURN (
+                WARNING, xcam_ret_is_ok (ret), ret,
+                "CLImageScaler prepare polyphase tables failed");
+        }
     }
 
-    output = _scaler_buf_pool->get_buffer (_scaler_buf_pool);
-    XCAM_ASSERT (output.ptr ());
+    output.buf = output.pool->get_buffer (output.pool);
+    XCAM_ASSERT (output.buf.ptr ());
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLImageScaler::prepare_polyphase_table (const VideoBufferInfo &in_info, ScalerOutput &output)
+{
+    SmartPtr<CLContext> context = get_context ();
+    const VideoBufferInfo &out_info = output.pool->get_video_info ();
+    std::vector<float> table;
+
+    for (uint32_t plane = 0; plane < 2; ++plane) {
+        uint32_t in_width = plane ? in_info.width / 2 : in_info.width;
+        uint32_t in_height = plane ? in_info.height / 2 : in_info.height;
+        uint32_t out_width = plane ? out_info.width / 2 : out_info.width;
+        uint32_t out_height = plane ? out_info.height / 2 : out_info.height;
+
+        for (uint32_t dir = 0; dir < 2; ++dir) {
+            output.taps[plane][dir] = dir ?
+                                      calc_polyphase_table (_filter, in_height, out_height, table) :
+                                      calc_polyphase_table (_filter, in_width, out_width, table);
+            output.table[plane][dir] = new CLBuffer (
+                context, table.size () * sizeof (float),
+                CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, &table[0]);
+            XCAM_FAIL_RETURN (
+                ERROR, output.table[plane][dir]->is_valid (), XCAM_RETURN_ERROR_MEM,
+                "CLImageScaler create polyphase table failed");
+        }
+
+        // horizontal pass result, output width x input height
+        CLImageDesc desc;
+        desc.format.image_channel_order = plane ? CL_RG : CL_R;
+        desc.format.image_channel_data_type = CL_UNORM_INT16;
+        desc.width = out_width;
+        desc.height = in_height;
+        output.temp[plane] = new CLImage2D (context, desc);
+        XCAM_FAIL_RETURN (
+            ERROR, output.temp[plane]->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "CLImageScaler create polyphase temp image failed");
+    }
+
+    XCAM_LOG_DEBUG (
+        "CLImageScaler polyphase %dx%d -> %dx%d, taps h:%d v:%d",
+        in_info.width, in_info.height, out_info.width, out_info.height,
+        output.taps[0][0], output.taps[0][1]);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLImageScaler::post_buffer (const SmartPtr<VideoBuffer> &buffer)
 {
@@ -252,15 +539,51 @@ create_scale_kernel (
         ERROR, kernel->build_kernel (kernel_scale_info, NULL) == XCAM_RETURN_NO_ERROR, NULL,
         "build scaler kernel(%s) failed", kernel_scale_info.kernel_name);
     XCAM_ASSERT (kernel->is_valid ());
+    kernel->set_work_size_tunable (true);
+    return kernel;
+}
+
+static SmartPtr<CLImageKernel>
+create_polyphase_scale_kernel (
+    const SmartPtr<CLContext> &context, SmartPtr<CLImageScaler> &handler,
+    CLImageScalerMemoryLayout layout, bool vertical)
+{
+    const XCamKernelInfo &info = kernel_polyphase_scale_info[vertical ? 1 : 0];
+    SmartPtr<CLImageKernel> kernel;
+    kernel = new CLPolyphaseScalerKernel (context, info.kernel_name, layout, vertical, handler);
+    XCAM_ASSERT (kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, kernel->build_kernel (info, NULL) == XCAM_RETURN_NO_ERROR, NULL,
+        "build scaler kernel(%s) failed", info.kernel_name);
+    XCAM_ASSERT (kernel->is_valid ());
     return kernel;
 }
 
 SmartPtr<CLImageHandler>
-create_cl_image_scaler_handler (const SmartPtr<CLContext> &context, const uint32_t format)
+create_cl_image_scaler_handler (
+    const SmartPtr<CLContext> &context, const uint32_t format, CLImageScalerFilter filter)
 {
     SmartPtr<CLImageScaler> scaler_handler;
     SmartPtr<CLImageKernel> scaler_kernel;
 
+    if (filter != CL_IMAGE_SCALER_FILTER_SAMPLER) {
+        XCAM_FAIL_RETURN (
+            ERROR, V4L2_PIX_FMT_NV12 == format, NULL,
+            "create cl image scaler failed, polyphase filter supports NV12 only, format:0x%08x", format);
+
+        scaler_handler = new CLImageScaler (context, filter);
+        XCAM_ASSERT (scaler_handler.ptr ());
+
+        // Y and UV, horizontal pass before vertical pass
+        for (uint32_t i = 0; i < 4; ++i) {
+            CLImageScalerMemoryLayout layout = (i < 2) ? CL_IMAGE_SCALER_NV12_Y : CL_IMAGE_SCALER_NV12_UV;
+            scaler_kernel = create_polyphase_scale_kernel (context, scaler_handler, layout, i % 2);
+            XCAM_FAIL_RETURN (ERROR, scaler_kernel.ptr (), NULL, "build polyphase scaler kernel failed");
+            scaler_handler->add_kernel (scaler_kernel);
+        }
+        return scaler_handler;
+    }
+
     scaler_handler = new CLImageScaler (context);
     XCAM_ASSERT (scaler_handler.ptr ());
 
@@ -34,11 +34,33 @@ enum CLImageScalerMemoryLayout {
     CL_IMAGE_SCALER_RGBA = 2,
 };
 
+enum CLImageScalerFilter {
+    CL_IMAGE_SCALER_FILTER_SAMPLER = 0,  // bilinear by image sampler
+    CL_IMAGE_SCALER_FILTER_BILINEAR,
+    CL_IMAGE_SCALER_FILTER_BICUBIC,
+    CL_IMAGE_SCALER_FILTER_LANCZOS3,
+};
+
 #define XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE0 8
 #define XCAM_CL_IMAGE_SCALER_KERNEL_LOCAL_WORK_SIZE1 4
 
+// polyphase filters only
+#define XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS 3
+#define XCAM_CL_IMAGE_SCALER_MAX_TAPS 16
+
 class CLImageScaler;
 
+// carried by every buffer CLImageScaler posts, @index is the scaler output it comes from
+struct CLScalerOutputMeta
+    : MetaData
+{
+    uint32_t index;
+
+    explicit CLScalerOutputMeta (uint32_t i)
+        : index (i)
+    {}
+};
+
 class CLScalerKernel
     : public CLImageKernel
 {
@@ -80,20 +102,71 @@ private:
     SmartPtr<CLImageScaler> _scaler;
 };
 
+/*
+ * separable polyphase scaler of NV12 planes, coefficient tables are computed once per output,
+ * each pass scales the plane into all outputs in one launch.
+ */
+class CLPolyphaseScalerKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLPolyphaseScalerKernel (
+        const SmartPtr<CLContext> &context, const char *name,
+        CLImageScalerMemoryLayout mem_layout, bool vertical, SmartPtr<CLImageScaler> &scaler);
+
+protected:
+    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
+
+private:
+    XCAM_DEAD_COPY (CLPolyphaseScalerKernel);
+
+private:
+    CLImageScalerMemoryLayout  _mem_layout;
+    bool                       _vertical;
+    SmartPtr<CLImageScaler>    _scaler;
+};
+
 class CLImageScaler
     : public CLImageHandler
 {
     friend class CLImageScalerKernel;
+    friend class CLPolyphaseScalerKernel;
+
+    struct ScalerOutput {
+        double                 h_factor;
+        double                 v_factor;
+        SmartPtr<BufferPool>   pool;
+        SmartPtr<VideoBuffer>  buf;
+        SmartPtr<CLScalerOutputMeta> meta;
+        // indexed by plane, Y and UV
+        SmartPtr<CLImage>      temp[2];
+        SmartPtr<CLBuffer>     table[2][2];
+        uint32_t               taps[2][2];
+
+        ScalerOutput ();
+    };
+
 public:
-    explicit CLImageScaler (const SmartPtr<CLContext> &context);
+    explicit CLImageScaler (
+        const SmartPtr<CLContext> &context, CLImageScalerFilter filter = CL_IMAGE_SCALER_FILTER_SAMPLER);
     void set_buffer_callback (SmartPtr<StatsCallback> &callback) {
         _scaler_callback = callback;
     }
+    CLImageScalerFilter get_filter () const {
+        return _filter;
+    }
 
+    // factors of the first output
     bool set_scaler_factor (const double h_factor, const double v_factor);
     bool get_scaler_factor (double &h_factor, double &v_factor) const;
-    SmartPtr<VideoBuffer> &get_scaler_buf () {
-        return _scaler_buf;
+    // adds one more scaled stream, polyphase filters only, call before the first frame
+    bool add_scaler_output (const double h_factor, const double v_factor);
+    uint32_t get_scaler_output_count () const {
+        return _output_count;
+    }
+    SmartPtr<VideoBuffer> &get_scaler_buf (uint32_t index = 0) {
+        XCAM_ASSERT (index < _output_count);
+        return _outputs[index].buf;
     };
 
     void emit_stop ();
@@ -103,19 +176,22 @@ protected:
     virtual XCamReturn execute_done (SmartPtr<VideoBuffer> &output);
 
 private:
-    XCamReturn prepare_scaler_buf (const VideoBufferInfo &video_info, SmartPtr<VideoBuffer> &output);
+    XCamReturn prepare_scaler_buf (const VideoBufferInfo &video_info, ScalerOutput &output);
+    XCamReturn prepare_polyphase_table (const VideoBufferInfo &in_info, ScalerOutput &output);
     XCamReturn post_buffer (const SmartPtr<VideoBuffer> &buffer);
 
 private:
-    double                     _h_scaler_factor;
-    double                     _v_scaler_factor;
-    SmartPtr<BufferPool>       _scaler_buf_pool;
-    SmartPtr<VideoBuffer>      _scaler_buf;
+    CLImageScalerFilter        _filter;
+    ScalerOutput               _outputs[XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS];
+    uint32_t                   _output_count;
     SmartPtr<StatsCallback>    _scaler_callback;
 };
 
+// filter other than CL_IMAGE_SCALER_FILTER_SAMPLER supports NV12 only
 SmartPtr<CLImageHandler>
-create_cl_image_scaler_handler (const SmartPtr<CLContext> &context, uint32_t format);
+create_cl_image_scaler_handler (
+    const SmartPtr<CLContext> &context, uint32_t format,
+    CLImageScalerFilter filter = CL_IMAGE_SCALER_FILTER_SAMPLER);
 
 };
 
@@ -49,6 +49,19 @@ CLImageWarpKernel::CLImageWarpKernel (
     , _channel (channel)
 {
     _handler = handler.dynamic_cast_ptr<CLImageWarpHandler> ();
+
+    // UV plane has half height, each UV pair covers 2 pixels
+#if CL_IMAGE_WARP_WRITE_UINT
+    if (channel == CL_IMAGE_CHANNEL_UV)
+        set_roi_block (16, 2);
+    else
+        set_roi_block (8, 1);
+#else
+    if (channel == CL_IMAGE_CHANNEL_UV)
+        set_roi_block (2, 2);
+    else
+        set_roi_block (1, 1);
+#endif
 }
 
 XCamReturn
@@ -125,12 +138,8 @@ CLImageWarpKernel::prepare_arguments (
 
       Warp Perspective Matrix = TMat * HMat
     */
-#if CL_IMAGE_WARP_WRITE_UINT
-    float shift_x = warp_config.trim_ratio * cl_desc_out.width * 8.0f;
-#else
-    float shift_x = warp_config.trim_ratio * cl_desc_out.width;
-#endif
-    float shift_y = warp_config.trim_ratio * cl_desc_out.height;
+    float shift_x = warp_config.trim_ratio * cl_desc_in.width;
+    float shift_y = warp_config.trim_ratio * cl_desc_in.height;
     float scale_x = 1.0f - 2.0f * warp_config.trim_ratio;
     float scale_y = 1.0f - 2.0f * warp_config.trim_ratio;
 
@@ -141,6 +150,37 @@ CLImageWarpKernel::prepare_arguments (
     warp_config.proj_mat[4] = scale_y * warp_config.proj_mat[4] + shift_y * warp_config.proj_mat[7];
     warp_config.proj_mat[5] = scale_y * warp_config.proj_mat[5] + shift_y * warp_config.proj_mat[8];
 
+    /*
+      Crop and scale: output pixel centers map into crop of the warped input size
+      Crop Matrix (CMat)
+      CMat = [ ratio_x, 0.0f,    offset_x;
+               0.0f,    ratio_y, offset_y;
+               0.0f,    0.0f,    1.0f;    ]
+
+      Warp Perspective Matrix = TMat * HMat * CMat
+    */
+    if (video_info_out.width != video_info_in.width || video_info_out.height != video_info_in.height ||
+            _handler->get_crop ().width || _handler->get_crop ().height) {
+        Rect crop = _handler->get_crop ();
+        if (!crop.width || !crop.height) {
+            crop.pos_x = crop.pos_y = 0;
+            crop.width = video_info_in.width;
+            crop.height = video_info_in.height;
+        }
+
+        float ratio_x = (float)crop.width / (float)video_info_out.width;
+        float ratio_y = (float)crop.height / (float)video_info_out.height;
+        float offset_x = (float)(crop.pos_x >> info_index) + 0.5f * (ratio_x - 1.0f);
+        float offset_y = (float)(crop.pos_y >> info_index) + 0.5f * (ratio_y - 1.0f);
+
+        for (uint32_t i = 0; i < 9; i += 3) {
+            warp_config.proj_mat[i + 2] +=
+                offset_x * warp_config.proj_mat[i] + offset_y * warp_config.proj_mat[i + 1];
+            warp_config.proj_mat[i] *= ratio_x;
+            warp_config.proj_mat[i + 1] *= ratio_y;
+        }
+    }
+
     XCAM_LOG_DEBUG ("warp config image size(%dx%d)", warp_config.width, warp_config.height);
     XCAM_LOG_DEBUG ("proj_mat[%d]=(%f, %f, %f, %f, %f, %f, %f, %f, %f);", warp_config.frame_id,
                     warp_config.proj_mat[0], warp_config.proj_mat[1], warp_config.proj_mat[2],
@@ -170,7 +210,53 @@ CLImageWarpKernel::prepare_arguments (
 
 CLImageWarpHandler::CLImageWarpHandler (const SmartPtr<CLContext> &context, const char *name)
     : CLImageHandler (context, name)
+    , _out_width (0)
+    , _out_height (0)
+{
+}
+
+bool
+CLImageWarpHandler::set_crop_scale (const Rect &crop, uint32_t out_width, uint32_t out_height)
 {
+    XCAM_FAIL_RETURN (
+        WARNING, crop.pos_x >= 0 && crop.pos_y >= 0 && crop.width >= 0 && crop.height >= 0, false,
+        "CL image warp(%s) invalid crop(%d, %d, %d, %d)",
+        XCAM_STR (get_name ()), crop.pos_x, crop.pos_y, crop.width, crop.height);
+
+    _crop = crop;
+    _out_width = XCAM_ALIGN_UP (out_width, 2);
+    _out_height = XCAM_ALIGN_UP (out_height, 2);
+    return true;
+}
+
+XCamReturn
+CLImageWarpHandler::prepare_buffer_pool_video_info (
+    const VideoBufferInfo &input,
+    VideoBufferInfo &output)
+{
+    if (!(_crop.width && _crop.height) && !(_out_width && _out_height)) {
+        output = input;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    uint32_t width = input.width;
+    uint32_t height = input.height;
+    if (_crop.width && _crop.height) {
+        width = XCAM_ALIGN_UP (_crop.width, 2);
+        height = XCAM_ALIGN_UP (_crop.height, 2);
+    }
+    if (_out_width && _out_height) {
+        width = _out_width;
+        height = _out_height;
+    }
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        output.init (input.format, width, height),
+        XCAM_RETURN_ERROR_PARAM,
+        "CL image warp(%s) output format(%s) unsupported",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (input.format));
+    return XCAM_RETURN_NO_ERROR;
 }
 
 bool
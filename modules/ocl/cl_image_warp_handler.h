@@ -103,15 +103,28 @@ public:
     bool set_warp_config (const XCamDVSResult& config);
     CLWarpConfig get_warp_config ();
 
+    // crop of warped image scaled to output size, folded into projection matrix,
+    // empty crop takes whole input, zero size keeps crop size
+    bool set_crop_scale (const Rect &crop, uint32_t out_width, uint32_t out_height);
+    const Rect &get_crop () const {
+        return _crop;
+    }
+
     virtual bool is_ready ();
 
 protected:
+    virtual XCamReturn prepare_buffer_pool_video_info (
+        const VideoBufferInfo &input,
+        VideoBufferInfo &output);
     virtual XCamReturn execute_done (SmartPtr<VideoBuffer> &output);
 
 private:
     XCAM_DEAD_COPY (CLImageWarpHandler);
 
     CLWarpConfigList _warp_config_list;
+    Rect             _crop;
+    uint32_t         _out_width;
+    uint32_t         _out_height;
 
 };
 
@@ -22,17 +22,28 @@
 #include "cl_context.h"
 #include "cl_device.h"
 #include "file_handle.h"
+#include "cl_kernel_profiler.h"
+#include "xcam_trace.h"
 
 #include <sys/stat.h>
+#include <dirent.h>
 
 #define ENABLE_DEBUG_KERNEL 0
 
 #define XCAM_CL_KERNEL_DEFAULT_LOCAL_WORK_SIZE 0
 
+#define XCAM_CL_KERNEL_HASH_SEED 0xcbf29ce484222325ULL
+#define XCAM_CL_KERNEL_BUNDLE_VERSION 1
+
+// timed launches of each local size candidate, the fastest one counts
+#define XCAM_CL_WORK_SIZE_TUNE_RUNS 3
+
 namespace XCam {
 
 CLKernel::KernelMap CLKernel::_kernel_map;
 Mutex CLKernel::_kernel_map_mutex;
+CLKernel::BundleMap CLKernel::_bundle_map;
+bool CLKernel::_bundle_loaded = false;
 
 static const char*
 default_cache_path () {
@@ -52,6 +63,9 @@ CLKernel::CLKernel (const SmartPtr<CLContext> &context, const char *name)
     : _name (NULL)
     , _kernel_id (NULL)
     , _context (context)
+    , _slots_committed (false)
+    , _source_key (0)
+    , _work_size_tunable (false)
 {
     XCAM_ASSERT (context.ptr ());
     //XCAM_ASSERT (name);
@@ -78,52 +92,211 @@ CLKernel::destroy ()
         _context->destroy_kernel_id (_kernel_id);
 }
 
+static uint64_t
+hash_string (const char *str, size_t len, uint64_t hash = XCAM_CL_KERNEL_HASH_SEED)
+{
+    // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= (uint8_t)str[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// binaries are only valid on the same device and driver
+static std::string
+generate_device_tag ()
+{
+    const CLDevieInfo &info = CLDevice::instance ()->get_device_info ();
+    uint64_t hash = hash_string (info.device_name, strlen (info.device_name));
+    hash = hash_string ("#", 1, hash);
+    hash = hash_string (info.driver_version, strlen (info.driver_version), hash);
+
+    char tag[32];
+    snprintf (tag, sizeof (tag), "%016" PRIx64, hash);
+    return tag;
+}
+
+const char *
+CLKernel::get_device_tag ()
+{
+    static const std::string tag = generate_device_tag ();
+    return tag.c_str ();
+}
+
+std::string
+CLKernel::get_cache_path ()
+{
+    std::string cache_path = CLKernel::get_kernel_cache_path ();
+    const char *env = std::getenv ("XCAM_CL_KERNEL_CACHE_PATH");
+    if (env)
+        cache_path.assign (env, strlen (env));
+    return cache_path;
+}
+
+/*
+ * bundle file layout, all integers in host byte order
+ *   magic[8], version(uint32), count(uint32), device_tag[16]
+ *   count * { key_len(uint32), binary_len(uint32), key, binary }
+ */
+struct KernelBundleHeader {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  count;
+    char      device_tag[16];
+};
+
+static const char kernel_bundle_magic[8] = {'X', 'C', 'A', 'M', 'K', 'B', 'D', 'L'};
+
 static void
-get_string_key_id (const char *str, uint32_t len, uint8_t key_id[8])
+load_kernel_bundle (CLKernel::BundleMap &bundle)
 {
-    uint32_t key[2];
-    uint32_t *ptr = (uint32_t*)(str);
-    uint32_t aligned_len = 0;
-    uint32_t i = 0;
+    std::string bundle_file = CLKernel::get_cache_path () + "/" XCAM_CL_KERNEL_BUNDLE_NAME;
+    const char *env = std::getenv ("XCAM_CL_KERNEL_BUNDLE");
+    if (env)
+        bundle_file.assign (env, strlen (env));
 
-    xcam_mem_clear (key);
-    if (!len)
-        len = strlen (str);
-    aligned_len = XCAM_ALIGN_DOWN (len, 8);
+    FileHandle file;
+    if (file.open (bundle_file.c_str (), "rb") != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_DEBUG ("no kernel bundle found in %s", bundle_file.c_str ());
+        return;
+    }
 
-    for (i = 0; i < aligned_len / 8; ++i) {
-        key[0] ^= ptr[0];
-        key[1] ^= ptr[1];
-        ptr += 2;
+    KernelBundleHeader header;
+    if (file.read_file (&header, sizeof (header)) != XCAM_RETURN_NO_ERROR ||
+            memcmp (header.magic, kernel_bundle_magic, sizeof (header.magic)) ||
+            header.version != XCAM_CL_KERNEL_BUNDLE_VERSION) {
+        XCAM_LOG_WARNING ("kernel bundle %s is invalid or of other version, ignored", bundle_file.c_str ());
+        return;
     }
-    memcpy (key_id, key, 8);
-    len -= aligned_len;
-    str += aligned_len;
-    for (i = 0; i < len; ++i) {
-        key_id[i] ^= (uint8_t)str[i];
+    if (strncmp (header.device_tag, CLKernel::get_device_tag (), sizeof (header.device_tag))) {
+        XCAM_LOG_WARNING ("kernel bundle %s was built for other device or driver, ignored", bundle_file.c_str ());
+        return;
     }
+
+    for (uint32_t i = 0; i < header.count; ++i) {
+        uint32_t lens[2];
+        if (file.read_file (lens, sizeof (lens)) != XCAM_RETURN_NO_ERROR ||
+                !lens[0] || lens[0] >= XCAM_MAX_STR_SIZE || !lens[1]) {
+            XCAM_LOG_WARNING ("kernel bundle %s is broken at entry %d", bundle_file.c_str (), i);
+            break;
+        }
+
+        std::string key (lens[0], '\0');
+        std::vector<uint8_t> binary (lens[1]);
+        if (file.read_file (&key[0], lens[0]) != XCAM_RETURN_NO_ERROR ||
+                file.read_file (&binary[0], lens[1]) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING ("kernel bundle %s is broken at entry %d", bundle_file.c_str (), i);
+            break;
+        }
+        bundle[key].swap (binary);
+    }
+
+    XCAM_LOG_INFO ("loaded %d kernels from bundle %s", (uint32_t)bundle.size (), bundle_file.c_str ());
 }
 
 XCamReturn
-CLKernel::build_kernel (const XCamKernelInfo& info, const char* options)
+CLKernel::pack_kernel_bundle (const char *cache_path, const char *bundle_file)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, cache_path && bundle_file, XCAM_RETURN_ERROR_PARAM,
+        "pack kernel bundle failed, cache path or bundle file is empty");
+
+    DIR *dir = opendir (cache_path);
+    XCAM_FAIL_RETURN (
+        ERROR, dir, XCAM_RETURN_ERROR_FILE,
+        "pack kernel bundle failed, open cache path %s failed", cache_path);
+
+    std::string suffix = std::string ("#") + get_device_tag ();
+    std::vector<std::string> keys;
+    struct dirent *entry = NULL;
+    while ((entry = readdir (dir)) != NULL) {
+        size_t len = strlen (entry->d_name);
+        if (len > suffix.length () &&
+                !strcmp (entry->d_name + len - suffix.length (), suffix.c_str ()))
+            keys.push_back (entry->d_name);
+    }
+    closedir (dir);
+
+    FileHandle file;
+    XCamReturn ret = file.open (bundle_file, "wb");
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "pack kernel bundle failed, open %s failed", bundle_file);
+
+    KernelBundleHeader header;
+    xcam_mem_clear (header);
+    memcpy (header.magic, kernel_bundle_magic, sizeof (header.magic));
+    header.version = XCAM_CL_KERNEL_BUNDLE_VERSION;
+    header.count = keys.size ();
+    memcpy (header.device_tag, get_device_tag (), sizeof (header.device_tag));
+    ret = file.write_file (&header, sizeof (header));
+
+    for (size_t i = 0; i < keys.size () && xcam_ret_is_ok (ret); ++i) {
+        std::string name = std::string (cache_path) + "/" + keys[i];
+        FileHandle cache_file;
+        size_t size = 0;
+
+        ret = cache_file.open (name.c_str (), "rb");
+        if (xcam_ret_is_ok (ret))
+            ret = cache_file.get_file_size (size);
+        if (xcam_ret_is_ok (ret) && !size)
+            ret = XCAM_RETURN_ERROR_FILE;
+
+        std::vector<uint8_t> binary (size);
+        if (xcam_ret_is_ok (ret))
+            ret = cache_file.read_file (&binary[0], size);
+
+        uint32_t lens[2] = {(uint32_t)keys[i].length (), (uint32_t)size};
+        if (xcam_ret_is_ok (ret))
+            ret = file.write_file (lens, sizeof (lens));
+        if (xcam_ret_is_ok (ret))
+            ret = file.write_file (keys[i].c_str (), lens[0]);
+        if (xcam_ret_is_ok (ret))
+            ret = file.write_file (&binary[0], size);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "pack kernel bundle failed on %s", name.c_str ());
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "pack kernel bundle failed, write %s failed", bundle_file);
+
+    XCAM_LOG_INFO ("packed %d kernels into %s", header.count, bundle_file);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLKernel::build_kernel (const XCamKernelInfo& info, const char* options, CLPrecision precision)
 {
     KernelMap::iterator i_kernel;
     SmartPtr<CLKernel> single_kernel;
     char key_str[1024];
-    uint8_t body_key[8];
+    uint64_t source_key = 0;
     std::string key;
+    std::string fp16_options;
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_FAIL_RETURN (ERROR, info.kernel_name, XCAM_RETURN_ERROR_PARAM, "build kernel failed since kernel name null");
 
-    xcam_mem_clear (body_key);
-    get_string_key_id (info.kernel_body, info.kernel_body_len, body_key);
+    if (precision == CLPrecisionHalf) {
+        if (CLDevice::instance ()->get_device_info ().fp16_supported) {
+            fp16_options = options ? options : "";
+            fp16_options += " -DENABLE_FP16=1";
+            options = fp16_options.c_str ();
+        } else {
+            XCAM_LOG_WARNING ("kernel(%s) falls back to float since device doesn't support fp16", info.kernel_name);
+        }
+    }
+
+    source_key = hash_string (
+        info.kernel_body, info.kernel_body_len ? info.kernel_body_len : strlen (info.kernel_body));
+    source_key = hash_string ("#", 1, source_key);
+    source_key = hash_string (XCAM_STR (options), strlen (XCAM_STR (options)), source_key);
     snprintf (
         key_str, sizeof(key_str),
-        "%s#%02x%02x%02x%02x%02x%02x%02x%02x#%s",
-        info.kernel_name,
-        body_key[0], body_key[1], body_key[2], body_key[3], body_key[4], body_key[5], body_key[6], body_key[7],
-        XCAM_STR(options));
+        "%s#%016" PRIx64 "#%s",
+        info.kernel_name, source_key, get_device_tag ());
     key = key_str;
 
     char temp_filename[XCAM_MAX_STR_SIZE] = {0};
@@ -136,64 +309,92 @@ CLKernel::build_kernel (const XCamKernelInfo& info, const char* options)
     bool load_cache = false;
     struct timeval ts;
 
-    std::string cache_path = _kernel_cache_path;
-    const char *env = std::getenv ("XCAM_CL_KERNEL_CACHE_PATH");
-    if (env)
-        cache_path.assign (env, strlen (env));
+    std::string cache_path = get_cache_path ();
 
     snprintf (
         cache_filename, XCAM_MAX_STR_SIZE - 1,
         "%s/%s",
         cache_path.c_str (), key_str);
 
+    std::vector<uint8_t> bundle_binary;
     {
         SmartLock locker (_kernel_map_mutex);
 
         i_kernel = _kernel_map.find (key);
-        if (i_kernel == _kernel_map.end ()) {
-            SmartPtr<CLContext>  context = get_context ();
-            single_kernel = new CLKernel (context, info.kernel_name);
-            XCAM_ASSERT (single_kernel.ptr ());
+        if (i_kernel != _kernel_map.end ()) {
+            single_kernel = i_kernel->second;
+        } else {
+            if (!_bundle_loaded) {
+                load_kernel_bundle (_bundle_map);
+                _bundle_loaded = true;
+            }
 
-            if (access (cache_path.c_str (), F_OK) == -1) {
-                mkdir (cache_path.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+            BundleMap::iterator i_bundle = _bundle_map.find (key);
+            if (i_bundle != _bundle_map.end ()) {
+                bundle_binary.swap (i_bundle->second);
+                _bundle_map.erase (i_bundle);
             }
+        }
+    }
 
-            ret = cache_file.open (cache_filename, "r");
-            if (ret == XCAM_RETURN_NO_ERROR) {
-                cache_file.get_file_size (read_cache_size);
-                if (read_cache_size > 0) {
-                    kernel_cache = (uint8_t*) xcam_malloc0 (sizeof (uint8_t) * (read_cache_size + 1));
-                    if (NULL != kernel_cache) {
-                        cache_file.read_file (kernel_cache, read_cache_size);
-                        cache_file.close ();
+    // build without lock, so different kernels can be built in parallel
+    if (!single_kernel.ptr ()) {
+        SmartPtr<CLContext>  context = get_context ();
+        single_kernel = new CLKernel (context, info.kernel_name);
+        XCAM_ASSERT (single_kernel.ptr ());
 
-                        ret = single_kernel->load_from_binary (kernel_cache, read_cache_size);
-                        xcam_free (kernel_cache);
-                        kernel_cache = NULL;
+        if (!bundle_binary.empty ()) {
+            ret = single_kernel->load_from_binary (&bundle_binary[0], bundle_binary.size ());
+            if (ret == XCAM_RETURN_NO_ERROR) {
+                load_cache = true;
+            } else {
+                XCAM_LOG_WARNING ("build kernel(%s) from bundle failed, try cache", key_str);
+            }
+        }
 
-                        XCAM_FAIL_RETURN (
-                            ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-                            "build kernel(%s) from binary failed", key_str);
+        if (!load_cache && access (cache_path.c_str (), F_OK) == -1) {
+            mkdir (cache_path.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+        }
 
+        ret = load_cache ? XCAM_RETURN_BYPASS : cache_file.open (cache_filename, "r");
+        if (ret == XCAM_RETURN_NO_ERROR) {
+            cache_file.get_file_size (read_cache_size);
+            if (read_cache_size > 0) {
+                kernel_cache = (uint8_t*) xcam_malloc0 (sizeof (uint8_t) * (read_cache_size + 1));
+                if (NULL != kernel_cache) {
+                    cache_file.read_file (kernel_cache, read_cache_size);
+                    cache_file.close ();
+
+                    ret = single_kernel->load_from_binary (kernel_cache, read_cache_size);
+                    xcam_free (kernel_cache);
+                    kernel_cache = NULL;
+
+                    // stale or broken cache, rebuild from source and overwrite it
+                    if (ret == XCAM_RETURN_NO_ERROR) {
                         load_cache = true;
+                    } else {
+                        XCAM_LOG_WARNING ("build kernel(%s) from cache failed, rebuild from source", key_str);
                     }
                 }
-            } else {
-                XCAM_LOG_DEBUG ("open kernel cache file to read failed ret(%d)", ret);
             }
+        } else if (!load_cache) {
+            XCAM_LOG_DEBUG ("open kernel cache file to read failed ret(%d)", ret);
+        }
 
-            if (load_cache == false) {
-                ret = single_kernel->load_from_source (info.kernel_body, strlen (info.kernel_body), &kernel_cache, &write_cache_size, options);
-                XCAM_FAIL_RETURN (
-                    ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
-                    "build kernel(%s) from source failed", key_str);
-            }
+        if (load_cache == false) {
+            ret = single_kernel->load_from_source (info.kernel_body, strlen (info.kernel_body), &kernel_cache, &write_cache_size, options);
+            XCAM_FAIL_RETURN (
+                ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+                "build kernel(%s) from source failed", key_str);
+        }
 
-            _kernel_map.insert (std::make_pair (key, single_kernel));
-            //_kernel_map[key] = single_kernel;
-        } else {
+        SmartLock locker (_kernel_map_mutex);
+        i_kernel = _kernel_map.find (key);
+        if (i_kernel != _kernel_map.end ()) {
+            // same kernel built by other thread meanwhile
             single_kernel = i_kernel->second;
+        } else {
+            _kernel_map.insert (std::make_pair (key, single_kernel));
         }
     }
 
@@ -228,6 +429,7 @@ CLKernel::build_kernel (const XCamKernelInfo& info, const char* options)
     XCAM_FAIL_RETURN (
         ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
         "load kernel(%s) from kernel failed", key_str);
+    _source_key = source_key;
     return ret;
 }
 
@@ -357,9 +559,126 @@ CLKernel::set_arguments (const CLArgList &args, const CLWorkSize &work_size)
         (int)work_size.local[0], (int)work_size.local[1], (int)work_size.local[2]);
 
     _arg_list = args;
+
+    // arguments set without slots, cached values are stale
+    CLArgSlots &cache = get_kernel_arg_cache ();
+    for (CLArgSlots::iterator iter = cache.begin (); iter != cache.end (); ++iter)
+        iter->bound = false;
+
     return ret;
 }
 
+XCamReturn
+CLKernel::declare_arg_slots (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count && _arg_list.empty (), XCAM_RETURN_ERROR_PARAM,
+        "cl kernel(%s) declare %d argument slots failed", get_kernel_name (), count);
+
+    _arg_slots.clear ();
+    _arg_slots.resize (count);
+    _slots_committed = false;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLKernel::bind_arg_value (uint32_t index, const void *value, uint32_t size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _arg_slots.size () && value && size, XCAM_RETURN_ERROR_PARAM,
+        "cl kernel(%s) bind argc(%d) failed, %d slots declared",
+        get_kernel_name (), index, (int)_arg_slots.size ());
+
+    CLArgSlot &slot = _arg_slots[index];
+    slot.value.assign ((const uint8_t *)value, (const uint8_t *)value + size);
+    slot.serial = 0;
+    slot.mem.release ();
+    slot.bound = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLKernel::bind_mem_arg (uint32_t index, const SmartPtr<CLMemory> &mem)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _arg_slots.size () && mem.ptr () && mem->is_valid (), XCAM_RETURN_ERROR_PARAM,
+        "cl kernel(%s) bind memory argc(%d) failed, %d slots declared",
+        get_kernel_name (), index, (int)_arg_slots.size ());
+
+    CLArgSlot &slot = _arg_slots[index];
+    const cl_mem &mem_id = mem->get_mem_id ();
+    slot.value.assign ((const uint8_t *)&mem_id, (const uint8_t *)&mem_id + sizeof (cl_mem));
+    slot.serial = mem->get_serial ();
+    slot.mem = mem;
+    slot.bound = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLKernel::commit_arg_slots (const CLWorkSize &work_size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_arg_slots.empty () && !is_arguments_set (), XCAM_RETURN_ERROR_PARAM,
+        "cl kernel(%s) commit argument slots failed, no slot declared or arguments already set",
+        get_kernel_name ());
+
+    for (uint32_t i = 0; i < _arg_slots.size (); ++i) {
+        const CLArgSlot &slot = _arg_slots[i];
+        XCAM_FAIL_RETURN (
+            ERROR, slot.bound && (!slot.serial || slot.mem.ptr ()), XCAM_RETURN_ERROR_PARAM,
+            "cl kernel(%s) commit argument slots failed, argc(%d) not bound", get_kernel_name (), i);
+    }
+
+    XCamReturn ret = set_work_size (work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "cl kernel(%s) commit argument slots failed on work size", get_kernel_name ());
+
+    _slots_committed = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLKernel::release_arg_slots ()
+{
+    // cached serials still tell unchanged memory on next bind
+    for (CLArgSlots::iterator iter = _arg_slots.begin (); iter != _arg_slots.end (); ++iter)
+        iter->mem.release ();
+}
+
+CLKernel::CLArgSlots &
+CLKernel::get_kernel_arg_cache ()
+{
+    if (_parent_kernel.ptr ())
+        return _parent_kernel->_kernel_arg_cache;
+    return _kernel_arg_cache;
+}
+
+XCamReturn
+CLKernel::sync_arg_slots ()
+{
+    CLArgSlots &cache = get_kernel_arg_cache ();
+    if (cache.size () < _arg_slots.size ())
+        cache.resize (_arg_slots.size ());
+
+    for (uint32_t i = 0; i < _arg_slots.size (); ++i) {
+        CLArgSlot &slot = _arg_slots[i];
+        if (slot.same_value (cache[i]))
+            continue;
+
+        XCamReturn ret = set_argument (i, &slot.value[0], slot.value.size ());
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "cl kernel(%s) set argc(%d) failed", get_kernel_name (), i);
+
+        cache[i].value = slot.value;
+        cache[i].serial = slot.serial;
+        cache[i].bound = true;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLKernel::set_argument (uint32_t arg_i, void *arg_addr, uint32_t arg_size)
 {
@@ -422,10 +741,16 @@ struct KernelUserData {
     SmartPtr<CLKernel>  kernel;
     SmartPtr<CLEvent>   event;
     CLArgList           arg_list;
+    std::vector<SmartPtr<CLMemory> > mem_list;
+    // launch queued time if profiled, 0 otherwise
+    int64_t             queued_time;
+    int64_t             frame_ts;
 
     KernelUserData (const SmartPtr<CLKernel> &k, SmartPtr<CLEvent> &e)
         : kernel (k)
         , event (e)
+        , queued_time (0)
+        , frame_ts (InvalidTimestamp)
     {}
 };
 
@@ -434,24 +759,337 @@ CLKernel::event_notify (cl_event event, cl_int status, void* data)
 {
     KernelUserData *kernel_data = (KernelUserData *)data;
     XCAM_ASSERT (event == kernel_data->event->get_event_id ());
-    XCAM_UNUSED (status);
-    XCAM_UNUSED (event);
+
+    if (kernel_data->queued_time && status == CL_COMPLETE)
+        CLKernelProfiler::instance ()->collect (
+            kernel_data->kernel->get_kernel_name (), event, kernel_data->queued_time, kernel_data->frame_ts);
 
     delete kernel_data;
 }
 
+enum WorkSizeMode {
+    WorkSizeFixed = 0,
+    WorkSizeCached,
+    WorkSizeTune,
+};
+
+/*
+ * local size tuning of launches keyed by kernel source, options and global size,
+ * candidates are timed one by one over successive launches.
+ */
+class WorkSizeTuner
+{
+    struct Entry {
+        std::vector<CLWorkSize>  candidates;
+        uint32_t                 index;
+        uint32_t                 runs;
+        int64_t                  best_time;
+        CLWorkSize               best;
+        bool                     done;
+
+        Entry () : index (0), runs (0), best_time (-1), done (false) {}
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+public:
+    static WorkSizeTuner *instance () {
+        static WorkSizeTuner tuner;
+        return &tuner;
+    }
+
+    WorkSizeMode get_mode () const {
+        return _mode;
+    }
+
+    // picks local size of next launch in @work_size, returns true if the launch need be timed
+    bool choose (const std::string &key, CLWorkSize &work_size, size_t max_group_size);
+    // @duration in microseconds, negative if launch failed
+    void report (const std::string &key, const CLWorkSize &work_size, int64_t duration);
+
+private:
+    WorkSizeTuner ();
+    void load ();
+    void save ();
+    void generate_candidates (const CLWorkSize &work_size, size_t max_group_size, std::vector<CLWorkSize> &candidates);
+    void finish_entry (const std::string &key, Entry &entry);
+
+private:
+    WorkSizeMode     _mode;
+    std::string      _file;
+    bool             _read_only;
+    bool             _loaded;
+    bool             _timing;
+    EntryMap         _entries;
+    Mutex            _mutex;
+};
+
+WorkSizeTuner::WorkSizeTuner ()
+    : _mode (WorkSizeCached)
+    , _read_only (false)
+    , _loaded (false)
+    , _timing (false)
+{
+    const char *env = std::getenv ("XCAM_CL_WORK_SIZE");
+    if (env) {
+        if (!strcmp (env, "fixed"))
+            _mode = WorkSizeFixed;
+        else if (!strcmp (env, "tune"))
+            _mode = WorkSizeTune;
+        else if (strcmp (env, "cached"))
+            XCAM_LOG_WARNING ("unknown XCAM_CL_WORK_SIZE(%s), use cached", env);
+    }
+
+    env = std::getenv ("XCAM_CL_WORK_SIZE_FILE");
+    if (env) {
+        _file = env;
+        _read_only = true;
+        if (_mode == WorkSizeTune) {
+            XCAM_LOG_WARNING ("XCAM_CL_WORK_SIZE_FILE set, local sizes are not tuned");
+            _mode = WorkSizeCached;
+        }
+    }
+}
+
+/*
+ * one launch each line,
+ *   <kernel name>#<source key> dim global[3] local[3]
+ */
+void
+WorkSizeTuner::load ()
+{
+    _loaded = true;
+    if (_file.empty ())
+        _file = CLKernel::get_cache_path () + "/" XCAM_CL_WORK_SIZE_FILE_PREFIX + CLKernel::get_device_tag ();
+
+    FILE *fp = fopen (_file.c_str (), "r");
+    if (!fp) {
+        XCAM_LOG_DEBUG ("no tuned work size file(%s)", _file.c_str ());
+        return;
+    }
+
+    char line[1024];
+    char name[512];
+    uint32_t dim = 0, global[3], local[3];
+    while (fgets (line, sizeof (line), fp)) {
+        if (sscanf (line, "%511s %u %u %u %u %u %u %u", name, &dim,
+                    &global[0], &global[1], &global[2], &local[0], &local[1], &local[2]) != 8 ||
+                dim == 0 || dim > 3)
+            continue;
+
+        Entry entry;
+        entry.best.dim = dim;
+        for (uint32_t i = 0; i < 3; ++i) {
+            entry.best.global[i] = global[i];
+            entry.best.local[i] = local[i];
+        }
+        entry.done = true;
+
+        char key[1024];
+        snprintf (key, sizeof (key), "%s %u %u %u %u", name, dim, global[0], global[1], global[2]);
+        _entries[key] = entry;
+    }
+    fclose (fp);
+    XCAM_LOG_INFO ("loaded %d tuned work sizes from %s", (int)_entries.size (), _file.c_str ());
+}
+
+void
+WorkSizeTuner::save ()
+{
+    if (_read_only)
+        return;
+
+    std::string cache_path = CLKernel::get_cache_path ();
+    if (access (cache_path.c_str (), F_OK) == -1)
+        mkdir (cache_path.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    char temp_file[XCAM_MAX_STR_SIZE];
+    snprintf (
+        temp_file, sizeof (temp_file), "%s." XCAM_TIMESTAMP_FORMAT,
+        _file.c_str (), XCAM_TIMESTAMP_ARGS (XCAM_TIMEVAL_2_USEC (ts)));
+
+    FILE *fp = fopen (temp_file, "w");
+    if (!fp) {
+        XCAM_LOG_WARNING ("open work size file(%s) to write failed", temp_file);
+        return;
+    }
+
+    bool ok = true;
+    for (EntryMap::iterator iter = _entries.begin (); iter != _entries.end (); ++iter) {
+        const Entry &entry = iter->second;
+        if (!entry.done)
+            continue;
+
+        uint32_t global[3] = {0, 0, 0}, local[3] = {0, 0, 0};
+        for (uint32_t i = 0; i < entry.best.dim && i < 3; ++i) {
+            global[i] = entry.best.global[i];
+            local[i] = entry.best.local[i];
+        }
+        std::string name = iter->first.substr (0, iter->first.find (' '));
+        if (fprintf (
+                    fp, "%s %u %u %u %u %u %u %u\n", name.c_str (), entry.best.dim,
+                    global[0], global[1], global[2], local[0], local[1], local[2]) < 0)
+            ok = false;
+    }
+
+    if (fclose (fp) == 0 && ok) {
+        rename (temp_file, _file.c_str ());
+    } else {
+        XCAM_LOG_WARNING ("write work size file(%s) failed", temp_file);
+        remove (temp_file);
+    }
+}
+
+void
+WorkSizeTuner::generate_candidates (
+    const CLWorkSize &work_size, size_t max_group_size, std::vector<CLWorkSize> &candidates)
+{
+    static const size_t sizes_x[] = {4, 8, 16, 32, 64, 128, 256};
+    static const size_t sizes_y[] = {1, 2, 4, 8, 16};
+    const CLDevieInfo &dev_info = CLDevice::instance ()->get_device_info ();
+
+    // kernel's own local size is timed first
+    candidates.push_back (work_size);
+
+    uint32_t count_y = (work_size.dim > 1 ? sizeof (sizes_y) / sizeof (sizes_y[0]) : 1);
+    for (uint32_t y = 0; y < count_y; ++y) {
+        for (uint32_t x = 0; x < sizeof (sizes_x) / sizeof (sizes_x[0]); ++x) {
+            CLWorkSize candidate = work_size;
+            candidate.local[0] = sizes_x[x];
+            if (work_size.dim > 1)
+                candidate.local[1] = sizes_y[y];
+
+            size_t group_size = 1;
+            bool valid = true;
+            for (uint32_t i = 0; i < candidate.dim; ++i) {
+                group_size *= candidate.local[i];
+                if (candidate.local[i] > dev_info.max_work_item_sizes[i] ||
+                        candidate.global[i] % candidate.local[i])
+                    valid = false;
+            }
+            if (!valid || group_size > max_group_size)
+                continue;
+
+            bool same = true;
+            for (uint32_t i = 0; i < candidate.dim; ++i)
+                same = same && candidate.local[i] == work_size.local[i];
+            if (!same)
+                candidates.push_back (candidate);
+        }
+    }
+}
+
+bool
+WorkSizeTuner::choose (const std::string &key, CLWorkSize &work_size, size_t max_group_size)
+{
+    SmartLock locker (_mutex);
+    if (!_loaded)
+        load ();
+
+    EntryMap::iterator iter = _entries.find (key);
+    if (iter != _entries.end () && iter->second.done) {
+        for (uint32_t i = 0; i < work_size.dim; ++i)
+            work_size.local[i] = iter->second.best.local[i];
+        return false;
+    }
+
+    // one launch timed at a time, others keep kernel's local size meanwhile
+    if (_mode != WorkSizeTune || _timing)
+        return false;
+
+    if (iter == _entries.end ()) {
+        Entry entry;
+        entry.best = work_size;
+        generate_candidates (work_size, max_group_size, entry.candidates);
+        iter = _entries.insert (std::make_pair (key, entry)).first;
+        XCAM_LOG_DEBUG ("tune work size(%s) with %d candidates", key.c_str (), (int)entry.candidates.size ());
+    }
+
+    Entry &entry = iter->second;
+    XCAM_ASSERT (entry.index < entry.candidates.size ());
+    for (uint32_t i = 0; i < work_size.dim; ++i)
+        work_size.local[i] = entry.candidates[entry.index].local[i];
+
+    _timing = true;
+    return true;
+}
+
+void
+WorkSizeTuner::report (const std::string &key, const CLWorkSize &work_size, int64_t duration)
+{
+    SmartLock locker (_mutex);
+    XCAM_ASSERT (_timing);
+    _timing = false;
+
+    EntryMap::iterator iter = _entries.find (key);
+    XCAM_ASSERT (iter != _entries.end ());
+    Entry &entry = iter->second;
+
+    if (duration >= 0 && (entry.best_time < 0 || duration < entry.best_time)) {
+        entry.best_time = duration;
+        entry.best = work_size;
+    }
+
+    if (duration < 0 || ++entry.runs >= XCAM_CL_WORK_SIZE_TUNE_RUNS) {
+        entry.runs = 0;
+        if (++entry.index >= entry.candidates.size ())
+            finish_entry (key, entry);
+    }
+}
+
+void
+WorkSizeTuner::finish_entry (const std::string &key, Entry &entry)
+{
+    entry.done = true;
+    entry.candidates.clear ();
+    XCAM_LOG_INFO (
+        "tuned work size(%s) local(%d, %d, %d) in %" PRId64 "us",
+        key.c_str (), (int)entry.best.local[0], (int)entry.best.local[1], (int)entry.best.local[2],
+        entry.best_time);
+    save ();
+}
+
+static bool
+get_tune_key (
+    const char *name, uint64_t source_key, const CLWorkSize &work_size, std::string &key)
+{
+    for (uint32_t i = 0; i < work_size.dim; ++i) {
+        // sub region launches and driver chosen local sizes are not tuned
+        if (work_size.offset[i] || !work_size.local[i])
+            return false;
+    }
+
+    char key_str[1024];
+    snprintf (
+        key_str, sizeof (key_str), "%s#%016" PRIx64 " %u %u %u %u",
+        XCAM_STR (name), source_key, work_size.dim, (uint32_t)work_size.global[0],
+        (uint32_t)(work_size.dim > 1 ? work_size.global[1] : 0),
+        (uint32_t)(work_size.dim > 2 ? work_size.global[2] : 0));
+    key = key_str;
+    return true;
+}
+
 XCamReturn
 CLKernel::execute (
     const SmartPtr<CLKernel> self,
     bool block,
     CLEventList &events,
-    SmartPtr<CLEvent> &event_out)
+    SmartPtr<CLEvent> &event_out,
+    SmartPtr<CLCommandQueue> queue)
 {
     XCAM_ASSERT (self.ptr () == this);
     XCAM_ASSERT (_context.ptr ());
     SmartPtr<CLEvent> kernel_event = event_out;
+    XCAM_TRACE_SCOPE (_name, InvalidTimestamp);
 
-    if (!block && !kernel_event.ptr ()) {
+    // profiled launches need an event even if blocking
+    bool profiled = CLKernelProfiler::instance ()->is_enabled ();
+    CLKernelBatch *batch = NULL;
+    if (!block && !profiled && !kernel_event.ptr ())
+        batch = CLKernelBatch::current ();
+
+    if ((!block || profiled) && !kernel_event.ptr () && !batch) {
         kernel_event = new CLEvent;
     }
 
@@ -459,7 +1097,51 @@ CLKernel::execute (
     XCAM_OBJ_PROFILING_START;
 #endif
 
-    XCamReturn ret = _context->execute_kernel (self, NULL, events, kernel_event);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (!_arg_slots.empty () && _arg_list.empty ()) {
+        ret = sync_arg_slots ();
+        XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "kernel(%s) sync argument slots failed", XCAM_STR(_name));
+    }
+
+    std::string tune_key;
+    bool timed = false;
+    int64_t start_time = 0;
+    CLWorkSize kernel_work_size = _work_size;
+    WorkSizeTuner *tuner = WorkSizeTuner::instance ();
+    if (_work_size_tunable && tuner->get_mode () != WorkSizeFixed &&
+            get_tune_key (_name, _source_key, _work_size, tune_key)) {
+        size_t max_group_size = 0;
+        if (clGetKernelWorkGroupInfo (
+                    _kernel_id, CLDevice::instance ()->get_device_id (), CL_KERNEL_WORK_GROUP_SIZE,
+                    sizeof (max_group_size), &max_group_size, NULL) != CL_SUCCESS)
+            max_group_size = CLDevice::instance ()->get_device_info ().max_work_group_size;
+
+        timed = tuner->choose (tune_key, _work_size, max_group_size);
+        if (timed) {
+            // time this launch alone
+            _context->finish (queue);
+            struct timeval ts;
+            gettimeofday (&ts, NULL);
+            start_time = XCAM_TIMEVAL_2_USEC (ts);
+        }
+    }
+
+    int64_t queued_time = profiled ? Tracer::now () : 0;
+    ret = _context->execute_kernel (self, queue, events, kernel_event);
+    if (timed) {
+        int64_t duration = -1;
+        if (ret == XCAM_RETURN_NO_ERROR && _context->finish (queue) == XCAM_RETURN_NO_ERROR) {
+            struct timeval ts;
+            gettimeofday (&ts, NULL);
+            duration = XCAM_TIMEVAL_2_USEC (ts) - start_time;
+        }
+        tuner->report (tune_key, _work_size, duration);
+    }
+    if (ret != XCAM_RETURN_NO_ERROR && !tune_key.empty ()) {
+        XCAM_LOG_WARNING ("kernel(%s) launch with tuned local size failed, retry with its own", XCAM_STR (_name));
+        _work_size = kernel_work_size;
+        ret = _context->execute_kernel (self, queue, events, kernel_event);
+    }
 
     XCAM_FAIL_RETURN (
         ERROR,
@@ -468,23 +1150,45 @@ CLKernel::execute (
         "kernel(%s) execute failed", XCAM_STR(_name));
 
 
-    if (block) {
-        _context->finish ();
+    if (batch) {
+        KernelUserData *user_data = new KernelUserData (self, kernel_event);
+        user_data->arg_list.swap (_arg_list);
+        for (CLArgSlots::iterator iter = _arg_slots.begin (); iter != _arg_slots.end (); ++iter) {
+            if (iter->mem.ptr ())
+                user_data->mem_list.push_back (iter->mem);
+        }
+        if (!batch->hold (queue, user_data)) {
+            // queue out of batch, launch was enqueued without event
+            _context->finish (queue);
+            delete user_data;
+        }
+    } else if (block) {
+        _context->finish (queue);
+        if (profiled)
+            CLKernelProfiler::instance ()->collect (
+                _name, kernel_event->get_event_id (), queued_time, Tracer::get_frame_ts ());
     } else {
         XCAM_ASSERT (kernel_event.ptr () && kernel_event->get_event_id ());
         KernelUserData *user_data = new KernelUserData (self, kernel_event);
+        user_data->queued_time = queued_time;
+        user_data->frame_ts = Tracer::get_frame_ts ();
         user_data->arg_list.swap (_arg_list);
+        for (CLArgSlots::iterator iter = _arg_slots.begin (); iter != _arg_slots.end (); ++iter) {
+            if (iter->mem.ptr ())
+                user_data->mem_list.push_back (iter->mem);
+        }
         ret = _context->set_event_callback (kernel_event, CL_COMPLETE, event_notify, user_data);
         if (ret != XCAM_RETURN_NO_ERROR) {
             XCAM_LOG_WARNING ("kernel(%s) set event callback failed", XCAM_STR (_name));
-            _context->finish ();
+            _context->finish (queue);
             delete user_data;
         }
     }
     _arg_list.clear ();
+    _slots_committed = false;
 
 #if ENABLE_DEBUG_KERNEL
-    _context->finish ();
+    _context->finish (queue);
     char name[1024];
     snprintf (name, 1024, "%s-%p", XCAM_STR (_name), this);
     XCAM_OBJ_PROFILING_END (name, XCAM_OBJ_DUR_FRAME_NUM);
@@ -492,4 +1196,79 @@ CLKernel::execute (
     return ret;
 }
 
+static __thread CLKernelBatch *tls_kernel_batch = NULL;
+
+CLKernelBatch::CLKernelBatch (const SmartPtr<CLContext> &context, const SmartPtr<CLCommandQueue> &queue)
+    : _context (context)
+    , _queue (queue)
+    , _prev (tls_kernel_batch)
+    , _closed (false)
+{
+    XCAM_ASSERT (context.ptr ());
+    XCAM_ASSERT (!queue.ptr () || !queue->is_out_of_order ());
+    tls_kernel_batch = this;
+}
+
+CLKernelBatch::~CLKernelBatch ()
+{
+    close ();
+}
+
+CLKernelBatch *
+CLKernelBatch::current ()
+{
+    return tls_kernel_batch;
+}
+
+bool
+CLKernelBatch::hold (const SmartPtr<CLCommandQueue> &queue, KernelUserData *data)
+{
+    if (_closed || queue.ptr () != _queue.ptr ())
+        return false;
+
+    _held.push_back (data);
+    return true;
+}
+
+void
+CLKernelBatch::marker_notify (cl_event event, cl_int status, void* data)
+{
+    HeldList *held = (HeldList *)data;
+    XCAM_UNUSED (event);
+    XCAM_UNUSED (status);
+
+    for (HeldList::iterator iter = held->begin (); iter != held->end (); ++iter)
+        delete *iter;
+    delete held;
+}
+
+XCamReturn
+CLKernelBatch::close (SmartPtr<CLEvent> &event_out)
+{
+    if (_closed)
+        return XCAM_RETURN_NO_ERROR;
+
+    _closed = true;
+    XCAM_ASSERT (tls_kernel_batch == this);
+    tls_kernel_batch = _prev;
+
+    if (_held.empty ())
+        return XCAM_RETURN_NO_ERROR;
+
+    HeldList *held = new HeldList;
+    held->swap (_held);
+
+    SmartPtr<CLEvent> marker = event_out.ptr () ? event_out : new CLEvent;
+    XCamReturn ret = _context->enqueue_marker (_queue, marker);
+    if (ret == XCAM_RETURN_NO_ERROR)
+        ret = _context->set_event_callback (marker, CL_COMPLETE, marker_notify, held);
+
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("kernel batch of %d launches wait done without marker", (int)held->size ());
+        _context->finish (_queue);
+        marker_notify (NULL, CL_COMPLETE, held);
+    }
+    return ret;
+}
+
 };
@@ -27,7 +27,9 @@
 #include <ocl/cl_argument.h>
 
 #include <CL/cl.h>
+#include <map>
 #include <string>
+#include <vector>
 #include <unistd.h>
 
 #define XCAM_CL_KERNEL_FUNC_SOURCE_BEGIN(func)  \
@@ -39,6 +41,13 @@
 
 #define XCAM_CL_KERNEL_FUNC_END
 
+// default bundle file in kernel cache path, env XCAM_CL_KERNEL_BUNDLE overrides it
+#define XCAM_CL_KERNEL_BUNDLE_NAME "kernels.bundle"
+// tuned local work sizes in kernel cache path, followed by device tag
+#define XCAM_CL_WORK_SIZE_FILE_PREFIX "worksize#"
+// chosen kernel variants in kernel cache path, followed by device tag
+#define XCAM_CL_VARIANT_FILE_PREFIX "variant#"
+
 XCAM_BEGIN_DECLARE
 
 typedef struct _XCamKernelInfo {
@@ -53,6 +62,15 @@ namespace XCam {
 
 class CLContext;
 class CLKernel;
+class CLCommandQueue;
+class CLKernelBatch;
+struct KernelUserData;
+
+// half builds kernels with -DENABLE_FP16=1 if device supports cl_khr_fp16
+enum CLPrecision {
+    CLPrecisionFloat = 0,
+    CLPrecisionHalf,
+};
 
 /*
  * Example to create a kernel
@@ -66,10 +84,13 @@ class CLKernel;
 class CLKernel {
     friend class CLContext;
 public:
+    typedef std::map<std::string, std::vector<uint8_t> > BundleMap;
+
     explicit CLKernel (const SmartPtr<CLContext> &context, const char *name);
     virtual ~CLKernel ();
 
-    XCamReturn build_kernel (const XCamKernelInfo& info, const char* options = NULL);
+    XCamReturn build_kernel (
+        const XCamKernelInfo& info, const char* options = NULL, CLPrecision precision = CLPrecisionFloat);
 
     cl_kernel get_kernel_id () {
         return _kernel_id;
@@ -88,19 +109,61 @@ public:
     const CLWorkSize &get_work_size () const {
         return _work_size;
     }
+    // relaunch with arguments already set, e.g. over sub regions
+    XCamReturn set_work_size (const CLWorkSize &work_size);
+
+    /*
+     * local work size autotuning, only for kernels whose results don't depend on local size,
+     * i.e. no local memory, barriers or group ids.
+     * env XCAM_CL_WORK_SIZE selects the mode,
+     *   "fixed", always launches with local size set by kernel
+     *   "cached", default, launches with local size tuned before if any
+     *   "tune", times local size candidates on first launches of each global size and saves
+     *           the fastest, launches being timed block until done
+     * env XCAM_CL_WORK_SIZE_FILE loads tuned sizes from a given file, which is never written.
+     */
+    void set_work_size_tunable (bool tunable) {
+        _work_size_tunable = tunable;
+    }
+    bool is_work_size_tunable () const {
+        return _work_size_tunable;
+    }
 
     bool is_arguments_set () const {
-        return !_arg_list.empty ();
+        return !_arg_list.empty () || _slots_committed;
     }
     const CLArgList &get_args () const {
         return _arg_list;
     }
 
+    /*
+     * persistent argument slots, instead of set_arguments for kernels launched every frame.
+     * slots are declared once and keep their values between launches, execute only calls
+     * clSetKernelArg for slots changed since last launch on the program kernel, which is
+     * shared by all kernels built from one source.
+     */
+    XCamReturn declare_arg_slots (uint32_t count);
+    uint32_t get_arg_slot_count () const {
+        return _arg_slots.size ();
+    }
+    XCamReturn bind_arg_value (uint32_t index, const void *value, uint32_t size);
+    template<typename DataType>
+    XCamReturn bind_arg (uint32_t index, const DataType &value) {
+        return bind_arg_value (index, &value, sizeof (DataType));
+    }
+    // @mem is held until slot is bound again or released
+    XCamReturn bind_mem_arg (uint32_t index, const SmartPtr<CLMemory> &mem);
+    // all slots need be bound once, sets work size of next launch
+    XCamReturn commit_arg_slots (const CLWorkSize &work_size);
+    // drops memory of all slots, which need be bound again before next launch
+    void release_arg_slots ();
+
     XCamReturn execute (
         const SmartPtr<CLKernel> self,
         bool block = false,
         CLEventList &events = CLEvent::EmptyList,
-        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
+        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent,
+        SmartPtr<CLCommandQueue> queue = NULL);
 
     XCamReturn load_from_source (
         const char *source, size_t length = 0,
@@ -110,9 +173,35 @@ public:
 
     XCamReturn load_from_binary (const uint8_t *binary, size_t length);
 
+    static const char *get_kernel_cache_path () {
+        return _kernel_cache_path;
+    }
+    // kernel cache path, env XCAM_CL_KERNEL_CACHE_PATH overrides it
+    static std::string get_cache_path ();
+    // tag of device and driver the cached binaries and tunings are valid on
+    static const char *get_device_tag ();
+    // pack cached binaries of current device and driver into a bundle loaded on first build_kernel
+    static XCamReturn pack_kernel_bundle (const char *cache_path, const char *bundle_file);
+
 private:
+    // value of one argument, @serial of memory is 0 for plain values
+    struct CLArgSlot {
+        std::vector<uint8_t>  value;
+        uint64_t              serial;
+        SmartPtr<CLMemory>    mem;
+        bool                  bound;
+
+        CLArgSlot () : serial (0), bound (false) {}
+        bool same_value (const CLArgSlot &slot) const {
+            return bound && slot.bound && serial == slot.serial && value == slot.value;
+        }
+    };
+    typedef std::vector<CLArgSlot> CLArgSlots;
+
     XCamReturn set_argument (uint32_t arg_i, void *arg_addr, uint32_t arg_size);
-    XCamReturn set_work_size (const CLWorkSize &work_size);
+    // arguments last set on the program kernel, kept by root kernel
+    CLArgSlots &get_kernel_arg_cache ();
+    XCamReturn sync_arg_slots ();
     void set_default_work_size ();
     void destroy ();
     XCamReturn clone (SmartPtr<CLKernel> kernel);
@@ -126,6 +215,8 @@ private:
     static KernelMap      _kernel_map;
     static Mutex          _kernel_map_mutex;
     static const char    *_kernel_cache_path;
+    static BundleMap      _bundle_map;
+    static bool           _bundle_loaded;
 
 private:
     char                 *_name;
@@ -134,10 +225,53 @@ private:
     SmartPtr<CLKernel>    _parent_kernel;
     CLArgList             _arg_list;
     CLWorkSize            _work_size;
+    CLArgSlots            _arg_slots;
+    bool                  _slots_committed;
+    CLArgSlots            _kernel_arg_cache;
+    uint64_t              _source_key;
+    bool                  _work_size_tunable;
 
     XCAM_OBJ_PROFILING_DEFINES;
 };
 
+/*
+ * CLKernelBatch, while current on this thread, non-blocking launches on @queue without
+ * event_out get neither event nor completion callback, the batch holds their arguments.
+ * close enqueues one marker on @queue and releases all of them once it completes.
+ * @queue must be in-order, launches on other queues are not batched.
+ */
+class CLKernelBatch
+{
+    friend class CLKernel;
+    typedef std::vector<KernelUserData *> HeldList;
+
+public:
+    explicit CLKernelBatch (const SmartPtr<CLContext> &context, const SmartPtr<CLCommandQueue> &queue = NULL);
+    // closes the batch if not closed
+    ~CLKernelBatch ();
+
+    // @event_out is the marker, NULL event if nothing was batched
+    XCamReturn close (SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
+    uint32_t get_launch_count () const {
+        return _held.size ();
+    }
+
+    static CLKernelBatch *current ();
+
+private:
+    bool hold (const SmartPtr<CLCommandQueue> &queue, KernelUserData *data);
+    static void marker_notify (cl_event event, cl_int status, void* data);
+
+    XCAM_DEAD_COPY (CLKernelBatch);
+
+private:
+    SmartPtr<CLContext>         _context;
+    SmartPtr<CLCommandQueue>    _queue;
+    HeldList                    _held;
+    CLKernelBatch              *_prev;
+    bool                        _closed;
+};
+
 };
 
 #endif //XCAM_CL_KERNEL_H
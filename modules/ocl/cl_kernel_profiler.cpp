@@ -0,0 +1,148 @@
+/*
+ * cl_kernel_profiler.cpp - CL kernel profiler
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_kernel_profiler.h"
+#include "cl_kernel.h"
+#include "xcam_trace.h"
+#include <algorithm>
+
+#define XCAM_CL_PROFILING_TRACK "cl-gpu"
+
+namespace XCam {
+
+static void
+dump_at_exit ()
+{
+    CLKernelProfiler::instance ()->dump ();
+}
+
+CLKernelProfiler *
+CLKernelProfiler::instance ()
+{
+    // never destroyed, launches may complete on driver threads at exit
+    static CLKernelProfiler *profiler = new CLKernelProfiler;
+    return profiler;
+}
+
+CLKernelProfiler::CLKernelProfiler ()
+    : _enabled (false)
+    , _unavailable (false)
+{
+    const char *env = std::getenv ("XCAM_CL_PROFILING");
+    if (env && !strcmp (env, "1")) {
+        _enabled = true;
+        atexit (dump_at_exit);
+    }
+}
+
+void
+CLKernelProfiler::collect (const char *kernel, cl_event event, int64_t queued_time, int64_t frame_ts)
+{
+    XCAM_ASSERT (kernel && event);
+
+    cl_ulong queued = 0, start = 0, end = 0;
+    if (clGetEventProfilingInfo (event, CL_PROFILING_COMMAND_QUEUED, sizeof (queued), &queued, NULL) != CL_SUCCESS ||
+            clGetEventProfilingInfo (event, CL_PROFILING_COMMAND_START, sizeof (start), &start, NULL) != CL_SUCCESS ||
+            clGetEventProfilingInfo (event, CL_PROFILING_COMMAND_END, sizeof (end), &end, NULL) != CL_SUCCESS) {
+        // queue created before profiler enabled
+        SmartLock locker (_mutex);
+        if (!_unavailable) {
+            _unavailable = true;
+            XCAM_LOG_WARNING ("kernel(%s) profiling info not available, queue not profiled", kernel);
+        }
+        return;
+    }
+
+    // device clock in nanoseconds, placed on host time by the queued stamp
+    int64_t wait = start > queued ? (int64_t)(start - queued) / 1000 : 0;
+    int64_t gpu = end > start ? (int64_t)(end - start) / 1000 : 0;
+
+    if (Tracer::is_enabled ())
+        Tracer::add_complete (XCAM_CL_PROFILING_TRACK, kernel, queued_time + wait, gpu, frame_ts);
+
+    SmartLock locker (_mutex);
+    Entry &entry = _entries[kernel];
+    if (!entry.gpu.ptr ())
+        entry.gpu = new LatencyStats;
+    entry.gpu->add (gpu);
+    ++entry.launches;
+    entry.gpu_total += gpu;
+    entry.wait_total += wait;
+    entry.wait_max = XCAM_MAX (entry.wait_max, wait);
+}
+
+static bool
+heavier_timing (const CLKernelTiming &a, const CLKernelTiming &b)
+{
+    return a.gpu_total > b.gpu_total;
+}
+
+void
+CLKernelProfiler::get_timings (std::vector<CLKernelTiming> &timings)
+{
+    timings.clear ();
+
+    SmartLock locker (_mutex);
+    for (EntryMap::iterator iter = _entries.begin (); iter != _entries.end (); ++iter) {
+        const Entry &entry = iter->second;
+        CLKernelTiming timing;
+        timing.kernel = iter->first;
+        timing.launches = entry.launches;
+        timing.gpu_total = entry.gpu_total;
+        timing.gpu_p50 = entry.gpu->get_percentile (50.0);
+        timing.gpu_p99 = entry.gpu->get_percentile (99.0);
+        timing.gpu_max = entry.gpu->get_max ();
+        timing.wait_avg = entry.launches ? entry.wait_total / (int64_t)entry.launches : 0;
+        timing.wait_max = entry.wait_max;
+        timings.push_back (timing);
+    }
+    std::sort (timings.begin (), timings.end (), heavier_timing);
+}
+
+void
+CLKernelProfiler::reset ()
+{
+    SmartLock locker (_mutex);
+    _entries.clear ();
+}
+
+void
+CLKernelProfiler::dump ()
+{
+    std::vector<CLKernelTiming> timings;
+    get_timings (timings);
+
+    int64_t total = 0;
+    for (uint32_t i = 0; i < timings.size (); ++i)
+        total += timings[i].gpu_total;
+
+    XCAM_LOG_INFO ("CL kernel timings on device(%s), gpu total:%" PRId64 "us", CLKernel::get_device_tag (), total);
+    for (uint32_t i = 0; i < timings.size (); ++i) {
+        const CLKernelTiming &timing = timings[i];
+        XCAM_LOG_INFO (
+            "kernel(%s) launches:%" PRIu64 " gpu total:%" PRId64 "us(%.1f%%) p50:%" PRId64 " p99:%" PRId64
+            " max:%" PRId64 " wait avg:%" PRId64 " max:%" PRId64,
+            timing.kernel.c_str (), timing.launches, timing.gpu_total,
+            total ? timing.gpu_total * 100.0 / total : 0.0,
+            timing.gpu_p50, timing.gpu_p99, timing.gpu_max, timing.wait_avg, timing.wait_max);
+    }
+}
+
+};
@@ -0,0 +1,99 @@
+/*
+ * cl_kernel_profiler.h - CL kernel profiler
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+
+#ifndef XCAM_CL_KERNEL_PROFILER_H
+#define XCAM_CL_KERNEL_PROFILER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <latency_stats.h>
+#include <CL/cl.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace XCam {
+
+// times in microseconds, wait is from launch queued to started on device
+struct CLKernelTiming {
+    std::string     kernel;
+    uint64_t        launches;
+    int64_t         gpu_total;
+    int64_t         gpu_p50;
+    int64_t         gpu_p99;
+    int64_t         gpu_max;
+    int64_t         wait_avg;
+    int64_t         wait_max;
+};
+
+/*
+ * CLKernelProfiler, device time of kernel launches read from profiling info of their events
+ * on completion, aggregated by kernel name and added to the trace on track "cl-gpu".
+ * command queues created while enabled are profiled, enable it before CL context is created.
+ * env XCAM_CL_PROFILING=1 enables it and logs timings at exit. thread-safe.
+ */
+class CLKernelProfiler
+{
+    struct Entry {
+        SmartPtr<LatencyStats>  gpu;
+        uint64_t                launches;
+        int64_t                 gpu_total;
+        int64_t                 wait_total;
+        int64_t                 wait_max;
+
+        Entry () : launches (0), gpu_total (0), wait_total (0), wait_max (0) {}
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+public:
+    static CLKernelProfiler *instance ();
+
+    void enable (bool enable) {
+        _enabled.store (enable, std::memory_order_relaxed);
+    }
+    bool is_enabled () const {
+        return _enabled.load (std::memory_order_relaxed);
+    }
+
+    // @event complete, @queued_time is Tracer::now () when the launch was queued
+    void collect (const char *kernel, cl_event event, int64_t queued_time, int64_t frame_ts);
+
+    // heaviest kernels first
+    void get_timings (std::vector<CLKernelTiming> &timings);
+    void reset ();
+    void dump ();
+
+private:
+    CLKernelProfiler ();
+
+    XCAM_DEAD_COPY (CLKernelProfiler);
+
+private:
+    std::atomic<bool>   _enabled;
+    bool                _unavailable;
+    EntryMap            _entries;
+    Mutex               _mutex;
+};
+
+};
+
+#endif //XCAM_CL_KERNEL_PROFILER_H
@@ -0,0 +1,320 @@
+/*
+ * cl_kernel_variants.cpp - CL kernel variants selection
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_kernel_variants.h"
+#include "cl_kernel.h"
+#include <xcam_mutex.h>
+#include <sys/stat.h>
+#include <map>
+
+// first frame of each variant warms up, the fastest of the timed ones counts
+#define XCAM_CL_VARIANT_WARMUP_RUNS 1
+#define XCAM_CL_VARIANT_TUNE_RUNS 3
+
+namespace XCam {
+
+enum VariantMode {
+    VariantFixed = 0,
+    VariantCached,
+    VariantTune,
+};
+
+/*
+ * choices of all stages keyed by stage and resolution,
+ * one frame of all stages is timed at a time.
+ */
+class VariantSelector
+{
+    struct Entry {
+        uint32_t     index;
+        uint32_t     runs;
+        int64_t      best_time;
+        std::string  best;
+        bool         done;
+
+        Entry () : index (0), runs (0), best_time (-1), done (false) {}
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+public:
+    static VariantSelector *instance () {
+        static VariantSelector selector;
+        return &selector;
+    }
+
+    // returns index of variant in @variants, @timed set if the frame need be timed
+    uint32_t choose (const std::string &key, const std::vector<std::string> &variants, bool &timed);
+    // @duration in microseconds, negative if frame failed
+    void report (const std::string &key, const std::vector<std::string> &variants, int64_t duration);
+
+private:
+    VariantSelector ();
+    void load ();
+    void save ();
+
+private:
+    VariantMode      _mode;
+    std::string      _file;
+    bool             _read_only;
+    bool             _loaded;
+    bool             _timing;
+    EntryMap         _entries;
+    Mutex            _mutex;
+};
+
+VariantSelector::VariantSelector ()
+    : _mode (VariantTune)
+    , _read_only (false)
+    , _loaded (false)
+    , _timing (false)
+{
+    const char *env = std::getenv ("XCAM_CL_VARIANT");
+    if (env) {
+        if (!strcmp (env, "fixed"))
+            _mode = VariantFixed;
+        else if (!strcmp (env, "cached"))
+            _mode = VariantCached;
+        else if (strcmp (env, "tune"))
+            XCAM_LOG_WARNING ("unknown XCAM_CL_VARIANT(%s), use tune", env);
+    }
+
+    env = std::getenv ("XCAM_CL_VARIANT_FILE");
+    if (env) {
+        _file = env;
+        _read_only = true;
+        if (_mode == VariantTune)
+            _mode = VariantCached;
+    }
+}
+
+/*
+ * one stage each line,
+ *   <stage> <width> <height> <variant name>
+ */
+void
+VariantSelector::load ()
+{
+    _loaded = true;
+    if (_file.empty ())
+        _file = CLKernel::get_cache_path () + "/" XCAM_CL_VARIANT_FILE_PREFIX + CLKernel::get_device_tag ();
+
+    FILE *fp = fopen (_file.c_str (), "r");
+    if (!fp) {
+        XCAM_LOG_DEBUG ("no kernel variant file(%s)", _file.c_str ());
+        return;
+    }
+
+    char line[1024];
+    char stage[256], name[256];
+    uint32_t width = 0, height = 0;
+    while (fgets (line, sizeof (line), fp)) {
+        if (sscanf (line, "%255s %u %u %255s", stage, &width, &height, name) != 4)
+            continue;
+
+        Entry entry;
+        entry.best = name;
+        entry.done = true;
+
+        char key[1024];
+        snprintf (key, sizeof (key), "%s %u %u", stage, width, height);
+        _entries[key] = entry;
+    }
+    fclose (fp);
+    XCAM_LOG_INFO ("loaded %d kernel variants from %s", (int)_entries.size (), _file.c_str ());
+}
+
+void
+VariantSelector::save ()
+{
+    if (_read_only)
+        return;
+
+    std::string cache_path = CLKernel::get_cache_path ();
+    if (access (cache_path.c_str (), F_OK) == -1)
+        mkdir (cache_path.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    char temp_file[XCAM_MAX_STR_SIZE];
+    snprintf (
+        temp_file, sizeof (temp_file), "%s." XCAM_TIMESTAMP_FORMAT,
+        _file.c_str (), XCAM_TIMESTAMP_ARGS (XCAM_TIMEVAL_2_USEC (ts)));
+
+    FILE *fp = fopen (temp_file, "w");
+    if (!fp) {
+        XCAM_LOG_WARNING ("open kernel variant file(%s) to write failed", temp_file);
+        return;
+    }
+
+    bool ok = true;
+    for (EntryMap::iterator iter = _entries.begin (); iter != _entries.end (); ++iter) {
+        if (!iter->second.done)
+            continue;
+        if (fprintf (fp, "%s %s\n", iter->first.c_str (), iter->second.best.c_str ()) < 0)
+            ok = false;
+    }
+
+    if (fclose (fp) == 0 && ok) {
+        rename (temp_file, _file.c_str ());
+    } else {
+        XCAM_LOG_WARNING ("write kernel variant file(%s) failed", temp_file);
+        remove (temp_file);
+    }
+}
+
+static uint32_t
+find_variant (const std::vector<std::string> &variants, const std::string &name)
+{
+    for (uint32_t i = 0; i < variants.size (); ++i) {
+        if (variants[i] == name)
+            return i;
+    }
+    return 0;
+}
+
+uint32_t
+VariantSelector::choose (const std::string &key, const std::vector<std::string> &variants, bool &timed)
+{
+    timed = false;
+    if (_mode == VariantFixed || variants.size () < 2)
+        return 0;
+
+    SmartLock locker (_mutex);
+    if (!_loaded)
+        load ();
+
+    EntryMap::iterator iter = _entries.find (key);
+    if (iter != _entries.end () && iter->second.done)
+        return find_variant (variants, iter->second.best);
+
+    // other frames keep the default variant while one is timed
+    if (_mode != VariantTune || _timing)
+        return 0;
+
+    if (iter == _entries.end ()) {
+        iter = _entries.insert (std::make_pair (key, Entry ())).first;
+        XCAM_LOG_DEBUG ("time kernel variants(%s) of %d candidates", key.c_str (), (int)variants.size ());
+    }
+
+    Entry &entry = iter->second;
+    XCAM_ASSERT (entry.index < variants.size ());
+    timed = true;
+    _timing = true;
+    return entry.index;
+}
+
+void
+VariantSelector::report (const std::string &key, const std::vector<std::string> &variants, int64_t duration)
+{
+    SmartLock locker (_mutex);
+    XCAM_ASSERT (_timing);
+    _timing = false;
+
+    EntryMap::iterator iter = _entries.find (key);
+    XCAM_ASSERT (iter != _entries.end ());
+    Entry &entry = iter->second;
+
+    ++entry.runs;
+    if (duration >= 0 && entry.runs > XCAM_CL_VARIANT_WARMUP_RUNS &&
+            (entry.best_time < 0 || duration < entry.best_time)) {
+        entry.best_time = duration;
+        entry.best = variants[entry.index];
+    }
+
+    // a failed variant is skipped
+    if (duration < 0 || entry.runs >= XCAM_CL_VARIANT_WARMUP_RUNS + XCAM_CL_VARIANT_TUNE_RUNS) {
+        entry.runs = 0;
+        if (++entry.index < variants.size ())
+            return;
+
+        entry.done = true;
+        if (entry.best.empty ())
+            entry.best = variants[0];
+        XCAM_LOG_INFO (
+            "chose kernel variant(%s) %s in %" PRId64 "us",
+            key.c_str (), entry.best.c_str (), entry.best_time);
+        save ();
+    }
+}
+
+CLKernelVariants::CLKernelVariants (const char *stage)
+    : _stage (XCAM_STR (stage))
+    , _index (0)
+    , _start_time (0)
+    , _timed (false)
+{
+}
+
+void
+CLKernelVariants::add_variant (const char *name)
+{
+    XCAM_ASSERT (name);
+    _variants.push_back (name);
+}
+
+uint32_t
+CLKernelVariants::begin_frame (
+    const SmartPtr<CLContext> &context, const SmartPtr<CLCommandQueue> &queue,
+    uint32_t width, uint32_t height)
+{
+    XCAM_ASSERT (!_variants.empty ());
+
+    // last frame failed before end_frame
+    if (_timed)
+        end_frame (false);
+
+    char key[512];
+    snprintf (key, sizeof (key), "%s %u %u", _stage.c_str (), width, height);
+    _key = key;
+
+    _index = VariantSelector::instance ()->choose (_key, _variants, _timed);
+    if (_timed) {
+        // time this frame alone
+        _context = context;
+        _queue = queue;
+        _context->finish (_queue);
+        struct timeval ts;
+        gettimeofday (&ts, NULL);
+        _start_time = XCAM_TIMEVAL_2_USEC (ts);
+    }
+
+    return _index;
+}
+
+void
+CLKernelVariants::end_frame (bool ok)
+{
+    if (!_timed)
+        return;
+    _timed = false;
+
+    int64_t duration = -1;
+    if (ok && _context->finish (_queue) == XCAM_RETURN_NO_ERROR) {
+        struct timeval ts;
+        gettimeofday (&ts, NULL);
+        duration = XCAM_TIMEVAL_2_USEC (ts) - _start_time;
+    }
+    _context.release ();
+    _queue.release ();
+
+    VariantSelector::instance ()->report (_key, _variants, duration);
+}
+
+};
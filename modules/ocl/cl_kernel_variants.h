@@ -0,0 +1,72 @@
+/*
+ * cl_kernel_variants.h - CL kernel variants selection
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CL_KERNEL_VARIANTS_H
+#define XCAM_CL_KERNEL_VARIANTS_H
+
+#include <xcam_std.h>
+#include <ocl/cl_context.h>
+#include <string>
+#include <vector>
+
+namespace XCam {
+
+/*
+ * CLKernelVariants, alternative implementations of one stage giving the same output.
+ * on first start of a resolution, variants are timed one by one over the first frames and
+ * the fastest one is cached next to kernel binaries, later starts use the cached choice.
+ * env XCAM_CL_VARIANT, "tune"(default), "cached" without timing, or "fixed" on first variant.
+ * env XCAM_CL_VARIANT_FILE, read only file of choices, variants are not timed.
+ */
+class CLKernelVariants
+{
+public:
+    explicit CLKernelVariants (const char *stage);
+
+    // only variants valid on this device and keeping the stage quality need be added, first is default
+    void add_variant (const char *name);
+    uint32_t get_variant_count () const {
+        return _variants.size ();
+    }
+
+    // called before kernels of each frame, returns index of variant to run
+    uint32_t begin_frame (
+        const SmartPtr<CLContext> &context, const SmartPtr<CLCommandQueue> &queue,
+        uint32_t width, uint32_t height);
+    // called after kernels of the frame, @ok is false if any kernel failed
+    void end_frame (bool ok);
+
+private:
+    XCAM_DEAD_COPY (CLKernelVariants);
+
+private:
+    std::string                 _stage;
+    std::vector<std::string>    _variants;
+    std::string                 _key;
+    uint32_t                    _index;
+    SmartPtr<CLContext>         _context;
+    SmartPtr<CLCommandQueue>    _queue;
+    int64_t                     _start_time;
+    bool                        _timed;
+};
+
+};
+
+#endif //XCAM_CL_KERNEL_VARIANTS_H
@@ -0,0 +1,198 @@
+/*
+ * cl_luma_histogram.cpp - CL luma histogram of SGRBG16 planar frames
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "cl_luma_histogram.h"
+#include "cl_context.h"
+
+#define XCAM_CL_LUMA_HIST_LOCAL_X 8
+#define XCAM_CL_LUMA_HIST_LOCAL_Y 8
+
+namespace XCam {
+
+enum {
+    KernelLumaHistClear = 0,
+    KernelLumaHist,
+};
+
+static const XCamKernelInfo kernel_luma_hist_info[] = {
+    {
+        "kernel_luma_hist_clear",
+#include "kernel_luma_hist.clx"
+        , 0,
+    },
+    {
+        "kernel_luma_hist",
+#include "kernel_luma_hist.clx"
+        , 0,
+    },
+};
+
+CLLumaHistogram::CLLumaHistogram (const SmartPtr<CLContext> &context, uint32_t bins, uint32_t block_factor)
+    : _context (context)
+    , _bins (bins)
+    , _block_factor (block_factor)
+    , _counted (false)
+    , _fetched (true)
+{
+    XCAM_ASSERT (bins && block_factor);
+}
+
+CLLumaHistogram::~CLLumaHistogram ()
+{
+    // read back writes into _host_hist
+    if (_read_event.ptr ())
+        _read_event->wait ();
+}
+
+XCamReturn
+CLLumaHistogram::init ()
+{
+    char build_options[128];
+    snprintf (build_options, sizeof (build_options), "-DHIST_BINS=%d -DBLOCK_FACTOR=%d", _bins, _block_factor);
+
+    _clear_kernel = new CLImageKernel (_context, kernel_luma_hist_info[KernelLumaHistClear].kernel_name);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _clear_kernel->build_kernel (kernel_luma_hist_info[KernelLumaHistClear], build_options) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL,
+        "build luma histogram clear kernel failed");
+
+    _count_kernel = new CLImageKernel (_context, kernel_luma_hist_info[KernelLumaHist].kernel_name);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _count_kernel->build_kernel (kernel_luma_hist_info[KernelLumaHist], build_options) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL,
+        "build luma histogram kernel failed");
+
+    uint32_t total_bins = _bins * _block_factor * _block_factor;
+    _hist_buf = new CLBuffer (_context, sizeof (uint32_t) * total_bins, CL_MEM_READ_WRITE);
+    XCAM_FAIL_RETURN (
+        ERROR, _hist_buf->is_valid (), XCAM_RETURN_ERROR_MEM,
+        "luma histogram buffer(%d bins) allocate failed", total_bins);
+    _host_hist.resize (total_bins, 0);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+CLLumaHistogram::is_read_done ()
+{
+    if (!_read_event.ptr ())
+        return true;
+
+    cl_int status = CL_QUEUED;
+    if (!_read_event->get_cl_event_info (CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof (status), &status))
+        status = -1;
+
+    if (status == CL_COMPLETE) {
+        _read_event.release ();
+        _fetched = false;
+        return true;
+    }
+
+    if (status < 0) {
+        XCAM_LOG_WARNING ("luma histogram read back failed with status:%d", status);
+        _read_event.release ();
+        return true;
+    }
+
+    return false;
+}
+
+XCamReturn
+CLLumaHistogram::prepare (const SmartPtr<CLImage> &image, const VideoBufferInfo &info)
+{
+    XCAM_ASSERT (_count_kernel.ptr () && _clear_kernel.ptr ());
+
+    _counted = is_read_done ();
+    _clear_kernel->set_enable (_counted);
+    _count_kernel->set_enable (_counted);
+    if (!_counted)
+        return XCAM_RETURN_NO_ERROR;
+
+    CLArgList args;
+    CLWorkSize work_size;
+
+    args.push_back (new CLMemArgument (_hist_buf));
+    work_size.dim = 1;
+    work_size.global[0] = _host_hist.size ();
+    work_size.local[0] = 0;
+    XCamReturn ret = _clear_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "luma histogram clear kernel set arguments failed");
+
+    const CLImageDesc &desc = image->get_image_desc ();
+    int plane_height = info.aligned_height;
+    int width = info.width;
+    int height = info.height;
+
+    args.clear ();
+    args.push_back (new CLMemArgument (image));
+    args.push_back (new CLArgumentT<int> (plane_height));
+    args.push_back (new CLArgumentT<int> (width));
+    args.push_back (new CLArgumentT<int> (height));
+    args.push_back (new CLMemArgument (_hist_buf));
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = XCAM_CL_LUMA_HIST_LOCAL_X;
+    work_size.local[1] = XCAM_CL_LUMA_HIST_LOCAL_Y;
+    work_size.global[0] = XCAM_ALIGN_UP (desc.width, XCAM_CL_LUMA_HIST_LOCAL_X);
+    work_size.global[1] = XCAM_ALIGN_UP (height, XCAM_CL_LUMA_HIST_LOCAL_Y);
+    ret = _count_kernel->set_arguments (args, work_size);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "luma histogram kernel set arguments failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CLLumaHistogram::read_back (const CLEventList &events)
+{
+    if (!_counted)
+        return XCAM_RETURN_NO_ERROR;
+    _counted = false;
+
+    CLEventList waits = events;
+    SmartPtr<CLEvent> event = new CLEvent;
+    XCamReturn ret = _hist_buf->enqueue_read (
+                         &_host_hist[0], 0, sizeof (uint32_t) * _host_hist.size (), waits, event, false);
+    XCAM_FAIL_RETURN (
+        WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+        "luma histogram enqueue read back failed");
+
+    _read_event = event;
+    // submit now, nothing else may flush the queue before next frame
+    _context->flush ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+const uint32_t *
+CLLumaHistogram::fetch ()
+{
+    if (!is_read_done () || _fetched)
+        return NULL;
+
+    _fetched = true;
+    return &_host_hist[0];
+}
+
+};
@@ -0,0 +1,87 @@
+/*
+ * cl_luma_histogram.h - CL luma histogram of SGRBG16 planar frames
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CL_LUMA_HISTOGRAM_H
+#define XCAM_CL_LUMA_HISTOGRAM_H
+
+#include <xcam_std.h>
+#include <ocl/cl_image_handler.h>
+#include <ocl/cl_memory.h>
+#include <vector>
+
+namespace XCam {
+
+/*
+ * CLLumaHistogram, luma histograms of frames counted on GPU for handlers without 3A stats.
+ * clear and count kernels run in the handler's kernel chain, the result is read back
+ * without blocking after the frame and fetched on a later frame, so no frame waits on it.
+ * frames arriving while a read back is in flight are not counted.
+ */
+class CLLumaHistogram
+{
+public:
+    // @block_factor, histograms of block_factor x block_factor blocks
+    explicit CLLumaHistogram (const SmartPtr<CLContext> &context, uint32_t bins, uint32_t block_factor = 1);
+    ~CLLumaHistogram ();
+
+    uint32_t get_bins () const {
+        return _bins;
+    }
+    uint32_t get_block_factor () const {
+        return _block_factor;
+    }
+
+    XCamReturn init ();
+    // both kernels need be added to handler ahead of the kernels using the histogram
+    SmartPtr<CLImageKernel> &get_clear_kernel () {
+        return _clear_kernel;
+    }
+    SmartPtr<CLImageKernel> &get_count_kernel () {
+        return _count_kernel;
+    }
+
+    // called in prepare_parameters, @image is the planar input of @info
+    XCamReturn prepare (const SmartPtr<CLImage> &image, const VideoBufferInfo &info);
+    // called in execute_done, reads back after @events
+    XCamReturn read_back (const CLEventList &events);
+    // histograms read back since last fetch, row by row of blocks, NULL if none, never waits
+    const uint32_t *fetch ();
+
+private:
+    bool is_read_done ();
+
+    XCAM_DEAD_COPY (CLLumaHistogram);
+
+private:
+    SmartPtr<CLContext>         _context;
+    uint32_t                    _bins;
+    uint32_t                    _block_factor;
+    SmartPtr<CLImageKernel>     _clear_kernel;
+    SmartPtr<CLImageKernel>     _count_kernel;
+    SmartPtr<CLBuffer>          _hist_buf;
+    std::vector<uint32_t>       _host_hist;
+    SmartPtr<CLEvent>           _read_event;
+    bool                        _counted;
+    bool                        _fetched;
+};
+
+};
+
+#endif //XCAM_CL_LUMA_HISTOGRAM_H
@@ -24,6 +24,11 @@
 #include "intel/cl_va_memory.h"
 #endif
 
+#include <atomic>
+
+#define XCAM_CL_MEMORY_POOL_MAX_BYTES (256ULL * 1024 * 1024)
+#define XCAM_CL_MEMORY_POOL_MIN_BUF_SIZE 4096
+
 namespace XCam {
 
 CLImageDesc::CLImageDesc ()
@@ -52,12 +57,16 @@ CLImageDesc::operator == (const CLImageDesc& desc) const
     return false;
 }
 
+static std::atomic<uint64_t> cl_memory_serial (0);
+
 CLMemory::CLMemory (const SmartPtr<CLContext> &context)
     : _context (context)
     , _mem_id (NULL)
     , _mem_fd (-1)
     , _mem_need_destroy (true)
     , _mapped_ptr (NULL)
+    , _serial (++cl_memory_serial)
+    , _mem_charge (MemoryCL)
 {
     XCAM_ASSERT (context.ptr () && context->is_valid ());
 }
@@ -167,6 +176,8 @@ CLBuffer::init_buffer (
     }
 
     set_mem_id (mem_id);
+    if (!(flags & CL_MEM_USE_HOST_PTR))
+        charge_memory (size);
     return true;
 }
 
@@ -211,7 +222,8 @@ XCamReturn
 CLBuffer::enqueue_read (
     void *ptr, uint32_t offset, uint32_t size,
     CLEventList &event_waits,
-    SmartPtr<CLEvent> &event_out)
+    SmartPtr<CLEvent> &event_out,
+    bool block)
 {
     SmartPtr<CLContext> context = get_context ();
     cl_mem mem_id = get_mem_id ();
@@ -220,7 +232,7 @@ CLBuffer::enqueue_read (
     if (!is_valid ())
         return XCAM_RETURN_ERROR_PARAM;
 
-    return context->enqueue_read_buffer (mem_id, ptr, offset, size, true, event_waits, event_out);
+    return context->enqueue_read_buffer (mem_id, ptr, offset, size, block, event_waits, event_out);
 }
 
 XCamReturn
@@ -239,6 +251,23 @@ CLBuffer::enqueue_write (
     return context->enqueue_write_buffer (mem_id, ptr, offset, size, true, event_waits, event_out);
 }
 
+XCamReturn
+CLBuffer::enqueue_copy (
+    const SmartPtr<CLBuffer> &dst,
+    uint32_t offset, uint32_t dst_offset, uint32_t size,
+    CLEventList &event_waits,
+    SmartPtr<CLEvent> &event_out)
+{
+    SmartPtr<CLContext> context = get_context ();
+
+    XCAM_ASSERT (is_valid () && dst.ptr () && dst->is_valid ());
+    if (!is_valid () || !dst.ptr () || !dst->is_valid ())
+        return XCAM_RETURN_ERROR_PARAM;
+
+    return context->enqueue_copy_buffer (
+               get_mem_id (), dst->get_mem_id (), offset, dst_offset, size, event_waits, event_out);
+}
+
 XCamReturn
 CLBuffer::enqueue_map (
     void *&ptr, uint32_t offset, uint32_t size,
@@ -600,6 +629,9 @@ bool CLImage2D::init_image_2d (
     }
     set_mem_id (mem_id);
     init_desc_by_image ();
+    // images on a buffer share its memory
+    if (!_bind_buf.ptr ())
+        charge_memory (get_image_desc ().size);
     return true;
 }
 
@@ -656,8 +688,232 @@ bool CLImage2DArray::init_image_2d_array (
     }
     set_mem_id (mem_id);
     init_desc_by_image ();
+    charge_memory (get_image_desc ().size);
     return true;
 }
 
 
+
+SmartPtr<CLMemoryPool> CLMemoryPool::_instance;
+Mutex CLMemoryPool::_instance_mutex;
+
+CLMemoryPool::Key::Key ()
+    : context_id (NULL)
+    , format {CL_R, CL_UNORM_INT8}
+    , width (0)
+    , height (0)
+    , size (0)
+    , flags (0)
+{
+}
+
+bool
+CLMemoryPool::Key::operator == (const CLMemoryPool::Key &key) const
+{
+    return (key.context_id == context_id &&
+            key.format.image_channel_order == format.image_channel_order &&
+            key.format.image_channel_data_type == format.image_channel_data_type &&
+            key.width == width && key.height == height &&
+            key.size == size && key.flags == flags);
+}
+
+// classes of 1/8 of the power of 2 below size, at most 12.5% wasted
+static uint32_t
+get_buffer_size_class (uint32_t size)
+{
+    if (size <= XCAM_CL_MEMORY_POOL_MIN_BUF_SIZE)
+        return XCAM_CL_MEMORY_POOL_MIN_BUF_SIZE;
+
+    uint32_t high = 1u << (31 - __builtin_clz (size));
+    uint32_t step = high / 8;
+    return XCAM_ALIGN_UP (size, step);
+}
+
+CLMemoryPool::CLMemoryPool ()
+    : _cached_bytes (0)
+    , _max_cached_bytes (XCAM_CL_MEMORY_POOL_MAX_BYTES)
+{
+}
+
+CLMemoryPool::~CLMemoryPool ()
+{
+    clear ();
+}
+
+SmartPtr<CLMemoryPool>
+CLMemoryPool::instance ()
+{
+    SmartLock locker (_instance_mutex);
+    if (!_instance.ptr ())
+        _instance = new CLMemoryPool;
+    return _instance;
+}
+
+SmartPtr<CLImage>
+CLMemoryPool::get_image_2d (
+    const SmartPtr<CLContext> &context, const CLImageDesc &desc, cl_mem_flags flags)
+{
+    XCAM_ASSERT (context.ptr ());
+
+    Key key;
+    key.context_id = context->get_context_id ();
+    key.format = desc.format;
+    key.width = desc.width;
+    key.height = desc.height;
+    key.flags = flags;
+    uint64_t bytes = (uint64_t)CLImage::calculate_pixel_bytes (desc.format) * desc.width * desc.height;
+
+    cl_mem mem_id = fetch (key);
+    if (!mem_id) {
+        cl_image_desc cl_desc;
+        xcam_mem_clear (cl_desc);
+        cl_desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+        cl_desc.image_width = desc.width;
+        cl_desc.image_height = desc.height;
+        cl_desc.image_depth = 1;
+
+        SmartPtr<CLContext> ctx = context;
+        mem_id = ctx->create_image (flags, desc.format, cl_desc);
+        XCAM_FAIL_RETURN (
+            WARNING, mem_id, NULL,
+            "CLMemoryPool create image 2d(%dx%d) failed", desc.width, desc.height);
+    }
+
+    SmartPtr<CLImage> image = new CLPoolImage2D (context, this, key, mem_id, bytes);
+    return image;
+}
+
+SmartPtr<CLBuffer>
+CLMemoryPool::get_buffer (
+    const SmartPtr<CLContext> &context, uint32_t size, cl_mem_flags flags)
+{
+    XCAM_ASSERT (context.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING, size, NULL,
+        "CLMemoryPool get buffer failed, size is 0");
+
+    Key key;
+    key.context_id = context->get_context_id ();
+    key.size = get_buffer_size_class (size);
+    key.flags = flags;
+
+    cl_mem mem_id = fetch (key);
+    if (!mem_id) {
+        SmartPtr<CLContext> ctx = context;
+        mem_id = ctx->create_buffer (key.size, flags, NULL);
+        XCAM_FAIL_RETURN (
+            WARNING, mem_id, NULL,
+            "CLMemoryPool create buffer(size:%d) failed", key.size);
+    }
+
+    SmartPtr<CLBuffer> buf = new CLPoolBuffer (context, this, key, mem_id, size);
+    return buf;
+}
+
+cl_mem
+CLMemoryPool::fetch (const Key &key)
+{
+    SmartLock locker (_mutex);
+    for (EntryList::iterator i = _entries.begin (); i != _entries.end (); ++i) {
+        if (i->key == key) {
+            cl_mem mem_id = i->mem_id;
+            _cached_bytes -= i->bytes;
+            _entries.erase (i);
+            return mem_id;
+        }
+    }
+    return NULL;
+}
+
+void
+CLMemoryPool::recycle (const SmartPtr<CLContext> &context, const Key &key, cl_mem mem_id, uint64_t bytes)
+{
+    SmartLock locker (_mutex);
+    Entry entry;
+    entry.key = key;
+    entry.mem_id = mem_id;
+    entry.bytes = bytes;
+    entry.context = context;
+    _entries.push_front (entry);
+    _cached_bytes += bytes;
+    shrink_unsafe (_max_cached_bytes);
+}
+
+void
+CLMemoryPool::shrink_unsafe (uint64_t max_bytes)
+{
+    while (_cached_bytes > max_bytes && !_entries.empty ()) {
+        Entry &entry = _entries.back ();
+        entry.context->destroy_mem (entry.mem_id);
+        _cached_bytes -= entry.bytes;
+        _entries.pop_back ();
+    }
+}
+
+void
+CLMemoryPool::set_max_cached_bytes (uint64_t bytes)
+{
+    SmartLock locker (_mutex);
+    _max_cached_bytes = bytes;
+    shrink_unsafe (_max_cached_bytes);
+}
+
+uint64_t
+CLMemoryPool::get_cached_bytes ()
+{
+    SmartLock locker (_mutex);
+    return _cached_bytes;
+}
+
+void
+CLMemoryPool::clear ()
+{
+    SmartLock locker (_mutex);
+    shrink_unsafe (0);
+}
+
+CLPoolImage2D::CLPoolImage2D (
+    const SmartPtr<CLContext> &context, const SmartPtr<CLMemoryPool> &pool,
+    const CLMemoryPool::Key &key, cl_mem mem_id, uint64_t bytes)
+    : CLImage (context)
+    , _pool (pool)
+    , _key (key)
+    , _bytes (bytes)
+{
+    set_mem_id (mem_id, false);
+    init_desc_by_image ();
+    // memory cached in pool has no owner
+    charge_memory (bytes);
+}
+
+CLPoolImage2D::~CLPoolImage2D ()
+{
+    release_fd ();
+    if (get_mapped_ptr ())
+        enqueue_unmap (get_mapped_ptr ());
+
+    _pool->recycle (get_context (), _key, get_mem_id (), _bytes);
+}
+
+CLPoolBuffer::CLPoolBuffer (
+    const SmartPtr<CLContext> &context, const SmartPtr<CLMemoryPool> &pool,
+    const CLMemoryPool::Key &key, cl_mem mem_id, uint32_t size)
+    : CLBuffer (context)
+    , _pool (pool)
+    , _key (key)
+{
+    set_mem_id (mem_id, false);
+    set_buf_size (size);
+    charge_memory (key.size);
+}
+
+CLPoolBuffer::~CLPoolBuffer ()
+{
+    release_fd ();
+    if (get_mapped_ptr ())
+        enqueue_unmap (get_mapped_ptr ());
+
+    _pool->recycle (get_context (), _key, get_mem_id (), _key.size);
+}
+
 };
@@ -24,6 +24,9 @@
 #include "ocl/cl_context.h"
 #include "ocl/cl_event.h"
 #include "video_buffer.h"
+#include <xcam_mutex.h>
+#include <memory_accounting.h>
+#include <list>
 
 #include <unistd.h>
 
@@ -53,6 +56,10 @@ public:
     bool is_valid () const {
         return _mem_id != NULL;
     }
+    // unique in process, never reused like cl_mem handles
+    uint64_t get_serial () const {
+        return _serial;
+    }
 
     bool get_cl_mem_info (
         cl_image_info param_name, size_t param_size,
@@ -75,11 +82,19 @@ protected:
     void set_mapped_ptr (void *ptr) {
         _mapped_ptr = ptr;
     }
+    void *get_mapped_ptr () const {
+        return _mapped_ptr;
+    }
 
     SmartPtr<CLContext> &get_context () {
         return _context;
     }
 
+    // device memory this object allocated or holds from CLMemoryPool
+    void charge_memory (uint64_t bytes) {
+        _mem_charge.charge (bytes);
+    }
+
 private:
     XCAM_DEAD_COPY (CLMemory);
 
@@ -89,6 +104,8 @@ private:
     int32_t               _mem_fd;
     bool                  _mem_need_destroy;
     void                 *_mapped_ptr;
+    uint64_t              _serial;
+    MemoryCharge          _mem_charge;
 };
 
 class CLBuffer
@@ -103,10 +120,12 @@ public:
         cl_mem_flags  flags =  CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
         void *host_ptr = NULL);
 
+    // non-blocking read needs @event_out, @ptr is written once it completes
     XCamReturn enqueue_read (
         void *ptr, uint32_t offset, uint32_t size,
         CLEventList &event_waits = CLEvent::EmptyList,
-        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
+        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent,
+        bool block = true);
     XCamReturn enqueue_write (
         void *ptr, uint32_t offset, uint32_t size,
         CLEventList &event_waits = CLEvent::EmptyList,
@@ -116,6 +135,11 @@ public:
         cl_map_flags map_flags = CL_MAP_READ | CL_MAP_WRITE,
         CLEventList &event_waits = CLEvent::EmptyList,
         SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
+    XCamReturn enqueue_copy (
+        const SmartPtr<CLBuffer> &dst,
+        uint32_t offset, uint32_t dst_offset, uint32_t size,
+        CLEventList &event_waits = CLEvent::EmptyList,
+        SmartPtr<CLEvent> &event_out = CLEvent::NullEvent);
 
     uint32_t get_buf_size () const {
         return _size;
@@ -259,6 +283,106 @@ private:
     XCAM_DEAD_COPY (CLImage2DArray);
 };
 
+/*
+ * CLMemoryPool, caches cl_mem of transient images and buffers.
+ * images are matched by (format, width, height, flags), buffers by size class and flags.
+ * memory goes back to pool when the returned object is destroyed, least recently
+ * used ones are released once cached size is over the limit.
+ */
+class CLMemoryPool
+    : public RefObj
+{
+    friend class CLPoolImage2D;
+    friend class CLPoolBuffer;
+
+public:
+    struct Key {
+        cl_context       context_id;
+        cl_image_format  format;
+        uint32_t         width;
+        uint32_t         height;
+        uint32_t         size;
+        cl_mem_flags     flags;
+
+        Key ();
+        bool operator == (const Key &key) const;
+    };
+
+    ~CLMemoryPool ();
+    static SmartPtr<CLMemoryPool> instance ();
+
+    SmartPtr<CLImage> get_image_2d (
+        const SmartPtr<CLContext> &context, const CLImageDesc &desc,
+        cl_mem_flags flags = CL_MEM_READ_WRITE);
+    SmartPtr<CLBuffer> get_buffer (
+        const SmartPtr<CLContext> &context, uint32_t size,
+        cl_mem_flags flags = CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR);
+
+    void set_max_cached_bytes (uint64_t bytes);
+    uint64_t get_cached_bytes ();
+    void clear ();
+
+private:
+    struct Entry {
+        Key                  key;
+        cl_mem               mem_id;
+        uint64_t             bytes;
+        SmartPtr<CLContext>  context;
+    };
+    typedef std::list<Entry> EntryList;
+
+    CLMemoryPool ();
+    cl_mem fetch (const Key &key);
+    void recycle (const SmartPtr<CLContext> &context, const Key &key, cl_mem mem_id, uint64_t bytes);
+    void shrink_unsafe (uint64_t max_bytes);
+
+    XCAM_DEAD_COPY (CLMemoryPool);
+
+private:
+    static SmartPtr<CLMemoryPool>  _instance;
+    static Mutex                   _instance_mutex;
+
+    EntryList                      _entries;
+    uint64_t                       _cached_bytes;
+    uint64_t                       _max_cached_bytes;
+    Mutex                          _mutex;
+};
+
+class CLPoolImage2D
+    : public CLImage
+{
+public:
+    explicit CLPoolImage2D (
+        const SmartPtr<CLContext> &context, const SmartPtr<CLMemoryPool> &pool,
+        const CLMemoryPool::Key &key, cl_mem mem_id, uint64_t bytes);
+    ~CLPoolImage2D ();
+
+private:
+    XCAM_DEAD_COPY (CLPoolImage2D);
+
+private:
+    SmartPtr<CLMemoryPool>  _pool;
+    CLMemoryPool::Key       _key;
+    uint64_t                _bytes;
+};
+
+class CLPoolBuffer
+    : public CLBuffer
+{
+public:
+    explicit CLPoolBuffer (
+        const SmartPtr<CLContext> &context, const SmartPtr<CLMemoryPool> &pool,
+        const CLMemoryPool::Key &key, cl_mem mem_id, uint32_t size);
+    ~CLPoolBuffer ();
+
+private:
+    XCAM_DEAD_COPY (CLPoolBuffer);
+
+private:
+    SmartPtr<CLMemoryPool>  _pool;
+    CLMemoryPool::Key       _key;
+};
+
 
 };
 #endif //
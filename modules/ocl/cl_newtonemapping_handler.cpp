@@ -21,6 +21,9 @@
 #include "cl_utils.h"
 #include "cl_newtonemapping_handler.h"
 
+// bins of one block, kernel looks curves up by 12 bits luma
+#define XCAM_CL_NEWTONEMAPPING_HIST_BINS 4096
+
 namespace XCam {
 
 static const XCamKernelInfo kernel_tone_mapping_pipe_info = {
@@ -204,8 +207,9 @@ block_split_haleq(int* hist, int hist_bin_count, int pixel_num, int block_start_
 }
 
 CLNewTonemappingImageHandler::CLNewTonemappingImageHandler (
-    const SmartPtr<CLContext> &context, const char *name)
+    const SmartPtr<CLContext> &context, const char *name, CLPrecision precision)
     : CLImageHandler (context, name)
+    , _precision (precision)
     , _output_format (XCAM_PIX_FMT_SGRBG16_planar)
     , _block_factor (4)
 {
@@ -221,6 +225,29 @@ CLNewTonemappingImageHandler::CLNewTonemappingImageHandler (
     }
 }
 
+bool
+CLNewTonemappingImageHandler::set_luma_histogram (const SmartPtr<CLLumaHistogram> &hist)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_tonemapping_kernel.ptr (), false,
+        "new tonemapping handler luma histogram need be set before tonemapping kernel");
+    XCAM_FAIL_RETURN (
+        ERROR,
+        hist.ptr () && hist->get_bins () == XCAM_CL_NEWTONEMAPPING_HIST_BINS &&
+        hist->get_block_factor () == (uint32_t)_block_factor,
+        false, "new tonemapping handler needs %dx%d luma histograms of %d bins",
+        _block_factor, _block_factor, XCAM_CL_NEWTONEMAPPING_HIST_BINS);
+
+    add_kernel (hist->get_clear_kernel ());
+    add_kernel (hist->get_count_kernel ());
+    _luma_hist = hist;
+
+    // curves of flat histograms until the first ones are read back
+    std::vector<uint32_t> flat_hist (XCAM_CL_NEWTONEMAPPING_HIST_BINS * _block_factor * _block_factor, 1);
+    update_curves_from_hist (&flat_hist[0]);
+    return true;
+}
+
 bool
 CLNewTonemappingImageHandler::set_tonemapping_kernel(SmartPtr<CLNewTonemappingImageKernel> &kernel)
 {
@@ -248,36 +275,8 @@ CLNewTonemappingImageHandler::prepare_buffer_pool_video_info (
 }
 
 XCamReturn
-CLNewTonemappingImageHandler::prepare_parameters (
-    SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+CLNewTonemappingImageHandler::update_curves_from_stats (SmartPtr<VideoBuffer> &input)
 {
-    SmartPtr<CLContext> context = get_context ();
-    const VideoBufferInfo &video_info = input->get_video_info ();
-    CLArgList args;
-    CLWorkSize work_size;
-
-    XCAM_ASSERT (_tonemapping_kernel.ptr ());
-
-    CLImageDesc desc;
-    desc.format.image_channel_order = CL_RGBA;
-    desc.format.image_channel_data_type = CL_UNORM_INT16;
-    desc.width = video_info.aligned_width / 4;
-    desc.height = video_info.aligned_height * 4;
-    desc.row_pitch = video_info.strides[0];
-    desc.array_size = 4;
-    desc.slice_pitch = video_info.strides [0] * video_info.aligned_height;
-
-    SmartPtr<CLImage> image_in = convert_to_climage (context, input, desc);
-    SmartPtr<CLImage> image_out = convert_to_climage (context, output, desc);
-    int image_width = video_info.aligned_width;
-    int image_height = video_info.aligned_height;
-
-    XCAM_FAIL_RETURN (
-        WARNING,
-        image_in->is_valid () && image_out->is_valid (),
-        XCAM_RETURN_ERROR_MEM,
-        "cl image handler(%s) in/out memory not available", XCAM_STR (get_name ()));
-
     SmartPtr<X3aStats> stats;
     SmartPtr<CLVideoBuffer> cl_buf = input.dynamic_cast_ptr<CLVideoBuffer> ();
     if (cl_buf.ptr ()) {
@@ -298,7 +297,7 @@ CLNewTonemappingImageHandler::prepare_parameters (
         ERROR, stats_ptr, XCAM_RETURN_ERROR_MEM,
         "new tonemapping handler prepare_arguments get_stats failed");
 
-    int block_factor = 4;
+    int block_factor = _block_factor;
     int width_per_block = stats_ptr->info.width / block_factor;
     int height_per_block = stats_ptr->info.height / block_factor;
     int height_last_block = height_per_block + stats_ptr->info.height % block_factor;
@@ -334,6 +333,7 @@ CLNewTonemappingImageHandler::prepare_parameters (
                 }
             }
 
+            _y_avg[block_row * block_factor + block_col] = 0.0f;
             block_split_haleq (hist_per_block, hist_bin_count, block_totalnum, block_start_index, _y_max, _y_avg, _map_hist);
         }
     }
@@ -341,6 +341,83 @@ CLNewTonemappingImageHandler::prepare_parameters (
     xcam_free (hist_per_block);
     hist_per_block = NULL;
 
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLNewTonemappingImageHandler::update_curves_from_hist (const uint32_t *hist)
+{
+    int block_count = _block_factor * _block_factor;
+    int hist_bin_count = XCAM_CL_NEWTONEMAPPING_HIST_BINS;
+    std::vector<int> hist_per_block (hist_bin_count);
+
+    for (int block = 0; block < block_count; block++) {
+        int block_start_index = block * hist_bin_count;
+        int block_totalnum = 0;
+        for (int i = 0; i < hist_bin_count; i++) {
+            hist_per_block[i] = hist[block_start_index + i];
+            block_totalnum += hist_per_block[i];
+        }
+        if (!block_totalnum)
+            continue;
+
+        _y_avg[block] = 0.0f;
+        block_split_haleq (&hist_per_block[0], hist_bin_count, block_totalnum, block_start_index, _y_max, _y_avg, _map_hist);
+    }
+}
+
+XCamReturn
+CLNewTonemappingImageHandler::prepare_parameters (
+    SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output)
+{
+    SmartPtr<CLContext> context = get_context ();
+    const VideoBufferInfo &video_info = input->get_video_info ();
+    CLArgList args;
+    CLWorkSize work_size;
+
+    XCAM_ASSERT (_tonemapping_kernel.ptr ());
+
+    CLImageDesc desc;
+    desc.format.image_channel_order = CL_RGBA;
+    desc.format.image_channel_data_type = CL_UNORM_INT16;
+    desc.width = video_info.aligned_width / 4;
+    desc.height = video_info.aligned_height * 4;
+    desc.row_pitch = video_info.strides[0];
+    desc.array_size = 4;
+    desc.slice_pitch = video_info.strides [0] * video_info.aligned_height;
+
+    SmartPtr<CLImage> image_in = convert_to_climage (context, input, desc);
+    SmartPtr<CLImage> image_out = convert_to_climage (context, output, desc);
+    int image_width = video_info.aligned_width;
+    int image_height = video_info.aligned_height;
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        image_in->is_valid () && image_out->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image handler(%s) in/out memory not available", XCAM_STR (get_name ()));
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_luma_hist.ptr ()) {
+        // curves of the latest histograms read back, current frame is counted for a later one
+        const uint32_t *hist = _luma_hist->fetch ();
+        if (hist)
+            update_curves_from_hist (hist);
+
+        ret = _luma_hist->prepare (image_in, video_info);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "new tone mapping luma histogram prepare failed.");
+    } else {
+        ret = update_curves_from_stats (input);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "new tone mapping update curves from 3a stats failed.");
+    }
+
+    int block_factor = _block_factor;
+    int hist_bin_count = XCAM_CL_NEWTONEMAPPING_HIST_BINS;
+
     SmartPtr<CLBuffer> y_max_buffer = new CLBuffer(
         context, sizeof(float) * block_factor * block_factor,
         CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, &_y_max);
@@ -370,7 +447,7 @@ CLNewTonemappingImageHandler::prepare_parameters (
     work_size.local[1] = 8;
 
     XCAM_ASSERT (_tonemapping_kernel.ptr ());
-    XCamReturn ret = _tonemapping_kernel->set_arguments (args, work_size);
+    ret = _tonemapping_kernel->set_arguments (args, work_size);
     XCAM_FAIL_RETURN (
         WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
         "new tone mapping kernel set arguments failed.");
@@ -378,9 +455,19 @@ CLNewTonemappingImageHandler::prepare_parameters (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLNewTonemappingImageHandler::execute_done (SmartPtr<VideoBuffer> &output)
+{
+    XCAM_UNUSED (output);
+    if (_luma_hist.ptr ())
+        _luma_hist->read_back (get_done_events ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 
 SmartPtr<CLImageHandler>
-create_cl_newtonemapping_image_handler (const SmartPtr<CLContext> &context)
+create_cl_newtonemapping_image_handler (const SmartPtr<CLContext> &context, CLPrecision precision, bool gpu_hist)
 {
     SmartPtr<CLNewTonemappingImageHandler> tonemapping_handler;
     SmartPtr<CLNewTonemappingImageKernel> tonemapping_kernel;
@@ -388,11 +475,19 @@ create_cl_newtonemapping_image_handler (const SmartPtr<CLContext> &context)
     tonemapping_kernel = new CLNewTonemappingImageKernel (context, "kernel_newtonemapping");
     XCAM_ASSERT (tonemapping_kernel.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, tonemapping_kernel->build_kernel (kernel_tone_mapping_pipe_info, NULL) == XCAM_RETURN_NO_ERROR, NULL,
+        ERROR, tonemapping_kernel->build_kernel (kernel_tone_mapping_pipe_info, NULL, precision) == XCAM_RETURN_NO_ERROR, NULL,
         "build new tonemapping kernel(%s) failed", kernel_tone_mapping_pipe_info.kernel_name);
 
     XCAM_ASSERT (tonemapping_kernel->is_valid ());
-    tonemapping_handler = new CLNewTonemappingImageHandler(context, "cl_handler_newtonemapping");
+    tonemapping_handler = new CLNewTonemappingImageHandler(context, "cl_handler_newtonemapping", precision);
+
+    if (gpu_hist) {
+        SmartPtr<CLLumaHistogram> luma_hist = new CLLumaHistogram (context, XCAM_CL_NEWTONEMAPPING_HIST_BINS, 4);
+        if (luma_hist->init () == XCAM_RETURN_NO_ERROR)
+            tonemapping_handler->set_luma_histogram (luma_hist);
+        else
+            XCAM_LOG_WARNING ("new tonemapping falls back to 3a stats since luma histogram init failed");
+    }
     tonemapping_handler->set_tonemapping_kernel(tonemapping_kernel);
 
     return tonemapping_handler;
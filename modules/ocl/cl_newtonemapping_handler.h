@@ -23,6 +23,7 @@
 
 #include <xcam_std.h>
 #include <ocl/cl_image_handler.h>
+#include <ocl/cl_luma_histogram.h>
 #include <x3a_stats_pool.h>
 
 namespace XCam {
@@ -44,17 +45,32 @@ class CLNewTonemappingImageHandler
     : public CLImageHandler
 {
 public:
-    explicit CLNewTonemappingImageHandler (const SmartPtr<CLContext> &context, const char *name);
+    explicit CLNewTonemappingImageHandler (
+        const SmartPtr<CLContext> &context, const char *name, CLPrecision precision = CLPrecisionFloat);
+    // curves from GPU block histograms of a previous frame instead of 3A stats,
+    // need be set before tonemapping kernel
+    bool set_luma_histogram (const SmartPtr<CLLumaHistogram> &hist);
     bool set_tonemapping_kernel(SmartPtr<CLNewTonemappingImageKernel> &kernel);
+    CLPrecision get_precision () const {
+        return _precision;
+    }
 
 protected:
     virtual XCamReturn prepare_buffer_pool_video_info (
         const VideoBufferInfo &input, VideoBufferInfo &output);
     virtual XCamReturn prepare_parameters (
         SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual XCamReturn execute_done (SmartPtr<VideoBuffer> &output);
+
+private:
+    XCamReturn update_curves_from_stats (SmartPtr<VideoBuffer> &input);
+    // @hist, block_factor x block_factor histograms of XCAM_CL_NEWTONEMAPPING_HIST_BINS
+    void update_curves_from_hist (const uint32_t *hist);
 
 private:
     SmartPtr<CLNewTonemappingImageKernel>   _tonemapping_kernel;
+    SmartPtr<CLLumaHistogram>               _luma_hist;
+    CLPrecision                             _precision;
     int32_t                                 _output_format;
     int                                     _block_factor;
     float                                   _map_hist[65536];
@@ -62,8 +78,10 @@ private:
     float                                   _y_avg[16];
 };
 
+// @gpu_hist, tonemaps by GPU luma histograms, 3A stats are not needed
 SmartPtr<CLImageHandler>
-create_cl_newtonemapping_image_handler (const SmartPtr<CLContext> &context);
+create_cl_newtonemapping_image_handler (
+    const SmartPtr<CLContext> &context, CLPrecision precision = CLPrecisionFloat, bool gpu_hist = true);
 
 };
 
@@ -25,6 +25,10 @@
 
 #define WAVELET_DECOMPOSITION_LEVELS 4
 
+// bins of one noise histogram, same as kernel_wavelet_coeff.cl
+#define WAVELET_NOISE_HIST_BINS 128
+#define WAVELET_NOISE_VARIANCE_WEIGHT 4.0f
+
 namespace XCam {
 
 enum {
@@ -32,6 +36,10 @@ enum {
     KernelWaveletReconstruct,
     KernelWaveletNoiseEstimate,
     KernelWaveletThreshold,
+    KernelWaveletLiftingForward,
+    KernelWaveletLiftingInverse,
+    KernelWaveletNoiseHist,
+    KernelWaveletNoiseVariance,
 };
 
 static const XCamKernelInfo kernel_new_wavelet_info[] = {
@@ -52,6 +60,26 @@ static const XCamKernelInfo kernel_new_wavelet_info[] = {
     },
     {
         "kernel_wavelet_coeff_thresholding",
+#include "kernel_wavelet_coeff.clx"
+        , 0,
+    },
+    {
+        "kernel_wavelet_haar_lifting_forward",
+#include "kernel_wavelet_haar.clx"
+        , 0,
+    },
+    {
+        "kernel_wavelet_haar_lifting_inverse",
+#include "kernel_wavelet_haar.clx"
+        , 0,
+    },
+    {
+        "kernel_wavelet_noise_hist",
+#include "kernel_wavelet_coeff.clx"
+        , 0,
+    },
+    {
+        "kernel_wavelet_noise_variance",
 #include "kernel_wavelet_coeff.clx"
         , 0,
     },
@@ -95,6 +123,10 @@ CLWaveletNoiseEstimateKernel::get_input_buffer ()
         image = buffer->ll;
     }
 
+    // variances stay on GPU, see CLWaveletNoiseVarianceKernel
+    if (_handler->is_gpu_noise_estimate ())
+        return image;
+
     float current_ag = _handler->get_denoise_config ().analog_gain;
     if ((_analog_gain == -1.0f) ||
             (fabs(_analog_gain - current_ag) > 0.2)) {
@@ -316,7 +348,7 @@ CLWaveletThresholdingKernel::prepare_arguments (
 
     CLImageDesc cl_desc = buffer->ll->get_image_desc ();
 
-    float weight = 4;
+    float weight = WAVELET_NOISE_VARIANCE_WEIGHT;
     if (_channel == CL_IMAGE_CHANNEL_Y) {
         noise_variance[0] = buffer->noise_variance[0] * weight;
         noise_variance[1] = buffer->noise_variance[0] * weight;
@@ -330,7 +362,10 @@ CLWaveletThresholdingKernel::prepare_arguments (
         _handler->dump_coeff (save_image, _channel, _current_layer, CL_WAVELET_SUBBAND_HH);
     }
 #endif
-    if (_channel == CL_IMAGE_CHANNEL_Y) {
+    if (_handler->is_gpu_noise_estimate ()) {
+        SmartPtr<CLBuffer> &noise_var_buf = _handler->get_noise_var_buffer (_channel);
+        args.push_back (new CLMemArgument (noise_var_buf));
+    } else if (_channel == CL_IMAGE_CHANNEL_Y) {
         args.push_back (new CLArgumentT<float> (noise_variance[0]));
         args.push_back (new CLArgumentT<float> (noise_variance[0]));
     } else {
@@ -369,6 +404,80 @@ CLWaveletThresholdingKernel::prepare_arguments (
     return XCAM_RETURN_NO_ERROR;
 }
 
+CLWaveletNoiseHistKernel::CLWaveletNoiseHistKernel (
+    const SmartPtr<CLContext> &context,
+    const char *name,
+    SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+    uint32_t channel)
+    : CLImageKernel (context, name, true)
+    , _channel (channel)
+    , _handler (handler)
+{
+}
+
+XCamReturn
+CLWaveletNoiseHistKernel::prepare_arguments (
+    CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLWaveletDecompBuffer> buffer = _handler->get_decomp_buffer (_channel, 1);
+    SmartPtr<CLBuffer> &hist = _handler->get_noise_hist (_channel);
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        buffer.ptr () && buffer->hh[0].ptr () && buffer->hh[0]->is_valid () && hist.ptr (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", get_kernel_name ());
+
+    const CLImageDesc &cl_desc = buffer->hh[0]->get_image_desc ();
+
+    args.push_back (new CLMemArgument (buffer->hh[0]));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)cl_desc.width));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)cl_desc.height));
+    args.push_back (new CLMemArgument (hist));
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 8;
+    work_size.global[0] = XCAM_ALIGN_UP (cl_desc.width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (cl_desc.height, work_size.local[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+CLWaveletNoiseVarianceKernel::CLWaveletNoiseVarianceKernel (
+    const SmartPtr<CLContext> &context,
+    const char *name,
+    SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+    uint32_t channel)
+    : CLImageKernel (context, name, true)
+    , _channel (channel)
+    , _handler (handler)
+{
+}
+
+XCamReturn
+CLWaveletNoiseVarianceKernel::prepare_arguments (
+    CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLBuffer> &hist = _handler->get_noise_hist (_channel);
+    SmartPtr<CLBuffer> &noise_var = _handler->get_noise_var_buffer (_channel);
+
+    XCAM_FAIL_RETURN (
+        WARNING, hist.ptr () && noise_var.ptr (), XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", get_kernel_name ());
+
+    args.push_back (new CLMemArgument (hist));
+    args.push_back (new CLArgumentT<float> (WAVELET_NOISE_VARIANCE_WEIGHT));
+    args.push_back (new CLMemArgument (noise_var));
+
+    // one work item per histogram, Y has one, UV has U and V
+    work_size.dim = 1;
+    work_size.global[0] = (_channel == CL_IMAGE_CHANNEL_Y) ? 1 : 2;
+    work_size.local[0] = 1;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 CLWaveletTransformKernel::CLWaveletTransformKernel (
     const SmartPtr<CLContext> &context,
     const char *name,
@@ -508,10 +617,95 @@ CLWaveletTransformKernel::get_decomp_buffer (uint32_t channel, int layer)
     return buffer;
 }
 
+CLWaveletLiftingKernel::CLWaveletLiftingKernel (
+    const SmartPtr<CLContext> &context,
+    const char *name,
+    SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+    CLWaveletFilterBank fb,
+    uint32_t layer)
+    : CLImageKernel (context, name, true)
+    , _filter_bank (fb)
+    , _current_layer (layer)
+    , _handler (handler)
+{
+}
+
+XCamReturn
+CLWaveletLiftingKernel::prepare_arguments (
+    CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<VideoBuffer> buf = (_filter_bank == CL_WAVELET_HAAR_ANALYSIS) ?
+                                _handler->get_input_buf () : _handler->get_output_buf ();
+    const VideoBufferInfo &video_info = buf->get_video_info ();
+
+    XCAM_FAIL_RETURN (
+        WARNING, video_info.strides[0] == video_info.strides[1], XCAM_RETURN_ERROR_PARAM,
+        "cl image kernel(%s) needs same Y and UV strides", get_kernel_name ());
+
+    uint32_t coeff_uv_offset = 0, coeff_pitch = 0;
+    SmartPtr<CLBuffer> &coeff = _handler->get_coeff_buffer (coeff_uv_offset, coeff_pitch);
+
+    // image buffer is only touched on the first level
+    SmartPtr<CLBuffer> image;
+    if (_current_layer == 1)
+        image = convert_to_clbuffer (context, buf);
+    else
+        image = coeff;
+
+    XCAM_FAIL_RETURN (
+        WARNING, image.ptr () && image->is_valid () && coeff.ptr () && coeff->is_valid (),
+        XCAM_RETURN_ERROR_MEM,
+        "cl image kernel(%s) in/out memory not available", get_kernel_name ());
+
+    uint32_t channel = _handler->get_channel ();
+    int32_t plane_begin = (channel & CL_IMAGE_CHANNEL_Y) ? 0 : 1;
+    int32_t plane_end = (channel & CL_IMAGE_CHANNEL_UV) ? 2 : 0;
+
+    float soft_threshold = _handler->get_denoise_config ().threshold[0];
+    float hard_threshold = _handler->get_denoise_config ().threshold[1];
+
+    args.push_back (new CLMemArgument (image));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)video_info.offsets[0]));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)video_info.offsets[1]));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)video_info.strides[0]));
+    args.push_back (new CLMemArgument (coeff));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)coeff_uv_offset));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)coeff_pitch));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)video_info.width));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)video_info.height));
+    args.push_back (new CLArgumentT<int32_t> ((int32_t)_current_layer));
+    args.push_back (new CLArgumentT<int32_t> (plane_begin));
+    args.push_back (new CLArgumentT<int32_t> (plane_end));
+    if (_filter_bank == CL_WAVELET_HAAR_SYNTHESIS) {
+        args.push_back (new CLArgumentT<float> (hard_threshold));
+        args.push_back (new CLArgumentT<float> (soft_threshold));
+    }
+
+    // one work item per 2x2 block of this level, Y plane is the widest
+    uint32_t block = 1 << _current_layer;
+    work_size.dim = 3;
+    work_size.local[0] = 8;
+    work_size.local[1] = 4;
+    work_size.local[2] = 1;
+    work_size.global[0] = XCAM_ALIGN_UP (XCAM_ALIGN_UP (video_info.width, block) / block, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (XCAM_ALIGN_UP (video_info.height, block) / block, work_size.local[1]);
+    work_size.global[2] = plane_end - plane_begin + 1;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 CLNewWaveletDenoiseImageHandler::CLNewWaveletDenoiseImageHandler (
-    const SmartPtr<CLContext> &context, const char *name, uint32_t channel)
+    const SmartPtr<CLContext> &context, const char *name, uint32_t channel, CLPrecision precision, bool lifting)
     : CLImageHandler (context, name)
     , _channel (channel)
+    , _precision (precision)
+    , _gpu_noise_estimate (false)
+    , _lifting (lifting)
+    , _coeff_width (0)
+    , _coeff_height (0)
+    , _coeff_uv_offset (0)
+    , _coeff_pitch (0)
 {
     _config.decomposition_levels = 5;
     _config.threshold[0] = 0.5;
@@ -530,6 +724,23 @@ CLNewWaveletDenoiseImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &inpu
     CLImageDesc cl_desc;
     SmartPtr<CLWaveletDecompBuffer> decompBuffer;
 
+    if (_lifting) {
+        // one coefficient buffer for all levels, kept till resolution changes
+        if (_coeff_buf.ptr () && _coeff_width == video_info.width && _coeff_height == video_info.height)
+            return XCAM_RETURN_NO_ERROR;
+
+        _coeff_pitch = XCAM_ALIGN_UP (video_info.width, 2);
+        _coeff_uv_offset = _coeff_pitch * XCAM_ALIGN_UP (video_info.height, 2);
+        uint32_t size = (_coeff_uv_offset + _coeff_pitch * XCAM_ALIGN_UP (video_info.height, 2) / 2) * sizeof (int16_t);
+        _coeff_buf = new CLBuffer (context, size, CL_MEM_READ_WRITE);
+        XCAM_FAIL_RETURN (
+            ERROR, _coeff_buf.ptr () && _coeff_buf->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "wavelet lifting create coefficient buffer(%dx%d) failed", video_info.width, video_info.height);
+        _coeff_width = video_info.width;
+        _coeff_height = video_info.height;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     CLImage::video_info_2_cl_image_desc (video_info, cl_desc);
 
     _decompBufferList.clear ();
@@ -553,11 +764,11 @@ CLNewWaveletDenoiseImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &inpu
                 cl_desc.format.image_channel_order = CL_RGBA;
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT8;
 
-                decompBuffer->ll = new CLImage2D (context, cl_desc);
+                decompBuffer->ll = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
-                decompBuffer->hl[0] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[0] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[0] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
                 /*
                                 uint32_t width = decompBuffer->width / 4;
                                 uint32_t height = decompBuffer->height;
@@ -578,14 +789,14 @@ CLNewWaveletDenoiseImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &inpu
                 */
 
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT16;
-                decompBuffer->hl[1] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[1] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[1] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT8;
-                decompBuffer->hl[2] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[2] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[2] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
                 _decompBufferList.push_back (decompBuffer);
             } else {
@@ -615,11 +826,11 @@ CLNewWaveletDenoiseImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &inpu
                 cl_desc.format.image_channel_order = CL_RGBA;
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT8;
 
-                decompBuffer->ll = new CLImage2D (context, cl_desc);
+                decompBuffer->ll = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
-                decompBuffer->hl[0] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[0] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[0] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
                 /*
                                 uint32_t width = decompBuffer->width / 4;
                                 uint32_t height = decompBuffer->height;
@@ -638,14 +849,14 @@ CLNewWaveletDenoiseImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &inpu
                                     context, hh_desc, 0, hh_buffer);
                 */
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT16;
-                decompBuffer->hl[1] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[1] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[1] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
                 cl_desc.format.image_channel_data_type = CL_UNORM_INT8;
-                decompBuffer->hl[2] = new CLImage2D (context, cl_desc);
-                decompBuffer->lh[2] = new CLImage2D (context, cl_desc);
-                decompBuffer->hh[2] = new CLImage2D (context, cl_desc);
+                decompBuffer->hl[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->lh[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+                decompBuffer->hh[2] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 
                 _decompBufferList.push_back (decompBuffer);
             } else {
@@ -702,6 +913,34 @@ CLNewWaveletDenoiseImageHandler::get_estimated_noise_variation (float* noise_var
     noise_var[2] = _noise_variance[2];
 }
 
+XCamReturn
+CLNewWaveletDenoiseImageHandler::enable_gpu_noise_estimate ()
+{
+    SmartPtr<CLContext> context = get_context ();
+    uint32_t channels[2] = {CL_IMAGE_CHANNEL_Y, CL_IMAGE_CHANNEL_UV};
+
+    for (uint32_t i = 0; i < 2; i++) {
+        if (!(_channel & channels[i]))
+            continue;
+
+        // kernel_wavelet_noise_variance clears histograms after use, so only zeroed once here
+        std::vector<uint32_t> hist (WAVELET_NOISE_HIST_BINS * 2, 0);
+        float noise_var[2] = {0.0f, 0.0f};
+        _noise_hist[i] = new CLBuffer (
+            context, sizeof (uint32_t) * hist.size (),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, &hist[0]);
+        _noise_var_buf[i] = new CLBuffer (
+            context, sizeof (noise_var),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, noise_var);
+        XCAM_FAIL_RETURN (
+            ERROR, _noise_hist[i]->is_valid () && _noise_var_buf[i]->is_valid (), XCAM_RETURN_ERROR_MEM,
+            "wavelet denoise create noise estimation buffers failed");
+    }
+
+    _gpu_noise_estimate = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 void
 CLNewWaveletDenoiseImageHandler::dump_coeff (SmartPtr<CLImage> image, uint32_t channel, uint32_t layer, uint32_t subband)
 {
@@ -786,7 +1025,8 @@ create_kernel_haar_decomposition (
     XCAM_ASSERT (haar_decomp_kernel.ptr ());
     XCAM_FAIL_RETURN (
         WARNING,
-        haar_decomp_kernel->build_kernel (kernel_new_wavelet_info[KernelWaveletDecompose], build_options) == XCAM_RETURN_NO_ERROR,
+        haar_decomp_kernel->build_kernel (
+            kernel_new_wavelet_info[KernelWaveletDecompose], build_options, handler->get_precision ()) == XCAM_RETURN_NO_ERROR,
         NULL,
         "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[KernelWaveletDecompose].kernel_name);
     XCAM_ASSERT (haar_decomp_kernel->is_valid ());
@@ -820,7 +1060,8 @@ create_kernel_haar_reconstruction (
     XCAM_ASSERT (haar_reconstruction_kernel.ptr ());
     XCAM_FAIL_RETURN (
         WARNING,
-        haar_reconstruction_kernel->build_kernel (kernel_new_wavelet_info[KernelWaveletReconstruct], build_options) == XCAM_RETURN_NO_ERROR,
+        haar_reconstruction_kernel->build_kernel (
+            kernel_new_wavelet_info[KernelWaveletReconstruct], build_options, handler->get_precision ()) == XCAM_RETURN_NO_ERROR,
         NULL,
         "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[KernelWaveletReconstruct].kernel_name);
     XCAM_ASSERT (haar_reconstruction_kernel->is_valid ());
@@ -850,7 +1091,8 @@ create_kernel_noise_estimation (
     XCAM_ASSERT (estimation_kernel.ptr ());
     XCAM_FAIL_RETURN (
         WARNING,
-        estimation_kernel->build_kernel (kernel_new_wavelet_info[KernelWaveletNoiseEstimate], build_options) == XCAM_RETURN_NO_ERROR,
+        estimation_kernel->build_kernel (
+            kernel_new_wavelet_info[KernelWaveletNoiseEstimate], build_options, handler->get_precision ()) == XCAM_RETURN_NO_ERROR,
         NULL,
         "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[KernelWaveletNoiseEstimate].kernel_name);
     XCAM_ASSERT (estimation_kernel->is_valid ());
@@ -871,9 +1113,11 @@ create_kernel_thresholding (
 
     snprintf (build_options, sizeof (build_options),
               " -DWAVELET_DENOISE_Y=%d "
-              " -DWAVELET_DENOISE_UV=%d ",
+              " -DWAVELET_DENOISE_UV=%d "
+              " -DWAVELET_NOISE_VAR_BUFFER=%d",
               (channel == CL_IMAGE_CHANNEL_Y ? 1 : 0),
-              (channel == CL_IMAGE_CHANNEL_UV ? 1 : 0));
+              (channel == CL_IMAGE_CHANNEL_UV ? 1 : 0),
+              (handler->is_gpu_noise_estimate () ? 1 : 0));
 
     threshold_kernel = new CLWaveletThresholdingKernel (context,
             "kernel_wavelet_coeff_thresholding",
@@ -889,17 +1133,105 @@ create_kernel_thresholding (
     return threshold_kernel;
 }
 
+static XCamReturn
+add_kernels_gpu_noise_estimation (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLNewWaveletDenoiseImageHandler> handler,
+    uint32_t channel)
+{
+    char build_options[1024];
+    xcam_mem_clear (build_options);
+
+    snprintf (build_options, sizeof (build_options),
+              " -DWAVELET_DENOISE_Y=%d "
+              " -DWAVELET_DENOISE_UV=%d ",
+              (channel == CL_IMAGE_CHANNEL_Y ? 1 : 0),
+              (channel == CL_IMAGE_CHANNEL_UV ? 1 : 0));
+
+    SmartPtr<CLImageKernel> hist_kernel = new CLWaveletNoiseHistKernel (
+        context, kernel_new_wavelet_info[KernelWaveletNoiseHist].kernel_name, handler, channel);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        hist_kernel->build_kernel (kernel_new_wavelet_info[KernelWaveletNoiseHist], build_options) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL,
+        "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[KernelWaveletNoiseHist].kernel_name);
+
+    SmartPtr<CLImageKernel> variance_kernel = new CLWaveletNoiseVarianceKernel (
+        context, kernel_new_wavelet_info[KernelWaveletNoiseVariance].kernel_name, handler, channel);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        variance_kernel->build_kernel (kernel_new_wavelet_info[KernelWaveletNoiseVariance], build_options) == XCAM_RETURN_NO_ERROR,
+        XCAM_RETURN_ERROR_CL,
+        "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[KernelWaveletNoiseVariance].kernel_name);
+
+    handler->add_kernel (hist_kernel);
+    handler->add_kernel (variance_kernel);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static SmartPtr<CLWaveletLiftingKernel>
+create_kernel_haar_lifting (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLNewWaveletDenoiseImageHandler> handler,
+    CLWaveletFilterBank fb,
+    uint32_t layer)
+{
+    SmartPtr<CLWaveletLiftingKernel> lifting_kernel;
+    uint32_t index = (fb == CL_WAVELET_HAAR_ANALYSIS) ? KernelWaveletLiftingForward : KernelWaveletLiftingInverse;
+
+    lifting_kernel = new CLWaveletLiftingKernel (
+        context, kernel_new_wavelet_info[index].kernel_name, handler, fb, layer);
+    XCAM_ASSERT (lifting_kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        lifting_kernel->build_kernel (kernel_new_wavelet_info[index], NULL) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "wavelet denoise build kernel(%s) failed", kernel_new_wavelet_info[index].kernel_name);
+    XCAM_ASSERT (lifting_kernel->is_valid ());
+
+    return lifting_kernel;
+}
+
 SmartPtr<CLImageHandler>
 create_cl_newwavelet_denoise_image_handler (
-    const SmartPtr<CLContext> &context, uint32_t channel, bool bayes_shrink)
+    const SmartPtr<CLContext> &context, uint32_t channel, bool bayes_shrink, CLPrecision precision,
+    bool lifting, bool gpu_noise)
 {
     SmartPtr<CLNewWaveletDenoiseImageHandler> wavelet_handler;
     SmartPtr<CLWaveletTransformKernel> haar_decomposition_kernel;
     SmartPtr<CLWaveletTransformKernel> haar_reconstruction_kernel;
 
-    wavelet_handler = new CLNewWaveletDenoiseImageHandler (context, "cl_newwavelet_denoise_handler", channel);
+    wavelet_handler = new CLNewWaveletDenoiseImageHandler (
+        context, "cl_newwavelet_denoise_handler", channel, precision, lifting);
     XCAM_ASSERT (wavelet_handler.ptr ());
 
+    if (lifting) {
+        if (bayes_shrink) {
+            XCAM_LOG_WARNING ("wavelet lifting mode does not support bayes shrink, use fixed thresholds");
+        }
+
+        // all planes of one level in one launch
+        for (int layer = 1; layer <= WAVELET_DECOMPOSITION_LEVELS; layer++) {
+            SmartPtr<CLImageKernel> image_kernel =
+                create_kernel_haar_lifting (context, wavelet_handler, CL_WAVELET_HAAR_ANALYSIS, layer);
+            XCAM_FAIL_RETURN (ERROR, image_kernel.ptr (), NULL, "wavelet lifting create forward kernel failed");
+            wavelet_handler->add_kernel (image_kernel);
+        }
+        for (int layer = WAVELET_DECOMPOSITION_LEVELS; layer >= 1; layer--) {
+            SmartPtr<CLImageKernel> image_kernel =
+                create_kernel_haar_lifting (context, wavelet_handler, CL_WAVELET_HAAR_SYNTHESIS, layer);
+            XCAM_FAIL_RETURN (ERROR, image_kernel.ptr (), NULL, "wavelet lifting create inverse kernel failed");
+            wavelet_handler->add_kernel (image_kernel);
+        }
+        return wavelet_handler;
+    }
+
+    if (bayes_shrink && gpu_noise) {
+        XCAM_FAIL_RETURN (
+            ERROR, wavelet_handler->enable_gpu_noise_estimate () == XCAM_RETURN_NO_ERROR, NULL,
+            "wavelet denoise enable gpu noise estimation failed");
+    }
+
     if (channel & CL_IMAGE_CHANNEL_Y) {
         for (int layer = 1; layer <= WAVELET_DECOMPOSITION_LEVELS; layer++) {
             SmartPtr<CLImageKernel> image_kernel =
@@ -908,6 +1240,12 @@ create_cl_newwavelet_denoise_image_handler (
         }
 
         if (bayes_shrink) {
+            if (gpu_noise) {
+                XCAM_FAIL_RETURN (
+                    ERROR,
+                    add_kernels_gpu_noise_estimation (context, wavelet_handler, CL_IMAGE_CHANNEL_Y) == XCAM_RETURN_NO_ERROR,
+                    NULL, "wavelet denoise create noise estimation kernels failed");
+            }
             for (int layer = 1; layer <= WAVELET_DECOMPOSITION_LEVELS; layer++) {
                 SmartPtr<CLImageKernel> image_kernel;
 
@@ -945,6 +1283,12 @@ create_cl_newwavelet_denoise_image_handler (
         }
 
         if (bayes_shrink) {
+            if (gpu_noise) {
+                XCAM_FAIL_RETURN (
+                    ERROR,
+                    add_kernels_gpu_noise_estimation (context, wavelet_handler, CL_IMAGE_CHANNEL_UV) == XCAM_RETURN_NO_ERROR,
+                    NULL, "wavelet denoise create noise estimation kernels failed");
+            }
             for (int layer = 1; layer <= WAVELET_DECOMPOSITION_LEVELS; layer++) {
                 SmartPtr<CLImageKernel> image_kernel;
 
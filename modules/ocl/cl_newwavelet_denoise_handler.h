@@ -122,6 +122,51 @@ private:
     SmartPtr<CLNewWaveletDenoiseImageHandler> _handler;
 };
 
+/*
+ * MAD noise estimation on GPU, |coefficient| of layer 1 HH band is counted into histograms,
+ * variance kernel takes sigma from the median and writes the variances thresholding kernels read,
+ * so noise is estimated every frame without reading back to host.
+ */
+class CLWaveletNoiseHistKernel
+    : public CLImageKernel
+{
+
+public:
+    explicit CLWaveletNoiseHistKernel (
+        const SmartPtr<CLContext> &context,
+        const char *name,
+        SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+        uint32_t channel);
+
+protected:
+    virtual XCamReturn prepare_arguments (
+        CLArgList &args, CLWorkSize &work_size);
+
+private:
+    uint32_t  _channel;
+    SmartPtr<CLNewWaveletDenoiseImageHandler> _handler;
+};
+
+class CLWaveletNoiseVarianceKernel
+    : public CLImageKernel
+{
+
+public:
+    explicit CLWaveletNoiseVarianceKernel (
+        const SmartPtr<CLContext> &context,
+        const char *name,
+        SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+        uint32_t channel);
+
+protected:
+    virtual XCamReturn prepare_arguments (
+        CLArgList &args, CLWorkSize &work_size);
+
+private:
+    uint32_t  _channel;
+    SmartPtr<CLNewWaveletDenoiseImageHandler> _handler;
+};
+
 class CLWaveletTransformKernel
     : public CLImageKernel
 {
@@ -152,6 +197,33 @@ private:
     SmartPtr<CLNewWaveletDenoiseImageHandler> _handler;
 };
 
+/*
+ * integer lifting haar transform, all levels are kept in place in one coefficient buffer,
+ * inverse kernel thresholds and reconstructs one level each.
+ */
+class CLWaveletLiftingKernel
+    : public CLImageKernel
+{
+
+public:
+    explicit CLWaveletLiftingKernel (
+        const SmartPtr<CLContext> &context,
+        const char *name,
+        SmartPtr<CLNewWaveletDenoiseImageHandler> &handler,
+        CLWaveletFilterBank fb,
+        uint32_t layer);
+
+protected:
+    virtual XCamReturn prepare_arguments (
+        CLArgList &args, CLWorkSize &work_size);
+
+private:
+    CLWaveletFilterBank        _filter_bank;
+    uint32_t                   _current_layer;
+
+    SmartPtr<CLNewWaveletDenoiseImageHandler> _handler;
+};
+
 class CLNewWaveletDenoiseImageHandler
     : public CLImageHandler
 {
@@ -159,18 +231,48 @@ class CLNewWaveletDenoiseImageHandler
 
 public:
     explicit CLNewWaveletDenoiseImageHandler (
-        const SmartPtr<CLContext> &context, const char *name, uint32_t channel);
+        const SmartPtr<CLContext> &context, const char *name, uint32_t channel,
+        CLPrecision precision = CLPrecisionFloat, bool lifting = false);
 
     bool set_denoise_config (const XCam3aResultWaveletNoiseReduction& config);
     XCam3aResultWaveletNoiseReduction& get_denoise_config () {
         return _config;
     };
+    CLPrecision get_precision () const {
+        return _precision;
+    }
+    uint32_t get_channel () const {
+        return _channel;
+    }
+    bool is_lifting () const {
+        return _lifting;
+    }
+
+    // lifting coefficients, Y plane followed by interleaved UV plane, pitch in elements
+    SmartPtr<CLBuffer> &get_coeff_buffer (uint32_t &uv_offset, uint32_t &pitch) {
+        uv_offset = _coeff_uv_offset;
+        pitch = _coeff_pitch;
+        return _coeff_buf;
+    }
 
     SmartPtr<CLWaveletDecompBuffer> get_decomp_buffer (uint32_t channel, int layer);
 
     void set_estimated_noise_variation (float* noise_var);
     void get_estimated_noise_variation (float* noise_var);
 
+    // estimate noise on GPU every frame instead of on host when analog gain changes,
+    // need be called before kernels are created
+    XCamReturn enable_gpu_noise_estimate ();
+    bool is_gpu_noise_estimate () const {
+        return _gpu_noise_estimate;
+    }
+    SmartPtr<CLBuffer> &get_noise_hist (uint32_t channel) {
+        return _noise_hist[channel == CL_IMAGE_CHANNEL_Y ? 0 : 1];
+    }
+    SmartPtr<CLBuffer> &get_noise_var_buffer (uint32_t channel) {
+        return _noise_var_buf[channel == CL_IMAGE_CHANNEL_Y ? 0 : 1];
+    }
+
     void dump_coeff (SmartPtr<CLImage> image, uint32_t channel, uint32_t layer, uint32_t subband);
 
 protected:
@@ -178,14 +280,27 @@ protected:
 
 private:
     uint32_t _channel;
+    CLPrecision _precision;
     XCam3aResultWaveletNoiseReduction _config;
     CLWaveletDecompBufferList _decompBufferList;
     float _noise_variance[3];
+
+    bool _gpu_noise_estimate;
+    SmartPtr<CLBuffer> _noise_hist[2];
+    SmartPtr<CLBuffer> _noise_var_buf[2];
+
+    bool _lifting;
+    SmartPtr<CLBuffer> _coeff_buf;
+    uint32_t _coeff_width;
+    uint32_t _coeff_height;
+    uint32_t _coeff_uv_offset;
+    uint32_t _coeff_pitch;
 };
 
 SmartPtr<CLImageHandler>
 create_cl_newwavelet_denoise_image_handler (
-    const SmartPtr<CLContext> &context, uint32_t channel, bool bayes_shrink);
+    const SmartPtr<CLContext> &context, uint32_t channel, bool bayes_shrink,
+    CLPrecision precision = CLPrecisionFloat, bool lifting = false, bool gpu_noise = true);
 
 };
 
@@ -34,9 +34,11 @@
 #include "cl_image_warp_handler.h"
 #include "cl_image_360_stitch.h"
 #include "cl_video_stabilizer.h"
+#include "thread_pool.h"
 
 #define XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE 6
 #define XCAM_CL_POST_IMAGE_MAX_POOL_SIZE 12
+#define XCAM_CL_POST_HANDLER_BUILD_THREADS 4
 
 namespace XCam {
 
@@ -44,9 +46,13 @@ CLPostImageProcessor::CLPostImageProcessor ()
     : CLImageProcessor ("CLPostImageProcessor")
     , _output_fourcc (V4L2_PIX_FMT_NV12)
     , _out_sample_type (OutSampleYuv)
+    , _out_width (0)
+    , _out_height (0)
     , _scaler_factor (1.0)
+    , _scaler_filter (CL_IMAGE_SCALER_FILTER_SAMPLER)
     , _tnr_mode (TnrYuv)
     , _defog_mode (CLPostImageProcessor::DefogDisabled)
+    , _defog_dcp_downscale (1)
     , _wavelet_basis (CL_WAVELET_DISABLED)
     , _wavelet_channel (CL_IMAGE_CHANNEL_UV)
     , _wavelet_bayes_shrink (false)
@@ -57,7 +63,7 @@ CLPostImageProcessor::CLPostImageProcessor ()
     , _enable_image_warp (false)
     , _enable_stitch (false)
     , _stitch_enable_seam (false)
-    , _stitch_fisheye_map (false)
+    , _stitch_fisheye_map (true)
     , _stitch_lsc (false)
     , _stitch_fm_ocl (false)
     , _stitch_scale_mode (CLBlenderScaleLocal)
@@ -65,6 +71,7 @@ CLPostImageProcessor::CLPostImageProcessor ()
     , _stitch_height (0)
     , _stitch_res_mode (0)
     , _surround_mode (SphereView)
+    , _degraded (false)
 {
     XCAM_LOG_DEBUG ("CLPostImageProcessor constructed");
 }
@@ -88,6 +95,7 @@ CLPostImageProcessor::set_output_format (uint32_t fourcc)
         _out_sample_type = OutSampleRGB;
         break;
     case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_YUYV:
         _out_sample_type = OutSampleYuv;
         break;
     default:
@@ -101,6 +109,37 @@ CLPostImageProcessor::set_output_format (uint32_t fourcc)
     return true;
 }
 
+bool
+CLPostImageProcessor::set_output_crop_scale (const Rect &crop, uint32_t width, uint32_t height)
+{
+    _out_crop = crop;
+    _out_width = width;
+    _out_height = height;
+    return true;
+}
+
+bool
+CLPostImageProcessor::need_fused_output () const
+{
+    if (_output_fourcc == V4L2_PIX_FMT_YUYV)
+        return true;
+
+    bool crop_scale = (_out_crop.width && _out_crop.height) || (_out_width && _out_height);
+    if (crop_scale && _out_sample_type != OutSampleRGB) {
+        if (!need_warp_output ())
+            XCAM_LOG_WARNING ("cl post processor output crop and scale need RGBA or YUYV output, ignored");
+        return false;
+    }
+    return crop_scale;
+}
+
+bool
+CLPostImageProcessor::need_warp_output () const
+{
+    bool crop_scale = (_out_crop.width && _out_crop.height) || (_out_width && _out_height);
+    return crop_scale && _output_fourcc == V4L2_PIX_FMT_NV12 && _enable_image_warp && !_enable_stitch;
+}
+
 void
 CLPostImageProcessor::set_stats_callback (const SmartPtr<StatsCallback> &callback)
 {
@@ -108,6 +147,20 @@ CLPostImageProcessor::set_stats_callback (const SmartPtr<StatsCallback> &callbac
     _stats_callback = callback;
 }
 
+bool
+CLPostImageProcessor::set_output_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, pool.ptr () && pool->get_video_info ().format, false,
+        "CLPostImageProcessor set output pool failed, pool not configured");
+
+    _output_pool = pool;
+
+    STREAM_LOCK;
+
+    return true;
+}
+
 bool
 CLPostImageProcessor::set_scaler_factor (const double factor)
 {
@@ -116,6 +169,28 @@ CLPostImageProcessor::set_scaler_factor (const double factor)
     return true;
 }
 
+bool
+CLPostImageProcessor::add_scaler_factor (const double factor)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !_scaler.ptr (), false,
+        "cl post processor add scaler factor failed, scaler already created");
+    XCAM_FAIL_RETURN (
+        WARNING, _scaler_extra_factors.size () + 1 < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS, false,
+        "cl post processor add scaler factor failed, max %d outputs", XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS);
+
+    _scaler_extra_factors.push_back (factor);
+    return true;
+}
+
+bool
+CLPostImageProcessor::set_scaler_filter (CLImageScalerFilter filter)
+{
+    _scaler_filter = filter;
+
+    return true;
+}
+
 bool
 CLPostImageProcessor::can_process_result (SmartPtr < X3aResult > & result)
 {
@@ -229,209 +304,372 @@ CLPostImageProcessor::apply_3a_result (SmartPtr<X3aResult> &result)
 }
 
 
-XCamReturn
-CLPostImageProcessor::create_handlers ()
+class CLPostHandlerSync {
+public:
+    explicit CLPostHandlerSync (uint32_t count)
+        : _remain (count)
+    {}
+    void done () {
+        SmartLock locker (_mutex);
+        if (--_remain == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (CLPostHandlerSync);
+
+private:
+    uint32_t          _remain;
+    Mutex             _mutex;
+    XCam::Cond        _cond;
+};
+
+class CLPostHandlerCreator
+    : public ThreadPool::UserData
 {
-    SmartPtr<CLImageHandler> image_handler;
-    SmartPtr<CLContext> context = get_cl_context ();
+public:
+    CLPostHandlerCreator (
+        CLPostImageProcessor *processor, CLPostImageProcessor::HandlerType type,
+        SmartPtr<CLImageHandler> &handler, const SmartPtr<CLPostHandlerSync> &sync)
+        : _processor (processor)
+        , _type (type)
+        , _handler (handler)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _handler = _processor->create_handler (_type);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn err) {
+        XCAM_UNUSED (err);
+        _sync->done ();
+    }
+
+private:
+    CLPostImageProcessor                *_processor;
+    CLPostImageProcessor::HandlerType    _type;
+    SmartPtr<CLImageHandler>            &_handler;
+    SmartPtr<CLPostHandlerSync>          _sync;
+};
 
+SmartPtr<CLImageHandler>
+CLPostImageProcessor::create_handler (HandlerType type)
+{
+    SmartPtr<CLContext> context = get_cl_context ();
     XCAM_ASSERT (context.ptr ());
 
-    /* defog: retinex */
-    image_handler = create_cl_retinex_image_handler (context);
-    _retinex = image_handler.dynamic_cast_ptr<CLRetinexImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _retinex.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create retinex handler failed");
-    _retinex->enable_handler (_defog_mode == CLPostImageProcessor::DefogRetinex);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-    add_handler (image_handler);
-
-    /* defog: dark channel prior */
-    image_handler = create_cl_defog_dcp_image_handler (context);
-    _defog_dcp = image_handler.dynamic_cast_ptr<CLDefogDcpImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _defog_dcp.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create defog handler failed");
-    _defog_dcp->enable_handler (_defog_mode == CLPostImageProcessor::DefogDarkChannelPrior);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-    add_handler (image_handler);
-
-    /* Temporal Noise Reduction */
-    if (_defog_mode != CLPostImageProcessor::DefogDisabled) {
-        switch (_tnr_mode) {
-        case TnrYuv: {
-            image_handler = create_cl_tnr_image_handler (context, CL_TNR_TYPE_YUV);
-            _tnr = image_handler.dynamic_cast_ptr<CLTnrImageHandler> ();
-            XCAM_FAIL_RETURN (
-                WARNING,
-                _tnr.ptr (),
-                XCAM_RETURN_ERROR_CL,
-                "CLPostImageProcessor create tnr handler failed");
-            image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-            image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
-            add_handler (image_handler);
-            break;
+    if (!is_handler_needed (type))
+        return NULL;
+
+    switch (type) {
+    case HandlerRetinex:
+        return create_cl_retinex_image_handler (context);
+    case HandlerDefogDcp:
+        return create_cl_defog_dcp_image_handler (context, _defog_dcp_downscale);
+    case HandlerTnr:
+        return create_cl_tnr_image_handler (context, CL_TNR_TYPE_YUV);
+    case HandlerWavelet:
+        return create_cl_wavelet_denoise_image_handler (context, _wavelet_channel);
+    case HandlerNewWavelet:
+        return create_cl_newwavelet_denoise_image_handler (
+                   context, _wavelet_channel, _wavelet_bayes_shrink, CLPrecisionFloat,
+                   _wavelet_basis == CL_WAVELET_HAAR_LIFTING);
+    case Handler3DDenoise: {
+        uint32_t denoise_channel = CL_IMAGE_CHANNEL_UV;
+
+        if (_3d_denoise_mode == CLPostImageProcessor::Denoise3DUV) {
+            denoise_channel = CL_IMAGE_CHANNEL_UV;
+        } else if (_3d_denoise_mode == CLPostImageProcessor::Denoise3DYuv) {
+            denoise_channel = CL_IMAGE_CHANNEL_Y | CL_IMAGE_CHANNEL_UV;
         }
-        case TnrDisable:
-            XCAM_LOG_DEBUG ("CLPostImageProcessor disable tnr");
+        return create_cl_3d_denoise_image_handler (context, denoise_channel, _3d_denoise_ref_count);
+    }
+    case HandlerScaler:
+        return create_cl_image_scaler_handler (context, V4L2_PIX_FMT_NV12, _scaler_filter);
+    case HandlerWireFrame:
+        return create_cl_wire_frame_image_handler (context);
+    case HandlerImageWarp:
+        return create_cl_image_warp_handler (context);
+    case HandlerVideoStab:
+        return create_cl_video_stab_handler (context);
+    case HandlerStitch:
+        return create_image_360_stitch (
+                   context, _stitch_enable_seam, _stitch_scale_mode,
+                   _stitch_fisheye_map, _stitch_lsc, (SurroundMode) _surround_mode, (StitchResMode) _stitch_res_mode);
+    case HandlerCsc:
+        if (need_fused_output ())
+            return create_cl_csc_image_handler (context, CL_CSC_TYPE_NV12SCALE);
+        return create_cl_csc_image_handler (context, CL_CSC_TYPE_NV12TORGBA);
+    default:
+        break;
+    }
+    return NULL;
+}
+
+void
+CLPostImageProcessor::create_handlers_parallel (SmartPtr<CLImageHandler> (&handlers)[HandlerTypeCount])
+{
+    SmartPtr<ThreadPool> pool = new ThreadPool ("CLPostHandlerBuild");
+    SmartPtr<CLPostHandlerSync> sync = new CLPostHandlerSync (HandlerTypeCount);
+    uint32_t queued = 0;
+
+    pool->set_threads (XCAM_CL_POST_HANDLER_BUILD_THREADS, XCAM_CL_POST_HANDLER_BUILD_THREADS);
+    if (xcam_ret_is_ok (pool->start ())) {
+        for (; queued < HandlerTypeCount; ++queued) {
+            SmartPtr<ThreadPool::UserData> creator =
+                new CLPostHandlerCreator (this, (HandlerType)queued, handlers[queued], sync);
+            if (!xcam_ret_is_ok (pool->queue (creator)))
+                break;
+        }
+    }
+
+    // build the rest in current thread if pool not available
+    for (uint32_t i = queued; i < HandlerTypeCount; ++i) {
+        handlers[i] = create_handler ((HandlerType)i);
+        sync->done ();
+    }
+
+    sync->wait ();
+    pool->stop ();
+}
+
+bool
+CLPostImageProcessor::is_handler_needed (HandlerType type) const
+{
+    switch (type) {
+    case HandlerRetinex:
+        return _defog_mode == CLPostImageProcessor::DefogRetinex;
+    case HandlerDefogDcp:
+        return _defog_mode == CLPostImageProcessor::DefogDarkChannelPrior;
+    case HandlerTnr:
+        return _defog_mode != CLPostImageProcessor::DefogDisabled && _tnr_mode == TnrYuv;
+    case HandlerWavelet:
+        return _wavelet_basis == CL_WAVELET_HAT;
+    case HandlerNewWavelet:
+        return _wavelet_basis == CL_WAVELET_HAAR || _wavelet_basis == CL_WAVELET_HAAR_LIFTING;
+    case Handler3DDenoise:
+        return _3d_denoise_mode != CLPostImageProcessor::Denoise3DDisabled;
+    case HandlerScaler:
+        return _enable_scaler;
+    case HandlerWireFrame:
+        return _enable_wireframe;
+    case HandlerImageWarp:
+        return _enable_image_warp;
+    case HandlerVideoStab:
+        // not enabled by any mode yet
+        return false;
+    case HandlerStitch:
+        return _enable_stitch;
+    case HandlerCsc:
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+XCamReturn
+CLPostImageProcessor::install_handler (HandlerType type, SmartPtr<CLImageHandler> &handler)
+{
+    XCAM_ASSERT (handler.ptr () && !_type_handlers[type].ptr ());
+
+    handler->set_pool_type (CLImageHandler::CLVideoPoolType);
+
+    switch (type) {
+    case HandlerRetinex:
+        _retinex = handler.dynamic_cast_ptr<CLRetinexImageHandler> ();
+        XCAM_ASSERT (_retinex.ptr ());
+        // luma pyramid of each frame shared by handlers
+        _gauss_pyramid = new CLGaussPyramid (get_cl_context ());
+        _retinex->set_gauss_pyramid (_gauss_pyramid);
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerDefogDcp:
+        _defog_dcp = handler.dynamic_cast_ptr<CLDefogDcpImageHandler> ();
+        XCAM_ASSERT (_defog_dcp.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerTnr:
+        _tnr = handler.dynamic_cast_ptr<CLTnrImageHandler> ();
+        XCAM_ASSERT (_tnr.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+        break;
+    case HandlerWavelet:
+        _wavelet = handler.dynamic_cast_ptr<CLWaveletDenoiseImageHandler> ();
+        XCAM_ASSERT (_wavelet.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+        break;
+    case HandlerNewWavelet:
+        _newwavelet = handler.dynamic_cast_ptr<CLNewWaveletDenoiseImageHandler> ();
+        XCAM_ASSERT (_newwavelet.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+        break;
+    case Handler3DDenoise:
+        _3d_denoise = handler.dynamic_cast_ptr<CL3DDenoiseImageHandler> ();
+        XCAM_ASSERT (_3d_denoise.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerScaler:
+        _scaler = handler.dynamic_cast_ptr<CLImageScaler> ();
+        XCAM_ASSERT (_scaler.ptr ());
+        _scaler->set_scaler_factor (_scaler_factor, _scaler_factor);
+        for (uint32_t i = 0; i < _scaler_extra_factors.size (); ++i) {
+            double factor = _scaler_extra_factors[i];
+            if (!_scaler->add_scaler_output (factor, factor))
+                XCAM_LOG_WARNING ("cl post processor drops scaler output of factor:%.3f", factor);
+        }
+        _scaler->set_buffer_callback (_stats_callback);
+        break;
+    case HandlerWireFrame:
+        _wireframe = handler.dynamic_cast_ptr<CLWireFrameImageHandler> ();
+        XCAM_ASSERT (_wireframe.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+        break;
+    case HandlerImageWarp:
+        _image_warp = handler.dynamic_cast_ptr<CLImageWarpHandler> ();
+        XCAM_ASSERT (_image_warp.ptr ());
+        // nv12 output crops and scales within the warp pass
+        if (need_warp_output ())
+            _image_warp->set_crop_scale (_out_crop, _out_width, _out_height);
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerVideoStab:
+        _video_stab = handler.dynamic_cast_ptr<CLVideoStabilizer> ();
+        XCAM_ASSERT (_video_stab.ptr ());
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerStitch:
+        _stitch = handler.dynamic_cast_ptr<CLImage360Stitch> ();
+        XCAM_ASSERT (_stitch.ptr ());
+        _stitch->set_output_size (_stitch_width, _stitch_height);
+#if HAVE_OPENCV
+        _stitch->set_feature_match_ocl (_stitch_fm_ocl);
+#endif
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
+        break;
+    case HandlerCsc:
+        /* csc (nv12torgba), or fused crop, scale and csc as the last pass */
+        _csc = handler.dynamic_cast_ptr<CLCscImageHandler> ();
+        XCAM_ASSERT (_csc.ptr ());
+        if (need_fused_output ())
+            _csc->set_crop_scale (_out_crop, _out_width, _out_height);
+        _csc->set_output_format (_output_fourcc);
+        handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
+        break;
+    default:
+        XCAM_ASSERT (false);
+        break;
+    }
+
+    // keep handlers in type order
+    SmartPtr<CLImageHandler> next;
+    for (uint32_t i = type + 1; i < HandlerTypeCount && !next.ptr (); ++i)
+        next = _type_handlers[i];
+
+    _type_handlers[type] = handler;
+    if (next.ptr ())
+        insert_handler (next, handler);
+    else
+        add_handler (handler);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CLPostImageProcessor::update_handler_enables ()
+{
+    for (uint32_t i = 0; i < HandlerTypeCount; ++i) {
+        if (!_type_handlers[i].ptr ())
+            continue;
+
+        bool enable = is_handler_needed ((HandlerType)i);
+        switch (i) {
+        case HandlerRetinex:
+        case HandlerDefogDcp:
+        case HandlerWavelet:
+        case HandlerNewWavelet:
+            enable = enable && !_degraded;
+            break;
+        case HandlerCsc:
+            enable = need_fused_output () || _out_sample_type == OutSampleRGB;
             break;
         default:
-            XCAM_LOG_WARNING ("CLPostImageProcessor unknown tnr mode (%d)", _tnr_mode);
             break;
         }
+        _type_handlers[i]->enable_handler (enable);
     }
+}
+
+XCamReturn
+CLPostImageProcessor::create_handlers ()
+{
+    SmartPtr<CLImageHandler> handlers[HandlerTypeCount];
+
+    create_handlers_parallel (handlers);
+
+    for (uint32_t i = 0; i < HandlerTypeCount; ++i) {
+        if (!is_handler_needed ((HandlerType)i))
+            continue;
 
-    /* wavelet denoise */
-    switch (_wavelet_basis) {
-    case CL_WAVELET_HAT: {
-        image_handler = create_cl_wavelet_denoise_image_handler (context, _wavelet_channel);
-        _wavelet = image_handler.dynamic_cast_ptr<CLWaveletDenoiseImageHandler> ();
         XCAM_FAIL_RETURN (
             WARNING,
-            _wavelet.ptr (),
+            handlers[i].ptr (),
             XCAM_RETURN_ERROR_CL,
-            "CLPostImageProcessor create wavelet denoise handler failed");
-        _wavelet->enable_handler (true);
-        image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-        image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
-        add_handler (image_handler);
-        break;
+            "CLPostImageProcessor create handler(type:%d) failed", i);
+        install_handler ((HandlerType)i, handlers[i]);
     }
-    case CL_WAVELET_HAAR: {
-        image_handler = create_cl_newwavelet_denoise_image_handler (context, _wavelet_channel, _wavelet_bayes_shrink);
-        _newwavelet = image_handler.dynamic_cast_ptr<CLNewWaveletDenoiseImageHandler> ();
+    update_handler_enables ();
+
+    if (_output_pool.ptr ()) {
+        SmartPtr<CLImageHandler> last_handler;
+        for (ImageHandlerList::iterator i_handler = handlers_begin ();
+                i_handler != handlers_end (); ++i_handler) {
+            if ((*i_handler)->is_handler_enabled ())
+                last_handler = *i_handler;
+        }
         XCAM_FAIL_RETURN (
             WARNING,
-            _newwavelet.ptr (),
-            XCAM_RETURN_ERROR_CL,
-            "CLPostImageProcessor create new wavelet denoise handler failed");
-        _newwavelet->enable_handler (true);
-        image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-        image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
-        add_handler (image_handler);
-        break;
-    }
-    case CL_WAVELET_DISABLED:
-    default :
-        XCAM_LOG_DEBUG ("unknown or disable wavelet (%d)", _wavelet_basis);
-        break;
+            last_handler.ptr () && !last_handler->is_buf_pool_disabled (),
+            XCAM_RETURN_ERROR_PARAM,
+            "CLPostImageProcessor output pool set but no handler writes output");
+
+        // handlers toggled later, e.g. by set_degraded, may fall back to pool of an earlier handler
+        last_handler->set_buffer_pool (_output_pool);
+        XCAM_LOG_INFO (
+            "CLPostImageProcessor handler(%s) outputs into external pool", XCAM_STR (last_handler->get_name ()));
     }
 
-    /* 3D noise reduction */
-    if (_3d_denoise_mode != CLPostImageProcessor::Denoise3DDisabled) {
-        uint32_t denoise_channel = CL_IMAGE_CHANNEL_UV;
+    return XCAM_RETURN_NO_ERROR;
+}
 
-        if (_3d_denoise_mode == CLPostImageProcessor::Denoise3DUV) {
-            denoise_channel = CL_IMAGE_CHANNEL_UV;
-        } else if (_3d_denoise_mode == CLPostImageProcessor::Denoise3DYuv) {
-            denoise_channel = CL_IMAGE_CHANNEL_Y | CL_IMAGE_CHANNEL_UV;
-        }
+XCamReturn
+CLPostImageProcessor::update_handlers ()
+{
+    // handlers are created with first frame
+    if (handlers_begin () == handlers_end ())
+        return XCAM_RETURN_NO_ERROR;
 
-        image_handler = create_cl_3d_denoise_image_handler (context, denoise_channel, _3d_denoise_ref_count);
-        _3d_denoise = image_handler.dynamic_cast_ptr<CL3DDenoiseImageHandler> ();
+    for (uint32_t i = 0; i < HandlerTypeCount; ++i) {
+        if (_type_handlers[i].ptr () || !is_handler_needed ((HandlerType)i))
+            continue;
+
+        // kernels are built in caller thread, frames wait on STREAM_LOCK meanwhile
+        SmartPtr<CLImageHandler> handler = create_handler ((HandlerType)i);
         XCAM_FAIL_RETURN (
             WARNING,
-            _3d_denoise.ptr (),
+            handler.ptr (),
             XCAM_RETURN_ERROR_CL,
-            "CL3aImageProcessor create 3D noise reduction handler failed");
-        image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-        image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-        image_handler->enable_handler (true);
-        add_handler (image_handler);
+            "CLPostImageProcessor create handler(type:%d) failed", i);
+        install_handler ((HandlerType)i, handler);
+        XCAM_LOG_INFO ("CLPostImageProcessor created handler(%s) while running", XCAM_STR (handler->get_name ()));
     }
-
-    /* image scaler */
-    image_handler = create_cl_image_scaler_handler (context, V4L2_PIX_FMT_NV12);
-    _scaler = image_handler.dynamic_cast_ptr<CLImageScaler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _scaler.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create scaler handler failed");
-    _scaler->set_scaler_factor (_scaler_factor, _scaler_factor);
-    _scaler->set_buffer_callback (_stats_callback);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->enable_handler (_enable_scaler);
-    add_handler (image_handler);
-
-    /* wire frame */
-    image_handler = create_cl_wire_frame_image_handler (context);
-    _wireframe = image_handler.dynamic_cast_ptr<CLWireFrameImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _wireframe.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create wire frame handler failed");
-    _wireframe->enable_handler (_enable_wireframe);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
-    add_handler (image_handler);
-
-    /* image warp */
-    image_handler = create_cl_image_warp_handler (context);
-    _image_warp = image_handler.dynamic_cast_ptr<CLImageWarpHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _image_warp.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create image warp handler failed");
-    _image_warp->enable_handler (_enable_image_warp);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-    add_handler (image_handler);
-
-    /* video stabilization */
-    image_handler = create_cl_video_stab_handler (context);
-    _video_stab = image_handler.dynamic_cast_ptr<CLVideoStabilizer> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _video_stab.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create video stabilizer failed");
-    _video_stab->enable_handler (false);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-    add_handler (image_handler);
-
-    /* image stitch */
-    image_handler =
-        create_image_360_stitch (context, _stitch_enable_seam, _stitch_scale_mode,
-                                 _stitch_fisheye_map, _stitch_lsc, (SurroundMode) _surround_mode, (StitchResMode) _stitch_res_mode);
-    _stitch = image_handler.dynamic_cast_ptr<CLImage360Stitch> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _stitch.ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create image stitch handler failed");
-    _stitch->set_output_size (_stitch_width, _stitch_height);
-#if HAVE_OPENCV
-    _stitch->set_feature_match_ocl (_stitch_fm_ocl);
-#endif
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_MAX_POOL_SIZE);
-    image_handler->enable_handler (_enable_stitch);
-    add_handler (image_handler);
-
-    /* csc (nv12torgba) */
-    image_handler = create_cl_csc_image_handler (context, CL_CSC_TYPE_NV12TORGBA);
-    _csc = image_handler.dynamic_cast_ptr<CLCscImageHandler> ();
-    XCAM_FAIL_RETURN (
-        WARNING,
-        _csc .ptr (),
-        XCAM_RETURN_ERROR_CL,
-        "CLPostImageProcessor create csc handler failed");
-    _csc->enable_handler (_out_sample_type == OutSampleRGB);
-    _csc->set_output_format (_output_fourcc);
-    image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
-    image_handler->set_pool_size (XCAM_CL_POST_IMAGE_DEFAULT_POOL_SIZE);
-    add_handler (image_handler);
+    update_handler_enables ();
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -443,17 +681,18 @@ CLPostImageProcessor::set_tnr (CLTnrMode mode)
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
-CLPostImageProcessor::set_defog_mode (CLDefogMode mode)
+CLPostImageProcessor::set_defog_mode (CLDefogMode mode, uint32_t dcp_downscale)
 {
     _defog_mode = mode;
+    _defog_dcp_downscale = dcp_downscale;
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
@@ -465,7 +704,22 @@ CLPostImageProcessor::set_wavelet (CLWaveletBasis basis, uint32_t channel, bool
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
+}
+
+void
+CLPostImageProcessor::set_degraded (bool degraded)
+{
+    STREAM_LOCK;
+
+    if (_degraded == degraded)
+        return;
+    _degraded = degraded;
+
+    // handlers only exist once started, they read the flag per frame
+    update_handler_enables ();
+
+    XCAM_LOG_INFO ("CLPostImageProcessor %s defog and wavelet", degraded ? "bypasses" : "resumes");
 }
 
 bool
@@ -476,7 +730,7 @@ CLPostImageProcessor::set_3ddenoise_mode (CL3DDenoiseMode mode, uint8_t ref_fram
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
@@ -486,7 +740,7 @@ CLPostImageProcessor::set_scaler (bool enable)
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
@@ -496,7 +750,7 @@ CLPostImageProcessor::set_wireframe (bool enable)
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
@@ -506,7 +760,7 @@ CLPostImageProcessor::set_image_warp (bool enable)
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 bool
@@ -537,7 +791,7 @@ CLPostImageProcessor::set_image_stitch (
 
     STREAM_LOCK;
 
-    return true;
+    return xcam_ret_is_ok (update_handlers ());
 }
 
 };
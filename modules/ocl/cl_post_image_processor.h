@@ -27,23 +27,26 @@
 #include <ocl/cl_image_processor.h>
 #include <stats_callback_interface.h>
 #include <ocl/cl_blender.h>
+#include <ocl/cl_image_scaler.h>
 #include <ocl/cl_utils.h>
 
 namespace XCam {
 
 class CLTnrImageHandler;
 class CLRetinexImageHandler;
+class CLGaussPyramid;
 class CLCscImageHandler;
 class CLDefogDcpImageHandler;
 class CLWaveletDenoiseImageHandler;
 class CLNewWaveletDenoiseImageHandler;
 class CL3DDenoiseImageHandler;
-class CLImageScaler;
 class CLWireFrameImageHandler;
 class CLImageWarpHandler;
 class CLImage360Stitch;
 class CLVideoStabilizer;
 
+class CLPostHandlerCreator;
+
 class CLPostImageProcessor
     : public CLImageProcessor
 {
@@ -76,18 +79,32 @@ public:
     virtual ~CLPostImageProcessor ();
 
     bool set_output_format (uint32_t fourcc);
+    // crops and scales in the final csc pass, for RGBA and YUYV outputs, zero size keeps crop size,
+    // NV12 output is cropped and scaled by image warp if enabled
+    bool set_output_crop_scale (const Rect &crop, uint32_t width, uint32_t height);
     void set_stats_callback (const SmartPtr<StatsCallback> &callback);
+    // last enabled handler writes into buffers of @pool, e.g. DrmBoBuffer of encoder input surfaces
+    // shared into CL, pool info need match output, need be called before start
+    bool set_output_pool (const SmartPtr<BufferPool> &pool);
 
     bool set_scaler_factor (const double factor);
     double get_scaler_factor () const {
         return _scaler_factor;
     }
+    // one more scaled output per call after the one of set_scaler_factor, polyphase filters only,
+    // need be called before start, posted buffers carry CLScalerOutputMeta of their output
+    bool add_scaler_factor (const double factor);
+    // polyphase filters support NV12 only
+    bool set_scaler_filter (CLImageScalerFilter filter);
     bool is_scaled () {
         return _enable_scaler;
     }
 
+    // handlers are only created for enabled features, features enabled after start
+    // create their handlers in the call, options built into existing handlers are kept
     virtual bool set_tnr (CLTnrMode mode);
-    virtual bool set_defog_mode (CLDefogMode mode);
+    // dcp_downscale 4 or 8 estimates dark channel prior at low resolution
+    virtual bool set_defog_mode (CLDefogMode mode, uint32_t dcp_downscale = 1);
     virtual bool set_wavelet (CLWaveletBasis basis, uint32_t channel, bool bayes_shrink);
     virtual bool set_3ddenoise_mode (CL3DDenoiseMode mode, uint8_t ref_frame_count);
     virtual bool set_scaler (bool enable);
@@ -97,23 +114,63 @@ public:
         bool enable_stitch, bool enable_seam, CLBlenderScaleMode scale_mode, bool enable_fisheye_map,
         bool lsc, bool fm_ocl, uint32_t stitch_width, uint32_t stitch_height, uint32_t res_mode);
 
+    // bypass defog and wavelet handlers while running late, configured modes are kept
+    void set_degraded (bool degraded);
+    bool is_degraded () const {
+        return _degraded;
+    }
+
 protected:
     virtual bool can_process_result (SmartPtr<X3aResult> &result);
     virtual XCamReturn apply_3a_results (X3aResultList &results);
     virtual XCamReturn apply_3a_result (SmartPtr<X3aResult> &result);
 
 private:
+    friend class CLPostHandlerCreator;
+
+    enum HandlerType {
+        HandlerRetinex = 0,
+        HandlerDefogDcp,
+        HandlerTnr,
+        HandlerWavelet,
+        HandlerNewWavelet,
+        Handler3DDenoise,
+        HandlerScaler,
+        HandlerWireFrame,
+        HandlerImageWarp,
+        HandlerVideoStab,
+        HandlerStitch,
+        HandlerCsc,
+        HandlerTypeCount
+    };
+
     virtual XCamReturn create_handlers ();
+    // kernels of handlers are built in parallel, NULL if handler not needed
+    void create_handlers_parallel (SmartPtr<CLImageHandler> (&handlers)[HandlerTypeCount]);
+    SmartPtr<CLImageHandler> create_handler (HandlerType type);
+    // only handlers of enabled features are created, csc is always kept for pass through
+    bool is_handler_needed (HandlerType type) const;
+    XCamReturn install_handler (HandlerType type, SmartPtr<CLImageHandler> &handler);
+    // creates handlers of features enabled after start, need STREAM_LOCK
+    XCamReturn update_handlers ();
+    void update_handler_enables ();
+    bool need_fused_output () const;
+    bool need_warp_output () const;
 
     XCAM_DEAD_COPY (CLPostImageProcessor);
 
 private:
     uint32_t                                  _output_fourcc;
     OutSampleType                             _out_sample_type;
+    Rect                                      _out_crop;
+    uint32_t                                  _out_width;
+    uint32_t                                  _out_height;
     SmartPtr<StatsCallback>                   _stats_callback;
+    SmartPtr<BufferPool>                      _output_pool;
 
     SmartPtr<CLTnrImageHandler>               _tnr;
     SmartPtr<CLRetinexImageHandler>           _retinex;
+    SmartPtr<CLGaussPyramid>                  _gauss_pyramid;
     SmartPtr<CLDefogDcpImageHandler>          _defog_dcp;
     SmartPtr<CLWaveletDenoiseImageHandler>    _wavelet;
     SmartPtr<CLNewWaveletDenoiseImageHandler> _newwavelet;
@@ -124,11 +181,15 @@ private:
     SmartPtr<CLImageWarpHandler>              _image_warp;
     SmartPtr<CLImage360Stitch>                _stitch;
     SmartPtr<CLVideoStabilizer>               _video_stab;
+    SmartPtr<CLImageHandler>                  _type_handlers[HandlerTypeCount];
 
     double                                    _scaler_factor;
+    std::vector<double>                       _scaler_extra_factors;
+    CLImageScalerFilter                       _scaler_filter;
 
     CLTnrMode                                 _tnr_mode;
     CLDefogMode                               _defog_mode;
+    uint32_t                                  _defog_dcp_downscale;
     CLWaveletBasis                            _wavelet_basis;
     uint32_t                                  _wavelet_channel;
     bool                                      _wavelet_bayes_shrink;
@@ -147,6 +208,7 @@ private:
     uint32_t                                  _stitch_height;
     uint32_t                                  _stitch_res_mode;
     uint32_t                                  _surround_mode;
+    bool                                      _degraded;
 };
 
 };
@@ -39,6 +39,10 @@
 #define SEAM_SUM_TYPE float
 #define SEAM_MASK_TYPE uint8_t
 
+// keep same as SLM_TILE_TX and SLM_TILE_H in kernel_gauss_lap_pyramid.cl
+#define PYRAMID_SLM_TILE_TX 8
+#define PYRAMID_SLM_TILE_H 32
+
 namespace XCam {
 
 enum {
@@ -52,7 +56,10 @@ enum {
     KernelSeamDP,
     KernelSeamMaskScale,
     KernelSeamMaskScaleSLM,
-    KernelSeamBlender
+    KernelSeamBlender,
+    KernelPyramidGaussLapSLM,
+    KernelPyramidReconstructSLM,
+    KernelPyramidReconstructScale
 };
 
 static const XCamKernelInfo kernels_info [] = {
@@ -108,6 +115,21 @@ static const XCamKernelInfo kernels_info [] = {
     },
     {
         "kernel_seam_mask_blend",
+#include "kernel_gauss_lap_pyramid.clx"
+        , 0,
+    },
+    {
+        "kernel_gauss_lap_slm",
+#include "kernel_gauss_lap_pyramid.clx"
+        , 0,
+    },
+    {
+        "kernel_lap_reconstruct_slm",
+#include "kernel_gauss_lap_pyramid.clx"
+        , 0,
+    },
+    {
+        "kernel_gauss_lap_reconstruct_scale",
 #include "kernel_gauss_lap_pyramid.clx"
         , 0,
     }
@@ -210,6 +232,14 @@ CLPyramidBlender::CLPyramidBlender (
     , _seam_pos_offset_x (0)
     , _seam_pos_valid_width (0)
     , _seam_mask_done (false)
+    , _seam_band_width (0)
+    , _seam_update_interval (XCAM_CL_SEAM_UPDATE_INTERVAL)
+    , _seam_band_radius (XCAM_CL_SEAM_BAND_RADIUS)
+    , _seam_cost_change (XCAM_CL_SEAM_COST_CHANGE)
+    , _seam_frame_count (0)
+    , _seam_ref_cost (0.0f)
+    , _seam_full_search (true)
+    , _seam_need_full (true)
 {
     if (layers <= 1)
         _layers = 1;
@@ -266,6 +296,13 @@ CLPyramidBlender::get_scale_image (bool is_uv)
     return _pyramid_layers[0].scale_image[plane];
 }
 
+bool
+CLPyramidBlender::is_scale_folded () const
+{
+    // a single level is blended into reconstruct image of level 0, which is scaled alone
+    return (get_scale_mode () == CLBlenderScaleLocal && _layers > 1 && !CL_PYRAMID_ENABLE_DUMP);
+}
+
 SmartPtr<CLBuffer>
 CLPyramidBlender::get_blend_mask (uint32_t layer, bool is_uv)
 {
@@ -308,11 +345,21 @@ CLPyramidBlender::get_seam_pos_info (uint32_t &offset_x, uint32_t &valid_width)
     valid_width = _seam_pos_valid_width;
 }
 
+void
+CLPyramidBlender::set_seam_update (uint32_t interval, uint32_t band_radius, float cost_change)
+{
+    _seam_update_interval = interval;
+    _seam_band_radius = band_radius;
+    _seam_cost_change = XCAM_MAX (cost_change, 0.0f);
+    _seam_need_full = true;
+}
+
 void
 PyramidLayer::bind_buf_to_layer0 (
     SmartPtr<CLContext> context,
     SmartPtr<VideoBuffer> &input0, SmartPtr<VideoBuffer> &input1, SmartPtr<VideoBuffer> &output,
-    const Rect &merge0_rect, const Rect &merge1_rect, bool need_uv, CLBlenderScaleMode scale_mode)
+    const Rect &merge0_rect, const Rect &merge1_rect, bool need_uv, CLBlenderScaleMode scale_mode,
+    bool scale_folded)
 {
     const VideoBufferInfo &in0_info = input0->get_video_info ();
     const VideoBufferInfo &in1_info = input1->get_video_info ();
@@ -349,13 +396,17 @@ PyramidLayer::bind_buf_to_layer0 (
 
         if (scale_mode == CLBlenderScaleLocal) {
             this->scale_image[i_plane] = convert_to_climage (context, output, cl_desc, out_info.offsets[i_plane]);
+            XCAM_ASSERT (this->scale_image[i_plane].ptr ());
+            // level 0 is reconstructed into scale image directly
+            if (scale_folded)
+                continue;
 
             cl_desc.width = XCAM_ALIGN_UP (this->blend_width, XCAM_CL_BLENDER_ALIGNMENT_X) / 8;
             cl_desc.height = XCAM_ALIGN_UP (this->blend_height, divider_vert[i_plane]) / divider_vert[i_plane];
             uint32_t row_pitch = CLImage::calculate_pixel_bytes (cl_desc.format) *
                                  XCAM_ALIGN_UP (cl_desc.width, XCAM_CL_IMAGE_ALIGNMENT_X);
             uint32_t size = row_pitch * cl_desc.height;
-            SmartPtr<CLBuffer> cl_buf = new CLBuffer (context, size);
+            SmartPtr<CLBuffer> cl_buf = CLMemoryPool::instance ()->get_buffer (context, size);
             XCAM_ASSERT (cl_buf.ptr () && cl_buf->is_valid ());
             cl_desc.row_pitch = row_pitch;
             this->blend_image[i_plane][ReconstructImageIndex] = new CLImage2D (context, cl_desc, 0, cl_buf);
@@ -376,7 +427,7 @@ PyramidLayer::init_layer0 (SmartPtr<CLContext> context, bool last_layer, bool ne
     //init mask
     this->mask_width[0] = this->blend_width;
     uint32_t mask_size = this->mask_width[0] * sizeof (float);
-    this->blend_mask[0] = new CLBuffer(context, mask_size);
+    this->blend_mask[0] = CLMemoryPool::instance ()->get_buffer (context, mask_size);
     float *blend_ptr = NULL;
     XCamReturn ret = this->blend_mask[0]->enqueue_map((void*&)blend_ptr, 0, mask_size);
     if (!xcam_ret_is_ok (ret)) {
@@ -408,16 +459,16 @@ PyramidLayer::init_layer0 (SmartPtr<CLContext> context, bool last_layer, bool ne
         cl_desc.width = this->blend_width / 8;
         cl_desc.height = XCAM_ALIGN_UP (this->blend_height, divider_vert[i_plane]) / divider_vert[i_plane];
 
-        this->blend_image[i_plane][BlendImageIndex] = new CLImage2D (context, cl_desc);
-        this->lap_image[i_plane][0] = new CLImage2D (context, cl_desc);
-        this->lap_image[i_plane][1] = new CLImage2D (context, cl_desc);
+        this->blend_image[i_plane][BlendImageIndex] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+        this->lap_image[i_plane][0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+        this->lap_image[i_plane][1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
         this->lap_offset_x[i_plane][0] = this->lap_offset_x[i_plane][1] = 0;
 
 #if CL_PYRAMID_ENABLE_DUMP
-        this->dump_gauss_resize[i_plane] = new CLImage2D (context, cl_desc);
-        this->dump_original[i_plane][0] = new CLImage2D (context, cl_desc);
-        this->dump_original[i_plane][1] = new CLImage2D (context, cl_desc);
-        this->dump_final[i_plane] = new CLImage2D (context, cl_desc);
+        this->dump_gauss_resize[i_plane] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+        this->dump_original[i_plane][0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+        this->dump_original[i_plane][1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
+        this->dump_final[i_plane] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc);
 #endif
     }
 }
@@ -444,7 +495,7 @@ PyramidLayer::build_cl_images (SmartPtr<CLContext> context, bool last_layer, boo
             row_pitch = CLImage::calculate_pixel_bytes (cl_desc_set.format) *
                         XCAM_ALIGN_UP (cl_desc_set.width, XCAM_CL_IMAGE_ALIGNMENT_X);
             size = row_pitch * cl_desc_set.height;
-            cl_buf = new CLBuffer (context, size);
+            cl_buf = CLMemoryPool::instance ()->get_buffer (context, size);
             XCAM_ASSERT (cl_buf.ptr () && cl_buf->is_valid ());
             cl_desc_set.row_pitch = row_pitch;
             this->gauss_image[plane][i_image] = new CLImage2D (context, cl_desc_set, 0, cl_buf);
@@ -457,23 +508,23 @@ PyramidLayer::build_cl_images (SmartPtr<CLContext> context, bool last_layer, boo
         row_pitch = CLImage::calculate_pixel_bytes (cl_desc_set.format) *
                     XCAM_ALIGN_UP (cl_desc_set.width, XCAM_CL_IMAGE_ALIGNMENT_X);
         size = row_pitch * cl_desc_set.height;
-        cl_buf = new CLBuffer (context, size);
+        cl_buf = CLMemoryPool::instance ()->get_buffer (context, size);
         XCAM_ASSERT (cl_buf.ptr () && cl_buf->is_valid ());
         cl_desc_set.row_pitch = row_pitch;
         this->blend_image[plane][ReconstructImageIndex] = new CLImage2D (context, cl_desc_set, 0, cl_buf);
         XCAM_ASSERT (this->blend_image[plane][ReconstructImageIndex].ptr ());
 #if CL_PYRAMID_ENABLE_DUMP
-        this->dump_gauss_resize[plane] = new CLImage2D (context, cl_desc_set);
-        this->dump_original[plane][0] = new CLImage2D (context, cl_desc_set);
-        this->dump_original[plane][1] = new CLImage2D (context, cl_desc_set);
-        this->dump_final[plane] = new CLImage2D (context, cl_desc_set);
+        this->dump_gauss_resize[plane] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
+        this->dump_original[plane][0] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
+        this->dump_original[plane][1] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
+        this->dump_final[plane] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
 #endif
         if (!last_layer) {
             cl_desc_set.row_pitch = 0;
-            this->blend_image[plane][BlendImageIndex] = new CLImage2D (context, cl_desc_set);
+            this->blend_image[plane][BlendImageIndex] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
             XCAM_ASSERT (this->blend_image[plane][BlendImageIndex].ptr ());
             for (int i_image = 0; i_image < XCAM_BLENDER_IMAGE_NUM; ++i_image) {
-                this->lap_image[plane][i_image] = new CLImage2D (context, cl_desc_set);
+                this->lap_image[plane][i_image] = CLMemoryPool::instance ()->get_image_2d (context, cl_desc_set);
                 XCAM_ASSERT (this->lap_image[plane][i_image].ptr ());
                 this->lap_offset_x[plane][i_image]  = 0; // offset to 0, need calculate from next layer if for deep multi-band blender
             }
@@ -563,7 +614,7 @@ gauss_fill_mask (
 
     //gauss to[0]
     to.mask_width[0] = to.blend_width;
-    to.blend_mask[0] = new CLBuffer (context, mask_size);
+    to.blend_mask[0] = CLMemoryPool::instance ()->get_buffer (context, mask_size);
     XCAM_ASSERT (to.blend_mask[0].ptr ());
     float *mask0_ptr = NULL;
     ret = to.blend_mask[0]->enqueue_map((void*&)mask0_ptr, 0, mask_size);
@@ -610,7 +661,7 @@ CLPyramidBlender::allocate_cl_buffers (
     _pyramid_layers[0].bind_buf_to_layer0 (
         context, input0, input1, output,
         get_input_merge_area (0), get_input_merge_area (1),
-        need_uv (), get_scale_mode ());
+        need_uv (), get_scale_mode (), is_scale_folded ());
 
     if (need_reallocate) {
         int g_radius = (((float)(window.width - 1) / 2) / (1 << _layers)) * 1.2f;
@@ -637,6 +688,8 @@ CLPyramidBlender::allocate_cl_buffers (
     //last layer buffer redirect
     last_layer_buffer_redirect ();
     _seam_mask_done = false;
+    _seam_path.clear ();
+    _seam_need_full = true;
 
     BLENDER_PROFILING_END (allocate_cl_buffers, 50);
 
@@ -694,6 +747,14 @@ CLPyramidBlender::init_seam_buffers (SmartPtr<CLContext> context)
         XCAM_RETURN_ERROR_CL,
         "CLPyramidBlender init seam buffer failed to create seam buffers");
 
+    _seam_band_buf = new CLBuffer (context, sizeof (int32_t) * _seam_height, CL_MEM_READ_ONLY);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _seam_band_buf.ptr () && _seam_band_buf->is_valid (),
+        XCAM_RETURN_ERROR_CL,
+        "CLPyramidBlender init seam buffer failed to create seam band buffer");
+    _seam_band.resize (_seam_height);
+
     uint32_t mask_width = XCAM_ALIGN_UP(_seam_width, XCAM_CL_BLENDER_ALIGNMENT_X);
     uint32_t mask_height = XCAM_ALIGN_UP(_seam_height, 2);
     for (uint32_t i = 0; i < _layers; ++i) {
@@ -705,8 +766,8 @@ CLPyramidBlender::init_seam_buffers (SmartPtr<CLContext> context)
                             XCAM_ALIGN_UP (cl_desc.width, XCAM_CL_IMAGE_ALIGNMENT_X);
 
         uint32_t mask_size = cl_desc.row_pitch * mask_height;
-        SmartPtr<CLBuffer> cl_buf0 = new CLBuffer (context, mask_size);
-        SmartPtr<CLBuffer> cl_buf1 = new CLBuffer (context, mask_size);
+        SmartPtr<CLBuffer> cl_buf0 = CLMemoryPool::instance ()->get_buffer (context, mask_size);
+        SmartPtr<CLBuffer> cl_buf1 = CLMemoryPool::instance ()->get_buffer (context, mask_size);
         XCAM_ASSERT (cl_buf0.ptr () && cl_buf0->is_valid () && cl_buf1.ptr () && cl_buf1->is_valid ());
 
         _pyramid_layers[i].seam_mask[CLSeamMaskTmp] = new CLImage2D (context, cl_desc, 0, cl_buf0);
@@ -738,6 +799,41 @@ assign_mask_line (SEAM_MASK_TYPE *mask_ptr, int line, int stride, int delimiter)
     memset (line_ptr + mask_1_len, MASK_0, sizeof (SEAM_MASK_TYPE) * (stride - mask_1_len));
 }
 
+XCamReturn
+CLPyramidBlender::prepare_seam_band ()
+{
+    XCAM_ASSERT (_seam_band_buf.ptr () && _seam_band.size () == _seam_height);
+
+    int32_t min_x = (int32_t)_seam_pos_offset_x;
+    int32_t max_x = (int32_t)(_seam_pos_offset_x + _seam_pos_valid_width) - 1;
+    uint32_t band_width = _seam_band_radius * 2 + 1;
+
+    _seam_full_search =
+        _seam_need_full || _seam_path.size () != _seam_height || band_width >= _seam_pos_valid_width ||
+        (_seam_update_interval && _seam_frame_count >= _seam_update_interval);
+
+    if (_seam_full_search) {
+        _seam_band_width = _seam_pos_valid_width;
+        std::fill (_seam_band.begin (), _seam_band.end (), min_x);
+        _seam_frame_count = 0;
+        _seam_need_full = false;
+    } else {
+        // seam moves 1 column per row at most, so does the band around it
+        _seam_band_width = band_width;
+        for (uint32_t i = 0; i < _seam_height; ++i) {
+            _seam_band[i] = XCAM_CLAMP (
+                _seam_path[i] - (int32_t)_seam_band_radius, min_x, max_x - (int32_t)band_width + 1);
+        }
+    }
+    ++_seam_frame_count;
+    _seam_mask_done = false;
+
+    XCamReturn ret = _seam_band_buf->enqueue_write (&_seam_band[0], 0, sizeof (int32_t) * _seam_height);
+    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLPyramidBlender write seam band failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLPyramidBlender::fill_seam_mask ()
 {
@@ -755,11 +851,20 @@ CLPyramidBlender::fill_seam_mask ()
     ret = _seam_sum_buf->enqueue_map ((void *&)sum_ptr, 0, sum_buf_size, CL_MAP_READ);
     XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLPyramidBlender map seam_sum_buf failed");
 
+    // both halves meet in columns shared by bands of the two middle rows
+    int mid_row = _seam_height / 2;
+    int start_x = _seam_band[mid_row];
+    int end_x = _seam_band[mid_row] + (int)_seam_band_width;
+    if (mid_row > 0) {
+        start_x = XCAM_MAX (start_x, _seam_band[mid_row - 1]);
+        end_x = XCAM_MIN (end_x, _seam_band[mid_row - 1] + (int)_seam_band_width);
+    }
+
     float min_sum = 9999999999.0f, tmp_sum;
-    int pos = 0, min_pos0, min_pos1;
+    int pos = start_x, min_pos0, min_pos1;
     int i = 0;
     SEAM_SUM_TYPE *sum_ptr0 = sum_ptr, *sum_ptr1 = sum_ptr + _seam_pos_stride;
-    for (i = (int)_seam_pos_offset_x; i < (int)(_seam_pos_offset_x + _seam_pos_valid_width); ++i) {
+    for (i = start_x; i < end_x; ++i) {
         tmp_sum = sum_ptr0[i] + sum_ptr1[i];
         if (tmp_sum >= min_sum)
             continue;
@@ -769,8 +874,37 @@ CLPyramidBlender::fill_seam_mask ()
     _seam_sum_buf->enqueue_unmap ((void*)sum_ptr);
     min_pos0 = min_pos1 = pos;
 
+    if (_seam_full_search) {
+        _seam_ref_cost = min_sum;
+    } else if (min_sum > XCAM_MAX (_seam_ref_cost, (float)_seam_height) * (1.0f + _seam_cost_change)) {
+        // scene changed, a better seam may be out of band
+        _seam_need_full = true;
+    }
+
     BLENDER_PROFILING_START (fill_seam_mask);
 
+    std::vector<int32_t> path (_seam_height);
+    ret = _seam_pos_buf->enqueue_map ((void *&)pos_ptr, 0, pos_buf_size, CL_MAP_READ);
+    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLPyramidBlender map seam_pos_buf failed");
+    XCAM_LOG_DEBUG ("CLPyramidBlender seam min sum:%.3f, pos:%d", min_sum, pos);
+    for (i = _seam_height / 2 - 1; i >= 0; --i) {
+        path[i] = min_pos0;
+        min_pos0 = pos_ptr [i * _seam_pos_stride + min_pos0];
+    }
+
+    for (i = _seam_height / 2; i < (int)_seam_height; ++i) {
+        path[i] = min_pos1;
+        min_pos1 = pos_ptr [i * _seam_pos_stride + min_pos1];
+    }
+    _seam_pos_buf->enqueue_unmap ((void*)pos_ptr);
+
+    _seam_mask_done = true;
+    if (path == _seam_path) {
+        BLENDER_PROFILING_END (fill_seam_mask, 50);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    _seam_path.swap (path);
+
     // reset layer0 seam_mask
     SmartPtr<CLImage> seam_mask = _pyramid_layers[0].seam_mask[CLSeamMaskTmp];
     const CLImageDesc &mask_desc = seam_mask->get_image_desc ();
@@ -782,26 +916,15 @@ CLPyramidBlender::fill_seam_mask ()
                                   &mask_row_pitch, &mask_slice_pitch, CL_MAP_READ);
     XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLPyramidBlender map seam_mask failed");
     uint32_t mask_stride = mask_row_pitch / sizeof (SEAM_MASK_TYPE);
-    ret = _seam_pos_buf->enqueue_map ((void *&)pos_ptr, 0, pos_buf_size, CL_MAP_READ);
-    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLPyramidBlender map seam_pos_buf failed");
-    //printf ("***********min sum:%.3f, pos:%d, sum0:%.3f, sum1:%.3f\n", min_sum, pos, sum_ptr0[pos], sum_ptr1[pos]);
-    for (i = _seam_height / 2 - 1; i >= 0; --i) {
-        assign_mask_line (mask_ptr, i, mask_stride, min_pos0);
-        min_pos0 = pos_ptr [i * _seam_pos_stride + min_pos0];
-    }
 
-    for (i = _seam_height / 2; i < (int)_seam_height; ++i) {
-        assign_mask_line (mask_ptr, i, mask_stride, min_pos1);
-        min_pos1 = pos_ptr [i * _seam_pos_stride + min_pos1];
+    for (i = 0; i < (int)_seam_height; ++i) {
+        assign_mask_line (mask_ptr, i, mask_stride, _seam_path[i]);
     }
     for (; i < (int)mask_desc.height; ++i) {
-        assign_mask_line (mask_ptr, i, mask_stride, min_pos1);
+        assign_mask_line (mask_ptr, i, mask_stride, _seam_path[_seam_height - 1]);
     }
 
     seam_mask->enqueue_unmap ((void*)mask_ptr);
-    _seam_pos_buf->enqueue_unmap ((void*)pos_ptr);
-
-    _seam_mask_done = true;
 
     BLENDER_PROFILING_END (fill_seam_mask, 50);
     return XCAM_RETURN_NO_ERROR;
@@ -841,10 +964,11 @@ CLPyramidBlendKernel::CLPyramidBlendKernel (
     , _is_uv (is_uv)
     , _need_seam (need_seam)
 {
+    declare_arg_slots (4);
 }
 
 XCamReturn
-CLPyramidBlendKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
+CLPyramidBlendKernel::bind_arguments (CLWorkSize &work_size)
 {
     SmartPtr<CLContext> context = get_context ();
 
@@ -860,10 +984,10 @@ CLPyramidBlendKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     XCAM_ASSERT (image_in0.ptr () && image_in1.ptr () && image_out.ptr ());
     const CLImageDesc &cl_desc_out = image_out->get_image_desc ();
 
-    args.push_back (new CLMemArgument (image_in0));
-    args.push_back (new CLMemArgument (image_in1));
-    args.push_back (new CLMemArgument (buf_mask));
-    args.push_back (new CLMemArgument (image_out));
+    bind_mem_arg (0, image_in0);
+    bind_mem_arg (1, image_in1);
+    bind_mem_arg (2, buf_mask);
+    bind_mem_arg (3, image_out);
 
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.local[0] = 8;
@@ -1013,20 +1137,20 @@ CLSeamDPKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
 {
 #define ELEMENT_PIXEL 1
 
+    XCamReturn ret = _blender->prepare_seam_band ();
+    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "CLSeamDPKernel prepare seam band failed");
+
     uint32_t width, height, stride;
-    uint32_t pos_offset_x, pos_valid_width;
     _blender->get_seam_info (width, height, stride);
-    _blender->get_seam_pos_info (pos_offset_x, pos_valid_width);
     int seam_height = (int)height;
     int seam_stride = (int)stride / ELEMENT_PIXEL;
-    int seam_offset_x = (int)pos_offset_x / ELEMENT_PIXEL; // ushort8
-    int seam_valid_with = (int)pos_valid_width / ELEMENT_PIXEL;
-    int max_pos = (int)(pos_offset_x + pos_valid_width - 1);
+    int band_width = (int)_blender->get_seam_band_width () / ELEMENT_PIXEL;
 
     SmartPtr<CLImage> image = _blender->get_image_diff ();
     SmartPtr<CLBuffer> pos_buf = _blender->get_seam_pos_buf ();
     SmartPtr<CLBuffer> sum_buf = _blender->get_seam_sum_buf ();
-    XCAM_ASSERT (image.ptr () && pos_buf.ptr () && sum_buf.ptr ());
+    SmartPtr<CLBuffer> band_buf = _blender->get_seam_band_buf ();
+    XCAM_ASSERT (image.ptr () && pos_buf.ptr () && sum_buf.ptr () && band_buf.ptr ());
 
     CLImageDesc cl_orig = image->get_image_desc ();
     CLImageDesc cl_desc_convert;
@@ -1043,14 +1167,13 @@ CLSeamDPKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     args.push_back (new CLMemArgument (convert_image));
     args.push_back (new CLMemArgument (pos_buf));
     args.push_back (new CLMemArgument (sum_buf));
-    args.push_back (new CLArgumentT<int> (seam_offset_x));
-    args.push_back (new CLArgumentT<int> (seam_valid_with));
-    args.push_back (new CLArgumentT<int> (max_pos));
+    args.push_back (new CLMemArgument (band_buf));
+    args.push_back (new CLArgumentT<int> (band_width));
     args.push_back (new CLArgumentT<int> (seam_height));
     args.push_back (new CLArgumentT<int> (seam_stride));
 
     work_size.dim = 1;
-    work_size.local[0] = XCAM_ALIGN_UP(seam_valid_with, 16);
+    work_size.local[0] = XCAM_ALIGN_UP(band_width, 16);
     work_size.global[0] = work_size.local[0] * 2;
 
     return XCAM_RETURN_NO_ERROR;
@@ -1327,6 +1450,81 @@ CLPyramidReconstructKernel::prepare_arguments (CLArgList &args, CLWorkSize &work
     return XCAM_RETURN_NO_ERROR;
 }
 
+static SmartPtr<CLImage>
+convert_to_unorm_image (const SmartPtr<CLContext> &context, const SmartPtr<CLImage> &image, bool is_uv)
+{
+    const CLImageDesc &desc = image->get_image_desc ();
+
+    CLImageDesc new_desc;
+    new_desc.format.image_channel_data_type = CL_UNORM_INT8;
+    if (is_uv) {
+        new_desc.format.image_channel_order = CL_RG;
+        new_desc.width = desc.width * 4;
+    } else {
+        new_desc.format.image_channel_order = CL_R;
+        new_desc.width = desc.width * 8;
+    }
+    new_desc.height = desc.height;
+    new_desc.row_pitch = desc.row_pitch;
+
+    SmartPtr<CLImage> new_image;
+    if (!change_image_format (context, image, new_image, new_desc) || !new_image->is_valid ())
+        return NULL;
+    return new_image;
+}
+
+CLPyramidReconstructScaleKernel::CLPyramidReconstructScaleKernel (
+    const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender, bool is_uv)
+    : CLImageKernel (context)
+    , _blender (blender)
+    , _is_uv (is_uv)
+{
+}
+
+XCamReturn
+CLPyramidReconstructScaleKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
+{
+    SmartPtr<CLContext> context = get_context ();
+    SmartPtr<CLImage> input_reconstruct =
+        convert_to_unorm_image (context, _blender->get_reconstruct_image (1, _is_uv), _is_uv);
+    SmartPtr<CLImage> input_lap =
+        convert_to_unorm_image (context, _blender->get_blend_image (0, _is_uv), _is_uv);
+    SmartPtr<CLImage> image_out = _blender->get_scale_image (_is_uv);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        input_reconstruct.ptr () && input_lap.ptr () && image_out.ptr (),
+        XCAM_RETURN_ERROR_CL,
+        "CLPyramidReconstructScaleKernel change image format failed");
+
+    const Rect &window = _blender->get_merge_window ();
+    const CLImageDesc &rec_desc = input_reconstruct->get_image_desc ();
+    int out_offset_x = window.pos_x / 8;
+    int out_width = window.width / 8;
+    int out_height = input_lap->get_image_desc ().height;
+    XCAM_FAIL_RETURN (ERROR, out_width > 0, XCAM_RETURN_ERROR_PARAM, "CLPyramidReconstructScaleKernel wrong window");
+
+    // scaling reconstructed level 0 sampled it half a pixel back, a quarter pixel of level 1
+    float in_sampler_offset_x = (SAMPLER_POSITION_OFFSET - 0.25f) / rec_desc.width;
+    float in_sampler_offset_y = (SAMPLER_POSITION_OFFSET - 0.25f) / rec_desc.height;
+
+    args.push_back (new CLMemArgument (input_reconstruct));
+    args.push_back (new CLArgumentT<float> (in_sampler_offset_x));
+    args.push_back (new CLArgumentT<float> (in_sampler_offset_y));
+    args.push_back (new CLMemArgument (input_lap));
+    args.push_back (new CLMemArgument (image_out));
+    args.push_back (new CLArgumentT<int> (out_offset_x));
+    args.push_back (new CLArgumentT<int> (out_width));
+    args.push_back (new CLArgumentT<int> (out_height));
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 4;
+    work_size.global[0] = XCAM_ALIGN_UP (out_width, work_size.local[0]);
+    work_size.global[1] = XCAM_ALIGN_UP (out_height, work_size.local[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 
 void
 CLPyramidBlender::dump_buffers ()
@@ -1464,6 +1662,131 @@ CLPyramidBlender::dump_buffers ()
 
 }
 
+CLPyramidGaussLapKernel::CLPyramidGaussLapKernel (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLPyramidBlender> &blender,
+    uint32_t layer,
+    uint32_t buf_index,
+    bool is_uv,
+    bool two_levels)
+    : CLImageKernel (context)
+    , _blender (blender)
+    , _layer (layer)
+    , _buf_index (buf_index)
+    , _is_uv (is_uv)
+    , _two_levels (two_levels)
+{
+    XCAM_ASSERT (layer + (two_levels ? 2 : 1) < XCAM_CL_PYRAMID_MAX_LEVEL);
+    XCAM_ASSERT (buf_index <= XCAM_BLENDER_IMAGE_NUM);
+
+    declare_arg_slots (two_levels ? 12 : 9);
+}
+
+XCamReturn
+CLPyramidGaussLapKernel::bind_arguments (CLWorkSize &work_size)
+{
+    const PyramidLayer &layer = _blender->get_pyramid_layer (_layer);
+    uint32_t plane = (_is_uv ? 1 : 0);
+
+    SmartPtr<CLImage> image_in = _blender->get_gauss_image (_layer, _buf_index, _is_uv);
+    SmartPtr<CLImage> image_lap = _blender->get_lap_image (_layer, _buf_index, _is_uv);
+    SmartPtr<CLImage> image_gauss1 = _blender->get_gauss_image (_layer + 1, _buf_index, _is_uv);
+    const CLImageDesc &lap_desc = image_lap->get_image_desc ();
+    const CLImageDesc &gauss1_desc = image_gauss1->get_image_desc ();
+
+    int in_offset_x = layer.gauss_offset_x[plane][_buf_index] / 8;
+    XCAM_ASSERT (in_offset_x * 8 == layer.gauss_offset_x[plane][_buf_index]);
+    int lap_offset_x = layer.lap_offset_x[plane][_buf_index] / 8;
+    XCAM_ASSERT (lap_offset_x * 8 == layer.lap_offset_x[plane][_buf_index]);
+
+    bind_mem_arg (0, image_in);
+    bind_arg<int> (1, in_offset_x);
+    bind_mem_arg (2, image_lap);
+    bind_arg<int> (3, lap_offset_x);
+    bind_arg<int> (4, (int)lap_desc.width);
+    bind_arg<int> (5, (int)lap_desc.height);
+    bind_arg<int> (6, (int)gauss1_desc.width);
+    bind_arg<int> (7, (int)gauss1_desc.height);
+
+    if (_two_levels) {
+        SmartPtr<CLImage> image_lap1 = _blender->get_lap_image (_layer + 1, _buf_index, _is_uv);
+        SmartPtr<CLImage> image_gauss2 = _blender->get_gauss_image (_layer + 2, _buf_index, _is_uv);
+        const CLImageDesc &gauss2_desc = image_gauss2->get_image_desc ();
+
+        bind_mem_arg (8, image_lap1);
+        bind_mem_arg (9, image_gauss2);
+        bind_arg<int> (10, (int)gauss2_desc.width);
+        bind_arg<int> (11, (int)gauss2_desc.height);
+    } else {
+        bind_mem_arg (8, image_gauss1);
+    }
+
+    // one 8x8 work-group per tile
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 8;
+    work_size.global[0] = XCAM_ALIGN_UP (lap_desc.width, PYRAMID_SLM_TILE_TX) / PYRAMID_SLM_TILE_TX * work_size.local[0];
+    work_size.global[1] = XCAM_ALIGN_UP (lap_desc.height, PYRAMID_SLM_TILE_H) / PYRAMID_SLM_TILE_H * work_size.local[1];
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+CLPyramidLapReconstructKernel::CLPyramidLapReconstructKernel (
+    const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender,
+    uint32_t layer, bool is_uv, bool two_levels)
+    : CLImageKernel (context)
+    , _blender (blender)
+    , _layer (layer)
+    , _is_uv (is_uv)
+    , _two_levels (two_levels)
+{
+    XCAM_ASSERT (layer + (two_levels ? 2 : 1) < XCAM_CL_PYRAMID_MAX_LEVEL);
+
+    declare_arg_slots (two_levels ? 10 : 7);
+}
+
+XCamReturn
+CLPyramidLapReconstructKernel::bind_arguments (CLWorkSize &work_size)
+{
+    SmartPtr<CLImage> image_in = _blender->get_reconstruct_image (_layer + (_two_levels ? 2 : 1), _is_uv);
+    SmartPtr<CLImage> image_lap = _blender->get_blend_image (_layer, _is_uv);
+    SmartPtr<CLImage> image_out = _blender->get_reconstruct_image (_layer, _is_uv);
+    // out_desc should be same as image_lap
+    const CLImageDesc &out_desc = image_lap->get_image_desc ();
+
+    int out_offset_x = 0;
+    if (_layer == 0 && _blender->get_scale_mode () != CLBlenderScaleLocal) {
+        const Rect &window = _blender->get_merge_window ();
+        XCAM_ASSERT (window.pos_x % XCAM_CL_BLENDER_ALIGNMENT_X == 0);
+        out_offset_x = window.pos_x / 8;
+    }
+
+    uint32_t slot = 0;
+    bind_mem_arg (slot++, image_in);
+    if (_two_levels) {
+        SmartPtr<CLImage> image_lap1 = _blender->get_blend_image (_layer + 1, _is_uv);
+        const CLImageDesc &lap1_desc = image_lap1->get_image_desc ();
+
+        bind_mem_arg (slot++, image_lap1);
+        bind_arg<int> (slot++, (int)lap1_desc.width);
+        bind_arg<int> (slot++, (int)lap1_desc.height);
+    }
+    bind_mem_arg (slot++, image_lap);
+    bind_mem_arg (slot++, image_out);
+    bind_arg<int> (slot++, out_offset_x);
+    bind_arg<int> (slot++, (int)out_desc.width);
+    bind_arg<int> (slot++, (int)out_desc.height);
+    XCAM_ASSERT (slot == get_arg_slot_count ());
+
+    work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+    work_size.local[0] = 8;
+    work_size.local[1] = 8;
+    work_size.global[0] = XCAM_ALIGN_UP (out_desc.width, PYRAMID_SLM_TILE_TX) / PYRAMID_SLM_TILE_TX * work_size.local[0];
+    work_size.global[1] = XCAM_ALIGN_UP (out_desc.height, PYRAMID_SLM_TILE_H) / PYRAMID_SLM_TILE_H * work_size.local[1];
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 CLBlenderLocalScaleKernel::CLBlenderLocalScaleKernel (
     const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender, bool is_uv)
     : CLBlenderScaleKernel (context, is_uv)
@@ -1533,10 +1856,11 @@ CLPyramidCopyKernel::CLPyramidCopyKernel (
     , _is_uv (is_uv)
     , _buf_index (buf_index)
 {
+    declare_arg_slots (6);
 }
 
 XCamReturn
-CLPyramidCopyKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
+CLPyramidCopyKernel::bind_arguments (CLWorkSize &work_size)
 {
     SmartPtr<CLContext> context = get_context ();
 
@@ -1567,12 +1891,12 @@ CLPyramidCopyKernel::prepare_arguments (CLArgList &args, CLWorkSize &work_size)
     printf ("copy(%d), in_offset_x:%d, out_offset_x:%d, max_x:%d\n", _buf_index, in_offset_x, out_offset_x, max_g_x);
 #endif
 
-    args.push_back (new CLMemArgument (from));
-    args.push_back (new CLArgumentT<int> (in_offset_x));
-    args.push_back (new CLMemArgument (to));
-    args.push_back (new CLArgumentT<int> (out_offset_x));
-    args.push_back (new CLArgumentT<int> (max_g_x));
-    args.push_back (new CLArgumentT<int> (max_g_y));
+    bind_mem_arg (0, from);
+    bind_arg<int> (1, in_offset_x);
+    bind_mem_arg (2, to);
+    bind_arg<int> (3, out_offset_x);
+    bind_arg<int> (4, max_g_x);
+    bind_arg<int> (5, max_g_y);
 
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
     work_size.local[0] = 16;
@@ -1648,6 +1972,48 @@ create_pyramid_reconstruct_kernel (
     return kernel;
 }
 
+static SmartPtr<CLImageKernel>
+create_pyramid_gauss_lap_kernel (
+    const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender,
+    uint32_t layer, uint32_t buf_index, bool is_uv, bool two_levels)
+{
+    char transform_option[1024];
+    snprintf (
+        transform_option, sizeof(transform_option),
+        "-DPYRAMID_UV=%d -DFUSE_TWO_LEVELS=%d", (is_uv ? 1 : 0), (two_levels ? 1 : 0));
+
+    SmartPtr<CLImageKernel> kernel;
+    kernel = new CLPyramidGaussLapKernel (context, blender, layer, buf_index, is_uv, two_levels);
+    XCAM_ASSERT (kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        kernel->build_kernel (kernels_info[KernelPyramidGaussLapSLM], transform_option) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "load pyramid gauss lap slm kernel(%s) failed", (is_uv ? "UV" : "Y"));
+    return kernel;
+}
+
+static SmartPtr<CLImageKernel>
+create_pyramid_lap_reconstruct_kernel (
+    const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender,
+    uint32_t layer, bool is_uv, bool two_levels)
+{
+    char transform_option[1024];
+    snprintf (
+        transform_option, sizeof(transform_option),
+        "-DPYRAMID_UV=%d -DFUSE_TWO_LEVELS=%d", (is_uv ? 1 : 0), (two_levels ? 1 : 0));
+
+    SmartPtr<CLImageKernel> kernel;
+    kernel = new CLPyramidLapReconstructKernel (context, blender, layer, is_uv, two_levels);
+    XCAM_ASSERT (kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING,
+        kernel->build_kernel (kernels_info[KernelPyramidReconstructSLM], transform_option) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "load pyramid lap reconstruct slm kernel(%s) failed", (is_uv ? "UV" : "Y"));
+    return kernel;
+}
+
 static SmartPtr<CLImageKernel>
 create_pyramid_blend_kernel (
     const SmartPtr<CLContext> &context,
@@ -1696,6 +2062,26 @@ create_pyramid_blender_local_scale_kernel (
     return kernel;
 }
 
+static SmartPtr<CLImageKernel>
+create_pyramid_reconstruct_scale_kernel (
+    const SmartPtr<CLContext> &context,
+    SmartPtr<CLPyramidBlender> &blender,
+    bool is_uv)
+{
+    char transform_option[1024];
+    snprintf (transform_option, sizeof(transform_option), "-DPYRAMID_UV=%d", is_uv ? 1 : 0);
+
+    SmartPtr<CLImageKernel> kernel;
+    kernel = new CLPyramidReconstructScaleKernel (context, blender, is_uv);
+    XCAM_ASSERT (kernel.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR,
+        kernel->build_kernel (kernels_info[KernelPyramidReconstructScale], transform_option) == XCAM_RETURN_NO_ERROR,
+        NULL,
+        "load pyramid reconstruct scaling kernel(%s) failed", is_uv ? "UV" : "Y");
+    return kernel;
+}
+
 static SmartPtr<CLImageKernel>
 create_pyramid_copy_kernel (
     const SmartPtr<CLContext> &context,
@@ -1781,6 +2167,8 @@ create_pyramid_blender (
     uint32_t buf_index = 0;
     int max_plane = (need_uv ? 2 : 1);
     bool uv_status[2] = {false, true};
+    bool fusion = (CL_PYRAMID_ENABLE_FUSION && !CL_PYRAMID_ENABLE_DUMP);
+    int rec_lowest = 0;
 
     XCAM_FAIL_RETURN (
         ERROR,
@@ -1791,6 +2179,9 @@ create_pyramid_blender (
 
     blender = new CLPyramidBlender (context, "cl_pyramid_blender", layer, need_uv, need_seam, scale_mode);
     XCAM_ASSERT (blender.ptr ());
+    // level 0 is reconstructed and scaled by one kernel
+    if (blender->is_scale_folded ())
+        rec_lowest = 1;
 
     if (need_seam) {
         kernel = create_seam_diff_kernel (context, blender);
@@ -1812,7 +2203,21 @@ create_pyramid_blender (
 
     for (int plane = 0; plane < max_plane; ++plane) {
         for (buf_index = 0; buf_index < XCAM_BLENDER_IMAGE_NUM; ++buf_index) {
-            for (i = 0; i < layer - 1; ++i) {
+            for (i = 0; i < layer - 1; ) {
+                if (fusion) {
+                    // levels in pairs from level 0, the last odd one alone
+                    bool two_levels = (i + 2 < layer);
+                    kernel = create_pyramid_gauss_lap_kernel (
+                        context, blender, (uint32_t)i, buf_index, uv_status[plane], two_levels);
+                    if (kernel.ptr ()) {
+                        blender->add_kernel (kernel);
+                        i += (two_levels ? 2 : 1);
+                        continue;
+                    }
+                    XCAM_LOG_WARNING ("pyramid blender fall back to non-fused kernels");
+                    fusion = false;
+                }
+
                 kernel = create_pyramid_transform_kernel (context, blender, (uint32_t)i, buf_index, uv_status[plane]);
                 XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "create pyramid transform kernel failed");
                 blender->add_kernel (kernel);
@@ -1820,6 +2225,7 @@ create_pyramid_blender (
                 kernel = create_pyramid_lap_kernel (context, blender, (uint32_t)i, buf_index, uv_status[plane]);
                 XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "create pyramid lap transform kernel failed");
                 blender->add_kernel (kernel);
+                ++i;
             }
         }
 
@@ -1829,13 +2235,33 @@ create_pyramid_blender (
             blender->add_kernel (kernel);
         }
 
-        for (i = layer - 2; i >= 0 && i < layer; --i) {
+        for (i = layer - 2; i >= rec_lowest && i < layer; ) {
+            if (fusion) {
+                // the top odd level alone, then levels in pairs down to the lowest level
+                bool two_levels = (i > rec_lowest && ((i - rec_lowest) % 2) == 1);
+                int level = (two_levels ? i - 1 : i);
+                kernel = create_pyramid_lap_reconstruct_kernel (
+                    context, blender, (uint32_t)level, uv_status[plane], two_levels);
+                if (kernel.ptr ()) {
+                    blender->add_kernel (kernel);
+                    i = level - 1;
+                    continue;
+                }
+                XCAM_LOG_WARNING ("pyramid blender fall back to non-fused reconstruct kernels");
+                fusion = false;
+            }
+
             kernel = create_pyramid_reconstruct_kernel (context, blender, (uint32_t)i, uv_status[plane]);
             XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "create pyramid reconstruct kernel failed");
             blender->add_kernel (kernel);
+            --i;
         }
 
-        if (scale_mode == CLBlenderScaleLocal) {
+        if (rec_lowest > 0) {
+            kernel = create_pyramid_reconstruct_scale_kernel (context, blender, uv_status[plane]);
+            XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "create pyramid reconstruct scaling kernel failed");
+            blender->add_kernel (kernel);
+        } else if (scale_mode == CLBlenderScaleLocal) {
             kernel = create_pyramid_blender_local_scale_kernel (context, blender, uv_status[plane]);
             XCAM_FAIL_RETURN (ERROR, kernel.ptr (), NULL, "create pyramid blender local scaling kernel failed");
             blender->add_kernel (kernel);
@@ -23,11 +23,22 @@
 
 #include <xcam_std.h>
 #include <ocl/cl_blender.h>
+#include <vector>
 
 #define CL_PYRAMID_ENABLE_DUMP 0
 
+// transform, lap and reconstruct kernels of two levels fused in one launch with SLM tiles
+#define CL_PYRAMID_ENABLE_FUSION 1
+
 #define XCAM_CL_PYRAMID_MAX_LEVEL  4
 
+// frames between two full range seam searches, 0 means only on cost change
+#define XCAM_CL_SEAM_UPDATE_INTERVAL 30
+// columns searched on each side of last seam in the frames between
+#define XCAM_CL_SEAM_BAND_RADIUS 16
+// relative rise of seam cost forcing a full range search in next frame
+#define XCAM_CL_SEAM_COST_CHANGE 0.5f
+
 namespace XCam {
 
 class CLPyramidBlender;
@@ -67,7 +78,8 @@ struct PyramidLayer {
     void bind_buf_to_layer0 (
         SmartPtr<CLContext> context,
         SmartPtr<VideoBuffer> &input0, SmartPtr<VideoBuffer> &input1, SmartPtr<VideoBuffer> &output,
-        const Rect &merge0_rect, const Rect &merge1_rect, bool need_uv, CLBlenderScaleMode scale_mode);
+        const Rect &merge0_rect, const Rect &merge1_rect, bool need_uv, CLBlenderScaleMode scale_mode,
+        bool scale_folded);
     void init_layer0 (SmartPtr<CLContext> context, bool last_layer, bool need_uv, int mask_radius, float mask_sigma);
     void build_cl_images (SmartPtr<CLContext> context, bool need_lap, bool need_uv);
     bool copy_mask_from_y_to_uv (SmartPtr<CLContext> &context);
@@ -94,6 +106,8 @@ public:
     SmartPtr<CLImage> get_blend_image (uint32_t layer, bool is_uv);
     SmartPtr<CLImage> get_reconstruct_image (uint32_t layer, bool is_uv);
     SmartPtr<CLImage> get_scale_image (bool is_uv);
+    // local scale is done by reconstruct of level 0, no reconstruct image of level 0
+    bool is_scale_folded () const;
     SmartPtr<CLBuffer> get_blend_mask (uint32_t layer, bool is_uv);
     SmartPtr<CLImage> get_seam_mask (uint32_t layer);
     const PyramidLayer &get_pyramid_layer (uint32_t layer) const;
@@ -106,6 +120,19 @@ public:
     SmartPtr<CLBuffer> &get_seam_sum_buf () {
         return _seam_sum_buf;
     }
+    SmartPtr<CLBuffer> &get_seam_band_buf () {
+        return _seam_band_buf;
+    }
+    uint32_t get_seam_band_width () const {
+        return _seam_band_width;
+    }
+    /*
+     * seam is searched in full range every @interval frames or once its cost rises
+     * by @cost_change, other frames only search @band_radius columns around last seam.
+     */
+    void set_seam_update (uint32_t interval, uint32_t band_radius, float cost_change);
+    // once per frame before seam DP, uploads search band of each row
+    XCamReturn prepare_seam_band ();
     uint32_t get_layers () const {
         return _layers;
     }
@@ -142,6 +169,18 @@ private:
     SmartPtr<CLBuffer>               _seam_pos_buf; // width = _seam_width; height = _seam_height;
     SmartPtr<CLBuffer>               _seam_sum_buf; // size = _seam_width
     bool                             _seam_mask_done;
+
+    SmartPtr<CLBuffer>               _seam_band_buf; // band start of each row
+    std::vector<int32_t>             _seam_band;
+    std::vector<int32_t>             _seam_path; // seam position of each row in last frame
+    uint32_t                         _seam_band_width;
+    uint32_t                         _seam_update_interval;
+    uint32_t                         _seam_band_radius;
+    float                            _seam_cost_change;
+    uint32_t                         _seam_frame_count;
+    float                            _seam_ref_cost;
+    bool                             _seam_full_search;
+    bool                             _seam_need_full;
     //SmartPtr<CLImage>                _seam_mask;
 };
 
@@ -154,7 +193,7 @@ public:
         uint32_t layer, bool is_uv, bool need_seam);
 
 protected:
-    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
+    virtual XCamReturn bind_arguments (CLWorkSize &work_size);
 private:
     SmartPtr<CLImage> get_input_0 () {
         return _blender->get_lap_image (_layer, 0, _is_uv);
@@ -330,6 +369,71 @@ private:
     bool                               _is_uv;
 };
 
+/*
+ * CLPyramidReconstructScaleKernel, reconstruct of level 0 sampled at scaled positions,
+ * writes merge window of output, takes place of CLBlenderLocalScaleKernel.
+ */
+class CLPyramidReconstructScaleKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLPyramidReconstructScaleKernel (
+        const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender, bool is_uv);
+
+protected:
+    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
+
+private:
+    XCAM_DEAD_COPY (CLPyramidReconstructScaleKernel);
+
+private:
+    SmartPtr<CLPyramidBlender>         _blender;
+    bool                               _is_uv;
+};
+
+class CLPyramidGaussLapKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLPyramidGaussLapKernel (
+        const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender,
+        uint32_t layer, uint32_t buf_index, bool is_uv, bool two_levels);
+
+protected:
+    virtual XCamReturn bind_arguments (CLWorkSize &work_size);
+
+private:
+    XCAM_DEAD_COPY (CLPyramidGaussLapKernel);
+
+private:
+    SmartPtr<CLPyramidBlender>         _blender;
+    uint32_t                           _layer;
+    uint32_t                           _buf_index;
+    bool                               _is_uv;
+    bool                               _two_levels;
+};
+
+class CLPyramidLapReconstructKernel
+    : public CLImageKernel
+{
+public:
+    explicit CLPyramidLapReconstructKernel (
+        const SmartPtr<CLContext> &context, SmartPtr<CLPyramidBlender> &blender,
+        uint32_t layer, bool is_uv, bool two_levels);
+
+protected:
+    virtual XCamReturn bind_arguments (CLWorkSize &work_size);
+
+private:
+    XCAM_DEAD_COPY (CLPyramidLapReconstructKernel);
+
+private:
+    SmartPtr<CLPyramidBlender>         _blender;
+    uint32_t                           _layer;
+    bool                               _is_uv;
+    bool                               _two_levels;
+};
+
 class CLBlenderLocalScaleKernel
     : public CLBlenderScaleKernel
 {
@@ -360,7 +464,7 @@ public:
         uint32_t buf_index, bool is_uv);
 
 protected:
-    virtual XCamReturn prepare_arguments (CLArgList &args, CLWorkSize &work_size);
+    virtual XCamReturn bind_arguments (CLWorkSize &work_size);
 
 private:
     SmartPtr<CLImage>  get_input () {
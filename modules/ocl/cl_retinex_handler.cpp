@@ -30,10 +30,11 @@ static uint32_t retinex_gauss_scale [3] = {2, 8, 20}; //{20, 60, 150};
 static float retinex_gauss_sigma [3] = {2.0f, 8.0f, 20.0f}; //{12.0f, 40.0f, 120.0f};
 static float retinex_config_log_min = -0.12f; // -0.18f
 static float retinex_config_log_max = 0.18f;  //0.2f
+// pyramid levels closest to gauss scales of the half resolution path
+static uint32_t retinex_pyramid_level [3] = {3, 5, 6};
 
 enum {
     KernelScaler = 0,
-    KernelGaussian,
     KernelRetinex,
 };
 
@@ -43,11 +44,6 @@ const static XCamKernelInfo kernel_retinex_info [] = {
 #include "kernel_image_scaler.clx"
         , 0,
     },
-    {
-        "kernel_gauss",
-#include "kernel_gauss.clx"
-        , 0,
-    },
     {
         "kernel_retinex",
 #include "kernel_retinex.clx"
@@ -150,7 +146,19 @@ CLRetinexImageKernel::prepare_arguments (
         XCAM_RETURN_ERROR_MEM,
         "cl image kernel(%s) in/out memory not available", get_kernel_name ());
 
-    for (uint32_t i = 0; i < XCAM_RETINEX_MAX_SCALE; ++i) {
+    SmartPtr<CLGaussPyramid> &pyramid = _retinex->get_gauss_pyramid ();
+    for (uint32_t i = 0; i < XCAM_RETINEX_MAX_SCALE && pyramid.ptr (); ++i) {
+        SmartPtr<CLEvent> level_event;
+        XCamReturn ret = pyramid->get_level (
+            input, retinex_pyramid_level[i], image_in_ga[i],
+            _retinex->get_done_events (), level_event, _retinex->get_cmd_queue ());
+        XCAM_FAIL_RETURN (
+            WARNING, xcam_ret_is_ok (ret), ret,
+            "cl image kernel(%s) get gauss pyramid level(%d) failed", get_kernel_name (), retinex_pyramid_level[i]);
+        _retinex->add_chain_event (level_event);
+    }
+
+    for (uint32_t i = 0; i < XCAM_RETINEX_MAX_SCALE && !pyramid.ptr (); ++i) {
         SmartPtr<VideoBuffer> gaussian_buf = _retinex->get_gaussian_buf (i);
         XCAM_ASSERT (gaussian_buf.ptr ());
 
@@ -195,8 +203,10 @@ CLRetinexImageKernel::prepare_arguments (
     return XCAM_RETURN_NO_ERROR;
 }
 
-CLRetinexImageHandler::CLRetinexImageHandler (const SmartPtr<CLContext> &context, const char *name)
+CLRetinexImageHandler::CLRetinexImageHandler (
+    const SmartPtr<CLContext> &context, const char *name, CLPrecision precision)
     : CLImageHandler (context, name)
+    , _precision (precision)
     , _scaler_factor(XCAM_RETINEX_SCALER_FACTOR)
 {
 }
@@ -226,7 +236,7 @@ CLRetinexImageHandler::prepare_output_buf (SmartPtr<VideoBuffer> &input, SmartPt
 XCamReturn
 CLRetinexImageHandler::prepare_scaler_buf (const VideoBufferInfo &video_info)
 {
-    if (!_scaler_buf_pool.ptr ()) {
+    if (!_scaler_buf_pool.ptr () && !_gauss_pyramid.ptr ()) {
         SmartPtr<CLContext> context = get_context ();
         VideoBufferInfo scaler_video_info;
         uint32_t new_width = XCAM_ALIGN_UP ((uint32_t)(video_info.width * _scaler_factor), 8);
@@ -270,6 +280,32 @@ CLRetinexImageHandler::set_retinex_scaler_kernel(SmartPtr<CLRetinexScalerImageKe
     return true;
 }
 
+bool
+CLRetinexImageHandler::set_retinex_gauss_kernel (uint32_t index, SmartPtr<CLGaussImageKernel> &kernel)
+{
+    XCAM_ASSERT (index < XCAM_RETINEX_MAX_SCALE);
+    SmartPtr<CLImageKernel> image_kernel = kernel;
+    add_kernel (image_kernel);
+    add_kernel (kernel->get_vertical_kernel ());
+    _retinex_gauss_kernels[index] = kernel;
+    return true;
+}
+
+bool
+CLRetinexImageHandler::set_gauss_pyramid (const SmartPtr<CLGaussPyramid> &pyramid)
+{
+    bool own_gauss = !pyramid.ptr ();
+
+    _gauss_pyramid = pyramid;
+    if (_retinex_scaler_kernel.ptr ())
+        _retinex_scaler_kernel->set_enable (own_gauss);
+    for (uint32_t i = 0; i < XCAM_RETINEX_MAX_SCALE; ++i) {
+        if (_retinex_gauss_kernels[i].ptr ())
+            _retinex_gauss_kernels[i]->set_gauss_enable (own_gauss);
+    }
+    return true;
+}
+
 static SmartPtr<CLRetinexScalerImageKernel>
 create_kernel_retinex_scaler (
     const SmartPtr<CLContext> &context, SmartPtr<CLRetinexImageHandler> handler)
@@ -294,16 +330,12 @@ create_kernel_retinex_gaussian (
     uint32_t radius, float sigma)
 {
     SmartPtr<CLRetinexGaussImageKernel> kernel;
-    char build_options[1024];
-
-    xcam_mem_clear (build_options);
-    snprintf (build_options, sizeof (build_options), " -DGAUSS_RADIUS=%d ", radius);
 
     kernel = new CLRetinexGaussImageKernel (context, handler, index, radius, sigma);
     XCAM_ASSERT (kernel.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, kernel->build_kernel (kernel_retinex_info[KernelGaussian], build_options) == XCAM_RETURN_NO_ERROR, NULL,
-        "build retinex gaussian kernel(%s) failed", kernel_retinex_info[KernelGaussian].kernel_name);
+        ERROR, kernel->build_gauss_kernels () == XCAM_RETURN_NO_ERROR, NULL,
+        "build retinex gaussian kernels of radius(%d) failed", radius);
 
     XCAM_ASSERT (kernel->is_valid ());
 
@@ -322,7 +354,8 @@ create_kernel_retinex (const SmartPtr<CLContext> &context, SmartPtr<CLRetinexIma
     kernel = new CLRetinexImageKernel (context, handler);
     XCAM_ASSERT (kernel.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, kernel->build_kernel (kernel_retinex_info[KernelRetinex], build_options) == XCAM_RETURN_NO_ERROR, NULL,
+        ERROR, kernel->build_kernel (
+            kernel_retinex_info[KernelRetinex], build_options, handler->get_precision ()) == XCAM_RETURN_NO_ERROR, NULL,
         "build retinex kernel(%s) failed", kernel_retinex_info[KernelRetinex].kernel_name);
 
     XCAM_ASSERT (kernel->is_valid ());
@@ -330,14 +363,14 @@ create_kernel_retinex (const SmartPtr<CLContext> &context, SmartPtr<CLRetinexIma
 }
 
 SmartPtr<CLImageHandler>
-create_cl_retinex_image_handler (const SmartPtr<CLContext> &context)
+create_cl_retinex_image_handler (const SmartPtr<CLContext> &context, CLPrecision precision)
 {
     SmartPtr<CLRetinexImageHandler> retinex_handler;
 
     SmartPtr<CLRetinexScalerImageKernel> retinex_scaler_kernel;
     SmartPtr<CLRetinexImageKernel> retinex_kernel;
 
-    retinex_handler = new CLRetinexImageHandler (context, "cl_handler_retinex");
+    retinex_handler = new CLRetinexImageHandler (context, "cl_handler_retinex", precision);
     retinex_scaler_kernel = create_kernel_retinex_scaler (context, retinex_handler);
     XCAM_FAIL_RETURN (
         ERROR,
@@ -347,7 +380,7 @@ create_cl_retinex_image_handler (const SmartPtr<CLContext> &context)
     retinex_handler->set_retinex_scaler_kernel (retinex_scaler_kernel);
 
     for (uint32_t i = 0; i < XCAM_RETINEX_MAX_SCALE; ++i) {
-        SmartPtr<CLImageKernel> retinex_gauss_kernel;
+        SmartPtr<CLGaussImageKernel> retinex_gauss_kernel;
         retinex_gauss_kernel = create_kernel_retinex_gaussian (
                                    context, retinex_handler, i, retinex_gauss_scale [i], retinex_gauss_sigma [i]);
         XCAM_FAIL_RETURN (
@@ -355,7 +388,7 @@ create_cl_retinex_image_handler (const SmartPtr<CLContext> &context)
             retinex_gauss_kernel.ptr () && retinex_gauss_kernel->is_valid (),
             NULL,
             "Retinex handler create gaussian kernel failed");
-        retinex_handler->add_kernel (retinex_gauss_kernel);
+        retinex_handler->set_retinex_gauss_kernel (i, retinex_gauss_kernel);
     }
 
     retinex_kernel = create_kernel_retinex (context, retinex_handler);
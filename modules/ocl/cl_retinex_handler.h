@@ -27,6 +27,7 @@
 #include <x3a_stats_pool.h>
 #include <ocl/cl_image_scaler.h>
 #include <ocl/cl_gauss_handler.h>
+#include <ocl/cl_gauss_pyramid.h>
 
 #define XCAM_RETINEX_MAX_SCALE 2
 #define XCAM_RETINEX_SCALER_FACTOR 0.5
@@ -100,9 +101,11 @@ class CLRetinexImageHandler
     : public CLImageHandler
 {
 public:
-    explicit CLRetinexImageHandler (const SmartPtr<CLContext> &context, const char *name);
+    explicit CLRetinexImageHandler (
+        const SmartPtr<CLContext> &context, const char *name, CLPrecision precision = CLPrecisionFloat);
     bool set_retinex_kernel(SmartPtr<CLRetinexImageKernel> &kernel);
     bool set_retinex_scaler_kernel(SmartPtr<CLRetinexScalerImageKernel> &kernel);
+    bool set_retinex_gauss_kernel (uint32_t index, SmartPtr<CLGaussImageKernel> &kernel);
     //bool set_retinex_gauss_kernel(SmartPtr<CLRetinexGaussImageKernel> &kernel);
     SmartPtr<VideoBuffer> &get_scaler_buf1 () {
         return _scaler_buf1;
@@ -111,6 +114,15 @@ public:
         XCAM_ASSERT (index < XCAM_RETINEX_MAX_SCALE);
         return _gaussian_buf[index];
     };
+    CLPrecision get_precision () const {
+        return _precision;
+    }
+
+    // gauss images come from shared pyramid levels instead of own scaler and gauss kernels
+    bool set_gauss_pyramid (const SmartPtr<CLGaussPyramid> &pyramid);
+    SmartPtr<CLGaussPyramid> &get_gauss_pyramid () {
+        return _gauss_pyramid;
+    }
 
     virtual void emit_stop ();
 
@@ -124,7 +136,10 @@ private:
     SmartPtr<CLRetinexImageKernel>        _retinex_kernel;
     SmartPtr<CLRetinexScalerImageKernel>  _retinex_scaler_kernel;
     //SmartPtr<CLRetinexGaussImageKernel>   _retinex_gauss_kernel;
+    SmartPtr<CLGaussImageKernel>          _retinex_gauss_kernels[XCAM_RETINEX_MAX_SCALE];
+    SmartPtr<CLGaussPyramid>              _gauss_pyramid;
 
+    CLPrecision                           _precision;
     double                                _scaler_factor;
     SmartPtr<BufferPool>                  _scaler_buf_pool;
     SmartPtr<VideoBuffer>                 _scaler_buf1;
@@ -133,7 +148,8 @@ private:
 };
 
 SmartPtr<CLImageHandler>
-create_cl_retinex_image_handler (const SmartPtr<CLContext> &context);
+create_cl_retinex_image_handler (
+    const SmartPtr<CLContext> &context, CLPrecision precision = CLPrecisionFloat);
 
 };
 
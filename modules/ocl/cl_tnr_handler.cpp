@@ -23,11 +23,19 @@
 #define TNR_PROCESSING_FRAME_COUNT  4
 #define TNR_LIST_FRAME_COUNT        4
 #define TNR_MOTION_THRESHOLD        2
+// keep in sync with kernel_tnr.cl
+#define TNR_MOTION_TILE_SIZE        32
 
 namespace XCam {
 
 static const XCamKernelInfo kernel_tnr_yuv_info = {
-    "kernel_tnr_yuv",
+    "kernel_tnr_yuv_tiled",
+#include "kernel_tnr.clx"
+    , 0
+};
+
+static const XCamKernelInfo kernel_tnr_motion_info = {
+    "kernel_tnr_yuv_motion",
 #include "kernel_tnr.clx"
     , 0
 };
@@ -281,6 +289,18 @@ CLTnrImageHandler::set_tnr_kernel(SmartPtr<CLTnrImageKernel> &kernel)
     return true;
 }
 
+bool
+CLTnrImageHandler::set_motion_kernel (SmartPtr<CLImageKernel> &kernel)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_tnr_kernel.ptr (), false,
+        "tnr handler set motion kernel failed, it runs before tnr kernel and must be set first");
+
+    add_kernel (kernel);
+    _motion_kernel = kernel;
+    return true;
+}
+
 bool
 CLTnrImageHandler::set_framecount (uint8_t count)
 {
@@ -390,6 +410,40 @@ CLTnrImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vi
     }
 
     uint32_t vertical_offset = video_info.aligned_height;
+    uint32_t tiles_x = xcam_ceil (video_info.width, TNR_MOTION_TILE_SIZE) / TNR_MOTION_TILE_SIZE;
+    uint32_t tiles_y = xcam_ceil (video_info.height, TNR_MOTION_TILE_SIZE) / TNR_MOTION_TILE_SIZE;
+
+    if (CL_TNR_TYPE_YUV == _type) {
+        XCAM_ASSERT (_motion_kernel.ptr ());
+        if (!_motion_mask.ptr () || _motion_mask->get_buf_size () != tiles_x * tiles_y) {
+            _motion_mask = new CLBuffer (context, tiles_x * tiles_y);
+            XCAM_FAIL_RETURN (
+                WARNING, _motion_mask->is_valid (), XCAM_RETURN_ERROR_MEM,
+                "tnr handler create motion mask(%dx%d) failed", tiles_x, tiles_y);
+        }
+
+        // motion of each tile against previous output, moving tiles skip tnr
+        CLArgList motion_args;
+        CLWorkSize motion_size;
+        motion_args.push_back (new CLMemArgument (image_in));
+        motion_args.push_back (new CLMemArgument (_image_out_prev));
+        motion_args.push_back (new CLMemArgument (_motion_mask));
+        motion_args.push_back (new CLArgumentT<uint> (vertical_offset));
+        motion_args.push_back (new CLArgumentT<uint> (tiles_x));
+        motion_args.push_back (new CLArgumentT<uint> (tiles_y));
+        motion_args.push_back (new CLArgumentT<float> (_thr_y));
+
+        motion_size.dim = XCAM_DEFAULT_IMAGE_DIM;
+        motion_size.local[0] = 8;
+        motion_size.local[1] = 4;
+        motion_size.global[0] = XCAM_ALIGN_UP (tiles_x, motion_size.local[0]);
+        motion_size.global[1] = XCAM_ALIGN_UP (tiles_y, motion_size.local[1]);
+
+        ret = _motion_kernel->set_arguments (motion_args, motion_size);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "tnr motion kernel set arguments failed.");
+    }
 
     //set args;
     work_size.dim = XCAM_DEFAULT_IMAGE_DIM;
@@ -404,6 +458,8 @@ CLTnrImageHandler::prepare_parameters (SmartPtr<VideoBuffer> &input, SmartPtr<Vi
         args.push_back (new CLArgumentT<float> (_gain_yuv));
         args.push_back (new CLArgumentT<float> (_thr_y));
         args.push_back (new CLArgumentT<float> (_thr_uv));
+        args.push_back (new CLMemArgument (_motion_mask));
+        args.push_back (new CLArgumentT<uint> (tiles_x));
 
         work_size.global[0] = video_info.width / 2;
         work_size.global[1] = video_info.height / 2;
@@ -458,6 +514,15 @@ create_cl_tnr_image_handler (const SmartPtr<CLContext> &context, CLTnrType type)
         "build tnr kernel failed");
 
     tnr_handler = new CLTnrImageHandler (context, type, "cl_handler_tnr");
+    if (CL_TNR_TYPE_YUV == type) {
+        SmartPtr<CLImageKernel> motion_kernel = new CLImageKernel (context, "kernel_tnr_yuv_motion");
+        XCAM_ASSERT (motion_kernel.ptr ());
+        XCAM_FAIL_RETURN (
+            ERROR, motion_kernel->build_kernel (kernel_tnr_motion_info, NULL) == XCAM_RETURN_NO_ERROR, NULL,
+            "build tnr motion kernel failed");
+        tnr_handler->set_motion_kernel (motion_kernel);
+    }
+
     XCAM_ASSERT (tnr_kernel->is_valid ());
     tnr_handler->set_tnr_kernel (tnr_kernel);
 
@@ -96,6 +96,8 @@ private:
 public:
     explicit CLTnrImageHandler (const SmartPtr<CLContext> &context, CLTnrType type, const char *name);
     bool set_tnr_kernel (SmartPtr<CLTnrImageKernel> &kernel);
+    // yuv only, per-tile motion mask of quarter scale luma SAD, set before tnr kernel
+    bool set_motion_kernel (SmartPtr<CLImageKernel> &kernel);
     bool set_framecount (uint8_t count) ;
     bool set_rgb_config (const XCam3aResultTemporalNoiseReduction& config);
     bool set_yuv_config (const XCam3aResultTemporalNoiseReduction& config);
@@ -115,6 +117,8 @@ private:
 
 private:
     SmartPtr<CLTnrImageKernel>  _tnr_kernel;
+    SmartPtr<CLImageKernel>     _motion_kernel;
+    SmartPtr<CLBuffer>          _motion_mask;
     CLTnrType                   _type;
 
     float                       _gain_yuv;
@@ -21,6 +21,9 @@
 #include "cl_utils.h"
 #include "cl_tonemapping_handler.h"
 
+// bins of GPU histogram, curve math is the same as 3A stats of 8 bits
+#define XCAM_CL_TONEMAPPING_HIST_BINS 256
+
 namespace XCam {
 
 static const XCamKernelInfo kernel_tonemapping_info = {
@@ -35,6 +38,64 @@ CLTonemappingImageKernel::CLTonemappingImageKernel (
 {
 }
 
+/*
+ * @hist of 1 << bit_depth bins over @pixel_totalnum pixels,
+ * @y_max and @y_target are scaled to 8 bits for kernel
+ */
+static void
+calc_tonemapping_curve (
+    const uint32_t *hist, uint32_t bit_depth, int pixel_totalnum, float &y_max, float &y_target)
+{
+    int pixel_num = 0;
+    int hist_bin_count = 1 << bit_depth;
+    int64_t cumulative_value = 0;
+    int saturated_thresh = pixel_totalnum * 0.003f;
+    int percent_90_thresh = pixel_totalnum * 0.1f;
+    int medium_thresh = pixel_totalnum * 0.5f;
+    float y_saturated = 0;
+    float y_percent_90 = 0;
+    float y_average = 0;
+    float y_medium = 0;
+
+    for (int i = (hist_bin_count - 1); i >= 0; i--)
+    {
+        pixel_num += hist[i];
+        if ((y_saturated == 0) && (pixel_num >= saturated_thresh))
+        {
+            y_saturated = i;
+        }
+        if ((y_percent_90 == 0) && (pixel_num >= percent_90_thresh))
+        {
+            y_percent_90 = i;
+        }
+        if ((y_medium == 0) && (pixel_num >= medium_thresh))
+        {
+            y_medium = i;
+        }
+        cumulative_value += i * hist[i];
+    }
+
+    y_average = cumulative_value / XCAM_MAX (pixel_totalnum, 1);
+
+    if (y_saturated < (hist_bin_count - 1)) {
+        y_saturated = y_saturated + 1;
+    }
+
+    y_target =  (hist_bin_count / y_saturated) * (1.5 * y_medium + 0.5 * y_average) / 2;
+
+    if (y_target < 4) {
+        y_target = 4;
+    }
+    if ((y_target > y_saturated) || (y_saturated < 4)) {
+        y_target = y_saturated / 4;
+    }
+
+    y_max = hist_bin_count * (2 * y_saturated + y_target) / y_saturated - y_saturated - y_target;
+
+    y_target = y_target / pow(2, bit_depth - 8);
+    y_max = y_max / pow(2, bit_depth - 8);
+}
+
 CLTonemappingImageHandler::CLTonemappingImageHandler (
     const SmartPtr<CLContext> &context, const char *name)
     : CLImageHandler (context, name)
@@ -44,6 +105,26 @@ CLTonemappingImageHandler::CLTonemappingImageHandler (
     _wb_config.gr_gain = 1.0;
     _wb_config.gb_gain = 1.0;
     _wb_config.b_gain = 1.0;
+
+    // curve of a flat histogram until the first one is read back
+    std::vector<uint32_t> flat_hist (XCAM_CL_TONEMAPPING_HIST_BINS, 1);
+    calc_tonemapping_curve (&flat_hist[0], 8, XCAM_CL_TONEMAPPING_HIST_BINS, _y_max, _y_target);
+}
+
+bool
+CLTonemappingImageHandler::set_luma_histogram (const SmartPtr<CLLumaHistogram> &hist)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_tonemapping_kernel.ptr (), false,
+        "tonemapping handler luma histogram need be set before tonemapping kernel");
+    XCAM_FAIL_RETURN (
+        ERROR, hist.ptr () && hist->get_bins () == XCAM_CL_TONEMAPPING_HIST_BINS && hist->get_block_factor () == 1,
+        false, "tonemapping handler needs one luma histogram of %d bins", XCAM_CL_TONEMAPPING_HIST_BINS);
+
+    add_kernel (hist->get_clear_kernel ());
+    add_kernel (hist->get_count_kernel ());
+    _luma_hist = hist;
+    return true;
 }
 
 bool
@@ -82,15 +163,43 @@ CLTonemappingImageHandler::prepare_buffer_pool_video_info (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLTonemappingImageHandler::update_curve_from_stats (SmartPtr<VideoBuffer> &input)
+{
+    SmartPtr<X3aStats> stats;
+    SmartPtr<CLVideoBuffer> cl_buf = input.dynamic_cast_ptr<CLVideoBuffer> ();
+    if (cl_buf.ptr ()) {
+        stats = cl_buf->find_3a_stats ();
+    }
+#if HAVE_LIBDRM
+    else {
+        SmartPtr<DrmBoBuffer> bo_buf = input.dynamic_cast_ptr<DrmBoBuffer> ();
+        stats = bo_buf->find_3a_stats ();
+    }
+#endif
+    XCAM_FAIL_RETURN (
+        ERROR,
+        stats.ptr (),
+        XCAM_RETURN_ERROR_MEM,
+        "CLTonemappingImageKernel find_3a_stats failed");
+    XCam3AStats *stats_ptr = stats->get_stats ();
+    XCAM_ASSERT (stats_ptr);
+
+    int pixel_totalnum = stats_ptr->info.aligned_width * stats_ptr->info.aligned_height;
+    calc_tonemapping_curve (stats_ptr->hist_y, stats_ptr->info.bit_depth, pixel_totalnum, _y_max, _y_target);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 CLTonemappingImageHandler::prepare_parameters (
     SmartPtr<VideoBuffer> &input,
     SmartPtr<VideoBuffer> &output)
 {
     SmartPtr<CLContext> context = get_context ();
-    float y_max = 0.0f, y_target = 0.0f;
     CLArgList args;
     CLWorkSize work_size;
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
     XCAM_ASSERT (_tonemapping_kernel.ptr ());
 
     const VideoBufferInfo &video_info = input->get_video_info ();
@@ -114,80 +223,32 @@ CLTonemappingImageHandler::prepare_parameters (
         XCAM_RETURN_ERROR_MEM,
         "cl image handler(%s) in/out memory not available", XCAM_STR(get_name ()));
 
-    SmartPtr<X3aStats> stats;
-    SmartPtr<CLVideoBuffer> cl_buf = input.dynamic_cast_ptr<CLVideoBuffer> ();
-    if (cl_buf.ptr ()) {
-        stats = cl_buf->find_3a_stats ();
-    }
-#if HAVE_LIBDRM
-    else {
-        SmartPtr<DrmBoBuffer> bo_buf = input.dynamic_cast_ptr<DrmBoBuffer> ();
-        stats = bo_buf->find_3a_stats ();
-    }
-#endif
-    XCAM_FAIL_RETURN (
-        ERROR,
-        stats.ptr (),
-        XCAM_RETURN_ERROR_MEM,
-        "CLTonemappingImageKernel find_3a_stats failed");
-    XCam3AStats *stats_ptr = stats->get_stats ();
-    XCAM_ASSERT (stats_ptr);
-
-    int pixel_totalnum = stats_ptr->info.aligned_width * stats_ptr->info.aligned_height;
-    int pixel_num = 0;
-    int hist_bin_count = 1 << stats_ptr->info.bit_depth;
-    int64_t cumulative_value = 0;
-    int saturated_thresh = pixel_totalnum * 0.003f;
-    int percent_90_thresh = pixel_totalnum * 0.1f;
-    int medium_thresh = pixel_totalnum * 0.5f;
-    float y_saturated = 0;
-    float y_percent_90 = 0;
-    float y_average = 0;
-    float y_medium = 0;
-
-    for (int i = (hist_bin_count - 1); i >= 0; i--)
-    {
-        pixel_num += stats_ptr->hist_y[i];
-        if ((y_saturated == 0) && (pixel_num >= saturated_thresh))
-        {
-            y_saturated = i;
+    if (_luma_hist.ptr ()) {
+        // curve of the latest histogram read back, current frame is counted for a later one
+        const uint32_t *hist = _luma_hist->fetch ();
+        if (hist) {
+            int pixel_totalnum = 0;
+            for (uint32_t i = 0; i < XCAM_CL_TONEMAPPING_HIST_BINS; ++i)
+                pixel_totalnum += hist[i];
+            calc_tonemapping_curve (hist, 8, pixel_totalnum, _y_max, _y_target);
         }
-        if ((y_percent_90 == 0) && (pixel_num >= percent_90_thresh))
-        {
-            y_percent_90 = i;
-        }
-        if ((y_medium == 0) && (pixel_num >= medium_thresh))
-        {
-            y_medium = i;
-        }
-        cumulative_value += i * stats_ptr->hist_y[i];
-    }
-
-    y_average = cumulative_value / pixel_totalnum;
 
-    if (y_saturated < (hist_bin_count - 1)) {
-        y_saturated = y_saturated + 1;
+        ret = _luma_hist->prepare (image_in, video_info);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "tone mapping luma histogram prepare failed.");
+    } else {
+        ret = update_curve_from_stats (input);
+        XCAM_FAIL_RETURN (
+            WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
+            "tone mapping update curve from 3a stats failed.");
     }
 
-    y_target =  (hist_bin_count / y_saturated) * (1.5 * y_medium + 0.5 * y_average) / 2;
-
-    if (y_target < 4) {
-        y_target = 4;
-    }
-    if ((y_target > y_saturated) || (y_saturated < 4)) {
-        y_target = y_saturated / 4;
-    }
-
-    y_max = hist_bin_count * (2 * y_saturated + y_target) / y_saturated - y_saturated - y_target;
-
-    y_target = y_target / pow(2, stats_ptr->info.bit_depth - 8);
-    y_max = y_max / pow(2, stats_ptr->info.bit_depth - 8);
-
     //set args;
     args.push_back (new CLMemArgument (image_in));
     args.push_back (new CLMemArgument (image_out));
-    args.push_back (new CLArgumentT<float> (y_max));
-    args.push_back (new CLArgumentT<float> (y_target));
+    args.push_back (new CLArgumentT<float> (_y_max));
+    args.push_back (new CLArgumentT<float> (_y_target));
     args.push_back (new CLArgumentT<int> (image_height));
 
     const CLImageDesc out_info = image_out->get_image_desc ();
@@ -198,7 +259,7 @@ CLTonemappingImageHandler::prepare_parameters (
     work_size.local[1] = 8;
 
     XCAM_ASSERT (_tonemapping_kernel.ptr ());
-    XCamReturn ret = _tonemapping_kernel->set_arguments (args, work_size);
+    ret = _tonemapping_kernel->set_arguments (args, work_size);
     XCAM_FAIL_RETURN (
         WARNING, ret == XCAM_RETURN_NO_ERROR, ret,
         "tone mapping kernel set arguments failed.");
@@ -206,9 +267,19 @@ CLTonemappingImageHandler::prepare_parameters (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+CLTonemappingImageHandler::execute_done (SmartPtr<VideoBuffer> &output)
+{
+    XCAM_UNUSED (output);
+    if (_luma_hist.ptr ())
+        _luma_hist->read_back (get_done_events ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 
 SmartPtr<CLImageHandler>
-create_cl_tonemapping_image_handler (const SmartPtr<CLContext> &context)
+create_cl_tonemapping_image_handler (const SmartPtr<CLContext> &context, bool gpu_hist)
 {
     SmartPtr<CLTonemappingImageHandler> tonemapping_handler;
     SmartPtr<CLTonemappingImageKernel> tonemapping_kernel;
@@ -221,6 +292,14 @@ create_cl_tonemapping_image_handler (const SmartPtr<CLContext> &context)
 
     XCAM_ASSERT (tonemapping_kernel->is_valid ());
     tonemapping_handler = new CLTonemappingImageHandler(context, "cl_handler_tonemapping");
+
+    if (gpu_hist) {
+        SmartPtr<CLLumaHistogram> luma_hist = new CLLumaHistogram (context, XCAM_CL_TONEMAPPING_HIST_BINS);
+        if (luma_hist->init () == XCAM_RETURN_NO_ERROR)
+            tonemapping_handler->set_luma_histogram (luma_hist);
+        else
+            XCAM_LOG_WARNING ("tonemapping falls back to 3a stats since luma histogram init failed");
+    }
     tonemapping_handler->set_tonemapping_kernel(tonemapping_kernel);
 
     return tonemapping_handler;
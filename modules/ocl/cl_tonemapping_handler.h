@@ -25,6 +25,7 @@
 #include <x3a_stats_pool.h>
 #include <ocl/cl_image_handler.h>
 #include <ocl/cl_bayer_basic_handler.h>
+#include <ocl/cl_luma_histogram.h>
 
 namespace XCam {
 
@@ -41,6 +42,9 @@ class CLTonemappingImageHandler
 {
 public:
     explicit CLTonemappingImageHandler (const SmartPtr<CLContext> &context, const char *name);
+    // curve from GPU histogram of a previous frame instead of 3A stats,
+    // need be set before tonemapping kernel
+    bool set_luma_histogram (const SmartPtr<CLLumaHistogram> &hist);
     bool set_tonemapping_kernel(SmartPtr<CLTonemappingImageKernel> &kernel);
     bool set_wb_config (const XCam3aResultWhiteBalance &wb);
 
@@ -49,16 +53,23 @@ protected:
         const VideoBufferInfo &input, VideoBufferInfo &output);
     virtual XCamReturn prepare_parameters (
         SmartPtr<VideoBuffer> &input, SmartPtr<VideoBuffer> &output);
+    virtual XCamReturn execute_done (SmartPtr<VideoBuffer> &output);
 
 private:
+    XCamReturn update_curve_from_stats (SmartPtr<VideoBuffer> &input);
+
     XCAM_DEAD_COPY (CLTonemappingImageHandler);
     SmartPtr<CLTonemappingImageKernel>   _tonemapping_kernel;
+    SmartPtr<CLLumaHistogram>            _luma_hist;
     int32_t                              _output_format;
     CLWBConfig                           _wb_config;
+    float                                _y_max;
+    float                                _y_target;
 };
 
+// @gpu_hist, tonemaps by GPU luma histogram, 3A stats are not needed
 SmartPtr<CLImageHandler>
-create_cl_tonemapping_image_handler (const SmartPtr<CLContext> &context);
+create_cl_tonemapping_image_handler (const SmartPtr<CLContext> &context, bool gpu_hist = true);
 
 };
 
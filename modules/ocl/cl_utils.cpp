@@ -87,20 +87,25 @@ convert_to_clbuffer (
     SmartPtr<CLBuffer> cl_buf;
 
     SmartPtr<CLVideoBuffer> cl_video_buf = buf.dynamic_cast_ptr<CLVideoBuffer> ();
+#if HAVE_LIBDRM
+    SmartPtr<DrmBoBuffer> bo_buf = buf.dynamic_cast_ptr<DrmBoBuffer> ();
+#endif
     if (cl_video_buf.ptr ()) {
         cl_buf = cl_video_buf;
     }
 #if HAVE_LIBDRM
-    else {
-        SmartPtr<DrmBoBuffer> bo_buf = buf.dynamic_cast_ptr<DrmBoBuffer> ();
+    else if (bo_buf.ptr ()) {
         SmartPtr<CLIntelContext> ctx = context.dynamic_cast_ptr<CLIntelContext> ();
-        XCAM_ASSERT (bo_buf.ptr () && ctx.ptr ());
+        XCAM_ASSERT (ctx.ptr ());
 
         cl_buf = new CLVaBuffer (ctx, bo_buf);
     }
-#else
-    XCAM_UNUSED (context);
 #endif
+    else {
+        // host memory, e.g. soft buffers, shared without copy if page aligned
+        cl_buf = CLVideoBuffer::import_video_buffer (buf);
+    }
+    XCAM_UNUSED (context);
 
     XCAM_FAIL_RETURN (WARNING, cl_buf.ptr (), NULL, "convert to clbuffer failed");
     return cl_buf;
@@ -117,6 +122,15 @@ convert_to_climage (
     SmartPtr<CLImage> cl_image;
 
     SmartPtr<CLVideoBuffer> cl_video_buf = buf.dynamic_cast_ptr<CLVideoBuffer> ();
+#if HAVE_LIBDRM
+    SmartPtr<DrmBoBuffer> bo_buf = buf.dynamic_cast_ptr<DrmBoBuffer> ();
+    if (!cl_video_buf.ptr () && !bo_buf.ptr ())
+#else
+    if (!cl_video_buf.ptr ())
+#endif
+        // host memory, e.g. soft buffers, shared without copy if page aligned
+        cl_video_buf = CLVideoBuffer::import_video_buffer (buf);
+
     if (cl_video_buf.ptr ()) {
         SmartPtr<CLBuffer> cl_buf;
 
@@ -133,10 +147,9 @@ convert_to_climage (
         cl_image = new CLImage2D (context, desc, flags, cl_buf);
     }
 #if HAVE_LIBDRM
-    else {
-        SmartPtr<DrmBoBuffer> bo_buf = buf.dynamic_cast_ptr<DrmBoBuffer> ();
+    else if (bo_buf.ptr ()) {
         SmartPtr<CLIntelContext> ctx = context.dynamic_cast_ptr<CLIntelContext> ();
-        XCAM_ASSERT (bo_buf.ptr () && ctx.ptr ());
+        XCAM_ASSERT (ctx.ptr ());
 
         cl_image = new CLVaImage (ctx, bo_buf, desc, offset);
     }
@@ -38,6 +38,7 @@ enum CLWaveletBasis {
     CL_WAVELET_DISABLED = 0,
     CL_WAVELET_HAT,
     CL_WAVELET_HAAR,
+    CL_WAVELET_HAAR_LIFTING,
 };
 
 enum CLImageChannel {
@@ -23,12 +23,17 @@
 #include "ocl/cl_device.h"
 #include "ocl/cl_video_buffer.h"
 #include "x3a_stats_pool.h"
+#include <unistd.h>
+#if HAVE_LIBDRM
+#include "ocl/intel/cl_va_memory.h"
+#endif
 
 namespace XCam {
 
-CLVideoBufferData::CLVideoBufferData (SmartPtr<CLBuffer> &body)
+CLVideoBufferData::CLVideoBufferData (SmartPtr<CLBuffer> &body, const SmartPtr<VideoBuffer> &host_buf)
     : _buf_ptr (NULL)
     , _buf (body)
+    , _host_buf (host_buf)
 {
     XCAM_ASSERT (body.ptr ());
 }
@@ -36,6 +41,15 @@ CLVideoBufferData::CLVideoBufferData (SmartPtr<CLBuffer> &body)
 CLVideoBufferData::~CLVideoBufferData ()
 {
     unmap ();
+
+    if (_host_buf.ptr ()) {
+        // blocking map waits for kernels on the buffer and makes their writes visible to host
+        if (map ())
+            unmap ();
+        _buf.release ();
+        _host_buf->unmap ();
+        _host_buf.release ();
+    }
     _buf.release ();
 }
 
@@ -78,6 +92,12 @@ CLVideoBufferData::unmap ()
     return true;
 }
 
+int
+CLVideoBufferData::get_fd ()
+{
+    return _buf->export_fd ();
+}
+
 CLVideoBuffer::CLVideoBuffer (
     const SmartPtr<CLContext> &context, const VideoBufferInfo &info, const SmartPtr<CLVideoBufferData> &data)
     : BufferProxy (info, data)
@@ -111,6 +131,90 @@ CLVideoBuffer::find_3a_stats ()
     return find_typed_attach<X3aStats> ();
 }
 
+SmartPtr<CLVideoBuffer>
+CLVideoBuffer::import_dma_buffer (const VideoBufferInfo &info, const SmartPtr<VideoBuffer> &dma_buf)
+{
+    XCAM_ASSERT (dma_buf.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING, dma_buf->get_size () >= info.size, NULL,
+        "CLVideoBuffer import failed, dma buffer size(%d) is less than %d", dma_buf->get_size (), info.size);
+
+#if HAVE_LIBDRM
+    SmartPtr<CLIntelContext> context = CLDevice::instance ()->get_context ().dynamic_cast_ptr<CLIntelContext> ();
+    XCAM_FAIL_RETURN (
+        WARNING, context.ptr (), NULL,
+        "CLVideoBuffer import failed, intel context is not available");
+
+    SmartPtr<CLBuffer> cl_buf = new CLDmaBuffer (context, dma_buf);
+    XCAM_ASSERT (cl_buf.ptr ());
+    XCAM_FAIL_RETURN (WARNING, cl_buf->is_valid (), NULL, "CLVideoBuffer import dma buffer failed");
+
+    SmartPtr<CLVideoBufferData> data = new CLVideoBufferData (cl_buf);
+    SmartPtr<CLVideoBuffer> buf = new CLVideoBuffer (context, info, data);
+    XCAM_ASSERT (buf.ptr ());
+    buf->set_timestamp (dma_buf->get_timestamp ());
+
+    return buf;
+#else
+    XCAM_LOG_DEBUG ("CLVideoBuffer import dma buffer unsupported without libdrm");
+    return NULL;
+#endif
+}
+
+SmartPtr<CLVideoBuffer>
+CLVideoBuffer::import_host_ptr (const VideoBufferInfo &info, uint8_t *ptr)
+{
+    // drivers copy unaligned host memory behind the scenes, that's no import
+    uintptr_t page_size = (uintptr_t) sysconf (_SC_PAGESIZE);
+    XCAM_FAIL_RETURN (
+        WARNING, ptr && ((uintptr_t) ptr % page_size) == 0, NULL,
+        "CLVideoBuffer import failed, host pointer is not %d bytes aligned", (int) page_size);
+
+    SmartPtr<CLContext> context = CLDevice::instance ()->get_context ();
+    SmartPtr<CLBuffer> cl_buf =
+        new CLBuffer (context, info.size, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, ptr);
+    XCAM_ASSERT (cl_buf.ptr ());
+    XCAM_FAIL_RETURN (WARNING, cl_buf->is_valid (), NULL, "CLVideoBuffer import host pointer failed");
+
+    SmartPtr<CLVideoBufferData> data = new CLVideoBufferData (cl_buf);
+    SmartPtr<CLVideoBuffer> buf = new CLVideoBuffer (context, info, data);
+    XCAM_ASSERT (buf.ptr ());
+
+    return buf;
+}
+
+SmartPtr<CLVideoBuffer>
+CLVideoBuffer::import_video_buffer (const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+    const VideoBufferInfo &info = buf->get_video_info ();
+
+    uintptr_t page_size = (uintptr_t) sysconf (_SC_PAGESIZE);
+    uint8_t *ptr = buf->map ();
+    if (!ptr || ((uintptr_t) ptr % page_size) != 0) {
+        buf->unmap ();
+        XCAM_LOG_DEBUG ("CLVideoBuffer import video buffer skipped, memory is not %d bytes aligned", (int) page_size);
+        return NULL;
+    }
+
+    SmartPtr<CLContext> context = CLDevice::instance ()->get_context ();
+    SmartPtr<CLBuffer> cl_buf =
+        new CLBuffer (context, info.size, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, ptr);
+    XCAM_ASSERT (cl_buf.ptr ());
+    if (!cl_buf->is_valid ()) {
+        buf->unmap ();
+        XCAM_LOG_WARNING ("CLVideoBuffer import video buffer failed");
+        return NULL;
+    }
+
+    SmartPtr<CLVideoBufferData> data = new CLVideoBufferData (cl_buf, buf);
+    SmartPtr<CLVideoBuffer> cl_video_buf = new CLVideoBuffer (context, info, data);
+    XCAM_ASSERT (cl_video_buf.ptr ());
+    cl_video_buf->set_timestamp (buf->get_timestamp ());
+
+    return cl_video_buf;
+}
+
 bool
 CLVideoBufferPool::fixate_video_info (VideoBufferInfo &info)
 {
@@ -37,6 +37,7 @@ class CLVideoBufferData
     : public BufferData
 {
     friend class CLVideoBufferPool;
+    friend class CLVideoBuffer;
 
 public:
     ~CLVideoBufferData ();
@@ -49,9 +50,11 @@ public:
     //derived from BufferData
     virtual uint8_t *map ();
     virtual bool unmap ();
+    virtual int get_fd ();
 
 protected:
-    explicit CLVideoBufferData (SmartPtr<CLBuffer> &body);
+    // @host_buf, owner of host memory wrapped by @body, kept until CL is done with it
+    explicit CLVideoBufferData (SmartPtr<CLBuffer> &body, const SmartPtr<VideoBuffer> &host_buf = NULL);
 
 private:
     XCAM_DEAD_COPY (CLVideoBufferData);
@@ -59,6 +62,7 @@ private:
 private:
     uint8_t                *_buf_ptr;
     SmartPtr<CLBuffer>      _buf;
+    SmartPtr<VideoBuffer>   _host_buf;
 };
 
 class CLVideoBuffer
@@ -75,6 +79,15 @@ public:
     SmartPtr<CLBuffer> get_cl_buffer ();
     SmartPtr<X3aStats> find_3a_stats ();
 
+    // zero-copy, wraps dma-buf of @dma_buf laid out as @info, NULL if import is unsupported
+    static SmartPtr<CLVideoBuffer> import_dma_buffer (
+        const VideoBufferInfo &info, const SmartPtr<VideoBuffer> &dma_buf);
+    // zero-copy by CL_MEM_USE_HOST_PTR, @ptr needs page alignment and stays valid while buffer lives
+    static SmartPtr<CLVideoBuffer> import_host_ptr (const VideoBufferInfo &info, uint8_t *ptr);
+    // zero-copy on host memory of @buf, e.g. SoftBufMemShared soft buffers, kept alive by the import,
+    // CPU sees CL writes once the import is released. NULL if memory of @buf is not page aligned
+    static SmartPtr<CLVideoBuffer> import_video_buffer (const SmartPtr<VideoBuffer> &buf);
+
 protected:
     CLVideoBuffer (const VideoBufferInfo &info, const SmartPtr<CLVideoBufferData> &data);
 
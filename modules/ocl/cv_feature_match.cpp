@@ -33,6 +33,18 @@ CVFeatureMatch::CVFeatureMatch ()
     , FeatureMatch ()
 {
     XCAM_ASSERT (_cv_context.ptr ());
+    _fast_detector = cv::FastFeatureDetector::create (20, true);
+}
+
+void
+CVFeatureMatch::reset_scratch ()
+{
+    // clear () keeps capacity, no reallocation once warmed up
+    _keypoints.clear ();
+    _corner_left.clear ();
+    _corner_right.clear ();
+    _status.clear ();
+    _err.clear ();
 }
 
 bool
@@ -59,11 +71,11 @@ void
 CVFeatureMatch::add_detected_data (
     cv::InputArray image, cv::Ptr<cv::Feature2D> detector, std::vector<cv::Point2f> &corners)
 {
-    std::vector<cv::KeyPoint> keypoints;
-    detector->detect (image, keypoints);
-    corners.reserve (corners.size () + keypoints.size ());
-    for (size_t i = 0; i < keypoints.size (); ++i) {
-        cv::KeyPoint &kp = keypoints[i];
+    _keypoints.clear ();
+    detector->detect (image, _keypoints);
+    corners.reserve (corners.size () + _keypoints.size ());
+    for (size_t i = 0; i < _keypoints.size (); ++i) {
+        cv::KeyPoint &kp = _keypoints[i];
         corners.push_back (kp.pt);
     }
 }
@@ -203,29 +215,25 @@ CVFeatureMatch::detect_and_match (
     cv::InputArray img_left, cv::InputArray img_right, Rect &crop_left, Rect &crop_right,
     int &valid_count, float &mean_offset, float &x_offset, int dst_width)
 {
-    std::vector<float> err;
-    std::vector<uchar> status;
-    std::vector<cv::Point2f> corner_left, corner_right;
-    cv::Ptr<cv::Feature2D> fast_detector;
     cv::Size win_size = cv::Size (5, 5);
 
     if (img_left.isUMat ())
         win_size = cv::Size (16, 16);
 
-    fast_detector = cv::FastFeatureDetector::create (20, true);
-    add_detected_data (img_left, fast_detector, corner_left);
+    reset_scratch ();
+    add_detected_data (img_left, _fast_detector, _corner_left);
 
-    if (corner_left.empty ()) {
+    if (_corner_left.empty ()) {
         return;
     }
 
     cv::calcOpticalFlowPyrLK (
-        img_left, img_right, corner_left, corner_right, status, err, win_size, 3,
+        img_left, img_right, _corner_left, _corner_right, _status, _err, win_size, 3,
         cv::TermCriteria (cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 10, 0.01f));
     cv::ocl::finish();
 
-    calc_of_match (img_left, img_right, corner_left, corner_right,
-                   status, err, valid_count, mean_offset, x_offset);
+    calc_of_match (img_left, img_right, _corner_left, _corner_right,
+                   _status, _err, valid_count, mean_offset, x_offset);
 
     adjust_stitch_area (dst_width, x_offset, crop_left, crop_right);
 
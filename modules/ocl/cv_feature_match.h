@@ -74,6 +74,17 @@ protected:
     void debug_write_image ( const SmartPtr<VideoBuffer> &buf, const Rect &rect, char *img_name,
                              char *frame_str, char *fm_idx_str);
 
+    void reset_scratch ();
+
+protected:
+    // scratch kept across frames, matchers of different overlaps can run in parallel
+    cv::Ptr<cv::Feature2D>         _fast_detector;
+    std::vector<cv::KeyPoint>      _keypoints;
+    std::vector<cv::Point2f>       _corner_left;
+    std::vector<cv::Point2f>       _corner_right;
+    std::vector<uchar>             _status;
+    std::vector<float>             _err;
+
 private:
     XCAM_DEAD_COPY (CVFeatureMatch);
 
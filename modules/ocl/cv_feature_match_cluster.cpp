@@ -265,29 +265,25 @@ CVFeatureMatchCluster::detect_and_match_cluster (
     cv::InputArray img_left, cv::InputArray img_right, Rect &crop_left, Rect &crop_right,
     float &mean_offset_x, float &mean_offset_y, float &x_offset, float &y_offset)
 {
-    std::vector<float> err;
-    std::vector<uchar> status;
-    std::vector<cv::Point2f> corner_left, corner_right;
-    cv::Ptr<cv::Feature2D> fast_detector;
     cv::Size win_size = cv::Size (21, 21);
 
     if (img_left.isUMat ())
         win_size = cv::Size (16, 16);
 
-    fast_detector = cv::FastFeatureDetector::create (20, true);
-    add_detected_data (img_left, fast_detector, corner_left);
+    reset_scratch ();
+    add_detected_data (img_left, _fast_detector, _corner_left);
 
-    if (corner_left.empty ()) {
+    if (_corner_left.empty ()) {
         return;
     }
 
     cv::calcOpticalFlowPyrLK (
-        img_left, img_right, corner_left, corner_right, status, err, win_size, 3,
+        img_left, img_right, _corner_left, _corner_right, _status, _err, win_size, 3,
         cv::TermCriteria (cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01f));
     cv::ocl::finish();
 
-    calc_of_match_cluster (img_left, img_right, corner_left, corner_right,
-                           status, err, mean_offset_x, mean_offset_y, x_offset, y_offset);
+    calc_of_match_cluster (img_left, img_right, _corner_left, _corner_right,
+                           _status, _err, mean_offset_x, mean_offset_y, x_offset, y_offset);
 
 #if XCAM_CV_FM_DEBUG
     XCAM_LOG_INFO ("x_offset:%0.2f", x_offset);
@@ -163,11 +163,27 @@ CVImageDeblurring::blind_deblurring (const cv::Mat &blurred, cv::Mat &deblurred,
         noise_power = 1.0f / _helper->get_snr (gray_blurred, median_blurred);
         XCAM_LOG_DEBUG ("estimated inv snr %f", noise_power);
     }
+    // kernel is estimated at reduced resolution, then scaled back
+    int scale = XCAM_MAX (_config.estimate_scale, 1);
+    cv::Mat gray_estimate = gray_blurred;
+    if (scale > 1)
+    {
+        cv::resize (gray_blurred, gray_estimate, cv::Size (), 1.0 / scale, 1.0 / scale, cv::INTER_AREA);
+    }
     if (kernel_size < 0)
     {
-        kernel_size = estimate_kernel_size (gray_blurred);
+        kernel_size = estimate_kernel_size (gray_estimate) * scale;
+        if (!(kernel_size & 1))
+        {
+            kernel_size++;
+        }
         XCAM_LOG_DEBUG ("estimated kernel size %d", kernel_size);
     }
+    int estimate_size = kernel_size;
+    if (scale > 1)
+    {
+        estimate_size = XCAM_MAX (kernel_size / scale, 3) | 1;
+    }
     if (use_edgetaper) {
         XCAM_LOG_DEBUG ("edgetaper will be used");
     }
@@ -179,7 +195,20 @@ CVImageDeblurring::blind_deblurring (const cv::Mat &blurred, cv::Mat &deblurred,
     std::vector<cv::Mat> deblurred_rgb (3);
     cv::Mat result_deblurred;
     cv::Mat result_kernel;
-    blind_deblurring_one_channel (gray_blurred, result_kernel, kernel_size, noise_power);
+    if (is_ocl_path ())
+    {
+        blind_deblurring_one_channel_ocl (gray_estimate, result_kernel, estimate_size, noise_power);
+    }
+    else
+    {
+        blind_deblurring_one_channel (gray_estimate, result_kernel, estimate_size, noise_power);
+    }
+    if (estimate_size != kernel_size)
+    {
+        cv::resize (result_kernel, result_kernel, cv::Size (kernel_size, kernel_size), 0, 0, cv::INTER_LINEAR);
+        _helper->apply_constraints (result_kernel, 0);
+        _helper->normalize_weights (result_kernel);
+    }
     for (int i = 0; i < 3; i++)
     {
         cv::Mat input;
@@ -191,8 +220,7 @@ CVImageDeblurring::blind_deblurring (const cv::Mat &blurred, cv::Mat &deblurred,
         {
             input = blurred_rgb[i].clone ();
         }
-        _wiener->wiener_filter (input, result_kernel, deblurred_rgb[i], noise_power);
-        _helper->apply_constraints (deblurred_rgb[i], 0);
+        wiener_channel (input, result_kernel, deblurred_rgb[i], noise_power);
     }
     cv::merge (deblurred_rgb, result_deblurred);
     result_deblurred.convertTo (result_deblurred, CV_8UC3);
@@ -200,25 +228,100 @@ CVImageDeblurring::blind_deblurring (const cv::Mat &blurred, cv::Mat &deblurred,
     kernel = result_kernel.clone ();
 }
 
+void
+CVImageDeblurring::wiener_channel (const cv::Mat &input, const cv::Mat &kernel, cv::Mat &output, float noise_power)
+{
+    if (is_ocl_path ())
+    {
+        cv::UMat input_u = input.getUMat (cv::ACCESS_READ);
+        cv::UMat kernel_u = kernel.getUMat (cv::ACCESS_READ);
+        cv::UMat output_u;
+        _wiener->wiener_filter (input_u, kernel_u, output_u, noise_power);
+        _helper->apply_constraints (output_u, 0);
+        output_u.copyTo (output);
+        return;
+    }
+
+    _wiener->wiener_filter (input, kernel, output, noise_power);
+    _helper->apply_constraints (output, 0);
+}
+
+// crops and constrains the kernel estimated in this iteration, true once it converged
+bool
+CVImageDeblurring::update_kernel (cv::Mat &kernel_current, int kernel_size, cv::Mat &kernel_last)
+{
+    kernel_current = kernel_current (cv::Rect (0, 0, kernel_size, kernel_size)).clone ();
+    double min_val;
+    double max_val;
+    cv::minMaxLoc (kernel_current, &min_val, &max_val);
+    _helper->apply_constraints (kernel_current, (float)max_val / 20);
+    _helper->normalize_weights (kernel_current);
+
+    bool converged = false;
+    if (_config.convergence > 0.0f && !kernel_last.empty ())
+    {
+        converged = cv::norm (kernel_current, kernel_last, cv::NORM_L1) < _config.convergence;
+    }
+    kernel_last = kernel_current.clone ();
+    return converged;
+}
+
 void
 CVImageDeblurring::blind_deblurring_one_channel (const cv::Mat &blurred, cv::Mat &kernel, int kernel_size, float noise_power)
 {
     cv::Mat kernel_current = cv::Mat::zeros (kernel_size, kernel_size, CV_32FC1);
+    cv::Mat kernel_last;
     cv::Mat deblurred_current = _helper->erosion (blurred, 2, 0);
+    cv::Mat blurred_ft;
+    _helper->compute_dft (blurred, blurred_ft);
     float sigmar = 20;
     for (int i = 0; i < _config.iterations; i++)
     {
         cv::Mat sharpened = _sharp->sharp_image_gray (deblurred_current, sigmar);
-        _wiener->wiener_filter (blurred, sharpened.clone (), kernel_current, noise_power);
-        kernel_current = kernel_current (cv::Rect (0, 0, kernel_size, kernel_size));
-        double min_val;
-        double max_val;
-        cv::minMaxLoc (kernel_current, &min_val, &max_val);
-        _helper->apply_constraints (kernel_current, (float)max_val / 20);
-        _helper->normalize_weights (kernel_current);
-        _wiener->wiener_filter (blurred, kernel_current.clone(), deblurred_current, noise_power);
+        _wiener->wiener_filter_ft (blurred_ft, blurred.size (), sharpened.clone (), kernel_current, noise_power);
+        bool converged = update_kernel (kernel_current, kernel_size, kernel_last);
+        _wiener->wiener_filter_ft (blurred_ft, blurred.size (), kernel_current.clone(), deblurred_current, noise_power);
+        _helper->apply_constraints (deblurred_current, 0);
+        sigmar *= 0.9;
+        if (converged)
+        {
+            XCAM_LOG_DEBUG ("blind deblurring converged after %d iterations", i + 1);
+            break;
+        }
+    }
+    kernel = kernel_current.clone ();
+}
+
+// image sized work stays on device, only the small kernel is constrained on host
+void
+CVImageDeblurring::blind_deblurring_one_channel_ocl (const cv::Mat &blurred, cv::Mat &kernel, int kernel_size, float noise_power)
+{
+    cv::Mat kernel_current = cv::Mat::zeros (kernel_size, kernel_size, CV_32FC1);
+    cv::Mat kernel_last;
+    cv::UMat blurred_u, blurred_ft;
+    blurred.copyTo (blurred_u);
+    _helper->compute_dft (blurred_u, blurred_ft);
+
+    cv::UMat deblurred_current;
+    _helper->erosion (blurred, 2, 0).copyTo (deblurred_current);
+    float sigmar = 20;
+    for (int i = 0; i < _config.iterations; i++)
+    {
+        cv::UMat sharpened = _sharp->sharp_image_gray (deblurred_current, sigmar);
+        cv::UMat kernel_u;
+        _wiener->wiener_filter_ft (blurred_ft, blurred.size (), sharpened, kernel_u, noise_power);
+        kernel_u (cv::Rect (0, 0, kernel_size, kernel_size)).copyTo (kernel_current);
+        bool converged = update_kernel (kernel_current, kernel_size, kernel_last);
+
+        kernel_current.copyTo (kernel_u);
+        _wiener->wiener_filter_ft (blurred_ft, blurred.size (), kernel_u, deblurred_current, noise_power);
         _helper->apply_constraints (deblurred_current, 0);
         sigmar *= 0.9;
+        if (converged)
+        {
+            XCAM_LOG_DEBUG ("blind deblurring converged after %d iterations", i + 1);
+            break;
+        }
     }
     kernel = kernel_current.clone ();
 }
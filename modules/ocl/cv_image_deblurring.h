@@ -34,10 +34,14 @@ namespace XCam {
 
 struct CVIDConfig {
     int iterations;            // number of iterations for IBD algorithm
+    float convergence;         // stop once L1 change of normalized kernel is below, 0 runs all iterations
+    int estimate_scale;        // kernel and its size are estimated on gray image downscaled by this
 
-    CVIDConfig (unsigned int _iterations = 50)
+    CVIDConfig (unsigned int _iterations = 50, float _convergence = 0.0f, int _estimate_scale = 1)
     {
         iterations = _iterations;
+        convergence = _convergence;
+        estimate_scale = _estimate_scale;
     }
 };
 
@@ -52,6 +56,9 @@ public:
 
 private:
     void blind_deblurring_one_channel (const cv::Mat &blurred, cv::Mat &kernel, int kernel_size, float noise_power);
+    void blind_deblurring_one_channel_ocl (const cv::Mat &blurred, cv::Mat &kernel, int kernel_size, float noise_power);
+    bool update_kernel (cv::Mat &kernel_current, int kernel_size, cv::Mat &kernel_last);
+    void wiener_channel (const cv::Mat &input, const cv::Mat &kernel, cv::Mat &output, float noise_power);
     int estimate_kernel_size (const cv::Mat &blurred);
     void crop_border (cv::Mat &image);
 
@@ -92,6 +92,38 @@ CVImageProcessHelper::apply_constraints (cv::Mat &image, float threshold_min_val
     }
 }
 
+void
+CVImageProcessHelper::compute_dft (const cv::UMat &image, cv::UMat &result)
+{
+    cv::UMat padded;
+    int m = cv::getOptimalDFTSize (image.rows);
+    int n = cv::getOptimalDFTSize (image.cols);
+    cv::copyMakeBorder (image, padded, 0, m - image.rows, 0, n - image.cols, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+    std::vector<cv::UMat> planes (2);
+    padded.convertTo (planes[0], CV_32FC1);
+    planes[1] = cv::UMat::zeros (padded.size (), CV_32FC1);
+    cv::merge (planes, result);
+    cv::dft (result, result);
+}
+
+void
+CVImageProcessHelper::compute_idft (const std::vector<cv::UMat> &input, cv::UMat &result)
+{
+    cv::UMat fimg;
+    cv::merge (input, fimg);
+    cv::idft (fimg, result, cv::DFT_REAL_OUTPUT + cv::DFT_SCALE);
+}
+
+void
+CVImageProcessHelper::apply_constraints (cv::UMat &image, float threshold_min_value, float threshold_max_value, float min_value, float max_value)
+{
+    cv::UMat mask;
+    cv::compare (image, cv::Scalar (threshold_min_value), mask, cv::CMP_LT);
+    image.setTo (cv::Scalar (min_value), mask);
+    cv::compare (image, cv::Scalar (threshold_max_value), mask, cv::CMP_GT);
+    image.setTo (cv::Scalar (max_value), mask);
+}
+
 void
 CVImageProcessHelper::normalize_weights (cv::Mat &weights)
 {
@@ -38,6 +38,11 @@ public:
     void compute_dft (const cv::Mat &image, cv::Mat &result);
     void compute_idft (cv::Mat *input, cv::Mat &result);
     void apply_constraints (cv::Mat &image, float threshold_min_value = 0.0f, float threshold_max_value = 255.0f, float min_value = 0.0f, float max_value = 255.0f);
+
+    // UMat versions run through OpenCV OCL on the shared CLContext
+    void compute_dft (const cv::UMat &image, cv::UMat &result);
+    void compute_idft (const std::vector<cv::UMat> &input, cv::UMat &result);
+    void apply_constraints (cv::UMat &image, float threshold_min_value = 0.0f, float threshold_max_value = 255.0f, float min_value = 0.0f, float max_value = 255.0f);
     float get_snr (const cv::Mat &noisy, const cv::Mat &noiseless);
     cv::Mat erosion (const cv::Mat &image, int erosion_size, int erosion_type);
     void normalize_weights (cv::Mat &weights);
@@ -47,6 +47,24 @@ CVImageSharp::sharp_image_gray (const cv::Mat &image, float sigmar)
     return sharpened.clone ();
 }
 
+cv::UMat
+CVImageSharp::sharp_image_gray (const cv::UMat &image, float sigmar)
+{
+    cv::UMat temp_image;
+    image.convertTo (temp_image, CV_32FC1);
+    cv::UMat bilateral_image;
+    cv::bilateralFilter (temp_image, bilateral_image, 5, sigmar, 2);
+
+    cv::Mat sharp_filter = (cv::Mat_<float>(3, 3) << -1, -1, -1, -1, 8, -1, -1, -1, -1);
+    cv::UMat filtered_image;
+    cv::filter2D (bilateral_image, filtered_image, -1, sharp_filter);
+    cv::normalize (filtered_image, filtered_image, 0, 255.0f, cv::NORM_MINMAX);
+    cv::UMat sharpened;
+    cv::add (temp_image, filtered_image, sharpened);
+    cv::normalize (sharpened, sharpened, 0, 255.0f, cv::NORM_MINMAX);
+    return sharpened;
+}
+
 float
 CVImageSharp::measure_sharp (const cv::Mat &image)
 {
@@ -36,6 +36,7 @@ public:
 
     float measure_sharp (const cv::Mat &image);
     cv::Mat sharp_image_gray (const cv::Mat &image, float sigmar);
+    cv::UMat sharp_image_gray (const cv::UMat &image, float sigmar);
 
     XCAM_DEAD_COPY (CVImageSharp);
 };
@@ -33,10 +33,24 @@ CVWienerFilter::CVWienerFilter ()
 void
 CVWienerFilter::wiener_filter (const cv::Mat &blurred_image, const cv::Mat &known, cv::Mat &unknown, float noise_power)
 {
-    int image_w = blurred_image.size ().width;
-    int image_h = blurred_image.size ().height;
     cv::Mat y_ft;
     _helpers->compute_dft (blurred_image, y_ft);
+    wiener_filter_ft (y_ft, blurred_image.size (), known, unknown, noise_power);
+}
+
+void
+CVWienerFilter::wiener_filter (const cv::UMat &blurred_image, const cv::UMat &known, cv::UMat &unknown, float noise_power)
+{
+    cv::UMat y_ft;
+    _helpers->compute_dft (blurred_image, y_ft);
+    wiener_filter_ft (y_ft, blurred_image.size (), known, unknown, noise_power);
+}
+
+void
+CVWienerFilter::wiener_filter_ft (const cv::Mat &y_ft, const cv::Size &size, const cv::Mat &known, cv::Mat &unknown, float noise_power)
+{
+    int image_w = size.width;
+    int image_h = size.height;
 
     cv::Mat padded = cv::Mat::zeros (image_h, image_w, CV_32FC1);
     int padx = padded.cols - known.cols;
@@ -51,22 +65,50 @@ CVWienerFilter::wiener_filter (const cv::Mat &blurred_image, const cv::Mat &know
     unknown_ft[1] = cv::Mat::zeros (image_h, image_w, CV_32FC1);
 
     cv::Mat denominator;
-    cv::Mat denominator_splitted[] = {cv::Mat::zeros (blurred_image.size (), CV_32FC1), cv::Mat::zeros (blurred_image.size (), CV_32FC1)};
+    cv::Mat denominator_splitted[] = {cv::Mat::zeros (size, CV_32FC1), cv::Mat::zeros (size, CV_32FC1)};
     cv::mulSpectrums (padded_ft, padded_ft, denominator, 0, true);
     cv::split (denominator, denominator_splitted);
-    denominator_splitted[0] = denominator_splitted[0] (cv::Rect (0, 0, blurred_image.cols, blurred_image.rows));
+    denominator_splitted[0] = denominator_splitted[0] (cv::Rect (0, 0, image_w, image_h));
     denominator_splitted[0] += cv::Scalar (noise_power);
 
     cv::Mat numerator;
-    cv::Mat numerator_splitted[] = {cv::Mat::zeros (blurred_image.size (), CV_32FC1), cv::Mat::zeros (blurred_image.size (), CV_32FC1)};
+    cv::Mat numerator_splitted[] = {cv::Mat::zeros (size, CV_32FC1), cv::Mat::zeros (size, CV_32FC1)};
     cv::mulSpectrums (y_ft, padded_ft, numerator, 0, true);
     cv::split (numerator, numerator_splitted);
-    numerator_splitted[0] = numerator_splitted[0] (cv::Rect (0, 0, blurred_image.cols, blurred_image.rows));
-    numerator_splitted[1] = numerator_splitted[1] (cv::Rect (0, 0, blurred_image.cols, blurred_image.rows));
+    numerator_splitted[0] = numerator_splitted[0] (cv::Rect (0, 0, image_w, image_h));
+    numerator_splitted[1] = numerator_splitted[1] (cv::Rect (0, 0, image_w, image_h));
     cv::divide (numerator_splitted[0], denominator_splitted[0], unknown_ft[0]);
     cv::divide (numerator_splitted[1], denominator_splitted[0], unknown_ft[1]);
     _helpers->compute_idft (unknown_ft, temp_unknown);
     unknown = temp_unknown.clone();
 }
 
+void
+CVWienerFilter::wiener_filter_ft (const cv::UMat &y_ft, const cv::Size &size, const cv::UMat &known, cv::UMat &unknown, float noise_power)
+{
+    cv::Rect image_rect (0, 0, size.width, size.height);
+
+    cv::UMat padded;
+    cv::copyMakeBorder (known, padded, 0, size.height - known.rows, 0, size.width - known.cols, cv::BORDER_CONSTANT, cv::Scalar::all(0));
+    cv::UMat padded_ft;
+    _helpers->compute_dft (padded, padded_ft);
+
+    cv::UMat denominator;
+    std::vector<cv::UMat> denominator_splitted;
+    cv::mulSpectrums (padded_ft, padded_ft, denominator, 0, true);
+    cv::split (denominator, denominator_splitted);
+    cv::UMat power;
+    cv::add (denominator_splitted[0] (image_rect), cv::Scalar (noise_power), power);
+
+    cv::UMat numerator;
+    std::vector<cv::UMat> numerator_splitted;
+    cv::mulSpectrums (y_ft, padded_ft, numerator, 0, true);
+    cv::split (numerator, numerator_splitted);
+
+    std::vector<cv::UMat> unknown_ft (2);
+    cv::divide (numerator_splitted[0] (image_rect), power, unknown_ft[0]);
+    cv::divide (numerator_splitted[1] (image_rect), power, unknown_ft[1]);
+    _helpers->compute_idft (unknown_ft, unknown);
+}
+
 }
@@ -36,6 +36,12 @@ public:
     explicit CVWienerFilter ();
 
     void wiener_filter (const cv::Mat &blurred_image, const cv::Mat &known, cv::Mat &unknown, float noise_power);
+    void wiener_filter (const cv::UMat &blurred_image, const cv::UMat &known, cv::UMat &unknown, float noise_power);
+
+    // @blurred_ft from CVImageProcessHelper::compute_dft of the blurred image of @size,
+    // iterations on the same blurred image compute it once
+    void wiener_filter_ft (const cv::Mat &blurred_ft, const cv::Size &size, const cv::Mat &known, cv::Mat &unknown, float noise_power);
+    void wiener_filter_ft (const cv::UMat &blurred_ft, const cv::Size &size, const cv::UMat &known, cv::UMat &unknown, float noise_power);
 
 private:
 
@@ -59,6 +59,37 @@ CLVaBuffer::init_va_buffer (const SmartPtr<CLIntelContext> &context, SmartPtr<Dr
     return true;
 }
 
+CLDmaBuffer::CLDmaBuffer (
+    const SmartPtr<CLIntelContext> &context,
+    const SmartPtr<VideoBuffer> &dma_buf)
+    : CLBuffer (context)
+    , _dma_buf (dma_buf)
+{
+    init_dma_buffer (context, dma_buf);
+}
+
+bool
+CLDmaBuffer::init_dma_buffer (const SmartPtr<CLIntelContext> &context, const SmartPtr<VideoBuffer> &dma_buf)
+{
+    cl_import_buffer_info_intel import_buffer_info;
+
+    xcam_mem_clear (import_buffer_info);
+    import_buffer_info.fd = dma_buf->get_fd ();
+    import_buffer_info.size = dma_buf->get_size ();
+    XCAM_FAIL_RETURN (
+        WARNING, import_buffer_info.fd >= 0, false,
+        "CLDmaBuffer import failed, invalid fd:%d", import_buffer_info.fd);
+
+    cl_mem mem_id = context->import_dma_buffer (import_buffer_info);
+    XCAM_FAIL_RETURN (
+        WARNING, mem_id, false,
+        "CLDmaBuffer import dma buffer(fd:%d) failed", import_buffer_info.fd);
+
+    set_mem_id (mem_id);
+    set_buf_size (import_buffer_info.size);
+    return true;
+}
+
 CLVaImage::CLVaImage (
     const SmartPtr<CLIntelContext> &context,
     SmartPtr<DrmBoBuffer> &bo,
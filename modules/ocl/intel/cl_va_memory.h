@@ -44,6 +44,24 @@ private:
     SmartPtr<DrmBoBuffer>   _bo;
 };
 
+// imports whole dma-buf of @dma_buf, which is kept until the buffer released
+class CLDmaBuffer
+    : public CLBuffer
+{
+public:
+    explicit CLDmaBuffer (
+        const SmartPtr<CLIntelContext> &context,
+        const SmartPtr<VideoBuffer> &dma_buf);
+
+private:
+    bool init_dma_buffer (const SmartPtr<CLIntelContext> &context, const SmartPtr<VideoBuffer> &dma_buf);
+
+    XCAM_DEAD_COPY (CLDmaBuffer);
+
+private:
+    SmartPtr<VideoBuffer>   _dma_buf;
+};
+
 class CLVaImage
     : public CLImage
 {
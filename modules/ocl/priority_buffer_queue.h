@@ -34,10 +34,18 @@ struct PriorityBuffer
     uint32_t                  rank;
     uint32_t                  seq_num;
 
+    // events to wait before next handler
+    CLEventList               events;
+    // inputs of previous handlers, kept until buffer done on multi queues
+    VideoBufferList           held_bufs;
+    // first handler launch, CLOCK_MONOTONIC us
+    int64_t                   start_time;
+
 public:
     PriorityBuffer ()
         : rank (0)
         , seq_num (0)
+        , start_time (0)
     {}
 
     void set_seq_num (const uint32_t value) {
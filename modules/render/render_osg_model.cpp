@@ -24,17 +24,120 @@
 #include <string>
 
 #include <osg/MatrixTransform>
+#include <osg/State>
 #include <osg/Texture2D>
 #include <osgDB/ReadFile>
 
+#if HAVE_GLES
+#include <gles/egl/egl_dma_image.h>
+#endif
+
+// imports kept per fd, more fds means the source pool changed
+#define XCAM_RENDER_DMA_MAX_IMAGES 16
+
 namespace XCam {
 
+#if HAVE_GLES
+DmaNV12Source::DmaNV12Source ()
+    : _current_image (NULL)
+    , _frame_number (0)
+    , _latched (false)
+    , _failed (false)
+{
+}
+
+DmaNV12Source::~DmaNV12Source ()
+{
+    clear_images ();
+}
+
+void
+DmaNV12Source::set_buffer (const SmartPtr<VideoBuffer> &buf)
+{
+    SmartLock locker (_mutex);
+    _pending = buf;
+}
+
+void
+DmaNV12Source::clear_images ()
+{
+    for (ImageMap::iterator i = _images.begin (); i != _images.end (); ++i)
+        delete i->second;
+    _images.clear ();
+    _current_image = NULL;
+}
+
+EGLDmaNV12Image *
+DmaNV12Source::import_buffer (const SmartPtr<VideoBuffer> &buf)
+{
+    int fd = buf->get_fd ();
+    ImageMap::iterator i = _images.find (fd);
+    if (i != _images.end ())
+        return i->second;
+
+    if (_images.size () >= XCAM_RENDER_DMA_MAX_IMAGES)
+        clear_images ();
+
+    EGLDmaNV12Image *image = new EGLDmaNV12Image;
+    if (!import_dma_nv12 (buf, *image)) {
+        delete image;
+        return NULL;
+    }
+    _images[fd] = image;
+    return image;
+}
+
+uint32_t
+DmaNV12Source::get_texture (uint32_t plane, uint32_t frame_number)
+{
+    if (!_latched || frame_number != _frame_number) {
+        SmartPtr<VideoBuffer> buf;
+        {
+            SmartLock locker (_mutex);
+            buf = _pending;
+            _pending.release ();
+        }
+        _frame_number = frame_number;
+        _latched = true;
+
+        if (buf.ptr () && !_failed) {
+            EGLDmaNV12Image *image = import_buffer (buf);
+            if (image) {
+                // previous one may still be read by GPU
+                _previous = _current;
+                _current = buf;
+                _current_image = image;
+            } else {
+                XCAM_LOG_WARNING ("render import dma-buf(fd:%d) failed, fall back to copy", buf->get_fd ());
+                _failed = true;
+            }
+        }
+    }
+
+    if (!_current_image)
+        return 0;
+
+    const SmartPtr<EGLDmaImage> &dma = (plane == 0 ? _current_image->y : _current_image->uv);
+    return dma->get_texture ();
+}
+
+void
+DmaNV12Texture::apply (osg::State &state) const
+{
+    const osg::FrameStamp *stamp = state.getFrameStamp ();
+    uint32_t frame_number = stamp ? stamp->getFrameNumber () : 0;
+
+    glBindTexture (GL_TEXTURE_2D, _source->get_texture (_plane, frame_number));
+}
+#endif
+
 RenderOsgModel::RenderOsgModel (const char *name, uint32_t width, uint32_t height)
     : _name (NULL)
     , _model (NULL)
     , _geode (NULL)
     , _program (NULL)
     , _texture (NULL)
+    , _dma_enabled (true)
 {
     XCAM_LOG_DEBUG ("RenderOsgModel width(%d), height(%d) ", width, height);
     XCAM_ASSERT (name);
@@ -56,6 +159,7 @@ RenderOsgModel::RenderOsgModel (const char *name, bool from_file)
     , _geode (NULL)
     , _program (NULL)
     , _texture (NULL)
+    , _dma_enabled (true)
 {
     XCAM_LOG_DEBUG ("RenderOsgModel model name (%s) ", name);
     XCAM_ASSERT (name);
@@ -236,44 +340,120 @@ RenderOsgModel::setup_model_matrix (
 XCamReturn
 RenderOsgModel::update_texture (SmartPtr<VideoBuffer> &buffer)
 {
-    XCamReturn result = XCAM_RETURN_NO_ERROR;
-
     XCAM_LOG_DEBUG ("RenderOsgModel::update_texture ");
 
-    if (NULL == _texture.get ()) {
+    if (NULL == _texture.get () || !buffer.ptr ()) {
         return XCAM_RETURN_ERROR_PARAM;
     }
 
-    {
-        SmartLock locker (_mutex);
+    SmartLock locker (_mutex);
 
-        VideoBufferInfo info = buffer->get_video_info ();
-        uint32_t image_width = info.width;
-        uint32_t image_height = info.height;
+#if HAVE_GLES
+    if (_dma_enabled && buffer->get_fd () >= 0 &&
+            (!_texture->_dma_source.valid () || !_texture->_dma_source->is_failed ())) {
+        return update_texture_dma (buffer);
+    }
+#endif
 
-        osg::ref_ptr<osg::Image> image_y = new osg::Image ();
-        osg::ref_ptr<osg::Image> image_uv = new osg::Image ();
+    return update_texture_copy (buffer);
+}
 
-        uint8_t* image_buffer = buffer->map ();
+bool
+RenderOsgModel::latch_buffer ()
+{
+    SmartPtr<VideoBuffer> buffer = _mailbox.take_latest ();
+    if (!buffer.ptr ())
+        return false;
 
-        uint8_t* src_y = image_buffer;
-        uint8_t* src_uv = image_buffer + image_width * image_height;
+    return (update_texture (buffer) == XCAM_RETURN_NO_ERROR);
+}
 
-        image_y->setImage (image_width, image_height, 1,
-                           GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-                           src_y, osg::Image::NO_DELETE);
+XCamReturn
+RenderOsgModel::update_texture_dma (SmartPtr<VideoBuffer> &buffer)
+{
+#if HAVE_GLES
+    if (!_texture->_dma_source.valid ()) {
+        if (!EGLDmaImage::is_supported ()) {
+            XCAM_LOG_INFO ("render dma-buf import not supported, textures copied");
+            _dma_enabled = false;
+            return update_texture_copy (buffer);
+        }
+
+        _texture->_dma_source = new DmaNV12Source ();
+        _texture->_dma_texture_y = new DmaNV12Texture (_texture->_dma_source.get (), 0);
+        _texture->_dma_texture_uv = new DmaNV12Texture (_texture->_dma_source.get (), 1);
+    }
 
-        image_uv->setImage (image_width / 2, image_height / 2, 1,
-                            GL_LUMINANCE, GL_RG, GL_UNSIGNED_BYTE,
-                            src_uv, osg::Image::NO_DELETE);
+    _texture->_dma_source->set_buffer (buffer);
+    if (!_texture->_dma_bound) {
+        bind_textures (_texture->_dma_texture_y.get (), _texture->_dma_texture_uv.get ());
+        _texture->_dma_bound = true;
+        if (_texture->_mapped_buffer.ptr ()) {
+            _texture->_mapped_buffer->unmap ();
+            _texture->_mapped_buffer.release ();
+        }
+    }
 
-        _texture->_texture_y->setImage (image_y);
-        _texture->_texture_uv->setImage (image_uv);
+    return XCAM_RETURN_NO_ERROR;
+#else
+    return update_texture_copy (buffer);
+#endif
+}
 
-        buffer->unmap ();
+XCamReturn
+RenderOsgModel::update_texture_copy (SmartPtr<VideoBuffer> &buffer)
+{
+#if HAVE_GLES
+    if (_texture->_dma_bound) {
+        bind_textures (_texture->_texture_y.get (), _texture->_texture_uv.get ());
+        _texture->_dma_bound = false;
     }
+#endif
 
-    return result;
+    const VideoBufferInfo &info = buffer->get_video_info ();
+    uint32_t image_width = info.width;
+    uint32_t image_height = info.height;
+
+    uint8_t* image_buffer = buffer->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, image_buffer, XCAM_RETURN_ERROR_MEM,
+        "RenderOsgModel map buffer failed");
+
+    osg::ref_ptr<osg::Image> image_y = new osg::Image ();
+    osg::ref_ptr<osg::Image> image_uv = new osg::Image ();
+
+    uint8_t* src_y = image_buffer + info.offsets[0];
+    uint8_t* src_uv = image_buffer + info.offsets[1];
+
+    image_y->setImage (image_width, image_height, 1,
+                       GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                       src_y, osg::Image::NO_DELETE);
+    image_y->setRowLength (info.strides[0]);
+
+    image_uv->setImage (image_width / 2, image_height / 2, 1,
+                        GL_LUMINANCE, GL_RG, GL_UNSIGNED_BYTE,
+                        src_uv, osg::Image::NO_DELETE);
+    image_uv->setRowLength (info.strides[1] / 2);
+
+    _texture->_texture_y->setImage (image_y);
+    _texture->_texture_uv->setImage (image_uv);
+
+    // images point into mapped memory, unmap the buffer they replaced
+    if (_texture->_mapped_buffer.ptr () && _texture->_mapped_buffer.ptr () != buffer.ptr ())
+        _texture->_mapped_buffer->unmap ();
+    _texture->_mapped_buffer = buffer;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+RenderOsgModel::bind_textures (osg::Texture2D *texture_y, osg::Texture2D *texture_uv)
+{
+    osg::ref_ptr<osg::Group> model = get_model ();
+    XCAM_ASSERT (model.get ());
+
+    model->getOrCreateStateSet ()->setTextureAttribute (0, texture_y);
+    model->getOrCreateStateSet ()->setTextureAttribute (1, texture_uv);
 }
 
 NV12Texture*
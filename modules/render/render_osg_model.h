@@ -27,9 +27,73 @@
 #include <interface/data_types.h>
 #include <interface/stitcher.h>
 #include <xcam_mutex.h>
+#include <video_buffer.h>
+#include <triple_buffer.h>
+#include <map>
 
 namespace XCam {
 
+#if HAVE_GLES
+struct EGLDmaNV12Image;
+
+/*
+ * latest dma-buf of NV12 textures, imported through EGL in draw thread.
+ * imports are cached by fd, so pooled buffers are imported once.
+ */
+class DmaNV12Source : public osg::Referenced
+{
+    typedef std::map<int, EGLDmaNV12Image *> ImageMap;
+
+public:
+    explicit DmaNV12Source ();
+
+    // any thread
+    void set_buffer (const SmartPtr<VideoBuffer> &buf);
+    bool is_failed () const {
+        return _failed;
+    }
+
+    // draw thread, latches latest buffer once per frame
+    uint32_t get_texture (uint32_t plane, uint32_t frame_number);
+
+protected:
+    virtual ~DmaNV12Source ();
+
+private:
+    EGLDmaNV12Image *import_buffer (const SmartPtr<VideoBuffer> &buf);
+    void clear_images ();
+
+private:
+    Mutex                      _mutex;
+    SmartPtr<VideoBuffer>      _pending;
+    SmartPtr<VideoBuffer>      _current;
+    SmartPtr<VideoBuffer>      _previous;
+    EGLDmaNV12Image           *_current_image;
+    ImageMap                   _images;
+    uint32_t                   _frame_number;
+    bool                       _latched;
+    volatile bool              _failed;
+};
+
+// binds one plane of DmaNV12Source instead of uploading an image
+class DmaNV12Texture : public osg::Texture2D
+{
+public:
+    explicit DmaNV12Texture (DmaNV12Source *source, uint32_t plane)
+        : _source (source)
+        , _plane (plane)
+    {}
+
+    virtual void apply (osg::State &state) const;
+
+private:
+    osg::ref_ptr<DmaNV12Source>    _source;
+    uint32_t                       _plane;
+};
+#endif
+
+class NV12Texture : public osg::Referenced
+
 class NV12Texture : public osg::Referenced
 {
 public:
@@ -37,6 +101,9 @@ public:
     {
         _image_width = width;
         _image_height = height;
+#if HAVE_GLES
+        _dma_bound = false;
+#endif
     }
 
 public:
@@ -48,6 +115,16 @@ public:
 
     osg::ref_ptr<osg::Uniform> _uniform_y;
     osg::ref_ptr<osg::Uniform> _uniform_uv;
+
+    // keeps mapped memory of images alive till next update
+    SmartPtr<VideoBuffer> _mapped_buffer;
+
+#if HAVE_GLES
+    osg::ref_ptr<DmaNV12Source> _dma_source;
+    osg::ref_ptr<osg::Texture2D> _dma_texture_y;
+    osg::ref_ptr<osg::Texture2D> _dma_texture_uv;
+    bool _dma_bound;
+#endif
 };
 
 class RenderOsgModel {
@@ -99,9 +176,29 @@ public:
         float rotation_z,
         float rotation_degrees);
 
+    // buffers with dma fd are sampled in place if EGL supports dma-buf import
     XCamReturn update_texture (SmartPtr<VideoBuffer> &buffer);
+    void enable_dma_texture (bool enable) {
+        _dma_enabled = enable;
+    }
+
+    /*
+     * latest frame mailbox, decouples render rate from producer rate.
+     * post_buffer from one producer thread, a frame replaced before render took it is released at once.
+     * latch_buffer in render thread, updates texture with the newest frame, false if none since last call.
+     */
+    void post_buffer (const SmartPtr<VideoBuffer> &buffer) {
+        _mailbox.put (buffer);
+    }
+    bool latch_buffer ();
+    uint64_t get_skipped_count () const {
+        return _mailbox.get_dropped_count ();
+    }
 
 private:
+    XCamReturn update_texture_dma (SmartPtr<VideoBuffer> &buffer);
+    XCamReturn update_texture_copy (SmartPtr<VideoBuffer> &buffer);
+    void bind_textures (osg::Texture2D *texture_y, osg::Texture2D *texture_uv);
 
     NV12Texture* create_texture (uint32_t width, uint32_t height);
     XCamReturn add_texture (osg::ref_ptr<NV12Texture> &texture);
@@ -114,6 +211,8 @@ private:
     osg::ref_ptr<osg::Geode> _geode;
     osg::ref_ptr<osg::Program> _program;
     osg::ref_ptr<NV12Texture> _texture;
+    bool _dma_enabled;
+    TripleBuffer<VideoBuffer> _mailbox;
 
     Mutex _mutex;
 };
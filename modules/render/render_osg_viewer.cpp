@@ -26,6 +26,25 @@
 
 namespace XCam {
 
+class RenderThread
+    : public Thread
+{
+public:
+    explicit RenderThread (RenderOsgViewer *viewer)
+        : Thread ("RenderThread")
+        , _viewer (viewer)
+    {}
+
+protected:
+    virtual bool loop () {
+        _viewer->start_render ();
+        return !_viewer->is_done ();
+    }
+
+private:
+    RenderOsgViewer *_viewer;
+};
+
 RenderOsgViewer::RenderOsgViewer ()
     : _viewer (NULL)
     , _model_groups (NULL)
@@ -40,6 +59,7 @@ RenderOsgViewer::RenderOsgViewer ()
 
 RenderOsgViewer::~RenderOsgViewer ()
 {
+    stop_render_thread ();
     _viewer->setDone (true);
 }
 
@@ -93,6 +113,7 @@ RenderOsgViewer::add_model (SmartPtr<RenderOsgModel> &model)
         return;
     }
 
+    _models.push_back (model);
     if (!_model_groups.ptr ()) {
         _model_groups = model;
     } else {
@@ -114,8 +135,44 @@ RenderOsgViewer::start_render ()
 {
     if (!_viewer->done ())
     {
+        for (uint32_t i = 0; i < _models.size (); ++i)
+            _models[i]->latch_buffer ();
+
         _viewer->frame ();
     }
 }
 
+bool
+RenderOsgViewer::start_render_thread ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_render_thread.ptr (), false,
+        "RenderOsgViewer render thread already started");
+
+    _render_thread = new RenderThread (this);
+    if (!_render_thread->start ()) {
+        XCAM_LOG_ERROR ("RenderOsgViewer start render thread failed");
+        _render_thread.release ();
+        return false;
+    }
+    return true;
+}
+
+void
+RenderOsgViewer::stop_render_thread ()
+{
+    if (!_render_thread.ptr ())
+        return;
+
+    _render_thread->stop ();
+    _render_thread.release ();
+
+    for (uint32_t i = 0; i < _models.size (); ++i) {
+        if (_models[i]->get_skipped_count ())
+            XCAM_LOG_DEBUG (
+                "render model(%s) skipped %" PRIu64 " frames",
+                XCAM_STR (_models[i]->get_name ()), _models[i]->get_skipped_count ());
+    }
+}
+
 } // namespace XCam
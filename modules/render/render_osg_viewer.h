@@ -28,10 +28,13 @@
 #include <interface/data_types.h>
 #include <interface/stitcher.h>
 #include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <vector>
 
 namespace XCam {
 
 class RenderOsgModel;
+class RenderThread;
 
 class RenderOsgViewer {
 public:
@@ -50,14 +53,28 @@ public:
 
     void validate_model_groups ();
 
+    // renders one frame on latest frames posted to models
     void start_render ();
 
+    /*
+     * renders in own thread till stop_render_thread or the window is closed,
+     * frames are paced by swap at display vsync, not by producers.
+     * views are realized in that thread, start_render is not called meanwhile.
+     */
+    bool start_render_thread ();
+    void stop_render_thread ();
+    bool is_done () {
+        return _viewer->done ();
+    }
+
 private:
     XCamReturn initialize ();
 
 private:
     osg::ref_ptr<osgViewer::Viewer> _viewer;
     SmartPtr<RenderOsgModel> _model_groups;
+    std::vector<SmartPtr<RenderOsgModel> > _models;
+    SmartPtr<RenderThread> _render_thread;
     bool _initialized;
 };
 
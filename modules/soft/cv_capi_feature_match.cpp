@@ -49,15 +49,29 @@ CVCapiFeatureMatch::get_crop_image (
     uint8_t* image_buffer = buffer->map();
     int offset = info.strides[NV12PlaneYIdx] * crop_rect.pos_y + crop_rect.pos_x;
 
-    crop_image.resize (crop_rect.width * crop_rect.height);
-    for (int i = 0; i < crop_rect.height; i++) {
-        for (int j = 0; j < crop_rect.width; j++) {
-            crop_image[i * crop_rect.width + j] =
-                image_buffer[offset + i * info.strides[NV12PlaneYIdx] + j];
+    // box filter decimation folded into the crop copy
+    int scale = 1 << _config.scale_level;
+    int width = crop_rect.width / scale;
+    int height = crop_rect.height / scale;
+    XCAM_FAIL_RETURN (
+        ERROR, width > 0 && height > 0, false,
+        "FeatureMatch(idx:%d): crop(%dx%d) too small for scale level:%d",
+        _fm_idx, crop_rect.width, crop_rect.height, _config.scale_level);
+
+    crop_image.resize (width * height);
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            const uint8_t *src = image_buffer + offset + i * scale * info.strides[NV12PlaneYIdx] + j * scale;
+            int sum = 0;
+            for (int y = 0; y < scale; y++) {
+                for (int x = 0; x < scale; x++)
+                    sum += src[y * info.strides[NV12PlaneYIdx] + x];
+            }
+            crop_image[i * width + j] = sum / (scale * scale);
         }
     }
 
-    img = cvMat (crop_rect.height, crop_rect.width, CV_8UC1, (void*)&crop_image[0]);
+    img = cvMat (height, width, CV_8UC1, (void*)&crop_image[0]);
 
     return true;
 }
@@ -94,6 +108,7 @@ CVCapiFeatureMatch::get_valid_offsets (
 {
     count = 0;
     sum = 0.0f;
+    float scale = (float)(1 << _config.scale_level);
 
     for (uint32_t i = 0; i < status.size (); ++i) {
         if (!status[i])
@@ -106,12 +121,12 @@ CVCapiFeatureMatch::get_valid_offsets (
 #endif
         if (error[i] > _config.max_track_error)
             continue;
-        if (fabs(corner0[i].y - corner1[i].y) >= _config.max_valid_offset_y)
+        if (fabs(corner0[i].y - corner1[i].y) * scale >= _config.max_valid_offset_y)
             continue;
         if (corner1[i].x < 0.0f || corner1[i].x > img0_size.width)
             continue;
 
-        float offset = corner1[i].x - corner0[i].x;
+        float offset = (corner1[i].x - corner0[i].x) * scale;
         sum += offset;
         ++count;
         offsets.push_back (offset);
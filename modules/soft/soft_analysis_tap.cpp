@@ -0,0 +1,287 @@
+/*
+ * soft_analysis_tap.cpp - downscaled analysis buffers shared by consumers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_analysis_tap.h"
+#include "soft_image.h"
+#include "soft_video_buf_allocator.h"
+
+namespace XCam {
+
+static void
+scale_plane (
+    const uint8_t *src, uint32_t src_pitch, uint32_t src_w, uint32_t src_h,
+    uint8_t *dst, uint32_t dst_pitch, uint32_t dst_w, uint32_t dst_h, uint32_t channels)
+{
+    if (channels == 1 && src_w / 2 == dst_w && src_h / 2 == dst_h) {
+        for (uint32_t y = 0; y < dst_h; ++y) {
+            const uint8_t *row0 = src + 2 * y * src_pitch;
+            soft_simd_half_uchar (row0, row0 + src_pitch, dst_w, dst + y * dst_pitch);
+        }
+        return;
+    }
+
+    // box average, boxes cover the source without overlap and hold 1 pixel at least
+    for (uint32_t y = 0; y < dst_h; ++y) {
+        uint32_t y0 = y * src_h / dst_h;
+        uint32_t y1 = XCAM_MAX ((y + 1) * src_h / dst_h, y0 + 1);
+        uint8_t *out = dst + y * dst_pitch;
+
+        for (uint32_t x = 0; x < dst_w; ++x) {
+            uint32_t x0 = x * src_w / dst_w;
+            uint32_t x1 = XCAM_MAX ((x + 1) * src_w / dst_w, x0 + 1);
+            uint32_t count = (y1 - y0) * (x1 - x0);
+
+            for (uint32_t c = 0; c < channels; ++c) {
+                uint32_t sum = 0;
+                for (uint32_t sy = y0; sy < y1; ++sy) {
+                    const uint8_t *in = src + sy * src_pitch + c;
+                    for (uint32_t sx = x0; sx < x1; ++sx)
+                        sum += in[sx * channels];
+                }
+                out[x * channels + c] = (uint8_t)((sum + count / 2) / count);
+            }
+        }
+    }
+}
+
+static inline uint8_t
+clamp_uchar (int32_t v)
+{
+    return (uint8_t)XCAM_CLAMP (v, 0, 255);
+}
+
+// BT.601 limited range, uv is subsampled by 2 in both directions
+static void
+convert_to_rgb24 (
+    const uint8_t *y_plane, const uint8_t *uv_plane, uint32_t width, uint32_t height,
+    uint8_t *dst, uint32_t dst_pitch)
+{
+    uint32_t uv_pitch = (width + 1) / 2 * 2;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t *luma = y_plane + y * width;
+        const uint8_t *uv = uv_plane + (y / 2) * uv_pitch;
+        uint8_t *out = dst + y * dst_pitch;
+
+        for (uint32_t x = 0; x < width; ++x) {
+            int32_t c = 298 * ((int32_t)luma[x] - 16) + 128;
+            int32_t d = (int32_t)uv[x / 2 * 2] - 128;
+            int32_t e = (int32_t)uv[x / 2 * 2 + 1] - 128;
+            out[3 * x] = clamp_uchar ((c + 409 * e) >> 8);
+            out[3 * x + 1] = clamp_uchar ((c - 100 * d - 208 * e) >> 8);
+            out[3 * x + 2] = clamp_uchar ((c + 516 * d) >> 8);
+        }
+    }
+}
+
+SoftAnalysisTap::SoftAnalysisTap (const char *name)
+    : _name (NULL)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+SoftAnalysisTap::~SoftAnalysisTap ()
+{
+    _outputs.clear ();
+    xcam_free (_name);
+}
+
+int32_t
+SoftAnalysisTap::add_output (uint32_t format, uint32_t width, uint32_t height, uint32_t buf_count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR,
+        format == V4L2_PIX_FMT_GREY || format == V4L2_PIX_FMT_NV12 || format == V4L2_PIX_FMT_RGB24,
+        -1,
+        "analysis tap(%s) output format(%s) unsupported", XCAM_STR (_name), xcam_fourcc_to_string (format));
+    XCAM_FAIL_RETURN (
+        ERROR,
+        width && height && buf_count && _outputs.size () < XCAM_SOFT_TAP_MAX_OUTPUTS &&
+        (format != V4L2_PIX_FMT_NV12 || (width % 2 == 0 && height % 2 == 0)),
+        -1,
+        "analysis tap(%s) add output(w:%d, h:%d, bufs:%d) failed, invalid params or too many outputs",
+        XCAM_STR (_name), width, height, buf_count);
+
+    VideoBufferInfo info;
+    info.init (format, width, height);
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (pool->reserve (buf_count)), -1,
+        "analysis tap(%s) reserve %d buffers(w:%d, h:%d) failed", XCAM_STR (_name), buf_count, width, height);
+
+    Output output;
+    output.format = format;
+    output.width = width;
+    output.height = height;
+    output.pool = pool;
+    if (format == V4L2_PIX_FMT_RGB24) {
+        output.scratch_y.resize (width * height);
+        output.scratch_uv.resize ((width + 1) / 2 * (height + 1) / 2 * 2);
+    }
+    _outputs.push_back (output);
+
+    XCAM_LOG_INFO (
+        "analysis tap(%s) output:%d %s(w:%d, h:%d)", XCAM_STR (_name),
+        (int32_t)_outputs.size () - 1, xcam_fourcc_to_string (format), width, height);
+    return (int32_t)_outputs.size () - 1;
+}
+
+bool
+SoftAnalysisTap::add_consumer (uint32_t index, StatsCallback *consumer)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _outputs.size () && consumer, false,
+        "analysis tap(%s) add consumer to output:%d failed", XCAM_STR (_name), index);
+
+    _outputs[index].consumers.push_back (consumer);
+    return true;
+}
+
+SmartPtr<VideoBuffer>
+SoftAnalysisTap::get_latest (uint32_t index) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _outputs.size (), NULL,
+        "analysis tap(%s) output:%d out of range", XCAM_STR (_name), index);
+
+    return _outputs[index].latest;
+}
+
+XCamReturn
+SoftAnalysisTap::produce_output (Output &output, const SmartPtr<VideoBuffer> &in, const uint8_t *in_mem)
+{
+    // consumers still hold all buffers, skip this frame rather than stall the pipeline
+    SmartPtr<VideoBuffer> buf = output.pool->try_get_buffer ();
+    if (!buf.ptr ()) {
+        XCAM_LOG_DEBUG (
+            "analysis tap(%s) output(w:%d, h:%d) has no free buffer, skip frame",
+            XCAM_STR (_name), output.width, output.height);
+        output.latest.release ();
+        return XCAM_RETURN_BYPASS;
+    }
+
+    const VideoBufferInfo &in_info = in->get_video_info ();
+    const VideoBufferInfo &out_info = buf->get_video_info ();
+    bool in_nv12 = (in_info.format == V4L2_PIX_FMT_NV12);
+    const uint8_t *in_y = in_mem + in_info.offsets[0];
+    const uint8_t *in_uv = in_nv12 ? in_mem + in_info.offsets[1] : NULL;
+    uint32_t uv_w = (output.width + 1) / 2;
+    uint32_t uv_h = (output.height + 1) / 2;
+
+    uint8_t *out_mem = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, out_mem, XCAM_RETURN_ERROR_MEM,
+        "analysis tap(%s) map output buffer failed", XCAM_STR (_name));
+
+    switch (output.format) {
+    case V4L2_PIX_FMT_GREY:
+        scale_plane (
+            in_y, in_info.strides[0], in_info.width, in_info.height,
+            out_mem + out_info.offsets[0], out_info.strides[0], output.width, output.height, 1);
+        break;
+    case V4L2_PIX_FMT_NV12:
+        scale_plane (
+            in_y, in_info.strides[0], in_info.width, in_info.height,
+            out_mem + out_info.offsets[0], out_info.strides[0], output.width, output.height, 1);
+        scale_plane (
+            in_uv, in_info.strides[1], in_info.width / 2, in_info.height / 2,
+            out_mem + out_info.offsets[1], out_info.strides[1], uv_w, uv_h, 2);
+        break;
+    case V4L2_PIX_FMT_RGB24:
+        scale_plane (
+            in_y, in_info.strides[0], in_info.width, in_info.height,
+            output.scratch_y.data (), output.width, output.width, output.height, 1);
+        if (in_nv12)
+            scale_plane (
+                in_uv, in_info.strides[1], in_info.width / 2, in_info.height / 2,
+                output.scratch_uv.data (), uv_w * 2, uv_w, uv_h, 2);
+        else
+            memset (output.scratch_uv.data (), 128, output.scratch_uv.size ());
+        convert_to_rgb24 (
+            output.scratch_y.data (), output.scratch_uv.data (), output.width, output.height,
+            out_mem + out_info.offsets[0], out_info.strides[0]);
+        break;
+    default:
+        XCAM_ASSERT (false);
+        break;
+    }
+
+    buf->unmap ();
+    buf->set_timestamp (in->get_timestamp ());
+    output.latest = buf;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftAnalysisTap::process (const SmartPtr<VideoBuffer> &in)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, in.ptr () && !_outputs.empty (), XCAM_RETURN_ERROR_PARAM,
+        "analysis tap(%s) process failed, %s", XCAM_STR (_name), (in.ptr () ? "no output" : "input is NULL"));
+
+    const VideoBufferInfo &in_info = in->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12 || in_info.format == V4L2_PIX_FMT_GREY,
+        XCAM_RETURN_ERROR_PARAM,
+        "analysis tap(%s) input format(%s) unsupported", XCAM_STR (_name), xcam_fourcc_to_string (in_info.format));
+
+    for (uint32_t i = 0; i < _outputs.size (); ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, _outputs[i].format != V4L2_PIX_FMT_NV12 || in_info.format == V4L2_PIX_FMT_NV12,
+            XCAM_RETURN_ERROR_PARAM,
+            "analysis tap(%s) output:%d needs NV12 input", XCAM_STR (_name), i);
+    }
+
+    const uint8_t *in_mem = in->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_mem, XCAM_RETURN_ERROR_MEM,
+        "analysis tap(%s) map input buffer failed", XCAM_STR (_name));
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < _outputs.size (); ++i) {
+        ret = produce_output (_outputs[i], in, in_mem);
+        if (!xcam_ret_is_ok (ret))
+            break;
+    }
+    in->unmap ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "analysis tap(%s) produce outputs failed", XCAM_STR (_name));
+
+    // input is released by now, slow consumers don't hold its mapping
+    for (uint32_t i = 0; i < _outputs.size (); ++i) {
+        Output &output = _outputs[i];
+        if (!output.latest.ptr ())
+            continue;
+
+        for (uint32_t c = 0; c < output.consumers.size (); ++c) {
+            ret = output.consumers[c]->scaled_image_ready (output.latest);
+            if (!xcam_ret_is_ok (ret)) {
+                XCAM_LOG_WARNING (
+                    "analysis tap(%s) consumer:%d of output:%d failed", XCAM_STR (_name), c, i);
+            }
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,91 @@
+/*
+ * soft_analysis_tap.h - downscaled analysis buffers shared by consumers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_ANALYSIS_TAP_H
+#define XCAM_SOFT_ANALYSIS_TAP_H
+
+#include <xcam_std.h>
+#include <buffer_pool.h>
+#include <stats_callback_interface.h>
+#include <vector>
+
+#define XCAM_SOFT_TAP_DEFAULT_BUFS 4
+#define XCAM_SOFT_TAP_MAX_OUTPUTS 8
+
+namespace XCam {
+
+/*
+ * SoftAnalysisTap, scales each input frame once per configured output,
+ * outputs are V4L2_PIX_FMT_GREY, V4L2_PIX_FMT_NV12 or V4L2_PIX_FMT_RGB24.
+ * every consumer of an output gets the same buffer through scaled_image_ready,
+ * so consumers must not write it; a consumer holding buffers asynchronously
+ * (e.g. smart analyzer) needs enough buffers in the output pool.
+ * input is NV12 or GREY, exact 2x reduction of luma runs SIMD kernels,
+ * other ratios use box average.
+ */
+class SoftAnalysisTap
+{
+    struct Output {
+        uint32_t                        format;
+        uint32_t                        width;
+        uint32_t                        height;
+        SmartPtr<BufferPool>            pool;
+        std::vector<StatsCallback *>    consumers;
+        std::vector<uint8_t>            scratch_y;
+        std::vector<uint8_t>            scratch_uv;
+        SmartPtr<VideoBuffer>           latest;
+
+        Output () : format (0), width (0), height (0) {}
+    };
+
+public:
+    explicit SoftAnalysisTap (const char *name = "SoftAnalysisTap");
+    ~SoftAnalysisTap ();
+
+    const char *get_name () const {
+        return _name;
+    }
+
+    // return output index, -1 on failure; NV12 output needs even width and height
+    int32_t add_output (
+        uint32_t format, uint32_t width, uint32_t height,
+        uint32_t buf_count = XCAM_SOFT_TAP_DEFAULT_BUFS);
+    bool add_consumer (uint32_t index, StatsCallback *consumer);
+    uint32_t get_output_count () const {
+        return _outputs.size ();
+    }
+
+    XCamReturn process (const SmartPtr<VideoBuffer> &in);
+    // last buffer produced by output @index, NULL before first process
+    SmartPtr<VideoBuffer> get_latest (uint32_t index) const;
+
+private:
+    XCamReturn produce_output (Output &output, const SmartPtr<VideoBuffer> &in, const uint8_t *in_mem);
+
+    XCAM_DEAD_COPY (SoftAnalysisTap);
+
+private:
+    char                   *_name;
+    std::vector<Output>     _outputs;
+};
+
+}
+
+#endif //XCAM_SOFT_ANALYSIS_TAP_H
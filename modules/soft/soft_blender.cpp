@@ -26,12 +26,16 @@
 #include "image_file_handle.h"
 #include "soft_video_buf_allocator.h"
 #include <map>
+#include <atomic>
 
 #define OVERLAP_POOL_SIZE 6
 #define LAP_POOL_SIZE 4
 
 #define DUMP_BLENDER 0
 
+// gauss level seam is searched on
+#define SEAM_DIFF_LEVEL 1
+
 namespace XCam {
 
 using namespace XCamSoftTasks;
@@ -40,18 +44,32 @@ DECLARE_WORK_CALLBACK (CbGaussDownScale, SoftBlender, gauss_scale_done);
 DECLARE_WORK_CALLBACK (CbBlendTask, SoftBlender, blend_task_done);
 DECLARE_WORK_CALLBACK (CbReconstructTask, SoftBlender, reconstruct_done);
 DECLARE_WORK_CALLBACK (CbLapTask, SoftBlender, lap_done);
+DECLARE_WORK_CALLBACK (CbSeamDiffTask, SoftBlender, seam_diff_done);
+
+namespace SoftBlenderPriv {
+
+// masks never change once published, a frame keeps the set it starts with
+struct BlendMasks {
+    SmartPtr<UcharImage>       orig;
+    SmartPtr<UcharImage>       coef[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+};
+
+};
 
 typedef std::map<void*, SmartPtr<BlendTask::Args>> MapBlendArgs;
 typedef std::map<void*, SmartPtr<ReconstructTask::Args>> MapReconsArgs;
+typedef std::map<void*, SmartPtr<SeamDiffTask::Args>> MapSeamArgs;
+typedef std::map<void*, SmartPtr<SoftBlenderPriv::BlendMasks>> MapFrameMasks;
 
 namespace SoftBlenderPriv {
 
 struct PyramidResource {
     SmartPtr<BufferPool>       overlap_pool;
+    // int16 laplace levels of this level size
+    SmartPtr<BufferPool>       lap_pool;
     SmartPtr<GaussDownScale>   scale_task[SoftBlender::BufIdxCount];
     SmartPtr<LaplaceTask>      lap_task[SoftBlender::BufIdxCount];
     SmartPtr<ReconstructTask>  recon_task;
-    SmartPtr<UcharImage>       coef_mask;
     MapReconsArgs              recons_args;
 };
 
@@ -65,18 +83,27 @@ blend[N] = blend (Ga[N)], Gb[N)])
  Level1: reconst[1] = reconstruct (reconst[2], LapA[1], LapB[1])
  Level0: output = reconstruct (reconst[1], LapA[0], LapB[0])
 
- LevelN: Pool[N].size = G[N].size
+ LevelN: Pool[N].size = G[N].size, LapPool[N].size = G[N-1].size
  */
 class BlenderPrivConfig {
 public:
     PyramidResource        pyr_layer[XCAM_SOFT_PYRAMID_MAX_LEVEL];
     uint32_t               pyr_levels;
+    std::atomic<uint32_t>  active_levels;
+    uint32_t               pipe_depth;
     SmartPtr<BlendTask>    last_level_blend;
-    SmartPtr<BufferPool>   first_lap_pool;
-    SmartPtr<UcharImage>   orig_mask;
 
     Mutex                  map_args_mutex;
     MapBlendArgs           blend_args;
+    SmartPtr<BlendMasks>   masks;
+    MapFrameMasks          frame_masks;
+
+    bool                   seam_enable;
+    uint32_t               seam_interval;
+    uint32_t               seam_frame_count;
+    std::atomic<bool>      seam_busy;
+    SmartPtr<SeamDiffTask> seam_diff_task;
+    MapSeamArgs            seam_args;
 
 private:
     SoftBlender           *_blender;
@@ -84,11 +111,26 @@ private:
 public:
     BlenderPrivConfig (SoftBlender *blender, uint32_t level)
         : pyr_levels (level)
+        , active_levels (level)
+        , pipe_depth (1)
+        , seam_enable (false)
+        , seam_interval (XCAM_SOFT_SEAM_UPDATE_INTERVAL)
+        , seam_frame_count (0)
+        , seam_busy (false)
         , _blender (blender)
     {}
 
     XCamReturn init_first_masks (uint32_t width, uint32_t height);
-    XCamReturn scale_down_masks (uint32_t level, uint32_t width, uint32_t height);
+    XCamReturn scale_down_masks (
+        const SmartPtr<BlendMasks> &level_masks, uint32_t level, uint32_t width, uint32_t height);
+    SmartPtr<BlendMasks> get_frame_masks (const SmartPtr<ImageHandler::Parameters> &param, bool last_use);
+
+    bool check_seam_update ();
+    XCamReturn start_seam_diff (
+        const SmartPtr<ImageHandler::Parameters> &param,
+        const SmartPtr<VideoBuffer> &gauss,
+        const uint32_t level, const SoftBlender::BufIdx idx);
+    XCamReturn update_seam_masks (const SmartPtr<UcharImage> &diff, const uint32_t level);
 
     XCamReturn start_scaler (
         const SmartPtr<ImageHandler::Parameters> &param,
@@ -103,6 +145,7 @@ public:
         const SmartPtr<ImageHandler::Parameters> &param,
         const SmartPtr<VideoBuffer> &buf,
         const SoftBlender::BufIdx idx);
+    XCamReturn start_feather_blend (const SmartPtr<SoftBlender::BlenderParam> &param);
 
     XCamReturn start_reconstruct_task_by_lap (
         const SmartPtr<ImageHandler::Parameters> &param,
@@ -118,6 +161,14 @@ public:
 
 };
 
+static uint32_t
+get_frame_levels (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    SmartPtr<SoftBlender::BlenderParam> blend_param = param.dynamic_cast_ptr<SoftBlender::BlenderParam> ();
+    XCAM_ASSERT (blend_param.ptr () && blend_param->pyr_levels);
+    return blend_param->pyr_levels;
+}
+
 #if DUMP_BLENDER
 #define dump_buf dump_buf_perfix_path
 
@@ -167,6 +218,31 @@ static void dump_level_buf (const SmartPtr<VideoBuffer> buf, ...) {
 }
 #endif
 
+// level 0 uses all pyramid levels, each level up drops the coarsest one
+class PyrLevelsKnob
+    : public QualityKnob
+{
+public:
+    explicit PyrLevelsKnob (SoftBlender *blender)
+        : QualityKnob ("pyr-levels")
+        , _blender (blender)
+    {}
+
+    virtual uint32_t get_level_count () const {
+        return _blender->get_pyr_levels ();
+    }
+    virtual uint32_t get_level () const {
+        return _blender->get_pyr_levels () - _blender->get_active_pyr_levels ();
+    }
+    virtual bool set_level (uint32_t level) {
+        uint32_t count = _blender->get_pyr_levels ();
+        return level < count && _blender->set_active_pyr_levels (count - level);
+    }
+
+private:
+    SoftBlender    *_blender;
+};
+
 SoftBlender::SoftBlender (const char *name)
     : SoftHandler (name)
     , Blender (SOFT_BLENDER_ALIGNMENT_X, SOFT_BLENDER_ALIGNMENT_Y)
@@ -175,6 +251,8 @@ SoftBlender::SoftBlender (const char *name)
         new SoftBlenderPriv::BlenderPrivConfig (this, XCAM_SOFT_PYRAMID_DEFAULT_LEVEL);
     XCAM_ASSERT (config.ptr ());
     _priv_config = config;
+
+    add_quality_knob (new PyrLevelsKnob (this));
 }
 
 SoftBlender::~SoftBlender ()
@@ -190,6 +268,54 @@ SoftBlender::set_pyr_levels (uint32_t num)
         "blender:%s set_pyr_levels failed, level(%d) must > 0", XCAM_STR (get_name ()), num);
 
     _priv_config->pyr_levels = num;
+    _priv_config->active_levels = num;
+    return true;
+}
+
+uint32_t
+SoftBlender::get_pyr_levels () const
+{
+    return _priv_config->pyr_levels;
+}
+
+bool
+SoftBlender::set_active_pyr_levels (uint32_t num)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, num > 0 && num <= _priv_config->pyr_levels, false,
+        "blender:%s set_active_pyr_levels failed, level(%d) out of [1, %d]",
+        XCAM_STR (get_name ()), num, _priv_config->pyr_levels);
+
+    _priv_config->active_levels = num;
+    return true;
+}
+
+uint32_t
+SoftBlender::get_active_pyr_levels () const
+{
+    return _priv_config->active_levels;
+}
+
+bool
+SoftBlender::set_pipeline_depth (uint32_t depth)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, depth > 0, false,
+        "blender:%s set_pipeline_depth failed, depth(%d) must > 0", XCAM_STR (get_name ()), depth);
+
+    _priv_config->pipe_depth = depth;
+    return true;
+}
+
+bool
+SoftBlender::set_seam_mode (bool enable, uint32_t interval)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, interval > 0, false,
+        "blender:%s set_seam_mode failed, interval(%d) must > 0", XCAM_STR (get_name ()), interval);
+
+    _priv_config->seam_enable = enable;
+    _priv_config->seam_interval = interval;
     return true;
 }
 
@@ -242,12 +368,19 @@ SoftBlenderPriv::BlenderPrivConfig::stop ()
         if (pyr_layer[i].overlap_pool.ptr ()) {
             pyr_layer[i].overlap_pool->stop ();
         }
+        if (pyr_layer[i].lap_pool.ptr ()) {
+            pyr_layer[i].lap_pool->stop ();
+        }
     }
 
     if (last_level_blend.ptr ()) {
         last_level_blend->stop ();
         last_level_blend.release ();
     }
+    if (seam_diff_task.ptr ()) {
+        seam_diff_task->stop ();
+        seam_diff_task.release ();
+    }
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -256,7 +389,7 @@ SoftBlenderPriv::BlenderPrivConfig::init_first_masks (uint32_t width, uint32_t h
 {
     uint32_t aligned_width = XCAM_ALIGN_UP (width, SOFT_BLENDER_ALIGNMENT_X);
 
-    orig_mask = new UcharImage (
+    SmartPtr<UcharImage> orig_mask = new UcharImage (
         width, height, aligned_width);
     XCAM_ASSERT (orig_mask.ptr ());
     XCAM_ASSERT (orig_mask->is_valid ());
@@ -292,35 +425,206 @@ SoftBlenderPriv::BlenderPrivConfig::init_first_masks (uint32_t width, uint32_t h
 
     dump_soft (orig_mask, "mask_orig", -1);
 
+    masks = new BlendMasks;
+    masks->orig = orig_mask;
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-SoftBlenderPriv::BlenderPrivConfig::scale_down_masks (uint32_t level, uint32_t width, uint32_t height)
+SoftBlenderPriv::BlenderPrivConfig::scale_down_masks (
+    const SmartPtr<BlendMasks> &level_masks, uint32_t level, uint32_t width, uint32_t height)
 {
     XCAM_ASSERT (width % SOFT_BLENDER_ALIGNMENT_X == 0);
     XCAM_ASSERT (height % SOFT_BLENDER_ALIGNMENT_Y == 0);
 
-    pyr_layer[level].coef_mask = new UcharImage (width, height);
-    XCAM_ASSERT (pyr_layer[level].coef_mask.ptr ());
+    level_masks->coef[level] = new UcharImage (width, height);
+    XCAM_ASSERT (level_masks->coef[level].ptr ());
 
     SmartPtr<GaussScaleGray::Args> args = new GaussScaleGray::Args;
     if (level == 0) {
-        args->in_luma = orig_mask;
+        args->in_luma = level_masks->orig;
     } else {
-        args->in_luma = pyr_layer[level - 1].coef_mask;
+        args->in_luma = level_masks->coef[level - 1];
     }
-    args->out_luma = pyr_layer[level].coef_mask;
+    args->out_luma = level_masks->coef[level];
     SmartPtr<GaussScaleGray> worker = new GaussScaleGray;
     WorkSize size ((args->out_luma->get_width () + 1) / 2, (args->out_luma->get_height () + 1) / 2);
-    worker->set_local_size (size);
-    worker->set_global_size (size);
-    XCamReturn ret = worker->work (args);
+    XCamReturn ret = worker->work (args, size, size);
+
+    dump_soft (level_masks->coef[level], "mask", (int32_t)level);
+    return ret;
+}
+
+SmartPtr<SoftBlenderPriv::BlendMasks>
+SoftBlenderPriv::BlenderPrivConfig::get_frame_masks (
+    const SmartPtr<ImageHandler::Parameters> &param, bool last_use)
+{
+    SmartPtr<BlendMasks> frame;
+    MapFrameMasks::iterator i = frame_masks.find (param.ptr ());
+    if (i == frame_masks.end ())
+        return masks;
+
+    frame = (*i).second;
+    if (last_use)
+        frame_masks.erase (i);
+    return frame;
+}
+
+bool
+SoftBlenderPriv::BlenderPrivConfig::check_seam_update ()
+{
+    if (!seam_enable || !seam_diff_task.ptr ())
+        return false;
+
+    return (seam_frame_count++ % seam_interval) == 0 && !seam_busy;
+}
+
+XCamReturn
+SoftBlenderPriv::BlenderPrivConfig::start_seam_diff (
+    const SmartPtr<ImageHandler::Parameters> &param,
+    const SmartPtr<VideoBuffer> &gauss,
+    const uint32_t level, const SoftBlender::BufIdx idx)
+{
+    // small copy of the level, so pyramid pool buffers go back in time
+    UcharImage luma (gauss, 0);
+    SmartPtr<UcharImage> copy = new UcharImage (luma.get_width (), luma.get_height ());
+    XCAM_ASSERT (copy.ptr () && copy->is_valid ());
+    for (uint32_t y = 0; y < luma.get_height (); ++y)
+        memcpy (copy->get_buf_ptr (0, y), luma.get_buf_ptr (0, y), luma.get_width ());
+
+    SmartPtr<SeamDiffTask::Args> args;
+    {
+        SmartLock locker (map_args_mutex);
+        MapSeamArgs::iterator i = seam_args.find (param.ptr ());
+        if (i == seam_args.end ()) {
+            args = new SeamDiffTask::Args (param, level);
+            XCAM_ASSERT (args.ptr ());
+            seam_args.insert (std::make_pair((void*)param.ptr (), args));
+        } else {
+            args = (*i).second;
+        }
+        args->in_luma[idx] = copy;
+
+        if (!args->in_luma[SoftBlender::Idx0].ptr () || !args->in_luma[SoftBlender::Idx1].ptr ())
+            return XCAM_RETURN_BYPASS;
+
+        seam_args.erase (i);
+    }
+
+    if (seam_busy.exchange (true))
+        return XCAM_RETURN_BYPASS;
+
+    args->out_diff = new UcharImage (copy->get_width (), copy->get_height ());
+    XCAM_ASSERT (args->out_diff.ptr ());
+
+    SmartPtr<SoftWorker> worker = seam_diff_task;
+    XCAM_ASSERT (worker.ptr ());
+
+    uint32_t thread_x = 2, thread_y = 2;
+    WorkSize work_unit = worker->get_work_uint ();
+    WorkSize global_size (
+        xcam_ceil (args->out_diff->get_width (), work_unit.value[0]) / work_unit.value[0],
+        xcam_ceil (args->out_diff->get_height (), work_unit.value[1]) / work_unit.value[1]);
+    WorkSize local_size (
+        xcam_ceil (global_size.value[0], thread_x) / thread_x,
+        xcam_ceil (global_size.value[1], thread_y) / thread_y);
 
-    dump_soft (pyr_layer[level].coef_mask, "mask", (int32_t)level);
+    XCamReturn ret = worker->work (args, global_size, local_size);
+    if (!xcam_ret_is_ok (ret))
+        seam_busy = false;
     return ret;
 }
 
+/*
+ * dynamic programming over rows, a seam moves 1 column per row at most,
+ * searched in the middle half of overlap, same range as CL blender.
+ */
+static void
+find_seam (const UcharImage *diff, std::vector<int32_t> &seam)
+{
+    int32_t width = diff->get_width (), height = diff->get_height ();
+    int32_t begin = width / 4;
+    int32_t range = XCAM_MAX (width / 2, 1);
+    std::vector<uint32_t> cost (range), last (range);
+    std::vector<int16_t> from (range * height);
+
+    const Uchar *line = diff->get_buf_ptr (begin, 0);
+    for (int32_t x = 0; x < range; ++x)
+        last[x] = line[x];
+
+    for (int32_t y = 1; y < height; ++y) {
+        line = diff->get_buf_ptr (begin, y);
+        int16_t *from_line = &from[y * range];
+        for (int32_t x = 0; x < range; ++x) {
+            int32_t best = x;
+            if (x > 0 && last[x - 1] < last[best])
+                best = x - 1;
+            if (x + 1 < range && last[x + 1] < last[best])
+                best = x + 1;
+            cost[x] = last[best] + line[x];
+            from_line[x] = (int16_t)best;
+        }
+        cost.swap (last);
+    }
+
+    int32_t pos = 0;
+    for (int32_t x = 1; x < range; ++x) {
+        if (last[x] < last[pos])
+            pos = x;
+    }
+
+    seam.resize (height);
+    for (int32_t y = height - 1; y >= 0; --y) {
+        seam[y] = pos + begin;
+        pos = from[y * range + pos];
+    }
+}
+
+XCamReturn
+SoftBlenderPriv::BlenderPrivConfig::update_seam_masks (const SmartPtr<UcharImage> &diff, const uint32_t level)
+{
+    XCAM_ASSERT (diff.ptr ());
+    std::vector<int32_t> seam;
+    find_seam (diff.ptr (), seam);
+
+    SmartPtr<BlendMasks> cur_masks;
+    {
+        SmartLock locker (map_args_mutex);
+        cur_masks = masks;
+    }
+    XCAM_ASSERT (cur_masks.ptr () && cur_masks->orig.ptr ());
+
+    // in0 on the left of seam, in1 on the right
+    uint32_t width = cur_masks->orig->get_width (), height = cur_masks->orig->get_height ();
+    uint32_t aligned_width = XCAM_ALIGN_UP (width, SOFT_BLENDER_ALIGNMENT_X);
+    uint32_t scale = 1 << (level + 1);
+    SmartPtr<BlendMasks> new_masks = new BlendMasks;
+    new_masks->orig = new UcharImage (width, height, aligned_width);
+    XCAM_ASSERT (new_masks->orig.ptr () && new_masks->orig->is_valid ());
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint32_t seam_y = XCAM_MIN (y / scale, (uint32_t)seam.size () - 1);
+        uint32_t pos = XCAM_MIN (seam[seam_y] * scale + scale / 2, width - 1);
+        Uchar *ptr = new_masks->orig->get_buf_ptr (0, y);
+        memset (ptr, 255, pos + 1);
+        memset (ptr + pos + 1, 0, aligned_width - pos - 1);
+    }
+    dump_soft (new_masks->orig, "seam_mask_orig", -1);
+
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        const SmartPtr<UcharImage> &coef = cur_masks->coef[i];
+        XCAM_ASSERT (coef.ptr ());
+        XCamReturn ret = scale_down_masks (new_masks, i, coef->get_width (), coef->get_height ());
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "blender:(%s) scale seam mask failed. level:%d", XCAM_STR (_blender->get_name ()), i);
+    }
+
+    SmartLock locker (map_args_mutex);
+    masks = new_masks;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 SoftBlenderPriv::BlenderPrivConfig::start_scaler (
     const SmartPtr<ImageHandler::Parameters> &param,
@@ -373,10 +677,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_scaler (
         xcam_ceil(global_size.value[0], thread_x) / thread_x ,
         xcam_ceil(global_size.value[1], thread_y) / thread_y);
 
-    worker->set_local_size (local_size);
-    worker->set_global_size (global_size);
-
-    return worker->work (args);
+    return worker->work (args, global_size, local_size);
 }
 
 XCamReturn
@@ -389,15 +690,8 @@ SoftBlenderPriv::BlenderPrivConfig::start_lap_task (
     XCAM_ASSERT (idx < SoftBlender::BufIdxCount);
     SmartPtr<VideoBuffer> gauss = scale_args->out_buf;
 
-    SmartPtr<VideoBuffer> out_buf;
-    if (level == 0) {
-        XCAM_ASSERT (first_lap_pool.ptr ());
-        out_buf = first_lap_pool->get_buffer ();
-    } else {
-        XCAM_ASSERT (pyr_layer[level - 1].overlap_pool.ptr ());
-        out_buf = pyr_layer[level - 1].overlap_pool->get_buffer ();
-    }
-
+    XCAM_ASSERT (pyr_layer[level].lap_pool.ptr ());
+    SmartPtr<VideoBuffer> out_buf = pyr_layer[level].lap_pool->get_buffer ();
     XCAM_FAIL_RETURN (
         ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
         "blender:(%s) start_lap_task failed, level(%d),idx(%d) get output buffer empty.",
@@ -408,8 +702,8 @@ SoftBlenderPriv::BlenderPrivConfig::start_lap_task (
     args->orig_uv = scale_args->in_uv; //new Uchar2Image (orig, 1);
     args->gauss_luma = new UcharImage (gauss, 0);
     args->gauss_uv = new Uchar2Image (gauss, 1);
-    args->out_luma = new UcharImage (out_buf, 0);
-    args->out_uv = new Uchar2Image (out_buf, 1);
+    args->out_luma = new ShortImage (out_buf, 0);
+    args->out_uv = new Short2Image (out_buf, 1);
 
     SmartPtr<SoftWorker> worker = pyr_layer[level].lap_task[idx];
     XCAM_ASSERT (worker.ptr ());
@@ -423,11 +717,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_lap_task (
         xcam_ceil(global_size.value[0], thread_x) / thread_x ,
         xcam_ceil(global_size.value[1], thread_y) / thread_y);
 
-
-    worker->set_local_size (local_size);
-    worker->set_global_size (global_size);
-
-    return worker->work (args);
+    return worker->work (args, global_size, local_size);
 }
 
 XCamReturn
@@ -438,13 +728,13 @@ SoftBlenderPriv::BlenderPrivConfig::start_blend_task (
 {
 
     SmartPtr<BlendTask::Args> args;
-    uint32_t last_level = pyr_levels - 1;
+    uint32_t last_level = get_frame_levels (param) - 1;
 
     {
         SmartLock locker (map_args_mutex);
         MapBlendArgs::iterator i = blend_args.find (param.ptr ());
         if (i == blend_args.end ()) {
-            args = new BlendTask::Args (param, pyr_layer[last_level].coef_mask);
+            args = new BlendTask::Args (param, get_frame_masks (param, false)->coef[last_level]);
             XCAM_ASSERT (args.ptr ());
             blend_args.insert (std::make_pair((void*)param.ptr (), args));
             XCAM_LOG_DEBUG ("soft_blender:%s init blender args", XCAM_STR (_blender->get_name ()));
@@ -487,10 +777,68 @@ SoftBlenderPriv::BlenderPrivConfig::start_blend_task (
         xcam_ceil (global_size.value[0], thread_x) / thread_x,
         xcam_ceil (global_size.value[1], thread_y) / thread_y);
 
-    worker->set_local_size (local_size);
-    worker->set_global_size (global_size);
+    return worker->work (args, global_size, local_size);
+}
+
+XCamReturn
+SoftBlenderPriv::BlenderPrivConfig::start_feather_blend (const SmartPtr<SoftBlender::BlenderParam> &param)
+{
+    SmartPtr<BlendMasks> frame_masks;
+    {
+        SmartLock locker (map_args_mutex);
+        frame_masks = masks;
+    }
+    XCAM_ASSERT (frame_masks.ptr () && frame_masks->orig.ptr ());
 
-    return worker->work (args);
+    SmartPtr<BlendTask::Args> args = new BlendTask::Args (param, frame_masks->orig, param->out_buf);
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<VideoBuffer> in_bufs[SoftBlender::BufIdxCount] = {param->in_buf, param->in1_buf};
+    for (uint32_t idx = 0; idx < SoftBlender::BufIdxCount; ++idx) {
+        const VideoBufferInfo &buf_info = in_bufs[idx]->get_video_info ();
+        Rect in_area = _blender->get_input_merge_area (idx);
+        if (in_area.width == 0 || in_area.height == 0) {
+            in_area.width = buf_info.width;
+            in_area.height = buf_info.height;
+        }
+        XCAM_ASSERT (in_area.pos_x % SOFT_BLENDER_ALIGNMENT_X == 0);
+        XCAM_ASSERT (in_area.pos_y % SOFT_BLENDER_ALIGNMENT_Y == 0);
+        args->in_luma[idx] = new UcharImage (
+            in_bufs[idx], in_area.width, in_area.height, buf_info.strides[0],
+            buf_info.offsets[0] + in_area.pos_x + in_area.pos_y * buf_info.strides[0]);
+        args->in_uv[idx] = new Uchar2Image (
+            in_bufs[idx], in_area.width / 2, in_area.height / 2, buf_info.strides[1],
+            buf_info.offsets[1] + in_area.pos_x + in_area.pos_y / 2 * buf_info.strides[1]);
+    }
+
+    Rect out_area = _blender->get_merge_window ();
+    const VideoBufferInfo &out_info = param->out_buf->get_video_info ();
+    if (out_area.width == 0 || out_area.height == 0) {
+        out_area.width = out_info.width;
+        out_area.height = out_info.height;
+    }
+    XCAM_ASSERT (out_area.pos_x % SOFT_BLENDER_ALIGNMENT_X == 0);
+    XCAM_ASSERT (out_area.pos_y % SOFT_BLENDER_ALIGNMENT_Y == 0);
+    args->out_luma = new UcharImage (
+        param->out_buf, out_area.width, out_area.height, out_info.strides[0],
+        out_info.offsets[0] + out_area.pos_x + out_area.pos_y * out_info.strides[0]);
+    args->out_uv = new Uchar2Image (
+        param->out_buf, out_area.width / 2, out_area.height / 2, out_info.strides[1],
+        out_info.offsets[1] + out_area.pos_x + out_area.pos_y / 2 * out_info.strides[1]);
+
+    SmartPtr<SoftWorker> worker = last_level_blend;
+    XCAM_ASSERT (worker.ptr ());
+
+    uint32_t thread_x = 2, thread_y = 2;
+    WorkSize work_unit = worker->get_work_uint ();
+    WorkSize global_size (
+        xcam_ceil (args->out_luma->get_width (), work_unit.value[0]) / work_unit.value[0],
+        xcam_ceil (args->out_luma->get_height (), work_unit.value[1]) / work_unit.value[1]);
+    WorkSize local_size (
+        xcam_ceil (global_size.value[0], thread_x) / thread_x,
+        xcam_ceil (global_size.value[1], thread_y) / thread_y);
+
+    return worker->work (args, global_size, local_size);
 }
 
 XCamReturn
@@ -500,11 +848,17 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task (
     XCAM_ASSERT (args.ptr ());
     XCAM_ASSERT (args->lap_luma[SoftBlender::Idx0].ptr () && args->lap_luma[SoftBlender::Idx1].ptr () && args->gauss_luma.ptr ());
     XCAM_ASSERT (args->lap_luma[SoftBlender::Idx0]->get_width () == args->lap_luma[SoftBlender::Idx1]->get_width ());
+    SmartPtr<BlendMasks> frame_masks;
+    {
+        SmartLock locker (map_args_mutex);
+        frame_masks = get_frame_masks (args->get_param (), level == 0);
+    }
+
     SmartPtr<VideoBuffer> out_buf;
     if (level == 0) {
         out_buf = args->get_param ()->out_buf;
         XCAM_ASSERT (out_buf.ptr ());
-        args->mask = orig_mask;
+        args->mask = frame_masks->orig;
 
         Rect out_area = _blender->get_merge_window ();
         const VideoBufferInfo &out_info = out_buf->get_video_info ();
@@ -525,7 +879,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task (
         XCAM_FAIL_RETURN (
             ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
             "blender:(%s) start_reconstruct_task failed, out buffer is empty.", XCAM_STR (_blender->get_name ()));
-        args->mask = pyr_layer[level - 1].coef_mask;
+        args->mask = frame_masks->coef[level - 1];
         args->out_luma = new UcharImage (out_buf, 0);
         args->out_uv = new Uchar2Image (out_buf, 1);
     }
@@ -544,10 +898,7 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task (
         xcam_ceil (global_size.value[0], thread_x) / thread_x,
         xcam_ceil (global_size.value[1], thread_y) / thread_y);
 
-    worker->set_local_size (local_size);
-    worker->set_global_size (global_size);
-
-    return worker->work (args);
+    return worker->work (args, global_size, local_size);
 }
 
 XCamReturn
@@ -600,8 +951,8 @@ SoftBlenderPriv::BlenderPrivConfig::start_reconstruct_task_by_lap (
         } else {
             args = (*i).second;
         }
-        args->lap_luma[idx] = new UcharImage (lap, 0);
-        args->lap_uv[idx] = new Uchar2Image (lap, 1);
+        args->lap_luma[idx] = new ShortImage (lap, 0);
+        args->lap_uv[idx] = new Short2Image (lap, 1);
         XCAM_ASSERT (args->lap_luma[idx].ptr () && args->lap_uv[idx].ptr ());
 
         if (!args->gauss_luma.ptr () || !args->lap_luma[SoftBlender::Idx0].ptr () ||
@@ -625,6 +976,24 @@ SoftBlender::start_work (const SmartPtr<ImageHandler::Parameters> &base)
         "blender:%s start_work failed, params(in1/out buf) are not fully set or type not correct",
         XCAM_STR (get_name ()));
 
+    if (get_blend_mode () == BlendModeFeather) {
+        // no pyramid levels marks a feather frame
+        param->pyr_levels = 0;
+        ret = _priv_config->start_feather_blend (param);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "blender:%s start_work failed on feather blend", XCAM_STR (get_name ()));
+        return ret;
+    }
+
+    // a frame keeps its levels while knobs turn
+    param->pyr_levels = XCAM_MIN ((uint32_t)_priv_config->active_levels, _priv_config->pyr_levels);
+    {
+        SmartLock locker (_priv_config->map_args_mutex);
+        _priv_config->frame_masks[param.ptr ()] = _priv_config->masks;
+    }
+    param->seam_update = _priv_config->check_seam_update ();
+
     //start gauss scale level0: idx0
     ret = _priv_config->start_scaler (param, param->in_buf, 0, Idx0);
     XCAM_FAIL_RETURN (
@@ -684,38 +1053,73 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
     XCAM_ASSERT (merge_size.width % SOFT_BLENDER_ALIGNMENT_X == 0);
 
     overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
-    SmartPtr<BufferPool> first_lap_pool = new SoftVideoBufAllocator (overlap_info);
-    XCAM_ASSERT (first_lap_pool.ptr ());
-    _priv_config->first_lap_pool = first_lap_pool;
+
+    if (get_blend_mode () == BlendModeFeather) {
+        // level 0 mask blends merge areas straight into output, no pyramid buffers
+        XCamReturn ret = _priv_config->init_first_masks (overlap_info.width, overlap_info.height);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "blender:%s init masks failed", XCAM_STR (get_name ()));
+
+        _priv_config->last_level_blend = new BlendTask (new CbBlendTask (this));
+        XCAM_ASSERT (_priv_config->last_level_blend.ptr ());
+
+        if (_priv_config->seam_enable) {
+            XCAM_LOG_WARNING ("blender:%s seam search needs pyramid levels, disabled in feather mode", XCAM_STR (get_name ()));
+            _priv_config->seam_enable = false;
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    // all pyramid levels share one arena, laplace levels are int16 in P010 layout
+    VideoBufferInfo level_info[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    VideoBufferInfo lap_info[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    uint32_t lap_count = LAP_POOL_SIZE * _priv_config->pipe_depth;
+    uint32_t overlap_count = OVERLAP_POOL_SIZE * _priv_config->pipe_depth;
+    SmartPtr<SoftBufArena> arena = new SoftBufArena;
+    XCAM_ASSERT (arena.ptr ());
+    for (uint32_t i = 0; i < _priv_config->pyr_levels; ++i) {
+        lap_info[i].init (V4L2_PIX_FMT_P010, merge_size.width, merge_size.height);
+        arena->request (lap_info[i], lap_count);
+        merge_size.width = XCAM_ALIGN_UP ((merge_size.width + 1) / 2, SOFT_BLENDER_ALIGNMENT_X);
+        merge_size.height = XCAM_ALIGN_UP ((merge_size.height + 1) / 2, SOFT_BLENDER_ALIGNMENT_Y);
+        level_info[i].init (in0_info.format, merge_size.width, merge_size.height);
+        arena->request (level_info[i], overlap_count);
+    }
     XCAM_FAIL_RETURN (
-        ERROR, _priv_config->first_lap_pool->reserve (LAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
-        "blender:%s reserve lap buffer pool(w:%d,h:%d) failed",
-        XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
+        ERROR, arena->commit (), XCAM_RETURN_ERROR_MEM,
+        "blender:%s allocate pyramid buffer arena(size:%zu) failed", XCAM_STR(get_name ()), arena->get_size ());
 
     SmartPtr<Worker::Callback> gauss_scale_cb = new CbGaussDownScale (this);
     SmartPtr<Worker::Callback> lap_cb = new CbLapTask (this);
     SmartPtr<Worker::Callback> reconst_cb = new CbReconstructTask (this);
     XCAM_ASSERT (gauss_scale_cb.ptr () && lap_cb.ptr () && reconst_cb.ptr ());
 
-    XCamReturn ret = _priv_config->init_first_masks (merge_size.width, merge_size.height);
+    XCamReturn ret = _priv_config->init_first_masks (overlap_info.width, overlap_info.height);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
         "blender:%s init masks failed", XCAM_STR (get_name ()));
 
     for (uint32_t i = 0; i < _priv_config->pyr_levels; ++i) {
-        merge_size.width = XCAM_ALIGN_UP ((merge_size.width + 1) / 2, SOFT_BLENDER_ALIGNMENT_X);
-        merge_size.height = XCAM_ALIGN_UP ((merge_size.height + 1) / 2, SOFT_BLENDER_ALIGNMENT_Y);
-        overlap_info.init (in0_info.format, merge_size.width, merge_size.height);
+        const VideoBufferInfo &info = level_info[i];
 
-        SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (overlap_info);
+        SmartPtr<BufferPool> pool = new SoftArenaBufAllocator (arena, info);
         XCAM_ASSERT (pool.ptr ());
         _priv_config->pyr_layer[i].overlap_pool = pool;
         XCAM_FAIL_RETURN (
-            ERROR, _priv_config->pyr_layer[i].overlap_pool->reserve (OVERLAP_POOL_SIZE), XCAM_RETURN_ERROR_MEM,
+            ERROR, xcam_ret_is_ok (_priv_config->pyr_layer[i].overlap_pool->reserve (overlap_count)), XCAM_RETURN_ERROR_MEM,
             "blender:%s reserve buffer pool(w:%d,h:%d) failed",
-            XCAM_STR(get_name ()), overlap_info.width, overlap_info.height);
+            XCAM_STR(get_name ()), info.width, info.height);
+
+        SmartPtr<BufferPool> lap_pool = new SoftArenaBufAllocator (arena, lap_info[i]);
+        XCAM_ASSERT (lap_pool.ptr ());
+        _priv_config->pyr_layer[i].lap_pool = lap_pool;
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (_priv_config->pyr_layer[i].lap_pool->reserve (lap_count)), XCAM_RETURN_ERROR_MEM,
+            "blender:%s reserve lap buffer pool(w:%d,h:%d) failed",
+            XCAM_STR(get_name ()), lap_info[i].width, lap_info[i].height);
 
-        ret = _priv_config->scale_down_masks (i, merge_size.width, merge_size.height);
+        ret = _priv_config->scale_down_masks (_priv_config->masks, i, info.width, info.height);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "blender:(%s) first time scale coeff mask failed. level:%d", XCAM_STR (get_name ()), i);
@@ -735,6 +1139,13 @@ SoftBlender::configure_resource (const SmartPtr<Parameters> &param)
     _priv_config->last_level_blend = new BlendTask (new CbBlendTask (this));
     XCAM_ASSERT (_priv_config->last_level_blend.ptr ());
 
+    if (_priv_config->seam_enable) {
+        _priv_config->seam_diff_task = new SeamDiffTask (new CbSeamDiffTask (this));
+        XCAM_ASSERT (_priv_config->seam_diff_task.ptr ());
+        _priv_config->seam_frame_count = 0;
+        _priv_config->seam_busy = false;
+    }
+
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -765,7 +1176,7 @@ SoftBlender::gauss_scale_done (
         work_broken (param, ret);
     }
 
-    if (next_level == _priv_config->pyr_levels) { // last level
+    if (next_level == get_frame_levels (param)) { // last level
         ret = _priv_config->start_blend_task (param, args->out_buf, idx);
     } else {
         ret = _priv_config->start_scaler (param, args->out_buf, next_level, idx);
@@ -774,6 +1185,16 @@ SoftBlender::gauss_scale_done (
     if (!xcam_ret_is_ok (ret)) {
         work_broken (param, ret);
     }
+
+    SmartPtr<BlenderParam> blend_param = param.dynamic_cast_ptr<BlenderParam> ();
+    XCAM_ASSERT (blend_param.ptr ());
+    if (blend_param->seam_update && level == XCAM_MIN ((uint32_t)SEAM_DIFF_LEVEL, get_frame_levels (param) - 1)) {
+        // seam search is side work, frame goes on with current masks if it fails
+        ret = _priv_config->start_seam_diff (param, args->out_buf, level, idx);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING ("blender:%s start seam diff failed", XCAM_STR (get_name ()));
+        }
+    }
 }
 
 void
@@ -818,8 +1239,16 @@ SoftBlender::blend_task_done (
     if (!check_work_continue (param, error))
         return;
 
+    SmartPtr<BlenderParam> blend_param = param.dynamic_cast_ptr<BlenderParam> ();
+    XCAM_ASSERT (blend_param.ptr ());
+    if (!blend_param->pyr_levels) {
+        dump_buf (args->out_buf, "blend-feather");
+        work_well_done (param, error);
+        return;
+    }
+
     dump_buf (args->out_buf, "blend-last");
-    ret = _priv_config->start_reconstruct_task_by_gauss (param, args->out_buf, _priv_config->pyr_levels - 1);
+    ret = _priv_config->start_reconstruct_task_by_gauss (param, args->out_buf, get_frame_levels (param) - 1);
 
     if (!xcam_ret_is_ok (ret)) {
         work_broken (param, ret);
@@ -856,6 +1285,25 @@ SoftBlender::reconstruct_done (
     }
 }
 
+void
+SoftBlender::seam_diff_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<SeamDiffTask::Args> args = base.dynamic_cast_ptr<SeamDiffTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    if (xcam_ret_is_ok (error)) {
+        dump_soft (args->out_diff, "seam_diff", (int32_t)args->level);
+        XCamReturn ret = _priv_config->update_seam_masks (args->out_diff, args->level);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING ("blender:%s update seam masks failed", XCAM_STR (get_name ()));
+        }
+    }
+    _priv_config->seam_busy = false;
+}
+
 SmartPtr<SoftHandler>
 create_soft_blender ()
 {
@@ -27,6 +27,7 @@
 
 #define XCAM_SOFT_PYRAMID_MAX_LEVEL 4
 #define XCAM_SOFT_PYRAMID_DEFAULT_LEVEL 3
+#define XCAM_SOFT_SEAM_UPDATE_INTERVAL 30
 
 namespace XCam {
 
@@ -42,6 +43,10 @@ class SoftBlender
 public:
     struct BlenderParam : ImageHandler::Parameters {
         SmartPtr<VideoBuffer> in1_buf;
+        // active pyramid levels, taken by blender when the frame starts, 0 for feather frames
+        uint32_t              pyr_levels;
+        // frame gives its diff map to seam search
+        bool                  seam_update;
 
         BlenderParam (
             const SmartPtr<VideoBuffer> &in0,
@@ -49,6 +54,8 @@ public:
             const SmartPtr<VideoBuffer> &out)
             : Parameters (in0, out)
             , in1_buf (in1)
+            , pyr_levels (0)
+            , seam_update (false)
         {}
     };
 
@@ -62,6 +69,22 @@ public:
     ~SoftBlender ();
 
     bool set_pyr_levels (uint32_t num);
+    uint32_t get_pyr_levels () const;
+    // 1 to pyr_levels, live from the next frame, fewer levels blend cheaper and sharper
+    bool set_active_pyr_levels (uint32_t num);
+    uint32_t get_active_pyr_levels () const;
+    // max frames blended at the same time, scales pyramid buffer pools; need be set before configure
+    bool set_pipeline_depth (uint32_t depth);
+    /*
+     * blend along a seam of least difference instead of the fixed center mask,
+     * seam is searched again every @interval frames off the frame path; need be set before configure
+     */
+    bool set_seam_mode (bool enable, uint32_t interval = XCAM_SOFT_SEAM_UPDATE_INTERVAL);
+
+    //derived from Blender interface
+    virtual bool is_feather_supported () const {
+        return true;
+    }
 
     //derived from SoftHandler
     virtual XCamReturn terminate ();
@@ -74,6 +97,8 @@ public:
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
     void reconstruct_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+    void seam_diff_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
 
 protected:
     explicit SoftBlender (const char *name = "SoftBlender");
@@ -19,190 +19,156 @@
  */
 
 #include "soft_blender_tasks_priv.h"
+#include <vector>
 
 namespace XCam {
 
 namespace XCamSoftTasks {
 
-const float GaussScaleGray::coeffs[GAUSS_DOWN_SCALE_SIZE] = {0.152f, 0.222f, 0.252f, 0.222f, 0.152f};
+/*
+ * 5x5 gauss downscale, separable in integer.
+ * Each output row takes vertical sums of 5 input rows into a line buffer,
+ * then horizontal sums on every other column of the line buffer.
+ * Out of image positions are clamped to border with SoftBorderNearest, same as SoftImage::read_array,
+ * SoftBorderNone is only for rows whose taps are all in image.
+ */
+template <typename BorderT, typename ImageT>
+static void
+gauss_scale_row (
+    const ImageT *in, ImageT *out, int32_t out_x, uint32_t out_len, int32_t out_y,
+    std::vector<int16_t> &line, std::vector<int16_t> &tmp)
+{
+    const uint32_t channels = sizeof (typename ImageT::Type);
+    const int32_t in_w = in->get_width ();
+    const int32_t in_h = in->get_height ();
+
+    // input columns [begin, end) of the output columns
+    int32_t begin = out_x * 2 - GAUSS_DOWN_SCALE_RADIUS;
+    int32_t end = (out_x + out_len - 1) * 2 + GAUSS_DOWN_SCALE_RADIUS + 1;
+    uint32_t len = end - begin;
+    // decimate kernels read 1 more pixel than taps need
+    line.resize ((len + 1) * channels);
+
+    const uint8_t *rows[GAUSS_DOWN_SCALE_SIZE];
+    int32_t valid_begin = begin, valid_end = end - 1;
+    BorderT::check (valid_begin, in_w);
+    BorderT::check (valid_end, in_w);
+    ++valid_end;
+    for (int32_t k = 0; k < GAUSS_DOWN_SCALE_SIZE; ++k) {
+        int32_t y = out_y * 2 + k - GAUSS_DOWN_SCALE_RADIUS;
+        BorderT::check (y, in_h);
+        rows[k] = (const uint8_t *)in->get_buf_ptr (valid_begin, y);
+    }
+
+    if (BorderT::inside (begin, len, in_w)) {
+        soft_simd_gauss_rows (rows, len * channels, line.data ());
+    } else {
+        uint32_t valid_len = valid_end - valid_begin;
+        tmp.resize (valid_len * channels);
+        soft_simd_gauss_rows (rows, valid_len * channels, tmp.data ());
+        for (uint32_t i = 0; i < len; ++i) {
+            int32_t pos = XCAM_CLAMP (begin + (int32_t)i, valid_begin, valid_end - 1) - valid_begin;
+            for (uint32_t c = 0; c < channels; ++c)
+                line[i * channels + c] = tmp[pos * channels + c];
+        }
+    }
+    for (uint32_t c = 0; c < channels; ++c)
+        line[len * channels + c] = 0;
+
+    uint8_t *dst = (uint8_t *)out->get_buf_ptr (out_x, out_y);
+    if (channels == 1)
+        soft_simd_gauss_decimate_uchar (line.data (), out_len, dst);
+    else
+        soft_simd_gauss_decimate_uchar2 (line.data (), out_len, dst);
+}
+
+// interior tiles, whose taps are all in image, go without border checks
+template <typename ImageT>
+static void
+gauss_scale_rows (
+    const ImageT *in, ImageT *out, uint32_t x, uint32_t width, uint32_t y, uint32_t height,
+    std::vector<int16_t> &line, std::vector<int16_t> &tmp)
+{
+    bool interior =
+        SoftBorderChecked::inside (
+            (int32_t)x * 2 - GAUSS_DOWN_SCALE_RADIUS, (width - 1) * 2 + GAUSS_DOWN_SCALE_SIZE, in->get_width ()) &&
+        SoftBorderChecked::inside (
+            (int32_t)y * 2 - GAUSS_DOWN_SCALE_RADIUS, (height - 1) * 2 + GAUSS_DOWN_SCALE_SIZE, in->get_height ());
+
+    if (interior) {
+        for (uint32_t out_y = y; out_y < y + height; ++out_y)
+            gauss_scale_row<SoftBorderNone> (in, out, x, width, out_y, line, tmp);
+    } else {
+        for (uint32_t out_y = y; out_y < y + height; ++out_y)
+            gauss_scale_row<SoftBorderNearest> (in, out, x, width, out_y, line, tmp);
+    }
+}
 
 void
-GaussScaleGray::gauss_luma_2x2 (
-    UcharImage *in_luma, UcharImage *out_luma,
-    uint32_t x, uint32_t y)
+GaussScaleGray::gauss_luma_rows (
+    const UcharImage *in_luma, UcharImage *out_luma,
+    uint32_t x, uint32_t width, uint32_t y, uint32_t height)
 {
-    /*
-    * o o o o o o o
-    * o o o o o o o
-    * o o Y(UV) o Y o o
-    * o o o o o o o
-    * o o Y o Y o o
-    * o o o o o o o
-    * o o o o o o o
-     */
-    uint32_t in_x = x * 4, in_y = y * 4;
-    float line[7];
-    float sum0[7] = {0.0f};
-    float sum1[7] = {0.0f};
-    in_luma->read_array<float, 7> (in_x - 2, in_y - 2, line);
-    multiply_coeff_y (sum0, line, coeffs[0]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y - 1, line);
-    multiply_coeff_y (sum0, line, coeffs[1]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y, line);
-    multiply_coeff_y (sum0, line, coeffs[2]);
-    multiply_coeff_y (sum1, line, coeffs[0]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y + 1, line);
-    multiply_coeff_y (sum0, line, coeffs[3]);
-    multiply_coeff_y (sum1, line, coeffs[1]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y + 2, line);
-    multiply_coeff_y (sum0, line, coeffs[4]);
-    multiply_coeff_y (sum1, line, coeffs[2]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y + 3, line);
-    multiply_coeff_y (sum1, line, coeffs[3]);
-    in_luma->read_array<float, 7> (in_x - 2, in_y + 4, line);
-    multiply_coeff_y (sum1, line, coeffs[4]);
-
-    float value[2];
-    Uchar out[2];
-    value[0] = gauss_sum (&sum0[0]);
-    value[1] = gauss_sum (&sum0[2]);
-    out[0] = convert_to_uchar (value[0]);
-    out[1] = convert_to_uchar (value[1]);
-    out_luma->write_array_no_check<2> (x * 2, y * 2, out);
-
-    value[0] = gauss_sum (&sum1[0]);
-    value[1] = gauss_sum (&sum1[2]);
-    out[0] = convert_to_uchar(value[0]);
-    out[1] = convert_to_uchar(value[1]);
-    out_luma->write_array_no_check<2> (x * 2, y * 2 + 1, out);
+    std::vector<int16_t> line, tmp;
+    gauss_scale_rows (in_luma, out_luma, x, width, y, height, line, tmp);
 }
 
 XCamReturn
 GaussScaleGray::work_range (const SmartPtr<Worker::Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<GaussScaleGray::Args> args = base.dynamic_cast_ptr<GaussScaleGray::Args> ();
+    SmartPtr<GaussScaleGray::Args> args = base.static_cast_ptr<GaussScaleGray::Args> ();
     XCAM_ASSERT (args.ptr ());
     UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
     XCAM_ASSERT (in_luma && out_luma);
 
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
-        {
-            gauss_luma_2x2 (in_luma, out_luma, x, y);
-        }
+    // each work unit is 2x2 output pixels
+    gauss_luma_rows (
+        in_luma, out_luma, range.pos[0] * 2, range.pos_len[0] * 2, range.pos[1] * 2, range.pos_len[1] * 2);
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
 GaussDownScale::work_range (const SmartPtr<Worker::Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<GaussDownScale::Args> args = base.dynamic_cast_ptr<GaussDownScale::Args> ();
+    SmartPtr<GaussDownScale::Args> args = base.static_cast_ptr<GaussDownScale::Args> ();
     XCAM_ASSERT (args.ptr ());
     UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
     Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
     XCAM_ASSERT (in_luma && in_uv);
     XCAM_ASSERT (out_luma && out_uv);
 
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
-        {
-            gauss_luma_2x2 (in_luma, out_luma, x, y);
-
-            // calculate UV
-            int32_t in_x = x * 2, in_y = y * 2;
-            Float2 uv_line[5];
-            Float2 uv_sum [5];
-
-            in_uv->read_array<Float2, 5> (in_x - 2, in_y - 2, uv_line);
-            multiply_coeff_uv (uv_sum, uv_line, coeffs[0]);
-            in_uv->read_array<Float2, 5> (in_x - 2, in_y - 1, uv_line);
-            multiply_coeff_uv (uv_sum, uv_line, coeffs[1]);
-            in_uv->read_array<Float2, 5> (in_x - 2, in_y , uv_line);
-            multiply_coeff_uv (uv_sum, uv_line, coeffs[2]);
-            in_uv->read_array<Float2, 5> (in_x - 2, in_y + 1, uv_line);
-            multiply_coeff_uv (uv_sum, uv_line, coeffs[3]);
-            in_uv->read_array<Float2, 5> (in_x - 2, in_y + 2, uv_line);
-            multiply_coeff_uv (uv_sum, uv_line, coeffs[4]);
-            Float2 uv_value;
-            uv_value = gauss_sum (&uv_sum[0]);
-            Uchar2 uv_out(convert_to_uchar(uv_value.x), convert_to_uchar(uv_value.y));
-            out_uv->write_data_no_check (x, y, uv_out);
-        }
+    // each work unit is 2x2 luma and 1 uv of output
+    gauss_luma_rows (
+        in_luma, out_luma, range.pos[0] * 2, range.pos_len[0] * 2, range.pos[1] * 2, range.pos_len[1] * 2);
+
+    std::vector<int16_t> line, tmp;
+    gauss_scale_rows (in_uv, out_uv, range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1], line, tmp);
 
-    //printf ("done\n");
     XCAM_LOG_DEBUG ("GaussDownScale work on range:[x:%d, width:%d, y:%d, height:%d]",
                     range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
-static inline void
-blend_luma_8 (const float *luma0, const float *luma1, const float *mask, float *out)
-{
-    //out[0] = luma0[0] * mask + luma1[0] * ( 1.0f - mask[0]);
-#define BLEND_LUMA_8(idx) out[idx] = (luma0[idx] - luma1[idx]) * mask[idx] + luma1[idx]
-    BLEND_LUMA_8 (0);
-    BLEND_LUMA_8 (1);
-    BLEND_LUMA_8 (2);
-    BLEND_LUMA_8 (3);
-    BLEND_LUMA_8 (4);
-    BLEND_LUMA_8 (5);
-    BLEND_LUMA_8 (6);
-    BLEND_LUMA_8 (7);
-}
-
-static inline void
-normalize_8 (float *value, const float max)
-{
-    value[0] /= max;
-    value[1] /= max;
-    value[2] /= max;
-    value[3] /= max;
-    value[4] /= max;
-    value[5] /= max;
-    value[6] /= max;
-    value[7] /= max;
-}
-
-static inline void
-read_and_blend_pixel_luma_8 (
-    const UcharImage *in0, const UcharImage *in1,
-    const UcharImage *mask,
-    const uint32_t in_x, const uint32_t in_y,
-    float *out_luma,
-    float *out_mask)
-{
-    float luma0_line[8], luma1_line[8];
-    mask->read_array_no_check<float, 8> (in_x, in_y, out_mask);
-    in0->read_array_no_check<float, 8> (in_x, in_y, luma0_line);
-    in1->read_array_no_check<float, 8> (in_x, in_y, luma1_line);
-    normalize_8 (out_mask, 255.0f);
-    blend_luma_8 (luma0_line, luma1_line, out_mask, out_luma);
-}
-
-static inline void
-read_and_blend_uv_4 (
-    const Uchar2Image *in_a, const Uchar2Image *in_b,
-    const float *mask,
-    const uint32_t in_x, const uint32_t in_y,
-    Float2 *out_uv)
+/*
+ * pyramid rows are done by SIMD row kernels, see soft_simd_laplace_row.
+ * uv takes the mask of the first luma row and column of each uv pixel, same for u and v.
+ */
+static void
+get_uv_mask (const UcharImage *mask, uint32_t uv_x, uint32_t uv_y, uint32_t uv_width, std::vector<uint8_t> &uv_mask)
 {
-    Float2 line_a[4], line_b[4];
-    in_a->read_array_no_check<Float2, 4> (in_x, in_y, line_a);
-    in_b->read_array_no_check<Float2, 4> (in_x, in_y, line_b);
-
-    //out_uv[0] = line_a[0] * mask + line_b[0] * ( 1.0f - mask[0]);
-#define BLEND_UV_4(i) out_uv[i] = (line_a[i] - line_b[i]) * mask[i] + line_b[i]
-    BLEND_UV_4 (0);
-    BLEND_UV_4 (1);
-    BLEND_UV_4 (2);
-    BLEND_UV_4 (3);
+    const Uchar *luma = mask->get_buf_ptr (uv_x * 2, uv_y * 2);
+    uv_mask.resize (uv_width * 2);
+    for (uint32_t i = 0; i < uv_width; ++i) {
+        uv_mask[2 * i] = luma[2 * i];
+        uv_mask[2 * i + 1] = luma[2 * i];
+    }
 }
 
 XCamReturn
 BlendTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<BlendTask::Args> args = base.dynamic_cast_ptr<BlendTask::Args> ();
+    SmartPtr<BlendTask::Args> args = base.static_cast_ptr<BlendTask::Args> ();
     XCAM_ASSERT (args.ptr ());
     UcharImage *in0_luma = args->in_luma[0].ptr (), *in1_luma = args->in_luma[1].ptr (), *out_luma = args->out_luma.ptr ();
     Uchar2Image *in0_uv = args->in_uv[0].ptr (), *in1_uv = args->in_uv[1].ptr (), *out_uv = args->out_uv.ptr ();
@@ -212,36 +178,25 @@ BlendTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
     XCAM_ASSERT (out_luma && out_uv);
     XCAM_ASSERT (mask);
 
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
-        {
-            // 8x2 -pixels each time for luma
-            uint32_t in_x = x * 8;
-            uint32_t in_y = y * 2;
-            float luma_blend[8], luma_mask[8];
-            Uchar luma_uc[8];
-
-            // process luma (in_x, in_y)
-            read_and_blend_pixel_luma_8 (in0_luma, in1_luma, mask, in_x, in_y, luma_blend, luma_mask);
-            convert_to_uchar_N<float, 8> (luma_blend, luma_uc);
-            out_luma->write_array_no_check<8> (in_x, in_y, luma_uc);
-
-            // process luma (in_x, in_y + 1)
-            read_and_blend_pixel_luma_8 (in0_luma, in1_luma, mask, in_x, in_y + 1, luma_blend, luma_mask);
-            convert_to_uchar_N<float, 8> (luma_blend, luma_uc);
-            out_luma->write_array_no_check<8> (in_x, in_y + 1, luma_uc);
-
-            // process uv(4x1) (uv_x, uv_y)
-            uint32_t uv_x = x * 4, uv_y = y;
-            Float2 uv_blend[4];
-            Uchar2 uv_uc[4];
-            luma_mask[1] = luma_mask[2];
-            luma_mask[2] = luma_mask[4];
-            luma_mask[3] = luma_mask[6];
-            read_and_blend_uv_4 (in0_uv, in1_uv, luma_mask, uv_x, uv_y, uv_blend);
-            convert_to_uchar2_N<Float2, 4> (uv_blend, uv_uc);
-            out_uv->write_array_no_check<4> (uv_x, uv_y, uv_uc);
-        }
+    // each work unit is 8x2 luma and 4x1 uv pixels, clipped to image
+    uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 2, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 2, height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        soft_simd_blend_row (
+            in0_luma->get_buf_ptr (x_begin, y), in1_luma->get_buf_ptr (x_begin, y), mask->get_buf_ptr (x_begin, y),
+            x_end - x_begin, out_luma->get_buf_ptr (x_begin, y));
+    }
+
+    std::vector<uint8_t> uv_mask;
+    uint32_t uv_x = x_begin / 2, uv_width = (x_end - x_begin) / 2;
+    for (uint32_t uv_y = y_begin / 2; uv_y < y_end / 2; ++uv_y) {
+        get_uv_mask (mask, uv_x, uv_y, uv_width, uv_mask);
+        soft_simd_blend_row (
+            (const uint8_t *)in0_uv->get_buf_ptr (uv_x, uv_y), (const uint8_t *)in1_uv->get_buf_ptr (uv_x, uv_y),
+            uv_mask.data (), uv_width * 2, (uint8_t *)out_uv->get_buf_ptr (uv_x, uv_y));
+    }
 
     XCAM_LOG_DEBUG ("BlendTask work on range:[x:%d, width:%d, y:%d, height:%d]",
                     range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
@@ -249,253 +204,281 @@ BlendTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
     return XCAM_RETURN_NO_ERROR;
 }
 
-static inline void
-minus_array_8 (float *orig, float *gauss, Uchar *ret)
+XCamReturn
+SeamDiffTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-#define ORG_MINUS_GAUSS(i) ret[i] = convert_to_uchar<float> ((orig[i] - gauss[i]) * 0.5f + 128.0f)
-    ORG_MINUS_GAUSS(0);
-    ORG_MINUS_GAUSS(1);
-    ORG_MINUS_GAUSS(2);
-    ORG_MINUS_GAUSS(3);
-    ORG_MINUS_GAUSS(4);
-    ORG_MINUS_GAUSS(5);
-    ORG_MINUS_GAUSS(6);
-    ORG_MINUS_GAUSS(7);
+    SmartPtr<SeamDiffTask::Args> args = base.static_cast_ptr<SeamDiffTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *in0_luma = args->in_luma[0].ptr (), *in1_luma = args->in_luma[1].ptr ();
+    UcharImage *out_diff = args->out_diff.ptr ();
+    XCAM_ASSERT (in0_luma && in1_luma && out_diff);
+
+    // each work unit is 8x2 pixels, clipped to image
+    uint32_t width = out_diff->get_width (), height = out_diff->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 2, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 2, height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        const Uchar *luma0 = in0_luma->get_buf_ptr (0, y);
+        const Uchar *luma1 = in1_luma->get_buf_ptr (0, y);
+        Uchar *diff = out_diff->get_buf_ptr (0, y);
+        for (uint32_t x = x_begin; x < x_end; ++x)
+            diff[x] = (luma0[x] > luma1[x] ? luma0[x] - luma1[x] : luma1[x] - luma0[x]);
+    }
+    return XCAM_RETURN_NO_ERROR;
 }
 
+// gauss rows up-sampled to row @y of next level, odd rows take the next gauss row checked by @BorderT
+template <typename BorderT, typename ImageT>
 static inline void
-interpolate_luma_int_row_8x1 (UcharImage* image, uint32_t fixed_x, uint32_t fixed_y, float *gauss_v, float* ret)
+get_gauss_rows (const ImageT *gauss, uint32_t x, uint32_t y, const uint8_t *&g0, const uint8_t *&g1)
 {
-    image->read_array<float, 5> (fixed_x, fixed_y, gauss_v);
-    ret[0] = gauss_v[0];
-    ret[1] = (gauss_v[0] + gauss_v[1]) * 0.5f;
-    ret[2] = gauss_v[1];
-    ret[3] = (gauss_v[1] + gauss_v[2]) * 0.5f;
-    ret[4] = gauss_v[2];
-    ret[5] = (gauss_v[2] + gauss_v[3]) * 0.5f;
-    ret[6] = gauss_v[3];
-    ret[7] = (gauss_v[3] + gauss_v[4]) * 0.5f;
+    int32_t gauss_y = y / 2;
+    g0 = (const uint8_t *)gauss->get_buf_ptr (x / 2, gauss_y);
+    if (y % 2) {
+        ++gauss_y;
+        BorderT::check (gauss_y, gauss->get_height ());
+    }
+    g1 = (const uint8_t *)gauss->get_buf_ptr (x / 2, gauss_y);
 }
 
-static inline void
-interpolate_luma_half_row_8x1 (UcharImage* image, uint32_t fixed_x, uint32_t next_y, float *last_gauss_v, float* ret)
+/*
+ * right border of up-sample is clamped by row kernels with @g_width,
+ * so border policies only pick the next gauss row.
+ */
+template <typename BorderT, typename ImageT, typename LapImageT>
+static void
+laplace_row (const ImageT *orig, const ImageT *gauss, LapImageT *lap, uint32_t x, uint32_t width, uint32_t y)
 {
-    float next_gauss_v[5];
-    float tmp;
-    image->read_array<float, 5> (fixed_x, next_y, next_gauss_v);
-    ret[0] = (last_gauss_v[0] + next_gauss_v[0]) / 2.0f;
-    ret[2] = (last_gauss_v[1] + next_gauss_v[1]) / 2.0f;
-    ret[4] = (last_gauss_v[2] + next_gauss_v[2]) / 2.0f;
-    ret[6] = (last_gauss_v[3] + next_gauss_v[3]) / 2.0f;
-    tmp = (last_gauss_v[4] + next_gauss_v[4]) / 2.0f;
-    ret[1] = (ret[0] + ret[2]) / 2.0f;
-    ret[3] = (ret[2] + ret[4]) / 2.0f;
-    ret[5] = (ret[4] + ret[6]) / 2.0f;
-    ret[7] = (ret[6] + tmp) / 2.0f;
+    const uint8_t *g0, *g1;
+    get_gauss_rows<BorderT> (gauss, x, y, g0, g1);
+    soft_simd_laplace_row (
+        (const uint8_t *)orig->get_buf_ptr (x, y), g0, g1, width, gauss->get_width () - x / 2,
+        sizeof (typename ImageT::Type), (int16_t *)lap->get_buf_ptr (x, y));
 }
 
-void
-LaplaceTask::interplate_luma_8x2 (
-    UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
-    uint32_t out_x, uint32_t out_y)
+// rows [y_begin, y_end), no border check if odd rows all have the next gauss row in image
+template <typename ImageT, typename LapImageT>
+static void
+laplace_rows (
+    const ImageT *orig, const ImageT *gauss, LapImageT *lap, uint32_t x, uint32_t width,
+    uint32_t y_begin, uint32_t y_end)
 {
-    uint32_t gauss_x = out_x / 2, first_gauss_y = out_y / 2;
-    float inter_value[8];
-    float gauss_v[5];
-    float orig_v[8];
-    Uchar lap_ret[8];
-    //interplate instaed of coefficient
-    interpolate_luma_int_row_8x1 (gauss_luma, gauss_x, first_gauss_y, gauss_v, inter_value);
-    orig_luma->read_array_no_check<float, 8> (out_x, out_y, orig_v);
-    minus_array_8 (orig_v, inter_value, lap_ret);
-    out_luma->write_array_no_check<8> (out_x, out_y, lap_ret);
-
-    uint32_t next_gauss_y = first_gauss_y + 1;
-    interpolate_luma_half_row_8x1 (gauss_luma, gauss_x, next_gauss_y, gauss_v, inter_value);
-    orig_luma->read_array_no_check<float, 8> (out_x, out_y + 1, orig_v);
-    minus_array_8 (orig_v, inter_value, lap_ret);
-    out_luma->write_array_no_check<8> (out_x, out_y + 1, lap_ret);
+    if (y_begin >= y_end)
+        return;
+
+    if ((y_end - 1) / 2 + 1 < gauss->get_height ()) {
+        for (uint32_t y = y_begin; y < y_end; ++y)
+            laplace_row<SoftBorderNone> (orig, gauss, lap, x, width, y);
+    } else {
+        for (uint32_t y = y_begin; y < y_end; ++y)
+            laplace_row<SoftBorderNearest> (orig, gauss, lap, x, width, y);
+    }
 }
 
-static inline void
-minus_array_uv_4 (Float2 *orig, Float2 *gauss, Uchar2 *ret)
+template <typename ImageT, typename LapImageT>
+static void
+reconstruct_row (
+    const LapImageT *lap0, const LapImageT *lap1, const uint8_t *mask, const ImageT *gauss, ImageT *out,
+    uint32_t x, uint32_t width, uint32_t y)
 {
-#define ORG_MINUS_GAUSS_UV(i) orig[i] -= gauss[i]; orig[i] *= 0.5f; orig[i] += 128.0f
-    ORG_MINUS_GAUSS_UV(0);
-    ORG_MINUS_GAUSS_UV(1);
-    ORG_MINUS_GAUSS_UV(2);
-    ORG_MINUS_GAUSS_UV(3);
-    convert_to_uchar2_N<Float2, 4> (orig, ret);
+    const uint8_t *g0, *g1;
+    get_gauss_rows<SoftBorderNearest> (gauss, x, y, g0, g1);
+    soft_simd_reconstruct_row (
+        (const int16_t *)lap0->get_buf_ptr (x, y), (const int16_t *)lap1->get_buf_ptr (x, y), mask,
+        g0, g1, width, gauss->get_width () - x / 2, sizeof (typename ImageT::Type), (uint8_t *)out->get_buf_ptr (x, y));
 }
 
-static inline void
-interpolate_uv_int_row_4x1 (Uchar2Image *image, uint32_t x, uint32_t y, Float2 *gauss_value, Float2 *ret)
+XCamReturn
+LaplaceTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-    image->read_array<Float2, 3> (x, y, gauss_value);
-    ret[0] = gauss_value[0];
-    ret[1] = gauss_value[0] + gauss_value[1];
-    ret[1] *= 0.5f;
-    ret[2] = gauss_value[1];
-    ret[3] = gauss_value[1] + gauss_value[2];
-    ret[3] *= 0.5f;
-}
+    SmartPtr<LaplaceTask::Args> args = base.static_cast_ptr<LaplaceTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *orig_luma = args->orig_luma.ptr (), *gauss_luma = args->gauss_luma.ptr ();
+    Uchar2Image *orig_uv = args->orig_uv.ptr (), *gauss_uv = args->gauss_uv.ptr ();
+    ShortImage *out_luma = args->out_luma.ptr ();
+    Short2Image *out_uv = args->out_uv.ptr ();
+    XCAM_ASSERT (orig_luma && orig_uv);
+    XCAM_ASSERT (gauss_luma && gauss_uv);
+    XCAM_ASSERT (out_luma && out_uv);
 
-static inline void
-interpolate_uv_half_row_4x1 (Uchar2Image *image, uint32_t x, uint32_t y, Float2 *gauss_value, Float2 *ret)
-{
-    Float2 next_gauss_uv[3];
-    image->read_array<Float2, 3> (x, y, next_gauss_uv);
-    ret[0] = (gauss_value[0] + next_gauss_uv[0]) * 0.5f;
-    ret[2] = (gauss_value[1] + next_gauss_uv[1]) * 0.5f;
-    Float2 tmp = (gauss_value[2] + next_gauss_uv[2]) * 0.5f;
-    ret[1] = (ret[0] + ret[2]) * 0.5f;
-    ret[3] = (ret[2] + tmp) * 0.5f;
+    // each work unit is 8x4 luma and 4x2 uv pixels, clipped to image
+    uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 4, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 4, height);
+
+    laplace_rows (orig_luma, gauss_luma, out_luma, x_begin, x_end - x_begin, y_begin, y_end);
+    laplace_rows (orig_uv, gauss_uv, out_uv, x_begin / 2, (x_end - x_begin) / 2, y_begin / 2, y_end / 2);
+
+    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
-LaplaceTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+ReconstructTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<LaplaceTask::Args> args = base.dynamic_cast_ptr<LaplaceTask::Args> ();
+    SmartPtr<ReconstructTask::Args> args = base.static_cast_ptr<ReconstructTask::Args> ();
     XCAM_ASSERT (args.ptr ());
-    UcharImage *orig_luma = args->orig_luma.ptr (), *gauss_luma = args->gauss_luma.ptr (), *out_luma = args->out_luma.ptr ();
-    Uchar2Image *orig_uv = args->orig_uv.ptr (), *gauss_uv = args->gauss_uv.ptr (), *out_uv = args->out_uv.ptr ();
-    XCAM_ASSERT (orig_luma && orig_uv);
+    ShortImage *lap_luma[2] = {args->lap_luma[0].ptr (), args->lap_luma[1].ptr ()};
+    UcharImage *gauss_luma = args->gauss_luma.ptr (), *out_luma = args->out_luma.ptr ();
+    Short2Image *lap_uv[2] = {args->lap_uv[0].ptr (), args->lap_uv[1].ptr ()};
+    Uchar2Image *gauss_uv = args->gauss_uv.ptr (), *out_uv = args->out_uv.ptr ();
+    UcharImage *mask_image = args->mask.ptr ();
+    XCAM_ASSERT (lap_luma[0] && lap_luma[1] && lap_uv[0] && lap_uv[1]);
     XCAM_ASSERT (gauss_luma && gauss_uv);
     XCAM_ASSERT (out_luma && out_uv);
+    XCAM_ASSERT (mask_image);
+
+    // blend of laplace levels and reconstruct are one pass, each work unit is 8x4 luma and 4x2 uv pixels
+    uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 4, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 4, height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y) {
+        reconstruct_row (
+            lap_luma[0], lap_luma[1], mask_image->get_buf_ptr (x_begin, y), gauss_luma, out_luma,
+            x_begin, x_end - x_begin, y);
+    }
+
+    std::vector<uint8_t> uv_mask;
+    uint32_t uv_x = x_begin / 2, uv_width = (x_end - x_begin) / 2;
+    for (uint32_t uv_y = y_begin / 2; uv_y < y_end / 2; ++uv_y) {
+        get_uv_mask (mask_image, uv_x, uv_y, uv_width, uv_mask);
+        reconstruct_row (lap_uv[0], lap_uv[1], uv_mask.data (), gauss_uv, out_uv, uv_x, uv_width, uv_y);
+    }
 
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
-        {
-            // 8x4 -pixels each time for luma
-            uint32_t out_x = x * 8, out_y = y * 4;
-            interplate_luma_8x2 (orig_luma, gauss_luma, out_luma, out_x, out_y);
-            interplate_luma_8x2 (orig_luma, gauss_luma, out_luma, out_x, out_y + 2);
-
-            // 4x2 uv
-            uint32_t out_uv_x = x * 4, out_uv_y = y * 2;
-            uint32_t gauss_uv_x = out_uv_x / 2, gauss_uv_y = out_uv_y / 2;
-            Float2 gauss_uv_value[3];
-            Float2 orig_uv_value[4];
-            Float2 inter_uv_value[4];
-            Uchar2 lap_uv_ret[4];
-            interpolate_uv_int_row_4x1 (gauss_uv, gauss_uv_x, gauss_uv_y, gauss_uv_value, inter_uv_value);
-            orig_uv->read_array_no_check<Float2, 4> (out_uv_x , out_uv_y, orig_uv_value);
-            minus_array_uv_4 (orig_uv_value, inter_uv_value, lap_uv_ret);
-            out_uv->write_array_no_check<4> (out_uv_x , out_uv_y, lap_uv_ret);
-
-            interpolate_uv_half_row_4x1 (gauss_uv, gauss_uv_x, gauss_uv_y + 1, gauss_uv_value, inter_uv_value);
-            orig_uv->read_array_no_check<Float2, 4> (out_uv_x , out_uv_y + 1, orig_uv_value);
-            minus_array_uv_4 (orig_uv_value, inter_uv_value, lap_uv_ret);
-            out_uv->write_array_no_check<4> (out_uv_x, out_uv_y + 1, lap_uv_ret);
-        }
     return XCAM_RETURN_NO_ERROR;
 }
 
-static inline void
-reconstruct_luma_8x1 (float *lap, float *up_sample, Uchar *result)
+XCamReturn
+MultiGaussTask::work_range (const SmartPtr<Worker::Arguments> &base, const WorkRange &range)
 {
-#define RECONSTRUCT_UP_SAMPLE(i) result[i] = convert_to_uchar<float>(up_sample[i] + lap[i] * 2.0f - 256.0f)
-    RECONSTRUCT_UP_SAMPLE(0);
-    RECONSTRUCT_UP_SAMPLE(1);
-    RECONSTRUCT_UP_SAMPLE(2);
-    RECONSTRUCT_UP_SAMPLE(3);
-    RECONSTRUCT_UP_SAMPLE(4);
-    RECONSTRUCT_UP_SAMPLE(5);
-    RECONSTRUCT_UP_SAMPLE(6);
-    RECONSTRUCT_UP_SAMPLE(7);
+    SmartPtr<MultiGaussTask::Args> args = base.static_cast_ptr<MultiGaussTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    // each work unit is 2x2 luma and 1 uv of output of one input
+    std::vector<int16_t> line, tmp;
+    for (uint32_t i = range.pos[2]; i < range.pos[2] + range.pos_len[2]; ++i) {
+        XCAM_ASSERT (i < args->in_luma.size ());
+        UcharImage *in_luma = args->in_luma[i].ptr (), *out_luma = args->out_luma[i].ptr ();
+        Uchar2Image *in_uv = args->in_uv[i].ptr (), *out_uv = args->out_uv[i].ptr ();
+        XCAM_ASSERT (in_luma && in_uv && out_luma && out_uv);
+
+        gauss_luma_rows (
+            in_luma, out_luma, range.pos[0] * 2, range.pos_len[0] * 2, range.pos[1] * 2, range.pos_len[1] * 2);
+        gauss_scale_rows (in_uv, out_uv, range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1], line, tmp);
+    }
+    return XCAM_RETURN_NO_ERROR;
 }
 
-static inline void
-reconstruct_luma_4x1 (Float2 *lap, Float2 *up_sample, Uchar2 *uv_uc)
+XCamReturn
+MultiLaplaceTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<MultiLaplaceTask::Args> args = base.static_cast_ptr<MultiLaplaceTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    for (uint32_t i = range.pos[2]; i < range.pos[2] + range.pos_len[2]; ++i) {
+        XCAM_ASSERT (i < args->out_luma.size ());
+        UcharImage *orig_luma = args->orig_luma[i].ptr (), *gauss_luma = args->gauss_luma[i].ptr ();
+        Uchar2Image *orig_uv = args->orig_uv[i].ptr (), *gauss_uv = args->gauss_uv[i].ptr ();
+        ShortImage *out_luma = args->out_luma[i].ptr ();
+        Short2Image *out_uv = args->out_uv[i].ptr ();
+        XCAM_ASSERT (orig_luma && orig_uv && gauss_luma && gauss_uv && out_luma && out_uv);
+
+        // each work unit is 8x4 luma and 4x2 uv pixels, clipped to image
+        uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+        uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+        uint32_t y_begin = range.pos[1] * 4, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 4, height);
+
+        laplace_rows (orig_luma, gauss_luma, out_luma, x_begin, x_end - x_begin, y_begin, y_end);
+        laplace_rows (orig_uv, gauss_uv, out_uv, x_begin / 2, (x_end - x_begin) / 2, y_begin / 2, y_end / 2);
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+template <typename ImageT>
+static void
+fuse_row (
+    const std::vector<SmartPtr<ImageT> > &ins, const std::vector<SmartPtr<ShortImage> > &weights,
+    ImageT *out, uint32_t x, uint32_t width, uint32_t y)
+{
+    const uint32_t channels = sizeof (typename ImageT::Type);
+    const uint8_t *in_rows[SOFT_FUSE_MAX_INPUTS];
+    const int16_t *weight_rows[SOFT_FUSE_MAX_INPUTS];
+    uint32_t count = ins.size ();
+    XCAM_ASSERT (count <= SOFT_FUSE_MAX_INPUTS && weights.size () == count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        in_rows[i] = (const uint8_t *)ins[i]->get_buf_ptr (x, y);
+        weight_rows[i] = weights[i]->get_buf_ptr (x * channels, y);
+    }
+    soft_simd_fuse_row (in_rows, weight_rows, count, width * channels, (uint8_t *)out->get_buf_ptr (x, y));
+}
+
+template <typename ImageT, typename LapImageT>
+static void
+fuse_reconstruct_row (
+    const std::vector<SmartPtr<LapImageT> > &laps, const std::vector<SmartPtr<ShortImage> > &weights,
+    const ImageT *gauss, ImageT *out, uint32_t x, uint32_t width, uint32_t y)
 {
-#define RECONSTRUCT_UP_SAMPLE_UV(i) \
-    uv_uc[i].x = convert_to_uchar<float>(up_sample[i].x + lap[i].x * 2.0f - 256.0f); \
-    uv_uc[i].y = convert_to_uchar<float>(up_sample[i].y + lap[i].y * 2.0f - 256.0f)
-
-    RECONSTRUCT_UP_SAMPLE_UV (0);
-    RECONSTRUCT_UP_SAMPLE_UV (1);
-    RECONSTRUCT_UP_SAMPLE_UV (2);
-    RECONSTRUCT_UP_SAMPLE_UV (3);
+    const uint32_t channels = sizeof (typename ImageT::Type);
+    const int16_t *lap_rows[SOFT_FUSE_MAX_INPUTS];
+    const int16_t *weight_rows[SOFT_FUSE_MAX_INPUTS];
+    uint32_t count = laps.size ();
+    XCAM_ASSERT (count <= SOFT_FUSE_MAX_INPUTS && weights.size () == count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        lap_rows[i] = (const int16_t *)laps[i]->get_buf_ptr (x, y);
+        weight_rows[i] = weights[i]->get_buf_ptr (x * channels, y);
+    }
+
+    const uint8_t *g0, *g1;
+    get_gauss_rows<SoftBorderNearest> (gauss, x, y, g0, g1);
+    soft_simd_fuse_reconstruct_row (
+        lap_rows, weight_rows, count, g0, g1, width, gauss->get_width () - x / 2, channels,
+        (uint8_t *)out->get_buf_ptr (x, y));
 }
 
 XCamReturn
-ReconstructTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+MultiBlendTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<MultiBlendTask::Args> args = base.static_cast_ptr<MultiBlendTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    UcharImage *out_luma = args->out_luma.ptr ();
+    Uchar2Image *out_uv = args->out_uv.ptr ();
+    XCAM_ASSERT (out_luma && out_uv);
+
+    // each work unit is 8x2 luma and 4x1 uv pixels, clipped to image
+    uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 2, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 2, height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y)
+        fuse_row (args->in_luma, args->luma_weights, out_luma, x_begin, x_end - x_begin, y);
+    for (uint32_t uv_y = y_begin / 2; uv_y < y_end / 2; ++uv_y)
+        fuse_row (args->in_uv, args->uv_weights, out_uv, x_begin / 2, (x_end - x_begin) / 2, uv_y);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiReconstructTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<ReconstructTask::Args> args = base.dynamic_cast_ptr<ReconstructTask::Args> ();
+    SmartPtr<MultiReconstructTask::Args> args = base.static_cast_ptr<MultiReconstructTask::Args> ();
     XCAM_ASSERT (args.ptr ());
-    UcharImage *lap_luma[2] = {args->lap_luma[0].ptr (), args->lap_luma[1].ptr ()};
     UcharImage *gauss_luma = args->gauss_luma.ptr (), *out_luma = args->out_luma.ptr ();
-    Uchar2Image *lap_uv[2] = {args->lap_uv[0].ptr (), args->lap_uv[1].ptr ()};
     Uchar2Image *gauss_uv = args->gauss_uv.ptr (), *out_uv = args->out_uv.ptr ();
-    UcharImage *mask_image = args->mask.ptr ();
-    XCAM_ASSERT (lap_luma[0] && lap_luma[1] && lap_uv[0] && lap_uv[1]);
-    XCAM_ASSERT (gauss_luma && gauss_uv);
-    XCAM_ASSERT (out_luma && out_uv);
-    XCAM_ASSERT (mask_image);
+    XCAM_ASSERT (gauss_luma && gauss_uv && out_luma && out_uv);
+
+    // each work unit is 8x4 luma and 4x2 uv pixels, clipped to image
+    uint32_t width = out_luma->get_width (), height = out_luma->get_height ();
+    uint32_t x_begin = range.pos[0] * 8, x_end = XCAM_MIN ((range.pos[0] + range.pos_len[0]) * 8, width);
+    uint32_t y_begin = range.pos[1] * 4, y_end = XCAM_MIN ((range.pos[1] + range.pos_len[1]) * 4, height);
+
+    for (uint32_t y = y_begin; y < y_end; ++y)
+        fuse_reconstruct_row (args->lap_luma, args->luma_weights, gauss_luma, out_luma, x_begin, x_end - x_begin, y);
+    for (uint32_t uv_y = y_begin / 2; uv_y < y_end / 2; ++uv_y)
+        fuse_reconstruct_row (args->lap_uv, args->uv_weights, gauss_uv, out_uv, x_begin / 2, (x_end - x_begin) / 2, uv_y);
 
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
-        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
-        {
-            // 8x4 -pixels each time for luma
-            float luma_blend[8], luma_mask1[8], luma_mask2[8];
-            float luma_sample[8];
-            float gauss_data[5];
-            Uchar luma_uchar[8];
-            uint32_t in_x = x * 8, in_y = y * 4;
-
-            // luma 1st - line
-            read_and_blend_pixel_luma_8 (lap_luma[0], lap_luma[1], mask_image, in_x, in_y, luma_blend, luma_mask1);
-            interpolate_luma_int_row_8x1 (gauss_luma, in_x / 2, in_y / 2, gauss_data, luma_sample);
-            reconstruct_luma_8x1 (luma_blend, luma_sample, luma_uchar);
-            out_luma->write_array_no_check<8> (in_x, in_y, luma_uchar);
-
-            // luma 2nd -line
-            in_y += 1;
-            read_and_blend_pixel_luma_8 (lap_luma[0], lap_luma[1], mask_image, in_x, in_y, luma_blend, luma_mask1);
-            interpolate_luma_half_row_8x1 (gauss_luma, in_x / 2, in_y / 2 + 1, gauss_data, luma_sample);
-            reconstruct_luma_8x1 (luma_blend, luma_sample, luma_uchar);
-            out_luma->write_array_no_check<8> (in_x, in_y, luma_uchar);
-
-            // luma 3rd -line
-            in_y += 1;
-            read_and_blend_pixel_luma_8 (lap_luma[0], lap_luma[1], mask_image, in_x, in_y, luma_blend, luma_mask2);
-            interpolate_luma_int_row_8x1 (gauss_luma, in_x / 2, in_y / 2, gauss_data, luma_sample);
-            reconstruct_luma_8x1 (luma_blend, luma_sample, luma_uchar);
-            out_luma->write_array_no_check<8> (in_x, in_y, luma_uchar);
-
-            // luma 4th -line
-            in_y += 1;
-            read_and_blend_pixel_luma_8 (lap_luma[0], lap_luma[1], mask_image, in_x, in_y, luma_blend, luma_mask2);
-            interpolate_luma_half_row_8x1 (gauss_luma, in_x / 2, in_y / 2 + 1, gauss_data, luma_sample);
-            reconstruct_luma_8x1 (luma_blend, luma_sample, luma_uchar);
-            out_luma->write_array_no_check<8> (in_x, in_y, luma_uchar);
-
-            // 4x2-UV process UV
-            uint32_t uv_x = x * 4, uv_y = y * 2;
-            Float2 uv_blend[4];
-            Float2 gauss_uv_value[3];
-            Float2 up_sample_uv[4];
-            Uchar2 uv_uc[4];
-            luma_mask1[1] = luma_mask1[2];
-            luma_mask1[2] = luma_mask1[4];
-            luma_mask1[3] = luma_mask1[6];
-            luma_mask2[1] = luma_mask2[2];
-            luma_mask2[2] = luma_mask2[4];
-            luma_mask2[3] = luma_mask1[6];
-
-            //1st-line UV
-            read_and_blend_uv_4 (lap_uv[0], lap_uv[1], luma_mask1, uv_x, uv_y, uv_blend);
-            interpolate_uv_int_row_4x1 (gauss_uv, uv_x / 2, uv_y / 2, gauss_uv_value, up_sample_uv);
-            reconstruct_luma_4x1 (uv_blend, up_sample_uv, uv_uc);
-            out_uv->write_array_no_check<4> (uv_x, uv_y, uv_uc);
-
-            //2nd-line UV
-            uv_y += 1;
-            read_and_blend_uv_4 (lap_uv[0], lap_uv[1], luma_mask2, uv_x, uv_y, uv_blend);
-            interpolate_uv_half_row_4x1 (gauss_uv, uv_x / 2, uv_y / 2 + 1, gauss_uv_value, up_sample_uv);
-            reconstruct_luma_4x1 (uv_blend, up_sample_uv, uv_uc);
-            out_uv->write_array_no_check<4> (uv_x, uv_y, uv_uc);
-        }
     return XCAM_RETURN_NO_ERROR;
 }
 
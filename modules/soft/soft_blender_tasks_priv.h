@@ -25,6 +25,7 @@
 #include <soft/soft_worker.h>
 #include <soft/soft_image.h>
 #include <soft/soft_blender.h>
+#include <vector>
 
 #define SOFT_BLENDER_ALIGNMENT_X 8
 #define SOFT_BLENDER_ALIGNMENT_Y 4
@@ -55,28 +56,9 @@ private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 
 protected:
-    void gauss_luma_2x2 (
-        UcharImage *in_luma, UcharImage *out_luma, uint32_t x, uint32_t y);
-
-    inline void multiply_coeff_y (float *out, const float *in, float coef) {
-        out[0] += in[0] * coef;
-        out[1] += in[1] * coef;
-        out[2] += in[2] * coef;
-        out[3] += in[3] * coef;
-        out[4] += in[4] * coef;
-        out[5] += in[5] * coef;
-        out[6] += in[6] * coef;
-        //out[7] += in[7] * coef;
-    }
-
-    template<typename T>
-    inline T gauss_sum (const T *input) {
-        return (input[0] * coeffs[0] + input[1] * coeffs[1] + input[2] * coeffs[2] +
-                input[3] * coeffs[3] + input[4] * coeffs[4]);
-    }
-
-protected:
-    static const float coeffs[GAUSS_DOWN_SCALE_SIZE];
+    void gauss_luma_rows (
+        const UcharImage *in_luma, UcharImage *out_luma,
+        uint32_t x, uint32_t width, uint32_t y, uint32_t height);
 };
 
 class GaussDownScale
@@ -112,14 +94,6 @@ public:
 
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
-
-    inline void multiply_coeff_uv (Float2 *out, Float2 *in, float coef) {
-        out[0] += in[0] * coef;
-        out[1] += in[1] * coef;
-        out[2] += in[2] * coef;
-        out[3] += in[3] * coef;
-        out[4] += in[4] * coef;
-    }
 };
 
 class BlendTask
@@ -154,13 +128,41 @@ private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
 
+class SeamDiffTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>   in_luma[2], out_diff;
+        const uint32_t         level;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param, const uint32_t l)
+            : SoftArgs (param)
+            , level (l)
+        {}
+    };
+
+public:
+    explicit SeamDiffTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("SoftSeamDiffTask", cb)
+    {
+        set_work_uint (8, 2);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
 class LaplaceTask
     : public SoftWorker
 {
 public:
     struct Args : SoftArgs {
-        SmartPtr<UcharImage>        orig_luma, gauss_luma, out_luma;
-        SmartPtr<Uchar2Image>       orig_uv, gauss_uv, out_uv;
+        SmartPtr<UcharImage>        orig_luma, gauss_luma;
+        SmartPtr<Uchar2Image>       orig_uv, gauss_uv;
+        // laplace level in SOFT_LAP_FRAC_BITS fraction bits
+        SmartPtr<ShortImage>        out_luma;
+        SmartPtr<Short2Image>       out_uv;
         const uint32_t              level;
         const SoftBlender::BufIdx   idx;
 
@@ -186,10 +188,6 @@ public:
 
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
-
-    void interplate_luma_8x2 (
-        UcharImage *orig_luma, UcharImage *gauss_luma, UcharImage *out_luma,
-        uint32_t out_x, uint32_t out_y);
 };
 
 class ReconstructTask
@@ -197,8 +195,10 @@ class ReconstructTask
 {
 public:
     struct Args : SoftArgs {
-        SmartPtr<UcharImage>        gauss_luma, lap_luma[2], out_luma;
-        SmartPtr<Uchar2Image>       gauss_uv, lap_uv[2], out_uv;
+        SmartPtr<UcharImage>        gauss_luma, out_luma;
+        SmartPtr<Uchar2Image>       gauss_uv, out_uv;
+        SmartPtr<ShortImage>        lap_luma[2];
+        SmartPtr<Short2Image>       lap_uv[2];
         SmartPtr<UcharImage>        mask;
         const uint32_t              level;
 
@@ -225,6 +225,123 @@ private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
 
+/*
+ * N-way multi-band tasks of SoftMultiBlender, z of work ranges is the input index
+ * for gauss and laplace tasks. weights of all inputs sum to 256 on every element,
+ * uv weights have one element for each of u and v.
+ */
+class MultiGaussTask
+    : public GaussScaleGray
+{
+public:
+    struct Args : SoftArgs {
+        std::vector<SmartPtr<UcharImage> >   in_luma, out_luma;
+        std::vector<SmartPtr<Uchar2Image> >  in_uv, out_uv;
+        const uint32_t                       level;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param, const uint32_t l)
+            : SoftArgs (param)
+            , level (l)
+        {}
+    };
+
+public:
+    explicit MultiGaussTask (const SmartPtr<Worker::Callback> &cb)
+        : GaussScaleGray ("MultiGaussTask", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class MultiLaplaceTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        std::vector<SmartPtr<UcharImage> >   orig_luma, gauss_luma;
+        std::vector<SmartPtr<Uchar2Image> >  orig_uv, gauss_uv;
+        std::vector<SmartPtr<ShortImage> >   out_luma;
+        std::vector<SmartPtr<Short2Image> >  out_uv;
+        const uint32_t                       level;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param, const uint32_t l)
+            : SoftArgs (param)
+            , level (l)
+        {}
+    };
+
+public:
+    explicit MultiLaplaceTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("MultiLaplaceTask", cb)
+    {
+        set_work_uint (8, 4);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class MultiBlendTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        std::vector<SmartPtr<UcharImage> >   in_luma;
+        std::vector<SmartPtr<Uchar2Image> >  in_uv;
+        std::vector<SmartPtr<ShortImage> >   luma_weights, uv_weights;
+        SmartPtr<UcharImage>                 out_luma;
+        SmartPtr<Uchar2Image>                out_uv;
+
+        SmartPtr<VideoBuffer>                out_buf;
+
+        explicit Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+        {}
+    };
+
+public:
+    explicit MultiBlendTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("MultiBlendTask", cb)
+    {
+        set_work_uint (8, 2);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+class MultiReconstructTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>                 gauss_luma, out_luma;
+        SmartPtr<Uchar2Image>                gauss_uv, out_uv;
+        std::vector<SmartPtr<ShortImage> >   lap_luma;
+        std::vector<SmartPtr<Short2Image> >  lap_uv;
+        std::vector<SmartPtr<ShortImage> >   luma_weights, uv_weights;
+        const uint32_t                       level;
+
+        SmartPtr<VideoBuffer>                out_buf;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param, const uint32_t l)
+            : SoftArgs (param)
+            , level (l)
+        {}
+    };
+
+public:
+    explicit MultiReconstructTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("MultiReconstructTask", cb)
+    {
+        set_work_uint (8, 4);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
 }
 
 }
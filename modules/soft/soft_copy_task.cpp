@@ -24,19 +24,43 @@ namespace XCam {
 
 namespace XCamSoftTasks {
 
+// rows without padding in between are copied as one span
 template <typename ImageT>
-static inline void copy_line (const ImageT *in, ImageT *out, const uint32_t y, const uint32_t size)
+static inline void
+copy_rows (const ImageT *in, ImageT *out, uint32_t y, uint32_t rows, uint32_t row_bytes, bool stream)
 {
-    const typename ImageT::Type *in_ptr = in->get_buf_ptr (0, y);
-    typename ImageT::Type *out_ptr = out->get_buf_ptr (0, y);
+    if (in->get_pitch () == row_bytes && out->get_pitch () == row_bytes) {
+        row_bytes *= rows;
+        rows = 1;
+    }
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        const uint8_t *in_ptr = (const uint8_t *)in->get_buf_ptr (0, y + i);
+        uint8_t *out_ptr = (uint8_t *)out->get_buf_ptr (0, y + i);
+
+        if (stream)
+            soft_simd_stream_copy (in_ptr, row_bytes, out_ptr);
+        else
+            memcpy (out_ptr, in_ptr, row_bytes);
+    }
+}
+
+void
+XCamSoftTasks::CopyTask::set_copy_size (uint32_t width, uint32_t height)
+{
+    // each unit is two luma rows and one uv row
+    uint32_t units = xcam_ceil (height, 2) / 2;
+    uint32_t unit_bytes = XCAM_MAX (width * 3, 1u);
+    uint32_t range_units = XCAM_CLAMP (XCAM_SOFT_COPY_RANGE_BYTES / unit_bytes, 1u, XCAM_MAX (units, 1u));
 
-    memcpy (out_ptr, in_ptr, size);
+    set_global_size (WorkSize (1, units));
+    set_local_size (WorkSize (1, range_units));
 }
 
 XCamReturn
 XCamSoftTasks::CopyTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
-    SmartPtr<CopyTask::Args> args = base.dynamic_cast_ptr<CopyTask::Args> ();
+    SmartPtr<CopyTask::Args> args = base.static_cast_ptr<CopyTask::Args> ();
     XCAM_ASSERT (args.ptr ());
 
     UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
@@ -46,14 +70,11 @@ XCamSoftTasks::CopyTask::work_range (const SmartPtr<Arguments> &base, const Work
 
     uint32_t luma_size = in_luma->get_width () * in_luma->pixel_size ();
     uint32_t uv_size = in_uv->get_width () * in_uv->pixel_size ();
-    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
-        uint32_t luma_y = y * 2;
-        copy_line<UcharImage> (in_luma, out_luma, luma_y, luma_size);
-        copy_line<UcharImage> (in_luma, out_luma, luma_y + 1, luma_size);
+    bool stream = (uint64_t)luma_size * in_luma->get_height () * 3 / 2 >= XCAM_SOFT_COPY_STREAM_BYTES;
 
-        uint32_t uv_y = y;
-        copy_line<Uchar2Image> (in_uv, out_uv, uv_y, uv_size);
-    }
+    uint32_t y = range.pos[1], rows = range.pos_len[1];
+    copy_rows<UcharImage> (in_luma, out_luma, y * 2, rows * 2, luma_size, stream);
+    copy_rows<Uchar2Image> (in_uv, out_uv, y, rows, uv_size, stream);
 
     XCAM_LOG_DEBUG ("CopyTask work on range:[x:%d, width:%d, y:%d, height:%d]",
                     range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
@@ -27,6 +27,12 @@
 #include <soft/soft_image.h>
 #include <interface/stitcher.h>
 
+// copies of more bytes are stored around cache, nothing reads them again soon
+#define XCAM_SOFT_COPY_STREAM_BYTES (1024 * 1024)
+// bytes of each work item, big enough to keep memory busy and small enough to leave
+// most of L2 to tasks running along
+#define XCAM_SOFT_COPY_RANGE_BYTES (256 * 1024)
+
 namespace XCam {
 
 namespace XCamSoftTasks {
@@ -49,6 +55,9 @@ public:
         : SoftWorker ("CopyTask", cb)
     {}
 
+    // work sizes to copy NV12 area of @width x @height, set before work
+    void set_copy_size (uint32_t width, uint32_t height);
+
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
@@ -0,0 +1,260 @@
+/*
+ * soft_csc.cpp - soft color space conversion implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_csc.h"
+#include "soft_worker.h"
+
+#define XCAM_SOFT_CSC_ALIGNMENT_X 16
+#define XCAM_SOFT_CSC_ALIGNMENT_Y 2
+
+#define XCAM_SOFT_CSC_MAX_PLANES 3
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+class CscTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>         in_luma;
+        SmartPtr<Uchar2Image>        in_uv;
+        // byte rows of each output plane
+        SmartPtr<UcharImage>         out_planes[XCAM_SOFT_CSC_MAX_PLANES];
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+        {}
+    };
+
+public:
+    explicit CscTask (const SmartPtr<Worker::Callback> &cb, uint32_t out_format)
+        : SoftWorker ("CscTask", cb)
+        , _out_format (out_format)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+
+private:
+    uint32_t    _out_format;
+};
+
+XCamReturn
+CscTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<CscTask::Args> args = base.static_cast_ptr<CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    UcharImage *in_luma = args->in_luma.ptr ();
+    Uchar2Image *in_uv = args->in_uv.ptr ();
+    XCAM_ASSERT (in_luma && in_uv);
+    XCAM_ASSERT (args->out_planes[0].ptr ());
+
+    uint32_t width = in_luma->get_width ();
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        const uint8_t *uv = (const uint8_t *)in_uv->get_buf_ptr (0, y);
+        for (uint32_t i = 0; i < 2; ++i) {
+            uint32_t luma_y = y * 2 + i;
+            const uint8_t *luma = in_luma->get_buf_ptr (0, luma_y);
+            uint8_t *out = args->out_planes[0]->get_buf_ptr (0, luma_y);
+
+            switch (_out_format) {
+            case V4L2_PIX_FMT_YUV420:
+                memcpy (out, luma, width);
+                break;
+            case V4L2_PIX_FMT_YUYV:
+                soft_simd_nv12_to_yuyv (luma, uv, width, out);
+                break;
+            case V4L2_PIX_FMT_RGBA32:
+                soft_simd_nv12_to_rgba (luma, uv, width, out);
+                break;
+            default:
+                XCAM_ASSERT (false);
+                return XCAM_RETURN_ERROR_PARAM;
+            }
+        }
+
+        if (_out_format == V4L2_PIX_FMT_YUV420) {
+            XCAM_ASSERT (args->out_planes[1].ptr () && args->out_planes[2].ptr ());
+            soft_simd_split_uv (
+                uv, in_uv->get_width (),
+                args->out_planes[1]->get_buf_ptr (0, y), args->out_planes[2]->get_buf_ptr (0, y));
+        }
+    }
+
+    XCAM_LOG_DEBUG ("CscTask work on range:[x:%d, width:%d, y:%d, height:%d]",
+                    range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+DECLARE_WORK_CALLBACK (CbCscTask, SoftCsc, csc_task_done);
+
+SoftCsc::SoftCsc (const char *name)
+    : SoftHandler (name)
+    , _out_format (V4L2_PIX_FMT_YUV420)
+    , _bands (XCAM_SOFT_CSC_DEFAULT_BANDS)
+{
+}
+
+SoftCsc::~SoftCsc ()
+{
+}
+
+bool
+SoftCsc::set_output_format (uint32_t fourcc)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_csc_task.ptr (), false,
+        "SoftCsc(%s) set output format failed, csc was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR,
+        fourcc == V4L2_PIX_FMT_YUV420 || fourcc == V4L2_PIX_FMT_RGBA32 || fourcc == V4L2_PIX_FMT_YUYV,
+        false,
+        "SoftCsc(%s) unsupported output format %s", XCAM_STR (get_name ()), xcam_fourcc_to_string (fourcc));
+
+    _out_format = fourcc;
+    return true;
+}
+
+bool
+SoftCsc::set_bands (uint32_t bands)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, bands, false,
+        "SoftCsc(%s) bands must be more than 0", XCAM_STR (get_name ()));
+
+    _bands = bands;
+    return true;
+}
+
+XCamReturn
+SoftCsc::convert (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftCsc::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftCsc(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        _out_format, in_info.width, in_info.height,
+        XCAM_ALIGN_UP (in_info.width, XCAM_SOFT_CSC_ALIGNMENT_X),
+        XCAM_ALIGN_UP (in_info.height, XCAM_SOFT_CSC_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    XCAM_ASSERT (!_csc_task.ptr ());
+    _csc_task = new XCamSoftTasks::CscTask (new CbCscTask (this), _out_format);
+    XCAM_ASSERT (_csc_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftCsc::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_csc_task.ptr ());
+    XCAM_ASSERT (param.ptr () && param->in_buf.ptr () && param->out_buf.ptr ());
+
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    const VideoBufferInfo &out_info = param->out_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        out_info.format == _out_format &&
+        out_info.width == in_info.width && out_info.height == in_info.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftCsc(%s) output(%s %dx%d) needs format %s and input size(%dx%d)",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (out_info.format), out_info.width, out_info.height,
+        xcam_fourcc_to_string (_out_format), in_info.width, in_info.height);
+
+    SmartPtr<XCamSoftTasks::CscTask::Args> args = new XCamSoftTasks::CscTask::Args (param);
+    args->in_luma = new UcharImage (param->in_buf, 0);
+    args->in_uv = new Uchar2Image (param->in_buf, 1);
+
+    for (uint32_t i = 0; i < out_info.components; ++i) {
+        VideoBufferPlanarInfo planar;
+        out_info.get_planar_info (planar, i);
+        args->out_planes[i] = new UcharImage (
+            param->out_buf, planar.width * planar.pixel_bytes, planar.height,
+            out_info.strides[i], out_info.offsets[i]);
+    }
+
+    uint32_t rows = in_info.height / 2;
+    WorkSize global_size (1, rows);
+    WorkSize local_size (1, xcam_ceil (rows, _bands) / _bands);
+    _csc_task->set_local_size (local_size);
+    _csc_task->set_global_size (global_size);
+
+    return _csc_task->work (args);
+}
+
+XCamReturn
+SoftCsc::terminate ()
+{
+    if (_csc_task.ptr ()) {
+        _csc_task->stop ();
+        _csc_task.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+SoftCsc::csc_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _csc_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::CscTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::CscTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler> create_soft_csc ()
+{
+    SmartPtr<SoftHandler> csc = new SoftCsc ();
+    XCAM_ASSERT (csc.ptr ());
+
+    return csc;
+}
+
+}
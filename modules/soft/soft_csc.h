@@ -0,0 +1,81 @@
+/*
+ * soft_csc.h - soft color space conversion class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_CSC_H
+#define XCAM_SOFT_CSC_H
+
+#include <xcam_std.h>
+#include <soft/soft_handler.h>
+#include <soft/soft_image.h>
+
+#define XCAM_SOFT_CSC_DEFAULT_BANDS 4
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class CscTask;
+};
+
+/*
+ * SoftCsc, converts NV12 into V4L2_PIX_FMT_YUV420(I420), V4L2_PIX_FMT_RGBA32 or
+ * V4L2_PIX_FMT_YUYV of the same size, outputs come from a SoftVideoBufAllocator pool.
+ * RGBA follows CLCscImageHandler NV12 to RGBA conversion, alpha is opaque.
+ */
+class SoftCsc
+    : public SoftHandler
+{
+public:
+    explicit SoftCsc (const char *name = "SoftCsc");
+    ~SoftCsc ();
+
+    // need be called before configure
+    bool set_output_format (uint32_t fourcc);
+    uint32_t get_output_format () const {
+        return _out_format;
+    }
+    bool set_bands (uint32_t bands);
+
+    XCamReturn convert (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void csc_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (SoftCsc);
+
+private:
+    SmartPtr<XCamSoftTasks::CscTask>      _csc_task;
+    uint32_t                              _out_format;
+    uint32_t                              _bands;
+};
+
+extern SmartPtr<SoftHandler> create_soft_csc ();
+
+}
+
+#endif //XCAM_SOFT_CSC_H
@@ -24,6 +24,10 @@
 #define XCAM_GEO_MAP_ALIGNMENT_X 8
 #define XCAM_GEO_MAP_ALIGNMENT_Y 2
 
+#define XCAM_GEO_FIXED_SCALE 16.0f
+#define XCAM_GEO_FIXED_MAX_SIZE 2048
+#define XCAM_GEO_FIXED_UPDATE_ROWS 128
+
 namespace XCam {
 
 DECLARE_WORK_CALLBACK (CbGeoMapTask, SoftGeoMapper, remap_task_done);
@@ -32,6 +36,15 @@ DECLARE_WORK_CALLBACK (CbGeoMapDualCurveTask, SoftDualCurveGeoMapper, remap_task
 
 SoftGeoMapper::SoftGeoMapper (const char *name)
     : SoftHandler (name)
+    , _pending_rows (0)
+    , _fixed_update_rows (XCAM_GEO_FIXED_UPDATE_ROWS)
+    , _fixed_point (false)
+    , _planar_mode (false)
+    , _out_format (0)
+    , _plane_layout (false)
+    , _spans_in_width (0)
+    , _spans_in_height (0)
+    , _table_key (0)
 {
 }
 
@@ -63,6 +76,355 @@ SoftGeoMapper::set_lookup_table (const PointFloat2 *data, uint32_t width, uint32
         }
     }
 
+    // later mappers of the key use this table, _lookup_table is never written after
+    _lookup_table = SharedTableCache::instance ()->add (
+                        SharedSoftLookupTable, _table_key, _lookup_table,
+                        (int64_t)width * height * sizeof (Float2), _lookup_ref);
+
+    return true;
+}
+
+bool
+SoftGeoMapper::use_shared_lookup_table ()
+{
+    SmartPtr<Float2Image> table =
+        SharedTableCache::instance ()->find<Float2Image> (SharedSoftLookupTable, _table_key, _lookup_ref);
+    if (!table.ptr ())
+        return false;
+
+    _lookup_table = table;
+    XCAM_LOG_DEBUG (
+        "SoftGeoMapper(%s) uses shared lookup table(%dx%d)",
+        XCAM_STR (get_name ()), table->get_width (), table->get_height ());
+    return true;
+}
+
+bool
+SoftGeoMapper::prepare_lookup_table (const PointFloat2 *data, uint32_t width, uint32_t height)
+{
+    SmartPtr<Short2Image> fixed_table;
+    Float2 factors;
+    bool has_fixed = false;
+    {
+        SmartLock locker (_next_mutex);
+        XCAM_FAIL_RETURN(
+            ERROR, data && _lookup_table.ptr () &&
+            width == _lookup_table->get_width () && height == _lookup_table->get_height (), false,
+            "SoftGeoMapper(%s) prepare look up table failed, size(%dx%d) differs from current table",
+            XCAM_STR (get_name ()), width, height);
+
+        has_fixed = _fixed_table.ptr ();
+        factors = _fixed_factors;
+    }
+
+    SmartPtr<Float2Image> lookup_table = new Float2Image (width, height);
+    XCAM_FAIL_RETURN(
+        ERROR, lookup_table.ptr () && lookup_table->is_valid (), false,
+        "SoftGeoMapper(%s) prepare look up table failed in data allocation",
+        XCAM_STR (get_name ()));
+
+    for (uint32_t i = 0; i < height; ++i) {
+        Float2 *ret = lookup_table->get_buf_ptr (0, i);
+        const PointFloat2 *line = &data[i * width];
+        for (uint32_t j = 0; j < width; ++j) {
+            ret[j].x = line [j].x;
+            ret[j].y = line [j].y;
+        }
+    }
+
+    if (has_fixed) {
+        const VideoBufferInfo &out_info = get_out_video_info ();
+        fixed_table = new Short2Image (out_info.aligned_width, out_info.aligned_height);
+        XCAM_FAIL_RETURN (
+            ERROR, fixed_table.ptr () && fixed_table->is_valid (), false,
+            "SoftGeoMapper(%s) prepare fixed table allocation failed", XCAM_STR (get_name ()));
+        expand_fixed_rows (lookup_table, fixed_table, factors, out_info, 0, out_info.aligned_height);
+    }
+
+    SmartLock locker (_next_mutex);
+    _next_lookup_table = lookup_table;
+    _next_fixed_table = fixed_table;
+    _next_fixed_factors = factors;
+    return true;
+}
+
+bool
+SoftGeoMapper::commit_lookup_table ()
+{
+    SmartLock locker (_next_mutex);
+    if (!_next_lookup_table.ptr ())
+        return false;
+
+    // tasks in flight hold the old tables until they finish,
+    // prepared tables are not shared as the key is of the old config
+    _lookup_table = _next_lookup_table;
+    _lookup_ref.release ();
+    _table_key = 0;
+    if (_next_fixed_table.ptr ()) {
+        _fixed_table = _next_fixed_table;
+        _fixed_factors = _next_fixed_factors;
+        _fixed_ref.release ();
+    } else if (_fixed_table.ptr ()) {
+        // configured after prepare, re-expand from new table
+        _fixed_factors = Float2 (0.0f, 0.0f);
+    }
+    _pending_table.release ();
+    _pending_rows = 0;
+
+    _next_lookup_table.release ();
+    _next_fixed_table.release ();
+    return true;
+}
+
+bool
+SoftGeoMapper::enable_fixed_point (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_map_task.ptr (), false,
+        "SoftGeoMapper(%s) enable fixed point failed, mapper was already configured",
+        XCAM_STR (get_name ()));
+
+    _fixed_point = enable;
+    return true;
+}
+
+bool
+SoftGeoMapper::enable_planar_mode (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_map_task.ptr (), false,
+        "SoftGeoMapper(%s) enable planar mode failed, mapper was already configured",
+        XCAM_STR (get_name ()));
+
+    _planar_mode = enable;
+    return true;
+}
+
+static bool
+is_format_supported (uint32_t in_format, uint32_t out_format)
+{
+    if (in_format == V4L2_PIX_FMT_NV12)
+        return out_format == V4L2_PIX_FMT_NV12 || out_format == V4L2_PIX_FMT_YUV420;
+
+    return in_format == out_format && (
+        in_format == V4L2_PIX_FMT_YUV420 || in_format == V4L2_PIX_FMT_P010 || in_format == V4L2_PIX_FMT_RGBA32);
+}
+
+bool
+SoftGeoMapper::set_output_format (uint32_t fourcc)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_map_task.ptr (), false,
+        "SoftGeoMapper(%s) set output format failed, mapper was already configured",
+        XCAM_STR (get_name ()));
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        !fourcc || fourcc == V4L2_PIX_FMT_NV12 || fourcc == V4L2_PIX_FMT_YUV420 ||
+        fourcc == V4L2_PIX_FMT_P010 || fourcc == V4L2_PIX_FMT_RGBA32,
+        false,
+        "SoftGeoMapper(%s) unsupported output format %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (fourcc));
+
+    _out_format = fourcc;
+    return true;
+}
+
+bool
+SoftGeoMapper::set_redirect_areas (const RedirectAreas &areas)
+{
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const RedirectArea &area = areas[i];
+        XCAM_FAIL_RETURN (
+            ERROR,
+            area.in_area.pos_x >= 0 && area.in_area.pos_y >= 0 && area.in_area.width > 0 && area.in_area.height > 0 &&
+            !(area.in_area.pos_x % 2) && !(area.in_area.pos_y % 2) &&
+            !(area.in_area.width % 2) && !(area.in_area.height % 2) && !(area.out_x % 2) && !(area.out_y % 2),
+            false,
+            "SoftGeoMapper(%s) redirect area(idx:%d) need even positions and sizes, in_area(%d, %d, %d, %d) out(%d, %d)",
+            XCAM_STR (get_name ()), i, area.in_area.pos_x, area.in_area.pos_y, area.in_area.width, area.in_area.height,
+            area.out_x, area.out_y);
+    }
+
+    _redirect_areas = areas;
+    return true;
+}
+
+void
+SoftGeoMapper::prepare_redirect (const SmartPtr<Worker::Arguments> &base, const SmartPtr<ImageHandler::Parameters> &param)
+{
+    SmartPtr<RedirectParam> redirect = param.dynamic_cast_ptr<RedirectParam> ();
+    if (_redirect_areas.empty () || !redirect.ptr () || !redirect->redirect_buf.ptr ())
+        return;
+
+    SmartPtr<XCamSoftTasks::GeoMapTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::GeoMapTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    args->redirect_luma = new UcharImage (redirect->redirect_buf, 0);
+    args->redirect_uv = new Uchar2Image (redirect->redirect_buf, 1);
+    args->redirect_areas = _redirect_areas;
+}
+
+void
+SoftGeoMapper::prepare_spans (const SmartPtr<Worker::Arguments> &base)
+{
+    SmartPtr<XCamSoftTasks::GeoMapTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::GeoMapTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    if (!args->redirect_areas.empty ())
+        return;
+
+    // output size is fixed at configure, so table, factors and input size decide the spans
+    const Float2 &factors = args->factors;
+    uint32_t in_w = args->in_luma->get_width (), in_h = args->in_luma->get_height ();
+    if (!_spans.ptr () || _spans_table.ptr () != _lookup_table.ptr () ||
+            !XCAM_DOUBLE_EQUAL_AROUND (factors.x, _spans_factors.x) ||
+            !XCAM_DOUBLE_EQUAL_AROUND (factors.y, _spans_factors.y) ||
+            in_w != _spans_in_width || in_h != _spans_in_height) {
+        _spans = XCamSoftTasks::GeoMapTask::build_spans (
+                     _lookup_table, factors, in_w, in_h, args->out_luma->get_width (), args->out_luma->get_height ());
+        _spans_table = _lookup_table;
+        _spans_factors = factors;
+        _spans_in_width = in_w;
+        _spans_in_height = in_h;
+
+        // dead blocks are one memset per row, rows of blocks in spans cost more
+        std::vector<uint32_t> cost (_spans->get_rows (), 1);
+        uint32_t valid_blocks = 0;
+        for (uint32_t y = 0; y < _spans->get_rows (); ++y) {
+            for (uint32_t i = _spans->offsets[y]; i < _spans->offsets[y + 1]; ++i)
+                cost[y] += _spans->spans[i].end - _spans->spans[i].begin;
+            valid_blocks += cost[y] - 1;
+        }
+        _map_task->set_row_cost (cost);
+
+        XCAM_LOG_DEBUG (
+            "SoftGeoMapper(%s) spans rebuilt, %d of %d blocks mapped inside input",
+            XCAM_STR (get_name ()), valid_blocks,
+            _spans->get_rows () * (xcam_ceil (args->out_luma->get_width (), XCAM_GEO_MAP_ALIGNMENT_X) / XCAM_GEO_MAP_ALIGNMENT_X));
+    }
+    args->spans = _spans;
+}
+
+bool
+SoftGeoMapper::init_fixed_table (const VideoBufferInfo &in_info, const VideoBufferInfo &out_info)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, in_info.width < XCAM_GEO_FIXED_MAX_SIZE && in_info.height < XCAM_GEO_FIXED_MAX_SIZE, false,
+        "SoftGeoMapper(%s) fixed point only support input size less than %d, but input size:%dx%d",
+        XCAM_STR (get_name ()), XCAM_GEO_FIXED_MAX_SIZE, in_info.width, in_info.height);
+
+    Float2 factors;
+    get_factors (factors.x, factors.y);
+
+    SharedTableCache *cache = SharedTableCache::instance ();
+    uint64_t key = get_fixed_table_key (factors, out_info);
+    SmartPtr<Short2Image> fixed_table = cache->find<Short2Image> (SharedSoftFixedTable, key, _fixed_ref);
+    if (!fixed_table.ptr ()) {
+        fixed_table = new Short2Image (out_info.aligned_width, out_info.aligned_height);
+        XCAM_FAIL_RETURN (
+            ERROR, fixed_table.ptr () && fixed_table->is_valid (), false,
+            "SoftGeoMapper(%s) fixed table allocation failed", XCAM_STR (get_name ()));
+
+        expand_fixed_rows (_lookup_table, fixed_table, factors, out_info, 0, out_info.aligned_height);
+        fixed_table = cache->add (
+                          SharedSoftFixedTable, key, fixed_table,
+                          (int64_t)out_info.aligned_width * out_info.aligned_height * sizeof (Short2), _fixed_ref);
+    }
+    {
+        SmartLock locker (_next_mutex);
+        _fixed_table = fixed_table;
+        _fixed_factors = factors;
+    }
+    _pending_table.release ();
+
+    return true;
+}
+
+void
+SoftGeoMapper::expand_fixed_rows (
+    const SmartPtr<Float2Image> &lookup_table,
+    const SmartPtr<Short2Image> &table, const Float2 &factors, const VideoBufferInfo &out_info,
+    uint32_t start_y, uint32_t end_y)
+{
+    Float2 out_center ((out_info.width - 1.0f) / 2.0f, (out_info.height - 1.0f) / 2.0f);
+    Float2 lut_center ((lookup_table->get_width () - 1.0f) / 2.0f, (lookup_table->get_height () - 1.0f) / 2.0f);
+
+    for (uint32_t y = start_y; y < end_y; ++y) {
+        Short2 *line = table->get_buf_ptr (0, y);
+        for (uint32_t x = 0; x < out_info.aligned_width; ++x) {
+            Float2 lut_pos = (Float2 (x, y) - out_center) / factors + lut_center;
+            Float2 in_pos = lookup_table->read_interpolate_data<Float2> (lut_pos.x, lut_pos.y);
+
+            // positions out of int16 range are also out of input image
+            in_pos = in_pos * XCAM_GEO_FIXED_SCALE;
+            line[x].x = (int16_t) XCAM_CLAMP (floorf (in_pos.x + 0.5f), (float)INT16_MIN, (float)INT16_MAX);
+            line[x].y = (int16_t) XCAM_CLAMP (floorf (in_pos.y + 0.5f), (float)INT16_MIN, (float)INT16_MAX);
+        }
+    }
+}
+
+uint64_t
+SoftGeoMapper::get_fixed_table_key (const Float2 &factors, const VideoBufferInfo &out_info) const
+{
+    if (!_table_key)
+        return 0;
+
+    uint32_t sizes[] = {out_info.width, out_info.height, out_info.aligned_width, out_info.aligned_height};
+    uint64_t key = SharedTableCache::hash (SharedTableCache::HashSeed, &_table_key, sizeof (_table_key));
+    key = SharedTableCache::hash (key, &factors.x, sizeof (factors.x));
+    key = SharedTableCache::hash (key, &factors.y, sizeof (factors.y));
+    return SharedTableCache::hash (key, sizes, sizeof (sizes));
+}
+
+bool
+SoftGeoMapper::update_fixed_table (const Float2 &factors, const VideoBufferInfo &out_info)
+{
+    // factors of a running update are kept, later changes are picked up after it is swapped in
+    if (!_pending_table.ptr ()) {
+        // swapped in at once if another mapper of the key expanded it,
+        // the ref held first keeps it from being dropped meanwhile
+        SharedTableCache *cache = SharedTableCache::instance ();
+        uint64_t key = get_fixed_table_key (factors, out_info);
+        SharedTableRef ref;
+        SmartPtr<Short2Image> shared = cache->find<Short2Image> (SharedSoftFixedTable, key, ref);
+        if (shared.ptr ()) {
+            cache->find<Short2Image> (SharedSoftFixedTable, key, _fixed_ref);
+            SmartLock locker (_next_mutex);
+            _fixed_table = shared;
+            _fixed_factors = factors;
+            return true;
+        }
+
+        _pending_table = new Short2Image (out_info.aligned_width, out_info.aligned_height);
+        XCAM_FAIL_RETURN (
+            ERROR, _pending_table.ptr () && _pending_table->is_valid (), false,
+            "SoftGeoMapper(%s) pending fixed table allocation failed", XCAM_STR (get_name ()));
+
+        _pending_factors = factors;
+        _pending_rows = 0;
+    }
+
+    uint32_t end_y = out_info.aligned_height;
+    if (_fixed_update_rows)
+        end_y = XCAM_MIN (_pending_rows + _fixed_update_rows, end_y);
+    expand_fixed_rows (_lookup_table, _pending_table, _pending_factors, out_info, _pending_rows, end_y);
+    _pending_rows = end_y;
+
+    if (_pending_rows < out_info.aligned_height)
+        return true;
+
+    // tasks in flight hold the old table until they finish
+    SmartPtr<Short2Image> fixed_table = SharedTableCache::instance ()->add (
+            SharedSoftFixedTable, get_fixed_table_key (_pending_factors, out_info), _pending_table,
+            (int64_t)out_info.aligned_width * out_info.aligned_height * sizeof (Short2), _fixed_ref);
+    {
+        SmartLock locker (_next_mutex);
+        _fixed_table = fixed_table;
+        _fixed_factors = _pending_factors;
+    }
+    _pending_table.release ();
+    _pending_rows = 0;
+
     return true;
 }
 
@@ -89,30 +451,57 @@ SoftGeoMapper::configure_resource (const SmartPtr<Parameters> &param)
         XCAM_STR (get_name ()));
 
     const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    uint32_t out_format = _out_format ? _out_format : in_info.format;
     XCAM_FAIL_RETURN (
-        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
-        "SoftGeoMapper(%s) only support format(NV12) but input format is %s",
-        XCAM_STR(get_name ()), xcam_fourcc_to_string (in_info.format));
+        ERROR, is_format_supported (in_info.format, out_format), XCAM_RETURN_ERROR_PARAM,
+        "SoftGeoMapper(%s) unsupported format, input:%s output:%s",
+        XCAM_STR(get_name ()), xcam_fourcc_to_string (in_info.format), xcam_fourcc_to_string (out_format));
+
+    _plane_layout = (in_info.format != V4L2_PIX_FMT_NV12 || out_format != V4L2_PIX_FMT_NV12);
+    if (_plane_layout) {
+        XCAM_FAIL_RETURN (
+            ERROR, enable_planar_mode (true), XCAM_RETURN_ERROR_PARAM,
+            "SoftGeoMapper(%s) format %s to %s needs planar mode",
+            XCAM_STR(get_name ()), xcam_fourcc_to_string (in_info.format), xcam_fourcc_to_string (out_format));
+        if (!_redirect_areas.empty ())
+            XCAM_LOG_WARNING ("SoftGeoMapper(%s) redirect areas ignored on format %s",
+                              XCAM_STR (get_name ()), xcam_fourcc_to_string (out_format));
+    }
 
     uint32_t width, height;
     get_output_size (width, height);
     VideoBufferInfo out_info;
     out_info.init (
-        in_info.format, width, height,
+        out_format, width, height,
         XCAM_ALIGN_UP (width, XCAM_GEO_MAP_ALIGNMENT_X),
         XCAM_ALIGN_UP (height, XCAM_GEO_MAP_ALIGNMENT_Y));
     set_out_video_info (out_info);
 
     init_factors ();
 
+    if ((_fixed_point || _planar_mode) && !init_fixed_table (in_info, out_info)) {
+        XCAM_FAIL_RETURN (
+            ERROR, !_plane_layout, XCAM_RETURN_ERROR_PARAM,
+            "SoftGeoMapper(%s) format %s has no float lookup path",
+            XCAM_STR (get_name ()), xcam_fourcc_to_string (out_format));
+
+        XCAM_LOG_WARNING ("SoftGeoMapper(%s) fall back to float lookup table", XCAM_STR (get_name ()));
+        SmartLock locker (_next_mutex);
+        _fixed_table.release ();
+        _fixed_ref.release ();
+    }
+
     XCAM_ASSERT (!_map_task.ptr ());
     _map_task = create_remap_task ();
+    // rows crossing the fisheye edge cost more than rows in the center
+    _map_task->set_partition_mode (SoftWorker::PartitionGuided);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
-void
-SoftGeoMapper::set_work_size (
+XCamReturn
+SoftGeoMapper::start_map_task (
+    const SmartPtr<Worker::Arguments> &args,
     uint32_t thread_x, uint32_t thread_y,
     uint32_t luma_width, uint32_t luma_height)
 {
@@ -124,8 +513,8 @@ SoftGeoMapper::set_work_size (
         xcam_ceil(global_size.value[0], thread_x) / thread_x ,
         xcam_ceil(global_size.value[1], thread_y) / thread_y);
 
-    _map_task->set_local_size (local_size);
-    _map_task->set_global_size (global_size);
+    // sizes go with the frame, the task may still run an earlier pipelined frame
+    return _map_task->work (args, global_size, local_size);
 }
 
 bool
@@ -142,6 +531,16 @@ SoftGeoMapper::init_factors ()
 SmartPtr<XCamSoftTasks::GeoMapTask>
 SoftGeoMapper::create_remap_task ()
 {
+    if (_fixed_table.ptr () && _plane_layout) {
+        if (get_out_video_info ().format == V4L2_PIX_FMT_P010)
+            return new XCamSoftTasks::GeoMapPlaneTask<uint16_t> (new CbGeoMapTask (this));
+        return new XCamSoftTasks::GeoMapPlaneTask<uint8_t> (new CbGeoMapTask (this));
+    }
+    if (_fixed_table.ptr () && _planar_mode)
+        return new XCamSoftTasks::GeoMapPlanarTask (new CbGeoMapTask (this));
+    if (_fixed_table.ptr ())
+        return new XCamSoftTasks::GeoMapFixedTask (new CbGeoMapTask (this));
+
     SmartPtr<XCamSoftTasks::GeoMapTask> map_task = new XCamSoftTasks::GeoMapTask (new CbGeoMapTask (this));
     XCAM_ASSERT (map_task.ptr ());
 
@@ -158,18 +557,128 @@ SoftGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameters> &param
     get_factors (factors.x, factors.y);
 
     SmartPtr<VideoBuffer> in_buf = param->in_buf, out_buf = param->out_buf;
-    SmartPtr<XCamSoftTasks::GeoMapTask::Args> args = new XCamSoftTasks::GeoMapTask::Args (param);
+    SmartPtr<XCamSoftTasks::GeoMapTask::Args> args;
+    if (_fixed_table.ptr ()) {
+        if (!XCAM_DOUBLE_EQUAL_AROUND (factors.x, _fixed_factors.x) ||
+                !XCAM_DOUBLE_EQUAL_AROUND (factors.y, _fixed_factors.y)) {
+            XCAM_FAIL_RETURN (
+                ERROR, update_fixed_table (factors, out_buf->get_video_info ()),
+                XCAM_RETURN_ERROR_MEM,
+                "SoftGeoMapper(%s) update fixed table failed", XCAM_STR (get_name ()));
+        }
+
+        if (_plane_layout)
+            return start_plane_task (param);
+
+        SmartPtr<XCamSoftTasks::GeoMapFixedTask::Args> fixed_args = new XCamSoftTasks::GeoMapFixedTask::Args (param);
+        fixed_args->fixed_table = _fixed_table;
+        args = fixed_args;
+    } else
+        args = new XCamSoftTasks::GeoMapTask::Args (param);
     args->in_luma = new UcharImage (in_buf, 0);
     args->in_uv = new Uchar2Image (in_buf, 1);
     args->out_luma = new UcharImage (out_buf, 0);
     args->out_uv = new Uchar2Image (out_buf, 1);
     args->lookup_table = _lookup_table;
     args->factors = factors;
+    prepare_redirect (args, param);
+    if (!_fixed_table.ptr ())
+        prepare_spans (args);
+
+    // planar task rows are luma rows followed by uv rows
+    uint32_t work_rows = args->out_luma->get_height ();
+    if (_fixed_table.ptr () && _planar_mode)
+        work_rows += args->out_uv->get_height ();
+
+    param->in_buf.release ();
+    return start_map_task (args, 2, 2, args->out_luma->get_width (), work_rows);
+}
+
+template <typename E>
+static void
+set_plane (
+    typename XCamSoftTasks::GeoMapPlaneTask<E>::Args *args,
+    const SmartPtr<VideoBuffer> &in_buf, uint32_t in_idx, uint32_t in_step, uint32_t in_first,
+    const SmartPtr<VideoBuffer> &out_buf, uint32_t out_idx, uint32_t channels, uint32_t shift,
+    const E *fill)
+{
+    XCAM_ASSERT (args->plane_count < XCAM_GEO_MAP_MAX_PLANES);
+    typename XCamSoftTasks::GeoMapPlaneTask<E>::Plane &plane = args->planes[args->plane_count++];
+    plane.in = new SoftImage<E> (in_buf, in_idx);
+    plane.out = new SoftImage<E> (out_buf, out_idx);
+    plane.in_step = in_step;
+    plane.in_first = in_first;
+    plane.channels = channels;
+    plane.shift = shift;
+    for (uint32_t i = 0; i < channels; ++i)
+        plane.fill[i] = fill[i];
+}
+
+template <typename E>
+static SmartPtr<typename XCamSoftTasks::GeoMapPlaneTask<E>::Args>
+create_plane_args (const SmartPtr<ImageHandler::Parameters> &param, uint32_t in_format, uint32_t out_format)
+{
+    static const E luma_fill[1] = {0};
+    static const E uv_fill[2] = {(E)(1 << (sizeof (E) * 8 - 1)), (E)(1 << (sizeof (E) * 8 - 1))};
+    static const E rgba_fill[4] = {0, 0, 0, (E)(-1)};
+
+    const SmartPtr<VideoBuffer> &in = param->in_buf, &out = param->out_buf;
+    SmartPtr<typename XCamSoftTasks::GeoMapPlaneTask<E>::Args> args =
+        new typename XCamSoftTasks::GeoMapPlaneTask<E>::Args (param);
+
+    if (out_format == V4L2_PIX_FMT_RGBA32) {
+        set_plane<E> (args.ptr (), in, 0, 4, 0, out, 0, 4, 0, rgba_fill);
+        return args;
+    }
+
+    set_plane<E> (args.ptr (), in, 0, 1, 0, out, 0, 1, 0, luma_fill);
+    if (out_format == V4L2_PIX_FMT_P010) {
+        set_plane<E> (args.ptr (), in, 1, 2, 0, out, 1, 2, 1, uv_fill);
+    } else if (in_format == V4L2_PIX_FMT_NV12) {
+        // split interleaved uv into I420 planes
+        set_plane<E> (args.ptr (), in, 1, 2, 0, out, 1, 1, 1, uv_fill);
+        set_plane<E> (args.ptr (), in, 1, 2, 1, out, 2, 1, 1, uv_fill);
+    } else {
+        set_plane<E> (args.ptr (), in, 1, 1, 0, out, 1, 1, 1, uv_fill);
+        set_plane<E> (args.ptr (), in, 2, 1, 0, out, 2, 1, 1, uv_fill);
+    }
+    return args;
+}
+
+template <typename E>
+static uint32_t
+get_plane_rows (const SmartPtr<typename XCamSoftTasks::GeoMapPlaneTask<E>::Args> &args)
+{
+    uint32_t rows = 0;
+    for (uint32_t i = 0; i < args->plane_count; ++i)
+        rows += args->planes[i].out->get_height ();
+    return rows;
+}
 
-    set_work_size (2, 2, args->out_luma->get_width (), args->out_luma->get_height ());
+XCamReturn
+SoftGeoMapper::start_plane_task (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_fixed_table.ptr ());
+
+    uint32_t in_format = param->in_buf->get_video_info ().format;
+    const VideoBufferInfo &out_info = param->out_buf->get_video_info ();
+    SmartPtr<XCamSoftTasks::GeoMapFixedTask::Args> args;
+    uint32_t rows = 0;
+    if (out_info.format == V4L2_PIX_FMT_P010) {
+        SmartPtr<XCamSoftTasks::GeoMapPlaneTask<uint16_t>::Args> plane_args =
+            create_plane_args<uint16_t> (param, in_format, out_info.format);
+        rows = get_plane_rows<uint16_t> (plane_args);
+        args = plane_args;
+    } else {
+        SmartPtr<XCamSoftTasks::GeoMapPlaneTask<uint8_t>::Args> plane_args =
+            create_plane_args<uint8_t> (param, in_format, out_info.format);
+        rows = get_plane_rows<uint8_t> (plane_args);
+        args = plane_args;
+    }
+    args->fixed_table = _fixed_table;
 
     param->in_buf.release ();
-    return _map_task->work (args);
+    return start_map_task (args, 2, 2, out_info.width, rows);
 }
 
 XCamReturn
@@ -196,6 +705,11 @@ SoftGeoMapper::terminate ()
         _map_task->stop ();
         _map_task.release ();
     }
+    _fixed_table.release ();
+    _fixed_ref.release ();
+    _pending_table.release ();
+    _spans.release ();
+    _spans_table.release ();
     return SoftHandler::terminate ();
 }
 
@@ -244,6 +758,26 @@ SoftDualConstGeoMapper::~SoftDualConstGeoMapper ()
 {
 }
 
+bool
+SoftDualConstGeoMapper::enable_fixed_point (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !enable, false,
+        "SoftGeoMapper(%s) fixed point is not supported by dual factors", XCAM_STR(get_name ()));
+
+    return true;
+}
+
+bool
+SoftDualConstGeoMapper::enable_planar_mode (bool enable)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !enable, false,
+        "SoftGeoMapper(%s) planar mode is not supported by dual factors", XCAM_STR(get_name ()));
+
+    return true;
+}
+
 bool
 SoftDualConstGeoMapper::set_left_factors (float x, float y)
 {
@@ -341,8 +875,7 @@ SoftDualConstGeoMapper::prepare_arguments (
     args->out_luma = new UcharImage (out_buf, 0);
     args->out_uv = new Uchar2Image (out_buf, 1);
     args->lookup_table = lookup_table;
-
-    set_work_size (2, 2, args->out_luma->get_width (), args->out_luma->get_height ());
+    prepare_redirect (args, param);
 
     param->in_buf.release ();
     return XCAM_RETURN_NO_ERROR;
@@ -351,8 +884,7 @@ SoftDualConstGeoMapper::prepare_arguments (
 XCamReturn
 SoftDualConstGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameters> &param)
 {
-    SmartPtr<XCamSoftTasks::GeoMapTask> map_task = get_map_task ();
-    XCAM_ASSERT (map_task.ptr ());
+    XCAM_ASSERT (get_map_task ().ptr ());
 
     SmartPtr<XCamSoftTasks::GeoMapDualConstTask::Args> args =
         new XCamSoftTasks::GeoMapDualConstTask::Args (param);
@@ -360,7 +892,7 @@ SoftDualConstGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameter
 
     prepare_arguments (args, param);
 
-    return map_task->work (args);
+    return start_map_task (args, 2, 2, args->out_luma->get_width (), args->out_luma->get_height ());
 }
 
 void
@@ -422,7 +954,15 @@ SoftDualCurveGeoMapper::start_remap_task (const SmartPtr<ImageHandler::Parameter
 
     prepare_arguments (args, param);
 
-    return map_task->work (args);
+    // row tables are shared by all threads and rebuilt only on factor change
+    SmartPtr<XCamSoftTasks::GeoMapDualCurveTask> curve_task = map_task.dynamic_cast_ptr<XCamSoftTasks::GeoMapDualCurveTask> ();
+    XCAM_ASSERT (curve_task.ptr ());
+    args->curve_rows = curve_task->get_curve_rows (args->left_factor, args->right_factor, args->out_luma->get_height ());
+    XCAM_FAIL_RETURN (
+        ERROR, args->curve_rows.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "SoftGeoMapper(%s) dual curve row factors failed", XCAM_STR (get_name ()));
+
+    return start_map_task (args, 2, 2, args->out_luma->get_width (), args->out_luma->get_height ());
 }
 
 void
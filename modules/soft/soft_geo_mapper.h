@@ -25,11 +25,15 @@
 #include <interface/geo_mapper.h>
 #include <soft/soft_handler.h>
 #include <soft/soft_image.h>
+#include <shared_table_cache.h>
 
 namespace XCam {
 
 namespace XCamSoftTasks {
 class GeoMapTask;
+struct GeoMapSpans;
+class GeoMapFixedTask;
+class GeoMapPlanarTask;
 class GeoMapDualConstTask;
 class GeoMapDualCurveTask;
 };
@@ -37,12 +41,78 @@ class GeoMapDualCurveTask;
 class SoftGeoMapper
     : public SoftHandler, public GeoMapper
 {
+public:
+    struct RedirectArea {
+        Rect        in_area;    // area of remapped image
+        uint32_t    out_x;      // position in redirect buffer
+        uint32_t    out_y;
+
+        RedirectArea () : out_x (0), out_y (0) {}
+    };
+    typedef std::vector<RedirectArea> RedirectAreas;
+
+    struct RedirectParam : ImageHandler::Parameters {
+        SmartPtr<VideoBuffer>  redirect_buf;
+    };
+
 public:
     SoftGeoMapper (const char *name = "SoftGeoMapper");
     ~SoftGeoMapper ();
 
+    // pixels inside areas are remapped into RedirectParam::redirect_buf directly instead of out_buf,
+    // all positions and sizes need be even
+    bool set_redirect_areas (const RedirectAreas &areas);
+    const RedirectAreas &get_redirect_areas () const {
+        return _redirect_areas;
+    }
+
     bool set_lookup_table (const PointFloat2 *data, uint32_t width, uint32_t height);
 
+    // hash of all the next lookup table is built from, such as calibration and sizes, 0 by default.
+    // tables of the same key are shared by mappers in process, fixed point tables too
+    void set_table_key (uint64_t key) {
+        _table_key = key;
+    }
+    // sets the table shared under the key instead of set_lookup_table, false if none
+    bool use_shared_lookup_table ();
+
+    // table of a new config built in caller thread while frames keep the current one,
+    // fixed point table is expanded here too. size must be same as current table
+    bool prepare_lookup_table (const PointFloat2 *data, uint32_t width, uint32_t height);
+    // swap prepared table in, call between frames; false if nothing prepared
+    bool commit_lookup_table ();
+
+    // expand lookup table into full-resolution Q12.4 positions and interpolate with integer weights,
+    // need be set before configure, input width and height must be less than 2048.
+    // table is re-expanded whenever factors change
+    virtual bool enable_fixed_point (bool enable);
+    bool is_fixed_point () const {
+        return _fixed_point;
+    }
+
+    // map luma and uv planes as separate row grids instead of 8x2 blocks with interleaved uv,
+    // both read the full-resolution fixed point table which is expanded even without fixed point.
+    // need be set before configure
+    virtual bool enable_planar_mode (bool enable);
+    bool is_planar_mode () const {
+        return _planar_mode;
+    }
+
+    // output layout, 0 keeps input format. NV12, YUV420(I420), P010 and RGBA32 are mapped to
+    // the same format, NV12 can be written as YUV420 too. formats other than NV12 to NV12 run
+    // in planar mode on the fixed point table, so input need be less than 2048x2048 and
+    // redirect areas are ignored. need be set before configure
+    bool set_output_format (uint32_t fourcc);
+    uint32_t get_output_format () const {
+        return _out_format;
+    }
+
+    // on factor change, rows of the next fixed table expanded per frame while frames keep
+    // the current table, 0 expands the whole table at once
+    void set_fixed_update_rows (uint32_t rows) {
+        _fixed_update_rows = rows;
+    }
+
     //derived from SoftHandler
     virtual XCamReturn terminate ();
 
@@ -59,22 +129,62 @@ protected:
     XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     XCamReturn start_work (const SmartPtr<Parameters> &param);
 
-    void set_work_size (uint32_t thread_x, uint32_t thread_y, uint32_t luma_width, uint32_t luma_height);
+    XCamReturn start_map_task (
+        const SmartPtr<Worker::Arguments> &args,
+        uint32_t thread_x, uint32_t thread_y, uint32_t luma_width, uint32_t luma_height);
     SmartPtr<XCamSoftTasks::GeoMapTask> &get_map_task () {
         return _map_task;
     }
     SmartPtr<Float2Image> &get_lookup_table () {
         return _lookup_table;
     }
+    void prepare_redirect (const SmartPtr<Worker::Arguments> &args, const SmartPtr<ImageHandler::Parameters> &param);
+    // float lookup path without redirect areas, rebuilt whenever table, factors or sizes change
+    void prepare_spans (const SmartPtr<Worker::Arguments> &args);
 
 protected:
     virtual bool init_factors ();
     virtual SmartPtr<XCamSoftTasks::GeoMapTask> create_remap_task ();
     virtual XCamReturn start_remap_task (const SmartPtr<ImageHandler::Parameters> &param);
 
+private:
+    XCamReturn start_plane_task (const SmartPtr<ImageHandler::Parameters> &param);
+    bool init_fixed_table (const VideoBufferInfo &in_info, const VideoBufferInfo &out_info);
+    void expand_fixed_rows (
+        const SmartPtr<Float2Image> &lookup_table,
+        const SmartPtr<Short2Image> &table, const Float2 &factors, const VideoBufferInfo &out_info,
+        uint32_t start_y, uint32_t end_y);
+    bool update_fixed_table (const Float2 &factors, const VideoBufferInfo &out_info);
+    uint64_t get_fixed_table_key (const Float2 &factors, const VideoBufferInfo &out_info) const;
+
 private:
     SmartPtr<XCamSoftTasks::GeoMapTask>   _map_task;
     SmartPtr<Float2Image>                 _lookup_table;
+    SmartPtr<Short2Image>                 _fixed_table;
+    Float2                                _fixed_factors;
+    SmartPtr<Short2Image>                 _pending_table;
+    Float2                                _pending_factors;
+    uint32_t                              _pending_rows;
+    uint32_t                              _fixed_update_rows;
+    bool                                  _fixed_point;
+    bool                                  _planar_mode;
+    uint32_t                              _out_format;
+    bool                                  _plane_layout;
+    RedirectAreas                         _redirect_areas;
+    SmartPtr<XCamSoftTasks::GeoMapSpans>  _spans;
+    SmartPtr<Float2Image>                 _spans_table;
+    Float2                                _spans_factors;
+    uint32_t                              _spans_in_width;
+    uint32_t                              _spans_in_height;
+    uint64_t                              _table_key;
+    SharedTableRef                        _lookup_ref;
+    SharedTableRef                        _fixed_ref;
+
+    // guards prepared tables and _fixed_factors against prepare_lookup_table
+    Mutex                                 _next_mutex;
+    SmartPtr<Float2Image>                 _next_lookup_table;
+    SmartPtr<Short2Image>                 _next_fixed_table;
+    Float2                                _next_fixed_factors;
 };
 
 extern SmartPtr<SoftHandler> create_soft_geo_mapper ();
@@ -97,6 +207,9 @@ public:
         y = _right_factor_y;
     }
 
+    virtual bool enable_fixed_point (bool enable);
+    virtual bool enable_planar_mode (bool enable);
+
     virtual void remap_task_done (
         const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
 
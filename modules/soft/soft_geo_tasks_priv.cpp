@@ -19,6 +19,7 @@
  */
 
 #include "soft_geo_tasks_priv.h"
+#include <algorithm>
 
 namespace XCam {
 
@@ -43,6 +44,28 @@ inline void check_bound (const uint32_t &img_w, const uint32_t &img_h, Float2 *i
         bound = BoundCritical;
 }
 
+// all positions and their right and bottom neighbours in image, interpolation needs no border check
+inline bool
+is_interior (const uint32_t &img_w, const uint32_t &img_h, const Float2 *pos, const uint32_t &count)
+{
+    const float max_x = (float)img_w - 1.0f, max_y = (float)img_h - 1.0f;
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (!(pos[idx].x >= 0.0f && pos[idx].x < max_x && pos[idx].y >= 0.0f && pos[idx].y < max_y))
+            return false;
+    }
+    return true;
+}
+
+template <typename ImageT, typename O, uint32_t N>
+inline void
+read_interpolate (const ImageT *image, const uint32_t &img_w, const uint32_t &img_h, Float2 *pos, O *out)
+{
+    if (is_interior (img_w, img_h, pos, N))
+        image->template read_interpolate_array<O, N, SoftBorderNone> (pos, out);
+    else
+        image->template read_interpolate_array<O, N, SoftBorderNearest> (pos, out);
+}
+
 template <typename TypeT>
 inline void calc_critical_pixels (const uint32_t &img_w, const uint32_t &img_h, Float2 *in_pos,
     const uint32_t &max_idx, const TypeT &zero_byte, TypeT *luma)
@@ -53,13 +76,105 @@ inline void calc_critical_pixels (const uint32_t &img_w, const uint32_t &img_h,
     }
 }
 
+struct BlockOutput {
+    UcharImage     *luma;
+    Uchar2Image    *uv;
+    uint32_t        x, y;
+    bool            partial;
+};
+
+// choose where the 8 x height block at (out_x, out_y) is written
+inline void
+select_block_output (
+    const GeoMapTask::Args *args, const uint32_t &out_x, const uint32_t &out_y, const uint32_t &height,
+    BlockOutput &out)
+{
+    out.luma = args->out_luma.ptr ();
+    out.uv = args->out_uv.ptr ();
+    out.x = out_x;
+    out.y = out_y;
+    out.partial = false;
+
+    const SoftGeoMapper::RedirectAreas &areas = args->redirect_areas;
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const Rect &area = areas[i].in_area;
+        int32_t x0 = XCAM_MAX ((int32_t)out_x, area.pos_x), x1 = XCAM_MIN ((int32_t)out_x + 8, area.pos_x + area.width);
+        int32_t y0 = XCAM_MAX ((int32_t)out_y, area.pos_y), y1 = XCAM_MIN ((int32_t)(out_y + height), area.pos_y + area.height);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        if (x1 - x0 == 8 && y1 - y0 == (int32_t)height) {
+            out.luma = args->redirect_luma.ptr ();
+            out.uv = args->redirect_uv.ptr ();
+            out.x = out_x - area.pos_x + areas[i].out_x;
+            out.y = out_y - area.pos_y + areas[i].out_y;
+            return;
+        }
+        out.partial = true;
+    }
+}
+
+// block crosses redirect area borders, copy the pixels inside areas after mapping
+static void
+redirect_partial_luma (
+    const GeoMapTask::Args *args, const uint32_t &out_x, const uint32_t &out_y, const uint32_t &rows)
+{
+    const SoftGeoMapper::RedirectAreas &areas = args->redirect_areas;
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const Rect &area = areas[i].in_area;
+        int32_t x0 = XCAM_MAX ((int32_t)out_x, area.pos_x), x1 = XCAM_MIN ((int32_t)out_x + 8, area.pos_x + area.width);
+        int32_t y0 = XCAM_MAX ((int32_t)out_y, area.pos_y), y1 = XCAM_MIN ((int32_t)(out_y + rows), area.pos_y + area.height);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        int32_t dx = areas[i].out_x - area.pos_x, dy = areas[i].out_y - area.pos_y;
+        for (int32_t y = y0; y < y1; ++y) {
+            memcpy (
+                args->redirect_luma->get_buf_ptr (x0 + dx, y + dy), args->out_luma->get_buf_ptr (x0, y),
+                (x1 - x0) * sizeof (Uchar));
+        }
+    }
+}
+
+// uv row of the 8x2 luma block at (out_x, out_y)
+static void
+redirect_partial_uv (const GeoMapTask::Args *args, const uint32_t &out_x, const uint32_t &out_y)
+{
+    const SoftGeoMapper::RedirectAreas &areas = args->redirect_areas;
+    for (uint32_t i = 0; i < areas.size (); ++i) {
+        const Rect &area = areas[i].in_area;
+        int32_t x0 = XCAM_MAX ((int32_t)out_x, area.pos_x), x1 = XCAM_MIN ((int32_t)out_x + 8, area.pos_x + area.width);
+        int32_t y0 = XCAM_MAX ((int32_t)out_y, area.pos_y), y1 = XCAM_MIN ((int32_t)out_y + 2, area.pos_y + area.height);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        // area positions are even, uv row is the one of 1st-line
+        int32_t dx = areas[i].out_x - area.pos_x, dy = areas[i].out_y - area.pos_y;
+        if (y0 == (int32_t)out_y) {
+            const Uchar2 *src = args->out_uv->get_buf_ptr (x0 / 2, y0 / 2);
+            std::copy (src, src + (x1 - x0) / 2, args->redirect_uv->get_buf_ptr ((x0 + dx) / 2, (y0 + dy) / 2));
+        }
+    }
+}
+
+static void
+redirect_partial_block (const GeoMapTask::Args *args, const uint32_t &out_x, const uint32_t &out_y)
+{
+    redirect_partial_luma (args, out_x, out_y, 2);
+    redirect_partial_uv (args, out_x, out_y);
+}
+
 static void map_image (
     const UcharImage *in_luma, const Uchar2Image *in_uv,
-    UcharImage *out_luma, Uchar2Image *out_uv, const Float2Image *lut,
+    const BlockOutput &out, const Float2Image *lut,
     const uint32_t &luma_w, const uint32_t &luma_h, const uint32_t &uv_w, const uint32_t &uv_h,
-    const uint32_t &x_idx, const uint32_t &y_idx, const uint32_t &out_x, const uint32_t &out_y,
     const Float2 &first, const Float2 &step, const Uchar *zero_luma_byte, const Uchar2 *zero_uv_byte)
 {
+    const uint32_t lut_w = lut->get_width (), lut_h = lut->get_height ();
+    UcharImage *out_luma = out.luma;
+    Uchar2Image *out_uv = out.uv;
+    const uint32_t &out_x = out.x, &out_y = out.y;
+
     Float2 lut_pos[8] = {
         first, Float2(first.x + step.x, first.y),
         Float2(first.x + step.x * 2, first.y), Float2(first.x + step.x * 3, first.y),
@@ -72,12 +187,12 @@ static void map_image (
     float  luma_value[8];
     Uchar  luma_uc[8];
     BoundState bound = BoundInternal;
-    lut->read_interpolate_array<Float2, 8> (lut_pos, in_pos);
+    read_interpolate<Float2Image, Float2, 8> (lut, lut_w, lut_h, lut_pos, in_pos);
     check_bound (luma_w, luma_h, in_pos, 7, bound);
     if (bound == BoundExternal)
         out_luma->write_array_no_check<8> (out_x, out_y, zero_luma_byte);
     else {
-        in_luma->read_interpolate_array<float, 8> (in_pos, luma_value);
+        read_interpolate<UcharImage, float, 8> (in_luma, luma_w, luma_h, in_pos, luma_value);
         convert_to_uchar_N<float, 8> (luma_value, luma_uc);
         if (bound == BoundCritical)
             calc_critical_pixels (luma_w, luma_h, in_pos, 8, zero_luma_byte[0], luma_uc);
@@ -93,24 +208,24 @@ static void map_image (
     in_pos[3] = in_pos[6] / 2.0f;
     check_bound (uv_w, uv_h, in_pos, 3, bound);
     if (bound == BoundExternal)
-        out_uv->write_array_no_check<4> (x_idx * 4, y_idx, zero_uv_byte);
+        out_uv->write_array_no_check<4> (out_x / 2, out_y / 2, zero_uv_byte);
     else {
-        in_uv->read_interpolate_array<Float2, 4> (in_pos, uv_value);
+        read_interpolate<Uchar2Image, Float2, 4> (in_uv, uv_w, uv_h, in_pos, uv_value);
         convert_to_uchar2_N<Float2, 4> (uv_value, uv_uc);
         if (bound == BoundCritical)
             calc_critical_pixels (uv_w, uv_h, in_pos, 4, zero_uv_byte[0], uv_uc);
-        out_uv->write_array_no_check<4> (x_idx * 4, y_idx, uv_uc);
+        out_uv->write_array_no_check<4> (out_x / 2, out_y / 2, uv_uc);
     }
 
     //2nd-line luma
     lut_pos[0].y = lut_pos[1].y = lut_pos[2].y = lut_pos[3].y = lut_pos[4].y = lut_pos[5].y =
                                   lut_pos[6].y = lut_pos[7].y = first.y + step.y;
-    lut->read_interpolate_array<Float2, 8> (lut_pos, in_pos);
+    read_interpolate<Float2Image, Float2, 8> (lut, lut_w, lut_h, lut_pos, in_pos);
     check_bound (luma_w, luma_h, in_pos, 7, bound);
     if (bound == BoundExternal)
         out_luma->write_array_no_check<8> (out_x, out_y + 1, zero_luma_byte);
     else {
-        in_luma->read_interpolate_array<float, 8> (in_pos, luma_value);
+        read_interpolate<UcharImage, float, 8> (in_luma, luma_w, luma_h, in_pos, luma_value);
         convert_to_uchar_N<float, 8> (luma_value, luma_uc);
         if (bound == BoundCritical)
             calc_critical_pixels (luma_w, luma_h, in_pos, 8, zero_luma_byte[0], luma_uc);
@@ -118,58 +233,433 @@ static void map_image (
     }
 }
 
-XCamReturn
-GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+// per dispatch constants of 8x2 blocks, positions are center aligned
+struct BlockMapping {
+    Float2      factors;
+    Float2      step;
+    Float2      out_center;
+    Float2      lut_center;
+
+    BlockMapping (const Float2 &f, const uint32_t &out_w, const uint32_t &out_h, const Float2Image *lut)
+        : factors (f)
+        , step (Float2 (1.0f, 1.0f) / f)
+        , out_center ((out_w - 1.0f) / 2.0f, (out_h - 1.0f) / 2.0f)
+        , lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f)
+    {}
+
+    Float2 get_first (const uint32_t &out_x, const uint32_t &out_y) const {
+        Float2 out_pos (out_x, out_y);
+        out_pos -= out_center;
+        Float2 first = out_pos / factors;
+        first += lut_center;
+        return first;
+    }
+};
+
+static void
+map_blocks (
+    const GeoMapTask::Args *args, const BlockMapping &mapping, const uint32_t &y,
+    const uint32_t &x_begin, const uint32_t &x_end)
 {
     static const Uchar zero_luma_byte[8] = {0, 0, 0, 0, 0, 0, 0, 0};
     static const Uchar2 zero_uv_byte[4] = {{128, 128}, {128, 128}, {128, 128}, {128, 128}};
-    SmartPtr<GeoMapTask::Args> args = base.dynamic_cast_ptr<GeoMapTask::Args> ();
+
+    const UcharImage *in_luma = args->in_luma.ptr ();
+    const Uchar2Image *in_uv = args->in_uv.ptr ();
+    const Float2Image *lut = args->lookup_table.ptr ();
+    uint32_t luma_w = in_luma->get_width ();
+    uint32_t luma_h = in_luma->get_height ();
+    uint32_t uv_w = in_uv->get_width ();
+    uint32_t uv_h = in_uv->get_height ();
+
+    for (uint32_t x = x_begin; x < x_end; ++x) {
+        uint32_t out_x = x * 8, out_y = y * 2;
+
+        BlockOutput out;
+        select_block_output (args, out_x, out_y, 2, out);
+        map_image (in_luma, in_uv, out, lut, luma_w, luma_h, uv_w, uv_h,
+                   mapping.get_first (out_x, out_y), mapping.step, zero_luma_byte, zero_uv_byte);
+        if (out.partial)
+            redirect_partial_block (args, out_x, out_y);
+    }
+}
+
+// blocks mapped outside input, same values as map_image writes, uv bytes are all 128
+static void
+fill_blocks (const GeoMapTask::Args *args, const uint32_t &y, const uint32_t &x_begin, const uint32_t &x_end)
+{
+    if (x_begin >= x_end)
+        return;
+
+    uint32_t len = (x_end - x_begin) * 8;
+    memset (args->out_luma->get_buf_ptr (x_begin * 8, y * 2), 0, len);
+    memset (args->out_luma->get_buf_ptr (x_begin * 8, y * 2 + 1), 0, len);
+    Uchar2 *uv = args->out_uv->get_buf_ptr (x_begin * 4, y);
+    std::fill (uv, uv + len / 2, Uchar2 (128, 128));
+}
+
+SmartPtr<GeoMapSpans>
+GeoMapTask::build_spans (
+    const SmartPtr<Float2Image> &lookup_table, const Float2 &factors,
+    uint32_t in_w, uint32_t in_h, uint32_t out_w, uint32_t out_h)
+{
+    XCAM_ASSERT (lookup_table.ptr ());
+    const Float2Image *lut = lookup_table.ptr ();
+    BlockMapping mapping (factors, out_w, out_h, lut);
+    uint32_t lut_w = lut->get_width (), lut_h = lut->get_height ();
+    uint32_t blocks_x = xcam_ceil (out_w, 8) / 8, blocks_y = xcam_ceil (out_h, 2) / 2;
+
+    SmartPtr<GeoMapSpans> spans = new GeoMapSpans;
+    spans->offsets.reserve (blocks_y + 1);
+    spans->offsets.push_back (0);
+    spans->in_rows.reserve (blocks_y);
+    float max_y = -1.0f;
+
+    for (uint32_t y = 0; y < blocks_y; ++y) {
+        bool in_span = false;
+        for (uint32_t x = 0; x < blocks_x; ++x) {
+            // same positions as map_image, a block is dead only if all 16 luma pixels are outside
+            Float2 first = mapping.get_first (x * 8, y * 2);
+            bool valid = false;
+            for (uint32_t row = 0; row < 2; ++row) {
+                Float2 lut_pos[8], in_pos[8];
+                float pos_y = row ? first.y + mapping.step.y : first.y;
+                lut_pos[0] = Float2 (first.x, pos_y);
+                for (uint32_t i = 1; i < 8; ++i)
+                    lut_pos[i] = Float2 (first.x + mapping.step.x * i, pos_y);
+
+                read_interpolate<Float2Image, Float2, 8> (lut, lut_w, lut_h, lut_pos, in_pos);
+                for (uint32_t i = 0; i < 8; ++i) {
+                    if (in_pos[i].x < 0.0f || in_pos[i].x >= in_w ||
+                            in_pos[i].y < 0.0f || in_pos[i].y >= in_h)
+                        continue;
+                    valid = true;
+                    max_y = XCAM_MAX (max_y, in_pos[i].y);
+                }
+            }
+
+            if (valid && !in_span)
+                spans->spans.push_back (GeoMapSpans::Span (x, x + 1));
+            else if (valid)
+                spans->spans.back ().end = x + 1;
+            in_span = valid;
+        }
+        spans->offsets.push_back (spans->spans.size ());
+
+        // bilinear neighbours, and the uv row of the lower luma row pair
+        uint32_t rows = max_y < 0.0f ? 0 : (uint32_t)max_y + 4;
+        spans->in_rows.push_back (XCAM_MIN (rows, in_h));
+    }
+
+    return spans;
+}
+
+uint32_t
+GeoMapTask::get_input_rows (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<GeoMapTask::Args> args = base.static_cast_ptr<GeoMapTask::Args> ();
     XCAM_ASSERT (args.ptr ());
 
-    UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
-    Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
-    Float2Image *lut = args->lookup_table.ptr ();
-    XCAM_ASSERT (in_luma && in_uv);
-    XCAM_ASSERT (out_luma && out_uv);
-    XCAM_ASSERT (lut);
+    const GeoMapSpans *spans = args->spans.ptr ();
+    uint32_t end_y = range.pos[1] + range.pos_len[1];
+    // whole input without spans
+    if (!spans || !end_y || end_y > spans->in_rows.size ())
+        return UINT32_MAX;
+
+    return spans->in_rows[end_y - 1];
+}
+
+XCamReturn
+GeoMapTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<GeoMapTask::Args> args = base.static_cast_ptr<GeoMapTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    XCAM_ASSERT (args->in_luma.ptr () && args->in_uv.ptr ());
+    XCAM_ASSERT (args->out_luma.ptr () && args->out_uv.ptr ());
+    XCAM_ASSERT (args->lookup_table.ptr ());
 
     Float2 factors = args->factors;
     XCAM_ASSERT (!XCAM_DOUBLE_EQUAL_AROUND (factors.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factors.y, 0.0f));
 
-    Float2 step = Float2(1.0f, 1.0f) / factors;
+    BlockMapping mapping (
+        factors, args->out_luma->get_width (), args->out_luma->get_height (), args->lookup_table.ptr ());
 
-    Float2 out_center ((out_luma->get_width () - 1.0f ) / 2.0f, (out_luma->get_height () - 1.0f ) / 2.0f);
-    Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
+    const GeoMapSpans *spans = args->spans.ptr ();
+    XCAM_ASSERT (!spans || args->redirect_areas.empty ());
+    uint32_t x_begin = range.pos[0], x_end = range.pos[0] + range.pos_len[0];
 
-    uint32_t luma_w = in_luma->get_width ();
-    uint32_t luma_h = in_luma->get_height ();
-    uint32_t uv_w = in_uv->get_width ();
-    uint32_t uv_h = in_uv->get_height ();
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        if (!spans || y >= spans->get_rows ()) {
+            map_blocks (args.ptr (), mapping, y, x_begin, x_end);
+            continue;
+        }
+
+        uint32_t x = x_begin;
+        for (uint32_t i = spans->offsets[y]; i < spans->offsets[y + 1]; ++i) {
+            const GeoMapSpans::Span &span = spans->spans[i];
+            uint32_t begin = XCAM_CLAMP (span.begin, x, x_end), end = XCAM_CLAMP (span.end, x, x_end);
+            fill_blocks (args.ptr (), y, x, begin);
+            map_blocks (args.ptr (), mapping, y, begin, end);
+            x = end;
+        }
+        fill_blocks (args.ptr (), y, x, x_end);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+#define XCAM_GEO_FIXED_BITS 4
+#define XCAM_GEO_FIXED_ONE (1 << XCAM_GEO_FIXED_BITS)
+#define XCAM_GEO_FIXED_MASK (XCAM_GEO_FIXED_ONE - 1)
+#define XCAM_GEO_FIXED_WEIGHT_ROUND (1 << (XCAM_GEO_FIXED_BITS * 2 - 1))
+
+inline bool
+calc_fixed_weights (
+    const Short2 &pos, const int32_t &img_w, const int32_t &img_h,
+    int32_t &x0, int32_t &y0, int32_t &x1, int32_t &y1, int32_t *weights)
+{
+    if (pos.x < 0 || pos.y < 0)
+        return false;
+
+    x0 = pos.x >> XCAM_GEO_FIXED_BITS;
+    y0 = pos.y >> XCAM_GEO_FIXED_BITS;
+    if (x0 >= img_w || y0 >= img_h)
+        return false;
+
+    x1 = XCAM_MIN (x0 + 1, img_w - 1);
+    y1 = XCAM_MIN (y0 + 1, img_h - 1);
+
+    int32_t fx = pos.x & XCAM_GEO_FIXED_MASK, fy = pos.y & XCAM_GEO_FIXED_MASK;
+    weights[0] = (XCAM_GEO_FIXED_ONE - fx) * (XCAM_GEO_FIXED_ONE - fy);
+    weights[1] = fx * (XCAM_GEO_FIXED_ONE - fy);
+    weights[2] = (XCAM_GEO_FIXED_ONE - fx) * fy;
+    weights[3] = fx * fy;
+    return true;
+}
+
+inline Uchar
+interpolate_fixed (const UcharImage *image, const Short2 &pos, const Uchar &zero_byte)
+{
+    int32_t x0, y0, x1, y1, w[4];
+    if (!calc_fixed_weights (pos, image->get_width (), image->get_height (), x0, y0, x1, y1, w))
+        return zero_byte;
+
+    const Uchar *top = image->get_buf_ptr (0, y0);
+    const Uchar *bottom = image->get_buf_ptr (0, y1);
+    int32_t value = top[x0] * w[0] + top[x1] * w[1] + bottom[x0] * w[2] + bottom[x1] * w[3];
+    return (Uchar)((value + XCAM_GEO_FIXED_WEIGHT_ROUND) >> (XCAM_GEO_FIXED_BITS * 2));
+}
+
+inline Uchar2
+interpolate_fixed (const Uchar2Image *image, const Short2 &pos, const Uchar2 &zero_byte)
+{
+    int32_t x0, y0, x1, y1, w[4];
+    if (!calc_fixed_weights (pos, image->get_width (), image->get_height (), x0, y0, x1, y1, w))
+        return zero_byte;
+
+    const Uchar2 *top = image->get_buf_ptr (0, y0);
+    const Uchar2 *bottom = image->get_buf_ptr (0, y1);
+    int32_t u = top[x0].x * w[0] + top[x1].x * w[1] + bottom[x0].x * w[2] + bottom[x1].x * w[3];
+    int32_t v = top[x0].y * w[0] + top[x1].y * w[1] + bottom[x0].y * w[2] + bottom[x1].y * w[3];
+    return Uchar2 (
+        (Uchar)((u + XCAM_GEO_FIXED_WEIGHT_ROUND) >> (XCAM_GEO_FIXED_BITS * 2)),
+        (Uchar)((v + XCAM_GEO_FIXED_WEIGHT_ROUND) >> (XCAM_GEO_FIXED_BITS * 2)));
+}
+
+XCamReturn
+GeoMapFixedTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    static const Uchar zero_luma_byte = 0;
+    static const Uchar2 zero_uv_byte = {128, 128};
+    SmartPtr<GeoMapFixedTask::Args> args = base.static_cast_ptr<GeoMapFixedTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
+    Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
+    Short2Image *table = args->fixed_table.ptr ();
+    XCAM_ASSERT (in_luma && in_uv);
+    XCAM_ASSERT (out_luma && out_uv);
+    XCAM_ASSERT (table);
 
     for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y)
         for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
         {
             uint32_t out_x = x * 8, out_y = y * 2;
+            XCAM_ASSERT (out_x + 8 <= table->get_width () && out_y + 2 <= table->get_height ());
+
+            BlockOutput out;
+            select_block_output (args.ptr (), out_x, out_y, 2, out);
+
+            const Short2 *pos = table->get_buf_ptr (out_x, out_y);
+            Uchar luma_uc[8];
+            for (uint32_t i = 0; i < 8; ++i)
+                luma_uc[i] = interpolate_fixed (in_luma, pos[i], zero_luma_byte);
+            out.luma->write_array_no_check<8> (out.x, out.y, luma_uc);
+
+            // 4x1 UV, sampled at even luma positions of 1st-line
+            Uchar2 uv_uc[4];
+            for (uint32_t i = 0; i < 4; ++i) {
+                Short2 uv_pos (pos[i * 2].x >> 1, pos[i * 2].y >> 1);
+                uv_uc[i] = interpolate_fixed (in_uv, uv_pos, zero_uv_byte);
+            }
+            out.uv->write_array_no_check<4> (out.x / 2, out.y / 2, uv_uc);
+
+            pos = table->get_buf_ptr (out_x, out_y + 1);
+            for (uint32_t i = 0; i < 8; ++i)
+                luma_uc[i] = interpolate_fixed (in_luma, pos[i], zero_luma_byte);
+            out.luma->write_array_no_check<8> (out.x, out.y + 1, luma_uc);
+
+            if (out.partial)
+                redirect_partial_block (args.ptr (), out_x, out_y);
+        }
 
-            // calculate 8x2 luma, center aligned
-            Float2 out_pos (out_x, out_y);
-            out_pos -= out_center;
-            Float2 first = out_pos / factors;
-            first += lut_center;
+    return XCAM_RETURN_NO_ERROR;
+}
 
-            map_image (in_luma, in_uv, out_luma, out_uv, lut, luma_w, luma_h, uv_w, uv_h,
-                       x, y, out_x, out_y, first, step, zero_luma_byte, zero_uv_byte);
+XCamReturn
+GeoMapPlanarTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    static const Uchar zero_luma_byte = 0;
+    static const Uchar2 zero_uv_byte = {128, 128};
+    SmartPtr<GeoMapFixedTask::Args> args = base.static_cast_ptr<GeoMapFixedTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
+    Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
+    Short2Image *table = args->fixed_table.ptr ();
+    XCAM_ASSERT (in_luma && in_uv);
+    XCAM_ASSERT (out_luma && out_uv);
+    XCAM_ASSERT (table);
+
+    const uint32_t luma_rows = out_luma->get_height ();
+    XCAM_ASSERT (luma_rows <= table->get_height ());
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        if (y < luma_rows) {
+            const Short2 *line = table->get_buf_ptr (0, y);
+            for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
+                uint32_t out_x = x * 8;
+                XCAM_ASSERT (out_x + 8 <= table->get_width ());
+
+                BlockOutput out;
+                select_block_output (args.ptr (), out_x, y, 1, out);
+
+                const Short2 *pos = line + out_x;
+                Uchar luma_uc[8];
+                for (uint32_t i = 0; i < 8; ++i)
+                    luma_uc[i] = interpolate_fixed (in_luma, pos[i], zero_luma_byte);
+                out.luma->write_array_no_check<8> (out.x, out.y, luma_uc);
+
+                if (out.partial)
+                    redirect_partial_luma (args.ptr (), out_x, y, 1);
+            }
+            continue;
         }
 
+        // uv rows sample even luma positions of even table rows
+        uint32_t luma_y = (y - luma_rows) * 2;
+        XCAM_ASSERT (luma_y + 2 <= table->get_height ());
+        const Short2 *line = table->get_buf_ptr (0, luma_y);
+        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
+            uint32_t out_x = x * 8;
+
+            BlockOutput out;
+            select_block_output (args.ptr (), out_x, luma_y, 2, out);
+
+            const Short2 *pos = line + out_x;
+            Uchar2 uv_uc[4];
+            for (uint32_t i = 0; i < 4; ++i) {
+                Short2 uv_pos (pos[i * 2].x >> 1, pos[i * 2].y >> 1);
+                uv_uc[i] = interpolate_fixed (in_uv, uv_pos, zero_uv_byte);
+            }
+            out.uv->write_array_no_check<4> (out.x / 2, out.y / 2, uv_uc);
+
+            if (out.partial)
+                redirect_partial_uv (args.ptr (), out_x, luma_y);
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+template <typename E>
+inline void
+interpolate_fixed_samples (
+    const SoftImage<E> *image, const uint32_t step, const uint32_t first, const uint32_t channels,
+    const Short2 &pos, const E *fill, E *out)
+{
+    int32_t x0, y0, x1, y1, w[4];
+    if (!calc_fixed_weights (pos, image->get_width () / step, image->get_height (), x0, y0, x1, y1, w)) {
+        for (uint32_t c = 0; c < channels; ++c)
+            out[c] = fill[c];
+        return;
+    }
+
+    const E *top = image->get_buf_ptr (first, y0), *bottom = image->get_buf_ptr (first, y1);
+    x0 *= step;
+    x1 *= step;
+    for (uint32_t c = 0; c < channels; ++c) {
+        int32_t value = top[x0 + c] * w[0] + top[x1 + c] * w[1] + bottom[x0 + c] * w[2] + bottom[x1 + c] * w[3];
+        out[c] = (E)((value + XCAM_GEO_FIXED_WEIGHT_ROUND) >> (XCAM_GEO_FIXED_BITS * 2));
+    }
+}
+
+template <typename E>
+XCamReturn
+GeoMapPlaneTask<E>::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<Args> args = base.template static_cast_ptr<Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    Short2Image *table = args->fixed_table.ptr ();
+    XCAM_ASSERT (table);
+    XCAM_ASSERT (args->plane_count > 0 && args->plane_count <= XCAM_GEO_MAP_MAX_PLANES);
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        uint32_t idx = 0, row = y;
+        while (idx + 1 < args->plane_count && row >= args->planes[idx].out->get_height ()) {
+            row -= args->planes[idx].out->get_height ();
+            ++idx;
+        }
+        const Plane &plane = args->planes[idx];
+        if (row >= plane.out->get_height ())
+            continue;
+
+        // half-resolution planes sample even luma positions of even table rows
+        const uint32_t table_y = row << plane.shift;
+        const uint32_t count = 8 >> plane.shift;
+        XCAM_ASSERT (table_y < table->get_height ());
+        const Short2 *line = table->get_buf_ptr (0, table_y);
+        const SoftImage<E> *in = plane.in.ptr ();
+
+        for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x) {
+            uint32_t out_x = x * 8;
+            XCAM_ASSERT (out_x + 8 <= table->get_width ());
+
+            const Short2 *pos = line + out_x;
+            E *out = plane.out->get_buf_ptr ((out_x >> plane.shift) * plane.channels, row);
+            for (uint32_t i = 0; i < count; ++i) {
+                const Short2 &p = pos[i << plane.shift];
+                Short2 in_pos (p.x >> plane.shift, p.y >> plane.shift);
+                interpolate_fixed_samples (
+                    in, plane.in_step, plane.in_first, plane.channels, in_pos, plane.fill, out + i * plane.channels);
+            }
+        }
+    }
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+template class GeoMapPlaneTask<uint8_t>;
+template class GeoMapPlaneTask<uint16_t>;
+
 XCamReturn
 GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
 {
     static const Uchar zero_luma_byte[8] = {0, 0, 0, 0, 0, 0, 0, 0};
     static const Uchar2 zero_uv_byte[4] = {{128, 128}, {128, 128}, {128, 128}, {128, 128}};
-    SmartPtr<GeoMapDualConstTask::Args> args = base.dynamic_cast_ptr<GeoMapDualConstTask::Args> ();
+    SmartPtr<GeoMapDualConstTask::Args> args = base.static_cast_ptr<GeoMapDualConstTask::Args> ();
     XCAM_ASSERT (args.ptr ());
 
     UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
@@ -209,8 +699,12 @@ GeoMapDualConstTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
             Float2 first = out_pos / factor;
             first += lut_center;
 
-            map_image (in_luma, in_uv, out_luma, out_uv, lut, luma_w, luma_h, uv_w, uv_h,
-                       x, y, out_x, out_y, first, step, zero_luma_byte, zero_uv_byte);
+            BlockOutput out;
+            select_block_output (args.ptr (), out_x, out_y, 2, out);
+            map_image (in_luma, in_uv, out, lut, luma_w, luma_h, uv_w, uv_h,
+                       first, step, zero_luma_byte, zero_uv_byte);
+            if (out.partial)
+                redirect_partial_block (args.ptr (), out_x, out_y);
         }
 
     return XCAM_RETURN_NO_ERROR;
@@ -221,31 +715,11 @@ GeoMapDualCurveTask::GeoMapDualCurveTask (const SmartPtr<Worker::Callback> &cb)
     , _scaled_height (0.0f)
     , _left_std_factor (0.0f, 0.0f)
     , _right_std_factor (0.0f, 0.0f)
-    , _left_factors (NULL)
-    , _right_factors (NULL)
-    , _left_steps (NULL)
-    , _right_steps (NULL)
 {
     set_work_uint (8, 2);
 }
 
 GeoMapDualCurveTask::~GeoMapDualCurveTask () {
-    if (_left_factors) {
-        delete [] _left_factors;
-        _left_factors = NULL;
-    }
-    if (_right_factors) {
-        delete [] _right_factors;
-        _right_factors = NULL;
-    }
-    if (_left_steps) {
-        delete [] _left_steps;
-        _left_steps = NULL;
-    }
-    if (_right_steps) {
-        delete [] _right_steps;
-        _right_steps = NULL;
-    }
 }
 
 void
@@ -254,6 +728,7 @@ GeoMapDualCurveTask::set_left_std_factor (float x, float y) {
 
     _left_std_factor.x = x;
     _left_std_factor.y = y;
+    _curve_rows.release ();
 }
 
 void
@@ -262,6 +737,7 @@ GeoMapDualCurveTask::set_right_std_factor (float x, float y) {
 
     _right_std_factor.x = x;
     _right_std_factor.y = y;
+    _curve_rows.release ();
 }
 
 static void calc_cur_row_factor (
@@ -278,51 +754,48 @@ static void calc_cur_row_factor (
     cur_row_factor.y = factor.y;
 }
 
-void
-GeoMapDualCurveTask::set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size) {
-    if (_left_factors == NULL) {
-        _left_factors = new Float2[size];
-        XCAM_ASSERT (_left_factors);
-    }
-    if (_right_factors == NULL) {
-        _right_factors = new Float2[size];
-        XCAM_ASSERT (_right_factors);
-    }
-
-    float ym = _scaled_height * 0.5f;
-    for (uint32_t y = 0; y < size; ++y) {
-        calc_cur_row_factor (y, ym, _left_std_factor, _scaled_height, args->left_factor, _left_factors[y]);
-        calc_cur_row_factor (y, ym, _right_std_factor, _scaled_height, args->right_factor, _right_factors[y]);
-    }
+static inline bool
+is_factor_valid (const Float2 &factor)
+{
+    return !XCAM_DOUBLE_EQUAL_AROUND (factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (factor.y, 0.0f);
 }
 
-bool
-GeoMapDualCurveTask::set_steps (uint32_t size) {
-    if (_left_steps == NULL) {
-        _left_steps =  new Float2[size];
-        XCAM_ASSERT (_left_steps);
-    }
-    if (_right_steps == NULL) {
-        _right_steps =  new Float2[size];
-        XCAM_ASSERT (_right_steps);
-    }
+SmartPtr<GeoMapCurveRows>
+GeoMapDualCurveTask::get_curve_rows (const Float2 &left_factor, const Float2 &right_factor, uint32_t rows)
+{
+    if (_curve_rows.ptr () && _curve_rows->left_factors.size () == rows &&
+            XCAM_DOUBLE_EQUAL_AROUND (_curve_rows->left_factor.x, left_factor.x) &&
+            XCAM_DOUBLE_EQUAL_AROUND (_curve_rows->left_factor.y, left_factor.y) &&
+            XCAM_DOUBLE_EQUAL_AROUND (_curve_rows->right_factor.x, right_factor.x) &&
+            XCAM_DOUBLE_EQUAL_AROUND (_curve_rows->right_factor.y, right_factor.y))
+        return _curve_rows;
+
+    SmartPtr<GeoMapCurveRows> curve_rows = new GeoMapCurveRows;
+    curve_rows->left_factor = left_factor;
+    curve_rows->right_factor = right_factor;
+    curve_rows->left_factors.resize (rows);
+    curve_rows->right_factors.resize (rows);
+    curve_rows->left_steps.resize (rows);
+    curve_rows->right_steps.resize (rows);
+
+    float ym = _scaled_height * 0.5f;
+    for (uint32_t y = 0; y < rows; ++y) {
+        Float2 &left = curve_rows->left_factors[y];
+        Float2 &right = curve_rows->right_factors[y];
+        calc_cur_row_factor (y, ym, _left_std_factor, _scaled_height, left_factor, left);
+        calc_cur_row_factor (y, ym, _right_std_factor, _scaled_height, right_factor, right);
 
-    for (uint32_t y = 0; y < size; ++y) {
         XCAM_FAIL_RETURN (
-            ERROR,
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_left_factors[y].y, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].x, 0.0f) &&
-            !XCAM_DOUBLE_EQUAL_AROUND (_right_factors[y].y, 0.0f),
-            false,
+            ERROR, is_factor_valid (left) && is_factor_valid (right), NULL,
             "GeoMapDualCurveTask invalid factor(row:%d): left_factor(x:%f, y:%f) right_factor(x:%f, y:%f)",
-            y, _left_factors[y].x, _left_factors[y].y, _right_factors[y].x, _right_factors[y].y);
+            y, left.x, left.y, right.x, right.y);
 
-        _left_steps[y] = Float2(1.0f, 1.0f) / _left_factors[y];
-        _right_steps[y] = Float2(1.0f, 1.0f) / _right_factors[y];
+        curve_rows->left_steps[y] = Float2(1.0f, 1.0f) / left;
+        curve_rows->right_steps[y] = Float2(1.0f, 1.0f) / right;
     }
 
-    return true;
+    _curve_rows = curve_rows;
+    return curve_rows;
 }
 
 XCamReturn
@@ -330,21 +803,17 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
 {
     static const Uchar zero_luma_byte[8] = {0, 0, 0, 0, 0, 0, 0, 0};
     static const Uchar2 zero_uv_byte[4] = {{128, 128}, {128, 128}, {128, 128}, {128, 128}};
-    SmartPtr<GeoMapDualCurveTask::Args> args = base.dynamic_cast_ptr<GeoMapDualCurveTask::Args> ();
+    SmartPtr<GeoMapDualCurveTask::Args> args = base.static_cast_ptr<GeoMapDualCurveTask::Args> ();
     XCAM_ASSERT (args.ptr ());
-    XCAM_ASSERT (
-        !XCAM_DOUBLE_EQUAL_AROUND (args->left_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (args->left_factor.y, 0.0f) &&
-        !XCAM_DOUBLE_EQUAL_AROUND (args->right_factor.x, 0.0f) && !XCAM_DOUBLE_EQUAL_AROUND (args->right_factor.y, 0.0f));
 
     UcharImage *in_luma = args->in_luma.ptr (), *out_luma = args->out_luma.ptr ();
     Uchar2Image *in_uv = args->in_uv.ptr (), *out_uv = args->out_uv.ptr ();
     Float2Image *lut = args->lookup_table.ptr ();
+    const GeoMapCurveRows *curve_rows = args->curve_rows.ptr ();
     XCAM_ASSERT (in_luma && in_uv);
     XCAM_ASSERT (out_luma && out_uv);
     XCAM_ASSERT (lut);
-
-    set_factors (args, out_luma->get_height ());
-    set_steps (out_luma->get_height ());
+    XCAM_ASSERT (curve_rows && curve_rows->left_factors.size () == out_luma->get_height ());
 
     Float2 out_center ((out_luma->get_width () - 1.0f ) / 2.0f, (out_luma->get_height () - 1.0f ) / 2.0f);
     Float2 lut_center ((lut->get_width () - 1.0f) / 2.0f, (lut->get_height () - 1.0f) / 2.0f);
@@ -358,8 +827,9 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
         for (uint32_t x = range.pos[0]; x < range.pos[0] + range.pos_len[0]; ++x)
         {
             uint32_t out_x = x * 8, out_y = y * 2;
-            Float2 &factor = (out_x + 4 < out_center.x) ? _left_factors[out_y] : _right_factors[out_y];
-            Float2 &step = (out_x + 4 < out_center.x) ? _left_steps[out_y] : _right_steps[out_y];
+            bool left = (out_x + 4 < out_center.x);
+            const Float2 &factor = left ? curve_rows->left_factors[out_y] : curve_rows->right_factors[out_y];
+            const Float2 &step = left ? curve_rows->left_steps[out_y] : curve_rows->right_steps[out_y];
 
             // calculate 8x2 luma, center aligned
             Float2 out_pos (out_x, out_y);
@@ -367,8 +837,12 @@ GeoMapDualCurveTask::work_range (const SmartPtr<Arguments> &base, const WorkRang
             Float2 first = out_pos / factor;
             first += lut_center;
 
-            map_image (in_luma, in_uv, out_luma, out_uv, lut, luma_w, luma_h, uv_w, uv_h,
-                       x, y, out_x, out_y, first, step, zero_luma_byte, zero_uv_byte);
+            BlockOutput out;
+            select_block_output (args.ptr (), out_x, out_y, 2, out);
+            map_image (in_luma, in_uv, out, lut, luma_w, luma_h, uv_w, uv_h,
+                       first, step, zero_luma_byte, zero_uv_byte);
+            if (out.partial)
+                redirect_partial_block (args.ptr (), out_x, out_y);
         }
 
     return XCAM_RETURN_NO_ERROR;
@@ -25,11 +25,35 @@
 #include <soft/soft_worker.h>
 #include <soft/soft_image.h>
 #include <soft/soft_handler.h>
+#include <soft/soft_geo_mapper.h>
 
 namespace XCam {
 
 namespace XCamSoftTasks {
 
+/*
+ * valid spans of GeoMapTask output in 8x2 blocks, block columns [begin, end) of block row y
+ * are spans[offsets[y]] to spans[offsets[y + 1] - 1]. blocks out of spans map outside input
+ * and are filled without lookup.
+ */
+struct GeoMapSpans {
+    struct Span {
+        uint32_t    begin;
+        uint32_t    end;
+
+        Span (uint32_t b = 0, uint32_t e = 0) : begin (b), end (e) {}
+    };
+
+    std::vector<Span>       spans;
+    std::vector<uint32_t>   offsets;
+    // input luma rows [0, in_rows[y]) are read by block rows [0, y], chroma included
+    std::vector<uint32_t>   in_rows;
+
+    uint32_t get_rows () const {
+        return offsets.empty () ? 0 : offsets.size () - 1;
+    }
+};
+
 class GeoMapTask
     : public SoftWorker
 {
@@ -40,6 +64,14 @@ public:
         SmartPtr<Float2Image>       lookup_table;
         Float2                      factors;
 
+        // optional, built by build_spans with the same table and factors, not used with redirect areas
+        SmartPtr<GeoMapSpans>       spans;
+
+        // optional, blocks inside redirect_areas are written to redirect_luma/uv
+        SmartPtr<UcharImage>        redirect_luma;
+        SmartPtr<Uchar2Image>       redirect_uv;
+        SoftGeoMapper::RedirectAreas redirect_areas;
+
         Args (
             const SmartPtr<ImageHandler::Parameters> &param)
             : SoftArgs (param)
@@ -53,6 +85,108 @@ public:
         set_work_uint (8, 2);
     }
 
+    // spans of blocks with any luma pixel mapped inside @in_w x @in_h input, @out_w x @out_h is output luma size
+    static SmartPtr<GeoMapSpans> build_spans (
+        const SmartPtr<Float2Image> &lookup_table, const Float2 &factors,
+        uint32_t in_w, uint32_t in_h, uint32_t out_w, uint32_t out_h);
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+    virtual uint32_t get_input_rows (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+/*
+ * Fixed-point path of GeoMapTask, lookup_table is replaced by a full-resolution
+ * table of input positions in Q12.4 format, pixels are fetched by integer bilinear weights.
+ */
+class GeoMapFixedTask
+    : public GeoMapTask
+{
+public:
+    struct Args : GeoMapTask::Args {
+        SmartPtr<Short2Image>       fixed_table;
+
+        Args (
+            const SmartPtr<ImageHandler::Parameters> &param)
+            : GeoMapTask::Args (param)
+        {}
+    };
+
+public:
+    explicit GeoMapFixedTask (const SmartPtr<Worker::Callback> &cb)
+        : GeoMapTask (cb)
+    {
+        set_work_uint (8, 2);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+/*
+ * Planar path of GeoMapFixedTask, luma and uv planes are mapped row by row in separate grids of
+ * one dispatch, rows [0, luma height) are luma and the following (luma height / 2) rows are uv.
+ * Both planes read the same full-resolution fixed_table.
+ */
+class GeoMapPlanarTask
+    : public GeoMapFixedTask
+{
+public:
+    explicit GeoMapPlanarTask (const SmartPtr<Worker::Callback> &cb)
+        : GeoMapFixedTask (cb)
+    {
+        set_work_uint (8, 1);
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+#define XCAM_GEO_MAP_MAX_PLANES 3
+
+/*
+ * Plane path of GeoMapFixedTask for layouts other than NV12 to NV12, I420, P010 and RGBA,
+ * or NV12 input written as I420. Each output plane reads interleaved samples of one input plane,
+ * rows of all planes follow one another in one dispatch like GeoMapPlanarTask.
+ * E is the sample type, uint8_t or uint16_t. redirect areas are not supported.
+ */
+template <typename E>
+class GeoMapPlaneTask
+    : public GeoMapFixedTask
+{
+public:
+    struct Plane {
+        SmartPtr<SoftImage<E> >   in;
+        SmartPtr<SoftImage<E> >   out;
+        uint32_t                  in_step;    // interleaved samples per input pixel
+        uint32_t                  in_first;   // first input sample of output pixel
+        uint32_t                  channels;   // samples per output pixel
+        uint32_t                  shift;      // 1 on half-resolution planes
+        E                         fill[4];    // written where input is out of range
+
+        Plane () : in_step (1), in_first (0), channels (1), shift (0) {
+            xcam_mem_clear (fill);
+        }
+    };
+
+    struct Args : GeoMapFixedTask::Args {
+        Plane                     planes[XCAM_GEO_MAP_MAX_PLANES];
+        uint32_t                  plane_count;
+
+        Args (
+            const SmartPtr<ImageHandler::Parameters> &param)
+            : GeoMapFixedTask::Args (param)
+            , plane_count (0)
+        {}
+    };
+
+public:
+    explicit GeoMapPlaneTask (const SmartPtr<Worker::Callback> &cb)
+        : GeoMapFixedTask (cb)
+    {
+        set_work_uint (8, 1);
+    }
+
 private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
@@ -82,11 +216,26 @@ private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 };
 
+/*
+ * per output row factors and steps of GeoMapDualCurveTask, built once per factor update
+ * and read only afterwards, so threads and frames in flight share them.
+ */
+struct GeoMapCurveRows {
+    Float2                  left_factor;
+    Float2                  right_factor;
+    std::vector<Float2>     left_factors;
+    std::vector<Float2>     right_factors;
+    std::vector<Float2>     left_steps;
+    std::vector<Float2>     right_steps;
+};
+
 class GeoMapDualCurveTask
     : public GeoMapDualConstTask
 {
 public:
     struct Args : GeoMapDualConstTask::Args {
+        SmartPtr<GeoMapCurveRows>   curve_rows;
+
         Args (
             const SmartPtr<ImageHandler::Parameters> &param)
             : GeoMapDualConstTask::Args (param)
@@ -100,27 +249,26 @@ public:
     void set_scaled_height (float scaled_height) {
         XCAM_ASSERT (!XCAM_DOUBLE_EQUAL_AROUND (scaled_height, 0.0f));
         _scaled_height = scaled_height;
+        _curve_rows.release ();
     }
 
     void set_left_std_factor (float x, float y);
     void set_right_std_factor (float x, float y);
 
-private:
-    void set_factors (SmartPtr<GeoMapDualCurveTask::Args> args, uint32_t size);
-    bool set_steps (uint32_t size);
+    // row tables of @rows output rows, rebuilt only if factors or rows change; NULL on invalid factors.
+    // not thread safe, call before work
+    SmartPtr<GeoMapCurveRows> get_curve_rows (const Float2 &left_factor, const Float2 &right_factor, uint32_t rows);
 
+private:
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
 
     XCAM_DEAD_COPY (GeoMapDualCurveTask);
 
 private:
-    float        _scaled_height;
-    Float2       _left_std_factor;
-    Float2       _right_std_factor;
-    Float2       *_left_factors;
-    Float2       *_right_factors;
-    Float2       *_left_steps;
-    Float2       *_right_steps;
+    float                       _scaled_height;
+    Float2                      _left_std_factor;
+    Float2                      _right_std_factor;
+    SmartPtr<GeoMapCurveRows>   _curve_rows;
 };
 
 }
@@ -22,6 +22,9 @@
 #include "soft_video_buf_allocator.h"
 #include "thread_pool.h"
 #include "soft_worker.h"
+#include "xcam_trace.h"
+#include "frame_latency.h"
+#include "memory_accounting.h"
 
 #define DEFAULT_SOFT_BUF_COUNT 4
 
@@ -67,9 +70,9 @@ XCamReturn
 SyncMeta::signal_wait_ret ()
 {
     SmartLock locker (_mutex);
-    if (_done)
-        return _error;
-    _cond.wait (_mutex);
+    // wakeup () sets error without done
+    while (!_done && xcam_ret_is_ok (_error))
+        _cond.wait (_mutex);
     return _error;
 }
 
@@ -82,7 +85,6 @@ SyncMeta::is_error () const
 
 SoftHandler::SoftHandler (const char* name)
     : ImageHandler (name)
-    , _wip_buf_count (0)
 {
 }
 
@@ -134,18 +136,26 @@ SoftHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bo
         "soft_hander(%s) execute buffer failed, params is null",
         XCAM_STR (get_name ()));
 
-    if (_need_configure) {
-        ret = configure_resource (param);
-        XCAM_FAIL_RETURN (
-            WARNING, xcam_ret_is_ok (ret), ret,
-            "soft_hander(%s) configure resource failed", XCAM_STR (get_name ()));
-
-        ret = configure_rest ();
-        XCAM_FAIL_RETURN (
-            WARNING, xcam_ret_is_ok (ret), ret,
-            "soft_hander(%s) confirm configure failed", XCAM_STR (get_name ()));
-
-        _need_configure = false;
+    XCAM_TRACE_SCOPE (get_name (), param->in_buf.ptr () ? param->in_buf->get_timestamp () : InvalidTimestamp);
+
+    {
+        // pipelined frames may execute at the same time
+        SmartLock locker (_config_mutex);
+        if (_need_configure) {
+            // resources and buffer pools are charged to the handler
+            MemoryOwnerScope mem_scope (get_name ());
+            ret = configure_resource (param);
+            XCAM_FAIL_RETURN (
+                WARNING, xcam_ret_is_ok (ret), ret,
+                "soft_hander(%s) configure resource failed", XCAM_STR (get_name ()));
+
+            ret = configure_rest ();
+            XCAM_FAIL_RETURN (
+                WARNING, xcam_ret_is_ok (ret), ret,
+                "soft_hander(%s) confirm configure failed", XCAM_STR (get_name ()));
+
+            _need_configure = false;
+        }
     }
 
     if (!param->out_buf.ptr () && _enable_allocator) {
@@ -155,6 +165,8 @@ SoftHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bo
             "soft_hander:%s execute buffer failed, output buffer failed in allocation.",
             XCAM_STR (get_name ()));
     }
+    if (param->in_buf.ptr () && param->out_buf.ptr ())
+        FrameLatencyMeta::carry (param->in_buf, param->out_buf);
 
     XCAM_ASSERT (!param->find_meta<SyncMeta> ().ptr ());
     SmartPtr<SyncMeta> sync_meta = new SyncMeta ();
@@ -176,40 +188,59 @@ SoftHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, bo
     _params.push (params);
     ret = worker->work (args);
 #else
+    // listed before start, workers may end the param before start_work returns
+    {
+        SmartLock locker (_sync_mutex);
+        _wip_syncs.push_back (sync_meta);
+    }
     _params.push (param);
     ret = start_work (param);
 #endif
 
     if (!xcam_ret_is_ok (ret)) {
         _params.erase (param);
+        remove_sync (sync_meta);
         XCAM_LOG_WARNING ("soft_hander(%s) execute buffer failed in starting workers", XCAM_STR (get_name ()));
         return ret;
     }
 
-    ++_wip_buf_count;
-    _cur_sync = sync_meta;
-
     if (sync) {
         XCAM_ASSERT (sync_meta.ptr ());
         ret = sync_meta->signal_wait_ret ();
-        _cur_sync.release ();
     }
 
     return ret;
 }
 
+void
+SoftHandler::remove_sync (const SmartPtr<SyncMeta> &sync)
+{
+    SmartLock locker (_sync_mutex);
+    for (SyncList::iterator i = _wip_syncs.begin (); i != _wip_syncs.end (); ++i) {
+        if ((*i).ptr () == sync.ptr ()) {
+            _wip_syncs.erase (i);
+            return;
+        }
+    }
+}
+
 XCamReturn
 SoftHandler::finish ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    SmartPtr<SyncMeta> sync = _cur_sync;
-    if (sync.ptr ()) {
-        ret = sync->signal_wait_ret ();
+    SyncList syncs;
+    {
+        SmartLock locker (_sync_mutex);
+        syncs = _wip_syncs;
+    }
+
+    // pipelined frames end in any order, wait for all of them
+    for (SyncList::iterator i = syncs.begin (); i != syncs.end (); ++i) {
+        XCamReturn sync_ret = (*i)->signal_wait_ret ();
+        if (xcam_ret_is_ok (ret))
+            ret = sync_ret;
     }
     XCAM_ASSERT (_params.is_empty ());
-    //wait for _wip_buf_count = 0
-    //if (ret == XCAM_RETURN_NO_ERROR)
-    //    XCAM_ASSERT (_wip_buf_count == 0);
 
     return ret;
 }
@@ -217,11 +248,14 @@ SoftHandler::finish ()
 XCamReturn
 SoftHandler::terminate ()
 {
-    SmartPtr<SyncMeta> sync = _cur_sync;
-    if (sync.ptr ()) {
-        sync->wakeup ();
-        sync.release ();
+    SyncList syncs;
+    {
+        SmartLock locker (_sync_mutex);
+        syncs.swap (_wip_syncs);
     }
+    for (SyncList::iterator i = syncs.begin (); i != syncs.end (); ++i)
+        (*i)->wakeup ();
+
     _params.clear ();
     return ImageHandler::terminate ();
 }
@@ -243,7 +277,11 @@ SoftHandler::work_well_done (const SmartPtr<ImageHandler::Parameters> &param, XC
         return;
     }
 
-    XCAM_LOG_DEBUG ("soft_hander(%s) work well done", XCAM_STR (get_name ()));
+    // workers skipped the rest of an expired frame, its output is incomplete
+    if (err == XCAM_RETURN_NO_ERROR && param->is_expired ())
+        err = XCAM_RETURN_BYPASS;
+
+    XCAM_LOG_DEBUG ("soft_hander(%s) work well done, errno(%d)", XCAM_STR (get_name ()), (int)err);
 
     param_ended (param, err);
 }
@@ -275,8 +313,8 @@ SoftHandler::param_ended (SmartPtr<ImageHandler::Parameters> param, XCamReturn e
 
     SmartPtr<SyncMeta> sync_meta = param->find_meta<SyncMeta> ();
     XCAM_ASSERT (sync_meta.ptr ());
+    remove_sync (sync_meta);
     sync_meta->signal_done (err);
-    --_wip_buf_count;
     execute_status_check (param, err);
 }
 
@@ -296,6 +334,18 @@ SoftHandler::check_work_continue (const SmartPtr<ImageHandler::Parameters> &para
     return true;
 }
 
+XCamReturn
+SoftHandler::wait_work_done (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (param.ptr ());
+    SmartPtr<SyncMeta> meta = param->find_meta<SyncMeta> ();
+    XCAM_FAIL_RETURN (
+        ERROR, meta.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "soft_hander(%s) wait work done failed, param was not executed", XCAM_STR (get_name ()));
+
+    return meta->signal_wait_ret ();
+}
+
 bool
 SoftHandler::is_param_error (const SmartPtr<ImageHandler::Parameters> &param)
 {
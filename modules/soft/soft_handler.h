@@ -24,6 +24,7 @@
 #include <xcam_std.h>
 #include <image_handler.h>
 #include <video_buffer.h>
+#include <row_progress.h>
 #include <worker.h>
 
 namespace XCam {
@@ -38,14 +39,30 @@ struct SoftArgs
 {
 private:
     SmartPtr<ImageHandler::Parameters> _param;
+    // caught with param, handlers may drop in_buf before work
+    SmartPtr<RowProgress>              _in_progress;
 public:
-    explicit SoftArgs (const SmartPtr<ImageHandler::Parameters> &param = NULL) : _param (param) {}
+    explicit SoftArgs (const SmartPtr<ImageHandler::Parameters> &param = NULL) : _param (param) {
+        catch_in_progress ();
+    }
     inline const SmartPtr<ImageHandler::Parameters> &get_param () const {
         return _param;
     }
     inline void set_param (const SmartPtr<ImageHandler::Parameters> &param) {
         _param = param;
         XCAM_ASSERT (param.ptr ());
+        catch_in_progress ();
+    }
+    // rows of in_buf still being captured, NULL if in_buf was complete
+    inline const SmartPtr<RowProgress> &get_in_progress () const {
+        return _in_progress;
+    }
+
+private:
+    inline void catch_in_progress () {
+        _in_progress.release ();
+        if (_param.ptr () && _param->in_buf.ptr ())
+            _in_progress = _param->in_buf->find_typed_metadata<RowProgress> ();
     }
 };
 
@@ -74,19 +91,26 @@ protected:
 
     //directly usage
     bool check_work_continue (const SmartPtr<ImageHandler::Parameters> &param, XCamReturn err);
+    // wait until @param executed by execute_buffer (param, false) is done or broken
+    XCamReturn wait_work_done (const SmartPtr<ImageHandler::Parameters> &param);
 
 private:
     void param_ended (SmartPtr<ImageHandler::Parameters> param, XCamReturn err);
+    void remove_sync (const SmartPtr<SyncMeta> &sync);
     static bool is_param_error (const SmartPtr<ImageHandler::Parameters> &param);
 
 private:
     XCAM_DEAD_COPY (SoftHandler);
 
 private:
+    typedef std::list<SmartPtr<SyncMeta> > SyncList;
+
     SmartPtr<ThreadPool>    _threads;
-    SmartPtr<SyncMeta>      _cur_sync;
     SafeList<Parameters>    _params;
-    mutable std::atomic<int32_t>  _wip_buf_count;
+    Mutex                   _config_mutex;
+    // syncs of params started but not ended yet
+    SyncList                _wip_syncs;
+    Mutex                   _sync_mutex;
 };
 
 }
@@ -32,6 +32,8 @@ typedef uint8_t Uchar;
 typedef int8_t Char;
 typedef Vector2<uint8_t> Uchar2;
 typedef Vector2<int8_t> Char2;
+typedef int16_t Short;
+typedef Vector2<int16_t> Short2;
 typedef Vector2<float> Float2;
 typedef Vector2<int> Int2;
 
@@ -41,6 +43,163 @@ enum BorderType {
     BorderTypeRewind,
 };
 
+/*
+ * border policies of SoftImage reads, picked at compile time.
+ * check moves @pos into [0, @size) and returns false if it reads as zero (BorderTypeConst),
+ * inside tells whether [@pos, @pos + @len) needs no check at all.
+ * SoftBorderNone is for callers which know every position is in image, e.g. interior tiles.
+ */
+struct SoftBorderNone {
+    static inline bool check (int32_t &pos, uint32_t size) {
+        XCAM_UNUSED (pos);
+        XCAM_UNUSED (size);
+        return true;
+    }
+    static inline bool inside (int32_t pos, uint32_t len, uint32_t size) {
+        XCAM_UNUSED (pos);
+        XCAM_UNUSED (len);
+        XCAM_UNUSED (size);
+        return true;
+    }
+};
+
+struct SoftBorderChecked {
+    static inline bool inside (int32_t pos, uint32_t len, uint32_t size) {
+        return pos >= 0 && pos + (int32_t)len <= (int32_t)size;
+    }
+};
+
+// BorderTypeNearest
+struct SoftBorderNearest : SoftBorderChecked {
+    static inline bool check (int32_t &pos, uint32_t size) {
+        if (pos < 0) pos = 0;
+        else if (pos >= (int32_t)size) pos = (int32_t)(size - 1);
+        return true;
+    }
+};
+
+// BorderTypeConst, out of image positions read as zero
+struct SoftBorderConst : SoftBorderChecked {
+    static inline bool check (int32_t &pos, uint32_t size) {
+        return pos >= 0 && pos < (int32_t)size;
+    }
+};
+
+// BorderTypeRewind, positions wrap around image
+struct SoftBorderRewind : SoftBorderChecked {
+    static inline bool check (int32_t &pos, uint32_t size) {
+        if (pos < 0 || pos >= (int32_t)size) {
+            pos %= (int32_t)size;
+            if (pos < 0) pos += (int32_t)size;
+        }
+        return true;
+    }
+};
+
+enum SoftSimdType {
+    SoftSimdNone = 0,
+    SoftSimdSSE4,
+    SoftSimdAVX2,
+    SoftSimdNEON,
+    SoftSimdAuto,  // best one supported by CPU
+};
+
+// SIMD path is selected by CPU features at runtime,
+// set_type can force a lower one before any processing starts
+SoftSimdType soft_simd_get_type ();
+SoftSimdType soft_simd_set_type (SoftSimdType type);
+
+// return false if SIMD is not supported or any position is close to border
+bool soft_simd_interpolate_uchar_8 (
+    const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height,
+    const Float2 *pos, float *out);
+bool soft_simd_interpolate_uchar2_4 (
+    const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height,
+    const Float2 *pos, Float2 *out);
+
+/*
+ * 5-tap gauss with weights {39, 57, 64, 57, 39} / 256, scalar code is used when SIMD is not supported.
+ * rows: out[i] = vertical sum of rows[0..4][i], in 15-bit fixed point, @len is in bytes
+ * decimate: out[j] = horizontal sum of in[2j .. 2j+4] back to Uchar, @in needs (2 * out_len + 4) pixels
+ */
+#define SOFT_GAUSS_TAPS 5
+void soft_simd_gauss_rows (const uint8_t *const *rows, uint32_t len, int16_t *out);
+void soft_simd_gauss_decimate_uchar (const int16_t *in, uint32_t out_len, uint8_t *out);
+void soft_simd_gauss_decimate_uchar2 (const int16_t *in, uint32_t out_len, uint8_t *out);
+
+// 2x2 box average of two rows, out[j] = (row0[2j] + row0[2j+1] + row1[2j] + row1[2j+1] + 2) >> 2
+void soft_simd_half_uchar (const uint8_t *row0, const uint8_t *row1, uint32_t out_len, uint8_t *out);
+
+/*
+ * temporal blend of @len bytes, Uchar and interleaved Uchar2 rows alike.
+ * @refs are oldest first and blended in order, each against the running result:
+ *   alpha = min ((threshold - |ref - cur|) * gain, strength / (ref_count - k)), 0 once difference reaches threshold
+ *   acc += ((ref - acc) * alpha + 64) >> 7
+ * older refs get smaller weights so the newest one leads; gain makes alpha reach its limit at half threshold.
+ * @strength is at most 128 (full reference) and @ref_count at most SOFT_TNR_MAX_REFS.
+ * integer and bit-exact with the scalar code, @out may be @cur or any of @refs
+ */
+#define SOFT_TNR_MAX_STRENGTH 128
+#define SOFT_TNR_MAX_REFS 4
+void soft_simd_tnr_blend (
+    const uint8_t *cur, const uint8_t *const *refs, uint32_t ref_count, uint32_t len,
+    uint8_t threshold, uint8_t strength, uint8_t *out);
+
+/*
+ * separable scaling, vertical pass in SIMD over whole rows, horizontal pass by the caller.
+ * lerp: out[i] = row0[i] * (128 - weight) + row1[i] * weight, @weight in [0, 128]
+ * sum: out[i] = sum of rows[0..count-1][i], @count at most 257 so sums stay in 16 bits
+ */
+#define SOFT_SCALE_WEIGHT_BITS 7
+void soft_simd_lerp_rows (const uint8_t *row0, const uint8_t *row1, uint32_t len, uint32_t weight, uint16_t *out);
+void soft_simd_sum_rows (const uint8_t *const *rows, uint32_t count, uint32_t len, uint16_t *out);
+
+/*
+ * one row of NV12 into other layouts, @width is in luma pixels and even.
+ * rgba uses the coefficients of kernel_csc_nv12torgba in 6-bit fixed point, alpha is 255
+ */
+void soft_simd_nv12_to_yuyv (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out);
+void soft_simd_nv12_to_rgba (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out);
+void soft_simd_split_uv (const uint8_t *uv, uint32_t uv_width, uint8_t *u, uint8_t *v);
+
+/*
+ * laplace pyramid rows, laplace levels are int16 with SOFT_LAP_FRAC_BITS fraction bits.
+ * @width is in pixels of @channels interleaved bytes, 1 for Uchar and 2 for Uchar2.
+ * up[i] is bilinear 2x up-sample of gauss rows @g0 and @g1 (pass @g1 = @g0 on even rows)
+ * with the same fraction bits, right border is clamped at @g_width gauss pixels.
+ * @mask has one byte per element, m = mask[i] + (mask[i] >> 7) so 255 takes the first input only.
+ *   laplace:     out[i] = orig[i] * 4 - up[i]
+ *   reconstruct: out[i] = clamp ((up[i] * 256 + lap0[i] * m + lap1[i] * (256 - m) + 512) >> 10)
+ *   blend:       out[i] = (in0[i] * m + in1[i] * (256 - m) + 128) >> 8, @len is in bytes
+ */
+#define SOFT_LAP_FRAC_BITS 2
+void soft_simd_laplace_row (
+    const uint8_t *orig, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, int16_t *out);
+void soft_simd_reconstruct_row (
+    const int16_t *lap0, const int16_t *lap1, const uint8_t *mask, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, uint8_t *out);
+void soft_simd_blend_row (const uint8_t *in0, const uint8_t *in1, const uint8_t *mask, uint32_t len, uint8_t *out);
+
+/*
+ * N-way fusion of @count rows, @weights of all inputs sum to 256 on every element.
+ *   fuse:             out[i] = (sum (in_k[i] * w_k[i]) + 128) >> 8, @len is in bytes
+ *   fuse reconstruct: out[i] = clamp ((up[i] * 256 + sum (lap_k[i] * w_k[i]) + 512) >> 10),
+ *                     up-sample and @width as in soft_simd_reconstruct_row
+ */
+#define SOFT_FUSE_MAX_INPUTS 8
+void soft_simd_fuse_row (
+    const uint8_t *const *ins, const int16_t *const *weights, uint32_t count, uint32_t len, uint8_t *out);
+void soft_simd_fuse_reconstruct_row (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, uint8_t *out);
+
+/*
+ * copy of @len bytes by non-temporal stores, @dst is not pulled into cache,
+ * for large copies not read again soon, plain memcpy without SIMD support
+ */
+void soft_simd_stream_copy (const uint8_t *src, uint32_t len, uint8_t *dst);
+
 template <typename T>
 class SoftImage
 {
@@ -101,15 +260,17 @@ public:
         return t_ptr[x];
     }
 
+    template<typename B = SoftBorderNearest>
     inline T read_data (int32_t x, int32_t y) const {
-        border_check (x, y);
+        if (!B::check (x, _width) || !B::check (y, _height))
+            return T ();
         return read_data_no_check (x, y);
     }
 
-    template<typename O>
+    template<typename O, typename B = SoftBorderNearest>
     inline O read_interpolate_data (float x, float y) const;
 
-    template<typename O, uint32_t N>
+    template<typename O, uint32_t N, typename B = SoftBorderNearest>
     inline void read_interpolate_array (Float2 *pos, O *array) const;
 
     template<uint32_t N>
@@ -128,29 +289,35 @@ public:
         }
     }
 
-    template<uint32_t N>
+    template<uint32_t N, typename B = SoftBorderNearest>
     inline void read_array (int32_t x, int32_t y, T *array) const {
         XCAM_ASSERT (N <= 8);
-        border_check_y (y);
-        if (x + N < _width) {
+        if (B::inside (x, N, _width) && B::check (y, _height)) {
             read_array_no_check<N> (x, y, array);
         } else {
-            const T *t_ptr = ((const T *)(_buf_ptr + y * _pitch));
-            for (uint32_t i = 0; i < N; ++i, ++x) {
-                border_check_x (x);
-                array[i] = t_ptr[x];
-            }
+            read_array<T, N, B> (x, y, array);
         }
     }
 
-    template<typename O, uint32_t N>
+    template<typename O, uint32_t N, typename B = SoftBorderNearest>
     inline void read_array (int32_t x, int32_t y, O *array) const {
         XCAM_ASSERT (N <= 8);
-        border_check_y (y);
+        if (!B::check (y, _height)) {
+            for (uint32_t i = 0; i < N; ++i)
+                array[i] = O ();
+            return;
+        }
+        if (B::inside (x, N, _width)) {
+            read_array_no_check<O, N> (x, y, array);
+            return;
+        }
         const T *t_ptr = ((const T *)(_buf_ptr + y * _pitch));
         for (uint32_t i = 0; i < N; ++i, ++x) {
-            border_check_x (x);
-            array[i] = t_ptr[x];
+            int32_t pos = x;
+            if (B::check (pos, _width))
+                array[i] = t_ptr[pos];
+            else
+                array[i] = O ();
         }
     }
 
@@ -188,22 +355,6 @@ public:
             }
         }
     }
-
-private:
-    inline void border_check_x (int32_t &x) const {
-        if (x < 0) x = 0;
-        else if (x >= (int32_t)_width) x = (int32_t)(_width - 1);
-    }
-
-    inline void border_check_y (int32_t &y) const {
-        if (y < 0) y = 0;
-        else if (y >= (int32_t)_height) y = (int32_t)(_height - 1);
-    }
-
-    inline void border_check (int32_t &x, int32_t &y) const {
-        border_check_x (x);
-        border_check_y (y);
-    }
 };
 
 
@@ -292,6 +443,8 @@ typedef SoftImage<Uchar> UcharImage;
 typedef SoftImage<Uchar2> Uchar2Image;
 typedef SoftImage<float> FloatImage;
 typedef SoftImage<Float2> Float2Image;
+typedef SoftImage<Short> ShortImage;
+typedef SoftImage<Short2> Short2Image;
 
 template <class SoftImageT>
 class SoftImageFile
@@ -357,26 +510,74 @@ SoftImageFile<SoftImageT>::write_buf (const SmartPtr<SoftImageT> &buf)
     return XCAM_RETURN_NO_ERROR;
 }
 
-template <typename T> template <typename O>
+/*
+ * SIMD interpolation of N positions for T images, false if not supported or any position
+ * is close to border, SIMD kernels check border themselves.
+ */
+template <typename T, typename O, uint32_t N>
+struct SoftSimdInterpolate {
+    static inline bool interpolate (
+        const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height, const Float2 *pos, O *out) {
+        XCAM_UNUSED (buf);
+        XCAM_UNUSED (pitch);
+        XCAM_UNUSED (width);
+        XCAM_UNUSED (height);
+        XCAM_UNUSED (pos);
+        XCAM_UNUSED (out);
+        return false;
+    }
+};
+
+template <>
+struct SoftSimdInterpolate<Uchar, float, 8> {
+    static inline bool interpolate (
+        const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height, const Float2 *pos, float *out) {
+        return soft_simd_interpolate_uchar_8 (buf, pitch, width, height, pos, out);
+    }
+};
+
+template <>
+struct SoftSimdInterpolate<Uchar2, Float2, 4> {
+    static inline bool interpolate (
+        const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height, const Float2 *pos, Float2 *out) {
+        return soft_simd_interpolate_uchar2_4 (buf, pitch, width, height, pos, out);
+    }
+};
+
+// both halves need SIMD, otherwise all 8 go scalar which gives the same values
+template <>
+struct SoftSimdInterpolate<Uchar2, Float2, 8> {
+    static inline bool interpolate (
+        const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height, const Float2 *pos, Float2 *out) {
+        return soft_simd_interpolate_uchar2_4 (buf, pitch, width, height, pos, out) &&
+               soft_simd_interpolate_uchar2_4 (buf, pitch, width, height, pos + 4, out + 4);
+    }
+};
+
+// SoftBorderNone needs (x + 1, y + 1) in image as well
+template <typename T> template <typename O, typename B>
 O
 SoftImage<T>::read_interpolate_data (float x, float y) const
 {
     int32_t x0 = (int32_t)(x), y0 = (int32_t)(y);
     float a = x - x0, b = y - y0;
     O l0[2], l1[2];
-    read_array<O, 2> (x0, y0, l0);
-    read_array<O, 2> (x0, y0 + 1, l1);
+    read_array<O, 2, B> (x0, y0, l0);
+    read_array<O, 2, B> (x0, y0 + 1, l1);
 
     return l1[1] * (a * b) + l0[0] * ((1 - a) * (1 - b)) +
            l1[0] * ((1 - a) * b) + l0[1] * (a * (1 - b));
 }
 
-template <typename T> template<typename O, uint32_t N>
+template <typename T> template<typename O, uint32_t N, typename B>
 void
 SoftImage<T>::read_interpolate_array (Float2 *pos, O *array) const
 {
+    if (SoftSimdInterpolate<T, O, N>::interpolate (_buf_ptr, _pitch, _width, _height, pos, array))
+        return;
+
     for (uint32_t i = 0; i < N; ++i) {
-        array[i] = read_interpolate_data<O> (pos[i].x, pos[i].y);
+        array[i] = read_interpolate_data<O, B> (pos[i].x, pos[i].y);
     }
 }
 
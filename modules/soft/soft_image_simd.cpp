@@ -0,0 +1,1596 @@
+/*
+ * soft_image_simd.cpp - soft image SIMD interpolation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_image.h"
+
+#if defined (__x86_64__) || defined (__i386__)
+#define XCAM_SOFT_SIMD_X86 1
+#include <immintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define XCAM_SOFT_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*
+ * Interpolation kernels keep the operation order of SoftImage::read_interpolate_data,
+ *   l1[1] * (a * b) + l0[0] * ((1 - a) * (1 - b)) + l1[0] * ((1 - a) * b) + l0[1] * (a * (1 - b))
+ * without fused multiply-add, so results are bit-exact with the scalar path.
+ * Kernels only run when all positions are inside the image, see check_inside.
+ */
+
+namespace XCam {
+
+typedef void (*InterpUcharFunc) (const uint8_t *buf, uint32_t pitch, const Float2 *pos, float *out);
+typedef void (*InterpUchar2Func) (const uint8_t *buf, uint32_t pitch, const Float2 *pos, Float2 *out);
+typedef uint32_t (*GaussRowsFunc) (const uint8_t *const *rows, uint32_t len, int16_t *out);
+typedef uint32_t (*GaussDecimateFunc) (const int16_t *in, uint32_t out_len, uint8_t *out);
+typedef uint32_t (*HalfUcharFunc) (const uint8_t *row0, const uint8_t *row1, uint32_t out_len, uint8_t *out);
+typedef uint32_t (*TnrBlendFunc) (
+    const uint8_t *cur, const uint8_t *const *refs, uint32_t ref_count, uint32_t len,
+    uint8_t threshold, const int16_t *gains, const int16_t *strengths, uint8_t *out);
+typedef uint32_t (*LerpRowsFunc) (const uint8_t *row0, const uint8_t *row1, uint32_t len, uint32_t weight, uint16_t *out);
+typedef uint32_t (*SumRowsFunc) (const uint8_t *const *rows, uint32_t count, uint32_t len, uint16_t *out);
+typedef uint32_t (*Nv12RowFunc) (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out);
+typedef uint32_t (*SplitUvFunc) (const uint8_t *uv, uint32_t uv_width, uint8_t *u, uint8_t *v);
+typedef uint32_t (*LaplaceRowFunc) (
+    const uint8_t *orig, const uint8_t *g0, const uint8_t *g1, uint32_t len, uint32_t g_len, uint32_t channels, int16_t *out);
+typedef uint32_t (*ReconstructRowFunc) (
+    const int16_t *lap0, const int16_t *lap1, const uint8_t *mask, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out);
+typedef uint32_t (*BlendRowFunc) (const uint8_t *in0, const uint8_t *in1, const uint8_t *mask, uint32_t len, uint8_t *out);
+typedef uint32_t (*FuseRowFunc) (
+    const uint8_t *const *ins, const int16_t *const *weights, uint32_t count, uint32_t len, uint8_t *out);
+typedef uint32_t (*FuseReconstructRowFunc) (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out);
+typedef uint32_t (*StreamCopyFunc) (const uint8_t *src, uint32_t len, uint8_t *dst);
+
+struct SoftSimdFuncs {
+    SoftSimdType       type;
+    InterpUcharFunc    uchar_8;   // 8 pixels of Uchar
+    InterpUchar2Func   uchar2_4;  // 4 pixels of Uchar2
+    // gauss kernels return how many elements are done, the rest are done by scalar code
+    GaussRowsFunc      gauss_rows;
+    GaussDecimateFunc  gauss_uchar;
+    GaussDecimateFunc  gauss_uchar2;
+    HalfUcharFunc      half_uchar;
+    TnrBlendFunc       tnr_blend;
+    LerpRowsFunc       lerp_rows;
+    SumRowsFunc        sum_rows;
+    Nv12RowFunc        nv12_to_yuyv;
+    Nv12RowFunc        nv12_to_rgba;
+    SplitUvFunc        split_uv;
+    // laplace kernels take @len and @g_len in bytes
+    LaplaceRowFunc     laplace_row;
+    ReconstructRowFunc reconstruct_row;
+    BlendRowFunc       blend_row;
+    FuseRowFunc        fuse_row;
+    FuseReconstructRowFunc fuse_reconstruct_row;
+    StreamCopyFunc     stream_copy;
+};
+
+/*
+ * Gauss kernels are integer and bit-exact with the scalar code below,
+ * vertical sums are kept in 15 bits so horizontal pass can use 16-bit multiply-add.
+ */
+static const int16_t gauss_weights[SOFT_GAUSS_TAPS] = {39, 57, 64, 57, 39};
+
+// kernel_csc_nv12torgba coefficients scaled by 64
+#define CSC_RV 73
+#define CSC_GU 25
+#define CSC_GV 37
+#define CSC_BU 130
+#define CSC_SHIFT 6
+
+static inline uint32_t
+load_u16 (const uint8_t *ptr)
+{
+    uint16_t v;
+    memcpy (&v, ptr, sizeof (v));
+    return v;
+}
+
+static inline int32_t
+load_u32 (const uint8_t *ptr)
+{
+    int32_t v;
+    memcpy (&v, ptr, sizeof (v));
+    return v;
+}
+
+#if XCAM_SOFT_SIMD_X86
+
+__attribute__ ((target ("sse4.1")))
+static inline void
+calc_weights_sse (
+    const Float2 *pos, uint32_t pitch, uint32_t pixel_bytes, int32_t *offsets,
+    __m128 &w11, __m128 &w00, __m128 &w10, __m128 &w01)
+{
+    __m128 p01 = _mm_loadu_ps (&pos[0].x);
+    __m128 p23 = _mm_loadu_ps (&pos[2].x);
+    __m128 xs = _mm_shuffle_ps (p01, p23, _MM_SHUFFLE (2, 0, 2, 0));
+    __m128 ys = _mm_shuffle_ps (p01, p23, _MM_SHUFFLE (3, 1, 3, 1));
+    __m128i xi = _mm_cvttps_epi32 (xs);
+    __m128i yi = _mm_cvttps_epi32 (ys);
+    __m128 a = _mm_sub_ps (xs, _mm_cvtepi32_ps (xi));
+    __m128 b = _mm_sub_ps (ys, _mm_cvtepi32_ps (yi));
+    __m128 one = _mm_set1_ps (1.0f);
+    __m128 ra = _mm_sub_ps (one, a);
+    __m128 rb = _mm_sub_ps (one, b);
+
+    w11 = _mm_mul_ps (a, b);
+    w00 = _mm_mul_ps (ra, rb);
+    w10 = _mm_mul_ps (ra, b);
+    w01 = _mm_mul_ps (a, rb);
+
+    __m128i off = _mm_add_epi32 (
+        _mm_mullo_epi32 (yi, _mm_set1_epi32 (pitch)),
+        _mm_mullo_epi32 (xi, _mm_set1_epi32 (pixel_bytes)));
+    _mm_storeu_si128 ((__m128i *)offsets, off);
+}
+
+__attribute__ ((target ("sse4.1")))
+static inline __m128
+blend_sse (__m128 p00, __m128 p01, __m128 p10, __m128 p11, __m128 w00, __m128 w01, __m128 w10, __m128 w11)
+{
+    __m128 r = _mm_add_ps (_mm_mul_ps (p11, w11), _mm_mul_ps (p00, w00));
+    r = _mm_add_ps (r, _mm_mul_ps (p10, w10));
+    return _mm_add_ps (r, _mm_mul_ps (p01, w01));
+}
+
+__attribute__ ((target ("sse4.1")))
+static void
+interp_uchar_8_sse (const uint8_t *buf, uint32_t pitch, const Float2 *pos, float *out)
+{
+    const __m128i mask = _mm_set1_epi32 (0xFF);
+    int32_t off[4];
+    __m128 w11, w00, w10, w01;
+
+    for (uint32_t i = 0; i < 8; i += 4) {
+        calc_weights_sse (pos + i, pitch, 1, off, w11, w00, w10, w01);
+        __m128i row0 = _mm_setr_epi32 (
+            load_u16 (buf + off[0]), load_u16 (buf + off[1]), load_u16 (buf + off[2]), load_u16 (buf + off[3]));
+        __m128i row1 = _mm_setr_epi32 (
+            load_u16 (buf + off[0] + pitch), load_u16 (buf + off[1] + pitch),
+            load_u16 (buf + off[2] + pitch), load_u16 (buf + off[3] + pitch));
+
+        __m128 p00 = _mm_cvtepi32_ps (_mm_and_si128 (row0, mask));
+        __m128 p01 = _mm_cvtepi32_ps (_mm_srli_epi32 (row0, 8));
+        __m128 p10 = _mm_cvtepi32_ps (_mm_and_si128 (row1, mask));
+        __m128 p11 = _mm_cvtepi32_ps (_mm_srli_epi32 (row1, 8));
+        _mm_storeu_ps (out + i, blend_sse (p00, p01, p10, p11, w00, w01, w10, w11));
+    }
+}
+
+__attribute__ ((target ("sse4.1")))
+static void
+interp_uchar2_4_sse (const uint8_t *buf, uint32_t pitch, const Float2 *pos, Float2 *out)
+{
+    const __m128i mask = _mm_set1_epi32 (0xFF);
+    int32_t off[4];
+    __m128 w11, w00, w10, w01;
+
+    calc_weights_sse (pos, pitch, 2, off, w11, w00, w10, w01);
+    // each 32-bit lane holds u0 v0 u1 v1 of two neighbor pixels
+    __m128i row0 = _mm_setr_epi32 (
+        load_u32 (buf + off[0]), load_u32 (buf + off[1]), load_u32 (buf + off[2]), load_u32 (buf + off[3]));
+    __m128i row1 = _mm_setr_epi32 (
+        load_u32 (buf + off[0] + pitch), load_u32 (buf + off[1] + pitch),
+        load_u32 (buf + off[2] + pitch), load_u32 (buf + off[3] + pitch));
+
+    __m128 u = blend_sse (
+        _mm_cvtepi32_ps (_mm_and_si128 (row0, mask)),
+        _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (row0, 16), mask)),
+        _mm_cvtepi32_ps (_mm_and_si128 (row1, mask)),
+        _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (row1, 16), mask)),
+        w00, w01, w10, w11);
+    __m128 v = blend_sse (
+        _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (row0, 8), mask)),
+        _mm_cvtepi32_ps (_mm_srli_epi32 (row0, 24)),
+        _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (row1, 8), mask)),
+        _mm_cvtepi32_ps (_mm_srli_epi32 (row1, 24)),
+        w00, w01, w10, w11);
+
+    _mm_storeu_ps (&out[0].x, _mm_unpacklo_ps (u, v));
+    _mm_storeu_ps (&out[2].x, _mm_unpackhi_ps (u, v));
+}
+
+__attribute__ ((target ("avx2")))
+static void
+interp_uchar_8_avx2 (const uint8_t *buf, uint32_t pitch, const Float2 *pos, float *out)
+{
+    __m256 p03 = _mm256_loadu_ps (&pos[0].x);
+    __m256 p47 = _mm256_loadu_ps (&pos[4].x);
+    // per-lane shuffle gives x0 x1 x4 x5 | x2 x3 x6 x7, then restore the order across lanes
+    __m256 xs = _mm256_castpd_ps (_mm256_permute4x64_pd (
+                                      _mm256_castps_pd (_mm256_shuffle_ps (p03, p47, _MM_SHUFFLE (2, 0, 2, 0))),
+                                      _MM_SHUFFLE (3, 1, 2, 0)));
+    __m256 ys = _mm256_castpd_ps (_mm256_permute4x64_pd (
+                                      _mm256_castps_pd (_mm256_shuffle_ps (p03, p47, _MM_SHUFFLE (3, 1, 3, 1))),
+                                      _MM_SHUFFLE (3, 1, 2, 0)));
+    __m256i xi = _mm256_cvttps_epi32 (xs);
+    __m256i yi = _mm256_cvttps_epi32 (ys);
+    __m256 a = _mm256_sub_ps (xs, _mm256_cvtepi32_ps (xi));
+    __m256 b = _mm256_sub_ps (ys, _mm256_cvtepi32_ps (yi));
+    __m256 one = _mm256_set1_ps (1.0f);
+    __m256 ra = _mm256_sub_ps (one, a);
+    __m256 rb = _mm256_sub_ps (one, b);
+
+    __m256i off = _mm256_add_epi32 (_mm256_mullo_epi32 (yi, _mm256_set1_epi32 (pitch)), xi);
+    // 32-bit gathers at byte offsets, the two low bytes are the neighbor pixels
+    __m256i row0 = _mm256_i32gather_epi32 ((const int *)buf, off, 1);
+    __m256i row1 = _mm256_i32gather_epi32 ((const int *)(buf + pitch), off, 1);
+
+    const __m256i mask = _mm256_set1_epi32 (0xFF);
+    __m256 p00 = _mm256_cvtepi32_ps (_mm256_and_si256 (row0, mask));
+    __m256 p01 = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (row0, 8), mask));
+    __m256 p10 = _mm256_cvtepi32_ps (_mm256_and_si256 (row1, mask));
+    __m256 p11 = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (row1, 8), mask));
+
+    __m256 r = _mm256_add_ps (_mm256_mul_ps (p11, _mm256_mul_ps (a, b)), _mm256_mul_ps (p00, _mm256_mul_ps (ra, rb)));
+    r = _mm256_add_ps (r, _mm256_mul_ps (p10, _mm256_mul_ps (ra, b)));
+    r = _mm256_add_ps (r, _mm256_mul_ps (p01, _mm256_mul_ps (a, rb)));
+    _mm256_storeu_ps (out, r);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+gauss_rows_sse2 (const uint8_t *const *rows, uint32_t len, int16_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i w[SOFT_GAUSS_TAPS];
+    for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k)
+        w[k] = _mm_set1_epi16 (gauss_weights[k]);
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i lo = zero, hi = zero;
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k) {
+            __m128i v = _mm_loadu_si128 ((const __m128i *)(rows[k] + i));
+            lo = _mm_add_epi16 (lo, _mm_mullo_epi16 (_mm_unpacklo_epi8 (v, zero), w[k]));
+            hi = _mm_add_epi16 (hi, _mm_mullo_epi16 (_mm_unpackhi_epi8 (v, zero), w[k]));
+        }
+        // sums fit in unsigned 16 bits, (sum + 1) >> 1
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_avg_epu16 (lo, zero));
+        _mm_storeu_si128 ((__m128i *)(out + i + 8), _mm_avg_epu16 (hi, zero));
+    }
+    return i;
+}
+
+// 2x2 box of 16 bytes of row0 and row1 into 8 pixels, (a + b + c + d + 2) >> 2
+__attribute__ ((target ("sse2")))
+static inline __m128i
+half_box_sse2 (__m128i r0, __m128i r1)
+{
+    const __m128i mask = _mm_set1_epi16 (0x00FF);
+    __m128i sum = _mm_add_epi16 (
+        _mm_add_epi16 (_mm_and_si128 (r0, mask), _mm_srli_epi16 (r0, 8)),
+        _mm_add_epi16 (_mm_and_si128 (r1, mask), _mm_srli_epi16 (r1, 8)));
+    return _mm_srli_epi16 (_mm_add_epi16 (sum, _mm_set1_epi16 (2)), 2);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+half_uchar_sse2 (const uint8_t *row0, const uint8_t *row1, uint32_t out_len, uint8_t *out)
+{
+    uint32_t j = 0;
+    for (; j + 16 <= out_len; j += 16) {
+        const uint8_t *p0 = row0 + 2 * j;
+        const uint8_t *p1 = row1 + 2 * j;
+        __m128i lo = half_box_sse2 (
+            _mm_loadu_si128 ((const __m128i *)p0), _mm_loadu_si128 ((const __m128i *)p1));
+        __m128i hi = half_box_sse2 (
+            _mm_loadu_si128 ((const __m128i *)(p0 + 16)), _mm_loadu_si128 ((const __m128i *)(p1 + 16)));
+        _mm_storeu_si128 ((__m128i *)(out + j), _mm_packus_epi16 (lo, hi));
+    }
+    return j;
+}
+
+// 8 pixels of one reference, values stay in 16 bits since t * gain <= 255 * 128
+__attribute__ ((target ("sse2")))
+static inline __m128i
+tnr_step_sse2 (__m128i acc, __m128i ref, __m128i t, __m128i gain, __m128i strength)
+{
+    __m128i alpha = _mm_min_epi16 (_mm_mullo_epi16 (t, gain), strength);
+    __m128i delta = _mm_add_epi16 (_mm_mullo_epi16 (_mm_sub_epi16 (ref, acc), alpha), _mm_set1_epi16 (64));
+    return _mm_add_epi16 (acc, _mm_srai_epi16 (delta, 7));
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+tnr_blend_sse2 (
+    const uint8_t *cur, const uint8_t *const *refs, uint32_t ref_count, uint32_t len,
+    uint8_t threshold, const int16_t *gains, const int16_t *strengths, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i thr = _mm_set1_epi8 ((char)threshold);
+    __m128i g[SOFT_TNR_MAX_REFS], s[SOFT_TNR_MAX_REFS];
+    for (uint32_t k = 0; k < ref_count; ++k) {
+        g[k] = _mm_set1_epi16 (gains[k]);
+        s[k] = _mm_set1_epi16 (strengths[k]);
+    }
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i c = _mm_loadu_si128 ((const __m128i *)(cur + i));
+        __m128i lo = _mm_unpacklo_epi8 (c, zero);
+        __m128i hi = _mm_unpackhi_epi8 (c, zero);
+        for (uint32_t k = 0; k < ref_count; ++k) {
+            __m128i r = _mm_loadu_si128 ((const __m128i *)(refs[k] + i));
+            __m128i diff = _mm_or_si128 (_mm_subs_epu8 (r, c), _mm_subs_epu8 (c, r));
+            __m128i t = _mm_subs_epu8 (thr, diff);
+            lo = tnr_step_sse2 (lo, _mm_unpacklo_epi8 (r, zero), _mm_unpacklo_epi8 (t, zero), g[k], s[k]);
+            hi = tnr_step_sse2 (hi, _mm_unpackhi_epi8 (r, zero), _mm_unpackhi_epi8 (t, zero), g[k], s[k]);
+        }
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_packus_epi16 (lo, hi));
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+lerp_rows_sse2 (const uint8_t *row0, const uint8_t *row1, uint32_t len, uint32_t weight, uint16_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i w0 = _mm_set1_epi16 ((int16_t)((1 << SOFT_SCALE_WEIGHT_BITS) - weight));
+    const __m128i w1 = _mm_set1_epi16 ((int16_t)weight);
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i r0 = _mm_loadu_si128 ((const __m128i *)(row0 + i));
+        __m128i r1 = _mm_loadu_si128 ((const __m128i *)(row1 + i));
+        __m128i lo = _mm_add_epi16 (
+            _mm_mullo_epi16 (_mm_unpacklo_epi8 (r0, zero), w0), _mm_mullo_epi16 (_mm_unpacklo_epi8 (r1, zero), w1));
+        __m128i hi = _mm_add_epi16 (
+            _mm_mullo_epi16 (_mm_unpackhi_epi8 (r0, zero), w0), _mm_mullo_epi16 (_mm_unpackhi_epi8 (r1, zero), w1));
+        _mm_storeu_si128 ((__m128i *)(out + i), lo);
+        _mm_storeu_si128 ((__m128i *)(out + i + 8), hi);
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+sum_rows_sse2 (const uint8_t *const *rows, uint32_t count, uint32_t len, uint16_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i lo = zero, hi = zero;
+        for (uint32_t k = 0; k < count; ++k) {
+            __m128i v = _mm_loadu_si128 ((const __m128i *)(rows[k] + i));
+            lo = _mm_add_epi16 (lo, _mm_unpacklo_epi8 (v, zero));
+            hi = _mm_add_epi16 (hi, _mm_unpackhi_epi8 (v, zero));
+        }
+        _mm_storeu_si128 ((__m128i *)(out + i), lo);
+        _mm_storeu_si128 ((__m128i *)(out + i + 8), hi);
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+nv12_to_yuyv_sse2 (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m128i luma = _mm_loadu_si128 ((const __m128i *)(y + i));
+        __m128i chroma = _mm_loadu_si128 ((const __m128i *)(uv + i));
+        _mm_storeu_si128 ((__m128i *)(out + 2 * i), _mm_unpacklo_epi8 (luma, chroma));
+        _mm_storeu_si128 ((__m128i *)(out + 2 * i + 16), _mm_unpackhi_epi8 (luma, chroma));
+    }
+    return i;
+}
+
+// 4 chroma values of 32-bit lanes into 8 pixels, each value twice
+__attribute__ ((target ("sse2")))
+static inline __m128i
+dup_chroma_sse2 (__m128i c)
+{
+    __m128i packed = _mm_packs_epi32 (c, c);
+    return _mm_unpacklo_epi16 (packed, packed);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+nv12_to_rgba_sse2 (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i bias = _mm_set1_epi16 (128);
+    const __m128i round = _mm_set1_epi16 (1 << (CSC_SHIFT - 1));
+    const __m128i alpha = _mm_set1_epi8 ((char)0xFF);
+
+    uint32_t i = 0;
+    for (; i + 8 <= width; i += 8) {
+        __m128i luma = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)(y + i)), zero);
+        __m128i chroma = _mm_sub_epi16 (_mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)(uv + i)), zero), bias);
+        __m128i du = dup_chroma_sse2 (_mm_srai_epi32 (_mm_slli_epi32 (chroma, 16), 16));
+        __m128i dv = dup_chroma_sse2 (_mm_srai_epi32 (chroma, 16));
+
+        __m128i r = _mm_add_epi16 (luma, _mm_srai_epi16 (
+            _mm_add_epi16 (_mm_mullo_epi16 (dv, _mm_set1_epi16 (CSC_RV)), round), CSC_SHIFT));
+        __m128i g = _mm_sub_epi16 (luma, _mm_srai_epi16 (
+            _mm_add_epi16 (_mm_add_epi16 (
+                _mm_mullo_epi16 (du, _mm_set1_epi16 (CSC_GU)), _mm_mullo_epi16 (dv, _mm_set1_epi16 (CSC_GV))), round),
+            CSC_SHIFT));
+        __m128i b = _mm_add_epi16 (luma, _mm_srai_epi16 (
+            _mm_add_epi16 (_mm_mullo_epi16 (du, _mm_set1_epi16 (CSC_BU)), round), CSC_SHIFT));
+
+        __m128i rg = _mm_unpacklo_epi8 (_mm_packus_epi16 (r, r), _mm_packus_epi16 (g, g));
+        __m128i ba = _mm_unpacklo_epi8 (_mm_packus_epi16 (b, b), alpha);
+        _mm_storeu_si128 ((__m128i *)(out + 4 * i), _mm_unpacklo_epi16 (rg, ba));
+        _mm_storeu_si128 ((__m128i *)(out + 4 * i + 16), _mm_unpackhi_epi16 (rg, ba));
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+split_uv_sse2 (const uint8_t *uv, uint32_t uv_width, uint8_t *u, uint8_t *v)
+{
+    const __m128i mask = _mm_set1_epi16 (0x00FF);
+
+    uint32_t i = 0;
+    for (; i + 16 <= uv_width; i += 16) {
+        __m128i a = _mm_loadu_si128 ((const __m128i *)(uv + 2 * i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *)(uv + 2 * i + 16));
+        _mm_storeu_si128 ((__m128i *)(u + i), _mm_packus_epi16 (_mm_and_si128 (a, mask), _mm_and_si128 (b, mask)));
+        _mm_storeu_si128 ((__m128i *)(v + i), _mm_packus_epi16 (_mm_srli_epi16 (a, 8), _mm_srli_epi16 (b, 8)));
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+gauss_round_sse2 (__m128i acc)
+{
+    return _mm_srai_epi32 (_mm_add_epi32 (acc, _mm_set1_epi32 (1 << 14)), 15);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+gauss_uchar_sse2 (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    const __m128i w01 = _mm_set1_epi32 ((gauss_weights[1] << 16) | gauss_weights[0]);
+    const __m128i w23 = _mm_set1_epi32 ((gauss_weights[3] << 16) | gauss_weights[2]);
+    const __m128i w4 = _mm_set1_epi32 (gauss_weights[4]);
+
+    uint32_t j = 0;
+    for (; j + 8 <= out_len; j += 8) {
+        __m128i acc[2];
+        for (uint32_t h = 0; h < 2; ++h) {
+            // pairs of (in[2j], in[2j+1]) multiplied with pairs of weights
+            const int16_t *ptr = in + 2 * (j + h * 4);
+            __m128i sum = _mm_madd_epi16 (_mm_loadu_si128 ((const __m128i *)ptr), w01);
+            sum = _mm_add_epi32 (sum, _mm_madd_epi16 (_mm_loadu_si128 ((const __m128i *)(ptr + 2)), w23));
+            sum = _mm_add_epi32 (sum, _mm_madd_epi16 (_mm_loadu_si128 ((const __m128i *)(ptr + 4)), w4));
+            acc[h] = gauss_round_sse2 (sum);
+        }
+        __m128i v = _mm_packs_epi32 (acc[0], acc[1]);
+        _mm_storel_epi64 ((__m128i *)(out + j), _mm_packus_epi16 (v, v));
+    }
+    return j;
+}
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+gauss_even_pixels_sse2 (const int16_t *in)
+{
+    // Uchar2 pixels 0, 2, 4, 6 out of 8
+    __m128 lo = _mm_castsi128_ps (_mm_loadu_si128 ((const __m128i *)in));
+    __m128 hi = _mm_castsi128_ps (_mm_loadu_si128 ((const __m128i *)(in + 8)));
+    return _mm_castps_si128 (_mm_shuffle_ps (lo, hi, _MM_SHUFFLE (2, 0, 2, 0)));
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+gauss_uchar2_sse2 (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i w01 = _mm_set1_epi32 ((gauss_weights[1] << 16) | gauss_weights[0]);
+    const __m128i w23 = _mm_set1_epi32 ((gauss_weights[3] << 16) | gauss_weights[2]);
+    const __m128i w4 = _mm_set1_epi32 (gauss_weights[4]);
+
+    uint32_t j = 0;
+    for (; j + 4 <= out_len; j += 4) {
+        const int16_t *ptr = in + 4 * j;
+        __m128i x[SOFT_GAUSS_TAPS];
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k)
+            x[k] = gauss_even_pixels_sse2 (ptr + 2 * k);
+
+        __m128i lo = _mm_madd_epi16 (_mm_unpacklo_epi16 (x[0], x[1]), w01);
+        lo = _mm_add_epi32 (lo, _mm_madd_epi16 (_mm_unpacklo_epi16 (x[2], x[3]), w23));
+        lo = _mm_add_epi32 (lo, _mm_madd_epi16 (_mm_unpacklo_epi16 (x[4], zero), w4));
+        __m128i hi = _mm_madd_epi16 (_mm_unpackhi_epi16 (x[0], x[1]), w01);
+        hi = _mm_add_epi32 (hi, _mm_madd_epi16 (_mm_unpackhi_epi16 (x[2], x[3]), w23));
+        hi = _mm_add_epi32 (hi, _mm_madd_epi16 (_mm_unpackhi_epi16 (x[4], zero), w4));
+
+        __m128i v = _mm_packs_epi32 (gauss_round_sse2 (lo), gauss_round_sse2 (hi));
+        _mm_storel_epi64 ((__m128i *)(out + 2 * j), _mm_packus_epi16 (v, v));
+    }
+    return j;
+}
+
+// 16 up-sampled elements from 8 gauss bytes, odd ones average the next gauss pixel
+__attribute__ ((target ("sse2")))
+static inline void
+lap_up_sample_sse2 (const uint8_t *g0, const uint8_t *g1, uint32_t channels, __m128i &lo, __m128i &hi)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i cur = _mm_add_epi16 (
+        _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)g0), zero),
+        _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)g1), zero));
+    __m128i next = _mm_add_epi16 (
+        _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)(g0 + channels)), zero),
+        _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)(g1 + channels)), zero));
+    __m128i even = _mm_add_epi16 (cur, cur);
+    __m128i odd = _mm_add_epi16 (cur, next);
+    if (channels == 1) {
+        lo = _mm_unpacklo_epi16 (even, odd);
+        hi = _mm_unpackhi_epi16 (even, odd);
+    } else {
+        lo = _mm_unpacklo_epi32 (even, odd);
+        hi = _mm_unpackhi_epi32 (even, odd);
+    }
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+laplace_row_sse2 (
+    const uint8_t *orig, const uint8_t *g0, const uint8_t *g1, uint32_t len, uint32_t g_len, uint32_t channels, int16_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        __m128i up_lo, up_hi;
+        lap_up_sample_sse2 (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        __m128i o = _mm_loadu_si128 ((const __m128i *)(orig + i));
+        __m128i lo = _mm_slli_epi16 (_mm_unpacklo_epi8 (o, zero), SOFT_LAP_FRAC_BITS);
+        __m128i hi = _mm_slli_epi16 (_mm_unpackhi_epi8 (o, zero), SOFT_LAP_FRAC_BITS);
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_subs_epi16 (lo, up_lo));
+        _mm_storeu_si128 ((__m128i *)(out + i + 8), _mm_subs_epi16 (hi, up_hi));
+    }
+    return i;
+}
+
+// mask weights of the first and the second input, m + (m >> 7) and 256 - that
+__attribute__ ((target ("sse2")))
+static inline void
+blend_weights_sse2 (__m128i mask, __m128i &w0, __m128i &w1)
+{
+    w0 = _mm_add_epi16 (mask, _mm_srli_epi16 (mask, 7));
+    w1 = _mm_sub_epi16 (_mm_set1_epi16 (256), w0);
+}
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+reconstruct_sse2 (__m128i lap0, __m128i lap1, __m128i w0, __m128i w1, __m128i up)
+{
+    const __m128i round = _mm_set1_epi32 (1 << (SOFT_LAP_FRAC_BITS + 7));
+    __m128i lo = _mm_madd_epi16 (_mm_unpacklo_epi16 (lap0, lap1), _mm_unpacklo_epi16 (w0, w1));
+    __m128i hi = _mm_madd_epi16 (_mm_unpackhi_epi16 (lap0, lap1), _mm_unpackhi_epi16 (w0, w1));
+    lo = _mm_add_epi32 (lo, _mm_slli_epi32 (_mm_srai_epi32 (_mm_unpacklo_epi16 (up, up), 16), 8));
+    hi = _mm_add_epi32 (hi, _mm_slli_epi32 (_mm_srai_epi32 (_mm_unpackhi_epi16 (up, up), 16), 8));
+    lo = _mm_srai_epi32 (_mm_add_epi32 (lo, round), SOFT_LAP_FRAC_BITS + 8);
+    hi = _mm_srai_epi32 (_mm_add_epi32 (hi, round), SOFT_LAP_FRAC_BITS + 8);
+    return _mm_packs_epi32 (lo, hi);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+reconstruct_row_sse2 (
+    const int16_t *lap0, const int16_t *lap1, const uint8_t *mask, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        __m128i up_lo, up_hi, w0, w1;
+        lap_up_sample_sse2 (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        __m128i m = _mm_loadu_si128 ((const __m128i *)(mask + i));
+
+        blend_weights_sse2 (_mm_unpacklo_epi8 (m, zero), w0, w1);
+        __m128i lo = reconstruct_sse2 (
+            _mm_loadu_si128 ((const __m128i *)(lap0 + i)), _mm_loadu_si128 ((const __m128i *)(lap1 + i)), w0, w1, up_lo);
+        blend_weights_sse2 (_mm_unpackhi_epi8 (m, zero), w0, w1);
+        __m128i hi = reconstruct_sse2 (
+            _mm_loadu_si128 ((const __m128i *)(lap0 + i + 8)), _mm_loadu_si128 ((const __m128i *)(lap1 + i + 8)),
+            w0, w1, up_hi);
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_packus_epi16 (lo, hi));
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+blend_row_sse2 (const uint8_t *in0, const uint8_t *in1, const uint8_t *mask, uint32_t len, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i round = _mm_set1_epi16 (128);
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128 ((const __m128i *)(in0 + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *)(in1 + i));
+        __m128i m = _mm_loadu_si128 ((const __m128i *)(mask + i));
+        __m128i w0, w1;
+
+        // sums stay below 65536, so unsigned 16-bit is enough
+        blend_weights_sse2 (_mm_unpacklo_epi8 (m, zero), w0, w1);
+        __m128i lo = _mm_add_epi16 (
+            _mm_mullo_epi16 (_mm_unpacklo_epi8 (a, zero), w0), _mm_mullo_epi16 (_mm_unpacklo_epi8 (b, zero), w1));
+        blend_weights_sse2 (_mm_unpackhi_epi8 (m, zero), w0, w1);
+        __m128i hi = _mm_add_epi16 (
+            _mm_mullo_epi16 (_mm_unpackhi_epi8 (a, zero), w0), _mm_mullo_epi16 (_mm_unpackhi_epi8 (b, zero), w1));
+        lo = _mm_srli_epi16 (_mm_adds_epu16 (lo, round), 8);
+        hi = _mm_srli_epi16 (_mm_adds_epu16 (hi, round), 8);
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_packus_epi16 (lo, hi));
+    }
+    return i;
+}
+
+// 32-bit sums of 8 elements, weights are non-negative so zero pairs keep signed products
+__attribute__ ((target ("sse2")))
+static inline void
+fuse_add_sse2 (__m128i v, __m128i w, __m128i &lo, __m128i &hi)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    lo = _mm_add_epi32 (lo, _mm_madd_epi16 (_mm_unpacklo_epi16 (v, zero), _mm_unpacklo_epi16 (w, zero)));
+    hi = _mm_add_epi32 (hi, _mm_madd_epi16 (_mm_unpackhi_epi16 (v, zero), _mm_unpackhi_epi16 (w, zero)));
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+fuse_row_sse2 (const uint8_t *const *ins, const int16_t *const *weights, uint32_t count, uint32_t len, uint8_t *out)
+{
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i round = _mm_set1_epi32 (128);
+
+    uint32_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        __m128i lo = round, hi = round;
+        for (uint32_t k = 0; k < count; ++k) {
+            __m128i v = _mm_unpacklo_epi8 (_mm_loadl_epi64 ((const __m128i *)(ins[k] + i)), zero);
+            fuse_add_sse2 (v, _mm_loadu_si128 ((const __m128i *)(weights[k] + i)), lo, hi);
+        }
+        __m128i v = _mm_packs_epi32 (_mm_srai_epi32 (lo, 8), _mm_srai_epi32 (hi, 8));
+        _mm_storel_epi64 ((__m128i *)(out + i), _mm_packus_epi16 (v, v));
+    }
+    return i;
+}
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+fuse_reconstruct_sse2 (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, uint32_t i, __m128i up)
+{
+    const __m128i round = _mm_set1_epi32 (1 << (SOFT_LAP_FRAC_BITS + 7));
+    __m128i lo = _mm_slli_epi32 (_mm_srai_epi32 (_mm_unpacklo_epi16 (up, up), 16), 8);
+    __m128i hi = _mm_slli_epi32 (_mm_srai_epi32 (_mm_unpackhi_epi16 (up, up), 16), 8);
+    for (uint32_t k = 0; k < count; ++k) {
+        fuse_add_sse2 (
+            _mm_loadu_si128 ((const __m128i *)(laps[k] + i)), _mm_loadu_si128 ((const __m128i *)(weights[k] + i)),
+            lo, hi);
+    }
+    lo = _mm_srai_epi32 (_mm_add_epi32 (lo, round), SOFT_LAP_FRAC_BITS + 8);
+    hi = _mm_srai_epi32 (_mm_add_epi32 (hi, round), SOFT_LAP_FRAC_BITS + 8);
+    return _mm_packs_epi32 (lo, hi);
+}
+
+__attribute__ ((target ("sse2")))
+static uint32_t
+fuse_reconstruct_row_sse2 (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        __m128i up_lo, up_hi;
+        lap_up_sample_sse2 (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        __m128i lo = fuse_reconstruct_sse2 (laps, weights, count, i, up_lo);
+        __m128i hi = fuse_reconstruct_sse2 (laps, weights, count, i + 8, up_hi);
+        _mm_storeu_si128 ((__m128i *)(out + i), _mm_packus_epi16 (lo, hi));
+    }
+    return i;
+}
+
+// head bytes up to 16-byte aligned @dst are copied as usual, stores are fenced before return
+__attribute__ ((target ("sse2")))
+static uint32_t
+stream_copy_sse2 (const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+    uint32_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (len < head + 64)
+        return 0;
+
+    memcpy (dst, src, head);
+    uint32_t i = head;
+    for (; i + 64 <= len; i += 64) {
+        __m128i a = _mm_loadu_si128 ((const __m128i *)(src + i));
+        __m128i b = _mm_loadu_si128 ((const __m128i *)(src + i + 16));
+        __m128i c = _mm_loadu_si128 ((const __m128i *)(src + i + 32));
+        __m128i d = _mm_loadu_si128 ((const __m128i *)(src + i + 48));
+        _mm_stream_si128 ((__m128i *)(dst + i), a);
+        _mm_stream_si128 ((__m128i *)(dst + i + 16), b);
+        _mm_stream_si128 ((__m128i *)(dst + i + 32), c);
+        _mm_stream_si128 ((__m128i *)(dst + i + 48), d);
+    }
+    _mm_sfence ();
+    return i;
+}
+
+#endif
+
+#if XCAM_SOFT_SIMD_NEON
+
+static inline void
+calc_weights_neon (
+    const Float2 *pos, uint32_t pitch, uint32_t pixel_bytes, int32_t *offsets,
+    float32x4_t &w11, float32x4_t &w00, float32x4_t &w10, float32x4_t &w01)
+{
+    float32x4x2_t xy = vld2q_f32 (&pos[0].x);
+    int32x4_t xi = vcvtq_s32_f32 (xy.val[0]);
+    int32x4_t yi = vcvtq_s32_f32 (xy.val[1]);
+    float32x4_t a = vsubq_f32 (xy.val[0], vcvtq_f32_s32 (xi));
+    float32x4_t b = vsubq_f32 (xy.val[1], vcvtq_f32_s32 (yi));
+    float32x4_t one = vdupq_n_f32 (1.0f);
+    float32x4_t ra = vsubq_f32 (one, a);
+    float32x4_t rb = vsubq_f32 (one, b);
+
+    w11 = vmulq_f32 (a, b);
+    w00 = vmulq_f32 (ra, rb);
+    w10 = vmulq_f32 (ra, b);
+    w01 = vmulq_f32 (a, rb);
+
+    int32x4_t off = vaddq_s32 (
+        vmulq_s32 (yi, vdupq_n_s32 (pitch)), vmulq_s32 (xi, vdupq_n_s32 (pixel_bytes)));
+    vst1q_s32 (offsets, off);
+}
+
+static inline float32x4_t
+blend_neon (
+    float32x4_t p00, float32x4_t p01, float32x4_t p10, float32x4_t p11,
+    float32x4_t w00, float32x4_t w01, float32x4_t w10, float32x4_t w11)
+{
+    float32x4_t r = vaddq_f32 (vmulq_f32 (p11, w11), vmulq_f32 (p00, w00));
+    r = vaddq_f32 (r, vmulq_f32 (p10, w10));
+    return vaddq_f32 (r, vmulq_f32 (p01, w01));
+}
+
+static inline float32x4_t
+u32_byte_to_f32 (uint32x4_t v, int shift)
+{
+    return vcvtq_f32_u32 (vandq_u32 (vshlq_u32 (v, vdupq_n_s32 (-shift)), vdupq_n_u32 (0xFF)));
+}
+
+static void
+interp_uchar_8_neon (const uint8_t *buf, uint32_t pitch, const Float2 *pos, float *out)
+{
+    int32_t off[4];
+    float32x4_t w11, w00, w10, w01;
+
+    for (uint32_t i = 0; i < 8; i += 4) {
+        calc_weights_neon (pos + i, pitch, 1, off, w11, w00, w10, w01);
+        uint32_t r0[4] = {
+            load_u16 (buf + off[0]), load_u16 (buf + off[1]), load_u16 (buf + off[2]), load_u16 (buf + off[3])
+        };
+        uint32_t r1[4] = {
+            load_u16 (buf + off[0] + pitch), load_u16 (buf + off[1] + pitch),
+            load_u16 (buf + off[2] + pitch), load_u16 (buf + off[3] + pitch)
+        };
+        uint32x4_t row0 = vld1q_u32 (r0);
+        uint32x4_t row1 = vld1q_u32 (r1);
+        vst1q_f32 (out + i, blend_neon (
+                       u32_byte_to_f32 (row0, 0), u32_byte_to_f32 (row0, 8),
+                       u32_byte_to_f32 (row1, 0), u32_byte_to_f32 (row1, 8),
+                       w00, w01, w10, w11));
+    }
+}
+
+static void
+interp_uchar2_4_neon (const uint8_t *buf, uint32_t pitch, const Float2 *pos, Float2 *out)
+{
+    int32_t off[4];
+    float32x4_t w11, w00, w10, w01;
+
+    calc_weights_neon (pos, pitch, 2, off, w11, w00, w10, w01);
+    uint32_t r0[4] = {
+        (uint32_t)load_u32 (buf + off[0]), (uint32_t)load_u32 (buf + off[1]),
+        (uint32_t)load_u32 (buf + off[2]), (uint32_t)load_u32 (buf + off[3])
+    };
+    uint32_t r1[4] = {
+        (uint32_t)load_u32 (buf + off[0] + pitch), (uint32_t)load_u32 (buf + off[1] + pitch),
+        (uint32_t)load_u32 (buf + off[2] + pitch), (uint32_t)load_u32 (buf + off[3] + pitch)
+    };
+    uint32x4_t row0 = vld1q_u32 (r0);
+    uint32x4_t row1 = vld1q_u32 (r1);
+
+    float32x4x2_t uv;
+    uv.val[0] = blend_neon (
+                    u32_byte_to_f32 (row0, 0), u32_byte_to_f32 (row0, 16),
+                    u32_byte_to_f32 (row1, 0), u32_byte_to_f32 (row1, 16),
+                    w00, w01, w10, w11);
+    uv.val[1] = blend_neon (
+                    u32_byte_to_f32 (row0, 8), u32_byte_to_f32 (row0, 24),
+                    u32_byte_to_f32 (row1, 8), u32_byte_to_f32 (row1, 24),
+                    w00, w01, w10, w11);
+    vst2q_f32 (&out[0].x, uv);
+}
+
+static uint32_t
+gauss_rows_neon (const uint8_t *const *rows, uint32_t len, int16_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint16x8_t lo = vdupq_n_u16 (0), hi = vdupq_n_u16 (0);
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k) {
+            uint8x16_t v = vld1q_u8 (rows[k] + i);
+            uint8x8_t w = vdup_n_u8 ((uint8_t)gauss_weights[k]);
+            lo = vmlal_u8 (lo, vget_low_u8 (v), w);
+            hi = vmlal_u8 (hi, vget_high_u8 (v), w);
+        }
+        vst1q_s16 (out + i, vreinterpretq_s16_u16 (vrshrq_n_u16 (lo, 1)));
+        vst1q_s16 (out + i + 8, vreinterpretq_s16_u16 (vrshrq_n_u16 (hi, 1)));
+    }
+    return i;
+}
+
+static inline uint8x8_t
+gauss_taps_neon (int16x8_t t0, int16x8_t t1, int16x8_t t2, int16x8_t t3, int16x8_t t4)
+{
+    int32x4_t lo = vmull_n_s16 (vget_low_s16 (t0), gauss_weights[0]);
+    int32x4_t hi = vmull_n_s16 (vget_high_s16 (t0), gauss_weights[0]);
+    lo = vmlal_n_s16 (lo, vget_low_s16 (t1), gauss_weights[1]);
+    hi = vmlal_n_s16 (hi, vget_high_s16 (t1), gauss_weights[1]);
+    lo = vmlal_n_s16 (lo, vget_low_s16 (t2), gauss_weights[2]);
+    hi = vmlal_n_s16 (hi, vget_high_s16 (t2), gauss_weights[2]);
+    lo = vmlal_n_s16 (lo, vget_low_s16 (t3), gauss_weights[3]);
+    hi = vmlal_n_s16 (hi, vget_high_s16 (t3), gauss_weights[3]);
+    lo = vmlal_n_s16 (lo, vget_low_s16 (t4), gauss_weights[4]);
+    hi = vmlal_n_s16 (hi, vget_high_s16 (t4), gauss_weights[4]);
+    return vqmovun_s16 (vcombine_s16 (vrshrn_n_s32 (lo, 15), vrshrn_n_s32 (hi, 15)));
+}
+
+static uint32_t
+gauss_uchar_neon (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    uint32_t j = 0;
+    for (; j + 8 <= out_len; j += 8) {
+        const int16_t *ptr = in + 2 * j;
+        int16x8x2_t t01 = vld2q_s16 (ptr);
+        int16x8x2_t t23 = vld2q_s16 (ptr + 2);
+        int16x8x2_t t4 = vld2q_s16 (ptr + 4);
+        vst1_u8 (out + j, gauss_taps_neon (t01.val[0], t01.val[1], t23.val[0], t23.val[1], t4.val[0]));
+    }
+    return j;
+}
+
+static uint32_t
+gauss_uchar2_neon (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    uint32_t j = 0;
+    for (; j + 8 <= out_len; j += 8) {
+        // val[0], val[1]: u, v of even pixels, val[2], val[3]: u, v of odd pixels
+        const int16_t *ptr = in + 4 * j;
+        int16x8x4_t t01 = vld4q_s16 (ptr);
+        int16x8x4_t t23 = vld4q_s16 (ptr + 4);
+        int16x8x4_t t4 = vld4q_s16 (ptr + 8);
+        uint8x8x2_t uv;
+        uv.val[0] = gauss_taps_neon (t01.val[0], t01.val[2], t23.val[0], t23.val[2], t4.val[0]);
+        uv.val[1] = gauss_taps_neon (t01.val[1], t01.val[3], t23.val[1], t23.val[3], t4.val[1]);
+        vst2_u8 (out + 2 * j, uv);
+    }
+    return j;
+}
+
+static uint32_t
+half_uchar_neon (const uint8_t *row0, const uint8_t *row1, uint32_t out_len, uint8_t *out)
+{
+    uint32_t j = 0;
+    for (; j + 8 <= out_len; j += 8) {
+        uint16x8_t sum = vpaddlq_u8 (vld1q_u8 (row0 + 2 * j));
+        sum = vpadalq_u8 (sum, vld1q_u8 (row1 + 2 * j));
+        vst1_u8 (out + j, vrshrn_n_u16 (sum, 2));
+    }
+    return j;
+}
+
+static inline int16x8_t
+tnr_step_neon (int16x8_t acc, uint8x8_t ref, uint8x8_t t, int16x8_t gain, int16x8_t strength)
+{
+    int16x8_t alpha = vminq_s16 (vmulq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (t)), gain), strength);
+    int16x8_t r = vreinterpretq_s16_u16 (vmovl_u8 (ref));
+    return vaddq_s16 (acc, vrshrq_n_s16 (vmulq_s16 (vsubq_s16 (r, acc), alpha), 7));
+}
+
+static uint32_t
+tnr_blend_neon (
+    const uint8_t *cur, const uint8_t *const *refs, uint32_t ref_count, uint32_t len,
+    uint8_t threshold, const int16_t *gains, const int16_t *strengths, uint8_t *out)
+{
+    const uint8x16_t thr = vdupq_n_u8 (threshold);
+    int16x8_t g[SOFT_TNR_MAX_REFS], s[SOFT_TNR_MAX_REFS];
+    for (uint32_t k = 0; k < ref_count; ++k) {
+        g[k] = vdupq_n_s16 (gains[k]);
+        s[k] = vdupq_n_s16 (strengths[k]);
+    }
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t c = vld1q_u8 (cur + i);
+        int16x8_t lo = vreinterpretq_s16_u16 (vmovl_u8 (vget_low_u8 (c)));
+        int16x8_t hi = vreinterpretq_s16_u16 (vmovl_u8 (vget_high_u8 (c)));
+        for (uint32_t k = 0; k < ref_count; ++k) {
+            uint8x16_t r = vld1q_u8 (refs[k] + i);
+            uint8x16_t t = vqsubq_u8 (thr, vabdq_u8 (r, c));
+            lo = tnr_step_neon (lo, vget_low_u8 (r), vget_low_u8 (t), g[k], s[k]);
+            hi = tnr_step_neon (hi, vget_high_u8 (r), vget_high_u8 (t), g[k], s[k]);
+        }
+        vst1q_u8 (out + i, vcombine_u8 (vqmovun_s16 (lo), vqmovun_s16 (hi)));
+    }
+    return i;
+}
+
+static uint32_t
+lerp_rows_neon (const uint8_t *row0, const uint8_t *row1, uint32_t len, uint32_t weight, uint16_t *out)
+{
+    const uint8x8_t w0 = vdup_n_u8 ((uint8_t)((1 << SOFT_SCALE_WEIGHT_BITS) - weight));
+    const uint8x8_t w1 = vdup_n_u8 ((uint8_t)weight);
+
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t r0 = vld1q_u8 (row0 + i);
+        uint8x16_t r1 = vld1q_u8 (row1 + i);
+        vst1q_u16 (out + i, vmlal_u8 (vmull_u8 (vget_low_u8 (r0), w0), vget_low_u8 (r1), w1));
+        vst1q_u16 (out + i + 8, vmlal_u8 (vmull_u8 (vget_high_u8 (r0), w0), vget_high_u8 (r1), w1));
+    }
+    return i;
+}
+
+static uint32_t
+sum_rows_neon (const uint8_t *const *rows, uint32_t count, uint32_t len, uint16_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint16x8_t lo = vdupq_n_u16 (0), hi = vdupq_n_u16 (0);
+        for (uint32_t k = 0; k < count; ++k) {
+            uint8x16_t v = vld1q_u8 (rows[k] + i);
+            lo = vaddw_u8 (lo, vget_low_u8 (v));
+            hi = vaddw_u8 (hi, vget_high_u8 (v));
+        }
+        vst1q_u16 (out + i, lo);
+        vst1q_u16 (out + i + 8, hi);
+    }
+    return i;
+}
+
+static uint32_t
+nv12_to_yuyv_neon (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        uint8x16x2_t yuyv;
+        yuyv.val[0] = vld1q_u8 (y + i);
+        yuyv.val[1] = vld1q_u8 (uv + i);
+        vst2q_u8 (out + 2 * i, yuyv);
+    }
+    return i;
+}
+
+static inline uint8x16_t
+csc_add_neon (uint8x16_t luma, int16x8_t delta)
+{
+    // delta of 8 chroma pairs, each for 2 pixels
+    int16x8x2_t d = vzipq_s16 (delta, delta);
+    int16x8_t lo = vaddq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (vget_low_u8 (luma))), d.val[0]);
+    int16x8_t hi = vaddq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (vget_high_u8 (luma))), d.val[1]);
+    return vcombine_u8 (vqmovun_s16 (lo), vqmovun_s16 (hi));
+}
+
+static uint32_t
+nv12_to_rgba_neon (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    const int16x8_t bias = vdupq_n_s16 (128);
+
+    uint32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        uint8x16_t luma = vld1q_u8 (y + i);
+        uint8x8x2_t chroma = vld2_u8 (uv + i);
+        int16x8_t du = vsubq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (chroma.val[0])), bias);
+        int16x8_t dv = vsubq_s16 (vreinterpretq_s16_u16 (vmovl_u8 (chroma.val[1])), bias);
+
+        int16x8_t dr = vrshrq_n_s16 (vmulq_n_s16 (dv, CSC_RV), CSC_SHIFT);
+        int16x8_t dg = vnegq_s16 (vrshrq_n_s16 (vmlaq_n_s16 (vmulq_n_s16 (du, CSC_GU), dv, CSC_GV), CSC_SHIFT));
+        int16x8_t db = vrshrq_n_s16 (vmulq_n_s16 (du, CSC_BU), CSC_SHIFT);
+
+        uint8x16x4_t rgba;
+        rgba.val[0] = csc_add_neon (luma, dr);
+        rgba.val[1] = csc_add_neon (luma, dg);
+        rgba.val[2] = csc_add_neon (luma, db);
+        rgba.val[3] = vdupq_n_u8 (0xFF);
+        vst4q_u8 (out + 4 * i, rgba);
+    }
+    return i;
+}
+
+static uint32_t
+split_uv_neon (const uint8_t *uv, uint32_t uv_width, uint8_t *u, uint8_t *v)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= uv_width; i += 16) {
+        uint8x16x2_t chroma = vld2q_u8 (uv + 2 * i);
+        vst1q_u8 (u + i, chroma.val[0]);
+        vst1q_u8 (v + i, chroma.val[1]);
+    }
+    return i;
+}
+
+static inline void
+lap_up_sample_neon (const uint8_t *g0, const uint8_t *g1, uint32_t channels, int16x8_t &lo, int16x8_t &hi)
+{
+    int16x8_t cur = vreinterpretq_s16_u16 (vaddl_u8 (vld1_u8 (g0), vld1_u8 (g1)));
+    int16x8_t next = vreinterpretq_s16_u16 (vaddl_u8 (vld1_u8 (g0 + channels), vld1_u8 (g1 + channels)));
+    int16x8_t even = vaddq_s16 (cur, cur);
+    int16x8_t odd = vaddq_s16 (cur, next);
+    if (channels == 1) {
+        int16x8x2_t zip = vzipq_s16 (even, odd);
+        lo = zip.val[0];
+        hi = zip.val[1];
+    } else {
+        int32x4x2_t zip = vzipq_s32 (vreinterpretq_s32_s16 (even), vreinterpretq_s32_s16 (odd));
+        lo = vreinterpretq_s16_s32 (zip.val[0]);
+        hi = vreinterpretq_s16_s32 (zip.val[1]);
+    }
+}
+
+static uint32_t
+laplace_row_neon (
+    const uint8_t *orig, const uint8_t *g0, const uint8_t *g1, uint32_t len, uint32_t g_len, uint32_t channels, int16_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        int16x8_t up_lo, up_hi;
+        lap_up_sample_neon (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        uint8x16_t o = vld1q_u8 (orig + i);
+        int16x8_t lo = vreinterpretq_s16_u16 (vshll_n_u8 (vget_low_u8 (o), SOFT_LAP_FRAC_BITS));
+        int16x8_t hi = vreinterpretq_s16_u16 (vshll_n_u8 (vget_high_u8 (o), SOFT_LAP_FRAC_BITS));
+        vst1q_s16 (out + i, vqsubq_s16 (lo, up_lo));
+        vst1q_s16 (out + i + 8, vqsubq_s16 (hi, up_hi));
+    }
+    return i;
+}
+
+static inline uint8x8_t
+reconstruct_neon (int16x8_t lap0, int16x8_t lap1, uint8x8_t mask, int16x8_t up)
+{
+    uint16x8_t m = vmovl_u8 (mask);
+    int16x8_t w0 = vreinterpretq_s16_u16 (vsraq_n_u16 (m, m, 7));
+    int16x8_t w1 = vsubq_s16 (vdupq_n_s16 (256), w0);
+    int32x4_t lo = vshll_n_s16 (vget_low_s16 (up), 8);
+    int32x4_t hi = vshll_n_s16 (vget_high_s16 (up), 8);
+    lo = vmlal_s16 (vmlal_s16 (lo, vget_low_s16 (lap0), vget_low_s16 (w0)), vget_low_s16 (lap1), vget_low_s16 (w1));
+    hi = vmlal_s16 (vmlal_s16 (hi, vget_high_s16 (lap0), vget_high_s16 (w0)), vget_high_s16 (lap1), vget_high_s16 (w1));
+    return vqmovun_s16 (vcombine_s16 (
+        vrshrn_n_s32 (lo, SOFT_LAP_FRAC_BITS + 8), vrshrn_n_s32 (hi, SOFT_LAP_FRAC_BITS + 8)));
+}
+
+static uint32_t
+reconstruct_row_neon (
+    const int16_t *lap0, const int16_t *lap1, const uint8_t *mask, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        int16x8_t up_lo, up_hi;
+        lap_up_sample_neon (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        uint8x16_t m = vld1q_u8 (mask + i);
+        uint8x8_t lo = reconstruct_neon (vld1q_s16 (lap0 + i), vld1q_s16 (lap1 + i), vget_low_u8 (m), up_lo);
+        uint8x8_t hi = reconstruct_neon (vld1q_s16 (lap0 + i + 8), vld1q_s16 (lap1 + i + 8), vget_high_u8 (m), up_hi);
+        vst1q_u8 (out + i, vcombine_u8 (lo, hi));
+    }
+    return i;
+}
+
+static inline uint8x8_t
+mask_blend_neon (uint8x8_t a, uint8x8_t b, uint8x8_t mask)
+{
+    uint16x8_t m = vmovl_u8 (mask);
+    uint16x8_t w0 = vsraq_n_u16 (m, m, 7);
+    uint16x8_t w1 = vsubq_u16 (vdupq_n_u16 (256), w0);
+    uint16x8_t sum = vmlaq_u16 (vmulq_u16 (vmovl_u8 (a), w0), vmovl_u8 (b), w1);
+    return vrshrn_n_u16 (sum, 8);
+}
+
+static uint32_t
+blend_row_neon (const uint8_t *in0, const uint8_t *in1, const uint8_t *mask, uint32_t len, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t a = vld1q_u8 (in0 + i);
+        uint8x16_t b = vld1q_u8 (in1 + i);
+        uint8x16_t m = vld1q_u8 (mask + i);
+        vst1q_u8 (out + i, vcombine_u8 (
+                      mask_blend_neon (vget_low_u8 (a), vget_low_u8 (b), vget_low_u8 (m)),
+                      mask_blend_neon (vget_high_u8 (a), vget_high_u8 (b), vget_high_u8 (m))));
+    }
+    return i;
+}
+
+static uint32_t
+fuse_row_neon (const uint8_t *const *ins, const int16_t *const *weights, uint32_t count, uint32_t len, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        int32x4_t lo = vdupq_n_s32 (0), hi = vdupq_n_s32 (0);
+        for (uint32_t k = 0; k < count; ++k) {
+            int16x8_t v = vreinterpretq_s16_u16 (vmovl_u8 (vld1_u8 (ins[k] + i)));
+            int16x8_t w = vld1q_s16 (weights[k] + i);
+            lo = vmlal_s16 (lo, vget_low_s16 (v), vget_low_s16 (w));
+            hi = vmlal_s16 (hi, vget_high_s16 (v), vget_high_s16 (w));
+        }
+        vst1_u8 (out + i, vqmovun_s16 (vcombine_s16 (vrshrn_n_s32 (lo, 8), vrshrn_n_s32 (hi, 8))));
+    }
+    return i;
+}
+
+static inline uint8x8_t
+fuse_reconstruct_neon (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, uint32_t i, int16x8_t up)
+{
+    int32x4_t lo = vshll_n_s16 (vget_low_s16 (up), 8);
+    int32x4_t hi = vshll_n_s16 (vget_high_s16 (up), 8);
+    for (uint32_t k = 0; k < count; ++k) {
+        int16x8_t lap = vld1q_s16 (laps[k] + i);
+        int16x8_t w = vld1q_s16 (weights[k] + i);
+        lo = vmlal_s16 (lo, vget_low_s16 (lap), vget_low_s16 (w));
+        hi = vmlal_s16 (hi, vget_high_s16 (lap), vget_high_s16 (w));
+    }
+    return vqmovun_s16 (vcombine_s16 (
+        vrshrn_n_s32 (lo, SOFT_LAP_FRAC_BITS + 8), vrshrn_n_s32 (hi, SOFT_LAP_FRAC_BITS + 8)));
+}
+
+static uint32_t
+fuse_reconstruct_row_neon (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, const uint8_t *g0, const uint8_t *g1,
+    uint32_t len, uint32_t g_len, uint32_t channels, uint8_t *out)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= len && i / 2 + 8 + channels <= g_len; i += 16) {
+        int16x8_t up_lo, up_hi;
+        lap_up_sample_neon (g0 + i / 2, g1 + i / 2, channels, up_lo, up_hi);
+        vst1q_u8 (out + i, vcombine_u8 (
+                      fuse_reconstruct_neon (laps, weights, count, i, up_lo),
+                      fuse_reconstruct_neon (laps, weights, count, i + 8, up_hi)));
+    }
+    return i;
+}
+
+#endif
+
+static SoftSimdFuncs
+select_funcs (SoftSimdType type)
+{
+    SoftSimdFuncs funcs = {
+        SoftSimdNone, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        NULL};
+
+#if XCAM_SOFT_SIMD_X86
+    __builtin_cpu_init ();
+    if (type >= SoftSimdAVX2 && __builtin_cpu_supports ("avx2")) {
+        funcs.type = SoftSimdAVX2;
+        funcs.uchar_8 = interp_uchar_8_avx2;
+        funcs.uchar2_4 = interp_uchar2_4_sse;
+    } else if (type >= SoftSimdSSE4 && __builtin_cpu_supports ("sse4.1")) {
+        funcs.type = SoftSimdSSE4;
+        funcs.uchar_8 = interp_uchar_8_sse;
+        funcs.uchar2_4 = interp_uchar2_4_sse;
+    }
+    if (funcs.type != SoftSimdNone) {
+        funcs.gauss_rows = gauss_rows_sse2;
+        funcs.gauss_uchar = gauss_uchar_sse2;
+        funcs.gauss_uchar2 = gauss_uchar2_sse2;
+        funcs.half_uchar = half_uchar_sse2;
+        funcs.tnr_blend = tnr_blend_sse2;
+        funcs.lerp_rows = lerp_rows_sse2;
+        funcs.sum_rows = sum_rows_sse2;
+        funcs.nv12_to_yuyv = nv12_to_yuyv_sse2;
+        funcs.nv12_to_rgba = nv12_to_rgba_sse2;
+        funcs.split_uv = split_uv_sse2;
+        funcs.laplace_row = laplace_row_sse2;
+        funcs.reconstruct_row = reconstruct_row_sse2;
+        funcs.blend_row = blend_row_sse2;
+        funcs.fuse_row = fuse_row_sse2;
+        funcs.fuse_reconstruct_row = fuse_reconstruct_row_sse2;
+        funcs.stream_copy = stream_copy_sse2;
+    }
+#elif XCAM_SOFT_SIMD_NEON
+    if (type >= SoftSimdNEON) {
+        funcs.type = SoftSimdNEON;
+        funcs.uchar_8 = interp_uchar_8_neon;
+        funcs.uchar2_4 = interp_uchar2_4_neon;
+        funcs.gauss_rows = gauss_rows_neon;
+        funcs.gauss_uchar = gauss_uchar_neon;
+        funcs.gauss_uchar2 = gauss_uchar2_neon;
+        funcs.half_uchar = half_uchar_neon;
+        funcs.tnr_blend = tnr_blend_neon;
+        funcs.lerp_rows = lerp_rows_neon;
+        funcs.sum_rows = sum_rows_neon;
+        funcs.nv12_to_yuyv = nv12_to_yuyv_neon;
+        funcs.nv12_to_rgba = nv12_to_rgba_neon;
+        funcs.split_uv = split_uv_neon;
+        funcs.laplace_row = laplace_row_neon;
+        funcs.reconstruct_row = reconstruct_row_neon;
+        funcs.blend_row = blend_row_neon;
+        funcs.fuse_row = fuse_row_neon;
+        funcs.fuse_reconstruct_row = fuse_reconstruct_row_neon;
+    }
+#else
+    XCAM_UNUSED (type);
+#endif
+
+    return funcs;
+}
+
+static SoftSimdFuncs &
+get_funcs ()
+{
+    static SoftSimdFuncs funcs = select_funcs (SoftSimdAuto);
+    return funcs;
+}
+
+SoftSimdType
+soft_simd_get_type ()
+{
+    return get_funcs ().type;
+}
+
+SoftSimdType
+soft_simd_set_type (SoftSimdType type)
+{
+    SoftSimdFuncs &funcs = get_funcs ();
+    funcs = select_funcs (type);
+    XCAM_LOG_DEBUG ("soft simd type selected:%d, required:%d", funcs.type, type);
+    return funcs.type;
+}
+
+// make sure the neighbors read by each kernel are inside the image without border check
+static inline bool
+check_inside (const Float2 *pos, uint32_t count, float max_x, float max_y)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!(pos[i].x >= 0.0f && pos[i].x < max_x && pos[i].y >= 0.0f && pos[i].y < max_y))
+            return false;
+    }
+    return true;
+}
+
+bool
+soft_simd_interpolate_uchar_8 (
+    const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height,
+    const Float2 *pos, float *out)
+{
+    InterpUcharFunc func = get_funcs ().uchar_8;
+    // 32-bit gather reads 4 bytes from x0
+    if (!func || width < 4 || height < 2 || !check_inside (pos, 8, width - 3, height - 1))
+        return false;
+
+    func (buf, pitch, pos, out);
+    return true;
+}
+
+bool
+soft_simd_interpolate_uchar2_4 (
+    const uint8_t *buf, uint32_t pitch, uint32_t width, uint32_t height,
+    const Float2 *pos, Float2 *out)
+{
+    InterpUchar2Func func = get_funcs ().uchar2_4;
+    if (!func || width < 2 || height < 2 || !check_inside (pos, 4, width - 1, height - 1))
+        return false;
+
+    func (buf, pitch, pos, out);
+    return true;
+}
+
+void
+soft_simd_gauss_rows (const uint8_t *const *rows, uint32_t len, int16_t *out)
+{
+    GaussRowsFunc func = get_funcs ().gauss_rows;
+    uint32_t i = func ? func (rows, len, out) : 0;
+
+    for (; i < len; ++i) {
+        int32_t sum = 0;
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k)
+            sum += gauss_weights[k] * rows[k][i];
+        out[i] = (int16_t)((sum + 1) >> 1);
+    }
+}
+
+void
+soft_simd_gauss_decimate_uchar (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    GaussDecimateFunc func = get_funcs ().gauss_uchar;
+    uint32_t j = func ? func (in, out_len, out) : 0;
+
+    for (; j < out_len; ++j) {
+        int32_t sum = 0;
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k)
+            sum += gauss_weights[k] * in[2 * j + k];
+        out[j] = (uint8_t)((sum + (1 << 14)) >> 15);
+    }
+}
+
+void
+soft_simd_gauss_decimate_uchar2 (const int16_t *in, uint32_t out_len, uint8_t *out)
+{
+    GaussDecimateFunc func = get_funcs ().gauss_uchar2;
+    uint32_t j = func ? func (in, out_len, out) : 0;
+
+    for (; j < out_len; ++j) {
+        int32_t sum_u = 0, sum_v = 0;
+        for (uint32_t k = 0; k < SOFT_GAUSS_TAPS; ++k) {
+            sum_u += gauss_weights[k] * in[2 * (2 * j + k)];
+            sum_v += gauss_weights[k] * in[2 * (2 * j + k) + 1];
+        }
+        out[2 * j] = (uint8_t)((sum_u + (1 << 14)) >> 15);
+        out[2 * j + 1] = (uint8_t)((sum_v + (1 << 14)) >> 15);
+    }
+}
+
+void
+soft_simd_half_uchar (const uint8_t *row0, const uint8_t *row1, uint32_t out_len, uint8_t *out)
+{
+    HalfUcharFunc func = get_funcs ().half_uchar;
+    uint32_t j = func ? func (row0, row1, out_len, out) : 0;
+
+    for (; j < out_len; ++j) {
+        uint32_t sum = row0[2 * j] + row0[2 * j + 1] + row1[2 * j] + row1[2 * j + 1];
+        out[j] = (uint8_t)((sum + 2) >> 2);
+    }
+}
+
+void
+soft_simd_tnr_blend (
+    const uint8_t *cur, const uint8_t *const *refs, uint32_t ref_count, uint32_t len,
+    uint8_t threshold, uint8_t strength, uint8_t *out)
+{
+    XCAM_ASSERT (ref_count <= SOFT_TNR_MAX_REFS);
+    ref_count = XCAM_MIN (ref_count, SOFT_TNR_MAX_REFS);
+    strength = XCAM_MIN (strength, SOFT_TNR_MAX_STRENGTH);
+    if (!ref_count || !threshold || !strength) {
+        if (out != cur)
+            memmove (out, cur, len);
+        return;
+    }
+
+    // alpha of each ref reaches its limit once difference is below half threshold
+    int16_t gains[SOFT_TNR_MAX_REFS], strengths[SOFT_TNR_MAX_REFS];
+    for (uint32_t k = 0; k < ref_count; ++k) {
+        strengths[k] = strength / (ref_count - k);
+        gains[k] = (int16_t) XCAM_CLAMP ((2 * strengths[k] + threshold - 1) / threshold, 1, SOFT_TNR_MAX_STRENGTH);
+    }
+
+    TnrBlendFunc func = get_funcs ().tnr_blend;
+    uint32_t i = func ? func (cur, refs, ref_count, len, threshold, gains, strengths, out) : 0;
+
+    for (; i < len; ++i) {
+        int32_t c = cur[i];
+        int32_t acc = c;
+        for (uint32_t k = 0; k < ref_count; ++k) {
+            int32_t r = refs[k][i];
+            int32_t t = XCAM_MAX ((int32_t)threshold - abs (r - c), 0);
+            int32_t alpha = XCAM_MIN (t * gains[k], (int32_t)strengths[k]);
+            acc += ((r - acc) * alpha + 64) >> 7;
+        }
+        out[i] = (uint8_t)acc;
+    }
+}
+
+void
+soft_simd_lerp_rows (const uint8_t *row0, const uint8_t *row1, uint32_t len, uint32_t weight, uint16_t *out)
+{
+    XCAM_ASSERT (weight <= (1 << SOFT_SCALE_WEIGHT_BITS));
+    LerpRowsFunc func = get_funcs ().lerp_rows;
+    uint32_t i = func ? func (row0, row1, len, weight, out) : 0;
+
+    uint32_t w0 = (1 << SOFT_SCALE_WEIGHT_BITS) - weight;
+    for (; i < len; ++i)
+        out[i] = (uint16_t)(row0[i] * w0 + row1[i] * weight);
+}
+
+void
+soft_simd_sum_rows (const uint8_t *const *rows, uint32_t count, uint32_t len, uint16_t *out)
+{
+    XCAM_ASSERT (count && count <= 257);
+    SumRowsFunc func = get_funcs ().sum_rows;
+    uint32_t i = func ? func (rows, count, len, out) : 0;
+
+    for (; i < len; ++i) {
+        uint32_t sum = 0;
+        for (uint32_t k = 0; k < count; ++k)
+            sum += rows[k][i];
+        out[i] = (uint16_t)sum;
+    }
+}
+
+void
+soft_simd_nv12_to_yuyv (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    XCAM_ASSERT (!(width % 2));
+    Nv12RowFunc func = get_funcs ().nv12_to_yuyv;
+    uint32_t i = func ? func (y, uv, width, out) : 0;
+
+    for (; i < width; i += 2) {
+        out[2 * i] = y[i];
+        out[2 * i + 1] = uv[i];
+        out[2 * i + 2] = y[i + 1];
+        out[2 * i + 3] = uv[i + 1];
+    }
+}
+
+static inline uint8_t
+csc_clamp (int32_t v)
+{
+    return (uint8_t) XCAM_CLAMP (v, 0, 255);
+}
+
+void
+soft_simd_nv12_to_rgba (const uint8_t *y, const uint8_t *uv, uint32_t width, uint8_t *out)
+{
+    XCAM_ASSERT (!(width % 2));
+    Nv12RowFunc func = get_funcs ().nv12_to_rgba;
+    uint32_t i = func ? func (y, uv, width, out) : 0;
+
+    const int32_t round = 1 << (CSC_SHIFT - 1);
+    for (; i < width; i += 2) {
+        int32_t du = uv[i] - 128, dv = uv[i + 1] - 128;
+        int32_t dr = (CSC_RV * dv + round) >> CSC_SHIFT;
+        int32_t dg = -((CSC_GU * du + CSC_GV * dv + round) >> CSC_SHIFT);
+        int32_t db = (CSC_BU * du + round) >> CSC_SHIFT;
+        for (uint32_t k = 0; k < 2; ++k) {
+            uint8_t *pixel = out + 4 * (i + k);
+            pixel[0] = csc_clamp (y[i + k] + dr);
+            pixel[1] = csc_clamp (y[i + k] + dg);
+            pixel[2] = csc_clamp (y[i + k] + db);
+            pixel[3] = 0xFF;
+        }
+    }
+}
+
+void
+soft_simd_split_uv (const uint8_t *uv, uint32_t uv_width, uint8_t *u, uint8_t *v)
+{
+    SplitUvFunc func = get_funcs ().split_uv;
+    uint32_t i = func ? func (uv, uv_width, u, v) : 0;
+
+    for (; i < uv_width; ++i) {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+
+// bilinear up-sample of element @i, sum of 4 gauss weights gives SOFT_LAP_FRAC_BITS fraction bits
+static inline int32_t
+lap_up_sample (const uint8_t *g0, const uint8_t *g1, uint32_t i, uint32_t g_width, uint32_t channels)
+{
+    uint32_t x = i / channels, c = i % channels;
+    uint32_t cur = x / 2 * channels + c;
+    int32_t v = g0[cur] + g1[cur];
+    if (!(x % 2))
+        return v * 2;
+
+    uint32_t next = XCAM_MIN (x / 2 + 1, g_width - 1) * channels + c;
+    return v + g0[next] + g1[next];
+}
+
+void
+soft_simd_laplace_row (
+    const uint8_t *orig, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, int16_t *out)
+{
+    XCAM_ASSERT (channels == 1 || channels == 2);
+    uint32_t len = width * channels;
+    LaplaceRowFunc func = get_funcs ().laplace_row;
+    uint32_t i = func ? func (orig, g0, g1, len, g_width * channels, channels, out) : 0;
+
+    for (; i < len; ++i)
+        out[i] = (int16_t)((orig[i] << SOFT_LAP_FRAC_BITS) - lap_up_sample (g0, g1, i, g_width, channels));
+}
+
+void
+soft_simd_reconstruct_row (
+    const int16_t *lap0, const int16_t *lap1, const uint8_t *mask, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, uint8_t *out)
+{
+    XCAM_ASSERT (channels == 1 || channels == 2);
+    uint32_t len = width * channels;
+    ReconstructRowFunc func = get_funcs ().reconstruct_row;
+    uint32_t i = func ? func (lap0, lap1, mask, g0, g1, len, g_width * channels, channels, out) : 0;
+
+    const int32_t shift = SOFT_LAP_FRAC_BITS + 8;
+    for (; i < len; ++i) {
+        int32_t m = mask[i] + (mask[i] >> 7);
+        int32_t v = lap_up_sample (g0, g1, i, g_width, channels) * 256 + lap0[i] * m + lap1[i] * (256 - m);
+        out[i] = (uint8_t) XCAM_CLAMP ((v + (1 << (shift - 1))) >> shift, 0, 255);
+    }
+}
+
+void
+soft_simd_blend_row (const uint8_t *in0, const uint8_t *in1, const uint8_t *mask, uint32_t len, uint8_t *out)
+{
+    BlendRowFunc func = get_funcs ().blend_row;
+    uint32_t i = func ? func (in0, in1, mask, len, out) : 0;
+
+    for (; i < len; ++i) {
+        uint32_t m = mask[i] + (mask[i] >> 7);
+        out[i] = (uint8_t)((in0[i] * m + in1[i] * (256 - m) + 128) >> 8);
+    }
+}
+
+
+void
+soft_simd_fuse_row (
+    const uint8_t *const *ins, const int16_t *const *weights, uint32_t count, uint32_t len, uint8_t *out)
+{
+    XCAM_ASSERT (count <= SOFT_FUSE_MAX_INPUTS);
+    FuseRowFunc func = get_funcs ().fuse_row;
+    uint32_t i = func ? func (ins, weights, count, len, out) : 0;
+
+    for (; i < len; ++i) {
+        int32_t sum = 128;
+        for (uint32_t k = 0; k < count; ++k)
+            sum += ins[k][i] * weights[k][i];
+        out[i] = (uint8_t) XCAM_CLAMP (sum >> 8, 0, 255);
+    }
+}
+
+void
+soft_simd_fuse_reconstruct_row (
+    const int16_t *const *laps, const int16_t *const *weights, uint32_t count, const uint8_t *g0, const uint8_t *g1,
+    uint32_t width, uint32_t g_width, uint32_t channels, uint8_t *out)
+{
+    XCAM_ASSERT (channels == 1 || channels == 2);
+    XCAM_ASSERT (count <= SOFT_FUSE_MAX_INPUTS);
+    uint32_t len = width * channels;
+    FuseReconstructRowFunc func = get_funcs ().fuse_reconstruct_row;
+    uint32_t i = func ? func (laps, weights, count, g0, g1, len, g_width * channels, channels, out) : 0;
+
+    const int32_t shift = SOFT_LAP_FRAC_BITS + 8;
+    for (; i < len; ++i) {
+        int32_t v = lap_up_sample (g0, g1, i, g_width, channels) * 256 + (1 << (shift - 1));
+        for (uint32_t k = 0; k < count; ++k)
+            v += laps[k][i] * weights[k][i];
+        out[i] = (uint8_t) XCAM_CLAMP (v >> shift, 0, 255);
+    }
+}
+
+void
+soft_simd_stream_copy (const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+    StreamCopyFunc func = get_funcs ().stream_copy;
+    uint32_t i = func ? func (src, len, dst) : 0;
+
+    memcpy (dst + i, src + i, len - i);
+}
+
+}
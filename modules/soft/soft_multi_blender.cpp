@@ -0,0 +1,639 @@
+/*
+ * soft_multi_blender.cpp - soft N-way multi-band blender implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_multi_blender.h"
+#include "soft_blender_tasks_priv.h"
+#include "soft_worker.h"
+#include "soft_video_buf_allocator.h"
+
+// one frame in flight and one being started
+#define MULTI_BLENDER_POOL_FRAMES 2
+
+namespace XCam {
+
+using namespace XCamSoftTasks;
+
+DECLARE_WORK_CALLBACK (CbMultiGaussTask, SoftMultiBlender, gauss_done);
+DECLARE_WORK_CALLBACK (CbMultiLapTask, SoftMultiBlender, lap_done);
+DECLARE_WORK_CALLBACK (CbMultiBlendTask, SoftMultiBlender, blend_done);
+DECLARE_WORK_CALLBACK (CbMultiReconstructTask, SoftMultiBlender, reconstruct_done);
+
+static void
+set_work_size (const SmartPtr<SoftWorker> &worker, uint32_t width, uint32_t height, uint32_t inputs)
+{
+    uint32_t thread_x = 2, thread_y = 2;
+    WorkSize work_unit = worker->get_work_uint ();
+    WorkSize global_size (
+        xcam_ceil (width, work_unit.value[0]) / work_unit.value[0],
+        xcam_ceil (height, work_unit.value[1]) / work_unit.value[1],
+        inputs);
+    WorkSize local_size (
+        xcam_ceil (global_size.value[0], thread_x) / thread_x,
+        xcam_ceil (global_size.value[1], thread_y) / thread_y,
+        1);
+
+    worker->set_local_size (local_size);
+    worker->set_global_size (global_size);
+}
+
+static SmartPtr<ShortImage>
+new_uv_weights (const SmartPtr<ShortImage> &luma)
+{
+    uint32_t width = luma->get_width (), height = luma->get_height () / 2;
+    SmartPtr<ShortImage> uv = new ShortImage (width, height);
+    XCAM_ASSERT (uv.ptr ());
+
+    // u and v of one pixel take the weight of its top-left luma
+    for (uint32_t y = 0; y < height; ++y) {
+        const int16_t *in = luma->get_buf_ptr (0, y * 2);
+        int16_t *out = uv->get_buf_ptr (0, y);
+        for (uint32_t x = 0; x < width; x += 2)
+            out[x] = out[x + 1] = in[x];
+    }
+    return uv;
+}
+
+SoftMultiBlender::SoftMultiBlender (const char *name)
+    : SoftHandler (name)
+    , _input_count (2)
+    , _pyr_levels (XCAM_SOFT_PYRAMID_DEFAULT_LEVEL)
+{
+}
+
+SoftMultiBlender::~SoftMultiBlender ()
+{
+}
+
+bool
+SoftMultiBlender::set_input_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_blend_task.ptr (), false,
+        "SoftMultiBlender(%s) set input count failed, blender was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, count >= 2 && count <= XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS, false,
+        "SoftMultiBlender(%s) input count(%d) need be in [2, %d]",
+        XCAM_STR (get_name ()), count, XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS);
+
+    _input_count = count;
+    return true;
+}
+
+bool
+SoftMultiBlender::set_pyr_levels (uint32_t levels)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_blend_task.ptr (), false,
+        "SoftMultiBlender(%s) set pyramid levels failed, blender was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, levels >= 1 && levels <= XCAM_SOFT_PYRAMID_MAX_LEVEL, false,
+        "SoftMultiBlender(%s) pyramid levels(%d) need be in [1, %d]",
+        XCAM_STR (get_name ()), levels, XCAM_SOFT_PYRAMID_MAX_LEVEL);
+
+    _pyr_levels = levels;
+    return true;
+}
+
+bool
+SoftMultiBlender::set_weights (const std::vector<SmartPtr<UcharImage> > &weights)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_blend_task.ptr (), false,
+        "SoftMultiBlender(%s) set weights failed, blender was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, weights.size () <= XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS, false,
+        "SoftMultiBlender(%s) got %d weights, no more than %d",
+        XCAM_STR (get_name ()), (uint32_t)weights.size (), XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS);
+
+    _weights = weights;
+    return true;
+}
+
+XCamReturn
+SoftMultiBlender::blend (const std::vector<SmartPtr<VideoBuffer> > &ins, SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<MultiBlendParam> param = new MultiBlendParam (ins, out_buf);
+    XCAM_FAIL_RETURN (
+        ERROR, param->in_buf.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiBlender(%s) blend failed, no input", XCAM_STR (get_name ()));
+
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ())
+        out_buf = param->out_buf;
+
+    return ret;
+}
+
+XCamReturn
+SoftMultiBlender::init_weights (uint32_t width, uint32_t height)
+{
+    std::vector<SmartPtr<UcharImage> > raw (_input_count);
+    for (uint32_t i = 0; i < _input_count; ++i) {
+        if (i < _weights.size () && _weights[i].ptr ()) {
+            XCAM_FAIL_RETURN (
+                ERROR, _weights[i]->get_width () == width && _weights[i]->get_height () == height,
+                XCAM_RETURN_ERROR_PARAM,
+                "SoftMultiBlender(%s) weight%d size(%dx%d) differs from input size(%dx%d)",
+                XCAM_STR (get_name ()), i, _weights[i]->get_width (), _weights[i]->get_height (), width, height);
+            raw[i] = _weights[i];
+            continue;
+        }
+        raw[i] = new UcharImage (width, height);
+        XCAM_ASSERT (raw[i].ptr ());
+        for (uint32_t y = 0; y < height; ++y)
+            memset (raw[i]->get_buf_ptr (0, y), 0xFF, width);
+    }
+
+    for (uint32_t level = 0; level <= _pyr_levels; ++level) {
+        uint32_t level_width = _level_info[level].width, level_height = _level_info[level].height;
+
+        if (level > 0) {
+            for (uint32_t i = 0; i < _input_count; ++i) {
+                SmartPtr<GaussScaleGray::Args> args = new GaussScaleGray::Args;
+                args->in_luma = raw[i];
+                args->out_luma = new UcharImage (level_width, level_height);
+                XCAM_ASSERT (args->out_luma.ptr ());
+
+                SmartPtr<GaussScaleGray> worker = new GaussScaleGray;
+                WorkSize size ((level_width + 1) / 2, (level_height + 1) / 2);
+                worker->set_local_size (size);
+                worker->set_global_size (size);
+                XCamReturn ret = worker->work (args);
+                XCAM_FAIL_RETURN (
+                    ERROR, xcam_ret_is_ok (ret), ret,
+                    "SoftMultiBlender(%s) scale weight%d failed, level:%d", XCAM_STR (get_name ()), i, level);
+                raw[i] = args->out_luma;
+            }
+        }
+
+        // fixed point weights of all inputs sum to 256, remainder goes to the largest one
+        std::vector<SmartPtr<ShortImage> > luma (_input_count);
+        for (uint32_t i = 0; i < _input_count; ++i) {
+            luma[i] = new ShortImage (level_width, level_height);
+            XCAM_ASSERT (luma[i].ptr ());
+        }
+        for (uint32_t y = 0; y < level_height; ++y) {
+            for (uint32_t x = 0; x < level_width; ++x) {
+                uint32_t sum = 0, largest = 0;
+                for (uint32_t i = 0; i < _input_count; ++i) {
+                    uint32_t value = *raw[i]->get_buf_ptr (x, y);
+                    sum += value;
+                    if (value > *raw[largest]->get_buf_ptr (x, y))
+                        largest = i;
+                }
+
+                uint32_t given = 0;
+                for (uint32_t i = 0; i < _input_count; ++i) {
+                    uint32_t weight = sum ? *raw[i]->get_buf_ptr (x, y) * 256 / sum : 256 / _input_count;
+                    *luma[i]->get_buf_ptr (x, y) = (int16_t)weight;
+                    given += weight;
+                }
+                *luma[largest]->get_buf_ptr (x, y) += (int16_t)(256 - given);
+            }
+        }
+
+        _luma_weights[level] = luma;
+        _uv_weights[level].resize (_input_count);
+        for (uint32_t i = 0; i < _input_count; ++i)
+            _uv_weights[level][i] = new_uv_weights (luma[i]);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftMultiBlender::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiBlender(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+    XCAM_FAIL_RETURN (
+        ERROR,
+        in_info.width % SOFT_BLENDER_ALIGNMENT_X == 0 && in_info.height % SOFT_BLENDER_ALIGNMENT_Y == 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiBlender(%s) input size(%dx%d) need be multiple of %dx%d",
+        XCAM_STR (get_name ()), in_info.width, in_info.height,
+        SOFT_BLENDER_ALIGNMENT_X, SOFT_BLENDER_ALIGNMENT_Y);
+
+    VideoBufferInfo out_info;
+    out_info.init (V4L2_PIX_FMT_NV12, in_info.width, in_info.height);
+    set_out_video_info (out_info);
+
+    uint32_t width = in_info.width, height = in_info.height;
+    _level_info[0] = out_info;
+    for (uint32_t i = 0; i < _pyr_levels; ++i) {
+        VideoBufferInfo lap_info;
+        lap_info.init (V4L2_PIX_FMT_P010, width, height);
+        width = XCAM_ALIGN_UP ((width + 1) / 2, SOFT_BLENDER_ALIGNMENT_X);
+        height = XCAM_ALIGN_UP ((height + 1) / 2, SOFT_BLENDER_ALIGNMENT_Y);
+        _level_info[i + 1].init (V4L2_PIX_FMT_NV12, width, height);
+
+        SmartPtr<BufferPool> gauss_pool = new SoftVideoBufAllocator (_level_info[i + 1]);
+        SmartPtr<BufferPool> lap_pool = new SoftVideoBufAllocator (lap_info);
+        SmartPtr<BufferPool> fuse_pool = new SoftVideoBufAllocator (_level_info[i + 1]);
+        XCAM_ASSERT (gauss_pool.ptr () && lap_pool.ptr () && fuse_pool.ptr ());
+        XCAM_FAIL_RETURN (
+            ERROR,
+            xcam_ret_is_ok (gauss_pool->reserve (_input_count * MULTI_BLENDER_POOL_FRAMES)) &&
+            xcam_ret_is_ok (lap_pool->reserve (_input_count * MULTI_BLENDER_POOL_FRAMES)) &&
+            xcam_ret_is_ok (fuse_pool->reserve (MULTI_BLENDER_POOL_FRAMES)),
+            XCAM_RETURN_ERROR_MEM,
+            "SoftMultiBlender(%s) reserve buffers of level:%d(%dx%d) failed",
+            XCAM_STR (get_name ()), i, lap_info.width, lap_info.height);
+        _gauss_pools[i] = gauss_pool;
+        _lap_pools[i] = lap_pool;
+        _fuse_pools[i] = fuse_pool;
+    }
+
+    XCamReturn ret = init_weights (in_info.width, in_info.height);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftMultiBlender(%s) init weights failed", XCAM_STR (get_name ()));
+
+    SmartPtr<Worker::Callback> gauss_cb = new CbMultiGaussTask (this);
+    SmartPtr<Worker::Callback> lap_cb = new CbMultiLapTask (this);
+    SmartPtr<Worker::Callback> recon_cb = new CbMultiReconstructTask (this);
+    XCAM_ASSERT (gauss_cb.ptr () && lap_cb.ptr () && recon_cb.ptr ());
+    for (uint32_t i = 0; i < _pyr_levels; ++i) {
+        _gauss_tasks[i] = new MultiGaussTask (gauss_cb);
+        _lap_tasks[i] = new MultiLaplaceTask (lap_cb);
+        _recon_tasks[i] = new MultiReconstructTask (recon_cb);
+        XCAM_ASSERT (_gauss_tasks[i].ptr () && _lap_tasks[i].ptr () && _recon_tasks[i].ptr ());
+    }
+    _blend_task = new MultiBlendTask (new CbMultiBlendTask (this));
+    XCAM_ASSERT (_blend_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftMultiBlender::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_blend_task.ptr ());
+    XCAM_ASSERT (param.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<MultiBlendParam> blend_param = param.dynamic_cast_ptr<MultiBlendParam> ();
+    XCAM_FAIL_RETURN (
+        ERROR, blend_param.ptr () && blend_param->ins.size () == _input_count, XCAM_RETURN_ERROR_PARAM,
+        "SoftMultiBlender(%s) needs be executed with MultiBlendParam of %d inputs",
+        XCAM_STR (get_name ()), _input_count);
+
+    for (uint32_t i = 0; i < _input_count; ++i) {
+        const SmartPtr<VideoBuffer> &in = blend_param->ins[i];
+        XCAM_FAIL_RETURN (
+            ERROR, in.ptr (), XCAM_RETURN_ERROR_PARAM,
+            "SoftMultiBlender(%s) input%d is empty", XCAM_STR (get_name ()), i);
+        const VideoBufferInfo &info = in->get_video_info ();
+        XCAM_FAIL_RETURN (
+            ERROR,
+            info.format == V4L2_PIX_FMT_NV12 &&
+            info.width == _level_info[0].width && info.height == _level_info[0].height,
+            XCAM_RETURN_ERROR_PARAM,
+            "SoftMultiBlender(%s) input%d(%s %dx%d) differs from input0(NV12 %dx%d)",
+            XCAM_STR (get_name ()), i, xcam_fourcc_to_string (info.format),
+            info.width, info.height, _level_info[0].width, _level_info[0].height);
+    }
+
+    SmartPtr<Frame> frame = new Frame;
+    XCAM_ASSERT (frame.ptr ());
+    {
+        SmartLock locker (_frames_mutex);
+        _frames[param.ptr ()] = frame;
+    }
+
+    XCamReturn ret = start_gauss (param, frame, 0);
+    if (!xcam_ret_is_ok (ret))
+        frame_ended (param);
+
+    return ret;
+}
+
+XCamReturn
+SoftMultiBlender::start_gauss (
+    const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame, uint32_t level)
+{
+    XCAM_ASSERT (level < _pyr_levels);
+    SmartPtr<MultiBlendParam> blend_param = param.static_cast_ptr<MultiBlendParam> ();
+
+    SmartPtr<MultiGaussTask::Args> args = new MultiGaussTask::Args (param, level);
+    XCAM_ASSERT (args.ptr ());
+
+    std::vector<SmartPtr<VideoBuffer> > &outs = frame->gauss[level];
+    outs.resize (_input_count);
+    for (uint32_t i = 0; i < _input_count; ++i) {
+        const SmartPtr<VideoBuffer> &in = level ? frame->gauss[level - 1][i] : blend_param->ins[i];
+        outs[i] = _gauss_pools[level]->get_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, outs[i].ptr (), XCAM_RETURN_ERROR_MEM,
+            "SoftMultiBlender(%s) gauss buffer of input%d failed in allocation, level:%d",
+            XCAM_STR (get_name ()), i, level);
+
+        args->in_luma.push_back (new UcharImage (in, 0));
+        args->in_uv.push_back (new Uchar2Image (in, 1));
+        args->out_luma.push_back (new UcharImage (outs[i], 0));
+        args->out_uv.push_back (new Uchar2Image (outs[i], 1));
+    }
+
+    const VideoBufferInfo &info = _level_info[level + 1];
+    set_work_size (_gauss_tasks[level], info.width, info.height, _input_count);
+    return _gauss_tasks[level]->work (args);
+}
+
+XCamReturn
+SoftMultiBlender::start_laps (const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame)
+{
+    SmartPtr<MultiBlendParam> blend_param = param.static_cast_ptr<MultiBlendParam> ();
+    uint32_t top = _pyr_levels - 1;
+
+    SmartPtr<MultiBlendTask::Args> blend_args = new MultiBlendTask::Args (param);
+    XCAM_ASSERT (blend_args.ptr ());
+    blend_args->out_buf = _fuse_pools[top]->get_buffer ();
+    XCAM_FAIL_RETURN (
+        ERROR, blend_args->out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "SoftMultiBlender(%s) top level buffer failed in allocation", XCAM_STR (get_name ()));
+    for (uint32_t i = 0; i < _input_count; ++i) {
+        blend_args->in_luma.push_back (new UcharImage (frame->gauss[top][i], 0));
+        blend_args->in_uv.push_back (new Uchar2Image (frame->gauss[top][i], 1));
+    }
+    blend_args->luma_weights = _luma_weights[_pyr_levels];
+    blend_args->uv_weights = _uv_weights[_pyr_levels];
+    blend_args->out_luma = new UcharImage (blend_args->out_buf, 0);
+    blend_args->out_uv = new Uchar2Image (blend_args->out_buf, 1);
+
+    std::vector<SmartPtr<MultiLaplaceTask::Args> > lap_args (_pyr_levels);
+    for (uint32_t level = 0; level < _pyr_levels; ++level) {
+        SmartPtr<MultiLaplaceTask::Args> &args = lap_args[level];
+        args = new MultiLaplaceTask::Args (param, level);
+        XCAM_ASSERT (args.ptr ());
+
+        std::vector<SmartPtr<VideoBuffer> > &laps = frame->laps[level];
+        laps.resize (_input_count);
+        for (uint32_t i = 0; i < _input_count; ++i) {
+            const SmartPtr<VideoBuffer> &orig = level ? frame->gauss[level - 1][i] : blend_param->ins[i];
+            const SmartPtr<VideoBuffer> &gauss = frame->gauss[level][i];
+            laps[i] = _lap_pools[level]->get_buffer ();
+            XCAM_FAIL_RETURN (
+                ERROR, laps[i].ptr (), XCAM_RETURN_ERROR_MEM,
+                "SoftMultiBlender(%s) laplace buffer of input%d failed in allocation, level:%d",
+                XCAM_STR (get_name ()), i, level);
+
+            args->orig_luma.push_back (new UcharImage (orig, 0));
+            args->orig_uv.push_back (new Uchar2Image (orig, 1));
+            args->gauss_luma.push_back (new UcharImage (gauss, 0));
+            args->gauss_uv.push_back (new Uchar2Image (gauss, 1));
+            args->out_luma.push_back (new ShortImage (laps[i], 0));
+            args->out_uv.push_back (new Short2Image (laps[i], 1));
+        }
+    }
+
+    // laplace levels and top level fusion of all inputs run at the same time
+    {
+        SmartLock locker (_frames_mutex);
+        frame->pending = _pyr_levels + 1;
+    }
+
+    for (uint32_t level = 0; level < _pyr_levels; ++level) {
+        const VideoBufferInfo &info = _level_info[level];
+        set_work_size (_lap_tasks[level], info.width, info.height, _input_count);
+        XCamReturn ret = _lap_tasks[level]->work (lap_args[level]);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "SoftMultiBlender(%s) start laplace task failed, level:%d", XCAM_STR (get_name ()), level);
+    }
+
+    const VideoBufferInfo &top_info = _level_info[_pyr_levels];
+    set_work_size (_blend_task, top_info.width, top_info.height, 1);
+    return _blend_task->work (blend_args);
+}
+
+XCamReturn
+SoftMultiBlender::start_reconstruct (
+    const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame, uint32_t level)
+{
+    XCAM_ASSERT (level < _pyr_levels);
+    XCAM_ASSERT (frame->fused.ptr ());
+
+    // gauss levels are no longer needed once all laplace levels are done
+    if (level == _pyr_levels - 1) {
+        for (uint32_t i = 0; i < _pyr_levels; ++i)
+            frame->gauss[i].clear ();
+    }
+
+    SmartPtr<MultiReconstructTask::Args> args = new MultiReconstructTask::Args (param, level);
+    XCAM_ASSERT (args.ptr ());
+    args->out_buf = level ? _fuse_pools[level - 1]->get_buffer () : param->out_buf;
+    XCAM_FAIL_RETURN (
+        ERROR, args->out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+        "SoftMultiBlender(%s) reconstruct buffer failed in allocation, level:%d",
+        XCAM_STR (get_name ()), level);
+
+    args->gauss_luma = new UcharImage (frame->fused, 0);
+    args->gauss_uv = new Uchar2Image (frame->fused, 1);
+    args->out_luma = new UcharImage (args->out_buf, 0);
+    args->out_uv = new Uchar2Image (args->out_buf, 1);
+    for (uint32_t i = 0; i < _input_count; ++i) {
+        args->lap_luma.push_back (new ShortImage (frame->laps[level][i], 0));
+        args->lap_uv.push_back (new Short2Image (frame->laps[level][i], 1));
+    }
+    args->luma_weights = _luma_weights[level];
+    args->uv_weights = _uv_weights[level];
+    frame->laps[level].clear ();
+    frame->fused.release ();
+
+    const VideoBufferInfo &info = _level_info[level];
+    set_work_size (_recon_tasks[level], info.width, info.height, 1);
+    return _recon_tasks[level]->work (args);
+}
+
+SmartPtr<SoftMultiBlender::Frame>
+SoftMultiBlender::get_frame (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    SmartLock locker (_frames_mutex);
+    MapFrames::iterator i = _frames.find (param.ptr ());
+    if (i == _frames.end ())
+        return NULL;
+    return (*i).second;
+}
+
+bool
+SoftMultiBlender::stage_done (const SmartPtr<Frame> &frame)
+{
+    SmartLock locker (_frames_mutex);
+    XCAM_ASSERT (frame->pending);
+    return --frame->pending == 0;
+}
+
+void
+SoftMultiBlender::frame_ended (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    SmartLock locker (_frames_mutex);
+    _frames.erase (param.ptr ());
+}
+
+XCamReturn
+SoftMultiBlender::terminate ()
+{
+    for (uint32_t i = 0; i < XCAM_SOFT_PYRAMID_MAX_LEVEL; ++i) {
+        if (_gauss_tasks[i].ptr ())
+            _gauss_tasks[i]->stop ();
+        if (_lap_tasks[i].ptr ())
+            _lap_tasks[i]->stop ();
+        if (_recon_tasks[i].ptr ())
+            _recon_tasks[i]->stop ();
+        if (_gauss_pools[i].ptr ())
+            _gauss_pools[i]->stop ();
+        if (_lap_pools[i].ptr ())
+            _lap_pools[i]->stop ();
+        if (_fuse_pools[i].ptr ())
+            _fuse_pools[i]->stop ();
+    }
+    if (_blend_task.ptr ())
+        _blend_task->stop ();
+
+    {
+        SmartLock locker (_frames_mutex);
+        _frames.clear ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+SoftMultiBlender::gauss_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<MultiGaussTask::Args> args = base.dynamic_cast_ptr<MultiGaussTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    SmartPtr<Frame> frame = get_frame (param);
+    if (!frame.ptr ())
+        return;
+    if (!check_work_continue (param, error)) {
+        frame_ended (param);
+        return;
+    }
+
+    XCamReturn ret = (args->level + 1 < _pyr_levels) ?
+                     start_gauss (param, frame, args->level + 1) : start_laps (param, frame);
+    if (!xcam_ret_is_ok (ret)) {
+        work_broken (param, ret);
+        frame_ended (param);
+    }
+}
+
+void
+SoftMultiBlender::lap_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<MultiLaplaceTask::Args> args = base.dynamic_cast_ptr<MultiLaplaceTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    SmartPtr<Frame> frame = get_frame (param);
+    if (!frame.ptr ())
+        return;
+    if (!check_work_continue (param, error)) {
+        frame_ended (param);
+        return;
+    }
+
+    if (!stage_done (frame))
+        return;
+
+    XCamReturn ret = start_reconstruct (param, frame, _pyr_levels - 1);
+    if (!xcam_ret_is_ok (ret)) {
+        work_broken (param, ret);
+        frame_ended (param);
+    }
+}
+
+void
+SoftMultiBlender::blend_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _blend_task.ptr ());
+
+    SmartPtr<MultiBlendTask::Args> args = base.dynamic_cast_ptr<MultiBlendTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    SmartPtr<Frame> frame = get_frame (param);
+    if (!frame.ptr ())
+        return;
+    if (!check_work_continue (param, error)) {
+        frame_ended (param);
+        return;
+    }
+
+    frame->fused = args->out_buf;
+    if (!stage_done (frame))
+        return;
+
+    XCamReturn ret = start_reconstruct (param, frame, _pyr_levels - 1);
+    if (!xcam_ret_is_ok (ret)) {
+        work_broken (param, ret);
+        frame_ended (param);
+    }
+}
+
+void
+SoftMultiBlender::reconstruct_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+
+    SmartPtr<MultiReconstructTask::Args> args = base.dynamic_cast_ptr<MultiReconstructTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    SmartPtr<Frame> frame = get_frame (param);
+    if (!frame.ptr ())
+        return;
+    if (!check_work_continue (param, error)) {
+        frame_ended (param);
+        return;
+    }
+
+    if (args->level == 0) {
+        frame_ended (param);
+        work_well_done (param, error);
+        return;
+    }
+
+    frame->fused = args->out_buf;
+    XCamReturn ret = start_reconstruct (param, frame, args->level - 1);
+    if (!xcam_ret_is_ok (ret)) {
+        work_broken (param, ret);
+        frame_ended (param);
+    }
+}
+
+SmartPtr<SoftHandler> create_soft_multi_blender ()
+{
+    SmartPtr<SoftHandler> blender = new SoftMultiBlender ();
+    XCAM_ASSERT (blender.ptr ());
+
+    return blender;
+}
+
+}
@@ -0,0 +1,155 @@
+/*
+ * soft_multi_blender.h - soft N-way multi-band blender class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_MULTI_BLENDER_H
+#define XCAM_SOFT_MULTI_BLENDER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <buffer_pool.h>
+#include <soft/soft_handler.h>
+#include <soft/soft_image.h>
+#include <soft/soft_blender.h>
+#include <map>
+#include <vector>
+
+#define XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS SOFT_FUSE_MAX_INPUTS
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class MultiGaussTask;
+class MultiLaplaceTask;
+class MultiBlendTask;
+class MultiReconstructTask;
+};
+
+/*
+ * SoftMultiBlender, multi-band fusion of 2 to XCAM_SOFT_MULTI_BLENDER_MAX_INPUTS NV12 images
+ * of one size into an output of the same size, e.g. a region seen by more than two cameras.
+ * pyramid of each input is built once, laplace levels of all inputs are summed with
+ * normalized weight pyramids and reconstructed in one pass per level.
+ * weights are per pixel of each input, inputs are averaged where all weights are 0.
+ * width need be multiple of 8 and height multiple of 4.
+ */
+class SoftMultiBlender
+    : public SoftHandler
+{
+public:
+    struct MultiBlendParam : ImageHandler::Parameters {
+        // in_buf is the first one of ins
+        std::vector<SmartPtr<VideoBuffer> >  ins;
+
+        explicit MultiBlendParam (const std::vector<SmartPtr<VideoBuffer> > &in_bufs, const SmartPtr<VideoBuffer> &out = NULL)
+            : Parameters (in_bufs.empty () ? NULL : in_bufs[0], out)
+            , ins (in_bufs)
+        {}
+    };
+
+public:
+    explicit SoftMultiBlender (const char *name = "SoftMultiBlender");
+    ~SoftMultiBlender ();
+
+    // all setters need be called before configure
+    bool set_input_count (uint32_t count);
+    uint32_t get_input_count () const {
+        return _input_count;
+    }
+    bool set_pyr_levels (uint32_t levels);
+    uint32_t get_pyr_levels () const {
+        return _pyr_levels;
+    }
+    // one weight image of output size for each input, an empty one is 255 everywhere
+    bool set_weights (const std::vector<SmartPtr<UcharImage> > &weights);
+
+    XCamReturn blend (const std::vector<SmartPtr<VideoBuffer> > &ins, SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void gauss_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+    void lap_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+    void blend_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+    void reconstruct_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    // pyramid buffers of one frame in flight
+    struct Frame {
+        // gauss[l] is level l + 1 of each input, laps[l] is level l
+        std::vector<SmartPtr<VideoBuffer> >  gauss[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+        std::vector<SmartPtr<VideoBuffer> >  laps[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+        // fused top level, then each reconstructed level
+        SmartPtr<VideoBuffer>                fused;
+        // works left in current stage
+        uint32_t                             pending;
+
+        Frame () : pending (0) {}
+    };
+    typedef std::map<void*, SmartPtr<Frame> > MapFrames;
+
+    XCamReturn init_weights (uint32_t width, uint32_t height);
+    XCamReturn start_gauss (const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame, uint32_t level);
+    XCamReturn start_laps (const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame);
+    XCamReturn start_reconstruct (
+        const SmartPtr<ImageHandler::Parameters> &param, const SmartPtr<Frame> &frame, uint32_t level);
+    SmartPtr<Frame> get_frame (const SmartPtr<ImageHandler::Parameters> &param);
+    // true once all works of current stage are done
+    bool stage_done (const SmartPtr<Frame> &frame);
+    void frame_ended (const SmartPtr<ImageHandler::Parameters> &param);
+
+    XCAM_DEAD_COPY (SoftMultiBlender);
+
+private:
+    uint32_t                                    _input_count;
+    uint32_t                                    _pyr_levels;
+    std::vector<SmartPtr<UcharImage> >          _weights;
+
+    // level 0 is output size, level l + 1 is gauss of level l
+    VideoBufferInfo                             _level_info[XCAM_SOFT_PYRAMID_MAX_LEVEL + 1];
+    std::vector<SmartPtr<ShortImage> >          _luma_weights[XCAM_SOFT_PYRAMID_MAX_LEVEL + 1];
+    std::vector<SmartPtr<ShortImage> >          _uv_weights[XCAM_SOFT_PYRAMID_MAX_LEVEL + 1];
+
+    SmartPtr<BufferPool>                        _gauss_pools[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    SmartPtr<BufferPool>                        _lap_pools[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    // level l + 1 size, for fused top level and reconstructed levels
+    SmartPtr<BufferPool>                        _fuse_pools[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    SmartPtr<XCamSoftTasks::MultiGaussTask>     _gauss_tasks[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    SmartPtr<XCamSoftTasks::MultiLaplaceTask>   _lap_tasks[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+    SmartPtr<XCamSoftTasks::MultiBlendTask>     _blend_task;
+    SmartPtr<XCamSoftTasks::MultiReconstructTask> _recon_tasks[XCAM_SOFT_PYRAMID_MAX_LEVEL];
+
+    Mutex                                       _frames_mutex;
+    MapFrames                                   _frames;
+};
+
+extern SmartPtr<SoftHandler> create_soft_multi_blender ();
+
+}
+
+#endif //XCAM_SOFT_MULTI_BLENDER_H
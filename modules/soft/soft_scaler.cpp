@@ -0,0 +1,483 @@
+/*
+ * soft_scaler.cpp - soft image scaler implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_scaler.h"
+#include "soft_worker.h"
+#include "soft_video_buf_allocator.h"
+
+#define XCAM_SOFT_SCALER_ALIGNMENT_X 16
+#define XCAM_SOFT_SCALER_ALIGNMENT_Y 2
+
+// bilinear result keeps weight bits of both passes
+#define SCALE_BILINEAR_SHIFT (SOFT_SCALE_WEIGHT_BITS * 2)
+#define SCALE_AREA_SHIFT 16
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+class ScaleTask
+    : public SoftWorker
+{
+public:
+    // input position of every output column or row
+    struct Axis {
+        std::vector<uint32_t>    pos;     // bilinear, first neighbour
+        std::vector<uint8_t>     weight;  // bilinear, weight of the second neighbour
+        uint32_t                 factor;  // area, inputs of one output
+
+        Axis () : factor (1) {}
+    };
+
+    // luma and uv planes of one output
+    struct Plan {
+        Axis        luma_x, luma_y;
+        Axis        uv_x, uv_y;
+        uint32_t    area_recip;  // (1 << 16) / pixels of one area
+    };
+
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>         in_luma;
+        SmartPtr<Uchar2Image>        in_uv;
+        SmartPtr<UcharImage>         out_luma[XCAM_SOFT_SCALER_MAX_OUTPUTS];
+        SmartPtr<Uchar2Image>        out_uv[XCAM_SOFT_SCALER_MAX_OUTPUTS];
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+        {}
+    };
+
+public:
+    explicit ScaleTask (const SmartPtr<Worker::Callback> &cb, SoftScaleMode mode)
+        : SoftWorker ("ScaleTask", cb)
+        , _mode (mode)
+    {}
+
+    // called in configure only
+    void set_plans (const std::vector<Plan> &plans) {
+        _plans = plans;
+    }
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+    virtual uint32_t get_input_rows (const SmartPtr<Arguments> &args, const WorkRange &range);
+
+    template <typename ImageT, uint32_t C>
+    void scale_row (
+        const SmartPtr<ImageT> &in, const SmartPtr<ImageT> &out,
+        const Axis &x, const Axis &y, uint32_t area_recip, uint32_t out_y, uint16_t *tmp);
+
+private:
+    SoftScaleMode         _mode;
+    std::vector<Plan>     _plans;
+};
+
+static void
+init_bilinear_axis (ScaleTask::Axis &axis, uint32_t in_size, uint32_t out_size)
+{
+    const int64_t one = 1 << SOFT_SCALE_WEIGHT_BITS;
+    const int64_t max_pos = (int64_t)(in_size - 1) * one;
+
+    axis.pos.resize (out_size);
+    axis.weight.resize (out_size);
+    for (uint32_t i = 0; i < out_size; ++i) {
+        // pixel centers aligned, (i + 0.5) * in / out - 0.5
+        int64_t pos = (2 * i + 1) * (int64_t)in_size * one / (2 * out_size) - one / 2;
+        pos = XCAM_CLAMP (pos, (int64_t)0, max_pos);
+        axis.pos[i] = (uint32_t)(pos >> SOFT_SCALE_WEIGHT_BITS);
+        axis.weight[i] = (uint8_t)(pos & (one - 1));
+    }
+}
+
+template <uint32_t C>
+static inline void
+bilinear_cols (const uint16_t *tmp, const ScaleTask::Axis &x, uint32_t in_width, uint8_t *out)
+{
+    const uint32_t one = 1 << SOFT_SCALE_WEIGHT_BITS;
+    const uint32_t round = 1 << (SCALE_BILINEAR_SHIFT - 1);
+
+    for (uint32_t i = 0; i < x.pos.size (); ++i) {
+        uint32_t x0 = x.pos[i];
+        uint32_t x1 = XCAM_MIN (x0 + 1, in_width - 1);
+        uint32_t w1 = x.weight[i], w0 = one - w1;
+        for (uint32_t c = 0; c < C; ++c)
+            out[i * C + c] = (uint8_t)((tmp[x0 * C + c] * w0 + tmp[x1 * C + c] * w1 + round) >> SCALE_BILINEAR_SHIFT);
+    }
+}
+
+template <uint32_t C>
+static inline void
+area_cols (const uint16_t *tmp, uint32_t factor, uint32_t recip, uint32_t out_width, uint8_t *out)
+{
+    const uint32_t round = 1 << (SCALE_AREA_SHIFT - 1);
+
+    for (uint32_t i = 0; i < out_width; ++i) {
+        const uint16_t *box = tmp + i * factor * C;
+        for (uint32_t c = 0; c < C; ++c) {
+            uint32_t sum = 0;
+            for (uint32_t j = 0; j < factor; ++j)
+                sum += box[j * C + c];
+            out[i * C + c] = (uint8_t)((sum * recip + round) >> SCALE_AREA_SHIFT);
+        }
+    }
+}
+
+template <typename ImageT, uint32_t C>
+void
+ScaleTask::scale_row (
+    const SmartPtr<ImageT> &in, const SmartPtr<ImageT> &out,
+    const Axis &x, const Axis &y, uint32_t area_recip, uint32_t out_y, uint16_t *tmp)
+{
+    uint32_t in_width = in->get_width ();
+    uint32_t len = in_width * C;
+    uint8_t *out_ptr = (uint8_t *)out->get_buf_ptr (0, out_y);
+
+    if (_mode == SoftScaleArea) {
+        const uint8_t *rows[XCAM_SOFT_SCALER_MAX_AREA_FACTOR];
+        for (uint32_t k = 0; k < y.factor; ++k)
+            rows[k] = (const uint8_t *)in->get_buf_ptr (0, out_y * y.factor + k);
+        soft_simd_sum_rows (rows, y.factor, len, tmp);
+        area_cols<C> (tmp, x.factor, area_recip, out->get_width (), out_ptr);
+        return;
+    }
+
+    uint32_t y0 = y.pos[out_y];
+    uint32_t y1 = XCAM_MIN (y0 + 1, in->get_height () - 1);
+    soft_simd_lerp_rows (
+        (const uint8_t *)in->get_buf_ptr (0, y0), (const uint8_t *)in->get_buf_ptr (0, y1),
+        len, y.weight[out_y], tmp);
+    bilinear_cols<C> (tmp, x, in_width, out_ptr);
+}
+
+// input rows of the plane of @y read by output rows [0, @out_y]
+static inline uint32_t
+get_axis_rows (const ScaleTask::Axis &y, SoftScaleMode mode, uint32_t out_y)
+{
+    if (mode == SoftScaleArea)
+        return (out_y + 1) * y.factor;
+    return y.pos[out_y] + 2;
+}
+
+uint32_t
+ScaleTask::get_input_rows (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<ScaleTask::Args> args = base.static_cast_ptr<ScaleTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    uint32_t rows = 0;
+
+    for (uint32_t idx = range.pos[0]; idx < range.pos[0] + range.pos_len[0]; ++idx) {
+        XCAM_ASSERT (idx < _plans.size () && args->out_uv[idx].ptr ());
+        const Plan &plan = _plans[idx];
+        uint32_t end_y = XCAM_MIN (range.pos[1] + range.pos_len[1], args->out_uv[idx]->get_height ());
+        if (!end_y)
+            continue;
+
+        // uv row r of input comes with luma rows 2r and 2r + 1
+        rows = XCAM_MAX (rows, get_axis_rows (plan.luma_y, _mode, end_y * 2 - 1));
+        rows = XCAM_MAX (rows, get_axis_rows (plan.uv_y, _mode, end_y - 1) * 2);
+    }
+    return rows;
+}
+
+XCamReturn
+ScaleTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<ScaleTask::Args> args = base.static_cast_ptr<ScaleTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    XCAM_ASSERT (args->in_luma.ptr () && args->in_uv.ptr ());
+
+    // uv rows take as many bytes as luma rows
+    std::vector<uint16_t> tmp (args->in_luma->get_width ());
+
+    for (uint32_t idx = range.pos[0]; idx < range.pos[0] + range.pos_len[0]; ++idx) {
+        XCAM_ASSERT (idx < _plans.size ());
+        const Plan &plan = _plans[idx];
+        const SmartPtr<UcharImage> &out_luma = args->out_luma[idx];
+        const SmartPtr<Uchar2Image> &out_uv = args->out_uv[idx];
+        XCAM_ASSERT (out_luma.ptr () && out_uv.ptr ());
+
+        // outputs of different sizes share the row range
+        uint32_t end_y = XCAM_MIN (range.pos[1] + range.pos_len[1], out_uv->get_height ());
+        for (uint32_t y = range.pos[1]; y < end_y; ++y) {
+            scale_row<UcharImage, 1> (
+                args->in_luma, out_luma, plan.luma_x, plan.luma_y, plan.area_recip, y * 2, tmp.data ());
+            scale_row<UcharImage, 1> (
+                args->in_luma, out_luma, plan.luma_x, plan.luma_y, plan.area_recip, y * 2 + 1, tmp.data ());
+            scale_row<Uchar2Image, 2> (
+                args->in_uv, out_uv, plan.uv_x, plan.uv_y, plan.area_recip, y, tmp.data ());
+        }
+    }
+
+    XCAM_LOG_DEBUG ("ScaleTask work on range:[x:%d, width:%d, y:%d, height:%d]",
+                    range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+DECLARE_WORK_CALLBACK (CbScaleTask, SoftScaler, scale_task_done);
+
+SoftScaler::SoftScaler (const char *name)
+    : SoftHandler (name)
+    , _mode (SoftScaleBilinear)
+    , _bands (XCAM_SOFT_SCALER_DEFAULT_BANDS)
+{
+    _sizes.push_back (OutputSize ());
+}
+
+SoftScaler::~SoftScaler ()
+{
+}
+
+bool
+SoftScaler::set_mode (SoftScaleMode mode)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_scale_task.ptr (), false,
+        "SoftScaler(%s) set mode failed, scaler was already configured", XCAM_STR (get_name ()));
+
+    _mode = mode;
+    return true;
+}
+
+bool
+SoftScaler::set_output_size (uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_scale_task.ptr (), false,
+        "SoftScaler(%s) set output size failed, scaler was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, !(width % 2) && !(height % 2), false,
+        "SoftScaler(%s) output size(%dx%d) need be even", XCAM_STR (get_name ()), width, height);
+
+    _sizes[0] = OutputSize (width, height);
+    return true;
+}
+
+bool
+SoftScaler::add_output (uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_scale_task.ptr (), false,
+        "SoftScaler(%s) add output failed, scaler was already configured", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, _sizes.size () < XCAM_SOFT_SCALER_MAX_OUTPUTS, false,
+        "SoftScaler(%s) add output failed, no more than %d outputs",
+        XCAM_STR (get_name ()), XCAM_SOFT_SCALER_MAX_OUTPUTS);
+    XCAM_FAIL_RETURN (
+        ERROR, width && height && !(width % 2) && !(height % 2), false,
+        "SoftScaler(%s) output size(%dx%d) need be even and not zero", XCAM_STR (get_name ()), width, height);
+
+    _sizes.push_back (OutputSize (width, height));
+    return true;
+}
+
+bool
+SoftScaler::set_bands (uint32_t bands)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, bands, false,
+        "SoftScaler(%s) bands must be more than 0", XCAM_STR (get_name ()));
+
+    _bands = bands;
+    return true;
+}
+
+XCamReturn
+SoftScaler::scale (const SmartPtr<VideoBuffer> &in, std::vector<SmartPtr<VideoBuffer> > &outs)
+{
+    SmartPtr<ScaleParam> param = new ScaleParam (in);
+    if (!outs.empty ())
+        param->out_buf = outs[0];
+    if (outs.size () > 1)
+        param->extra_bufs.assign (outs.begin () + 1, outs.end ());
+
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret)) {
+        outs.resize (_sizes.size ());
+        outs[0] = param->out_buf;
+        for (uint32_t i = 1; i < outs.size (); ++i)
+            outs[i] = param->extra_bufs[i - 1];
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftScaler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftScaler(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+
+    if (!_sizes[0].width || !_sizes[0].height)
+        _sizes[0] = OutputSize (in_info.width, in_info.height);
+
+    std::vector<XCamSoftTasks::ScaleTask::Plan> plans (_sizes.size ());
+    std::vector<SmartPtr<BufferPool> > pools;
+    for (uint32_t i = 0; i < _sizes.size (); ++i) {
+        const OutputSize &size = _sizes[i];
+        XCamSoftTasks::ScaleTask::Plan &plan = plans[i];
+
+        if (_mode == SoftScaleArea) {
+            uint32_t factor_x = in_info.width / size.width, factor_y = in_info.height / size.height;
+            XCAM_FAIL_RETURN (
+                ERROR,
+                factor_x && factor_y && factor_x * size.width == in_info.width &&
+                factor_y * size.height == in_info.height &&
+                factor_x <= XCAM_SOFT_SCALER_MAX_AREA_FACTOR && factor_y <= XCAM_SOFT_SCALER_MAX_AREA_FACTOR,
+                XCAM_RETURN_ERROR_PARAM,
+                "SoftScaler(%s) area mode needs input(%dx%d) an integer multiple(<=%d) of output%d(%dx%d)",
+                XCAM_STR (get_name ()), in_info.width, in_info.height, XCAM_SOFT_SCALER_MAX_AREA_FACTOR,
+                i, size.width, size.height);
+
+            plan.luma_x.factor = plan.uv_x.factor = factor_x;
+            plan.luma_y.factor = plan.uv_y.factor = factor_y;
+            uint32_t pixels = factor_x * factor_y;
+            plan.area_recip = ((1 << SCALE_AREA_SHIFT) + pixels / 2) / pixels;
+        } else {
+            XCamSoftTasks::init_bilinear_axis (plan.luma_x, in_info.width, size.width);
+            XCamSoftTasks::init_bilinear_axis (plan.luma_y, in_info.height, size.height);
+            XCamSoftTasks::init_bilinear_axis (plan.uv_x, in_info.width / 2, size.width / 2);
+            XCamSoftTasks::init_bilinear_axis (plan.uv_y, in_info.height / 2, size.height / 2);
+            plan.area_recip = 0;
+        }
+
+        VideoBufferInfo out_info;
+        out_info.init (
+            V4L2_PIX_FMT_NV12, size.width, size.height,
+            XCAM_ALIGN_UP (size.width, XCAM_SOFT_SCALER_ALIGNMENT_X),
+            XCAM_ALIGN_UP (size.height, XCAM_SOFT_SCALER_ALIGNMENT_Y));
+        if (i == 0) {
+            set_out_video_info (out_info);
+            continue;
+        }
+
+        SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (out_info);
+        XCAM_FAIL_RETURN (
+            ERROR, pool.ptr () && xcam_ret_is_ok (pool->reserve (XCAM_DEFAULT_HANDLER_BUF_CAP)), XCAM_RETURN_ERROR_MEM,
+            "SoftScaler(%s) reserve buffers of output%d(%dx%d) failed",
+            XCAM_STR (get_name ()), i, size.width, size.height);
+        pools.push_back (pool);
+    }
+    _pools = pools;
+
+    XCAM_ASSERT (!_scale_task.ptr ());
+    _scale_task = new XCamSoftTasks::ScaleTask (new CbScaleTask (this), _mode);
+    XCAM_ASSERT (_scale_task.ptr ());
+    _scale_task->set_plans (plans);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftScaler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_scale_task.ptr ());
+    XCAM_ASSERT (param.ptr () && param->in_buf.ptr () && param->out_buf.ptr ());
+
+    SmartPtr<ScaleParam> scale_param = param.dynamic_cast_ptr<ScaleParam> ();
+    XCAM_FAIL_RETURN (
+        ERROR, _sizes.size () == 1 || scale_param.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "SoftScaler(%s) has %d outputs, it needs be executed with ScaleParam",
+        XCAM_STR (get_name ()), (uint32_t)_sizes.size ());
+    if (scale_param.ptr ())
+        scale_param->extra_bufs.resize (_sizes.size () - 1);
+
+    SmartPtr<XCamSoftTasks::ScaleTask::Args> args = new XCamSoftTasks::ScaleTask::Args (param);
+    args->in_luma = new UcharImage (param->in_buf, 0);
+    args->in_uv = new Uchar2Image (param->in_buf, 1);
+
+    uint32_t max_rows = 0;
+    for (uint32_t i = 0; i < _sizes.size (); ++i) {
+        SmartPtr<VideoBuffer> buf = param->out_buf;
+        if (i > 0) {
+            SmartPtr<VideoBuffer> &extra = scale_param->extra_bufs[i - 1];
+            if (!extra.ptr ())
+                extra = _pools[i - 1]->get_buffer (_pools[i - 1]);
+            XCAM_FAIL_RETURN (
+                ERROR, extra.ptr (), XCAM_RETURN_ERROR_MEM,
+                "SoftScaler(%s) output%d buffer failed in allocation", XCAM_STR (get_name ()), i);
+            buf = extra;
+        }
+
+        const VideoBufferInfo &out_info = buf->get_video_info ();
+        XCAM_FAIL_RETURN (
+            ERROR,
+            out_info.format == V4L2_PIX_FMT_NV12 &&
+            out_info.width == _sizes[i].width && out_info.height == _sizes[i].height,
+            XCAM_RETURN_ERROR_PARAM,
+            "SoftScaler(%s) output%d buffer(%s %dx%d) differs from output size(%dx%d)",
+            XCAM_STR (get_name ()), i, xcam_fourcc_to_string (out_info.format),
+            out_info.width, out_info.height, _sizes[i].width, _sizes[i].height);
+
+        args->out_luma[i] = new UcharImage (buf, 0);
+        args->out_uv[i] = new Uchar2Image (buf, 1);
+        max_rows = XCAM_MAX (max_rows, _sizes[i].height / 2);
+    }
+
+    WorkSize global_size (_sizes.size (), max_rows);
+    WorkSize local_size (1, xcam_ceil (max_rows, _bands) / _bands);
+    _scale_task->set_local_size (local_size);
+    _scale_task->set_global_size (global_size);
+
+    return _scale_task->work (args);
+}
+
+XCamReturn
+SoftScaler::terminate ()
+{
+    if (_scale_task.ptr ()) {
+        _scale_task->stop ();
+        _scale_task.release ();
+    }
+    _pools.clear ();
+    return SoftHandler::terminate ();
+}
+
+void
+SoftScaler::scale_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _scale_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::ScaleTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::ScaleTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler> create_soft_scaler ()
+{
+    SmartPtr<SoftHandler> scaler = new SoftScaler ();
+    XCAM_ASSERT (scaler.ptr ());
+
+    return scaler;
+}
+
+}
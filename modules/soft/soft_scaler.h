@@ -0,0 +1,119 @@
+/*
+ * soft_scaler.h - soft image scaler class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_SCALER_H
+#define XCAM_SOFT_SCALER_H
+
+#include <xcam_std.h>
+#include <buffer_pool.h>
+#include <soft/soft_handler.h>
+#include <soft/soft_image.h>
+#include <vector>
+
+#define XCAM_SOFT_SCALER_MAX_OUTPUTS 4
+#define XCAM_SOFT_SCALER_DEFAULT_BANDS 4
+// largest ratio of area mode in each direction
+#define XCAM_SOFT_SCALER_MAX_AREA_FACTOR 16
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class ScaleTask;
+};
+
+enum SoftScaleMode {
+    SoftScaleBilinear = 0,
+    // box average, input size must be an integer multiple of each output size
+    SoftScaleArea,
+};
+
+/*
+ * SoftScaler, scales one NV12 input into up to XCAM_SOFT_SCALER_MAX_OUTPUTS NV12 outputs
+ * in one pass over the input. output 0 comes from the handler allocator, the others from
+ * pools of their own, all SoftVideoBufAllocator unless the caller gives buffers.
+ * output sizes need be even.
+ */
+class SoftScaler
+    : public SoftHandler
+{
+public:
+    struct ScaleParam : ImageHandler::Parameters {
+        // outputs 1.., empty ones are taken from output pools
+        std::vector<SmartPtr<VideoBuffer> >  extra_bufs;
+
+        ScaleParam (const SmartPtr<VideoBuffer> &in = NULL, const SmartPtr<VideoBuffer> &out = NULL)
+            : Parameters (in, out)
+        {}
+    };
+
+public:
+    explicit SoftScaler (const char *name = "SoftScaler");
+    ~SoftScaler ();
+
+    // all setters need be called before configure
+    bool set_mode (SoftScaleMode mode);
+    SoftScaleMode get_mode () const {
+        return _mode;
+    }
+    // output 0, zero size keeps input size
+    bool set_output_size (uint32_t width, uint32_t height);
+    bool add_output (uint32_t width, uint32_t height);
+    uint32_t get_output_count () const {
+        return _sizes.size ();
+    }
+    bool set_bands (uint32_t bands);
+
+    // @outs is resized to output count, empty entries are allocated
+    XCamReturn scale (const SmartPtr<VideoBuffer> &in, std::vector<SmartPtr<VideoBuffer> > &outs);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void scale_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (SoftScaler);
+
+private:
+    struct OutputSize {
+        uint32_t    width;
+        uint32_t    height;
+
+        OutputSize (uint32_t w = 0, uint32_t h = 0) : width (w), height (h) {}
+    };
+
+    SmartPtr<XCamSoftTasks::ScaleTask>    _scale_task;
+    SoftScaleMode                         _mode;
+    uint32_t                              _bands;
+    std::vector<OutputSize>               _sizes;
+    std::vector<SmartPtr<BufferPool> >    _pools;
+};
+
+extern SmartPtr<SoftHandler> create_soft_scaler ();
+
+}
+
+#endif //XCAM_SOFT_SCALER_H
@@ -21,15 +21,27 @@
 #include "soft_stitcher.h"
 #include "soft_blender.h"
 #include "soft_geo_mapper.h"
+#include "soft_scaler.h"
 #include "soft_video_buf_allocator.h"
 #include "interface/feature_match.h"
 #include "surview_fisheye_dewarp.h"
+#include "fisheye_table_cache.h"
 #include "soft_copy_task.h"
 #include "xcam_utils.h"
-#include <map>
+#include "xcam_thread.h"
+#include "task_graph.h"
+#include "safe_list.h"
+#include "frame_latency.h"
+#include "memory_accounting.h"
+#include "blend_reuse.h"
+#include <sched.h>
+#include <atomic>
 
 #define ENABLE_FEATURE_MATCH HAVE_OPENCV
 
+// feature match cadence knob runs matching up to 1 << 3 times less often
+#define SOFT_STITCHER_FM_MAX_SHIFT 3
+
 #if ENABLE_FEATURE_MATCH
 #include "cv_capi_feature_match.h"
 #ifndef ANDROID
@@ -69,11 +81,60 @@ DECLARE_HANDLER_CALLBACK (CbGeoMap, SoftStitcher, dewarp_done);
 DECLARE_HANDLER_CALLBACK (CbBlender, SoftStitcher, blender_done);
 DECLARE_WORK_CALLBACK (CbCopyTask, SoftStitcher, copy_task_done);
 
+class StitcherImpl;
+
+// task graph run of one frame, keeps dewarp outputs for blenders and copiers
+class StitchRun
+    : public TaskRun
+{
+public:
+    StitchRun (StitcherImpl *impl, const SmartPtr<SoftStitcher::StitcherParam> &param)
+        : stitch_param (param)
+        , _impl (impl)
+    {}
+
+    SmartPtr<SoftStitcher::StitcherParam>  stitch_param;
+    SmartPtr<VideoBuffer>                  dewarp_bufs[XCAM_STITCH_MAX_CAMERAS];
+
+protected:
+    virtual void run_done (XCamReturn error);
+
+private:
+    StitcherImpl                          *_impl;
+};
+
+class StitchTask
+    : public TaskGraph::Task
+{
+public:
+    enum Stage {
+        StageDewarp,
+        StageBlend,
+        StageCopy,
+    };
+
+    StitchTask (StitcherImpl *impl, Stage stage, uint32_t idx)
+        : _impl (impl)
+        , _stage (stage)
+        , _idx (idx)
+    {}
+
+    virtual XCamReturn run (const SmartPtr<TaskRun> &run, TaskGraph::NodeId id);
+
+private:
+    StitcherImpl    *_impl;
+    Stage            _stage;
+    uint32_t         _idx;
+};
+
 struct BlenderParam
     : SoftBlender::BlenderParam
 {
     SmartPtr<SoftStitcher::StitcherParam>  stitch_param;
+    SmartPtr<StitchRun>                    run;
+    TaskGraph::NodeId                      node;
     uint32_t idx;
+    uint32_t reuse_ticket;
 
     BlenderParam (
         uint32_t i,
@@ -81,33 +142,38 @@ struct BlenderParam
         const SmartPtr<VideoBuffer> &in1,
         const SmartPtr<VideoBuffer> &out)
         : SoftBlender::BlenderParam (in0, in1, out)
+        , node (XCAM_TASK_GRAPH_INVALID_NODE)
         , idx (i)
+        , reuse_ticket (0)
     {}
 };
 
-typedef std::map<void*, SmartPtr<BlenderParam>> BlenderParams;
-typedef std::map<void*, int32_t> BlendCopyTaskNums;
-
 struct HandlerParam
-    : ImageHandler::Parameters
+    : SoftGeoMapper::RedirectParam
 {
     SmartPtr<SoftStitcher::StitcherParam>  stitch_param;
+    SmartPtr<StitchRun>                    run;
+    TaskGraph::NodeId                      node;
     uint32_t idx;
 
     HandlerParam (uint32_t i)
-        : idx (i)
+        : node (XCAM_TASK_GRAPH_INVALID_NODE)
+        , idx (i)
     {}
 };
 
 struct StitcherCopyArgs
     : XCamSoftTasks::CopyTask::Args
 {
+    SmartPtr<StitchRun>                    run;
+    TaskGraph::NodeId                      node;
     uint32_t idx;
 
     StitcherCopyArgs (
         uint32_t i,
         const SmartPtr<ImageHandler::Parameters> &param)
         : XCamSoftTasks::CopyTask::Args (param)
+        , node (XCAM_TASK_GRAPH_INVALID_NODE)
         , idx (i)
     {}
 };
@@ -125,11 +191,12 @@ struct Factor {
 struct Overlap {
     SmartPtr<FeatureMatch>       matcher;
     SmartPtr<SoftBlender>        blender;
-    BlenderParams                param_map;
+    // guarded by StitcherImpl::_map_mutex
+    uint32_t                     fm_frame_count;
+    bool                         fm_pending;
+    BlendReuse                   reuse;
 
-    SmartPtr<BlenderParam> find_blender_param_in_map (
-        const SmartPtr<SoftStitcher::StitcherParam> &key,
-        const uint32_t idx);
+    Overlap () : fm_frame_count (0), fm_pending (false) {}
 };
 
 struct FisheyeDewarp {
@@ -142,7 +209,21 @@ struct FisheyeDewarp {
         SmartPtr<SoftGeoMapper> mapper,
         const CameraInfo &cam_info,
         const Stitcher::RoundViewSlice &view_slice,
-        const BowlDataConfig &bowl);
+        const BowlDataConfig &bowl, bool use_cache,
+        const CalibrationBinary *binary = NULL);
+    // new table kept in mapper till commit_lookup_table
+    XCamReturn prepare_dewarp_geo_table (
+        const CameraInfo &cam_info,
+        const Stitcher::RoundViewSlice &view_slice,
+        const BowlDataConfig &bowl, bool use_cache,
+        const CalibrationBinary *binary = NULL);
+
+private:
+    static void get_table_size (const Stitcher::RoundViewSlice &view_slice, uint32_t &width, uint32_t &height);
+    static void build_geo_table (
+        SurViewFisheyeDewarp::MapTable &map_table, uint32_t &table_width, uint32_t &table_height,
+        const CameraInfo &cam_info, const Stitcher::RoundViewSlice &view_slice,
+        const BowlDataConfig &bowl, bool use_cache, const CalibrationBinary *binary);
 };
 
 struct Copier {
@@ -150,34 +231,106 @@ struct Copier {
     Stitcher::CopyArea                   copy_area;
 
     XCamReturn start_copy_task (
-        const SmartPtr<ImageHandler::Parameters> &param,
-        const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
+        const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, const SmartPtr<VideoBuffer> &buf);
 };
 typedef std::vector<Copier>    Copiers;
 
+struct FMRequest {
+    uint32_t                     idx;
+    SmartPtr<VideoBuffer>        left_buf;
+    SmartPtr<VideoBuffer>        right_buf;
+
+    FMRequest (uint32_t i, const SmartPtr<VideoBuffer> &left, const SmartPtr<VideoBuffer> &right)
+        : idx (i)
+        , left_buf (left)
+        , right_buf (right)
+    {}
+};
+
+struct BowlRequest {
+    BowlDataConfig               bowl;
+
+    explicit BowlRequest (const BowlDataConfig &config)
+        : bowl (config)
+    {}
+};
+
+// rebuilds dewarp tables of bowl updates, newest request wins
+class BowlUpdateThread
+    : public Thread
+{
+public:
+    explicit BowlUpdateThread (StitcherImpl *impl)
+        : Thread ("soft_stitcher_bowl")
+        , _impl (impl)
+    {}
+
+    bool push_request (const SmartPtr<BowlRequest> &req) {
+        return _requests.push (req);
+    }
+    void trigger_stop () {
+        _requests.pause_pop ();
+        _requests.clear ();
+    }
+
+protected:
+    virtual bool loop ();
+
+private:
+    StitcherImpl               *_impl;
+    SafeList<BowlRequest>       _requests;
+};
+
+// runs feature match requests at idle priority, results are picked up by next frames' dewarp
+class FMThread
+    : public Thread
+{
+public:
+    explicit FMThread (StitcherImpl *impl)
+        : Thread ("soft_stitcher_fm")
+        , _impl (impl)
+    {}
+
+    bool push_request (const SmartPtr<FMRequest> &req) {
+        return _requests.push (req);
+    }
+    void trigger_stop () {
+        _requests.pause_pop ();
+        _requests.clear ();
+    }
+
+protected:
+    virtual bool started ();
+    virtual bool loop ();
+
+private:
+    StitcherImpl               *_impl;
+    SafeList<FMRequest>         _requests;
+};
+
 class StitcherImpl {
     friend class XCam::SoftStitcher;
 
 public:
     StitcherImpl (SoftStitcher *handler)
-        : _stitcher (handler)
+        : _bowl_ready (false)
+        , _fm_interval_shift (0)
+        , _blend_level_drop (0)
+        , _stitcher (handler)
     {}
 
     XCamReturn init_config (uint32_t count);
 
-    bool remove_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param);
-    int32_t dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    XCamReturn start_frame (const SmartPtr<SoftStitcher::StitcherParam> &param);
+    void frame_done (const SmartPtr<SoftStitcher::StitcherParam> &param, XCamReturn error);
 
-    XCamReturn start_dewarp_works (const SmartPtr<SoftStitcher::StitcherParam> &param);
-    XCamReturn start_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param);
-    XCamReturn start_overlap_tasks (
-        const SmartPtr<SoftStitcher::StitcherParam> &param,
-        const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
-    XCamReturn start_copy_tasks (
-        const SmartPtr<SoftStitcher::StitcherParam> &param,
-        const uint32_t idx, const SmartPtr<VideoBuffer> &buf);
+    // graph stages
+    XCamReturn start_dewarp (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx);
+    XCamReturn start_blender (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx);
+    XCamReturn start_copier (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx);
 
     XCamReturn start_single_blender (const uint32_t idx, const SmartPtr<BlenderParam> &param);
+    void keep_blend_result (const SmartPtr<BlenderParam> &param);
     XCamReturn stop ();
 
     XCamReturn fisheye_dewarp_to_table ();
@@ -188,12 +341,37 @@ public:
 
     bool get_and_reset_feature_match_factors (uint32_t idx, Factor &left, Factor &right);
 
+    XCamReturn schedule_feature_match (
+        const SmartPtr<VideoBuffer> &left_buf,
+        const SmartPtr<VideoBuffer> &right_buf,
+        const uint32_t idx);
+    void run_feature_match (const SmartPtr<FMRequest> &req);
+
+    XCamReturn request_bowl_update (const BowlDataConfig &config);
+    XCamReturn prepare_bowl_tables (const BowlDataConfig &config);
+
+    // quality knobs, turned from any thread
+    uint32_t get_fm_interval_shift () const {
+        return _fm_interval_shift;
+    }
+    void set_fm_interval_shift (uint32_t shift) {
+        _fm_interval_shift = shift;
+    }
+    uint32_t get_blend_level_drop () const {
+        return _blend_level_drop;
+    }
+    bool set_blend_level_drop (uint32_t drop);
+
 private:
     SmartPtr<SoftGeoMapper> create_geo_mapper (const Stitcher::RoundViewSlice &view_slice);
 
     XCamReturn init_fisheye (uint32_t idx);
+    bool init_redirect_areas ();
     bool init_dewarp_factors (uint32_t idx);
     XCamReturn create_copier (Stitcher::CopyArea area);
+    XCamReturn init_task_graph (uint32_t count);
+    void get_slice_bowl (uint32_t idx, const BowlDataConfig &config, BowlDataConfig &bowl);
+    void commit_bowl_tables ();
 
     void calc_factors (
         const uint32_t &idx, const Factor &last_left_factor, const Factor &last_right_factor,
@@ -206,11 +384,71 @@ private:
     SmartPtr<BufferPool>    _dewarp_pool;
 
     Mutex                   _map_mutex;
-    BlendCopyTaskNums       _task_counts;
+    SmartPtr<TaskGraph>     _graph;
+    SmartPtr<FMThread>      _fm_thread;
+
+    // prepared tables of _next_bowl in all dewarps, guarded by _map_mutex
+    SmartPtr<BowlUpdateThread>  _bowl_thread;
+    BowlDataConfig          _next_bowl;
+    bool                    _bowl_ready;
+
+    std::atomic<uint32_t>   _fm_interval_shift;
+    std::atomic<uint32_t>   _blend_level_drop;
 
     SoftStitcher           *_stitcher;
 };
 
+// level L runs feature match 1 << L times less often than its schedule
+class FMCadenceKnob
+    : public QualityKnob
+{
+public:
+    explicit FMCadenceKnob (StitcherImpl *impl)
+        : QualityKnob ("fm-cadence")
+        , _impl (impl)
+    {}
+
+    virtual uint32_t get_level_count () const {
+        return SOFT_STITCHER_FM_MAX_SHIFT + 1;
+    }
+    virtual uint32_t get_level () const {
+        return _impl->get_fm_interval_shift ();
+    }
+    virtual bool set_level (uint32_t level) {
+        if (level > SOFT_STITCHER_FM_MAX_SHIFT)
+            return false;
+        _impl->set_fm_interval_shift (level);
+        return true;
+    }
+
+private:
+    StitcherImpl   *_impl;
+};
+
+// level L drops the L coarsest pyramid levels of all overlap blenders
+class BlendLevelsKnob
+    : public QualityKnob
+{
+public:
+    explicit BlendLevelsKnob (StitcherImpl *impl)
+        : QualityKnob ("blend-pyr-levels")
+        , _impl (impl)
+    {}
+
+    virtual uint32_t get_level_count () const {
+        return XCAM_SOFT_PYRAMID_DEFAULT_LEVEL;
+    }
+    virtual uint32_t get_level () const {
+        return _impl->get_blend_level_drop ();
+    }
+    virtual bool set_level (uint32_t level) {
+        return _impl->set_blend_level_drop (level);
+    }
+
+private:
+    StitcherImpl   *_impl;
+};
+
 
 void
 StitcherImpl::calc_factors (
@@ -269,26 +507,69 @@ StitcherImpl::init_dewarp_factors (uint32_t idx)
     return true;
 }
 
+void
+FisheyeDewarp::get_table_size (const Stitcher::RoundViewSlice &view_slice, uint32_t &width, uint32_t &height)
+{
+    width = view_slice.width / MAP_FACTOR_X;
+    width = XCAM_ALIGN_UP (width, 4);
+    height = view_slice.height / MAP_FACTOR_Y;
+    height = XCAM_ALIGN_UP (height, 2);
+}
+
+void
+FisheyeDewarp::build_geo_table (
+    SurViewFisheyeDewarp::MapTable &map_table, uint32_t &table_width, uint32_t &table_height,
+    const CameraInfo &cam_info, const Stitcher::RoundViewSlice &view_slice,
+    const BowlDataConfig &bowl, bool use_cache, const CalibrationBinary *binary)
+{
+    PolyFisheyeDewarp fd;
+    fd.set_intrinsic_param (cam_info.calibration.intrinsic);
+    fd.set_extrinsic_param (cam_info.calibration.extrinsic);
+
+    get_table_size (view_slice, table_width, table_height);
+    map_table.resize (table_width * table_height);
+    FisheyeTableCache cache;
+    if (use_cache || binary)
+        cache.set_key (
+            cam_info.calibration.intrinsic, cam_info.calibration.extrinsic, bowl,
+            table_width, table_height, view_slice.width, view_slice.height);
+
+    CalibrationTable table;
+    if (binary && binary->find_table (cache.get_key (), table_width, table_height, table)) {
+        map_table.assign (table.data, table.data + table_width * table_height);
+        return;
+    }
+
+    if (!use_cache || !cache.load (map_table)) {
+        fd.fisheye_dewarp (
+            map_table, table_width, table_height,
+            view_slice.width, view_slice.height, bowl);
+        if (use_cache)
+            cache.save (map_table);
+    }
+}
+
 XCamReturn
 FisheyeDewarp::set_dewarp_geo_table (
     SmartPtr<SoftGeoMapper> mapper,
     const CameraInfo &cam_info,
     const Stitcher::RoundViewSlice &view_slice,
-    const BowlDataConfig &bowl)
+    const BowlDataConfig &bowl, bool use_cache,
+    const CalibrationBinary *binary)
 {
-    PolyFisheyeDewarp fd;
-    fd.set_intrinsic_param (cam_info.calibration.intrinsic);
-    fd.set_extrinsic_param (cam_info.calibration.extrinsic);
-
+    // stitchers of the same calibration and config share one table
     uint32_t table_width, table_height;
-    table_width = view_slice.width / MAP_FACTOR_X;
-    table_width = XCAM_ALIGN_UP (table_width, 4);
-    table_height = view_slice.height / MAP_FACTOR_Y;
-    table_height = XCAM_ALIGN_UP (table_height, 2);
-    SurViewFisheyeDewarp::MapTable map_table(table_width * table_height);
-    fd.fisheye_dewarp (
-        map_table, table_width, table_height,
-        view_slice.width, view_slice.height, bowl);
+    get_table_size (view_slice, table_width, table_height);
+    FisheyeTableCache cache;
+    cache.set_key (
+        cam_info.calibration.intrinsic, cam_info.calibration.extrinsic, bowl,
+        table_width, table_height, view_slice.width, view_slice.height);
+    mapper->set_table_key (cache.get_key ());
+    if (mapper->use_shared_lookup_table ())
+        return XCAM_RETURN_NO_ERROR;
+
+    SurViewFisheyeDewarp::MapTable map_table;
+    build_geo_table (map_table, table_width, table_height, cam_info, view_slice, bowl, use_cache, binary);
 
     XCAM_FAIL_RETURN (
         ERROR, mapper->set_lookup_table (map_table.data (), table_width, table_height),
@@ -296,6 +577,23 @@ FisheyeDewarp::set_dewarp_geo_table (
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+FisheyeDewarp::prepare_dewarp_geo_table (
+    const CameraInfo &cam_info,
+    const Stitcher::RoundViewSlice &view_slice,
+    const BowlDataConfig &bowl, bool use_cache,
+    const CalibrationBinary *binary)
+{
+    SurViewFisheyeDewarp::MapTable map_table;
+    uint32_t table_width, table_height;
+    build_geo_table (map_table, table_width, table_height, cam_info, view_slice, bowl, use_cache, binary);
+
+    XCAM_FAIL_RETURN (
+        ERROR, dewarp->prepare_lookup_table (map_table.data (), table_width, table_height),
+        XCAM_RETURN_ERROR_UNKNOWN, "prepare fisheye dewarp lookup table failed");
+    return XCAM_RETURN_NO_ERROR;
+}
+
 bool
 StitcherImpl::get_and_reset_feature_match_factors (uint32_t idx, Factor &left, Factor &right)
 {
@@ -317,9 +615,13 @@ SmartPtr<SoftGeoMapper>
 StitcherImpl::create_geo_mapper (const Stitcher::RoundViewSlice &view_slice)
 {
     SmartPtr<SoftGeoMapper> dewarp;
-    if (_stitcher->get_scale_mode () == ScaleSingleConst)
+    if (_stitcher->get_scale_mode () == ScaleSingleConst) {
         dewarp = new SoftGeoMapper ("sitcher_remapper");
-    else if (_stitcher->get_scale_mode () == ScaleDualConst)
+
+        // static calibration, expand dewarp table to full resolution once
+        if (_stitcher->is_table_cache_enabled ())
+            dewarp->enable_fixed_point (true);
+    } else if (_stitcher->get_scale_mode () == ScaleDualConst)
         dewarp = new SoftDualConstGeoMapper ("sitcher_dualconst_remapper");
     else {
         SmartPtr<SoftDualCurveGeoMapper> geomap = new SoftDualCurveGeoMapper ("sitcher_dualcurve_remapper");
@@ -357,7 +659,7 @@ StitcherImpl::init_fisheye (uint32_t idx)
     XCAM_ASSERT (pool.ptr ());
     fisheye.buf_pool = pool;
     XCAM_FAIL_RETURN (
-        ERROR, fisheye.buf_pool->reserve (2), XCAM_RETURN_ERROR_MEM,
+        ERROR, xcam_ret_is_ok (fisheye.buf_pool->reserve (_stitcher->get_pipeline_depth () + 1)), XCAM_RETURN_ERROR_MEM,
         "stitcher:%s reserve dewarp buffer pool(w:%d,h:%d) failed",
         XCAM_STR (_stitcher->get_name ()), buf_info.width, buf_info.height);
     return XCAM_RETURN_NO_ERROR;
@@ -380,17 +682,46 @@ StitcherImpl::create_copier (Stitcher::CopyArea area)
     copier.copy_task = new XCamSoftTasks::CopyTask (copy_cb);
     XCAM_ASSERT (copier.copy_task.ptr ());
     copier.copy_area = area;
+    copier.copy_task->set_copy_size (area.in_area.width, area.in_area.height);
     _copiers.push_back (copier);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+bool
+StitcherImpl::init_redirect_areas ()
+{
+    const Stitcher::CopyAreaArray &areas = _stitcher->get_copy_area ();
+    uint32_t camera_num = _stitcher->get_camera_num ();
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        SoftGeoMapper::RedirectAreas redirects;
+        for (uint32_t j = 0; j < areas.size (); ++j) {
+            if (areas[j].in_idx != i)
+                continue;
+
+            SoftGeoMapper::RedirectArea redirect;
+            redirect.in_area = areas[j].in_area;
+            redirect.out_x = areas[j].out_area.pos_x;
+            redirect.out_y = areas[j].out_area.pos_y;
+            redirects.push_back (redirect);
+        }
+
+        if (!_fisheye[i].dewarp->set_redirect_areas (redirects))
+            return false;
+    }
+
+    return true;
+}
+
 XCamReturn
 StitcherImpl::init_config (uint32_t count)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     SmartPtr<ImageHandler::Callback> blender_cb = new CbBlender (_stitcher);
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
     for (uint32_t i = 0; i < count; ++i) {
         ret = init_fisheye (i);
         XCAM_FAIL_RETURN (
@@ -408,6 +739,7 @@ StitcherImpl::init_config (uint32_t count)
         config.recur_offset_error = 8.0f;
         config.max_adjusted_offset = 24.0f;
         config.max_valid_offset_y = 20.0f;
+        config.scale_level = 1;
 #ifndef ANDROID
         config.max_track_error = 28.0f;
 #else
@@ -420,9 +752,30 @@ StitcherImpl::init_config (uint32_t count)
         _overlaps[i].blender = create_soft_blender ().dynamic_cast_ptr<SoftBlender>();
         XCAM_ASSERT (_overlaps[i].blender.ptr ());
         _overlaps[i].blender->set_callback (blender_cb);
-        _overlaps[i].param_map.clear ();
+        _overlaps[i].blender->set_pipeline_depth (_stitcher->get_pipeline_depth ());
+        _overlaps[i].blender->set_blend_mode (_stitcher->get_blend_mode ());
+        _overlaps[i].blender->set_active_pyr_levels (
+            XCAM_SOFT_PYRAMID_DEFAULT_LEVEL - XCAM_MIN ((uint32_t)_blend_level_drop, XCAM_SOFT_PYRAMID_DEFAULT_LEVEL - 1));
+
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (i);
+        _overlaps[i].blender->set_output_size (out_width, out_height);
+        _overlaps[i].blender->set_merge_window (overlap_info.out_area);
+        _overlaps[i].blender->set_input_valid_area (overlap_info.left, 0);
+        _overlaps[i].blender->set_input_valid_area (overlap_info.right, 1);
+        _overlaps[i].blender->set_input_merge_area (overlap_info.left, 0);
+        _overlaps[i].blender->set_input_merge_area (overlap_info.right, 1);
+        _overlaps[i].fm_frame_count = 0;
+        _overlaps[i].fm_pending = false;
+        _overlaps[i].reuse.set_policy (_stitcher->get_blend_reuse ());
     }
 
+#if ENABLE_FEATURE_MATCH
+    _fm_thread = new FMThread (this);
+    XCAM_FAIL_RETURN (
+        ERROR, _fm_thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "stitcher:%s start feature match thread failed", XCAM_STR (_stitcher->get_name ()));
+#endif
+
     Stitcher::CopyAreaArray areas = _stitcher->get_copy_area ();
     uint32_t size = areas.size ();
     for (uint32_t i = 0; i < size; ++i) {
@@ -431,46 +784,63 @@ StitcherImpl::init_config (uint32_t count)
                         areas[i].in_area.pos_x, areas[i].in_area.pos_y, areas[i].in_area.width, areas[i].in_area.height,
                         areas[i].out_area.pos_x, areas[i].out_area.pos_y, areas[i].out_area.width, areas[i].out_area.height);
 
-        XCAM_ASSERT (areas[i].in_idx < size);
+        XCAM_ASSERT (areas[i].in_idx < count);
         ret = create_copier (areas[i]);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "soft-stitcher::%s init copier failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
     }
 
-    return XCAM_RETURN_NO_ERROR;
-}
+    if (_stitcher->is_fused_mode () && !init_redirect_areas ()) {
+        XCAM_LOG_WARNING (
+            "soft-stitcher:%s copy areas can't be fused into dewarp, fall back to copy tasks",
+            XCAM_STR (_stitcher->get_name ()));
 
-bool
-StitcherImpl::remove_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param)
-{
-    XCAM_ASSERT (param.ptr ());
-    SmartLock locker (_map_mutex);
-    BlendCopyTaskNums::iterator i = _task_counts.find (param.ptr ());
-    if (i == _task_counts.end ())
-        return false;
+        for (uint32_t i = 0; i < count; ++i)
+            _fisheye[i].dewarp->set_redirect_areas (SoftGeoMapper::RedirectAreas ());
+        _stitcher->enable_fused_mode (false);
+    }
 
-    _task_counts.erase (i);
-    return true;
+    return init_task_graph (count);
 }
 
-int32_t
-StitcherImpl::dec_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param)
+XCamReturn
+StitcherImpl::init_task_graph (uint32_t count)
 {
-    XCAM_ASSERT (param.ptr ());
-    SmartLock locker (_map_mutex);
-    BlendCopyTaskNums::iterator i = _task_counts.find (param.ptr ());
-    if (i == _task_counts.end ())
-        return -1;
+    // blenders wait for both neighbor dewarps, copiers for their input dewarp, fused copies need none
+    _graph = new TaskGraph (_stitcher->get_name ());
+    TaskGraph::NodeId dewarp_nodes[XCAM_STITCH_MAX_CAMERAS];
+    for (uint32_t i = 0; i < count; ++i) {
+        dewarp_nodes[i] = XCAM_TASK_GRAPH_INVALID_NODE;
+        if (!_stitcher->is_camera_in_strip (i))
+            continue;
+        dewarp_nodes[i] = _graph->add_node (new StitchTask (this, StitchTask::StageDewarp, i), true);
+        XCAM_ASSERT (dewarp_nodes[i] != XCAM_TASK_GRAPH_INVALID_NODE);
+    }
 
-    int32_t &count = i->second;
-    --count;
-    if (count > 0)
-        return count;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!_stitcher->is_overlap_in_strip (i))
+            continue;
+        TaskGraph::NodeId node = _graph->add_node (new StitchTask (this, StitchTask::StageBlend, i), true);
+        _graph->add_edge (dewarp_nodes[i], node);
+        _graph->add_edge (dewarp_nodes[(i + 1) % count], node);
+    }
 
-    XCAM_ASSERT (count == 0);
-    _task_counts.erase (i);
-    return 0;
+    if (!_stitcher->is_fused_mode ()) {
+        for (uint32_t i = 0; i < _copiers.size (); ++i) {
+            TaskGraph::NodeId node = _graph->add_node (new StitchTask (this, StitchTask::StageCopy, i), true);
+            _graph->add_edge (dewarp_nodes[_copiers[i].copy_area.in_idx], node);
+        }
+    }
+
+    XCamReturn ret = _graph->seal ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s init task graph failed", XCAM_STR (_stitcher->get_name ()));
+
+    XCAM_LOG_DEBUG (
+        "soft-stitcher:%s task graph of %d nodes", XCAM_STR (_stitcher->get_name ()), _graph->get_node_count ());
+    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
@@ -482,22 +852,18 @@ StitcherImpl::fisheye_dewarp_to_table ()
         _stitcher->get_camera_info (i, cam_info);
         Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (i);
 
-        BowlDataConfig bowl = _stitcher->get_bowl_config ();
-        bowl.angle_start = view_slice.hori_angle_start;
-        bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
-
-        uint32_t out_width, out_height;
-        _stitcher->get_output_size (out_width, out_height);
+        BowlDataConfig bowl;
+        get_slice_bowl (i, _stitcher->get_bowl_config (), bowl);
 
         _fisheye[i].dewarp->set_output_size (view_slice.width, view_slice.height);
-        if (bowl.angle_end < bowl.angle_start)
-            bowl.angle_start -= 360.0f;
         XCAM_LOG_INFO (
             "soft-stitcher:%s camera(idx:%d) info (angle start:%.2f, range:%.2f), bowl info (angle start%.2f, end:%.2f)",
             XCAM_STR (_stitcher->get_name ()), i,
             view_slice.hori_angle_start, view_slice.hori_angle_range,
             bowl.angle_start, bowl.angle_end);
-        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (_fisheye[i].dewarp, cam_info, view_slice, bowl);
+        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (
+            _fisheye[i].dewarp, cam_info, view_slice, bowl, _stitcher->is_table_cache_enabled (),
+            _stitcher->get_calibration_binary ().ptr ());
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
             "stitcher:%s set dewarp geo table failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
@@ -507,45 +873,180 @@ StitcherImpl::fisheye_dewarp_to_table ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+StitcherImpl::get_slice_bowl (uint32_t idx, const BowlDataConfig &config, BowlDataConfig &bowl)
+{
+    const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (idx);
+
+    bowl = config;
+    bowl.angle_start = view_slice.hori_angle_start;
+    bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
+    if (bowl.angle_end < bowl.angle_start)
+        bowl.angle_start -= 360.0f;
+}
+
 XCamReturn
-StitcherImpl::start_dewarp_works (const SmartPtr<SoftStitcher::StitcherParam> &param)
+StitcherImpl::request_bowl_update (const BowlDataConfig &config)
 {
-    uint32_t camera_num = _stitcher->get_camera_num ();
-    Factor cur_left, cur_right;
+    if (!_bowl_thread.ptr ()) {
+        _bowl_thread = new BowlUpdateThread (this);
+        if (!_bowl_thread->start ()) {
+            _bowl_thread.release ();
+            XCAM_LOG_ERROR ("stitcher:%s start bowl update thread failed", XCAM_STR (_stitcher->get_name ()));
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+    }
 
+    _bowl_thread->push_request (new BowlRequest (config));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::prepare_bowl_tables (const BowlDataConfig &config)
+{
+    {
+        // tables of a request not committed yet are replaced
+        SmartLock locker (_map_mutex);
+        _bowl_ready = false;
+    }
+
+    uint32_t camera_num = _stitcher->get_camera_num ();
     for (uint32_t i = 0; i < camera_num; ++i) {
-        SmartPtr<VideoBuffer> out_buf = _fisheye[i].buf_pool->get_buffer ();
-        SmartPtr<HandlerParam> dewarp_params = new HandlerParam (i);
-        dewarp_params->in_buf = param->in_bufs[i];
-        dewarp_params->out_buf = out_buf;
-        dewarp_params->stitch_param = param;
-
-        init_dewarp_factors (i);
-        XCamReturn ret = _fisheye[i].dewarp->execute_buffer (dewarp_params, false);
+        CameraInfo cam_info;
+        _stitcher->get_camera_info (i, cam_info);
+        Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (i);
+
+        BowlDataConfig bowl;
+        get_slice_bowl (i, config, bowl);
+        XCamReturn ret = _fisheye[i].prepare_dewarp_geo_table (
+            cam_info, view_slice, bowl, _stitcher->is_table_cache_enabled (),
+            _stitcher->get_calibration_binary ().ptr ());
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s fisheye dewarp buffer failed", XCAM_STR (_stitcher->get_name ()));
+            "stitcher:%s prepare dewarp geo table failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
     }
+
+    SmartLock locker (_map_mutex);
+    _next_bowl = config;
+    _bowl_ready = true;
     return XCAM_RETURN_NO_ERROR;
 }
 
-SmartPtr<BlenderParam>
-Overlap::find_blender_param_in_map (
-    const SmartPtr<SoftStitcher::StitcherParam> &key,
-    const uint32_t idx)
+void
+StitcherImpl::commit_bowl_tables ()
 {
-    SmartPtr<BlenderParam> param;
-    BlenderParams::iterator i = param_map.find (key.ptr ());
-    if (i == param_map.end ()) {
-        param = new BlenderParam (idx, NULL, NULL, NULL);
-        XCAM_ASSERT (param.ptr ());
-        param->stitch_param = key;
-        param_map.insert (std::make_pair ((void*)key.ptr (), param));
-    } else {
-        param = (*i).second;
+    SmartLock locker (_map_mutex);
+    if (!_bowl_ready)
+        return;
+
+    // dewarps of previous frames were all started, so every frame sees one config
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        _fisheye[i].dewarp->commit_lookup_table ();
+
+        SmartPtr<SoftDualCurveGeoMapper> geomap = _fisheye[i].dewarp.dynamic_cast_ptr<SoftDualCurveGeoMapper> ();
+        if (geomap.ptr ()) {
+            const Stitcher::RoundViewSlice &view_slice = _stitcher->get_round_view_slice (i);
+            float scaled_height = (_next_bowl.wall_height + _next_bowl.ground_length / 2.0f) /
+                                  (_next_bowl.wall_height + _next_bowl.ground_length) * view_slice.height;
+            geomap->set_scaled_height (scaled_height);
+        }
     }
+    _stitcher->set_bowl_config (_next_bowl);
+    _bowl_ready = false;
 
-    return param;
+    XCAM_LOG_INFO ("soft-stitcher:%s bowl config updated", XCAM_STR (_stitcher->get_name ()));
+}
+
+bool
+BowlUpdateThread::loop ()
+{
+    SmartPtr<BowlRequest> req = _requests.pop (-1);
+    if (!req.ptr ())
+        return false;
+
+    // skip to the newest request
+    while (_requests.size ()) {
+        SmartPtr<BowlRequest> next = _requests.pop (0);
+        if (!next.ptr ())
+            break;
+        req = next;
+    }
+
+    XCamReturn ret = _impl->prepare_bowl_tables (req->bowl);
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING ("soft-stitcher bowl update failed, keep current config");
+    }
+    return true;
+}
+
+void
+StitchRun::run_done (XCamReturn error)
+{
+    _impl->frame_done (stitch_param, error);
+}
+
+XCamReturn
+StitchTask::run (const SmartPtr<TaskRun> &run, TaskGraph::NodeId id)
+{
+    SmartPtr<StitchRun> stitch_run = run.dynamic_cast_ptr<StitchRun> ();
+    XCAM_ASSERT (stitch_run.ptr ());
+
+    switch (_stage) {
+    case StageDewarp:
+        return _impl->start_dewarp (stitch_run, id, _idx);
+    case StageBlend:
+        return _impl->start_blender (stitch_run, id, _idx);
+    case StageCopy:
+        return _impl->start_copier (stitch_run, id, _idx);
+    }
+    return XCAM_RETURN_ERROR_PARAM;
+}
+
+XCamReturn
+StitcherImpl::start_frame (const SmartPtr<SoftStitcher::StitcherParam> &param)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _graph.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "soft-stitcher:%s start frame failed, task graph is not ready", XCAM_STR (_stitcher->get_name ()));
+
+    commit_bowl_tables ();
+    return _graph->launch (new StitchRun (this, param));
+}
+
+void
+StitcherImpl::frame_done (const SmartPtr<SoftStitcher::StitcherParam> &param, XCamReturn error)
+{
+    if (!xcam_ret_is_ok (error)) {
+        _stitcher->work_broken (param, error);
+        return;
+    }
+    _stitcher->work_well_done (param, XCAM_RETURN_NO_ERROR);
+}
+
+XCamReturn
+StitcherImpl::start_dewarp (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx)
+{
+    const SmartPtr<SoftStitcher::StitcherParam> &param = run->stitch_param;
+
+    SmartPtr<VideoBuffer> out_buf = _fisheye[idx].buf_pool->get_buffer ();
+    SmartPtr<HandlerParam> dewarp_params = new HandlerParam (idx);
+    dewarp_params->in_buf = param->in_bufs[idx];
+    dewarp_params->out_buf = out_buf;
+    dewarp_params->stitch_param = param;
+    dewarp_params->run = run;
+    dewarp_params->node = node;
+    dewarp_params->deadline = param->deadline;
+    if (_stitcher->is_fused_mode ())
+        dewarp_params->redirect_buf = param->out_buf;
+
+    init_dewarp_factors (idx);
+    XCamReturn ret = _fisheye[idx].dewarp->execute_buffer (dewarp_params, false);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s fisheye dewarp buffer failed, idx:%d", XCAM_STR (_stitcher->get_name ()), idx);
+
+    return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
@@ -597,100 +1098,203 @@ StitcherImpl::feature_match (
     return XCAM_RETURN_NO_ERROR;
 }
 
-XCamReturn
-StitcherImpl::start_single_blender (
-    const uint32_t idx,
-    const SmartPtr<BlenderParam> &param)
+bool
+FMThread::started ()
 {
-    SmartPtr<SoftBlender> blender = _overlaps[idx].blender;
-    const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (idx);
-    uint32_t out_width, out_height;
-    _stitcher->get_output_size (out_width, out_height);
-
-    blender->set_output_size (out_width, out_height);
-    blender->set_merge_window (overlap_info.out_area);
-    blender->set_input_valid_area (overlap_info.left, 0);
-    blender->set_input_valid_area (overlap_info.right, 1);
-    blender->set_input_merge_area (overlap_info.left, 0);
-    blender->set_input_merge_area (overlap_info.right, 1);
-    return blender->execute_buffer (param, false);
+#ifdef SCHED_IDLE
+    struct sched_param param;
+    xcam_mem_clear (param);
+    if (pthread_setschedparam (pthread_self (), SCHED_IDLE, &param) != 0) {
+        XCAM_LOG_WARNING ("soft-stitcher feature match thread keeps normal priority");
+    }
+#endif
+    return Thread::started ();
 }
 
-XCamReturn
-StitcherImpl::start_overlap_tasks (
-    const SmartPtr<SoftStitcher::StitcherParam> &param,
-    const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
+bool
+FMThread::loop ()
 {
-    SmartPtr<BlenderParam> cur_param, prev_param;
-    const uint32_t camera_num = _stitcher->get_camera_num ();
-    uint32_t pre_idx = (idx + camera_num - 1) % camera_num;
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    {
-        SmartPtr<BlenderParam> param_b;
+    SmartPtr<FMRequest> req = _requests.pop (-1);
+    if (!req.ptr ())
+        return false;
 
-        SmartLock locker (_map_mutex);
-        param_b = _overlaps[idx].find_blender_param_in_map (param, idx);
-        param_b->in_buf = buf;
-        if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
-            cur_param = param_b;
-            _overlaps[idx].param_map.erase (param.ptr ());
-        }
+    _impl->run_feature_match (req);
+    return true;
+}
 
-        param_b = _overlaps[pre_idx].find_blender_param_in_map (param, pre_idx);
-        param_b->in1_buf = buf;
-        if (param_b->in_buf.ptr () && param_b->in1_buf.ptr ()) {
-            prev_param = param_b;
-            _overlaps[pre_idx].param_map.erase (param.ptr ());
+// mean absolute luma difference of two areas, sampled every 4 pixels
+static float
+overlap_luma_diff (
+    const SmartPtr<VideoBuffer> &left_buf, const Rect &left_area,
+    const SmartPtr<VideoBuffer> &right_buf, const Rect &right_area)
+{
+    const uint32_t step = 4;
+    const VideoBufferInfo &left_info = left_buf->get_video_info ();
+    const VideoBufferInfo &right_info = right_buf->get_video_info ();
+    uint32_t width = XCAM_MIN (left_area.width, right_area.width);
+    uint32_t height = XCAM_MIN (left_area.height, right_area.height);
+
+    uint8_t *left_ptr = left_buf->map ();
+    uint8_t *right_ptr = right_buf->map ();
+    float diff = 0.0f;
+    if (left_ptr && right_ptr && width >= step && height >= step) {
+        uint64_t sum = 0, count = 0;
+        for (uint32_t y = 0; y < height; y += step) {
+            const uint8_t *left_line =
+                left_ptr + left_info.offsets[0] + (left_area.pos_y + y) * left_info.strides[0] + left_area.pos_x;
+            const uint8_t *right_line =
+                right_ptr + right_info.offsets[0] + (right_area.pos_y + y) * right_info.strides[0] + right_area.pos_x;
+            for (uint32_t x = 0; x < width; x += step) {
+                sum += abs ((int32_t)left_line[x] - (int32_t)right_line[x]);
+                ++count;
+            }
         }
+        diff = (float)sum / count;
     }
+    if (left_ptr)
+        left_buf->unmap ();
+    if (right_ptr)
+        right_buf->unmap ();
 
-    if (cur_param.ptr ()) {
-        cur_param->out_buf = param->out_buf;
-        ret = start_single_blender (idx, cur_param);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s blend overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
+    return diff;
+}
+
+bool
+StitcherImpl::set_blend_level_drop (uint32_t drop)
+{
+    if (drop >= XCAM_SOFT_PYRAMID_DEFAULT_LEVEL)
+        return false;
+
+    _blend_level_drop = drop;
+    for (uint32_t i = 0; i < XCAM_STITCH_MAX_CAMERAS; ++i) {
+        if (_overlaps[i].blender.ptr ())
+            _overlaps[i].blender->set_active_pyr_levels (XCAM_SOFT_PYRAMID_DEFAULT_LEVEL - drop);
+        _overlaps[i].reuse.reset ();
     }
+    return true;
+}
 
-    if (prev_param.ptr ()) {
-        prev_param->out_buf = param->out_buf;
-        ret = start_single_blender (pre_idx, prev_param);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s blend overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), pre_idx);
+XCamReturn
+StitcherImpl::schedule_feature_match (
+    const SmartPtr<VideoBuffer> &left_buf,
+    const SmartPtr<VideoBuffer> &right_buf,
+    const uint32_t idx)
+{
+    XCAM_ASSERT (_fm_thread.ptr ());
+    const FMSchedulePolicy &policy = _stitcher->get_fm_schedule ();
+
+    {
+        SmartLock locker (_map_mutex);
+        Overlap &overlap = _overlaps[idx];
+        uint32_t count = overlap.fm_frame_count++;
+        uint32_t interval = (policy.mode == FMScheduleInterval ? policy.interval : 1) << _fm_interval_shift;
+        if (interval > 1 && count % interval != 0)
+            return XCAM_RETURN_BYPASS;
+
+        // previous match still running, drop this frame instead of queuing buffers
+        if (overlap.fm_pending)
+            return XCAM_RETURN_BYPASS;
+        overlap.fm_pending = true;
     }
 
-#if ENABLE_FEATURE_MATCH
-    //start feature match
-    if (cur_param.ptr ()) {
-        ret = feature_match (cur_param->in_buf, cur_param->in1_buf, idx);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
+    _fm_thread->push_request (new FMRequest (idx, left_buf, right_buf));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+StitcherImpl::run_feature_match (const SmartPtr<FMRequest> &req)
+{
+    const FMSchedulePolicy &policy = _stitcher->get_fm_schedule ();
+    uint32_t idx = req->idx;
+
+    bool match = true;
+    if (policy.mode == FMScheduleOnDiff) {
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (idx);
+        float diff = overlap_luma_diff (req->left_buf, overlap_info.left, req->right_buf, overlap_info.right);
+        match = diff > policy.diff_threshold;
     }
 
-    if (prev_param.ptr ()) {
-        ret = feature_match (prev_param->in_buf, prev_param->in1_buf, pre_idx);
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), pre_idx);
+    if (match) {
+        XCamReturn ret = feature_match (req->left_buf, req->right_buf, idx);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING (
+                "soft-stitcher:%s feature-match overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
+        }
+    }
+
+    SmartLock locker (_map_mutex);
+    _overlaps[idx].fm_pending = false;
+}
+
+XCamReturn
+StitcherImpl::start_single_blender (
+    const uint32_t idx,
+    const SmartPtr<BlenderParam> &param)
+{
+    // areas were set in init_config, pipelined frames read them at any time
+    SmartPtr<SoftBlender> blender = _overlaps[idx].blender;
+    return blender->execute_buffer (param, false);
+}
+
+XCamReturn
+StitcherImpl::start_blender (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx)
+{
+    const SmartPtr<SoftStitcher::StitcherParam> &param = run->stitch_param;
+    uint32_t next_idx = (idx + 1) % _stitcher->get_camera_num ();
+
+    SmartPtr<BlenderParam> blend_param = new BlenderParam (
+        idx, run->dewarp_bufs[idx], run->dewarp_bufs[next_idx], param->out_buf);
+    blend_param->stitch_param = param;
+    blend_param->run = run;
+    blend_param->node = node;
+    blend_param->deadline = param->deadline;
+
+    BlendReuse &reuse = _overlaps[idx].reuse;
+    if (reuse.is_enabled ()) {
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (idx);
+        if (reuse.try_reuse (
+                    blend_param->in_buf, overlap_info.left, blend_param->in1_buf, overlap_info.right,
+                    param->out_buf, overlap_info.out_area, blend_param->reuse_ticket)) {
+            // static inputs give nothing new to feature match either
+            XCAM_LOG_DEBUG ("soft-stitcher:%s overlap idx:%d reused", XCAM_STR (_stitcher->get_name ()), idx);
+            run->node_done (node, XCAM_RETURN_NO_ERROR);
+            return XCAM_RETURN_NO_ERROR;
+        }
     }
+
+    XCamReturn ret = start_single_blender (idx, blend_param);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s blend overlap idx:%d failed", XCAM_STR (_stitcher->get_name ()), idx);
+
+#if ENABLE_FEATURE_MATCH
+    //schedule feature match, done on fm thread
+    schedule_feature_match (blend_param->in_buf, blend_param->in1_buf, idx);
 #endif
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+StitcherImpl::keep_blend_result (const SmartPtr<BlenderParam> &param)
+{
+    BlendReuse &reuse = _overlaps[param->idx].reuse;
+    if (reuse.is_enabled ())
+        reuse.keep (param->out_buf, _stitcher->get_overlap (param->idx).out_area, param->reuse_ticket);
+}
+
 XCamReturn
 Copier::start_copy_task (
-    const SmartPtr<ImageHandler::Parameters> &param,
-    const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
+    const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, const SmartPtr<VideoBuffer> &buf)
 {
     XCAM_ASSERT (copy_task.ptr ());
 
-    SmartPtr<VideoBuffer> in_buf = buf, out_buf = param->out_buf;
+    SmartPtr<VideoBuffer> in_buf = buf, out_buf = run->stitch_param->out_buf;
     const VideoBufferInfo &in_info = in_buf->get_video_info ();
     const VideoBufferInfo &out_info = out_buf->get_video_info ();
 
-    SmartPtr<StitcherCopyArgs> args = new StitcherCopyArgs (idx, param);
+    SmartPtr<StitcherCopyArgs> args = new StitcherCopyArgs (copy_area.in_idx, run->stitch_param);
+    args->run = run;
+    args->node = node;
     args->in_luma = new UcharImage (
         in_buf, copy_area.in_area.width, copy_area.in_area.height, in_info.strides[0],
         in_info.offsets[0] + copy_area.in_area.pos_x + copy_area.in_area.pos_y * in_info.strides[0]);
@@ -705,32 +1309,19 @@ Copier::start_copy_task (
         out_buf, copy_area.out_area.width / 2, copy_area.out_area.height / 2, out_info.strides[0],
         out_info.offsets[1] + copy_area.out_area.pos_x + copy_area.out_area.pos_y / 2 * out_info.strides[1]);
 
-    uint32_t thread_x = 1, thread_y = 4;
-    WorkSize global_size (1, xcam_ceil (copy_area.in_area.height, 2) / 2);
-    WorkSize local_size (
-        xcam_ceil (global_size.value[0], thread_x) / thread_x,
-        xcam_ceil (global_size.value[1], thread_y) / thread_y);
-
-    copy_task->set_local_size (local_size);
-    copy_task->set_global_size (global_size);
-
     return copy_task->work (args);
 }
 
 XCamReturn
-StitcherImpl::start_copy_tasks (
-    const SmartPtr<SoftStitcher::StitcherParam> &param,
-    const uint32_t idx, const SmartPtr<VideoBuffer> &buf)
+StitcherImpl::start_copier (const SmartPtr<StitchRun> &run, TaskGraph::NodeId node, uint32_t idx)
 {
-    uint32_t size = _stitcher->get_copy_area ().size ();
-    for (uint32_t i = 0; i < size; ++i) {
-        if(_copiers[i].copy_area.in_idx == idx) {
-            XCamReturn ret = _copiers[i].start_copy_task (param, idx, buf);
-            XCAM_FAIL_RETURN (
-                ERROR, xcam_ret_is_ok (ret), ret,
-                "soft-stitcher:%s start copy task failed, idx:%d", XCAM_STR (_stitcher->get_name ()), idx);
-        }
-    }
+    XCAM_ASSERT (idx < _copiers.size ());
+    Copier &copier = _copiers[idx];
+
+    XCamReturn ret = copier.start_copy_task (run, node, run->dewarp_bufs[copier.copy_area.in_idx]);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s start copy task failed, idx:%d", XCAM_STR (_stitcher->get_name ()), copier.copy_area.in_idx);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -738,6 +1329,19 @@ StitcherImpl::start_copy_tasks (
 XCamReturn
 StitcherImpl::stop ()
 {
+    if (_bowl_thread.ptr ()) {
+        _bowl_thread->trigger_stop ();
+        _bowl_thread->stop ();
+        _bowl_thread.release ();
+    }
+    _bowl_ready = false;
+
+    if (_fm_thread.ptr ()) {
+        _fm_thread->trigger_stop ();
+        _fm_thread->stop ();
+        _fm_thread.release ();
+    }
+
     uint32_t cam_num = _stitcher->get_camera_num ();
     for (uint32_t i = 0; i < cam_num; ++i) {
         if (_fisheye[i].dewarp.ptr ()) {
@@ -752,6 +1356,12 @@ StitcherImpl::stop ()
             _overlaps[i].blender->terminate ();
             _overlaps[i].blender.release ();
         }
+        if (_overlaps[i].reuse.is_enabled ()) {
+            XCAM_LOG_INFO (
+                "soft-stitcher:%s overlap idx:%d blended %" PRIu64 " frames, reused %" PRIu64 " frames",
+                XCAM_STR (_stitcher->get_name ()), i,
+                _overlaps[i].reuse.get_blended_count (), _overlaps[i].reuse.get_reused_count ());
+        }
     }
 
     for (Copiers::iterator i_copy = _copiers.begin (); i_copy != _copiers.end (); ++i_copy) {
@@ -773,11 +1383,20 @@ StitcherImpl::stop ()
 SoftStitcher::SoftStitcher (const char *name)
     : SoftHandler (name)
     , Stitcher (SOFT_STITCHER_ALIGNMENT_X, SOFT_STITCHER_ALIGNMENT_Y)
+    , _fused_mode (false)
+    , _pipe_depth (1)
+    , _frame_budget (0)
 {
     SmartPtr<SoftSitcherPriv::StitcherImpl> impl = new SoftSitcherPriv::StitcherImpl (this);
     XCAM_ASSERT (impl.ptr ());
     _impl = impl;
 
+    // fewer feature matches are hardly seen, coarser blending comes next
+#if ENABLE_FEATURE_MATCH
+    add_quality_knob (new SoftSitcherPriv::FMCadenceKnob (impl.ptr ()));
+#endif
+    add_quality_knob (new SoftSitcherPriv::BlendLevelsKnob (impl.ptr ()));
+
 #if ENABLE_FEATURE_MATCH
 #ifndef ANDROID
     cv::ocl::setUseOpenCL (false);
@@ -796,6 +1415,9 @@ SoftStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuff
         ERROR, !in_bufs.empty (), XCAM_RETURN_ERROR_PARAM,
         "soft-stitcher:%s stitch buffer failed, in_bufs is empty", XCAM_STR (get_name ()));
 
+    // handlers of the stitcher are charged under it
+    MemoryOwnerScope mem_scope (get_name ());
+
     SmartPtr<StitcherParam> param = new StitcherParam;
     param->out_buf = out_buf;
     uint32_t count = 0;
@@ -805,45 +1427,148 @@ SoftStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuff
         param->in_bufs[count++] = buf;
     }
     param->in_buf_num = count;
-    XCamReturn ret = execute_buffer (param, true);
-    if (!out_buf.ptr () && xcam_ret_is_ok (ret)) {
-        out_buf = param->out_buf;
+    param->set_deadline_after (_frame_budget);
+
+    if (_pipe_depth <= 1) {
+        XCamReturn ret = execute_buffer (param, true);
+        if (!out_buf.ptr () && ret == XCAM_RETURN_NO_ERROR) {
+            out_buf = param->out_buf;
+        }
+        if (ret == XCAM_RETURN_NO_ERROR && out_buf.ptr ()) {
+            FrameLatencyMeta::carry (param->in_bufs[0], out_buf);
+            FrameLatencyMeta::stamp (out_buf, "stitch");
+        }
+        return ret;
     }
-    return ret;
+
+    XCamReturn ret = execute_buffer (param, false);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s stitch buffer failed in pipeline", XCAM_STR (get_name ()));
+
+    _pipe_params.push (param);
+    if (_pipe_params.size () < _pipe_depth) {
+        out_buf.release ();
+        return XCAM_RETURN_BYPASS;
+    }
+
+    return pop_queued_frame (out_buf);
+}
+
+bool
+SoftStitcher::set_pipeline_depth (uint32_t depth)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, depth > 0 && depth <= XCAM_SOFT_STITCHER_MAX_PIPE_DEPTH, false,
+        "soft-stitcher:%s set pipeline depth(%d) failed, range[1, %d]",
+        XCAM_STR (get_name ()), depth, XCAM_SOFT_STITCHER_MAX_PIPE_DEPTH);
+    XCAM_FAIL_RETURN (
+        ERROR, _need_configure, false,
+        "soft-stitcher:%s set pipeline depth failed, already configured", XCAM_STR (get_name ()));
+
+    _pipe_depth = depth;
+    return true;
 }
 
 XCamReturn
-SoftStitcher::terminate ()
+SoftStitcher::flush_buffers (SmartPtr<VideoBuffer> &out_buf)
 {
-    _impl->stop ();
-    return SoftHandler::terminate ();
+    // drop queued frames which missed deadline, until an output or empty
+    XCamReturn ret = XCAM_RETURN_BYPASS;
+    do {
+        ret = pop_queued_frame (out_buf);
+    } while (ret == XCAM_RETURN_BYPASS && !_pipe_params.is_empty ());
+
+    return ret;
 }
 
 XCamReturn
-SoftStitcher::start_task_count (const SmartPtr<SoftStitcher::StitcherParam> &param)
+SoftStitcher::flush_buffers (SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
 {
-    XCAM_ASSERT (param.ptr ());
-    XCAM_ASSERT (_impl.ptr ());
+    XCamReturn ret = flush_buffers (out_buf);
+    if (ret != XCAM_RETURN_NO_ERROR || !get_extra_output_count ()) {
+        extra_bufs.clear ();
+        return ret;
+    }
 
-    SmartLock locker (_impl->_map_mutex);
+    return scale_extra_outputs (out_buf, extra_bufs);
+}
 
+XCamReturn
+SoftStitcher::scale_extra_outputs (
+    const SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
+{
+    XCAM_ASSERT (out_buf.ptr ());
+
+    if (!_extra_scaler.ptr ()) {
+        const VideoBufferInfo &out_info = out_buf->get_video_info ();
+        SmartPtr<SoftScaler> scaler = new SoftScaler ("SoftStitcherExtraScaler");
+        XCAM_ASSERT (scaler.ptr ());
+
+        // box average keeps small outputs free of aliasing
+        bool area = true;
+        for (uint32_t i = 0; i < get_extra_output_count (); ++i) {
+            const OutputSize &size = get_extra_output_size (i);
+            uint32_t factor_x = out_info.width / size.width, factor_y = out_info.height / size.height;
+            if (!factor_x || !factor_y || factor_x * size.width != out_info.width ||
+                    factor_y * size.height != out_info.height ||
+                    factor_x > XCAM_SOFT_SCALER_MAX_AREA_FACTOR || factor_y > XCAM_SOFT_SCALER_MAX_AREA_FACTOR)
+                area = false;
+
+            if (!i)
+                scaler->set_output_size (size.width, size.height);
+            else
+                scaler->add_output (size.width, size.height);
+        }
+        scaler->set_mode (area ? SoftScaleArea : SoftScaleBilinear);
+        _extra_scaler = scaler;
+    }
+
+    XCamReturn ret = _extra_scaler->scale (out_buf, extra_bufs);
     XCAM_FAIL_RETURN (
-        ERROR, check_work_continue (param, XCAM_RETURN_NO_ERROR), XCAM_RETURN_ERROR_PARAM,
-        "soft-stitcher:%s start task count failed in work check", XCAM_STR (get_name ()));
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s scale extra outputs failed", XCAM_STR (get_name ()));
 
-    if (_impl->_task_counts.find (param.ptr ()) != _impl->_task_counts.end ()) {
-        XCAM_LOG_ERROR ("tasks already started, this should never happen.");
-        return XCAM_RETURN_ERROR_UNKNOWN;
-    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftStitcher::pop_queued_frame (SmartPtr<VideoBuffer> &out_buf)
+{
+    out_buf.release ();
+    if (_pipe_params.is_empty ())
+        return XCAM_RETURN_BYPASS;
 
-    int32_t count = get_camera_num ();
-    count += get_copy_area ().size ();
+    SmartPtr<StitcherParam> param = _pipe_params.pop ();
+    XCAM_ASSERT (param.ptr ());
 
-    XCAM_LOG_DEBUG ("stitcher :%s start task count :%d", XCAM_STR(get_name ()), count);
-    _impl->_task_counts.insert (std::make_pair((void*)param.ptr(), count));
+    XCamReturn ret = wait_work_done (param);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "soft-stitcher:%s stitch queued buffer failed", XCAM_STR (get_name ()));
+    if (ret == XCAM_RETURN_BYPASS) {
+        XCAM_LOG_DEBUG ("soft-stitcher:%s queued frame missed its deadline", XCAM_STR (get_name ()));
+        return ret;
+    }
+
+    out_buf = param->out_buf;
+    FrameLatencyMeta::carry (param->in_bufs[0], out_buf);
+    FrameLatencyMeta::stamp (out_buf, "stitch");
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+SoftStitcher::terminate ()
+{
+    _impl->stop ();
+    _pipe_params.clear ();
+    if (_extra_scaler.ptr ()) {
+        _extra_scaler->terminate ();
+        _extra_scaler.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
 void
 SoftStitcher::dewarp_done (
     const SmartPtr<ImageHandler> &handler,
@@ -852,26 +1577,18 @@ SoftStitcher::dewarp_done (
 {
     SmartPtr<SoftSitcherPriv::HandlerParam> dewarp_param = base.dynamic_cast_ptr<SoftSitcherPriv::HandlerParam> ();
     XCAM_ASSERT (dewarp_param.ptr ());
-    SmartPtr<SoftStitcher::StitcherParam> param = dewarp_param->stitch_param;
-    XCAM_ASSERT (param.ptr ());
+    SmartPtr<SoftSitcherPriv::StitchRun> run = dewarp_param->run;
+    XCAM_ASSERT (run.ptr ());
     XCAM_UNUSED (handler);
 
-    if (!check_work_continue (param, error))
-        return;
-
-    XCAM_LOG_INFO ("soft-stitcher:%s camera(idx:%d) dewarp done", XCAM_STR (get_name ()), dewarp_param->idx);
-    stitcher_dump_buf (dewarp_param->out_buf, dewarp_param->idx, "stitcher-dewarp");
-
-    //start both blender and feature match
-    XCamReturn ret = _impl->start_overlap_tasks (param, dewarp_param->idx, dewarp_param->out_buf);
-    if (!xcam_ret_is_ok (ret)) {
-        work_broken (param, ret);
+    if (xcam_ret_is_ok (error)) {
+        XCAM_LOG_INFO ("soft-stitcher:%s camera(idx:%d) dewarp done", XCAM_STR (get_name ()), dewarp_param->idx);
+        stitcher_dump_buf (dewarp_param->out_buf, dewarp_param->idx, "stitcher-dewarp");
+        run->dewarp_bufs[dewarp_param->idx] = dewarp_param->out_buf;
     }
 
-    ret = _impl->start_copy_tasks (param, dewarp_param->idx, dewarp_param->out_buf);
-    if (!xcam_ret_is_ok (ret)) {
-        work_broken (param, ret);
-    }
+    // blenders and copiers of this camera start once their inputs are all done
+    run->node_done (dewarp_param->node, error);
 }
 
 void
@@ -882,21 +1599,17 @@ SoftStitcher::blender_done (
 {
     SmartPtr<SoftSitcherPriv::BlenderParam> blender_param = base.dynamic_cast_ptr<SoftSitcherPriv::BlenderParam> ();
     XCAM_ASSERT (blender_param.ptr ());
-    SmartPtr<SoftStitcher::StitcherParam> param = blender_param->stitch_param;
-    XCAM_ASSERT (param.ptr ());
+    SmartPtr<SoftSitcherPriv::StitchRun> run = blender_param->run;
+    XCAM_ASSERT (run.ptr ());
     XCAM_UNUSED (handler);
 
-    if (!check_work_continue (param, error)) {
-        _impl->remove_task_count (param);
-        return;
+    if (xcam_ret_is_ok (error)) {
+        stitcher_dump_buf (blender_param->out_buf, blender_param->idx, "stitcher-blend");
+        _impl->keep_blend_result (blender_param);
+        XCAM_LOG_INFO ("blender:(%s) overlap:%d done", XCAM_STR (handler->get_name ()), blender_param->idx);
     }
 
-    stitcher_dump_buf (blender_param->out_buf, blender_param->idx, "stitcher-blend");
-    XCAM_LOG_INFO ("blender:(%s) overlap:%d done", XCAM_STR (handler->get_name ()), blender_param->idx);
-
-    if (_impl->dec_task_count (param) == 0) {
-        work_well_done (param, error);
-    }
+    run->node_done (blender_param->node, error);
 }
 
 void
@@ -909,19 +1622,13 @@ SoftStitcher::copy_task_done (
     XCAM_ASSERT (worker.ptr ());
     SmartPtr<SoftSitcherPriv::StitcherCopyArgs> args = base.dynamic_cast_ptr<SoftSitcherPriv::StitcherCopyArgs> ();
     XCAM_ASSERT (args.ptr ());
-    const SmartPtr<SoftStitcher::StitcherParam> param =
-        args->get_param ().dynamic_cast_ptr<SoftStitcher::StitcherParam> ();
-    XCAM_ASSERT (param.ptr ());
+    SmartPtr<SoftSitcherPriv::StitchRun> run = args->run;
+    XCAM_ASSERT (run.ptr ());
 
-    if (!check_work_continue (param, error)) {
-        _impl->remove_task_count (param);
-        return;
-    }
-    XCAM_LOG_INFO ("soft-stitcher:%s camera(idx:%d) copy done", XCAM_STR (get_name ()), args->idx);
+    if (xcam_ret_is_ok (error))
+        XCAM_LOG_INFO ("soft-stitcher:%s camera(idx:%d) copy done", XCAM_STR (get_name ()), args->idx);
 
-    if (_impl->dec_task_count (param) == 0) {
-        work_well_done (param, error);
-    }
+    run->node_done (args->node, error);
 }
 
 XCamReturn
@@ -992,15 +1699,14 @@ SoftStitcher::start_work (const SmartPtr<Parameters> &base)
         "soft_stitcher:%s start_work failed, params(in_buf_num) in_bufs are set",
         XCAM_STR (get_name ()));
 
-    XCamReturn ret = start_task_count (param);
     XCAM_FAIL_RETURN (
-        ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
-        "soft_stitcher:%s start blender count failed", XCAM_STR (get_name ()));
+        ERROR, check_work_continue (param, XCAM_RETURN_NO_ERROR), XCAM_RETURN_ERROR_PARAM,
+        "soft_stitcher:%s start_work failed in work check", XCAM_STR (get_name ()));
 
-    ret = _impl->start_dewarp_works (param);
+    XCamReturn ret = _impl->start_frame (param);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_PARAM,
-        "soft_stitcher:%s start dewarp works failed", XCAM_STR (get_name ()));
+        "soft_stitcher:%s start frame task graph failed", XCAM_STR (get_name ()));
 
     //for (uint32_t i = 0; i < param->in_buf_num; ++i) {
     //    param->in_bufs[i].release ();
@@ -1009,6 +1715,19 @@ SoftStitcher::start_work (const SmartPtr<Parameters> &base)
     return ret;
 }
 
+bool
+SoftStitcher::update_bowl_config (const BowlDataConfig &config)
+{
+    if (_need_configure)
+        return set_bowl_config (config);
+
+    XCamReturn ret = _impl->request_bowl_update (config);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), false,
+        "soft-stitcher:%s update bowl config failed", XCAM_STR (get_name ()));
+    return true;
+}
+
 SmartPtr<Stitcher>
 Stitcher::create_soft_stitcher ()
 {
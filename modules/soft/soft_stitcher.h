@@ -25,8 +25,12 @@
 #include <interface/stitcher.h>
 #include <soft/soft_handler.h>
 
+#define XCAM_SOFT_STITCHER_MAX_PIPE_DEPTH 3
+
 namespace XCam {
 
+class SoftScaler;
+
 namespace SoftSitcherPriv {
 class StitcherImpl;
 class CbGeoMap;
@@ -60,21 +64,76 @@ public:
     explicit SoftStitcher (const char *name = "SoftStitcher");
     ~SoftStitcher ();
 
+    // extra outputs version of Stitcher
+    using Stitcher::stitch_buffers;
+
+    // dewarp copy areas into output buffer directly, only overlap areas go through dewarp buffers.
+    // need be set before configure
+    void enable_fused_mode (bool enable) {
+        _fused_mode = enable;
+    }
+    bool is_fused_mode () const {
+        return _fused_mode;
+    }
+
+    // frames in flight, dewarp of next frames overlaps blending of previous ones.
+    // with depth > 1, stitch_buffers returns the output of the frame queued (depth - 1) calls before
+    // and XCAM_RETURN_BYPASS until pipeline is filled, out_buf of each queued frame must be empty or distinct.
+    // need be set before configure
+    bool set_pipeline_depth (uint32_t depth);
+    uint32_t get_pipeline_depth () const {
+        return _pipe_depth;
+    }
+    // get rest of queued outputs in order, return XCAM_RETURN_BYPASS when pipeline is empty
+    XCamReturn flush_buffers (SmartPtr<VideoBuffer> &out_buf);
+    // same with extra outputs of each flushed frame
+    XCamReturn flush_buffers (SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs);
+
+    // deadline of each frame from its stitch_buffers call, 0 means none.
+    // a frame missing it skips the rest of its work and returns XCAM_RETURN_BYPASS without output
+    void set_frame_budget (int64_t budget_us) {
+        _frame_budget = budget_us;
+    }
+    int64_t get_frame_budget () const {
+        return _frame_budget;
+    }
+
+    // derived from Stitcher, before configure it's same as set_bowl_config
+    virtual bool update_bowl_config (const BowlDataConfig &config);
+    // dewarps, blenders and copies outside the strip are left out of the task graph
+    virtual bool is_output_strip_supported () const {
+        return true;
+    }
+    // extra outputs are scaled by SoftScaler, area mode when all of them divide the output size
+    virtual bool is_extra_output_supported () const {
+        return true;
+    }
+    virtual bool is_feather_blend_supported () const {
+        return true;
+    }
+    // overlaps of static inputs copy their last blended result
+    virtual bool is_blend_reuse_supported () const {
+        return true;
+    }
+
     //derived from SoftHandler
     virtual XCamReturn terminate ();
 
 protected:
     // interface derive from Stitcher
     XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+    XCamReturn scale_extra_outputs (
+        const SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs);
 
     //derived from SoftHandler
     XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     XCamReturn start_work (const SmartPtr<Parameters> &param);
 
 private:
-    // handler done, call back functions
-    XCamReturn start_task_count (
-        const SmartPtr<SoftStitcher::StitcherParam> &param);
+    // wait the oldest queued frame, XCAM_RETURN_BYPASS if none or it missed deadline
+    XCamReturn pop_queued_frame (SmartPtr<VideoBuffer> &out_buf);
+
+    // handler done, call back functions, each completes its node of the frame's task graph run
     void dewarp_done (
         const SmartPtr<ImageHandler> &handler,
         const SmartPtr<ImageHandler::Parameters> &param, const XCamReturn error);
@@ -87,6 +146,11 @@ private:
 
 private:
     SmartPtr<SoftSitcherPriv::StitcherImpl> _impl;
+    bool                                    _fused_mode;
+    uint32_t                                _pipe_depth;
+    int64_t                                 _frame_budget;
+    SafeList<StitcherParam>                 _pipe_params;
+    SmartPtr<SoftScaler>                    _extra_scaler;
 };
 
 }
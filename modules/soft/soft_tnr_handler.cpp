@@ -0,0 +1,336 @@
+/*
+ * soft_tnr_handler.cpp - soft temporal noise reduction handler implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "soft_tnr_handler.h"
+#include "soft_worker.h"
+
+#define XCAM_SOFT_TNR_DEFAULT_LUMA_THRESHOLD 24
+#define XCAM_SOFT_TNR_DEFAULT_UV_THRESHOLD 16
+#define XCAM_SOFT_TNR_DEFAULT_STRENGTH 80
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+
+class TnrTask
+    : public SoftWorker
+{
+public:
+    struct Args : SoftArgs {
+        SmartPtr<UcharImage>         in_luma, out_luma;
+        SmartPtr<Uchar2Image>        in_uv, out_uv;
+        // oldest first
+        SmartPtr<UcharImage>         ref_luma[XCAM_SOFT_TNR_MAX_REFS];
+        SmartPtr<Uchar2Image>        ref_uv[XCAM_SOFT_TNR_MAX_REFS];
+        uint32_t                     ref_count;
+        uint8_t                      luma_threshold;
+        uint8_t                      uv_threshold;
+        uint8_t                      strength;
+
+        Args (const SmartPtr<ImageHandler::Parameters> &param)
+            : SoftArgs (param)
+            , ref_count (0)
+            , luma_threshold (0)
+            , uv_threshold (0)
+            , strength (0)
+        {}
+    };
+
+public:
+    explicit TnrTask (const SmartPtr<Worker::Callback> &cb)
+        : SoftWorker ("TnrTask", cb)
+    {}
+
+private:
+    virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
+};
+
+template <typename ImageT>
+static inline void
+blend_line (
+    const SmartPtr<ImageT> &in, const SmartPtr<ImageT> *refs, uint32_t ref_count,
+    const SmartPtr<ImageT> &out, uint32_t y, uint8_t threshold, uint8_t strength)
+{
+    const uint8_t *ref_rows[XCAM_SOFT_TNR_MAX_REFS];
+    for (uint32_t k = 0; k < ref_count; ++k)
+        ref_rows[k] = (const uint8_t *)refs[k]->get_buf_ptr (0, y);
+
+    soft_simd_tnr_blend (
+        (const uint8_t *)in->get_buf_ptr (0, y), ref_rows, ref_count,
+        in->get_width () * in->pixel_size (), threshold, strength,
+        (uint8_t *)out->get_buf_ptr (0, y));
+}
+
+XCamReturn
+TnrTask::work_range (const SmartPtr<Arguments> &base, const WorkRange &range)
+{
+    SmartPtr<TnrTask::Args> args = base.static_cast_ptr<TnrTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+    XCAM_ASSERT (args->in_luma.ptr () && args->in_uv.ptr ());
+    XCAM_ASSERT (args->out_luma.ptr () && args->out_uv.ptr ());
+
+    for (uint32_t y = range.pos[1]; y < range.pos[1] + range.pos_len[1]; ++y) {
+        uint32_t luma_y = y * 2;
+        blend_line<UcharImage> (
+            args->in_luma, args->ref_luma, args->ref_count, args->out_luma,
+            luma_y, args->luma_threshold, args->strength);
+        blend_line<UcharImage> (
+            args->in_luma, args->ref_luma, args->ref_count, args->out_luma,
+            luma_y + 1, args->luma_threshold, args->strength);
+        blend_line<Uchar2Image> (
+            args->in_uv, args->ref_uv, args->ref_count, args->out_uv,
+            y, args->uv_threshold, args->strength);
+    }
+
+    XCAM_LOG_DEBUG ("TnrTask work on range:[x:%d, width:%d, y:%d, height:%d]",
+                    range.pos[0], range.pos_len[0], range.pos[1], range.pos_len[1]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
+
+DECLARE_WORK_CALLBACK (CbTnrTask, SoftTnrHandler, tnr_task_done);
+
+SoftTnrHandler::SoftTnrHandler (const char *name)
+    : SoftHandler (name)
+    , _ref_count (1)
+    , _luma_threshold (XCAM_SOFT_TNR_DEFAULT_LUMA_THRESHOLD)
+    , _uv_threshold (XCAM_SOFT_TNR_DEFAULT_UV_THRESHOLD)
+    , _strength (XCAM_SOFT_TNR_DEFAULT_STRENGTH)
+    , _bands (XCAM_SOFT_TNR_DEFAULT_BANDS)
+{
+}
+
+SoftTnrHandler::~SoftTnrHandler ()
+{
+}
+
+bool
+SoftTnrHandler::set_reference_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, count && count <= XCAM_SOFT_TNR_MAX_REFS, false,
+        "SoftTnrHandler(%s) reference count(%d) must be in [1, %d]",
+        XCAM_STR (get_name ()), count, XCAM_SOFT_TNR_MAX_REFS);
+
+    // output pool was sized by the count at configure
+    XCAM_FAIL_RETURN (
+        ERROR, !_tnr_task.ptr () || count <= _ref_count, false,
+        "SoftTnrHandler(%s) reference count can't grow from %d to %d after configure",
+        XCAM_STR (get_name ()), _ref_count, count);
+
+    SmartLock locker (_refs_mutex);
+    _ref_count = count;
+    while (_refs.size () > _ref_count)
+        _refs.pop_back ();
+    return true;
+}
+
+bool
+SoftTnrHandler::set_strength (uint8_t strength)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, strength <= SOFT_TNR_MAX_STRENGTH, false,
+        "SoftTnrHandler(%s) strength(%d) must be no more than %d",
+        XCAM_STR (get_name ()), strength, SOFT_TNR_MAX_STRENGTH);
+
+    _strength = strength;
+    return true;
+}
+
+bool
+SoftTnrHandler::set_bands (uint32_t bands)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, bands, false,
+        "SoftTnrHandler(%s) bands must be more than 0", XCAM_STR (get_name ()));
+
+    _bands = bands;
+    return true;
+}
+
+void
+SoftTnrHandler::reset_references ()
+{
+    // tasks in flight hold their references until they finish
+    SmartLock locker (_refs_mutex);
+    _refs.clear ();
+}
+
+XCamReturn
+SoftTnrHandler::denoise (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out_buf)
+{
+    SmartPtr<ImageHandler::Parameters> param = new ImageHandler::Parameters (in, out_buf);
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+SoftTnrHandler::configure_resource (const SmartPtr<Parameters> &param)
+{
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "SoftTnrHandler(%s) only support format(NV12) but input format is %s",
+        XCAM_STR (get_name ()), xcam_fourcc_to_string (in_info.format));
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        in_info.format, in_info.width, in_info.height,
+        in_info.aligned_width, in_info.aligned_height);
+    set_out_video_info (out_info);
+
+    // outputs kept as references are not back in pool
+    if (_enable_allocator)
+        enable_allocator (true, _ref_count + XCAM_DEFAULT_HANDLER_BUF_CAP);
+
+    XCAM_ASSERT (!_tnr_task.ptr ());
+    _tnr_task = new XCamSoftTasks::TnrTask (new CbTnrTask (this));
+    XCAM_ASSERT (_tnr_task.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftTnrHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
+{
+    XCAM_ASSERT (_tnr_task.ptr ());
+    XCAM_ASSERT (param.ptr () && param->in_buf.ptr () && param->out_buf.ptr ());
+
+    const VideoBufferInfo &in_info = param->in_buf->get_video_info ();
+    const VideoBufferInfo &out_info = param->out_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        out_info.format == V4L2_PIX_FMT_NV12 &&
+        out_info.width == in_info.width && out_info.height == in_info.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "SoftTnrHandler(%s) output(%s %dx%d) must be the same as input(%s %dx%d)",
+        XCAM_STR (get_name ()),
+        xcam_fourcc_to_string (out_info.format), out_info.width, out_info.height,
+        xcam_fourcc_to_string (in_info.format), in_info.width, in_info.height);
+
+    SmartLock locker (_refs_mutex);
+
+    // references are outputs of earlier frames, a broken or skipped one drops the history
+    if (_last_param.ptr ()) {
+        XCamReturn last_ret = wait_work_done (_last_param);
+        _last_param.release ();
+        if (last_ret != XCAM_RETURN_NO_ERROR)
+            _refs.clear ();
+    }
+
+    SmartPtr<XCamSoftTasks::TnrTask::Args> args = new XCamSoftTasks::TnrTask::Args (param);
+    args->in_luma = new UcharImage (param->in_buf, 0);
+    args->in_uv = new Uchar2Image (param->in_buf, 1);
+    args->out_luma = new UcharImage (param->out_buf, 0);
+    args->out_uv = new Uchar2Image (param->out_buf, 1);
+    args->luma_threshold = _luma_threshold;
+    args->uv_threshold = _uv_threshold;
+    args->strength = _strength;
+
+    uint32_t count = XCAM_MIN ((uint32_t)_refs.size (), _ref_count);
+    std::list<SmartPtr<VideoBuffer> >::iterator i_ref = _refs.begin ();
+    for (uint32_t k = 0; k < count; ++k, ++i_ref) {
+        const VideoBufferInfo &ref_info = (*i_ref)->get_video_info ();
+        if (ref_info.width != in_info.width || ref_info.height != in_info.height) {
+            XCAM_LOG_INFO (
+                "SoftTnrHandler(%s) frame size changed to %dx%d, references dropped",
+                XCAM_STR (get_name ()), in_info.width, in_info.height);
+            _refs.clear ();
+            count = 0;
+            break;
+        }
+        args->ref_luma[count - 1 - k] = new UcharImage (*i_ref, 0);
+        args->ref_uv[count - 1 - k] = new Uchar2Image (*i_ref, 1);
+    }
+    args->ref_count = count;
+
+    uint32_t rows = xcam_ceil (args->in_luma->get_height (), 2) / 2;
+    WorkSize global_size (1, rows);
+    WorkSize local_size (1, xcam_ceil (rows, _bands) / _bands);
+    _tnr_task->set_local_size (local_size);
+    _tnr_task->set_global_size (global_size);
+
+    XCamReturn ret = _tnr_task->work (args);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "SoftTnrHandler(%s) start tnr task failed", XCAM_STR (get_name ()));
+
+    // a reused output buffer only stays once, as the newest reference
+    for (std::list<SmartPtr<VideoBuffer> >::iterator i = _refs.begin (); i != _refs.end (); ) {
+        if (i->ptr () == param->out_buf.ptr ())
+            i = _refs.erase (i);
+        else
+            ++i;
+    }
+    _refs.push_front (param->out_buf);
+    while (_refs.size () > _ref_count)
+        _refs.pop_back ();
+    _last_param = param;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SoftTnrHandler::terminate ()
+{
+    if (_tnr_task.ptr ()) {
+        _tnr_task->stop ();
+        _tnr_task.release ();
+    }
+    {
+        SmartLock locker (_refs_mutex);
+        _refs.clear ();
+        _last_param.release ();
+    }
+    return SoftHandler::terminate ();
+}
+
+void
+SoftTnrHandler::tnr_task_done (
+    const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &base, const XCamReturn error)
+{
+    XCAM_UNUSED (worker);
+    XCAM_ASSERT (worker.ptr () == _tnr_task.ptr ());
+
+    SmartPtr<XCamSoftTasks::TnrTask::Args> args = base.dynamic_cast_ptr<XCamSoftTasks::TnrTask::Args> ();
+    XCAM_ASSERT (args.ptr ());
+
+    const SmartPtr<ImageHandler::Parameters> param = args->get_param ();
+    if (!check_work_continue (param, error))
+        return;
+
+    work_well_done (param, error);
+}
+
+SmartPtr<SoftHandler> create_soft_tnr_handler ()
+{
+    SmartPtr<SoftHandler> tnr = new SoftTnrHandler ();
+    XCAM_ASSERT (tnr.ptr ());
+
+    return tnr;
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+ * soft_tnr_handler.h - soft temporal noise reduction handler class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SOFT_TNR_HANDLER_H
+#define XCAM_SOFT_TNR_HANDLER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <soft/soft_handler.h>
+#include <soft/soft_image.h>
+#include <list>
+
+#define XCAM_SOFT_TNR_MAX_REFS SOFT_TNR_MAX_REFS
+#define XCAM_SOFT_TNR_DEFAULT_BANDS 4
+
+namespace XCam {
+
+namespace XCamSoftTasks {
+class TnrTask;
+};
+
+/*
+ * SoftTnrHandler, motion-adaptive temporal denoise of NV12 frames.
+ * each pixel is blended with the same pixel of up to XCAM_SOFT_TNR_MAX_REFS earlier
+ * outputs, a reference is weighted less as it differs more and skipped once the
+ * difference reaches the plane threshold, so moving parts keep the current frame.
+ * references are previous output buffers, they must not be changed by the caller
+ * until the handler is done with them; with caller-provided outputs rotate at least
+ * reference-count + 1 buffers, reusing one output buffer works but keeps one reference.
+ * frames are processed in order, each waits for the previous one.
+ */
+class SoftTnrHandler
+    : public SoftHandler
+{
+public:
+    explicit SoftTnrHandler (const char *name = "SoftTnrHandler");
+    ~SoftTnrHandler ();
+
+    bool set_reference_count (uint32_t count);
+    uint32_t get_reference_count () const {
+        return _ref_count;
+    }
+    // difference at which a reference stops being blended, 0 disables the plane
+    void set_thresholds (uint8_t luma, uint8_t uv) {
+        _luma_threshold = luma;
+        _uv_threshold = uv;
+    }
+    // largest weight of one reference, SOFT_TNR_MAX_STRENGTH means reference only
+    bool set_strength (uint8_t strength);
+    // rows are split into @bands work items
+    bool set_bands (uint32_t bands);
+
+    // next frame starts without history, e.g. after scene cut or seek
+    void reset_references ();
+
+    XCamReturn denoise (const SmartPtr<VideoBuffer> &in, SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from SoftHandler
+    virtual XCamReturn terminate ();
+
+    void tnr_task_done (
+        const SmartPtr<Worker> &worker, const SmartPtr<Worker::Arguments> &args, const XCamReturn error);
+
+protected:
+    //derived from SoftHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    XCAM_DEAD_COPY (SoftTnrHandler);
+
+private:
+    SmartPtr<XCamSoftTasks::TnrTask>      _tnr_task;
+    uint32_t                              _ref_count;
+    uint8_t                               _luma_threshold;
+    uint8_t                               _uv_threshold;
+    uint8_t                               _strength;
+    uint32_t                              _bands;
+
+    // newest first, guarded with _last_param by _refs_mutex
+    Mutex                                 _refs_mutex;
+    std::list<SmartPtr<VideoBuffer> >     _refs;
+    SmartPtr<ImageHandler::Parameters>    _last_param;
+};
+
+extern SmartPtr<SoftHandler> create_soft_tnr_handler ();
+
+}
+
+#endif //XCAM_SOFT_TNR_HANDLER_H
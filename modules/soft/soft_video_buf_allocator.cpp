@@ -19,14 +19,96 @@
  */
 
 #include "soft_video_buf_allocator.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SOFT_BUF_ARENA_ALIGNMENT 64
+#define SOFT_BUF_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// from linux/mempolicy.h
+#define SOFT_BUF_MPOL_PREFERRED 1
 
 namespace XCam {
 
+static void
+bind_numa_node (void *ptr, size_t size, int32_t node)
+{
+#ifdef SYS_mbind
+    if (node < 0 || node >= (int32_t)(sizeof (unsigned long) * 8))
+        return;
+
+    unsigned long node_mask = 1UL << node;
+    if (syscall (SYS_mbind, ptr, size, SOFT_BUF_MPOL_PREFERRED, &node_mask, sizeof (node_mask) * 8, 0) != 0) {
+        XCAM_LOG_WARNING ("soft buffer bind to numa node:%d failed, errno:%d", node, errno);
+    }
+#else
+    XCAM_UNUSED (ptr);
+    XCAM_UNUSED (size);
+    XCAM_UNUSED (node);
+#endif
+}
+
+/*
+ * mapped memory returns its mapped size in @mapped_size,
+ * 0 means the memory came from heap.
+ */
+static uint8_t *
+alloc_soft_mem (size_t size, const SoftBufMemPolicy &policy, size_t &mapped_size)
+{
+    mapped_size = 0;
+    if (policy.mode == SoftBufMemShared) {
+        size_t map_size = XCAM_ALIGN_UP (size, (size_t)sysconf (_SC_PAGESIZE));
+        void *ptr = mmap (NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr != MAP_FAILED) {
+            bind_numa_node (ptr, map_size, policy.numa_node);
+            mapped_size = map_size;
+            return (uint8_t *)ptr;
+        }
+        XCAM_LOG_WARNING ("soft buffer map shared pages failed, errno:%d, fall back to heap", errno);
+    } else if (policy.mode == SoftBufMemHugePage) {
+        size_t map_size = XCAM_ALIGN_UP (size, (size_t)SOFT_BUF_HUGE_PAGE_SIZE);
+        void *ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+        ptr = mmap (NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (ptr == MAP_FAILED) {
+            ptr = mmap (NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (ptr != MAP_FAILED)
+                madvise (ptr, map_size, MADV_HUGEPAGE);
+#endif
+        }
+
+        if (ptr != MAP_FAILED) {
+            // pages are not touched yet, bind them before first use
+            bind_numa_node (ptr, map_size, policy.numa_node);
+            mapped_size = map_size;
+            return (uint8_t *)ptr;
+        }
+        XCAM_LOG_WARNING ("soft buffer map huge pages failed, errno:%d, fall back to heap", errno);
+    }
+
+    return xcam_malloc_type_array (uint8_t, size);
+}
+
+static void
+free_soft_mem (uint8_t *ptr, size_t mapped_size)
+{
+    if (!ptr)
+        return;
+
+    if (mapped_size)
+        munmap (ptr, mapped_size);
+    else
+        xcam_free (ptr);
+}
+
 class VideoMemData
     : public BufferData
 {
 public:
-    explicit VideoMemData (uint32_t size);
+    explicit VideoMemData (uint32_t size, const SoftBufMemPolicy &policy);
     virtual ~VideoMemData ();
     bool is_valid () const {
         return (_mem_ptr ? true : false);
@@ -39,21 +121,23 @@ public:
 private:
     uint8_t    *_mem_ptr;
     uint32_t    _mem_size;
+    size_t      _mapped_size;
 };
 
-VideoMemData::VideoMemData (uint32_t size)
+VideoMemData::VideoMemData (uint32_t size, const SoftBufMemPolicy &policy)
     : _mem_ptr (NULL)
     , _mem_size (0)
+    , _mapped_size (0)
 {
     XCAM_ASSERT (size > 0);
-    _mem_ptr = xcam_malloc_type_array (uint8_t, size);
+    _mem_ptr = alloc_soft_mem (size, policy, _mapped_size);
     if (_mem_ptr)
         _mem_size = size;
 }
 
 VideoMemData::~VideoMemData ()
 {
-    xcam_free (_mem_ptr);
+    free_soft_mem (_mem_ptr, _mapped_size);
 }
 
 uint8_t *
@@ -89,7 +173,7 @@ SoftVideoBufAllocator::allocate_data (const VideoBufferInfo &buffer_info)
         ERROR, buffer_info.size, NULL,
         "SoftVideoBufAllocator allocate data failed. buf_size is zero");
 
-    SmartPtr<VideoMemData> data = new VideoMemData (buffer_info.size);
+    SmartPtr<VideoMemData> data = new VideoMemData (buffer_info.size, _mem_policy);
     XCAM_FAIL_RETURN (
         ERROR, data.ptr () && data->is_valid (), NULL,
         "SoftVideoBufAllocator allocate data failed. buf_size:%d", buffer_info.size);
@@ -97,5 +181,124 @@ SoftVideoBufAllocator::allocate_data (const VideoBufferInfo &buffer_info)
     return data;
 }
 
+class ArenaMemData
+    : public BufferData
+{
+public:
+    explicit ArenaMemData (const SmartPtr<SoftBufArena> &arena, uint8_t *ptr)
+        : _arena (arena)
+        , _mem_ptr (ptr)
+    {}
+
+    //derive from BufferData
+    virtual uint8_t *map () {
+        return _mem_ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+
+private:
+    SmartPtr<SoftBufArena>    _arena;
+    uint8_t                  *_mem_ptr;
+};
+
+SoftBufArena::SoftBufArena ()
+    : _mem (NULL)
+    , _mapped_size (0)
+    , _base (NULL)
+    , _size (0)
+    , _used (0)
+{
+}
+
+SoftBufArena::~SoftBufArena ()
+{
+    free_soft_mem (_mem, _mapped_size);
+}
+
+size_t
+SoftBufArena::get_alignment () const
+{
+    if (_mem_policy.mode == SoftBufMemShared)
+        return (size_t)sysconf (_SC_PAGESIZE);
+    return SOFT_BUF_ARENA_ALIGNMENT;
 }
 
+bool
+SoftBufArena::request (const VideoBufferInfo &info, uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_mem, false,
+        "SoftBufArena request failed, arena already committed");
+    XCAM_FAIL_RETURN (
+        ERROR, info.size && count, false,
+        "SoftBufArena request failed, buf_size:%d, count:%d", info.size, count);
+
+    _size += XCAM_ALIGN_UP ((size_t)info.size, get_alignment ()) * count;
+    return true;
+}
+
+bool
+SoftBufArena::commit ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_mem && _size, false,
+        "SoftBufArena commit failed, committed:%s, size:%zu", _mem ? "yes" : "no", _size);
+
+    size_t alignment = get_alignment ();
+    _mem = alloc_soft_mem (_size + alignment, _mem_policy, _mapped_size);
+    XCAM_FAIL_RETURN (
+        ERROR, _mem, false,
+        "SoftBufArena commit failed, allocate size:%zu", _size);
+
+    _base = (uint8_t *)XCAM_ALIGN_UP ((uintptr_t)_mem, alignment);
+    _used = 0;
+    return true;
+}
+
+uint8_t *
+SoftBufArena::acquire (uint32_t size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _base, NULL,
+        "SoftBufArena acquire failed, arena was not committed");
+
+    size_t aligned_size = XCAM_ALIGN_UP ((size_t)size, get_alignment ());
+    XCAM_FAIL_RETURN (
+        ERROR, _used + aligned_size <= _size, NULL,
+        "SoftBufArena acquire failed, size:%d out of arena(used:%zu, size:%zu)", size, _used, _size);
+
+    uint8_t *ptr = _base + _used;
+    _used += aligned_size;
+    return ptr;
+}
+
+SoftArenaBufAllocator::SoftArenaBufAllocator (
+    const SmartPtr<SoftBufArena> &arena, const VideoBufferInfo &info)
+    : _arena (arena)
+{
+    XCAM_ASSERT (arena.ptr ());
+    set_video_info (info);
+}
+
+SoftArenaBufAllocator::~SoftArenaBufAllocator ()
+{
+}
+
+SmartPtr<BufferData>
+SoftArenaBufAllocator::allocate_data (const VideoBufferInfo &buffer_info)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, buffer_info.size, NULL,
+        "SoftArenaBufAllocator allocate data failed. buf_size is zero");
+
+    uint8_t *ptr = _arena->acquire (buffer_info.size);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr, NULL,
+        "SoftArenaBufAllocator allocate data failed. buf_size:%d", buffer_info.size);
+
+    return new ArenaMemData (_arena, ptr);
+}
+
+}
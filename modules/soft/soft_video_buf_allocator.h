@@ -26,6 +26,31 @@
 
 namespace XCam {
 
+enum SoftBufMemMode {
+    SoftBufMemHeap = 0,
+    SoftBufMemHugePage,
+    SoftBufMemShared,
+};
+
+/*
+ * backing memory of soft buffers.
+ * SoftBufMemHugePage maps explicit huge pages(MAP_HUGETLB) if the system reserved them,
+ * otherwise anonymous pages advised with MADV_HUGEPAGE; heap is the last fallback.
+ * SoftBufMemShared maps page aligned memory of whole pages, which GPUs sharing memory
+ * with CPU take as is, e.g. convert_to_clbuffer wraps it by CL_MEM_USE_HOST_PTR without copy.
+ * numa_node >= 0 prefers that node for mapped pages, pick the node of the CPUs
+ * running the workers which read the buffers.
+ */
+struct SoftBufMemPolicy {
+    SoftBufMemMode    mode;
+    int32_t           numa_node;
+
+    SoftBufMemPolicy (SoftBufMemMode m = SoftBufMemHeap, int32_t node = -1)
+        : mode (m)
+        , numa_node (node)
+    {}
+};
+
 class SoftVideoBufAllocator
     : public BufferPool
 {
@@ -34,9 +59,71 @@ public:
     explicit SoftVideoBufAllocator (const VideoBufferInfo &info);
     virtual ~SoftVideoBufAllocator ();
 
+    // set before reserve, applies to data allocated afterwards
+    void set_mem_policy (const SoftBufMemPolicy &policy) {
+        _mem_policy = policy;
+    }
+
 private:
     //derive from BufferPool
     virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
+
+private:
+    SoftBufMemPolicy          _mem_policy;
+};
+
+/*
+ * SoftBufArena, one contiguous memory block carved into buffers of several pools.
+ * request all buffers first, then commit to allocate the whole block,
+ * SoftArenaBufAllocator pools acquire their buffers from it in reserve.
+ * not thread-safe, layout and reserve need be done in configure.
+ */
+class SoftBufArena
+{
+public:
+    explicit SoftBufArena ();
+    ~SoftBufArena ();
+
+    // set before request, SoftBufMemShared aligns each buffer to pages
+    void set_mem_policy (const SoftBufMemPolicy &policy) {
+        _mem_policy = policy;
+    }
+
+    bool request (const VideoBufferInfo &info, uint32_t count);
+    bool commit ();
+    uint8_t *acquire (uint32_t size);
+
+    size_t get_size () const {
+        return _size;
+    }
+
+private:
+    size_t get_alignment () const;
+
+    XCAM_DEAD_COPY (SoftBufArena);
+
+private:
+    uint8_t            *_mem;
+    size_t              _mapped_size;
+    uint8_t            *_base;
+    size_t              _size;
+    size_t              _used;
+    SoftBufMemPolicy    _mem_policy;
+};
+
+class SoftArenaBufAllocator
+    : public BufferPool
+{
+public:
+    explicit SoftArenaBufAllocator (const SmartPtr<SoftBufArena> &arena, const VideoBufferInfo &info);
+    virtual ~SoftArenaBufAllocator ();
+
+private:
+    //derive from BufferPool
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
+
+private:
+    SmartPtr<SoftBufArena>    _arena;
 };
 
 #if 0
@@ -19,11 +19,121 @@
  */
 
 #include "soft_worker.h"
+#include "soft_handler.h"
 #include "thread_pool.h"
 #include "xcam_mutex.h"
+#include "xcam_trace.h"
+#include <algorithm>
+
+// idle worker threads poll this many pause loops before sleeping, items are tens of microseconds
+#define XCAM_SOFT_WORKER_SPINS 4096
+// longest wait for input rows still being captured, several frame intervals
+#define XCAM_SOFT_WORKER_ROWS_TIMEOUT 500000
 
 namespace XCam {
 
+// prefix sums of row costs, _prefix[y] is the cost of rows [0, y)
+class RowCost {
+public:
+    explicit RowCost (const std::vector<uint32_t> &cost)
+        : _prefix (cost.size () + 1, 0)
+    {
+        for (size_t i = 0; i < cost.size (); ++i)
+            _prefix[i + 1] = _prefix[i] + cost[i];
+    }
+    uint32_t get_rows () const {
+        return _prefix.size () - 1;
+    }
+    const std::vector<uint64_t> &get_prefix () const {
+        return _prefix;
+    }
+
+private:
+    XCAM_DEAD_COPY (RowCost);
+
+private:
+    std::vector<uint64_t>    _prefix;
+};
+
+class GuidedSched {
+public:
+    GuidedSched (uint32_t rows, uint32_t workers, const SmartPtr<RowCost> &cost)
+        : _next (0)
+        , _rows (rows)
+        , _workers (XCAM_MAX (workers, 1u))
+        , _cost (cost)
+    {}
+
+    bool next (uint32_t &start, uint32_t &len);
+
+private:
+    uint32_t band_end (uint32_t pos) const;
+
+    XCAM_DEAD_COPY (GuidedSched);
+
+private:
+    std::atomic<uint32_t>    _next;
+    uint32_t                 _rows;
+    uint32_t                 _workers;
+    SmartPtr<RowCost>        _cost;
+};
+
+uint32_t
+GuidedSched::band_end (uint32_t pos) const
+{
+    // half of the even share of remaining work, leaves later bands for balancing
+    if (!_cost.ptr ()) {
+        uint32_t len = XCAM_MAX ((_rows - pos) / (2 * _workers), 1u);
+        return pos + len;
+    }
+
+    const std::vector<uint64_t> &prefix = _cost->get_prefix ();
+    uint64_t remain = prefix[_rows] - prefix[pos];
+    uint64_t target = prefix[pos] + XCAM_MAX (remain / (2 * _workers), (uint64_t)1);
+    uint32_t end = std::lower_bound (prefix.begin () + pos + 1, prefix.end (), target) - prefix.begin ();
+    return XCAM_CLAMP (end, pos + 1, _rows);
+}
+
+bool
+GuidedSched::next (uint32_t &start, uint32_t &len)
+{
+    uint32_t pos = _next.load ();
+    uint32_t end = 0;
+    do {
+        if (pos >= _rows)
+            return false;
+        end = band_end (pos);
+    } while (!_next.compare_exchange_weak (pos, end));
+
+    start = pos;
+    len = end - pos;
+    return true;
+}
+
+static bool
+is_args_expired (const SmartPtr<Worker::Arguments> &args)
+{
+    SmartPtr<SoftArgs> soft_args = args.dynamic_cast_ptr<SoftArgs> ();
+    if (!soft_args.ptr () || !soft_args->get_param ().ptr ())
+        return false;
+
+    return soft_args->get_param ()->is_expired ();
+}
+
+// NULL unless input of @args is still being filled
+static SmartPtr<RowProgress>
+get_input_progress (const SmartPtr<Worker::Arguments> &args)
+{
+    SmartPtr<SoftArgs> soft_args = args.dynamic_cast_ptr<SoftArgs> ();
+    if (!soft_args.ptr ())
+        return NULL;
+
+    SmartPtr<RowProgress> progress = soft_args->get_in_progress ();
+    if (progress.ptr () && progress->is_complete ())
+        return NULL;
+    return progress;
+}
+
 class ItemSynch {
 private:
     mutable std::atomic<uint32_t>  _remain_items;
@@ -50,20 +160,34 @@ private:
     XCAM_DEAD_COPY (ItemSynch);
 };
 
+// counted by itself, so done can hand the item back to its worker for reuse
 class WorkItem
     : public ThreadPool::UserData
+    , public RefObj
 {
 public:
-    WorkItem (
+    WorkItem ()
+        : _frame_ts (InvalidTimestamp)
+    {
+    }
+    void reset (
         const SmartPtr<SoftWorker> &worker,
         const SmartPtr<Worker::Arguments> &args,
         const WorkSize &item,
-        SmartPtr<ItemSynch> &sync)
-        : _worker (worker)
-        , _args (args)
-        , _item (item)
-        , _sync (sync)
-    {
+        const WorkSize &global,
+        const WorkSize &local,
+        const SmartPtr<ItemSynch> &sync,
+        const SmartPtr<GuidedSched> &sched,
+        const SmartPtr<RowProgress> &progress) {
+        _worker = worker;
+        _args = args;
+        _item = item;
+        _global = global;
+        _local = local;
+        _sync = sync;
+        _sched = sched;
+        _progress = progress;
+        _frame_ts = Tracer::get_frame_ts ();
     }
     virtual XCamReturn run ();
     virtual void done (XCamReturn err);
@@ -73,7 +197,12 @@ private:
     SmartPtr<SoftWorker>         _worker;
     SmartPtr<Worker::Arguments>  _args;
     WorkSize                     _item;
+    WorkSize                     _global;
+    WorkSize                     _local;
     SmartPtr<ItemSynch>          _sync;
+    SmartPtr<GuidedSched>        _sched;
+    SmartPtr<RowProgress>        _progress;
+    int64_t                      _frame_ts;
 };
 
 XCamReturn
@@ -83,9 +212,37 @@ WorkItem::run ()
     if (!xcam_ret_is_ok (ret))
         return ret;
 
-    ret = _worker->work_impl (_args, _item);
-    if (!xcam_ret_is_ok (ret))
-        _sync->update_error (ret);
+    if (is_args_expired (_args))
+        return XCAM_RETURN_BYPASS;
+
+    XCAM_TRACE_SCOPE (_worker->get_name (), _frame_ts);
+    if (!_sched.ptr ()) {
+        WorkRange range = _worker->get_range (_item, _global, _local);
+        ret = _worker->wait_input_rows (_progress, _args, range);
+        if (xcam_ret_is_ok (ret))
+            ret = _worker->work_range (_args, range);
+        if (!xcam_ret_is_ok (ret))
+            _sync->update_error (ret);
+        return ret;
+    }
+
+    WorkRange range;
+    range.pos_len[0] = _global.value[0];
+    range.pos_len[2] = _global.value[2];
+    // bands are taken top down, so they follow rows being captured
+    while (_sched->next (range.pos[1], range.pos_len[1])) {
+        ret = _worker->wait_input_rows (_progress, _args, range);
+        if (xcam_ret_is_ok (ret))
+            ret = _worker->work_range (_args, range);
+        if (!xcam_ret_is_ok (ret)) {
+            _sync->update_error (ret);
+            break;
+        }
+        if (!xcam_ret_is_ok (_sync->get_error ()))
+            break;
+        if (is_args_expired (_args))
+            return XCAM_RETURN_BYPASS;
+    }
 
     return ret;
 }
@@ -93,22 +250,58 @@ WorkItem::run ()
 void
 WorkItem::done (XCamReturn err)
 {
-    if (_sync->dec () == 0) {
-        XCamReturn ret = _sync->get_error ();
-        if (xcam_ret_is_ok (ret))
+    SmartPtr<SoftWorker> worker = _worker;
+    SmartPtr<Worker::Arguments> args = _args;
+    SmartPtr<ItemSynch> sync = _sync;
+
+    // a free item must not keep worker, args or buffers alive
+    _worker.release ();
+    _args.release ();
+    _sync.release ();
+    _sched.release ();
+    _progress.release ();
+    worker->recycle_item (this);
+
+    if (sync->dec () == 0) {
+        XCamReturn ret = sync->get_error ();
+        if (ret == XCAM_RETURN_NO_ERROR)
             ret = err;
-        _worker->all_items_done (_args, ret);
+        worker->all_items_done (args, ret);
     }
 }
 
 SoftWorker::SoftWorker (const char *name, const SmartPtr<Callback> &cb)
     : Worker (name, cb)
     , _work_unit (1, 1, 1)
+    , _partition (PartitionStatic)
 {
 }
 
 SoftWorker::~SoftWorker ()
 {
+    _free_items.clear ();
+}
+
+SmartPtr<WorkItem>
+SoftWorker::get_free_item ()
+{
+    {
+        SmartLock locker (_items_mutex);
+        if (!_free_items.empty ()) {
+            SmartPtr<WorkItem> item = _free_items.back ();
+            _free_items.pop_back ();
+            return item;
+        }
+    }
+    return new WorkItem ();
+}
+
+void
+SoftWorker::recycle_item (const SmartPtr<WorkItem> &item)
+{
+    SmartLock locker (_items_mutex);
+    if (_free_items.size () < XCAM_SOFT_WORKER_MAX_FREE_ITEMS)
+        _free_items.push_back (item);
 }
 
 bool
@@ -124,6 +317,17 @@ SoftWorker::set_work_uint (uint32_t x, uint32_t y, uint32_t z)
     return true;
 }
 
+void
+SoftWorker::set_row_cost (const std::vector<uint32_t> &cost)
+{
+    SmartPtr<RowCost> row_cost;
+    if (!cost.empty ())
+        row_cost = new RowCost (cost);
+
+    SmartLock locker (_threads_mutex);
+    _row_cost = row_cost;
+}
+
 bool
 SoftWorker::set_threads (const SmartPtr<ThreadPool> &threads)
 {
@@ -144,10 +348,14 @@ SoftWorker::stop ()
 XCamReturn
 SoftWorker::work (const SmartPtr<Worker::Arguments> &args)
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    return work (args, get_global_size (), get_local_size ());
+}
 
-    const WorkSize &global = get_global_size ();
-    const WorkSize &local = get_local_size ();
+XCamReturn
+SoftWorker::work (const SmartPtr<Worker::Arguments> &args, const WorkSize &global, const WorkSize &local)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    XCAM_TRACE_SCOPE (get_name (), InvalidTimestamp);
 
     XCAM_ASSERT (local.value[0] * local.value[1] * local.value[2]);
     XCAM_ASSERT (global.value[0] * global.value[1] * global.value[2]);
@@ -164,43 +372,78 @@ SoftWorker::work (const SmartPtr<Worker::Arguments> &args)
         ERROR, max_items, XCAM_RETURN_ERROR_PARAM,
         "SoftWorker(%s) max item is zero. work failed.", XCAM_STR (get_name ()));
 
+    SmartPtr<RowProgress> progress = get_input_progress (args);
+
     if (max_items == 1) {
-        ret = work_impl (args, WorkSize(0, 0, 0));
+        if (is_args_expired (args))
+            ret = XCAM_RETURN_BYPASS;
+        else if (progress.ptr ())
+            ret = wait_input_rows (progress, args, get_range (WorkSize(0, 0, 0), global, local));
+        if (ret == XCAM_RETURN_NO_ERROR)
+            ret = work_range (args, get_range (WorkSize(0, 0, 0), global, local));
         status_check (args, ret);
         return ret;
     }
 
-    if (!_threads.ptr ()) {
-        char thr_name [XCAM_MAX_STR_SIZE];
-        snprintf (thr_name, XCAM_MAX_STR_SIZE, "%s-thrs", XCAM_STR(get_name ()));
-
-        SmartPtr<ThreadPool> threads = new ThreadPool (thr_name);
-        XCAM_ASSERT (threads.ptr ());
-        _threads = threads;
-        _threads->set_threads (max_items, max_items + 1); //extra thread to process all_items_done
-        ret = _threads->start ();
-        XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), ret,
-            "SoftWorker(%s) work failed when starting threads", XCAM_STR(get_name()));
+    SmartPtr<RowCost> row_cost;
+    {
+        // pipelined frames may call work at the same time
+        SmartLock locker (_threads_mutex);
+        row_cost = _row_cost;
+        if (!_threads.ptr ()) {
+            char thr_name [XCAM_MAX_STR_SIZE];
+            snprintf (thr_name, XCAM_MAX_STR_SIZE, "%s-thrs", XCAM_STR(get_name ()));
+
+            SmartPtr<ThreadPool> threads = new ThreadPool (thr_name);
+            XCAM_ASSERT (threads.ptr ());
+            threads->set_threads (max_items, max_items + 1); //extra thread to process all_items_done
+            threads->set_schedule_mode (ThreadPool::ScheduleWorkStealing);
+            threads->set_spin_count (XCAM_SOFT_WORKER_SPINS);
+            ret = threads->start ();
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (ret), ret,
+                "SoftWorker(%s) work failed when starting threads", XCAM_STR(get_name()));
+            _threads = threads;
+        }
     }
 
     SmartPtr<ItemSynch> sync = new ItemSynch (max_items);
-    for (uint32_t z = 0; z < items.value[2]; ++z)
-        for (uint32_t y = 0; y < items.value[1]; ++y)
-            for (uint32_t x = 0; x < items.value[0]; ++x)
-            {
-                SmartPtr<WorkItem> item = new WorkItem (this, args, WorkSize(x, y, z), sync);
-                ret = _threads->queue (item);
-                if (!xcam_ret_is_ok (ret)) {
-                    //consider half queued but half failed
-                    sync->update_error (ret);
-                    //status_check (args, ret); // need it here?
-                    XCAM_LOG_ERROR (
-                        "SoftWorker(%s) queue work item(x:%d y: %d z:%d) failed",
-                        XCAM_STR(get_name()), x, y, z);
-                    return ret;
+
+    // all items are queued at once, waking sleeping threads together
+    ThreadPool::UserDataList queued;
+
+    if (_partition == PartitionGuided && global.value[1] > 1) {
+        if (row_cost.ptr () && row_cost->get_rows () != global.value[1]) {
+            XCAM_LOG_DEBUG (
+                "SoftWorker(%s) row cost size:%d mismatches rows:%d, ignored",
+                XCAM_STR(get_name()), row_cost->get_rows (), global.value[1]);
+            row_cost.release ();
+        }
+
+        SmartPtr<GuidedSched> sched = new GuidedSched (global.value[1], max_items, row_cost);
+        for (uint32_t i = 0; i < max_items; ++i) {
+            SmartPtr<WorkItem> item = get_free_item ();
+            item->reset (this, args, WorkSize(i, 0, 0), global, local, sync, sched, progress);
+            queued.push_back (item);
+        }
+    } else {
+        for (uint32_t z = 0; z < items.value[2]; ++z)
+            for (uint32_t y = 0; y < items.value[1]; ++y)
+                for (uint32_t x = 0; x < items.value[0]; ++x)
+                {
+                    SmartPtr<WorkItem> item = get_free_item ();
+                    item->reset (this, args, WorkSize(x, y, z), global, local, sync, NULL, progress);
+                    queued.push_back (item);
                 }
-            }
+    }
+
+    ret = _threads->queue_many (queued);
+    if (!xcam_ret_is_ok (ret)) {
+        sync->update_error (ret);
+        XCAM_LOG_ERROR (
+            "SoftWorker(%s) queue %d work items failed", XCAM_STR(get_name()), (int)queued.size ());
+        return ret;
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -212,11 +455,9 @@ SoftWorker::all_items_done (const SmartPtr<Arguments> &args, XCamReturn error)
 }
 
 WorkRange
-SoftWorker::get_range (const WorkSize &item)
+SoftWorker::get_range (const WorkSize &item, const WorkSize &global, const WorkSize &local)
 {
     WorkRange range;
-    const WorkSize &global = get_global_size ();
-    const WorkSize &local = get_local_size ();
 
     for (uint32_t i = 0; i < WORK_MAX_DIM; ++i) {
         range.pos[i] = item.value[i] * local.value[i];
@@ -229,13 +470,6 @@ SoftWorker::get_range (const WorkSize &item)
     return range;
 }
 
-XCamReturn
-SoftWorker::work_impl (const SmartPtr<Arguments> &args, const WorkSize &item)
-{
-    WorkRange range = get_range (item);
-    return work_range (args, range);
-}
-
 XCamReturn
 SoftWorker::work_range (const SmartPtr<Arguments> &args, const WorkRange &range)
 {
@@ -256,6 +490,32 @@ SoftWorker::work_range (const SmartPtr<Arguments> &args, const WorkRange &range)
     return ret;
 }
 
+uint32_t
+SoftWorker::get_input_rows (const SmartPtr<Arguments> &, const WorkRange &)
+{
+    return UINT32_MAX;
+}
+
+XCamReturn
+SoftWorker::wait_input_rows (
+    const SmartPtr<RowProgress> &progress, const SmartPtr<Arguments> &args, const WorkRange &range)
+{
+    if (!progress.ptr ())
+        return XCAM_RETURN_NO_ERROR;
+
+    uint32_t rows = get_input_rows (args, range);
+    if (progress->get_rows () >= XCAM_MIN (rows, progress->get_total_rows ()))
+        return XCAM_RETURN_NO_ERROR;
+
+    XCAM_TRACE_SCOPE ("wait-rows", InvalidTimestamp);
+    XCamReturn ret = progress->wait (rows, XCAM_SOFT_WORKER_ROWS_TIMEOUT);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (ret), ret,
+        "SoftWorker(%s) waiting for input rows:%d of range(y:%d, height:%d) failed",
+        XCAM_STR (get_name ()), rows, range.pos[1], range.pos_len[1]);
+    return ret;
+}
+
 XCamReturn
 SoftWorker::work_unit (const SmartPtr<Arguments> &, const WorkSize &)
 {
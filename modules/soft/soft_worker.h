@@ -23,10 +23,18 @@
 
 #include <xcam_std.h>
 #include <worker.h>
+#include <xcam_mutex.h>
+#include <vector>
+
+// idle work items a worker keeps for reuse
+#define XCAM_SOFT_WORKER_MAX_FREE_ITEMS 64
 
 namespace XCam {
 
 class ThreadPool;
+class RowCost;
+class RowProgress;
+class WorkItem;
 
 struct WorkRange {
     uint32_t pos[WORK_MAX_DIM];
@@ -44,6 +52,18 @@ class SoftWorker
 {
     friend class WorkItem;
 
+public:
+    /*
+     * PartitionStatic, each work item runs its fixed local-size block.
+     * PartitionGuided, work items keep grabbing bands of global rows from a shared counter,
+     *   band size shrinks with the remaining work(guided self-scheduling),
+     *   so rows of uneven cost still finish together.
+     */
+    enum PartitionMode {
+        PartitionStatic = 0,
+        PartitionGuided,
+    };
+
 public:
     explicit SoftWorker (const char *name, const SmartPtr<Callback> &cb = NULL);
     virtual ~SoftWorker ();
@@ -55,24 +75,51 @@ public:
 
     bool set_threads (const SmartPtr<ThreadPool> &threads);
 
+    void set_partition_mode (PartitionMode mode) {
+        _partition = mode;
+    }
+    PartitionMode get_partition_mode () const {
+        return _partition;
+    }
+    // guided mode, relative cost of each global row, ignored if size mismatches; empty clears it
+    void set_row_cost (const std::vector<uint32_t> &cost);
+
     // derived from Worker
     virtual XCamReturn work (const SmartPtr<Arguments> &args);
     virtual XCamReturn stop ();
 
+    // sizes go with this call only, so pipelined frames can run one worker at different sizes
+    XCamReturn work (const SmartPtr<Arguments> &args, const WorkSize &global, const WorkSize &local);
+
 private:
     //new virtual functions
     virtual XCamReturn work_range (const SmartPtr<Arguments> &args, const WorkRange &range);
-    virtual WorkRange get_range (const WorkSize &item);
+    virtual WorkRange get_range (const WorkSize &item, const WorkSize &global, const WorkSize &local);
     virtual XCamReturn work_unit (const SmartPtr<Arguments> &args, const WorkSize &unit);
-
-    XCamReturn work_impl (const SmartPtr<Arguments> &args, const WorkSize &item);
+    /*
+     * input rows [0, n) read by @range, waited for on inputs still being captured(RowProgress),
+     * default is the whole input; workers reading inputs top down return less to start early.
+     */
+    virtual uint32_t get_input_rows (const SmartPtr<Arguments> &args, const WorkRange &range);
+
+    XCamReturn wait_input_rows (
+        const SmartPtr<RowProgress> &progress, const SmartPtr<Arguments> &args, const WorkRange &range);
     void all_items_done (const SmartPtr<Arguments> &args, XCamReturn error);
 
+    // items are recycled once done instead of allocated per dispatch
+    SmartPtr<WorkItem> get_free_item ();
+    void recycle_item (const SmartPtr<WorkItem> &item);
+
     XCAM_DEAD_COPY (SoftWorker);
 
 private:
     SmartPtr<ThreadPool>    _threads;
+    Mutex                   _threads_mutex;
     WorkSize                _work_unit;
+    PartitionMode           _partition;
+    SmartPtr<RowCost>       _row_cost;
+    std::vector<SmartPtr<WorkItem> >  _free_items;
+    Mutex                   _items_mutex;
 };
 
 }
@@ -0,0 +1,897 @@
+/*
+ * vk_blender.cpp - vulkan blender implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "xcam_utils.h"
+#include "vk_device.h"
+#include "vk_cmdbuf.h"
+#include "vk_worker.h"
+#include "vk_video_buf_allocator.h"
+#include "vk_blender.h"
+
+#define OVERLAP_POOL_SIZE 6
+#define LAP_POOL_SIZE 2
+
+#define GAUSS_RADIUS 2
+#define GAUSS_DIAMETER  ((GAUSS_RADIUS)*2+1)
+
+static const float gauss_coeffs[GAUSS_DIAMETER] = {0.152f, 0.222f, 0.252f, 0.222f, 0.152f};
+
+namespace XCam {
+
+namespace VKBlenderPriv {
+
+enum {
+    ShaderGaussScalePyr = 0,
+    ShaderLapTransPyr,
+    ShaderBlendPyr,
+    ShaderReconstructPyr,
+    ShaderCount
+};
+
+static const uint32_t shaders_binding_count[ShaderCount] = {4, 6, 7, 9};
+
+static const VKShaderInfo gauss_scale_shader_info (
+    "main",
+std::vector<uint32_t> {
+#include "shader_gauss_scale_pyr.comp.spv"
+});
+
+static const VKShaderInfo lap_trans_shader_info (
+    "main",
+std::vector<uint32_t> {
+#include "shader_lap_trans_pyr.comp.spv"
+});
+
+static const VKShaderInfo blend_shader_info (
+    "main",
+std::vector<uint32_t> {
+#include "shader_blend_pyr.comp.spv"
+});
+
+static const VKShaderInfo reconstruct_shader_info (
+    "main",
+std::vector<uint32_t> {
+#include "shader_reconstruct_pyr.comp.spv"
+});
+
+// push constants, same layout as PushConsts in shaders/spv/shader_*_pyr.comp
+struct GaussScaleProp {
+    uint32_t    in_img_width;
+    uint32_t    in_img_height;
+    uint32_t    in_offset_x;
+    uint32_t    out_img_width;
+    uint32_t    merge_width;
+};
+
+struct LapTransProp {
+    uint32_t    in_img_width;
+    uint32_t    in_img_height;
+    uint32_t    in_offset_x;
+    uint32_t    gaussscale_img_width;
+    uint32_t    gaussscale_img_height;
+    uint32_t    merge_width;
+};
+
+struct BlendProp {
+    uint32_t    in_img_width;
+};
+
+struct ReconstructProp {
+    uint32_t    lap_img_width;
+    uint32_t    lap_img_height;
+    uint32_t    out_img_width;
+    uint32_t    out_offset_x;
+    uint32_t    prev_blend_img_width;
+    uint32_t    prev_blend_img_height;
+};
+
+template <typename TProp>
+class PushConstsT
+    : public VKConstRange::VKPushConstArg
+{
+public:
+    PushConstsT (const TProp &prop)
+        : _prop (prop)
+    {}
+
+    bool get_const_data (VkPushConstantRange &range, void *& ptr) {
+        range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        range.offset = 0;
+        range.size = sizeof (_prop);
+        ptr = &_prop;
+        return true;
+    }
+
+private:
+    TProp    _prop;
+};
+
+struct PyramidLayer {
+    SmartPtr<BufferPool>       overlap_pool;
+    SmartPtr<VKWorker>         gauss_scale[VKBlender::BufIdxCount];
+    SmartPtr<VKWorker>         lap_trans[VKBlender::BufIdxCount];
+    SmartPtr<VKWorker>         reconstruct;
+
+    SmartPtr<VideoBuffer>      gauss_buf[VKBlender::BufIdxCount];
+    SmartPtr<VideoBuffer>      lap_buf[VKBlender::BufIdxCount];
+    // output of reconstruct, empty on level 0 which writes blender output
+    SmartPtr<VideoBuffer>      reconstruct_buf;
+
+    std::vector<uint8_t>       mask_data;
+    SmartPtr<VKBuffer>         coef_mask;
+};
+
+class BlenderPrivConfig {
+public:
+    PyramidLayer                  pyr_layer[XCAM_VK_PYRAMID_MAX_LEVEL];
+    uint32_t                      pyr_levels;
+
+    SmartPtr<VKWorker>            top_level_blend;
+    SmartPtr<VideoBuffer>         blend_buf;
+    SmartPtr<BufferPool>          first_lap_pool;
+    std::vector<uint8_t>          first_mask_data;
+    SmartPtr<VKBuffer>            first_mask;
+
+    VKDescriptor::BindingArray    layouts[ShaderCount];
+
+private:
+    VKBlender                    *_blender;
+
+public:
+    BlenderPrivConfig (VKBlender *blender, uint32_t level)
+        : pyr_levels (level)
+        , _blender (blender)
+    {}
+
+    XCamReturn init_layouts ();
+    XCamReturn init_first_masks (uint32_t width);
+    XCamReturn scale_down_masks (uint32_t level, uint32_t width);
+    XCamReturn init_buffers (const Rect &merge_size);
+    XCamReturn init_workers ();
+
+    XCamReturn record (const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VKBlender::BlenderParam> &param);
+    XCamReturn stop ();
+
+private:
+    SmartPtr<VKWorker> create_worker (
+        const char *name, uint32_t shader, const VKShaderInfo &info,
+        const SmartPtr<VKConstRange::VKPushConstArg> &push_const, const WorkSize &global);
+
+    XCamReturn record_gauss_scale (
+        const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &in_buf,
+        const Rect &merge_area, uint32_t level, VKBlender::BufIdx idx);
+    XCamReturn record_lap_trans (
+        const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &in_buf,
+        const Rect &merge_area, uint32_t level, VKBlender::BufIdx idx);
+    XCamReturn record_blend (const SmartPtr<VKCmdBuf> &cmdbuf);
+    XCamReturn record_reconstruct (
+        const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &out_buf, uint32_t level);
+};
+
+static bool
+add_nv12_bindings (
+    const VKDescriptor::BindingArray &layout, const SmartPtr<VideoBuffer> &buf,
+    VKDescriptor::SetBindInfoArray &bindings)
+{
+    SmartPtr<VKVideoBuffer> vk_buf = buf.dynamic_cast_ptr<VKVideoBuffer> ();
+    XCAM_FAIL_RETURN (
+        ERROR, vk_buf.ptr (), false,
+        "vk-blender buffer is not vk buffer");
+    XCAM_ASSERT (bindings.size () + 2 <= layout.size ());
+
+    const VideoBufferInfo &info = vk_buf->get_video_info ();
+    VKDescriptor::SetBindInfo bind;
+    bind.layout = layout[bindings.size ()];
+    bind.desc = VKBufDesc (vk_buf->get_vk_buf (), 0, info.offsets[1]);
+    bindings.push_back (bind);
+
+    bind.layout = layout[bindings.size ()];
+    bind.desc = VKBufDesc (vk_buf->get_vk_buf (), info.offsets[1], info.size - info.offsets[1]);
+    bindings.push_back (bind);
+
+    return true;
+}
+
+static void
+add_mask_binding (
+    const VKDescriptor::BindingArray &layout, const SmartPtr<VKBuffer> &mask,
+    VKDescriptor::SetBindInfoArray &bindings)
+{
+    XCAM_ASSERT (mask.ptr ());
+    XCAM_ASSERT (bindings.size () < layout.size ());
+
+    VKDescriptor::SetBindInfo bind;
+    bind.layout = layout[bindings.size ()];
+    bind.desc = VKBufDesc (mask);
+    bindings.push_back (bind);
+}
+
+static bool
+check_area_aligned (const Rect &area)
+{
+    return area.pos_y == 0 && area.width && area.height &&
+           area.pos_x % VK_BLENDER_ALIGN_X == 0 &&
+           area.width % VK_BLENDER_ALIGN_X == 0 &&
+           area.height % VK_BLENDER_ALIGN_Y == 0;
+}
+
+XCamReturn
+BlenderPrivConfig::init_layouts ()
+{
+    for (uint32_t i = 0; i < ShaderCount; ++i) {
+        layouts[i].clear ();
+        for (uint32_t j = 0; j < shaders_binding_count[i]; ++j) {
+            SmartPtr<VKDescriptor::SetLayoutBinding> binding =
+                new VKDescriptor::ComputeLayoutBinding (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, j);
+            layouts[i].push_back (binding);
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BlenderPrivConfig::init_first_masks (uint32_t width)
+{
+    XCAM_ASSERT (width && (width % VK_BLENDER_ALIGN_X == 0));
+
+    std::vector<float> gauss_table;
+    uint32_t quater = width / 4;
+    XCAM_ASSERT (quater > 1);
+
+    get_gauss_table (quater, (quater + 1) / 4.0f, gauss_table, false);
+    for (uint32_t i = 0; i < gauss_table.size (); ++i) {
+        float value = ((i < quater) ? (128.0f * (2.0f - gauss_table[i])) : (128.0f * gauss_table[i]));
+        value = XCAM_CLAMP (value, 0.0f, 255.0f);
+        gauss_table[i] = value;
+    }
+
+    first_mask_data.resize (width);
+    uint32_t gauss_start_pos = (width - gauss_table.size ()) / 2;
+    uint32_t idx = 0;
+    for (idx = 0; idx < gauss_start_pos; ++idx) {
+        first_mask_data[idx] = 255;
+    }
+    for (uint32_t i = 0; i < gauss_table.size (); ++idx, ++i) {
+        first_mask_data[idx] = (uint8_t) gauss_table[i];
+    }
+    for (; idx < width; ++idx) {
+        first_mask_data[idx] = 0;
+    }
+
+    first_mask = VKBuffer::create_buffer (
+        _blender->get_vk_device (), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, width, first_mask_data.data ());
+    XCAM_FAIL_RETURN (
+        ERROR, first_mask.ptr (), XCAM_RETURN_ERROR_MEM,
+        "vk-blender(%s) create first mask failed", XCAM_STR (_blender->get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BlenderPrivConfig::scale_down_masks (uint32_t level, uint32_t width)
+{
+    XCAM_ASSERT (width && (width % VK_BLENDER_ALIGN_X == 0));
+
+    const std::vector<uint8_t> &prev_data = (level == 0) ? first_mask_data : pyr_layer[level - 1].mask_data;
+    XCAM_ASSERT (!prev_data.empty ());
+
+    std::vector<uint8_t> &cur_data = pyr_layer[level].mask_data;
+    cur_data.resize (width);
+    for (uint32_t i = 0; i < width; ++i) {
+        int prev_start = i * 2 - 2;
+        float sum = 0.0f;
+
+        for (int j = 0; j < GAUSS_DIAMETER; ++j) {
+            int prev_idx = XCAM_CLAMP (prev_start + j, 0, (int)prev_data.size () - 1);
+            sum += prev_data[prev_idx] * gauss_coeffs[j];
+        }
+
+        cur_data[i] = XCAM_CLAMP (sum, 0.0f, 255.0f);
+    }
+
+    pyr_layer[level].coef_mask = VKBuffer::create_buffer (
+        _blender->get_vk_device (), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, width, cur_data.data ());
+    XCAM_FAIL_RETURN (
+        ERROR, pyr_layer[level].coef_mask.ptr (), XCAM_RETURN_ERROR_MEM,
+        "vk-blender(%s) create mask failed, level:%d", XCAM_STR (_blender->get_name ()), level);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static SmartPtr<BufferPool>
+create_overlap_pool (const SmartPtr<VKDevice> &dev, const Rect &size, uint32_t count)
+{
+    VideoBufferInfo info;
+    info.init (V4L2_PIX_FMT_NV12, size.width, size.height, size.width, size.height);
+
+    SmartPtr<BufferPool> pool = create_vk_buffer_pool (dev);
+    XCAM_ASSERT (pool.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, pool->set_video_info (info) && xcam_ret_is_ok (pool->reserve (count)), NULL,
+        "vk-blender reserve buffer pool failed, size:%dx%d", size.width, size.height);
+
+    return pool;
+}
+
+static bool
+get_buffers (const SmartPtr<BufferPool> &pool, SmartPtr<VideoBuffer> *bufs, uint32_t count)
+{
+    XCAM_ASSERT (pool.ptr ());
+    for (uint32_t i = 0; i < count; ++i) {
+        bufs[i] = pool->get_buffer ();
+        XCAM_FAIL_RETURN (ERROR, bufs[i].ptr (), false, "vk-blender get buffer from pool failed");
+    }
+
+    return true;
+}
+
+XCamReturn
+BlenderPrivConfig::init_buffers (const Rect &merge_size)
+{
+    const SmartPtr<VKDevice> &dev = _blender->get_vk_device ();
+
+    first_lap_pool = create_overlap_pool (dev, merge_size, LAP_POOL_SIZE);
+    XCAM_FAIL_RETURN (
+        ERROR, first_lap_pool.ptr (), XCAM_RETURN_ERROR_MEM,
+        "vk-blender(%s) create lap buffer pool failed", XCAM_STR (_blender->get_name ()));
+
+    XCamReturn ret = init_first_masks (merge_size.width);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) init first masks failed", XCAM_STR (_blender->get_name ()));
+
+    Rect size = merge_size;
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        size.width = XCAM_ALIGN_UP ((size.width + 1) / 2, VK_BLENDER_ALIGN_X);
+        size.height = XCAM_ALIGN_UP ((size.height + 1) / 2, VK_BLENDER_ALIGN_Y);
+
+        PyramidLayer &layer = pyr_layer[i];
+        layer.overlap_pool = create_overlap_pool (dev, size, OVERLAP_POOL_SIZE);
+        XCAM_FAIL_RETURN (
+            ERROR, layer.overlap_pool.ptr (), XCAM_RETURN_ERROR_MEM,
+            "vk-blender(%s) create overlap buffer pool failed, level:%d", XCAM_STR (_blender->get_name ()), i);
+
+        ret = scale_down_masks (i, size.width);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-blender(%s) scale down masks failed, level:%d", XCAM_STR (_blender->get_name ()), i);
+
+        const SmartPtr<BufferPool> &lap_pool = (i == 0) ? first_lap_pool : pyr_layer[i - 1].overlap_pool;
+        XCAM_FAIL_RETURN (
+            ERROR,
+            get_buffers (layer.overlap_pool, layer.gauss_buf, VKBlender::BufIdxCount) &&
+            get_buffers (lap_pool, layer.lap_buf, VKBlender::BufIdxCount) &&
+            (i == 0 || get_buffers (lap_pool, &layer.reconstruct_buf, 1)),
+            XCAM_RETURN_ERROR_MEM,
+            "vk-blender(%s) get pyramid buffers failed, level:%d", XCAM_STR (_blender->get_name ()), i);
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, get_buffers (pyr_layer[pyr_levels - 1].overlap_pool, &blend_buf, 1), XCAM_RETURN_ERROR_MEM,
+        "vk-blender(%s) get blend buffer failed", XCAM_STR (_blender->get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<VKWorker>
+BlenderPrivConfig::create_worker (
+    const char *name, uint32_t shader, const VKShaderInfo &info,
+    const SmartPtr<VKConstRange::VKPushConstArg> &push_const, const WorkSize &global)
+{
+    XCAM_ASSERT (shader < ShaderCount);
+
+    SmartPtr<VKWorker> worker = new VKWorker (_blender->get_vk_device (), name);
+    XCAM_ASSERT (worker.ptr ());
+    worker->set_global_size (global);
+
+    VKConstRange::VKPushConstArgs push_consts;
+    push_consts.push_back (push_const);
+    XCamReturn ret = worker->build (info, layouts[shader], push_consts);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), NULL,
+        "vk-blender(%s) build %s failed", XCAM_STR (_blender->get_name ()), XCAM_STR (name));
+
+    return worker;
+}
+
+#define CREATE_PYR_WORKER(worker, name, shader, info, Prop, global)                \
+    {                                                                               \
+        Prop prop;                                                                  \
+        xcam_mem_clear (prop);                                                      \
+        worker = create_worker (name, shader, info, new PushConstsT<Prop> (prop), global); \
+        XCAM_FAIL_RETURN (                                                          \
+            ERROR, worker.ptr (), XCAM_RETURN_ERROR_VULKAN,                         \
+            "vk-blender(%s) create %s worker failed", XCAM_STR (_blender->get_name ()), name); \
+    }
+
+XCamReturn
+BlenderPrivConfig::init_workers ()
+{
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        PyramidLayer &layer = pyr_layer[i];
+        const VideoBufferInfo &gs_info = layer.gauss_buf[VKBlender::Idx0]->get_video_info ();
+        const VideoBufferInfo &lap_info = layer.lap_buf[VKBlender::Idx0]->get_video_info ();
+
+        WorkSize gs_global (
+            XCAM_ALIGN_UP (gs_info.aligned_width / sizeof (uint32_t), 8) / 8,
+            XCAM_ALIGN_UP (gs_info.height, 16) / 16);
+        WorkSize lap_global (
+            XCAM_ALIGN_UP (lap_info.width / (sizeof (uint32_t) * 2), 8) / 8,
+            XCAM_ALIGN_UP (lap_info.height, 32) / 32);
+
+        for (uint32_t idx = 0; idx < VKBlender::BufIdxCount; ++idx) {
+            CREATE_PYR_WORKER (
+                layer.gauss_scale[idx], "vk-gauss-scale-pyr", ShaderGaussScalePyr,
+                gauss_scale_shader_info, GaussScaleProp, gs_global);
+            CREATE_PYR_WORKER (
+                layer.lap_trans[idx], "vk-lap-trans-pyr", ShaderLapTransPyr,
+                lap_trans_shader_info, LapTransProp, lap_global);
+        }
+        CREATE_PYR_WORKER (
+            layer.reconstruct, "vk-reconstruct-pyr", ShaderReconstructPyr,
+            reconstruct_shader_info, ReconstructProp, lap_global);
+    }
+
+    const VideoBufferInfo &top_info = blend_buf->get_video_info ();
+    WorkSize blend_global (
+        XCAM_ALIGN_UP (top_info.width / (sizeof (uint32_t) * 2), 8) / 8,
+        XCAM_ALIGN_UP (top_info.height, 16) / 16);
+    CREATE_PYR_WORKER (
+        top_level_blend, "vk-blend-pyr", ShaderBlendPyr,
+        blend_shader_info, BlendProp, blend_global);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BlenderPrivConfig::record_gauss_scale (
+    const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &in_buf,
+    const Rect &merge_area, uint32_t level, VKBlender::BufIdx idx)
+{
+    const SmartPtr<VideoBuffer> &out_buf = pyr_layer[level].gauss_buf[idx];
+    const VideoBufferInfo &in_info = in_buf->get_video_info ();
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        merge_area.pos_y == 0 && merge_area.height == (int32_t)in_info.height &&
+        merge_area.pos_x + merge_area.width <= (int32_t)in_info.width &&
+        merge_area.width <= (int32_t)out_info.width * 2 &&
+        merge_area.height <= (int32_t)out_info.height * 2,
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) gauss scale invalid buffer size: input:%dx%d, output:%dx%d, merge_area:%dx%d, level:%d idx:%d",
+        XCAM_STR (_blender->get_name ()), in_info.width, in_info.height, out_info.width, out_info.height,
+        merge_area.width, merge_area.height, level, (int)idx);
+
+    const uint32_t unit_bytes = sizeof (uint32_t);
+    GaussScaleProp prop;
+    prop.in_img_width = in_info.aligned_width / unit_bytes;
+    prop.in_img_height = in_info.height;
+    prop.in_offset_x = merge_area.pos_x / unit_bytes;
+    prop.out_img_width = out_info.aligned_width / unit_bytes;
+    prop.merge_width = merge_area.width / unit_bytes;
+
+    VKDescriptor::SetBindInfoArray bindings;
+    const VKDescriptor::BindingArray &layout = layouts[ShaderGaussScalePyr];
+    XCAM_FAIL_RETURN (
+        ERROR, add_nv12_bindings (layout, in_buf, bindings) && add_nv12_bindings (layout, out_buf, bindings),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) gauss scale bind buffers failed, level:%d idx:%d",
+        XCAM_STR (_blender->get_name ()), level, (int)idx);
+
+    SmartPtr<VKWorker::VKArguments> args = new VKWorker::VKArguments (bindings);
+    args->add_push_const (new PushConstsT<GaussScaleProp> (prop));
+    return pyr_layer[level].gauss_scale[idx]->record (cmdbuf, args);
+}
+
+XCamReturn
+BlenderPrivConfig::record_lap_trans (
+    const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &in_buf,
+    const Rect &merge_area, uint32_t level, VKBlender::BufIdx idx)
+{
+    const SmartPtr<VideoBuffer> &gs_buf = pyr_layer[level].gauss_buf[idx];
+    const SmartPtr<VideoBuffer> &out_buf = pyr_layer[level].lap_buf[idx];
+    const VideoBufferInfo &in_info = in_buf->get_video_info ();
+    const VideoBufferInfo &gs_info = gs_buf->get_video_info ();
+    const VideoBufferInfo &out_info = out_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        merge_area.width == (int32_t)out_info.width && merge_area.height == (int32_t)out_info.height &&
+        merge_area.width <= (int32_t)gs_info.width * 2 && merge_area.height <= (int32_t)gs_info.height * 2,
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) lap trans invalid buffer size: output:%dx%d, gaussscale:%dx%d, merge_area:%dx%d, level:%d idx:%d",
+        XCAM_STR (_blender->get_name ()), out_info.width, out_info.height, gs_info.width, gs_info.height,
+        merge_area.width, merge_area.height, level, (int)idx);
+
+    const uint32_t unit_bytes = sizeof (uint32_t) * 2;
+    LapTransProp prop;
+    prop.in_img_width = in_info.aligned_width / unit_bytes;
+    prop.in_img_height = in_info.height;
+    prop.in_offset_x = merge_area.pos_x / unit_bytes;
+    prop.gaussscale_img_width = gs_info.aligned_width / sizeof (uint32_t);
+    prop.gaussscale_img_height = gs_info.height;
+    prop.merge_width = merge_area.width / unit_bytes;
+
+    VKDescriptor::SetBindInfoArray bindings;
+    const VKDescriptor::BindingArray &layout = layouts[ShaderLapTransPyr];
+    XCAM_FAIL_RETURN (
+        ERROR,
+        add_nv12_bindings (layout, in_buf, bindings) &&
+        add_nv12_bindings (layout, gs_buf, bindings) &&
+        add_nv12_bindings (layout, out_buf, bindings),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) lap trans bind buffers failed, level:%d idx:%d",
+        XCAM_STR (_blender->get_name ()), level, (int)idx);
+
+    SmartPtr<VKWorker::VKArguments> args = new VKWorker::VKArguments (bindings);
+    args->add_push_const (new PushConstsT<LapTransProp> (prop));
+    return pyr_layer[level].lap_trans[idx]->record (cmdbuf, args);
+}
+
+XCamReturn
+BlenderPrivConfig::record_blend (const SmartPtr<VKCmdBuf> &cmdbuf)
+{
+    const PyramidLayer &top = pyr_layer[pyr_levels - 1];
+    XCAM_ASSERT (top.coef_mask.ptr ());
+
+    const VideoBufferInfo &info = blend_buf->get_video_info ();
+    BlendProp prop;
+    prop.in_img_width = info.aligned_width / (sizeof (uint32_t) * 2);
+
+    VKDescriptor::SetBindInfoArray bindings;
+    const VKDescriptor::BindingArray &layout = layouts[ShaderBlendPyr];
+    XCAM_FAIL_RETURN (
+        ERROR,
+        add_nv12_bindings (layout, top.gauss_buf[VKBlender::Idx0], bindings) &&
+        add_nv12_bindings (layout, top.gauss_buf[VKBlender::Idx1], bindings) &&
+        add_nv12_bindings (layout, blend_buf, bindings),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) blend bind buffers failed", XCAM_STR (_blender->get_name ()));
+    add_mask_binding (layout, top.coef_mask, bindings);
+
+    SmartPtr<VKWorker::VKArguments> args = new VKWorker::VKArguments (bindings);
+    args->add_push_const (new PushConstsT<BlendProp> (prop));
+    return top_level_blend->record (cmdbuf, args);
+}
+
+XCamReturn
+BlenderPrivConfig::record_reconstruct (
+    const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VideoBuffer> &out_buf, uint32_t level)
+{
+    const PyramidLayer &layer = pyr_layer[level];
+    const SmartPtr<VideoBuffer> &output = (level == 0) ? out_buf : layer.reconstruct_buf;
+    const SmartPtr<VideoBuffer> &prev_blend =
+        (level == pyr_levels - 1) ? blend_buf : pyr_layer[level + 1].reconstruct_buf;
+    const SmartPtr<VKBuffer> &mask = (level == 0) ? first_mask : pyr_layer[level - 1].coef_mask;
+    XCAM_ASSERT (output.ptr () && prev_blend.ptr () && mask.ptr ());
+
+    const VideoBufferInfo &lap_info = layer.lap_buf[VKBlender::Idx0]->get_video_info ();
+    const VideoBufferInfo &out_info = output->get_video_info ();
+    const VideoBufferInfo &prev_info = prev_blend->get_video_info ();
+    const Rect merge_area = (level == 0) ? _blender->get_merge_window () : Rect (0, 0, out_info.width, out_info.height);
+    XCAM_FAIL_RETURN (
+        ERROR,
+        merge_area.pos_y == 0 && merge_area.height == (int32_t)out_info.height &&
+        merge_area.pos_x + merge_area.width <= (int32_t)out_info.width &&
+        merge_area.width == (int32_t)lap_info.width && merge_area.height == (int32_t)lap_info.height &&
+        lap_info.width <= prev_info.width * 2 && lap_info.height <= prev_info.height * 2,
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) reconstruct invalid buffer size: lap:%dx%d, output:%dx%d, prev_blend:%dx%d, merge_area:%dx%d, level:%d",
+        XCAM_STR (_blender->get_name ()), lap_info.width, lap_info.height, out_info.width, out_info.height,
+        prev_info.width, prev_info.height, merge_area.width, merge_area.height, level);
+
+    const uint32_t unit_bytes = sizeof (uint32_t) * 2;
+    ReconstructProp prop;
+    prop.lap_img_width = lap_info.aligned_width / unit_bytes;
+    prop.lap_img_height = lap_info.height;
+    prop.out_img_width = out_info.aligned_width / unit_bytes;
+    prop.out_offset_x = merge_area.pos_x / unit_bytes;
+    prop.prev_blend_img_width = prev_info.aligned_width / sizeof (uint32_t);
+    prop.prev_blend_img_height = prev_info.height;
+
+    VKDescriptor::SetBindInfoArray bindings;
+    const VKDescriptor::BindingArray &layout = layouts[ShaderReconstructPyr];
+    XCAM_FAIL_RETURN (
+        ERROR,
+        add_nv12_bindings (layout, layer.lap_buf[VKBlender::Idx0], bindings) &&
+        add_nv12_bindings (layout, layer.lap_buf[VKBlender::Idx1], bindings) &&
+        add_nv12_bindings (layout, output, bindings) &&
+        add_nv12_bindings (layout, prev_blend, bindings),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) reconstruct bind buffers failed, level:%d", XCAM_STR (_blender->get_name ()), level);
+    add_mask_binding (layout, mask, bindings);
+
+    SmartPtr<VKWorker::VKArguments> args = new VKWorker::VKArguments (bindings);
+    args->add_push_const (new PushConstsT<ReconstructProp> (prop));
+    return layer.reconstruct->record (cmdbuf, args);
+}
+
+/*
+ * stages of all levels depend on the previous ones only through buffers,
+ * barriers are inserted between gauss scale levels, before blend and between reconstruct levels.
+ */
+XCamReturn
+BlenderPrivConfig::record (const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<VKBlender::BlenderParam> &param)
+{
+    XCAM_ASSERT (cmdbuf.ptr () && param.ptr ());
+
+    const SmartPtr<VideoBuffer> in_bufs[VKBlender::BufIdxCount] = {param->in_buf, param->in1_buf};
+    Rect areas[XCAM_VK_PYRAMID_MAX_LEVEL][VKBlender::BufIdxCount];
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    for (uint32_t level = 0; level < pyr_levels; ++level) {
+        for (uint32_t i = 0; i < VKBlender::BufIdxCount; ++i) {
+            VKBlender::BufIdx idx = (VKBlender::BufIdx)i;
+            const SmartPtr<VideoBuffer> &in_buf = (level == 0) ? in_bufs[idx] : pyr_layer[level - 1].gauss_buf[idx];
+
+            if (level == 0) {
+                areas[level][idx] = _blender->get_input_merge_area (idx);
+                XCAM_FAIL_RETURN (
+                    ERROR, check_area_aligned (areas[level][idx]), XCAM_RETURN_ERROR_PARAM,
+                    "vk-blender(%s) invalid input merge area, pos_x:%d, pos_y:%d, width:%d, height:%d, idx:%d",
+                    XCAM_STR (_blender->get_name ()), areas[level][idx].pos_x, areas[level][idx].pos_y,
+                    areas[level][idx].width, areas[level][idx].height, (int)idx);
+            } else {
+                const VideoBufferInfo &info = in_buf->get_video_info ();
+                areas[level][idx] = Rect (0, 0, info.width, info.height);
+            }
+
+            ret = record_gauss_scale (cmdbuf, in_buf, areas[level][idx], level, idx);
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (ret), ret,
+                "vk-blender(%s) record gauss scale failed, level:%d idx:%d",
+                XCAM_STR (_blender->get_name ()), level, (int)idx);
+        }
+        cmdbuf->insert_barrier ();
+    }
+
+    for (uint32_t level = 0; level < pyr_levels; ++level) {
+        for (uint32_t i = 0; i < VKBlender::BufIdxCount; ++i) {
+            VKBlender::BufIdx idx = (VKBlender::BufIdx)i;
+            const SmartPtr<VideoBuffer> &in_buf = (level == 0) ? in_bufs[idx] : pyr_layer[level - 1].gauss_buf[idx];
+
+            ret = record_lap_trans (cmdbuf, in_buf, areas[level][idx], level, idx);
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (ret), ret,
+                "vk-blender(%s) record laplace transformation failed, level:%d idx:%d",
+                XCAM_STR (_blender->get_name ()), level, (int)idx);
+        }
+    }
+
+    ret = record_blend (cmdbuf);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) record blend failed", XCAM_STR (_blender->get_name ()));
+
+    const Rect &window = _blender->get_merge_window ();
+    XCAM_FAIL_RETURN (
+        ERROR, check_area_aligned (window), XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) invalid output merge area, pos_x:%d, pos_y:%d, width:%d, height:%d",
+        XCAM_STR (_blender->get_name ()), window.pos_x, window.pos_y, window.width, window.height);
+
+    for (int level = pyr_levels - 1; level >= 0; --level) {
+        cmdbuf->insert_barrier ();
+        ret = record_reconstruct (cmdbuf, param->out_buf, level);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-blender(%s) record reconstruct failed, level:%d",
+            XCAM_STR (_blender->get_name ()), level);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BlenderPrivConfig::stop ()
+{
+    for (uint32_t i = 0; i < pyr_levels; ++i) {
+        PyramidLayer &layer = pyr_layer[i];
+        for (uint32_t idx = 0; idx < VKBlender::BufIdxCount; ++idx) {
+            layer.gauss_scale[idx].release ();
+            layer.lap_trans[idx].release ();
+            layer.gauss_buf[idx].release ();
+            layer.lap_buf[idx].release ();
+        }
+        layer.reconstruct.release ();
+        layer.reconstruct_buf.release ();
+
+        if (layer.overlap_pool.ptr ()) {
+            layer.overlap_pool->stop ();
+        }
+    }
+
+    top_level_blend.release ();
+    blend_buf.release ();
+    if (first_lap_pool.ptr ()) {
+        first_lap_pool->stop ();
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+};
+
+VKBlender::VKBlender (const SmartPtr<VKDevice> dev, const char *name)
+    : VKHandler (dev, name)
+    , Blender (VK_BLENDER_ALIGN_X, VK_BLENDER_ALIGN_Y)
+{
+    SmartPtr<VKBlenderPriv::BlenderPrivConfig> config =
+        new VKBlenderPriv::BlenderPrivConfig (this, XCAM_VK_PYRAMID_DEFAULT_LEVEL);
+    XCAM_ASSERT (config.ptr ());
+    _priv_config = config;
+}
+
+VKBlender::~VKBlender ()
+{
+}
+
+XCamReturn
+VKBlender::terminate ()
+{
+    _priv_config->stop ();
+    return VKHandler::terminate ();
+}
+
+XCamReturn
+VKBlender::blend (
+    const SmartPtr<VideoBuffer> &in0,
+    const SmartPtr<VideoBuffer> &in1,
+    SmartPtr<VideoBuffer> &out_buf)
+{
+    XCAM_ASSERT (in0.ptr () && in1.ptr ());
+
+    SmartPtr<BlenderParam> param = new BlenderParam (in0, in1, out_buf);
+    XCAM_ASSERT (param.ptr ());
+
+    XCamReturn ret = execute_buffer (param, true);
+    if (xcam_ret_is_ok (ret) && !out_buf.ptr ()) {
+        out_buf = param->out_buf;
+    }
+
+    return ret;
+}
+
+XCamReturn
+VKBlender::configure_resource (const SmartPtr<Parameters> &param)
+{
+    XCAM_ASSERT (param.ptr () && param->in_buf.ptr ());
+    XCAM_ASSERT (_priv_config->pyr_levels <= XCAM_VK_PYRAMID_MAX_LEVEL);
+
+    const VideoBufferInfo &in0_info = param->in_buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, in0_info.format == V4L2_PIX_FMT_NV12, XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) only support NV12 format, but input format is %s",
+        XCAM_STR(get_name ()), xcam_fourcc_to_string (in0_info.format));
+
+    Rect in0_area, in1_area, out_area;
+    in0_area = get_input_merge_area (Idx0);
+    in1_area = get_input_merge_area (Idx1);
+    out_area = get_merge_window ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        in0_area.width && in0_area.height &&
+        in0_area.width == in1_area.width && in0_area.height == in1_area.height &&
+        in0_area.width == out_area.width && in0_area.height == out_area.height,
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) invalid input/output overlap area, input0:%dx%d, input1:%dx%d, output:%dx%d",
+        XCAM_STR(get_name ()), in0_area.width, in0_area.height,
+        in1_area.width, in1_area.height, out_area.width, out_area.height);
+
+    uint32_t out_width, out_height;
+    get_output_size (out_width, out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, out_width && out_height, XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) invalid output size, output size:%dx%d",
+        XCAM_STR(get_name ()), out_width, out_height);
+
+    VideoBufferInfo out_info;
+    out_info.init (
+        in0_info.format, out_width, out_height,
+        XCAM_ALIGN_UP (out_width, VK_BLENDER_ALIGN_X), XCAM_ALIGN_UP (out_height, VK_BLENDER_ALIGN_Y));
+    set_out_video_info (out_info);
+
+    Rect merge_size = get_merge_window ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        merge_size.width && merge_size.height &&
+        merge_size.width % VK_BLENDER_ALIGN_X == 0 &&
+        merge_size.height % VK_BLENDER_ALIGN_Y == 0,
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) invalid merge size, width:%d, height:%d",
+        XCAM_STR (get_name ()), merge_size.width, merge_size.height);
+
+    XCamReturn ret = _priv_config->init_layouts ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) init binding layouts failed", XCAM_STR (get_name ()));
+
+    ret = _priv_config->init_buffers (merge_size);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) init pyramid buffers failed", XCAM_STR (get_name ()));
+
+    ret = _priv_config->init_workers ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) init pyramid workers failed", XCAM_STR (get_name ()));
+
+    if (!get_record_cmdbuf ().ptr ()) {
+        _batch = new VKWorkerBatch (get_vk_device ());
+        ret = _batch->init ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-blender(%s) init worker batch failed", XCAM_STR (get_name ()));
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKBlender::start_work (const SmartPtr<ImageHandler::Parameters> &base)
+{
+    XCAM_ASSERT (base.ptr ());
+    SmartPtr<BlenderParam> param = base.dynamic_cast_ptr<BlenderParam> ();
+    XCAM_FAIL_RETURN (
+        ERROR,
+        param.ptr () && param->in_buf.ptr () && param->in1_buf.ptr () && param->out_buf.ptr (),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-blender(%s) start work failed, invalid parameters", XCAM_STR (get_name ()));
+
+    const SmartPtr<VKCmdBuf> &record_cmdbuf = get_record_cmdbuf ();
+    if (record_cmdbuf.ptr ())
+        return _priv_config->record (record_cmdbuf, param);
+
+    XCAM_ASSERT (_batch.ptr ());
+    XCamReturn ret = _batch->begin ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) begin worker batch failed", XCAM_STR (get_name ()));
+
+    ret = _priv_config->record (_batch->get_cmdbuf (), param);
+    if (!xcam_ret_is_ok (ret)) {
+        _batch->discard ();
+        XCAM_LOG_ERROR ("vk-blender(%s) record pyramid failed", XCAM_STR (get_name ()));
+        return ret;
+    }
+
+    ret = _batch->submit_and_wait ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-blender(%s) submit worker batch failed", XCAM_STR (get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<VKHandler>
+create_vk_blender (const SmartPtr<VKDevice> &dev)
+{
+    SmartPtr<VKBlender> blender = new VKBlender (dev);
+    XCAM_ASSERT (blender.ptr ());
+    return blender;
+}
+
+SmartPtr<Blender>
+Blender::create_vk_blender ()
+{
+    SmartPtr<VKHandler> handler = XCam::create_vk_blender (VKDevice::default_device ());
+    return handler.dynamic_cast_ptr<Blender> ();
+}
+
+}
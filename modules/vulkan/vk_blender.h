@@ -0,0 +1,96 @@
+/*
+ * vk_blender.h - vulkan blender class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_VK_BLENDER_H
+#define XCAM_VK_BLENDER_H
+
+#include <interface/blender.h>
+#include <vulkan/vulkan_std.h>
+#include <vulkan/vk_handler.h>
+
+#define XCAM_VK_PYRAMID_MAX_LEVEL 4
+#define XCAM_VK_PYRAMID_DEFAULT_LEVEL 3
+
+#define VK_BLENDER_ALIGN_X 8
+#define VK_BLENDER_ALIGN_Y 4
+
+namespace XCam {
+
+class VKWorkerBatch;
+
+namespace VKBlenderPriv {
+class BlenderPrivConfig;
+};
+
+/*
+ * pyramid blender, gauss scale, laplace transform, top level blend and reconstruct
+ * are recorded into one command buffer, see VKHandler::set_record_cmdbuf.
+ */
+class VKBlender
+    : public VKHandler, public Blender
+{
+    friend class VKBlenderPriv::BlenderPrivConfig;
+
+public:
+    struct BlenderParam : ImageHandler::Parameters {
+        SmartPtr<VideoBuffer> in1_buf;
+
+        BlenderParam (
+            const SmartPtr<VideoBuffer> &in0,
+            const SmartPtr<VideoBuffer> &in1,
+            const SmartPtr<VideoBuffer> &out)
+            : Parameters (in0, out)
+            , in1_buf (in1)
+        {}
+    };
+
+    enum BufIdx {
+        Idx0 = 0,
+        Idx1,
+        BufIdxCount
+    };
+
+public:
+    explicit VKBlender (const SmartPtr<VKDevice> dev, const char *name = "VKBlender");
+    ~VKBlender ();
+
+    //derived from VKHandler
+    virtual XCamReturn terminate ();
+
+protected:
+    //derived from Blender interface
+    XCamReturn blend (
+        const SmartPtr<VideoBuffer> &in0,
+        const SmartPtr<VideoBuffer> &in1,
+        SmartPtr<VideoBuffer> &out_buf);
+
+    //derived from VKHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    SmartPtr<VKBlenderPriv::BlenderPrivConfig>    _priv_config;
+    SmartPtr<VKWorkerBatch>                       _batch;
+};
+
+extern SmartPtr<VKHandler> create_vk_blender (const SmartPtr<VKDevice> &dev);
+}
+
+#endif // XCAM_VK_BLENDER_H
@@ -134,6 +134,18 @@ VKCmdBuf::DispatchParam::fill_cmd_buf (VKCmdBuf &buf)
 
 XCamReturn
 VKCmdBuf::record (const SmartPtr<DispatchParam> param)
+{
+    XCamReturn ret = begin ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "VKCmdBuf record failed when begin");
+
+    ret = record_dispatch (param);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "VKCmdBuf record failed when dispatch");
+
+    return end ();
+}
+
+XCamReturn
+VKCmdBuf::begin ()
 {
     VkCommandBufferBeginInfo buf_begin_info = {};
     buf_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -145,15 +157,89 @@ VKCmdBuf::record (const SmartPtr<DispatchParam> param)
         ERROR, vkBeginCommandBuffer (_cmd_buf_id, &buf_begin_info),
         XCAM_RETURN_ERROR_VULKAN, "VKCmdBuf begin command buffer failed");
 
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKCmdBuf::record_dispatch (const SmartPtr<DispatchParam> param)
+{
+    XCAM_ASSERT (param.ptr ());
+
     XCamReturn ret = param->fill_cmd_buf (*this);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret),
         ret, "VKCmdBuf dispatch params failed");
 
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static VkAccessFlags
+get_stage_access (VkPipelineStageFlags stage, bool write)
+{
+    VkAccessFlags access = 0;
+    if (stage & VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+        access |= write ? VK_ACCESS_SHADER_WRITE_BIT : (VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    if (stage & VK_PIPELINE_STAGE_TRANSFER_BIT)
+        access |= write ? VK_ACCESS_TRANSFER_WRITE_BIT : (VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    if (stage & VK_PIPELINE_STAGE_HOST_BIT)
+        access |= write ? VK_ACCESS_HOST_WRITE_BIT : VK_ACCESS_HOST_READ_BIT;
+    return access;
+}
+
+XCamReturn
+VKCmdBuf::insert_barrier (VkPipelineStageFlags dst_stage, VkPipelineStageFlags src_stage)
+{
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = get_stage_access (src_stage, true);
+    barrier.dstAccessMask = get_stage_access (dst_stage, false);
+
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_cmd_buf_id));
+    vkCmdPipelineBarrier (
+        _cmd_buf_id, src_stage, dst_stage,
+        0, 1, &barrier, 0, NULL, 0, NULL);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKCmdBuf::end ()
+{
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_cmd_buf_id));
     XCAM_VK_CHECK_RETURN (
         ERROR, vkEndCommandBuffer (_cmd_buf_id),
-        XCAM_RETURN_ERROR_VULKAN, "VKCmdBuf begin command buffer failed");
+        XCAM_RETURN_ERROR_VULKAN, "VKCmdBuf end command buffer failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
 
+XCamReturn
+VKCmdBuf::record_copy (const SmartPtr<VKBuffer> &src, const SmartPtr<VKBuffer> &dst, VkDeviceSize size)
+{
+    XCAM_ASSERT (src.ptr () && dst.ptr ());
+    XCamReturn ret = begin ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "VKCmdBuf record copy failed when begin");
+
+    VkBufferCopy region = {};
+    region.srcOffset = 0;
+    region.dstOffset = 0;
+    region.size = size;
+    vkCmdCopyBuffer (_cmd_buf_id, src->get_buf_id (), dst->get_buf_id (), 1, &region);
+
+    return end ();
+}
+
+XCamReturn
+VKCmdBuf::record_copy_regions (
+    const SmartPtr<VKBuffer> &src, const SmartPtr<VKBuffer> &dst, const std::vector<VkBufferCopy> &regions)
+{
+    XCAM_ASSERT (src.ptr () && dst.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !regions.empty (), XCAM_RETURN_ERROR_PARAM,
+        "VKCmdBuf record copy regions failed, regions are empty");
+
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_cmd_buf_id));
+    vkCmdCopyBuffer (_cmd_buf_id, src->get_buf_id (), dst->get_buf_id (), regions.size (), &regions[0]);
     return XCAM_RETURN_NO_ERROR;
 }
 
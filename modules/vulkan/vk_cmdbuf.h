@@ -86,9 +86,24 @@ public:
 
     XCamReturn record (const SmartPtr<DispatchParam> param);
 
+    // record several dispatches into one buffer, begin () ... end ()
+    XCamReturn begin ();
+    XCamReturn record_dispatch (const SmartPtr<DispatchParam> param);
+    // @dst_stage sees writes of @src_stage, stages of compute shader, transfer or host
+    XCamReturn insert_barrier (
+        VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VkPipelineStageFlags src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    XCamReturn end ();
+
     // for fill_cmd_buf
     XCamReturn dispatch (const GroupSize &group);
 
+    // begin, copy @size bytes from @src to @dst, end
+    XCamReturn record_copy (const SmartPtr<VKBuffer> &src, const SmartPtr<VKBuffer> &dst, VkDeviceSize size);
+    // copy @regions from @src to @dst in one command, between begin () and end ()
+    XCamReturn record_copy_regions (
+        const SmartPtr<VKBuffer> &src, const SmartPtr<VKBuffer> &dst, const std::vector<VkBufferCopy> &regions);
+
 protected:
     explicit VKCmdBuf (const SmartPtr<Pool> pool, VkCommandBuffer buf_id);
 
@@ -21,81 +21,33 @@
 #include <vulkan/vulkan_std.h>
 #include "vk_copy_handler.h"
 #include "vk_video_buf_allocator.h"
-#include "vk_shader.h"
 #include "vk_memory.h"
-#include "vk_worker.h"
+#include "vk_cmdbuf.h"
 #include "vk_device.h"
+#include "vk_sync.h"
+#include "vulkan_common.h"
 
-#define COPY_SHADER_BINDING_COUNT 2
 #define INVALID_INDEX (uint32_t)(-1)
 
 namespace XCam {
 
-namespace {
-
-DECLARE_WORK_CALLBACK (CbCopyTask, VKCopyHandler, copy_done);
-
-class VKCopyPushConst
-    : public VKConstRange::VKPushConstArg
+// rows of full width are contiguous and merged into one region
+static void
+add_copy_region (std::vector<VkBufferCopy> &regions, VkDeviceSize src, VkDeviceSize dst, VkDeviceSize size)
 {
-public:
-    VKCopyPushConst (const VKCopyHandler::PushConstsProp &prop)
-        : _prop (prop)
-    {}
-
-    bool get_const_data (VkPushConstantRange &range, void *& ptr) {
-        range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-        range.offset = 0;
-        range.size = sizeof (_prop);
-        ptr = &_prop;
-        return true;
+    if (!regions.empty ()) {
+        VkBufferCopy &last = regions.back ();
+        if (last.srcOffset + last.size == src && last.dstOffset + last.size == dst) {
+            last.size += size;
+            return;
+        }
     }
 
-private:
-    VKCopyHandler::PushConstsProp _prop;
-};
-
-};
-
-static const VKShaderInfo copy_shader_info (
-    "main",
-std::vector<uint32_t> {
-#include "shader_copy.comp.spv"
-});
-
-#if 0
-VKCopyArguments::VKCopyArguments (const SmartPtr<VKBuffer> in, SmartPtr<VKBuffer> out)
-    : _in_buf (in)
-    , _out_buf (out)
-{
-    XCAM_ASSERT (in.ptr());
-    XCAM_ASSERT (out.ptr());
-}
-
-XCamReturn
-VKCopyArguments::prepare_bindings (VKDescriptor::SetBindInfoArray &binding_array)
-{
-    XCAM_FAIL_RETURN (
-        ERROR, _in_buf.ptr () && _out_buf.ptr (), XCAM_RETURN_ERROR_PARAM,
-        "VKCopyArguments input or output buffer is empty.");
-
-    binding_array.resize (2);
-    binding_array[0].layout = new VKDescriptor::ComputeLayoutBinding (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0);
-    binding_array[0].desc = VKBufDesc (_in_buf);
-
-    binding_array[0].layout = new VKDescriptor::ComputeLayoutBinding (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1);
-    binding_array[0].desc = VKBufDesc (_out_buf);
-    return XCAM_RETURN_NO_ERROR;
-}
-#endif
-
-VKCopyHandler::PushConstsProp::PushConstsProp ()
-    : in_img_width (0)
-    , in_x_offset (0)
-    , out_img_width (0)
-    , out_x_offset (0)
-    , copy_width (0)
-{
+    VkBufferCopy region = {};
+    region.srcOffset = src;
+    region.dstOffset = dst;
+    region.size = size;
+    regions.push_back (region);
 }
 
 VKCopyHandler::VKCopyHandler (const SmartPtr<VKDevice> dev, const char* name)
@@ -128,14 +80,10 @@ VKCopyHandler::set_copy_area (uint32_t idx, const Rect &in_area, const Rect &out
     return true;
 }
 
-#define UNIT_BYTES (4*sizeof(uint32_t))
-
 XCamReturn
 VKCopyHandler::configure_resource (const SmartPtr<ImageHandler::Parameters> &param)
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
     XCAM_ASSERT (param.ptr ());
-    XCAM_ASSERT (!_worker.ptr ());
 
     XCAM_FAIL_RETURN (
         ERROR, param->in_buf.ptr (), XCAM_RETURN_ERROR_VULKAN,
@@ -153,44 +101,96 @@ VKCopyHandler::configure_resource (const SmartPtr<ImageHandler::Parameters> &par
     XCAM_FAIL_RETURN (
         ERROR, out_info.is_valid (), XCAM_RETURN_ERROR_PARAM,
         "VKCopyHandler(%s) invalid out info.", XCAM_STR (get_name ()));
+    XCAM_FAIL_RETURN (
+        ERROR, in_info.format == V4L2_PIX_FMT_NV12 && out_info.format == V4L2_PIX_FMT_NV12,
+        XCAM_RETURN_ERROR_PARAM,
+        "VKCopyHandler(%s) only support NV12 format", XCAM_STR (get_name ()));
+
+    // Y rows then UV rows, all in one vkCmdCopyBuffer
+    _regions.clear ();
+    for (int32_t y = 0; y < _in_area.height; ++y) {
+        add_copy_region (
+            _regions,
+            in_info.offsets[0] + (_in_area.pos_y + y) * in_info.strides[0] + _in_area.pos_x,
+            out_info.offsets[0] + (_out_area.pos_y + y) * out_info.strides[0] + _out_area.pos_x,
+            _in_area.width);
+    }
+    for (int32_t y = 0; y < _in_area.height / 2; ++y) {
+        add_copy_region (
+            _regions,
+            in_info.offsets[1] + (_in_area.pos_y / 2 + y) * in_info.strides[1] + _in_area.pos_x,
+            out_info.offsets[1] + (_out_area.pos_y / 2 + y) * out_info.strides[1] + _out_area.pos_x,
+            _in_area.width);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
 
-    _image_prop.in_img_width = in_info.aligned_width / UNIT_BYTES;
-    _image_prop.in_x_offset = _in_area.pos_x / UNIT_BYTES;
-    _image_prop.out_img_width = out_info.aligned_width / UNIT_BYTES;
-    _image_prop.out_x_offset = _out_area.pos_x / UNIT_BYTES;
-    _image_prop.copy_width = _in_area.width / UNIT_BYTES;
-    WorkSize global_size (
-        XCAM_ALIGN_UP (_image_prop.copy_width, 8 ) / 8,
-        XCAM_ALIGN_UP (_in_area.height * 3 / 2, 8 ) / 8);
-
-    _binding_layout.clear ();
-    for (int i = 0; i < COPY_SHADER_BINDING_COUNT; ++i) {
-        SmartPtr<VKDescriptor::SetLayoutBinding> binding =
-            new VKDescriptor::ComputeLayoutBinding (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, i);
-        _binding_layout.push_back (binding);
+XCamReturn
+VKCopyHandler::submit (const SmartPtr<VKBuffer> &in_buf, const SmartPtr<VKBuffer> &out_buf)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (!_cmdbuf.ptr ()) {
+        if (_device->has_timeline_semaphore ()) {
+            SmartPtr<VKCmdBuf::Pool> pool = VKCmdBuf::create_pool (_device, VK_QUEUE_TRANSFER_BIT);
+            if (pool.ptr ())
+                _cmdbuf = pool->allocate_buffer ();
+            _timeline = _device->create_timeline ();
+        }
+        if (!_cmdbuf.ptr () || !_timeline.ptr ()) {
+            _timeline.release ();
+            _cmdbuf = VKCmdBuf::create_command_buffer (_device);
+            _fence = _device->create_fence (0);
+            XCAM_FAIL_RETURN (
+                ERROR, _cmdbuf.ptr () && _fence.ptr (), XCAM_RETURN_ERROR_VULKAN,
+                "VKCopyHandler(%s) create command buffer or fence failed.", XCAM_STR (get_name ()));
+        }
     }
 
-    if (!_worker.ptr ()) {
-        _worker = new VKWorker(get_vk_device(), "VKCopyTask", new CbCopyTask(this));
-        XCAM_ASSERT (_worker.ptr());
+    // cmdbuf of last submit is reused, usually done by now
+    if (_done_point.is_valid ()) {
+        ret = _done_point.wait ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "VKCopyHandler(%s) wait last copy failed.", XCAM_STR (get_name ()));
+    }
 
-        _worker->set_global_size (global_size);
+    ret = _cmdbuf->begin ();
+    if (xcam_ret_is_ok (ret))
+        ret = _cmdbuf->record_copy_regions (in_buf, out_buf, _regions);
+    XCamReturn end_ret = _cmdbuf->end ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret) && xcam_ret_is_ok (end_ret), XCAM_RETURN_ERROR_VULKAN,
+        "VKCopyHandler(%s) record copy failed.", XCAM_STR (get_name ()));
 
-        VKConstRange::VKPushConstArgs push_consts;
-        push_consts.push_back (new VKCopyPushConst (_image_prop));
-        ret = _worker->build (copy_shader_info, _binding_layout, push_consts);
+    VKSyncPoint wait = take_wait_point ();
+    if (!_timeline.ptr ()) {
+        ret = _device->compute_queue_submit (_cmdbuf, _fence);
         XCAM_FAIL_RETURN (
-            ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_VULKAN,
-            "VKCopyHandler(%s) build copy shader failed.", XCAM_STR (get_name ()));
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "VKCopyHandler(%s) submit compute queue failed.", XCAM_STR (get_name ()));
+
+        ret = _fence->wait ();
+        _fence->reset ();
+        return ret;
     }
 
-    return ret;
+    VKSyncPoint signal (_timeline, _timeline->next_value ());
+    ret = _device->transfer_queue_submit (_cmdbuf, wait, signal);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "VKCopyHandler(%s) submit transfer queue failed.", XCAM_STR (get_name ()));
+    _done_point = signal;
+
+    if (is_async ())
+        return XCAM_RETURN_NO_ERROR;
+    return signal.wait ();
 }
 
 XCamReturn
 VKCopyHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
 {
-    XCAM_ASSERT (_binding_layout.size () == COPY_SHADER_BINDING_COUNT);
+    XCAM_ASSERT (!_regions.empty ());
     SmartPtr<VKVideoBuffer> in_vk = param->in_buf.dynamic_cast_ptr<VKVideoBuffer> ();
     SmartPtr<VKVideoBuffer> out_vk = param->out_buf.dynamic_cast_ptr<VKVideoBuffer> ();
 
@@ -198,32 +198,20 @@ VKCopyHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
         ERROR, in_vk.ptr () && out_vk.ptr(), XCAM_RETURN_ERROR_VULKAN,
         "VKCopyHandler(%s) param.in_buf or param.out_buf is not vk buf.", XCAM_STR (get_name ()));
 
-    VKDescriptor::SetBindInfoArray bindings (_binding_layout.size ());
-    bindings[0].layout = _binding_layout[0];
-    bindings[0].desc = VKBufDesc (in_vk->get_vk_buf ());
-    bindings[1].layout = _binding_layout[1];
-    bindings[1].desc = VKBufDesc (out_vk->get_vk_buf ());
+    if (_record_cmdbuf.ptr ())
+        return _record_cmdbuf->record_copy_regions (in_vk->get_vk_buf (), out_vk->get_vk_buf (), _regions);
 
-    SmartPtr<VKWorker::VKArguments> args = new VKWorker::VKArguments;
-    args->set_bindings (bindings);
-    args->add_push_const (new VKCopyPushConst (_image_prop));
-    return _worker->work (args);
+    return submit (in_vk->get_vk_buf (), out_vk->get_vk_buf ());
 }
 
-void
-VKCopyHandler::copy_done (
-    const SmartPtr<Worker> &worker,
-    const SmartPtr<Worker::Arguments> &args,
-    const XCamReturn error)
+XCamReturn
+VKCopyHandler::finish ()
 {
-    XCAM_UNUSED (args);
-    if (!xcam_ret_is_ok (error)) {
-        XCAM_LOG_ERROR ("VKCopyHandler(%s) copy failed.", XCAM_STR (get_name ()));
-    }
+    // copies on transfer queue aren't waited by compute queue idle
+    if (_done_point.is_valid ())
+        _done_point.wait ();
 
-    SmartPtr<VKWorker> vk_worker = worker.dynamic_cast_ptr<VKWorker> ();
-    XCAM_ASSERT (vk_worker.ptr ());
-    vk_worker->wait_fence ();
+    return VKHandler::finish ();
 }
 
 XCamReturn
@@ -23,60 +23,45 @@
 
 #include <xcam_utils.h>
 #include <vulkan/vulkan_std.h>
-#include <vulkan/vk_worker.h>
 #include <vulkan/vk_handler.h>
-#include <vulkan/vk_descriptor.h>
+#include <vector>
 
 namespace XCam {
 
-#if 0
-class VKCopyArguments
-    : public VKWorker::VKArguments
-{
-public:
-    explicit VKCopyArguments (const SmartPtr<VKBuffer> in, SmartPtr<VKBuffer> out);
-
-private:
-    virtual XCamReturn prepare_bindings (VKDescriptor::SetBindInfoArray &binding_array);
-private:
-    SmartPtr<VKBuffer>        _in_buf;
-    SmartPtr<VKBuffer>        _out_buf;
-};
-#endif
+class VKBuffer;
+class VKCmdBuf;
+class VKFence;
+class VKTimeline;
 
+/*
+ * VKCopyHandler, copies copy area of NV12 buffers by vkCmdCopyBuffer, one region a row,
+ * regions of both planes in one command. own submits run on transfer queue of device
+ * with timeline semaphore, else on compute queue with a fence.
+ */
 class VKCopyHandler
     : public VKHandler
 {
-public:
-    struct PushConstsProp {
-        uint    in_img_width;
-        uint    in_x_offset;
-        uint    out_img_width;
-        uint    out_x_offset;
-        uint    copy_width;
-
-        PushConstsProp ();
-    };
-
 public:
     explicit VKCopyHandler (const SmartPtr<VKDevice> dev, const char* name = "vk-copy-handler");
 
     bool set_copy_area (uint32_t idx, const Rect &in_area, const Rect &out_area);
 
     XCamReturn copy (const SmartPtr<VideoBuffer> &in_buf, SmartPtr<VideoBuffer> &out_buf);
-    void copy_done (
-        const SmartPtr<Worker> &worker,
-        const SmartPtr<Worker::Arguments> &args,
-        const XCamReturn error);
+
+    // derived from VKHandler
+    virtual XCamReturn finish ();
 
 private:
     virtual XCamReturn configure_resource (const SmartPtr<Parameters> &param);
     virtual XCamReturn start_work (const SmartPtr<Parameters> &param);
 
+    XCamReturn submit (const SmartPtr<VKBuffer> &in_buf, const SmartPtr<VKBuffer> &out_buf);
+
 private:
-    SmartPtr<VKWorker>               _worker;
-    PushConstsProp                   _image_prop;
-    VKDescriptor::BindingArray       _binding_layout;
+    std::vector<VkBufferCopy>        _regions;
+    SmartPtr<VKCmdBuf>               _cmdbuf;
+    SmartPtr<VKTimeline>             _timeline;
+    SmartPtr<VKFence>                _fence;
 
     uint32_t                         _index;
     Rect                             _in_area;
@@ -76,16 +76,18 @@ Pool::add_binding (const SmartPtr<SetLayoutBinding> &bind)
 }
 
 bool
-Pool::add_set_bindings (const BindingArray &binds)
+Pool::add_set_bindings (const BindingArray &binds, uint32_t set_count)
 {
     XCAM_FAIL_RETURN (
         ERROR, !XCAM_IS_VALID_VK_ID (_pool_id), false,
         "vk desriptor pool was inited, cannot add new binding.");
 
-    for (BindingArray::const_iterator i = binds.begin (); i != binds.end (); ++i) {
-        add_binding (*i);
+    for (uint32_t count = 0; count < set_count; ++count) {
+        for (BindingArray::const_iterator i = binds.begin (); i != binds.end (); ++i) {
+            add_binding (*i);
+        }
     }
-    ++_set_size;
+    _set_size += set_count;
 
     return true;
 }
@@ -113,6 +115,8 @@ Pool::create ()
     XCAM_ASSERT (_set_size);
     VkDescriptorPoolCreateInfo create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // sets are given back one by one in Set destructor
+    create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     create_info.maxSets = _set_size;
     create_info.poolSizeCount = pool_sizes.size ();
     create_info.pPoolSizes = pool_sizes.data ();
@@ -215,6 +219,24 @@ Set::update_set (const SetBindInfoArray &bind_array)
     return ret;
 }
 
+bool
+Set::is_bound_to (const SetBindInfoArray &bind_array) const
+{
+    if (bind_array.size () != _bind_array.size ())
+        return false;
+
+    for (uint32_t i = 0; i < bind_array.size (); ++i) {
+        const SetBindInfo &cur = _bind_array[i];
+        const SetBindInfo &bind = bind_array[i];
+        if (cur.layout->get_index () != bind.layout->get_index () ||
+                cur.desc.desc_info.buffer != bind.desc.desc_info.buffer ||
+                cur.desc.desc_info.offset != bind.desc.desc_info.offset ||
+                cur.desc.desc_info.range != bind.desc.desc_info.range)
+            return false;
+    }
+    return true;
+}
+
 }
 
 }
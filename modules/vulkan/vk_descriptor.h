@@ -25,6 +25,9 @@
 #include <vulkan/vk_memory.h>
 #include <map>
 
+// descriptor sets kept by one pipeline for recurring buffer bindings
+#define XCAM_VK_DESC_SET_CACHE_SIZE 8
+
 namespace XCam {
 
 class VKDevice;
@@ -88,6 +91,8 @@ public:
     explicit Set (VkDescriptorSet set_id, const SmartPtr<Pool> pool);
     ~Set ();
     XCamReturn update_set (const SetBindInfoArray &bind_array);
+    // same buffers, offsets and ranges on the same binding indexes
+    bool is_bound_to (const SetBindInfoArray &bind_array) const;
     VkDescriptorSet get_set_id () const {
         return _set_id;
     }
@@ -107,7 +112,8 @@ class Pool
 public:
     explicit Pool (const SmartPtr<VKDevice> dev);
     ~Pool ();
-    bool add_set_bindings (const BindingArray &binds);
+    // room for @set_count sets of @binds
+    bool add_set_bindings (const BindingArray &binds, uint32_t set_count = 1);
     XCamReturn create ();
     const SmartPtr<VKDevice>  get_device() const {
         return _dev;
@@ -24,7 +24,11 @@
 #include "vk_instance.h"
 #include "vk_sync.h"
 #include "vk_cmdbuf.h"
+#include "vk_mem_allocator.h"
 #include "file_handle.h"
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string.h>
 
 namespace XCam {
 
@@ -33,17 +37,34 @@ Mutex VKDevice::_default_mutex;
 
 VKDevice::~VKDevice ()
 {
+    if (_completion_thread.ptr ()) {
+        _completion_thread->stop ();
+        _completion_thread->drain ();
+        _completion_thread.release ();
+    }
+    _mem_allocator.release ();
+    if (XCAM_IS_VALID_VK_ID (_pipeline_cache)) {
+        save_pipeline_cache ();
+        vkDestroyPipelineCache (_dev_id, _pipeline_cache, _allocator.ptr ());
+    }
     if (_dev_id)
         vkDestroyDevice (_dev_id, _allocator.ptr ());
 }
 
 VKDevice::VKDevice (VkDevice id, const SmartPtr<VKInstance> &instance)
     : _dev_id (id)
+    , _compute_queue (VK_NULL_HANDLE)
+    , _transfer_queue (VK_NULL_HANDLE)
     , _instance (instance)
+    , _pipeline_cache (VK_NULL_HANDLE)
+    , _has_timeline (false)
+    , _wait_semaphores (NULL)
+    , _get_semaphore_value (NULL)
 {
     XCAM_ASSERT (instance.ptr ());
     XCAM_ASSERT (XCAM_IS_VALID_VK_ID (id));
     _allocator = instance->get_allocator ();
+    _mem_allocator = new VKMemAllocator (this);
 }
 
 SmartPtr<VKDevice>
@@ -71,42 +92,191 @@ VKDevice::create_device ()
     uint32_t compute_idx = instance->get_compute_queue_family_idx ();
     SmartPtr<VkAllocationCallbacks> allocator = instance->get_allocator ();
 
+    uint32_t transfer_idx = instance->get_transfer_queue_family_idx ();
+
     float priority = 1.0f; //TODO, queue priority change?
-    VkDeviceQueueCreateInfo dev_queue_info = {};
-    dev_queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    dev_queue_info.queueFamilyIndex = compute_idx; // default use compute idx
-    dev_queue_info.queueCount = 1;
-    dev_queue_info.pQueuePriorities = &priority;
+    VkDeviceQueueCreateInfo dev_queue_info[2] = {};
+    dev_queue_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    dev_queue_info[0].queueFamilyIndex = compute_idx; // default use compute idx
+    dev_queue_info[0].queueCount = 1;
+    dev_queue_info[0].pQueuePriorities = &priority;
+    uint32_t queue_info_count = 1;
+
+    if (transfer_idx != XCAM_INVALID_VK_QUEUE_IDX) {
+        dev_queue_info[1] = dev_queue_info[0];
+        dev_queue_info[1].queueFamilyIndex = transfer_idx;
+        queue_info_count = 2;
+    }
 
     VkDeviceCreateInfo dev_create_info = {};
     dev_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     //TODO, add graphics queue info
-    dev_create_info.queueCreateInfoCount = 1;
-    dev_create_info.pQueueCreateInfos = &dev_queue_info;
+    dev_create_info.queueCreateInfoCount = queue_info_count;
+    dev_create_info.pQueueCreateInfos = dev_queue_info;
 
     VkDevice dev_id = 0;
-    XCAM_VK_CHECK_RETURN (
-        ERROR,
-        vkCreateDevice (phy_dev, &dev_create_info, allocator.ptr (), &dev_id),
-        NULL, "create vk device failed");
+    bool timeline_enabled = false;
+#ifdef VK_KHR_timeline_semaphore
+    uint32_t ext_count = 0;
+    vkEnumerateDeviceExtensionProperties (phy_dev, NULL, &ext_count, NULL);
+    std::vector<VkExtensionProperties> exts (ext_count);
+    if (ext_count)
+        vkEnumerateDeviceExtensionProperties (phy_dev, NULL, &ext_count, exts.data ());
+
+    for (uint32_t i = 0; i < exts.size (); ++i) {
+        if (strcmp (exts[i].extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+            continue;
+
+        const char *ext_name = VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME;
+        VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_feature = {};
+        timeline_feature.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+        timeline_feature.timelineSemaphore = VK_TRUE;
+
+        VkDeviceCreateInfo timeline_create_info = dev_create_info;
+        timeline_create_info.pNext = &timeline_feature;
+        timeline_create_info.enabledExtensionCount = 1;
+        timeline_create_info.ppEnabledExtensionNames = &ext_name;
+        // extension listed but feature missing, go on without it
+        if (vkCreateDevice (phy_dev, &timeline_create_info, allocator.ptr (), &dev_id) == VK_SUCCESS)
+            timeline_enabled = true;
+        break;
+    }
+#endif
+
+    if (!timeline_enabled) {
+        XCAM_VK_CHECK_RETURN (
+            ERROR,
+            vkCreateDevice (phy_dev, &dev_create_info, allocator.ptr (), &dev_id),
+            NULL, "create vk device failed");
+    }
 
     XCAM_ASSERT (XCAM_IS_VALID_VK_ID (dev_id));
     SmartPtr<VKDevice> device = new VKDevice (dev_id, instance);
     XCAM_ASSERT (device.ptr ());
 
+    if (timeline_enabled)
+        device->prepare_timeline_semaphore ();
+
     XCamReturn ret = device->prepare_compute_queue ();
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), NULL,
         "VKDevice prepare compute queue failed.");
 
+    ret = device->prepare_pipeline_cache ();
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING ("VKDevice prepare pipeline cache failed, pipelines will be compiled without cache");
+    }
+
     return device;
 }
 
+void
+VKDevice::prepare_timeline_semaphore ()
+{
+    _wait_semaphores = vkGetDeviceProcAddr (_dev_id, "vkWaitSemaphoresKHR");
+    _get_semaphore_value = vkGetDeviceProcAddr (_dev_id, "vkGetSemaphoreCounterValueKHR");
+    _has_timeline = _wait_semaphores && _get_semaphore_value;
+
+    if (!_has_timeline) {
+        XCAM_LOG_WARNING ("VKDevice timeline semaphore functions not found, fences are used");
+    }
+}
+
 XCamReturn
 VKDevice::prepare_compute_queue ()
 {
     uint32_t compute_idx = _instance->get_compute_queue_family_idx ();
     vkGetDeviceQueue (_dev_id, compute_idx, 0, &_compute_queue);
+
+    uint32_t transfer_idx = _instance->get_transfer_queue_family_idx ();
+    if (transfer_idx != XCAM_INVALID_VK_QUEUE_IDX)
+        vkGetDeviceQueue (_dev_id, transfer_idx, 0, &_transfer_queue);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKDevice::prepare_pipeline_cache ()
+{
+    const char *cache_path = std::getenv ("XCAM_VK_PIPELINE_CACHE_PATH");
+    std::string path;
+    if (cache_path) {
+        path = cache_path;
+    } else {
+        const char *home_dir = std::getenv ("HOME");
+        path = home_dir ? home_dir : "/tmp";
+        path += "/.xcam";
+    }
+
+    const uint8_t *uuid = _instance->get_device_properties ().pipelineCacheUUID;
+    char uuid_str[VK_UUID_SIZE * 2 + 1] = {0};
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+        snprintf (uuid_str + i * 2, 3, "%02x", uuid[i]);
+    _pipeline_cache_file = path + "/vk-pipeline-" + uuid_str + ".cache";
+
+    // stale or foreign data is rejected by the driver through the cache header
+    std::vector<uint8_t> data;
+    FileHandle file;
+    size_t file_size = 0;
+    if (xcam_ret_is_ok (file.open (_pipeline_cache_file.c_str (), "rb")) &&
+            xcam_ret_is_ok (file.get_file_size (file_size)) && file_size > 0) {
+        data.resize (file_size);
+        if (!xcam_ret_is_ok (file.read_file (data.data (), file_size))) {
+            XCAM_LOG_WARNING ("VKDevice read pipeline cache(%s) failed, ignored", _pipeline_cache_file.c_str ());
+            data.clear ();
+        }
+    }
+    file.close ();
+
+    VkPipelineCacheCreateInfo cache_info = {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = data.size ();
+    cache_info.pInitialData = data.empty () ? NULL : data.data ();
+
+    VkPipelineCache cache_id = VK_NULL_HANDLE;
+    XCAM_VK_CHECK_RETURN (
+        ERROR, vkCreatePipelineCache (_dev_id, &cache_info, _allocator.ptr (), &cache_id),
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice create pipeline cache failed.");
+
+    _pipeline_cache = cache_id;
+    XCAM_LOG_DEBUG (
+        "VKDevice pipeline cache(%s) created with %d bytes",
+        _pipeline_cache_file.c_str (), (int)data.size ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKDevice::save_pipeline_cache ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, XCAM_IS_VALID_VK_ID (_pipeline_cache), XCAM_RETURN_ERROR_PARAM,
+        "VKDevice save pipeline cache failed, cache was not created");
+
+    size_t size = 0;
+    XCAM_VK_CHECK_RETURN (
+        ERROR, vkGetPipelineCacheData (_dev_id, _pipeline_cache, &size, NULL),
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice query pipeline cache size failed.");
+    if (!size)
+        return XCAM_RETURN_BYPASS;
+
+    std::vector<uint8_t> data (size);
+    XCAM_VK_CHECK_RETURN (
+        ERROR, vkGetPipelineCacheData (_dev_id, _pipeline_cache, &size, data.data ()),
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice get pipeline cache data failed.");
+
+    std::string dir = _pipeline_cache_file.substr (0, _pipeline_cache_file.rfind ('/'));
+    if (access (dir.c_str (), F_OK) == -1) {
+        mkdir (dir.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    }
+
+    FileHandle file;
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.open (_pipeline_cache_file.c_str (), "wb")), XCAM_RETURN_ERROR_FILE,
+        "VKDevice open pipeline cache(%s) failed", _pipeline_cache_file.c_str ());
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.write_file (data.data (), size)), XCAM_RETURN_ERROR_FILE,
+        "VKDevice write pipeline cache(%s) failed", _pipeline_cache_file.c_str ());
+
+    XCAM_LOG_DEBUG ("VKDevice pipeline cache(%s) saved, %d bytes", _pipeline_cache_file.c_str (), (int)size);
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -177,7 +347,7 @@ VKDevice::allocate_mem_id (VkDeviceSize size, VkMemoryPropertyFlags memory_prop)
     VkMemoryAllocateInfo mem_alloc_info = {};
     mem_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     mem_alloc_info.allocationSize = size;
-    mem_alloc_info.memoryTypeIndex = _instance->get_mem_type_index (memory_prop);
+    mem_alloc_info.memoryTypeIndex = get_mem_type_index (memory_prop);
 
     XCAM_FAIL_RETURN (
         ERROR, mem_alloc_info.memoryTypeIndex != (uint32_t)(-1), VK_NULL_HANDLE,
@@ -189,6 +359,12 @@ VKDevice::allocate_mem_id (VkDeviceSize size, VkMemoryPropertyFlags memory_prop)
     return mem_id;
 }
 
+uint32_t
+VKDevice::get_mem_type_index (VkMemoryPropertyFlags memory_prop) const
+{
+    return _instance->get_mem_type_index (memory_prop);
+}
+
 void
 VKDevice::free_mem_id (VkDeviceMemory mem)
 {
@@ -224,6 +400,17 @@ VKDevice::create_buf_id (VkBufferUsageFlags usage, uint32_t size)
     buf_create_info.usage = usage;
     buf_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // copied on transfer queue and read on compute queue without ownership transfer
+    uint32_t families[2] = {
+        _instance->get_compute_queue_family_idx (), _instance->get_transfer_queue_family_idx ()
+    };
+    if (has_transfer_queue () &&
+            (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))) {
+        buf_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buf_create_info.queueFamilyIndexCount = 2;
+        buf_create_info.pQueueFamilyIndices = families;
+    }
+
     VkBuffer buf_id;
     XCAM_VK_CHECK_RETURN (
         ERROR, vkCreateBuffer (_dev_id, &buf_create_info, _allocator.ptr (), &buf_id),
@@ -327,6 +514,10 @@ VKDevice::create_cmd_pool (VkFlags queue_flag)
         create_pool_info.queueFamilyIndex = _instance->get_compute_queue_family_idx ();
     else if (queue_flag == VK_QUEUE_GRAPHICS_BIT)
         create_pool_info.queueFamilyIndex = _instance->get_graphics_queue_family_idx ();
+    else if (queue_flag == VK_QUEUE_TRANSFER_BIT)
+        create_pool_info.queueFamilyIndex = has_transfer_queue () ?
+                                            _instance->get_transfer_queue_family_idx () :
+                                            _instance->get_compute_queue_family_idx ();
     else {
         XCAM_LOG_WARNING ("VKDevice create command pool failed, queue_flag(%d) not supported.", queue_flag);
         return VK_NULL_HANDLE;
@@ -468,4 +659,166 @@ VKDevice::compute_queue_wait_idle ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+SmartPtr<VKTimeline>
+VKDevice::create_timeline ()
+{
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_dev_id));
+    XCAM_FAIL_RETURN (
+        ERROR, _has_timeline, NULL,
+        "VKDevice create timeline failed, timeline semaphore not enabled.");
+
+#ifdef VK_KHR_timeline_semaphore
+    VkSemaphoreTypeCreateInfoKHR type_info = {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
+    VkSemaphore semaphore_id = VK_NULL_HANDLE;
+    XCAM_VK_CHECK_RETURN (
+        ERROR, vkCreateSemaphore (_dev_id, &semaphore_info, _allocator.ptr (), &semaphore_id),
+        NULL, "VKDevice create timeline semaphore failed.");
+    return new VKTimeline (this, semaphore_id);
+#else
+    return NULL;
+#endif
+}
+
+void
+VKDevice::destroy_semaphore (VkSemaphore semaphore)
+{
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_dev_id));
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (semaphore));
+
+    vkDestroySemaphore (_dev_id, semaphore, _allocator.ptr ());
+}
+
+XCamReturn
+VKDevice::wait_semaphore (VkSemaphore semaphore, uint64_t value, uint64_t timeout)
+{
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_dev_id));
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (semaphore));
+
+#ifdef VK_KHR_timeline_semaphore
+    XCAM_ASSERT (_wait_semaphores);
+    VkSemaphoreWaitInfoKHR wait_info = {};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &semaphore;
+    wait_info.pValues = &value;
+
+    VkResult ret = ((PFN_vkWaitSemaphoresKHR)_wait_semaphores) (_dev_id, &wait_info, timeout);
+    if (ret == VK_TIMEOUT) {
+        XCAM_LOG_DEBUG ("VKDevice wait for semaphore timeout");
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR, ret == VK_SUCCESS,
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice wait for semaphore failed.");
+    return XCAM_RETURN_NO_ERROR;
+#else
+    XCAM_UNUSED (value);
+    XCAM_UNUSED (timeout);
+    return XCAM_RETURN_ERROR_VULKAN;
+#endif
+}
+
+XCamReturn
+VKDevice::get_semaphore_value (VkSemaphore semaphore, uint64_t &value)
+{
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_dev_id));
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (semaphore));
+
+#ifdef VK_KHR_timeline_semaphore
+    XCAM_ASSERT (_get_semaphore_value);
+    XCAM_VK_CHECK_RETURN (
+        ERROR, ((PFN_vkGetSemaphoreCounterValueKHR)_get_semaphore_value) (_dev_id, semaphore, &value),
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice get semaphore value failed.");
+    return XCAM_RETURN_NO_ERROR;
+#else
+    XCAM_UNUSED (value);
+    return XCAM_RETURN_ERROR_VULKAN;
+#endif
+}
+
+XCamReturn
+VKDevice::compute_queue_submit (
+    const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal)
+{
+    return queue_submit (_compute_queue, cmd_buf, wait, signal);
+}
+
+XCamReturn
+VKDevice::transfer_queue_submit (
+    const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal)
+{
+    return queue_submit (has_transfer_queue () ? _transfer_queue : _compute_queue, cmd_buf, wait, signal);
+}
+
+XCamReturn
+VKDevice::queue_submit (
+    VkQueue queue, const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, cmd_buf.ptr () && signal.is_valid (),
+        XCAM_RETURN_ERROR_PARAM, "VKDevice queue submit failed, cmd_buf or signal point is empty.");
+
+#ifdef VK_KHR_timeline_semaphore
+    VkCommandBuffer buf_id = cmd_buf->get_cmd_buf_id ();
+    VkSemaphore wait_id = VK_NULL_HANDLE;
+    VkSemaphore signal_id = signal.timeline->get_semaphore_id ();
+    VkPipelineStageFlags wait_stage = (queue == _compute_queue) ?
+                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    VkTimelineSemaphoreSubmitInfoKHR timeline_info = {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &signal.value;
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &buf_id;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &signal_id;
+
+    if (wait.is_valid ()) {
+        wait_id = wait.timeline->get_semaphore_id ();
+        timeline_info.waitSemaphoreValueCount = 1;
+        timeline_info.pWaitSemaphoreValues = &wait.value;
+        submit_info.waitSemaphoreCount = 1;
+        submit_info.pWaitSemaphores = &wait_id;
+        submit_info.pWaitDstStageMask = &wait_stage;
+    }
+
+    XCAM_VK_CHECK_RETURN (
+        ERROR, vkQueueSubmit (queue, 1, &submit_info, VK_NULL_HANDLE),
+        XCAM_RETURN_ERROR_VULKAN, "VKDevice queue submit with timeline failed.");
+
+    return XCAM_RETURN_NO_ERROR;
+#else
+    XCAM_UNUSED (wait);
+    return XCAM_RETURN_ERROR_VULKAN;
+#endif
+}
+
+SmartPtr<VKCompletionThread>
+VKDevice::get_completion_thread ()
+{
+    SmartLock locker (_completion_mutex);
+    if (!_completion_thread.ptr ()) {
+        SmartPtr<VKCompletionThread> thread = new VKCompletionThread ();
+        XCAM_FAIL_RETURN (
+            ERROR, thread->start (), NULL,
+            "VKDevice start completion thread failed.");
+        _completion_thread = thread;
+    }
+    return _completion_thread;
+}
+
 }
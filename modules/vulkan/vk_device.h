@@ -23,16 +23,21 @@
 
 #include <vulkan/vulkan_std.h>
 #include <xcam_mutex.h>
+#include <string>
 
 namespace XCam {
 
 class VKPipeline;
 class VKShader;
 class VKFence;
+class VKTimeline;
+class VKCompletionThread;
+struct VKSyncPoint;
 class VKCmdBuf;
 class VKInstance;
 class VKMemory;
 class VKBuffer;
+class VKMemAllocator;
 
 namespace VKDescriptor {
 class Pool;
@@ -43,6 +48,7 @@ class VKDevice
     : public RefObj
 {
     friend class VKFence;
+    friend class VKTimeline;
     friend class VKShader;
     friend class VKPipeline;
     friend class VKCmdBuf;
@@ -50,6 +56,7 @@ class VKDevice
     friend class VKDescriptor::Set;
     friend class VKMemory;
     friend class VKBuffer;
+    friend class VKMemAllocator;
 public:
     ~VKDevice ();
     static SmartPtr<VKDevice> default_device ();
@@ -70,10 +77,42 @@ public:
     XCamReturn compute_queue_submit (const SmartPtr<VKCmdBuf> cmd_buf, const SmartPtr<VKFence> fence);
     XCamReturn compute_queue_wait_idle ();
 
+    // VK_KHR_timeline_semaphore, enabled on device creation when supported
+    bool has_timeline_semaphore () const {
+        return _has_timeline;
+    }
+    SmartPtr<VKTimeline> create_timeline ();
+    // GPU waits on @wait if valid before running cmd_buf, then signals @signal
+    XCamReturn compute_queue_submit (
+        const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal);
+    // shared by all workers of device, started on first call
+    SmartPtr<VKCompletionThread> get_completion_thread ();
+
+    // queue of a dedicated transfer family, copies on it overlap compute
+    bool has_transfer_queue () const {
+        return XCAM_IS_VALID_VK_ID (_transfer_queue);
+    }
+    // runs on compute queue if there is no transfer queue, needs timeline semaphore
+    XCamReturn transfer_queue_submit (
+        const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal);
+
+    // device memory of VKMemory is carved from blocks of this allocator
+    const SmartPtr<VKMemAllocator> &get_mem_allocator () const {
+        return _mem_allocator;
+    }
+
+    // pipeline cache is loaded from and saved to a file named by pipelineCacheUUID,
+    // XCAM_VK_PIPELINE_CACHE_PATH overrides the default directory $HOME/.xcam
+    VkPipelineCache get_pipeline_cache () const {
+        return _pipeline_cache;
+    }
+    XCamReturn save_pipeline_cache ();
+
 protected:
     void destroy_shader_id (VkShaderModule shader);
     VkDeviceMemory allocate_mem_id (VkDeviceSize size, VkMemoryPropertyFlags memory_prop);
     void free_mem_id (VkDeviceMemory mem);
+    uint32_t get_mem_type_index (VkMemoryPropertyFlags memory_prop) const;
     XCamReturn map_mem (VkDeviceMemory mem, VkDeviceSize size, VkDeviceSize offset, void *&ptr);
     void unmap_mem (VkDeviceMemory mem);
     VkBuffer create_buf_id (VkBufferUsageFlags usage, uint32_t size);
@@ -97,9 +136,17 @@ protected:
     XCamReturn reset_fence (VkFence fence);
     XCamReturn wait_for_fence (VkFence fence, uint64_t timeout);
 
+    void destroy_semaphore (VkSemaphore semaphore);
+    XCamReturn wait_semaphore (VkSemaphore semaphore, uint64_t value, uint64_t timeout);
+    XCamReturn get_semaphore_value (VkSemaphore semaphore, uint64_t &value);
+
 protected:
     explicit VKDevice (VkDevice id, const SmartPtr<VKInstance> &instance);
+    void prepare_timeline_semaphore ();
+    XCamReturn queue_submit (
+        VkQueue queue, const SmartPtr<VKCmdBuf> cmd_buf, const VKSyncPoint &wait, const VKSyncPoint &signal);
     XCamReturn prepare_compute_queue ();
+    XCamReturn prepare_pipeline_cache ();
     //SmartPtr<VKLayout> create_desc_set_layout ();
 
 private:
@@ -111,8 +158,18 @@ private:
 
     VkDevice                         _dev_id;
     VkQueue                          _compute_queue;
+    VkQueue                          _transfer_queue;
     SmartPtr<VkAllocationCallbacks>  _allocator;
     SmartPtr<VKInstance>             _instance;
+    SmartPtr<VKMemAllocator>         _mem_allocator;
+    VkPipelineCache                  _pipeline_cache;
+    std::string                      _pipeline_cache_file;
+
+    bool                             _has_timeline;
+    PFN_vkVoidFunction               _wait_semaphores;
+    PFN_vkVoidFunction               _get_semaphore_value;
+    SmartPtr<VKCompletionThread>     _completion_thread;
+    Mutex                            _completion_mutex;
 };
 
 }
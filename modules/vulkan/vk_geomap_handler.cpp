@@ -21,14 +21,21 @@
 #include "vk_geomap_handler.h"
 #include "vk_video_buf_allocator.h"
 #include "vk_device.h"
+#include "vulkan_common.h"
 
 #define GEOMAP_SHADER_BINDING_COUNT 5
 
+// constant_id of shader_geomap.comp
+#define GEOMAP_SPEC_LOCAL_SIZE_X 0
+#define GEOMAP_SPEC_LOCAL_SIZE_Y 1
+
 #define XCAM_VK_GEOMAP_ALIGN_X 4
 #define XCAM_VK_GEOMAP_ALIGN_Y 2
 
 namespace XCam {
 
+static_assert (sizeof (PointFloat2) == 2 * sizeof (float), "look up table is uploaded as float pairs");
+
 DECLARE_WORK_CALLBACK (CbGeoMapTask, VKGeoMapHandler, geomap_done);
 
 class VKGeoMapPushConst
@@ -86,22 +93,17 @@ VKGeoMapHandler::set_lookup_table (const PointFloat2 *data, uint32_t width, uint
     _lut_width = width;
     _lut_height = height;
 
-    uint32_t lut_size = width * height * 2 * sizeof (float);
+    // shader reads x, y float pairs, same layout as PointFloat2, copy @data as is
+    uint32_t lut_size = width * height * sizeof (PointFloat2);
     SmartPtr<VKBuffer> buf = VKBuffer::create_buffer (
         get_vk_device (), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, lut_size);
-    XCAM_ASSERT (buf.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, buf.ptr (), false,
+        "VKGeoMapHandler(%s) create look up table buffer failed", XCAM_STR (get_name ()));
 
-    float *ptr = (float *) buf->map (lut_size, 0);
+    void *ptr = buf->map (lut_size, 0);
     XCAM_FAIL_RETURN (ERROR, ptr, false, "VKGeoMapHandler(%s) map range failed", XCAM_STR (get_name ()));
-    for (uint32_t i = 0; i < height; ++i) {
-        float *ret = &ptr[i * width * 2];
-        const PointFloat2 *line = &data[i * width];
-
-        for (uint32_t j = 0; j < width; ++j) {
-            ret[j * 2] = line[j].x;
-            ret[j * 2 + 1] = line[j].y;
-        }
-    }
+    memcpy (ptr, data, lut_size);
     buf->unmap ();
     _lut_buf = buf;
 
@@ -168,9 +170,12 @@ VKGeoMapHandler::configure_resource (const SmartPtr<ImageHandler::Parameters> &p
     _image_prop.lut_std_step[0] = 1.0f / factor_x;
     _image_prop.lut_std_step[1] = 1.0f / factor_y;
 
+    // shader work group size is specialized at pipeline creation, one work item maps 2 rows
+    uint32_t local_x, local_y;
+    vk_get_local_size (local_x, local_y);
     WorkSize global_size (
-        XCAM_ALIGN_UP (_image_prop.out_img_width, 8) / 8,
-        XCAM_ALIGN_UP (_image_prop.out_img_height, 16) / 16);
+        XCAM_ALIGN_UP (_image_prop.out_img_width, local_x) / local_x,
+        XCAM_ALIGN_UP (_image_prop.out_img_height, local_y * 2) / (local_y * 2));
 
     _binding_layout.clear ();
     for (int i = 0; i < GEOMAP_SHADER_BINDING_COUNT; ++i) {
@@ -183,12 +188,16 @@ VKGeoMapHandler::configure_resource (const SmartPtr<ImageHandler::Parameters> &p
     if (!_worker.ptr ()) {
         _worker = new VKWorker (get_vk_device(), "VKGeoMapTask", new CbGeoMapTask(this));
         XCAM_ASSERT (_worker.ptr ());
+        _worker->set_async (is_async ());
 
         _worker->set_global_size (global_size);
 
         VKConstRange::VKPushConstArgs push_consts;
         push_consts.push_back (new VKGeoMapPushConst (_image_prop));
-        ret = _worker->build (geomap_shader_info, _binding_layout, push_consts);
+        VKShaderInfo info = geomap_shader_info;
+        info.spec_consts.push_back (VKSpecConst (GEOMAP_SPEC_LOCAL_SIZE_X, local_x));
+        info.spec_consts.push_back (VKSpecConst (GEOMAP_SPEC_LOCAL_SIZE_Y, local_y));
+        ret = _worker->build (info, _binding_layout, push_consts);
         XCAM_FAIL_RETURN (
             ERROR, xcam_ret_is_ok (ret), XCAM_RETURN_ERROR_VULKAN,
             "VKGeoMapHandler(%s) build geomap shader failed.", XCAM_STR (get_name ()));
@@ -236,7 +245,14 @@ VKGeoMapHandler::start_work (const SmartPtr<ImageHandler::Parameters> &param)
     XCAM_ASSERT (args.ptr ());
     args->set_bindings (bindings);
     args->add_push_const (new VKGeoMapPushConst (_image_prop));
-    return _worker->work (args);
+
+    if (_record_cmdbuf.ptr ())
+        return _worker->record (_record_cmdbuf, args);
+
+    _worker->set_wait_point (take_wait_point ());
+    XCamReturn ret = _worker->work (args);
+    _done_point = _worker->get_done_point ();
+    return ret;
 }
 
 void
@@ -20,6 +20,7 @@
 
 #include "vk_handler.h"
 #include "vk_device.h"
+#include "vk_cmdbuf.h"
 #include "vk_video_buf_allocator.h"
 
 namespace XCam {
@@ -27,6 +28,7 @@ namespace XCam {
 VKHandler::VKHandler (const SmartPtr<VKDevice> dev, const char* name)
     : ImageHandler (name)
     , _device (dev)
+    , _async (false)
 {
 }
 
@@ -51,6 +53,20 @@ VKHandler::terminate ()
     return ImageHandler::terminate ();
 }
 
+void
+VKHandler::set_record_cmdbuf (const SmartPtr<VKCmdBuf> &cmdbuf)
+{
+    _record_cmdbuf = cmdbuf;
+}
+
+VKSyncPoint
+VKHandler::take_wait_point ()
+{
+    VKSyncPoint point = _wait_point;
+    _wait_point = VKSyncPoint ();
+    return point;
+}
+
 SmartPtr<BufferPool>
 VKHandler::create_allocator ()
 {
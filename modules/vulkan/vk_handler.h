@@ -22,11 +22,13 @@
 #define XCAM_VK_HANDLER_H
 
 #include <vulkan/vulkan_std.h>
+#include <vulkan/vk_sync.h>
 #include <image_handler.h>
 
 namespace XCam {
 
 class VKDevice;
+class VKCmdBuf;
 
 class VKHandler
     : public ImageHandler
@@ -42,14 +44,43 @@ public:
     virtual XCamReturn finish ();
     virtual XCamReturn terminate ();
 
+    // once set, work is recorded into cmdbuf instead of being submitted,
+    // the owner of cmdbuf submits it and waits for done.
+    void set_record_cmdbuf (const SmartPtr<VKCmdBuf> &cmdbuf);
+    const SmartPtr<VKCmdBuf> &get_record_cmdbuf () const {
+        return _record_cmdbuf;
+    }
+
+    // needs timeline semaphore on device, else work stays synchronous.
+    // execute_buffer returns after submit, output is ready at get_done_point ()
+    // and done callbacks run on completion thread of device
+    void set_async (bool async) {
+        _async = async;
+    }
+    bool is_async () const {
+        return _async;
+    }
+    // next work waits on GPU for @point, e.g. done point of the handler before
+    void set_wait_point (const VKSyncPoint &point) {
+        _wait_point = point;
+    }
+    const VKSyncPoint &get_done_point () const {
+        return _done_point;
+    }
+
 protected:
     SmartPtr<BufferPool> create_allocator ();
+    VKSyncPoint take_wait_point ();
 
 private:
     XCAM_DEAD_COPY (VKHandler);
 
 protected:
     SmartPtr<VKDevice>      _device;
+    SmartPtr<VKCmdBuf>      _record_cmdbuf;
+    VKSyncPoint             _wait_point;
+    VKSyncPoint             _done_point;
+    bool                    _async;
 };
 
 }
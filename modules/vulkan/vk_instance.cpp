@@ -24,8 +24,6 @@
 #define APP_NAME "xcam"
 #define ENGINE_NAME "xcam"
 
-#define XCAM_INVALID_VK_QUEUE_IDX UINT32_MAX
-
 namespace XCam {
 
 extern void vk_init_error_string ();
@@ -45,6 +43,7 @@ VKInstance::VKInstance (VkInstance id, VkAllocationCallbacks *allocator)
     , _physical_device (NULL)
     , _compute_queue_family_idx (XCAM_INVALID_VK_QUEUE_IDX)
     , _graphics_queue_family_idx (XCAM_INVALID_VK_QUEUE_IDX)
+    , _transfer_queue_family_idx (XCAM_INVALID_VK_QUEUE_IDX)
 {
     XCAM_ASSERT (XCAM_IS_VALID_VK_ID (id));
     xcam_mem_clear (_device_properties);
@@ -205,6 +204,11 @@ VKInstance::query_queue_info ()
         if (queue_family[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
             _graphics_queue_family_idx = i;
         }
+        if ((queue_family[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(queue_family[i].queueFlags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT)) &&
+                _transfer_queue_family_idx == XCAM_INVALID_VK_QUEUE_IDX) {
+            _transfer_queue_family_idx = i;
+        }
     }
 
     XCAM_FAIL_RETURN (
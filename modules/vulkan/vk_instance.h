@@ -24,6 +24,8 @@
 #include <vulkan/vulkan_std.h>
 #include <xcam_mutex.h>
 
+#define XCAM_INVALID_VK_QUEUE_IDX UINT32_MAX
+
 namespace XCam {
 
 class VKInstance
@@ -44,7 +46,14 @@ public:
     uint32_t get_graphics_queue_family_idx () const {
         return _graphics_queue_family_idx;
     }
+    // dedicated DMA family without compute/graphics, XCAM_INVALID_VK_QUEUE_IDX if none
+    uint32_t get_transfer_queue_family_idx () const {
+        return _transfer_queue_family_idx;
+    }
     uint32_t get_mem_type_index (VkMemoryPropertyFlags prop) const;
+    const VkPhysicalDeviceProperties &get_device_properties () const {
+        return _device_properties;
+    }
 
     SmartPtr<VkAllocationCallbacks> get_allocator () const {
         return _allocator;
@@ -70,6 +79,7 @@ private:
     VkPhysicalDeviceMemoryProperties _dev_mem_properties;
     uint32_t                         _compute_queue_family_idx;
     uint32_t                         _graphics_queue_family_idx;
+    uint32_t                         _transfer_queue_family_idx;
 };
 
 }
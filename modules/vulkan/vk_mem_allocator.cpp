@@ -0,0 +1,257 @@
+/*
+ * vk_mem_allocator.cpp - vulkan device memory sub-allocator
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "vk_mem_allocator.h"
+#include "vk_device.h"
+
+namespace XCam {
+
+static uint32_t
+get_max_order ()
+{
+    uint32_t order = 0;
+    while (((VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << order) < XCAM_VK_MEM_BLOCK_SIZE)
+        ++order;
+    return order;
+}
+
+static uint32_t
+get_order (VkDeviceSize size)
+{
+    uint32_t order = 0;
+    while (((VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << order) < size)
+        ++order;
+    return order;
+}
+
+VKMemBlock::VKMemBlock (uint32_t type_idx, VkDeviceMemory mem_id, void *mapped_ptr)
+    : _type_idx (type_idx)
+    , _mem_id (mem_id)
+    , _mapped_ptr (mapped_ptr)
+    , _used (0)
+{
+    uint32_t max_order = get_max_order ();
+    _free_lists.resize (max_order + 1);
+    _free_lists[max_order].insert (0);
+}
+
+VKMemBlock::~VKMemBlock ()
+{
+    XCAM_ASSERT (is_empty ());
+}
+
+bool
+VKMemBlock::alloc (uint32_t order, VkDeviceSize &offset)
+{
+    uint32_t max_order = _free_lists.size () - 1;
+    uint32_t i = order;
+    while (i <= max_order && _free_lists[i].empty ())
+        ++i;
+    if (i > max_order)
+        return false;
+
+    offset = *_free_lists[i].begin ();
+    _free_lists[i].erase (_free_lists[i].begin ());
+
+    // split till the requested order, upper halves go to free lists
+    while (i > order) {
+        --i;
+        _free_lists[i].insert (offset + ((VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << i));
+    }
+
+    _used += (VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << order;
+    return true;
+}
+
+void
+VKMemBlock::free (VkDeviceSize offset, uint32_t order)
+{
+    uint32_t max_order = _free_lists.size () - 1;
+    XCAM_ASSERT (order <= max_order);
+    _used -= (VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << order;
+
+    // merge with free buddies
+    while (order < max_order) {
+        VkDeviceSize buddy = offset ^ ((VkDeviceSize)XCAM_VK_MEM_MIN_ALLOC_SIZE << order);
+        std::set<VkDeviceSize>::iterator i = _free_lists[order].find (buddy);
+        if (i == _free_lists[order].end ())
+            break;
+
+        _free_lists[order].erase (i);
+        offset = XCAM_MIN (offset, buddy);
+        ++order;
+    }
+    _free_lists[order].insert (offset);
+}
+
+VKMemAllocator::VKMemAllocator (VKDevice *dev)
+    : _dev (dev)
+{
+    XCAM_ASSERT (dev);
+}
+
+VKMemAllocator::~VKMemAllocator ()
+{
+    for (size_t i = 0; i < _blocks.size (); ++i) {
+        if (!_blocks[i]->is_empty ()) {
+            XCAM_LOG_WARNING ("vk mem allocator destroyed with memory in use, type:%d", _blocks[i]->get_type_index ());
+        }
+        destroy_block (_blocks[i]);
+    }
+    _blocks.clear ();
+}
+
+VKMemBlock *
+VKMemAllocator::create_block (uint32_t type_idx, VkMemoryPropertyFlags prop)
+{
+    VkDeviceMemory mem_id = _dev->allocate_mem_id (XCAM_VK_MEM_BLOCK_SIZE, prop);
+    XCAM_FAIL_RETURN (
+        ERROR, XCAM_IS_VALID_VK_ID (mem_id), NULL,
+        "vk mem allocator create block failed, type:%d", type_idx);
+
+    // Vulkan allows one mapping per memory object, host visible blocks stay mapped
+    void *mapped_ptr = NULL;
+    if ((prop & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+            !xcam_ret_is_ok (_dev->map_mem (mem_id, VK_WHOLE_SIZE, 0, mapped_ptr))) {
+        XCAM_LOG_ERROR ("vk mem allocator map block failed, type:%d", type_idx);
+        _dev->free_mem_id (mem_id);
+        return NULL;
+    }
+
+    VKMemBlock *block = new VKMemBlock (type_idx, mem_id, mapped_ptr);
+    XCAM_ASSERT (block);
+    _blocks.push_back (block);
+
+    XCAM_LOG_DEBUG (
+        "vk mem allocator created block(%d) of %d bytes, type:%d",
+        (int)_blocks.size (), XCAM_VK_MEM_BLOCK_SIZE, type_idx);
+    return block;
+}
+
+void
+VKMemAllocator::destroy_block (VKMemBlock *block)
+{
+    XCAM_ASSERT (block);
+    if (block->_mapped_ptr)
+        _dev->unmap_mem (block->_mem_id);
+    _dev->free_mem_id (block->_mem_id);
+
+    block->_used = 0;
+    delete block;
+}
+
+XCamReturn
+VKMemAllocator::allocate (
+    const VkMemoryRequirements &reqs, VkMemoryPropertyFlags prop, VKMemAllocation &alloc)
+{
+    alloc = VKMemAllocation ();
+
+    uint32_t type_idx = _dev->get_mem_type_index (prop);
+    XCAM_FAIL_RETURN (
+        ERROR, type_idx != (uint32_t)(-1), XCAM_RETURN_ERROR_MEM,
+        "vk mem allocator can NOT find memory type:0x%08x", (uint32_t)prop);
+
+    VkDeviceSize need = XCAM_MAX (reqs.size, reqs.alignment);
+    if (need > XCAM_VK_MEM_BLOCK_SIZE || !(reqs.memoryTypeBits & (1u << type_idx))) {
+        alloc.mem_id = _dev->allocate_mem_id (reqs.size, prop);
+        XCAM_FAIL_RETURN (
+            ERROR, XCAM_IS_VALID_VK_ID (alloc.mem_id), XCAM_RETURN_ERROR_MEM,
+            "vk mem allocator dedicated allocation failed, size:%d", (int)reqs.size);
+        alloc.size = reqs.size;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    uint32_t order = get_order (need);
+    VkDeviceSize offset = 0;
+    VKMemBlock *found = NULL;
+
+    SmartLock locker (_mutex);
+    for (size_t i = 0; i < _blocks.size (); ++i) {
+        if (_blocks[i]->get_type_index () == type_idx && _blocks[i]->alloc (order, offset)) {
+            found = _blocks[i];
+            break;
+        }
+    }
+
+    if (!found) {
+        found = create_block (type_idx, prop);
+        XCAM_FAIL_RETURN (
+            ERROR, found && found->alloc (order, offset), XCAM_RETURN_ERROR_MEM,
+            "vk mem allocator allocate failed, size:%d", (int)reqs.size);
+    }
+
+    alloc.mem_id = found->_mem_id;
+    alloc.offset = offset;
+    alloc.size = reqs.size;
+    alloc.mapped_ptr = found->_mapped_ptr ? (uint8_t *)found->_mapped_ptr + offset : NULL;
+    alloc.block = found;
+    alloc.order = order;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+VKMemAllocator::free (VKMemAllocation &alloc)
+{
+    if (!XCAM_IS_VALID_VK_ID (alloc.mem_id))
+        return;
+
+    if (!alloc.block) {
+        _dev->free_mem_id (alloc.mem_id);
+        alloc = VKMemAllocation ();
+        return;
+    }
+
+    SmartLock locker (_mutex);
+    VKMemBlock *block = alloc.block;
+    block->free (alloc.offset, alloc.order);
+    alloc = VKMemAllocation ();
+
+    if (!block->is_empty ())
+        return;
+
+    // keep one empty block per memory type for reconfiguration
+    bool has_spare = false;
+    std::vector<VKMemBlock *>::iterator pos = _blocks.end ();
+    for (std::vector<VKMemBlock *>::iterator i = _blocks.begin (); i != _blocks.end (); ++i) {
+        if (*i == block)
+            pos = i;
+        else if ((*i)->get_type_index () == block->get_type_index () && (*i)->is_empty ())
+            has_spare = true;
+    }
+    XCAM_ASSERT (pos != _blocks.end ());
+
+    if (has_spare) {
+        _blocks.erase (pos);
+        destroy_block (block);
+    }
+}
+
+void
+VKMemAllocator::get_usage (uint32_t &block_count, VkDeviceSize &used_size) const
+{
+    SmartLock locker (_mutex);
+    block_count = _blocks.size ();
+    used_size = 0;
+    for (size_t i = 0; i < _blocks.size (); ++i)
+        used_size += _blocks[i]->_used;
+}
+
+}
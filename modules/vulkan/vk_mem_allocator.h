@@ -0,0 +1,118 @@
+/*
+ * vk_mem_allocator.h - vulkan device memory sub-allocator
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_VK_MEM_ALLOCATOR_H
+#define XCAM_VK_MEM_ALLOCATOR_H
+
+#include <vulkan/vulkan_std.h>
+#include <xcam_mutex.h>
+#include <set>
+
+#define XCAM_VK_MEM_BLOCK_SIZE (32 * 1024 * 1024)
+#define XCAM_VK_MEM_MIN_ALLOC_SIZE 256
+
+namespace XCam {
+
+class VKDevice;
+class VKMemBlock;
+
+struct VKMemAllocation {
+    VkDeviceMemory     mem_id;
+    VkDeviceSize       offset;
+    VkDeviceSize       size;
+    // persistent mapping of the block, NULL if not host visible or dedicated
+    void              *mapped_ptr;
+    VKMemBlock        *block;
+    uint32_t           order;
+
+    VKMemAllocation ()
+        : mem_id (VK_NULL_HANDLE)
+        , offset (0)
+        , size (0)
+        , mapped_ptr (NULL)
+        , block (NULL)
+        , order (0)
+    {}
+};
+
+/*
+ * buddy allocator over one VkDeviceMemory of XCAM_VK_MEM_BLOCK_SIZE,
+ * ranges of order n are (XCAM_VK_MEM_MIN_ALLOC_SIZE << n) bytes and aligned to their size.
+ */
+class VKMemBlock
+{
+    friend class VKMemAllocator;
+
+public:
+    ~VKMemBlock ();
+
+    uint32_t get_type_index () const {
+        return _type_idx;
+    }
+    bool is_empty () const {
+        return _used == 0;
+    }
+
+private:
+    explicit VKMemBlock (uint32_t type_idx, VkDeviceMemory mem_id, void *mapped_ptr);
+    bool alloc (uint32_t order, VkDeviceSize &offset);
+    void free (VkDeviceSize offset, uint32_t order);
+
+    XCAM_DEAD_COPY (VKMemBlock);
+
+private:
+    uint32_t                       _type_idx;
+    VkDeviceMemory                 _mem_id;
+    void                          *_mapped_ptr;
+    VkDeviceSize                   _used;
+    std::vector<std::set<VkDeviceSize>>  _free_lists;
+};
+
+/*
+ * owned by VKDevice, groups blocks by memory type and carves aligned ranges from them.
+ * requests larger than a block get a dedicated allocation.
+ */
+class VKMemAllocator
+{
+public:
+    explicit VKMemAllocator (VKDevice *dev);
+    ~VKMemAllocator ();
+
+    XCamReturn allocate (
+        const VkMemoryRequirements &reqs, VkMemoryPropertyFlags prop, VKMemAllocation &alloc);
+    void free (VKMemAllocation &alloc);
+
+    void get_usage (uint32_t &block_count, VkDeviceSize &used_size) const;
+
+private:
+    VKMemBlock *create_block (uint32_t type_idx, VkMemoryPropertyFlags prop);
+    void destroy_block (VKMemBlock *block);
+
+    XCAM_DEAD_COPY (VKMemAllocator);
+
+private:
+    VKDevice                      *_dev;
+    std::vector<VKMemBlock *>      _blocks;
+    mutable Mutex                  _mutex;
+};
+
+}
+
+#endif //XCAM_VK_MEM_ALLOCATOR_H
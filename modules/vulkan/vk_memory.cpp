@@ -25,22 +25,25 @@ namespace XCam {
 
 VKMemory::VKMemory (
     const SmartPtr<VKDevice> dev,
-    VkDeviceMemory id,
+    const VKMemAllocation &alloc,
     uint32_t size,
     VkMemoryPropertyFlags mem_prop)
     : _dev (dev)
-    , _mem_id (id)
+    , _alloc (alloc)
     , _mem_prop (mem_prop)
     , _size (size)
     , _mapped_ptr (NULL)
+    , _mem_charge (MemoryVK)
 {
-    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (id));
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (alloc.mem_id));
+    _mem_charge.charge (size);
 }
 
 VKMemory::~VKMemory ()
 {
-    if (XCAM_IS_VALID_VK_ID (_mem_id) && _dev.ptr ()) {
-        _dev->free_mem_id (_mem_id);
+    if (XCAM_IS_VALID_VK_ID (_alloc.mem_id) && _dev.ptr ()) {
+        unmap ();
+        _dev->get_mem_allocator ()->free (_alloc);
     }
 }
 
@@ -50,9 +53,15 @@ VKMemory::map (VkDeviceSize size, VkDeviceSize offset)
     if (_mapped_ptr)
         return _mapped_ptr;
 
+    // sub-allocated memory is mapped with its block
+    if (_alloc.mapped_ptr) {
+        _mapped_ptr = (uint8_t *)_alloc.mapped_ptr + offset;
+        return _mapped_ptr;
+    }
+
     XCAM_FAIL_RETURN (
         ERROR,
-        xcam_ret_is_ok (_dev->map_mem (_mem_id, size, offset, _mapped_ptr)), NULL,
+        xcam_ret_is_ok (_dev->map_mem (_alloc.mem_id, size, _alloc.offset + offset, _mapped_ptr)), NULL,
         "VK memory map failed");
 
     return _mapped_ptr;
@@ -62,7 +71,8 @@ void
 VKMemory::unmap ()
 {
     if (_mapped_ptr) {
-        _dev->unmap_mem (_mem_id);
+        if (!_alloc.mapped_ptr)
+            _dev->unmap_mem (_alloc.mem_id);
         _mapped_ptr = NULL;
     }
 }
@@ -70,11 +80,11 @@ VKMemory::unmap ()
 VKBuffer::VKBuffer (
     const SmartPtr<VKDevice> dev,
     VkBuffer buf_id,
-    VkDeviceMemory mem_id,
+    const VKMemAllocation &alloc,
     uint32_t size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags prop)
-    : VKMemory (dev, mem_id, size, prop)
+    : VKMemory (dev, alloc, size, prop)
     , _buffer_id (buf_id)
     , _usage_flags (usage)
     , _prop_flags (prop)
@@ -92,9 +102,9 @@ XCamReturn
 VKBuffer::bind ()
 {
     XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_buffer_id));
-    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_mem_id));
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_alloc.mem_id));
 
-    return _dev->bind_buffer (_buffer_id, _mem_id, 0);
+    return _dev->bind_buffer (_buffer_id, _alloc.mem_id, _alloc.offset);
 }
 
 SmartPtr<VKBuffer>
@@ -116,13 +126,15 @@ VKBuffer::create_buffer (
     VkDevice dev_id = dev->get_dev_id ();
     VkMemoryRequirements mem_reqs;
     vkGetBufferMemoryRequirements (dev_id, buf_id, &mem_reqs);
-    VkDeviceMemory mem_id = dev->allocate_mem_id (mem_reqs.size, mem_prop);
-    XCAM_FAIL_RETURN (
-        ERROR, XCAM_IS_VALID_VK_ID (mem_id), NULL,
-        "vk create buffer failed in mem allocation");
+    VKMemAllocation alloc;
+    if (!xcam_ret_is_ok (dev->get_mem_allocator ()->allocate (mem_reqs, mem_prop, alloc))) {
+        XCAM_LOG_ERROR ("vk create buffer failed in mem allocation");
+        dev->destroy_buf_id (buf_id);
+        return NULL;
+    }
 
     // size == mem_reqs.size or size?
-    SmartPtr<VKBuffer> buf = new VKBuffer (dev, buf_id, mem_id, size, usage, mem_prop);
+    SmartPtr<VKBuffer> buf = new VKBuffer (dev, buf_id, alloc, size, usage, mem_prop);
 
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (buf->bind ()), NULL,
@@ -22,6 +22,8 @@
 #define XCAM_VK_MEMORY_H
 
 #include <vulkan/vulkan_std.h>
+#include <vulkan/vk_mem_allocator.h>
+#include <memory_accounting.h>
 
 namespace XCam {
 
@@ -35,11 +37,15 @@ public:
     void unmap ();
 
 protected:
+    // alloc may be a sub-range of a VKMemAllocator block, it is freed back on destruction
     explicit VKMemory (
-        const SmartPtr<VKDevice> dev, VkDeviceMemory id,
+        const SmartPtr<VKDevice> dev, const VKMemAllocation &alloc,
         uint32_t size, VkMemoryPropertyFlags mem_prop);
     VkDeviceMemory get_mem_id () const {
-        return _mem_id;
+        return _alloc.mem_id;
+    }
+    VkDeviceSize get_mem_offset () const {
+        return _alloc.offset;
     }
 
 private:
@@ -47,10 +53,11 @@ private:
 
 protected:
     const SmartPtr<VKDevice>     _dev;
-    VkDeviceMemory               _mem_id;
+    VKMemAllocation              _alloc;
     VkMemoryPropertyFlags        _mem_prop;
     uint32_t                     _size;
     void                        *_mapped_ptr;
+    MemoryCharge                 _mem_charge;
 };
 
 class VKBuffer
@@ -80,7 +87,7 @@ public:
 private:
     explicit VKBuffer (
         const SmartPtr<VKDevice> dev, VkBuffer buf_id,
-        VkDeviceMemory mem_id, uint32_t size,
+        const VKMemAllocation &alloc, uint32_t size,
         VkBufferUsageFlags usage, VkMemoryPropertyFlags prop);
     XCamReturn bind ();
 
@@ -190,7 +190,8 @@ VKComputePipeline::ensure_pipeline ()
     VkPipeline pipe_id;
     XCAM_VK_CHECK_RETURN (
         ERROR, vkCreateComputePipelines (
-            _dev->get_dev_id (), 0, 1, &pipeline_create_info, 0, &pipe_id),
+            _dev->get_dev_id (), _dev->get_pipeline_cache (), 1, &pipeline_create_info,
+            _allocator.ptr (), &pipe_id),
         XCAM_RETURN_ERROR_VULKAN, "VK create compute pipeline failed.");
 
     XCAM_ASSERT (XCAM_IS_VALID_VK_ID (pipe_id));
@@ -205,13 +206,32 @@ VKComputePipeline::update_bindings (const VKDescriptor::SetBindInfoArray &bind_a
         ERROR, _pool.ptr () && XCAM_IS_VALID_VK_ID (_desc_layout), XCAM_RETURN_ERROR_PARAM,
         "vk compute pipeline update bindins failed, pool was not set or desc_layout not ensured");
 
-    if (_desc_set.ptr ())
-        _desc_set.release ();
+    // buffers of pools come back frame after frame, reuse the set written for them
+    typedef std::list<SmartPtr<VKDescriptor::Set>> SetList;
+    for (SetList::iterator i = _desc_sets.begin (); i != _desc_sets.end (); ++i) {
+        if ((*i)->is_bound_to (bind_array)) {
+            _desc_set = *i;
+            _desc_sets.erase (i);
+            _desc_sets.push_front (_desc_set);
+            return XCAM_RETURN_NO_ERROR;
+        }
+    }
 
-    _desc_set = _pool->allocate_set (bind_array, _desc_layout);
-    XCAM_FAIL_RETURN (
-        ERROR, _desc_set.ptr (), XCAM_RETURN_ERROR_UNKNOWN,
-        "vk compute pipeline update bindins failed to allocate desc_set or update bindings");
+    if (_desc_sets.size () < XCAM_VK_DESC_SET_CACHE_SIZE) {
+        _desc_set = _pool->allocate_set (bind_array, _desc_layout);
+        XCAM_FAIL_RETURN (
+            ERROR, _desc_set.ptr (), XCAM_RETURN_ERROR_UNKNOWN,
+            "vk compute pipeline update bindins failed to allocate desc_set or update bindings");
+    } else {
+        // rewrite the least recently used one, previous submits were waited on
+        _desc_set = _desc_sets.back ();
+        _desc_sets.pop_back ();
+        XCamReturn ret = _desc_set->update_set (bind_array);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk compute pipeline update bindins failed to update desc_set");
+    }
+    _desc_sets.push_front (_desc_set);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -279,6 +299,7 @@ VKComputePipeline::get_compute_create_info (
     shader_stage_create_info.stage = shader->get_shader_stage_flags ();
     shader_stage_create_info.module = shader->get_shader_id ();
     shader_stage_create_info.pName = shader->get_func_name ();
+    shader_stage_create_info.pSpecializationInfo = shader->get_spec_info ();
 
     VkComputePipelineCreateInfo pipeline_create_info = { };
     pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
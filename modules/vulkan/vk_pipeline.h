@@ -25,6 +25,7 @@
 #include <vulkan/vk_descriptor.h>
 #include <vulkan/vk_device.h>
 #include <vulkan/vk_shader.h>
+#include <list>
 
 namespace XCam {
 
@@ -120,6 +121,8 @@ private:
     VkPipelineLayout                 _pipe_layout;
     VkDescriptorSetLayout            _desc_layout;
     SmartPtr<VKDescriptor::Set>      _desc_set;
+    // most recently used first
+    std::list<SmartPtr<VKDescriptor::Set>>  _desc_sets;
 };
 
 }
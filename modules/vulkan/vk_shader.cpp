@@ -31,6 +31,7 @@ VKShader::VKShader (SmartPtr<VKDevice> dev, VkShaderModule id, const char *name)
 {
     XCAM_IS_VALID_VK_ID (id);
     xcam_mem_clear (_name);
+    xcam_mem_clear (_spec_info);
     if (name)
         strncpy (_name, name, XCAM_VK_NAME_LENGTH - 1);
     strncpy (_func_name, "main", XCAM_VK_NAME_LENGTH - 1);
@@ -56,5 +57,34 @@ VKShader::set_name (const char *name)
     strncpy (_name, name, XCAM_VK_NAME_LENGTH - 1);
 }
 
+void
+VKShader::set_spec_const (uint32_t id, uint32_t value)
+{
+    for (size_t i = 0; i < _spec_entries.size (); ++i) {
+        if (_spec_entries[i].constantID == id) {
+            _spec_data[i] = value;
+            return;
+        }
+    }
+
+    VkSpecializationMapEntry entry;
+    entry.constantID = id;
+    entry.offset = _spec_data.size () * sizeof (uint32_t);
+    entry.size = sizeof (uint32_t);
+    _spec_entries.push_back (entry);
+    _spec_data.push_back (value);
+
+    _spec_info.mapEntryCount = _spec_entries.size ();
+    _spec_info.pMapEntries = _spec_entries.data ();
+    _spec_info.dataSize = _spec_data.size () * sizeof (uint32_t);
+    _spec_info.pData = _spec_data.data ();
+}
+
+const VkSpecializationInfo *
+VKShader::get_spec_info () const
+{
+    return _spec_entries.empty () ? NULL : &_spec_info;
+}
+
 
 }
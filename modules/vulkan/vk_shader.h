@@ -22,6 +22,7 @@
 #define XCAM_VK_SHADER_H
 
 #include <vulkan/vulkan_std.h>
+#include <vector>
 
 namespace XCam {
 
@@ -48,6 +49,11 @@ public:
         return _name;
     }
 
+    // 32-bit specialization constant of @id, set before the pipeline is created
+    void set_spec_const (uint32_t id, uint32_t value);
+    // NULL if no constant was set
+    const VkSpecializationInfo *get_spec_info () const;
+
 private:
     explicit VKShader (SmartPtr<VKDevice> dev, VkShaderModule id, const char *name = "null");
 
@@ -62,6 +68,9 @@ private:
     VkShaderStageFlagBits            _shader_stage;
     char                             _func_name [XCAM_VK_NAME_LENGTH];
     char                             _name [XCAM_VK_NAME_LENGTH];
+    std::vector<VkSpecializationMapEntry>  _spec_entries;
+    std::vector<uint32_t>            _spec_data;
+    VkSpecializationInfo             _spec_info;
 };
 
 typedef std::vector<SmartPtr<VKShader>> ShaderVec;
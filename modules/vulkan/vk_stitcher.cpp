@@ -0,0 +1,508 @@
+/*
+ * vk_stitcher.cpp - Vulkan stitcher implementation
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "surview_fisheye_dewarp.h"
+#include "fisheye_table_cache.h"
+#include "frame_latency.h"
+#include "memory_accounting.h"
+#include "vk_device.h"
+#include "vk_worker.h"
+#include "vk_video_buf_allocator.h"
+#include "vk_geomap_handler.h"
+#include "vk_blender.h"
+#include "vk_copy_handler.h"
+#include "vk_stitcher.h"
+
+#define VK_STITCHER_ALIGNMENT_X 16
+#define VK_STITCHER_ALIGNMENT_Y 4
+
+#define VK_STITCHER_RESERVED_BUF_COUNT 4
+
+#define MAP_FACTOR_X  16
+#define MAP_FACTOR_Y  16
+
+namespace XCam {
+
+namespace VKSitcherPriv {
+
+struct FisheyeDewarp {
+    SmartPtr<VKGeoMapHandler>    dewarp;
+    SmartPtr<BufferPool>         buf_pool;
+
+    XCamReturn set_dewarp_geo_table (
+        const CameraInfo &cam_info, const Stitcher::RoundViewSlice &view_slice,
+        const BowlDataConfig &bowl, bool use_cache);
+};
+
+struct Copier {
+    SmartPtr<VKCopyHandler>    copier;
+    uint32_t                   in_idx;
+
+    Copier () : in_idx (0) {}
+};
+typedef std::vector<Copier> Copiers;
+
+class StitcherImpl {
+    friend class XCam::VKStitcher;
+
+public:
+    StitcherImpl (VKStitcher *handler)
+        : _stitcher (handler)
+    {}
+
+    XCamReturn init_config (uint32_t count, const SmartPtr<VKCmdBuf> &cmdbuf);
+    XCamReturn fisheye_dewarp_to_table ();
+
+    XCamReturn record_dewarps (const SmartPtr<VKStitcher::StitcherParam> &param);
+    XCamReturn record_blenders (const SmartPtr<VKStitcher::StitcherParam> &param);
+    XCamReturn record_copiers (const SmartPtr<VKStitcher::StitcherParam> &param);
+
+    XCamReturn stop ();
+
+private:
+    XCamReturn init_fisheye (uint32_t idx);
+
+private:
+    FisheyeDewarp                 _fisheye[XCAM_STITCH_MAX_CAMERAS];
+    SmartPtr<VKBlender>           _blenders[XCAM_STITCH_MAX_CAMERAS];
+    Copiers                       _copiers;
+
+    // dewarp outputs of the frame being recorded
+    SmartPtr<VideoBuffer>         _dewarp_bufs[XCAM_STITCH_MAX_CAMERAS];
+    VKStitcher                   *_stitcher;
+};
+
+XCamReturn
+FisheyeDewarp::set_dewarp_geo_table (
+    const CameraInfo &cam_info, const Stitcher::RoundViewSlice &view_slice,
+    const BowlDataConfig &bowl, bool use_cache)
+{
+    PolyFisheyeDewarp fd;
+    fd.set_intrinsic_param (cam_info.calibration.intrinsic);
+    fd.set_extrinsic_param (cam_info.calibration.extrinsic);
+
+    uint32_t table_width, table_height;
+    table_width = view_slice.width / MAP_FACTOR_X;
+    table_height = view_slice.height / MAP_FACTOR_Y;
+
+    FisheyeTableCache cache;
+    SurViewFisheyeDewarp::MapTable map_table;
+    const PointFloat2 *table = NULL;
+    if (use_cache) {
+        cache.set_key (
+            cam_info.calibration.intrinsic, cam_info.calibration.extrinsic, bowl,
+            table_width, table_height, view_slice.width, view_slice.height);
+        // uploaded straight from the mapped file, no host copy of the table
+        table = cache.map ();
+    }
+
+    if (!table) {
+        map_table.resize (table_width * table_height);
+        fd.fisheye_dewarp (
+            map_table, table_width, table_height,
+            view_slice.width, view_slice.height, bowl);
+        if (use_cache)
+            cache.save (map_table);
+        table = map_table.data ();
+    }
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        dewarp->set_lookup_table (table, table_width, table_height),
+        XCAM_RETURN_ERROR_UNKNOWN,
+        "set fisheye dewarp lookup table failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::init_fisheye (uint32_t idx)
+{
+    FisheyeDewarp &fisheye = _fisheye[idx];
+    Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (idx);
+    const SmartPtr<VKDevice> &dev = _stitcher->get_vk_device ();
+
+    fisheye.dewarp = new VKGeoMapHandler (dev, "sitcher_singleconst_remapper");
+    XCAM_ASSERT (fisheye.dewarp.ptr ());
+    fisheye.dewarp->enable_allocator (false);
+
+    VideoBufferInfo buf_info;
+    buf_info.init (
+        V4L2_PIX_FMT_NV12, view_slice.width, view_slice.height,
+        XCAM_ALIGN_UP (view_slice.width, VK_STITCHER_ALIGNMENT_X),
+        XCAM_ALIGN_UP (view_slice.height, VK_STITCHER_ALIGNMENT_Y));
+
+    SmartPtr<BufferPool> pool = create_vk_buffer_pool (dev);
+    XCAM_ASSERT (pool.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, pool->set_video_info (buf_info) && xcam_ret_is_ok (pool->reserve (VK_STITCHER_RESERVED_BUF_COUNT)),
+        XCAM_RETURN_ERROR_MEM,
+        "vk-stitcher(%s) reserve dewarp buffer pool failed, width:%d, height:%d",
+        XCAM_STR (_stitcher->get_name ()), buf_info.width, buf_info.height);
+    fisheye.buf_pool = pool;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::init_config (uint32_t count, const SmartPtr<VKCmdBuf> &cmdbuf)
+{
+    uint32_t out_width, out_height;
+    _stitcher->get_output_size (out_width, out_height);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        XCamReturn ret = init_fisheye (i);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-stitcher(%s) init fisheye failed, idx:%d.", XCAM_STR (_stitcher->get_name ()), i);
+        _fisheye[i].dewarp->set_record_cmdbuf (cmdbuf);
+
+        const Stitcher::ImageOverlapInfo &overlap_info = _stitcher->get_overlap (i);
+        SmartPtr<VKBlender> blender =
+            create_vk_blender (_stitcher->get_vk_device ()).dynamic_cast_ptr<VKBlender> ();
+        XCAM_ASSERT (blender.ptr ());
+        blender->enable_allocator (false);
+        blender->set_record_cmdbuf (cmdbuf);
+        blender->set_output_size (out_width, out_height);
+        blender->set_merge_window (overlap_info.out_area);
+        blender->set_input_valid_area (overlap_info.left, 0);
+        blender->set_input_valid_area (overlap_info.right, 1);
+        blender->set_input_merge_area (overlap_info.left, 0);
+        blender->set_input_merge_area (overlap_info.right, 1);
+        _blenders[i] = blender;
+    }
+
+    Stitcher::CopyAreaArray areas = _stitcher->get_copy_area ();
+    uint32_t size = areas.size ();
+    for (uint32_t i = 0; i < size; ++i) {
+        XCAM_ASSERT (areas[i].in_idx < count);
+
+        Copier copier;
+        copier.in_idx = areas[i].in_idx;
+        copier.copier = new VKCopyHandler (_stitcher->get_vk_device (), "stitch_copy");
+        XCAM_ASSERT (copier.copier.ptr ());
+
+        copier.copier->enable_allocator (false);
+        copier.copier->set_record_cmdbuf (cmdbuf);
+        copier.copier->set_copy_area (areas[i].in_idx, areas[i].in_area, areas[i].out_area);
+        _copiers.push_back (copier);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::fisheye_dewarp_to_table ()
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        CameraInfo cam_info;
+        _stitcher->get_camera_info (i, cam_info);
+        Stitcher::RoundViewSlice view_slice = _stitcher->get_round_view_slice (i);
+
+        BowlDataConfig bowl = _stitcher->get_bowl_config ();
+        bowl.angle_start = view_slice.hori_angle_start;
+        bowl.angle_end = format_angle (view_slice.hori_angle_start + view_slice.hori_angle_range);
+
+        XCAM_ASSERT (_fisheye[i].dewarp.ptr ());
+        _fisheye[i].dewarp->set_output_size (view_slice.width, view_slice.height);
+
+        if (bowl.angle_end < bowl.angle_start)
+            bowl.angle_start -= 360.0f;
+
+        XCAM_LOG_INFO (
+            "vk-stitcher(%s) camera(idx:%d) info(angle start:%.2f, range:%.2f), bowl info(angle start:%.2f, end:%.2f)",
+            XCAM_STR (_stitcher->get_name ()), i,
+            view_slice.hori_angle_start, view_slice.hori_angle_range,
+            bowl.angle_start, bowl.angle_end);
+
+        XCamReturn ret = _fisheye[i].set_dewarp_geo_table (
+            cam_info, view_slice, bowl, _stitcher->is_table_cache_enabled ());
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-stitcher(%s) set dewarp geo table failed, idx:%d", XCAM_STR (_stitcher->get_name ()), i);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::record_dewarps (const SmartPtr<VKStitcher::StitcherParam> &param)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    XCAM_FAIL_RETURN (
+        ERROR, param->in_buf_num >= camera_num, XCAM_RETURN_ERROR_PARAM,
+        "vk-stitcher(%s) input buffer number(%d) is less than camera number(%d)",
+        XCAM_STR (_stitcher->get_name ()), param->in_buf_num, camera_num);
+
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        _dewarp_bufs[i] = _fisheye[i].buf_pool->get_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, _dewarp_bufs[i].ptr (), XCAM_RETURN_ERROR_MEM,
+            "vk-stitcher(%s) get dewarp buffer failed, idx:%d", XCAM_STR (_stitcher->get_name ()), i);
+
+        SmartPtr<ImageHandler::Parameters> dewarp_param =
+            new ImageHandler::Parameters (param->in_bufs[i], _dewarp_bufs[i]);
+        XCamReturn ret = _fisheye[i].dewarp->execute_buffer (dewarp_param, true);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-stitcher(%s) record fisheye dewarp failed, idx:%d",
+            XCAM_STR (_stitcher->get_name ()), i);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::record_blenders (const SmartPtr<VKStitcher::StitcherParam> &param)
+{
+    uint32_t camera_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < camera_num; ++i) {
+        SmartPtr<VKBlender::BlenderParam> blend_param = new VKBlender::BlenderParam (
+            _dewarp_bufs[i], _dewarp_bufs[(i + 1) % camera_num], param->out_buf);
+        XCamReturn ret = _blenders[i]->execute_buffer (blend_param, true);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-stitcher(%s) record blender failed, overlap idx:%d",
+            XCAM_STR (_stitcher->get_name ()), i);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::record_copiers (const SmartPtr<VKStitcher::StitcherParam> &param)
+{
+    for (uint32_t i = 0; i < _copiers.size (); ++i) {
+        SmartPtr<ImageHandler::Parameters> copy_param =
+            new ImageHandler::Parameters (_dewarp_bufs[_copiers[i].in_idx], param->out_buf);
+        XCamReturn ret = _copiers[i].copier->execute_buffer (copy_param, true);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk-stitcher(%s) record copier failed, i:%d idx:%d",
+            XCAM_STR (_stitcher->get_name ()), i, _copiers[i].in_idx);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitcherImpl::stop ()
+{
+    uint32_t cam_num = _stitcher->get_camera_num ();
+    for (uint32_t i = 0; i < cam_num; ++i) {
+        if (_fisheye[i].dewarp.ptr ()) {
+            _fisheye[i].dewarp->terminate ();
+            _fisheye[i].dewarp.release ();
+        }
+        if (_fisheye[i].buf_pool.ptr ()) {
+            _fisheye[i].buf_pool->stop ();
+        }
+        _dewarp_bufs[i].release ();
+
+        if (_blenders[i].ptr ()) {
+            _blenders[i]->terminate ();
+            _blenders[i].release ();
+        }
+    }
+
+    for (Copiers::iterator i_copier = _copiers.begin (); i_copier != _copiers.end (); ++i_copier) {
+        SmartPtr<VKCopyHandler> &copier = (*i_copier).copier;
+        if (copier.ptr ()) {
+            copier->terminate ();
+            copier.release ();
+        }
+    }
+    _copiers.clear ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+};
+
+VKStitcher::VKStitcher (const SmartPtr<VKDevice> &dev, const char *name)
+    : VKHandler (dev, name)
+    , Stitcher (VK_STITCHER_ALIGNMENT_X, VK_STITCHER_ALIGNMENT_X)
+{
+    SmartPtr<VKSitcherPriv::StitcherImpl> impl = new VKSitcherPriv::StitcherImpl (this);
+    XCAM_ASSERT (impl.ptr ());
+    _impl = impl;
+}
+
+VKStitcher::~VKStitcher ()
+{
+}
+
+XCamReturn
+VKStitcher::terminate ()
+{
+    _impl->stop ();
+    return VKHandler::terminate ();
+}
+
+XCamReturn
+VKStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !in_bufs.empty (), XCAM_RETURN_ERROR_PARAM,
+        "vk-stitcher(%s) stitch buffer failed, input buffers is empty", XCAM_STR (get_name ()));
+
+    // handlers of the stitcher are charged under it
+    MemoryOwnerScope mem_scope (get_name ());
+
+    SmartPtr<StitcherParam> param = new StitcherParam;
+    XCAM_ASSERT (param.ptr ());
+    param->out_buf = out_buf;
+
+    uint32_t count = 0;
+    for (VideoBufferList::const_iterator iter = in_bufs.begin(); iter != in_bufs.end (); ++iter) {
+        SmartPtr<VideoBuffer> buf = *iter;
+        XCAM_ASSERT (buf.ptr ());
+        param->in_bufs[count++] = buf;
+    }
+    param->in_buf_num = count;
+
+    XCamReturn ret = execute_buffer (param, true);
+    if (!out_buf.ptr () && xcam_ret_is_ok (ret)) {
+        out_buf = param->out_buf;
+    }
+    if (xcam_ret_is_ok (ret) && out_buf.ptr ()) {
+        FrameLatencyMeta::carry (param->in_bufs[0], out_buf);
+        FrameLatencyMeta::stamp (out_buf, "stitch");
+    }
+
+    return ret;
+}
+
+XCamReturn
+VKStitcher::configure_resource (const SmartPtr<Parameters> &param)
+{
+    XCAM_UNUSED (param);
+    XCAM_ASSERT (_impl.ptr ());
+
+    if (get_scale_mode () != ScaleSingleConst) {
+        XCAM_LOG_WARNING (
+            "vk-stitcher(%s) only supports single const scale mode, dual const is ignored",
+            XCAM_STR (get_name ()));
+    }
+
+    XCamReturn ret = estimate_round_slices ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) estimate round view slices failed", XCAM_STR (get_name ()));
+
+    ret = estimate_coarse_crops ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) estimate coarse crops failed", XCAM_STR (get_name ()));
+
+    ret = mark_centers ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) mark centers failed", XCAM_STR (get_name ()));
+
+    ret = estimate_overlap ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) estimake coarse overlap failed", XCAM_STR (get_name ()));
+
+    ret = update_copy_areas ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) update copy areas failed", XCAM_STR (get_name ()));
+
+    VideoBufferInfo out_info;
+    uint32_t out_width, out_height;
+    get_output_size (out_width, out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, out_width && out_height, XCAM_RETURN_ERROR_PARAM,
+        "vk-stitcher(%s) output size was not set", XCAM_STR (get_name ()));
+
+    _batch = new VKWorkerBatch (get_vk_device ());
+    ret = _batch->init ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) init worker batch failed", XCAM_STR (get_name ()));
+
+    uint32_t camera_count = get_camera_num ();
+    ret = _impl->init_config (camera_count, _batch->get_cmdbuf ());
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) initialize private config failed", XCAM_STR (get_name ()));
+
+    ret = _impl->fisheye_dewarp_to_table ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) fisheye_dewarp_to_table failed", XCAM_STR (get_name ()));
+
+    out_info.init (
+        V4L2_PIX_FMT_NV12, out_width, out_height,
+        XCAM_ALIGN_UP (out_width, VK_STITCHER_ALIGNMENT_X),
+        XCAM_ALIGN_UP (out_height, VK_STITCHER_ALIGNMENT_Y));
+    set_out_video_info (out_info);
+
+    return ret;
+}
+
+XCamReturn
+VKStitcher::start_work (const SmartPtr<Parameters> &base)
+{
+    XCAM_ASSERT (base.ptr ());
+    XCAM_ASSERT (_batch.ptr ());
+
+    SmartPtr<StitcherParam> param = base.dynamic_cast_ptr<StitcherParam> ();
+    XCAM_FAIL_RETURN (
+        ERROR, param.ptr () && param->in_buf_num > 0 && param->in_bufs[0].ptr () && param->out_buf.ptr (),
+        XCAM_RETURN_ERROR_PARAM,
+        "vk-stitcher(%s) start work failed, invalid parameters", XCAM_STR (get_name ()));
+
+    XCamReturn ret = _batch->begin ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) begin worker batch failed", XCAM_STR (get_name ()));
+
+    ret = _impl->record_dewarps (param);
+    if (xcam_ret_is_ok (ret))
+        ret = _batch->add_barrier (VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+    if (xcam_ret_is_ok (ret))
+        ret = _impl->record_blenders (param);
+    if (xcam_ret_is_ok (ret))
+        ret = _impl->record_copiers (param);
+    if (!xcam_ret_is_ok (ret)) {
+        _batch->discard ();
+        XCAM_LOG_ERROR ("vk-stitcher(%s) record frame failed", XCAM_STR (get_name ()));
+        return ret;
+    }
+
+    ret = _batch->submit_and_wait ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk-stitcher(%s) submit worker batch failed", XCAM_STR (get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<Stitcher>
+Stitcher::create_vk_stitcher ()
+{
+    return new VKStitcher (VKDevice::default_device ());
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+ * vk_stitcher.h - Vulkan stitcher class
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_VK_STITCHER_H
+#define XCAM_VK_STITCHER_H
+
+#include <interface/stitcher.h>
+#include <vulkan/vulkan_std.h>
+#include <vulkan/vk_handler.h>
+
+namespace XCam {
+
+class VKWorkerBatch;
+
+namespace VKSitcherPriv {
+class StitcherImpl;
+};
+
+/*
+ * dewarps, blenders and copiers of one frame are recorded into one command buffer,
+ * which is submitted once and waited by one fence.
+ */
+class VKStitcher
+    : public VKHandler
+    , public Stitcher
+{
+    friend class VKSitcherPriv::StitcherImpl;
+
+public:
+    struct StitcherParam
+        : ImageHandler::Parameters
+    {
+        uint32_t in_buf_num;
+        SmartPtr<VideoBuffer> in_bufs[XCAM_STITCH_MAX_CAMERAS];
+
+        StitcherParam ()
+            : Parameters (NULL, NULL)
+            , in_buf_num (0)
+        {}
+    };
+
+public:
+    explicit VKStitcher (const SmartPtr<VKDevice> &dev, const char *name = "VKStitcher");
+    ~VKStitcher ();
+
+    // derived from VKHandler
+    virtual XCamReturn terminate ();
+
+protected:
+    // interface derive from Stitcher
+    XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+
+    // derived from VKHandler
+    XCamReturn configure_resource (const SmartPtr<Parameters> &param);
+    XCamReturn start_work (const SmartPtr<Parameters> &param);
+
+private:
+    SmartPtr<VKSitcherPriv::StitcherImpl>    _impl;
+    SmartPtr<VKWorkerBatch>                  _batch;
+};
+
+}
+
+#endif // XCAM_VK_STITCHER_H
@@ -52,4 +52,116 @@ VKFence::wait (uint64_t timeout)
     return _dev->wait_for_fence (_fence_id, timeout);
 }
 
+VKTimeline::VKTimeline (const SmartPtr<VKDevice> dev, VkSemaphore id)
+    : _semaphore_id (id)
+    , _last_value (0)
+    , _dev (dev)
+{
+}
+
+VKTimeline::~VKTimeline ()
+{
+    if (_dev.ptr () && XCAM_IS_VALID_VK_ID (_semaphore_id))
+        _dev->destroy_semaphore (_semaphore_id);
+}
+
+uint64_t
+VKTimeline::next_value ()
+{
+    SmartLock locker (_mutex);
+    return ++_last_value;
+}
+
+XCamReturn
+VKTimeline::wait (uint64_t value, uint64_t timeout)
+{
+    XCAM_ASSERT (_dev.ptr ());
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_semaphore_id));
+    return _dev->wait_semaphore (_semaphore_id, value, timeout);
+}
+
+XCamReturn
+VKTimeline::get_value (uint64_t &value)
+{
+    XCAM_ASSERT (_dev.ptr ());
+    XCAM_ASSERT (XCAM_IS_VALID_VK_ID (_semaphore_id));
+    return _dev->get_semaphore_value (_semaphore_id, value);
+}
+
+XCamReturn
+VKSyncPoint::wait (uint64_t timeout) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, timeline.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "vk sync point wait failed, timeline is null");
+    return timeline->wait (value, timeout);
+}
+
+VKCompletionThread::VKCompletionThread (const char *name)
+    : Thread (name)
+{
+}
+
+VKCompletionThread::~VKCompletionThread ()
+{
+    drain ();
+}
+
+XCamReturn
+VKCompletionThread::add (const VKSyncPoint &point, const SmartPtr<VKCompletion> &completion)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, point.is_valid () && completion.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "vk completion thread add failed, sync point or completion is null");
+
+    SmartLock locker (_mutex);
+    Pending pending;
+    pending.point = point;
+    pending.completion = completion;
+    _pending.push_back (pending);
+    _pending_cond.broadcast ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+VKCompletionThread::loop ()
+{
+    Pending pending;
+    {
+        SmartLock locker (_mutex);
+        if (_pending.empty ()) {
+            _pending_cond.timedwait (_mutex, XCAM_VK_COMPLETION_WAIT_TIMEOUT / 1000);
+            return true;
+        }
+        pending = _pending.front ();
+    }
+
+    XCamReturn ret = pending.point.wait (XCAM_VK_COMPLETION_WAIT_TIMEOUT);
+    if (ret == XCAM_RETURN_ERROR_TIMEOUT)
+        return true;
+
+    {
+        SmartLock locker (_mutex);
+        _pending.pop_front ();
+    }
+    pending.completion->complete (ret);
+    return true;
+}
+
+void
+VKCompletionThread::drain ()
+{
+    XCAM_ASSERT (!is_running ());
+
+    PendingList pending_list;
+    {
+        SmartLock locker (_mutex);
+        pending_list.swap (_pending);
+    }
+    for (PendingList::iterator i = pending_list.begin (); i != pending_list.end (); ++i) {
+        XCamReturn ret = i->point.wait ();
+        i->completion->complete (ret);
+    }
+}
+
 }
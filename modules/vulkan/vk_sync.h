@@ -22,6 +22,12 @@
 #define XCAM_VK_SYNC_H
 
 #include <vulkan/vulkan_std.h>
+#include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <list>
+
+// completion thread rechecks stop request at least this often
+#define XCAM_VK_COMPLETION_WAIT_TIMEOUT 10000000 // ns
 
 namespace XCam {
 
@@ -51,6 +57,92 @@ protected:
     SmartPtr<VKDevice>       _dev;
 };
 
+/*
+ * VKTimeline, a timeline semaphore (VK_KHR_timeline_semaphore),
+ * every submit signals a bigger value than the one before.
+ */
+class VKTimeline
+{
+    friend class VKDevice;
+public:
+    virtual ~VKTimeline ();
+
+    // value for next submit to signal
+    uint64_t next_value ();
+    XCamReturn wait (uint64_t value, uint64_t timeout = UINT64_MAX);
+    XCamReturn get_value (uint64_t &value);
+
+    VkSemaphore get_semaphore_id () const {
+        return _semaphore_id;
+    }
+
+protected:
+    explicit VKTimeline (const SmartPtr<VKDevice> dev, VkSemaphore id);
+
+private:
+    XCAM_DEAD_COPY (VKTimeline);
+
+protected:
+    VkSemaphore              _semaphore_id;
+    uint64_t                 _last_value;
+    Mutex                    _mutex;
+    SmartPtr<VKDevice>       _dev;
+};
+
+// future of a submit, done once timeline reaches value
+struct VKSyncPoint {
+    SmartPtr<VKTimeline>     timeline;
+    uint64_t                 value;
+
+    VKSyncPoint () : value (0) {}
+    VKSyncPoint (const SmartPtr<VKTimeline> &t, uint64_t v) : timeline (t), value (v) {}
+    bool is_valid () const {
+        return timeline.ptr () != NULL;
+    }
+    XCamReturn wait (uint64_t timeout = UINT64_MAX) const;
+};
+
+class VKCompletion
+{
+public:
+    virtual ~VKCompletion () {}
+    virtual void complete (XCamReturn error) = 0;
+};
+
+/*
+ * VKCompletionThread, waits sync points in the order added and runs their
+ * completions on this one thread, submitting threads don't block in waits.
+ * completions still pending on stop are run by drain ().
+ */
+class VKCompletionThread
+    : public Thread
+{
+    struct Pending {
+        VKSyncPoint                point;
+        SmartPtr<VKCompletion>     completion;
+    };
+    typedef std::list<Pending> PendingList;
+
+public:
+    explicit VKCompletionThread (const char *name = "vk-completion");
+    ~VKCompletionThread ();
+
+    XCamReturn add (const VKSyncPoint &point, const SmartPtr<VKCompletion> &completion);
+    // waits and completes pending ones on caller thread, thread must be stopped
+    void drain ();
+
+protected:
+    virtual bool loop ();
+
+private:
+    XCAM_DEAD_COPY (VKCompletionThread);
+
+private:
+    PendingList                    _pending;
+    Mutex                          _mutex;
+    Cond                           _pending_cond;
+};
+
 }
 
 #endif  //XCAM_VK_SYNC_H
@@ -0,0 +1,153 @@
+/*
+ * vk_uploader.cpp - upload host frames into device local buffers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "vk_uploader.h"
+#include "vk_device.h"
+#include "vk_memory.h"
+
+namespace XCam {
+
+VKUploader::VKUploader (const SmartPtr<VKDevice> &dev, uint32_t ring_size)
+    : _dev (dev)
+    , _ring_size (XCAM_MAX (ring_size, 1u))
+    , _slot_size (0)
+    , _next (0)
+{
+}
+
+VKUploader::~VKUploader ()
+{
+    finish ();
+}
+
+XCamReturn
+VKUploader::init (uint32_t slot_size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _dev.ptr () && slot_size, XCAM_RETURN_ERROR_PARAM,
+        "vk uploader init failed, device is null or slot size is zero");
+    XCAM_FAIL_RETURN (
+        ERROR, _dev->has_timeline_semaphore (), XCAM_RETURN_ERROR_VULKAN,
+        "vk uploader init failed, device has no timeline semaphore");
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _slots.empty (), XCAM_RETURN_ERROR_ORDER,
+        "vk uploader was inited");
+
+    if (!_dev->has_transfer_queue ()) {
+        XCAM_LOG_INFO ("vk uploader has no dedicated transfer queue, copies run on compute queue");
+    }
+
+    _cmd_pool = VKCmdBuf::create_pool (_dev, VK_QUEUE_TRANSFER_BIT);
+    _timeline = _dev->create_timeline ();
+    XCAM_FAIL_RETURN (
+        ERROR, _cmd_pool.ptr () && _timeline.ptr (), XCAM_RETURN_ERROR_VULKAN,
+        "vk uploader init failed when creating command pool or timeline");
+
+    std::vector<Slot> slots (_ring_size);
+    for (uint32_t i = 0; i < _ring_size; ++i) {
+        Slot &slot = slots[i];
+        slot.staging = VKBuffer::create_buffer (_dev, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, slot_size);
+        XCAM_FAIL_RETURN (
+            ERROR, slot.staging.ptr (), XCAM_RETURN_ERROR_MEM,
+            "vk uploader init failed when creating staging buffer(idx:%d, size:%d)", i, slot_size);
+
+        // stays mapped, memory is host coherent
+        slot.ptr = (uint8_t *)slot.staging->map ();
+        slot.cmdbuf = _cmd_pool->allocate_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, slot.ptr && slot.cmdbuf.ptr (), XCAM_RETURN_ERROR_VULKAN,
+            "vk uploader init failed when mapping staging buffer or allocating cmdbuf(idx:%d)", i);
+    }
+
+    _slots.swap (slots);
+    _slot_size = slot_size;
+    _next = 0;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<VKBuffer>
+VKUploader::create_device_buffer (uint32_t size)
+{
+    return VKBuffer::create_buffer (
+        _dev, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        size, NULL, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+XCamReturn
+VKUploader::upload (const void *data, uint32_t size, const SmartPtr<VKBuffer> &dst, VKSyncPoint &done)
+{
+    XCAM_ASSERT (data && dst.ptr ());
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_slots.empty (), XCAM_RETURN_ERROR_ORDER,
+        "vk uploader upload failed, not inited");
+    XCAM_FAIL_RETURN (
+        ERROR, size && size <= _slot_size, XCAM_RETURN_ERROR_PARAM,
+        "vk uploader upload failed, size:%d exceeds slot size:%d", size, _slot_size);
+
+    Slot &slot = _slots[_next];
+    // staging slot is still read by a copy of frames before
+    if (slot.done.is_valid ()) {
+        XCamReturn ret = slot.done.wait ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk uploader wait staging slot(idx:%d) failed", _next);
+    }
+
+    memcpy (slot.ptr, data, size);
+
+    XCamReturn ret = slot.cmdbuf->record_copy (slot.staging, dst, size);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk uploader record copy failed");
+
+    VKSyncPoint signal (_timeline, _timeline->next_value ());
+    ret = _dev->transfer_queue_submit (slot.cmdbuf, VKSyncPoint (), signal);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk uploader submit copy failed");
+
+    slot.done = signal;
+    done = signal;
+    _next = (_next + 1) % _slots.size ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKUploader::finish ()
+{
+    SmartLock locker (_mutex);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < _slots.size (); ++i) {
+        if (!_slots[i].done.is_valid ())
+            continue;
+
+        XCamReturn wait_ret = _slots[i].done.wait ();
+        if (!xcam_ret_is_ok (wait_ret))
+            ret = wait_ret;
+        _slots[i].done = VKSyncPoint ();
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+ * vk_uploader.h - upload host frames into device local buffers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_VK_UPLOADER_H
+#define XCAM_VK_UPLOADER_H
+
+#include <vulkan/vulkan_std.h>
+#include <vulkan/vk_cmdbuf.h>
+#include <vulkan/vk_sync.h>
+#include <xcam_mutex.h>
+#include <vector>
+
+#define XCAM_VK_UPLOAD_RING_SIZE 3
+
+namespace XCam {
+
+class VKDevice;
+class VKBuffer;
+
+/*
+ * VKUploader, host frames go through a ring of host-visible staging buffers
+ * and are copied into device local buffers on the transfer queue of device,
+ * so upload of frame N+1 overlaps compute on frame N. compute waits on GPU
+ * for the returned sync point, e.g. through VKHandler::set_wait_point.
+ * CPU only blocks when copies of all staging slots are still running.
+ * needs timeline semaphore on device.
+ */
+class VKUploader
+{
+    struct Slot {
+        SmartPtr<VKBuffer>   staging;
+        uint8_t             *ptr;
+        SmartPtr<VKCmdBuf>   cmdbuf;
+        VKSyncPoint          done;
+
+        Slot () : ptr (NULL) {}
+    };
+
+public:
+    explicit VKUploader (const SmartPtr<VKDevice> &dev, uint32_t ring_size = XCAM_VK_UPLOAD_RING_SIZE);
+    ~VKUploader ();
+
+    // staging slots of @slot_size bytes
+    XCamReturn init (uint32_t slot_size);
+
+    // storage buffer in device local memory, destination of upload
+    SmartPtr<VKBuffer> create_device_buffer (uint32_t size);
+    // @done signals once @dst holds @data
+    XCamReturn upload (const void *data, uint32_t size, const SmartPtr<VKBuffer> &dst, VKSyncPoint &done);
+    // waits for all copies in flight
+    XCamReturn finish ();
+
+private:
+    XCAM_DEAD_COPY (VKUploader);
+
+private:
+    SmartPtr<VKDevice>              _dev;
+    SmartPtr<VKCmdBuf::Pool>        _cmd_pool;
+    SmartPtr<VKTimeline>            _timeline;
+    std::vector<Slot>               _slots;
+    uint32_t                        _ring_size;
+    uint32_t                        _slot_size;
+    uint32_t                        _next;
+    Mutex                           _mutex;
+};
+
+}
+
+#endif  //XCAM_VK_UPLOADER_H
@@ -80,8 +80,9 @@ VKVideoData::unmap ()
     return true;
 }
 
-VKVideoBufAllocator::VKVideoBufAllocator (const SmartPtr<VKDevice> dev)
+VKVideoBufAllocator::VKVideoBufAllocator (const SmartPtr<VKDevice> dev, VkMemoryPropertyFlags mem_prop)
     : _dev (dev)
+    , _mem_prop (mem_prop)
 {
 }
 
@@ -96,8 +97,12 @@ VKVideoBufAllocator::allocate_data (const VideoBufferInfo &buffer_info)
         ERROR, buffer_info.size, NULL,
         "VKVideoBufAllocator allocate data failed. buf_size is zero");
 
+    // copy areas are copied by vkCmdCopyBuffer
+    VkBufferUsageFlags usage =
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
     SmartPtr<VKBuffer> vk_buf =
-        VKBuffer::create_buffer (_dev, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, buffer_info.size);
+        VKBuffer::create_buffer (_dev, usage, buffer_info.size, NULL, _mem_prop);
 
     XCAM_FAIL_RETURN (
         ERROR, vk_buf.ptr (), NULL,
@@ -21,6 +21,7 @@
 #ifndef XCAM_VK_VIDEO_BUF_ALLOCATOR_H
 #define XCAM_VK_VIDEO_BUF_ALLOCATOR_H
 
+#include <vulkan/vulkan_std.h>
 #include <buffer_pool.h>
 
 namespace XCam {
@@ -32,7 +33,10 @@ class VKVideoBufAllocator
     : public BufferPool
 {
 public:
-    explicit VKVideoBufAllocator (const SmartPtr<VKDevice> dev);
+    // buffers in DEVICE_LOCAL memory can't be mapped, they are filled by VKUploader
+    explicit VKVideoBufAllocator (
+        const SmartPtr<VKDevice> dev,
+        VkMemoryPropertyFlags mem_prop = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     virtual ~VKVideoBufAllocator ();
 
 private:
@@ -42,6 +46,7 @@ private:
 
 private:
     SmartPtr<VKDevice>     _dev;
+    VkMemoryPropertyFlags  _mem_prop;
 };
 
 class VKVideoBuffer
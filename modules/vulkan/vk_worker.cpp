@@ -63,9 +63,27 @@ VKWorker::VKArguments::add_push_const (const SmartPtr<VKConstRange::VKPushConstA
     return true;
 }
 
+class VKWorker::Completion
+    : public VKCompletion
+{
+public:
+    Completion (const SmartPtr<VKWorker> &worker, const SmartPtr<Worker::Arguments> &args)
+        : _worker (worker)
+        , _args (args)
+    {}
+    void complete (XCamReturn error) {
+        _worker->status_check (_args, error);
+    }
+
+private:
+    SmartPtr<VKWorker>             _worker;
+    SmartPtr<Worker::Arguments>    _args;
+};
+
 VKWorker::VKWorker (SmartPtr<VKDevice> dev, const char *name, const SmartPtr<Callback> &cb)
     : Worker (name, cb)
     , _device (dev)
+    , _async (false)
 {
 }
 
@@ -99,11 +117,13 @@ VKWorker::build (
         ERROR, shader.ptr (), XCAM_RETURN_ERROR_VULKAN,
         "vk woker(%s) build failed when creating shader.", XCAM_STR (get_name ()));
     shader->set_func_name (info.func_name.c_str ());
+    for (size_t i = 0; i < info.spec_consts.size (); ++i)
+        shader->set_spec_const (info.spec_consts[i].id, info.spec_consts[i].value);
 
     _desc_pool = new VKDescriptor::Pool (_device);
     XCAM_ASSERT (_desc_pool.ptr ());
     XCAM_FAIL_RETURN (
-        ERROR, _desc_pool->add_set_bindings (bindings), XCAM_RETURN_ERROR_VULKAN,
+        ERROR, _desc_pool->add_set_bindings (bindings, XCAM_VK_DESC_SET_CACHE_SIZE), XCAM_RETURN_ERROR_VULKAN,
         "vk woker(%s) build failed to add bindings to desc_pool", XCAM_STR (get_name ()));
     ret = _desc_pool->create ();
     XCAM_FAIL_RETURN (
@@ -129,6 +149,13 @@ VKWorker::build (
         ERROR, _cmdbuf.ptr (), XCAM_RETURN_ERROR_VULKAN,
         "vk woker(%s) build failed when creating command buffers.", XCAM_STR (get_name ()));
 
+    if (_device->has_timeline_semaphore ()) {
+        _timeline = _device->create_timeline ();
+        if (!_timeline.ptr ()) {
+            XCAM_LOG_WARNING ("vk woker(%s) create timeline failed, fence is used.", XCAM_STR (get_name ()));
+        }
+    }
+
     _fence = _device->create_fence (VK_FENCE_CREATE_SIGNALED_BIT);
     XCAM_FAIL_RETURN (
         ERROR, _fence.ptr (), XCAM_RETURN_ERROR_VULKAN,
@@ -136,9 +163,9 @@ VKWorker::build (
     return XCAM_RETURN_NO_ERROR;
 }
 
-// derived from Worker
 XCamReturn
-VKWorker::work (const SmartPtr<Worker::Arguments> &args)
+VKWorker::prepare_dispatch (
+    const SmartPtr<Worker::Arguments> &args, SmartPtr<VKCmdBuf::DispatchParam> &dispatch)
 {
     SmartPtr<VKArguments> vk_args = args.dynamic_cast_ptr<VKArguments>();
     XCAM_FAIL_RETURN (
@@ -164,14 +191,69 @@ VKWorker::work (const SmartPtr<Worker::Arguments> &args)
         "vk woker(%s) update binding argements failed.", XCAM_STR (get_name ()));
 
     const WorkSize global = get_global_size ();
-    SmartPtr<VKCmdBuf::DispatchParam> dispatch  =
-        new VKCmdBuf::DispatchParam (_pipeline, global.value[0], global.value[1], global.value[2]);
+    dispatch = new VKCmdBuf::DispatchParam (_pipeline, global.value[0], global.value[1], global.value[2]);
     if (!push_consts.empty()) {
         XCAM_FAIL_RETURN (
             ERROR, dispatch->update_push_consts (push_consts), XCAM_RETURN_ERROR_PARAM,
             "vk woker(%s) update push-consts failed.", XCAM_STR (get_name ()));
     }
 
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// derived from Worker
+XCamReturn
+VKWorker::submit_timeline (const SmartPtr<Worker::Arguments> &args)
+{
+    // cmdbuf and descriptor sets of last submit are reused, usually done by now
+    if (_done_point.is_valid ()) {
+        XCamReturn ret = _done_point.wait ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "vk woker(%s) wait last submit failed.", XCAM_STR (get_name ()));
+    }
+
+    SmartPtr<VKCmdBuf::DispatchParam> dispatch;
+    XCamReturn ret = prepare_dispatch (args, dispatch);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) prepare dispatch failed.", XCAM_STR (get_name ()));
+
+    ret = _cmdbuf->record (dispatch);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) record cmdbuf failed.", XCAM_STR (get_name ()));
+
+    VKSyncPoint signal (_timeline, _timeline->next_value ());
+    ret = _device->compute_queue_submit (_cmdbuf, _wait_point, signal);
+    _wait_point = VKSyncPoint ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) submit compute queue with timeline failed.", XCAM_STR (get_name ()));
+    _done_point = signal;
+
+    SmartPtr<VKCompletionThread> completion_thread;
+    if (_async)
+        completion_thread = _device->get_completion_thread ();
+    if (completion_thread.ptr ())
+        return completion_thread->add (signal, new Completion (this, args));
+
+    status_check (args, ret);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKWorker::work (const SmartPtr<Worker::Arguments> &args)
+{
+    if (_timeline.ptr ())
+        return submit_timeline (args);
+
+    SmartPtr<VKCmdBuf::DispatchParam> dispatch;
+    XCamReturn ret = prepare_dispatch (args, dispatch);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) prepare dispatch failed.", XCAM_STR (get_name ()));
+
     ret = _cmdbuf->record (dispatch);
     XCAM_FAIL_RETURN (
         ERROR, xcam_ret_is_ok (ret), ret,
@@ -187,11 +269,35 @@ VKWorker::work (const SmartPtr<Worker::Arguments> &args)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+VKWorker::record (const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<Worker::Arguments> &args)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, cmdbuf.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "vk woker(%s) record failed, cmdbuf is null.", XCAM_STR (get_name ()));
+
+    SmartPtr<VKCmdBuf::DispatchParam> dispatch;
+    XCamReturn ret = prepare_dispatch (args, dispatch);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) prepare dispatch failed.", XCAM_STR (get_name ()));
+
+    ret = cmdbuf->record_dispatch (dispatch);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk woker(%s) record dispatch failed.", XCAM_STR (get_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 VKWorker::stop ()
 {
     if (_pipeline.ptr () && _device.ptr ()) {
-        if (_fence.ptr ()) {
+        if (_timeline.ptr ()) {
+            if (_done_point.is_valid ())
+                _done_point.wait ();
+        } else if (_fence.ptr ()) {
             _fence->wait ();
             _fence->reset ();
         }
@@ -204,7 +310,13 @@ XCamReturn
 VKWorker::wait_fence ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    if (_fence.ptr ()) {
+    if (_timeline.ptr ()) {
+        if (_done_point.is_valid ())
+            ret = _done_point.wait ();
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_ERROR ("vk woker(%s) wait timeline failed.", XCAM_STR (get_name ()));
+        }
+    } else if (_fence.ptr ()) {
         ret = _fence->wait ();
         if (!xcam_ret_is_ok (ret)) {
             XCAM_LOG_ERROR ("vk woker(%s) wait fence failed.", XCAM_STR (get_name ()));
@@ -215,4 +327,114 @@ VKWorker::wait_fence ()
     return ret;
 }
 
+VKWorkerBatch::VKWorkerBatch (const SmartPtr<VKDevice> &dev)
+    : _device (dev)
+    , _recording (false)
+{
+}
+
+VKWorkerBatch::~VKWorkerBatch ()
+{
+    if (_recording)
+        discard ();
+}
+
+XCamReturn
+VKWorkerBatch::init ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _device.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "vk worker batch init failed, device is null.");
+
+    _cmdbuf = VKCmdBuf::create_command_buffer (_device);
+    XCAM_FAIL_RETURN (
+        ERROR, _cmdbuf.ptr (), XCAM_RETURN_ERROR_VULKAN,
+        "vk worker batch init failed when creating command buffer.");
+
+    _fence = _device->create_fence (0);
+    XCAM_FAIL_RETURN (
+        ERROR, _fence.ptr (), XCAM_RETURN_ERROR_VULKAN,
+        "vk worker batch init failed when creating fence.");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKWorkerBatch::begin ()
+{
+    XCAM_ASSERT (_cmdbuf.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !_recording, XCAM_RETURN_ERROR_ORDER,
+        "vk worker batch begin failed, batch is recording.");
+
+    XCamReturn ret = _cmdbuf->begin ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk worker batch begin command buffer failed.");
+
+    _recording = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+VKWorkerBatch::add (const SmartPtr<VKWorker> &worker, const SmartPtr<Worker::Arguments> &args)
+{
+    XCAM_ASSERT (worker.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, _recording, XCAM_RETURN_ERROR_ORDER,
+        "vk worker batch add worker(%s) failed, batch not begun.", XCAM_STR (worker->get_name ()));
+
+    return worker->record (_cmdbuf, args);
+}
+
+XCamReturn
+VKWorkerBatch::add_barrier (VkPipelineStageFlags dst_stage)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _recording, XCAM_RETURN_ERROR_ORDER,
+        "vk worker batch add barrier failed, batch not begun.");
+
+    return _cmdbuf->insert_barrier (dst_stage);
+}
+
+XCamReturn
+VKWorkerBatch::submit_and_wait ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _recording, XCAM_RETURN_ERROR_ORDER,
+        "vk worker batch submit failed, batch not begun.");
+    _recording = false;
+
+    // copies recorded by copy handlers write on transfer stage
+    XCamReturn ret = _cmdbuf->insert_barrier (
+        VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+    XCamReturn end_ret = _cmdbuf->end ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret) && xcam_ret_is_ok (end_ret), XCAM_RETURN_ERROR_VULKAN,
+        "vk worker batch end command buffer failed.");
+
+    ret = _device->compute_queue_submit (_cmdbuf, _fence);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk worker batch submit compute queue failed.");
+
+    ret = _fence->wait ();
+    _fence->reset ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "vk worker batch wait fence failed.");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+VKWorkerBatch::discard ()
+{
+    if (!_recording)
+        return;
+
+    _recording = false;
+    _cmdbuf->end ();
+}
+
 }
@@ -23,6 +23,8 @@
 
 #include <vulkan/vulkan_std.h>
 #include <vulkan/vk_descriptor.h>
+#include <vulkan/vk_cmdbuf.h>
+#include <vulkan/vk_sync.h>
 #include <worker.h>
 #include <string>
 
@@ -31,18 +33,26 @@ namespace XCam {
 class VKPipeline;
 class VKDevice;
 class VKFence;
-class VKCmdBuf;
 
 enum VKSahderInfoType {
     VKSahderInfoSpirVBinary = 0,
     VKSahderInfoSpirVPath   = 1,
 };
 
+struct VKSpecConst {
+    uint32_t                   id;
+    uint32_t                   value;
+
+    VKSpecConst (uint32_t i, uint32_t v) : id (i), value (v) {}
+};
+
 struct VKShaderInfo {
     VKSahderInfoType           type;
     std::string                func_name;
     std::string                spirv_path;
     std::vector<uint32_t>      spirv_bin;
+    // specialization constants the pipeline is built with
+    std::vector<VKSpecConst>   spec_consts;
 
     VKShaderInfo () {}
     VKShaderInfo (const char *func, const char *path)
@@ -95,9 +105,34 @@ public:
     // derived from Worker
     virtual XCamReturn work (const SmartPtr<Arguments> &args);
     virtual XCamReturn stop ();
+    // waits for the last submit, on timeline semaphore when device has it
     XCamReturn wait_fence ();
 
+    // with timeline semaphore, callback runs on completion thread of device
+    // once GPU is done, work () returns right after submit
+    void set_async (bool async) {
+        _async = async;
+    }
+    // next submit waits on GPU for @point, chains work of other workers
+    void set_wait_point (const VKSyncPoint &point) {
+        _wait_point = point;
+    }
+    // invalid without timeline semaphore
+    const VKSyncPoint &get_done_point () const {
+        return _done_point;
+    }
+
+    // record dispatch into cmdbuf of caller, which submits and waits,
+    // bindings stay valid until next work or record of this worker
+    XCamReturn record (const SmartPtr<VKCmdBuf> &cmdbuf, const SmartPtr<Arguments> &args);
+
 private:
+    class Completion;
+
+    XCamReturn prepare_dispatch (
+        const SmartPtr<Arguments> &args, SmartPtr<VKCmdBuf::DispatchParam> &dispatch);
+    XCamReturn submit_timeline (const SmartPtr<Arguments> &args);
+
     XCAM_DEAD_COPY (VKWorker);
 
 private:
@@ -106,6 +141,47 @@ private:
     SmartPtr<VKPipeline>           _pipeline;
     SmartPtr<VKFence>              _fence;
     SmartPtr<VKCmdBuf>             _cmdbuf;
+    SmartPtr<VKTimeline>           _timeline;
+    VKSyncPoint                    _wait_point;
+    VKSyncPoint                    _done_point;
+    bool                           _async;
+};
+
+/*
+ * batch dispatches of several workers into one command buffer, submitted once with one fence.
+ * begin () -> add ()/add_barrier () ... -> submit_and_wait (), discard () drops a failed batch.
+ */
+class VKWorkerBatch
+{
+public:
+    explicit VKWorkerBatch (const SmartPtr<VKDevice> &dev);
+    ~VKWorkerBatch ();
+
+    XCamReturn init ();
+
+    // handlers set by VKHandler::set_record_cmdbuf record into this buffer
+    const SmartPtr<VKCmdBuf> &get_cmdbuf () const {
+        return _cmdbuf;
+    }
+    bool is_recording () const {
+        return _recording;
+    }
+
+    XCamReturn begin ();
+    XCamReturn add (const SmartPtr<VKWorker> &worker, const SmartPtr<Worker::Arguments> &args);
+    // later dispatches, or copies of @dst_stage, see writes of previous dispatches
+    XCamReturn add_barrier (VkPipelineStageFlags dst_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    XCamReturn submit_and_wait ();
+    void discard ();
+
+private:
+    XCAM_DEAD_COPY (VKWorkerBatch);
+
+private:
+    SmartPtr<VKDevice>             _device;
+    SmartPtr<VKCmdBuf>             _cmdbuf;
+    SmartPtr<VKFence>              _fence;
+    bool                           _recording;
 };
 
 }
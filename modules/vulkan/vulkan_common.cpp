@@ -19,6 +19,7 @@
  */
 
 #include "vulkan_common.h"
+#include "vk_instance.h"
 #include <map>
 
 #define VK_STR_INSERT(ERR)    \
@@ -74,4 +75,31 @@ xcam_default_shader_path ()
     return home + "/.xcam/vk";
 }
 
+void
+vk_get_local_size (uint32_t &x, uint32_t &y)
+{
+    x = y = XCAM_VK_DEFAULT_LOCAL_SIZE;
+
+    const char *env = std::getenv (XCAM_VK_LOCAL_SIZE);
+    uint32_t env_x = 0, env_y = 0;
+    if (env && sscanf (env, "%ux%u", &env_x, &env_y) == 2 && env_x && env_y) {
+        x = env_x;
+        y = env_y;
+    }
+
+    SmartPtr<VKInstance> instance = VKInstance::get_instance ();
+    if (!instance.ptr ())
+        return;
+
+    const VkPhysicalDeviceLimits &limits = instance->get_device_properties ().limits;
+    x = XCAM_MIN (x, limits.maxComputeWorkGroupSize[0]);
+    y = XCAM_MIN (y, limits.maxComputeWorkGroupSize[1]);
+    while (x * y > limits.maxComputeWorkGroupInvocations) {
+        if (x >= y)
+            x = XCAM_MAX (x / 2, 1u);
+        else
+            y = XCAM_MAX (y / 2, 1u);
+    }
+}
+
 }
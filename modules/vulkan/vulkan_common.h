@@ -24,10 +24,16 @@
 #include <vulkan/vulkan_std.h>
 #include <string>
 
+// work group size of specialized shaders, "<x>x<y>", default 8x8
+#define XCAM_VK_LOCAL_SIZE "XCAM_VK_LOCAL_SIZE"
+#define XCAM_VK_DEFAULT_LOCAL_SIZE 8
+
 namespace XCam {
 
 const char* vk_error_str(VkResult id);
 const std::string xcam_default_shader_path ();
+// work group size for shaders with specialized local size, within device limits
+void vk_get_local_size (uint32_t &x, uint32_t &y);
 }
 
 #endif
@@ -122,7 +122,7 @@ XCam3AAiqContext::setup_stats_pool (uint32_t bit_depth)
         false,
         "3a stats set video info failed");
 
-    if (!pool->reserve (6)) {
+    if (!xcam_ret_is_ok (pool->reserve (6))) {
         XCAM_LOG_WARNING ("init_3a_stats_pool failed to reserve stats buffer.");
         return false;
     }
@@ -76,6 +76,9 @@ void DigitalVideoStabilizer::setConfig(DvsConfig* config)
     _videoStab->setFrameSize(cv::Size(config->frame_width, config->frame_height));
     _videoStab->configMotionFilter(config->radius, config->stdev);
     _videoStab->configFeatureDetector(config->features, config->minDistance);
+    _videoStab->configAnalysis(
+        config->analysis_scale, config->grid_cols, config->grid_rows, config->min_tracked,
+        cv::Rect2f(config->roi_x, config->roi_y, config->roi_width, config->roi_height));
 }
 
 void DigitalVideoStabilizer::release()
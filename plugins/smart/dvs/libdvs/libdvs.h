@@ -57,6 +57,14 @@ typedef struct  DvsConfig
     float stdev;
     int features;
     double minDistance;
+    // motion analysis runs on frames scaled by analysis_scale, keypoints limited
+    // to features / (grid_cols * grid_rows) per cell of roi (fractions of frame);
+    // tracked keypoints are reused till less than min_tracked survive, 0 detects every frame
+    float analysis_scale;
+    int grid_cols;
+    int grid_rows;
+    int min_tracked;
+    float roi_x, roi_y, roi_width, roi_height;
 
     DvsConfig()
     {
@@ -67,6 +75,14 @@ typedef struct  DvsConfig
         stdev = 10.0f;
         features = 1000;
         minDistance = 15.0f;
+        analysis_scale = 1.0f;
+        grid_cols = 1;
+        grid_rows = 1;
+        min_tracked = 0;
+        roi_x = 0.0f;
+        roi_y = 0.0f;
+        roi_width = 1.0f;
+        roi_height = 1.0f;
     }
 } DvsConfig;
 
@@ -24,6 +24,149 @@ using namespace cv;
 using namespace cv::videostab;
 using namespace std;
 
+// homography needs 4 point pairs
+#define DVS_MIN_MOTION_POINTS 4
+
+TrackingMotionEstimator::TrackingMotionEstimator(Ptr<MotionEstimatorBase> estimator)
+    : ImageMotionEstimatorBase(estimator->motionModel())
+    , estimator_ (estimator)
+    , features_ (1000)
+    , minDistance_ (15.0)
+    , scale_ (1.0f)
+    , gridCols_ (1)
+    , gridRows_ (1)
+    , minTracked_ (0)
+    , roi_ (0.0f, 0.0f, 1.0f, 1.0f)
+    , lastFrame_ (NULL)
+{
+}
+
+void
+TrackingMotionEstimator::setDetector(int features, double minDistance)
+{
+    features_ = features;
+    minDistance_ = minDistance;
+}
+
+void
+TrackingMotionEstimator::setAnalysis(float scale, int gridCols, int gridRows, int minTracked, const Rect2f &roi)
+{
+    scale = std::min(std::max(scale, 0.05f), 1.0f);
+    Rect2f validRoi = roi & Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+    if (validRoi.area() <= 0.0f)
+        validRoi = Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+
+    // tracked points are in coordinates of previous analysis size
+    if (scale != scale_ || validRoi != roi_) {
+        points_.clear();
+        lastSmall_.release();
+        lastFrame_ = NULL;
+    }
+
+    scale_ = scale;
+    gridCols_ = std::max(gridCols, 1);
+    gridRows_ = std::max(gridRows, 1);
+    minTracked_ = minTracked;
+    roi_ = validRoi;
+}
+
+void
+TrackingMotionEstimator::downscale(const Mat &frame, Mat &small)
+{
+    Mat gray;
+    if (frame.channels() != 1)
+        cvtColor(frame, gray, COLOR_BGR2GRAY);
+    else
+        gray = frame;
+
+    if (scale_ < 1.0f)
+        resize(gray, small, Size(), scale_, scale_, INTER_AREA);
+    else
+        small = gray;
+}
+
+void
+TrackingMotionEstimator::detect(const Mat &small)
+{
+    Rect area(
+        cvRound(roi_.x * small.cols), cvRound(roi_.y * small.rows),
+        cvRound(roi_.width * small.cols), cvRound(roi_.height * small.rows));
+    area &= Rect(0, 0, small.cols, small.rows);
+
+    // caps per cell spread features over the frame instead of clustering in textured areas
+    int cellFeatures = std::max(features_ / (gridCols_ * gridRows_), 1);
+    double minDistance = std::max(minDistance_ * scale_, 1.0);
+    vector<Point2f> corners;
+
+    points_.clear();
+    for (int row = 0; row < gridRows_; ++row) {
+        for (int col = 0; col < gridCols_; ++col) {
+            Rect cell(
+                area.x + area.width * col / gridCols_, area.y + area.height * row / gridRows_,
+                area.width / gridCols_, area.height / gridRows_);
+            if (cell.width < 8 || cell.height < 8)
+                continue;
+
+            goodFeaturesToTrack(small(cell), corners, cellFeatures, 0.01, minDistance);
+            for (size_t i = 0; i < corners.size(); ++i)
+                points_.push_back(corners[i] + Point2f((float)cell.x, (float)cell.y));
+        }
+    }
+}
+
+Mat
+TrackingMotionEstimator::estimate(const Mat &frame0, const Mat &frame1, bool *ok)
+{
+    // frame0 is frame1 of last call, so it is only downscaled once
+    Mat small0, small1;
+    if (lastFrame_ == frame0.data && !lastSmall_.empty())
+        small0 = lastSmall_;
+    else {
+        downscale(frame0, small0);
+        points_.clear();
+    }
+    downscale(frame1, small1);
+    lastFrame_ = frame1.data;
+    lastSmall_ = small1;
+
+    if (minTracked_ <= 0 || (int)points_.size() < std::max(minTracked_, DVS_MIN_MOTION_POINTS))
+        detect(small0);
+
+    inliers0_.clear();
+    inliers1_.clear();
+    if (!points_.empty()) {
+        calcOpticalFlowPyrLK(small0, small1, points_, nextPoints_, status_, errors_);
+
+        Rect2f bounds(0.0f, 0.0f, (float)small1.cols, (float)small1.rows);
+        for (size_t i = 0; i < points_.size(); ++i) {
+            if (!status_[i] || !bounds.contains(nextPoints_[i]))
+                continue;
+            inliers0_.push_back(points_[i]);
+            inliers1_.push_back(nextPoints_[i]);
+        }
+    }
+
+    // survivors are tracked on from frame1
+    points_ = inliers1_;
+
+    if ((int)inliers0_.size() < DVS_MIN_MOTION_POINTS) {
+        if (ok)
+            *ok = false;
+        return Mat::eye(3, 3, CV_32F);
+    }
+
+    Mat motion = estimator_->estimate(inliers0_, inliers1_, ok);
+    if (scale_ < 1.0f) {
+        // S^-1 * M * S with S = diag(scale, scale, 1)
+        motion.at<float>(0, 2) /= scale_;
+        motion.at<float>(1, 2) /= scale_;
+        motion.at<float>(2, 0) *= scale_;
+        motion.at<float>(2, 1) *= scale_;
+    }
+
+    return motion;
+}
+
 Mat
 OnePassVideoStabilizer::nextStabilizedMotion(DvsData* frame, int& stablizedPos)
 {
@@ -88,6 +231,9 @@ OnePassVideoStabilizer::nextStabilizedMotion(DvsData* frame, int& stablizedPos)
 Mat
 OnePassVideoStabilizer::estimateMotion()
 {
+    if (motionEstimator_.dynamicCast<KeypointBasedMotionEstimator>().empty())
+        return motionEstimator_->estimate(at(curPos_ - 1, frames_), at(curPos_, frames_));
+
 #if ENABLE_DVS_CL_PATH
     cv::UMat frame0 = at(curPos_ - 1, frames_).getUMat(ACCESS_READ);
     cv::UMat frame1 = at(curPos_, frames_).getUMat(ACCESS_READ);
@@ -206,6 +352,9 @@ TwoPassVideoStabilizer::nextStabilizedMotion(DvsData* frame, int& stablizedPos)
 Mat
 TwoPassVideoStabilizer::estimateMotion()
 {
+    if (motionEstimator_.dynamicCast<KeypointBasedMotionEstimator>().empty())
+        return motionEstimator_->estimate(at(curPos_ - 1, frames_), at(curPos_, frames_));
+
 #if ENABLE_DVS_CL_PATH
     cv::UMat frame0 = at(curPos_ - 1, frames_).getUMat(ACCESS_READ);
     cv::UMat frame1 = at(curPos_, frames_).getUMat(ACCESS_READ);
@@ -257,6 +406,8 @@ VideoStabilizer::VideoStabilizer(
     bool inpainter)
     : isTwoPass_ (isTwoPass)
     , trimRatio_ (0.05f)
+    , features_ (1000)
+    , minDistance_ (15.0)
 {
     Ptr<MotionEstimatorRansacL2> est = makePtr<MotionEstimatorRansacL2>(MM_HOMOGRAPHY);
     Ptr<IOutlierRejector> outlierRejector = makePtr<TranslationBasedLocalOutlierRejector>();
@@ -284,6 +435,7 @@ VideoStabilizer::VideoStabilizer(
         onePassStabilizer->setMotionFilter(makePtr<GaussianMotionFilter>(15, 10));
     }
 
+    keypointEstimator_ = kbest;
     stabilizer_->setMotionEstimator(kbest);
 
     stabilizer_->setRadius(15);
@@ -331,8 +483,12 @@ VideoStabilizer::~VideoStabilizer() {}
 void
 VideoStabilizer::configFeatureDetector(int features, double minDistance)
 {
-    Ptr<ImageMotionEstimatorBase> estimator = stabilizer_->motionEstimator();
-    Ptr<FeatureDetector> detector = estimator.dynamicCast<KeypointBasedMotionEstimator>()->detector();
+    features_ = features;
+    minDistance_ = minDistance;
+    if (!trackingEstimator_.empty())
+        trackingEstimator_->setDetector(features, minDistance);
+
+    Ptr<FeatureDetector> detector = keypointEstimator_->detector();
     if (NULL == detector) {
         return;
     }
@@ -341,6 +497,30 @@ VideoStabilizer::configFeatureDetector(int features, double minDistance)
     detector.dynamicCast<GFTTDetector>()->setMinDistance(minDistance);
 }
 
+void
+VideoStabilizer::configAnalysis(float scale, int gridCols, int gridRows, int minTracked, const Rect2f &roi)
+{
+    bool fullAnalysis =
+        scale >= 1.0f && gridCols <= 1 && gridRows <= 1 && minTracked <= 0 &&
+        roi == Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+
+    if (fullAnalysis) {
+        if (!trackingEstimator_.empty()) {
+            stabilizer_->setMotionEstimator(keypointEstimator_);
+            trackingEstimator_.release();
+        }
+        return;
+    }
+
+    // called for every frame, keep tracked points of existing estimator
+    if (trackingEstimator_.empty()) {
+        trackingEstimator_ = makePtr<TrackingMotionEstimator>(makePtr<MotionEstimatorRansacL2>(MM_HOMOGRAPHY));
+        trackingEstimator_->setDetector(features_, minDistance_);
+        stabilizer_->setMotionEstimator(trackingEstimator_);
+    }
+    trackingEstimator_->setAnalysis(scale, gridCols, gridRows, minTracked, roi);
+}
+
 void
 VideoStabilizer::configMotionFilter(int radius, float stdev)
 {
@@ -28,6 +28,48 @@
 
 #include "libdvs.h"
 
+// tracks keypoints on downscaled frames, detector reruns only when too few points survive
+class TrackingMotionEstimator : public cv::videostab::ImageMotionEstimatorBase
+{
+public:
+    TrackingMotionEstimator(cv::Ptr<cv::videostab::MotionEstimatorBase> estimator);
+    virtual ~TrackingMotionEstimator() {};
+
+    void setDetector(int features, double minDistance);
+    void setAnalysis(float scale, int gridCols, int gridRows, int minTracked, const cv::Rect2f &roi);
+
+    virtual void setMotionModel(cv::videostab::MotionModel val) {
+        estimator_->setMotionModel(val);
+    }
+    virtual cv::videostab::MotionModel motionModel() const {
+        return estimator_->motionModel();
+    }
+    virtual cv::Mat estimate(const cv::Mat &frame0, const cv::Mat &frame1, bool *ok = 0);
+
+private:
+    void downscale(const cv::Mat &frame, cv::Mat &small);
+    void detect(const cv::Mat &small);
+
+private:
+    cv::Ptr<cv::videostab::MotionEstimatorBase> estimator_;
+    int features_;
+    double minDistance_;
+    float scale_;
+    int gridCols_;
+    int gridRows_;
+    int minTracked_;
+    cv::Rect2f roi_;
+
+    const uchar *lastFrame_;
+    cv::Mat lastSmall_;
+    std::vector<cv::Point2f> points_;
+    std::vector<cv::Point2f> nextPoints_;
+    std::vector<uchar> status_;
+    std::vector<float> errors_;
+    std::vector<cv::Point2f> inliers0_;
+    std::vector<cv::Point2f> inliers1_;
+};
+
 class OnePassVideoStabilizer : public cv::videostab::OnePassStabilizer
 {
 public:
@@ -83,6 +125,8 @@ public:
     }
 
     void configFeatureDetector(int features, double minDistance);
+    // scale 1, 1x1 grid, minTracked 0 and full roi keep the full resolution detector of every frame
+    void configAnalysis(float scale, int gridCols, int gridRows, int minTracked, const cv::Rect2f &roi);
     void configMotionFilter(int radius, float stdev);
     void configDeblurrer(int radius, double sensitivity);
 
@@ -94,6 +138,10 @@ private:
     float trimRatio_;
     cv::Size frameSize_;
     cv::Ptr<cv::videostab::StabilizerBase> stabilizer_;
+    cv::Ptr<cv::videostab::KeypointBasedMotionEstimator> keypointEstimator_;
+    cv::Ptr<TrackingMotionEstimator> trackingEstimator_;
+    int features_;
+    double minDistance_;
 };
 
 
@@ -39,6 +39,10 @@
 #include "libdvs/libdvs.h"
 
 #define DVS_MOTION_FILTER_RADIUS   15
+#define DVS_ANALYSIS_SCALE         0.5f
+#define DVS_FEATURE_GRID_COLS      4
+#define DVS_FEATURE_GRID_ROWS      3
+#define DVS_MIN_TRACKED_FEATURES   300
 
 struct DvsBuffer : public DvsData
 {
@@ -143,6 +147,10 @@ XCamReturn dvs_analyze(XCamSmartAnalysisContext *context, XCamVideoBuffer *buffe
     config.stdev = 10.0f;
     config.features = 1000;
     config.minDistance = 20.0f;
+    config.analysis_scale = DVS_ANALYSIS_SCALE;
+    config.grid_cols = DVS_FEATURE_GRID_COLS;
+    config.grid_rows = DVS_FEATURE_GRID_ROWS;
+    config.min_tracked = DVS_MIN_TRACKED_FEATURES;
 
     theDVS->setConfig(&config);
 
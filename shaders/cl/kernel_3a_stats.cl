@@ -0,0 +1,65 @@
+/*
+ * function:    kernel_3a_stats_reduce
+ *     sums width_factor x height_factor cells of kernel_bayer_basic into one grid of XCamGridStat
+ * input:       cells, ushort8 {avg_y, avg_r, avg_gr, avg_gb, avg_b, valid_wb_count, f_value1, f_value2}
+ * output:      XCam3AStats, grids as uint8 of the same order behind header, aligned_width x aligned_height
+ * header:      XCam3AStats header size in uint, stores are unaligned
+ * grid_width, grid_height:   valid grids, others are zero
+ * factor_shift:    log2 (width_factor * height_factor), averages of cells are shifted
+ */
+__kernel void kernel_3a_stats_reduce (
+    __global const ushort8 *input, __global uint *output, uint header,
+    uint grid_width, uint grid_height, uint aligned_width, uint aligned_height,
+    uint width_factor, uint height_factor, uint factor_shift)
+{
+    uint w = get_global_id (0);
+    uint h = get_global_id (1);
+    if (w >= aligned_width || h >= aligned_height)
+        return;
+
+    uint8 sum = (uint8) (0);
+    if (w < grid_width && h < grid_height) {
+        uint8 shift = (uint8) (factor_shift, factor_shift, factor_shift, factor_shift, factor_shift, 0, 0, 0);
+        uint cell_pitch = aligned_width * width_factor;
+        for (uint i_h = h * height_factor; i_h < (h + 1) * height_factor; ++i_h) {
+            for (uint i_w = w * width_factor; i_w < (w + 1) * width_factor; ++i_w) {
+                sum += convert_uint8 (input[mad24 (i_h, cell_pitch, i_w)]) >> shift;
+            }
+        }
+    }
+
+    vstore8 (sum, mad24 (h, aligned_width, w), output + header);
+}
+
+/*
+ * function:    kernel_3a_stats_histogram
+ *     one work item per bin counts the grids, no atomics and no clearing needed
+ * stats:       XCam3AStats, grids followed by hist_rgb (uint4 {r, gr, gb, b}) and hist_y (uint)
+ *              behind header
+ */
+__kernel void kernel_3a_stats_histogram (
+    __global uint *stats, uint header,
+    uint grid_width, uint grid_height, uint aligned_width, uint aligned_height, uint bins)
+{
+    uint bin = get_global_id (0);
+    if (bin >= bins)
+        return;
+
+    __global const uint *grids = stats + header;
+    uint grid_count = aligned_width * aligned_height;
+    __global uint *hist_rgb = stats + header + grid_count * 8;
+    __global uint *hist_y = hist_rgb + bins * 4;
+
+    uint4 count_rgb = (uint4) (0);
+    uint count_y = 0;
+    for (uint h = 0; h < grid_height; ++h) {
+        for (uint w = 0; w < grid_width; ++w) {
+            uint8 grid = vload8 (mad24 (h, aligned_width, w), grids);
+            count_rgb += convert_uint4 (-(grid.s1234 == (uint4) (bin)));
+            count_y += (grid.s0 == bin);
+        }
+    }
+
+    vstore4 (count_rgb, bin, hist_rgb);
+    hist_y[bin] = count_y;
+}
@@ -130,8 +130,9 @@ inline void weighted_average (__read_only image2d_t input,
 
     int local_id_x = get_local_id(0);
     int local_id_y = get_local_id(1);
-    const int group_id_x = get_group_id(0);
-    const int group_id_y = get_group_id(1);
+    // global offset of ROI launch is aligned to work group
+    const int group_id_x = get_group_id(0) + get_global_offset(0) / get_local_size(0);
+    const int group_id_y = get_group_id(1) + get_global_offset(1) / get_local_size(1);
 
     int start_x = mad24(group_id_x, WORKGROUP_WIDTH, -REF_BLOCK_X_OFFSET);
     int start_y = mad24(group_id_y, WORKGROUP_HEIGHT, -REF_BLOCK_Y_OFFSET);
@@ -250,8 +251,9 @@ __kernel void kernel_3d_denoise ( float gain,
 
     int local_id_x = get_local_id(0);
     int local_id_y = get_local_id(1);
-    const int group_id_x = get_group_id(0);
-    const int group_id_y = get_group_id(1);
+    // global offset of ROI launch is aligned to work group
+    const int group_id_x = get_group_id(0) + get_global_offset(0) / get_local_size(0);
+    const int group_id_y = get_group_id(1) + get_global_offset(1) / get_local_size(1);
 
 #if WORKGROUP_WIDTH == 4
     int2 pos = subgroup_pos(sg_id, sg_lid);
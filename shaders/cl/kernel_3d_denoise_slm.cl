@@ -44,8 +44,9 @@ inline void weighted_average (__read_only image2d_t input,
 
     const int local_id_x = get_local_id(0);
     const int local_id_y = get_local_id(1);
-    const int group_id_x = get_group_id(0);
-    const int group_id_y = get_group_id(1);
+    // global offset of ROI launch is aligned to work group
+    const int group_id_x = get_group_id(0) + get_global_offset(0) / get_local_size(0);
+    const int group_id_y = get_group_id(1) + get_global_offset(1) / get_local_size(1);
 
     int i = local_id_x + local_id_y * WORK_BLOCK_WIDTH;
     int start_x = mad24(group_id_x, WORK_BLOCK_WIDTH, -REF_BLOCK_X_OFFSET);
@@ -3,6 +3,8 @@
  *     sample code of default kernel arguments
  * input:    image2d_t as read only
  * output:   image2d_t as write only
+ * input_pitch: row pitch of buffer input in bytes
+ * packed_bits: 10 or 12 for MIPI packed RAW10/RAW12 buffer input, unpacked here; 0 for 16-bit input
  */
 
 //#define ENABLE_IMAGE_2D_INPUT 0
@@ -60,6 +62,33 @@ inline void gamma_correct(float8 *in_out, __global float *table)
     in_out->s7 = table[clamp(convert_int(in_out->s7 * 255.0f), 0, 255)];
 }
 
+/* MIPI RAW10, 4 pixels in 5 bytes, high 8 bits of each then one byte of 2-bit lows */
+inline ushort8 unpack_raw10 (__global const uchar *src)
+{
+    uchar8 hi = (uchar8)(vload4 (0, src), vload4 (0, src + 5));
+    ushort8 lo = (ushort8)((ushort4)(src[4]), (ushort4)(src[9])) >> (ushort8)(0, 2, 4, 6, 0, 2, 4, 6);
+    return (convert_ushort8 (hi) << (ushort8)2) | (lo & (ushort8)0x3);
+}
+
+/* MIPI RAW12, 2 pixels in 3 bytes, high 8 bits of each then one byte of 4-bit lows */
+inline ushort8 unpack_raw12 (__global const uchar *src)
+{
+    uchar4 b0 = vload4 (0, src), b1 = vload4 (0, src + 4), b2 = vload4 (0, src + 8);
+    ushort8 hi = convert_ushort8 ((uchar8)(b0.s01, b0.s3, b1.s0, b1.s23, b2.s12));
+    ushort8 lo = convert_ushort8 ((uchar8)(b0.s22, b1.s11, b2.s00, b2.s33)) >> (ushort8)(0, 4, 0, 4, 0, 4, 0, 4);
+    return (hi << (ushort8)4) | (lo & (ushort8)0xF);
+}
+
+// 8 pixels from @cell * 8 of a row
+inline ushort8 read_bayer_cell (__global const uchar *row, int cell, uint packed_bits)
+{
+    if (packed_bits == 10)
+        return unpack_raw10 (row + cell * 10);
+    else if (packed_bits == 12)
+        return unpack_raw12 (row + cell * 12);
+    return ((__global const ushort8 *)row)[cell];
+}
+
 inline float avg_float8 (float8 data)
 {
     return (data.s0 + data.s1 + data.s2 + data.s3 + data.s4 + data.s5 + data.s6 + data.s7) * 0.125f;
@@ -156,9 +185,10 @@ __kernel void kernel_bayer_basic (
 #if ENABLE_IMAGE_2D_INPUT
     __read_only image2d_t input,
 #else
-    __global const ushort8 *input,
+    __global const uchar *input,
 #endif
-    uint input_aligned_width,
+    uint input_pitch,
+    uint packed_bits,
     __write_only image2d_t output,
     uint out_height,
     CLBLCConfig blc_config,
@@ -199,8 +229,8 @@ __kernel void kernel_bayer_basic (
         line1 = convert_float8 (as_ushort8 (read_imageui(input, sampler, (int2)(x, y * 2)))) / 65536.0f;
         line2 = convert_float8 (as_ushort8 (read_imageui(input, sampler, (int2)(x, y * 2 + 1)))) / 65536.0f;
 #else
-        line1 = convert_float8 (input [y * 2 * input_aligned_width + x]) / 65536.0f;
-        line2 = convert_float8 (input [(y * 2 + 1) * input_aligned_width + x]) / 65536.0f;
+        line1 = convert_float8 (read_bayer_cell (input + y * 2 * input_pitch, x, packed_bits)) / 65536.0f;
+        line2 = convert_float8 (read_bayer_cell (input + (y * 2 + 1) * input_pitch, x, packed_bits)) / 65536.0f;
 #endif
 
         float4 gr = mad (line1.even, blc_multiplier, - blc_config.level_gr);
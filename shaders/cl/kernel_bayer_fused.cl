@@ -0,0 +1,188 @@
+/*
+ * function: kernel_bayer_fused
+ *     demosaic, rgb to yuv and macc in one pass, writes NV12 directly
+ * params:
+ *   input:    image2d_t as read only, GRBG planes from kernel_bayer_basic (blc, wb, gamma applied)
+ *   input_height: height of one GRBG plane
+ *   output_y: image2d_t as write only, 4 luma pixels per texel
+ *   output_uv: image2d_t as write only, 2 uv pairs per texel
+ *   matrix: rgb to yuv matrix
+ *   macc_table: macc table
+ */
+
+#pragma OPENCL FP_CONTRACT OFF
+
+#define WORKGROUP_CELL_WIDTH 64
+#define WORKGROUP_CELL_HEIGHT 4
+
+#define DEMOSAIC_X_CELL_PER_WORKITEM 2
+
+#define PIXEL_PER_CELL 2
+
+// halo of demosaic neighbourhood
+#define SLM_CELL_X_OFFSET 4
+#define SLM_CELL_Y_OFFSET 1
+
+#define SLM_CELL_X_VALID_SIZE WORKGROUP_CELL_WIDTH
+#define SLM_CELL_Y_VALID_SIZE WORKGROUP_CELL_HEIGHT
+
+#define SLM_CELL_X_SIZE (SLM_CELL_X_VALID_SIZE + SLM_CELL_X_OFFSET * 2)
+#define SLM_CELL_Y_SIZE (SLM_CELL_Y_VALID_SIZE + SLM_CELL_Y_OFFSET * 2)
+
+inline int get_shared_pos_x (int i)
+{
+    return i % SLM_CELL_X_SIZE;
+}
+
+inline int get_shared_pos_y (int i)
+{
+    return i / SLM_CELL_X_SIZE;
+}
+
+inline int shared_pos (int x, int y)
+{
+    return mad24(y, SLM_CELL_X_SIZE, x);
+}
+
+/* BA10=> GRBG  */
+inline void grbg_slm_load (
+    __local float *px, __local float *py, __local float *pz, __local float *pw,
+    int index, __read_only image2d_t input, uint input_height, int x_start, int y_start
+)
+{
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    int x0 = (get_shared_pos_x (index) + x_start) / 4;
+    int y0 = get_shared_pos_y (index) + y_start;
+
+    y0 = y0 > 0 ? y0 : 0;
+
+    (*(__local float4 *)(px + index)) = read_imagef (input, sampler, (int2)(x0, y0));
+    (*(__local float4 *)(py + index)) = read_imagef (input, sampler, (int2)(x0, y0 + input_height));
+    (*(__local float4 *)(pz + index)) = read_imagef (input, sampler, (int2)(x0, y0 + input_height * 2));
+    (*(__local float4 *)(pw + index)) = read_imagef (input, sampler, (int2)(x0, y0 + input_height * 3));
+}
+
+// same interpolation as demosaic_2_cell of kernel_bayer_pipe, 4x2 pixels kept in registers
+void demosaic_2_cell_rgb (
+    __local float *x_data_in, __local float *y_data_in, __local float *z_data_in, __local float *w_data_in,
+    int in_x, int in_y, float4 *r, float4 *g, float4 *b)
+{
+    int index;
+    {
+        float3 R_y[2];
+        index = shared_pos (in_x - 1, in_y);
+        R_y[0] = *(__local float3*)(y_data_in + index);
+        index = shared_pos (in_x - 1, in_y + 1);
+        R_y[1] = *(__local float3*)(y_data_in + index);
+
+        r[0].s02 = (R_y[0].s01 + R_y[0].s12) * 0.5f;
+        r[0].s13 = R_y[0].s12;
+        r[1].s02 = (R_y[0].s01 + R_y[0].s12 + R_y[1].s01 + R_y[1].s12) * 0.25f;
+        r[1].s13 = (R_y[0].s12 + R_y[1].s12) * 0.5f;
+    }
+
+    {
+        float3 B_z[2];
+        index = shared_pos (in_x, in_y - 1);
+        B_z[0] = *(__local float3*)(z_data_in + index);
+        index = shared_pos (in_x, in_y);
+        B_z[1] = *(__local float3*)(z_data_in + index);
+
+        b[0].s02 = (B_z[0].s01 + B_z[1].s01) * 0.5f;
+        b[0].s13 = (B_z[0].s01 + B_z[0].s12 + B_z[1].s01 + B_z[1].s12) * 0.25f;
+        b[1].s02 = B_z[1].s01;
+        b[1].s13 = (B_z[1].s01 + B_z[1].s12) * 0.5f;
+    }
+
+    {
+        float3 Gr_x[2], Gb_w[2];
+        index = shared_pos (in_x, in_y);
+        Gr_x[0] = *(__local float3*)(x_data_in + index);
+        index = shared_pos (in_x, in_y + 1);
+        Gr_x[1] = *(__local float3*)(x_data_in + index);
+
+        index = shared_pos (in_x - 1, in_y - 1);
+        Gb_w[0] = *(__local float3*)(w_data_in + index);
+        index = shared_pos (in_x - 1, in_y);
+        Gb_w[1] = *(__local float3*)(w_data_in + index);
+
+        g[0].s02 = (Gr_x[0].s01 * 4.0f + Gb_w[0].s01 +
+                    Gb_w[0].s12 + Gb_w[1].s01 + Gb_w[1].s12) * 0.125f;
+        g[0].s13 = (Gr_x[0].s01 + Gr_x[0].s12 + Gb_w[0].s12 + Gb_w[1].s12) * 0.25f;
+        g[1].s02 = (Gr_x[0].s01 + Gr_x[1].s01 + Gb_w[1].s01 + Gb_w[1].s12) * 0.25f;
+        g[1].s13 = (Gb_w[1].s12 * 4.0f + Gr_x[0].s01 +
+                    Gr_x[0].s12 + Gr_x[1].s01 + Gr_x[1].s12) * 0.125f;
+    }
+}
+
+unsigned int get_sector_id (float u, float v)
+{
+    u = fabs(u) > 0.00001f ? u : 0.00001f;
+    float tg = v / u;
+    unsigned int se = tg > 1.f ? (tg > 2.f ? 3 : 2) : (tg > 0.5f ? 1 : 0);
+    unsigned int so = tg > -1.f ? (tg > -0.5f ? 3 : 2) : (tg > -2.f ? 1 : 0);
+    return tg > 0 ? (u > 0 ? se : (se + 8)) : (u > 0 ? (so + 12) : (so + 4));
+}
+
+inline float2 csc_macc_uv (float r, float g, float b, __global float *matrix, __global float *table)
+{
+    float u = mad(matrix[3], r, mad(matrix[4], g, matrix[5] * b));
+    float v = mad(matrix[6], r, mad(matrix[7], g, matrix[8] * b));
+    unsigned int id = 4 * get_sector_id (u, v);
+
+    return (float2)(mad(u, table[id], v * table[id + 1]) + 0.5f,
+                    mad(u, table[id + 2], v * table[id + 3]) + 0.5f);
+}
+
+__kernel void kernel_bayer_fused (
+    __read_only image2d_t input,
+    uint input_height,
+    __write_only image2d_t output_y,
+    __write_only image2d_t output_uv,
+    __global float *matrix,
+    __global float *macc_table)
+{
+    int l_id_x = get_local_id(0);
+    int l_id_y = get_local_id(1);
+    int l_size_x = get_local_size (0);
+
+    __local float p1_x[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE], p1_y[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE], p1_z[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE], p1_w[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE];
+
+    int x_start = get_group_id (0) * WORKGROUP_CELL_WIDTH;
+    int y_start = get_group_id (1) * WORKGROUP_CELL_HEIGHT;
+    int i = mad24 (l_id_y, l_size_x, l_id_x);
+
+    if (i * 4 < SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE) {
+        grbg_slm_load (p1_x, p1_y, p1_z, p1_w, i * 4,
+                       input, input_height,
+                       x_start - SLM_CELL_X_OFFSET, y_start - SLM_CELL_Y_OFFSET);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int workitem_x_size = (SLM_CELL_X_VALID_SIZE / DEMOSAIC_X_CELL_PER_WORKITEM);
+    int input_x = (i % workitem_x_size) * DEMOSAIC_X_CELL_PER_WORKITEM;
+    int input_y = i / workitem_x_size;
+    int out_x = (input_x + x_start) * PIXEL_PER_CELL / 4;
+    int out_y = (input_y + y_start) * PIXEL_PER_CELL;
+
+    if (out_x >= get_image_width (output_y) || out_y >= get_image_height (output_y))
+        return;
+
+    float4 r[2], g[2], b[2];
+    demosaic_2_cell_rgb (
+        p1_x, p1_y, p1_z, p1_w,
+        input_x + SLM_CELL_X_OFFSET, input_y + SLM_CELL_Y_OFFSET, r, g, b);
+
+    float4 luma[2];
+    luma[0] = mad(matrix[0], r[0], mad(matrix[1], g[0], matrix[2] * b[0]));
+    luma[1] = mad(matrix[0], r[1], mad(matrix[1], g[1], matrix[2] * b[1]));
+
+    // uv sampled at even pixels of even rows, as kernel_yuv_pipe does
+    float4 uv;
+    uv.s01 = csc_macc_uv (r[0].s0, g[0].s0, b[0].s0, matrix, macc_table);
+    uv.s23 = csc_macc_uv (r[0].s2, g[0].s2, b[0].s2, matrix, macc_table);
+
+    write_imageui (output_y, (int2)(out_x, out_y), convert_uint4 (convert_uchar4_sat (luma[0] * 255.0f)));
+    write_imageui (output_y, (int2)(out_x, out_y + 1), convert_uint4 (convert_uchar4_sat (luma[1] * 255.0f)));
+    write_imageui (output_uv, (int2)(out_x, out_y / 2), convert_uint4 (convert_uchar4_sat (uv * 255.0f)));
+}
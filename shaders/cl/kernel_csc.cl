@@ -163,3 +163,49 @@ __kernel void kernel_csc_nv12torgba (
     write_imagef(output, (int2)(2 * x + 1, 2 * y + 1), pixel_out4);
 }
 
+
+/*
+ * function: kernel_csc_nv12scale
+ *     crops, scales and converts nv12 in one pass, two output pixels per work item
+ * input_y/input_uv: nv12 planes, CL_R and CL_RG
+ * output:   RGBA image, or YUYV as RGBA image of half width
+ * crop:     crop rectangle (x, y, width, height) normalized to input size
+ * out_yuyv: 1 for YUYV output, 0 for RGBA output
+ */
+__kernel void kernel_csc_nv12scale (
+    __read_only image2d_t input_y, __write_only image2d_t output, __read_only image2d_t input_uv,
+    float4 crop, int out_width, int out_height, int out_yuyv)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    if (2 * x >= out_width || y >= out_height)
+        return;
+
+    sampler_t sampler = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+    float2 step = crop.zw / (float2)(out_width, out_height);
+    float2 pos0 = crop.xy + ((float2)(2 * x, y) + 0.5f) * step;
+    float2 pos1 = (float2)(pos0.x + step.x, pos0.y);
+
+    float y0 = read_imagef (input_y, sampler, pos0).x;
+    float y1 = read_imagef (input_y, sampler, pos1).x;
+
+    if (out_yuyv) {
+        float2 uv = read_imagef (input_uv, sampler, (float2)(pos0.x + step.x * 0.5f, pos0.y)).xy;
+        write_imagef (output, (int2)(x, y), (float4)(y0, uv.x, y1, uv.y));
+        return;
+    }
+
+    float2 uv0 = read_imagef (input_uv, sampler, pos0).xy - 0.5f;
+    float2 uv1 = read_imagef (input_uv, sampler, pos1).xy - 0.5f;
+    float4 pixel_out0, pixel_out1;
+    pixel_out0.x = y0 + 1.13983f * uv0.y;
+    pixel_out0.y = y0 - 0.39465f * uv0.x - 0.5806f * uv0.y;
+    pixel_out0.z = y0 + 2.03211f * uv0.x;
+    pixel_out0.w = 0.0f;
+    pixel_out1.x = y1 + 1.13983f * uv1.y;
+    pixel_out1.y = y1 - 0.39465f * uv1.x - 0.5806f * uv1.y;
+    pixel_out1.z = y1 + 2.03211f * uv1.x;
+    pixel_out1.w = 0.0f;
+    write_imagef (output, (int2)(2 * x, y), pixel_out0);
+    write_imagef (output, (int2)(2 * x + 1, y), pixel_out1);
+}
@@ -133,3 +133,138 @@ __kernel void kernel_defog_recover (
     write_imageui(output_uv, (int2)(g_id_x, g_id_y), convert_uint4(as_ushort4(convert_uchar8(out_data))));
 }
 
+
+/*
+ * function:    kernel_dark_channel_down
+ *              dark channel minimum and luma mean of DEFOG_DOWNSCALE x DEFOG_DOWNSCALE blocks
+ * input_y:     Y channel image2d_t as read only
+ * input_dark:  dark channel image2d_t as read only
+ * output_low:  low resolution map image2d_t as write only, x: dark, y: luma
+ *
+ * input data_type CL_UNSIGNED_INT16, channel_order CL_RGBA
+ * output data_type CL_UNORM_INT8, channel_order CL_RG
+ */
+
+#ifndef DEFOG_DOWNSCALE
+#define DEFOG_DOWNSCALE 8
+#endif
+
+__kernel void kernel_dark_channel_down (
+    __read_only image2d_t input_y, __read_only image2d_t input_dark,
+    __write_only image2d_t output_low)
+{
+    int low_x = get_global_id (0);
+    int low_y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    int pos_x = low_x * DEFOG_DOWNSCALE / 8;
+    int pos_y = low_y * DEFOG_DOWNSCALE;
+    float dark = 255.0f;
+    float luma = 0.0f;
+
+    for (int i = 0; i < DEFOG_DOWNSCALE; ++i) {
+        float8 y = convert_float8(as_uchar8(convert_ushort4(read_imageui(input_y, sampler, (int2)(pos_x, pos_y + i)))));
+        float8 d = convert_float8(as_uchar8(convert_ushort4(read_imageui(input_dark, sampler, (int2)(pos_x, pos_y + i)))));
+#if DEFOG_DOWNSCALE == 8
+        float4 y4 = y.lo + y.hi;
+        float4 d4 = min (d.lo, d.hi);
+#else
+        float4 y4 = (low_x & 1) ? y.hi : y.lo;
+        float4 d4 = (low_x & 1) ? d.hi : d.lo;
+#endif
+        luma += y4.x + y4.y + y4.z + y4.w;
+        dark = min (dark, min (min (d4.x, d4.y), min (d4.z, d4.w)));
+    }
+
+    luma /= (float)(DEFOG_DOWNSCALE * DEFOG_DOWNSCALE);
+    write_imagef (output_low, (int2)(low_x, low_y), (float4)(dark / 255.0f, luma / 255.0f, 0.0f, 0.0f));
+}
+
+/*
+ * function:    kernel_bi_filter_down
+ *              bilateral filter of low resolution dark channel guided by its luma
+ * input_low:   low resolution map image2d_t as read only, x: dark, y: luma
+ * output_low:  filtered low resolution map image2d_t as write only, luma kept
+ *
+ * data_type CL_UNORM_INT8, channel_order CL_RG
+ */
+
+#define LOW_PATCH_RADIUS 2
+#define LOW_SIGMA_LUMA (28.0f / 255.0f)
+
+__kernel void kernel_bi_filter_down (
+    __read_only image2d_t input_low, __write_only image2d_t output_low)
+{
+    int pos_x = get_global_id (0);
+    int pos_y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    float2 center = read_imagef (input_low, sampler, (int2)(pos_x, pos_y)).xy;
+    float weight_sum = 0.0f;
+    float data_sum = 0.0f;
+
+    for (int j = -LOW_PATCH_RADIUS; j <= LOW_PATCH_RADIUS; ++j) {
+        for (int i = -LOW_PATCH_RADIUS; i <= LOW_PATCH_RADIUS; ++i) {
+            float2 cur = read_imagef (input_low, sampler, (int2)(pos_x + i, pos_y + j)).xy;
+            float delta = (cur.y - center.y) / LOW_SIGMA_LUMA;
+            float weight = native_exp (-0.5f * delta * delta);
+            weight_sum += weight;
+            data_sum += cur.x * weight;
+        }
+    }
+
+    write_imagef (output_low, (int2)(pos_x, pos_y), (float4)(data_sum / weight_sum, center.y, 0.0f, 0.0f));
+}
+
+/*
+ * function:    kernel_dark_upsample
+ *              joint bilateral upsample, bilinear weights of 2x2 low resolution neighbors
+ *              scaled by luma similarity to the full resolution pixel
+ * input_y:     Y channel image2d_t as read only
+ * input_low:   filtered low resolution map image2d_t as read only, x: dark, y: luma
+ * output_dark: dark channel image2d_t as write only
+ *
+ * input_y, output_dark data_type CL_UNSIGNED_INT16, channel_order CL_RGBA
+ * input_low data_type CL_UNORM_INT8, channel_order CL_RG
+ */
+
+__kernel void kernel_dark_upsample (
+    __read_only image2d_t input_y, __read_only image2d_t input_low,
+    __write_only image2d_t output_dark)
+{
+    int pos_x = get_global_id (0);
+    int pos_y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    float8 y = convert_float8(as_uchar8(convert_ushort4(read_imageui(input_y, sampler, (int2)(pos_x, pos_y))))) / 255.0f;
+    float y_in[8] = {y.s0, y.s1, y.s2, y.s3, y.s4, y.s5, y.s6, y.s7};
+    float dark[8];
+
+    float low_y = (pos_y + 0.5f) / DEFOG_DOWNSCALE - 0.5f;
+    int y0 = (int)floor (low_y);
+    float fy = low_y - y0;
+
+#pragma unroll
+    for (int i = 0; i < 8; ++i) {
+        float low_x = (pos_x * 8 + i + 0.5f) / DEFOG_DOWNSCALE - 0.5f;
+        int x0 = (int)floor (low_x);
+        float fx = low_x - x0;
+
+        float2 p00 = read_imagef (input_low, sampler, (int2)(x0, y0)).xy;
+        float2 p10 = read_imagef (input_low, sampler, (int2)(x0 + 1, y0)).xy;
+        float2 p01 = read_imagef (input_low, sampler, (int2)(x0, y0 + 1)).xy;
+        float2 p11 = read_imagef (input_low, sampler, (int2)(x0 + 1, y0 + 1)).xy;
+
+        float4 luma = (float4)(p00.y, p10.y, p01.y, p11.y);
+        float4 delta = (luma - y_in[i]) / LOW_SIGMA_LUMA;
+        float4 weight = (float4)((1.0f - fx) * (1.0f - fy), fx * (1.0f - fy), (1.0f - fx) * fy, fx * fy);
+        weight *= native_exp (-0.5f * delta * delta);
+        weight += 0.0001f;
+
+        float sum = weight.x * p00.x + weight.y * p10.x + weight.z * p01.x + weight.w * p11.x;
+        dark[i] = sum / (weight.x + weight.y + weight.z + weight.w) * 255.0f;
+    }
+
+    float8 out_data = (float8)(dark[0], dark[1], dark[2], dark[3], dark[4], dark[5], dark[6], dark[7]);
+    out_data = clamp (out_data, 0.0f, 255.0f);
+    write_imageui(output_dark, (int2)(pos_x, pos_y), convert_uint4(as_ushort4(convert_uchar8(out_data))));
+}
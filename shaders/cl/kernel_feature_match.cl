@@ -0,0 +1,270 @@
+/*
+ * feature match of stitching overlaps, Shi-Tomasi corners of the left crop tracked into the
+ * right crop by pyramidal Lucas-Kanade.
+ * images are gauss pyramid levels of whole frames as CL_R CL_UNORM_INT8, crops are given by origin.
+ * FM_LK_WIN:       tracking window size of all levels
+ * FM_LK_ITERS:     max iterations of each level
+ * FM_LK_EPS:       iterations of a level stop once the update is shorter, in pixels
+ * FM_LK_MIN_EIG:   corners with smaller minimum eigenvalue of gradient matrix are lost
+ * FM_LOCAL_SIZE:   work items tracking one corner, power of 2
+ */
+
+#ifndef FM_LK_WIN
+#define FM_LK_WIN 41
+#endif
+
+#ifndef FM_LK_ITERS
+#define FM_LK_ITERS 10
+#endif
+
+#ifndef FM_LK_EPS
+#define FM_LK_EPS 0.01f
+#endif
+
+#ifndef FM_LK_MIN_EIG
+#define FM_LK_MIN_EIG 1.0e-6f
+#endif
+
+#ifndef FM_LOCAL_SIZE
+#define FM_LOCAL_SIZE 64
+#endif
+
+#define FM_LK_HALF (FM_LK_WIN / 2)
+#define FM_LK_AREA (FM_LK_WIN * FM_LK_WIN)
+#define FM_LK_PER_ITEM ((FM_LK_AREA + FM_LOCAL_SIZE - 1) / FM_LOCAL_SIZE)
+
+__constant sampler_t fm_nearest_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+__constant sampler_t fm_linear_sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+/*
+ * function: kernel_fm_corner_score
+ *           minimum eigenvalue of 3x3 sums of sobel gradient products, as cornerMinEigenVal
+ * origin_x, origin_y: crop position on image
+ * score:     crop width x height
+ * max_score: maximum of all scores as uint, cleared before launch
+ * workitem = 1 pixel of crop
+ */
+__kernel void kernel_fm_corner_score (
+    __read_only image2d_t image, int origin_x, int origin_y, int width, int height,
+    __global float *score, __global uint *max_score)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    int lid = get_local_id (1) * get_local_size (0) + get_local_id (0);
+    __local uint group_max;
+
+    if (lid == 0)
+        group_max = 0;
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    if (x < width && y < height) {
+        float p[5][5];
+#pragma unroll
+        for (int i = 0; i < 5; ++i) {
+#pragma unroll
+            for (int j = 0; j < 5; ++j)
+                p[i][j] = read_imagef (image, fm_nearest_sampler, (int2)(origin_x + x - 2 + j, origin_y + y - 2 + i)).x;
+        }
+
+        float3 sum = 0.0f;
+#pragma unroll
+        for (int i = 1; i < 4; ++i) {
+#pragma unroll
+            for (int j = 1; j < 4; ++j) {
+                float dx = (p[i - 1][j + 1] + 2.0f * p[i][j + 1] + p[i + 1][j + 1]) -
+                           (p[i - 1][j - 1] + 2.0f * p[i][j - 1] + p[i + 1][j - 1]);
+                float dy = (p[i + 1][j - 1] + 2.0f * p[i + 1][j] + p[i + 1][j + 1]) -
+                           (p[i - 1][j - 1] + 2.0f * p[i - 1][j] + p[i - 1][j + 1]);
+                sum += (float3)(dx * dx, dx * dy, dy * dy);
+            }
+        }
+
+        float diff = sum.x - sum.z;
+        float eig = 0.5f * ((sum.x + sum.z) - sqrt (diff * diff + 4.0f * sum.y * sum.y));
+        eig = fmax (eig, 0.0f);
+        score[y * width + x] = eig;
+
+        // order of non-negative floats is kept by their bits
+        atomic_max (&group_max, as_uint (eig));
+    }
+
+    barrier (CLK_LOCAL_MEM_FENCE);
+    if (lid == 0)
+        atomic_max (max_score, group_max);
+}
+
+/*
+ * function: kernel_fm_corner_select
+ *           local maximums of score over quality * maximum score, as goodFeaturesToTrack
+ * count:      corners found, cleared before launch, may be more than max_count
+ * candidates: (x, y, score) of corners in crop
+ * workitem = 1 pixel of crop
+ */
+__kernel void kernel_fm_corner_select (
+    __global const float *score, int width, int height, float quality,
+    __global const uint *max_score, __global uint *count,
+    __global float4 *candidates, uint max_count)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+
+    if (x >= width || y >= height)
+        return;
+
+    float value = score[y * width + x];
+    if (value <= as_float (max_score[0]) * quality)
+        return;
+
+    for (int i = max (y - 1, 0); i <= min (y + 1, height - 1); ++i) {
+        for (int j = max (x - 1, 0); j <= min (x + 1, width - 1); ++j) {
+            if (score[i * width + j] > value)
+                return;
+        }
+    }
+
+    uint index = atomic_inc (count);
+    if (index < max_count)
+        candidates[index] = (float4)((float)x, (float)y, value, 0.0f);
+}
+
+inline float
+fm_read_luma (__read_only image2d_t image, float2 pos)
+{
+    return read_imagef (image, fm_linear_sampler, pos + 0.5f).x;
+}
+
+// offset of pixel @i of window to its center
+inline float2
+fm_window_offset (int i)
+{
+    return (float2)((float)(i % FM_LK_WIN - FM_LK_HALF), (float)(i / FM_LK_WIN - FM_LK_HALF));
+}
+
+inline float4
+fm_group_sum (__local float4 *scratch, float4 value)
+{
+    int lid = get_local_id (0);
+
+    scratch[lid] = value;
+    barrier (CLK_LOCAL_MEM_FENCE);
+    for (int s = FM_LOCAL_SIZE / 2; s > 0; s >>= 1) {
+        if (lid < s)
+            scratch[lid] += scratch[lid + s];
+        barrier (CLK_LOCAL_MEM_FENCE);
+    }
+
+    float4 sum = scratch[0];
+    barrier (CLK_LOCAL_MEM_FENCE);
+    return sum;
+}
+
+/*
+ * tracks one level, returns refined @flow.
+ * @left_pt and @right_pt are the corner on left and right level images without flow,
+ * @lost is set if the window is too flat to track. all work items of the group get the same results.
+ */
+inline float2
+fm_track_level (
+    __read_only image2d_t left, __read_only image2d_t right,
+    float2 left_pt, float2 right_pt, float2 flow, __local float4 *scratch, int *lost)
+{
+    int lid = get_local_id (0);
+    float lv[FM_LK_PER_ITEM], gx[FM_LK_PER_ITEM], gy[FM_LK_PER_ITEM];
+
+    float4 mat = 0.0f;
+    for (int k = 0; k < FM_LK_PER_ITEM; ++k) {
+        int i = lid + k * FM_LOCAL_SIZE;
+        lv[k] = gx[k] = gy[k] = 0.0f;
+        if (i >= FM_LK_AREA)
+            continue;
+
+        float2 pos = left_pt + fm_window_offset (i);
+        lv[k] = fm_read_luma (left, pos);
+        gx[k] = 0.5f * (fm_read_luma (left, pos + (float2)(1.0f, 0.0f)) - fm_read_luma (left, pos - (float2)(1.0f, 0.0f)));
+        gy[k] = 0.5f * (fm_read_luma (left, pos + (float2)(0.0f, 1.0f)) - fm_read_luma (left, pos - (float2)(0.0f, 1.0f)));
+        mat += (float4)(gx[k] * gx[k], gx[k] * gy[k], gy[k] * gy[k], 0.0f);
+    }
+    mat = fm_group_sum (scratch, mat);
+
+    float diff = mat.x - mat.z;
+    float min_eig = 0.5f * ((mat.x + mat.z) - sqrt (diff * diff + 4.0f * mat.y * mat.y)) / FM_LK_AREA;
+    float det = mat.x * mat.z - mat.y * mat.y;
+    if (min_eig < FM_LK_MIN_EIG || det < FLT_EPSILON) {
+        lost[0] = 1;
+        return flow;
+    }
+
+    for (int iter = 0; iter < FM_LK_ITERS; ++iter) {
+        float4 b = 0.0f;
+        for (int k = 0; k < FM_LK_PER_ITEM; ++k) {
+            int i = lid + k * FM_LOCAL_SIZE;
+            if (i >= FM_LK_AREA)
+                continue;
+
+            float2 pos = right_pt + flow + fm_window_offset (i);
+            float d = fm_read_luma (right, pos) - lv[k];
+            b += (float4)(d * gx[k], d * gy[k], 0.0f, 0.0f);
+        }
+        b = fm_group_sum (scratch, b);
+
+        float2 delta = (float2)(mat.z * b.x - mat.y * b.y, mat.x * b.y - mat.y * b.x) / det;
+        flow -= delta;
+        if (dot (delta, delta) < FM_LK_EPS * FM_LK_EPS)
+            break;
+    }
+
+    return flow;
+}
+
+/*
+ * function: kernel_fm_lk_track
+ *           tracks corners over 4 pyramid levels, left0 and right0 are the base level
+ * left_origin, right_origin: crop positions on base level
+ * corners:   corners in left crop
+ * tracked:   corners in right crop
+ * errors:    mean absolute difference of base level windows, in 8 bits luma
+ * status:    0 if the corner is lost
+ * work group = 1 corner
+ */
+__kernel void kernel_fm_lk_track (
+    __read_only image2d_t left0, __read_only image2d_t left1,
+    __read_only image2d_t left2, __read_only image2d_t left3,
+    __read_only image2d_t right0, __read_only image2d_t right1,
+    __read_only image2d_t right2, __read_only image2d_t right3,
+    float2 left_origin, float2 right_origin,
+    __global const float2 *corners, int corner_count,
+    __global float2 *tracked, __global float *errors, __global int *status)
+{
+    int index = get_group_id (0);
+    int lid = get_local_id (0);
+    __local float4 scratch[FM_LOCAL_SIZE];
+
+    if (index >= corner_count)
+        return;
+
+    float2 pt = corners[index];
+    float2 flow = 0.0f;
+    int lost = 0;
+
+    flow = fm_track_level (left3, right3, (left_origin + pt) / 8.0f, (right_origin + pt) / 8.0f, flow, scratch, &lost);
+    flow = fm_track_level (left2, right2, (left_origin + pt) / 4.0f, (right_origin + pt) / 4.0f, flow * 2.0f, scratch, &lost);
+    flow = fm_track_level (left1, right1, (left_origin + pt) / 2.0f, (right_origin + pt) / 2.0f, flow * 2.0f, scratch, &lost);
+    flow = fm_track_level (left0, right0, left_origin + pt, right_origin + pt, flow * 2.0f, scratch, &lost);
+
+    float4 err = 0.0f;
+    for (int k = 0; k < FM_LK_PER_ITEM; ++k) {
+        int i = lid + k * FM_LOCAL_SIZE;
+        if (i >= FM_LK_AREA)
+            continue;
+
+        float2 offset = fm_window_offset (i);
+        err.x += fabs (fm_read_luma (right0, right_origin + pt + flow + offset) - fm_read_luma (left0, left_origin + pt + offset));
+    }
+    err = fm_group_sum (scratch, err);
+
+    if (lid == 0) {
+        tracked[index] = pt + flow;
+        errors[index] = err.x * 255.0f / FM_LK_AREA;
+        status[index] = lost ? 0 : 1;
+    }
+}
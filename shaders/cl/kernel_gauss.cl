@@ -1,8 +1,10 @@
 /*
- * function: kernel_gauss
- * input:    image2d_t as read only
- * output:   image2d_t as write only
- * workitem = 4x2 pixel ouptut
+ * function: kernel_gauss_h
+ *     horizontal pass of separable gauss window, rows of work group cached in local memory
+ * input:    image2d_t CL_R as read only
+ * buf:      width x height floats, horizontal result
+ * table:    GAUSS_SCALE weights
+ * workitem = 4 pixels, work group GAUSS_H_LOCAL_X x GAUSS_H_LOCAL_Y
  * GAUSS_RADIUS must be defined in build options.
  */
 
@@ -12,47 +14,187 @@
 
 #define GAUSS_SCALE (2 * GAUSS_RADIUS + 1)
 
-__kernel void kernel_gauss (__read_only image2d_t input, __write_only image2d_t output, __global float *table)
+#define GAUSS_H_LOCAL_X 16
+#define GAUSS_H_LOCAL_Y 4
+#define GAUSS_ROW_CACHE (GAUSS_H_LOCAL_X * 4 + 2 * GAUSS_RADIUS)
+
+#define GAUSS_V_LOCAL_X 8
+#define GAUSS_V_LOCAL_Y 16
+#define GAUSS_COL_CACHE (GAUSS_V_LOCAL_Y + 2 * GAUSS_RADIUS)
+
+__kernel void kernel_gauss_h (
+    __read_only image2d_t input, __global float *buf, int width, int height, __global float *table)
 {
     int x = get_global_id (0);
     int y = get_global_id (1);
+    int l_x = get_local_id (0);
+    int l_y = get_local_id (1);
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-    float4 in1;
-    int i, j;
-    int index;
-    float4 out1 = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
-    float4 out2 = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
-
-    for(i = 0; i < GAUSS_SCALE + 1; i++)
-        for(j = 0; j < GAUSS_SCALE + 3; j++) {
-            in1 = read_imagef (input, sampler, (int2)(4 * x - GAUSS_RADIUS + j, 2 * y - GAUSS_RADIUS + i));
-            //first line
-            if (i < GAUSS_SCALE) {
-                index = i * GAUSS_SCALE + j;
-                out1.x +=  (j < GAUSS_SCALE ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out1.y += ((j < GAUSS_SCALE + 1) && j > 0 ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out1.z += ((j < GAUSS_SCALE + 2) && j > 1 ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out1.w += (j > 2 ? table[index] * in1.x : 0.0f);
-            }
-            //second line
-            if (i > 0) {
-                index = (i - 1) * GAUSS_SCALE + j;
-                out2.x +=  (j < GAUSS_SCALE ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out2.y += ((j < GAUSS_SCALE + 1) && j > 0 ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out2.z += ((j < GAUSS_SCALE + 2) && j > 1 ? table[index] * in1.x : 0.0f);
-                index -= 1;
-                out2.w += (j > 2 ? table[index] * in1.x : 0.0f);
-            }
-        }
-
-    write_imagef(output, (int2)(x, 2 * y), out1);
-    write_imagef(output, (int2)(x,  2 * y + 1), out2);
+    __local float rows[GAUSS_H_LOCAL_Y][GAUSS_ROW_CACHE];
+    __local float weights[GAUSS_SCALE];
+
+    int row_begin = get_group_id (0) * GAUSS_H_LOCAL_X * 4 - GAUSS_RADIUS;
+    for (int i = l_x; i < GAUSS_ROW_CACHE; i += GAUSS_H_LOCAL_X)
+        rows[l_y][i] = read_imagef (input, sampler, (int2)(row_begin + i, y)).x;
+    for (int i = mad24 (l_y, GAUSS_H_LOCAL_X, l_x); i < GAUSS_SCALE; i += GAUSS_H_LOCAL_X * GAUSS_H_LOCAL_Y)
+        weights[i] = table[i];
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    if (x * 4 >= width || y >= height)
+        return;
+
+    __local float *row = rows[l_y] + l_x * 4;
+    float4 sum = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < GAUSS_SCALE; i++)
+        sum += (float4)(row[i], row[i + 1], row[i + 2], row[i + 3]) * weights[i];
+
+    vstore4 (sum, 0, buf + mad24 (y, width, x * 4));
+}
+
+/*
+ * function: kernel_gauss_v
+ *     vertical pass of separable gauss window, columns of work group cached in local memory
+ * buf:      horizontal result of kernel_gauss_h
+ * output:   image2d_t CL_RGBA as write only
+ * workitem = 4 pixels, work group GAUSS_V_LOCAL_X x GAUSS_V_LOCAL_Y
+ */
+__kernel void kernel_gauss_v (
+    __global float *buf, int width, int height, __write_only image2d_t output, __global float *table)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    int l_x = get_local_id (0);
+    int l_y = get_local_id (1);
+
+    __local float4 cols[GAUSS_COL_CACHE][GAUSS_V_LOCAL_X];
+    __local float weights[GAUSS_SCALE];
+
+    int col = min (x, width / 4 - 1) * 4;
+    int col_begin = get_group_id (1) * GAUSS_V_LOCAL_Y - GAUSS_RADIUS;
+    for (int i = l_y; i < GAUSS_COL_CACHE; i += GAUSS_V_LOCAL_Y) {
+        int row = clamp (col_begin + i, 0, height - 1);
+        cols[i][l_x] = vload4 (0, buf + mad24 (row, width, col));
+    }
+    for (int i = mad24 (l_y, GAUSS_V_LOCAL_X, l_x); i < GAUSS_SCALE; i += GAUSS_V_LOCAL_X * GAUSS_V_LOCAL_Y)
+        weights[i] = table[i];
+    barrier (CLK_LOCAL_MEM_FENCE);
 
+    if (x * 4 >= width || y >= height)
+        return;
+
+    float4 sum = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
+    for (int i = 0; i < GAUSS_SCALE; i++)
+        sum += cols[l_y + i][l_x] * weights[i];
+
+    write_imagef (output, (int2)(x, y), sum);
 }
 
+/*
+ * function: kernel_gauss_iir_h
+ *     horizontal pass of recursive gauss (Young / van Vliet), cost independent of sigma,
+ *     causal filter then anti-causal filter in place, edges extended
+ * input:    image2d_t CL_R as read only
+ * buf:      width x height floats, horizontal result
+ * coeffs:   B, b1, b2, b3 normalized by b0
+ * workitem = 1 row
+ */
+__kernel void kernel_gauss_iir_h (
+    __read_only image2d_t input, __global float *buf, int width, int height, float4 coeffs)
+{
+    int y = get_global_id (0);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    if (y >= height)
+        return;
+
+    __global float *line = buf + y * width;
+    float w1 = read_imagef (input, sampler, (int2)(0, y)).x;
+    float w2 = w1, w3 = w1;
+    for (int i = 0; i < width; i++) {
+        float w0 = coeffs.x * read_imagef (input, sampler, (int2)(i, y)).x + coeffs.y * w1 + coeffs.z * w2 + coeffs.w * w3;
+        line[i] = w0;
+        w3 = w2;
+        w2 = w1;
+        w1 = w0;
+    }
+
+    w2 = w1;
+    w3 = w1;
+    for (int i = width - 1; i >= 0; i--) {
+        float w0 = coeffs.x * line[i] + coeffs.y * w1 + coeffs.z * w2 + coeffs.w * w3;
+        line[i] = w0;
+        w3 = w2;
+        w2 = w1;
+        w1 = w0;
+    }
+}
+
+/*
+ * function: kernel_gauss_iir_v
+ *     vertical pass of recursive gauss, causal filter in place, anti-causal filter to output
+ * buf:      horizontal result of kernel_gauss_iir_h
+ * output:   image2d_t CL_RGBA as write only
+ * workitem = 4 columns
+ */
+__kernel void kernel_gauss_iir_v (
+    __global float *buf, int width, int height, __write_only image2d_t output, float4 coeffs)
+{
+    int x = get_global_id (0);
+
+    if (x * 4 >= width)
+        return;
+
+    __global float *column = buf + x * 4;
+    float4 w1 = vload4 (0, column);
+    float4 w2 = w1, w3 = w1;
+    for (int i = 0; i < height; i++) {
+        float4 w0 = coeffs.x * vload4 (0, column + i * width) + coeffs.y * w1 + coeffs.z * w2 + coeffs.w * w3;
+        vstore4 (w0, 0, column + i * width);
+        w3 = w2;
+        w2 = w1;
+        w1 = w0;
+    }
+
+    w2 = w1;
+    w3 = w1;
+    for (int i = height - 1; i >= 0; i--) {
+        float4 w0 = coeffs.x * vload4 (0, column + i * width) + coeffs.y * w1 + coeffs.z * w2 + coeffs.w * w3;
+        write_imagef (output, (int2)(x, i), w0);
+        w3 = w2;
+        w2 = w1;
+        w1 = w0;
+    }
+}
+
+/*
+ * function: kernel_gauss_pyramid_down
+ *           5x5 binomial blur and 2x decimation of one gauss pyramid level
+ * input:    level image2d_t as read only, CL_R
+ * output:   next level image2d_t as write only, CL_R
+ * workitem = 1 pixel output
+ */
+
+__constant float gauss_pyramid_coeffs[5] = {0.0625f, 0.25f, 0.375f, 0.25f, 0.0625f};
+
+__kernel void kernel_gauss_pyramid_down (__read_only image2d_t input, __write_only image2d_t output)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    if (x >= get_image_width (output) || y >= get_image_height (output))
+        return;
+
+    float sum = 0.0f;
+#pragma unroll
+    for (int i = 0; i < 5; ++i) {
+        float line = 0.0f;
+#pragma unroll
+        for (int j = 0; j < 5; ++j)
+            line += gauss_pyramid_coeffs[j] * read_imagef (input, sampler, (int2)(2 * x - 2 + j, 2 * y - 2 + i)).x;
+        sum += gauss_pyramid_coeffs[i] * line;
+    }
+
+    write_imagef (output, (int2)(x, y), (float4)(sum, 0.0f, 0.0f, 0.0f));
+}
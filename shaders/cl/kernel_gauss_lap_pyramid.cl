@@ -198,6 +198,48 @@ kernel_gauss_lap_reconstruct (
 #endif
 }
 
+/*
+ * reconstruct of level 0 scaled into output window, in place of kernel_pyramid_scale on it
+ * input_gauss: CL_UNORM_INT8 R(Y) or RG(UV), reconstruct of level 1
+ * input_lap:   CL_UNORM_INT8 R(Y) or RG(UV), blended lap of level 0
+ * output:      RGBA-CL_UNSIGNED_INT16
+ * output_width, output_height: scaled window size
+ */
+__kernel void
+kernel_gauss_lap_reconstruct_scale (
+    __read_only image2d_t input_gauss,
+    float in_sampler_offset_x, float in_sampler_offset_y,
+    __read_only image2d_t input_lap,
+    __write_only image2d_t output, int out_offset_x, int output_width, int output_height)
+{
+    const sampler_t sampler = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+    int g_x = get_global_id (0);
+    int g_y = get_global_id (1);
+
+    if (g_x >= output_width || g_y >= output_height)
+        return;
+
+    float2 norm_pos = (float2)(g_x, g_y) / (float2)(output_width, output_height);
+    float2 input_gauss_pos = norm_pos + (float2)(in_sampler_offset_x, in_sampler_offset_y);
+    float8 data_g, lap;
+    float step_x;
+
+#if !PYRAMID_UV
+    step_x = 0.125f / output_width;
+    data_g = read_scale_y (input_gauss, sampler, input_gauss_pos, step_x) * 256.0f;
+    lap = read_scale_y (input_lap, sampler, norm_pos, step_x) * 255.0f;
+#else
+    step_x = 0.25f / output_width;
+    data_g = read_scale_uv (input_gauss, sampler, input_gauss_pos, step_x) * 256.0f;
+    lap = read_scale_uv (input_lap, sampler, norm_pos, step_x) * 255.0f;
+#endif
+    lap = (lap - 128.0f) * 2.0f;
+
+    data_g += lap + 0.5f;
+    data_g = clamp (data_g, 0.0f, 255.0f);
+    write_imageui (output, (int2)(g_x + out_offset_x, g_y), convert_uint4(as_ushort4(convert_uchar8(data_g))));
+}
+
 __kernel void
 kernel_pyramid_blend (
     __read_only image2d_t input0, __read_only image2d_t input1,
@@ -366,51 +408,67 @@ __inline int pos_buf_index (int x, int y, int stride)
     return mad24 (stride, y, x);
 }
 
+// columns out of the band of previous row are never a predecessor
+__inline float band_sum (__local float *slm_sum, int idx, int band_width)
+{
+    return (idx >= 0 && idx < band_width) ? slm_sum[idx] : MAXFLOAT;
+}
+
+/*
+ * band_buf: first column of the search band of each row, band of adjacent rows
+ *           moves no more than 1 column, band_width columns per row.
+ * every work item owns one column of the band, all columns of a row are
+ * solved at once, rows go one by one from top and bottom borders to middle.
+ */
 __kernel void
 kernel_seam_dp (
     __read_only image2d_t image,
-    __global short *pos_buf, __global float *sum_buf, int offset_x, int valid_width,
-    int max_pos, int seam_height, int seam_stride)
+    __global short *pos_buf, __global float *sum_buf, __global int *band_buf,
+    int band_width, int seam_height, int seam_stride)
 {
     int l_x = get_local_id (0);
     int group_id = get_group_id (0);
-    if (l_x >= valid_width)
+    if (l_x >= band_width)
         return;
 
     // group0 fill first half slice image curve y = [0, seam_height/2 - 1]
     // group1 fill send half slice image curve = [seam_height - 1, seam_height/2]
     int first_slice_h = seam_height / 2;
     int group_h = (group_id == 0 ? first_slice_h : seam_height - first_slice_h);
+    int step = (group_id == 0 ? 1 : -1);
 
     __local float slm_sum[4096];
     float mid, left, right, cur;
     int slm_idx;
-    int default_pos;
 
-    int x = l_x + offset_x;
     const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
     int y = (group_id == 0 ? 0 : seam_height - 1);
+    int band_x = band_buf[y];
+    int x = l_x + band_x;
     float sum = convert_float(read_imageui(image, sampler, (int2)(x, y)).x);
 
-    default_pos = x;
     slm_sum[l_x] = sum;
     barrier (CLK_LOCAL_MEM_FENCE);
-    pos_buf[pos_buf_index(x, y, seam_stride)] = convert_short(default_pos);
-
-    for (int i = 0; i < group_h; ++i) {
-        y = (group_id == 0 ? i : seam_height - i - 1);
-        slm_idx = l_x - 1;
-        slm_idx = (slm_idx > 0 ? slm_idx : 0);
-        left = slm_sum[slm_idx];
-        slm_idx = l_x + 1;
-        slm_idx = (slm_idx < valid_width ? slm_idx : valid_width - 1);
-        right = slm_sum[slm_idx];
+    pos_buf[pos_buf_index(x, y, seam_stride)] = convert_short(x);
+
+    for (int i = 1; i < group_h; ++i) {
+        y += step;
+        int prev_band_x = band_x;
+        band_x = band_buf[y];
+        x = l_x + band_x;
+
+        // same column in previous row
+        slm_idx = l_x + band_x - prev_band_x;
+        left = band_sum (slm_sum, slm_idx - 1, band_width);
+        mid = band_sum (slm_sum, slm_idx, band_width);
+        right = band_sum (slm_sum, slm_idx + 1, band_width);
+        barrier (CLK_LOCAL_MEM_FENCE);
 
         cur = convert_float(read_imageui(image, sampler, (int2)(x, y)).x);
 
         left = left + cur;
         right = right + cur;
-        mid = sum + cur;
+        mid = mid + cur;
 
         int pos;
         pos = (left < mid) ? LEFT_POS : MID_POS;
@@ -420,14 +478,10 @@ kernel_seam_dp (
         slm_sum[l_x] = sum;
         barrier (CLK_LOCAL_MEM_FENCE);
 
-        pos += default_pos;
-        pos = clamp (pos, offset_x, max_pos);
-        //if (l_x == 3)
-        //    printf ("s:%f, pos:%d, mid:%f, offset_x:%d\n", sum.s0, pos.s0, mid.s0, offset_x);
+        pos += x;
         pos_buf[pos_buf_index(x, y, seam_stride)] = convert_short(pos);
     }
     sum_buf[group_id * seam_stride + x] = sum;
-    //printf ("sum(x):%f(x:%d)\n", sum_buf[x].s0, x);
 }
 
 __kernel void
@@ -612,3 +666,343 @@ kernel_mask_gauss_scale (
 
 }
 
+
+/*
+ * SLM tiled pyramid kernels, work-group MUST be 8x8.
+ * each work-group computes SLM_TILE_W bytes x SLM_TILE_H lines of the finest level,
+ * FUSE_TWO_LEVELS computes next level of the same tile in one launch.
+ * up-scaling is bilinear at half pixel, same as the sampler of kernel_lap_transform and
+ * kernel_gauss_lap_reconstruct with SAMPLER_POSITION_OFFSET 0.
+ */
+#ifndef FUSE_TWO_LEVELS
+#define FUSE_TWO_LEVELS 0
+#endif
+
+#if PYRAMID_UV
+#define PIXEL_BYTES 2
+#else
+#define PIXEL_BYTES 1
+#endif
+
+#define SLM_WG_SIZE 64
+#define SLM_TILE_TX 8
+#define SLM_TILE_W (SLM_TILE_TX * 8)
+#define SLM_TILE_H 32
+#define SLM_TILE1_W (SLM_TILE_W / 2)
+#define SLM_TILE1_H (SLM_TILE_H / 2)
+#define SLM_TILE2_W (SLM_TILE_W / 4)
+#define SLM_TILE2_H (SLM_TILE_H / 4)
+
+// sampler path reads UNORM8 as v/255 and scales by 256
+#define UNORM_SCALE (256.0f / 255.0f)
+
+// gauss_lap: halo pixels of level 1 before(L) and after(R) the tile
+#if FUSE_TWO_LEVELS
+#define G1_SLM_L 4
+#define G1_SLM_R 1
+#else
+#define G1_SLM_L 1
+#define G1_SLM_R 0
+#endif
+#define G1_SLM_W (SLM_TILE1_W + (G1_SLM_L + G1_SLM_R) * PIXEL_BYTES)
+#define G1_SLM_H (SLM_TILE1_H + G1_SLM_L + G1_SLM_R)
+#define G2_SLM_W (SLM_TILE2_W + PIXEL_BYTES)
+#define G2_SLM_H (SLM_TILE2_H + 1)
+
+#define IN_SLM_T (G1_SLM_L * 2 + 2)
+#define IN_SLM_B (G1_SLM_R * 2 + 1)
+#define IN_SLM_TX_L ((IN_SLM_T * PIXEL_BYTES + 7) / 8)
+#define IN_SLM_TX_R ((IN_SLM_B * PIXEL_BYTES + 7) / 8)
+#define IN_SLM_TX (SLM_TILE_TX + IN_SLM_TX_L + IN_SLM_TX_R)
+#define IN_SLM_W (IN_SLM_TX * 8)
+#define IN_SLM_H (SLM_TILE_H + IN_SLM_T + IN_SLM_B)
+
+inline void
+load_slm_texels (
+    __read_only image2d_t image, __local uchar *slm,
+    int tx0, int y0, int width_tx, int lines, int lid)
+{
+    const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    for (int i = lid; i < width_tx * lines; i += SLM_WG_SIZE) {
+        int line = i / width_tx;
+        int tx = i - line * width_tx;
+        uint4 data = read_imageui (image, sampler, (int2)(tx0 + tx, y0 + line));
+        vstore8 (as_uchar8 (convert_ushort4 (data)), 0, slm + (line * width_tx + tx) * 8);
+    }
+}
+
+// byte position clamped as CLK_ADDRESS_CLAMP_TO_EDGE on RGBA16 texels
+inline int
+clamp_texel_pos (int pos, int width_tx)
+{
+    int tx = (pos >= 0 ? pos : pos - 7) / 8;
+    int offset = pos - tx * 8;
+    return clamp (tx, 0, width_tx - 1) * 8 + offset;
+}
+
+// vertical then horizontal in the order of kernel_gauss_scale_transform
+inline uchar
+gauss_scale_slm (__local const uchar *slm, int stride, int pos, int line, int lines)
+{
+    float col[GAUSS_V_R * 2 + 1];
+
+    for (int i_h = 0; i_h <= GAUSS_V_R * 2; ++i_h) {
+        int cur_pos = clamp (pos + (i_h - GAUSS_V_R) * PIXEL_BYTES, 0, stride - 1);
+        col[i_h] = 0.0f;
+        for (int i_v = -GAUSS_V_R; i_v <= GAUSS_V_R; ++i_v) {
+            int cur_line = clamp (line + i_v, 0, lines - 1);
+            col[i_h] += slm[cur_line * stride + cur_pos] * coeffs[i_v + COEFF_MID];
+        }
+    }
+
+    float sum = col[2] * coeffs[COEFF_MID] + col[1] * coeffs[COEFF_MID + 1] + col[0] * coeffs[COEFF_MID + 2] +
+                col[3] * coeffs[COEFF_MID + 1] + col[4] * coeffs[COEFF_MID + 2];
+    return convert_uchar_sat (sum + 0.5f);
+}
+
+/*
+ * x, y: byte and line on finer level
+ * slm_x, slm_y: byte and line on coarser level where slm starts
+ * neighbors before first pixel/line are clamped to edge
+ */
+inline float
+upsample_pixel_slm (int x, int y, __local const uchar *slm, int stride, int slm_x, int slm_y)
+{
+    int pixel = x / PIXEL_BYTES;
+    int k = pixel / 2;
+    int m = y / 2;
+    int pos = k * PIXEL_BYTES + (x - pixel * PIXEL_BYTES) - slm_x;
+    int left = ((pixel & 1) || k == 0) ? 0 : PIXEL_BYTES;
+    int top = ((y & 1) || m == 0) ? 0 : stride;
+    __local const uchar *cur = slm + (m - slm_y) * stride + pos;
+
+    float sum = cur[0] + cur[-left] + cur[-top] + cur[-left - top];
+    return sum * (0.25f * UNORM_SCALE);
+}
+
+inline float8
+upsample_texel_slm (int x, int y, __local const uchar *slm, int stride, int slm_x, int slm_y)
+{
+    float data[8];
+    for (int i = 0; i < 8; ++i)
+        data[i] = upsample_pixel_slm (x + i, y, slm, stride, slm_x, slm_y);
+    return vload8 (0, data);
+}
+
+inline uint4
+lap_texel_slm (
+    __local const uchar *fine, int x, int y,
+    __local const uchar *slm, int stride, int slm_x, int slm_y)
+{
+    float8 orig = convert_float8 (vload8 (0, fine));
+    float8 lap = (orig - upsample_texel_slm (x, y, slm, stride, slm_x, slm_y)) * 0.5f + 128.0f + 0.5f;
+    return convert_uint4 (as_ushort4 (convert_uchar8_sat (lap)));
+}
+
+/*
+ * input: RGBA-CL_UNSIGNED_INT16, gauss of level 0
+ * output_lap: RGBA-CL_UNSIGNED_INT16, lap of level 0
+ * FUSE_TWO_LEVELS
+ *   output_lap1: RGBA-CL_UNSIGNED_INT16, lap of level 1
+ *   output_gauss2: RGBA-CL_UNSIGNED_INT16, gauss of level 2
+ * else
+ *   output_gauss1: RGBA-CL_UNSIGNED_INT16, gauss of level 1
+ * widths in RGBA16 texels
+ */
+__kernel void
+kernel_gauss_lap_slm (
+    __read_only image2d_t input, int in_offset_x,
+    __write_only image2d_t output_lap, int lap_offset_x, int lap_width, int lap_height,
+    int gauss1_width, int gauss1_height
+#if FUSE_TWO_LEVELS
+    , __write_only image2d_t output_lap1, __write_only image2d_t output_gauss2,
+    int gauss2_width, int gauss2_height
+#else
+    , __write_only image2d_t output_gauss1
+#endif
+)
+{
+    __local uchar in_slm[IN_SLM_W * IN_SLM_H];
+    __local uchar g1_slm[G1_SLM_W * G1_SLM_H];
+
+    const int lid = get_local_id (1) * get_local_size (0) + get_local_id (0);
+    const int tile_x = get_group_id (0) * SLM_TILE_W;
+    const int tile_y = get_group_id (1) * SLM_TILE_H;
+    const int in_x = tile_x - IN_SLM_TX_L * 8;
+    const int in_y = tile_y - IN_SLM_T;
+    const int g1_x = tile_x / 2 - G1_SLM_L * PIXEL_BYTES;
+    const int g1_y = tile_y / 2 - G1_SLM_L;
+    int i;
+
+    load_slm_texels (input, in_slm, in_x / 8 + in_offset_x, in_y, IN_SLM_TX, IN_SLM_H, lid);
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (i = lid; i < G1_SLM_W * G1_SLM_H; i += SLM_WG_SIZE) {
+        int line = i / G1_SLM_W;
+        int pos = clamp_texel_pos (g1_x + i - line * G1_SLM_W, gauss1_width);
+        int pixel = pos / PIXEL_BYTES;
+        line = clamp (g1_y + line, 0, gauss1_height - 1);
+        g1_slm[i] = gauss_scale_slm (
+                        in_slm, IN_SLM_W, pixel * 2 * PIXEL_BYTES + (pos - pixel * PIXEL_BYTES) - in_x,
+                        line * 2 - in_y, IN_SLM_H);
+    }
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+#if FUSE_TWO_LEVELS
+    __local uchar g2_slm[G2_SLM_W * G2_SLM_H];
+    const int g2_x = tile_x / 4 - PIXEL_BYTES;
+    const int g2_y = tile_y / 4 - 1;
+
+    for (i = lid; i < G2_SLM_W * G2_SLM_H; i += SLM_WG_SIZE) {
+        int line = i / G2_SLM_W;
+        int pos = clamp_texel_pos (g2_x + i - line * G2_SLM_W, gauss2_width);
+        int pixel = pos / PIXEL_BYTES;
+        line = clamp (g2_y + line, 0, gauss2_height - 1);
+        g2_slm[i] = gauss_scale_slm (
+                        g1_slm, G1_SLM_W, pixel * 2 * PIXEL_BYTES + (pos - pixel * PIXEL_BYTES) - g1_x,
+                        line * 2 - g1_y, G1_SLM_H);
+    }
+    barrier (CLK_LOCAL_MEM_FENCE);
+#endif
+
+    for (i = lid; i < SLM_TILE_TX * SLM_TILE_H; i += SLM_WG_SIZE) {
+        int line = i / SLM_TILE_TX;
+        int tx = i - line * SLM_TILE_TX;
+        int g_tx = tile_x / 8 + tx;
+        int g_y = tile_y + line;
+        if (g_tx >= lap_width || g_y >= lap_height)
+            continue;
+
+        uint4 lap = lap_texel_slm (
+                        in_slm + (g_y - in_y) * IN_SLM_W + g_tx * 8 - in_x, g_tx * 8, g_y,
+                        g1_slm, G1_SLM_W, g1_x, g1_y);
+        write_imageui (output_lap, (int2)(g_tx + lap_offset_x, g_y), lap);
+    }
+
+    for (i = lid; i < SLM_TILE_TX / 2 * SLM_TILE1_H; i += SLM_WG_SIZE) {
+        int line = i / (SLM_TILE_TX / 2);
+        int tx = i - line * (SLM_TILE_TX / 2);
+        int g_tx = tile_x / 16 + tx;
+        int g_y = tile_y / 2 + line;
+        if (g_tx >= gauss1_width || g_y >= gauss1_height)
+            continue;
+
+        __local const uchar *g1 = g1_slm + (g_y - g1_y) * G1_SLM_W + g_tx * 8 - g1_x;
+#if FUSE_TWO_LEVELS
+        uint4 lap = lap_texel_slm (g1, g_tx * 8, g_y, g2_slm, G2_SLM_W, g2_x, g2_y);
+        write_imageui (output_lap1, (int2)(g_tx, g_y), lap);
+#else
+        write_imageui (output_gauss1, (int2)(g_tx, g_y), convert_uint4 (as_ushort4 (vload8 (0, g1))));
+#endif
+    }
+
+#if FUSE_TWO_LEVELS
+    for (i = lid; i < SLM_TILE_TX / 4 * SLM_TILE2_H; i += SLM_WG_SIZE) {
+        int line = i / (SLM_TILE_TX / 4);
+        int tx = i - line * (SLM_TILE_TX / 4);
+        int g_tx = tile_x / 32 + tx;
+        int g_y = tile_y / 4 + line;
+        if (g_tx >= gauss2_width || g_y >= gauss2_height)
+            continue;
+
+        __local const uchar *g2 = g2_slm + (g_y - g2_y) * G2_SLM_W + g_tx * 8 - g2_x;
+        write_imageui (output_gauss2, (int2)(g_tx, g_y), convert_uint4 (as_ushort4 (vload8 (0, g2))));
+    }
+#endif
+}
+
+// lap_reconstruct: coarsest input tile, one texel and one line of halo before the tile
+#if FUSE_TWO_LEVELS
+#define RIN_TILE_TX (SLM_TILE2_W / 8)
+#define RIN_TILE_H SLM_TILE2_H
+#else
+#define RIN_TILE_TX (SLM_TILE1_W / 8)
+#define RIN_TILE_H SLM_TILE1_H
+#endif
+#define RIN_SLM_TX (RIN_TILE_TX + 1)
+#define RIN_SLM_W (RIN_SLM_TX * 8)
+#define RIN_SLM_H (RIN_TILE_H + 1)
+
+#define LAP1_SLM_TX (SLM_TILE1_W / 8 + 1)
+#define LAP1_SLM_W (LAP1_SLM_TX * 8)
+#define LAP1_SLM_H (SLM_TILE1_H + 1)
+#define R1_SLM_W (SLM_TILE1_W + PIXEL_BYTES)
+#define R1_SLM_H (SLM_TILE1_H + 1)
+
+/*
+ * input_reconst: RGBA-CL_UNSIGNED_INT16, reconstruct of level 2 if FUSE_TWO_LEVELS else level 1
+ * input_lap1: RGBA-CL_UNSIGNED_INT16, blended lap of level 1
+ * input_lap: RGBA-CL_UNSIGNED_INT16, blended lap of level 0
+ * output: RGBA-CL_UNSIGNED_INT16, reconstruct of level 0
+ * widths in RGBA16 texels
+ */
+__kernel void
+kernel_lap_reconstruct_slm (
+    __read_only image2d_t input_reconst,
+#if FUSE_TWO_LEVELS
+    __read_only image2d_t input_lap1, int reconst1_width, int reconst1_height,
+#endif
+    __read_only image2d_t input_lap,
+    __write_only image2d_t output, int out_offset_x, int out_width, int out_height)
+{
+    const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    __local uchar rin_slm[RIN_SLM_W * RIN_SLM_H];
+
+    const int lid = get_local_id (1) * get_local_size (0) + get_local_id (0);
+    const int tile_x = get_group_id (0) * SLM_TILE_W;
+    const int tile_y = get_group_id (1) * SLM_TILE_H;
+    int i;
+
+#if FUSE_TWO_LEVELS
+    __local uchar lap1_slm[LAP1_SLM_W * LAP1_SLM_H];
+    __local uchar r1_slm[R1_SLM_W * R1_SLM_H];
+    const int rin_x = tile_x / 4 - 8;
+    const int rin_y = tile_y / 4 - 1;
+    const int lap1_x = tile_x / 2 - 8;
+    const int lap1_y = tile_y / 2 - 1;
+    const int src_x = tile_x / 2 - PIXEL_BYTES;
+    const int src_y = tile_y / 2 - 1;
+    __local const uchar *src_slm = r1_slm;
+    const int src_stride = R1_SLM_W;
+
+    load_slm_texels (input_reconst, rin_slm, rin_x / 8, rin_y, RIN_SLM_TX, RIN_SLM_H, lid);
+    load_slm_texels (input_lap1, lap1_slm, lap1_x / 8, lap1_y, LAP1_SLM_TX, LAP1_SLM_H, lid);
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    for (i = lid; i < R1_SLM_W * R1_SLM_H; i += SLM_WG_SIZE) {
+        int line = i / R1_SLM_W;
+        int pos = clamp_texel_pos (src_x + i - line * R1_SLM_W, reconst1_width);
+        line = clamp (src_y + line, 0, reconst1_height - 1);
+
+        int lap_pos = clamp (pos - lap1_x, 0, LAP1_SLM_W - 1);
+        int lap_line = clamp (line - lap1_y, 0, LAP1_SLM_H - 1);
+        float lap = (lap1_slm[lap_line * LAP1_SLM_W + lap_pos] - 128.0f) * 2.0f;
+        float data = upsample_pixel_slm (pos, line, rin_slm, RIN_SLM_W, rin_x, rin_y) + lap + 0.5f;
+        r1_slm[i] = convert_uchar_sat (data);
+    }
+    barrier (CLK_LOCAL_MEM_FENCE);
+#else
+    const int src_x = tile_x / 2 - 8;
+    const int src_y = tile_y / 2 - 1;
+    __local const uchar *src_slm = rin_slm;
+    const int src_stride = RIN_SLM_W;
+
+    load_slm_texels (input_reconst, rin_slm, src_x / 8, src_y, RIN_SLM_TX, RIN_SLM_H, lid);
+    barrier (CLK_LOCAL_MEM_FENCE);
+#endif
+
+    for (i = lid; i < SLM_TILE_TX * SLM_TILE_H; i += SLM_WG_SIZE) {
+        int line = i / SLM_TILE_TX;
+        int tx = i - line * SLM_TILE_TX;
+        int g_tx = tile_x / 8 + tx;
+        int g_y = tile_y + line;
+        if (g_tx >= out_width || g_y >= out_height)
+            continue;
+
+        float8 lap = convert_float8 (as_uchar8 (convert_ushort4 (read_imageui (input_lap, sampler, (int2)(g_tx, g_y)))));
+        lap = (lap - 128.0f) * 2.0f;
+        float8 data = upsample_texel_slm (g_tx * 8, g_y, src_slm, src_stride, src_x, src_y) + lap + 0.5f;
+        write_imageui (output, (int2)(g_tx + out_offset_x, g_y), convert_uint4 (as_ushort4 (convert_uchar8_sat (data))));
+    }
+}
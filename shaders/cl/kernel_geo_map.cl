@@ -5,6 +5,7 @@
  * geo_table, CL_RGBA + CL_FLOAT
  * output_y,  CL_RGBA + CL_UNSIGNED_INT16
  * output_uv,  CL_RGBA + CL_UNSIGNED_INT16
+ * direct_y/direct_uv, ENABLE_DIRECT_OUT only, same format as output, columns in direct range written here
  *
  * description:
  * the center of geo_table and output positons are both mapped to (0, 0)
@@ -18,6 +19,10 @@
 #define ENABLE_SCALE 0
 #endif
 
+#ifndef ENABLE_DIRECT_OUT
+#define ENABLE_DIRECT_OUT 0
+#endif
+
 #define CONST_DATA_Y 0.0f
 #define CONST_DATA_UV (float2)(0.5f, 0.5f)
 
@@ -77,11 +82,26 @@ kernel_geo_map (
 #if ENABLE_LSC
     __read_only image2d_t lsc_table, float2 gray_threshold,
 #endif
-    __write_only image2d_t output_y, __write_only image2d_t output_uv, float2 out_size)
+    __write_only image2d_t output_y, __write_only image2d_t output_uv, float2 out_size
+#if ENABLE_DIRECT_OUT
+    , __write_only image2d_t direct_y, __write_only image2d_t direct_uv,
+    int4 direct_range, int2 direct_offset
+#endif
+)
 {
     const int g_x = get_global_id (0);
     const int g_y_uv = get_global_id (1);
     const int g_y = get_global_id (1) * 2;
+#if ENABLE_DIRECT_OUT
+    // columns in [direct_range.x, direct_range.z) go to final image, shifted by direct_offset.x before direct_range.y
+    const bool is_direct = (g_x >= direct_range.x && g_x < direct_range.z);
+    const int direct_x = g_x + (g_x < direct_range.y ? direct_offset.x : direct_offset.y);
+#define GEO_WRITE_OUT(plane, y, data) \
+    if (is_direct) write_imageui (direct_##plane, (int2)(direct_x, y), data); \
+    else write_imageui (output_##plane, (int2)(g_x, y), data)
+#else
+#define GEO_WRITE_OUT(plane, y, data) write_imageui (output_##plane, (int2)(g_x, y), data)
+#endif
     float8 output_data;
     float2 from_pos;
     bool out_of_bound[8];
@@ -122,13 +142,13 @@ kernel_geo_map (
     get_lsc_data (lsc_table, (int2)(g_x, g_y), table_scale_step.x, gray_threshold, output_data, &lsc_data);
     output_data = clamp (output_data * lsc_data, 0.0f, 1.0f);
 #endif
-    write_imageui (output_y, (int2)(g_x, g_y), convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
+    GEO_WRITE_OUT (y, g_y, convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
 
     output_data.s01 = out_of_bound[0] ? CONST_DATA_UV : read_imagef (input_uv, sampler, input_pos[0]).xy;
     output_data.s23 = out_of_bound[2] ? CONST_DATA_UV : read_imagef (input_uv, sampler, input_pos[2]).xy;
     output_data.s45 = out_of_bound[4] ? CONST_DATA_UV : read_imagef (input_uv, sampler, input_pos[4]).xy;
     output_data.s67 = out_of_bound[6] ? CONST_DATA_UV : read_imagef (input_uv, sampler, input_pos[6]).xy;
-    write_imageui (output_uv, (int2)(g_x, g_y_uv), convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
+    GEO_WRITE_OUT (uv, g_y_uv, convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
 
 #if ENABLE_SCALE
     scale.y = (g_y + 1 >= stable_y_start) ? 1.0f : ((right_scale_factor.y - left_scale_factor.y) /
@@ -151,5 +171,5 @@ kernel_geo_map (
     get_lsc_data (lsc_table, (int2)(g_x, g_y + 1), table_scale_step.x, gray_threshold, output_data, &lsc_data);
     output_data = clamp (output_data * lsc_data, 0.0f, 1.0f);
 #endif
-    write_imageui (output_y, (int2)(g_x, g_y + 1), convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
+    GEO_WRITE_OUT (y, g_y + 1, convert_uint4(as_ushort4(convert_uchar8(output_data * 255.0f))));
 }
@@ -21,3 +21,83 @@ __kernel void kernel_image_scaler (__read_only image2d_t input,
     write_imagef(output, (int2)(x, y), scaled_pixel);
 }
 
+
+/*
+ * polyphase separable scaler, horizontal pass then vertical pass,
+ * each pass writes all outputs (at most 3) in one launch, get_global_id(2) is output index.
+ * table of an output keeps (taps + 1) floats per output coordinate, first source coordinate then weights.
+ */
+inline float4 polyphase_filter_h (__read_only image2d_t input, __global const float *table, int taps, int x, int y)
+{
+    const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    __global const float *entry = table + x * (taps + 1);
+    int start = (int)entry[0];
+    float4 sum = 0.0f;
+    for (int i = 0; i < taps; ++i)
+        sum += entry[i + 1] * read_imagef (input, sampler, (int2)(start + i, y));
+    return clamp (sum, 0.0f, 1.0f);
+}
+
+inline float4 polyphase_filter_v (__read_only image2d_t input, __global const float *table, int taps, int x, int y)
+{
+    const sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    __global const float *entry = table + y * (taps + 1);
+    int start = (int)entry[0];
+    float4 sum = 0.0f;
+    for (int i = 0; i < taps; ++i)
+        sum += entry[i + 1] * read_imagef (input, sampler, (int2)(x, start + i));
+    return clamp (sum, 0.0f, 1.0f);
+}
+
+/*
+ * function: kernel_image_scaler_polyphase_h
+ * input:      source plane
+ * output0-2:  intermediate planes, output width x source height
+ * table0-2:   horizontal coefficient tables
+ * out_count:  valid outputs, unused image and table args repeat the first output
+ */
+__kernel void kernel_image_scaler_polyphase_h (
+    __read_only image2d_t input,
+    __write_only image2d_t output0, __write_only image2d_t output1, __write_only image2d_t output2,
+    __global const float *table0, __global const float *table1, __global const float *table2,
+    int4 taps, int4 out_width, int height, int out_count)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    int index = get_global_id (2);
+    if (index >= out_count || y >= height)
+        return;
+
+    if (index == 0 && x < out_width.s0)
+        write_imagef (output0, (int2)(x, y), polyphase_filter_h (input, table0, taps.s0, x, y));
+    else if (index == 1 && x < out_width.s1)
+        write_imagef (output1, (int2)(x, y), polyphase_filter_h (input, table1, taps.s1, x, y));
+    else if (index == 2 && x < out_width.s2)
+        write_imagef (output2, (int2)(x, y), polyphase_filter_h (input, table2, taps.s2, x, y));
+}
+
+/*
+ * function: kernel_image_scaler_polyphase_v
+ * input0-2:   intermediate planes of kernel_image_scaler_polyphase_h
+ * output0-2:  scaled planes
+ * table0-2:   vertical coefficient tables
+ */
+__kernel void kernel_image_scaler_polyphase_v (
+    __read_only image2d_t input0, __read_only image2d_t input1, __read_only image2d_t input2,
+    __write_only image2d_t output0, __write_only image2d_t output1, __write_only image2d_t output2,
+    __global const float *table0, __global const float *table1, __global const float *table2,
+    int4 taps, int4 out_width, int4 out_height, int out_count)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    int index = get_global_id (2);
+    if (index >= out_count)
+        return;
+
+    if (index == 0 && x < out_width.s0 && y < out_height.s0)
+        write_imagef (output0, (int2)(x, y), polyphase_filter_v (input0, table0, taps.s0, x, y));
+    else if (index == 1 && x < out_width.s1 && y < out_height.s1)
+        write_imagef (output1, (int2)(x, y), polyphase_filter_v (input1, table1, taps.s1, x, y));
+    else if (index == 2 && x < out_width.s2 && y < out_height.s2)
+        write_imagef (output2, (int2)(x, y), polyphase_filter_v (input2, table2, taps.s2, x, y));
+}
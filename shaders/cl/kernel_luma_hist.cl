@@ -0,0 +1,91 @@
+/*
+ * luma histograms of SGRBG16 planar frames, planes Gr, R, B, Gb stacked vertically
+ * as RGBA UNORM_INT16 images of 4 pixels a texel.
+ * HIST_BINS:       bins of one block
+ * BLOCK_FACTOR:    frame split into BLOCK_FACTOR x BLOCK_FACTOR blocks, histograms stored row by row
+ */
+
+#ifndef HIST_BINS
+#define HIST_BINS 256
+#endif
+
+#ifndef BLOCK_FACTOR
+#define BLOCK_FACTOR 1
+#endif
+
+#define HIST_TOTAL_BINS (HIST_BINS * BLOCK_FACTOR * BLOCK_FACTOR)
+
+// work group counts into local memory first if all bins fit
+#define HIST_LOCAL_MAX_BINS 4096
+
+/*
+ * function:    kernel_luma_hist_clear
+ *     one work item per bin
+ */
+__kernel void kernel_luma_hist_clear (__global uint *hist)
+{
+    hist[get_global_id (0)] = 0;
+}
+
+/*
+ * function:    kernel_luma_hist
+ *     one work item counts 4 pixels
+ * plane_height:    aligned height of one plane
+ * width, height:   valid pixels
+ */
+__kernel void kernel_luma_hist (
+    __read_only image2d_t input, int plane_height, int width, int height, __global uint *hist)
+{
+    int g_id_x = get_global_id (0);
+    int g_id_y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+#if HIST_TOTAL_BINS <= HIST_LOCAL_MAX_BINS
+    __local uint local_hist[HIST_TOTAL_BINS];
+    int local_index = mad24 ((int)get_local_id (1), (int)get_local_size (0), (int)get_local_id (0));
+    int local_count = get_local_size (0) * get_local_size (1);
+    for (int i = local_index; i < HIST_TOTAL_BINS; i += local_count)
+        local_hist[i] = 0;
+    barrier (CLK_LOCAL_MEM_FENCE);
+#define HIST_COUNT(index) atomic_inc (local_hist + (index))
+#else
+#define HIST_COUNT(index) atomic_inc (hist + (index))
+#endif
+
+    int pos_x = g_id_x * 4;
+    if (pos_x < width && g_id_y < height) {
+        float4 data_Gr = read_imagef (input, sampler, (int2)(g_id_x, g_id_y));
+        float4 data_R = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + plane_height));
+        float4 data_B = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + plane_height * 2));
+        float4 data_Gb = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + plane_height * 3));
+
+        float4 y = data_R * 0.299f;
+        y = mad ((data_Gr + data_Gb) * 0.5f, 0.587f, y);
+        y = mad (data_B, 0.114f, y);
+        int4 bin = clamp (convert_int4 (mad (y, (float4)(HIST_BINS - 1), 0.5f)), 0, HIST_BINS - 1);
+
+        int block = 0;
+#if BLOCK_FACTOR > 1
+        int block_row = min (g_id_y / max (height / BLOCK_FACTOR, 1), BLOCK_FACTOR - 1);
+        int block_col = min (pos_x / max (width / BLOCK_FACTOR, 1), BLOCK_FACTOR - 1);
+        block = mad24 (block_row, BLOCK_FACTOR, block_col) * HIST_BINS;
+#endif
+
+        HIST_COUNT (block + bin.x);
+        if (pos_x + 1 < width)
+            HIST_COUNT (block + bin.y);
+        if (pos_x + 2 < width)
+            HIST_COUNT (block + bin.z);
+        if (pos_x + 3 < width)
+            HIST_COUNT (block + bin.w);
+    }
+
+#if HIST_TOTAL_BINS <= HIST_LOCAL_MAX_BINS
+    barrier (CLK_LOCAL_MEM_FENCE);
+    for (int i = local_index; i < HIST_TOTAL_BINS; i += local_count) {
+        uint count = local_hist[i];
+        if (count)
+            atomic_add (hist + i, count);
+    }
+#endif
+}
@@ -9,6 +9,24 @@
 #define WORK_ITEM_Y_SIZE 8
 #define BLOCK_FACTOR 4
 
+#ifndef ENABLE_FP16
+#define ENABLE_FP16 0
+#endif
+
+// half keeps color planes only, luma, histogram index and weights need float
+#if ENABLE_FP16
+#pragma OPENCL EXTENSION cl_khr_fp16 : enable
+#define data4_t half4
+#define read_image_data read_imageh
+#define write_image_data write_imageh
+#define convert_data4_t convert_half4
+#else
+#define data4_t float4
+#define read_image_data read_imagef
+#define write_image_data write_imagef
+#define convert_data4_t
+#endif
+
 __kernel void kernel_newtonemapping (
     __read_only image2d_t input, __write_only image2d_t output,
     __global float *y_max, __global float *y_avg, __global float *hist_leq,
@@ -34,17 +52,17 @@ __kernel void kernel_newtonemapping (
 
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-    float4 src_data_Gr = read_imagef (input, sampler, (int2)(g_id_x, g_id_y));
-    float4 src_data_R = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + image_height));
-    float4 src_data_B = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + image_height * 2));
-    float4 src_data_Gb = read_imagef (input, sampler, (int2)(g_id_x, g_id_y + image_height * 3));
+    data4_t src_data_Gr = read_image_data (input, sampler, (int2)(g_id_x, g_id_y));
+    data4_t src_data_R = read_image_data (input, sampler, (int2)(g_id_x, g_id_y + image_height));
+    data4_t src_data_B = read_image_data (input, sampler, (int2)(g_id_x, g_id_y + image_height * 2));
+    data4_t src_data_Gb = read_image_data (input, sampler, (int2)(g_id_x, g_id_y + image_height * 3));
 
-    float4 src_data_G = (src_data_Gr + src_data_Gb) / 2;
+    float4 src_data_G = (convert_float4 (src_data_Gr) + convert_float4 (src_data_Gb)) / 2;
 
     float4 src_y_data = 0.0f;
-    src_y_data = mad(src_data_R, 0.299f, src_y_data);
+    src_y_data = mad(convert_float4 (src_data_R), 0.299f, src_y_data);
     src_y_data = mad(src_data_G, 0.587f, src_y_data);
-    src_y_data = mad(src_data_B, 0.114f, src_y_data);
+    src_y_data = mad(convert_float4 (src_data_B), 0.114f, src_y_data);
 
     float4 dst_y_data;
     float4 d, wd, haleq, s, ws;
@@ -88,14 +106,14 @@ __kernel void kernel_newtonemapping (
 
     dst_y_data = total_haleq / total_w;
 
-    float4 gain = (dst_y_data + 0.0001f) / (src_y_data + 0.0001f);
+    data4_t gain = convert_data4_t ((dst_y_data + 0.0001f) / (src_y_data + 0.0001f));
     src_data_Gr = src_data_Gr * gain;
     src_data_R = src_data_R * gain;
     src_data_B = src_data_B * gain;
     src_data_Gb = src_data_Gb * gain;
 
-    write_imagef(output, (int2)(g_id_x, g_id_y), src_data_Gr);
-    write_imagef(output, (int2)(g_id_x, g_id_y + image_height), src_data_R);
-    write_imagef(output, (int2)(g_id_x, g_id_y + image_height * 2), src_data_B);
-    write_imagef(output, (int2)(g_id_x, g_id_y + image_height * 3), src_data_Gb);
+    write_image_data(output, (int2)(g_id_x, g_id_y), src_data_Gr);
+    write_image_data(output, (int2)(g_id_x, g_id_y + image_height), src_data_R);
+    write_image_data(output, (int2)(g_id_x, g_id_y + image_height * 2), src_data_B);
+    write_image_data(output, (int2)(g_id_x, g_id_y + image_height * 3), src_data_Gb);
 }
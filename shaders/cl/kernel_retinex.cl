@@ -8,6 +8,26 @@
 #define RETINEX_SCALE_SIZE 2
 #endif
 
+#ifndef ENABLE_FP16
+#define ENABLE_FP16 0
+#endif
+
+// half covers uv only, log table index and uv gain limits need float
+#if ENABLE_FP16
+#pragma OPENCL EXTENSION cl_khr_fp16 : enable
+#define data_t half
+#define data4_t half4
+#define read_image_data read_imageh
+#define write_image_data write_imageh
+#define convert_data4_t convert_half4
+#else
+#define data_t float
+#define data4_t float4
+#define read_image_data read_imagef
+#define write_image_data write_imagef
+#define convert_data4_t
+#endif
+
 typedef struct {
     float    gain;
     float    threshold;
@@ -69,7 +89,8 @@ __kernel void kernel_retinex (
     sampler_t sampler_orig = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
     sampler_t sampler_ga = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
 
-    float4 y_out, uv_in;
+    float4 y_out;
+    data4_t uv_in;
     float4 y_in, y_ga[RETINEX_SCALE_SIZE];
     float4 y_in_lg, y_lg;
     int i;
@@ -128,7 +149,8 @@ __kernel void kernel_retinex (
     // copy UV
     if(y % 2 == 0) {
         float2 avg_y_out, avg_y_in, gain_y;
-        float4 uv_out, gain_uv;
+        data4_t uv_out;
+        float4 gain_uv;
         y_in = y_in / 255.0f;
         avg_y_in = (float2)((y_in.x + y_in.y) * 0.5f, (y_in.z + y_in.w) * 0.5f);
         avg_y_out = (float2)((y_out.x + y_out.y) * 0.5f, (y_out.z + y_out.w) * 0.5f);
@@ -138,8 +160,8 @@ __kernel void kernel_retinex (
         gain_y = (avg_y_out + 0.1f) / (avg_y_in + 0.05f);
         gain_y = gain_y * (avg_y_in * 2.0f + 1.0f);
 
-        uv_in = read_imagef(input_uv, sampler_orig, (int2)(x, y / 2)) - 0.5f;
-        float2 v_coef = 1.01f / (1.13f * uv_in.xz + 0.01f);
+        uv_in = read_image_data(input_uv, sampler_orig, (int2)(x, y / 2)) - (data_t)0.5f;
+        float2 v_coef = 1.01f / (1.13f * convert_float2 (uv_in.xz) + 0.01f);
         float2 v_gain_1 = v_coef - avg_y_in * v_coef;
         float2 v_gain_2 = -v_coef;
         float2 v_gain_min = (v_gain_1 < v_gain_2) ? v_gain_1 : v_gain_2;
@@ -148,7 +170,7 @@ __kernel void kernel_retinex (
         v_gain_max = max (v_gain_max, 0.1f);
         gain_y = clamp (gain_y, v_gain_min, v_gain_max);
 
-        float2 u_coef = 1.01f / (2.03f * uv_in.yw + 0.01f);
+        float2 u_coef = 1.01f / (2.03f * convert_float2 (uv_in.yw) + 0.01f);
         float2 u_gain_1 = u_coef - avg_y_in * u_coef;
         float2 u_gain_2 = -u_coef;
         float2 u_gain_min = (u_gain_1 < u_gain_2) ? u_gain_1 : u_gain_2;
@@ -158,7 +180,7 @@ __kernel void kernel_retinex (
         gain_y = clamp (gain_y, u_gain_min, u_gain_max);
         gain_uv = (float4) (gain_y, gain_y);
         //printf (" (%.2f) ", gain_uv.x);
-        uv_out = uv_in * gain_uv + 0.5f;
-        write_imagef(output_uv, (int2)(x, y / 2), uv_out);
+        uv_out = uv_in * convert_data4_t (gain_uv) + (data_t)0.5f;
+        write_image_data(output_uv, (int2)(x, y / 2), uv_out);
     }
 }
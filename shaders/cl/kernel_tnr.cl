@@ -10,13 +10,10 @@
  * thr_uv:            Motion sensitivity for UV, higher value can cause more motion blur
  */
 
-__kernel void kernel_tnr_yuv(
+inline void tnr_yuv_pixels(
     __read_only image2d_t inputFrame, __read_only image2d_t inputFrame0,
-    __write_only image2d_t outputFrame, uint vertical_offset, float gain, float thr_y, float thr_uv)
+    __write_only image2d_t outputFrame, int x, int y, uint vertical_offset, float gain, float thr_y, float thr_uv)
 {
-    int x = get_global_id(0);
-    int y = get_global_id(1);
-
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
     float4 pixel_t0_Y1 = read_imagef(inputFrame0, sampler, (int2)(2 * x, 2 * y));
     float4 pixel_t0_Y2 = read_imagef(inputFrame0, sampler, (int2)(2 * x + 1, 2 * y));
@@ -76,6 +73,87 @@ __kernel void kernel_tnr_yuv(
     write_imagef(outputFrame, (int2)(2 * x + 1, y + vertical_offset), pixel_outV);
 }
 
+__kernel void kernel_tnr_yuv(
+    __read_only image2d_t inputFrame, __read_only image2d_t inputFrame0,
+    __write_only image2d_t outputFrame, uint vertical_offset, float gain, float thr_y, float thr_uv)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    tnr_yuv_pixels(inputFrame, inputFrame0, outputFrame, x, y, vertical_offset, gain, thr_y, thr_uv);
+}
+
+#define TNR_MOTION_TILE_SIZE    32
+#define TNR_MOTION_SAMPLE_STEP  4
+
+/*
+ * function: kernel_tnr_yuv_motion
+ *     per-tile motion mask from luma SAD sampled at 1/4 scale
+ * inputFrame:       image2d_t as read only
+ * inputFrame0:      image2d_t as read only, previous output
+ * motion_mask:      one byte per TNR_MOTION_TILE_SIZE tile, 1 means moving
+ * vertical_offset:  vertical offset from y to uv, luma rows of tiles are clamped under it
+ * tiles_x, tiles_y: tile count
+ * thr_motion:       mean absolute luma difference of a moving tile
+ */
+
+__kernel void kernel_tnr_yuv_motion(
+    __read_only image2d_t inputFrame, __read_only image2d_t inputFrame0,
+    __global uchar *motion_mask, uint vertical_offset, uint tiles_x, uint tiles_y, float thr_motion)
+{
+    int tile_x = get_global_id(0);
+    int tile_y = get_global_id(1);
+    if (tile_x >= tiles_x || tile_y >= tiles_y)
+        return;
+
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+    int2 origin = (int2)(tile_x, tile_y) * TNR_MOTION_TILE_SIZE + TNR_MOTION_SAMPLE_STEP / 2;
+    int max_y = (int)vertical_offset - 1;
+
+    float sad = 0.0f;
+    for (int j = 0; j < TNR_MOTION_TILE_SIZE / TNR_MOTION_SAMPLE_STEP; ++j) {
+        int pos_y = min(origin.y + j * TNR_MOTION_SAMPLE_STEP, max_y);
+        for (int i = 0; i < TNR_MOTION_TILE_SIZE / TNR_MOTION_SAMPLE_STEP; ++i) {
+            int2 pos = (int2)(origin.x + i * TNR_MOTION_SAMPLE_STEP, pos_y);
+            sad += fabs(read_imagef(inputFrame, sampler, pos).x - read_imagef(inputFrame0, sampler, pos).x);
+        }
+    }
+
+    const float samples = (TNR_MOTION_TILE_SIZE / TNR_MOTION_SAMPLE_STEP) * (TNR_MOTION_TILE_SIZE / TNR_MOTION_SAMPLE_STEP);
+    motion_mask[tile_y * tiles_x + tile_x] = (sad > thr_motion * samples) ? 1 : 0;
+}
+
+/*
+ * function: kernel_tnr_yuv_tiled
+ *     kernel_tnr_yuv on static tiles, moving tiles copy current frame.
+ *     a work group stays in one tile, so the branch is uniform
+ * motion_mask:      output of kernel_tnr_yuv_motion
+ * tiles_x:          tile count of each row
+ */
+
+__kernel void kernel_tnr_yuv_tiled(
+    __read_only image2d_t inputFrame, __read_only image2d_t inputFrame0,
+    __write_only image2d_t outputFrame, uint vertical_offset, float gain, float thr_y, float thr_uv,
+    __global const uchar *motion_mask, uint tiles_x)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    int tile = (2 * y / TNR_MOTION_TILE_SIZE) * tiles_x + (2 * x / TNR_MOTION_TILE_SIZE);
+    if (!motion_mask[tile]) {
+        tnr_yuv_pixels(inputFrame, inputFrame0, outputFrame, x, y, vertical_offset, gain, thr_y, thr_uv);
+        return;
+    }
+
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
+    write_imagef(outputFrame, (int2)(2 * x, 2 * y), read_imagef(inputFrame, sampler, (int2)(2 * x, 2 * y)));
+    write_imagef(outputFrame, (int2)(2 * x + 1, 2 * y), read_imagef(inputFrame, sampler, (int2)(2 * x + 1, 2 * y)));
+    write_imagef(outputFrame, (int2)(2 * x, 2 * y + 1), read_imagef(inputFrame, sampler, (int2)(2 * x, 2 * y + 1)));
+    write_imagef(outputFrame, (int2)(2 * x + 1, 2 * y + 1), read_imagef(inputFrame, sampler, (int2)(2 * x + 1, 2 * y + 1)));
+    write_imagef(outputFrame, (int2)(2 * x, y + vertical_offset), read_imagef(inputFrame, sampler, (int2)(2 * x, y + vertical_offset)));
+    write_imagef(outputFrame, (int2)(2 * x + 1, y + vertical_offset), read_imagef(inputFrame, sampler, (int2)(2 * x + 1, y + vertical_offset)));
+}
+
 /*
  * function: kernel_tnr_rgb
  *     Temporal Noise Reduction
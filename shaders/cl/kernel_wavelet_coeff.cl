@@ -13,6 +13,25 @@
 #define WAVELET_DENOISE_UV 0
 #endif
 
+#ifndef ENABLE_FP16
+#define ENABLE_FP16 0
+#endif
+
+#if ENABLE_FP16
+#pragma OPENCL EXTENSION cl_khr_fp16 : enable
+#define data_t half
+#define data4_t half4
+#define data16_t half16
+#define read_image_data read_imageh
+#define write_image_data write_imageh
+#else
+#define data_t float
+#define data4_t float4
+#define data16_t float16
+#define read_image_data read_image_data
+#define write_image_data write_image_data
+#endif
+
 #define WG_CELL_X_SIZE 8
 #define WG_CELL_Y_SIZE 8
 
@@ -44,11 +63,11 @@ __kernel void kernel_wavelet_coeff_variance (__read_only image2d_t input, __writ
 
     int local_index = local_id_y * WG_CELL_X_SIZE + local_id_x;
 
-    float offset = 0.5f;
-    float4 line_sum[5] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
-    float4 line_var = 0.0f;
+    data_t offset = 0.5f;
+    data4_t line_sum[5] = {(data4_t)0.0f, (data4_t)0.0f, (data4_t)0.0f, (data4_t)0.0f, (data4_t)0.0f};
+    data4_t line_var = (data4_t)0.0f;
 
-    __local float4 local_src_data[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE];
+    __local data4_t local_src_data[SLM_CELL_X_SIZE * SLM_CELL_Y_SIZE];
 
     int i = local_id_x + local_id_y * WG_CELL_X_SIZE;
     int start_x = mad24(group_id_x, WG_CELL_X_SIZE, -SLM_CELL_X_OFFSET);
@@ -58,15 +77,15 @@ __kernel void kernel_wavelet_coeff_variance (__read_only image2d_t input, __writ
     {
         int x = start_x + (j % SLM_CELL_X_SIZE);
         int y = start_y + (j / SLM_CELL_X_SIZE);
-        local_src_data[j] = read_imagef (input, sampler, (int2)(x, y)) - offset;
+        local_src_data[j] = read_image_data (input, sampler, (int2)(x, y)) - offset;
     }
     barrier(CLK_LOCAL_MEM_FENCE);
 
-    float16 line0 = *((__local float16 *)(local_src_data + local_id_y * SLM_CELL_X_SIZE + local_id_x));
-    float16 line1 = *((__local float16 *)(local_src_data + (local_id_y + 1) * SLM_CELL_X_SIZE + local_id_x));
-    float16 line2 = *((__local float16 *)(local_src_data + (local_id_y + 2) * SLM_CELL_X_SIZE + local_id_x));
-    float16 line3 = *((__local float16 *)(local_src_data + (local_id_y + 3) * SLM_CELL_X_SIZE + local_id_x));
-    float16 line4 = *((__local float16 *)(local_src_data + (local_id_y + 4) * SLM_CELL_X_SIZE + local_id_x));
+    data16_t line0 = *((__local data16_t *)(local_src_data + local_id_y * SLM_CELL_X_SIZE + local_id_x));
+    data16_t line1 = *((__local data16_t *)(local_src_data + (local_id_y + 1) * SLM_CELL_X_SIZE + local_id_x));
+    data16_t line2 = *((__local data16_t *)(local_src_data + (local_id_y + 2) * SLM_CELL_X_SIZE + local_id_x));
+    data16_t line3 = *((__local data16_t *)(local_src_data + (local_id_y + 3) * SLM_CELL_X_SIZE + local_id_x));
+    data16_t line4 = *((__local data16_t *)(local_src_data + (local_id_y + 4) * SLM_CELL_X_SIZE + local_id_x));
 
 #if WAVELET_DENOISE_Y
     line_sum[0] = mad(line0.s0123, line0.s0123, line_sum[0]);
@@ -119,7 +138,7 @@ __kernel void kernel_wavelet_coeff_variance (__read_only image2d_t input, __writ
     line_sum[4] = mad(line4.s789a, line4.s789a, line_sum[4]);
     line_sum[4] = mad(line4.s89ab, line4.s89ab, line_sum[4]);
 
-    line_var = (line_sum[0] + line_sum[1] + line_sum[2] + line_sum[3] + line_sum[4]) / 45;
+    line_var = (line_sum[0] + line_sum[1] + line_sum[2] + line_sum[3] + line_sum[4]) / (data_t)45;
 #endif
 
 #if WAVELET_DENOISE_UV
@@ -163,10 +182,10 @@ __kernel void kernel_wavelet_coeff_variance (__read_only image2d_t input, __writ
     line_sum[4] = mad(line4.sabcd, line4.sabcd, line_sum[4]);
     line_sum[4] = mad(line4.scdef, line4.scdef, line_sum[4]);
 
-    line_var = ((line_sum[0] + line_sum[1] + line_sum[2] + line_sum[3] + line_sum[4]) / 35);
+    line_var = ((line_sum[0] + line_sum[1] + line_sum[2] + line_sum[3] + line_sum[4]) / (data_t)35);
 #endif
 
-    write_imagef(output, (int2)(g_id_x, g_id_y), line_var);
+    write_image_data(output, (int2)(g_id_x, g_id_y), line_var);
 }
 
 /*
@@ -175,9 +194,20 @@ __kernel void kernel_wavelet_coeff_variance (__read_only image2d_t input, __writ
  * hl/lh/hh:  wavelet coefficients
  * layer:        wavelet decomposition layer
  * decomLevels:  wavelet decomposition levels
+ * always in float, scaled variance is out of half range
+ * WAVELET_NOISE_VAR_BUFFER: noise variances read from buffer written by kernel_wavelet_noise_variance
  */
 
-__kernel void kernel_wavelet_coeff_thresholding (float noise_var1, float noise_var2,
+#ifndef WAVELET_NOISE_VAR_BUFFER
+#define WAVELET_NOISE_VAR_BUFFER 0
+#endif
+
+__kernel void kernel_wavelet_coeff_thresholding (
+#if WAVELET_NOISE_VAR_BUFFER
+        __global const float *noise_var_buf,
+#else
+        float noise_var1, float noise_var2,
+#endif
         __read_only image2d_t in_hl, __read_only image2d_t var_hl, __write_only image2d_t out_hl,
         __read_only image2d_t in_lh, __read_only image2d_t var_lh, __write_only image2d_t out_lh,
         __read_only image2d_t in_hh, __read_only image2d_t var_hh, __write_only image2d_t out_hh,
@@ -208,6 +238,10 @@ __kernel void kernel_wavelet_coeff_thresholding (float noise_var1, float noise_v
     float4 thresh_lh;
     float4 thresh_hh;
 
+#if WAVELET_NOISE_VAR_BUFFER
+    float noise_var1 = noise_var_buf[0];
+    float noise_var2 = noise_var_buf[1];
+#endif
     float4 noise_var = (float4) (noise_var1, noise_var2, noise_var1, noise_var2);
 
     input_hl = read_imagef(in_hl, sampler, (int2)(x, y)) - 0.5f;
@@ -241,3 +275,97 @@ __kernel void kernel_wavelet_coeff_thresholding (float noise_var1, float noise_v
     write_imagef(out_hh, (int2)(x, y), output_hh + 0.5f);
 }
 
+
+/*
+ * function: kernel_wavelet_noise_hist
+ *     histograms of |coefficient| of finest HH band for MAD noise estimation,
+ *     Y counts all pixels in one histogram, UV counts U and V in two
+ * in_hh:          HH coefficients of layer 1, 8 bits centered at 127/128
+ * width, height:  valid texels
+ * hist:           WAVELET_NOISE_HIST_BINS bins each
+ */
+
+#define WAVELET_NOISE_HIST_BINS 128
+
+#if WAVELET_DENOISE_UV
+#define WAVELET_NOISE_HISTS 2
+#else
+#define WAVELET_NOISE_HISTS 1
+#endif
+
+__kernel void kernel_wavelet_noise_hist (
+    __read_only image2d_t in_hh, int width, int height, __global uint *hist)
+{
+    int x = get_global_id (0);
+    int y = get_global_id (1);
+    sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+    __local uint local_hist[WAVELET_NOISE_HIST_BINS * WAVELET_NOISE_HISTS];
+    int local_index = mad24 ((int)get_local_id (1), (int)get_local_size (0), (int)get_local_id (0));
+    int local_count = get_local_size (0) * get_local_size (1);
+    for (int i = local_index; i < WAVELET_NOISE_HIST_BINS * WAVELET_NOISE_HISTS; i += local_count)
+        local_hist[i] = 0;
+    barrier (CLK_LOCAL_MEM_FENCE);
+
+    if (x < width && y < height) {
+        int4 value = convert_int4 (mad (read_imagef (in_hh, sampler, (int2)(x, y)), 255.0f, 0.5f));
+        int4 base = select ((int4)(128), (int4)(127), value <= 127);
+        uint4 bin = min (abs (value - base), (uint4)(WAVELET_NOISE_HIST_BINS - 1));
+
+#if WAVELET_DENOISE_UV
+        // U and V interleaved
+        bin.yw += WAVELET_NOISE_HIST_BINS;
+#endif
+        atomic_inc (local_hist + bin.x);
+        atomic_inc (local_hist + bin.y);
+        atomic_inc (local_hist + bin.z);
+        atomic_inc (local_hist + bin.w);
+    }
+
+    barrier (CLK_LOCAL_MEM_FENCE);
+    for (int i = local_index; i < WAVELET_NOISE_HIST_BINS * WAVELET_NOISE_HISTS; i += local_count) {
+        uint count = local_hist[i];
+        if (count)
+            atomic_add (hist + i, count);
+    }
+}
+
+/*
+ * function: kernel_wavelet_noise_variance
+ *     noise variance from median of kernel_wavelet_noise_hist, sigma = MAD / 0.6745,
+ *     one work item per histogram, histogram is cleared for next frame
+ * weight:     scale of variance for thresholding
+ * noise_var:  2 variances read by kernel_wavelet_coeff_thresholding,
+ *             kept from last frame if nothing counted
+ */
+__kernel void kernel_wavelet_noise_variance (__global uint *hist, float weight, __global float *noise_var)
+{
+    int id = get_global_id (0);
+    __global uint *bins = hist + id * WAVELET_NOISE_HIST_BINS;
+
+    uint total = 0;
+    for (int i = 0; i < WAVELET_NOISE_HIST_BINS; i++)
+        total += bins[i];
+
+    uint sum = 0;
+    int median = 0;
+    for (int i = 0; i < WAVELET_NOISE_HIST_BINS; i++) {
+        sum += bins[i];
+        if (sum >= (total >> 1)) {
+            median = i;
+            break;
+        }
+    }
+
+    for (int i = 0; i < WAVELET_NOISE_HIST_BINS; i++)
+        bins[i] = 0;
+
+    if (!total)
+        return;
+
+    float sigma = median / 0.6745f;
+    noise_var[id] = sigma * sigma * weight;
+#if !WAVELET_DENOISE_UV
+    noise_var[1] = noise_var[0];
+#endif
+}
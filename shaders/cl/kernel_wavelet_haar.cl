@@ -18,6 +18,25 @@
 #define WAVELET_BAYES_SHRINK 1
 #endif
 
+#ifndef ENABLE_FP16
+#define ENABLE_FP16 0
+#endif
+
+#if ENABLE_FP16
+#pragma OPENCL EXTENSION cl_khr_fp16 : enable
+#define data_t half
+#define data4_t half4
+#define data8_t half8
+#define read_image_data read_imageh
+#define write_image_data write_imageh
+#else
+#define data_t float
+#define data4_t float4
+#define data8_t data8_t
+#define read_image_data read_image_data
+#define write_image_data write_image_data
+#endif
+
 __kernel void kernel_wavelet_haar_decomposition (
     __read_only image2d_t input,
     __write_only image2d_t ll, __write_only image2d_t hl,
@@ -29,49 +48,49 @@ __kernel void kernel_wavelet_haar_decomposition (
     int y = get_global_id (1);
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-    float8 line[2];
-    line[0].lo = read_imagef(input, sampler, (int2)(2 * x, 2 * y));
-    line[0].hi = read_imagef(input, sampler, (int2)(2 * x + 1, 2 * y));
-    line[1].lo = read_imagef(input, sampler, (int2)(2 * x, 2 * y + 1));
-    line[1].hi = read_imagef(input, sampler, (int2)(2 * x + 1, 2 * y + 1));
+    data8_t line[2];
+    line[0].lo = read_image_data(input, sampler, (int2)(2 * x, 2 * y));
+    line[0].hi = read_image_data(input, sampler, (int2)(2 * x + 1, 2 * y));
+    line[1].lo = read_image_data(input, sampler, (int2)(2 * x, 2 * y + 1));
+    line[1].hi = read_image_data(input, sampler, (int2)(2 * x + 1, 2 * y + 1));
 
     // row transform
-    float8 row_l;
-    float8 row_h;
-    row_l = (float8)(line[0].lo + line[1].lo, line[0].hi + line[1].hi) / 2.0f;
-    row_h = (float8)(line[0].lo - line[1].lo, line[0].hi - line[1].hi) / 2.0f;
+    data8_t row_l;
+    data8_t row_h;
+    row_l = (data8_t)(line[0].lo + line[1].lo, line[0].hi + line[1].hi) / (data_t)2.0f;
+    row_h = (data8_t)(line[0].lo - line[1].lo, line[0].hi - line[1].hi) / (data_t)2.0f;
 
-    float4 line_ll;
-    float4 line_hl;
-    float4 line_lh;
-    float4 line_hh;
+    data4_t line_ll;
+    data4_t line_hl;
+    data4_t line_lh;
+    data4_t line_hh;
 
 #if WAVELET_DENOISE_Y
     // column transform
-    line_ll = (row_l.odd + row_l.even) / 2.0f;
-    line_hl = (row_l.odd - row_l.even) / 2.0f;
-    line_lh = (row_h.odd + row_h.even) / 2.0f;
-    line_hh = (row_h.odd - row_h.even) / 2.0f;
+    line_ll = (row_l.odd + row_l.even) / (data_t)2.0f;
+    line_hl = (row_l.odd - row_l.even) / (data_t)2.0f;
+    line_lh = (row_h.odd + row_h.even) / (data_t)2.0f;
+    line_hh = (row_h.odd - row_h.even) / (data_t)2.0f;
 #endif
 
 #if WAVELET_DENOISE_UV
     // U column transform
-    line_ll.odd = (row_l.odd.odd + row_l.odd.even) / 2.0f;
-    line_hl.odd = (row_l.odd.odd - row_l.odd.even) / 2.0f;
-    line_lh.odd = (row_h.odd.odd + row_h.odd.even) / 2.0f;
-    line_hh.odd = (row_h.odd.odd - row_h.odd.even) / 2.0f;
+    line_ll.odd = (row_l.odd.odd + row_l.odd.even) / (data_t)2.0f;
+    line_hl.odd = (row_l.odd.odd - row_l.odd.even) / (data_t)2.0f;
+    line_lh.odd = (row_h.odd.odd + row_h.odd.even) / (data_t)2.0f;
+    line_hh.odd = (row_h.odd.odd - row_h.odd.even) / (data_t)2.0f;
 
     // V column transform
-    line_ll.even = (row_l.even.odd + row_l.even.even) / 2.0f;
-    line_hl.even = (row_l.even.odd - row_l.even.even) / 2.0f;
-    line_lh.even = (row_h.even.odd + row_h.even.even) / 2.0f;
-    line_hh.even = (row_h.even.odd - row_h.even.even) / 2.0f;
+    line_ll.even = (row_l.even.odd + row_l.even.even) / (data_t)2.0f;
+    line_hl.even = (row_l.even.odd - row_l.even.even) / (data_t)2.0f;
+    line_lh.even = (row_h.even.odd + row_h.even.even) / (data_t)2.0f;
+    line_hh.even = (row_h.even.odd - row_h.even.even) / (data_t)2.0f;
 #endif
 
-    write_imagef(ll, (int2)(x, y), line_ll);
-    write_imagef(hl, (int2)(x, y), line_hl + 0.5f);
-    write_imagef(lh, (int2)(x, y), line_lh + 0.5f);
-    write_imagef(hh, (int2)(x, y), line_hh + 0.5f);
+    write_image_data(ll, (int2)(x, y), line_ll);
+    write_image_data(hl, (int2)(x, y), line_hl + (data_t)0.5f);
+    write_image_data(lh, (int2)(x, y), line_lh + (data_t)0.5f);
+    write_image_data(hh, (int2)(x, y), line_hh + (data_t)0.5f);
 }
 
 /*
@@ -98,17 +117,18 @@ __kernel void kernel_wavelet_haar_reconstruction (
     int y = get_global_id (1);
     sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-    float thresh = 0.0f;
+    data_t thresh = 0.0f;
+    data_t soft_thresh = softThresh;
 
-    float4 line_ll;
-    float4 line_hl;
-    float4 line_lh;
-    float4 line_hh;
+    data4_t line_ll;
+    data4_t line_hl;
+    data4_t line_lh;
+    data4_t line_hh;
 
-    line_ll = read_imagef(ll, sampler, (int2)(x, y));
-    line_hl = read_imagef(hl, sampler, (int2)(x, y)) - 0.5f;
-    line_lh = read_imagef(lh, sampler, (int2)(x, y)) - 0.5f;
-    line_hh = read_imagef(hh, sampler, (int2)(x, y)) - 0.5f;
+    line_ll = read_image_data(ll, sampler, (int2)(x, y));
+    line_hl = read_image_data(hl, sampler, (int2)(x, y)) - (data_t)0.5f;
+    line_lh = read_image_data(lh, sampler, (int2)(x, y)) - (data_t)0.5f;
+    line_hh = read_image_data(hh, sampler, (int2)(x, y)) - (data_t)0.5f;
 
 #if WAVELET_DENOISE_Y
     thresh = hardThresh * y_threshConst[layer - 1];
@@ -120,47 +140,47 @@ __kernel void kernel_wavelet_haar_reconstruction (
 
 #if !WAVELET_BAYES_SHRINK
     // thresholding
-    line_hl = (line_hl < -thresh) ? line_hl + (thresh - thresh * softThresh) : line_hl;
-    line_hl = (line_hl > thresh) ? line_hl - (thresh - thresh * softThresh) : line_hl;
-    line_hl = (line_hl > -thresh && line_hl < thresh) ? line_hl * softThresh : line_hl;
+    line_hl = (line_hl < -thresh) ? line_hl + (thresh - thresh * soft_thresh) : line_hl;
+    line_hl = (line_hl > thresh) ? line_hl - (thresh - thresh * soft_thresh) : line_hl;
+    line_hl = (line_hl > -thresh && line_hl < thresh) ? line_hl * soft_thresh : line_hl;
 
-    line_lh = (line_lh < -thresh) ? line_lh + (thresh - thresh * softThresh) : line_lh;
-    line_lh = (line_lh > thresh) ? line_lh - (thresh - thresh * softThresh) : line_lh;
-    line_lh = (line_lh > -thresh && line_lh < thresh) ? line_lh * softThresh : line_lh;
+    line_lh = (line_lh < -thresh) ? line_lh + (thresh - thresh * soft_thresh) : line_lh;
+    line_lh = (line_lh > thresh) ? line_lh - (thresh - thresh * soft_thresh) : line_lh;
+    line_lh = (line_lh > -thresh && line_lh < thresh) ? line_lh * soft_thresh : line_lh;
 
-    line_hh = (line_hh < -thresh) ? line_hh + (thresh - thresh * softThresh) : line_hh;
-    line_hh = (line_hh > thresh) ? line_hh - (thresh - thresh * softThresh) : line_hh;
-    line_hh = (line_hh > -thresh && line_hh < thresh) ? line_hh * softThresh : line_hh;
+    line_hh = (line_hh < -thresh) ? line_hh + (thresh - thresh * soft_thresh) : line_hh;
+    line_hh = (line_hh > thresh) ? line_hh - (thresh - thresh * soft_thresh) : line_hh;
+    line_hh = (line_hh > -thresh && line_hh < thresh) ? line_hh * soft_thresh : line_hh;
 #endif
 
 #if WAVELET_DENOISE_Y
     // row reconstruction
-    float8 row_l;
-    float8 row_h;
-    row_l = (float8)(line_ll + line_lh, line_hl + line_hh);
-    row_h = (float8)(line_ll - line_lh, line_hl - line_hh);
+    data8_t row_l;
+    data8_t row_h;
+    row_l = (data8_t)(line_ll + line_lh, line_hl + line_hh);
+    row_h = (data8_t)(line_ll - line_lh, line_hl - line_hh);
 
     // column reconstruction
-    float8 line[2];
+    data8_t line[2];
     line[0].odd = row_l.lo + row_l.hi;
     line[0].even = row_l.lo - row_l.hi;
     line[1].odd = row_h.lo + row_h.hi;
     line[1].even = row_h.lo - row_h.hi;
 
-    write_imagef(output, (int2)(2 * x, 2 * y), line[0].lo);
-    write_imagef(output, (int2)(2 * x + 1, 2 * y), line[0].hi);
-    write_imagef(output, (int2)(2 * x, 2 * y + 1), line[1].lo);
-    write_imagef(output, (int2)(2 * x + 1, 2 * y + 1), line[1].hi);
+    write_image_data(output, (int2)(2 * x, 2 * y), line[0].lo);
+    write_image_data(output, (int2)(2 * x + 1, 2 * y), line[0].hi);
+    write_image_data(output, (int2)(2 * x, 2 * y + 1), line[1].lo);
+    write_image_data(output, (int2)(2 * x + 1, 2 * y + 1), line[1].hi);
 #endif
 
 #if WAVELET_DENOISE_UV
     // row reconstruction
-    float8 row_l;
-    float8 row_h;
-    row_l = (float8)(line_ll + line_lh, line_hl + line_hh);
-    row_h = (float8)(line_ll - line_lh, line_hl - line_hh);
+    data8_t row_l;
+    data8_t row_h;
+    row_l = (data8_t)(line_ll + line_lh, line_hl + line_hh);
+    row_h = (data8_t)(line_ll - line_lh, line_hl - line_hh);
 
-    float8 line[2];
+    data8_t line[2];
 
     // U column reconstruction
     line[0].odd.odd = row_l.lo.odd + row_l.hi.odd;
@@ -174,9 +194,180 @@ __kernel void kernel_wavelet_haar_reconstruction (
     line[1].even.odd = row_h.lo.even + row_h.hi.even;
     line[1].even.even = row_h.lo.even - row_h.hi.even;
 
-    write_imagef(output, (int2)(2 * x, 2 * y), line[0].lo);
-    write_imagef(output, (int2)(2 * x + 1, 2 * y), line[0].hi);
-    write_imagef(output, (int2)(2 * x, 2 * y + 1), line[1].lo);
-    write_imagef(output, (int2)(2 * x + 1, 2 * y + 1), line[1].hi);
+    write_image_data(output, (int2)(2 * x, 2 * y), line[0].lo);
+    write_image_data(output, (int2)(2 * x + 1, 2 * y), line[0].hi);
+    write_image_data(output, (int2)(2 * x, 2 * y + 1), line[1].lo);
+    write_image_data(output, (int2)(2 * x + 1, 2 * y + 1), line[1].hi);
 #endif
 }
+
+/*
+ * integer lifting haar transform, coefficients stay in place in one short buffer.
+ * level l works on 2x2 blocks of elements 2^(l-1) apart, ll stays at the block origin,
+ * hl/lh/hh go to the right, lower and lower right element.
+ * plane 0 is Y, plane 1/2 are U/V interleaved in the uv plane.
+ * buffers, offsets and pitches are in elements, uchar for image and short for coefficients.
+ */
+
+inline int lifting_index (int plane, int x, int y, int y_offset, int uv_offset, int pitch)
+{
+    return (plane == 0) ? (y_offset + y * pitch + x) : (uv_offset + y * pitch + 2 * x + plane - 1);
+}
+
+/*
+ * function: kernel_wavelet_haar_lifting_forward
+ * input:        NV12 image buffer, read on level 1 only
+ * coeff:        coefficient buffer, same layout as input
+ * width/height: Y plane size
+ * plane_begin/plane_end: processed planes, 0 for Y, 1 and 2 for UV
+ */
+__kernel void kernel_wavelet_haar_lifting_forward (
+    __global const uchar *input, int in_y_offset, int in_uv_offset, int in_pitch,
+    __global short *coeff, int coeff_uv_offset, int coeff_pitch,
+    int width, int height, int level, int plane_begin, int plane_end)
+{
+    int bx = get_global_id (0);
+    int by = get_global_id (1);
+    int plane = plane_begin + get_global_id (2);
+    if (plane > plane_end)
+        return;
+
+    int plane_width = plane ? (width / 2) : width;
+    int plane_height = plane ? (height / 2) : height;
+    int step = 1 << (level - 1);
+    int x0 = bx * step * 2;
+    int y0 = by * step * 2;
+    if (x0 >= plane_width || y0 >= plane_height)
+        return;
+
+    // residual elements are kept as they are
+    if (x0 + step >= plane_width || y0 + step >= plane_height) {
+        if (level > 1)
+            return;
+        for (int y = y0; y < min (y0 + 2, plane_height); ++y)
+            for (int x = x0; x < min (x0 + 2, plane_width); ++x)
+                coeff[lifting_index (plane, x, y, 0, coeff_uv_offset, coeff_pitch)] =
+                    input[lifting_index (plane, x, y, in_y_offset, in_uv_offset, in_pitch)];
+        return;
+    }
+
+    int i00 = lifting_index (plane, x0, y0, 0, coeff_uv_offset, coeff_pitch);
+    int i01 = lifting_index (plane, x0 + step, y0, 0, coeff_uv_offset, coeff_pitch);
+    int i10 = lifting_index (plane, x0, y0 + step, 0, coeff_uv_offset, coeff_pitch);
+    int i11 = lifting_index (plane, x0 + step, y0 + step, 0, coeff_uv_offset, coeff_pitch);
+
+    int p00, p01, p10, p11;
+    if (level == 1) {
+        p00 = input[lifting_index (plane, x0, y0, in_y_offset, in_uv_offset, in_pitch)];
+        p01 = input[lifting_index (plane, x0 + 1, y0, in_y_offset, in_uv_offset, in_pitch)];
+        p10 = input[lifting_index (plane, x0, y0 + 1, in_y_offset, in_uv_offset, in_pitch)];
+        p11 = input[lifting_index (plane, x0 + 1, y0 + 1, in_y_offset, in_uv_offset, in_pitch)];
+    } else {
+        p00 = coeff[i00];
+        p01 = coeff[i01];
+        p10 = coeff[i10];
+        p11 = coeff[i11];
+    }
+
+    // row lifting
+    int d0 = p00 - p01;
+    int s0 = p01 + (d0 >> 1);
+    int d1 = p10 - p11;
+    int s1 = p11 + (d1 >> 1);
+
+    // column lifting
+    int lh = s0 - s1;
+    int ll = s1 + (lh >> 1);
+    int hh = d0 - d1;
+    int hl = d1 + (hh >> 1);
+
+    coeff[i00] = (short)ll;
+    coeff[i01] = (short)hl;
+    coeff[i10] = (short)lh;
+    coeff[i11] = (short)hh;
+}
+
+inline int lifting_shrink (int coeff, float thresh, float soft_thresh)
+{
+    float value = (float)coeff;
+    if (value > thresh)
+        value -= thresh - thresh * soft_thresh;
+    else if (value < -thresh)
+        value += thresh - thresh * soft_thresh;
+    else
+        value *= soft_thresh;
+    return convert_int_rte (value);
+}
+
+/*
+ * function: kernel_wavelet_haar_lifting_inverse
+ *     thresholds detail coefficients of one level and reconstructs it,
+ *     level 1 writes pixels to output, other levels write back in place.
+ * hardThresh/softThresh: same meaning as kernel_wavelet_haar_reconstruction
+ */
+__kernel void kernel_wavelet_haar_lifting_inverse (
+    __global uchar *output, int out_y_offset, int out_uv_offset, int out_pitch,
+    __global short *coeff, int coeff_uv_offset, int coeff_pitch,
+    int width, int height, int level, int plane_begin, int plane_end,
+    float hardThresh, float softThresh)
+{
+    int bx = get_global_id (0);
+    int by = get_global_id (1);
+    int plane = plane_begin + get_global_id (2);
+    if (plane > plane_end)
+        return;
+
+    int plane_width = plane ? (width / 2) : width;
+    int plane_height = plane ? (height / 2) : height;
+    int step = 1 << (level - 1);
+    int x0 = bx * step * 2;
+    int y0 = by * step * 2;
+    if (x0 >= plane_width || y0 >= plane_height)
+        return;
+
+    if (x0 + step >= plane_width || y0 + step >= plane_height) {
+        if (level > 1)
+            return;
+        for (int y = y0; y < min (y0 + 2, plane_height); ++y)
+            for (int x = x0; x < min (x0 + 2, plane_width); ++x)
+                output[lifting_index (plane, x, y, out_y_offset, out_uv_offset, out_pitch)] =
+                    convert_uchar_sat (coeff[lifting_index (plane, x, y, 0, coeff_uv_offset, coeff_pitch)]);
+        return;
+    }
+
+    int i00 = lifting_index (plane, x0, y0, 0, coeff_uv_offset, coeff_pitch);
+    int i01 = lifting_index (plane, x0 + step, y0, 0, coeff_uv_offset, coeff_pitch);
+    int i10 = lifting_index (plane, x0, y0 + step, 0, coeff_uv_offset, coeff_pitch);
+    int i11 = lifting_index (plane, x0 + step, y0 + step, 0, coeff_uv_offset, coeff_pitch);
+
+    // thresholds of normalized float coefficients scaled to lifting coefficients
+    float thresh = hardThresh * (plane ? uv_threshConst[level - 1] : y_threshConst[level - 1]) * 255.0f;
+    int ll = coeff[i00];
+    int hl = lifting_shrink (coeff[i01], thresh * 2.0f, softThresh);
+    int lh = lifting_shrink (coeff[i10], thresh * 2.0f, softThresh);
+    int hh = lifting_shrink (coeff[i11], thresh * 4.0f, softThresh);
+
+    // column inverse
+    int s1 = ll - (lh >> 1);
+    int s0 = lh + s1;
+    int d1 = hl - (hh >> 1);
+    int d0 = hh + d1;
+
+    // row inverse
+    int p01 = s0 - (d0 >> 1);
+    int p00 = d0 + p01;
+    int p11 = s1 - (d1 >> 1);
+    int p10 = d1 + p11;
+
+    if (level == 1) {
+        output[lifting_index (plane, x0, y0, out_y_offset, out_uv_offset, out_pitch)] = convert_uchar_sat (p00);
+        output[lifting_index (plane, x0 + 1, y0, out_y_offset, out_uv_offset, out_pitch)] = convert_uchar_sat (p01);
+        output[lifting_index (plane, x0, y0 + 1, out_y_offset, out_uv_offset, out_pitch)] = convert_uchar_sat (p10);
+        output[lifting_index (plane, x0 + 1, y0 + 1, out_y_offset, out_uv_offset, out_pitch)] = convert_uchar_sat (p11);
+    } else {
+        coeff[i00] = (short)p00;
+        coeff[i01] = (short)p01;
+        coeff[i10] = (short)p10;
+        coeff[i11] = (short)p11;
+    }
+}
@@ -0,0 +1,937 @@
+/*
+ * bench-handlers.cpp - benchmark geo-mapper, blender and stitcher handlers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "test_common.h"
+#include <interface/geo_mapper.h>
+#include <interface/blender.h>
+#include <interface/stitcher.h>
+#include <calibration_parser.h>
+#include <image_file_handle.h>
+#include <xcam_trace.h>
+#include <soft/soft_video_buf_allocator.h>
+#if HAVE_GLES
+#include <gles/gl_video_buffer.h>
+#include <gles/egl/egl_base.h>
+#endif
+#if HAVE_VULKAN
+#include <vulkan/vk_device.h>
+#include <vulkan/vk_geomap_handler.h>
+#endif
+#include <sys/resource.h>
+#include <sched.h>
+#include <inttypes.h>
+#include <algorithm>
+#include <map>
+#include <string>
+
+#define BENCH_LUT_STEP 8
+#define BENCH_CAMERA_NUM 4
+#define BENCH_MAX_INPUTS BENCH_CAMERA_NUM
+#define BENCH_MAX_CPU_SWEEP 8
+#define BENCH_DEFAULT_TOLERANCE 10.0
+
+using namespace XCam;
+
+enum BenchModule {
+    BenchModuleSoft    = 0,
+    BenchModuleGLES,
+    BenchModuleVulkan,
+    BenchModuleCount
+};
+
+enum BenchType {
+    BenchTypeRemap     = 0,
+    BenchTypeBlend,
+    BenchTypeStitch,
+    BenchTypeCount
+};
+
+struct BenchResolution {
+    const char   *name;
+    uint32_t      width;
+    uint32_t      height;
+};
+
+static const char *module_names[BenchModuleCount] = {"soft", "gles", "vulkan"};
+// modules of this build, picked by --module all
+static const bool module_built[BenchModuleCount] = {true, HAVE_GLES, HAVE_VULKAN};
+static const char *type_names[BenchTypeCount] = {"remap", "blend", "stitch"};
+static const BenchResolution resolutions[] = {
+    {"1080p", 1920, 1080},
+    {"4k", 3840, 2160},
+    {"8k", 7680, 4320},
+};
+#define BENCH_RES_NUM (sizeof (resolutions) / sizeof (resolutions[0]))
+
+struct BenchConfig {
+    const char   *input_file;
+    const char   *calib_path;
+    uint32_t      cam_width;
+    uint32_t      cam_height;
+    uint32_t      loop;
+    uint32_t      warmup;
+    uint32_t      cpus;
+
+    BenchConfig ()
+        : input_file (NULL)
+        , calib_path (NULL)
+        , cam_width (1280)
+        , cam_height (800)
+        , loop (20)
+        , warmup (2)
+        , cpus (0)
+    {}
+};
+
+struct BenchResult {
+    BenchModule   module;
+    BenchType     type;
+    const char   *res_name;
+    uint32_t      cpus;
+    uint32_t      in_width;
+    uint32_t      in_height;
+    uint32_t      out_width;
+    uint32_t      out_height;
+    uint32_t      frames;
+    double        p50_ms;
+    double        p99_ms;
+    double        fps;
+    uint64_t      bytes_per_frame;
+    double        cpu_percent;
+};
+
+class BenchCase {
+public:
+    BenchCase (BenchModule module, BenchType type)
+        : _module (module)
+        , _type (type)
+        , _in_num (0)
+    {}
+    virtual ~BenchCase () {}
+
+    virtual XCamReturn process () = 0;
+
+    XCamReturn prepare_buffers (
+        const BenchConfig &config, uint32_t in_num,
+        uint32_t in_width, uint32_t in_height, uint32_t out_width, uint32_t out_height);
+
+    uint64_t get_bytes_per_frame () const;
+    void set_timestamp (int64_t ts) {
+        for (uint32_t i = 0; i < _in_num; ++i)
+            _in_bufs[i]->set_timestamp (ts);
+    }
+    BenchModule get_module () const {
+        return _module;
+    }
+    BenchType get_type () const {
+        return _type;
+    }
+
+protected:
+    BenchModule                 _module;
+    BenchType                   _type;
+    SmartPtr<VideoBuffer>       _in_bufs[BENCH_MAX_INPUTS];
+    uint32_t                    _in_num;
+    SmartPtr<VideoBuffer>       _out_buf;
+
+private:
+    SmartPtr<BufferPool>        _in_pool;
+    SmartPtr<BufferPool>        _out_pool;
+};
+
+static SmartPtr<BufferPool>
+create_buf_pool (BenchModule module, const VideoBufferInfo &info, uint32_t count)
+{
+    SmartPtr<BufferPool> pool;
+    if (module == BenchModuleSoft) {
+        pool = new SoftVideoBufAllocator (info);
+    } else if (module == BenchModuleGLES) {
+#if HAVE_GLES
+        pool = new GLVideoBufferPool (info);
+#endif
+    } else if (module == BenchModuleVulkan) {
+#if HAVE_VULKAN
+        pool = create_vk_buffer_pool (VKDevice::default_device ());
+        if (pool.ptr ())
+            pool->set_video_info (info);
+#endif
+    }
+    XCAM_FAIL_RETURN (ERROR, pool.ptr (), NULL, "module(%s) has no buffer pool", module_names[module]);
+
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (pool->reserve (count)), NULL, "reserve buffer pool failed");
+    return pool;
+}
+
+// diagonal gradients, different for each input so blending is not a plain copy
+static XCamReturn
+fill_synthetic_buf (const SmartPtr<VideoBuffer> &buf, uint32_t idx)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    uint8_t *mem = buf->map ();
+    XCAM_FAIL_RETURN (ERROR, mem, XCAM_RETURN_ERROR_MEM, "map buffer failed");
+
+    for (uint32_t y = 0; y < info.height; ++y) {
+        uint8_t *luma = mem + info.offsets[0] + y * info.strides[0];
+        for (uint32_t x = 0; x < info.width; ++x)
+            luma[x] = (uint8_t)(x + y + idx * 64);
+    }
+    for (uint32_t y = 0; y < info.height / 2; ++y) {
+        uint8_t *uv = mem + info.offsets[1] + y * info.strides[1];
+        for (uint32_t x = 0; x < info.width / 2; ++x) {
+            uv[x * 2] = (uint8_t)(128 + x - y);
+            uv[x * 2 + 1] = (uint8_t)(128 + idx * 32);
+        }
+    }
+    buf->unmap ();
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+BenchCase::prepare_buffers (
+    const BenchConfig &config, uint32_t in_num,
+    uint32_t in_width, uint32_t in_height, uint32_t out_width, uint32_t out_height)
+{
+    XCAM_ASSERT (in_num <= BENCH_MAX_INPUTS);
+
+    VideoBufferInfo in_info, out_info;
+    in_info.init (V4L2_PIX_FMT_NV12, in_width, in_height);
+    out_info.init (V4L2_PIX_FMT_NV12, out_width, out_height);
+
+    _in_pool = create_buf_pool (_module, in_info, in_num);
+    _out_pool = create_buf_pool (_module, out_info, 1);
+    XCAM_FAIL_RETURN (ERROR, _in_pool.ptr () && _out_pool.ptr (), XCAM_RETURN_ERROR_MEM, "create buffer pools failed");
+
+    ImageFileHandle file;
+    if (config.input_file) {
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (file.open (config.input_file, "rb")), XCAM_RETURN_ERROR_FILE,
+            "open input file(%s) failed", config.input_file);
+    }
+
+    _in_num = in_num;
+    for (uint32_t i = 0; i < in_num; ++i) {
+        _in_bufs[i] = _in_pool->get_buffer (_in_pool);
+        XCAM_ASSERT (_in_bufs[i].ptr ());
+
+        if (config.input_file) {
+            file.rewind ();
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (file.read_buf (_in_bufs[i])), XCAM_RETURN_ERROR_FILE,
+                "read %dx%d frame from file(%s) failed", in_width, in_height, config.input_file);
+        } else {
+            XCAM_FAIL_RETURN (
+                ERROR, xcam_ret_is_ok (fill_synthetic_buf (_in_bufs[i], i)), XCAM_RETURN_ERROR_MEM,
+                "fill synthetic buffer failed");
+        }
+    }
+
+    _out_buf = _out_pool->get_buffer (_out_pool);
+    XCAM_ASSERT (_out_buf.ptr ());
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+uint64_t
+BenchCase::get_bytes_per_frame () const
+{
+    uint64_t bytes = _out_buf->get_video_info ().size;
+    for (uint32_t i = 0; i < _in_num; ++i)
+        bytes += _in_bufs[i]->get_video_info ().size;
+
+    return bytes;
+}
+
+class RemapCase
+    : public BenchCase
+{
+public:
+    explicit RemapCase (BenchModule module)
+        : BenchCase (module, BenchTypeRemap)
+    {}
+
+    XCamReturn init (uint32_t width, uint32_t height);
+    virtual XCamReturn process () {
+        return _mapper->remap (_in_bufs[0], _out_buf);
+    }
+
+private:
+    SmartPtr<GeoMapper>     _mapper;
+};
+
+XCamReturn
+RemapCase::init (uint32_t width, uint32_t height)
+{
+    if (_module == BenchModuleSoft)
+        _mapper = GeoMapper::create_soft_geo_mapper ();
+#if HAVE_GLES
+    else if (_module == BenchModuleGLES)
+        _mapper = GeoMapper::create_gl_geo_mapper ();
+#endif
+#if HAVE_VULKAN
+    else if (_module == BenchModuleVulkan)
+        _mapper = new VKGeoMapHandler (VKDevice::default_device ());
+#endif
+    XCAM_FAIL_RETURN (ERROR, _mapper.ptr (), XCAM_RETURN_ERROR_PARAM, "create geo mapper failed");
+
+    // horizontal flip, every output pixel is interpolated from the lookup table
+    uint32_t lut_width = XCAM_ALIGN_UP (width, BENCH_LUT_STEP) / BENCH_LUT_STEP;
+    uint32_t lut_height = XCAM_ALIGN_UP (height, BENCH_LUT_STEP) / BENCH_LUT_STEP;
+    std::vector<PointFloat2> lut (lut_width * lut_height);
+    for (uint32_t i = 0; i < lut_height; ++i) {
+        for (uint32_t j = 0; j < lut_width; ++j) {
+            lut[i * lut_width + j].x = (lut_width - j) * BENCH_LUT_STEP;
+            lut[i * lut_width + j].y = i * BENCH_LUT_STEP;
+        }
+    }
+
+    _mapper->set_output_size (width, height);
+    XCAM_FAIL_RETURN (
+        ERROR, _mapper->set_lookup_table (lut.data (), lut_width, lut_height), XCAM_RETURN_ERROR_PARAM,
+        "set lookup table failed");
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+class BlendCase
+    : public BenchCase
+{
+public:
+    explicit BlendCase (BenchModule module)
+        : BenchCase (module, BenchTypeBlend)
+    {}
+
+    XCamReturn init (uint32_t width, uint32_t height);
+    virtual XCamReturn process () {
+        return _blender->blend (_in_bufs[0], _in_bufs[1], _out_buf);
+    }
+
+private:
+    SmartPtr<Blender>       _blender;
+};
+
+XCamReturn
+BlendCase::init (uint32_t width, uint32_t height)
+{
+    if (_module == BenchModuleSoft)
+        _blender = Blender::create_soft_blender ();
+#if HAVE_GLES
+    else if (_module == BenchModuleGLES)
+        _blender = Blender::create_gl_blender ();
+#endif
+#if HAVE_VULKAN
+    else if (_module == BenchModuleVulkan)
+        _blender = Blender::create_vk_blender ();
+#endif
+    XCAM_FAIL_RETURN (ERROR, _blender.ptr (), XCAM_RETURN_ERROR_PARAM, "create blender failed");
+
+    // whole frames overlap, the worst case of a stitching seam
+    Rect area (0, 0, width, height);
+    _blender->set_output_size (width, height);
+    _blender->set_merge_window (area);
+    _blender->set_input_merge_area (area, 0);
+    _blender->set_input_merge_area (area, 1);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+class StitchCase
+    : public BenchCase
+{
+public:
+    explicit StitchCase (BenchModule module)
+        : BenchCase (module, BenchTypeStitch)
+    {}
+
+    XCamReturn init (const char *calib_path, uint32_t width, uint32_t height);
+    virtual XCamReturn process () {
+        if (_in_list.empty ())
+            _in_list.assign (_in_bufs, _in_bufs + _in_num);
+        return _stitcher->stitch_buffers (_in_list, _out_buf);
+    }
+
+private:
+    SmartPtr<Stitcher>      _stitcher;
+    VideoBufferList         _in_list;
+};
+
+static XCamReturn
+parse_camera_info (const char *path, uint32_t idx, CameraInfo &info)
+{
+    static const char *instrinsic_names[] = {
+        "intrinsic_camera_front.txt", "intrinsic_camera_right.txt",
+        "intrinsic_camera_rear.txt", "intrinsic_camera_left.txt"
+    };
+    static const char *exstrinsic_names[] = {
+        "extrinsic_camera_front.txt", "extrinsic_camera_right.txt",
+        "extrinsic_camera_rear.txt", "extrinsic_camera_left.txt"
+    };
+    static const float viewpoints_range[] = {64.0f, 160.0f, 64.0f, 160.0f};
+
+    std::string intrinsic_path = std::string (path) + "/" + instrinsic_names[idx];
+    std::string extrinsic_path = std::string (path) + "/" + exstrinsic_names[idx];
+
+    CalibrationParser parser;
+    XCamReturn ret = parser.parse_intrinsic_file (intrinsic_path.c_str (), info.calibration.intrinsic);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "parse intrinsic params(%s) failed", intrinsic_path.c_str ());
+    ret = parser.parse_extrinsic_file (extrinsic_path.c_str (), info.calibration.extrinsic);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "parse extrinsic params(%s) failed", extrinsic_path.c_str ());
+    info.calibration.extrinsic.trans_x += TEST_CAMERA_POSITION_OFFSET_X;
+
+    info.angle_range = viewpoints_range[idx];
+    info.round_angle_start = (idx * 360.0f / BENCH_CAMERA_NUM) - info.angle_range / 2.0f;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StitchCase::init (const char *calib_path, uint32_t width, uint32_t height)
+{
+    if (_module == BenchModuleSoft)
+        _stitcher = Stitcher::create_soft_stitcher ();
+#if HAVE_GLES
+    else if (_module == BenchModuleGLES)
+        _stitcher = Stitcher::create_gl_stitcher ();
+#endif
+#if HAVE_VULKAN
+    else if (_module == BenchModuleVulkan)
+        _stitcher = Stitcher::create_vk_stitcher ();
+#endif
+    XCAM_FAIL_RETURN (ERROR, _stitcher.ptr (), XCAM_RETURN_ERROR_PARAM, "create stitcher failed");
+
+    CameraInfo cam_info[BENCH_CAMERA_NUM];
+    for (uint32_t i = 0; i < BENCH_CAMERA_NUM; ++i) {
+        XCamReturn ret = parse_camera_info (calib_path, i, cam_info[i]);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "parse camera info(idx:%d) failed", i);
+    }
+
+    PointFloat3 bowl_coord_offset;
+    centralize_bowl_coord_from_cameras (
+        cam_info[0].calibration.extrinsic, cam_info[1].calibration.extrinsic,
+        cam_info[2].calibration.extrinsic, cam_info[3].calibration.extrinsic,
+        bowl_coord_offset);
+
+    _stitcher->set_camera_num (BENCH_CAMERA_NUM);
+    for (uint32_t i = 0; i < BENCH_CAMERA_NUM; ++i)
+        _stitcher->set_camera_info (i, cam_info[i]);
+
+    BowlDataConfig bowl;
+    bowl.wall_height = 3000.0f;
+    bowl.ground_length = 2000.0f;
+    bowl.angle_start = 0.0f;
+    bowl.angle_end = 360.0f;
+    _stitcher->set_bowl_config (bowl);
+    _stitcher->set_output_size (width, height);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static int64_t
+get_time_usec ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+static int64_t
+get_cpu_time_usec ()
+{
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return XCAM_TIMEVAL_2_USEC (usage.ru_utime) + XCAM_TIMEVAL_2_USEC (usage.ru_stime);
+}
+
+static double
+get_percentile_ms (const std::vector<int64_t> &sorted_usec, uint32_t percent)
+{
+    XCAM_ASSERT (!sorted_usec.empty ());
+    size_t idx = (sorted_usec.size () * percent + 99) / 100;
+    idx = XCAM_CLAMP (idx, 1, sorted_usec.size ()) - 1;
+    return sorted_usec[idx] / 1000.0;
+}
+
+static XCamReturn
+run_case (BenchCase &bench, const BenchConfig &config, BenchResult &result)
+{
+    for (uint32_t i = 0; i < config.warmup; ++i) {
+        XCamReturn ret = bench.process ();
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "warmup frame(%d) failed", i);
+    }
+
+    std::vector<int64_t> latency (config.loop);
+    int64_t cpu_start = get_cpu_time_usec ();
+    int64_t wall_start = get_time_usec ();
+    for (uint32_t i = 0; i < config.loop; ++i) {
+        int64_t start = get_time_usec ();
+        bench.set_timestamp (start);
+        XCamReturn ret = bench.process ();
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "process frame(%d) failed", i);
+        latency[i] = get_time_usec () - start;
+    }
+    int64_t wall_time = XCAM_MAX (get_time_usec () - wall_start, 1);
+    int64_t cpu_time = get_cpu_time_usec () - cpu_start;
+
+    std::sort (latency.begin (), latency.end ());
+    result.module = bench.get_module ();
+    result.type = bench.get_type ();
+    result.frames = config.loop;
+    result.p50_ms = get_percentile_ms (latency, 50);
+    result.p99_ms = get_percentile_ms (latency, 99);
+    result.fps = config.loop * 1000000.0 / wall_time;
+    result.bytes_per_frame = bench.get_bytes_per_frame ();
+    result.cpu_percent = cpu_time * 100.0 / wall_time;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static XCamReturn
+bench_one (
+    BenchModule module, BenchType type, const BenchResolution &res,
+    const BenchConfig &config, BenchResult &result)
+{
+    result.res_name = res.name;
+    result.cpus = config.cpus;
+    result.out_width = res.width;
+    result.out_height = res.height;
+    result.in_width = res.width;
+    result.in_height = res.height;
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    switch (type) {
+    case BenchTypeRemap: {
+        RemapCase bench (module);
+        ret = bench.init (res.width, res.height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "init remap failed");
+        ret = bench.prepare_buffers (config, 1, res.width, res.height, res.width, res.height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "prepare remap buffers failed");
+        return run_case (bench, config, result);
+    }
+    case BenchTypeBlend: {
+        BlendCase bench (module);
+        ret = bench.init (res.width, res.height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "init blend failed");
+        ret = bench.prepare_buffers (config, 2, res.width, res.height, res.width, res.height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "prepare blend buffers failed");
+        return run_case (bench, config, result);
+    }
+    case BenchTypeStitch: {
+        // panorama of the resolution width, same 3:1 aspect as test-surround-view
+        result.out_height = XCAM_ALIGN_UP (res.width / 3, 16);
+        result.in_width = config.cam_width;
+        result.in_height = config.cam_height;
+
+        StitchCase bench (module);
+        ret = bench.init (config.calib_path, result.out_width, result.out_height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "init stitch failed");
+        ret = bench.prepare_buffers (
+            config, BENCH_CAMERA_NUM, result.in_width, result.in_height, result.out_width, result.out_height);
+        XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "prepare stitch buffers failed");
+        return run_case (bench, config, result);
+    }
+    default:
+        XCAM_LOG_ERROR ("unsupported bench type:%d", type);
+        return XCAM_RETURN_ERROR_PARAM;
+    }
+}
+
+// limit this thread and all threads started later to the first @cpus of @allowed cores, 0 for all
+static XCamReturn
+set_cpu_limit (const cpu_set_t &allowed, uint32_t cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < CPU_SETSIZE && (!cpus || count < cpus); ++i) {
+        if (!CPU_ISSET (i, &allowed))
+            continue;
+        CPU_SET (i, &set);
+        ++count;
+    }
+
+    if (cpus > count)
+        XCAM_LOG_WARNING ("only %d cpus available, %d requested", count, cpus);
+
+    XCAM_FAIL_RETURN (
+        ERROR, sched_setaffinity (0, sizeof (set), &set) == 0, XCAM_RETURN_ERROR_PARAM,
+        "limit to %d cpus failed, %s", count, strerror (errno));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static std::string
+get_result_key (const char *module, const char *type, const char *res, uint32_t cpus)
+{
+    char key[XCAM_MAX_STR_SIZE];
+    snprintf (key, sizeof (key), "%s %s %s %d", module, type, res, cpus);
+    return key;
+}
+
+// baseline file, one case a line: module type resolution cpus p50_ms, '#' starts a comment
+static XCamReturn
+load_baseline (const char *path, std::map<std::string, double> &baseline)
+{
+    FILE *fp = fopen (path, "r");
+    XCAM_FAIL_RETURN (ERROR, fp, XCAM_RETURN_ERROR_FILE, "open baseline file(%s) failed", path);
+
+    char line[256];
+    uint32_t line_num = 0;
+    while (fgets (line, sizeof (line), fp)) {
+        ++line_num;
+        char module[32], type[32], res[32];
+        uint32_t cpus = 0;
+        double p50_ms = 0.0;
+
+        char *start = line + strspn (line, " \t");
+        if (*start == '#' || *start == '\n' || *start == '\0')
+            continue;
+        if (sscanf (start, "%31s %31s %31s %u %lf", module, type, res, &cpus, &p50_ms) != 5 || p50_ms <= 0.0) {
+            XCAM_LOG_WARNING ("baseline file(%s) line:%d is invalid, ignored", path, line_num);
+            continue;
+        }
+        baseline[get_result_key (module, type, res, cpus)] = p50_ms;
+    }
+    fclose (fp);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static XCamReturn
+save_baseline (const char *path, const std::vector<BenchResult> &results, const BenchConfig &config)
+{
+    FILE *fp = fopen (path, "w");
+    XCAM_FAIL_RETURN (ERROR, fp, XCAM_RETURN_ERROR_FILE, "open baseline file(%s) failed", path);
+
+    fprintf (fp, "# bench-handlers baseline, %ld cpu cores, %s input, %d frames\n",
+             sysconf (_SC_NPROCESSORS_ONLN), config.input_file ? config.input_file : "synthetic", config.loop);
+    fprintf (fp, "# module type resolution cpus p50_ms\n");
+    for (size_t i = 0; i < results.size (); ++i) {
+        const BenchResult &r = results[i];
+        fprintf (fp, "%s %s %s %d %.3f\n", module_names[r.module], type_names[r.type], r.res_name, r.cpus, r.p50_ms);
+    }
+    fclose (fp);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// returns number of cases slower than baseline p50 by more than @tolerance percent
+static uint32_t
+check_baseline (
+    const std::map<std::string, double> &baseline, const std::vector<BenchResult> &results, double tolerance)
+{
+    uint32_t regressions = 0;
+    for (size_t i = 0; i < results.size (); ++i) {
+        const BenchResult &r = results[i];
+        std::string key = get_result_key (module_names[r.module], type_names[r.type], r.res_name, r.cpus);
+        std::map<std::string, double>::const_iterator it = baseline.find (key);
+        if (it == baseline.end ()) {
+            fprintf (stderr, "[ NEW  ] %-28s p50:%.3fms, no baseline\n", key.c_str (), r.p50_ms);
+            continue;
+        }
+
+        double change = (r.p50_ms - it->second) * 100.0 / it->second;
+        bool regressed = change > tolerance;
+        fprintf (stderr, "[ %s ] %-28s p50:%.3fms baseline:%.3fms (%+.1f%%)\n",
+                 regressed ? "FAIL" : " OK ", key.c_str (), r.p50_ms, it->second, change);
+        if (regressed)
+            ++regressions;
+    }
+
+    return regressions;
+}
+
+static void
+write_json (FILE *fp, const std::vector<BenchResult> &results, const BenchConfig &config)
+{
+    fprintf (fp, "{\n");
+    fprintf (fp, "  \"cpu_cores\": %ld,\n", sysconf (_SC_NPROCESSORS_ONLN));
+    fprintf (fp, "  \"input\": \"%s\",\n", config.input_file ? config.input_file : "synthetic");
+    fprintf (fp, "  \"warmup\": %d,\n", config.warmup);
+    fprintf (fp, "  \"results\": [");
+    for (size_t i = 0; i < results.size (); ++i) {
+        const BenchResult &r = results[i];
+        fprintf (fp, "%s\n    {", i ? "," : "");
+        fprintf (fp, "\"module\": \"%s\", \"type\": \"%s\", \"resolution\": \"%s\", \"cpus\": %d, ",
+                 module_names[r.module], type_names[r.type], r.res_name, r.cpus);
+        fprintf (fp, "\"input\": \"%dx%d\", \"output\": \"%dx%d\", \"frames\": %d, ",
+                 r.in_width, r.in_height, r.out_width, r.out_height, r.frames);
+        fprintf (fp, "\"p50_ms\": %.3f, \"p99_ms\": %.3f, \"fps\": %.2f, ",
+                 r.p50_ms, r.p99_ms, r.fps);
+        fprintf (fp, "\"bytes_per_frame\": %" PRIu64 ", \"mbytes_per_sec\": %.1f, \"cpu_percent\": %.1f}",
+                 r.bytes_per_frame, r.bytes_per_frame * r.fps / 1000000.0, r.cpu_percent);
+    }
+    fprintf (fp, "\n  ]\n}\n");
+}
+
+static void usage (const char *arg0)
+{
+    printf ("Usage:\n"
+            "%s --module MODULE --type TYPE --res RES ...\n"
+            "\t--module            optional, module selected from: soft, gles, vulkan, all(built in), default: soft\n"
+            "\t--type              optional, processing type, selected from: remap, blend, stitch, all, default: all\n"
+            "\t--res               optional, resolution selected from: 1080p, 4k, 8k, all, default: 1080p\n"
+            "\t--input             optional, input image(NV12) read at each input size, default: synthetic image\n"
+            "\t--cam-w             optional, stitch camera width, default: 1280\n"
+            "\t--cam-h             optional, stitch camera height, default: 800\n"
+            "\t--loop              optional, how many frames to measure, default: 20\n"
+            "\t--warmup            optional, how many frames to run before measuring, default: 2\n"
+            "\t--cpus              optional, comma separated cpu counts to sweep, 0 for all cores, default: 0\n"
+            "\t--baseline          optional, baseline file to compare p50 latency against, fails on regression\n"
+            "\t--tolerance         optional, allowed p50 regression in percent, default: 10\n"
+            "\t--save-baseline     optional, write p50 latency of all cases to baseline file\n"
+            "\t--json              optional, output JSON file, default: stdout\n"
+            "\t--trace             optional, export per-stage trace to file in Chrome trace format\n"
+            "\t--help              usage\n"
+            "stitch reads calibration files from env " FISHEYE_CONFIG_ENV_VAR ", default: " FISHEYE_CONFIG_PATH "\n",
+            arg0);
+}
+
+int main (int argc, char *argv[])
+{
+    bool modules[BenchModuleCount] = {true, false, false};
+    bool types[BenchTypeCount] = {true, true, true};
+    bool res_enabled[BENCH_RES_NUM] = {true, false, false};
+    const char *json_file = NULL;
+    const char *trace_file = NULL;
+    const char *baseline_file = NULL;
+    const char *save_file = NULL;
+    double tolerance = BENCH_DEFAULT_TOLERANCE;
+    uint32_t cpu_sweep[BENCH_MAX_CPU_SWEEP] = {0};
+    uint32_t cpu_sweep_num = 1;
+    BenchConfig config;
+
+    const struct option long_opts[] = {
+        {"module", required_argument, NULL, 'm'},
+        {"type", required_argument, NULL, 't'},
+        {"res", required_argument, NULL, 'r'},
+        {"input", required_argument, NULL, 'i'},
+        {"cam-w", required_argument, NULL, 'w'},
+        {"cam-h", required_argument, NULL, 'h'},
+        {"loop", required_argument, NULL, 'l'},
+        {"warmup", required_argument, NULL, 'u'},
+        {"cpus", required_argument, NULL, 'c'},
+        {"baseline", required_argument, NULL, 'b'},
+        {"tolerance", required_argument, NULL, 'o'},
+        {"save-baseline", required_argument, NULL, 's'},
+        {"json", required_argument, NULL, 'j'},
+        {"trace", required_argument, NULL, 'T'},
+        {"help", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int opt = -1;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'm': {
+            XCAM_ASSERT (optarg);
+            bool all = !strcasecmp (optarg, "all");
+            bool found = all;
+            for (uint32_t i = 0; i < BenchModuleCount; ++i) {
+                modules[i] = (all && module_built[i]) || !strcasecmp (optarg, module_names[i]);
+                found = found || modules[i];
+            }
+            if (!found) {
+                XCAM_LOG_ERROR ("unknown module:%s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        }
+        case 't': {
+            XCAM_ASSERT (optarg);
+            bool all = !strcasecmp (optarg, "all");
+            bool found = all;
+            for (uint32_t i = 0; i < BenchTypeCount; ++i) {
+                types[i] = all || !strcasecmp (optarg, type_names[i]);
+                found = found || types[i];
+            }
+            if (!found) {
+                XCAM_LOG_ERROR ("unknown type:%s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        }
+        case 'r': {
+            XCAM_ASSERT (optarg);
+            bool all = !strcasecmp (optarg, "all");
+            bool found = all;
+            for (uint32_t i = 0; i < BENCH_RES_NUM; ++i) {
+                res_enabled[i] = all || !strcasecmp (optarg, resolutions[i].name);
+                found = found || res_enabled[i];
+            }
+            if (!found) {
+                XCAM_LOG_ERROR ("unknown resolution:%s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        }
+        case 'i':
+            XCAM_ASSERT (optarg);
+            config.input_file = optarg;
+            break;
+        case 'w':
+            config.cam_width = atoi(optarg);
+            break;
+        case 'h':
+            config.cam_height = atoi(optarg);
+            break;
+        case 'l':
+            config.loop = atoi(optarg);
+            break;
+        case 'u':
+            config.warmup = atoi(optarg);
+            break;
+        case 'c': {
+            XCAM_ASSERT (optarg);
+            cpu_sweep_num = 0;
+            for (char *str = optarg; *str && cpu_sweep_num < BENCH_MAX_CPU_SWEEP; ) {
+                char *end = NULL;
+                long count = strtol (str, &end, 10);
+                if (end == str || count < 0) {
+                    XCAM_LOG_ERROR ("invalid cpus:%s", optarg);
+                    usage (argv[0]);
+                    return -1;
+                }
+                cpu_sweep[cpu_sweep_num++] = (uint32_t)count;
+                str = (*end == ',') ? end + 1 : end;
+            }
+            break;
+        }
+        case 'b':
+            XCAM_ASSERT (optarg);
+            baseline_file = optarg;
+            break;
+        case 'o':
+            tolerance = atof(optarg);
+            break;
+        case 's':
+            XCAM_ASSERT (optarg);
+            save_file = optarg;
+            break;
+        case 'j':
+            XCAM_ASSERT (optarg);
+            json_file = optarg;
+            break;
+        case 'T':
+            XCAM_ASSERT (optarg);
+            trace_file = optarg;
+            break;
+        case 'e':
+            usage (argv[0]);
+            return 0;
+        default:
+            XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
+            usage (argv[0]);
+            return -1;
+        }
+    }
+
+    if (optind < argc) {
+        XCAM_LOG_ERROR ("unknown option %s", argv[optind]);
+        usage (argv[0]);
+        return -1;
+    }
+    CHECK_EXP (config.loop > 0, "loop count must be positive");
+    CHECK_EXP (tolerance >= 0.0, "tolerance must not be negative");
+
+    std::map<std::string, double> baseline;
+    if (baseline_file)
+        CHECK (load_baseline (baseline_file, baseline), "load baseline from %s failed", baseline_file);
+
+#if HAVE_GLES
+    SmartPtr<EGLBase> egl;
+    if (modules[BenchModuleGLES]) {
+        egl = new EGLBase ();
+        XCAM_FAIL_RETURN (ERROR, egl->init (), -1, "init EGL failed");
+    }
+#else
+    CHECK_EXP (!modules[BenchModuleGLES], "GLES module unsupported");
+#endif
+
+#if HAVE_VULKAN
+    if (modules[BenchModuleVulkan])
+        CHECK_EXP (VKDevice::default_device ().ptr (), "get default VKDevice failed, please check vulkan environment");
+#else
+    CHECK_EXP (!modules[BenchModuleVulkan], "vulkan module unsupported");
+#endif
+
+    if (trace_file)
+        Tracer::enable (true);
+
+    std::string calib_path = FISHEYE_CONFIG_PATH;
+    const char *env = std::getenv (FISHEYE_CONFIG_ENV_VAR);
+    if (env)
+        calib_path.assign (env, strlen (env));
+    config.calib_path = calib_path.c_str ();
+
+    cpu_set_t allowed_cpus;
+    CHECK_EXP (
+        sched_getaffinity (0, sizeof (allowed_cpus), &allowed_cpus) == 0,
+        "get cpu affinity failed, %s", strerror (errno));
+
+    std::vector<BenchResult> results;
+    for (uint32_t c = 0; c < cpu_sweep_num; ++c) {
+        // handlers start their threads on first frame, so every case inherits the limit
+        config.cpus = cpu_sweep[c];
+        CHECK (set_cpu_limit (allowed_cpus, config.cpus), "set cpu limit failed");
+
+        for (uint32_t m = 0; m < BenchModuleCount; ++m) {
+            if (!modules[m])
+                continue;
+            for (uint32_t t = 0; t < BenchTypeCount; ++t) {
+                if (!types[t])
+                    continue;
+                for (uint32_t r = 0; r < BENCH_RES_NUM; ++r) {
+                    if (!res_enabled[r])
+                        continue;
+
+                    BenchResult result;
+                    XCamReturn ret = bench_one ((BenchModule)m, (BenchType)t, resolutions[r], config, result);
+                    CHECK (ret, "bench %s %s at %s failed", module_names[m], type_names[t], resolutions[r].name);
+                    results.push_back (result);
+                }
+            }
+        }
+    }
+
+    FILE *fp = stdout;
+    if (json_file) {
+        fp = fopen (json_file, "w");
+        CHECK_EXP (fp, "open json file(%s) failed", json_file);
+    }
+    write_json (fp, results, config);
+    if (fp != stdout)
+        fclose (fp);
+
+    if (trace_file)
+        CHECK (Tracer::export_chrome_trace (trace_file), "export trace to %s failed", trace_file);
+
+    if (save_file)
+        CHECK (save_baseline (save_file, results, config), "save baseline to %s failed", save_file);
+
+    if (baseline_file) {
+        uint32_t regressions = check_baseline (baseline, results, tolerance);
+        CHECK_EXP (
+            !regressions, "%d of %d cases regressed more than %.1f%% against %s",
+            regressions, (uint32_t)results.size (), tolerance, baseline_file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#!/bin/sh
+#
+# check-perf.sh - performance regression check of soft/gles/vulkan handlers
+#
+# runs bench-handlers over a fixed workload matrix and compares p50 latency of
+# every case against the baseline of this platform, fails on regressions.
+#
+# usage: check-perf.sh [--update]
+#   --update    record current results as the baseline of this platform
+#
+# env:
+#   BENCH_HANDLERS      bench-handlers binary, default: ./bench-handlers
+#   PERF_BASELINE_DIR   baseline directory, default: perf-baselines next to this script
+#   PERF_PLATFORM       baseline name, default: <machine>-<cpu cores>
+#   PERF_TOLERANCE      allowed p50 regression in percent, default: 10
+#   PERF_MODULES        modules to run, default: soft, gles and vulkan are added when built in
+#   PERF_LOOP           frames measured of each case, default: 30
+#   FISHEYE_CONFIG_PATH stitch calibration files, stitch cases are skipped without them
+#
+
+BENCH_HANDLERS=${BENCH_HANDLERS:-./bench-handlers}
+PERF_BASELINE_DIR=${PERF_BASELINE_DIR:-$(dirname "$0")/perf-baselines}
+PERF_PLATFORM=${PERF_PLATFORM:-$(uname -m)-$(getconf _NPROCESSORS_ONLN)}
+PERF_TOLERANCE=${PERF_TOLERANCE:-10}
+PERF_MODULES=${PERF_MODULES:-soft}
+PERF_LOOP=${PERF_LOOP:-30}
+CALIB_PATH=${FISHEYE_CONFIG_PATH:-./calib_params}
+
+BASELINE="$PERF_BASELINE_DIR/$PERF_PLATFORM.txt"
+RESULT_DIR=${PERF_RESULT_DIR:-perf-results}
+
+update=0
+if [ "$1" = "--update" ]; then
+    update=1
+elif [ -n "$1" ]; then
+    echo "usage: $0 [--update]" >&2
+    exit 1
+fi
+
+if [ ! -x "$BENCH_HANDLERS" ]; then
+    echo "check-perf: $BENCH_HANDLERS not found" >&2
+    exit 1
+fi
+
+if [ $update -eq 0 ] && [ ! -f "$BASELINE" ]; then
+    echo "check-perf: no baseline $BASELINE for platform $PERF_PLATFORM" >&2
+    echo "check-perf: record one with 'make check-perf-update' on an idle machine" >&2
+    exit 1
+fi
+
+types="remap blend"
+if [ -f "$CALIB_PATH/intrinsic_camera_front.txt" ]; then
+    types="$types stitch"
+else
+    echo "check-perf: no calibration files in $CALIB_PATH, stitch cases skipped" >&2
+fi
+
+# stitch thread scaling, core counts above this machine's are dropped
+cores=$(getconf _NPROCESSORS_ONLN)
+sweep=""
+for n in 1 2 4 8; do
+    [ $n -le $cores ] && sweep="$sweep${sweep:+,}$n"
+done
+
+mkdir -p "$RESULT_DIR"
+rm -f "$RESULT_DIR"/case-*
+status=0
+index=0
+run_bench () {
+    index=$((index + 1))
+    result="$RESULT_DIR/case-$index"
+    if [ $update -eq 1 ]; then
+        "$BENCH_HANDLERS" --loop $PERF_LOOP --json "$result.json" --save-baseline "$result.txt" "$@" || status=1
+    else
+        "$BENCH_HANDLERS" --loop $PERF_LOOP --json "$result.json" \
+            --baseline "$BASELINE" --tolerance $PERF_TOLERANCE "$@" || status=1
+    fi
+}
+
+for module in $PERF_MODULES; do
+    for type in $types; do
+        for res in 1080p 4k; do
+            run_bench --module $module --type $type --res $res
+        done
+    done
+done
+
+case " $types " in
+*" stitch "*)
+    run_bench --module soft --type stitch --res 1080p --cpus $sweep
+    ;;
+esac
+
+if [ $update -eq 1 ]; then
+    if [ $status -ne 0 ]; then
+        echo "check-perf: bench failed, baseline $BASELINE not updated" >&2
+        exit 1
+    fi
+    mkdir -p "$PERF_BASELINE_DIR"
+    {
+        echo "# check-perf baseline of $PERF_PLATFORM, $(date -u +%Y-%m-%d)"
+        cat "$RESULT_DIR"/case-*.txt | grep -v '^#'
+    } > "$BASELINE"
+    echo "check-perf: baseline written to $BASELINE"
+    exit 0
+fi
+
+if [ $status -ne 0 ]; then
+    echo "check-perf: FAILED against $BASELINE, results in $RESULT_DIR" >&2
+    exit 1
+fi
+echo "check-perf: passed against $BASELINE"
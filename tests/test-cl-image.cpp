@@ -131,7 +131,7 @@ print_help (const char *bin_name)
     printf ("Usage: %s [-f format] -i input -o output\n"
             "\t -t type           specify image handler type\n"
             "\t                   select from [demo, blacklevel, defect, demosaic, tonemapping, csc, hdr, wb, denoise,"
-            " gamma, snr, bnr, macc, ee, bayerpipe, yuvpipe, retinex, gauss, wavelet-hat, wavelet-haar, dcp, fisheye]\n"
+            " gamma, snr, bnr, macc, ee, bayerpipe, yuvpipe, retinex, gauss, wavelet-hat, wavelet-haar, wavelet-lifting, dcp, fisheye]\n"
             "\t -f input_format   specify a input format\n"
             "\t -W image_width    specify input image width\n"
             "\t -H image_height   specify input image height\n"
@@ -143,9 +143,12 @@ print_help (const char *bin_name)
             "\t -k binary_kernel  specify binary kernel path\n"
             "\t -p count          specify cl kernel loop count\n"
             "\t -c csc_type       specify csc type, default:rgba2nv12\n"
-            "\t                   select from [rgbatonv12, rgbatolab, rgba64torgba, yuyvtorgba, nv12torgba]\n"
+            "\t                   select from [rgbatonv12, rgbatolab, rgba64torgba, yuyvtorgba, nv12torgba, nv12scale]\n"
             "\t -b                enable bayer-nr, default: disable\n"
             "\t -P                enable psnr calculation, default: disable\n"
+            "\t -F                half precision of retinex and wavelet(haar) if device supports fp16\n"
+            "\t -d downscale      dcp estimates dark channel at 1/downscale resolution, select from [1, 4, 8], default: 1\n"
+            "\t -R x,y,w,h        process only rectangle of frame(defog, 3d denoise), can be repeated\n"
             "\t -h                help\n"
             , bin_name);
 
@@ -179,8 +182,12 @@ int main (int argc, char *argv[])
     CLCscType csc_type = CL_CSC_TYPE_RGBATONV12;
     bool enable_bnr = false;
     bool enable_psnr = false;
+    CLPrecision precision = CLPrecisionFloat;
+    uint32_t dcp_downscale = 1;
+    bool wavelet_lifting = false;
+    std::vector<Rect> rois;
 
-    while ((opt =  getopt(argc, argv, "f:W:H:i:o:r:t:k:p:c:g:bPh")) != -1) {
+    while ((opt =  getopt(argc, argv, "f:W:H:i:o:r:t:k:p:c:g:d:R:bPFh")) != -1) {
         switch (opt) {
         case 'i':
             input_file = optarg;
@@ -248,6 +255,10 @@ int main (int argc, char *argv[])
                 handler_type = TestHandlerHatWavelet;
             else if (!strcasecmp (optarg, "wavelet-haar"))
                 handler_type = TestHandlerHaarWavelet;
+            else if (!strcasecmp (optarg, "wavelet-lifting")) {
+                handler_type = TestHandlerHaarWavelet;
+                wavelet_lifting = true;
+            }
             else if (!strcasecmp (optarg, "dcp"))
                 handler_type = TestHandlerDefogDcp;
             else if (!strcasecmp (optarg, "3d-denoise"))
@@ -278,6 +289,8 @@ int main (int argc, char *argv[])
                 csc_type = CL_CSC_TYPE_YUYVTORGBA;
             else if (!strcasecmp (optarg, "nv12torgba"))
                 csc_type = CL_CSC_TYPE_NV12TORGBA;
+            else if (!strcasecmp (optarg, "nv12scale"))
+                csc_type = CL_CSC_TYPE_NV12SCALE;
             else
                 print_help (bin_name);
             break;
@@ -290,6 +303,23 @@ int main (int argc, char *argv[])
             enable_psnr = true;
             break;
 
+        case 'F':
+            precision = CLPrecisionHalf;
+            break;
+        case 'd':
+            dcp_downscale = atoi (optarg);
+            break;
+
+        case 'R': {
+            Rect roi;
+            if (sscanf (optarg, "%d,%d,%d,%d", &roi.pos_x, &roi.pos_y, &roi.width, &roi.height) != 4) {
+                print_help (bin_name);
+                return -1;
+            }
+            rois.push_back (roi);
+            break;
+        }
+
         case 'h':
             print_help (bin_name);
             return 0;
@@ -379,7 +409,7 @@ int main (int argc, char *argv[])
         break;
     }
     case TestHandlerRetinex: {
-        image_handler = create_cl_retinex_image_handler (context);
+        image_handler = create_cl_retinex_image_handler (context, precision);
         SmartPtr<CLRetinexImageHandler> retinex = image_handler.dynamic_cast_ptr<CLRetinexImageHandler> ();
         XCAM_ASSERT (retinex.ptr ());
         break;
@@ -404,7 +434,8 @@ int main (int argc, char *argv[])
         break;
     }
     case TestHandlerHaarWavelet: {
-        image_handler = create_cl_newwavelet_denoise_image_handler (context, CL_IMAGE_CHANNEL_UV | CL_IMAGE_CHANNEL_Y, false);
+        image_handler = create_cl_newwavelet_denoise_image_handler (
+                            context, CL_IMAGE_CHANNEL_UV | CL_IMAGE_CHANNEL_Y, false, precision, wavelet_lifting);
         SmartPtr<CLNewWaveletDenoiseImageHandler> wavelet = image_handler.dynamic_cast_ptr<CLNewWaveletDenoiseImageHandler> ();
         XCAM_ASSERT (wavelet.ptr ());
         XCam3aResultWaveletNoiseReduction wavelet_config;
@@ -417,7 +448,7 @@ int main (int argc, char *argv[])
         break;
     }
     case TestHandlerDefogDcp: {
-        image_handler = create_cl_defog_dcp_image_handler (context);
+        image_handler = create_cl_defog_dcp_image_handler (context, dcp_downscale);
         XCAM_ASSERT (image_handler.ptr ());
         break;
     }
@@ -494,6 +525,7 @@ int main (int argc, char *argv[])
         XCAM_LOG_ERROR ("create image_handler failed");
         return -1;
     }
+    image_handler->set_roi_list (rois);
 
     input_buf_info.init (input_format, width, height);
 
@@ -501,7 +533,7 @@ int main (int argc, char *argv[])
     XCAM_ASSERT (buf_pool.ptr ());
     image_handler->set_pool_type (CLImageHandler::CLVideoPoolType);
     buf_pool->set_video_info (input_buf_info);
-    if (!buf_pool->reserve (6)) {
+    if (!xcam_ret_is_ok (buf_pool->reserve (6))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return -1;
     }
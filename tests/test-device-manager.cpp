@@ -46,6 +46,7 @@
 #include "drm_display.h"
 #endif
 #include "fake_poll_thread.h"
+#include "io_reactor.h"
 #include "image_file_handle.h"
 #include <base/xcam_3a_types.h>
 #include <unistd.h>
@@ -264,7 +265,8 @@ void print_help (const char *bin_name)
 #endif
             "], default is [simple]\n"
             "\t -m mem_type     specify video memory type\n"
-            "\t                 mem_type select from [dma, mmap], default is [mmap]\n"
+            "\t                 mem_type select from [dma, mmap, export], default is [mmap]\n"
+            "\t                 export: mmap buffers exported as dma-buf\n"
             "\t -s              save file to %s\n"
             "\t -n interval     save file on every [interval] frame\n"
             "\t -f pixel_fmt    specify output pixel format\n"
@@ -280,7 +282,14 @@ void print_help (const char *bin_name)
             "\t -e display_mode preview mode\n"
             "\t                 select from [primary, overlay], default is [primary]\n"
             "\t --sync          set analyzer in sync mode\n"
+            "\t --analysis-interval  analyze 3a stats of every n frames, extrapolate ae/awb in between\n"
+            "\t --parallel-3a   run 3a handlers concurrently if analyzer supports\n"
+            "\t --io-reactor    poll capture and event devices from one epoll thread\n"
+            "\t --latest-only   display and save the latest processed buffer only, drop stale ones\n"
             "\t -r raw_input    specify the path of raw image as fake source instead of live camera\n"
+            "\t --replay-speed  pace raw input by its timestamps, 1.0 is real time, N is N times faster\n"
+            "\t                 frames are dropped if buffers are not returned in time, default 0 is as fast as possible\n"
+            "\t --replay-ts     text file of raw input timestamps in us, one per frame, default is [raw_input].ts\n"
             "\t -h              help\n"
 #if HAVE_LIBCL
             "CL features:\n"
@@ -305,6 +314,7 @@ void print_help (const char *bin_name)
             "\t --enable-wireframe  enable wire frame\n"
             "\t --pipeline      specify pipe mode\n"
             "\t                 select from [basic, advance, extreme], default is [basic]\n"
+            "\t --fused-pipe    demosaic to NV12 in one pass, not with bnr or tnr\n"
             "\t --disable-post  disable cl post image processor\n"
 #endif
             , bin_name
@@ -334,6 +344,7 @@ int main (int argc, char *argv[])
     CL3aImageProcessor::PipelineProfile pipeline_mode = CL3aImageProcessor::BasicPipelineProfile;
     CL3aImageProcessor::CaptureStage capture_stage = CL3aImageProcessor::TonemappingStage;
     CL3aImageProcessor::CLTonemappingMode wdr_mode = CL3aImageProcessor::WDRdisabled;
+    bool fused_pipe = false;
 
 #if HAVE_IA_AIQ
     int32_t brightness_level = 128;
@@ -353,6 +364,7 @@ int main (int argc, char *argv[])
     DrmDisplayMode display_mode = DRM_DISPLAY_MODE_PRIMARY;
 #endif
     enum v4l2_memory v4l2_mem_type = V4L2_MEMORY_MMAP;
+    bool dma_export = false;
     const char *bin_name = argv[0];
     uint32_t capture_mode = V4L2_CAPTURE_MODE_VIDEO;
     uint32_t pixel_format = V4L2_PIX_FMT_NV12;
@@ -360,6 +372,10 @@ int main (int argc, char *argv[])
     bool    have_usbcam = 0;
     std::string usb_device_name;
     bool sync_mode = false;
+    uint32_t analysis_interval = 1;
+    bool parallel_3a = false;
+    bool use_io_reactor = false;
+    bool latest_only = false;
     bool save_file = false;
     uint32_t interval_frames = 1;
     uint32_t save_frames = 0;
@@ -367,6 +383,8 @@ int main (int argc, char *argv[])
     uint32_t frame_width = 1920;
     uint32_t frame_height = 1080;
     std::string path_to_fake;
+    double replay_speed = 0.0;
+    std::string replay_ts_file;
 
     int opt;
     const char *short_opts = "sca:n:m:f:W:H:d:b:pi:e:r:h";
@@ -382,8 +400,15 @@ int main (int argc, char *argv[])
         {"enable-warp", no_argument, NULL, 'A'},
         {"usb", required_argument, NULL, 'U'},
         {"sync", no_argument, NULL, 'Y'},
+        {"analysis-interval", required_argument, NULL, 'I'},
+        {"parallel-3a", no_argument, NULL, 'G'},
+        {"io-reactor", no_argument, NULL, 'Q'},
+        {"latest-only", no_argument, NULL, 'K'},
+        {"replay-speed", required_argument, NULL, 'R'},
+        {"replay-ts", required_argument, NULL, 'S'},
         {"capture", required_argument, NULL, 'C'},
         {"pipeline", required_argument, NULL, 'P'},
+        {"fused-pipe", no_argument, NULL, 'Z'},
         {"disable-post", no_argument, NULL, 'O'},
         {0, 0, 0, 0},
     };
@@ -417,7 +442,10 @@ int main (int argc, char *argv[])
                 v4l2_mem_type = V4L2_MEMORY_DMABUF;
             else if (!strcmp (optarg, "mmap"))
                 v4l2_mem_type = V4L2_MEMORY_MMAP;
-            else
+            else if (!strcmp (optarg, "export")) {
+                v4l2_mem_type = V4L2_MEMORY_MMAP;
+                dma_export = true;
+            } else
                 print_help (bin_name);
             break;
         }
@@ -486,6 +514,27 @@ int main (int argc, char *argv[])
         case 'Y':
             sync_mode = true;
             break;
+        case 'I':
+            XCAM_ASSERT (optarg);
+            analysis_interval = XCAM_MAX (atoi (optarg), 1);
+            break;
+        case 'G':
+            parallel_3a = true;
+            break;
+        case 'Q':
+            use_io_reactor = true;
+            break;
+        case 'K':
+            latest_only = true;
+            break;
+        case 'R':
+            XCAM_ASSERT (optarg);
+            replay_speed = atof (optarg);
+            break;
+        case 'S':
+            XCAM_ASSERT (optarg);
+            replay_ts_file = optarg;
+            break;
 #if HAVE_LIBCL
         case 'c':
             have_cl_processor = true;
@@ -628,6 +677,10 @@ int main (int argc, char *argv[])
             have_cl_post_processor = false;
             break;
         }
+        case 'Z': {
+            fused_pipe = true;
+            break;
+        }
 #endif
         case 'r': {
             XCAM_ASSERT (optarg);
@@ -724,6 +777,13 @@ int main (int argc, char *argv[])
     }
     XCAM_ASSERT (analyzer.ptr ());
     analyzer->set_sync_mode (sync_mode);
+    if (analysis_interval > 1) {
+        analyzer->set_analysis_interval (analysis_interval);
+        analyzer->set_latest_stats_only (true);
+        analyzer->set_results_extrapolation (true);
+    }
+    if (parallel_3a)
+        analyzer->set_parallel_handlers (true);
 
 #if HAVE_LIBCL
     SmartHandlerList smart_handlers = SmartAnalyzerLoader::load_smart_handlers (DEFAULT_SMART_ANALYSIS_LIB_DIR);
@@ -755,6 +815,7 @@ int main (int argc, char *argv[])
     device->set_capture_mode (capture_mode);
     //device->set_mem_type (V4L2_MEMORY_DMABUF);
     device->set_mem_type (v4l2_mem_type);
+    device->set_dma_export (dma_export);
     device->set_buffer_count (8);
     if (pixel_format == V4L2_PIX_FMT_SGRBG12) {
         frame_rate = 30;
@@ -828,6 +889,7 @@ int main (int argc, char *argv[])
 
         cl_processor->set_tnr (tnr_type, tnr_level);
         cl_processor->set_profile (pipeline_mode);
+        cl_processor->set_fused_pipe (fused_pipe);
 #if HAVE_IA_AIQ
         analyzer->set_parameter_brightness((brightness_level - 128) / 128.0);
 #endif
@@ -878,7 +940,13 @@ int main (int argc, char *argv[])
     if (have_usbcam) {
         poll_thread = new PollThread ();
     } else if (path_to_fake.c_str ()) {
-        poll_thread = new FakePollThread (path_to_fake.c_str ());
+        SmartPtr<FakePollThread> fake_poll_thread = new FakePollThread (path_to_fake.c_str ());
+        if (!fake_poll_thread->set_replay_speed (replay_speed) ||
+                (!replay_ts_file.empty () && !fake_poll_thread->set_timestamp_file (replay_ts_file.c_str ()))) {
+            print_help (bin_name);
+            return -1;
+        }
+        poll_thread = fake_poll_thread;
     }
 #if HAVE_IA_AIQ
     else {
@@ -887,7 +955,15 @@ int main (int argc, char *argv[])
         poll_thread = isp_poll_thread;
     }
 #endif
+    SmartPtr<IoReactor> io_reactor;
+    if (use_io_reactor) {
+        io_reactor = new IoReactor ("test_io_reactor");
+        ret = io_reactor->start ();
+        CHECK (ret, "io reactor start failed");
+        poll_thread->set_io_reactor (io_reactor);
+    }
     device_manager->set_poll_thread (poll_thread);
+    device_manager->set_latest_buffer_only (latest_only);
 
     ret = device_manager->start ();
     CHECK (ret, "device manager start failed");
@@ -912,6 +988,8 @@ int main (int argc, char *argv[])
 
     ret = device_manager->stop();
     CHECK_CONTINUE (ret, "device manager stop failed");
+    if (io_reactor.ptr ())
+        io_reactor->stop ();
     device->close ();
 #if HAVE_IA_AIQ
     event_device->close ();
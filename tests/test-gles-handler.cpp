@@ -25,6 +25,8 @@
 #include <gles/egl/egl_base.h>
 #include <gles/gl_copy_handler.h>
 #include <gles/gl_geomap_handler.h>
+#include <gles/gl_blender.h>
+#include <gles/gl_executor.h>
 #include <interface/blender.h>
 
 using namespace XCam;
@@ -44,6 +46,13 @@ public:
     virtual ~GLStream () {}
 
     virtual XCamReturn create_buf_pool (const VideoBufferInfo &info, uint32_t count);
+
+    void set_executor (const SmartPtr<GLExecutor> &executor) {
+        _executor = executor;
+    }
+
+private:
+    SmartPtr<GLExecutor>    _executor;
 };
 
 typedef std::vector<SmartPtr<GLStream>> GLStreams;
@@ -58,8 +67,9 @@ GLStream::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
 {
     SmartPtr<GLVideoBufferPool> pool = new GLVideoBufferPool (info);
     XCAM_ASSERT (pool.ptr ());
+    pool->set_executor (_executor);
 
-    if (!pool->reserve (count)) {
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
         XCAM_LOG_ERROR ("create buffer pool failed");
         return XCAM_RETURN_ERROR_MEM;
     }
@@ -97,6 +107,7 @@ static void usage (const char *arg0)
             "\t--out-h             optional, output height, default: 800\n"
             "\t--save              optional, save file or not, select from [true/false], default: true\n"
             "\t--loop              optional, how many loops need to run, default: 1\n"
+            "\t--executor          optional, run GL work on an executor thread owning the context\n"
             "\t--help              usage\n",
             arg0);
 }
@@ -114,6 +125,7 @@ int main (int argc, char **argv)
 
     int loop = 1;
     bool save_output = true;
+    bool use_executor = false;
 
     const struct option long_opts[] = {
         {"type", required_argument, NULL, 't'},
@@ -126,6 +138,7 @@ int main (int argc, char **argv)
         {"out-h", required_argument, NULL, 'H'},
         {"save", required_argument, NULL, 's'},
         {"loop", required_argument, NULL, 'l'},
+        {"executor", no_argument, NULL, 'x'},
         {"help", no_argument, NULL, 'e'},
         {NULL, 0, NULL, 0},
     };
@@ -177,6 +190,9 @@ int main (int argc, char **argv)
         case 'l':
             loop = atoi(optarg);
             break;
+        case 'x':
+            use_executor = true;
+            break;
         case 'e':
             usage (argv[0]);
             return 0;
@@ -209,9 +225,20 @@ int main (int argc, char **argv)
     printf ("output height:\t\t%d\n", output_height);
     printf ("save output:\t\t%s\n", save_output ? "true" : "false");
     printf ("loop count:\t\t%d\n", loop);
-
-    SmartPtr<EGLBase> egl = new EGLBase ();
-    XCAM_FAIL_RETURN (ERROR, egl->init (), -1, "init EGL failed");
+    printf ("executor:\t\t%s\n", use_executor ? "true" : "false");
+
+    SmartPtr<EGLBase> egl;
+    SmartPtr<GLExecutor> executor;
+    if (use_executor) {
+        executor = new GLExecutor ();
+        XCAM_ASSERT (executor.ptr ());
+        CHECK (executor->start (), "start GL executor failed");
+        for (uint32_t i = 0; i < ins.size (); ++i)
+            ins[i]->set_executor (executor);
+    } else {
+        egl = new EGLBase ();
+        XCAM_FAIL_RETURN (ERROR, egl->init (), -1, "init EGL failed");
+    }
 
     VideoBufferInfo in_info;
     in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
@@ -233,6 +260,7 @@ int main (int argc, char **argv)
     case GLTypeCopy: {
         SmartPtr<GLCopyHandler> copyer = new GLCopyHandler ();
         XCAM_ASSERT (copyer.ptr ());
+        copyer->set_executor (executor);
 
         Rect in_area = Rect (0, 0, output_width, output_height);
         Rect out_area = in_area;
@@ -246,11 +274,13 @@ int main (int argc, char **argv)
                 outs[0]->write_buf ();
             FPS_CALCULATION (gl-copy, XCAM_OBJ_DUR_FRAME_NUM);
         }
+        copyer->terminate ();
         break;
     }
     case GLTypeRemap: {
         SmartPtr<GLGeoMapHandler> mapper = new GLGeoMapHandler ();
         XCAM_ASSERT (mapper.ptr ());
+        mapper->set_executor (executor);
         mapper->set_output_size (output_width, output_height);
 
         uint32_t lut_width = XCAM_ALIGN_UP (output_width, 8) / 8;
@@ -267,12 +297,16 @@ int main (int argc, char **argv)
                 outs[0]->write_buf ();
             FPS_CALCULATION (gl-remap, XCAM_OBJ_DUR_FRAME_NUM);
         }
+        mapper->terminate ();
         break;
     }
     case GLTypeBlender: {
         CHECK_EXP (ins.size () == 2, "Error: blender needs 2 input files.");
         SmartPtr<Blender> blender = Blender::create_gl_blender ();
         XCAM_ASSERT (blender.ptr ());
+        SmartPtr<GLBlender> gl_blender = blender.dynamic_cast_ptr<GLBlender> ();
+        XCAM_ASSERT (gl_blender.ptr ());
+        gl_blender->set_executor (executor);
         blender->set_output_size (output_width, output_height);
 
         Rect area;
@@ -300,6 +334,7 @@ int main (int argc, char **argv)
                 outs[0]->write_buf ();
             FPS_CALCULATION (gl-blend, XCAM_OBJ_DUR_FRAME_NUM);
         }
+        gl_blender->terminate ();
         break;
     }
     default: {
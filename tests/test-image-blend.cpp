@@ -271,11 +271,11 @@ int main (int argc, char *argv[])
     XCAM_ASSERT (buf_pool0.ptr () && buf_pool1.ptr ());
     buf_pool0->set_video_info (input_buf_info0);
     buf_pool1->set_video_info (input_buf_info1);
-    if (!buf_pool0->reserve (2)) {
+    if (!xcam_ret_is_ok (buf_pool0->reserve (2))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return -1;
     }
-    if (!buf_pool1->reserve (2)) {
+    if (!xcam_ret_is_ok (buf_pool1->reserve (2))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return -1;
     }
@@ -42,14 +42,17 @@ usage (const char* arg0)
             "\t--output,   output image(RGB) PREFIX\n"
             "\t--blind,    optional, blind or non-blind deblurring, default true; select from [true/false]\n"
             "\t--save,     optional, save file or not, default true; select from [true/false]\n"
+            "\t--converge, optional, blind deblurring stops once kernel changes less than this, default 0 (off)\n"
+            "\t--scale,    optional, blind deblurring estimates kernel on image downscaled by this, default 1\n"
             "\t--help,     usage\n",
             arg0);
 }
 
 static void
-blind_deblurring (cv::Mat &input_image, cv::Mat &output_image)
+blind_deblurring (cv::Mat &input_image, cv::Mat &output_image, const CVIDConfig &config)
 {
     SmartPtr<CVImageDeblurring> image_deblurring = new CVImageDeblurring ();
+    image_deblurring->set_config (config);
     cv::Mat kernel;
     image_deblurring->blind_deblurring (input_image, output_image, kernel, -1, -1, false);
 }
@@ -87,12 +90,15 @@ int main (int argc, char *argv[])
 
     bool need_save_output = true;
     bool blind = true;
+    CVIDConfig config;
 
     const struct option long_opts[] = {
         {"input", required_argument, NULL, 'i'},
         {"output", required_argument, NULL, 'o'},
         {"blind", required_argument, NULL, 'b'},
         {"save", required_argument, NULL, 's'},
+        {"converge", required_argument, NULL, 'c'},
+        {"scale", required_argument, NULL, 'S'},
         {"help", no_argument, NULL, 'H'},
         {0, 0, 0, 0},
     };
@@ -113,6 +119,12 @@ int main (int argc, char *argv[])
         case 's':
             need_save_output = (strcasecmp (optarg, "false") == 0 ? false : true);
             break;
+        case 'c':
+            config.convergence = atof (optarg);
+            break;
+        case 'S':
+            config.estimate_scale = atoi (optarg);
+            break;
         case 'H':
             usage (argv[0]);
             return -1;
@@ -141,6 +153,8 @@ int main (int argc, char *argv[])
     printf ("output file :%s\n", file_out_name);
     printf ("blind deblurring:%s\n", blind ? "true" : "false");
     printf ("need save file:%s\n", need_save_output ? "true" : "false");
+    printf ("convergence:%f\n", config.convergence);
+    printf ("estimate scale:%d\n", config.estimate_scale);
     printf ("----------------------\n");
 
     SmartPtr<CVImageSharp> sharp = new CVImageSharp ();
@@ -153,7 +167,7 @@ int main (int argc, char *argv[])
     }
     if (blind)
     {
-        blind_deblurring (input_image, output_image);
+        blind_deblurring (input_image, output_image, config);
     }
     else
     {
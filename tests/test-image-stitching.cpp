@@ -146,8 +146,9 @@ void usage(const char* arg0)
             "\t--surround-mode     optional, stitching surround mode, select from [sphere, bowl], default: sphere\n"
             "\t--scale-mode        optional, image scaling mode, select from [local/global], default: local\n"
             "\t--enable-seam       optional, enable seam finder in blending area, default: no\n"
-            "\t--enable-fisheyemap optional, enable fisheye map, default: no\n"
+            "\t--enable-fisheyemap optional, fisheye map by cached geo table, select from [true/false], default: true\n"
             "\t--enable-lsc        optional, enable lens shading correction, default: no\n"
+            "\t--direct-output     optional, fisheye writes non-overlap columns into output, local scale only, default: no\n"
 #if HAVE_OPENCV
             "\t--fm-ocl            optional, enable ocl for feature match, select from [true/false], default: false\n"
 #endif
@@ -187,8 +188,9 @@ int main (int argc, char *argv[])
 
     int loop = 1;
     bool enable_seam = false;
-    bool enable_fisheye_map = false;
+    bool enable_fisheye_map = true;
     bool enable_lsc = false;
+    bool direct_output = false;
     CLBlenderScaleMode scale_mode = CLBlenderScaleLocal;
     StitchResMode res_mode = StitchRes1080P;
     SurroundMode surround_mode = SphereView;
@@ -224,8 +226,9 @@ int main (int argc, char *argv[])
         {"surround-mode", required_argument, NULL, 'r'},
         {"scale-mode", required_argument, NULL, 'c'},
         {"enable-seam", no_argument, NULL, 'S'},
-        {"enable-fisheyemap", no_argument, NULL, 'F'},
+        {"enable-fisheyemap", optional_argument, NULL, 'F'},
         {"enable-lsc", no_argument, NULL, 'L'},
+        {"direct-output", no_argument, NULL, 'D'},
 #if HAVE_OPENCV
         {"fm-ocl", required_argument, NULL, 'O'},
 #endif
@@ -300,11 +303,14 @@ int main (int argc, char *argv[])
             enable_seam = true;
             break;
         case 'F':
-            enable_fisheye_map = true;
+            enable_fisheye_map = (optarg && !strcasecmp (optarg, "false")) ? false : true;
             break;
         case 'L':
             enable_lsc = true;
             break;
+        case 'D':
+            direct_output = true;
+            break;
 #if HAVE_OPENCV
         case 'O':
             fm_ocl = (strcasecmp (optarg, "true") == 0 ? true : false);
@@ -403,6 +409,7 @@ int main (int argc, char *argv[])
     printf ("seam mask:\t\t%s\n", enable_seam ? "true" : "false");
     printf ("fisheye map:\t\t%s\n", enable_fisheye_map ? "true" : "false");
     printf ("shading correction:\t%s\n", enable_lsc ? "true" : "false");
+    printf ("direct output:\t\t%s\n", direct_output ? "true" : "false");
 #if HAVE_OPENCV
     printf ("feature match ocl:\t%s\n", fm_ocl ? "true" : "false");
 #endif
@@ -419,7 +426,7 @@ int main (int argc, char *argv[])
     image_360 =
         create_image_360_stitch (
             context, enable_seam, scale_mode, enable_fisheye_map, enable_lsc, surround_mode,
-            res_mode, fisheye_num, all_in_one).dynamic_cast_ptr<CLImage360Stitch> ();
+            res_mode, fisheye_num, all_in_one, direct_output).dynamic_cast_ptr<CLImage360Stitch> ();
     XCAM_ASSERT (image_360.ptr ());
     image_360->set_output_size (output_width, output_height);
 #if HAVE_OPENCV
@@ -447,7 +454,7 @@ int main (int argc, char *argv[])
         SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
         XCAM_ASSERT (pool.ptr ());
         pool->set_video_info (input_buf_info);
-        if (!pool->reserve (6)) {
+        if (!xcam_ret_is_ok (pool->reserve (6))) {
             XCAM_LOG_ERROR ("init buffer pool failed");
             return -1;
         }
@@ -458,7 +465,7 @@ int main (int argc, char *argv[])
     SmartPtr<BufferPool> top_view_pool = new CLVideoBufferPool ();
     XCAM_ASSERT (top_view_pool.ptr ());
     top_view_pool->set_video_info (top_view_buf_info);
-    if (!top_view_pool->reserve (6)) {
+    if (!xcam_ret_is_ok (top_view_pool->reserve (6))) {
         XCAM_LOG_ERROR ("top-view-buffer pool reserve failed");
         return -1;
     }
@@ -467,7 +474,7 @@ int main (int argc, char *argv[])
     SmartPtr<BufferPool> rectified_view_pool = new CLVideoBufferPool ();
     XCAM_ASSERT (rectified_view_pool.ptr ());
     rectified_view_pool->set_video_info (rectified_view_buf_info);
-    if (!rectified_view_pool->reserve (6)) {
+    if (!xcam_ret_is_ok (rectified_view_pool->reserve (6))) {
         XCAM_LOG_ERROR ("top-view-buffer pool reserve failed");
         return -1;
     }
@@ -0,0 +1,95 @@
+/*
+ * test-kernel-bundle.cpp - pack cached kernel binaries into a bundle
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+/*
+ * Usage:
+ * 1. warm kernel cache by running the pipelines once on target device, e.g.
+ *    $ XCAM_CL_KERNEL_CACHE_PATH=/tmp/xcam-kernels test-pipe-manager ...
+ * 2. pack binaries of current device and driver into a bundle
+ *    $ test-kernel-bundle --cache-path /tmp/xcam-kernels --bundle kernels.bundle
+ * 3. install bundle to $HOME/.xcam/kernels.bundle or set env XCAM_CL_KERNEL_BUNDLE,
+ *    kernels are loaded from it on first build, a bundle of other device/driver is ignored.
+ */
+
+#include "test_common.h"
+#include "ocl/cl_device.h"
+#include "ocl/cl_kernel.h"
+#include <getopt.h>
+#include <string>
+
+using namespace XCam;
+
+static void
+print_help (const char *arg0)
+{
+    printf ("Usage: %s --cache-path <dir> --bundle <file>\n"
+            "\t --cache-path  optional, kernel cache path, default: $XCAM_CL_KERNEL_CACHE_PATH or %s\n"
+            "\t --bundle      optional, output bundle file, default: <cache-path>/%s\n"
+            "\t --help        help\n"
+            , arg0, CLKernel::get_kernel_cache_path (), XCAM_CL_KERNEL_BUNDLE_NAME);
+}
+
+int main (int argc, char *argv[])
+{
+    std::string cache_path = CLKernel::get_kernel_cache_path ();
+    std::string bundle_file;
+
+    const char *env = std::getenv ("XCAM_CL_KERNEL_CACHE_PATH");
+    if (env)
+        cache_path = env;
+
+    const struct option long_opts [] = {
+        {"cache-path", required_argument, NULL, 'c'},
+        {"bundle", required_argument, NULL, 'b'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt = 0;
+    while ((opt = getopt_long (argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            cache_path = optarg;
+            break;
+        case 'b':
+            bundle_file = optarg;
+            break;
+        case 'h':
+            print_help (argv[0]);
+            return 0;
+
+        default:
+            print_help (argv[0]);
+            return -1;
+        }
+    }
+
+    if (bundle_file.empty ())
+        bundle_file = cache_path + "/" XCAM_CL_KERNEL_BUNDLE_NAME;
+
+    const CLDevieInfo &info = CLDevice::instance ()->get_device_info ();
+    printf ("device: %s, driver: %s\n", info.device_name, info.driver_version);
+
+    XCamReturn ret = CLKernel::pack_kernel_bundle (cache_path.c_str (), bundle_file.c_str ());
+    CHECK (ret, "pack kernels in %s into %s failed", cache_path.c_str (), bundle_file.c_str ());
+
+    printf ("bundle saved to %s\n", bundle_file.c_str ());
+    return 0;
+}
@@ -416,7 +416,7 @@ int main (int argc, char *argv[])
     buf_info.init (pixel_format, image_width, image_height);
     SmartPtr<BufferPool> buf_pool = new CLVideoBufferPool ();
     XCAM_ASSERT (buf_pool.ptr ());
-    if (!buf_pool->set_video_info (buf_info) || !buf_pool->reserve (DEFAULT_FPT_BUF_COUNT)) {
+    if (!buf_pool->set_video_info (buf_info) || !xcam_ret_is_ok (buf_pool->reserve (DEFAULT_FPT_BUF_COUNT))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return -1;
     }
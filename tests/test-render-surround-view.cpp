@@ -143,7 +143,7 @@ SVStream::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
     }
     XCAM_ASSERT (pool.ptr ());
 
-    if (!pool->reserve (count)) {
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
         XCAM_LOG_ERROR ("create buffer pool failed");
         pool.release ();
         return XCAM_RETURN_ERROR_MEM;
@@ -310,8 +310,7 @@ create_car_model (const char *name)
 
 static int
 run_stitcher (
-    const SmartPtr<Stitcher> &stitcher,
-    const SmartPtr<RenderOsgViewer> &render, const SmartPtr<RenderOsgModel> &model,
+    const SmartPtr<Stitcher> &stitcher, const SmartPtr<RenderOsgModel> &model,
     const SVStreams &ins, const SVStreams &outs, bool save_output)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
@@ -340,6 +339,8 @@ run_stitcher (
 
         {
             SmartLock locker (mutex);
+            // new buffer each frame, the render thread may still hold the last one
+            outs[0]->get_buf ().release ();
             CHECK (
                 stitcher->stitch_buffers (in_buffers, outs[0]->get_buf ()),
                 "stitch buffer failed.");
@@ -349,8 +350,7 @@ run_stitcher (
             }
         }
 
-        model->update_texture (outs[0]->get_buf ());
-        render->start_render ();
+        model->post_buffer (outs[0]->get_buf ());
 
         FPS_CALCULATION (surround - view, XCAM_OBJ_DUR_FRAME_NUM);
     } while (true);
@@ -601,11 +601,15 @@ int main (int argc, char *argv[])
 
     render->validate_model_groups ();
 
+    // render at display rate on the latest stitched frame
+    CHECK_EXP (render->start_render_thread (), "start render thread failed");
+
     while (loop--) {
         CHECK_EXP (
-            run_stitcher (stitcher, render, svm_model, ins, outs, save_output) == 0,
+            run_stitcher (stitcher, svm_model, ins, outs, save_output) == 0,
             "run stitcher failed");
     }
 
+    render->stop_render_thread ();
     return 0;
 }
@@ -24,6 +24,11 @@
 #include <soft/soft_video_buf_allocator.h>
 #include <interface/blender.h>
 #include <interface/geo_mapper.h>
+#include <soft/soft_geo_mapper.h>
+#include <soft/soft_blender.h>
+#include <soft/soft_tnr_handler.h>
+#include <soft/soft_scaler.h>
+#include <soft/soft_csc.h>
 
 #define MAP_WIDTH 3
 #define MAP_HEIGHT 4
@@ -40,7 +45,10 @@ using namespace XCam;
 enum SoftType {
     SoftTypeNone    = 0,
     SoftTypeBlender,
-    SoftTypeRemap
+    SoftTypeRemap,
+    SoftTypeTnr,
+    SoftTypeScale,
+    SoftTypeCsc
 };
 
 class SoftStream
@@ -69,7 +77,7 @@ SoftStream::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
     XCAM_ASSERT (pool.ptr ());
 
     pool->set_video_info (info);
-    if (!pool->reserve (count)) {
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
         XCAM_LOG_ERROR ("create buffer pool failed");
         return XCAM_RETURN_ERROR_MEM;
     }
@@ -82,18 +90,26 @@ static void usage(const char* arg0)
 {
     printf ("Usage:\n"
             "%s --type TYPE --input0 input.nv12 --input1 input1.nv12 --output output.nv12 ...\n"
-            "\t--type              processing type, selected from: blend, remap\n"
+            "\t--type              processing type, selected from: blend, remap, tnr, scale, csc\n"
             "\t--input0            input image(NV12)\n"
             "\t--input1            input image(NV12)\n"
-            "\t--output            output image(NV12/MP4)\n"
+            "\t--output            output image(NV12/MP4), csc writes raw .yuv/.rgba/.yuyv files\n"
             "\t--in-w              optional, input width, default: 1280\n"
             "\t--in-h              optional, input height, default: 800\n"
             "\t--out-w             optional, output width, default: 1280\n"
             "\t--out-h             optional, output height, default: 800\n"
             "\t--save              optional, save file or not, select from [true/false], default: true\n"
             "\t--loop              optional, how many loops need to run, default: 1\n"
+            "\t--geomap            optional, remap path, select from [float/fixed/planar], default: float\n"
+            "\t--remap-format      optional, remap output format, select from [nv12/i420], default: nv12\n"
+            "\t--async-io          optional, frames read ahead and written behind by I/O threads, 0 means inline, default: 0\n"
+            "\t--mmap              optional, async reader maps input files, select from [true/false], default: false\n"
+            "\t--seam              optional, blend along a seam searched every N frames, 0 means fixed mask, default: 0\n"
+            "\t--tnr-refs          optional, tnr reference frames, range [1, %d], default: 1\n"
+            "\t--scale-mode        optional, scale mode, select from [bilinear/area], default: bilinear\n"
+            "\t--csc-format        optional, csc output format, select from [i420/rgba/yuyv], default: i420\n"
             "\t--help              usage\n",
-            arg0);
+            arg0, XCAM_SOFT_TNR_MAX_REFS);
 }
 
 int main (int argc, char *argv[])
@@ -109,6 +125,14 @@ int main (int argc, char *argv[])
 
     int loop = 1;
     bool save_output = true;
+    const char *geomap_path = "float";
+    uint32_t remap_format = V4L2_PIX_FMT_NV12;
+    uint32_t async_io = 0;
+    bool use_mmap = false;
+    uint32_t seam_interval = 0;
+    uint32_t tnr_refs = 1;
+    SoftScaleMode scale_mode = SoftScaleBilinear;
+    uint32_t csc_format = V4L2_PIX_FMT_YUV420;
 
     const struct option long_opts[] = {
         {"type", required_argument, NULL, 't'},
@@ -121,6 +145,14 @@ int main (int argc, char *argv[])
         {"out-h", required_argument, NULL, 'H'},
         {"save", required_argument, NULL, 's'},
         {"loop", required_argument, NULL, 'l'},
+        {"geomap", required_argument, NULL, 'g'},
+        {"remap-format", required_argument, NULL, 'P'},
+        {"async-io", required_argument, NULL, 'A'},
+        {"mmap", required_argument, NULL, 'm'},
+        {"seam", required_argument, NULL, 'S'},
+        {"tnr-refs", required_argument, NULL, 'R'},
+        {"scale-mode", required_argument, NULL, 'M'},
+        {"csc-format", required_argument, NULL, 'F'},
         {"help", no_argument, NULL, 'e'},
         {NULL, 0, NULL, 0},
     };
@@ -134,6 +166,12 @@ int main (int argc, char *argv[])
                 type = SoftTypeBlender;
             else if (!strcasecmp (optarg, "remap"))
                 type = SoftTypeRemap;
+            else if (!strcasecmp (optarg, "tnr"))
+                type = SoftTypeTnr;
+            else if (!strcasecmp (optarg, "scale"))
+                type = SoftTypeScale;
+            else if (!strcasecmp (optarg, "csc"))
+                type = SoftTypeCsc;
             else {
                 XCAM_LOG_ERROR ("unknown type:%s", optarg);
                 usage (argv[0]);
@@ -170,6 +208,65 @@ int main (int argc, char *argv[])
         case 'l':
             loop = atoi(optarg);
             break;
+        case 'g':
+            XCAM_ASSERT (optarg);
+            if (strcasecmp (optarg, "float") && strcasecmp (optarg, "fixed") && strcasecmp (optarg, "planar")) {
+                XCAM_LOG_ERROR ("unknown geomap path: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            geomap_path = optarg;
+            break;
+        case 'P':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "nv12"))
+                remap_format = V4L2_PIX_FMT_NV12;
+            else if (!strcasecmp (optarg, "i420"))
+                remap_format = V4L2_PIX_FMT_YUV420;
+            else {
+                XCAM_LOG_ERROR ("unknown remap format: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'A':
+            async_io = atoi(optarg);
+            break;
+        case 'm':
+            use_mmap = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'S':
+            seam_interval = atoi(optarg);
+            break;
+        case 'R':
+            tnr_refs = atoi(optarg);
+            break;
+        case 'M':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "bilinear"))
+                scale_mode = SoftScaleBilinear;
+            else if (!strcasecmp (optarg, "area"))
+                scale_mode = SoftScaleArea;
+            else {
+                XCAM_LOG_ERROR ("unknown scale mode: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'F':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "i420"))
+                csc_format = V4L2_PIX_FMT_YUV420;
+            else if (!strcasecmp (optarg, "rgba"))
+                csc_format = V4L2_PIX_FMT_RGBA32;
+            else if (!strcasecmp (optarg, "yuyv"))
+                csc_format = V4L2_PIX_FMT_YUYV;
+            else {
+                XCAM_LOG_ERROR ("unknown csc format: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
         default:
             XCAM_LOG_ERROR ("getopt_long return unknown value:%c", opt);
             usage (argv[0]);
@@ -200,16 +297,21 @@ int main (int argc, char *argv[])
     printf ("output height:\t\t%d\n", output_height);
     printf ("save output:\t\t%s\n", save_output ? "true" : "false");
     printf ("loop count:\t\t%d\n", loop);
+    printf ("geomap path:\t\t%s\n", geomap_path);
+    printf ("async io:\t\t%d\n", async_io);
+    printf ("mmap input:\t\t%s\n", use_mmap ? "true" : "false");
 
     VideoBufferInfo in_info;
     in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
     for (uint32_t i = 0; i < ins.size (); ++i) {
         ins[i]->set_buf_size (input_width, input_height);
+        ins[i]->enable_async_io (async_io, use_mmap);
         CHECK (ins[i]->create_buf_pool (in_info, 6), "create buffer pool failed");
         CHECK (ins[i]->open_reader ("rb"), "open input file(%s) failed", ins[i]->get_file_name ());
     }
 
     outs[0]->set_buf_size (output_width, output_height);
+    outs[0]->enable_async_io (async_io);
     if (save_output) {
         CHECK (outs[0]->estimate_file_format (), "%s: estimate file format failed", outs[0]->get_file_name ());
         CHECK (outs[0]->open_writer ("wb"), "open output file(%s) failed", outs[0]->get_file_name ());
@@ -221,6 +323,11 @@ int main (int argc, char *argv[])
         SmartPtr<Blender> blender = Blender::create_soft_blender ();
         XCAM_ASSERT (blender.ptr ());
         blender->set_output_size (output_width, output_height);
+        if (seam_interval) {
+            SmartPtr<SoftBlender> soft_blender = blender.dynamic_cast_ptr<SoftBlender> ();
+            XCAM_ASSERT (soft_blender.ptr ());
+            soft_blender->set_seam_mode (true, seam_interval);
+        }
 
         Rect area;
         area.pos_x = 0;
@@ -242,6 +349,8 @@ int main (int argc, char *argv[])
         CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
         CHECK (ins[1]->read_buf(), "read buffer from file(%s) failed.", ins[1]->get_file_name ());
         for (int i = 0; i < loop; ++i) {
+            if (outs[0]->is_async_io ())
+                outs[0]->get_buf ().release ();
             CHECK (blender->blend (ins[0]->get_buf (), ins[1]->get_buf (), outs[0]->get_buf ()), "blend buffer failed");
             if (save_output)
                 outs[0]->write_buf ();
@@ -254,10 +363,18 @@ int main (int argc, char *argv[])
         XCAM_ASSERT (mapper.ptr ());
         mapper->set_output_size (output_width, output_height);
         mapper->set_lookup_table (map_table, MAP_WIDTH, MAP_HEIGHT);
+
+        SmartPtr<SoftGeoMapper> soft_mapper = mapper.dynamic_cast_ptr<SoftGeoMapper> ();
+        XCAM_ASSERT (soft_mapper.ptr ());
+        soft_mapper->enable_fixed_point (!strcasecmp (geomap_path, "fixed"));
+        soft_mapper->enable_planar_mode (!strcasecmp (geomap_path, "planar"));
+        CHECK_EXP (soft_mapper->set_output_format (remap_format), "remap output format is invalid");
         //mapper->set_factors ((output_width - 1.0f) / (MAP_WIDTH - 1.0f), (output_height - 1.0f) / (MAP_HEIGHT - 1.0f));
 
         CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
         for (int i = 0; i < loop; ++i) {
+            if (outs[0]->is_async_io ())
+                outs[0]->get_buf ().release ();
             CHECK (mapper->remap (ins[0]->get_buf (), outs[0]->get_buf ()), "remap buffer failed");
             if (save_output)
                 outs[0]->write_buf ();
@@ -265,6 +382,66 @@ int main (int argc, char *argv[])
         }
         break;
     }
+    case SoftTypeTnr: {
+        SmartPtr<SoftTnrHandler> tnr = new SoftTnrHandler ();
+        XCAM_ASSERT (tnr.ptr ());
+        CHECK_EXP (tnr->set_reference_count (tnr_refs), "tnr reference count(%d) is invalid", tnr_refs);
+
+        // every loop denoises the next input frame, input file is rewound at its end
+        for (int i = 0; i < loop; ++i) {
+            XCamReturn ret = ins[0]->read_buf ();
+            if (ret == XCAM_RETURN_BYPASS) {
+                ins[0]->rewind ();
+                tnr->reset_references ();
+                ret = ins[0]->read_buf ();
+            }
+            CHECK (ret, "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+
+            // outputs stay references of later frames, take a new one from tnr pool
+            outs[0]->get_buf ().release ();
+            CHECK (tnr->denoise (ins[0]->get_buf (), outs[0]->get_buf ()), "tnr buffer failed");
+            if (save_output)
+                outs[0]->write_buf ();
+            FPS_CALCULATION (soft-tnr, XCAM_OBJ_DUR_FRAME_NUM);
+        }
+        break;
+    }
+    case SoftTypeScale: {
+        SmartPtr<SoftScaler> scaler = new SoftScaler ();
+        XCAM_ASSERT (scaler.ptr ());
+        scaler->set_mode (scale_mode);
+        CHECK_EXP (
+            scaler->set_output_size (output_width, output_height),
+            "scale output size(%dx%d) is invalid", output_width, output_height);
+
+        std::vector<SmartPtr<VideoBuffer> > scaled;
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        for (int i = 0; i < loop; ++i) {
+            scaled.clear ();
+            CHECK (scaler->scale (ins[0]->get_buf (), scaled), "scale buffer failed");
+            outs[0]->get_buf () = scaled[0];
+            if (save_output)
+                outs[0]->write_buf ();
+            FPS_CALCULATION (soft-scale, XCAM_OBJ_DUR_FRAME_NUM);
+        }
+        break;
+    }
+    case SoftTypeCsc: {
+        SmartPtr<SoftCsc> csc = new SoftCsc ();
+        XCAM_ASSERT (csc.ptr ());
+        CHECK_EXP (csc->set_output_format (csc_format), "csc output format is invalid");
+
+        CHECK (ins[0]->read_buf(), "read buffer from file(%s) failed.", ins[0]->get_file_name ());
+        for (int i = 0; i < loop; ++i) {
+            // output pool has csc format, buffers of output stream are NV12
+            outs[0]->get_buf ().release ();
+            CHECK (csc->convert (ins[0]->get_buf (), outs[0]->get_buf ()), "csc buffer failed");
+            if (save_output)
+                outs[0]->write_buf ();
+            FPS_CALCULATION (soft-csc, XCAM_OBJ_DUR_FRAME_NUM);
+        }
+        break;
+    }
     default: {
         XCAM_LOG_ERROR ("unsupported type:%d", type);
         usage (argv[0]);
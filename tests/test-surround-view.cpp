@@ -22,12 +22,25 @@
 #include "test_stream.h"
 #include <interface/geo_mapper.h>
 #include <interface/stitcher.h>
+#include <interface/strip_stitcher.h>
+#include <interface/topview_generator.h>
 #include <calibration_parser.h>
+#include <calibration_binary.h>
+#include <thread_pool.h>
+#include <safe_list.h>
 #include <soft/soft_video_buf_allocator.h>
+#include <soft/soft_stitcher.h>
+#include <sys/stat.h>
+#include <algorithm>
 #if HAVE_GLES
 #include <gles/gl_video_buffer.h>
+#include <gles/gl_stitcher.h>
 #include <gles/egl/egl_base.h>
 #endif
+#if HAVE_VULKAN
+#include <vulkan/vk_device.h>
+#include <vulkan/vk_geomap_handler.h>
+#endif
 
 using namespace XCam;
 
@@ -39,12 +52,14 @@ enum FrameMode {
 enum SVModule {
     SVModuleNone    = 0,
     SVModuleSoft,
-    SVModuleGLES
+    SVModuleGLES,
+    SVModuleVulkan
 };
 
 enum SVOutIdx {
     IdxStitch    = 0,
     IdxTopView,
+    IdxViewport,
     IdxCount
 };
 
@@ -67,6 +82,19 @@ public:
     const SmartPtr<GeoMapper> &get_mapper () {
         return _mapper;
     }
+    void set_topview (const SmartPtr<TopViewGenerator> &topview) {
+        XCAM_ASSERT (topview.ptr ());
+        _topview = topview;
+    }
+    const SmartPtr<TopViewGenerator> &get_topview () {
+        return _topview;
+    }
+    void set_persistent_map (bool enable) {
+        _persistent_map = enable;
+    }
+    void set_huge_page (bool enable) {
+        _huge_page = enable;
+    }
 
     virtual XCamReturn create_buf_pool (const VideoBufferInfo &info, uint32_t count);
 
@@ -76,12 +104,17 @@ private:
 private:
     SVModule               _module;
     SmartPtr<GeoMapper>    _mapper;
+    SmartPtr<TopViewGenerator> _topview;
+    bool                   _persistent_map;
+    bool                   _huge_page;
 };
 typedef std::vector<SmartPtr<SVStream>> SVStreams;
 
 SVStream::SVStream (const char *file_name, uint32_t width, uint32_t height)
     :  Stream (file_name, width, height)
     , _module (SVModuleNone)
+    , _persistent_map (false)
+    , _huge_page (false)
 {
 }
 
@@ -94,15 +127,26 @@ SVStream::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
 
     SmartPtr<BufferPool> pool;
     if (_module == SVModuleSoft) {
-        pool = new SoftVideoBufAllocator (info);
+        SmartPtr<SoftVideoBufAllocator> soft_pool = new SoftVideoBufAllocator (info);
+        if (_huge_page)
+            soft_pool->set_mem_policy (SoftBufMemPolicy (SoftBufMemHugePage));
+        pool = soft_pool;
     } else if (_module == SVModuleGLES) {
 #if HAVE_GLES
-        pool = new GLVideoBufferPool (info);
+        SmartPtr<GLVideoBufferPool> gl_pool = new GLVideoBufferPool (info);
+        gl_pool->set_persistent_map (_persistent_map);
+        pool = gl_pool;
+#endif
+    } else if (_module == SVModuleVulkan) {
+#if HAVE_VULKAN
+        pool = create_vk_buffer_pool (VKDevice::default_device ());
+        XCAM_ASSERT (pool.ptr ());
+        pool->set_video_info (info);
 #endif
     }
     XCAM_ASSERT (pool.ptr ());
 
-    if (!pool->reserve (count)) {
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
         XCAM_LOG_ERROR ("create buffer pool failed");
         return XCAM_RETURN_ERROR_MEM;
     }
@@ -121,6 +165,10 @@ create_stitcher (SVModule module)
     } else if (module == SVModuleGLES) {
 #if HAVE_GLES
         stitcher = Stitcher::create_gl_stitcher ();
+#endif
+    } else if (module == SVModuleVulkan) {
+#if HAVE_VULKAN
+        stitcher = Stitcher::create_vk_stitcher ();
 #endif
     }
     XCAM_ASSERT (stitcher.ptr ());
@@ -128,32 +176,88 @@ create_stitcher (SVModule module)
     return stitcher;
 }
 
-static int
-parse_camera_info (const char *path, uint32_t idx, CameraInfo &info, uint32_t camera_count)
+// soft stitchers each render one strip into output taken from a shared pool
+static SmartPtr<Stitcher>
+create_strip_stitcher (
+    uint32_t strips, uint32_t output_width, uint32_t output_height, bool fused_mode, int64_t frame_budget,
+    BlendMode blend_mode)
 {
-    static const char *instrinsic_names[] = {
-        "intrinsic_camera_front.txt", "intrinsic_camera_right.txt",
-        "intrinsic_camera_rear.txt", "intrinsic_camera_left.txt"
-    };
-    static const char *exstrinsic_names[] = {
-        "extrinsic_camera_front.txt", "extrinsic_camera_right.txt",
-        "extrinsic_camera_rear.txt", "extrinsic_camera_left.txt"
-    };
-    static const float viewpoints_range[] = {64.0f, 160.0f, 64.0f, 160.0f};
+    SmartPtr<StripStitcher> strip_stitcher = new StripStitcher ();
+    for (uint32_t i = 0; i < strips; ++i) {
+        SmartPtr<SoftStitcher> soft_stitcher = Stitcher::create_soft_stitcher ().dynamic_cast_ptr<SoftStitcher> ();
+        XCAM_ASSERT (soft_stitcher.ptr ());
+        soft_stitcher->enable_fused_mode (fused_mode);
+        soft_stitcher->set_frame_budget (frame_budget);
+        soft_stitcher->set_blend_mode (blend_mode);
+        XCAM_FAIL_RETURN (
+            ERROR, strip_stitcher->add_stitcher (soft_stitcher), NULL,
+            "add strip(%d) stitcher failed", i);
+    }
 
-    char intrinsic_path[XCAM_TEST_MAX_STR_SIZE] = {'\0'};
-    char extrinsic_path[XCAM_TEST_MAX_STR_SIZE] = {'\0'};
-    snprintf (intrinsic_path, XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, instrinsic_names[idx]);
-    snprintf (extrinsic_path, XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, exstrinsic_names[idx]);
+    VideoBufferInfo info;
+    info.init (
+        V4L2_PIX_FMT_NV12, output_width, output_height,
+        XCAM_ALIGN_UP (output_width, 8), XCAM_ALIGN_UP (output_height, 4));
+    SmartPtr<BufferPool> pool = new SoftVideoBufAllocator (info);
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (pool->reserve (4)), NULL, "reserve strip output pool failed");
+    strip_stitcher->set_output_pool (pool);
 
-    CalibrationParser parser;
-    CHECK (
-        parser.parse_intrinsic_file (intrinsic_path, info.calibration.intrinsic),
-        "parse intrinsic params (%s)failed.", intrinsic_path);
+    return strip_stitcher;
+}
+
+static const char *instrinsic_names[] = {
+    "intrinsic_camera_front.txt", "intrinsic_camera_right.txt",
+    "intrinsic_camera_rear.txt", "intrinsic_camera_left.txt"
+};
+static const char *exstrinsic_names[] = {
+    "extrinsic_camera_front.txt", "extrinsic_camera_right.txt",
+    "extrinsic_camera_rear.txt", "extrinsic_camera_left.txt"
+};
+
+static int
+convert_calibration (const char *path, const char *binary_path, uint32_t camera_count)
+{
+    char intrinsic_paths[4][XCAM_TEST_MAX_STR_SIZE];
+    char extrinsic_paths[4][XCAM_TEST_MAX_STR_SIZE];
+    const char *intrinsic_files[4];
+    const char *extrinsic_files[4];
+    for (uint32_t i = 0; i < camera_count; ++i) {
+        snprintf (intrinsic_paths[i], XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, instrinsic_names[i]);
+        snprintf (extrinsic_paths[i], XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, exstrinsic_names[i]);
+        intrinsic_files[i] = intrinsic_paths[i];
+        extrinsic_files[i] = extrinsic_paths[i];
+    }
 
     CHECK (
-        parser.parse_extrinsic_file (extrinsic_path, info.calibration.extrinsic),
-        "parse extrinsic params (%s)failed.", extrinsic_path);
+        CalibrationBinary::convert_text_files (binary_path, intrinsic_files, extrinsic_files, camera_count),
+        "convert calibration files to binary(%s) failed", binary_path);
+    return 0;
+}
+
+static int
+parse_camera_info (
+    const char *path, uint32_t idx, CameraInfo &info, uint32_t camera_count,
+    const CalibrationBinary *binary)
+{
+    static const float viewpoints_range[] = {64.0f, 160.0f, 64.0f, 160.0f};
+
+    if (binary) {
+        CHECK (binary->get_calibration (idx, info.calibration), "get calibration(idx:%d) from binary failed", idx);
+    } else {
+        char intrinsic_path[XCAM_TEST_MAX_STR_SIZE] = {'\0'};
+        char extrinsic_path[XCAM_TEST_MAX_STR_SIZE] = {'\0'};
+        snprintf (intrinsic_path, XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, instrinsic_names[idx]);
+        snprintf (extrinsic_path, XCAM_TEST_MAX_STR_SIZE, "%s/%s", path, exstrinsic_names[idx]);
+
+        CalibrationParser parser;
+        CHECK (
+            parser.parse_intrinsic_file (intrinsic_path, info.calibration.intrinsic),
+            "parse intrinsic params (%s)failed.", intrinsic_path);
+
+        CHECK (
+            parser.parse_extrinsic_file (extrinsic_path, info.calibration.extrinsic),
+            "parse extrinsic params (%s)failed.", extrinsic_path);
+    }
     info.calibration.extrinsic.trans_x += TEST_CAMERA_POSITION_OFFSET_X;
 
     info.angle_range = viewpoints_range[idx];
@@ -225,45 +329,89 @@ write_out_image (const SmartPtr<SVStream> &out, uint32_t frame_num)
 #endif
 }
 
-static XCamReturn
-create_topview_mapper (
-    const SmartPtr<Stitcher> &stitcher, const SmartPtr<SVStream> &stitch,
-    const SmartPtr<SVStream> &topview, SVModule module)
+static SmartPtr<GeoMapper>
+create_view_mapper (SVModule module)
 {
-    BowlModel bowl_model (stitcher->get_bowl_config (), stitch->get_width (), stitch->get_height ());
-    BowlModel::PointMap points;
-
-    float length_mm = 0.0f, width_mm = 0.0f;
-    bowl_model.get_max_topview_area_mm (length_mm, width_mm);
-    XCAM_LOG_INFO ("Max Topview Area (L%.2fmm, W%.2fmm)", length_mm, width_mm);
-
-    bowl_model.get_topview_rect_map (points, topview->get_width (), topview->get_height (), length_mm, width_mm);
     SmartPtr<GeoMapper> mapper;
     if (module == SVModuleSoft) {
         mapper = GeoMapper::create_soft_geo_mapper ();
     } else if (module == SVModuleGLES) {
 #if HAVE_GLES
         mapper = GeoMapper::create_gl_geo_mapper ();
+#endif
+    } else if (module == SVModuleVulkan) {
+#if HAVE_VULKAN
+        mapper = new VKGeoMapHandler (VKDevice::default_device ());
 #endif
     }
     XCAM_ASSERT (mapper.ptr ());
+    return mapper;
+}
+
+static XCamReturn
+create_topview_mapper (
+    const SmartPtr<Stitcher> &stitcher, const SmartPtr<SVStream> &stitch,
+    const SmartPtr<SVStream> &topview, SVModule module)
+{
+    SmartPtr<TopViewGenerator> generator = new TopViewGenerator (create_view_mapper (module));
+    XCAM_ASSERT (generator.ptr ());
+    generator->set_bowl (stitcher->get_bowl_config (), stitch->get_width (), stitch->get_height ());
+    generator->set_output_size (topview->get_width (), topview->get_height ());
 
-    mapper->set_output_size (topview->get_width (), topview->get_height ());
-    mapper->set_lookup_table (points.data (), topview->get_width (), topview->get_height ());
-    topview->set_mapper (mapper);
+    XCamReturn ret = generator->prepare ();
+    XCAM_FAIL_RETURN (ERROR, xcam_ret_is_ok (ret), ret, "prepare topview generator failed");
+    topview->set_topview (generator);
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+// viewport stitches only columns it reads when @restrict_strip is set, before first frame
+static int
+create_viewport_mapper (
+    const SmartPtr<Stitcher> &stitcher, const SmartPtr<SVStream> &stitch,
+    const SmartPtr<SVStream> &view, const BowlModel::Viewport &viewport, SVModule module, bool restrict_strip)
+{
+    BowlModel bowl_model (stitcher->get_bowl_config (), stitch->get_width (), stitch->get_height ());
+    BowlModel::PointMap points;
+    uint32_t start_x = 0, end_x = 0;
+    CHECK_EXP (
+        bowl_model.get_viewport_map (points, view->get_width (), view->get_height (), viewport, start_x, end_x),
+        "viewport map(yaw:%.2f, pitch:%.2f, fov:%.2f) failed", viewport.yaw, viewport.pitch, viewport.fov);
+    XCAM_LOG_INFO ("viewport reads stitched columns [%d, %d)", start_x, end_x);
+
+    if (restrict_strip && end_x - start_x < stitch->get_width ()) {
+        uint32_t align = stitcher->get_alignment_x ();
+        start_x = XCAM_ALIGN_DOWN (start_x, align);
+        end_x = XCAM_MIN (XCAM_ALIGN_UP (end_x, align), XCAM_ALIGN_DOWN (stitch->get_width (), align));
+        CHECK_EXP (
+            stitcher->set_output_strip (start_x, end_x - start_x),
+            "set viewport strip [%d, %d) failed", start_x, end_x);
+    }
+
+    SmartPtr<GeoMapper> mapper = create_view_mapper (module);
+    mapper->set_output_size (view->get_width (), view->get_height ());
+    mapper->set_lookup_table (points.data (), view->get_width (), view->get_height ());
+    view->set_mapper (mapper);
+
+    return 0;
+}
+
 static XCamReturn
-remap_topview_buf (const SmartPtr<SVStream> &stitch, const SmartPtr<SVStream> &topview)
+remap_view_buf (const SmartPtr<SVStream> &stitch, const SmartPtr<SVStream> &view)
 {
-    const SmartPtr<GeoMapper> mapper = topview->get_mapper();
-    XCAM_ASSERT (mapper.ptr ());
+    if (view->is_async_io ())
+        view->get_buf ().release ();
 
-    XCamReturn ret = mapper->remap (stitch->get_buf (), topview->get_buf ());
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (view->get_topview ().ptr ()) {
+        ret = view->get_topview ()->generate (stitch->get_buf (), view->get_buf ());
+    } else {
+        const SmartPtr<GeoMapper> mapper = view->get_mapper();
+        XCAM_ASSERT (mapper.ptr ());
+        ret = mapper->remap (stitch->get_buf (), view->get_buf ());
+    }
     if (ret != XCAM_RETURN_NO_ERROR) {
-        XCAM_LOG_ERROR ("remap stitched image to topview failed.");
+        XCAM_LOG_ERROR ("remap stitched image to %s failed.", view->get_file_name ());
         return ret;
     }
 
@@ -278,22 +426,105 @@ write_image (
 
     write_in_image (ins, frame_num);
 
-    if (save_output)
+    if (save_output) {
         write_out_image (outs[IdxStitch], frame_num);
+        for (uint32_t i = IdxCount; i < outs.size (); ++i)
+            write_out_image (outs[i], frame_num);
+
+        if (outs.size () > IdxViewport && outs[IdxViewport]->get_mapper ().ptr ()) {
+            remap_view_buf (outs[IdxStitch], outs[IdxViewport]);
+            write_out_image (outs[IdxViewport], frame_num);
+        }
+    }
 
     if (save_topview) {
-        remap_topview_buf (outs[IdxStitch], outs[IdxTopView]);
+        remap_view_buf (outs[IdxStitch], outs[IdxTopView]);
         write_out_image (outs[IdxTopView], frame_num);
     }
 
     frame_num++;
 }
 
+// extra outputs follow IdxCount in outs
+static void
+get_extra_bufs (const SVStreams &outs, uint32_t pipe_depth, std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
+{
+    extra_bufs.clear ();
+    for (uint32_t i = IdxCount; i < outs.size (); ++i) {
+        if (pipe_depth > 1 || outs[i]->is_async_io ())
+            outs[i]->get_buf ().release ();
+        extra_bufs.push_back (outs[i]->get_buf ());
+    }
+}
+
+static void
+set_extra_bufs (const SVStreams &outs, const std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
+{
+    for (uint32_t i = 0; i < extra_bufs.size () && IdxCount + i < outs.size (); ++i)
+        outs[IdxCount + i]->get_buf () = extra_bufs[i];
+}
+
+static XCamReturn
+stitch_frame (
+    const SmartPtr<Stitcher> &stitcher, const VideoBufferList &in_buffers,
+    const SVStreams &outs, uint32_t pipe_depth)
+{
+    // pipelined frames and queued writes need distinct output buffers
+    if (pipe_depth > 1 || outs[IdxStitch]->is_async_io ())
+        outs[IdxStitch]->get_buf ().release ();
+
+    if (outs.size () <= IdxCount)
+        return stitcher->stitch_buffers (in_buffers, outs[IdxStitch]->get_buf ());
+
+    std::vector<SmartPtr<VideoBuffer> > extra_bufs;
+    get_extra_bufs (outs, pipe_depth, extra_bufs);
+    XCamReturn ret = stitcher->stitch_buffers (in_buffers, outs[IdxStitch]->get_buf (), extra_bufs);
+    set_extra_bufs (outs, extra_bufs);
+    return ret;
+}
+
+static XCamReturn
+flush_frame (const SmartPtr<SoftStitcher> &stitcher, const SVStreams &outs)
+{
+    if (outs.size () <= IdxCount)
+        return stitcher->flush_buffers (outs[IdxStitch]->get_buf ());
+
+    std::vector<SmartPtr<VideoBuffer> > extra_bufs;
+    get_extra_bufs (outs, 2, extra_bufs);
+    XCamReturn ret = stitcher->flush_buffers (outs[IdxStitch]->get_buf (), extra_bufs);
+    set_extra_bufs (outs, extra_bufs);
+    return ret;
+}
+
+static int
+flush_frames (
+    const SmartPtr<Stitcher> &stitcher,
+    const SVStreams &ins, const SVStreams &outs,
+    bool save_output, bool save_topview, uint32_t pipe_depth)
+{
+    if (pipe_depth <= 1)
+        return 0;
+
+    SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+    XCAM_ASSERT (soft_stitcher.ptr ());
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    while ((ret = flush_frame (soft_stitcher, outs)) == XCAM_RETURN_NO_ERROR) {
+        if (save_output || save_topview)
+            write_image (ins, outs, save_output, save_topview);
+
+        FPS_CALCULATION (surround-view, XCAM_OBJ_DUR_FRAME_NUM);
+    }
+    CHECK_EXP (ret == XCAM_RETURN_BYPASS, "flush stitched buffers failed.");
+
+    return 0;
+}
+
 static int
 single_frame (
     const SmartPtr<Stitcher> &stitcher,
     const SVStreams &ins, const SVStreams &outs,
-    bool save_output, bool save_topview, int loop)
+    bool save_output, bool save_topview, int loop, uint32_t pipe_depth)
 {
     for (uint32_t i = 0; i < ins.size (); ++i) {
         CHECK (ins[i]->rewind (), "rewind buffer from file(%s) failed", ins[i]->get_file_name ());
@@ -309,7 +540,10 @@ single_frame (
     }
 
     while (loop--) {
-        CHECK (stitcher->stitch_buffers (in_buffers, outs[IdxStitch]->get_buf ()), "stitch buffer failed.");
+        XCamReturn ret = stitch_frame (stitcher, in_buffers, outs, pipe_depth);
+        if (ret == XCAM_RETURN_BYPASS)
+            continue;
+        CHECK (ret, "stitch buffer failed.");
 
         if (save_output || save_topview)
             write_image (ins, outs, save_output, save_topview);
@@ -317,14 +551,14 @@ single_frame (
         FPS_CALCULATION (surround-view, XCAM_OBJ_DUR_FRAME_NUM);
     }
 
-    return 0;
+    return flush_frames (stitcher, ins, outs, save_output, save_topview, pipe_depth);
 }
 
 static int
 multi_frame (
     const SmartPtr<Stitcher> &stitcher,
     const SVStreams &ins, const SVStreams &outs,
-    bool save_output, bool save_topview, int loop)
+    bool save_output, bool save_topview, int loop, uint32_t pipe_depth)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
@@ -348,9 +582,10 @@ multi_frame (
             if (ret == XCAM_RETURN_BYPASS)
                 break;
 
-            CHECK (
-                stitcher->stitch_buffers (in_buffers, outs[IdxStitch]->get_buf ()),
-                "stitch buffer failed.");
+            ret = stitch_frame (stitcher, in_buffers, outs, pipe_depth);
+            if (ret == XCAM_RETURN_BYPASS)
+                continue;
+            CHECK (ret, "stitch buffer failed.");
 
             if (save_output || save_topview)
                 write_image (ins, outs, save_output, save_topview);
@@ -359,34 +594,296 @@ multi_frame (
         } while (true);
     }
 
-    return 0;
+    return flush_frames (stitcher, ins, outs, save_output, save_topview, pipe_depth);
 }
 
 static int
 run_stitcher (
     const SmartPtr<Stitcher> &stitcher,
     const SVStreams &ins, const SVStreams &outs,
-    FrameMode frame_mode, bool save_output, bool save_topview, int loop)
+    FrameMode frame_mode, bool save_output, bool save_topview, int loop, uint32_t pipe_depth)
 {
     CHECK (check_streams<SVStreams> (ins), "invalid input streams");
     CHECK (check_streams<SVStreams> (outs), "invalid output streams");
 
     int ret = -1;
     if (frame_mode == FrameSingle)
-        ret = single_frame (stitcher, ins, outs, save_output, save_topview, loop);
+        ret = single_frame (stitcher, ins, outs, save_output, save_topview, loop, pipe_depth);
     else if (frame_mode == FrameMulti)
-        ret = multi_frame (stitcher, ins, outs, save_output, save_topview, loop);
+        ret = multi_frame (stitcher, ins, outs, save_output, save_topview, loop, pipe_depth);
     else
         XCAM_LOG_ERROR ("invalid frame mode: %d", frame_mode);
 
     return ret;
 }
 
+struct BatchJob {
+    std::string        inputs[4];
+    std::string        output;
+    int64_t            size;    // bytes of input0, longer clips are scheduled first
+};
+typedef std::vector<BatchJob> BatchJobs;
+
+struct BatchConfig {
+    SVModule           module;
+    uint32_t           input_width;
+    uint32_t           input_height;
+    uint32_t           output_width;
+    uint32_t           output_height;
+    bool               save_output;
+    bool               persistent_map;
+    bool               huge_page;
+    uint32_t           async_io;
+    bool               use_mmap;
+    uint32_t           pipe_depth;
+};
+
+class BatchState
+{
+public:
+    explicit BatchState (uint32_t job_count)
+        : frames (0)
+        , failed (0)
+        , _job_count (job_count)
+        , _done_count (0)
+    {}
+
+    void job_done (bool ok, uint32_t frame_count) {
+        frames += frame_count;
+        if (!ok)
+            ++failed;
+
+        SmartLock locker (_mutex);
+        ++_done_count;
+        _cond.broadcast ();
+    }
+    void wait_all () {
+        SmartLock locker (_mutex);
+        while (_done_count < _job_count)
+            _cond.wait (_mutex);
+    }
+
+public:
+    SafeList<Stitcher>       idle;     // stitcher instances waiting for jobs
+    std::atomic<uint32_t>    frames;
+    std::atomic<uint32_t>    failed;
+
+private:
+    uint32_t                 _job_count;
+    uint32_t                 _done_count;
+    Mutex                    _mutex;
+    Cond                     _cond;
+};
+
+static int64_t
+get_time_usec ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+static bool
+batch_job_longer (const BatchJob &job0, const BatchJob &job1)
+{
+    return job0.size > job1.size;
+}
+
+// each line: input0 input1 input2 input3 output, empty lines and lines starting with '#' are skipped
+static int
+parse_batch_jobs (const char *path, BatchJobs &jobs)
+{
+    FILE *fp = fopen (path, "r");
+    CHECK_EXP (fp, "open batch job list(%s) failed", path);
+
+    char line[XCAM_TEST_MAX_STR_SIZE * 5];
+    uint32_t line_num = 0;
+    while (fgets (line, sizeof (line), fp)) {
+        ++line_num;
+
+        char *save_ptr = NULL;
+        char *token = strtok_r (line, " \t\r\n", &save_ptr);
+        if (!token || token[0] == '#')
+            continue;
+
+        BatchJob job;
+        uint32_t i = 0;
+        for (; token && i < 5; ++i, token = strtok_r (NULL, " \t\r\n", &save_ptr)) {
+            if (i < 4)
+                job.inputs[i] = token;
+            else
+                job.output = token;
+        }
+        if (i < 5 || token) {
+            XCAM_LOG_ERROR ("batch job list(%s) line %d needs 4 inputs and 1 output", path, line_num);
+            fclose (fp);
+            return -1;
+        }
+
+        struct stat st;
+        job.size = (stat (job.inputs[0].c_str (), &st) == 0) ? (int64_t)st.st_size : 0;
+        jobs.push_back (job);
+    }
+    fclose (fp);
+
+    CHECK_EXP (!jobs.empty (), "batch job list(%s) has no job", path);
+    std::stable_sort (jobs.begin (), jobs.end (), batch_job_longer);
+    return 0;
+}
+
+static int
+open_batch_streams (const BatchJob &job, const BatchConfig &config, SVStreams &ins, SVStreams &outs)
+{
+    VideoBufferInfo in_info;
+    in_info.init (V4L2_PIX_FMT_NV12, config.input_width, config.input_height);
+    for (uint32_t i = 0; i < 4; ++i) {
+        SmartPtr<SVStream> in = new SVStream (job.inputs[i].c_str ());
+        XCAM_ASSERT (in.ptr ());
+        in->set_module (config.module);
+        in->set_persistent_map (config.persistent_map);
+        in->set_huge_page (config.huge_page);
+        in->set_buf_size (config.input_width, config.input_height);
+        in->enable_async_io (config.async_io, config.use_mmap);
+        CHECK (in->create_buf_pool (in_info, 6), "create buffer pool failed");
+        CHECK (in->open_reader ("rb"), "open input file(%s) failed", in->get_file_name ());
+        ins.push_back (in);
+    }
+
+    SmartPtr<SVStream> out = new SVStream (job.output.c_str ());
+    XCAM_ASSERT (out.ptr ());
+    out->set_buf_size (config.output_width, config.output_height);
+    out->enable_async_io (config.async_io);
+    if (config.save_output) {
+        CHECK (out->estimate_file_format (), "%s: estimate file format failed", out->get_file_name ());
+        CHECK (out->open_writer ("wb"), "open output file(%s) failed", out->get_file_name ());
+    }
+    outs.push_back (out);
+
+    return 0;
+}
+
+static int
+run_batch_job (
+    const SmartPtr<Stitcher> &stitcher, const BatchJob &job, const BatchConfig &config, uint32_t &frame_count)
+{
+    SVStreams ins, outs;
+    CHECK_EXP (
+        open_batch_streams (job, config, ins, outs) == 0,
+        "batch job(%s) open streams failed", job.output.c_str ());
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    VideoBufferList in_buffers;
+    while (true) {
+        in_buffers.clear ();
+        for (uint32_t i = 0; i < ins.size (); ++i) {
+            ret = ins[i]->read_buf ();
+            if (ret == XCAM_RETURN_BYPASS)
+                break;
+            CHECK (ret, "read buffer from file(%s) failed.", ins[i]->get_file_name ());
+            in_buffers.push_back (ins[i]->get_buf ());
+        }
+        if (ret == XCAM_RETURN_BYPASS)
+            break;
+
+        ret = stitch_frame (stitcher, in_buffers, outs, config.pipe_depth);
+        if (ret == XCAM_RETURN_BYPASS)
+            continue;
+        CHECK (ret, "batch job(%s) stitch buffer failed.", job.output.c_str ());
+
+        if (config.save_output)
+            outs[IdxStitch]->write_buf ();
+        ++frame_count;
+    }
+
+    if (config.pipe_depth > 1) {
+        SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+        XCAM_ASSERT (soft_stitcher.ptr ());
+
+        while ((ret = soft_stitcher->flush_buffers (outs[IdxStitch]->get_buf ())) == XCAM_RETURN_NO_ERROR) {
+            if (config.save_output)
+                outs[IdxStitch]->write_buf ();
+            ++frame_count;
+        }
+        CHECK_EXP (ret == XCAM_RETURN_BYPASS, "batch job(%s) flush stitched buffers failed.", job.output.c_str ());
+    }
+
+    CHECK (outs[IdxStitch]->close (), "batch job(%s) close output failed", job.output.c_str ());
+    return 0;
+}
+
+class BatchWork
+    : public ThreadPool::UserData
+{
+public:
+    BatchWork (BatchState *state, const BatchJob &job, const BatchConfig &config)
+        : _state (state)
+        , _job (job)
+        , _config (config)
+    {}
+
+    virtual XCamReturn run () {
+        SmartPtr<Stitcher> stitcher = _state->idle.pop ();
+        XCAM_ASSERT (stitcher.ptr ());
+
+        uint32_t frame_count = 0;
+        int ret = run_batch_job (stitcher, _job, _config, frame_count);
+        _state->idle.push (stitcher);
+
+        XCAM_LOG_INFO ("batch job(%s) %s, %d frames", _job.output.c_str (), ret == 0 ? "done" : "failed", frame_count);
+        _state->job_done (ret == 0, frame_count);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    BatchState          *_state;
+    BatchJob             _job;
+    const BatchConfig   &_config;
+};
+
+// free instances take the next job, longest clips first.
+// GL contexts are bound to the creating thread, other modules run jobs there one by one
+static int
+run_batch (const std::vector<SmartPtr<Stitcher> > &stitchers, const BatchJobs &jobs, const BatchConfig &config)
+{
+    BatchState state (jobs.size ());
+    for (uint32_t i = 0; i < stitchers.size (); ++i)
+        state.idle.push (stitchers[i]);
+
+    int64_t start = get_time_usec ();
+    if (config.module == SVModuleSoft) {
+        SmartPtr<ThreadPool> pool = new ThreadPool ("sv-batch");
+        XCAM_ASSERT (pool.ptr ());
+        pool->set_threads (stitchers.size (), stitchers.size ());
+        CHECK (pool->start (), "start batch thread pool failed");
+
+        for (uint32_t i = 0; i < jobs.size (); ++i) {
+            XCamReturn ret = pool->queue (new BatchWork (&state, jobs[i], config));
+            CHECK_STATEMENT (ret, state.job_done (false, 0), "queue batch job(%s) failed", jobs[i].output.c_str ());
+        }
+        state.wait_all ();
+        pool->stop ();
+    } else {
+        for (uint32_t i = 0; i < jobs.size (); ++i) {
+            BatchWork work (&state, jobs[i], config);
+            work.run ();
+        }
+    }
+    int64_t elapsed = get_time_usec () - start;
+
+    uint32_t frames = state.frames;
+    double seconds = elapsed / 1000000.0;
+    printf ("batch jobs:\t\t%d done, %d failed\n", (int)jobs.size () - (int)state.failed, (int)state.failed);
+    printf ("batch throughput:\t%d frames in %.2fs, %.2f fps\n",
+            frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+
+    return state.failed ? -1 : 0;
+}
+
 static void usage(const char* arg0)
 {
     printf ("Usage:\n"
             "%s --module MODULE --input0 input.nv12 --input1 input1.nv12 --input2 input2.nv12 ...\n"
-            "\t--module            processing module, selected from: soft, gles\n"
+            "\t--module            processing module, selected from: soft, gles, vulkan\n"
             "\t--                  read calibration files from exported path $FISHEYE_CONFIG_PATH\n"
             "\t--input0            input image(NV12)\n"
             "\t--input1            input image(NV12)\n"
@@ -401,12 +898,37 @@ static void usage(const char* arg0)
             "\t--topview-h         optional, output height, default: 720\n"
             "\t--scale-mode        optional, scaling mode for geometric mapping,\n"
             "\t                    select from [singleconst/dualconst/dualcurve], default: singleconst\n"
+            "\t--blend-mode        optional, overlap blending of soft and gles modules, select from [pyramid/feather], default: pyramid\n"
             "\t--frame-mode        optional, times of buffer reading, select from [single/multi], default: multi\n"
             "\t--save              optional, save file or not, select from [true/false], default: true\n"
             "\t--save-topview      optional, save top view video, select from [true/false], default: false\n"
+            "\t--table-cache       optional, cache dewarp tables of static calibration, select from [true/false], default: false\n"
+            "\t--calib-binary      optional, binary calibration file, converted from text files if it doesn't exist\n"
+            "\t--fused-mode        optional, soft and gles modules dewarp copy areas into output directly, select from [true/false], default: false\n"
+            "\t--pipe-depth        optional, soft module frames in flight, range [1, 3], default: 1\n"
+            "\t--frame-budget      optional, soft module deadline of each frame in microseconds, 0 means none, default: 0\n"
+            "\t--persistent-map    optional, gles module keeps buffers mapped and syncs by fences, select from [true/false], default: false\n"
+            "\t--batch-dewarp      optional, gles module dewarps all cameras in one dispatch, select from [true/false], default: false\n"
+            "\t--blend-device      optional, gles module blends overlaps on GPU, CPU or the faster measured,\n"
+            "\t                    select from [gpu/cpu/auto], default: gpu\n"
+            "\t--huge-page         optional, soft module input buffers use huge pages, select from [true/false], default: false\n"
+            "\t--fm-schedule       optional, soft module feature match schedule, select from [every/interval/diff], default: every\n"
+            "\t--fm-param          optional, frame interval of interval schedule or luma diff threshold of diff schedule\n"
+            "\t--blend-reuse       optional, soft module and gles module blending on CPU reuse blended static overlaps,\n"
+            "\t                    \"interval[,threshold]\" of most frames reused in a row and tile luma diff, default: 0 no reuse\n"
+            "\t--async-io          optional, frames read ahead and written behind by I/O threads, 0 means inline, default: 0\n"
+            "\t--mmap              optional, async reader maps input files, select from [true/false], default: false\n"
+            "\t--batch             optional, job list of lines \"input0 input1 input2 input3 output\", replaces --input and --output\n"
+            "\t--instances         optional, stitcher instances running batch jobs concurrently, soft module only, default: 1\n"
+            "\t--strips            optional, output split into strips rendered by parallel soft stitchers, soft module only, default: 1\n"
+            "\t--viewport          optional, also save view of stitched output from bowl center, \"yaw,pitch,fov\" in degree,\n"
+            "\t                    soft module without strips stitches only columns the view reads\n"
+            "\t--viewport-size     optional, viewport size WxH, default: 1280x720\n"
+            "\t--extra-out         optional, extra output size WxH scaled from each stitched output, soft module only,\n"
+            "\t                    repeat for up to %d outputs\n"
             "\t--loop              optional, how many loops need to run, default: 1\n"
             "\t--help              usage\n",
-            arg0);
+            arg0, XCAM_STITCH_MAX_EXTRA_OUTPUTS);
 }
 
 int main (int argc, char *argv[])
@@ -424,10 +946,34 @@ int main (int argc, char *argv[])
     FrameMode frame_mode = FrameMulti;
     SVModule module = SVModuleNone;
     GeoMapScaleMode scale_mode = ScaleSingleConst;
+    BlendMode blend_mode = BlendModePyramid;
 
     int loop = 1;
     bool save_output = true;
     bool save_topview = false;
+    bool table_cache = false;
+    const char *calib_binary_path = NULL;
+    bool fused_mode = false;
+    uint32_t pipe_depth = 1;
+    int64_t frame_budget = 0;
+    bool persistent_map = false;
+    bool batch_dewarp = false;
+    const char *blend_device = "gpu";
+    bool huge_page = false;
+    FMSchedulePolicy fm_schedule;
+    const char *fm_param = NULL;
+    BlendReusePolicy blend_reuse;
+    uint32_t async_io = 0;
+    bool use_mmap = false;
+    const char *batch_path = NULL;
+    uint32_t instances = 1;
+    uint32_t strips = 1;
+    std::vector<Stitcher::OutputSize> extra_sizes;
+    bool has_viewport = false;
+    BowlModel::Viewport viewport;
+    uint32_t viewport_width = 1280;
+    uint32_t viewport_height = 720;
+    BatchJobs batch_jobs;
 
     const struct option long_opts[] = {
         {"module", required_argument, NULL, 'm'},
@@ -443,9 +989,30 @@ int main (int argc, char *argv[])
         {"topview-w", required_argument, NULL, 'P'},
         {"topview-h", required_argument, NULL, 'V'},
         {"scale-mode", required_argument, NULL, 'S'},
+        {"blend-mode", required_argument, NULL, 'E'},
         {"frame-mode", required_argument, NULL, 'f'},
         {"save", required_argument, NULL, 's'},
         {"save-topview", required_argument, NULL, 't'},
+        {"table-cache", required_argument, NULL, 'T'},
+        {"calib-binary", required_argument, NULL, 'c'},
+        {"fused-mode", required_argument, NULL, 'F'},
+        {"pipe-depth", required_argument, NULL, 'D'},
+        {"frame-budget", required_argument, NULL, 'u'},
+        {"persistent-map", required_argument, NULL, 'M'},
+        {"batch-dewarp", required_argument, NULL, 'B'},
+        {"blend-device", required_argument, NULL, 'Q'},
+        {"huge-page", required_argument, NULL, 'g'},
+        {"fm-schedule", required_argument, NULL, 'a'},
+        {"fm-param", required_argument, NULL, 'r'},
+        {"blend-reuse", required_argument, NULL, 'R'},
+        {"async-io", required_argument, NULL, 'A'},
+        {"mmap", required_argument, NULL, 'p'},
+        {"batch", required_argument, NULL, 'b'},
+        {"instances", required_argument, NULL, 'K'},
+        {"strips", required_argument, NULL, 'G'},
+        {"viewport", required_argument, NULL, 'y'},
+        {"viewport-size", required_argument, NULL, 'z'},
+        {"extra-out", required_argument, NULL, 'x'},
         {"loop", required_argument, NULL, 'L'},
         {"help", no_argument, NULL, 'e'},
         {NULL, 0, NULL, 0},
@@ -460,6 +1027,8 @@ int main (int argc, char *argv[])
                 module = SVModuleSoft;
             else if (!strcasecmp (optarg, "gles")) {
                 module = SVModuleGLES;
+            } else if (!strcasecmp (optarg, "vulkan")) {
+                module = SVModuleVulkan;
             } else {
                 XCAM_LOG_ERROR ("unknown module:%s", optarg);
                 usage (argv[0]);
@@ -518,6 +1087,18 @@ int main (int argc, char *argv[])
                 return -1;
             }
             break;
+        case 'E':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "pyramid"))
+                blend_mode = BlendModePyramid;
+            else if (!strcasecmp (optarg, "feather"))
+                blend_mode = BlendModeFeather;
+            else {
+                XCAM_LOG_ERROR ("BlendMode unknown mode: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
         case 'f':
             XCAM_ASSERT (optarg);
             if (!strcasecmp (optarg, "single"))
@@ -536,6 +1117,107 @@ int main (int argc, char *argv[])
         case 't':
             save_topview = (strcasecmp (optarg, "false") == 0 ? false : true);
             break;
+        case 'T':
+            table_cache = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'c':
+            calib_binary_path = optarg;
+            break;
+        case 'F':
+            fused_mode = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'D':
+            pipe_depth = atoi(optarg);
+            break;
+        case 'u':
+            frame_budget = atoll(optarg);
+            break;
+        case 'M':
+            persistent_map = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'B':
+            batch_dewarp = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'Q':
+            XCAM_ASSERT (optarg);
+            if (strcasecmp (optarg, "gpu") && strcasecmp (optarg, "cpu") && strcasecmp (optarg, "auto")) {
+                XCAM_LOG_ERROR ("unknown blend device: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            blend_device = optarg;
+            break;
+        case 'g':
+            huge_page = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'a':
+            XCAM_ASSERT (optarg);
+            if (!strcasecmp (optarg, "every"))
+                fm_schedule.mode = FMScheduleEveryFrame;
+            else if (!strcasecmp (optarg, "interval"))
+                fm_schedule.mode = FMScheduleInterval;
+            else if (!strcasecmp (optarg, "diff"))
+                fm_schedule.mode = FMScheduleOnDiff;
+            else {
+                XCAM_LOG_ERROR ("FeatureMatchSchedule unknown mode: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'r':
+            fm_param = optarg;
+            break;
+        case 'R':
+            XCAM_ASSERT (optarg);
+            if (sscanf (optarg, "%u,%f", &blend_reuse.refresh_interval, &blend_reuse.tile_threshold) < 1) {
+                XCAM_LOG_ERROR ("invalid blend reuse: %s", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'A':
+            async_io = atoi(optarg);
+            break;
+        case 'p':
+            use_mmap = (strcasecmp (optarg, "false") == 0 ? false : true);
+            break;
+        case 'b':
+            batch_path = optarg;
+            break;
+        case 'K':
+            instances = atoi(optarg);
+            break;
+        case 'G':
+            strips = atoi(optarg);
+            break;
+        case 'y':
+            XCAM_ASSERT (optarg);
+            if (sscanf (optarg, "%f,%f,%f", &viewport.yaw, &viewport.pitch, &viewport.fov) != 3) {
+                XCAM_LOG_ERROR ("viewport(%s) need be yaw,pitch,fov", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            has_viewport = true;
+            break;
+        case 'z':
+            XCAM_ASSERT (optarg);
+            if (sscanf (optarg, "%ux%u", &viewport_width, &viewport_height) != 2) {
+                XCAM_LOG_ERROR ("viewport size(%s) need be WxH", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            break;
+        case 'x': {
+            XCAM_ASSERT (optarg);
+            Stitcher::OutputSize size;
+            if (sscanf (optarg, "%ux%u", &size.width, &size.height) != 2) {
+                XCAM_LOG_ERROR ("extra output size(%s) need be WxH", optarg);
+                usage (argv[0]);
+                return -1;
+            }
+            extra_sizes.push_back (size);
+            break;
+        }
         case 'L':
             loop = atoi(optarg);
             break;
@@ -552,19 +1234,60 @@ int main (int argc, char *argv[])
         return -1;
     }
 
-    CHECK_EXP (ins.size () == 4, "surrond view needs 4 input streams");
-    for (uint32_t i = 0; i < ins.size (); ++i) {
-        CHECK_EXP (ins[i].ptr (), "input stream is NULL, index:%d", i);
-        CHECK_EXP (strlen (ins[i]->get_file_name ()), "input file name was not set, index:%d", i);
+    if (fm_param && fm_schedule.mode == FMScheduleInterval)
+        fm_schedule.interval = atoi (fm_param);
+    else if (fm_param && fm_schedule.mode == FMScheduleOnDiff)
+        fm_schedule.diff_threshold = atof (fm_param);
+
+    CHECK_EXP (strips >= 1, "strips(%d) must be at least 1", strips);
+    if (has_viewport) {
+        CHECK_EXP (!batch_path, "viewport is not supported by batch jobs");
+        CHECK_EXP (viewport_width > 1 && viewport_height > 1, "viewport size(%dx%d) is invalid",
+                   viewport_width, viewport_height);
+        viewport.aspect = (float)viewport_width / viewport_height;
+        printf ("viewport:\t\tyaw:%.2f pitch:%.2f fov:%.2f %dx%d\n",
+                viewport.yaw, viewport.pitch, viewport.fov, viewport_width, viewport_height);
+    }
+    if (!extra_sizes.empty ()) {
+        CHECK_EXP (module == SVModuleSoft && strips == 1, "extra outputs are only supported by soft module without strips");
+        CHECK_EXP (!batch_path, "extra outputs are not supported by batch jobs");
+        for (uint32_t i = 0; i < extra_sizes.size (); ++i)
+            printf ("extra output%d:\t\t%dx%d\n", i, extra_sizes[i].width, extra_sizes[i].height);
+    }
+    if (strips > 1) {
+        CHECK_EXP (module == SVModuleSoft, "strips are only supported by soft module");
+        CHECK_EXP (pipe_depth == 1, "strips need pipeline depth 1");
+        printf ("strips:\t\t\t%d\n", strips);
     }
 
-    CHECK_EXP (outs.size () == 1 && outs[IdxStitch].ptr (), "surrond view needs 1 output stream");
-    CHECK_EXP (strlen (outs[IdxStitch]->get_file_name ()), "output file name was not set");
+    if (batch_path) {
+        CHECK_EXP (parse_batch_jobs (batch_path, batch_jobs) == 0, "parse batch job list(%s) failed", batch_path);
+        CHECK_EXP (instances >= 1, "batch needs at least 1 stitcher instance");
+        CHECK_EXP (!save_topview, "topview is not supported in batch mode");
+        if (module != SVModuleSoft && instances > 1) {
+            XCAM_LOG_WARNING ("only soft module runs batch jobs concurrently, use 1 instance");
+            instances = 1;
+        }
 
-    for (uint32_t i = 0; i < ins.size (); ++i) {
-        printf ("input%d file:\t\t%s\n", i, ins[i]->get_file_name ());
+        printf ("batch job list:\t\t%s, %d jobs\n", batch_path, (int)batch_jobs.size ());
+        printf ("instances:\t\t%d\n", instances);
+    } else {
+        instances = 1;
+
+        CHECK_EXP (ins.size () == 4, "surrond view needs 4 input streams");
+        for (uint32_t i = 0; i < ins.size (); ++i) {
+            CHECK_EXP (ins[i].ptr (), "input stream is NULL, index:%d", i);
+            CHECK_EXP (strlen (ins[i]->get_file_name ()), "input file name was not set, index:%d", i);
+        }
+
+        CHECK_EXP (outs.size () == 1 && outs[IdxStitch].ptr (), "surrond view needs 1 output stream");
+        CHECK_EXP (strlen (outs[IdxStitch]->get_file_name ()), "output file name was not set");
+
+        for (uint32_t i = 0; i < ins.size (); ++i) {
+            printf ("input%d file:\t\t%s\n", i, ins[i]->get_file_name ());
+        }
+        printf ("output file:\t\t%s\n", outs[IdxStitch]->get_file_name ());
     }
-    printf ("output file:\t\t%s\n", outs[IdxStitch]->get_file_name ());
     printf ("input width:\t\t%d\n", input_width);
     printf ("input height:\t\t%d\n", input_height);
     printf ("output width:\t\t%d\n", output_width);
@@ -573,9 +1296,24 @@ int main (int argc, char *argv[])
     printf ("topview height:\t\t%d\n", topview_height);
     printf ("scaling mode:\t\t%s\n", (scale_mode == ScaleSingleConst) ? "singleconst" :
             ((scale_mode == ScaleDualConst) ? "dualconst" : "dualcurve"));
+    printf ("blend mode:\t\t%s\n", (blend_mode == BlendModeFeather) ? "feather" : "pyramid");
     printf ("frame mode:\t\t%s\n", (frame_mode == FrameSingle) ? "singleframe" : "multiframe");
     printf ("save output:\t\t%s\n", save_output ? "true" : "false");
     printf ("save topview:\t\t%s\n", save_topview ? "true" : "false");
+    printf ("table cache:\t\t%s\n", table_cache ? "true" : "false");
+    printf ("calib binary:\t\t%s\n", XCAM_STR (calib_binary_path));
+    printf ("fused mode:\t\t%s\n", fused_mode ? "true" : "false");
+    printf ("pipeline depth:\t\t%d\n", pipe_depth);
+    printf ("frame budget:\t\t%" PRId64 "us\n", frame_budget);
+    printf ("persistent map:\t\t%s\n", persistent_map ? "true" : "false");
+    printf ("batch dewarp:\t\t%s\n", batch_dewarp ? "true" : "false");
+    printf ("blend device:\t\t%s\n", blend_device);
+    printf ("huge page:\t\t%s\n", huge_page ? "true" : "false");
+    printf ("fm schedule:\t\t%s\n", (fm_schedule.mode == FMScheduleEveryFrame) ? "every" :
+            ((fm_schedule.mode == FMScheduleInterval) ? "interval" : "diff"));
+    printf ("blend reuse:\t\t%d, threshold:%.2f\n", blend_reuse.refresh_interval, blend_reuse.tile_threshold);
+    printf ("async io:\t\t%d\n", async_io);
+    printf ("mmap input:\t\t%s\n", use_mmap ? "true" : "false");
     printf ("loop count:\t\t%d\n", loop);
 
     if (module == SVModuleGLES) {
@@ -585,6 +1323,13 @@ int main (int argc, char *argv[])
 #endif
     }
 
+    if (module == SVModuleVulkan) {
+#if !HAVE_VULKAN
+        XCAM_LOG_ERROR ("vulkan module unsupported");
+        return -1;
+#endif
+    }
+
 #if HAVE_GLES
     SmartPtr<EGLBase> egl;
     if (module == SVModuleGLES) {
@@ -594,25 +1339,6 @@ int main (int argc, char *argv[])
     }
 #endif
 
-    VideoBufferInfo in_info;
-    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
-    for (uint32_t i = 0; i < ins.size (); ++i) {
-        ins[i]->set_module (module);
-        ins[i]->set_buf_size (input_width, input_height);
-        CHECK (ins[i]->create_buf_pool (in_info, 6), "create buffer pool failed");
-        CHECK (ins[i]->open_reader ("rb"), "open input file(%s) failed", ins[i]->get_file_name ());
-    }
-
-    outs[IdxStitch]->set_buf_size (output_width, output_height);
-    if (save_output) {
-        CHECK (outs[IdxStitch]->estimate_file_format (),
-            "%s: estimate file format failed", outs[IdxStitch]->get_file_name ());
-        CHECK (outs[IdxStitch]->open_writer ("wb"), "open output file(%s) failed", outs[IdxStitch]->get_file_name ());
-    }
-
-    SmartPtr<Stitcher> stitcher = create_stitcher (module);
-    XCAM_ASSERT (stitcher.ptr ());
-
     CameraInfo cam_info[4];
     std::string fisheye_config_path = FISHEYE_CONFIG_PATH;
     const char *env = std::getenv (FISHEYE_CONFIG_ENV_VAR);
@@ -620,9 +1346,24 @@ int main (int argc, char *argv[])
         fisheye_config_path.assign (env, strlen (env));
     XCAM_LOG_INFO ("calibration config path:%s", fisheye_config_path.c_str ());
 
-    uint32_t camera_count = ins.size ();
+    uint32_t camera_count = 4;
+    SmartPtr<CalibrationBinary> calib_binary;
+    if (calib_binary_path) {
+        calib_binary = new CalibrationBinary ();
+        if (!xcam_ret_is_ok (calib_binary->load (calib_binary_path))) {
+            CHECK_EXP (
+                convert_calibration (fisheye_config_path.c_str (), calib_binary_path, camera_count) == 0,
+                "convert calibration to binary(%s) failed", calib_binary_path);
+            CHECK (calib_binary->load (calib_binary_path), "load calibration binary(%s) failed", calib_binary_path);
+        }
+        CHECK_EXP (
+            calib_binary->get_camera_count () == camera_count,
+            "calibration binary(%s) has %d cameras, expect %d",
+            calib_binary_path, calib_binary->get_camera_count (), camera_count);
+    }
+
     for (uint32_t i = 0; i < camera_count; ++i) {
-        if (parse_camera_info (fisheye_config_path.c_str (), i, cam_info[i], camera_count) != 0) {
+        if (parse_camera_info (fisheye_config_path.c_str (), i, cam_info[i], camera_count, calib_binary.ptr ()) != 0) {
             XCAM_LOG_ERROR ("parse fisheye dewarp info(idx:%d) failed.", i);
             return -1;
         }
@@ -634,23 +1375,108 @@ int main (int argc, char *argv[])
         cam_info[2].calibration.extrinsic, cam_info[3].calibration.extrinsic,
         bowl_coord_offset);
 
-    stitcher->set_camera_num (camera_count);
-    for (uint32_t i = 0; i < camera_count; ++i) {
-        stitcher->set_camera_info (i, cam_info[i]);
+    // batch jobs share the calibration, each instance takes one job at a time
+    std::vector<SmartPtr<Stitcher> > stitchers;
+    for (uint32_t n = 0; n < instances; ++n) {
+        SmartPtr<Stitcher> stitcher;
+        if (strips > 1) {
+            stitcher = create_strip_stitcher (strips, output_width, output_height, fused_mode, frame_budget, blend_mode);
+            CHECK_EXP (stitcher.ptr (), "create strip stitcher failed");
+        } else {
+            stitcher = create_stitcher (module);
+            CHECK_EXP (stitcher->set_blend_mode (blend_mode), "blend mode is not supported by this module");
+        }
+        XCAM_ASSERT (stitcher.ptr ());
+
+        stitcher->set_camera_num (camera_count);
+        for (uint32_t i = 0; i < camera_count; ++i) {
+            stitcher->set_camera_info (i, cam_info[i]);
+        }
+
+        BowlDataConfig bowl;
+        bowl.wall_height = 3000.0f;
+        bowl.ground_length = 2000.0f;
+        bowl.angle_start = 0.0f;
+        bowl.angle_end = 360.0f;
+        stitcher->set_bowl_config (bowl);
+        stitcher->set_output_size (output_width, output_height);
+        stitcher->set_scale_mode (scale_mode);
+        stitcher->enable_table_cache (table_cache);
+        stitcher->set_calibration_binary (calib_binary);
+        CHECK_EXP (stitcher->set_fm_schedule (fm_schedule), "set feature match schedule failed");
+        if (module == SVModuleSoft && strips == 1) {
+            SmartPtr<SoftStitcher> soft_stitcher = stitcher.dynamic_cast_ptr<SoftStitcher> ();
+            soft_stitcher->enable_fused_mode (fused_mode);
+            CHECK_EXP (soft_stitcher->set_pipeline_depth (pipe_depth), "set pipeline depth(%d) failed", pipe_depth);
+            soft_stitcher->set_frame_budget (frame_budget);
+            for (uint32_t i = 0; i < extra_sizes.size (); ++i)
+                CHECK_EXP (
+                    stitcher->add_extra_output (extra_sizes[i].width, extra_sizes[i].height),
+                    "add extra output(%dx%d) failed", extra_sizes[i].width, extra_sizes[i].height);
+        } else if (strips == 1) {
+            CHECK_EXP (pipe_depth == 1, "pipeline depth is only supported by soft module");
+        }
+#if HAVE_GLES
+        if (module == SVModuleGLES) {
+            SmartPtr<GLStitcher> gl_stitcher = stitcher.dynamic_cast_ptr<GLStitcher> ();
+            XCAM_ASSERT (gl_stitcher.ptr ());
+            gl_stitcher->set_persistent_map (persistent_map);
+            gl_stitcher->enable_batch_dewarp (batch_dewarp);
+            if (!strcasecmp (blend_device, "cpu"))
+                gl_stitcher->set_blend_device (GLStitcher::BlendOnCPU);
+            else if (!strcasecmp (blend_device, "auto"))
+                gl_stitcher->set_blend_device (GLStitcher::BlendAuto);
+            gl_stitcher->enable_fused_mode (fused_mode);
+        }
+#endif
+        CHECK_EXP (stitcher->set_blend_reuse (blend_reuse), "set blend reuse failed");
+
+        stitchers.push_back (stitcher);
     }
 
-    BowlDataConfig bowl;
-    bowl.wall_height = 3000.0f;
-    bowl.ground_length = 2000.0f;
-    bowl.angle_start = 0.0f;
-    bowl.angle_end = 360.0f;
-    stitcher->set_bowl_config (bowl);
-    stitcher->set_output_size (output_width, output_height);
-    stitcher->set_scale_mode (scale_mode);
+    if (batch_path) {
+        BatchConfig config;
+        config.module = module;
+        config.input_width = input_width;
+        config.input_height = input_height;
+        config.output_width = output_width;
+        config.output_height = output_height;
+        config.save_output = save_output;
+        config.persistent_map = persistent_map;
+        config.huge_page = huge_page;
+        config.async_io = async_io;
+        config.use_mmap = use_mmap;
+        config.pipe_depth = pipe_depth;
+
+        CHECK_EXP (run_batch (stitchers, batch_jobs, config) == 0, "run batch jobs failed");
+        return 0;
+    }
+    SmartPtr<Stitcher> stitcher = stitchers[0];
+
+    VideoBufferInfo in_info;
+    in_info.init (V4L2_PIX_FMT_NV12, input_width, input_height);
+    for (uint32_t i = 0; i < ins.size (); ++i) {
+        ins[i]->set_module (module);
+        ins[i]->set_persistent_map (persistent_map);
+        ins[i]->set_huge_page (huge_page);
+        ins[i]->enable_async_io (async_io, use_mmap);
+        ins[i]->set_buf_size (input_width, input_height);
+        CHECK (ins[i]->create_buf_pool (in_info, 6), "create buffer pool failed");
+        CHECK (ins[i]->open_reader ("rb"), "open input file(%s) failed", ins[i]->get_file_name ());
+    }
+
+    outs[IdxStitch]->set_buf_size (output_width, output_height);
+    outs[IdxStitch]->enable_async_io (async_io);
+    if (save_output) {
+        CHECK (outs[IdxStitch]->estimate_file_format (),
+            "%s: estimate file format failed", outs[IdxStitch]->get_file_name ());
+        CHECK (outs[IdxStitch]->open_writer ("wb"), "open output file(%s) failed", outs[IdxStitch]->get_file_name ());
+    }
 
     if (save_topview) {
         add_stream (outs, "topview", topview_width, topview_height);
-        XCAM_ASSERT (outs.size () >= IdxCount);
+        XCAM_ASSERT (outs.size () > IdxTopView);
+        outs[IdxTopView]->enable_async_io (async_io);
 
         CHECK (outs[IdxTopView]->estimate_file_format (),
             "%s: estimate file format failed", outs[IdxTopView]->get_file_name ());
@@ -659,8 +1485,38 @@ int main (int argc, char *argv[])
         create_topview_mapper (stitcher, outs[IdxStitch], outs[IdxTopView], module);
     }
 
+    // topview and viewport slots stay unused without their options
+    if ((has_viewport || !extra_sizes.empty ()) && outs.size () < IdxViewport)
+        add_stream (outs, "topview", topview_width, topview_height);
+    if (has_viewport || !extra_sizes.empty ())
+        add_stream (outs, "viewport", viewport_width, viewport_height);
+    if (has_viewport) {
+        outs[IdxViewport]->enable_async_io (async_io);
+        if (save_output) {
+            CHECK (outs[IdxViewport]->estimate_file_format (),
+                "%s: estimate file format failed", outs[IdxViewport]->get_file_name ());
+            CHECK (outs[IdxViewport]->open_writer ("wb"), "open output file(%s) failed", outs[IdxViewport]->get_file_name ());
+        }
+        CHECK_EXP (
+            create_viewport_mapper (
+                stitcher, outs[IdxStitch], outs[IdxViewport], viewport, module,
+                module == SVModuleSoft && strips == 1 && extra_sizes.empty ()) == 0,
+            "create viewport mapper failed");
+    }
+    for (uint32_t i = 0; i < extra_sizes.size (); ++i) {
+        char name[XCAM_TEST_MAX_STR_SIZE] = {'\0'};
+        std::snprintf (name, XCAM_TEST_MAX_STR_SIZE, "extra%dx%d", extra_sizes[i].width, extra_sizes[i].height);
+        add_stream (outs, name, extra_sizes[i].width, extra_sizes[i].height);
+        SmartPtr<SVStream> &extra = outs.back ();
+        extra->enable_async_io (async_io);
+        if (save_output) {
+            CHECK (extra->estimate_file_format (), "%s: estimate file format failed", extra->get_file_name ());
+            CHECK (extra->open_writer ("wb"), "open output file(%s) failed", extra->get_file_name ());
+        }
+    }
+
     CHECK_EXP (
-        run_stitcher (stitcher, ins, outs, frame_mode, save_output, save_topview, loop) == 0,
+        run_stitcher (stitcher, ins, outs, frame_mode, save_output, save_topview, loop, pipe_depth) == 0,
         "run stitcher failed");
 
     return 0;
@@ -201,7 +201,7 @@ int main (int argc, char *argv[])
     SmartPtr<BufferPool> buf_pool = new CLVideoBufferPool ();
     XCAM_ASSERT (buf_pool.ptr ());
     buf_pool->set_video_info (input_buf_info);
-    if (!buf_pool->reserve (36)) {
+    if (!xcam_ret_is_ok (buf_pool->reserve (36))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return -1;
     }
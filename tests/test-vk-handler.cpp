@@ -73,7 +73,7 @@ VKStream::create_buf_pool (const VideoBufferInfo &info, uint32_t count)
         return XCAM_RETURN_ERROR_UNKNOWN;
     }
 
-    if (!pool->reserve (count)) {
+    if (!xcam_ret_is_ok (pool->reserve (count))) {
         XCAM_LOG_ERROR ("create buffer pool failed");
         return XCAM_RETURN_ERROR_MEM;
     }
@@ -23,6 +23,7 @@
 
 #include <buffer_pool.h>
 #include <image_file_handle.h>
+#include <image_file_stream.h>
 #if (!defined(ANDROID) && (HAVE_OPENCV))
 #include <ocl/cv_base_class.h>
 #endif
@@ -95,6 +96,16 @@ public:
     }
     XCamReturn estimate_file_format ();
 
+    // depth 0 reads and writes in caller thread, set before opening.
+    // written buffers are queued, release output buffer before producing next frame
+    void enable_async_io (uint32_t depth, bool use_mmap = false) {
+        _io_depth = depth;
+        _use_mmap = use_mmap;
+    }
+    bool is_async_io () const {
+        return _io_depth > 0;
+    }
+
     XCamReturn open_reader (const char *option);
     XCamReturn open_writer (const char *option);
     XCamReturn close ();
@@ -131,6 +142,10 @@ private:
     SmartPtr<BufferPool>     _pool;
 
     ImageFileHandle          _file;
+    SmartPtr<ImageFileReader> _file_reader;
+    SmartPtr<ImageFileWriter> _file_writer;
+    uint32_t                 _io_depth;
+    bool                     _use_mmap;
 #if XCAM_TEST_OPENCV
     cv::VideoWriter          _writer;
 #endif
@@ -141,6 +156,8 @@ Stream::Stream (const char *file_name, uint32_t width, uint32_t height)
     : _file_name (NULL)
     , _width (width)
     , _height (height)
+    , _io_depth (0)
+    , _use_mmap (false)
     , _format (FileNV12)
 {
     if (file_name)
@@ -149,7 +166,7 @@ Stream::Stream (const char *file_name, uint32_t width, uint32_t height)
 
 Stream::~Stream ()
 {
-    _file.close ();
+    close ();
 
     if (_file_name) {
         xcam_free (_file_name);
@@ -171,6 +188,18 @@ Stream::open_reader (const char *option)
         ERROR, _format == FileNV12, XCAM_RETURN_ERROR_PARAM,
         "stream(%s) only support NV12 input format", _file_name);
 
+    if (is_async_io ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, _pool.ptr (), XCAM_RETURN_ERROR_ORDER,
+            "stream(%s) async reader needs buffer pool created first", _file_name);
+
+        _file_reader = new ImageFileReader (_io_depth);
+        XCamReturn ret = _file_reader->open (_file_name, _pool, _use_mmap);
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_FILE, "stream(%s) open failed", _file_name);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
     if (_file.open (_file_name, option) != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_ERROR ("stream(%s) open failed", _file_name);
         return XCAM_RETURN_ERROR_FILE;
@@ -184,7 +213,13 @@ Stream::open_writer (const char *option)
 {
     XCAM_ASSERT (_format != FileNone);
 
-    if (_format == FileNV12) {
+    if (_format == FileNV12 && is_async_io ()) {
+        _file_writer = new ImageFileWriter (_io_depth);
+        if (_file_writer->open (_file_name, option) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_ERROR ("stream(%s) open failed", _file_name);
+            return XCAM_RETURN_ERROR_FILE;
+        }
+    } else if (_format == FileNV12) {
         if (_file.open (_file_name, option) != XCAM_RETURN_NO_ERROR) {
             XCAM_LOG_ERROR ("stream(%s) open failed", _file_name);
             return XCAM_RETURN_ERROR_FILE;
@@ -209,12 +244,26 @@ Stream::open_writer (const char *option)
 XCamReturn
 Stream::close ()
 {
-    return _file.close ();
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_file_reader.ptr ()) {
+        ret = _file_reader->close ();
+        _file_reader.release ();
+    }
+    if (_file_writer.ptr ()) {
+        ret = _file_writer->close ();
+        _file_writer.release ();
+    }
+    _file.close ();
+
+    return ret;
 }
 
 XCamReturn
 Stream::rewind ()
 {
+    if (_file_reader.ptr ())
+        return _file_reader->rewind ();
+
     return _file.rewind ();
 }
 
@@ -223,6 +272,9 @@ Stream::read_buf ()
 {
     XCAM_ASSERT (_pool.ptr ());
 
+    if (_file_reader.ptr ())
+        return _file_reader->read_buf (_buf);
+
     _buf = _pool->get_buffer (_pool);
     XCAM_ASSERT (_buf.ptr ());
 
@@ -231,7 +283,11 @@ Stream::read_buf ()
 
 XCamReturn
 Stream::write_buf (char *frame_str) {
-    if (_format == FileNV12) {
+    if (_format == FileNV12 && _file_writer.ptr ()) {
+        XCamReturn ret = _file_writer->write_buf (_buf);
+        XCAM_FAIL_RETURN (
+            ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "stream(%s) write buffer failed", _file_name);
+    } else if (_format == FileNV12) {
         _file.write_buf (_buf);
     } else if (_format == FileMP4) {
 #if XCAM_TEST_OPENCV
@@ -260,6 +316,9 @@ Stream::estimate_file_format ()
 
     if (!strcasecmp (suffix, "nv12")) {
         _format = FileNV12;
+    } else if (!strcasecmp (suffix, "yuv") || !strcasecmp (suffix, "yuyv") || !strcasecmp (suffix, "rgba")) {
+        // raw planes of any buffer format are written as NV12 files are
+        _format = FileNV12;
     } else if (!strcasecmp (suffix, "mp4")) {
 #if XCAM_TEST_OPENCV
         _format = FileMP4;
@@ -22,6 +22,15 @@
 #define GST_XCAM_UTILS_H
 
 #include "dma_video_buffer.h"
+#include "latency_stats.h"
+#include "frame_latency.h"
+#include <gst/allocators/gstdmabuf.h>
+
+#define GST_XCAM_STATS_MESSAGE_NAME "xcam-stats"
+
+#ifndef GST_CAPS_FEATURE_MEMORY_DMABUF
+#define GST_CAPS_FEATURE_MEMORY_DMABUF "memory:DMABuf"
+#endif
 
 class DmaGstBuffer
     : public XCam::DmaVideoBuffer
@@ -45,4 +54,57 @@ private:
     GstBuffer *_gst_buf;
 };
 
+/*
+ * element message "xcam-stats", latencies in microseconds,
+ * pool-used is the count of buffers out of the pool holding pool-total.
+ * each stage of @stages adds <stage>-p50, <stage>-p99 and <stage>-max, latencies from capture.
+ */
+static inline GstMessage *
+gst_xcam_stats_message_new (
+    GstElement *element, const XCam::LatencyStats &latency, guint64 dropped,
+    guint pool_used, guint pool_total, const XCam::FrameLatencyStats *stages = NULL)
+{
+    GstStructure *structure = gst_structure_new (
+        GST_XCAM_STATS_MESSAGE_NAME,
+        "frames", G_TYPE_UINT64, (guint64) latency.get_total_count (),
+        "dropped", G_TYPE_UINT64, dropped,
+        "latency-p50", G_TYPE_INT64, (gint64) latency.get_percentile (50.0),
+        "latency-p99", G_TYPE_INT64, (gint64) latency.get_percentile (99.0),
+        "latency-max", G_TYPE_INT64, (gint64) latency.get_max (),
+        "pool-used", G_TYPE_UINT, pool_used,
+        "pool-total", G_TYPE_UINT, pool_total,
+        NULL);
+
+    std::vector<XCam::FrameLatencyStats::StageLatency> stage_latency;
+    if (stages)
+        stages->get_stages (stage_latency);
+    for (uint32_t i = 0; i < stage_latency.size (); ++i) {
+        gchar *name = g_strcanon (
+            g_strdup (stage_latency[i].stage.c_str ()), G_CSET_A_2_Z G_CSET_a_2_z G_CSET_DIGITS "-_", '-');
+        gchar *p50 = g_strdup_printf ("%s-p50", name);
+        gchar *p99 = g_strdup_printf ("%s-p99", name);
+        gchar *max = g_strdup_printf ("%s-max", name);
+        gst_structure_set (
+            structure,
+            p50, G_TYPE_INT64, (gint64) stage_latency[i].p50,
+            p99, G_TYPE_INT64, (gint64) stage_latency[i].p99,
+            max, G_TYPE_INT64, (gint64) stage_latency[i].max,
+            NULL);
+        g_free (max);
+        g_free (p99);
+        g_free (p50);
+        g_free (name);
+    }
+
+    return gst_message_new_element (GST_OBJECT_CAST (element), structure);
+}
+
+// whether negotiated @caps carry memory:DMABuf feature
+static inline gboolean
+gst_xcam_caps_has_dmabuf (GstCaps *caps)
+{
+    GstCapsFeatures *features = gst_caps_get_features (caps, 0);
+    return features && gst_caps_features_contains (features, GST_CAPS_FEATURE_MEMORY_DMABUF);
+}
+
 #endif // GST_XCAM_UTILS_H
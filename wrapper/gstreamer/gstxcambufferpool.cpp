@@ -97,6 +97,8 @@ static void
 gst_xcam_buffer_pool_init (GstXCamBufferPool *pool)
 {
     pool->need_video_meta = FALSE;
+    pool->dmabuf_caps = FALSE;
+    pool->outstanding = 0;
     XCAM_CONSTRUCTOR (pool->device_manager, SmartPtr<MainDeviceManager>);
 }
 
@@ -168,12 +170,21 @@ gst_xcam_buffer_pool_acquire_buffer (
     SmartPtr<VideoBuffer> video_buf = device_manager->dequeue_buffer ();
     VideoBufferInfo video_info;
     gsize offsets[XCAM_VIDEO_MAX_COMPONENTS];
+    int dma_fd = -1;
 
     XCAM_UNUSED (params);
 
     if (!video_buf.ptr ())
         return GST_FLOW_ERROR;
 
+    // capture timestamps are monotonic, same clock as g_get_monotonic_time
+    int64_t latency = g_get_monotonic_time () - video_buf->get_timestamp ();
+    if (video_buf->get_timestamp () > 0 && latency >= 0)
+        pool->src->latency.add (latency);
+    // stamped frames leave the pipeline here
+    FrameLatencyMeta::stamp (video_buf, "output");
+    device_manager->get_frame_latency ().add (video_buf);
+
     video_info = video_buf->get_video_info ();
     for (int i = 0; i < XCAM_VIDEO_MAX_COMPONENTS; i++) {
         offsets[i] = video_info.offsets[i];
@@ -185,10 +196,16 @@ gst_xcam_buffer_pool_acquire_buffer (
     ((GstMeta *)(meta))->flags = (GstMetaFlags)(GST_META_FLAG_POOLED | GST_META_FLAG_LOCKED | GST_META_FLAG_READONLY);
     //GST_META_FLAG_SET (meta, (GST_META_FLAG_POOLED | GST_META_FLAG_LOCKED | GST_META_FLAG_READONLY));
 
-    if (GST_XCAM_SRC_MEM_MODE (pool->src) == V4L2_MEMORY_DMABUF) {
-        mem = gst_dmabuf_allocator_alloc (
-                  pool->allocator, dup (video_buf->get_fd ()), video_buf->get_size ());
-    } else if (GST_XCAM_SRC_MEM_MODE (pool->src) == V4L2_MEMORY_MMAP) {
+    // processed buffers carry fds of their own pools whatever the capture mem_type is
+    dma_fd = video_buf->get_fd ();
+    if (dma_fd >= 0 && (pool->dmabuf_caps || GST_XCAM_SRC_MEM_MODE (pool->src) == V4L2_MEMORY_DMABUF)) {
+        dma_fd = dup (dma_fd);
+        if (dma_fd >= 0)
+            mem = gst_dmabuf_allocator_alloc (pool->allocator, dma_fd, video_buf->get_size ());
+    } else if (pool->dmabuf_caps) {
+        GST_ERROR ("xcam buffer pool acquire buffer failed, memory:DMABuf negotiated but buffer has no dma-buf fd");
+    } else if (GST_XCAM_SRC_MEM_MODE (pool->src) == V4L2_MEMORY_MMAP ||
+               GST_XCAM_SRC_MEM_MODE (pool->src) == V4L2_MEMORY_DMABUF) {
         mem = gst_memory_new_wrapped (
                   (GstMemoryFlags)(GST_MEMORY_FLAG_READONLY | GST_MEMORY_FLAG_NO_SHARE),
                   video_buf->map (), video_buf->get_size (),
@@ -196,12 +213,16 @@ gst_xcam_buffer_pool_acquire_buffer (
                   NULL, NULL);
     } else {
         GST_WARNING ("xcam buffer pool acquire buffer failed since mem_type not supported");
-        return GST_FLOW_ERROR;
     }
 
-    XCAM_ASSERT (mem);
+    if (!mem) {
+        gst_buffer_unref (out_buf);
+        return GST_FLOW_ERROR;
+    }
     gst_buffer_append_memory (out_buf, mem);
-    if (pool->need_video_meta) {
+
+    // importers of dma-buf take plane layout from video meta only
+    if (pool->need_video_meta || pool->dmabuf_caps) {
         GstVideoMeta *video_meta =
             gst_buffer_add_video_meta_full (
                 out_buf, GST_VIDEO_FRAME_FLAG_NONE,
@@ -219,6 +240,7 @@ gst_xcam_buffer_pool_acquire_buffer (
 
     GST_BUFFER_TIMESTAMP (out_buf) = video_buf->get_timestamp () * 1000; //us to ns
 
+    g_atomic_int_inc (&pool->outstanding);
     *buffer = out_buf;
     return GST_FLOW_OK;
 }
@@ -226,7 +248,10 @@ gst_xcam_buffer_pool_acquire_buffer (
 static void
 gst_xcam_buffer_pool_release_buffer (GstBufferPool *base_pool, GstBuffer *buffer)
 {
-    XCAM_UNUSED (base_pool);
+    GstXCamBufferPool *pool = GST_XCAM_BUFFER_POOL (base_pool);
+    XCAM_ASSERT (pool);
+
+    g_atomic_int_add (&pool->outstanding, -1);
     gst_buffer_unref (buffer);
 }
 
@@ -252,5 +277,15 @@ gst_xcam_buffer_pool_new (GstXCamSrc *src, GstCaps *caps, SmartPtr<MainDeviceMan
     pool->src = src;
     gst_object_ref (src);
     pool->device_manager = device_manager;
+    pool->dmabuf_caps = gst_xcam_caps_has_dmabuf (caps);
+    if (pool->dmabuf_caps)
+        GST_INFO ("xcam buffer pool exports dma-buf memory");
     return GST_BUFFER_POOL (pool);
 }
+
+guint
+gst_xcam_buffer_pool_get_outstanding (GstXCamBufferPool *pool)
+{
+    XCAM_ASSERT (pool);
+    return (guint) g_atomic_int_get (&pool->outstanding);
+}
@@ -42,6 +42,9 @@ struct _GstXCamBufferPool
     GstAllocator                              *allocator;
     GstXCamSrc                                *src;
     gboolean                                   need_video_meta;
+    // memory:DMABuf negotiated, every buffer goes out as dma-buf memory with video meta
+    gboolean                                   dmabuf_caps;
+    gint                                       outstanding;
     XCam::SmartPtr<GstXCam::MainDeviceManager> device_manager;
 };
 
@@ -55,6 +58,10 @@ GType gst_xcam_buffer_pool_get_type (void);
 GstBufferPool *
 gst_xcam_buffer_pool_new (GstXCamSrc *xcamsrc, GstCaps *caps, XCam::SmartPtr<GstXCam::MainDeviceManager> &device_manager);
 
+// buffers acquired and not yet released by downstream
+guint
+gst_xcam_buffer_pool_get_outstanding (GstXCamBufferPool *pool);
+
 G_END_DECLS
 
 #endif // GST_XCAM_BUFFER_POOL_H
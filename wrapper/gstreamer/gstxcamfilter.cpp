@@ -40,10 +40,19 @@ using namespace GstXCam;
 #define DEFAULT_PROP_ENABLE_IMAGE_STITCH    FALSE
 #define DEFAULT_PROP_STITCH_ENABLE_SEAM     FALSE
 #define DEFAULT_PROP_STITCH_SCALE_MODE      CLBlenderScaleLocal
-#define DEFAULT_PROP_STITCH_FISHEYE_MAP     FALSE
+#define DEFAULT_PROP_STITCH_FISHEYE_MAP     TRUE
 #define DEFAULT_PROP_STITCH_LSC             FALSE
 #define DEFAULT_PROP_STITCH_FM_OCL          FALSE
 #define DEFAULT_PROP_STITCH_RES_MODE        StitchRes1080P
+#define DEFAULT_PROP_STATS_INTERVAL         0
+#define DEFAULT_PROP_QOS_DEGRADE            FALSE
+#define DEFAULT_PROP_SHARED_CONTEXT         NULL
+#define DEFAULT_PROP_SHARED_BATCH           1
+#define DEFAULT_PROP_SHARED_PRIORITY        0
+#define DEFAULT_PROP_SHARED_DEADLINE        0
+
+// downstream QoS proportion to resume bypassed handlers, lower than 1.0 to avoid toggling per frame
+#define QOS_RESUME_PROPORTION               0.8
 
 XCAM_BEGIN_DECLARE
 
@@ -62,7 +71,13 @@ enum {
     PROP_STITCH_FISHEYE_MAP,
     PROP_STITCH_LSC,
     PROP_STITCH_FM_OCL,
-    PROP_STITCH_RES_MODE
+    PROP_STITCH_RES_MODE,
+    PROP_STATS_INTERVAL,
+    PROP_QOS_DEGRADE,
+    PROP_SHARED_CONTEXT,
+    PROP_SHARED_BATCH,
+    PROP_SHARED_PRIORITY,
+    PROP_SHARED_DEADLINE
 };
 
 #define GST_TYPE_XCAM_FILTER_COPY_MODE (gst_xcam_filter_copy_mode_get_type ())
@@ -221,6 +236,7 @@ static gboolean gst_xcam_filter_stop (GstBaseTransform *trans);
 static void gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer);
 static GstFlowReturn gst_xcam_filter_prepare_output_buffer (GstBaseTransform * trans, GstBuffer *input, GstBuffer **outbuf);
 static GstFlowReturn gst_xcam_filter_transform (GstBaseTransform *trans, GstBuffer *inbuf, GstBuffer *outbuf);
+static gboolean gst_xcam_filter_src_event (GstBaseTransform *trans, GstEvent *event);
 
 XCAM_END_DECLARE
 
@@ -320,6 +336,48 @@ gst_xcam_filter_class_init (GstXCamFilterClass *class_self)
                            GST_TYPE_XCAM_FILTER_STITCH_RES_MODE, DEFAULT_PROP_STITCH_RES_MODE,
                            (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property (
+        gobject_class, PROP_STATS_INTERVAL,
+        g_param_spec_uint ("stats-interval", "stats interval",
+                           "Interval in ms of xcam-stats element messages, 0 disables",
+                           0, G_MAXUINT, DEFAULT_PROP_STATS_INTERVAL,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_QOS_DEGRADE,
+        g_param_spec_boolean ("qos-degrade", "qos degrade", "Bypass defog and wavelet while downstream is late",
+                              DEFAULT_PROP_QOS_DEGRADE, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SHARED_CONTEXT,
+        g_param_spec_string ("shared-context", "shared context",
+                             "Filters with the same name share one processor, settings follow the first filter; "
+                             "ignored with 3D denoise, wireframe, image warp or stitch",
+                             DEFAULT_PROP_SHARED_CONTEXT, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SHARED_BATCH,
+        g_param_spec_uint ("shared-batch", "shared batch",
+                           "Frames of different streams processed in one launch on the shared context, "
+                           "ignored with defog dcp or bayes wavelet",
+                           1, XCAM_SHARED_PIPE_MAX_BATCH, DEFAULT_PROP_SHARED_BATCH,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SHARED_PRIORITY,
+        g_param_spec_uint ("shared-priority", "shared priority",
+                           "Frames of higher priority streams go first on the shared context, e.g. preview over recording",
+                           0, G_MAXUINT, DEFAULT_PROP_SHARED_PRIORITY,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_SHARED_DEADLINE,
+        g_param_spec_uint ("shared-deadline", "shared deadline",
+                           "Latency budget in ms on the shared context, a frame waiting longer is passed on "
+                           "unprocessed and counted as dropped; 0 means no deadline",
+                           0, G_MAXUINT, DEFAULT_PROP_SHARED_DEADLINE,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
     gst_element_class_set_details_simple (element_class,
                                           "Libxcam Filter",
                                           "Filter/Effect/Video",
@@ -338,6 +396,7 @@ gst_xcam_filter_class_init (GstXCamFilterClass *class_self)
     basetrans_class->before_transform = GST_DEBUG_FUNCPTR (gst_xcam_filter_before_transform);
     basetrans_class->prepare_output_buffer = GST_DEBUG_FUNCPTR (gst_xcam_filter_prepare_output_buffer);
     basetrans_class->transform = GST_DEBUG_FUNCPTR (gst_xcam_filter_transform);
+    basetrans_class->src_event = GST_DEBUG_FUNCPTR (gst_xcam_filter_src_event);
 }
 
 static void
@@ -362,10 +421,23 @@ gst_xcam_filter_init (GstXCamFilter *xcamfilter)
     xcamfilter->delay_buf_num = DEFAULT_DELAY_BUFFER_NUM;
     xcamfilter->cached_buf_num = 0;
 
+    xcamfilter->stats_interval = DEFAULT_PROP_STATS_INTERVAL;
+    xcamfilter->qos_degrade = DEFAULT_PROP_QOS_DEGRADE;
+    xcamfilter->shared_context = g_strdup (DEFAULT_PROP_SHARED_CONTEXT);
+    xcamfilter->shared_stream_id = 0;
+    xcamfilter->shared_batch = DEFAULT_PROP_SHARED_BATCH;
+    xcamfilter->shared_priority = DEFAULT_PROP_SHARED_PRIORITY;
+    xcamfilter->shared_deadline = DEFAULT_PROP_SHARED_DEADLINE;
+    xcamfilter->last_stats_time = 0;
+    xcamfilter->dropped_num = 0;
+    XCAM_CONSTRUCTOR (xcamfilter->latency, LatencyStats);
+    XCAM_CONSTRUCTOR (xcamfilter->push_times, std::queue<int64_t>);
+
     XCAM_CONSTRUCTOR (xcamfilter->pipe_manager, SmartPtr<MainPipeManager>);
     SmartPtr<MainPipeManager> pipe_manager = new MainPipeManager;
     XCAM_ASSERT (pipe_manager.ptr ());
     xcamfilter->pipe_manager = pipe_manager;
+    XCAM_CONSTRUCTOR (xcamfilter->shared_pipe, SmartPtr<SharedPipeManager>);
 }
 
 static void
@@ -378,6 +450,12 @@ gst_xcam_filter_finalize (GObject *object)
 
     xcamfilter->pipe_manager.release ();
     XCAM_DESTRUCTOR (xcamfilter->pipe_manager, SmartPtr<MainPipeManager>);
+    xcamfilter->shared_pipe.release ();
+    XCAM_DESTRUCTOR (xcamfilter->shared_pipe, SmartPtr<SharedPipeManager>);
+    g_free (xcamfilter->shared_context);
+    XCAM_DESTRUCTOR (xcamfilter->latency, LatencyStats);
+    typedef std::queue<int64_t> TimeQueue;
+    XCAM_DESTRUCTOR (xcamfilter->push_times, TimeQueue);
 
     G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -432,6 +510,25 @@ gst_xcam_filter_set_property (GObject *object, guint prop_id, const GValue *valu
     case PROP_STITCH_RES_MODE:
         xcamfilter->stitch_res_mode = (StitchResMode) g_value_get_enum (value);
         break;
+    case PROP_STATS_INTERVAL:
+        xcamfilter->stats_interval = g_value_get_uint (value);
+        break;
+    case PROP_QOS_DEGRADE:
+        xcamfilter->qos_degrade = g_value_get_boolean (value);
+        break;
+    case PROP_SHARED_CONTEXT:
+        g_free (xcamfilter->shared_context);
+        xcamfilter->shared_context = g_value_dup_string (value);
+        break;
+    case PROP_SHARED_BATCH:
+        xcamfilter->shared_batch = g_value_get_uint (value);
+        break;
+    case PROP_SHARED_PRIORITY:
+        xcamfilter->shared_priority = g_value_get_uint (value);
+        break;
+    case PROP_SHARED_DEADLINE:
+        xcamfilter->shared_deadline = g_value_get_uint (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -488,16 +585,64 @@ gst_xcam_filter_get_property (GObject *object, guint prop_id, GValue *value, GPa
     case PROP_STITCH_RES_MODE:
         g_value_set_enum (value, xcamfilter->stitch_res_mode);
         break;
+    case PROP_STATS_INTERVAL:
+        g_value_set_uint (value, xcamfilter->stats_interval);
+        break;
+    case PROP_QOS_DEGRADE:
+        g_value_set_boolean (value, xcamfilter->qos_degrade);
+        break;
+    case PROP_SHARED_CONTEXT:
+        g_value_set_string (value, xcamfilter->shared_context);
+        break;
+    case PROP_SHARED_BATCH:
+        g_value_set_uint (value, xcamfilter->shared_batch);
+        break;
+    case PROP_SHARED_PRIORITY:
+        g_value_set_uint (value, xcamfilter->shared_priority);
+        break;
+    case PROP_SHARED_DEADLINE:
+        g_value_set_uint (value, xcamfilter->shared_deadline);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
     }
 }
 
+// handlers keeping state across frames or fed by smart analysis can't be shared by streams
+static bool
+gst_xcam_filter_can_share (GstXCamFilter *xcamfilter)
+{
+    if (!xcamfilter->shared_context || !xcamfilter->shared_context[0])
+        return false;
+
+    if (xcamfilter->denoise_3d_mode != DENOISE_3D_NONE || xcamfilter->enable_wireframe ||
+            xcamfilter->enable_image_warp || xcamfilter->enable_stitch) {
+        XCAM_LOG_WARNING (
+            "xcamfilter shared-context(%s) ignored, 3D denoise, wireframe, image warp and stitch need own processor",
+            xcamfilter->shared_context);
+        return false;
+    }
+
+    return true;
+}
+
+static SmartPtr<CLPostImageProcessor>
+gst_xcam_filter_get_image_processor (GstXCamFilter *xcamfilter)
+{
+    if (xcamfilter->shared_pipe.ptr ())
+        return xcamfilter->shared_pipe->get_image_processor ();
+
+    SmartPtr<MainPipeManager> pipe_manager = xcamfilter->pipe_manager;
+    XCAM_ASSERT (pipe_manager.ptr ());
+    return pipe_manager->get_image_processor ();
+}
+
 static gboolean
 gst_xcam_filter_start (GstBaseTransform *trans)
 {
     GstXCamFilter *xcamfilter = GST_XCAM_FILTER (trans);
+    bool shared = gst_xcam_filter_can_share (xcamfilter);
 
     if (xcamfilter->buf_count <= xcamfilter->delay_buf_num) {
         XCAM_LOG_ERROR (
@@ -507,10 +652,17 @@ gst_xcam_filter_start (GstBaseTransform *trans)
         return false;
     }
 
+    xcamfilter->latency.reset ();
+    xcamfilter->push_times = std::queue<int64_t> ();
+    xcamfilter->dropped_num = 0;
+    xcamfilter->last_stats_time = g_get_monotonic_time ();
+
     SmartPtr<MainPipeManager> pipe_manager = xcamfilter->pipe_manager;
     SmartPtr<SmartAnalyzer> smart_analyzer;
 
-    SmartHandlerList smart_handlers = SmartAnalyzerLoader::load_smart_handlers (DEFAULT_SMART_ANALYSIS_LIB_DIR);
+    SmartHandlerList smart_handlers;
+    if (!shared)
+        smart_handlers = SmartAnalyzerLoader::load_smart_handlers (DEFAULT_SMART_ANALYSIS_LIB_DIR);
     if (!smart_handlers.empty ()) {
         smart_analyzer = new SmartAnalyzer ();
         if (smart_analyzer.ptr ()) {
@@ -568,22 +720,49 @@ gst_xcam_filter_start (GstBaseTransform *trans)
         }
     }
 
-    pipe_manager->add_image_processor (image_processor);
-    pipe_manager->set_image_processor (image_processor);
+    if (shared) {
+        SharedPipeConfig config;
+        config.defog_mode = xcamfilter->defog_mode;
+        config.wavelet_mode = xcamfilter->wavelet_mode;
+        // air light and bayes noise estimation take the whole image, slots would mix
+        config.batch_size = xcamfilter->shared_batch;
+        if (config.batch_size > 1 &&
+                (xcamfilter->defog_mode == DEFOG_DCP || xcamfilter->wavelet_mode == HARR_WAVELET_BAYES)) {
+            XCAM_LOG_WARNING ("xcamfilter shared-batch ignored, defog dcp and bayes wavelet use whole-frame statistics");
+            config.batch_size = 1;
+        }
+        xcamfilter->shared_pipe = SharedPipeManager::attach (
+            xcamfilter->shared_context, config, image_processor,
+            xcamfilter->shared_priority, (int64_t) xcamfilter->shared_deadline * 1000,
+            xcamfilter->shared_stream_id);
+        if (!xcamfilter->shared_pipe.ptr ()) {
+            XCAM_LOG_ERROR ("xcamfilter attach to shared-context(%s) failed", xcamfilter->shared_context);
+            return false;
+        }
+    } else {
+        pipe_manager->add_image_processor (image_processor);
+        pipe_manager->set_image_processor (image_processor);
+    }
 
     SmartPtr<BufferPool> pool = new CLVideoBufferPool ();
     XCAM_ASSERT (pool.ptr ());
     xcamfilter->buf_pool = pool;
 
+#if !HAVE_LIBDRM
     if (xcamfilter->copy_mode == COPY_MODE_DMA) {
-        XCAM_LOG_WARNING ("CLVideoBuffer doesn't support DMA copy mode, switch to CPU copy mode");
+        XCAM_LOG_WARNING ("CLVideoBuffer can't export dma-buf without libdrm, switch to CPU copy mode");
         xcamfilter->copy_mode = COPY_MODE_CPU;
     }
+#endif
 
     if (xcamfilter->copy_mode == COPY_MODE_DMA) {
         xcamfilter->allocator = gst_dmabuf_allocator_new ();
         if (!xcamfilter->allocator) {
             GST_WARNING ("xcamfilter get allocator failed");
+            if (xcamfilter->shared_pipe.ptr ()) {
+                SharedPipeManager::detach (xcamfilter->shared_pipe, xcamfilter->shared_stream_id);
+                xcamfilter->shared_pipe.release ();
+            }
             return false;
         }
     }
@@ -604,6 +783,11 @@ gst_xcam_filter_stop (GstBaseTransform *trans)
     if (pipe_manager.ptr ())
         pipe_manager->stop ();
 
+    if (xcamfilter->shared_pipe.ptr ()) {
+        SharedPipeManager::detach (xcamfilter->shared_pipe, xcamfilter->shared_stream_id);
+        xcamfilter->shared_pipe.release ();
+    }
+
     return true;
 }
 
@@ -725,7 +909,7 @@ gst_xcam_filter_set_caps (GstBaseTransform *trans, GstCaps *incaps, GstCaps *out
     xcamfilter->gst_src_video_info = out_info;
 
     SmartPtr<MainPipeManager> pipe_manager = xcamfilter->pipe_manager;
-    SmartPtr<CLPostImageProcessor> processor = pipe_manager->get_image_processor();
+    SmartPtr<CLPostImageProcessor> processor = gst_xcam_filter_get_image_processor (xcamfilter);
     XCAM_ASSERT (pipe_manager.ptr () && processor.ptr ());
     if (!processor->set_output_format (V4L2_PIX_FMT_NV12))
         return false;
@@ -743,11 +927,6 @@ gst_xcam_filter_set_caps (GstBaseTransform *trans, GstCaps *incaps, GstCaps *out
                        GST_VIDEO_INFO_WIDTH (&out_info), GST_VIDEO_INFO_HEIGHT (&out_info));
     }
 
-    if (pipe_manager->start () != XCAM_RETURN_NO_ERROR) {
-        XCAM_LOG_ERROR ("pipe manager start failed");
-        return false;
-    }
-
     VideoBufferInfo buf_info;
     buf_info.init (
         V4L2_PIX_FMT_NV12,
@@ -756,10 +935,20 @@ gst_xcam_filter_set_caps (GstBaseTransform *trans, GstCaps *incaps, GstCaps *out
         XCAM_ALIGN_UP (GST_VIDEO_INFO_WIDTH (&in_info), 16),
         XCAM_ALIGN_UP (GST_VIDEO_INFO_HEIGHT (&in_info), 16));
 
+    if (xcamfilter->shared_pipe.ptr ()) {
+        if (xcamfilter->shared_pipe->start_stream (xcamfilter->shared_stream_id, buf_info) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_ERROR ("shared pipe start stream failed");
+            return false;
+        }
+    } else if (pipe_manager->start () != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_ERROR ("pipe manager start failed");
+        return false;
+    }
+
     SmartPtr<BufferPool> buf_pool = xcamfilter->buf_pool;
     XCAM_ASSERT (buf_pool.ptr ());
     if (!buf_pool->set_video_info (buf_info) ||
-            !buf_pool->reserve (xcamfilter->buf_count)) {
+            !xcam_ret_is_ok (buf_pool->reserve (xcamfilter->buf_count))) {
         XCAM_LOG_ERROR ("init buffer pool failed");
         return false;
     }
@@ -853,10 +1042,21 @@ append_xcambuf_to_gstbuf (GstAllocator *allocator, SmartPtr<VideoBuffer> xcambuf
         offsets [i] = xcaminfo.offsets [i];
     }
 
+    int fd = xcambuf->get_fd ();
+    if (fd < 0) {
+        XCAM_LOG_ERROR ("xcamfilter export dma-buf failed");
+        return GST_FLOW_ERROR;
+    }
+
     GstBuffer *tmpbuf = gst_buffer_new ();
-    GstMemory *mem = gst_dmabuf_allocator_alloc (allocator, dup (xcambuf->get_fd ()), xcambuf->get_size ());
+    GstMemory *mem = gst_dmabuf_allocator_alloc (allocator, dup (fd), xcambuf->get_size ());
     XCAM_ASSERT (mem);
 
+    // same as GstXCamBufferPool, xcambuf returns to its pool only after downstream releases tmpbuf
+    GstXCamBufferMeta *meta = gst_buffer_add_xcam_buffer_meta (tmpbuf, xcambuf);
+    XCAM_ASSERT (meta);
+    XCAM_UNUSED (meta);
+
     gst_buffer_append_memory (tmpbuf, mem);
 
     gst_buffer_add_video_meta_full (
@@ -885,6 +1085,44 @@ get_dmabuf_fd (GstBuffer *buffer)
     return gst_dmabuf_memory_get_fd (mem);
 }
 
+// zero-copy import only if upstream memory has exactly the layout of xcam buffers
+static bool
+is_dmabuf_importable (const GstVideoInfo &gstinfo, GstBuffer *buffer, const VideoBufferInfo &xcaminfo)
+{
+    if (gst_buffer_n_memory (buffer) != 1)
+        return false;
+
+    GstVideoMeta *video_meta = gst_buffer_get_video_meta (buffer);
+    uint32_t planes = video_meta ? video_meta->n_planes : GST_VIDEO_INFO_N_PLANES (&gstinfo);
+    if (planes != xcaminfo.components)
+        return false;
+
+    for (uint32_t i = 0; i < planes; ++i) {
+        gsize offset = video_meta ? video_meta->offset[i] : GST_VIDEO_INFO_PLANE_OFFSET (&gstinfo, i);
+        gint stride = video_meta ? video_meta->stride[i] : GST_VIDEO_INFO_PLANE_STRIDE (&gstinfo, i);
+        if (offset != xcaminfo.offsets[i] || (uint32_t)stride != xcaminfo.strides[i])
+            return false;
+    }
+
+    return gst_buffer_get_size (buffer) >= xcaminfo.size;
+}
+
+static SmartPtr<VideoBuffer>
+import_dmabuf_to_xcambuf (
+    const GstVideoInfo &gstinfo, GstBuffer *buffer, gint dma_fd, const SmartPtr<BufferPool> &buf_pool)
+{
+    const VideoBufferInfo &info = buf_pool->get_video_info ();
+    if (!is_dmabuf_importable (gstinfo, buffer, info)) {
+        XCAM_LOG_DEBUG ("xcamfilter dma-buf layout mismatch, fall back to copy");
+        return NULL;
+    }
+
+    SmartPtr<VideoBuffer> dma_buf = new DmaGstBuffer (info, dma_fd, buffer);
+    dma_buf->set_timestamp (GST_BUFFER_TIMESTAMP (buffer) / 1000); //ns to us
+
+    return CLVideoBuffer::import_dma_buffer (info, dma_buf);
+}
+
 static void
 gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer)
 {
@@ -899,37 +1137,65 @@ gst_xcam_filter_before_transform (GstBaseTransform *trans, GstBuffer *buffer)
 
     SmartPtr<VideoBuffer> video_buf;
     gint dma_fd = get_dmabuf_fd (buffer);
-    if (dma_fd >= 0) {
-#if HAVE_LIBDRM
-        SmartPtr<DrmBoBufferPool> bo_buf_pool = buf_pool.dynamic_cast_ptr<DrmBoBufferPool> ();
-        SmartPtr<DrmDisplay> display = bo_buf_pool->get_drm_display ();
-        VideoBufferInfo info = bo_buf_pool->get_video_info ();
-
-        SmartPtr<VideoBuffer> dma_buf = new DmaGstBuffer (info, dma_fd, buffer);
-        video_buf = display->convert_to_drm_bo_buf (display, dma_buf);
-#endif
-        if (!video_buf.ptr ()) {
-            XCAM_LOG_ERROR ("xcamfilter convert to drm bo buffer failed");
-            return;
-        }
-    } else {
+    if (dma_fd >= 0)
+        video_buf = import_dmabuf_to_xcambuf (xcamfilter->gst_sink_video_info, buffer, dma_fd, buf_pool);
+
+    if (!video_buf.ptr ()) {
         video_buf = buf_pool->get_buffer (buf_pool);
-        if (!buf_pool.ptr ()) {
+        if (!video_buf.ptr ()) {
             XCAM_LOG_ERROR ("xcamfilter sink-pad get buffer failed");
+            ++xcamfilter->dropped_num;
             return;
         }
 
         copy_gstbuf_to_xcambuf (xcamfilter->gst_sink_video_info, buffer, video_buf);
     }
 
-    if (pipe_manager->push_buffer (video_buf) != XCAM_RETURN_NO_ERROR) {
+    int64_t push_time = g_get_monotonic_time ();
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (xcamfilter->shared_pipe.ptr ())
+        ret = xcamfilter->shared_pipe->push_stream_buffer (xcamfilter->shared_stream_id, video_buf);
+    else
+        ret = pipe_manager->push_buffer (video_buf);
+    if (ret != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_ERROR ("xcamfilter push buffer failed");
+        ++xcamfilter->dropped_num;
         return;
     }
 
+    xcamfilter->push_times.push (push_time);
     xcamfilter->cached_buf_num++;
 }
 
+static void
+gst_xcam_filter_post_stats (GstXCamFilter *xcamfilter)
+{
+    int64_t now = g_get_monotonic_time ();
+    if (!xcamfilter->stats_interval ||
+            now - xcamfilter->last_stats_time < (int64_t) xcamfilter->stats_interval * 1000)
+        return;
+    xcamfilter->last_stats_time = now;
+
+    BufferPoolStats pool_stats;
+    SmartPtr<BufferPool> buf_pool = xcamfilter->buf_pool;
+    XCAM_ASSERT (buf_pool.ptr ());
+    buf_pool->get_stats (pool_stats);
+    uint32_t free_count = buf_pool->get_free_buffer_size ();
+    uint32_t used_count = pool_stats.allocated > free_count ? pool_stats.allocated - free_count : 0;
+
+    // frames passed on unprocessed after missing shared-deadline count as dropped
+    guint64 dropped_num = xcamfilter->dropped_num;
+    FrameScheduler::StreamStats stream_stats;
+    if (xcamfilter->shared_pipe.ptr () &&
+            xcamfilter->shared_pipe->get_stream_stats (xcamfilter->shared_stream_id, stream_stats))
+        dropped_num += stream_stats.expired;
+
+    GstMessage *msg = gst_xcam_stats_message_new (
+        GST_ELEMENT_CAST (xcamfilter), xcamfilter->latency, dropped_num,
+        used_count, pool_stats.allocated);
+    gst_element_post_message (GST_ELEMENT_CAST (xcamfilter), msg);
+}
+
 static GstFlowReturn
 gst_xcam_filter_prepare_output_buffer (GstBaseTransform *trans, GstBuffer *input, GstBuffer **outbuf)
 {
@@ -946,13 +1212,25 @@ gst_xcam_filter_prepare_output_buffer (GstBaseTransform *trans, GstBuffer *input
     if (xcamfilter->cached_buf_num <= xcamfilter->delay_buf_num)
         timeout = 0;
 
-    video_buf = pipe_manager->dequeue_buffer (timeout);
+    if (xcamfilter->shared_pipe.ptr ())
+        video_buf = xcamfilter->shared_pipe->dequeue_stream_buffer (xcamfilter->shared_stream_id, timeout);
+    else
+        video_buf = pipe_manager->dequeue_buffer (timeout);
     if (!video_buf.ptr ()) {
         XCAM_LOG_WARNING ("xcamfilter dequeue buffer failed");
+        if (timeout != 0)
+            ++xcamfilter->dropped_num;
         *outbuf = NULL;
         return GST_FLOW_OK;
     }
 
+    // pipeline keeps buffer order, the oldest push is this buffer
+    if (!xcamfilter->push_times.empty ()) {
+        xcamfilter->latency.add (g_get_monotonic_time () - xcamfilter->push_times.front ());
+        xcamfilter->push_times.pop ();
+    }
+    gst_xcam_filter_post_stats (xcamfilter);
+
     if (xcamfilter->copy_mode == COPY_MODE_CPU) {
         ret = copy_xcambuf_to_gstbuf (xcamfilter->gst_src_video_info, video_buf, outbuf);
     } else if (xcamfilter->copy_mode == COPY_MODE_DMA) {
@@ -983,6 +1261,33 @@ gst_xcam_filter_transform (GstBaseTransform *trans, GstBuffer *inbuf, GstBuffer
     return GST_FLOW_OK;
 }
 
+static gboolean
+gst_xcam_filter_src_event (GstBaseTransform *trans, GstEvent *event)
+{
+    GstXCamFilter *xcamfilter = GST_XCAM_FILTER (trans);
+
+    if (xcamfilter->qos_degrade && GST_EVENT_TYPE (event) == GST_EVENT_QOS) {
+        GstQOSType type;
+        gdouble proportion;
+        GstClockTimeDiff diff;
+        GstClockTime timestamp;
+        gst_event_parse_qos (event, &type, &proportion, &diff, &timestamp);
+
+        SmartPtr<CLPostImageProcessor> processor = gst_xcam_filter_get_image_processor (xcamfilter);
+        if (processor.ptr ()) {
+            if (!processor->is_degraded () && diff > 0) {
+                GST_INFO_OBJECT (xcamfilter, "downstream late %" G_GINT64_FORMAT "ns, bypass defog and wavelet", diff);
+                processor->set_degraded (true);
+            } else if (processor->is_degraded () && diff <= 0 && proportion < QOS_RESUME_PROPORTION) {
+                GST_INFO_OBJECT (xcamfilter, "downstream caught up, resume defog and wavelet");
+                processor->set_degraded (false);
+            }
+        }
+    }
+
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->src_event (trans, event);
+}
+
 static gboolean
 gst_xcam_filter_plugin_init (GstPlugin *xcamfilter)
 {
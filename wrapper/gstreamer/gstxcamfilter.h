@@ -25,8 +25,11 @@
 #include <gst/video/video.h>
 
 #include "main_pipe_manager.h"
+#include "shared_pipe_manager.h"
 #include "gst_xcam_utils.h"
 
+#include <queue>
+
 XCAM_BEGIN_DECLARE
 
 #define GST_TYPE_XCAM_FILTER             (gst_xcam_filter_get_type())
@@ -91,11 +94,24 @@ struct _GstXCamFilter
 
     uint32_t                                 delay_buf_num;
     uint32_t                                 cached_buf_num;
+
+    uint32_t                                 stats_interval;
+    gboolean                                 qos_degrade;
+    gchar                                   *shared_context;
+    uint32_t                                 shared_stream_id;
+    uint32_t                                 shared_batch;
+    uint32_t                                 shared_priority;
+    uint32_t                                 shared_deadline;
+    int64_t                                  last_stats_time;
+    guint64                                  dropped_num;
+    XCam::LatencyStats                       latency;
+    std::queue<int64_t>                      push_times;
     GstAllocator                            *allocator;
     GstVideoInfo                             gst_sink_video_info;
     GstVideoInfo                             gst_src_video_info;
     XCam::SmartPtr<XCam::BufferPool>         buf_pool;
     XCam::SmartPtr<GstXCam::MainPipeManager> pipe_manager;
+    XCam::SmartPtr<GstXCam::SharedPipeManager> shared_pipe;
 };
 
 struct _GstXCamFilterClass
@@ -32,11 +32,17 @@
  *  ! video/x-raw, format=NV12, width=1920, height=1080, framerate=25/1     \
  *  ! vaapiencode_h264 ! fakesink
  * ]|
+ * |[
+ * gst-launch-1.0 xcamsrc name=src imageprocessor=1 preview-factors="0.5" \
+ *  ! video/x-raw, format=NV12, width=1920, height=1080 ! fakesink          \
+ *  src.preview_0 ! videoconvert ! xvimagesink
+ * ]|
  * </refsect2>
  */
 
 #include "gstxcamsrc.h"
 #include "gstxcambufferpool.h"
+#include "gstxcambuffermeta.h"
 #if HAVE_IA_AIQ
 #include "gstxcaminterface.h"
 #include "dynamic_analyzer_loader.h"
@@ -76,6 +82,8 @@ using namespace GstXCam;
 #endif
 #define DEFAULT_PROP_ENABLE_USB         FALSE
 #define DEFAULT_PROP_BUFFERCOUNT        8
+#define DEFAULT_PROP_STATS_INTERVAL     0
+#define DEFAULT_PROP_LATENCY_STAMPS     FALSE
 #define DEFAULT_PROP_PIXELFORMAT        V4L2_PIX_FMT_NV12 //420 instead of 0
 #define DEFAULT_PROP_FIELD              V4L2_FIELD_NONE // 0
 #define DEFAULT_PROP_ANALYZER           SIMPLE_ANALYZER
@@ -92,6 +100,8 @@ using namespace GstXCam;
 #define DEFAULT_PROP_ENABLE_WIREFRAME   FALSE
 #define DEFAULT_PROP_ENABLE_IMAGE_WARP  FALSE
 #define DEFAULT_PROP_CL_PIPE_PROFILE    0
+#define DEFAULT_PROP_PROFILE_BUDGET     0
+#define DEFAULT_PREVIEW_FACTOR          0.5
 #define DEFAULT_SMART_ANALYSIS_LIB_DIR "/usr/lib/xcam/plugins/smart"
 #endif
 
@@ -109,12 +119,22 @@ using namespace GstXCam;
 
 XCAM_BEGIN_DECLARE
 
+// dma-buf caps come first, so downstream which imports dma-buf gets frames without copy
 static GstStaticPadTemplate gst_xcam_src_factory =
     GST_STATIC_PAD_TEMPLATE ("src",
                              GST_PAD_SRC,
                              GST_PAD_ALWAYS,
-                             GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_VIDEO_FORMATS_ALL)));
+                             GST_STATIC_CAPS (
+                                 GST_VIDEO_CAPS_MAKE_WITH_FEATURES (GST_CAPS_FEATURE_MEMORY_DMABUF, GST_VIDEO_FORMATS_ALL) "; "
+                                 GST_VIDEO_CAPS_MAKE (GST_VIDEO_FORMATS_ALL)));
 
+#if HAVE_LIBCL
+static GstStaticPadTemplate gst_xcam_src_preview_factory =
+    GST_STATIC_PAD_TEMPLATE ("preview_%u",
+                             GST_PAD_SRC,
+                             GST_PAD_REQUEST,
+                             GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("NV12")));
+#endif
 
 GST_DEBUG_CATEGORY (gst_xcam_src_debug);
 #define GST_CAT_DEFAULT gst_xcam_src_debug
@@ -336,6 +356,7 @@ enum {
     PROP_WDR_MODE,
     PROP_3A_ANALYZER,
     PROP_PIPE_PROFLE,
+    PROP_PROFILE_BUDGET,
     PROP_CPF,
 #if HAVE_IA_AIQ
     PROP_ENABLE_3A,
@@ -348,7 +369,10 @@ enum {
     PROP_DENOISE_3D_MODE,
     PROP_ENABLE_WIREFRAME,
     PROP_ENABLE_IMAGE_WARP,
-    PROP_FAKE_INPUT
+    PROP_FAKE_INPUT,
+    PROP_STATS_INTERVAL,
+    PROP_LATENCY_STAMPS,
+    PROP_PREVIEW_FACTORS
 };
 
 #if HAVE_IA_AIQ
@@ -375,6 +399,13 @@ static gboolean gst_xcam_src_unlock (GstBaseSrc *src);
 static gboolean gst_xcam_src_unlock_stop (GstBaseSrc *src);
 static GstFlowReturn gst_xcam_src_alloc (GstBaseSrc *src, guint64 offset, guint size, GstBuffer **buffer);
 static GstFlowReturn gst_xcam_src_fill (GstPushSrc *src, GstBuffer *out);
+#if HAVE_LIBCL
+static GstPad* gst_xcam_src_request_new_pad (
+    GstElement *element, GstPadTemplate *templ, const gchar *name, const GstCaps *caps);
+static void gst_xcam_src_release_pad (GstElement *element, GstPad *pad);
+static GstPadProbeReturn gst_xcam_src_forward_eos (GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
+static gboolean gst_xcam_src_setup_previews (GstXCamSrc *src, SmartPtr<CLPostImageProcessor> &cl_post_processor);
+#endif
 
 #if HAVE_IA_AIQ
 /* GstXCamInterface implementation */
@@ -482,6 +513,20 @@ gst_xcam_src_class_init (GstXCamSrcClass * class_self)
         g_param_spec_string ("fake-input", "fake input", "Use the specified raw file as fake input instead of live camera",
                              NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property (
+        gobject_class, PROP_STATS_INTERVAL,
+        g_param_spec_uint ("stats-interval", "stats interval",
+                           "Interval in ms of xcam-stats element messages, 0 disables",
+                           0, G_MAXUINT, DEFAULT_PROP_STATS_INTERVAL,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_LATENCY_STAMPS,
+        g_param_spec_boolean ("latency-stamps", "latency stamps",
+                              "Stamp frames where they change hands from capture to output, "
+                              "xcam-stats messages add latencies of each stage",
+                              DEFAULT_PROP_LATENCY_STAMPS, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
     g_object_class_install_property (
         gobject_class, PROP_IMAGE_PROCESSOR,
         g_param_spec_enum ("imageprocessor", "image processor", "Image Processor",
@@ -518,6 +563,14 @@ gst_xcam_src_class_init (GstXCamSrcClass * class_self)
                            GST_TYPE_XCAM_SRC_CL_PIPE_PROFILE, DEFAULT_PROP_CL_PIPE_PROFILE,
                            (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property (
+        gobject_class, PROP_PROFILE_BUDGET,
+        g_param_spec_uint ("profile-budget", "cl pipe profile budget",
+                           "Frame time budget in us, pipe steps below pipe-profile while GPU time goes over it "
+                           "and back once it drops, settable while playing; 0 disables (only for cl imageprocessor)",
+                           0, G_MAXUINT, DEFAULT_PROP_PROFILE_BUDGET,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
     g_object_class_install_property (
         gobject_class, PROP_DENOISE_3D_MODE,
         g_param_spec_enum ("denoise-3d", "3D Denoise mode", "3D Denoise mode",
@@ -551,6 +604,13 @@ gst_xcam_src_class_init (GstXCamSrcClass * class_self)
         gobject_class, PROP_ENABLE_IMAGE_WARP,
         g_param_spec_boolean ("enable-warp", "enable image warp", "Enable Image Warp",
                               DEFAULT_PROP_ENABLE_IMAGE_WARP, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property (
+        gobject_class, PROP_PREVIEW_FACTORS,
+        g_param_spec_string ("preview-factors", "preview scale factors",
+                             "Comma separated scale factors of preview_%u pads by pad index, "
+                             "e.g. \"0.5,0.25\", missing ones are 0.5",
+                             NULL, (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 #endif
 
     gst_element_class_set_details_simple (element_class,
@@ -562,6 +622,14 @@ gst_xcam_src_class_init (GstXCamSrcClass * class_self)
     gst_element_class_add_pad_template (
         element_class,
         gst_static_pad_template_get (&gst_xcam_src_factory));
+#if HAVE_LIBCL
+    gst_element_class_add_pad_template (
+        element_class,
+        gst_static_pad_template_get (&gst_xcam_src_preview_factory));
+
+    element_class->request_new_pad = GST_DEBUG_FUNCPTR (gst_xcam_src_request_new_pad);
+    element_class->release_pad = GST_DEBUG_FUNCPTR (gst_xcam_src_release_pad);
+#endif
 
     basesrc_class->get_caps = GST_DEBUG_FUNCPTR (gst_xcam_src_get_caps);
     basesrc_class->set_caps = GST_DEBUG_FUNCPTR (gst_xcam_src_set_caps);
@@ -597,12 +665,21 @@ gst_xcam_src_init (GstXCamSrc *xcamsrc)
 
 #if HAVE_LIBCL
     xcamsrc->cl_pipe_profile = DEFAULT_PROP_CL_PIPE_PROFILE;
+    xcamsrc->profile_budget = DEFAULT_PROP_PROFILE_BUDGET;
     xcamsrc->wdr_mode_type = DEFAULT_PROP_WDR_MODE;
     xcamsrc->wavelet_mode = NONE_WAVELET;
     xcamsrc->defog_mode = DEFAULT_PROP_DEFOG_MODE;
     xcamsrc->denoise_3d_mode = DEFAULT_PROP_3D_DENOISE_MODE;
     xcamsrc->denoise_3d_ref_count = 2;
     xcamsrc->enable_wireframe = DEFAULT_PROP_ENABLE_WIREFRAME;
+    xcamsrc->preview_factors = NULL;
+    for (guint i = 0; i < GST_XCAM_SRC_MAX_PREVIEWS; ++i) {
+        xcamsrc->preview_pads[i] = NULL;
+        xcamsrc->preview_negotiated[i] = FALSE;
+    }
+    gst_pad_add_probe (
+        GST_BASE_SRC_PAD (xcamsrc), GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        gst_xcam_src_forward_eos, xcamsrc, NULL);
 #endif
 
     xcamsrc->path_to_fake = NULL;
@@ -610,7 +687,12 @@ gst_xcam_src_init (GstXCamSrc *xcamsrc)
     xcamsrc->time_offset = -1;
     xcamsrc->buf_mark = 0;
     xcamsrc->duration = 0;
+    xcamsrc->stats_interval = DEFAULT_PROP_STATS_INTERVAL;
+    xcamsrc->latency_stamps = DEFAULT_PROP_LATENCY_STAMPS;
+    xcamsrc->last_stats_time = 0;
+    XCAM_CONSTRUCTOR (xcamsrc->latency, LatencyStats);
     xcamsrc->mem_type = DEFAULT_PROP_MEM_MODE;
+    xcamsrc->dmabuf_caps = FALSE;
     xcamsrc->field = DEFAULT_PROP_FIELD;
 
     xcamsrc->in_format = 0;
@@ -647,6 +729,11 @@ gst_xcam_src_finalize (GObject * object)
 
     xcamsrc->device_manager.release ();
     XCAM_DESTRUCTOR (xcamsrc->device_manager, SmartPtr<MainDeviceManager>);
+    XCAM_DESTRUCTOR (xcamsrc->latency, LatencyStats);
+#if HAVE_LIBCL
+    if (xcamsrc->preview_factors)
+        xcam_free (xcamsrc->preview_factors);
+#endif
 
     G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -685,6 +772,12 @@ gst_xcam_src_get_property (
     case PROP_FAKE_INPUT:
         g_value_set_string (value, src->path_to_fake);
         break;
+    case PROP_STATS_INTERVAL:
+        g_value_set_uint (value, src->stats_interval);
+        break;
+    case PROP_LATENCY_STAMPS:
+        g_value_set_boolean (value, src->latency_stamps);
+        break;
     case PROP_IMAGE_PROCESSOR:
         g_value_set_enum (value, src->image_processor_type);
         break;
@@ -708,6 +801,9 @@ gst_xcam_src_get_property (
     case PROP_PIPE_PROFLE:
         g_value_set_enum (value, src->cl_pipe_profile);
         break;
+    case PROP_PROFILE_BUDGET:
+        g_value_set_uint (value, src->profile_budget);
+        break;
     case PROP_DENOISE_3D_MODE:
         g_value_set_enum (value, src->denoise_3d_mode);
         break;
@@ -726,6 +822,9 @@ gst_xcam_src_get_property (
     case PROP_ENABLE_IMAGE_WARP:
         g_value_set_boolean (value, src->enable_image_warp);
         break;
+    case PROP_PREVIEW_FACTORS:
+        g_value_set_string (value, src->preview_factors);
+        break;
 #endif
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -787,6 +886,12 @@ gst_xcam_src_set_property (
             src->path_to_fake = strndup (raw_path, XCAM_MAX_STR_SIZE);
         break;
     }
+    case PROP_STATS_INTERVAL:
+        src->stats_interval = g_value_get_uint (value);
+        break;
+    case PROP_LATENCY_STAMPS:
+        src->latency_stamps = g_value_get_boolean (value);
+        break;
     case PROP_IMAGE_PROCESSOR:
         src->image_processor_type = (ImageProcessorType)g_value_get_enum (value);
         if (src->image_processor_type == ISP_IMAGE_PROCESSOR) {
@@ -836,6 +941,15 @@ gst_xcam_src_set_property (
     case PROP_PIPE_PROFLE:
         src->cl_pipe_profile = g_value_get_enum (value);
         break;
+    case PROP_PROFILE_BUDGET: {
+        src->profile_budget = g_value_get_uint (value);
+        SmartPtr<CL3aImageProcessor> cl_processor;
+        if (src->device_manager.ptr ())
+            cl_processor = src->device_manager->get_cl_image_processor ();
+        if (cl_processor.ptr ())
+            cl_processor->set_profile_budget (src->profile_budget);
+        break;
+    }
     case PROP_DENOISE_3D_MODE:
         src->denoise_3d_mode = (Denoise3DModeType) g_value_get_enum (value);
         break;
@@ -854,6 +968,15 @@ gst_xcam_src_set_property (
     case PROP_ENABLE_IMAGE_WARP:
         src->enable_image_warp = g_value_get_boolean (value);
         break;
+    case PROP_PREVIEW_FACTORS: {
+        const char *factors = g_value_get_string (value);
+        if (src->preview_factors)
+            xcam_free (src->preview_factors);
+        src->preview_factors = NULL;
+        if (factors)
+            src->preview_factors = strndup (factors, XCAM_MAX_STR_SIZE);
+        break;
+    }
 #endif
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -918,6 +1041,10 @@ gst_xcam_src_start (GstBaseSrc *src)
 #endif
     SmartPtr<V4l2Device> capture_device;
     SmartPtr<V4l2SubDevice> event_device;
+
+    xcamsrc->latency.reset ();
+    xcamsrc->last_stats_time = g_get_monotonic_time ();
+    device_manager->set_latency_stamps (xcamsrc->latency_stamps);
     SmartPtr<PollThread> poll_thread;
 
     // Check device
@@ -1000,6 +1127,7 @@ gst_xcam_src_start (GstBaseSrc *src)
         }
 
         cl_processor->set_profile ((CL3aImageProcessor::PipelineProfile)xcamsrc->cl_pipe_profile);
+        cl_processor->set_profile_budget (xcamsrc->profile_budget);
         device_manager->add_image_processor (cl_processor);
         device_manager->set_cl_image_processor (cl_processor);
         break;
@@ -1048,6 +1176,9 @@ gst_xcam_src_start (GstBaseSrc *src)
 
     device_manager->add_image_processor (cl_post_processor);
     device_manager->set_cl_post_image_processor (cl_post_processor);
+
+    if (!gst_xcam_src_setup_previews (xcamsrc, cl_post_processor))
+        return FALSE;
 #endif
 
     switch (xcamsrc->analyzer_type) {
@@ -1128,7 +1259,8 @@ gst_xcam_src_start (GstBaseSrc *src)
     }
 
     if (smart_analyzer.ptr ()) {
-        if (cl_post_processor.ptr () && xcamsrc->enable_wireframe) {
+        // previews set the scaler factors already, wire frame follows the first one
+        if (cl_post_processor.ptr () && xcamsrc->enable_wireframe && !device_manager->get_preview_count ()) {
             cl_post_processor->set_scaler (true);
             cl_post_processor->set_scaler_factor (640.0 / DEFAULT_VIDEO_WIDTH);
         }
@@ -1142,6 +1274,10 @@ gst_xcam_src_start (GstBaseSrc *src)
 
     if (xcamsrc->enable_usb) {
         poll_thread = new PollThread ();
+#if HAVE_LIBJPEG
+        if (xcamsrc->in_format == V4L2_PIX_FMT_MJPEG)
+            poll_thread->set_mjpeg_decoder (new MjpegDecoder ("xcamsrc-mjpeg"));
+#endif
     } else if (xcamsrc->path_to_fake) {
         poll_thread = new FakePollThread (xcamsrc->path_to_fake);
     }
@@ -1174,6 +1310,11 @@ gst_xcam_src_stop (GstBaseSrc *src)
         event_device->close ();
 
     device_manager->pause_dequeue ();
+#if HAVE_LIBCL
+    device_manager->clear_preview_buffers ();
+    for (guint i = 0; i < GST_XCAM_SRC_MAX_PREVIEWS; ++i)
+        xcamsrc->preview_negotiated[i] = FALSE;
+#endif
     return TRUE;
 }
 
@@ -1260,9 +1401,13 @@ gst_xcam_src_set_caps (GstBaseSrc *src, GstCaps *caps)
 #endif
 
     xcamsrc->out_format = out_format;
+    xcamsrc->dmabuf_caps = gst_xcam_caps_has_dmabuf (caps);
 
     SmartPtr<MainDeviceManager> device_manager = xcamsrc->device_manager;
     SmartPtr<V4l2Device> capture_device = device_manager->get_capture_device ();
+    // MMAP buffers reaching downstream without processing need exported fds
+    if (xcamsrc->dmabuf_caps && xcamsrc->mem_type == V4L2_MEMORY_MMAP)
+        capture_device->set_dma_export (true);
     capture_device->set_framerate (GST_VIDEO_INFO_FPS_N (&info), GST_VIDEO_INFO_FPS_D (&info));
     capture_device->set_format (
         GST_VIDEO_INFO_WIDTH (&info),
@@ -1277,20 +1422,30 @@ gst_xcam_src_set_caps (GstBaseSrc *src, GstCaps *caps)
     capture_device->get_format (format);
     xcamsrc->gst_video_info = info;
     size_t offset = 0;
-    for (uint32_t n = 0; n < GST_VIDEO_INFO_N_PLANES (&xcamsrc->gst_video_info); n++) {
-        GST_VIDEO_INFO_PLANE_OFFSET (&xcamsrc->gst_video_info, n) = offset;
-        if (out_format == V4L2_PIX_FMT_NV12) {
-            GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline * 2 / 3;
+    if (format.fmt.pix.pixelformat == V4L2_PIX_FMT_MJPEG) {
+        // decoded into NV12 buffers of MjpegDecoder
+        VideoBufferInfo decoded_info;
+        decoded_info.init (V4L2_PIX_FMT_NV12, format.fmt.pix.width, format.fmt.pix.height);
+        for (uint32_t n = 0; n < GST_VIDEO_INFO_N_PLANES (&xcamsrc->gst_video_info); n++) {
+            GST_VIDEO_INFO_PLANE_OFFSET (&xcamsrc->gst_video_info, n) = decoded_info.offsets[n];
+            GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = decoded_info.strides[n];
         }
-        else if (format.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV) {
-            // for 4:2:2 format, stride is widthx2
-            GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline;
-        }
-        else {
-            GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline / 2;
+    } else {
+        for (uint32_t n = 0; n < GST_VIDEO_INFO_N_PLANES (&xcamsrc->gst_video_info); n++) {
+            GST_VIDEO_INFO_PLANE_OFFSET (&xcamsrc->gst_video_info, n) = offset;
+            if (out_format == V4L2_PIX_FMT_NV12) {
+                GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline * 2 / 3;
+            }
+            else if (format.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV) {
+                // for 4:2:2 format, stride is widthx2
+                GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline;
+            }
+            else {
+                GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) = format.fmt.pix.bytesperline / 2;
+            }
+            offset += GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) * format.fmt.pix.height;
+            //TODO, need set offsets
         }
-        offset += GST_VIDEO_INFO_PLANE_STRIDE (&xcamsrc->gst_video_info, n) * format.fmt.pix.height;
-        //TODO, need set offsets
     }
 
     // TODO, need calculate aligned width/height
@@ -1350,24 +1505,36 @@ gst_xcam_src_alloc (GstBaseSrc *src, guint64 offset, guint size, GstBuffer **buf
     return ret;
 }
 
-static GstFlowReturn
-gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
+static void
+gst_xcam_src_post_stats (GstXCamSrc *src)
 {
-    GstXCamSrc *src = GST_XCAM_SRC_CAST (basesrc);
-
-    GST_BUFFER_OFFSET (buf) = src->buf_mark;
-    GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET (buf) + 1;
-    ++src->buf_mark;
+    int64_t now = g_get_monotonic_time ();
+    if (!src->stats_interval || now - src->last_stats_time < (int64_t) src->stats_interval * 1000)
+        return;
+    src->last_stats_time = now;
+
+    guint pool_used = 0;
+    if (src->pool)
+        pool_used = gst_xcam_buffer_pool_get_outstanding (GST_XCAM_BUFFER_POOL (src->pool));
+
+    GstMessage *msg = gst_xcam_stats_message_new (
+        GST_ELEMENT_CAST (src), src->latency, src->device_manager->get_dropped_count (),
+        pool_used, src->buf_count, src->latency_stamps ? &src->device_manager->get_frame_latency () : NULL);
+    gst_element_post_message (GST_ELEMENT_CAST (src), msg);
+}
 
+static void
+gst_xcam_src_apply_time_offset (GstXCamSrc *src, GstBuffer *buf)
+{
     if (!GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (buf)))
-        return GST_FLOW_OK;
+        return;
 
     if (!src->time_offset_ready) {
         GstClock *clock = GST_ELEMENT_CLOCK (src);
         GstClockTime actual_time = 0;
 
         if (!clock)
-            return GST_FLOW_OK;
+            return;
 
         actual_time = gst_clock_get_time (clock) - GST_ELEMENT_CAST (src)->base_time;
         src->time_offset = actual_time - GST_BUFFER_TIMESTAMP (buf);
@@ -1379,9 +1546,280 @@ gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
     //GST_BUFFER_DURATION (buf) = src->duration;
 
     XCAM_STATIC_FPS_CALCULATION (gstxcamsrc, XCAM_OBJ_DUR_FRAME_NUM);
+}
+
+#if HAVE_LIBCL
+static gboolean
+gst_xcam_src_setup_previews (GstXCamSrc *src, SmartPtr<CLPostImageProcessor> &cl_post_processor)
+{
+    SmartPtr<MainDeviceManager> device_manager = src->device_manager;
+    double factors[GST_XCAM_SRC_MAX_PREVIEWS];
+    gchar **tokens = NULL;
+    guint token_count = 0;
+    guint count = 0;
+
+    // slots below the last requested pad are all scaled, so pad indexes keep their factors
+    GST_OBJECT_LOCK (src);
+    for (guint i = 0; i < GST_XCAM_SRC_MAX_PREVIEWS; ++i) {
+        if (src->preview_pads[i])
+            count = i + 1;
+    }
+    GST_OBJECT_UNLOCK (src);
+
+    device_manager->set_preview_count (count);
+    if (!count)
+        return TRUE;
+
+    if (src->preview_factors) {
+        tokens = g_strsplit (src->preview_factors, ",", -1);
+        token_count = g_strv_length (tokens);
+    }
+    for (guint i = 0; i < count; ++i) {
+        factors[i] = (i < token_count) ? g_ascii_strtod (tokens[i], NULL) : DEFAULT_PREVIEW_FACTOR;
+        if (factors[i] <= 0.0 || factors[i] > 1.0) {
+            XCAM_LOG_ERROR ("xcamsrc preview factor(%s) of preview_%d out of (0, 1]", tokens[i], i);
+            g_strfreev (tokens);
+            return FALSE;
+        }
+    }
+    g_strfreev (tokens);
+
+    cl_post_processor->set_scaler (true);
+    cl_post_processor->set_scaler_factor (factors[0]);
+    // sampler scaler has one output only
+    if (count > 1)
+        cl_post_processor->set_scaler_filter (CL_IMAGE_SCALER_FILTER_BILINEAR);
+    for (guint i = 1; i < count; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, cl_post_processor->add_scaler_factor (factors[i]), FALSE,
+            "xcamsrc add scaler factor of preview_%d failed", i);
+    }
+
+    XCAM_LOG_INFO ("xcamsrc scales %d preview(s) in cl post processor", count);
+    return TRUE;
+}
+
+static GstPad *
+gst_xcam_src_get_preview_pad (GstXCamSrc *src, guint index)
+{
+    GstPad *pad = NULL;
+
+    GST_OBJECT_LOCK (src);
+    if (src->preview_pads[index])
+        pad = GST_PAD_CAST (gst_object_ref (src->preview_pads[index]));
+    GST_OBJECT_UNLOCK (src);
+    return pad;
+}
+
+static gboolean
+gst_xcam_src_negotiate_preview (GstXCamSrc *src, GstPad *pad, const VideoBufferInfo &info)
+{
+    GstVideoInfo video_info;
+    GstCaps *caps = NULL;
+    gchar *stream_id = NULL;
+    gboolean ret = FALSE;
+
+    stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT_CAST (src), GST_PAD_NAME (pad));
+    gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    gst_video_info_init (&video_info);
+    gst_video_info_set_format (&video_info, GST_VIDEO_FORMAT_NV12, info.width, info.height);
+    GST_VIDEO_INFO_FPS_N (&video_info) = GST_VIDEO_INFO_FPS_N (&src->gst_video_info);
+    GST_VIDEO_INFO_FPS_D (&video_info) = GST_VIDEO_INFO_FPS_D (&src->gst_video_info);
+    caps = gst_video_info_to_caps (&video_info);
+    ret = gst_pad_push_event (pad, gst_event_new_caps (caps));
+    gst_caps_unref (caps);
+    if (!ret) {
+        GST_WARNING_OBJECT (pad, "preview caps %dx%d not accepted", info.width, info.height);
+        return FALSE;
+    }
+
+    gst_pad_push_event (pad, gst_event_new_segment (&GST_BASE_SRC_CAST (src)->segment));
+    return TRUE;
+}
+
+// scaled buffers stay in the pools of scaler outputs until downstream frees them
+static GstBuffer *
+gst_xcam_src_wrap_preview (const SmartPtr<VideoBuffer> &video_buf)
+{
+    const VideoBufferInfo &video_info = video_buf->get_video_info ();
+    gsize offsets[XCAM_VIDEO_MAX_COMPONENTS];
+    GstXCamBufferMeta *meta = NULL;
+    GstBuffer *out_buf = NULL;
+
+    uint8_t *data = video_buf->map ();
+    XCAM_FAIL_RETURN (WARNING, data, NULL, "xcamsrc map preview buffer failed");
+
+    out_buf = gst_buffer_new ();
+    meta = gst_buffer_add_xcam_buffer_meta (out_buf, video_buf);
+    XCAM_ASSERT (meta);
+    ((GstMeta *)(meta))->flags = (GstMetaFlags)(GST_META_FLAG_LOCKED | GST_META_FLAG_READONLY);
+
+    gst_buffer_append_memory (
+        out_buf,
+        gst_memory_new_wrapped (
+            (GstMemoryFlags)(GST_MEMORY_FLAG_READONLY | GST_MEMORY_FLAG_NO_SHARE),
+            data, video_buf->get_size (),
+            video_info.offsets[0], video_info.size,
+            NULL, NULL));
+
+    for (int i = 0; i < XCAM_VIDEO_MAX_COMPONENTS; i++) {
+        offsets[i] = video_info.offsets[i];
+    }
+    gst_buffer_add_video_meta_full (
+        out_buf, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_NV12,
+        video_info.width, video_info.height, video_info.components,
+        offsets, (gint*)(video_info.strides));
+
+    GST_BUFFER_TIMESTAMP (out_buf) = video_buf->get_timestamp () * 1000; //us to ns
+    return out_buf;
+}
+
+// previews of a frame are queued before the frame leaves post processor, push them along with it
+static void
+gst_xcam_src_push_previews (GstXCamSrc *src)
+{
+    SmartPtr<MainDeviceManager> device_manager = src->device_manager;
+    uint32_t count = device_manager->get_preview_count ();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        GstPad *pad = gst_xcam_src_get_preview_pad (src, i);
+
+        while (true) {
+            SmartPtr<VideoBuffer> video_buf = device_manager->dequeue_preview_buffer (i);
+            if (!video_buf.ptr ())
+                break;
+            if (!pad)
+                continue;
+
+            if (!src->preview_negotiated[i]) {
+                src->preview_negotiated[i] = gst_xcam_src_negotiate_preview (src, pad, video_buf->get_video_info ());
+                if (!src->preview_negotiated[i])
+                    continue;
+            }
+
+            GstBuffer *out_buf = gst_xcam_src_wrap_preview (video_buf);
+            if (!out_buf)
+                continue;
+            GST_BUFFER_OFFSET (out_buf) = src->buf_mark;
+            GST_BUFFER_OFFSET_END (out_buf) = src->buf_mark + 1;
+            if (src->time_offset_ready)
+                GST_BUFFER_TIMESTAMP (out_buf) += src->time_offset;
+
+            GstFlowReturn ret = gst_pad_push (pad, out_buf);
+            if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)
+                GST_DEBUG_OBJECT (pad, "push preview buffer failed, %s", gst_flow_get_name (ret));
+        }
+
+        if (pad)
+            gst_object_unref (pad);
+    }
+}
+#endif
+
+static GstFlowReturn
+gst_xcam_src_fill (GstPushSrc *basesrc, GstBuffer *buf)
+{
+    GstXCamSrc *src = GST_XCAM_SRC_CAST (basesrc);
+
+    gst_xcam_src_post_stats (src);
+
+    GST_BUFFER_OFFSET (buf) = src->buf_mark;
+    GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET (buf) + 1;
+
+    gst_xcam_src_apply_time_offset (src, buf);
+#if HAVE_LIBCL
+    gst_xcam_src_push_previews (src);
+#endif
+
+    ++src->buf_mark;
     return GST_FLOW_OK;
 }
 
+#if HAVE_LIBCL
+static GstPad *
+gst_xcam_src_request_new_pad (
+    GstElement *element, GstPadTemplate *templ, const gchar *name, const GstCaps *caps)
+{
+    GstXCamSrc *xcamsrc = GST_XCAM_SRC (element);
+    guint index = GST_XCAM_SRC_MAX_PREVIEWS;
+    gchar pad_name[32];
+    GstPad *pad = NULL;
+
+    XCAM_UNUSED (caps);
+
+    // scaler outputs are fixed once post processor starts
+    if (GST_STATE (element) > GST_STATE_READY) {
+        GST_WARNING_OBJECT (element, "preview pads need be requested before PAUSED");
+        return NULL;
+    }
+
+    GST_OBJECT_LOCK (xcamsrc);
+    if (name && sscanf (name, "preview_%u", &index) == 1) {
+        if (index >= GST_XCAM_SRC_MAX_PREVIEWS || xcamsrc->preview_pads[index])
+            index = GST_XCAM_SRC_MAX_PREVIEWS;
+    } else {
+        for (index = 0; index < GST_XCAM_SRC_MAX_PREVIEWS; ++index) {
+            if (!xcamsrc->preview_pads[index])
+                break;
+        }
+    }
+    if (index >= GST_XCAM_SRC_MAX_PREVIEWS) {
+        GST_OBJECT_UNLOCK (xcamsrc);
+        GST_WARNING_OBJECT (
+            element, "request pad(%s) failed, max %d preview pads", XCAM_STR (name), GST_XCAM_SRC_MAX_PREVIEWS);
+        return NULL;
+    }
+
+    snprintf (pad_name, sizeof (pad_name), "preview_%u", index);
+    pad = gst_pad_new_from_template (templ, pad_name);
+    gst_pad_use_fixed_caps (pad);
+    xcamsrc->preview_pads[index] = pad;
+    xcamsrc->preview_negotiated[index] = FALSE;
+    GST_OBJECT_UNLOCK (xcamsrc);
+
+    gst_element_add_pad (element, pad);
+    return pad;
+}
+
+static void
+gst_xcam_src_release_pad (GstElement *element, GstPad *pad)
+{
+    GstXCamSrc *xcamsrc = GST_XCAM_SRC (element);
+
+    GST_OBJECT_LOCK (xcamsrc);
+    for (guint i = 0; i < GST_XCAM_SRC_MAX_PREVIEWS; ++i) {
+        if (xcamsrc->preview_pads[i] == pad)
+            xcamsrc->preview_pads[i] = NULL;
+    }
+    GST_OBJECT_UNLOCK (xcamsrc);
+
+    gst_element_remove_pad (element, pad);
+}
+
+// main pad ends the previews too, or their sinks never finish
+static GstPadProbeReturn
+gst_xcam_src_forward_eos (GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    GstXCamSrc *xcamsrc = GST_XCAM_SRC_CAST (user_data);
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    XCAM_UNUSED (pad);
+    if (GST_EVENT_TYPE (event) != GST_EVENT_EOS)
+        return GST_PAD_PROBE_OK;
+
+    for (guint i = 0; i < GST_XCAM_SRC_MAX_PREVIEWS; ++i) {
+        GstPad *preview = gst_xcam_src_get_preview_pad (xcamsrc, i);
+        if (!preview)
+            continue;
+        gst_pad_push_event (preview, gst_event_new_eos ());
+        gst_object_unref (preview);
+    }
+    return GST_PAD_PROBE_OK;
+}
+#endif
+
 #if HAVE_IA_AIQ
 static gboolean
 gst_xcam_src_set_white_balance_mode (GstXCam3A *xcam3a, XCamAwbMode mode)
@@ -23,6 +23,7 @@
 #define GST_XCAM_SRC_H
 
 #include "main_dev_manager.h"
+#include "gst_xcam_utils.h"
 #include <gst/base/gstpushsrc.h>
 
 XCAM_BEGIN_DECLARE
@@ -38,6 +39,9 @@ XCAM_BEGIN_DECLARE
 #define GST_XCAM_SRC_BUF_COUNT(src) ((GST_XCAM_SRC_CAST(src))->buf_count)
 #define GST_XCAM_SRC_OUT_VIDEO_INFO(src) (&(GST_XCAM_SRC_CAST(src))->gst_video_info)
 
+// request pads of scaled previews, scaled by the cl post processor run of main frames
+#define GST_XCAM_SRC_MAX_PREVIEWS 3
+
 
 typedef enum {
     ISP_IMAGE_PROCESSOR = 0,
@@ -107,7 +111,13 @@ struct _GstXCamSrc
     int64_t                      buf_mark;
     GstClockTime                 duration;
 
+    uint32_t                     stats_interval;
+    gboolean                     latency_stamps;
+    int64_t                      last_stats_time;
+    XCam::LatencyStats           latency;
+
     enum v4l2_memory             mem_type;
+    gboolean                     dmabuf_caps;
     enum v4l2_field              field;
     uint32_t                     in_format;
     uint32_t                     out_format;
@@ -117,7 +127,12 @@ struct _GstXCamSrc
     WDRModeType                  wdr_mode_type;
     AnalyzerType                 analyzer_type;
     int32_t                      cl_pipe_profile;
+    uint32_t                     profile_budget;
     WaveletModeType              wavelet_mode;
+    char                        *preview_factors;
+    GstPad                      *preview_pads[GST_XCAM_SRC_MAX_PREVIEWS];
+    gboolean                     preview_negotiated[GST_XCAM_SRC_MAX_PREVIEWS];
+    guint                        preview_count;
     XCam::SmartPtr<GstXCam::MainDeviceManager>  device_manager;
 };
 
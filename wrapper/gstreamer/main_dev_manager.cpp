@@ -21,11 +21,17 @@
 
 #include "main_dev_manager.h"
 
+// unconsumed previews must not hold all buffers of scaler pools
+#define PREVIEW_MAX_QUEUED_BUFFERS 2
+
 using namespace XCam;
 
 namespace GstXCam {
 
 MainDeviceManager::MainDeviceManager()
+#if HAVE_LIBCL
+    : _preview_count (0)
+#endif
 {
 }
 
@@ -66,4 +72,56 @@ MainDeviceManager::resume_dequeue ()
     return _ready_buffers.resume_pop ();
 }
 
+#if HAVE_LIBCL
+bool
+MainDeviceManager::set_preview_count (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, count <= XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS, false,
+        "main device manager set preview count(%d) failed, max %d",
+        count, XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS);
+
+    clear_preview_buffers ();
+    _preview_count = count;
+    return true;
+}
+
+XCamReturn
+MainDeviceManager::scaled_image_ready (const SmartPtr<VideoBuffer> &buffer)
+{
+    XCAM_ASSERT (buffer.ptr ());
+
+    uint32_t index = 0;
+    SmartPtr<CLScalerOutputMeta> meta = buffer->find_typed_metadata<CLScalerOutputMeta> ();
+    if (meta.ptr ())
+        index = meta->index;
+
+    if (index < _preview_count) {
+        SafeList<VideoBuffer> &previews = _preview_buffers[index];
+        previews.push (buffer);
+        while (previews.size () > PREVIEW_MAX_QUEUED_BUFFERS)
+            previews.pop (0);
+    }
+
+    // smart analyzer takes the first output only
+    if (index)
+        return XCAM_RETURN_NO_ERROR;
+    return DeviceManager::scaled_image_ready (buffer);
+}
+
+SmartPtr<VideoBuffer>
+MainDeviceManager::dequeue_preview_buffer (uint32_t index)
+{
+    XCAM_ASSERT (index < _preview_count);
+    return _preview_buffers[index].pop (0);
+}
+
+void
+MainDeviceManager::clear_preview_buffers ()
+{
+    for (uint32_t i = 0; i < XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS; ++i)
+        _preview_buffers[i].clear ();
+}
+#endif
+
 };
@@ -84,17 +84,32 @@ public:
     XCam::SmartPtr<XCam::CLPostImageProcessor> &get_cl_post_image_processor () {
         return _cl_post_image_processor;
     }
+
+    // scaled outputs 0 to @count - 1 of post processor are queued for previews, others go to
+    // smart analyzer only, need be called before start
+    bool set_preview_count (uint32_t count);
+    uint32_t get_preview_count () const {
+        return _preview_count;
+    }
+    // oldest queued scaled buffer of preview @index, NULL if none, never waits
+    XCam::SmartPtr<XCam::VideoBuffer> dequeue_preview_buffer (uint32_t index);
+    void clear_preview_buffers ();
 #endif
 
 protected:
     virtual void handle_message (const XCam::SmartPtr<XCam::XCamMessage> &msg);
     virtual void handle_buffer (const XCam::SmartPtr<XCam::VideoBuffer> &buf);
+#if HAVE_LIBCL
+    virtual XCamReturn scaled_image_ready (const XCam::SmartPtr<XCam::VideoBuffer> &buffer);
+#endif
 
 private:
     XCam::SafeList<XCam::VideoBuffer>         _ready_buffers;
 #if HAVE_LIBCL
     XCam::SmartPtr<XCam::CL3aImageProcessor>   _cl_image_processor;
     XCam::SmartPtr<XCam::CLPostImageProcessor> _cl_post_image_processor;
+    XCam::SafeList<XCam::VideoBuffer>          _preview_buffers[XCAM_CL_IMAGE_SCALER_MAX_OUTPUTS];
+    uint32_t                                   _preview_count;
 #endif
 };
 
@@ -0,0 +1,585 @@
+/*
+ * shared_pipe_manager.cpp - one image processor shared by streams of several filters
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "shared_pipe_manager.h"
+#include <ocl/cl_device.h>
+#include <ocl/cl_video_buffer.h>
+
+// dispatcher wakes up to check stopping
+#define XCAM_SHARED_PIPE_WAIT_TIMEOUT 100000 // us
+#define XCAM_SHARED_PIPE_NO_STREAM ((uint32_t)-1)
+
+using namespace XCam;
+
+namespace GstXCam {
+
+typedef std::map<std::string, SmartPtr<SharedPipeManager> > SharedPipeMap;
+
+static Mutex          shared_pipes_mutex;
+static SharedPipeMap  shared_pipes;
+
+// attached to input buffer, handlers copy attaches from input to output
+class SharedStreamTag
+    : public VideoBuffer
+{
+public:
+    explicit SharedStreamTag (uint32_t stream_id)
+        : VideoBuffer (VideoBufferInfo ())
+        , _stream_id (stream_id)
+    {}
+
+    uint32_t get_stream_id () const {
+        return _stream_id;
+    }
+
+    virtual uint8_t *map () {
+        return NULL;
+    }
+    virtual bool unmap () {
+        return false;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    uint32_t    _stream_id;
+};
+
+// attached to a batch buffer, stream and timestamp of each slot
+class SharedBatchTag
+    : public VideoBuffer
+{
+public:
+    struct Slot {
+        uint32_t    stream_id;
+        int64_t     timestamp;
+        bool        valid;
+    };
+
+    explicit SharedBatchTag ()
+        : VideoBuffer (VideoBufferInfo ())
+    {}
+
+    void add_slot (uint32_t stream_id, int64_t timestamp, bool valid) {
+        Slot slot = {stream_id, timestamp, valid};
+        _slots.push_back (slot);
+    }
+    const std::vector<Slot> &get_slots () const {
+        return _slots;
+    }
+
+    virtual uint8_t *map () {
+        return NULL;
+    }
+    virtual bool unmap () {
+        return false;
+    }
+    virtual int get_fd () {
+        return -1;
+    }
+
+private:
+    std::vector<Slot>    _slots;
+};
+
+static int64_t
+get_dispatch_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+class SharedPipeDispatcher
+    : public Thread
+{
+public:
+    explicit SharedPipeDispatcher (SharedPipeManager *manager)
+        : Thread ("SharedPipeDispatcher")
+        , _manager (manager)
+    {}
+
+protected:
+    virtual bool loop () {
+        XCamReturn ret = _manager->dispatch ();
+        return (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_ERROR_TIMEOUT);
+    }
+
+private:
+    SharedPipeManager   *_manager;
+};
+
+SharedPipeManager::SharedPipeManager (const char *name, const SharedPipeConfig &config)
+    : _name (name)
+    , _config (config)
+    , _batch_deadline (0)
+    , _scheduler (XCAM_SHARED_PIPE_STREAM_INFLIGHT)
+{
+    XCAM_LOG_DEBUG ("SharedPipeManager(%s) construction", get_name ());
+}
+
+SharedPipeManager::~SharedPipeManager ()
+{
+    stop_pipe ();
+    XCAM_LOG_DEBUG ("SharedPipeManager(%s) destruction", get_name ());
+}
+
+SmartPtr<SharedPipeManager>
+SharedPipeManager::attach (
+    const char *name, const SharedPipeConfig &config,
+    const SmartPtr<CLPostImageProcessor> &processor,
+    uint32_t priority, int64_t budget, uint32_t &stream_id)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, name && name[0] && processor.ptr (), NULL,
+        "shared pipe attach failed, invalid name or processor");
+
+    SmartLock registry_locker (shared_pipes_mutex);
+    SmartPtr<SharedPipeManager> manager;
+    SharedPipeMap::iterator i_pipe = shared_pipes.find (name);
+    if (i_pipe == shared_pipes.end ()) {
+        manager = new SharedPipeManager (name, config);
+        processor->keep_attached_buf (true);
+        manager->_image_processor = processor;
+        manager->add_image_processor (processor);
+        shared_pipes[name] = manager;
+        XCAM_LOG_INFO ("shared pipe(%s) created", name);
+    } else {
+        manager = i_pipe->second;
+        XCAM_FAIL_RETURN (
+            ERROR, manager->_config == config, NULL,
+            "shared pipe(%s) attach failed, stream settings differ from the first stream", name);
+    }
+
+    SmartLock locker (manager->_mutex);
+    stream_id = manager->_scheduler.add_stream (priority, budget);
+    manager->_streams[stream_id] = new Stream;
+    XCAM_LOG_INFO (
+        "shared pipe(%s) stream:%d attached with priority:%d budget:%" PRId64 "us, %d streams",
+        name, stream_id, priority, budget, (uint32_t)manager->_streams.size ());
+
+    return manager;
+}
+
+void
+SharedPipeManager::detach (const SmartPtr<SharedPipeManager> &manager, uint32_t stream_id)
+{
+    XCAM_ASSERT (manager.ptr ());
+
+    SmartLock registry_locker (shared_pipes_mutex);
+    bool last_stream = false;
+    {
+        SmartLock locker (manager->_mutex);
+        StreamMap::iterator i_stream = manager->_streams.find (stream_id);
+        if (i_stream == manager->_streams.end ())
+            return;
+
+        // wake up the filter if it's still waiting for output
+        i_stream->second->ready.pause_pop ();
+        manager->_streams.erase (i_stream);
+        last_stream = manager->_streams.empty ();
+    }
+    manager->_scheduler.remove_stream (stream_id);
+
+    XCAM_LOG_INFO ("shared pipe(%s) stream:%d detached", manager->get_name (), stream_id);
+    if (!last_stream)
+        return;
+
+    manager->stop_pipe ();
+    shared_pipes.erase (manager->_name);
+    XCAM_LOG_INFO ("shared pipe(%s) released", manager->get_name ());
+}
+
+SmartPtr<SharedPipeManager::Stream>
+SharedPipeManager::get_stream (uint32_t stream_id)
+{
+    SmartLock locker (_mutex);
+    StreamMap::iterator i_stream = _streams.find (stream_id);
+    if (i_stream == _streams.end ())
+        return NULL;
+    return i_stream->second;
+}
+
+XCamReturn
+SharedPipeManager::start_stream (uint32_t stream_id, const VideoBufferInfo &info)
+{
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _streams.find (stream_id) != _streams.end (), XCAM_RETURN_ERROR_PARAM,
+        "shared pipe(%s) start stream:%d failed, not attached", get_name (), stream_id);
+
+    if (is_running ()) {
+        XCAM_FAIL_RETURN (
+            ERROR,
+            info.width == _frame_info.width && info.height == _frame_info.height &&
+            info.aligned_width == _frame_info.aligned_width && info.aligned_height == _frame_info.aligned_height,
+            XCAM_RETURN_ERROR_PARAM,
+            "shared pipe(%s) stream:%d size(%dx%d) differs from pipe size(%dx%d)",
+            get_name (), stream_id, info.width, info.height, _frame_info.width, _frame_info.height);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    if (_config.batch_size > 1) {
+        XCAM_FAIL_RETURN (
+            ERROR, info.format == V4L2_PIX_FMT_NV12 && _config.batch_size <= XCAM_SHARED_PIPE_MAX_BATCH,
+            XCAM_RETURN_ERROR_PARAM,
+            "shared pipe(%s) batch:%d needs NV12 and no more than %d slots",
+            get_name (), _config.batch_size, XCAM_SHARED_PIPE_MAX_BATCH);
+
+        uint32_t batch_height = info.aligned_height * _config.batch_size;
+        VideoBufferInfo batch_info;
+        batch_info.init (V4L2_PIX_FMT_NV12, info.width, batch_height, info.aligned_width, batch_height);
+
+        // every stream has up to XCAM_SHARED_PIPE_STREAM_INFLIGHT frames in processor
+        _batch_pool = new CLVideoBufferPool ();
+        XCAM_FAIL_RETURN (
+            ERROR,
+            _batch_pool->set_video_info (batch_info) &&
+            xcam_ret_is_ok (_batch_pool->reserve (XCAM_SHARED_PIPE_STREAM_INFLIGHT + 1)),
+            XCAM_RETURN_ERROR_MEM,
+            "shared pipe(%s) reserve batch buffers(%dx%d) failed", get_name (), info.width, batch_height);
+    }
+
+    XCamReturn ret = start ();
+    XCAM_FAIL_RETURN (
+        ERROR, ret == XCAM_RETURN_NO_ERROR, ret,
+        "shared pipe(%s) start failed", get_name ());
+
+    _dispatcher = new SharedPipeDispatcher (this);
+    if (!_dispatcher->start ()) {
+        XCAM_LOG_ERROR ("shared pipe(%s) start dispatcher failed", get_name ());
+        _dispatcher.release ();
+        stop ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    _frame_info = info;
+    XCAM_LOG_INFO (
+        "shared pipe(%s) started with size(%dx%d), batch:%d",
+        get_name (), info.width, info.height, _config.batch_size);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SharedPipeManager::stop_pipe ()
+{
+    if (_dispatcher.ptr ()) {
+        _dispatcher->emit_stop ();
+        _scheduler.wakeup ();
+        _dispatcher->stop ();
+        _dispatcher.release ();
+    }
+
+    if (is_running ())
+        stop ();
+
+    if (_batch_pool.ptr ())
+        _batch_pool->stop ();
+    if (_scatter_pool.ptr ())
+        _scatter_pool->stop ();
+}
+
+XCamReturn
+SharedPipeManager::push_stream_buffer (uint32_t stream_id, SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    XCAM_FAIL_RETURN (
+        WARNING, get_stream (stream_id).ptr () && is_running (), XCAM_RETURN_ERROR_PARAM,
+        "shared pipe(%s) push buffer failed, stream:%d not running", get_name (), stream_id);
+
+    buf->attach_buffer (SmartPtr<SharedStreamTag> (new SharedStreamTag (stream_id)));
+    XCamReturn ret = _scheduler.push (stream_id, buf);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        buf->detach_buffer (buf->find_typed_attach<SharedStreamTag> ());
+
+    return ret;
+}
+
+SmartPtr<VideoBuffer>
+SharedPipeManager::dequeue_stream_buffer (uint32_t stream_id, int32_t timeout)
+{
+    SmartPtr<Stream> stream = get_stream (stream_id);
+    if (!stream.ptr ())
+        return NULL;
+
+    return stream->ready.pop (timeout);
+}
+
+// batch waits a short while till every stream has a frame to dispatch
+bool
+SharedPipeManager::is_batch_ready ()
+{
+    uint32_t ready_count = _scheduler.get_ready_stream_count ();
+    if (_config.batch_size <= 1 || !ready_count)
+        return ready_count > 0;
+
+    uint32_t stream_count = 0;
+    {
+        SmartLock locker (_mutex);
+        stream_count = _streams.size ();
+    }
+
+    int64_t now = get_dispatch_time ();
+    if (ready_count < XCAM_MIN (stream_count, _config.batch_size)) {
+        if (!_batch_deadline)
+            _batch_deadline = now + XCAM_SHARED_PIPE_BATCH_WAIT;
+        if (now < _batch_deadline)
+            return false;
+    }
+
+    _batch_deadline = 0;
+    return true;
+}
+
+// one frame each stream, expired frames go to their streams unprocessed
+void
+SharedPipeManager::take_jobs (std::vector<FrameScheduler::Job> &jobs, uint32_t max_count)
+{
+    std::vector<uint32_t> taken;
+    FrameScheduler::Job job;
+
+    while (jobs.size () < max_count && _scheduler.pop (job, taken)) {
+        if (job.expired) {
+            XCAM_LOG_DEBUG (
+                "shared pipe(%s) stream:%d frame missed deadline, pass it on unprocessed",
+                get_name (), job.stream_id);
+            job.buf->detach_buffer (job.buf->find_typed_attach<SharedStreamTag> ());
+            deliver (job.stream_id, job.buf);
+            continue;
+        }
+
+        jobs.push_back (job);
+        taken.push_back (job.stream_id);
+    }
+}
+
+XCamReturn
+SharedPipeManager::dispatch ()
+{
+    uint64_t generation = _scheduler.get_generation ();
+    std::vector<FrameScheduler::Job> jobs;
+    if (is_batch_ready ())
+        take_jobs (jobs, _config.batch_size);
+
+    if (jobs.empty ()) {
+        _scheduler.wait_change (
+            generation, _batch_deadline ? XCAM_SHARED_PIPE_BATCH_WAIT : XCAM_SHARED_PIPE_WAIT_TIMEOUT);
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    if (_config.batch_size > 1)
+        return dispatch_batch (jobs);
+
+    SmartPtr<VideoBuffer> &buf = jobs[0].buf;
+    if (push_buffer (buf) != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("shared pipe(%s) drops a frame of stream:%d", get_name (), jobs[0].stream_id);
+        take_frame_done (buf);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SharedPipeManager::dispatch_batch (const std::vector<FrameScheduler::Job> &jobs)
+{
+    SmartPtr<SharedBatchTag> tag = new SharedBatchTag;
+    SmartPtr<VideoBuffer> batch = _batch_pool->get_buffer (_batch_pool);
+    SmartPtr<CLBuffer> batch_cl = batch.ptr () ? batch.dynamic_cast_ptr<CLBuffer> () : NULL;
+    const VideoBufferInfo &frame = _frame_info;
+    uint32_t y_size = frame.strides[0] * frame.aligned_height;
+    uint32_t uv_size = frame.strides[1] * frame.aligned_height / 2;
+
+    for (uint32_t i = 0; i < jobs.size (); ++i) {
+        const SmartPtr<VideoBuffer> &buf = jobs[i].buf;
+        uint32_t stream_id = jobs[i].stream_id;
+
+        const VideoBufferInfo &info = buf->get_video_info ();
+        SmartPtr<CLBuffer> frame_cl = buf.dynamic_cast_ptr<CLBuffer> ();
+        bool valid =
+            batch_cl.ptr () && frame_cl.ptr () &&
+            info.strides[0] == frame.strides[0] && info.aligned_height == frame.aligned_height;
+
+        if (valid) {
+            const VideoBufferInfo &batch_info = batch->get_video_info ();
+            valid =
+                frame_cl->enqueue_copy (
+                    batch_cl, info.offsets[0], batch_info.offsets[0] + i * y_size, y_size) == XCAM_RETURN_NO_ERROR &&
+                frame_cl->enqueue_copy (
+                    batch_cl, info.offsets[1], batch_info.offsets[1] + i * uv_size, uv_size) == XCAM_RETURN_NO_ERROR;
+        }
+        if (!valid) {
+            XCAM_LOG_WARNING (
+                "shared pipe(%s) drops a frame of stream:%d, packing batch failed",
+                get_name (), stream_id);
+        }
+        tag->add_slot (stream_id, buf->get_timestamp (), valid);
+    }
+
+    bool pushed = false;
+    if (batch.ptr ()) {
+        // copies run on the in-order default queue, done before handlers read the batch
+        CLDevice::instance ()->get_context ()->finish ();
+        batch->set_timestamp (jobs[0].buf->get_timestamp ());
+        batch->attach_buffer (tag);
+        pushed = (push_buffer (batch) == XCAM_RETURN_NO_ERROR);
+    }
+
+    if (!pushed) {
+        XCAM_LOG_WARNING ("shared pipe(%s) drops a batch of %d frames", get_name (), (uint32_t)jobs.size ());
+        for (uint32_t i = 0; i < jobs.size (); ++i)
+            _scheduler.done (jobs[i].stream_id);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SharedPipeManager::scatter_batch (const SmartPtr<VideoBuffer> &buf, const SmartPtr<SharedBatchTag> &tag)
+{
+    const std::vector<SharedBatchTag::Slot> &slots = tag->get_slots ();
+    const VideoBufferInfo &batch_info = buf->get_video_info ();
+    SmartPtr<CLBuffer> batch_cl = buf.dynamic_cast_ptr<CLBuffer> ();
+    uint32_t slot_height = batch_info.aligned_height / _config.batch_size;
+
+    if (!batch_cl.ptr () || batch_info.format != V4L2_PIX_FMT_NV12 ||
+            slot_height * _config.batch_size != batch_info.aligned_height) {
+        XCAM_LOG_WARNING ("shared pipe(%s) can't split batch output, drop %d frames", get_name (), (uint32_t)slots.size ());
+        return;
+    }
+
+    // only the processor notify thread comes here
+    if (!_scatter_pool.ptr ()) {
+        VideoBufferInfo out_info;
+        out_info.init (
+            V4L2_PIX_FMT_NV12, _frame_info.width, _frame_info.height, batch_info.strides[0], slot_height);
+        uint32_t count = _config.batch_size * (XCAM_SHARED_PIPE_STREAM_INFLIGHT + 1);
+        _scatter_pool = new CLVideoBufferPool ();
+        // downstream may hold outputs for a while, grow instead of stalling the processor,
+        // set before reserve so the free ring is sized for the grown count
+        _scatter_pool->set_grow_limit (count * 2);
+        if (!_scatter_pool->set_video_info (out_info) || !xcam_ret_is_ok (_scatter_pool->reserve (count))) {
+            XCAM_LOG_WARNING ("shared pipe(%s) reserve output buffers failed", get_name ());
+            _scatter_pool.release ();
+            return;
+        }
+    }
+
+    uint32_t y_size = batch_info.strides[0] * slot_height;
+    uint32_t uv_size = batch_info.strides[1] * slot_height / 2;
+    std::vector<SmartPtr<VideoBuffer> > outputs (slots.size ());
+    for (uint32_t i = 0; i < slots.size (); ++i) {
+        if (!slots[i].valid)
+            continue;
+
+        SmartPtr<VideoBuffer> out = _scatter_pool->get_buffer (_scatter_pool);
+        SmartPtr<CLBuffer> out_cl = out.ptr () ? out.dynamic_cast_ptr<CLBuffer> () : NULL;
+        if (!out_cl.ptr ()) {
+            XCAM_LOG_WARNING ("shared pipe(%s) drops a frame of stream:%d, no output buffer", get_name (), slots[i].stream_id);
+            continue;
+        }
+
+        const VideoBufferInfo &out_info = out->get_video_info ();
+        if (batch_cl->enqueue_copy (
+                    out_cl, batch_info.offsets[0] + i * y_size, out_info.offsets[0], y_size) != XCAM_RETURN_NO_ERROR ||
+                batch_cl->enqueue_copy (
+                    out_cl, batch_info.offsets[1] + i * uv_size, out_info.offsets[1], uv_size) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING ("shared pipe(%s) drops a frame of stream:%d, split batch failed", get_name (), slots[i].stream_id);
+            continue;
+        }
+
+        out->set_timestamp (slots[i].timestamp);
+        outputs[i] = out;
+    }
+
+    CLDevice::instance ()->get_context ()->finish ();
+    for (uint32_t i = 0; i < slots.size (); ++i) {
+        if (outputs[i].ptr ())
+            deliver (slots[i].stream_id, outputs[i]);
+    }
+}
+
+uint32_t
+SharedPipeManager::take_frame_done (const SmartPtr<VideoBuffer> &buf)
+{
+    SmartPtr<SharedStreamTag> tag = buf->find_typed_attach<SharedStreamTag> ();
+    XCAM_FAIL_RETURN (
+        WARNING, tag.ptr (), XCAM_SHARED_PIPE_NO_STREAM,
+        "shared pipe(%s) got a buffer without stream tag", get_name ());
+    buf->detach_buffer (tag);
+
+    uint32_t stream_id = tag->get_stream_id ();
+    _scheduler.done (stream_id);
+
+    return stream_id;
+}
+
+void
+SharedPipeManager::deliver (uint32_t stream_id, const SmartPtr<VideoBuffer> &buf)
+{
+    SmartPtr<Stream> stream = get_stream (stream_id);
+    if (!stream.ptr ()) {
+        XCAM_LOG_DEBUG ("shared pipe(%s) stream:%d gone, drop output", get_name (), stream_id);
+        return;
+    }
+
+    stream->ready.push (buf);
+}
+
+void
+SharedPipeManager::post_buffer (const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    SmartPtr<SharedBatchTag> batch_tag = buf->find_typed_attach<SharedBatchTag> ();
+    if (!batch_tag.ptr ()) {
+        deliver (take_frame_done (buf), buf);
+        return;
+    }
+
+    buf->detach_buffer (batch_tag);
+    scatter_batch (buf, batch_tag);
+
+    const std::vector<SharedBatchTag::Slot> &slots = batch_tag->get_slots ();
+    for (uint32_t i = 0; i < slots.size (); ++i)
+        _scheduler.done (slots[i].stream_id);
+}
+
+void
+SharedPipeManager::process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
+{
+    PipeManager::process_buffer_failed (processor, buf);
+    if (!buf.ptr ())
+        return;
+
+    SmartPtr<SharedBatchTag> batch_tag = buf->find_typed_attach<SharedBatchTag> ();
+    if (!batch_tag.ptr ()) {
+        take_frame_done (buf);
+        return;
+    }
+
+    buf->detach_buffer (batch_tag);
+    const std::vector<SharedBatchTag::Slot> &slots = batch_tag->get_slots ();
+    for (uint32_t i = 0; i < slots.size (); ++i)
+        _scheduler.done (slots[i].stream_id);
+}
+
+};
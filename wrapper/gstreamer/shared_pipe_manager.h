@@ -0,0 +1,160 @@
+/*
+ * shared_pipe_manager.h - one image processor shared by streams of several filters
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAMFILTER_SHARED_PIPE_MANAGER_H
+#define XCAMFILTER_SHARED_PIPE_MANAGER_H
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pipe_manager.h>
+#include <video_buffer.h>
+#include <buffer_pool.h>
+#include <safe_list.h>
+#include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <frame_scheduler.h>
+#include <ocl/cl_post_image_processor.h>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// frames of one stream in processor at the same time, others wait their turn
+#define XCAM_SHARED_PIPE_STREAM_INFLIGHT 2
+
+#define XCAM_SHARED_PIPE_MAX_BATCH 8
+// longest wait for frames of the other streams to fill a batch
+#define XCAM_SHARED_PIPE_BATCH_WAIT 2000 // us
+
+namespace GstXCam {
+
+class SharedPipeDispatcher;
+class SharedBatchTag;
+
+// settings every stream of a shared pipe must agree on
+struct SharedPipeConfig {
+    int32_t     defog_mode;
+    int32_t     wavelet_mode;
+    uint32_t    batch_size;
+
+    SharedPipeConfig () : defog_mode (0), wavelet_mode (0), batch_size (1) {}
+    bool operator == (const SharedPipeConfig &other) const {
+        return defog_mode == other.defog_mode && wavelet_mode == other.wavelet_mode &&
+               batch_size == other.batch_size;
+    }
+};
+
+/*
+ * SharedPipeManager, streams attached by the same name run through one
+ * CLPostImageProcessor, so handlers, buffer pools and cmd queues exist once.
+ * a dispatcher thread feeds pending frames to processor in FrameScheduler
+ * order: higher stream priority first, then earliest deadline. each stream
+ * keeps no more than XCAM_SHARED_PIPE_STREAM_INFLIGHT frames in processor,
+ * so a fast stream can't starve others of the same priority. a frame past
+ * its deadline goes to its stream unprocessed and counts as expired.
+ * outputs find their stream by a tag attached to the input buffer.
+ * handlers keeping state across frames (3D denoise, warp, stitch) and
+ * smart analysis must not be used on a shared pipe.
+ *
+ * batch_size > 1 stacks frames of up to batch_size streams in one tall NV12
+ * buffer, slot i holds rows [i * aligned_height, (i + 1) * aligned_height),
+ * so every handler runs one launch per batch; outputs are split back per slot.
+ * filters reading the neighbourhood see the adjacent slot instead of a clamped
+ * edge at slot borders, handlers with whole-frame statistics must not be batched.
+ */
+class SharedPipeManager
+    : public XCam::PipeManager
+{
+    friend class SharedPipeDispatcher;
+
+    struct Stream {
+        XCam::SafeList<XCam::VideoBuffer>               ready;
+    };
+    typedef std::map<uint32_t, XCam::SmartPtr<Stream> > StreamMap;
+
+public:
+    ~SharedPipeManager ();
+
+    /*
+     * the first stream of @name brings configured @processor, later ones reuse the shared one.
+     * higher @priority wins, frames are due @budget us after push, 0 means no deadline.
+     */
+    static XCam::SmartPtr<SharedPipeManager> attach (
+        const char *name, const SharedPipeConfig &config,
+        const XCam::SmartPtr<XCam::CLPostImageProcessor> &processor,
+        uint32_t priority, int64_t budget, uint32_t &stream_id);
+    // pipe stops and is dropped after its last stream detached
+    static void detach (const XCam::SmartPtr<SharedPipeManager> &manager, uint32_t stream_id);
+
+    const char *get_name () const {
+        return _name.c_str ();
+    }
+    XCam::SmartPtr<XCam::CLPostImageProcessor> &get_image_processor () {
+        return _image_processor;
+    }
+
+    // pipe starts with the first stream, all streams need the same input layout
+    XCamReturn start_stream (uint32_t stream_id, const XCam::VideoBufferInfo &info);
+    XCamReturn push_stream_buffer (uint32_t stream_id, XCam::SmartPtr<XCam::VideoBuffer> &buf);
+    XCam::SmartPtr<XCam::VideoBuffer> dequeue_stream_buffer (uint32_t stream_id, int32_t timeout);
+    bool get_stream_stats (uint32_t stream_id, XCam::FrameScheduler::StreamStats &stats) {
+        return _scheduler.get_stream_stats (stream_id, stats);
+    }
+
+protected:
+    virtual void post_buffer (const XCam::SmartPtr<XCam::VideoBuffer> &buf);
+    virtual void process_buffer_failed (XCam::ImageProcessor *processor, const XCam::SmartPtr<XCam::VideoBuffer> &buf);
+
+private:
+    SharedPipeManager (const char *name, const SharedPipeConfig &config);
+
+    XCamReturn dispatch ();
+    bool is_batch_ready ();
+    void take_jobs (std::vector<XCam::FrameScheduler::Job> &jobs, uint32_t max_count);
+    XCamReturn dispatch_batch (const std::vector<XCam::FrameScheduler::Job> &jobs);
+    void scatter_batch (const XCam::SmartPtr<XCam::VideoBuffer> &buf, const XCam::SmartPtr<SharedBatchTag> &tag);
+
+    XCam::SmartPtr<Stream> get_stream (uint32_t stream_id);
+    uint32_t take_frame_done (const XCam::SmartPtr<XCam::VideoBuffer> &buf);
+    void deliver (uint32_t stream_id, const XCam::SmartPtr<XCam::VideoBuffer> &buf);
+    void stop_pipe ();
+
+    XCAM_DEAD_COPY (SharedPipeManager);
+
+private:
+    std::string                                   _name;
+    SharedPipeConfig                              _config;
+    XCam::SmartPtr<XCam::CLPostImageProcessor>    _image_processor;
+    XCam::SmartPtr<XCam::Thread>                  _dispatcher;
+    XCam::VideoBufferInfo                         _frame_info;
+    XCam::SmartPtr<XCam::BufferPool>              _batch_pool;
+    XCam::SmartPtr<XCam::BufferPool>              _scatter_pool;
+    int64_t                                       _batch_deadline;
+
+    XCam::FrameScheduler                          _scheduler;
+    StreamMap                                     _streams;
+    XCam::Mutex                                   _mutex;
+};
+
+};
+
+#endif // XCAMFILTER_SHARED_PIPE_MANAGER_H
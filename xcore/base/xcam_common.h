@@ -79,6 +79,13 @@ int xcam_device_ioctl (int fd, int cmd, void *arg);
 const char *xcam_fourcc_to_string (uint32_t fourcc);
 
 void xcam_set_log (const char* file_name);
+/*
+ * async log formats messages into a ring of the calling thread and writes them on a log thread,
+ * messages are dropped when the ring is full. env XCAM_LOG_ASYNC=1 enables it at start.
+ */
+void xcam_set_log_async (int enable);
+// writes out pending async messages
+void xcam_flush_log ();
 void xcam_print_log (const char* format, ...);
 
 static inline uint32_t
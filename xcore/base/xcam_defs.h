@@ -21,22 +21,40 @@
 #ifndef XCAM_DEFS_H
 #define XCAM_DEFS_H
 
+#define XCAM_LOG_LEVEL_DEBUG    0
+#define XCAM_LOG_LEVEL_INFO     1
+#define XCAM_LOG_LEVEL_WARNING  2
+#define XCAM_LOG_LEVEL_ERROR    3
+
+// logs below it are compiled out, e.g. CPPFLAGS="-DXCAM_LOG_MIN_LEVEL=2" keeps warnings and errors
+#ifndef XCAM_LOG_MIN_LEVEL
+#define XCAM_LOG_MIN_LEVEL XCAM_LOG_LEVEL_DEBUG
+#endif
+
 #ifndef XCAM_LOG_ERROR
 #define XCAM_LOG_ERROR(format, ...)    \
     xcam_print_log ("XCAM ERROR %s:%d: " format "\n", __FILE__, __LINE__, ## __VA_ARGS__)
 #endif
 
 #ifndef XCAM_LOG_WARNING
+#if XCAM_LOG_MIN_LEVEL <= XCAM_LOG_LEVEL_WARNING
 #define XCAM_LOG_WARNING(format, ...)   \
     xcam_print_log ("XCAM WARNING %s:%d: " format "\n", __FILE__, __LINE__, ## __VA_ARGS__)
+#else
+#define XCAM_LOG_WARNING(...)
+#endif
 #endif
 
 #ifndef XCAM_LOG_INFO
+#if XCAM_LOG_MIN_LEVEL <= XCAM_LOG_LEVEL_INFO
 #define XCAM_LOG_INFO(format, ...)   \
     xcam_print_log ("XCAM INFO %s:%d: " format "\n", __FILE__, __LINE__, ## __VA_ARGS__)
+#else
+#define XCAM_LOG_INFO(...)
+#endif
 #endif
 
-#ifdef DEBUG
+#if defined (DEBUG) && XCAM_LOG_MIN_LEVEL <= XCAM_LOG_LEVEL_DEBUG
 #ifndef XCAM_LOG_DEBUG
 #define XCAM_LOG_DEBUG(format, ...)   \
       xcam_print_log ("XCAM DEBUG %s:%d: " format "\n", __FILE__, __LINE__, ## __VA_ARGS__)
@@ -0,0 +1,219 @@
+/*
+ * blend_reuse.cpp - reuse of blended overlaps
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "blend_reuse.h"
+
+namespace XCam {
+
+// block means of @area luma, sampled every 2 pixels, appended to @luma
+static bool
+scale_luma (
+    const SmartPtr<VideoBuffer> &buf, const Rect &area,
+    std::vector<uint8_t> &luma, uint32_t &blocks_x, uint32_t &blocks_y)
+{
+    const uint32_t block = XCAM_BLEND_REUSE_BLOCK;
+    blocks_x = area.width / block;
+    blocks_y = area.height / block;
+    if (!buf.ptr () || !blocks_x || !blocks_y)
+        return false;
+
+    uint8_t *ptr = buf->map ();
+    XCAM_FAIL_RETURN (ERROR, ptr, false, "blend reuse map input buffer failed");
+
+    const VideoBufferInfo &info = buf->get_video_info ();
+    size_t start = luma.size ();
+    luma.resize (start + blocks_x * blocks_y);
+    uint8_t *out = &luma[start];
+
+    for (uint32_t by = 0; by < blocks_y; ++by) {
+        const uint8_t *line =
+            ptr + info.offsets[0] + (area.pos_y + by * block) * info.strides[0] + area.pos_x;
+        for (uint32_t bx = 0; bx < blocks_x; ++bx) {
+            const uint8_t *src = line + bx * block;
+            uint32_t sum = 0;
+            for (uint32_t y = 0; y < block; y += 2) {
+                const uint8_t *row = src + y * info.strides[0];
+                sum += row[0] + row[2] + row[4] + row[6];
+            }
+            out[by * blocks_x + bx] = (sum + 8) >> 4;
+        }
+    }
+
+    buf->unmap ();
+    return true;
+}
+
+// any tile of @cur blocks differs from @ref by more than @threshold in mean
+static bool
+is_tile_changed (
+    const uint8_t *cur, const uint8_t *ref, uint32_t blocks_x, uint32_t blocks_y, float threshold)
+{
+    const uint32_t tile = XCAM_BLEND_REUSE_TILE;
+    for (uint32_t ty = 0; ty < blocks_y; ty += tile) {
+        uint32_t th = XCAM_MIN (tile, blocks_y - ty);
+        for (uint32_t tx = 0; tx < blocks_x; tx += tile) {
+            uint32_t tw = XCAM_MIN (tile, blocks_x - tx);
+            uint32_t sum = 0;
+            for (uint32_t y = ty; y < ty + th; ++y) {
+                const uint8_t *cur_line = cur + y * blocks_x;
+                const uint8_t *ref_line = ref + y * blocks_x;
+                for (uint32_t x = tx; x < tx + tw; ++x)
+                    sum += abs ((int32_t)cur_line[x] - (int32_t)ref_line[x]);
+            }
+            if (sum > threshold * tw * th)
+                return true;
+        }
+    }
+    return false;
+}
+
+// copies NV12 @area of @buf to @data, or @data to @buf if @to_buf
+static bool
+copy_nv12_area (const SmartPtr<VideoBuffer> &buf, const Rect &area, uint8_t *data, bool to_buf)
+{
+    const VideoBufferInfo &info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12, false,
+        "blend reuse only supports NV12, format:%s", xcam_fourcc_to_string (info.format));
+
+    uint8_t *ptr = buf->map ();
+    XCAM_FAIL_RETURN (ERROR, ptr, false, "blend reuse map output buffer failed");
+
+    const uint32_t width = area.width;
+    for (int32_t y = 0; y < area.height; ++y) {
+        uint8_t *line = ptr + info.offsets[0] + (area.pos_y + y) * info.strides[0] + area.pos_x;
+        if (to_buf)
+            memcpy (line, data, width);
+        else
+            memcpy (data, line, width);
+        data += width;
+    }
+    for (int32_t y = 0; y < area.height / 2; ++y) {
+        uint8_t *line = ptr + info.offsets[1] + (area.pos_y / 2 + y) * info.strides[1] + area.pos_x;
+        if (to_buf)
+            memcpy (line, data, width);
+        else
+            memcpy (data, line, width);
+        data += width;
+    }
+
+    buf->unmap ();
+    return true;
+}
+
+BlendReuse::BlendReuse ()
+    : _result_valid (false)
+    , _ticket (0)
+    , _reused_in_row (0)
+    , _reused_count (0)
+    , _blended_count (0)
+{
+    xcam_mem_clear (_ref_blocks);
+}
+
+void
+BlendReuse::set_policy (const BlendReusePolicy &policy)
+{
+    SmartLock locker (_mutex);
+    _policy = policy;
+    _result_valid = false;
+}
+
+void
+BlendReuse::reset ()
+{
+    SmartLock locker (_mutex);
+    _result_valid = false;
+    _ref_luma.clear ();
+}
+
+bool
+BlendReuse::try_reuse (
+    const SmartPtr<VideoBuffer> &left_buf, const Rect &left_area,
+    const SmartPtr<VideoBuffer> &right_buf, const Rect &right_area,
+    const SmartPtr<VideoBuffer> &out_buf, const Rect &out_area, uint32_t &ticket)
+{
+    std::vector<uint8_t> luma;
+    uint32_t blocks[4];
+    bool scaled =
+        scale_luma (left_buf, left_area, luma, blocks[0], blocks[1]) &&
+        scale_luma (right_buf, right_area, luma, blocks[2], blocks[3]);
+
+    SmartLock locker (_mutex);
+    ticket = ++_ticket;
+
+    bool reuse =
+        scaled && _result_valid && _reused_in_row < _policy.refresh_interval &&
+        !memcmp (blocks, _ref_blocks, sizeof (blocks)) && luma.size () == _ref_luma.size () &&
+        out_area.width == _result_area.width && out_area.height == _result_area.height;
+    if (reuse) {
+        const uint32_t left_size = blocks[0] * blocks[1];
+        reuse =
+            !is_tile_changed (&luma[0], &_ref_luma[0], blocks[0], blocks[1], _policy.tile_threshold) &&
+            !is_tile_changed (
+                &luma[left_size], &_ref_luma[left_size], blocks[2], blocks[3], _policy.tile_threshold);
+    }
+
+    if (reuse && copy_nv12_area (out_buf, out_area, &_result[0], true)) {
+        ++_reused_in_row;
+        ++_reused_count;
+        return true;
+    }
+
+    // blended again, later inputs are compared to these
+    _result_valid = false;
+    _reused_in_row = 0;
+    ++_blended_count;
+    _ref_luma.swap (luma);
+    if (scaled)
+        memcpy (_ref_blocks, blocks, sizeof (blocks));
+    else
+        _ref_luma.clear ();
+    return false;
+}
+
+void
+BlendReuse::keep (const SmartPtr<VideoBuffer> &out_buf, const Rect &out_area, uint32_t ticket)
+{
+    SmartLock locker (_mutex);
+    // a later frame blended again or inputs were not scaled
+    if (ticket != _ticket || _ref_luma.empty () || out_area.width <= 0 || out_area.height <= 0)
+        return;
+
+    _result.resize (out_area.width * (out_area.height + out_area.height / 2));
+    _result_area = out_area;
+    _result_valid = copy_nv12_area (out_buf, out_area, &_result[0], false);
+}
+
+uint64_t
+BlendReuse::get_reused_count () const
+{
+    SmartLock locker (_mutex);
+    return _reused_count;
+}
+
+uint64_t
+BlendReuse::get_blended_count () const
+{
+    SmartLock locker (_mutex);
+    return _blended_count;
+}
+
+}
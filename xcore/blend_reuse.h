@@ -0,0 +1,90 @@
+/*
+ * blend_reuse.h - reuse of blended overlaps
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_BLEND_REUSE_H
+#define XCAM_BLEND_REUSE_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <video_buffer.h>
+#include <interface/stitcher.h>
+#include <vector>
+
+// luma is scaled down by blocks of 8x8, tiles are 8x8 blocks
+#define XCAM_BLEND_REUSE_BLOCK 8
+#define XCAM_BLEND_REUSE_TILE 8
+
+namespace XCam {
+
+/*
+ * BlendReuse, last blended result of one NV12 overlap and the inputs it was blended from.
+ * inputs of a new frame are compared to the blended ones by tiles of 1/8 scaled luma,
+ * the kept result is copied out while no tile changed; slow changes add up against the
+ * blended inputs and refresh_interval bounds frames reused in a row.
+ * thread-safe, results of frames blended at the same time are only kept from the latest one.
+ */
+class BlendReuse
+{
+public:
+    BlendReuse ();
+
+    void set_policy (const BlendReusePolicy &policy);
+    bool is_enabled () const {
+        return _policy.refresh_interval > 0;
+    }
+    // drops kept result, e.g. after blend settings change
+    void reset ();
+
+    /*
+     * copies kept result into @out_area of @out_buf if inputs are static, returns true.
+     * otherwise returns false, the overlap need be blended and kept by @ticket.
+     */
+    bool try_reuse (
+        const SmartPtr<VideoBuffer> &left_buf, const Rect &left_area,
+        const SmartPtr<VideoBuffer> &right_buf, const Rect &right_area,
+        const SmartPtr<VideoBuffer> &out_buf, const Rect &out_area, uint32_t &ticket);
+    // keeps @out_area of @out_buf blended after try_reuse gave @ticket
+    void keep (const SmartPtr<VideoBuffer> &out_buf, const Rect &out_area, uint32_t ticket);
+
+    uint64_t get_reused_count () const;
+    uint64_t get_blended_count () const;
+
+private:
+    XCAM_DEAD_COPY (BlendReuse);
+
+private:
+    BlendReusePolicy        _policy;
+    // scaled luma of blended inputs, left then right
+    std::vector<uint8_t>    _ref_luma;
+    uint32_t                _ref_blocks[4];
+    // kept result, luma then interleaved uv
+    std::vector<uint8_t>    _result;
+    Rect                    _result_area;
+    bool                    _result_valid;
+    uint32_t                _ticket;
+    uint32_t                _reused_in_row;
+    uint64_t                _reused_count;
+    uint64_t                _blended_count;
+    mutable Mutex           _mutex;
+};
+
+}
+
+#endif //XCAM_BLEND_REUSE_H
@@ -22,6 +22,37 @@
 
 namespace XCam {
 
+static std::atomic<uint64_t> pool_mem_budget (0);
+static std::atomic<uint64_t> pool_mem_used (0);
+
+// @force charges reserved data, which must not fail on budget
+static bool
+charge_pool_mem (uint64_t size, bool force)
+{
+    uint64_t used = pool_mem_used.load ();
+    do {
+        uint64_t budget = pool_mem_budget.load ();
+        if (!force && budget && used + size > budget)
+            return false;
+    } while (!pool_mem_used.compare_exchange_weak (used, used + size));
+
+    return true;
+}
+
+static void
+refund_pool_mem (uint64_t size)
+{
+    pool_mem_used -= size;
+}
+
+static int64_t
+get_pool_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
 BufferProxy::BufferProxy (const VideoBufferInfo &info, const SmartPtr<BufferData> &data)
     : VideoBuffer (info)
     , _data (data)
@@ -65,14 +96,67 @@ BufferProxy::get_fd ()
 }
 
 BufferPool::BufferPool ()
-    : _allocated_num (0)
+    : _buf_list (new SafeRing<BufferData> (XCAM_BUFFER_POOL_DEFAULT_COUNT))
+    , _allocated_num (0)
     , _max_count (0)
     , _started (false)
+    , _grow_max (0)
+    , _idle_trim_time (XCAM_BUFFER_POOL_IDLE_TRIM_MS * 1000LL)
+    , _busy_time (0)
+    , _charged_size (0)
+    , _mem_charge (MemoryPool)
+    , _out_num (0)
+    , _high_water (0)
+    , _grow_count (0)
+    , _trim_count (0)
+    , _wait_count (0)
+    , _wait_time (0)
 {
 }
 
 BufferPool::~BufferPool ()
 {
+    refund_pool_mem (_charged_size);
+}
+
+void
+BufferPool::set_memory_budget (uint64_t bytes)
+{
+    pool_mem_budget = bytes;
+}
+
+uint64_t
+BufferPool::get_memory_usage ()
+{
+    return pool_mem_used.load ();
+}
+
+bool
+BufferPool::set_grow_limit (uint32_t max_count, uint32_t idle_trim_ms)
+{
+    SmartLock lock (_mutex);
+    if (max_count > _buf_list->get_capacity ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, !_started, false,
+            "BufferPool grow limit:%d exceeds the free ring capacity:%d, need set it before reserve",
+            max_count, _buf_list->get_capacity ());
+        resize_ring_unsafe (max_count);
+    }
+
+    _grow_max = max_count;
+    _idle_trim_time = idle_trim_ms * 1000LL;
+    return true;
+}
+
+void
+BufferPool::get_stats (BufferPoolStats &stats) const
+{
+    stats.allocated = _allocated_num;
+    stats.high_water = _high_water;
+    stats.grow_count = _grow_count;
+    stats.trim_count = _trim_count;
+    stats.wait_count = _wait_count;
+    stats.wait_time = _wait_time;
 }
 
 bool
@@ -96,36 +180,69 @@ BufferPool::update_video_info_unsafe (const VideoBufferInfo &info)
     _buffer_info = info;
 }
 
-bool
+void
+BufferPool::resize_ring_unsafe (uint32_t count)
+{
+    XCAM_ASSERT (!_started);
+    if (count <= _buf_list->get_capacity ())
+        return;
+
+    SmartPtr<SafeRing<BufferData> > ring = new SafeRing<BufferData> (count);
+    SmartPtr<BufferData> data;
+    while ((data = _buf_list->try_pop ()).ptr ())
+        ring->try_push (data);
+    _buf_list = ring;
+}
+
+XCamReturn
 BufferPool::reserve (uint32_t max_count)
 {
-    uint32_t i = 0;
+    uint32_t i = 0, start = 0;
 
-    XCAM_ASSERT (max_count);
+    XCAM_FAIL_RETURN (
+        ERROR, max_count, XCAM_RETURN_ERROR_PARAM,
+        "BufferPool reserve count must be positive");
 
     SmartLock lock (_mutex);
 
-    for (i = _allocated_num; i < max_count; ++i) {
-        SmartPtr<BufferData> new_data = allocate_data (_buffer_info);
-        if (!new_data.ptr ())
-            break;
-        _buf_list.push (new_data);
+    // get and release use the ring without _mutex, so it can't be replaced once started
+    if (max_count > _buf_list->get_capacity ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, !_started, XCAM_RETURN_ERROR_PARAM,
+            "BufferPool reserve count:%d exceeds the free ring capacity:%d of a started pool, need stop it first",
+            max_count, _buf_list->get_capacity ());
+        resize_ring_unsafe (max_count);
+    }
+
+    start = _allocated_num;
+    {
+        MemoryOwnerScope mem_scope (_mem_charge.get_owner (), true);
+        for (i = start; i < max_count; ++i) {
+            SmartPtr<BufferData> new_data = allocate_data (_buffer_info);
+            if (!new_data.ptr () || !_buf_list->try_push (new_data))
+                break;
+        }
     }
 
     XCAM_FAIL_RETURN (
         ERROR,
         i > 0,
-        false,
+        XCAM_RETURN_ERROR_MEM,
         "BufferPool reserve failed with none buffer data allocated");
 
     if (i != max_count) {
         XCAM_LOG_WARNING ("BufferPool expect to reserve %d data but only reserved %d", max_count, i);
     }
+    if (i > start) {
+        charge_pool_mem ((uint64_t)_buffer_info.size * (i - start), true);
+        _charged_size += (uint64_t)_buffer_info.size * (i - start);
+        _mem_charge.charge (_charged_size);
+    }
     _max_count = i;
     _allocated_num = _max_count;
     _started = true;
 
-    return true;
+    return XCAM_RETURN_NO_ERROR;
 }
 
 bool
@@ -134,24 +251,98 @@ BufferPool::add_data_unsafe (const SmartPtr<BufferData> &data)
     if (!data.ptr ())
         return false;
 
-    _buf_list.push (data);
+    if (!_started && _buf_list->size () == _buf_list->get_capacity ())
+        resize_ring_unsafe (_buf_list->get_capacity () * 2);
+
+    XCAM_FAIL_RETURN (
+        ERROR, _buf_list->try_push (data), false,
+        "BufferPool add data failed, pool already holds %d data", _allocated_num.load ());
     ++_allocated_num;
+    charge_pool_mem (_buffer_info.size, true);
+    _charged_size += _buffer_info.size;
+    _mem_charge.charge (_charged_size);
 
     XCAM_ASSERT (_allocated_num <= _max_count || !_max_count);
     return true;
 }
 
 SmartPtr<VideoBuffer>
-BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
+BufferPool::wrap_data (const SmartPtr<BufferPool> &self, SmartPtr<BufferData> &data)
 {
-    SmartPtr<BufferProxy> ret_buf;
-    SmartPtr<BufferData> data;
+    SmartPtr<BufferProxy> ret_buf = create_buffer_from_data (data);
+    ret_buf->set_buf_pool (self);
+
+    uint32_t out_num = ++_out_num;
+    uint32_t high_water = _high_water.load ();
+    while (out_num > high_water && !_high_water.compare_exchange_weak (high_water, out_num));
+
+    return ret_buf;
+}
+
+SmartPtr<BufferData>
+BufferPool::grow_data ()
+{
+    if (!_grow_max)
+        return NULL;
+
+    _busy_time = get_pool_time ();
+
+    SmartLock lock (_mutex);
+    if (_allocated_num >= _grow_max)
+        return NULL;
+
+    uint64_t size = _buffer_info.size;
+    if (!charge_pool_mem (size, false)) {
+        XCAM_LOG_DEBUG ("BufferPool grow stopped by memory budget, allocated:%d", _allocated_num.load ());
+        return NULL;
+    }
 
+    SmartPtr<BufferData> data;
     {
-        SmartLock lock (_mutex);
-        if (!_started)
-            return NULL;
+        MemoryOwnerScope mem_scope (_mem_charge.get_owner (), true);
+        data = allocate_data (_buffer_info);
     }
+    if (!data.ptr ()) {
+        refund_pool_mem (size);
+        XCAM_LOG_WARNING ("BufferPool grow failed to allocate data");
+        return NULL;
+    }
+
+    _charged_size += size;
+    _mem_charge.charge (_charged_size);
+    ++_allocated_num;
+    ++_grow_count;
+    return data;
+}
+
+bool
+BufferPool::trim_data ()
+{
+    int64_t now = get_pool_time ();
+    if (now - _busy_time < _idle_trim_time || _buf_list->is_empty ())
+        return false;
+
+    SmartLock lock (_mutex);
+    if (_allocated_num <= _max_count)
+        return false;
+
+    uint64_t size = XCAM_MIN ((uint64_t)_buffer_info.size, _charged_size);
+    refund_pool_mem (size);
+    _charged_size -= size;
+    _mem_charge.charge (_charged_size);
+    --_allocated_num;
+    ++_trim_count;
+
+    // trim one data per idle period
+    _busy_time = now;
+    return true;
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
+{
+    if (!_started)
+        return NULL;
 
     XCAM_ASSERT (self.ptr () == this);
     XCAM_FAIL_RETURN(
@@ -160,15 +351,23 @@ BufferPool::get_buffer (const SmartPtr<BufferPool> &self)
         NULL,
         "BufferPool get_buffer failed since parameter<self> not this");
 
-    data = _buf_list.pop ();
+    SmartPtr<BufferData> data = _buf_list->try_pop ();
+    if (!data.ptr ())
+        data = grow_data ();
+
+    if (!data.ptr ()) {
+        int64_t start = get_pool_time ();
+        data = _buf_list->pop ();
+        _wait_time += get_pool_time () - start;
+        ++_wait_count;
+    }
+
     if (!data.ptr ()) {
         XCAM_LOG_DEBUG ("BufferPool failed to get buffer");
         return NULL;
     }
-    ret_buf = create_buffer_from_data (data);
-    ret_buf->set_buf_pool (self);
 
-    return ret_buf;
+    return wrap_data (self, data);
 }
 
 SmartPtr<VideoBuffer>
@@ -177,6 +376,33 @@ BufferPool::get_buffer ()
     return get_buffer (SmartPtr<BufferPool>(this));
 }
 
+SmartPtr<VideoBuffer>
+BufferPool::try_get_buffer (const SmartPtr<BufferPool> &self)
+{
+    if (!_started)
+        return NULL;
+
+    XCAM_FAIL_RETURN(
+        WARNING,
+        self.ptr () == this,
+        NULL,
+        "BufferPool try_get_buffer failed since parameter<self> not this");
+
+    SmartPtr<BufferData> data = _buf_list->try_pop ();
+    if (!data.ptr ())
+        data = grow_data ();
+    if (!data.ptr ())
+        return NULL;
+
+    return wrap_data (self, data);
+}
+
+SmartPtr<VideoBuffer>
+BufferPool::try_get_buffer ()
+{
+    return try_get_buffer (SmartPtr<BufferPool>(this));
+}
+
 void
 BufferPool::stop ()
 {
@@ -184,18 +410,23 @@ BufferPool::stop ()
         SmartLock lock (_mutex);
         _started = false;
     }
-    _buf_list.pause_pop ();
+    _buf_list->pause_pop ();
 }
 
 void
 BufferPool::release (SmartPtr<BufferData> &data)
 {
-    {
-        SmartLock lock (_mutex);
-        if (!_started)
-            return;
+    --_out_num;
+    if (!_started)
+        return;
+
+    if (_grow_max && _allocated_num > _max_count && trim_data ())
+        return;
+
+    // ring holds every allocated data, so push never fails here
+    if (!_buf_list->try_push (data)) {
+        XCAM_LOG_WARNING ("BufferPool release data failed since free list is full");
     }
-    _buf_list.push (data);
 }
 
 bool
@@ -23,7 +23,13 @@
 
 #include <xcam_std.h>
 #include <safe_list.h>
+#include <safe_ring.h>
 #include <video_buffer.h>
+#include <memory_accounting.h>
+
+// initial free ring capacity, reserve and set_grow_limit resize it
+#define XCAM_BUFFER_POOL_DEFAULT_COUNT 4
+#define XCAM_BUFFER_POOL_IDLE_TRIM_MS 2000
 
 namespace XCam {
 
@@ -79,6 +85,24 @@ private:
     SmartPtr<BufferPool>       _pool;
 };
 
+struct BufferPoolStats {
+    uint32_t    allocated;
+    uint32_t    high_water;     // most buffers out of the pool at once
+    uint32_t    grow_count;
+    uint32_t    trim_count;
+    uint32_t    wait_count;
+    int64_t     wait_time;      // microseconds blocked in get_buffer
+
+    BufferPoolStats ()
+        : allocated (0)
+        , high_water (0)
+        , grow_count (0)
+        , trim_count (0)
+        , wait_count (0)
+        , wait_time (0)
+    {}
+};
+
 class BufferPool
     : public RefObj
 {
@@ -89,22 +113,48 @@ public:
     virtual ~BufferPool ();
 
     bool set_video_info (const VideoBufferInfo &info);
-    bool reserve (uint32_t max_count = 4);
+    // the free ring is resized to @max_count only before the pool is started,
+    // a larger count on a started pool fails with XCAM_RETURN_ERROR_PARAM
+    XCamReturn reserve (uint32_t max_count = XCAM_BUFFER_POOL_DEFAULT_COUNT);
     SmartPtr<VideoBuffer> get_buffer (const SmartPtr<BufferPool> &self);
     SmartPtr<VideoBuffer> get_buffer ();
 
+    // never block, return NULL if no free buffer
+    SmartPtr<VideoBuffer> try_get_buffer (const SmartPtr<BufferPool> &self);
+    SmartPtr<VideoBuffer> try_get_buffer ();
+
     void stop ();
 
+    /*
+     * elastic pool, reserved count is the minimum.
+     * an empty pool allocates up to @max_count data instead of blocking,
+     * grown data is trimmed one by one after @idle_trim_ms without pressure.
+     * @max_count 0 keeps the pool fixed, a limit above the free ring capacity
+     * fails on a started pool, so set it before reserve.
+     */
+    bool set_grow_limit (uint32_t max_count, uint32_t idle_trim_ms = XCAM_BUFFER_POOL_IDLE_TRIM_MS);
+    void get_stats (BufferPoolStats &stats) const;
+
+    // MemoryAccounting owner of pool data, caught on pool creation
+    uint32_t get_mem_owner () const {
+        return _mem_charge.get_owner ();
+    }
+
+    // bytes shared by all pools, 0 means unlimited. reserved data counts against it too
+    // but is never refused, only growing stops once the budget is used up
+    static void set_memory_budget (uint64_t bytes);
+    static uint64_t get_memory_usage ();
+
     const VideoBufferInfo & get_video_info () const {
         return _buffer_info;
     }
 
     bool has_free_buffers () {
-        return !_buf_list.is_empty ();
+        return !_buf_list->is_empty ();
     }
 
     uint32_t get_free_buffer_size () {
-        return _buf_list.size ();
+        return _buf_list->size ();
     }
 
 protected:
@@ -117,16 +167,35 @@ protected:
     void update_video_info_unsafe (const VideoBufferInfo &info);
 
 private:
+    SmartPtr<VideoBuffer> wrap_data (const SmartPtr<BufferPool> &self, SmartPtr<BufferData> &data);
+    SmartPtr<BufferData> grow_data ();
+    bool trim_data ();
+    void resize_ring_unsafe (uint32_t count);
     void release (SmartPtr<BufferData> &data);
     XCAM_DEAD_COPY (BufferPool);
 
 private:
     Mutex                    _mutex;
     VideoBufferInfo          _buffer_info;
-    SafeList<BufferData>     _buf_list;
-    uint32_t                 _allocated_num;
+    // free data, get and release only lock when get_buffer has to wait,
+    // the ring is replaced by a larger one only while the pool is not started
+    SmartPtr<SafeRing<BufferData> >  _buf_list;
+    std::atomic<uint32_t>    _allocated_num;
     uint32_t                 _max_count;
-    bool                     _started;
+    std::atomic<bool>        _started;
+
+    uint32_t                 _grow_max;
+    int64_t                  _idle_trim_time;
+    std::atomic<int64_t>     _busy_time;
+    uint64_t                 _charged_size;
+    MemoryCharge             _mem_charge;
+
+    std::atomic<uint32_t>    _out_num;
+    std::atomic<uint32_t>    _high_water;
+    std::atomic<uint32_t>    _grow_count;
+    std::atomic<uint32_t>    _trim_count;
+    std::atomic<uint32_t>    _wait_count;
+    std::atomic<int64_t>     _wait_time;
 };
 
 class VKDevice;
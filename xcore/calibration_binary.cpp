@@ -0,0 +1,286 @@
+/*
+ * calibration_binary.cpp - binary rig calibration with optional dewarp tables
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "calibration_binary.h"
+#include "interface/stitcher.h"
+#include "calibration_parser.h"
+#include "file_handle.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define XCAM_CALIBRATION_MAGIC 0x4c414358 // "XCAL"
+#define XCAM_CALIBRATION_VERSION 1
+#define XCAM_CALIBRATION_TABLE_ALIGN 16
+
+namespace XCam {
+
+// structs are stored as they are, calib_size rejects files of other layouts
+struct CalibrationHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t calib_size;
+    uint32_t camera_count;
+    uint32_t table_count;
+    uint32_t reserved[2];
+};
+
+struct CalibrationTableEntry {
+    uint32_t camera;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t offset;
+};
+
+static size_t
+get_tables_offset (uint32_t camera_count, uint32_t table_count)
+{
+    size_t offset =
+        sizeof (CalibrationHeader) + camera_count * sizeof (CalibrationInfo) +
+        table_count * sizeof (CalibrationTableEntry);
+    return XCAM_ALIGN_UP (offset, XCAM_CALIBRATION_TABLE_ALIGN);
+}
+
+CalibrationBinary::CalibrationBinary ()
+    : _data (NULL)
+    , _size (0)
+    , _camera_count (0)
+    , _table_count (0)
+{
+}
+
+CalibrationBinary::~CalibrationBinary ()
+{
+    unload ();
+}
+
+XCamReturn
+CalibrationBinary::write_file (
+    const char *file_path, const CalibrationInfo *calibs, uint32_t count,
+    const CalibrationTable *tables, uint32_t table_count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, file_path && calibs && count && (tables || !table_count), XCAM_RETURN_ERROR_PARAM,
+        "calibration binary write failed, invalid params");
+
+    CalibrationHeader header;
+    xcam_mem_clear (header);
+    header.magic = XCAM_CALIBRATION_MAGIC;
+    header.version = XCAM_CALIBRATION_VERSION;
+    header.header_size = sizeof (header);
+    header.calib_size = sizeof (CalibrationInfo);
+    header.camera_count = count;
+    header.table_count = table_count;
+
+    std::vector<CalibrationTableEntry> entries (table_count);
+    uint64_t offset = get_tables_offset (count, table_count);
+    for (uint32_t i = 0; i < table_count; ++i) {
+        const CalibrationTable &table = tables[i];
+        XCAM_FAIL_RETURN (
+            ERROR, table.camera < count && table.width && table.height && table.data, XCAM_RETURN_ERROR_PARAM,
+            "calibration binary write failed, table:%d invalid", i);
+
+        CalibrationTableEntry &entry = entries[i];
+        xcam_mem_clear (entry);
+        entry.camera = table.camera;
+        entry.width = table.width;
+        entry.height = table.height;
+        entry.key = table.key;
+        entry.offset = offset;
+        offset += XCAM_ALIGN_UP (table.width * table.height * sizeof (PointFloat2), XCAM_CALIBRATION_TABLE_ALIGN);
+    }
+
+    // write to temporary file first, readers never map partial files
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    char temp_name[XCAM_MAX_STR_SIZE] = {0};
+    snprintf (
+        temp_name, XCAM_MAX_STR_SIZE - 1, "%s." XCAM_TIMESTAMP_FORMAT,
+        file_path, XCAM_TIMESTAMP_ARGS (XCAM_TIMEVAL_2_USEC (ts)));
+
+    FileHandle file;
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (file.open (temp_name, "wb")), XCAM_RETURN_ERROR_FILE,
+        "calibration binary open file(%s) failed", temp_name);
+
+    static const uint8_t padding[XCAM_CALIBRATION_TABLE_ALIGN] = {0};
+    size_t written = sizeof (header) + count * sizeof (CalibrationInfo) + table_count * sizeof (CalibrationTableEntry);
+    bool ret =
+        xcam_ret_is_ok (file.write_file (&header, sizeof (header))) &&
+        xcam_ret_is_ok (file.write_file (calibs, count * sizeof (CalibrationInfo))) &&
+        (!table_count || xcam_ret_is_ok (file.write_file (entries.data (), table_count * sizeof (CalibrationTableEntry))));
+
+    for (uint32_t i = 0; ret && i < table_count; ++i) {
+        XCAM_ASSERT (entries[i].offset >= written && entries[i].offset - written < XCAM_CALIBRATION_TABLE_ALIGN);
+        if (entries[i].offset > written)
+            ret = xcam_ret_is_ok (file.write_file (padding, entries[i].offset - written));
+
+        size_t size = tables[i].width * tables[i].height * sizeof (PointFloat2);
+        ret = ret && xcam_ret_is_ok (file.write_file (tables[i].data, size));
+        written = entries[i].offset + size;
+    }
+    file.close ();
+
+    if (!ret || rename (temp_name, file_path) != 0) {
+        remove (temp_name);
+        XCAM_LOG_ERROR ("calibration binary write file(%s) failed", file_path);
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    XCAM_LOG_INFO (
+        "calibration binary(%s) written, cameras:%d, tables:%d", file_path, count, table_count);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CalibrationBinary::convert_text_files (
+    const char *file_path, const char * const *intrinsic_files, const char * const *extrinsic_files,
+    uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, intrinsic_files && extrinsic_files && count, XCAM_RETURN_ERROR_PARAM,
+        "calibration binary convert failed, invalid params");
+
+    CalibrationParser parser;
+    std::vector<CalibrationInfo> calibs (count);
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < count; ++i) {
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret = parser.parse_intrinsic_file (intrinsic_files[i], calibs[i].intrinsic)), ret,
+            "calibration binary convert intrinsic file(%s) failed", XCAM_STR (intrinsic_files[i]));
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret = parser.parse_extrinsic_file (extrinsic_files[i], calibs[i].extrinsic)), ret,
+            "calibration binary convert extrinsic file(%s) failed", XCAM_STR (extrinsic_files[i]));
+    }
+
+    return write_file (file_path, calibs.data (), count);
+}
+
+XCamReturn
+CalibrationBinary::load (const char *file_path)
+{
+    XCAM_ASSERT (file_path);
+    unload ();
+
+    int fd = open (file_path, O_RDONLY | O_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        WARNING, fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "calibration binary open file(%s) failed", file_path);
+
+    struct stat st;
+    if (fstat (fd, &st) < 0 || (size_t)st.st_size < sizeof (CalibrationHeader)) {
+        close (fd);
+        XCAM_LOG_WARNING ("calibration binary(%s) too small or stat failed", file_path);
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    size_t size = st.st_size;
+    void *data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    XCAM_FAIL_RETURN (
+        WARNING, data != MAP_FAILED, XCAM_RETURN_ERROR_MEM,
+        "calibration binary map file(%s) failed", file_path);
+
+    const CalibrationHeader *header = (const CalibrationHeader *)data;
+    bool valid =
+        header->magic == XCAM_CALIBRATION_MAGIC && header->version == XCAM_CALIBRATION_VERSION &&
+        header->header_size == sizeof (CalibrationHeader) && header->calib_size == sizeof (CalibrationInfo) &&
+        header->camera_count <= XCAM_STITCH_MAX_CAMERAS &&
+        get_tables_offset (header->camera_count, header->table_count) <= size;
+
+    const CalibrationTableEntry *entries = (const CalibrationTableEntry *)(
+        (const uint8_t *)data + sizeof (CalibrationHeader) + header->camera_count * sizeof (CalibrationInfo));
+    for (uint32_t i = 0; valid && i < header->table_count; ++i) {
+        const CalibrationTableEntry &entry = entries[i];
+        uint64_t table_size = (uint64_t)entry.width * entry.height * sizeof (PointFloat2);
+        valid =
+            entry.camera < header->camera_count && entry.offset % XCAM_CALIBRATION_TABLE_ALIGN == 0 &&
+            entry.offset <= size && table_size <= size - entry.offset;
+    }
+
+    if (!valid) {
+        munmap (data, size);
+        XCAM_LOG_WARNING ("calibration binary(%s) header mismatch or truncated", file_path);
+        return XCAM_RETURN_ERROR_PARAM;
+    }
+
+    _data = (uint8_t *)data;
+    _size = size;
+    _camera_count = header->camera_count;
+    _table_count = header->table_count;
+
+    XCAM_LOG_DEBUG (
+        "calibration binary(%s) loaded, cameras:%d, tables:%d", file_path, _camera_count, _table_count);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CalibrationBinary::unload ()
+{
+    if (_data)
+        munmap (_data, _size);
+    _data = NULL;
+    _size = 0;
+    _camera_count = 0;
+    _table_count = 0;
+}
+
+XCamReturn
+CalibrationBinary::get_calibration (uint32_t idx, CalibrationInfo &calib) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _data && idx < _camera_count, XCAM_RETURN_ERROR_PARAM,
+        "calibration binary get calibration(idx:%d) failed, %s", idx, (_data ? "invalid index" : "not loaded"));
+
+    const CalibrationInfo *calibs = (const CalibrationInfo *)(_data + sizeof (CalibrationHeader));
+    memcpy (&calib, &calibs[idx], sizeof (CalibrationInfo));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+CalibrationBinary::find_table (uint64_t key, uint32_t width, uint32_t height, CalibrationTable &table) const
+{
+    if (!_data)
+        return false;
+
+    const CalibrationTableEntry *entries = (const CalibrationTableEntry *)(
+        _data + sizeof (CalibrationHeader) + _camera_count * sizeof (CalibrationInfo));
+    for (uint32_t i = 0; i < _table_count; ++i) {
+        const CalibrationTableEntry &entry = entries[i];
+        if (entry.key != key || entry.width != width || entry.height != height)
+            continue;
+
+        table.camera = entry.camera;
+        table.width = entry.width;
+        table.height = entry.height;
+        table.key = entry.key;
+        table.data = (const PointFloat2 *)(_data + entry.offset);
+        return true;
+    }
+
+    return false;
+}
+
+}
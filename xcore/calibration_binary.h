@@ -0,0 +1,87 @@
+/*
+ * calibration_binary.h - binary rig calibration with optional dewarp tables
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CALIBRATION_BINARY_H
+#define XCAM_CALIBRATION_BINARY_H
+
+#include <xcam_std.h>
+#include <interface/data_types.h>
+
+namespace XCam {
+
+struct CalibrationInfo;
+
+// dewarp table of one camera, key is FisheyeTableCache::get_key of its calibration and sizes
+struct CalibrationTable {
+    uint32_t             camera;
+    uint32_t             width;
+    uint32_t             height;
+    uint64_t             key;
+    const PointFloat2   *data;
+
+    CalibrationTable ()
+        : camera (0), width (0), height (0), key (0), data (NULL)
+    {}
+};
+
+/*
+ * calibrations of all cameras of a rig in one versioned file, mapped read only,
+ * so batch tools load a rig without parsing text or recalculating dewarp tables.
+ */
+class CalibrationBinary
+{
+public:
+    explicit CalibrationBinary ();
+    ~CalibrationBinary ();
+
+    static XCamReturn write_file (
+        const char *file_path, const CalibrationInfo *calibs, uint32_t count,
+        const CalibrationTable *tables = NULL, uint32_t table_count = 0);
+    // converts Scaramuzza's text files of each camera
+    static XCamReturn convert_text_files (
+        const char *file_path, const char * const *intrinsic_files, const char * const *extrinsic_files,
+        uint32_t count);
+
+    XCamReturn load (const char *file_path);
+    void unload ();
+    bool is_loaded () const {
+        return _data != NULL;
+    }
+
+    uint32_t get_camera_count () const {
+        return _camera_count;
+    }
+    XCamReturn get_calibration (uint32_t idx, CalibrationInfo &calib) const;
+    // data points into mapped file, valid till unload
+    bool find_table (uint64_t key, uint32_t width, uint32_t height, CalibrationTable &table) const;
+
+private:
+    XCAM_DEAD_COPY (CalibrationBinary);
+
+private:
+    uint8_t         *_data;
+    size_t           _size;
+    uint32_t         _camera_count;
+    uint32_t         _table_count;
+};
+
+}
+
+#endif //XCAM_CALIBRATION_BINARY_H
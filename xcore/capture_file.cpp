@@ -0,0 +1,727 @@
+/*
+ * capture_file.cpp - compressed multi-camera capture file
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "capture_file.h"
+#include "lossless_codec.h"
+#include <xcam_mutex.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "XFRM" and "XIDX" in file order
+#define CAPTURE_FRAME_MAGIC 0x4d524658
+#define CAPTURE_INDEX_MAGIC 0x58444958
+#define CAPTURE_MAX_CAMERAS 64
+
+namespace XCam {
+
+struct CaptureFileHeader {
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    camera_count;
+};
+
+struct CaptureCameraRecord {
+    uint32_t    format;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    reserved;
+};
+
+// followed by uint32_t sizes of stripes and payload, raw frames have no stripe sizes
+struct CaptureFrameHeader {
+    uint32_t    magic;
+    uint32_t    camera;
+    int64_t     timestamp;
+    uint32_t    codec;
+    uint32_t    stripe_count;
+    uint64_t    payload_size;
+};
+
+struct CaptureIndexRecord {
+    uint32_t    camera;
+    uint32_t    reserved;
+    int64_t     timestamp;
+    uint64_t    offset;
+};
+
+struct CaptureTrailer {
+    uint64_t    index_offset;
+    uint32_t    frame_count;
+    uint32_t    magic;
+};
+
+CaptureStripe::CaptureStripe ()
+    : plane (NULL)
+    , stride (0)
+    , row_bytes (0)
+    , rows (0)
+    , channels (1)
+    , data (NULL)
+    , size (0)
+    , ok (false)
+{
+}
+
+class StripeSync {
+public:
+    explicit StripeSync (uint32_t count)
+        : _remain (count)
+    {}
+    void done () {
+        SmartLock locker (_mutex);
+        if (--_remain == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (StripeSync);
+
+private:
+    uint32_t          _remain;
+    Mutex             _mutex;
+    XCam::Cond        _cond;
+};
+
+static void
+code_stripe (CaptureStripe &stripe, bool encode)
+{
+    if (encode) {
+        stripe.coded.clear ();
+        LosslessCodec::encode (
+            stripe.plane, stripe.stride, stripe.row_bytes, stripe.rows, stripe.channels, stripe.coded);
+        stripe.ok = true;
+    } else {
+        stripe.ok = LosslessCodec::decode (
+                        stripe.data, stripe.size,
+                        stripe.plane, stripe.stride, stripe.row_bytes, stripe.rows, stripe.channels);
+    }
+}
+
+class StripeWork
+    : public ThreadPool::UserData
+{
+public:
+    StripeWork (CaptureStripe &stripe, bool encode, const SmartPtr<StripeSync> &sync)
+        : _stripe (stripe)
+        , _encode (encode)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        code_stripe (_stripe, _encode);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn err) {
+        XCAM_UNUSED (err);
+        _sync->done ();
+    }
+
+private:
+    CaptureStripe          &_stripe;
+    bool                    _encode;
+    SmartPtr<StripeSync>    _sync;
+};
+
+// caller thread codes the first stripe
+static bool
+code_stripes (const SmartPtr<ThreadPool> &pool, std::vector<CaptureStripe> &stripes, uint32_t count, bool encode)
+{
+    if (!pool.ptr () || count < 2) {
+        for (uint32_t i = 0; i < count; ++i)
+            code_stripe (stripes[i], encode);
+    } else {
+        SmartPtr<StripeSync> sync = new StripeSync (count - 1);
+        for (uint32_t i = 1; i < count; ++i) {
+            SmartPtr<ThreadPool::UserData> work = new StripeWork (stripes[i], encode, sync);
+            if (!xcam_ret_is_ok (pool->queue (work))) {
+                code_stripe (stripes[i], encode);
+                sync->done ();
+            }
+        }
+        code_stripe (stripes[0], encode);
+        sync->wait ();
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!stripes[i].ok)
+            return false;
+    }
+    return true;
+}
+
+// stripes of all planes in plane order, returns stripe count
+static uint32_t
+split_stripes (const VideoBufferInfo &info, uint8_t *memory, std::vector<CaptureStripe> &stripes)
+{
+    uint32_t count = 0;
+    VideoBufferPlanarInfo planar;
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        for (uint32_t y = 0; y < planar.height; y += XCAM_CAPTURE_STRIPE_ROWS) {
+            if (count >= stripes.size ())
+                stripes.resize (count + 1);
+
+            CaptureStripe &stripe = stripes[count++];
+            stripe.plane = memory + info.offsets[index] + (size_t)y * info.strides[index];
+            stripe.stride = info.strides[index];
+            stripe.row_bytes = planar.width * planar.pixel_bytes;
+            stripe.rows = XCAM_MIN (planar.height - y, (uint32_t)XCAM_CAPTURE_STRIPE_ROWS);
+            stripe.channels = XCAM_MAX (planar.pixel_bytes, 1u);
+            stripe.data = NULL;
+            stripe.size = 0;
+            stripe.ok = false;
+        }
+    }
+    return count;
+}
+
+static bool
+match_camera (const VideoBufferInfo &camera, const VideoBufferInfo &info)
+{
+    return camera.format == info.format && camera.width == info.width && camera.height == info.height;
+}
+
+static SmartPtr<ThreadPool>
+create_coder_pool (uint32_t threads)
+{
+    if (threads < 2)
+        return NULL;
+
+    SmartPtr<ThreadPool> pool = new ThreadPool ("CaptureCoder");
+    pool->set_threads (threads - 1, threads - 1);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (pool->start ()), NULL,
+        "capture file start coder threads failed, code stripes in caller thread");
+
+    return pool;
+}
+
+CaptureFileWriter::CaptureFileWriter ()
+    : _fp (NULL)
+    , _path (NULL)
+    , _codec (CaptureCodecLossless)
+    , _threads (XCAM_CAPTURE_DEFAULT_THREADS)
+    , _offset (0)
+    , _raw_bytes (0)
+    , _coded_bytes (0)
+{
+}
+
+CaptureFileWriter::~CaptureFileWriter ()
+{
+    close ();
+}
+
+bool
+CaptureFileWriter::add_camera (const VideoBufferInfo &info, uint32_t &camera)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_fp && info.is_valid () && _cameras.size () < CAPTURE_MAX_CAMERAS, false,
+        "capture file add camera failed, file opened or invalid format");
+
+    camera = _cameras.size ();
+    _cameras.push_back (info);
+    return true;
+}
+
+bool
+CaptureFileWriter::set_codec (CaptureCodec codec)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_fp && (codec == CaptureCodecRaw || codec == CaptureCodecLossless), false,
+        "capture file set codec failed, file opened or invalid codec:%d", (int)codec);
+
+    _codec = codec;
+    return true;
+}
+
+bool
+CaptureFileWriter::set_threads (uint32_t threads)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_fp && threads, false,
+        "capture file set threads failed, file opened or threads is 0");
+
+    _threads = threads;
+    return true;
+}
+
+XCamReturn
+CaptureFileWriter::write_data (const void *data, size_t size)
+{
+    if (!size)
+        return XCAM_RETURN_NO_ERROR;
+
+    XCAM_FAIL_RETURN (
+        ERROR, fwrite (data, 1, size, _fp) == size, XCAM_RETURN_ERROR_FILE,
+        "capture file(%s) write failed, errno:%d", XCAM_STR (_path), errno);
+
+    _offset += size;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureFileWriter::open (const char *path)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, path && !_fp && !_cameras.empty (), XCAM_RETURN_ERROR_PARAM,
+        "capture file open failed, path is NULL, file opened or no camera added");
+
+    _fp = fopen (path, "wb");
+    XCAM_FAIL_RETURN (
+        ERROR, _fp, XCAM_RETURN_ERROR_FILE,
+        "capture file(%s) open failed, errno:%d", path, errno);
+
+    _path = strndup (path, XCAM_MAX_STR_SIZE);
+    _index.clear ();
+    _offset = 0;
+    _raw_bytes = 0;
+    _coded_bytes = 0;
+
+    CaptureFileHeader header;
+    xcam_mem_clear (header);
+    memcpy (header.magic, XCAM_CAPTURE_FILE_MAGIC, sizeof (header.magic));
+    header.version = XCAM_CAPTURE_FILE_VERSION;
+    header.camera_count = _cameras.size ();
+    XCamReturn ret = write_data (&header, sizeof (header));
+
+    for (uint32_t i = 0; i < _cameras.size () && xcam_ret_is_ok (ret); ++i) {
+        CaptureCameraRecord record;
+        xcam_mem_clear (record);
+        record.format = _cameras[i].format;
+        record.width = _cameras[i].width;
+        record.height = _cameras[i].height;
+        ret = write_data (&record, sizeof (record));
+    }
+
+    if (!xcam_ret_is_ok (ret)) {
+        close ();
+        return ret;
+    }
+
+    if (_codec == CaptureCodecLossless)
+        _pool = create_coder_pool (_threads);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureFileWriter::write_frame (uint32_t camera, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _fp && buf.ptr () && camera < _cameras.size (), XCAM_RETURN_ERROR_PARAM,
+        "capture file write frame failed, file not opened, buf is NULL or invalid camera:%d", camera);
+
+    const VideoBufferInfo info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, match_camera (_cameras[camera], info), XCAM_RETURN_ERROR_PARAM,
+        "capture file write frame failed, buf format doesn't match camera:%d", camera);
+
+    uint8_t *memory = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, memory, XCAM_RETURN_ERROR_MEM,
+        "capture file write frame failed, map buffer failed");
+
+    uint32_t count = split_stripes (info, memory, _stripes);
+    uint64_t raw_size = 0;
+    for (uint32_t i = 0; i < count; ++i)
+        raw_size += (uint64_t)_stripes[i].row_bytes * _stripes[i].rows;
+
+    CaptureFrameHeader header;
+    xcam_mem_clear (header);
+    header.magic = CAPTURE_FRAME_MAGIC;
+    header.camera = camera;
+    header.timestamp = buf->get_timestamp ();
+    header.codec = _codec;
+    header.payload_size = raw_size;
+
+    if (_codec == CaptureCodecLossless) {
+        if (!code_stripes (_pool, _stripes, count, true)) {
+            buf->unmap ();
+            XCAM_LOG_ERROR ("capture file write frame failed, encode stripes failed");
+            return XCAM_RETURN_ERROR_UNKNOWN;
+        }
+
+        _stripe_sizes.resize (count);
+        header.payload_size = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            _stripe_sizes[i] = _stripes[i].coded.size ();
+            header.payload_size += _stripe_sizes[i];
+        }
+        header.stripe_count = count;
+    }
+
+    IndexEntry entry;
+    entry.camera = camera;
+    entry.timestamp = header.timestamp;
+    entry.offset = _offset;
+
+    XCamReturn ret = write_data (&header, sizeof (header));
+    if (xcam_ret_is_ok (ret) && header.stripe_count)
+        ret = write_data (_stripe_sizes.data (), count * sizeof (uint32_t));
+
+    for (uint32_t i = 0; i < count && xcam_ret_is_ok (ret); ++i) {
+        CaptureStripe &stripe = _stripes[i];
+        if (header.stripe_count) {
+            ret = write_data (stripe.coded.data (), stripe.coded.size ());
+            continue;
+        }
+        for (uint32_t y = 0; y < stripe.rows && xcam_ret_is_ok (ret); ++y)
+            ret = write_data (stripe.plane + (size_t)y * stripe.stride, stripe.row_bytes);
+    }
+    buf->unmap ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "capture file(%s) write frame of camera:%d failed", XCAM_STR (_path), camera);
+
+    _index.push_back (entry);
+    _raw_bytes += raw_size;
+    _coded_bytes += header.payload_size;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+CaptureFileWriter::write_index ()
+{
+    CaptureTrailer trailer;
+    trailer.index_offset = _offset;
+    trailer.frame_count = _index.size ();
+    trailer.magic = CAPTURE_INDEX_MAGIC;
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    for (uint32_t i = 0; i < _index.size () && xcam_ret_is_ok (ret); ++i) {
+        CaptureIndexRecord record;
+        xcam_mem_clear (record);
+        record.camera = _index[i].camera;
+        record.timestamp = _index[i].timestamp;
+        record.offset = _index[i].offset;
+        ret = write_data (&record, sizeof (record));
+    }
+
+    if (xcam_ret_is_ok (ret))
+        ret = write_data (&trailer, sizeof (trailer));
+    return ret;
+}
+
+XCamReturn
+CaptureFileWriter::close ()
+{
+    if (_pool.ptr ()) {
+        _pool->stop ();
+        _pool.release ();
+    }
+    if (!_fp)
+        return XCAM_RETURN_NO_ERROR;
+
+    XCamReturn ret = write_index ();
+    if (fclose (_fp) != 0 && xcam_ret_is_ok (ret))
+        ret = XCAM_RETURN_ERROR_FILE;
+    _fp = NULL;
+
+    if (xcam_ret_is_ok (ret)) {
+        XCAM_LOG_INFO (
+            "capture file(%s) closed, %d frames, %" PRIu64 " bytes coded from %" PRIu64 " bytes",
+            XCAM_STR (_path), (int)_index.size (), _coded_bytes, _raw_bytes);
+    } else {
+        XCAM_LOG_ERROR ("capture file(%s) close failed, index may be lost", XCAM_STR (_path));
+    }
+
+    xcam_free (_path);
+    _path = NULL;
+    return ret;
+}
+
+CaptureFileReader::CaptureFileReader ()
+    : _map_ptr (NULL)
+    , _map_size (0)
+    , _data_offset (0)
+    , _threads (XCAM_CAPTURE_DEFAULT_THREADS)
+{
+}
+
+CaptureFileReader::~CaptureFileReader ()
+{
+    close ();
+}
+
+bool
+CaptureFileReader::is_capture_file (const char *path)
+{
+    if (!path)
+        return false;
+
+    FILE *fp = fopen (path, "rb");
+    if (!fp)
+        return false;
+
+    char magic[8];
+    bool ret = (fread (magic, 1, sizeof (magic), fp) == sizeof (magic) &&
+                !memcmp (magic, XCAM_CAPTURE_FILE_MAGIC, sizeof (magic)));
+    fclose (fp);
+    return ret;
+}
+
+bool
+CaptureFileReader::set_threads (uint32_t threads)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_map_ptr && threads, false,
+        "capture file set threads failed, file opened or threads is 0");
+
+    _threads = threads;
+    return true;
+}
+
+XCamReturn
+CaptureFileReader::open (const char *path)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, path && !_map_ptr, XCAM_RETURN_ERROR_PARAM,
+        "capture file open failed, path is NULL or file opened");
+
+    int fd = ::open (path, O_RDONLY);
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "capture file(%s) open failed, errno:%d", path, errno);
+
+    struct stat st;
+    if (fstat (fd, &st) < 0 || (size_t)st.st_size < sizeof (CaptureFileHeader)) {
+        ::close (fd);
+        XCAM_LOG_ERROR ("capture file(%s) open failed, file is too small", path);
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    void *ptr = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close (fd);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, XCAM_RETURN_ERROR_FILE,
+        "capture file(%s) mmap failed, errno:%d", path, errno);
+
+    _map_ptr = (uint8_t *)ptr;
+    _map_size = st.st_size;
+
+    CaptureFileHeader header;
+    memcpy (&header, _map_ptr, sizeof (header));
+    _data_offset = sizeof (header) + (uint64_t)header.camera_count * sizeof (CaptureCameraRecord);
+    if (memcmp (header.magic, XCAM_CAPTURE_FILE_MAGIC, sizeof (header.magic)) ||
+            header.version != XCAM_CAPTURE_FILE_VERSION ||
+            !header.camera_count || header.camera_count > CAPTURE_MAX_CAMERAS ||
+            _data_offset > _map_size) {
+        XCAM_LOG_ERROR ("capture file(%s) open failed, invalid file header", path);
+        close ();
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    for (uint32_t i = 0; i < header.camera_count; ++i) {
+        CaptureCameraRecord record;
+        memcpy (&record, _map_ptr + sizeof (header) + i * sizeof (record), sizeof (record));
+
+        VideoBufferInfo info;
+        if (!info.init (record.format, record.width, record.height)) {
+            XCAM_LOG_ERROR ("capture file(%s) open failed, invalid format of camera:%d", path, i);
+            close ();
+            return XCAM_RETURN_ERROR_FILE;
+        }
+        _cameras.push_back (info);
+    }
+
+    if (!xcam_ret_is_ok (load_index ()))
+        scan_frames ();
+
+    _pool = create_coder_pool (_threads);
+    XCAM_LOG_INFO (
+        "capture file(%s) opened, %d cameras, %d frames",
+        path, (int)_cameras.size (), (int)_frames.size ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+CaptureFileReader::close ()
+{
+    if (_pool.ptr ()) {
+        _pool->stop ();
+        _pool.release ();
+    }
+    if (_map_ptr) {
+        munmap (_map_ptr, _map_size);
+        _map_ptr = NULL;
+        _map_size = 0;
+    }
+    _cameras.clear ();
+    _frames.clear ();
+}
+
+XCamReturn
+CaptureFileReader::load_index ()
+{
+    if (_map_size < _data_offset + sizeof (CaptureTrailer))
+        return XCAM_RETURN_ERROR_FILE;
+
+    CaptureTrailer trailer;
+    memcpy (&trailer, _map_ptr + _map_size - sizeof (trailer), sizeof (trailer));
+    if (trailer.magic != CAPTURE_INDEX_MAGIC || trailer.index_offset < _data_offset ||
+            trailer.index_offset + (uint64_t)trailer.frame_count * sizeof (CaptureIndexRecord) +
+            sizeof (trailer) != _map_size)
+        return XCAM_RETURN_ERROR_FILE;
+
+    _frames.resize (trailer.frame_count);
+    for (uint32_t i = 0; i < trailer.frame_count; ++i) {
+        CaptureIndexRecord record;
+        memcpy (&record, _map_ptr + trailer.index_offset + i * sizeof (record), sizeof (record));
+        if (record.camera >= _cameras.size () || record.offset < _data_offset ||
+                record.offset + sizeof (CaptureFrameHeader) > trailer.index_offset) {
+            _frames.clear ();
+            return XCAM_RETURN_ERROR_FILE;
+        }
+
+        _frames[i].camera = record.camera;
+        _frames[i].timestamp = record.timestamp;
+        _frames[i].offset = record.offset;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+// walks frames till the end or a broken one, for files not closed
+XCamReturn
+CaptureFileReader::scan_frames ()
+{
+    _frames.clear ();
+
+    uint64_t pos = _data_offset;
+    while (pos + sizeof (CaptureFrameHeader) <= _map_size) {
+        CaptureFrameHeader header;
+        memcpy (&header, _map_ptr + pos, sizeof (header));
+        uint64_t frame_size =
+            sizeof (header) + (uint64_t)header.stripe_count * sizeof (uint32_t) + header.payload_size;
+        if (header.magic != CAPTURE_FRAME_MAGIC || header.camera >= _cameras.size () ||
+                frame_size > _map_size - pos)
+            break;
+
+        Frame frame;
+        frame.camera = header.camera;
+        frame.timestamp = header.timestamp;
+        frame.offset = pos;
+        _frames.push_back (frame);
+        pos += frame_size;
+    }
+
+    XCAM_LOG_WARNING (
+        "capture file has no index, %d frames found, %" PRIu64 " bytes left over",
+        (int)_frames.size (), (uint64_t)(_map_size - pos));
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+CaptureFileReader::get_camera_info (uint32_t camera, VideoBufferInfo &info) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, camera < _cameras.size (), false,
+        "capture file get camera info failed, invalid camera:%d", camera);
+
+    info = _cameras[camera];
+    return true;
+}
+
+bool
+CaptureFileReader::get_frame_info (uint32_t index, uint32_t &camera, int64_t &timestamp) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, index < _frames.size (), false,
+        "capture file get frame info failed, invalid frame index:%d", index);
+
+    camera = _frames[index].camera;
+    timestamp = _frames[index].timestamp;
+    return true;
+}
+
+XCamReturn
+CaptureFileReader::read_frame (uint32_t index, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _map_ptr && buf.ptr () && index < _frames.size (), XCAM_RETURN_ERROR_PARAM,
+        "capture file read frame failed, file not opened, buf is NULL or invalid frame index:%d", index);
+
+    const Frame &frame = _frames[index];
+    const VideoBufferInfo info = buf->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, match_camera (_cameras[frame.camera], info), XCAM_RETURN_ERROR_PARAM,
+        "capture file read frame failed, buf format doesn't match camera:%d", frame.camera);
+
+    CaptureFrameHeader header;
+    memcpy (&header, _map_ptr + frame.offset, sizeof (header));
+    uint64_t sizes_bytes = (uint64_t)header.stripe_count * sizeof (uint32_t);
+    XCAM_FAIL_RETURN (
+        ERROR, header.magic == CAPTURE_FRAME_MAGIC && header.camera == frame.camera &&
+        sizeof (header) + sizes_bytes + header.payload_size <= _map_size - frame.offset,
+        XCAM_RETURN_ERROR_FILE,
+        "capture file read frame failed, frame:%d is broken", index);
+
+    uint8_t *memory = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, memory, XCAM_RETURN_ERROR_MEM,
+        "capture file read frame failed, map buffer failed");
+
+    const uint8_t *data = _map_ptr + frame.offset + sizeof (header) + sizes_bytes;
+    uint32_t count = split_stripes (info, memory, _stripes);
+    bool ok = false;
+
+    if (header.codec == CaptureCodecRaw && !header.stripe_count) {
+        uint64_t raw_size = 0;
+        for (uint32_t i = 0; i < count; ++i)
+            raw_size += (uint64_t)_stripes[i].row_bytes * _stripes[i].rows;
+
+        ok = (raw_size == header.payload_size);
+        for (uint32_t i = 0; i < count && ok; ++i) {
+            CaptureStripe &stripe = _stripes[i];
+            for (uint32_t y = 0; y < stripe.rows; ++y) {
+                memcpy (stripe.plane + (size_t)y * stripe.stride, data, stripe.row_bytes);
+                data += stripe.row_bytes;
+            }
+        }
+    } else if (header.codec == CaptureCodecLossless && header.stripe_count == count) {
+        const uint8_t *sizes = _map_ptr + frame.offset + sizeof (header);
+        uint64_t offset = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t size = 0;
+            memcpy (&size, sizes + i * sizeof (size), sizeof (size));
+            _stripes[i].data = data + offset;
+            _stripes[i].size = size;
+            offset += size;
+        }
+        ok = (offset == header.payload_size) && code_stripes (_pool, _stripes, count, false);
+    }
+    buf->unmap ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, ok, XCAM_RETURN_ERROR_FILE,
+        "capture file read frame failed, frame:%d of codec:%d can't be decoded", index, header.codec);
+
+    buf->set_timestamp (header.timestamp);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
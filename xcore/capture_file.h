@@ -0,0 +1,178 @@
+/*
+ * capture_file.h - compressed multi-camera capture file
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_CAPTURE_FILE_H
+#define XCAM_CAPTURE_FILE_H
+
+#include <xcam_std.h>
+#include <video_buffer.h>
+#include <thread_pool.h>
+#include <vector>
+
+#define XCAM_CAPTURE_FILE_MAGIC "XCAMCAP1"
+#define XCAM_CAPTURE_FILE_VERSION 1
+// rows of a plane coded alone, stripes of a frame are coded in parallel
+#define XCAM_CAPTURE_STRIPE_ROWS 32
+#define XCAM_CAPTURE_DEFAULT_THREADS 4
+
+namespace XCam {
+
+enum CaptureCodec {
+    CaptureCodecRaw = 0,
+    CaptureCodecLossless,
+};
+
+// rows of one plane coded as one unit
+struct CaptureStripe {
+    uint8_t                *plane;
+    uint32_t                stride;
+    uint32_t                row_bytes;
+    uint32_t                rows;
+    uint32_t                channels;
+    // coded data, read from file or written by encoding
+    const uint8_t          *data;
+    size_t                  size;
+    std::vector<uint8_t>    coded;
+    bool                    ok;
+
+    CaptureStripe ();
+};
+
+/*
+ * capture file, frames of several cameras in one file, each frame with its camera and timestamp.
+ * layout, little-endian,
+ *   file header and formats of cameras,
+ *   frames, each a header, sizes of coded stripes and stripes, planes packed without padding,
+ *   index of frames and trailer, written on close.
+ * a file without index, e.g. capture killed, is still read by walking over frames.
+ */
+class CaptureFileWriter
+{
+public:
+    CaptureFileWriter ();
+    ~CaptureFileWriter ();
+
+    // all setters need be called before open
+    bool add_camera (const VideoBufferInfo &info, uint32_t &camera);
+    bool set_codec (CaptureCodec codec);
+    // threads coding stripes, caller thread included
+    bool set_threads (uint32_t threads);
+
+    XCamReturn open (const char *path);
+    // frames of cameras in any order, each keeps timestamp of @buf
+    XCamReturn write_frame (uint32_t camera, const SmartPtr<VideoBuffer> &buf);
+    XCamReturn close ();
+
+    uint32_t get_frame_count () const {
+        return _index.size ();
+    }
+    // bytes of frames before and after coding
+    uint64_t get_raw_bytes () const {
+        return _raw_bytes;
+    }
+    uint64_t get_coded_bytes () const {
+        return _coded_bytes;
+    }
+
+private:
+    XCamReturn write_data (const void *data, size_t size);
+    XCamReturn write_index ();
+
+    XCAM_DEAD_COPY (CaptureFileWriter);
+
+private:
+    struct IndexEntry {
+        uint32_t    camera;
+        int64_t     timestamp;
+        uint64_t    offset;
+    };
+
+    FILE                           *_fp;
+    char                           *_path;
+    std::vector<VideoBufferInfo>    _cameras;
+    std::vector<IndexEntry>         _index;
+    std::vector<CaptureStripe>      _stripes;
+    std::vector<uint32_t>           _stripe_sizes;
+    CaptureCodec                    _codec;
+    uint32_t                        _threads;
+    SmartPtr<ThreadPool>            _pool;
+    uint64_t                        _offset;
+    uint64_t                        _raw_bytes;
+    uint64_t                        _coded_bytes;
+};
+
+class CaptureFileReader
+{
+public:
+    CaptureFileReader ();
+    ~CaptureFileReader ();
+
+    // checks the magic only
+    static bool is_capture_file (const char *path);
+
+    // set before open
+    bool set_threads (uint32_t threads);
+
+    // file is mapped and frames are indexed
+    XCamReturn open (const char *path);
+    void close ();
+    bool is_opened () const {
+        return _map_ptr != NULL;
+    }
+
+    uint32_t get_camera_count () const {
+        return _cameras.size ();
+    }
+    bool get_camera_info (uint32_t camera, VideoBufferInfo &info) const;
+
+    // frames in file order
+    uint32_t get_frame_count () const {
+        return _frames.size ();
+    }
+    bool get_frame_info (uint32_t index, uint32_t &camera, int64_t &timestamp) const;
+    // @buf of camera format, strides of its own, timestamp is set
+    XCamReturn read_frame (uint32_t index, const SmartPtr<VideoBuffer> &buf);
+
+private:
+    XCamReturn load_index ();
+    XCamReturn scan_frames ();
+
+    XCAM_DEAD_COPY (CaptureFileReader);
+
+private:
+    struct Frame {
+        uint32_t    camera;
+        int64_t     timestamp;
+        uint64_t    offset;
+    };
+
+    uint8_t                        *_map_ptr;
+    size_t                          _map_size;
+    uint64_t                        _data_offset;
+    std::vector<VideoBufferInfo>    _cameras;
+    std::vector<Frame>              _frames;
+    std::vector<CaptureStripe>      _stripes;
+    uint32_t                        _threads;
+    SmartPtr<ThreadPool>            _pool;
+};
+
+}
+
+#endif //XCAM_CAPTURE_FILE_H
@@ -58,26 +58,77 @@ MessageThread::loop()
     return false;
 }
 
+class BufferSinkThread
+    : public Thread
+{
+public:
+    explicit BufferSinkThread (DeviceManager *dev_manager)
+        : Thread ("BufferSinkThread")
+        , _manager (dev_manager)
+    {}
+
+protected:
+    virtual bool loop () {
+        XCamReturn ret = _manager->buffer_sink_loop ();
+        return (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_ERROR_TIMEOUT);
+    }
+
+    DeviceManager *_manager;
+};
+
 XCamMessage::XCamMessage (XCamMessageType type, int64_t timestamp, const char *message)
     : timestamp (timestamp)
     , msg_id (type)
     , msg (NULL)
+    , count (1)
+    , text (NULL)
+    , text_capacity (0)
 {
-    if (message)
-        this->msg = strndup (message, XCAM_MAX_STR_SIZE);
+    reset (type, timestamp, message);
 }
 
 XCamMessage::~XCamMessage ()
 {
-    if (msg)
-        xcam_free (msg);
+    if (text)
+        xcam_free (text);
+}
+
+void
+XCamMessage::reset (XCamMessageType type, int64_t timestamp, const char *message)
+{
+    this->timestamp = timestamp;
+    this->msg_id = type;
+    this->msg = NULL;
+    this->count = 1;
+
+    if (!message)
+        return;
+
+    uint32_t size = strnlen (message, XCAM_MAX_STR_SIZE - 1) + 1;
+    if (size > text_capacity) {
+        char *new_text = (char *) realloc (text, size);
+        if (!new_text) {
+            XCAM_LOG_ERROR ("XCamMessage alloc text failed");
+            return;
+        }
+        text = new_text;
+        text_capacity = size;
+    }
+    memcpy (text, message, size - 1);
+    text[size - 1] = '\0';
+    this->msg = text;
 }
 
 DeviceManager::DeviceManager()
     : _has_3a (true)
+    , _dropped_msg_count (0)
     , _is_running (false)
+    , _failed_count (0)
+    , _latest_buffer_only (false)
+    , _latency_stamps (false)
 {
     _3a_process_center = new X3aImageProcessCenter;
+    _msg_batch.reserve (_msg_queue.get_capacity ());
     XCAM_LOG_DEBUG ("~DeviceManager construction");
 }
 
@@ -153,6 +204,26 @@ DeviceManager::set_poll_thread (SmartPtr<PollThread> thread)
     return true;
 }
 
+bool
+DeviceManager::set_latest_buffer_only (bool latest_only)
+{
+    if (is_running())
+        return false;
+
+    _latest_buffer_only = latest_only;
+    return true;
+}
+
+bool
+DeviceManager::set_latency_stamps (bool enable)
+{
+    if (is_running())
+        return false;
+
+    _latency_stamps = enable;
+    return true;
+}
+
 XCamReturn
 DeviceManager::start ()
 {
@@ -222,6 +293,16 @@ DeviceManager::start ()
 
     }
 
+    if (_latest_buffer_only) {
+        _buffer_sink_thread = new BufferSinkThread (this);
+        if (!_buffer_sink_thread->start ())
+            XCAM_FAILED_STOP (ret = XCAM_RETURN_ERROR_THREAD, "start buffer sink thread failed");
+    }
+
+    _msg_thread = new MessageThread (this);
+    if (!_msg_thread->start ())
+        XCAM_FAILED_STOP (ret = XCAM_RETURN_ERROR_THREAD, "start message thread failed");
+
     //Initialize and start poll thread
     XCAM_ASSERT (_poll_thread.ptr ());
     _poll_thread->set_capture_device (_device);
@@ -229,6 +310,8 @@ DeviceManager::start ()
         _poll_thread->set_event_device (_subdevice);
     _poll_thread->set_poll_callback (this);
     _poll_thread->set_stats_callback (this);
+    _poll_thread->set_latency_stamps (_latency_stamps);
+    _frame_latency.reset ();
 
     XCAM_FAILED_STOP (ret = _poll_thread->start(), "start poll failed");
 
@@ -258,6 +341,26 @@ DeviceManager::stop ()
     if (_3a_process_center.ptr())
         _3a_process_center->stop ();
 
+    if (_buffer_sink_thread.ptr ()) {
+        {
+            SmartLock locker (_sink_mutex);
+            _sink_cond.broadcast ();
+        }
+        _buffer_sink_thread->stop ();
+        _buffer_sink_thread.release ();
+        XCAM_LOG_DEBUG ("buffer sink dropped %" PRIu64 " buffers", _latest_buffer.get_dropped_count ());
+    }
+    _latest_buffer.clear ();
+
+    if (_msg_thread.ptr ()) {
+        _msg_queue.pause_pop ();
+        _msg_thread->stop ();
+        _msg_thread.release ();
+        _msg_queue.clear ();
+        _msg_queue.resume_pop ();
+        XCAM_LOG_DEBUG ("message queue dropped %" PRIu64 " messages", _dropped_msg_count.load ());
+    }
+
     if (_subdevice.ptr ())
         _subdevice->stop ();
 
@@ -313,6 +416,7 @@ DeviceManager::scaled_image_ready (const SmartPtr<VideoBuffer> &buffer)
 XCamReturn
 DeviceManager::poll_buffer_ready (SmartPtr<VideoBuffer> &buf)
 {
+    FrameLatencyMeta::stamp (buf, "device-manager");
     if (_has_3a) {
         if (_3a_process_center->put_buffer (buf) == false)
             return XCAM_RETURN_ERROR_UNKNOWN;
@@ -323,6 +427,7 @@ DeviceManager::poll_buffer_ready (SmartPtr<VideoBuffer> &buf)
 XCamReturn
 DeviceManager::poll_buffer_failed (int64_t timestamp, const char *msg)
 {
+    ++_failed_count;
     post_message (XCAM_MESSAGE_BUF_ERROR, timestamp, msg);
     return XCAM_RETURN_NO_ERROR;
 }
@@ -348,12 +453,22 @@ void
 DeviceManager::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
     ImageProcessCallback::process_buffer_done (processor, buf);
+
+    // the last processor is the only producer, never waits for a slow sink
+    if (_buffer_sink_thread.ptr ()) {
+        _latest_buffer.put (buf);
+        SmartLock locker (_sink_mutex);
+        _sink_cond.signal ();
+        return;
+    }
+    FrameLatencyMeta::stamp (buf, "handle-buffer");
     handle_buffer (buf);
 }
 
 void
 DeviceManager::process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
+    ++_failed_count;
     ImageProcessCallback::process_buffer_failed (processor, buf);
 }
 
@@ -366,8 +481,32 @@ DeviceManager::process_image_result_done (ImageProcessor *processor, const Smart
 void
 DeviceManager::post_message (XCamMessageType type, int64_t timestamp, const char *msg)
 {
-    SmartPtr<XCamMessage> new_msg = new XCamMessage (type, timestamp, msg);
-    _msg_queue.push (new_msg);
+    SmartPtr<XCamMessage> new_msg = _msg_pool.try_pop ();
+    if (new_msg.ptr ())
+        new_msg->reset (type, timestamp, msg);
+    else
+        new_msg = new XCamMessage (type, timestamp, msg);
+
+    // callers are capture and processing threads, a stalled handler must not block them
+    if (!_msg_queue.try_push (new_msg)) {
+        ++_dropped_msg_count;
+        XCAM_LOG_DEBUG ("message queue full, message(type:%d) dropped", (int)type);
+        recycle_message (new_msg);
+    }
+}
+
+void
+DeviceManager::recycle_message (const SmartPtr<XCamMessage> &msg)
+{
+    // freed if pool is full
+    _msg_pool.try_push (msg);
+}
+
+void
+DeviceManager::handle_messages (const XCamMessageList &msgs)
+{
+    for (XCamMessageList::const_iterator iter = msgs.begin (); iter != msgs.end (); ++iter)
+        handle_message (*iter);
 }
 
 XCamReturn
@@ -377,7 +516,42 @@ DeviceManager::message_loop ()
     SmartPtr<XCamMessage> msg = _msg_queue.pop (msg_time_out);
     if (!msg.ptr ())
         return XCAM_RETURN_ERROR_THREAD;
-    handle_message (msg);
+
+    // one wakeup takes all pending messages, same type of one frame in a row are coalesced
+    _msg_batch.push_back (msg);
+    while (_msg_batch.size () < _msg_queue.get_capacity () && (msg = _msg_queue.try_pop ()).ptr ()) {
+        SmartPtr<XCamMessage> &last = _msg_batch.back ();
+        if (msg->timestamp != InvalidTimestamp &&
+                last->msg_id == msg->msg_id && last->timestamp == msg->timestamp) {
+            last->count += msg->count;
+            recycle_message (msg);
+            continue;
+        }
+        _msg_batch.push_back (msg);
+    }
+
+    handle_messages (_msg_batch);
+
+    for (XCamMessageList::iterator iter = _msg_batch.begin (); iter != _msg_batch.end (); ++iter)
+        recycle_message (*iter);
+    _msg_batch.clear ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+DeviceManager::buffer_sink_loop ()
+{
+    const static uint32_t sink_time_out = 100000; // 100ms, to check stop
+    SmartPtr<VideoBuffer> buf = _latest_buffer.take_latest ();
+    if (!buf.ptr ()) {
+        SmartLock locker (_sink_mutex);
+        if (!_latest_buffer.has_new ())
+            _sink_cond.timedwait (_sink_mutex, sink_time_out);
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    FrameLatencyMeta::stamp (buf, "handle-buffer");
+    handle_buffer (buf);
     return XCAM_RETURN_NO_ERROR;
 }
 
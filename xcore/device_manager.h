@@ -30,6 +30,9 @@
 #include <image_processor.h>
 #include <poll_thread.h>
 #include <stats_callback_interface.h>
+#include <triple_buffer.h>
+#include <frame_latency.h>
+#include <vector>
 
 namespace XCam {
 
@@ -46,6 +49,8 @@ struct XCamMessage {
     int64_t          timestamp;
     XCamMessageType  msg_id;
     char            *msg;
+    // messages of same type and timestamp coalesced into this one, text is of the first
+    uint32_t         count;
 
     XCamMessage (
         XCamMessageType type,
@@ -53,10 +58,21 @@ struct XCamMessage {
         const char *message = NULL);
     ~XCamMessage ();
 
+    // reuses text storage once it is large enough
+    void reset (XCamMessageType type, int64_t timestamp, const char *message);
+
+private:
+    // storage of msg, kept over reset
+    char            *text;
+    uint32_t         text_capacity;
+
     XCAM_DEAD_COPY (XCamMessage);
 };
 
+typedef std::vector<SmartPtr<XCamMessage> > XCamMessageList;
+
 class MessageThread;
+class BufferSinkThread;
 
 class DeviceManager
     : public PollCallback
@@ -65,6 +81,7 @@ class DeviceManager
     , public ImageProcessCallback
 {
     friend class MessageThread;
+    friend class BufferSinkThread;
 
 public:
     DeviceManager();
@@ -76,6 +93,10 @@ public:
     bool set_smart_analyzer (SmartPtr<SmartAnalyzer> analyzer);
     bool add_image_processor (SmartPtr<ImageProcessor> processor);
     bool set_poll_thread (SmartPtr<PollThread> thread);
+    // handle_buffer runs in own thread on the latest processed buffer, older ones dropped
+    bool set_latest_buffer_only (bool latest_only);
+    // captured frames carry FrameLatencyMeta stamps through processors up to handle_buffer
+    bool set_latency_stamps (bool enable);
 
     SmartPtr<V4l2Device>& get_capture_device () {
         return _device;
@@ -93,12 +114,27 @@ public:
     bool has_3a () const {
         return _has_3a;
     }
+    // stage latencies of frames the output adds once they leave the pipeline
+    FrameLatencyStats &get_frame_latency () {
+        return _frame_latency;
+    }
+    // buffers failed in capture or processing, or replaced before handle_buffer took them
+    uint64_t get_dropped_count () const {
+        return _failed_count.load () + _latest_buffer.get_dropped_count ();
+    }
 
     XCamReturn start ();
     XCamReturn stop ();
 
 protected:
+    /*
+     * messages are delivered by MessageThread and recycled once the handler returns,
+     * handlers copy what they keep instead of holding @msg.
+     * handle_messages gets all pending messages of one wakeup, in order,
+     * default calls handle_message on each.
+     */
     virtual void handle_message (const SmartPtr<XCamMessage> &msg) = 0;
+    virtual void handle_messages (const XCamMessageList &msgs);
     virtual void handle_buffer (const SmartPtr<VideoBuffer> &buf) = 0;
 
 protected:
@@ -119,8 +155,11 @@ protected:
     virtual void process_image_result_done (ImageProcessor *processor, const SmartPtr<X3aResult> &result);
 
 private:
+    // never blocks, message is dropped if the queue is full
     void post_message (XCamMessageType type, int64_t timestamp, const char *msg);
     XCamReturn message_loop ();
+    void recycle_message (const SmartPtr<XCamMessage> &msg);
+    XCamReturn buffer_sink_loop ();
 
     XCAM_DEAD_COPY (DeviceManager);
 
@@ -135,10 +174,25 @@ protected:
     SmartPtr<X3aImageProcessCenter>  _3a_process_center;
 
     /* msg queue */
-    SafeList<XCamMessage>            _msg_queue;
+    SafeRing<XCamMessage>            _msg_queue;
+    SafeRing<XCamMessage>            _msg_pool;
+    XCamMessageList                  _msg_batch;
     SmartPtr<MessageThread>          _msg_thread;
+    std::atomic<uint64_t>            _dropped_msg_count;
 
     bool                             _is_running;
+    std::atomic<uint64_t>            _failed_count;
+
+    /* latest buffer hand-over to handle_buffer */
+    bool                             _latest_buffer_only;
+    TripleBuffer<VideoBuffer>        _latest_buffer;
+    SmartPtr<BufferSinkThread>       _buffer_sink_thread;
+    Mutex                            _sink_mutex;
+    Cond                             _sink_cond;
+
+    /* frame latency stamps */
+    bool                             _latency_stamps;
+    FrameLatencyStats                _frame_latency;
 
     /* smart analysis */
     SmartPtr<SmartAnalyzer>         _smart_analyzer;
@@ -19,6 +19,9 @@
  */
 
 #include "dma_video_buffer.h"
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
 
 namespace XCam {
 
@@ -38,27 +41,100 @@ DmaVideoBuffer::DmaVideoBuffer (const VideoBufferInfo &info, int dma_fd, bool ne
     : VideoBuffer (info)
     , _dma_fd (dma_fd)
     , _need_close_fd (need_close_fd)
+    , _mapped (NULL)
+    , _mapped_size (0)
+    , _map_count (0)
+    , _map_access (CpuReadWrite)
 {
     XCAM_ASSERT (dma_fd >= 0);
 }
 
 DmaVideoBuffer::~DmaVideoBuffer ()
 {
+    XCAM_ASSERT (!_map_count);
+    if (_mapped)
+        munmap (_mapped, _mapped_size);
     if (_need_close_fd && _dma_fd > 0)
         close (_dma_fd);
 }
 
+static bool
+sync_dma_buf (int fd, uint64_t flags)
+{
+    struct dma_buf_sync sync;
+    sync.flags = flags;
+
+    int ret = 0;
+    do {
+        ret = ioctl (fd, DMA_BUF_IOCTL_SYNC, &sync);
+    } while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+
+    // fd without sync support, nothing to flush
+    return ret >= 0 || errno == ENOTTY;
+}
+
+static uint64_t
+dma_sync_access (DmaVideoBuffer::CpuAccess access)
+{
+    uint64_t flags = 0;
+    if (access & DmaVideoBuffer::CpuRead)
+        flags |= DMA_BUF_SYNC_READ;
+    if (access & DmaVideoBuffer::CpuWrite)
+        flags |= DMA_BUF_SYNC_WRITE;
+    return flags;
+}
+
+bool
+DmaVideoBuffer::begin_cpu_access (CpuAccess access)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, sync_dma_buf (_dma_fd, DMA_BUF_SYNC_START | dma_sync_access (access)), false,
+        "DmaVideoBuffer(fd:%d) sync start failed", _dma_fd);
+    return true;
+}
+
+bool
+DmaVideoBuffer::end_cpu_access (CpuAccess access)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, sync_dma_buf (_dma_fd, DMA_BUF_SYNC_END | dma_sync_access (access)), false,
+        "DmaVideoBuffer(fd:%d) sync end failed", _dma_fd);
+    return true;
+}
+
 uint8_t *
 DmaVideoBuffer::map ()
 {
-    XCAM_ASSERT (false && "DmaVideoBuffer::map not supported");
-    return NULL;
+    if (_map_count) {
+        ++_map_count;
+        return _mapped;
+    }
+
+    if (!_mapped) {
+        _mapped_size = get_size ();
+        void *ptr = mmap (NULL, _mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, _dma_fd, 0);
+        XCAM_FAIL_RETURN (
+            ERROR, ptr != MAP_FAILED, NULL,
+            "DmaVideoBuffer(fd:%d) mmap size:%d failed", _dma_fd, (uint32_t)_mapped_size);
+        _mapped = (uint8_t *)ptr;
+    }
+
+    begin_cpu_access (_map_access);
+    ++_map_count;
+    return _mapped;
 }
+
 bool
 DmaVideoBuffer::unmap ()
 {
-    XCAM_ASSERT (false && "DmaVideoBuffer::map not supported");
-    return false;
+    XCAM_FAIL_RETURN (
+        WARNING, _map_count, false,
+        "DmaVideoBuffer(fd:%d) unmap without map", _dma_fd);
+
+    if (--_map_count)
+        return true;
+
+    return end_cpu_access (_map_access);
 }
 
 int
@@ -26,14 +26,33 @@
 
 namespace XCam {
 
+/*
+ * cpu mapping is created on first map and kept till buffer released,
+ * map/unmap pairs only sync cpu caches with DMA_BUF_IOCTL_SYNC.
+ */
 class DmaVideoBuffer
     : public VideoBuffer
 {
+public:
+    enum CpuAccess {
+        CpuRead      = 0x1,
+        CpuWrite     = 0x2,
+        CpuReadWrite = CpuRead | CpuWrite,
+    };
+
 public:
     DmaVideoBuffer (const VideoBufferInfo &info, int dma_fd, bool need_close_fd = false);
 
     virtual ~DmaVideoBuffer ();
 
+    // access synced by following map/unmap, default CpuReadWrite
+    void set_map_access (CpuAccess access) {
+        _map_access = access;
+    }
+    // explicit cache sync around cpu access of mapped data
+    bool begin_cpu_access (CpuAccess access);
+    bool end_cpu_access (CpuAccess access);
+
     virtual uint8_t *map ();
     virtual bool unmap ();
     virtual int get_fd ();
@@ -45,6 +64,10 @@ private:
 private:
     int         _dma_fd;
     bool        _need_close_fd;
+    uint8_t    *_mapped;
+    size_t      _mapped_size;
+    uint32_t    _map_count;
+    CpuAccess   _map_access;
 };
 
 SmartPtr<DmaVideoBuffer> external_buf_to_dma_buf (XCamVideoBuffer *buf);
@@ -29,6 +29,7 @@ DrmBoData::DrmBoData (SmartPtr<DrmDisplay> &display, drm_intel_bo *bo)
     : _display (display)
     , _bo (bo)
     , _buf (NULL)
+    , _map_count (0)
     , _prime_fd (-1)
     , _need_close_fd (true)
 {
@@ -48,7 +49,9 @@ DrmBoData::~DrmBoData ()
 uint8_t *
 DrmBoData::map ()
 {
+    // nested maps share one mapping
     if (_buf) {
+        ++_map_count;
         return _buf;
     }
 
@@ -66,6 +69,7 @@ DrmBoData::map ()
     }
 
     _buf = (uint8_t *)_bo->virt;
+    _map_count = 1;
     return  _buf;
 }
 
@@ -74,6 +78,10 @@ DrmBoData::unmap ()
 {
     if (!_buf || !_bo)
         return true;
+    if (_map_count > 1) {
+        --_map_count;
+        return true;
+    }
 
     uint32_t tiling_mode, swizzle_mode;
 
@@ -89,6 +97,7 @@ DrmBoData::unmap ()
     }
 
     _buf = NULL;
+    _map_count = 0;
     return true;
 }
 
@@ -60,6 +60,7 @@ private:
     SmartPtr<DrmDisplay>       _display;
     drm_intel_bo              *_bo;
     uint8_t                   *_buf;
+    uint32_t                   _map_count;
     int                       _prime_fd;
     bool                      _need_close_fd;
 };
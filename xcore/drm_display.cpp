@@ -25,12 +25,18 @@
 #include <drm_fourcc.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <poll.h>
 
 
 #define DEFAULT_DRM_DEVICE "i915"
 #define DEFAULT_DRM_BUSID "PCI:00:02:00"
 #define DEFAULT_DRM_BATCH_SIZE 0x80000
 
+// framebuffers kept for pool buffers, more than any buffer pool holds
+#define XCAM_DRM_FB_CACHE_SIZE 32
+// a flip finishes on next vblank, several frames at least
+#define XCAM_DRM_FLIP_TIMEOUT 100 // ms
+
 namespace XCam {
 
 SmartPtr<DrmDisplay> DrmDisplay::_instance(NULL);
@@ -77,8 +83,17 @@ DrmDisplay::DrmDisplay (const char *module)
     , _format (0)
     , _width (0)
     , _height (0)
+    , _overlay_plane_id (0)
+    , _overlay_format (0)
+    , _overlay_width (0)
+    , _overlay_height (0)
+    , _atomic (false)
+    , _flip_pending (false)
 {
     xcam_mem_clear(_compose);
+    xcam_mem_clear(_overlay_compose);
+    xcam_mem_clear(_display_fbs);
+    xcam_mem_clear(_pending_fbs);
 
     if (module)
         _module = strndup (module, XCAM_MAX_STR_SIZE);
@@ -111,7 +126,15 @@ DrmDisplay::DrmDisplay (const char *module)
 
 DrmDisplay::~DrmDisplay()
 {
+    if (_flip_pending)
+        wait_flip_done ();
+
+    for (FBMap::iterator i = _buf_fb_handles.begin (); i != _buf_fb_handles.end (); ++i)
+        drmModeRmFB (_fd, i->second.fb_handle);
+    _buf_fb_handles.clear ();
+
     _display_buf.release ();
+    _display_overlay.release ();
 
     if (_buf_manager)
         drm_intel_bufmgr_destroy (_buf_manager);
@@ -239,6 +262,12 @@ DrmDisplay::get_connector(drmModeRes *res)
 
 XCamReturn
 DrmDisplay::get_plane()
+{
+    return find_plane (_format, 0, _plane_id);
+}
+
+XCamReturn
+DrmDisplay::find_plane (uint32_t format, uint32_t excluded, uint32_t &plane_id)
 {
     drmModePlaneResPtr planes = drmModeGetPlaneResources(_fd);
     XCAM_FAIL_RETURN(ERROR, planes, XCAM_RETURN_ERROR_PARAM,
@@ -254,14 +283,15 @@ DrmDisplay::get_plane()
         XCAM_FAIL_RETURN(ERROR, plane, XCAM_RETURN_ERROR_PARAM,
                          "failed to query plane %d: %s", i, strerror(errno));
 
-        if (plane->crtc_id || !(plane->possible_crtcs & (1 << _crtc_index))) {
+        if (plane->plane_id == excluded || plane->crtc_id ||
+                !(plane->possible_crtcs & (1 << _crtc_index))) {
             continue;
         }
 
         for (uint32_t j = 0; j < plane->count_formats; j++) {
             // found a plane matching the requested format
-            if (plane->formats[j] == _format) {
-                _plane_id = plane->plane_id;
+            if (plane->formats[j] == format) {
+                plane_id = plane->plane_id;
                 drmModeFreePlane(plane);
                 drmModeFreePlaneResources(planes);
                 return XCAM_RETURN_NO_ERROR;
@@ -277,6 +307,79 @@ DrmDisplay::get_plane()
     return XCAM_RETURN_ERROR_PARAM;
 }
 
+bool
+DrmDisplay::set_overlay (
+    uint32_t width, uint32_t height, uint32_t format,
+    const struct v4l2_rect* compose)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !is_render_inited () && compose, false,
+        "drm display set overlay failed, %s", (compose ? "render already inited" : "compose is NULL"));
+
+    _overlay_width = width;
+    _overlay_height = height;
+    _overlay_format = to_drm_fourcc (format);
+    _overlay_compose = *compose;
+    return true;
+}
+
+static uint32_t
+get_property_id (int fd, drmModeObjectPropertiesPtr props, const char *name)
+{
+    uint32_t id = 0;
+    for (uint32_t i = 0; i < props->count_props && !id; ++i) {
+        drmModePropertyPtr prop = drmModeGetProperty (fd, props->props[i]);
+        if (prop && !strcmp (prop->name, name))
+            id = prop->prop_id;
+        drmModeFreeProperty (prop);
+    }
+    return id;
+}
+
+bool
+DrmDisplay::get_plane_props (uint32_t plane_id, PlaneProps &props)
+{
+    drmModeObjectPropertiesPtr obj_props = drmModeObjectGetProperties (_fd, plane_id, DRM_MODE_OBJECT_PLANE);
+    XCAM_FAIL_RETURN (
+        WARNING, obj_props, false,
+        "drm get properties of plane:%d failed: %s", plane_id, strerror (errno));
+
+    props.fb_id = get_property_id (_fd, obj_props, "FB_ID");
+    props.crtc_id = get_property_id (_fd, obj_props, "CRTC_ID");
+    props.src_x = get_property_id (_fd, obj_props, "SRC_X");
+    props.src_y = get_property_id (_fd, obj_props, "SRC_Y");
+    props.src_w = get_property_id (_fd, obj_props, "SRC_W");
+    props.src_h = get_property_id (_fd, obj_props, "SRC_H");
+    props.crtc_x = get_property_id (_fd, obj_props, "CRTC_X");
+    props.crtc_y = get_property_id (_fd, obj_props, "CRTC_Y");
+    props.crtc_w = get_property_id (_fd, obj_props, "CRTC_W");
+    props.crtc_h = get_property_id (_fd, obj_props, "CRTC_H");
+    drmModeFreeObjectProperties (obj_props);
+
+    return props.fb_id && props.crtc_id && props.src_x && props.src_y && props.src_w && props.src_h &&
+           props.crtc_x && props.crtc_y && props.crtc_w && props.crtc_h;
+}
+
+bool
+DrmDisplay::init_atomic ()
+{
+    // caps set after planes chosen, universal planes would expose cursor planes to find_plane
+    if (drmSetClientCap (_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 ||
+            drmSetClientCap (_fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+        XCAM_LOG_INFO ("drm atomic modeset not supported, use legacy plane and page flip");
+        return false;
+    }
+
+    if (!get_plane_props (_plane_id, _plane_props) ||
+            (_overlay_plane_id && !get_plane_props (_overlay_plane_id, _overlay_props))) {
+        XCAM_LOG_INFO ("drm plane properties incomplete, use legacy plane and page flip");
+        return false;
+    }
+
+    XCAM_LOG_INFO ("drm display uses atomic commit on plane:%d overlay:%d", _plane_id, _overlay_plane_id);
+    return true;
+}
+
 XCamReturn
 DrmDisplay::render_init (
     uint32_t con_id,
@@ -320,9 +423,20 @@ DrmDisplay::render_init (
                      XCAM_RETURN_ERROR_PARAM,
                      "failed to get plane with required format %s", strerror(errno));
 
+    _overlay_plane_id = 0;
+    if (_overlay_format) {
+        ret = find_plane (_overlay_format, _plane_id, _overlay_plane_id);
+        XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR,
+                         XCAM_RETURN_ERROR_PARAM,
+                         "failed to get overlay plane with required format %s", strerror(errno));
+    }
+
     drmModeFreeResources(resource);
-    if (_display_mode ==  DRM_DISPLAY_MODE_OVERLAY)
+
+    if (_display_mode ==  DRM_DISPLAY_MODE_OVERLAY) {
+        _atomic = init_atomic ();
         _is_render_inited = true;
+    }
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -365,27 +479,20 @@ DrmDisplay::create_drm_buf (
 }
 
 XCamReturn
-DrmDisplay::render_setup_frame_buffer (SmartPtr<VideoBuffer> &buf)
+DrmDisplay::get_bo_handle (SmartPtr<VideoBuffer> &buf, uint32_t &bo_handle)
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    VideoBufferInfo video_info = buf->get_video_info ();
-    uint32_t fourcc = video_info.format;
-    uint32_t fb_handle = 0;
-    uint32_t bo_handle = 0;
-    uint32_t bo_handles[4] = { 0 };
-    FB fb;
     SmartPtr<V4l2BufferProxy> v4l2_proxy;
     SmartPtr<DrmBoBuffer> bo_buf;
 
     v4l2_proxy = buf.dynamic_cast_ptr<V4l2BufferProxy> ();
     bo_buf = buf.dynamic_cast_ptr<DrmBoBuffer> ();
     if (v4l2_proxy.ptr ()) {
+        // same dma-buf always gets the same handle on this fd
         struct drm_prime_handle prime;
         memset(&prime, 0, sizeof (prime));
-        prime.fd = v4l2_proxy->get_v4l2_dma_fd();
+        prime.fd = v4l2_proxy->get_fd();
 
-        ret = (XCamReturn) xcam_device_ioctl(_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime);
-        if (ret) {
+        if (xcam_device_ioctl(_fd, DRM_IOCTL_PRIME_FD_TO_HANDLE, &prime)) {
             XCAM_LOG_WARNING("FD_TO_PRIME_HANDLE failed: %s", strerror(errno));
             return XCAM_RETURN_ERROR_IOCTL;
         }
@@ -400,19 +507,99 @@ DrmDisplay::render_setup_frame_buffer (SmartPtr<VideoBuffer> &buf)
         return XCAM_RETURN_ERROR_PARAM;
     }
 
+    return XCAM_RETURN_NO_ERROR;
+}
+
+DrmDisplay::FB *
+DrmDisplay::find_frame_buffer (SmartPtr<VideoBuffer> &buf)
+{
+    uint32_t bo_handle = 0;
+    if (get_bo_handle (buf, bo_handle) != XCAM_RETURN_NO_ERROR)
+        return NULL;
+
+    FBMap::iterator iter = _buf_fb_handles.find (bo_handle);
+    if (iter == _buf_fb_handles.end ())
+        return NULL;
+
+    const VideoBufferInfo &video_info = buf->get_video_info ();
+    FB &fb = iter->second;
+    if (fb.width != video_info.width || fb.height != video_info.height ||
+            fb.format != video_info.format || fb.stride != video_info.strides[0])
+        return NULL;
+
+    fb.index = global_signal_index++;
+    return &fb;
+}
+
+bool
+DrmDisplay::has_frame_buffer (SmartPtr<VideoBuffer> &buf)
+{
+    return find_frame_buffer (buf) != NULL;
+}
+
+void
+DrmDisplay::evict_frame_buffer ()
+{
+    FBMap::iterator oldest = _buf_fb_handles.end ();
+    for (FBMap::iterator i = _buf_fb_handles.begin (); i != _buf_fb_handles.end (); ++i) {
+        uint32_t fb_handle = i->second.fb_handle;
+        if (fb_handle == _display_fbs[0] || fb_handle == _display_fbs[1] ||
+                fb_handle == _pending_fbs[0] || fb_handle == _pending_fbs[1])
+            continue;
+        if (oldest == _buf_fb_handles.end () || (int32_t)(i->second.index - oldest->second.index) < 0)
+            oldest = i;
+    }
+
+    if (oldest == _buf_fb_handles.end ())
+        return;
+
+    drmModeRmFB (_fd, oldest->second.fb_handle);
+    _buf_fb_handles.erase (oldest);
+}
+
+XCamReturn
+DrmDisplay::render_setup_frame_buffer (SmartPtr<VideoBuffer> &buf)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    VideoBufferInfo video_info = buf->get_video_info ();
+    uint32_t fourcc = video_info.format;
+    uint32_t fb_handle = 0;
+    uint32_t bo_handle = 0;
+    uint32_t bo_handles[4] = { 0 };
+    FB fb;
+
+    if (find_frame_buffer (buf))
+        return XCAM_RETURN_NO_ERROR;
+
+    ret = get_bo_handle (buf, bo_handle);
+    if (ret != XCAM_RETURN_NO_ERROR)
+        return ret;
+
+    // bo reallocated with new geometry
+    FBMap::iterator iter = _buf_fb_handles.find (bo_handle);
+    if (iter != _buf_fb_handles.end ()) {
+        drmModeRmFB (_fd, iter->second.fb_handle);
+        _buf_fb_handles.erase (iter);
+    }
+    if (_buf_fb_handles.size () >= XCAM_DRM_FB_CACHE_SIZE)
+        evict_frame_buffer ();
+
     for (uint32_t i = 0; i < 4; ++i) {
         bo_handles [i] = bo_handle;
     }
 
     ret = (XCamReturn) drmModeAddFB2(_fd, video_info.width, video_info.height, fourcc, bo_handles,
                                      video_info.strides, video_info.offsets, &fb_handle, 0);
+    XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
+                     "drmModeAddFB2 failed: %s", strerror(errno));
 
     fb.fb_handle = fb_handle;
     fb.index = global_signal_index++;
-    _buf_fb_handles[buf.ptr ()] = fb;
-
-    XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_PARAM,
-                     "drmModeAddFB2 failed: %s", strerror(errno));
+    fb.width = video_info.width;
+    fb.height = video_info.height;
+    fb.format = video_info.format;
+    fb.stride = video_info.strides[0];
+    _buf_fb_handles[bo_handle] = fb;
 
     return ret;
 }
@@ -448,6 +635,7 @@ DrmDisplay::set_plane (const FB &fb)
                                        0, 0, _width << 16, _height << 16);
     XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_IOCTL,
                      "failed to set plane via drm: %s", strerror(errno));
+    _display_fbs[0] = fb_handle;
 #if 0
     drmVBlank vblank;
     vblank.request.type = (drmVBlankSeqType) (DRM_VBLANK_EVENT | DRM_VBLANK_RELATIVE);
@@ -460,51 +648,192 @@ DrmDisplay::set_plane (const FB &fb)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+DrmDisplay::set_overlay_plane (const FB &fb)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    ret = (XCamReturn) drmModeSetPlane(_fd, _overlay_plane_id, _crtc_id,
+                                       fb.fb_handle, 0,
+                                       _overlay_compose.left, _overlay_compose.top,
+                                       _overlay_compose.width, _overlay_compose.height,
+                                       0, 0, _overlay_width << 16, _overlay_height << 16);
+    XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_IOCTL,
+                     "failed to set overlay plane via drm: %s", strerror(errno));
+    _display_fbs[1] = fb.fb_handle;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 DrmDisplay::page_flip (const FB &fb)
 {
     XCamReturn ret;
     uint32_t fb_handle = fb.fb_handle;
-    uint32_t index = fb.index;
 
+    // completes on next vblank, see wait_flip_done
     ret = (XCamReturn) drmModePageFlip(_fd, _crtc_id, fb_handle,
-                                       DRM_MODE_PAGE_FLIP_EVENT,
-                                       (void*)(unsigned long) index);
+                                       DRM_MODE_PAGE_FLIP_EVENT, this);
     XCAM_FAIL_RETURN(ERROR, ret == XCAM_RETURN_NO_ERROR, XCAM_RETURN_ERROR_IOCTL,
                      "failed on page flip: %s", strerror(errno));
 
+    _flip_pending = true;
+    _pending_fbs[0] = fb_handle;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+DrmDisplay::add_plane_props (
+    drmModeAtomicReqPtr req, uint32_t plane_id, const PlaneProps &props, uint32_t fb_handle,
+    const struct v4l2_rect &compose, uint32_t width, uint32_t height)
+{
+    bool failed = false;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.fb_id, fb_handle) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.crtc_id, _crtc_id) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.src_x, 0) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.src_y, 0) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.src_w, (uint64_t)width << 16) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.src_h, (uint64_t)height << 16) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.crtc_x, (uint64_t)(int64_t)compose.left) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.crtc_y, (uint64_t)(int64_t)compose.top) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.crtc_w, compose.width) < 0;
+    failed |= drmModeAtomicAddProperty (req, plane_id, props.crtc_h, compose.height) < 0;
+    return !failed;
+}
+
+XCamReturn
+DrmDisplay::atomic_commit (const FB &fb, const FB *overlay_fb)
+{
+    drmModeAtomicReqPtr req = drmModeAtomicAlloc ();
+    XCAM_FAIL_RETURN (ERROR, req, XCAM_RETURN_ERROR_MEM, "drm atomic alloc failed");
+
+    bool ok = add_plane_props (req, _plane_id, _plane_props, fb.fb_handle, _compose, _width, _height);
+    if (ok && overlay_fb)
+        ok = add_plane_props (
+                 req, _overlay_plane_id, _overlay_props, overlay_fb->fb_handle,
+                 _overlay_compose, _overlay_width, _overlay_height);
+
+    int ret = -1;
+    if (ok)
+        ret = drmModeAtomicCommit (_fd, req, DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, this);
+    drmModeAtomicFree (req);
+
+    XCAM_FAIL_RETURN (ERROR, ret == 0, XCAM_RETURN_ERROR_IOCTL,
+                      "drm atomic commit failed: %s", (ok ? strerror (errno) : "add property failed"));
+
+    _flip_pending = true;
+    _pending_fbs[0] = fb.fb_handle;
+    _pending_fbs[1] = overlay_fb ? overlay_fb->fb_handle : _display_fbs[1];
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+DrmDisplay::page_flip_handler (
+    int fd, unsigned int sequence, unsigned int tv_sec, unsigned int tv_usec, void *user_data)
+{
+    XCAM_UNUSED (fd);
+    DrmDisplay *display = (DrmDisplay *)user_data;
+    XCAM_ASSERT (display);
+
+    XCAM_LOG_DEBUG ("drm flip done on vblank:%d at %d.%06ds", sequence, tv_sec, tv_usec);
+
+    // previous buffers are off screen now
+    display->_flip_pending = false;
+    display->_display_buf = display->_pending_buf;
+    display->_pending_buf.release ();
+    if (display->_pending_overlay.ptr ())
+        display->_display_overlay = display->_pending_overlay;
+    display->_pending_overlay.release ();
+    display->_display_fbs[0] = display->_pending_fbs[0];
+    display->_display_fbs[1] = display->_pending_fbs[1] ? display->_pending_fbs[1] : display->_display_fbs[1];
+    xcam_mem_clear (display->_pending_fbs);
+}
+
+XCamReturn
+DrmDisplay::wait_flip_done ()
+{
     drmEventContext evctx;
-    struct timeval timeout = { .tv_sec = 3, .tv_usec = 0 };
-    fd_set fds;
     memset(&evctx, 0, sizeof evctx);
     evctx.version = DRM_EVENT_CONTEXT_VERSION;
-    evctx.vblank_handler = NULL;
-    //evctx.page_flip_handler = page_flip_handler;
-    FD_ZERO(&fds);
-    FD_SET(_fd, &fds);
-    select(_fd + 1, &fds, NULL, NULL, &timeout);
-    drmHandleEvent(_fd, &evctx);
+    evctx.page_flip_handler = page_flip_handler;
+
+    while (_flip_pending) {
+        struct pollfd poll_fd;
+        poll_fd.fd = _fd;
+        poll_fd.events = POLLIN;
+        poll_fd.revents = 0;
+
+        int ret = poll (&poll_fd, 1, XCAM_DRM_FLIP_TIMEOUT);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0) {
+            // don't stall display forever on a lost event
+            XCAM_LOG_WARNING ("drm wait flip event timeout");
+            page_flip_handler (_fd, 0, 0, 0, this);
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        }
+        drmHandleEvent (_fd, &evctx);
+    }
 
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
 DrmDisplay::render_buffer(SmartPtr<VideoBuffer> &buf)
+{
+    SmartPtr<VideoBuffer> overlay;
+    return render_buffers (buf, overlay);
+}
+
+XCamReturn
+DrmDisplay::render_buffers (SmartPtr<VideoBuffer> &buf, SmartPtr<VideoBuffer> &overlay)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    FBMap::iterator iter = _buf_fb_handles.find (buf.ptr ());
+    FB *fb = find_frame_buffer (buf);
+    FB *overlay_fb = NULL;
     XCAM_FAIL_RETURN(
         ERROR,
-        iter != _buf_fb_handles.end (),
+        fb,
         XCAM_RETURN_ERROR_PARAM,
         "buffer not register on framebuf");
-    if(_display_mode == DRM_DISPLAY_MODE_OVERLAY)
-        ret = _plane_id ? set_plane(iter->second) : page_flip(iter->second);
+
+    if (overlay.ptr ()) {
+        XCAM_FAIL_RETURN(
+            ERROR,
+            _overlay_plane_id,
+            XCAM_RETURN_ERROR_PARAM,
+            "overlay plane not set before render_init");
+        overlay_fb = find_frame_buffer (overlay);
+        XCAM_FAIL_RETURN(
+            ERROR,
+            overlay_fb,
+            XCAM_RETURN_ERROR_PARAM,
+            "overlay buffer not register on framebuf");
+    }
+
+    // one flip queued at a time, the frame before is still on screen
+    if (_flip_pending)
+        wait_flip_done ();
+
+    if(_display_mode == DRM_DISPLAY_MODE_OVERLAY && _atomic)
+        ret = atomic_commit (*fb, overlay_fb);
+    else if(_display_mode == DRM_DISPLAY_MODE_OVERLAY)
+        ret = _plane_id ? set_plane(*fb) : page_flip(*fb);
     else if(_display_mode == DRM_DISPLAY_MODE_PRIMARY) {
-        ret = set_crtc (iter->second);
-        ret = page_flip (iter->second);
+        ret = set_crtc (*fb);
+        ret = page_flip (*fb);
+    }
+
+    if (ret == XCAM_RETURN_NO_ERROR && overlay_fb && !_atomic)
+        ret = set_overlay_plane (*overlay_fb);
+
+    if (_flip_pending) {
+        _pending_buf = buf;
+        _pending_overlay = overlay;
+    } else {
+        _display_buf = buf;
+        if (overlay.ptr ())
+            _display_overlay = overlay;
     }
-    _display_buf = buf;
 
     return ret;
 }
@@ -57,11 +57,26 @@ class DrmDisplay {
     friend class DrmBoBufferPool;
     friend class CLBoBufferPool;
 
+    // framebuffer of a bo, cached till bo geometry changes or evicted
     struct FB {
         uint32_t fb_handle;
-        uint32_t index;
+        uint32_t index;     // last use, for eviction
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint32_t stride;
 
-        FB () : fb_handle (0), index (0) {}
+        FB () : fb_handle (0), index (0), width (0), height (0), format (0), stride (0) {}
+    };
+
+    // property ids of a plane for atomic commit
+    struct PlaneProps {
+        uint32_t fb_id;
+        uint32_t crtc_id;
+        uint32_t src_x, src_y, src_w, src_h;
+        uint32_t crtc_x, crtc_y, crtc_w, crtc_h;
+
+        PlaneProps () { xcam_mem_clear (*this); }
     };
 
 public:
@@ -77,6 +92,10 @@ public:
     bool is_render_inited () const {
         return _is_render_inited;
     }
+    // second plane composed by display, set before render_init
+    bool set_overlay (
+        uint32_t width, uint32_t height, uint32_t format,
+        const struct v4l2_rect* compose);
     XCamReturn render_init (
         uint32_t con_id,
         uint32_t crtc_id,
@@ -85,11 +104,13 @@ public:
         uint32_t format,
         const struct v4l2_rect* compose);
 
-    bool has_frame_buffer (SmartPtr<VideoBuffer> &buf) {
-        return _buf_fb_handles.find (buf.ptr ()) != _buf_fb_handles.end ();
-    };
+    bool has_frame_buffer (SmartPtr<VideoBuffer> &buf);
+    // reuses framebuffer created for the same bo before
     XCamReturn render_setup_frame_buffer (SmartPtr<VideoBuffer> &buf);
+    // returns once flip queued, waits the previous flip only
     XCamReturn render_buffer (SmartPtr<VideoBuffer> &buf);
+    // buf and overlay flipped in one commit, overlay needs set_overlay
+    XCamReturn render_buffers (SmartPtr<VideoBuffer> &buf, SmartPtr<VideoBuffer> &overlay);
 
     int get_drm_handle() const {
         return _fd;
@@ -123,12 +144,29 @@ private:
     XCamReturn get_crtc(drmModeRes *res);
     XCamReturn get_connector(drmModeRes *res);
     XCamReturn get_plane();
+    XCamReturn find_plane (uint32_t format, uint32_t excluded, uint32_t &plane_id);
     XCamReturn set_plane(const FB &fb);
+    XCamReturn set_overlay_plane (const FB &fb);
     XCamReturn set_crtc(const FB &fb);
     XCamReturn page_flip(const FB &fb);
 
+    bool init_atomic ();
+    bool get_plane_props (uint32_t plane_id, PlaneProps &props);
+    bool add_plane_props (
+        drmModeAtomicReqPtr req, uint32_t plane_id, const PlaneProps &props, uint32_t fb_handle,
+        const struct v4l2_rect &compose, uint32_t width, uint32_t height);
+    XCamReturn atomic_commit (const FB &fb, const FB *overlay_fb);
+    XCamReturn wait_flip_done ();
+    static void page_flip_handler (
+        int fd, unsigned int sequence, unsigned int tv_sec, unsigned int tv_usec, void *user_data);
+
+    XCamReturn get_bo_handle (SmartPtr<VideoBuffer> &buf, uint32_t &bo_handle);
+    FB *find_frame_buffer (SmartPtr<VideoBuffer> &buf);
+    void evict_frame_buffer ();
+
 private:
-    typedef std::map<const VideoBuffer *, FB> FBMap;
+    // keyed by gem handle, proxies of the same bo share one framebuffer
+    typedef std::map<uint32_t, FB> FBMap;
 
     static bool    _preview_flag;
 
@@ -151,8 +189,25 @@ private:
 
     struct v4l2_rect _compose;
 
+    unsigned int _overlay_plane_id;
+    unsigned int _overlay_format;
+    unsigned int _overlay_width;
+    unsigned int _overlay_height;
+    struct v4l2_rect _overlay_compose;
+
+    bool _atomic;
+    PlaneProps _plane_props;
+    PlaneProps _overlay_props;
+
     FBMap _buf_fb_handles;
+    // on screen till next flip done, queued ones wait for flip event
+    bool _flip_pending;
     SmartPtr<VideoBuffer>  _display_buf;
+    SmartPtr<VideoBuffer>  _display_overlay;
+    SmartPtr<VideoBuffer>  _pending_buf;
+    SmartPtr<VideoBuffer>  _pending_overlay;
+    uint32_t _display_fbs[2];
+    uint32_t _pending_fbs[2];
 
 private:
     XCAM_DEAD_COPY (DrmDisplay);
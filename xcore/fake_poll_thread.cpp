@@ -22,14 +22,34 @@
 #if HAVE_LIBDRM
 #include "drm_bo_buffer.h"
 #endif
+#include <unistd.h>
+#include <time.h>
 
 #define DEFAULT_FPT_BUF_COUNT 4
+// longest sleep of one loop, keeps stop responsive
+#define FPT_MAX_WAIT_USEC 100000
 
 namespace XCam {
 
+static int64_t
+get_monotonic_time ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return XCAM_TIMESPEC_2_USEC (now);
+}
+
 FakePollThread::FakePollThread (const char *raw_path)
     : _raw_path (NULL)
-    , _raw (NULL)
+    , _ts_path (NULL)
+    , _speed (0.0)
+    , _fps (XCAM_FAKE_REPLAY_DEFAULT_FPS)
+    , _frame_interval (0)
+    , _frame_index (0)
+    , _loop_offset (0)
+    , _start_time (-1)
+    , _start_ts (0)
+    , _replaying (false)
 {
     XCAM_ASSERT (raw_path);
 
@@ -41,9 +61,130 @@ FakePollThread::~FakePollThread ()
 {
     if (_raw_path)
         xcam_free (_raw_path);
+    if (_ts_path)
+        xcam_free (_ts_path);
+}
+
+bool
+FakePollThread::set_replay_speed (double speed)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, speed >= 0.0, false,
+        "FakePollThread invalid replay speed:%.2f", speed);
+
+    _speed = speed;
+    return true;
+}
+
+bool
+FakePollThread::set_timestamp_file (const char *path)
+{
+    XCAM_FAIL_RETURN (ERROR, path, false, "FakePollThread timestamp file is NULL");
+
+    if (_ts_path)
+        xcam_free (_ts_path);
+    _ts_path = strndup (path, XCAM_MAX_STR_SIZE);
+    return true;
+}
+
+bool
+FakePollThread::set_frame_rate (double fps)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, fps > 0.0, false,
+        "FakePollThread invalid frame rate:%.2f", fps);
+
+    _fps = fps;
+    return true;
+}
+
+bool
+FakePollThread::set_buffer_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (ERROR, pool.ptr (), false, "FakePollThread buffer pool is NULL");
+
+    _buf_pool = pool;
+    return true;
+}
 
-    if (_raw)
-        fclose (_raw);
+void
+FakePollThread::get_replay_stats (FakeReplayStats &stats)
+{
+    SmartLock locker (_stats_mutex);
+    stats = _stats;
+}
+
+XCamReturn
+FakePollThread::load_timestamps ()
+{
+    _timestamps.clear ();
+
+    char default_path[XCAM_MAX_STR_SIZE];
+    const char *path = _ts_path;
+    if (!path) {
+        snprintf (default_path, sizeof (default_path), "%s.ts", _raw_path);
+        if (access (default_path, R_OK) == 0)
+            path = default_path;
+    }
+
+    if (path) {
+        FILE *fp = fopen (path, "r");
+        XCAM_FAIL_RETURN (
+            ERROR, fp, XCAM_RETURN_ERROR_FILE,
+            "FakePollThread failed to open timestamp file:%s", path);
+
+        char line[128];
+        while (fgets (line, sizeof (line), fp)) {
+            char *end = NULL;
+            long long ts = strtoll (line, &end, 10);
+            if (end == line)
+                continue;
+            _timestamps.push_back ((int64_t)ts);
+        }
+        fclose (fp);
+
+        XCAM_FAIL_RETURN (
+            ERROR, !_timestamps.empty (), XCAM_RETURN_ERROR_FILE,
+            "FakePollThread no timestamp found in file:%s", path);
+    } else if (_capture.is_opened ()) {
+        uint32_t camera = 0;
+        int64_t ts = 0;
+        for (uint32_t i = 0; i < _capture.get_frame_count (); ++i) {
+            _capture.get_frame_info (i, camera, ts);
+            _timestamps.push_back (ts);
+        }
+    }
+
+    // average step of distinct timestamps, used after the listed ones and to loop
+    int64_t span = 0;
+    uint32_t steps = 0;
+    for (size_t i = 1; i < _timestamps.size (); ++i) {
+        if (_timestamps[i] > _timestamps[i - 1]) {
+            span += _timestamps[i] - _timestamps[i - 1];
+            ++steps;
+        }
+    }
+    _frame_interval = steps ? span / steps : (int64_t)(1000000.0 / _fps);
+    if (_frame_interval <= 0)
+        _frame_interval = 1;
+
+    XCAM_LOG_INFO (
+        "FakePollThread replays %s at speed %.2f, %d timestamps, frame interval %" PRId64 "us",
+        _raw_path, _speed, (int)_timestamps.size (), _frame_interval);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+int64_t
+FakePollThread::get_frame_timestamp (uint32_t index) const
+{
+    if (_timestamps.empty ())
+        return (int64_t)index * _frame_interval;
+
+    if (index < _timestamps.size ())
+        return _timestamps[index];
+
+    return _timestamps.back () + (int64_t)(index + 1 - _timestamps.size ()) * _frame_interval;
 }
 
 XCamReturn
@@ -55,12 +196,41 @@ FakePollThread::start()
         XCAM_RETURN_ERROR_FILE,
         "FakePollThread failed due to raw path NULL");
 
-    _raw = fopen (_raw_path, "rb");
-    XCAM_FAIL_RETURN(
-        ERROR,
-        _raw,
-        XCAM_RETURN_ERROR_FILE,
-        "FakePollThread failed to open file:%s", XCAM_STR (_raw_path));
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (CaptureFileReader::is_capture_file (_raw_path)) {
+        ret = _capture.open (_raw_path);
+        XCAM_FAIL_RETURN(
+            ERROR,
+            xcam_ret_is_ok (ret),
+            XCAM_RETURN_ERROR_FILE,
+            "FakePollThread failed to open capture file:%s", _raw_path);
+    } else {
+        ret = _raw.open (_raw_path, "rb");
+        XCAM_FAIL_RETURN(
+            ERROR,
+            xcam_ret_is_ok (ret),
+            XCAM_RETURN_ERROR_FILE,
+            "FakePollThread failed to open file:%s", XCAM_STR (_raw_path));
+
+        if (!xcam_ret_is_ok (_raw.map_file ()))
+            XCAM_LOG_WARNING ("FakePollThread map file:%s failed, read with stdio instead", _raw_path);
+    }
+
+    ret = load_timestamps ();
+    if (!xcam_ret_is_ok (ret)) {
+        _raw.close ();
+        _capture.close ();
+        return ret;
+    }
+
+    _frame_index = 0;
+    _loop_offset = 0;
+    _start_time = -1;
+    {
+        SmartLock locker (_stats_mutex);
+        _stats = FakeReplayStats ();
+        _replaying = true;
+    }
 
     return PollThread::start ();
 }
@@ -68,89 +238,156 @@ FakePollThread::start()
 XCamReturn
 FakePollThread::stop ()
 {
+    {
+        SmartLock locker (_stats_mutex);
+        _replaying = false;
+    }
     if (_buf_pool.ptr ())
         _buf_pool->stop ();
 
-    return PollThread::stop ();;
+    XCamReturn ret = PollThread::stop ();
+    _raw.close ();
+    _capture.close ();
+
+    FakeReplayStats stats;
+    get_replay_stats (stats);
+    XCAM_LOG_INFO (
+        "FakePollThread replay done, emitted:%d, dropped:%d, max late:%.2fms",
+        stats.emitted, stats.dropped, stats.max_late / 1000.0f);
+
+    return ret;
 }
 
 XCamReturn
-FakePollThread::read_buf (SmartPtr<VideoBuffer> &buf)
+FakePollThread::wait_frame_due (int64_t timestamp)
 {
-    uint8_t *dst = buf->map ();
-    const VideoBufferInfo info = buf->get_video_info ();
-    VideoBufferPlanarInfo planar;
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    int64_t now = get_monotonic_time ();
+    if (_start_time < 0) {
+        _start_time = now;
+        _start_ts = timestamp;
+    }
 
-    for (uint32_t index = 0; index < info.components; index++) {
-        info.get_planar_info(planar, index);
-        uint32_t line_bytes = planar.width * planar.pixel_bytes;
-
-        for (uint32_t i = 0; i < planar.height; i++) {
-            if (fread (dst + info.offsets [index] + i * info.strides [index], 1, line_bytes, _raw) < line_bytes) {
-                if (feof (_raw)) {
-                    fseek (_raw, 0, SEEK_SET);
-                    ret = XCAM_RETURN_BYPASS;
-                } else {
-                    XCAM_LOG_ERROR ("poll_buffer_loop failed to read file");
-                    ret = XCAM_RETURN_ERROR_FILE;
-                }
-                goto done;
-            }
+    int64_t due = _start_time + (int64_t)((timestamp - _start_ts) / _speed);
+    if (now < due) {
+        if (due - now > FPT_MAX_WAIT_USEC) {
+            usleep (FPT_MAX_WAIT_USEC);
+            return XCAM_RETURN_ERROR_TIMEOUT;
         }
+        usleep (due - now);
+        now = get_monotonic_time ();
     }
 
-done:
-    buf->unmap ();
-    return ret;
+    SmartLock locker (_stats_mutex);
+    if (now - due > _stats.max_late)
+        _stats.max_late = now - due;
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+FakePollThread::next_frame (const SmartPtr<VideoBuffer> &buf)
+{
+    XCamReturn ret = XCAM_RETURN_BYPASS;
+    if (!_capture.is_opened ())
+        ret = buf.ptr () ? _raw.read_buf (buf) : _raw.skip_buf (_frame_info);
+    else if (_frame_index < _capture.get_frame_count ())
+        ret = buf.ptr () ? _capture.read_frame (_frame_index, buf) : XCAM_RETURN_NO_ERROR;
+    if (ret != XCAM_RETURN_BYPASS)
+        return ret;
+
+    XCAM_FAIL_RETURN (
+        ERROR, _frame_index, XCAM_RETURN_ERROR_FILE,
+        "FakePollThread file:%s is smaller than one frame", _raw_path);
+
+    // loop to file start, timestamps keep going on from last frame
+    _loop_offset += get_frame_timestamp (_frame_index - 1) - get_frame_timestamp (0) + _frame_interval;
+    _frame_index = 0;
+    if (!_capture.is_opened ())
+        _raw.rewind ();
+
+    return XCAM_RETURN_BYPASS;
 }
 
 XCamReturn
 FakePollThread::poll_buffer_loop ()
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<VideoBuffer> buf;
 
     if (!_buf_pool.ptr () && init_buffer_pool () != XCAM_RETURN_NO_ERROR)
         return XCAM_RETURN_ERROR_MEM;
+    _frame_info = _buf_pool->get_video_info ();
 
-    SmartPtr<VideoBuffer> buf = _buf_pool->get_buffer (_buf_pool);
-    if (!buf.ptr ()) {
-        XCAM_LOG_WARNING ("FakePollThread get buffer failed");
-        return XCAM_RETURN_ERROR_MEM;
+    int64_t timestamp = get_frame_timestamp (_frame_index) + _loop_offset;
+    if (_speed > 0.0) {
+        ret = wait_frame_due (timestamp);
+        if (ret != XCAM_RETURN_NO_ERROR)
+            return ret;
+
+        buf = _buf_pool->try_get_buffer (_buf_pool);
+        if (!buf.ptr ()) {
+            SmartLock locker (_stats_mutex);
+            // stopped pool has no buffer either
+            if (!_replaying)
+                return XCAM_RETURN_ERROR_TIMEOUT;
+
+            ret = next_frame (buf);
+            if (ret == XCAM_RETURN_BYPASS)
+                return XCAM_RETURN_ERROR_TIMEOUT;
+            XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "FakePollThread skip frame failed");
+
+            ++_frame_index;
+            ++_stats.dropped;
+            return XCAM_RETURN_NO_ERROR;
+        }
+    } else {
+        buf = _buf_pool->get_buffer (_buf_pool);
+        if (!buf.ptr ()) {
+            XCAM_LOG_WARNING ("FakePollThread get buffer failed");
+            return XCAM_RETURN_ERROR_MEM;
+        }
     }
 
-    ret = read_buf (buf);
-    if (ret == XCAM_RETURN_BYPASS) {
-        ret = read_buf (buf);
+    ret = next_frame (buf);
+    if (ret == XCAM_RETURN_BYPASS)
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "FakePollThread read frame failed");
+
+    ++_frame_index;
+    buf->set_timestamp (timestamp);
+    {
+        SmartLock locker (_stats_mutex);
+        ++_stats.emitted;
     }
 
-    SmartPtr<VideoBuffer> video_buf = buf;
-    if (ret == XCAM_RETURN_NO_ERROR && _poll_callback)
-        return _poll_callback->poll_buffer_ready (video_buf);
+    if (_latency_stamps)
+        FrameLatencyMeta::start (buf, "capture");
+    if (_poll_callback)
+        return _poll_callback->poll_buffer_ready (buf);
 
     return ret;
 }
-
 XCamReturn
 FakePollThread::init_buffer_pool ()
 {
     struct v4l2_format format;
-    if (!_capture_dev.ptr () ||
-            _capture_dev->get_format (format) != XCAM_RETURN_NO_ERROR) {
+    VideoBufferInfo info;
+    if (_capture_dev.ptr () &&
+            _capture_dev->get_format (format) == XCAM_RETURN_NO_ERROR) {
+        info.init(format.fmt.pix.pixelformat,
+                  format.fmt.pix.width,
+                  format.fmt.pix.height, 0, 0, 0);
+    } else if (!_capture.get_camera_count () || !_capture.get_camera_info (0, info)) {
         XCAM_LOG_ERROR ("Can't init buffer pool without format");
         return XCAM_RETURN_ERROR_PARAM;
     }
-    VideoBufferInfo info;
-    info.init(format.fmt.pix.pixelformat,
-              format.fmt.pix.width,
-              format.fmt.pix.height, 0, 0, 0);
 #if HAVE_LIBDRM
     SmartPtr<DrmDisplay> drm_disp = DrmDisplay::instance ();
     SmartPtr<BufferPool> pool = new DrmBoBufferPool (drm_disp);
     XCAM_ASSERT (pool.ptr ());
     _buf_pool = pool;
 
-    if (_buf_pool->set_video_info (info) && _buf_pool->reserve (DEFAULT_FPT_BUF_COUNT))
+    if (_buf_pool->set_video_info (info) && xcam_ret_is_ok (_buf_pool->reserve (DEFAULT_FPT_BUF_COUNT)))
         return XCAM_RETURN_NO_ERROR;
 #endif
 
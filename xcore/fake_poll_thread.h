@@ -23,9 +23,33 @@
 
 #include <xcam_std.h>
 #include <poll_thread.h>
+#include <image_file_handle.h>
+#include <capture_file.h>
+#include <vector>
+
+#define XCAM_FAKE_REPLAY_DEFAULT_FPS 30.0
 
 namespace XCam {
 
+struct FakeReplayStats {
+    uint32_t emitted;
+    // frames skipped in paced replay while all buffers were held downstream
+    uint32_t dropped;
+    // latest emission behind schedule, in microseconds
+    int64_t  max_late;
+
+    FakeReplayStats () : emitted (0), dropped (0), max_late (0) {}
+};
+
+/*
+ * FakePollThread, replays a raw recording through PollThread callbacks.
+ * raw file is mapped and frames of capture format are read in turn, looping at end of file,
+ * frames of a multi-camera recording are interleaved and replayed as they are.
+ * a capture file, see CaptureFileWriter, is decoded instead and replayed with its own timestamps.
+ * each frame carries its recorded timestamp, frames sharing a timestamp are emitted together.
+ * replay speed 0 emits as fast as downstream returns buffers, a paced speed emits by timestamps
+ * and drops frames when no buffer is free.
+ */
 class FakePollThread
     : public PollThread
 {
@@ -33,11 +57,27 @@ public:
     explicit FakePollThread (const char *raw_path);
     ~FakePollThread ();
 
+    // all setters need be called before start
+    // 1.0 is real time, N is N times faster, 0 is as fast as possible (default)
+    bool set_replay_speed (double speed);
+    // text file of recorded timestamps in microseconds, one line per frame,
+    // default is "<raw_path>.ts" if it exists, then timestamps of capture file
+    bool set_timestamp_file (const char *path);
+    // timestamps step by 1/@fps without timestamp file
+    bool set_frame_rate (double fps);
+    // pool of capture format, default is drm bo buffers
+    bool set_buffer_pool (const SmartPtr<BufferPool> &pool);
+
+    void get_replay_stats (FakeReplayStats &stats);
+
     virtual XCamReturn start();
     virtual XCamReturn stop ();
 
 protected:
     virtual XCamReturn poll_buffer_loop ();
+    virtual bool capture_pollable () const {
+        return false;
+    }
 
 private:
     XCAM_DEAD_COPY (FakePollThread);
@@ -46,12 +86,33 @@ private:
         return XCAM_RETURN_ERROR_UNKNOWN;
     }
     XCamReturn init_buffer_pool ();
-    XCamReturn read_buf (SmartPtr<VideoBuffer> &buf);
+    XCamReturn load_timestamps ();
+    int64_t get_frame_timestamp (uint32_t index) const;
+    // waits until frame of @timestamp is due, TIMEOUT if wait is not over
+    XCamReturn wait_frame_due (int64_t timestamp);
+    XCamReturn next_frame (const SmartPtr<VideoBuffer> &buf);
 
 private:
     char                        *_raw_path;
-    FILE                        *_raw;
+    char                        *_ts_path;
+    ImageFileHandle              _raw;
+    CaptureFileReader            _capture;
     SmartPtr<BufferPool>         _buf_pool;
+    VideoBufferInfo              _frame_info;
+
+    double                       _speed;
+    double                       _fps;
+    std::vector<int64_t>         _timestamps;
+    int64_t                      _frame_interval;
+    uint32_t                     _frame_index;
+    int64_t                      _loop_offset;
+    // wall clock of first emitted frame and its timestamp
+    int64_t                      _start_time;
+    int64_t                      _start_ts;
+
+    Mutex                        _stats_mutex;
+    FakeReplayStats              _stats;
+    bool                         _replaying;
 };
 
 };
@@ -38,7 +38,8 @@ public:
         XCAM_UNUSED (arg);
 
         int ret = 0;
-        switch (cmd) {
+        // ioctl numbers with the direction bit set are out of int range
+        switch ((uint32_t) cmd) {
         case VIDIOC_ENUM_FMT:
             ret = -1;
             break;
@@ -37,8 +37,8 @@ public:
     }
     bool end_of_file ();
     XCamReturn open (const char *name, const char *option);
-    XCamReturn close ();
-    XCamReturn rewind ();
+    virtual XCamReturn close ();
+    virtual XCamReturn rewind ();
     XCamReturn get_file_size (size_t &size);
     const char* get_file_name () const {
         return _file_name;
@@ -0,0 +1,239 @@
+/*
+ * fisheye_table_cache.cpp - fisheye dewarp table file cache
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "fisheye_table_cache.h"
+#include "file_handle.h"
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define XCAM_FISHEYE_TABLE_MAGIC 0x43544658 // "XFTC"
+#define XCAM_FISHEYE_TABLE_VERSION 1
+
+namespace XCam {
+
+struct TableHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t key;
+};
+
+// FNV-1a
+static uint64_t
+hash_bytes (uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+FisheyeTableCache::FisheyeTableCache (const char *cache_path)
+    : _key (0)
+    , _table_w (0)
+    , _table_h (0)
+    , _mapped (NULL)
+    , _mapped_size (0)
+{
+    if (!cache_path)
+        cache_path = std::getenv ("XCAM_FISHEYE_TABLE_CACHE_PATH");
+
+    if (cache_path) {
+        _cache_path = cache_path;
+    } else {
+        const char *home_dir = std::getenv ("HOME");
+        _cache_path = home_dir ? home_dir : "/tmp";
+        _cache_path += "/.xcam";
+    }
+}
+
+FisheyeTableCache::~FisheyeTableCache ()
+{
+    unmap ();
+}
+
+void
+FisheyeTableCache::set_key (
+    const IntrinsicParameter &intrinsic, const ExtrinsicParameter &extrinsic,
+    const BowlDataConfig &bowl, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h)
+{
+    uint32_t sizes[5] = {XCAM_FISHEYE_TABLE_VERSION, table_w, table_h, image_w, image_h};
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = hash_bytes (hash, &intrinsic, sizeof (intrinsic));
+    hash = hash_bytes (hash, &extrinsic, sizeof (extrinsic));
+    hash = hash_bytes (hash, &bowl, sizeof (bowl));
+    hash = hash_bytes (hash, sizes, sizeof (sizes));
+
+    _key = hash;
+    _table_w = table_w;
+    _table_h = table_h;
+
+    char file_name[XCAM_MAX_STR_SIZE] = {0};
+    snprintf (file_name, XCAM_MAX_STR_SIZE - 1, "%s/fisheye-%016" PRIx64 ".tbl", _cache_path.c_str (), _key);
+    _file_name = file_name;
+}
+
+bool
+FisheyeTableCache::load (SurViewFisheyeDewarp::MapTable &table)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_file_name.empty (), false,
+        "fisheye table cache load failed, key was not set");
+
+    FileHandle file;
+    if (!xcam_ret_is_ok (file.open (_file_name.c_str (), "rb"))) {
+        XCAM_LOG_DEBUG ("fisheye table cache(%s) not found", _file_name.c_str ());
+        return false;
+    }
+
+    size_t size = 0;
+    TableHeader header;
+    size_t data_size = _table_w * _table_h * sizeof (PointFloat2);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        xcam_ret_is_ok (file.get_file_size (size)) && size == sizeof (header) + data_size &&
+        xcam_ret_is_ok (file.read_file (&header, sizeof (header))),
+        false,
+        "fisheye table cache(%s) size mismatch, ignored", _file_name.c_str ());
+
+    XCAM_FAIL_RETURN (
+        WARNING,
+        header.magic == XCAM_FISHEYE_TABLE_MAGIC && header.version == XCAM_FISHEYE_TABLE_VERSION &&
+        header.width == _table_w && header.height == _table_h && header.key == _key,
+        false,
+        "fisheye table cache(%s) header mismatch, ignored", _file_name.c_str ());
+
+    table.resize (_table_w * _table_h);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.read_file (table.data (), data_size)), false,
+        "fisheye table cache(%s) read data failed", _file_name.c_str ());
+
+    XCAM_LOG_INFO ("fisheye table loaded from cache(%s)", _file_name.c_str ());
+    return true;
+}
+
+const PointFloat2 *
+FisheyeTableCache::map ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_file_name.empty (), NULL,
+        "fisheye table cache map failed, key was not set");
+    unmap ();
+
+    int fd = open (_file_name.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        XCAM_LOG_DEBUG ("fisheye table cache(%s) not found", _file_name.c_str ());
+        return NULL;
+    }
+
+    struct stat st;
+    size_t data_size = _table_w * _table_h * sizeof (PointFloat2);
+    if (fstat (fd, &st) < 0 || (size_t)st.st_size != sizeof (TableHeader) + data_size) {
+        close (fd);
+        XCAM_LOG_WARNING ("fisheye table cache(%s) size mismatch, ignored", _file_name.c_str ());
+        return NULL;
+    }
+
+    void *data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    XCAM_FAIL_RETURN (
+        WARNING, data != MAP_FAILED, NULL,
+        "fisheye table cache map file(%s) failed", _file_name.c_str ());
+
+    const TableHeader *header = (const TableHeader *)data;
+    if (header->magic != XCAM_FISHEYE_TABLE_MAGIC || header->version != XCAM_FISHEYE_TABLE_VERSION ||
+            header->width != _table_w || header->height != _table_h || header->key != _key) {
+        munmap (data, st.st_size);
+        XCAM_LOG_WARNING ("fisheye table cache(%s) header mismatch, ignored", _file_name.c_str ());
+        return NULL;
+    }
+
+    // read once front to back by the upload
+    madvise (data, st.st_size, MADV_SEQUENTIAL);
+    _mapped = data;
+    _mapped_size = st.st_size;
+
+    XCAM_LOG_INFO ("fisheye table mapped from cache(%s)", _file_name.c_str ());
+    return (const PointFloat2 *)((const uint8_t *)data + sizeof (TableHeader));
+}
+
+void
+FisheyeTableCache::unmap ()
+{
+    if (_mapped)
+        munmap (_mapped, _mapped_size);
+    _mapped = NULL;
+    _mapped_size = 0;
+}
+
+bool
+FisheyeTableCache::save (const SurViewFisheyeDewarp::MapTable &table)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_file_name.empty () && table.size () == _table_w * _table_h, false,
+        "fisheye table cache save failed, key was not set or table size mismatch");
+
+    if (access (_cache_path.c_str (), F_OK) == -1) {
+        mkdir (_cache_path.c_str (), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    }
+
+    // write to temporary file first, readers never see partial tables
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    char temp_name[XCAM_MAX_STR_SIZE] = {0};
+    snprintf (
+        temp_name, XCAM_MAX_STR_SIZE - 1, "%s." XCAM_TIMESTAMP_FORMAT,
+        _file_name.c_str (), XCAM_TIMESTAMP_ARGS (XCAM_TIMEVAL_2_USEC (ts)));
+
+    FileHandle file;
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (file.open (temp_name, "wb")), false,
+        "fisheye table cache open file(%s) failed", temp_name);
+
+    TableHeader header;
+    header.magic = XCAM_FISHEYE_TABLE_MAGIC;
+    header.version = XCAM_FISHEYE_TABLE_VERSION;
+    header.width = _table_w;
+    header.height = _table_h;
+    header.key = _key;
+
+    bool ret =
+        xcam_ret_is_ok (file.write_file (&header, sizeof (header))) &&
+        xcam_ret_is_ok (file.write_file (table.data (), table.size () * sizeof (PointFloat2)));
+    file.close ();
+
+    if (!ret || rename (temp_name, _file_name.c_str ()) != 0) {
+        remove (temp_name);
+        XCAM_LOG_WARNING ("fisheye table cache save to file(%s) failed", _file_name.c_str ());
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * fisheye_table_cache.h - fisheye dewarp table file cache
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_FISHEYE_TABLE_CACHE_H
+#define XCAM_FISHEYE_TABLE_CACHE_H
+
+#include <xcam_std.h>
+#include <surview_fisheye_dewarp.h>
+#include <string>
+
+namespace XCam {
+
+/*
+ * Keeps fisheye dewarp tables in files named by a hash of the calibration,
+ * bowl config and table/image size, so static rigs only calculate them once.
+ * Cache path is $XCAM_FISHEYE_TABLE_CACHE_PATH, or $HOME/.xcam by default.
+ */
+class FisheyeTableCache
+{
+public:
+    explicit FisheyeTableCache (const char *cache_path = NULL);
+    ~FisheyeTableCache ();
+
+    void set_key (
+        const IntrinsicParameter &intrinsic, const ExtrinsicParameter &extrinsic,
+        const BowlDataConfig &bowl, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h);
+    const char *get_file_name () const {
+        return _file_name.c_str ();
+    }
+    uint64_t get_key () const {
+        return _key;
+    }
+
+    bool load (SurViewFisheyeDewarp::MapTable &table);
+    bool save (const SurViewFisheyeDewarp::MapTable &table);
+
+    // maps cached table read only for uploading it without a host copy, valid till unmap
+    const PointFloat2 *map ();
+    void unmap ();
+
+private:
+    XCAM_DEAD_COPY (FisheyeTableCache);
+
+private:
+    std::string     _cache_path;
+    std::string     _file_name;
+    uint64_t        _key;
+    uint32_t        _table_w, _table_h;
+    void           *_mapped;
+    size_t          _mapped_size;
+};
+
+}
+
+#endif //XCAM_FISHEYE_TABLE_CACHE_H
@@ -0,0 +1,147 @@
+/*
+ * frame_latency.cpp - per frame latency stamps of pipeline stages
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "frame_latency.h"
+#include <time.h>
+
+namespace XCam {
+
+FrameLatencyMeta::FrameLatencyMeta (int64_t capture_time)
+    : count (0)
+{
+    timestamp = capture_time;
+}
+
+void
+FrameLatencyMeta::stamp (const char *stage)
+{
+    if (count >= XCAM_FRAME_LATENCY_MAX_STAMPS)
+        return;
+
+    Stamp &entry = stamps[count++];
+    strncpy (entry.stage, XCAM_STR (stage), XCAM_FRAME_LATENCY_STAGE_LEN - 1);
+    entry.stage[XCAM_FRAME_LATENCY_STAGE_LEN - 1] = '\0';
+    entry.time = now ();
+}
+
+int64_t
+FrameLatencyMeta::now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+void
+FrameLatencyMeta::start (const SmartPtr<VideoBuffer> &buf, const char *stage)
+{
+    XCAM_ASSERT (buf.ptr ());
+    if (buf->find_typed_metadata<FrameLatencyMeta> ().ptr ())
+        return;
+
+    SmartPtr<FrameLatencyMeta> meta = new FrameLatencyMeta (buf->get_timestamp ());
+    meta->stamp (stage);
+    buf->add_metadata (meta);
+}
+
+void
+FrameLatencyMeta::stamp (const SmartPtr<VideoBuffer> &buf, const char *stage)
+{
+    XCAM_ASSERT (buf.ptr ());
+    SmartPtr<FrameLatencyMeta> meta = buf->find_typed_metadata<FrameLatencyMeta> ();
+    if (meta.ptr ())
+        meta->stamp (stage);
+}
+
+void
+FrameLatencyMeta::carry (const SmartPtr<VideoBuffer> &from, const SmartPtr<VideoBuffer> &to)
+{
+    XCAM_ASSERT (from.ptr () && to.ptr ());
+    if (from.ptr () == to.ptr ())
+        return;
+
+    SmartPtr<FrameLatencyMeta> meta = from->find_typed_metadata<FrameLatencyMeta> ();
+    if (!meta.ptr () || to->find_typed_metadata<FrameLatencyMeta> ().ptr ())
+        return;
+    to->add_metadata (meta);
+}
+
+FrameLatencyStats::FrameLatencyStats (uint32_t window)
+    : _window (window)
+{
+}
+
+void
+FrameLatencyStats::add (const FrameLatencyMeta &meta)
+{
+    SmartLock locker (_mutex);
+
+    for (uint32_t i = 0; i < meta.count; ++i) {
+        const FrameLatencyMeta::Stamp &entry = meta.stamps[i];
+
+        uint32_t index = 0;
+        for (; index < _stages.size (); ++index) {
+            if (_stages[index].name == entry.stage)
+                break;
+        }
+        if (index == _stages.size ()) {
+            Stage stage;
+            stage.name = entry.stage;
+            stage.stats = new LatencyStats (_window);
+            _stages.push_back (stage);
+        }
+
+        _stages[index].stats->add (entry.time - meta.timestamp);
+    }
+}
+
+void
+FrameLatencyStats::add (const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+    SmartPtr<FrameLatencyMeta> meta = buf->find_typed_metadata<FrameLatencyMeta> ();
+    if (meta.ptr ())
+        add (*meta.ptr ());
+}
+
+void
+FrameLatencyStats::reset ()
+{
+    SmartLock locker (_mutex);
+    _stages.clear ();
+}
+
+void
+FrameLatencyStats::get_stages (std::vector<StageLatency> &stages) const
+{
+    SmartLock locker (_mutex);
+
+    stages.resize (_stages.size ());
+    for (uint32_t i = 0; i < _stages.size (); ++i) {
+        const LatencyStats &stats = *_stages[i].stats.ptr ();
+        stages[i].stage = _stages[i].name;
+        stages[i].frames = stats.get_total_count ();
+        stages[i].p50 = stats.get_percentile (50.0);
+        stages[i].p99 = stats.get_percentile (99.0);
+        stages[i].max = stats.get_max ();
+    }
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * frame_latency.h - per frame latency stamps of pipeline stages
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_FRAME_LATENCY_H
+#define XCAM_FRAME_LATENCY_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <meta_data.h>
+#include <latency_stats.h>
+#include <video_buffer.h>
+#include <string>
+
+#define XCAM_FRAME_LATENCY_MAX_STAMPS 16
+#define XCAM_FRAME_LATENCY_STAGE_LEN 32
+
+namespace XCam {
+
+/*
+ * FrameLatencyMeta, monotonic times in microseconds where a frame changes hands.
+ * MetaData::timestamp is the capture time stamps count from. derived buffers share
+ * the meta of their input, a frame is stamped by one thread at a time.
+ */
+struct FrameLatencyMeta
+    : MetaData
+{
+    struct Stamp {
+        char        stage[XCAM_FRAME_LATENCY_STAGE_LEN];
+        int64_t     time;
+    };
+
+    Stamp           stamps[XCAM_FRAME_LATENCY_MAX_STAMPS];
+    uint32_t        count;
+
+    explicit FrameLatencyMeta (int64_t capture_time);
+    // stamps beyond XCAM_FRAME_LATENCY_MAX_STAMPS are dropped
+    void stamp (const char *stage);
+
+    static int64_t now ();
+    // starts stamps of @buf from its timestamp, does nothing if it has stamps already
+    static void start (const SmartPtr<VideoBuffer> &buf, const char *stage);
+    // stamps @buf if it carries stamps
+    static void stamp (const SmartPtr<VideoBuffer> &buf, const char *stage);
+    // @to shares the stamps of @from
+    static void carry (const SmartPtr<VideoBuffer> &from, const SmartPtr<VideoBuffer> &to);
+};
+
+/*
+ * FrameLatencyStats, percentiles of latency from capture to each stage,
+ * stages kept in the order first seen. thread-safe.
+ */
+class FrameLatencyStats
+{
+public:
+    struct StageLatency {
+        std::string     stage;
+        uint64_t        frames;
+        int64_t         p50;
+        int64_t         p99;
+        int64_t         max;
+    };
+
+    explicit FrameLatencyStats (uint32_t window = XCAM_LATENCY_STATS_DEFAULT_WINDOW);
+
+    void add (const FrameLatencyMeta &meta);
+    // adds stamps of @buf if it carries any
+    void add (const SmartPtr<VideoBuffer> &buf);
+    void reset ();
+
+    void get_stages (std::vector<StageLatency> &stages) const;
+
+private:
+    struct Stage {
+        std::string                 name;
+        SmartPtr<LatencyStats>      stats;
+    };
+
+    XCAM_DEAD_COPY (FrameLatencyStats);
+
+private:
+    mutable Mutex               _mutex;
+    std::vector<Stage>          _stages;
+    uint32_t                    _window;
+};
+
+}
+
+#endif //XCAM_FRAME_LATENCY_H
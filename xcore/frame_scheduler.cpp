@@ -0,0 +1,232 @@
+/*
+ * frame_scheduler.cpp - deadline-aware frame scheduler across streams
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <time.h>
+
+namespace XCam {
+
+static int64_t
+get_scheduler_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+FrameScheduler::FrameScheduler (uint32_t stream_inflight)
+    : _stream_inflight (XCAM_MAX (stream_inflight, 1u))
+    , _next_id (0)
+    , _generation (0)
+{
+}
+
+FrameScheduler::~FrameScheduler ()
+{
+    _entries.clear ();
+}
+
+uint32_t
+FrameScheduler::add_stream (uint32_t priority, int64_t budget)
+{
+    SmartLock locker (_mutex);
+    uint32_t stream_id = _next_id++;
+    Stream &stream = _streams[stream_id];
+    stream.priority = priority;
+    stream.budget = XCAM_MAX (budget, (int64_t)0);
+    return stream_id;
+}
+
+void
+FrameScheduler::remove_stream (uint32_t stream_id)
+{
+    SmartLock locker (_mutex);
+    _streams.erase (stream_id);
+    for (EntryList::iterator i = _entries.begin (); i != _entries.end (); ) {
+        if (i->stream_id == stream_id)
+            _entries.erase (i++);
+        else
+            ++i;
+    }
+    ++_generation;
+    _change_cond.broadcast ();
+}
+
+XCamReturn
+FrameScheduler::push (uint32_t stream_id, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    SmartLock locker (_mutex);
+    std::map<uint32_t, Stream>::iterator i_stream = _streams.find (stream_id);
+    XCAM_FAIL_RETURN (
+        WARNING, i_stream != _streams.end (), XCAM_RETURN_ERROR_PARAM,
+        "frame scheduler push failed, stream:%d not added", stream_id);
+
+    Stream &stream = i_stream->second;
+    int64_t now = get_scheduler_time ();
+    Entry entry;
+    entry.stream_id = stream_id;
+    entry.priority = stream.priority;
+    entry.deadline = stream.budget ? now + stream.budget : 0;
+    entry.key = stream.budget ? entry.deadline : now + XCAM_FRAME_SCHEDULER_NO_DEADLINE_SLACK;
+    entry.buf = buf;
+    ++stream.stats.pushed;
+
+    // after all entries ordered before or equal, keeps push order of a stream
+    EntryList::iterator i = _entries.end ();
+    while (i != _entries.begin ()) {
+        EntryList::iterator prev = i;
+        --prev;
+        if (prev->priority > entry.priority ||
+                (prev->priority == entry.priority && prev->key <= entry.key))
+            break;
+        i = prev;
+    }
+    _entries.insert (i, entry);
+
+    ++_generation;
+    _change_cond.broadcast ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+FrameScheduler::is_stream_ready_unsafe (uint32_t stream_id, const Stream &stream) const
+{
+    XCAM_UNUSED (stream_id);
+    return stream.inflight < _stream_inflight;
+}
+
+bool
+FrameScheduler::pop (Job &job, const std::vector<uint32_t> &excluded_streams)
+{
+    SmartLock locker (_mutex);
+    int64_t now = get_scheduler_time ();
+    std::vector<uint32_t> skipped (excluded_streams);
+
+    for (EntryList::iterator i = _entries.begin (); i != _entries.end (); ++i) {
+        if (std::find (skipped.begin (), skipped.end (), i->stream_id) != skipped.end ())
+            continue;
+
+        // first entry of a stream is its oldest frame
+        skipped.push_back (i->stream_id);
+        std::map<uint32_t, Stream>::iterator i_stream = _streams.find (i->stream_id);
+        XCAM_ASSERT (i_stream != _streams.end ());
+        Stream &stream = i_stream->second;
+        if (!is_stream_ready_unsafe (i->stream_id, stream))
+            continue;
+
+        bool expired = i->deadline && now > i->deadline;
+        // passing it on now would overtake frames in flight
+        if (expired && stream.inflight)
+            continue;
+
+        job.stream_id = i->stream_id;
+        job.buf = i->buf;
+        job.deadline = i->deadline;
+        job.expired = expired;
+        _entries.erase (i);
+
+        if (expired) {
+            ++stream.stats.expired;
+        } else {
+            ++stream.inflight;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void
+FrameScheduler::done (uint32_t stream_id)
+{
+    SmartLock locker (_mutex);
+    std::map<uint32_t, Stream>::iterator i_stream = _streams.find (stream_id);
+    if (i_stream == _streams.end ())
+        return;
+
+    Stream &stream = i_stream->second;
+    if (stream.inflight) {
+        --stream.inflight;
+        ++stream.stats.processed;
+    }
+    ++_generation;
+    _change_cond.broadcast ();
+}
+
+uint32_t
+FrameScheduler::get_ready_stream_count ()
+{
+    SmartLock locker (_mutex);
+    std::vector<uint32_t> counted;
+    for (EntryList::iterator i = _entries.begin (); i != _entries.end (); ++i) {
+        if (std::find (counted.begin (), counted.end (), i->stream_id) != counted.end ())
+            continue;
+        counted.push_back (i->stream_id);
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < counted.size (); ++i) {
+        std::map<uint32_t, Stream>::iterator i_stream = _streams.find (counted[i]);
+        if (i_stream != _streams.end () && is_stream_ready_unsafe (counted[i], i_stream->second))
+            ++count;
+    }
+    return count;
+}
+
+bool
+FrameScheduler::get_stream_stats (uint32_t stream_id, StreamStats &stats)
+{
+    SmartLock locker (_mutex);
+    std::map<uint32_t, Stream>::iterator i_stream = _streams.find (stream_id);
+    if (i_stream == _streams.end ())
+        return false;
+
+    stats = i_stream->second.stats;
+    return true;
+}
+
+uint64_t
+FrameScheduler::get_generation ()
+{
+    SmartLock locker (_mutex);
+    return _generation;
+}
+
+void
+FrameScheduler::wait_change (uint64_t generation, uint32_t timeout_us)
+{
+    SmartLock locker (_mutex);
+    if (_generation != generation)
+        return;
+    _change_cond.timedwait (_mutex, timeout_us);
+}
+
+void
+FrameScheduler::wakeup ()
+{
+    SmartLock locker (_mutex);
+    ++_generation;
+    _change_cond.broadcast ();
+}
+
+}
@@ -0,0 +1,126 @@
+/*
+ * frame_scheduler.h - deadline-aware frame scheduler across streams
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_FRAME_SCHEDULER_H
+#define XCAM_FRAME_SCHEDULER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <video_buffer.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#define XCAM_FRAME_SCHEDULER_DEFAULT_INFLIGHT 2
+// frames without deadline sort as if due this long after push, they never expire
+#define XCAM_FRAME_SCHEDULER_NO_DEADLINE_SLACK 100000 // us
+
+namespace XCam {
+
+/*
+ * FrameScheduler, pending frames of all streams ordered by stream priority
+ * first (higher wins), then earliest deadline; deadline is push time plus
+ * the stream latency budget. a stream has at most @stream_inflight frames
+ * taken and not done, frames of one stream leave in push order.
+ * a frame found past its deadline while its stream has nothing in flight
+ * is handed out as expired, consumer should pass it on unprocessed;
+ * these soft-deadline drops are counted per stream.
+ */
+class FrameScheduler
+{
+public:
+    struct Job {
+        uint32_t                stream_id;
+        SmartPtr<VideoBuffer>   buf;
+        int64_t                 deadline; // CLOCK_MONOTONIC us, 0 means none
+        bool                    expired;
+
+        Job () : stream_id (0), deadline (0), expired (false) {}
+    };
+
+    struct StreamStats {
+        uint64_t    pushed;
+        uint64_t    processed;
+        uint64_t    expired;
+
+        StreamStats () : pushed (0), processed (0), expired (0) {}
+    };
+
+private:
+    struct Stream {
+        uint32_t        priority;
+        int64_t         budget;
+        uint32_t        inflight;
+        StreamStats     stats;
+
+        Stream () : priority (0), budget (0), inflight (0) {}
+    };
+
+    struct Entry {
+        uint32_t                stream_id;
+        uint32_t                priority;
+        int64_t                 key;
+        int64_t                 deadline;
+        SmartPtr<VideoBuffer>   buf;
+    };
+    typedef std::list<Entry> EntryList;
+
+public:
+    explicit FrameScheduler (uint32_t stream_inflight = XCAM_FRAME_SCHEDULER_DEFAULT_INFLIGHT);
+    ~FrameScheduler ();
+
+    // @budget in us, 0 means frames of the stream have no deadline
+    uint32_t add_stream (uint32_t priority, int64_t budget);
+    // pending frames of the stream are dropped
+    void remove_stream (uint32_t stream_id);
+
+    XCamReturn push (uint32_t stream_id, const SmartPtr<VideoBuffer> &buf);
+    // never block; false if no stream is allowed to give a frame
+    bool pop (Job &job, const std::vector<uint32_t> &excluded_streams = std::vector<uint32_t> ());
+    // a job not expired is done by consumer
+    void done (uint32_t stream_id);
+
+    // streams allowed to give a frame now
+    uint32_t get_ready_stream_count ();
+    bool get_stream_stats (uint32_t stream_id, StreamStats &stats);
+
+    // changes on every push and done, wait_change returns early once it moves on
+    uint64_t get_generation ();
+    void wait_change (uint64_t generation, uint32_t timeout_us);
+    void wakeup ();
+
+private:
+    bool is_stream_ready_unsafe (uint32_t stream_id, const Stream &stream) const;
+
+    XCAM_DEAD_COPY (FrameScheduler);
+
+private:
+    uint32_t                         _stream_inflight;
+    std::map<uint32_t, Stream>       _streams;
+    EntryList                        _entries;
+    uint32_t                         _next_id;
+    uint64_t                         _generation;
+    Mutex                            _mutex;
+    Cond                             _change_cond;
+};
+
+}
+
+#endif //XCAM_FRAME_SCHEDULER_H
@@ -0,0 +1,208 @@
+/*
+ * gyro_stabilizer.cpp - video stabilization from gyro poses only
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "gyro_stabilizer.h"
+
+namespace XCam {
+
+GyroStabilizer::GyroStabilizer ()
+    : _motion_filter (15, 10)
+    , _world_to_device (AXIS_X, AXIS_MINUS_Z, AXIS_NONE)
+    , _device_to_image (AXIS_X, AXIS_Y, AXIS_Y)
+    , _filter_radius (15)
+    , _bands (1)
+    , _width (0)
+    , _height (0)
+    , _frame_id (-1)
+{
+}
+
+XCamReturn
+GyroStabilizer::set_sensor_calibration (CalibrationParams &params)
+{
+    _calib_params = params;
+    return _projector.set_sensor_calibration (params);
+}
+
+XCamReturn
+GyroStabilizer::set_camera_intrinsics (
+    double focal_x, double focal_y, double offset_x, double offset_y, double skew)
+{
+    _calib_params.focal_x = focal_x;
+    _calib_params.focal_y = focal_y;
+    _calib_params.offset_x = offset_x;
+    _calib_params.offset_y = offset_y;
+    _calib_params.skew = skew;
+    return _projector.set_camera_intrinsics (focal_x, focal_y, offset_x, offset_y, skew);
+}
+
+void
+GyroStabilizer::align_coordinate_system (
+    const CoordinateSystemConv &world_to_device, const CoordinateSystemConv &device_to_image)
+{
+    _world_to_device = world_to_device;
+    _device_to_image = device_to_image;
+}
+
+XCamReturn
+GyroStabilizer::set_motion_filter (uint32_t radius, float stdev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, radius > 0 && _frame_id < 0, XCAM_RETURN_ERROR_PARAM,
+        "gyro stabilizer set motion filter failed, %s", (radius ? "frames already pushed" : "radius is 0"));
+
+    _filter_radius = radius;
+    _motion_filter.set_filters (radius, stdev);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+GyroStabilizer::set_row_bands (uint32_t bands)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, bands >= 1 && bands <= XCAM_GYRO_STAB_MAX_BANDS, XCAM_RETURN_ERROR_PARAM,
+        "gyro stabilizer row bands(%d) out of range [1, %d]", bands, XCAM_GYRO_STAB_MAX_BANDS);
+
+    _bands = bands;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+GyroStabilizer::reset ()
+{
+    _frame_id = -1;
+    _motions.clear ();
+    _band_list.clear ();
+}
+
+Mat3d
+GyroStabilizer::calc_extrinsics (
+    int64_t ts, const std::vector<int64_t> &pose_ts,
+    const std::vector<Vec4d> &orientation, const std::vector<Vec3d> &translation)
+{
+    Mat3d ext = _projector.calc_camera_extrinsics (ts, pose_ts, orientation, translation);
+    return _projector.align_coordinate_system (_world_to_device, ext, _device_to_image);
+}
+
+XCamReturn
+GyroStabilizer::push_frame (int64_t frame_ts, const DevicePoseList &poses, GyroWarp &warp)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _width && _height, XCAM_RETURN_ERROR_ORDER,
+        "gyro stabilizer frame size not set");
+
+    std::vector<int64_t> pose_ts;
+    std::vector<Vec4d> orientation;
+    std::vector<Vec3d> translation;
+    pose_ts.reserve (poses.size ());
+    orientation.reserve (poses.size ());
+    translation.reserve (poses.size ());
+    for (DevicePoseList::const_iterator i = poses.begin (); i != poses.end (); ++i) {
+        const SmartPtr<DevicePose> &pose = *i;
+        pose_ts.push_back (pose->timestamp);
+        orientation.push_back (Vec4d (
+                                   pose->orientation[0], pose->orientation[1],
+                                   pose->orientation[2], pose->orientation[3]));
+        translation.push_back (Vec3d (pose->translation[0], pose->translation[1], pose->translation[2]));
+    }
+
+    ++_frame_id;
+    Mat3d extrinsic;
+    std::vector<Mat3d> band_inv (_bands);
+    if (!poses.empty ()) {
+        extrinsic = calc_extrinsics (frame_ts, pose_ts, orientation, translation);
+
+        // row band centers are exposed readout_time * (b + 0.5) / bands after first row
+        for (uint32_t b = 0; b < _bands && _bands > 1; ++b) {
+            int64_t band_ts = frame_ts + (int64_t)(_calib_params.readout_time * (b + 0.5) / _bands);
+            Mat3d band_ext = calc_extrinsics (band_ts, pose_ts, orientation, translation);
+            band_inv[b] = _projector.calc_projective (band_ext, extrinsic);
+        }
+    }
+
+    if (_frame_id > 0) {
+        if (_motions.size () >= 2 * _filter_radius + 1)
+            _motions.pop_front ();
+        _motions.push_back (_projector.calc_projective (_last_extrinsic, extrinsic));
+    }
+    _last_extrinsic = extrinsic;
+
+    // corrections are used when the frame comes out of filter window
+    if (_band_list.size () >= _filter_radius + 1)
+        _band_list.pop_front ();
+    _band_list.push_back (band_inv);
+
+    if (_frame_id < _filter_radius)
+        return XCAM_RETURN_BYPASS;
+
+    int64_t stab_id = _frame_id - _filter_radius;
+    int32_t stab_pos = XCAM_MIN (stab_id, (int64_t)_filter_radius + 1);
+    Mat3d proj_mat = _motion_filter.stabilize (stab_pos, _motions, _frame_id);
+
+    warp.frame_id = stab_id;
+    warp.width = _width;
+    warp.height = _height;
+    warp.proj_inv = proj_mat.inverse ();
+    warp.band_inv = _band_list.front ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+static inline Vec3d
+normalize_point (const Vec3d &p)
+{
+    double w = fabs (p[2]) > 1e-9 ? p[2] : 1e-9;
+    return Vec3d (p[0] / w, p[1] / w, 1.0);
+}
+
+void
+GyroStabilizer::build_lookup_table (
+    const GyroWarp &warp, uint32_t table_w, uint32_t table_h, PointFloat2 *table)
+{
+    XCAM_ASSERT (table && table_w && table_h && warp.width && warp.height && !warp.band_inv.empty ());
+
+    uint32_t bands = warp.band_inv.size ();
+    double step_x = (double)warp.width / table_w;
+    double step_y = (double)warp.height / table_h;
+
+    for (uint32_t ty = 0; ty < table_h; ++ty) {
+        PointFloat2 *line = table + ty * table_w;
+        for (uint32_t tx = 0; tx < table_w; ++tx) {
+            Vec3d ref = normalize_point (warp.proj_inv * Vec3d (tx * step_x, ty * step_y, 1.0));
+            if (bands == 1) {
+                line[tx] = PointFloat2 (ref[0], ref[1]);
+                continue;
+            }
+
+            // blend neighbouring bands, band edges would show as tearing
+            double pos = ref[1] * bands / warp.height - 0.5;
+            int32_t b0 = XCAM_CLAMP ((int32_t)floor (pos), 0, (int32_t)bands - 1);
+            int32_t b1 = XCAM_MIN (b0 + 1, (int32_t)bands - 1);
+            double weight = XCAM_CLAMP (pos - b0, 0.0, 1.0);
+
+            Vec3d in0 = normalize_point (warp.band_inv[b0] * ref);
+            Vec3d in1 = normalize_point (warp.band_inv[b1] * ref);
+            line[tx] = PointFloat2 (
+                           in0[0] + (in1[0] - in0[0]) * weight,
+                           in0[1] + (in1[1] - in0[1]) * weight);
+        }
+    }
+}
+
+}
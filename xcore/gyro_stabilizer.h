@@ -0,0 +1,110 @@
+/*
+ * gyro_stabilizer.h - video stabilization from gyro poses only
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_GYRO_STABILIZER_H
+#define XCAM_GYRO_STABILIZER_H
+
+#include <xcam_std.h>
+#include <meta_data.h>
+#include <image_projector.h>
+#include <motion_filter.h>
+#include <interface/data_types.h>
+#include <list>
+#include <vector>
+
+#define XCAM_GYRO_STAB_MAX_BANDS 64
+
+namespace XCam {
+
+// maps output pixels of a stabilized frame to its input pixels
+struct GyroWarp {
+    int64_t               frame_id;
+    uint32_t              width;
+    uint32_t              height;
+    // output to the frame at its first row time
+    Mat3d                 proj_inv;
+    // first row time to each row band, rolling shutter correction
+    std::vector<Mat3d>    band_inv;
+
+    GyroWarp () : frame_id (-1), width (0), height (0) {}
+};
+
+/*
+ * pure gyro path of video stabilization, no image is analyzed.
+ * camera orientation of each frame and row band comes from interpolated poses,
+ * motions are smoothed by MotionFilter, so output lags input by filter radius frames.
+ */
+class GyroStabilizer
+{
+    typedef std::list<std::vector<Mat3d> > BandList;
+
+public:
+    explicit GyroStabilizer ();
+
+    // readout_time and gyro_delay in the unit of frame timestamps
+    XCamReturn set_sensor_calibration (CalibrationParams &params);
+    XCamReturn set_camera_intrinsics (
+        double focal_x, double focal_y, double offset_x, double offset_y, double skew);
+    void align_coordinate_system (
+        const CoordinateSystemConv &world_to_device, const CoordinateSystemConv &device_to_image);
+    XCamReturn set_motion_filter (uint32_t radius, float stdev);
+    // bands of rolling shutter correction, 1 disables it
+    XCamReturn set_row_bands (uint32_t bands);
+    void set_frame_size (uint32_t width, uint32_t height) {
+        _width = width;
+        _height = height;
+    }
+
+    void reset ();
+
+    // poses around frame_ts, XCAM_RETURN_BYPASS till filter window filled
+    XCamReturn push_frame (int64_t frame_ts, const DevicePoseList &poses, GyroWarp &warp);
+
+    // input coords of table_w x table_h points evenly covering output, for GeoMapper::set_lookup_table
+    static void build_lookup_table (
+        const GyroWarp &warp, uint32_t table_w, uint32_t table_h, PointFloat2 *table);
+
+private:
+    Mat3d calc_extrinsics (
+        int64_t ts, const std::vector<int64_t> &pose_ts,
+        const std::vector<Vec4d> &orientation, const std::vector<Vec3d> &translation);
+
+    XCAM_DEAD_COPY (GyroStabilizer);
+
+private:
+    ImageProjector            _projector;
+    MotionFilter              _motion_filter;
+    CalibrationParams         _calib_params;
+    CoordinateSystemConv      _world_to_device;
+    CoordinateSystemConv      _device_to_image;
+    uint32_t                  _filter_radius;
+    uint32_t                  _bands;
+    uint32_t                  _width;
+    uint32_t                  _height;
+
+    int64_t                   _frame_id;
+    Mat3d                     _last_extrinsic;
+    std::list<Mat3d>          _motions; //motions[i] calculated from frame i to i+1
+    BandList                  _band_list;
+};
+
+}
+
+#endif //XCAM_GYRO_STABILIZER_H
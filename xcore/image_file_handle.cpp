@@ -20,15 +20,22 @@
  */
 
 #include "image_file_handle.h"
+#include <sys/mman.h>
 
 namespace XCam {
 
 ImageFileHandle::ImageFileHandle ()
+    : _map_ptr (NULL)
+    , _map_size (0)
+    , _map_pos (0)
 {
 }
 
 ImageFileHandle::ImageFileHandle (const char *name, const char *option)
     : FileHandle (name, option)
+    , _map_ptr (NULL)
+    , _map_size (0)
+    , _map_pos (0)
 {
 }
 
@@ -37,6 +44,99 @@ ImageFileHandle::~ImageFileHandle ()
     close ();
 }
 
+XCamReturn
+ImageFileHandle::map_file ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, is_valid () && !_map_ptr, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) map failed, file is not opened or already mapped", XCAM_STR (get_file_name ()));
+
+    size_t size = 0;
+    XCamReturn ret = get_file_size (size);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret) && size, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) map failed, invalid file size", XCAM_STR (get_file_name ()));
+
+    void *ptr = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fileno (_fp), 0);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) mmap failed, errno:%d", XCAM_STR (get_file_name ()), errno);
+
+    // frames are read once from start to end
+    madvise (ptr, size, MADV_SEQUENTIAL);
+
+    _map_ptr = (uint8_t *)ptr;
+    _map_size = size;
+    _map_pos = 0;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileHandle::close ()
+{
+    if (_map_ptr) {
+        munmap (_map_ptr, _map_size);
+        _map_ptr = NULL;
+        _map_size = 0;
+        _map_pos = 0;
+    }
+
+    return FileHandle::close ();
+}
+
+XCamReturn
+ImageFileHandle::rewind ()
+{
+    _map_pos = 0;
+    return FileHandle::rewind ();
+}
+
+size_t
+ImageFileHandle::get_frame_size (const VideoBufferInfo &info)
+{
+    VideoBufferPlanarInfo planar;
+    size_t frame_size = 0;
+
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        frame_size += planar.width * planar.pixel_bytes * planar.height;
+    }
+    return frame_size;
+}
+
+XCamReturn
+ImageFileHandle::read_mapped_buf (const SmartPtr<VideoBuffer> &buf)
+{
+    const VideoBufferInfo info = buf->get_video_info ();
+    VideoBufferPlanarInfo planar;
+
+    size_t frame_size = get_frame_size (info);
+    if (_map_pos + frame_size > _map_size) {
+        _map_pos = _map_size;
+        return XCAM_RETURN_BYPASS;
+    }
+
+    uint8_t *memory = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, memory, XCAM_RETURN_ERROR_MEM,
+        "image file(%s) read failed, map buffer failed", XCAM_STR (get_file_name ()));
+
+    const uint8_t *src = _map_ptr + _map_pos;
+    for (uint32_t index = 0; index < info.components; index++) {
+        info.get_planar_info (planar, index);
+        uint32_t line_bytes = planar.width * planar.pixel_bytes;
+
+        for (uint32_t i = 0; i < planar.height; i++) {
+            memcpy (memory + info.offsets [index] + i * info.strides [index], src, line_bytes);
+            src += line_bytes;
+        }
+    }
+    buf->unmap ();
+
+    _map_pos += frame_size;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 ImageFileHandle::read_buf (const SmartPtr<VideoBuffer> &buf)
 {
@@ -47,6 +147,9 @@ ImageFileHandle::read_buf (const SmartPtr<VideoBuffer> &buf)
 
     XCAM_ASSERT (is_valid ());
 
+    if (_map_ptr)
+        return read_mapped_buf (buf);
+
     memory = buf->map ();
     for (uint32_t index = 0; index < info.components; index++) {
         info.get_planar_info (planar, index);
@@ -67,6 +170,38 @@ ImageFileHandle::read_buf (const SmartPtr<VideoBuffer> &buf)
     return ret;
 }
 
+XCamReturn
+ImageFileHandle::skip_buf (const VideoBufferInfo &info)
+{
+    XCAM_ASSERT (is_valid ());
+
+    size_t frame_size = get_frame_size (info);
+    if (_map_ptr) {
+        if (_map_pos + frame_size > _map_size) {
+            _map_pos = _map_size;
+            return XCAM_RETURN_BYPASS;
+        }
+        _map_pos += frame_size;
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    size_t size = 0;
+    long pos = ftell (_fp);
+    XCAM_FAIL_RETURN (
+        ERROR, pos >= 0 && xcam_ret_is_ok (get_file_size (size)), XCAM_RETURN_ERROR_FILE,
+        "image file(%s) skip failed, invalid file position", XCAM_STR (get_file_name ()));
+
+    if ((size_t)pos + frame_size > size) {
+        fseek (_fp, 0L, SEEK_END);
+        return XCAM_RETURN_BYPASS;
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, fseek (_fp, (long)frame_size, SEEK_CUR) == 0, XCAM_RETURN_ERROR_FILE,
+        "image file(%s) skip failed, seek error", XCAM_STR (get_file_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 ImageFileHandle::write_buf (const SmartPtr<VideoBuffer> &buf)
 {
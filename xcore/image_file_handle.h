@@ -35,11 +35,32 @@ public:
     explicit ImageFileHandle (const char *name, const char *option);
     virtual ~ImageFileHandle ();
 
+    // maps the whole file opened for reading, read_buf copies frames from the mapping
+    // instead of fread, released on close
+    XCamReturn map_file ();
+    bool is_mapped () const {
+        return _map_ptr != NULL;
+    }
+
     XCamReturn read_buf (const SmartPtr<VideoBuffer> &buf);
     XCamReturn write_buf (const SmartPtr<VideoBuffer> &buf);
+    // moves over one frame of @info without reading it, BYPASS at end of file
+    XCamReturn skip_buf (const VideoBufferInfo &info);
+
+    // derived from FileHandle
+    virtual XCamReturn close ();
+    virtual XCamReturn rewind ();
 
 private:
+    static size_t get_frame_size (const VideoBufferInfo &info);
+    XCamReturn read_mapped_buf (const SmartPtr<VideoBuffer> &buf);
+
     XCAM_DEAD_COPY (ImageFileHandle);
+
+private:
+    uint8_t        *_map_ptr;
+    size_t          _map_size;
+    size_t          _map_pos;
 };
 
 }
@@ -0,0 +1,329 @@
+/*
+ * image_file_stream.cpp - image file reader and writer with their own I/O thread
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "image_file_stream.h"
+#include "xcam_thread.h"
+
+// reader retries when all pool buffers are held by others, in microseconds
+#define XCAM_FILE_READER_RETRY_TIME 2000
+
+namespace XCam {
+
+class FileReadThread
+    : public Thread
+{
+public:
+    explicit FileReadThread (ImageFileReader *reader)
+        : Thread ("file_reader")
+        , _reader (reader)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _reader->read_ahead ();
+    }
+
+private:
+    ImageFileReader   *_reader;
+};
+
+class FileWriteThread
+    : public Thread
+{
+public:
+    explicit FileWriteThread (ImageFileWriter *writer)
+        : Thread ("file_writer")
+        , _writer (writer)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _writer->write_behind ();
+    }
+
+private:
+    ImageFileWriter   *_writer;
+};
+
+ImageFileReader::ImageFileReader (uint32_t depth)
+    : _depth (XCAM_MAX (depth, 1u))
+    , _status (XCAM_RETURN_NO_ERROR)
+    , _stopping (false)
+{
+}
+
+ImageFileReader::~ImageFileReader ()
+{
+    close ();
+}
+
+XCamReturn
+ImageFileReader::open (const char *name, const SmartPtr<BufferPool> &pool, bool use_mmap)
+{
+    close ();
+
+    XCAM_FAIL_RETURN (
+        ERROR, name && pool.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "image file reader open failed, file name or buffer pool is NULL");
+
+    XCamReturn ret = _file.open (name, "rb");
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "image file reader open file(%s) failed", name);
+
+    if (use_mmap && !xcam_ret_is_ok (_file.map_file ())) {
+        XCAM_LOG_WARNING ("image file reader(%s) falls back to fread", name);
+    }
+
+    _pool = pool;
+    return start_thread ();
+}
+
+XCamReturn
+ImageFileReader::close ()
+{
+    stop_thread ();
+    _pool.release ();
+    return _file.close ();
+}
+
+XCamReturn
+ImageFileReader::rewind ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "image file reader rewind failed, file is not opened");
+
+    stop_thread ();
+
+    XCamReturn ret = _file.rewind ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "image file reader(%s) rewind failed", XCAM_STR (get_file_name ()));
+
+    return start_thread ();
+}
+
+XCamReturn
+ImageFileReader::start_thread ()
+{
+    XCAM_ASSERT (!_thread.ptr ());
+    {
+        SmartLock locker (_mutex);
+        _frames.clear ();
+        _status = XCAM_RETURN_NO_ERROR;
+        _stopping = false;
+    }
+
+    _thread = new FileReadThread (this);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "image file reader(%s) start thread failed", XCAM_STR (get_file_name ()));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ImageFileReader::stop_thread ()
+{
+    if (!_thread.ptr ())
+        return;
+
+    {
+        SmartLock locker (_mutex);
+        _stopping = true;
+        _space_cond.broadcast ();
+    }
+    _thread->stop ();
+    _thread.release ();
+
+    SmartLock locker (_mutex);
+    _frames.clear ();
+}
+
+bool
+ImageFileReader::read_ahead ()
+{
+    {
+        SmartLock locker (_mutex);
+        while (!_stopping && _frames.size () >= _depth)
+            _space_cond.wait (_mutex);
+        if (_stopping)
+            return false;
+    }
+
+    SmartPtr<VideoBuffer> buf = _pool->try_get_buffer (_pool);
+    if (!buf.ptr ()) {
+        // buffers back to pool don't signal reader
+        SmartLock locker (_mutex);
+        if (!_stopping)
+            _space_cond.timedwait (_mutex, XCAM_FILE_READER_RETRY_TIME);
+        return true;
+    }
+
+    XCamReturn ret = _file.read_buf (buf);
+
+    SmartLock locker (_mutex);
+    if (ret == XCAM_RETURN_NO_ERROR) {
+        _frames.push_back (buf);
+        _frame_cond.broadcast ();
+        return true;
+    }
+
+    // end of file or error, stop reading till rewind
+    if (ret != XCAM_RETURN_BYPASS) {
+        XCAM_LOG_ERROR ("image file reader(%s) read frame failed", XCAM_STR (get_file_name ()));
+    }
+    _status = ret;
+    _frame_cond.broadcast ();
+    return false;
+}
+
+XCamReturn
+ImageFileReader::read_buf (SmartPtr<VideoBuffer> &buf)
+{
+    buf.release ();
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "image file reader read failed, file is not opened");
+
+    while (_frames.empty () && _status == XCAM_RETURN_NO_ERROR)
+        _frame_cond.wait (_mutex);
+
+    if (_frames.empty ())
+        return _status;
+
+    buf = _frames.front ();
+    _frames.pop_front ();
+    _space_cond.signal ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+ImageFileWriter::ImageFileWriter (uint32_t depth)
+    : _depth (XCAM_MAX (depth, 1u))
+    , _status (XCAM_RETURN_NO_ERROR)
+    , _stopping (false)
+{
+}
+
+ImageFileWriter::~ImageFileWriter ()
+{
+    close ();
+}
+
+XCamReturn
+ImageFileWriter::open (const char *name, const char *option)
+{
+    close ();
+
+    XCamReturn ret = _file.open (name, option);
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "image file writer open file(%s) failed", XCAM_STR (name));
+
+    {
+        SmartLock locker (_mutex);
+        _frames.clear ();
+        _status = XCAM_RETURN_NO_ERROR;
+        _stopping = false;
+    }
+
+    _thread = new FileWriteThread (this);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread->start (), XCAM_RETURN_ERROR_THREAD,
+        "image file writer(%s) start thread failed", XCAM_STR (name));
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ImageFileWriter::close ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (_thread.ptr ()) {
+        {
+            SmartLock locker (_mutex);
+            _stopping = true;
+            _frame_cond.broadcast ();
+        }
+        _thread->stop ();
+        _thread.release ();
+
+        SmartLock locker (_mutex);
+        _frames.clear ();
+        ret = _status;
+    }
+
+    _file.close ();
+    return ret;
+}
+
+XCamReturn
+ImageFileWriter::write_buf (const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _thread.ptr () && !_stopping, XCAM_RETURN_ERROR_ORDER,
+        "image file writer write failed, file is not opened");
+
+    while (_status == XCAM_RETURN_NO_ERROR && _frames.size () >= _depth)
+        _space_cond.wait (_mutex);
+    if (_status != XCAM_RETURN_NO_ERROR)
+        return _status;
+
+    _frames.push_back (buf);
+    _frame_cond.signal ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+ImageFileWriter::write_behind ()
+{
+    SmartPtr<VideoBuffer> buf;
+    {
+        SmartLock locker (_mutex);
+        while (_frames.empty () && !_stopping)
+            _frame_cond.wait (_mutex);
+
+        // close drains the queue before stopping
+        if (_frames.empty ())
+            return false;
+        buf = _frames.front ();
+    }
+
+    XCamReturn ret = _file.write_buf (buf);
+
+    SmartLock locker (_mutex);
+    // frame being written still counts for depth
+    _frames.pop_front ();
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_ERROR ("image file writer(%s) write frame failed", XCAM_STR (get_file_name ()));
+        _status = ret;
+        _frames.clear ();
+    }
+    _space_cond.broadcast ();
+    return ret == XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,125 @@
+/*
+ * image_file_stream.h - image file reader and writer with their own I/O thread
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_IMAGE_FILE_STREAM_H
+#define XCAM_IMAGE_FILE_STREAM_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <buffer_pool.h>
+#include <image_file_handle.h>
+#include <list>
+
+#define XCAM_FILE_STREAM_DEFAULT_DEPTH 3
+
+namespace XCam {
+
+class Thread;
+
+/*
+ * reads frames ahead into buffers of pool on its own thread, keeps at most depth frames ready.
+ * pool needs more buffers than depth plus the frames held by readers.
+ */
+class ImageFileReader
+{
+    friend class FileReadThread;
+
+public:
+    explicit ImageFileReader (uint32_t depth = XCAM_FILE_STREAM_DEFAULT_DEPTH);
+    ~ImageFileReader ();
+
+    const char *get_file_name () const {
+        return _file.get_file_name ();
+    }
+
+    // use_mmap maps the whole file and copies frames from it, for large raw files
+    XCamReturn open (const char *name, const SmartPtr<BufferPool> &pool, bool use_mmap = false);
+    XCamReturn close ();
+    // drops prefetched frames and reads from the first frame again
+    XCamReturn rewind ();
+
+    // waits next frame, XCAM_RETURN_BYPASS at end of file
+    XCamReturn read_buf (SmartPtr<VideoBuffer> &buf);
+
+private:
+    bool read_ahead ();
+    XCamReturn start_thread ();
+    void stop_thread ();
+
+    XCAM_DEAD_COPY (ImageFileReader);
+
+private:
+    ImageFileHandle                     _file;
+    SmartPtr<BufferPool>                _pool;
+    SmartPtr<Thread>                    _thread;
+    uint32_t                            _depth;
+
+    std::list<SmartPtr<VideoBuffer> >   _frames;
+    XCamReturn                          _status;
+    bool                                _stopping;
+    Mutex                               _mutex;
+    Cond                                _frame_cond;
+    Cond                                _space_cond;
+};
+
+/*
+ * writes queued frames on its own thread, write_buf blocks only while depth frames are queued.
+ * queued buffers must not be changed by callers until written, hand over a buffer and get a new one.
+ */
+class ImageFileWriter
+{
+    friend class FileWriteThread;
+
+public:
+    explicit ImageFileWriter (uint32_t depth = XCAM_FILE_STREAM_DEFAULT_DEPTH);
+    ~ImageFileWriter ();
+
+    const char *get_file_name () const {
+        return _file.get_file_name ();
+    }
+
+    XCamReturn open (const char *name, const char *option);
+    // writes all queued frames before closing the file
+    XCamReturn close ();
+
+    // returns the error of earlier writes if any
+    XCamReturn write_buf (const SmartPtr<VideoBuffer> &buf);
+
+private:
+    bool write_behind ();
+
+    XCAM_DEAD_COPY (ImageFileWriter);
+
+private:
+    ImageFileHandle                     _file;
+    SmartPtr<Thread>                    _thread;
+    uint32_t                            _depth;
+
+    std::list<SmartPtr<VideoBuffer> >   _frames;
+    XCamReturn                          _status;
+    bool                                _stopping;
+    Mutex                               _mutex;
+    Cond                                _frame_cond;
+    Cond                                _space_cond;
+};
+
+}
+
+#endif // XCAM_IMAGE_FILE_STREAM_H
@@ -19,9 +19,31 @@
  */
 
 #include "image_handler.h"
+#include "xcam_trace.h"
+#include "memory_accounting.h"
 
 namespace XCam {
 
+static int64_t
+get_handler_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+void
+ImageHandler::Parameters::set_deadline_after (int64_t budget_us)
+{
+    deadline = (budget_us > 0) ? get_handler_time () + budget_us : 0;
+}
+
+bool
+ImageHandler::Parameters::is_expired () const
+{
+    return deadline && get_handler_time () > deadline;
+}
+
 ImageHandler::ImageHandler (const char* name)
     : _need_configure (true)
     , _enable_allocator (true)
@@ -106,7 +128,11 @@ ImageHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, b
         "image_handler(%s) execute buffer failed, params is null",
         XCAM_STR (get_name ()));
 
+    XCAM_TRACE_SCOPE (get_name (), param->in_buf.ptr () ? param->in_buf->get_timestamp () : InvalidTimestamp);
+
     if (_need_configure) {
+        // resources and buffer pools are charged to the handler
+        MemoryOwnerScope mem_scope (get_name ());
         ret = configure_resource (param);
         XCAM_FAIL_RETURN (
             WARNING, xcam_ret_is_ok (ret), ret,
@@ -119,6 +145,12 @@ ImageHandler::execute_buffer (const SmartPtr<ImageHandler::Parameters> &param, b
         _need_configure = false;
     }
 
+    // work is submitted at once here, a frame can only be skipped before it starts
+    if (param->is_expired ()) {
+        XCAM_LOG_DEBUG ("image_handler(%s) frame expired before execution, bypassed", XCAM_STR (get_name ()));
+        return XCAM_RETURN_BYPASS;
+    }
+
     if (!param->out_buf.ptr () && _enable_allocator) {
         param->out_buf = get_free_buf ();
         XCAM_FAIL_RETURN (
@@ -157,6 +189,17 @@ ImageHandler::execute_status_check (const SmartPtr<ImageHandler::Parameters> &pa
         _callback->execute_status (this, params, error);
 }
 
+bool
+ImageHandler::add_quality_knob (const SmartPtr<QualityKnob> &knob)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, knob.ptr () && knob->get_level_count () > 0, false,
+        "image_handler(%s) add quality knob failed, knob invalid", XCAM_STR (get_name ()));
+
+    _quality_knobs.push_back (knob);
+    return true;
+}
+
 XCamReturn
 ImageHandler::reserve_buffers (const VideoBufferInfo &info, uint32_t count)
 {
@@ -167,7 +210,7 @@ ImageHandler::reserve_buffers (const VideoBufferInfo &info, uint32_t count)
     _allocator->set_video_info (info);
 
     XCAM_FAIL_RETURN (
-        ERROR, _allocator->reserve (count), XCAM_RETURN_ERROR_MEM,
+        ERROR, xcam_ret_is_ok (_allocator->reserve (count)), XCAM_RETURN_ERROR_MEM,
         "ImageHandler(%s) reserve buffers(%d) failed", XCAM_STR(get_name ()), count);
 
     return XCAM_RETURN_NO_ERROR;
@@ -25,6 +25,7 @@
 #include <meta_data.h>
 #include <buffer_pool.h>
 #include <worker.h>
+#include <quality_knob.h>
 
 #define DECLARE_HANDLER_CALLBACK(CbClass, Next, mem_func)                \
     class CbClass : public ::XCam::ImageHandler::Callback {              \
@@ -50,11 +51,16 @@ public:
     struct Parameters {
         SmartPtr<VideoBuffer> in_buf;
         SmartPtr<VideoBuffer> out_buf;
+        // CLOCK_MONOTONIC microseconds, 0 means none.
+        // remaining work of an expired frame is skipped, the frame ends with XCAM_RETURN_BYPASS
+        int64_t               deadline;
 
         Parameters (const SmartPtr<VideoBuffer> &in = NULL, const SmartPtr<VideoBuffer> &out = NULL)
-            : in_buf (in), out_buf (out)
+            : in_buf (in), out_buf (out), deadline (0)
         {}
         virtual ~Parameters() {}
+        void set_deadline_after (int64_t budget_us);
+        bool is_expired () const;
         bool add_meta (const SmartPtr<MetaBase> &meta);
         template <typename MType> SmartPtr<MType> find_meta ();
 
@@ -90,6 +96,11 @@ public:
     bool set_out_video_info (const VideoBufferInfo &info);
     bool enable_allocator (bool enable, uint32_t buf_count = XCAM_DEFAULT_HANDLER_BUF_CAP);
 
+    // knobs the handler offers to QualityGovernor, in order of least quality loss
+    const QualityKnobList &get_quality_knobs () const {
+        return _quality_knobs;
+    }
+
     // virtual functions
     // execute_buffer params should  NOT be const
     virtual XCamReturn execute_buffer (const SmartPtr<Parameters> &params, bool sync);
@@ -104,6 +115,7 @@ protected:
 
     virtual void execute_status_check (const SmartPtr<Parameters> &params, const XCamReturn error);
 
+    bool add_quality_knob (const SmartPtr<QualityKnob> &knob);
     bool set_allocator (const SmartPtr<BufferPool> &allocator);
     const SmartPtr<BufferPool> &get_allocator () const {
         return _allocator;
@@ -128,6 +140,7 @@ private:
     SmartPtr<BufferPool>    _allocator;
     uint32_t                _buf_capacity;
     char                   *_name;
+    QualityKnobList         _quality_knobs;
 };
 
 inline bool
@@ -20,6 +20,9 @@
 
 #include "image_processor.h"
 #include "xcam_thread.h"
+#include "safe_list.h"
+#include "frame_latency.h"
+#include <set>
 
 namespace XCam {
 
@@ -129,6 +132,8 @@ bool X3aResultsProcessThread::loop ()
     while ((result = _queue.pop (0)).ptr ()) {
         result_list.push_back (result);
     }
+    // results of older frames are overridden anyway
+    ImageProcessor::coalesce_results (result_list);
 
     XCamReturn ret = _processor->process_3a_results (result_list);
     if (ret != XCAM_RETURN_NO_ERROR) {
@@ -140,6 +145,7 @@ bool X3aResultsProcessThread::loop ()
 ImageProcessor::ImageProcessor (const char* name)
     : _name (NULL)
     , _callback (NULL)
+    , _dropped_buf_count (0)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -167,6 +173,13 @@ ImageProcessor::set_callback (ImageProcessCallback *callback)
     return true;
 }
 
+void
+ImageProcessor::set_thread_policy (const ThreadPolicy &policy)
+{
+    _processor_thread->set_policy (policy);
+    _results_thread->set_policy (policy);
+}
+
 XCamReturn
 ImageProcessor::start()
 {
@@ -200,17 +213,22 @@ ImageProcessor::stop()
 
     _processor_thread->stop ();
     _results_thread->stop ();
-    XCAM_LOG_DEBUG ("ImageProcessor(%s) stopped", XCAM_STR (_name));
+    XCAM_LOG_DEBUG (
+        "ImageProcessor(%s) stopped, %" PRIu64 " buffers dropped on full queue",
+        XCAM_STR (_name), _dropped_buf_count.load ());
     return XCAM_RETURN_NO_ERROR;
 }
 
 XCamReturn
 ImageProcessor::push_buffer (SmartPtr<VideoBuffer> &buf)
 {
-    if (_video_buf_queue.push (buf))
+    // callers are capture and poll threads, a slow processor must not stall them
+    if (_video_buf_queue.try_push (buf))
         return XCAM_RETURN_NO_ERROR;
 
-    XCAM_LOG_DEBUG ("processor push buffer failed");
+    ++_dropped_buf_count;
+    XCAM_LOG_DEBUG (
+        "ImageProcessor(%s) input queue full, buffer dropped", XCAM_STR (_name));
     return XCAM_RETURN_ERROR_UNKNOWN;
 }
 
@@ -299,6 +317,31 @@ ImageProcessor::process_3a_result (SmartPtr<X3aResult> &result)
     return ret;
 }
 
+void
+ImageProcessor::coalesce_results (X3aResultList &results)
+{
+    if (results.size () < 2)
+        return;
+
+    // walk from the latest, erase earlier ones of seen types
+    std::set<uint32_t> types;
+    X3aResultList::iterator i_res = results.end ();
+    do {
+        --i_res;
+        if (!(*i_res).ptr ())
+            continue;
+
+        uint32_t type = (*i_res)->get_type ();
+        if (types.insert (type).second)
+            continue;
+
+        XCAM_LOG_DEBUG (
+            "coalesce 3a result(type:0x%x, timestamp:" XCAM_TIMESTAMP_FORMAT ")",
+            type, XCAM_TIMESTAMP_ARGS ((*i_res)->get_timestamp ()));
+        i_res = results.erase (i_res);
+    } while (i_res != results.begin ());
+}
+
 void
 ImageProcessor::filter_valid_results (X3aResultList &input, X3aResultList &valid_results)
 {
@@ -315,6 +358,7 @@ ImageProcessor::filter_valid_results (X3aResultList &input, X3aResultList &valid
 void
 ImageProcessor::notify_process_buffer_done (const SmartPtr<VideoBuffer> &buf)
 {
+    FrameLatencyMeta::stamp (buf, get_name ());
     if (_callback)
         _callback->process_buffer_done (this, buf);
 }
@@ -24,7 +24,9 @@
 #include <xcam_std.h>
 #include <video_buffer.h>
 #include <x3a_result.h>
-#include <safe_list.h>
+#include <safe_ring.h>
+#include <xcam_thread.h>
+#include <atomic>
 
 namespace XCam {
 
@@ -52,7 +54,7 @@ class ImageProcessor
     friend class ImageProcessorThread;
     friend class X3aResultsProcessThread;
 
-    typedef SafeList<VideoBuffer> VideoBufQueue;
+    typedef SafeRing<VideoBuffer> VideoBufQueue;
 
 public:
     explicit ImageProcessor (const char* name);
@@ -63,13 +65,22 @@ public:
     }
 
     bool set_callback (ImageProcessCallback *callback);
+    // set before start, applies to buffer and 3a results threads
+    void set_thread_policy (const ThreadPolicy &policy);
     XCamReturn start();
     XCamReturn stop ();
 
+    // never blocks, @buf is dropped and counted if the input queue is full
     XCamReturn push_buffer (SmartPtr<VideoBuffer> &buf);
+    uint64_t get_dropped_buffer_count () const {
+        return _dropped_buf_count.load ();
+    }
     XCamReturn push_3a_results (X3aResultList &results);
     XCamReturn push_3a_result (SmartPtr<X3aResult> &result);
 
+    // keeps only the latest result of each type, order of the kept results unchanged
+    static void coalesce_results (X3aResultList &results);
+
 protected:
     virtual bool can_process_result (SmartPtr<X3aResult> &result) = 0;
     virtual XCamReturn apply_3a_results (X3aResultList &results) = 0;
@@ -98,6 +109,7 @@ protected:
     ImageProcessCallback               *_callback;
     SmartPtr<ImageProcessorThread>      _processor_thread;
     VideoBufQueue                       _video_buf_queue;
+    std::atomic<uint64_t>               _dropped_buf_count;
     SmartPtr<X3aResultsProcessThread>   _results_thread;
 };
 
@@ -75,11 +75,12 @@ ImageProjector::interp_orientation (
     while (i + 1 < count && orient_ts[i + 1] < frame_ts) {
         i++;
     }
-    if (i >= count) return Quaternd (orientation[count - 1]);
+    if (i >= count - 1) return Quaternd (orientation[count - 1]);
 
     index = i;
 
-    double weight_start = (orient_ts[i + 1] - frame_ts) / (orient_ts[i + 1] - orient_ts[i]);
+    // samples within a frame apart, integer division would snap to one of them
+    double weight_start = (double)(orient_ts[i + 1] - frame_ts) / (orient_ts[i + 1] - orient_ts[i]);
     double weight_end = 1.0f - weight_start;
     XCAM_ASSERT (weight_start >= 0 && weight_start <= 1.0);
     XCAM_ASSERT (weight_end >= 0 && weight_end <= 1.0);
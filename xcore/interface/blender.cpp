@@ -27,6 +27,7 @@ Blender::Blender (uint32_t alignment_x, uint32_t alignment_y)
     , _alignment_y (alignment_y)
     , _out_width (0)
     , _out_height (0)
+    , _blend_mode (BlendModePyramid)
 {
 }
 
@@ -40,6 +41,17 @@ Blender::set_output_size (uint32_t width, uint32_t height) {
     _out_height = XCAM_ALIGN_UP (height, get_alignment_y ());
 }
 
+bool
+Blender::set_blend_mode (BlendMode mode)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, mode == BlendModePyramid || is_feather_supported (), false,
+        "blender set blend mode failed, feather mode is not supported");
+
+    _blend_mode = mode;
+    return true;
+}
+
 bool
 Blender::set_merge_window (const Rect &window) {
     uint32_t alignmend_x = get_alignment_x ();
@@ -39,6 +39,7 @@ public:
     static SmartPtr<Blender> create_ocl_blender ();
     static SmartPtr<Blender> create_soft_blender ();
     static SmartPtr<Blender> create_gl_blender ();
+    static SmartPtr<Blender> create_vk_blender ();
 
     void set_output_size (uint32_t width, uint32_t height);
     void get_output_size (uint32_t &width, uint32_t &height) const {
@@ -71,6 +72,15 @@ public:
         return _alignment_y;
     }
 
+    // need be set before configure
+    bool set_blend_mode (BlendMode mode);
+    BlendMode get_blend_mode () const {
+        return _blend_mode;
+    }
+    virtual bool is_feather_supported () const {
+        return false;
+    }
+
     virtual XCamReturn blend (
         const SmartPtr<VideoBuffer> &in0,
         const SmartPtr<VideoBuffer> &in1,
@@ -86,6 +96,7 @@ private:
 private:
     uint32_t                         _alignment_x, _alignment_y;
     uint32_t                         _out_width, _out_height;
+    BlendMode                        _blend_mode;
     Rect                             _input_valid_area[XCAM_BLENDER_IMAGE_NUM];
     Rect                             _merge_window;  // for output buffer
 
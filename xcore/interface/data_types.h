@@ -37,6 +37,12 @@ enum GeoMapScaleMode {
     ScaleDualCurve
 };
 
+enum BlendMode {
+    BlendModePyramid = 0,
+    // alpha ramp of the level 0 mask straight into output, no pyramid
+    BlendModeFeather
+};
+
 struct Rect {
     int32_t pos_x, pos_y;
     int32_t width, height;
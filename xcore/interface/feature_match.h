@@ -37,6 +37,7 @@ struct CVFMConfig {
     float max_adjusted_offset; // maximum offset of each adjustment
     float max_valid_offset_y;  // valid maximum offset in vertical direction
     float max_track_error;     // maximum track error
+    int scale_level;           // CVCapiFeatureMatch matches luma decimated by (1 << scale_level), offsets stay full-res
 
     CVFMConfig ()
         : sitch_min_width (56)
@@ -47,6 +48,7 @@ struct CVFMConfig {
         , max_adjusted_offset (12.0f)
         , max_valid_offset_y (8.0f)
         , max_track_error (24.0f)
+        , scale_level (0)
     {}
 };
 
@@ -21,6 +21,8 @@
 
 #include "stitcher.h"
 #include "xcam_utils.h"
+#include "xcam_mutex.h"
+#include <list>
 
 // angle to position, output range [-180, 180]
 #define OUT_WINDOWS_START 0.0f
@@ -29,6 +31,9 @@
 
 #define XCAM_GL_RESTART_FIXED_INDEX 0xFFFF
 
+// distinct bowl meshes kept, views switch among a few resolutions and lods
+#define XCAM_BOWL_MODEL_CACHE_SIZE 8
+
 namespace XCam {
 
 static inline bool
@@ -79,10 +84,14 @@ split_area_by_out (
 Stitcher::Stitcher (uint32_t align_x, uint32_t align_y)
     : _is_crop_set (false)
     , _scale_mode (ScaleSingleConst)
+    , _table_cache (false)
+    , _blend_mode (BlendModePyramid)
     , _alignment_x (align_x)
     , _alignment_y (align_y)
     , _output_width (0)
     , _output_height (0)
+    , _strip_start (0)
+    , _strip_width (0)
     , _out_start_angle (OUT_WINDOWS_START)
     , _camera_num (0)
     , _is_round_view_set (false)
@@ -97,6 +106,139 @@ Stitcher::~Stitcher ()
 {
 }
 
+bool
+Stitcher::set_fm_schedule (const FMSchedulePolicy &policy)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, policy.mode != FMScheduleInterval || policy.interval > 0, false,
+        "stitcher set feature match schedule failed, interval must be > 0");
+    XCAM_FAIL_RETURN (
+        ERROR, policy.diff_threshold >= 0.0f && policy.diff_threshold <= 255.0f, false,
+        "stitcher set feature match schedule failed, diff threshold:%.2f out of [0, 255]",
+        policy.diff_threshold);
+
+    _fm_schedule = policy;
+    return true;
+}
+
+bool
+Stitcher::set_blend_reuse (const BlendReusePolicy &policy)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, policy.tile_threshold >= 0.0f && policy.tile_threshold <= 255.0f, false,
+        "stitcher set blend reuse failed, tile threshold:%.2f out of [0, 255]", policy.tile_threshold);
+    XCAM_FAIL_RETURN (
+        ERROR, !policy.refresh_interval || is_blend_reuse_supported (), false,
+        "stitcher set blend reuse failed, not supported by this stitcher");
+
+    _blend_reuse = policy;
+    return true;
+}
+
+bool
+Stitcher::set_output_strip (uint32_t start_x, uint32_t width)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, is_output_strip_supported () || !width, false,
+        "stitcher set output strip failed, not supported");
+    XCAM_FAIL_RETURN (
+        ERROR, !_is_overlap_set, false,
+        "stitcher set output strip failed, overlaps are already estimated");
+    XCAM_FAIL_RETURN (
+        ERROR,
+        XCAM_ALIGN_DOWN (start_x, _alignment_x) == start_x &&
+        XCAM_ALIGN_DOWN (width, _alignment_x) == width, false,
+        "stitcher set output strip failed, start(%d) and width(%d) need be aligned to %d",
+        start_x, width, _alignment_x);
+
+    _strip_start = start_x;
+    _strip_width = width;
+    return true;
+}
+
+bool
+Stitcher::set_blend_mode (BlendMode mode)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, mode == BlendModePyramid || is_feather_blend_supported (), false,
+        "stitcher set blend mode failed, feather blending is not supported");
+
+    _blend_mode = mode;
+    return true;
+}
+
+bool
+Stitcher::add_extra_output (uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, is_extra_output_supported (), false,
+        "stitcher add extra output failed, not supported");
+    XCAM_FAIL_RETURN (
+        ERROR, _extra_sizes.size () < XCAM_STITCH_MAX_EXTRA_OUTPUTS, false,
+        "stitcher add extra output failed, at most %d extra outputs", XCAM_STITCH_MAX_EXTRA_OUTPUTS);
+    XCAM_FAIL_RETURN (
+        ERROR, width && height && !(width % 2) && !(height % 2), false,
+        "stitcher add extra output failed, size(%dx%d) need be even", width, height);
+
+    _extra_sizes.push_back (OutputSize (width, height));
+    return true;
+}
+
+XCamReturn
+Stitcher::stitch_buffers (
+    const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf,
+    std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _extra_sizes.empty () || !_strip_width, XCAM_RETURN_ERROR_PARAM,
+        "stitcher extra outputs need whole output, but output strip is set");
+
+    XCamReturn ret = stitch_buffers (in_bufs, out_buf);
+    if (ret != XCAM_RETURN_NO_ERROR || _extra_sizes.empty ()) {
+        extra_bufs.clear ();
+        return ret;
+    }
+
+    return scale_extra_outputs (out_buf, extra_bufs);
+}
+
+XCamReturn
+Stitcher::scale_extra_outputs (
+    const SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs)
+{
+    XCAM_UNUSED (out_buf);
+    XCAM_UNUSED (extra_bufs);
+    XCAM_LOG_ERROR ("stitcher scale extra outputs failed, not supported");
+    return XCAM_RETURN_ERROR_PARAM;
+}
+
+bool
+Stitcher::is_overlap_in_strip (uint32_t idx) const
+{
+    XCAM_ASSERT (idx < _camera_num);
+    if (!_strip_width)
+        return true;
+
+    int32_t pos = _overlap_info[idx].out_area.pos_x;
+    return pos >= (int32_t)_strip_start && pos < (int32_t)(_strip_start + _strip_width);
+}
+
+bool
+Stitcher::is_camera_in_strip (uint32_t idx) const
+{
+    XCAM_ASSERT (idx < _camera_num);
+    if (!_strip_width)
+        return true;
+
+    if (is_overlap_in_strip (idx) || is_overlap_in_strip ((idx + _camera_num - 1) % _camera_num))
+        return true;
+    for (uint32_t i = 0; i < _copy_areas.size (); ++i) {
+        if (_copy_areas[i].in_idx == idx)
+            return true;
+    }
+    return false;
+}
+
 bool
 Stitcher::set_bowl_config (const BowlDataConfig &config)
 {
@@ -104,6 +246,14 @@ Stitcher::set_bowl_config (const BowlDataConfig &config)
     return true;
 }
 
+bool
+Stitcher::update_bowl_config (const BowlDataConfig &config)
+{
+    XCAM_UNUSED (config);
+    XCAM_LOG_WARNING ("stitcher doesn't support bowl config update while running");
+    return false;
+}
+
 bool
 Stitcher::set_camera_num (uint32_t num)
 {
@@ -531,9 +681,33 @@ Stitcher::update_copy_areas ()
 
     XCAM_ASSERT (_copy_areas.size() >= _camera_num);
 
+    if (_strip_width)
+        clip_copy_areas_to_strip ();
+
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+Stitcher::clip_copy_areas_to_strip ()
+{
+    int32_t strip_end = _strip_start + _strip_width;
+    CopyAreaArray clipped;
+    for (uint32_t i = 0; i < _copy_areas.size (); ++i) {
+        CopyArea area = _copy_areas[i];
+        int32_t start = XCAM_MAX (area.out_area.pos_x, (int32_t)_strip_start);
+        int32_t end = XCAM_MIN (area.out_area.pos_x + area.out_area.width, strip_end);
+        if (end <= start)
+            continue;
+
+        area.in_area.pos_x += start - area.out_area.pos_x;
+        area.in_area.width = end - start;
+        area.out_area.pos_x = start;
+        area.out_area.width = end - start;
+        clipped.push_back (area);
+    }
+    _copy_areas = clipped;
+}
+
 BowlModel::BowlModel (const BowlDataConfig &config, const uint32_t image_width, const uint32_t image_height)
     : _config (config)
     , _bowl_img_width (image_width)
@@ -597,20 +771,103 @@ BowlModel::get_topview_rect_map (
     return true;
 }
 
+bool
+BowlModel::get_viewport_map (
+    PointMap &texture_points, uint32_t res_width, uint32_t res_height, const Viewport &viewport,
+    uint32_t &start_x, uint32_t &end_x)
+{
+    XCAM_FAIL_RETURN (
+        ERROR,
+        res_width > 1 && res_height > 1 && viewport.fov > 0.0f && viewport.fov < 180.0f && viewport.aspect > 0.0f,
+        false,
+        "bowl model viewport map(res:%dx%d) failed, invalid fov(%.2f) or aspect(%.2f)",
+        res_width, res_height, viewport.fov, viewport.aspect);
+
+    float yaw = degree2radian (viewport.yaw), pitch = degree2radian (viewport.pitch);
+    float half_w = tan (degree2radian (viewport.fov) / 2.0f);
+    float half_h = half_w / viewport.aspect;
+
+    // bowl image x grows with angle of (x, -y), forward, right and up of the view
+    PointFloat3 forward (cos (pitch) * cos (yaw), -cos (pitch) * sin (yaw), sin (pitch));
+    PointFloat3 right (-sin (yaw), -cos (yaw), 0.0f);
+    PointFloat3 up (-sin (pitch) * cos (yaw), sin (pitch) * sin (yaw), cos (pitch));
+
+    const float a = _config.a, b = _config.b, c = _config.c;
+    float min_angle = XCAM_PI, max_angle = -XCAM_PI;
+    texture_points.resize (res_width * res_height);
+
+    for (uint32_t row = 0; row < res_height; row++) {
+        float v = (1.0f - 2.0f * row / (res_height - 1.0f)) * half_h;
+        for (uint32_t col = 0; col < res_width; col++) {
+            float u = (2.0f * col / (res_width - 1.0f) - 1.0f) * half_w;
+            PointFloat3 dir (
+                forward.x + right.x * u + up.x * v,
+                forward.y + right.y * u + up.y * v,
+                forward.z + right.z * u + up.z * v);
+
+            // view center is the ellipsoid center, rays below the ground hit the ground plane
+            float t = 1.0f / sqrt (dir.x * dir.x / (a * a) + dir.y * dir.y / (b * b) + dir.z * dir.z / (c * c));
+            if (_config.center_z + t * dir.z < 0.0f)
+                t = -_config.center_z / dir.z;
+            PointFloat3 world_pos (t * dir.x, t * dir.y, XCAM_MAX (_config.center_z + t * dir.z, 0.0f));
+
+            texture_points [res_width * row + col] = bowl_view_coords_to_image (
+                        _config, world_pos, _bowl_img_width, _bowl_img_height);
+
+            float angle = atan2 (-dir.y, dir.x) - yaw;
+            angle = angle - 2.0f * XCAM_PI * floor ((angle + XCAM_PI) / (2.0f * XCAM_PI));
+            min_angle = XCAM_MIN (min_angle, angle);
+            max_angle = XCAM_MAX (max_angle, angle);
+        }
+    }
+
+    float start_angle = yaw + min_angle, end_angle = yaw + max_angle;
+    start_angle -= 2.0f * XCAM_PI * floor (start_angle / (2.0f * XCAM_PI));
+    end_angle = start_angle + (max_angle - min_angle);
+    if (end_angle >= 2.0f * XCAM_PI) {
+        start_x = 0;
+        end_x = _bowl_img_width;
+    } else {
+        float scale = _bowl_img_width / (2.0f * XCAM_PI);
+        start_x = (uint32_t) XCAM_MAX (floor (start_angle * scale) - 1.0f, 0.0f);
+        end_x = (uint32_t) XCAM_MIN (ceil (end_angle * scale) + 2.0f, (float)_bowl_img_width);
+    }
+    return true;
+}
+
+uint32_t
+BowlModel::get_vertex_count (uint32_t res_width, uint32_t res_height)
+{
+    if (res_height < 2)
+        return 0;
+    return 2 * (res_width + 1) * (res_height - 1);
+}
+
+void
+BowlModel::get_lod_resolution (uint32_t lod, uint32_t &res_width, uint32_t &res_height)
+{
+    lod = XCAM_MIN (lod, (uint32_t)XCAM_BOWL_MODEL_MAX_LOD);
+    res_width = XCAM_MAX (res_width >> lod, 2u);
+    res_height = XCAM_MAX (res_height >> lod, 2u);
+}
+
 bool
 BowlModel::get_stitch_image_vertex_model (
-    VertexMap &vertices, PointMap &texture_points, IndexVector &indeices,
+    PointFloat3 *vertices, PointFloat2 *texture_points, int32_t *indices, uint32_t count,
     uint32_t res_width, uint32_t res_height, float vertex_height)
 {
-    vertices.reserve (2 * (res_width + 1) * (res_height + 1));
-    texture_points.reserve (2 * (res_width + 1) * (res_height + 1));
-    indeices.reserve (2 * (res_width + 1) * (res_height + 1) + (res_height + 1));
+    uint32_t vertex_count = get_vertex_count (res_width, res_height);
+    XCAM_FAIL_RETURN (
+        ERROR, vertices && texture_points && indices && res_width && vertex_count && count >= vertex_count,
+        false,
+        "bowl model get vertex model(res:%dx%d) failed, buffers of %d entries need %d",
+        res_width, res_height, count, vertex_count);
 
     float step_x = (float)_bowl_img_width / res_width;
     float step_y = vertex_height / res_height;
     float offset_y = (float)_bowl_img_height - vertex_height;
 
-    int32_t indicator = 0;
+    uint32_t indicator = 0;
 
     for (uint32_t row = 0; row < res_height - 1; row++) {
         PointFloat2 texture_pos0;
@@ -628,22 +885,135 @@ BowlModel::get_stitch_image_vertex_model (
                 bowl_view_image_to_world (
                     _config, _bowl_img_width, _bowl_img_height, texture_pos0);
 
-            vertices.push_back (PointFloat3(world_pos0.x / _config.a, world_pos0.y / _config.b, world_pos0.z / _config.c));
-            indeices.push_back (indicator++);
-            texture_points.push_back (PointFloat2(texture_pos0.x / _bowl_img_width, texture_pos0.y / _bowl_img_height));
+            vertices[indicator] = PointFloat3(world_pos0.x / _config.a, world_pos0.y / _config.b, world_pos0.z / _config.c);
+            texture_points[indicator] = PointFloat2(texture_pos0.x / _bowl_img_width, texture_pos0.y / _bowl_img_height);
+            indices[indicator] = indicator;
+            indicator++;
 
             PointFloat3 world_pos1 =
                 bowl_view_image_to_world (
                     _config, _bowl_img_width, _bowl_img_height, texture_pos1);
 
-            vertices.push_back (PointFloat3(world_pos1.x / _config.a, world_pos1.y / _config.b, world_pos1.z / _config.c));
-            indeices.push_back (indicator++);
-            texture_points.push_back (PointFloat2(texture_pos1.x / _bowl_img_width, texture_pos1.y / _bowl_img_height));
+            vertices[indicator] = PointFloat3(world_pos1.x / _config.a, world_pos1.y / _config.b, world_pos1.z / _config.c);
+            texture_points[indicator] = PointFloat2(texture_pos1.x / _bowl_img_width, texture_pos1.y / _bowl_img_height);
+            indices[indicator] = indicator;
+            indicator++;
         }
     }
+    XCAM_ASSERT (indicator == vertex_count);
+    return true;
+}
+
+bool
+BowlModel::get_stitch_image_vertex_model (
+    VertexMap &vertices, PointMap &texture_points, IndexVector &indeices,
+    uint32_t res_width, uint32_t res_height, float vertex_height)
+{
+    SmartPtr<VertexModel> model = get_cached_vertex_model (res_width, res_height, vertex_height);
+    XCAM_FAIL_RETURN (
+        ERROR, model.ptr (), false,
+        "bowl model get vertex model(res:%dx%d) failed", res_width, res_height);
+
+    // assign reuses capacity of caller vectors
+    vertices.assign (model->vertices.begin (), model->vertices.end ());
+    texture_points.assign (model->texture_points.begin (), model->texture_points.end ());
+    indeices.assign (model->indices.begin (), model->indices.end ());
     return true;
 }
 
+struct BowlModelKey {
+    BowlDataConfig    config;
+    uint32_t          img_width, img_height;
+    uint32_t          res_width, res_height;
+    float             vertex_height;
+
+    bool operator == (const BowlModelKey &key) const {
+        return config.a == key.config.a && config.b == key.config.b && config.c == key.config.c &&
+               config.angle_start == key.config.angle_start && config.angle_end == key.config.angle_end &&
+               config.center_z == key.config.center_z && config.wall_height == key.config.wall_height &&
+               config.ground_length == key.config.ground_length &&
+               img_width == key.img_width && img_height == key.img_height &&
+               res_width == key.res_width && res_height == key.res_height &&
+               vertex_height == key.vertex_height;
+    }
+};
+
+struct BowlModelEntry {
+    BowlModelKey                       key;
+    SmartPtr<BowlModel::VertexModel>   model;
+};
+
+// most recently used first
+static std::list<BowlModelEntry> bowl_model_cache;
+static Mutex bowl_model_cache_mutex;
+
+SmartPtr<BowlModel::VertexModel>
+BowlModel::get_cached_vertex_model (uint32_t res_width, uint32_t res_height, float vertex_height)
+{
+    BowlModelKey key;
+    key.config = _config;
+    key.img_width = _bowl_img_width;
+    key.img_height = _bowl_img_height;
+    key.res_width = res_width;
+    key.res_height = res_height;
+    key.vertex_height = vertex_height;
+
+    {
+        SmartLock locker (bowl_model_cache_mutex);
+        for (std::list<BowlModelEntry>::iterator i = bowl_model_cache.begin (); i != bowl_model_cache.end (); ++i) {
+            if (i->key == key) {
+                bowl_model_cache.splice (bowl_model_cache.begin (), bowl_model_cache, i);
+                return bowl_model_cache.front ().model;
+            }
+        }
+    }
+
+    // built out of lock, a racing thread may build same model once more
+    uint32_t count = get_vertex_count (res_width, res_height);
+    XCAM_FAIL_RETURN (
+        ERROR, res_width && count, NULL,
+        "bowl model resolution(%dx%d) is too small", res_width, res_height);
+
+    SmartPtr<VertexModel> model = new VertexModel;
+    model->vertices.resize (count);
+    model->texture_points.resize (count);
+    model->indices.resize (count);
+    if (!get_stitch_image_vertex_model (
+                model->vertices.data (), model->texture_points.data (), model->indices.data (), count,
+                res_width, res_height, vertex_height))
+        return NULL;
+
+    BowlModelEntry entry;
+    entry.key = key;
+    entry.model = model;
+
+    SmartLock locker (bowl_model_cache_mutex);
+    bowl_model_cache.push_front (entry);
+    if (bowl_model_cache.size () > XCAM_BOWL_MODEL_CACHE_SIZE)
+        bowl_model_cache.pop_back ();
+    return model;
+}
+
+float
+BowlModel::get_topview_image_height () const
+{
+    float wall_image_height = _config.wall_height / (float)(_config.wall_height + _config.ground_length) * (float)_bowl_img_height;
+    return (float)_bowl_img_height - wall_image_height;
+}
+
+SmartPtr<BowlModel::VertexModel>
+BowlModel::get_bowlview_vertex_model (uint32_t res_width, uint32_t res_height, uint32_t lod)
+{
+    get_lod_resolution (lod, res_width, res_height);
+    return get_cached_vertex_model (res_width, res_height, (float)_bowl_img_height);
+}
+
+SmartPtr<BowlModel::VertexModel>
+BowlModel::get_topview_vertex_model (uint32_t res_width, uint32_t res_height, uint32_t lod)
+{
+    get_lod_resolution (lod, res_width, res_height);
+    return get_cached_vertex_model (res_width, res_height, get_topview_image_height ());
+}
 
 bool
 BowlModel::get_bowlview_vertex_model (
@@ -658,10 +1028,7 @@ BowlModel::get_topview_vertex_model (
     VertexMap &vertices, PointMap &texture_points, IndexVector &indeices,
     uint32_t res_width, uint32_t res_height)
 {
-    float wall_image_height = _config.wall_height / (float)(_config.wall_height + _config.ground_length) * (float)_bowl_img_height;
-    float ground_image_height = (float)_bowl_img_height - wall_image_height;
-
-    return get_stitch_image_vertex_model (vertices, texture_points, indeices, res_width, res_height, ground_image_height);
+    return get_stitch_image_vertex_model (vertices, texture_points, indeices, res_width, res_height, get_topview_image_height ());
 }
 
 
@@ -26,13 +26,18 @@
 #include <interface/data_types.h>
 #include <vector>
 #include <video_buffer.h>
+#include <calibration_binary.h>
 
 #define XCAM_STITCH_FISHEYE_MAX_NUM    6
 #define XCAM_STITCH_MAX_CAMERAS XCAM_STITCH_FISHEYE_MAX_NUM
+#define XCAM_STITCH_MAX_EXTRA_OUTPUTS 4
 #define XCAM_STITCH_MIN_SEAM_WIDTH 56
 
 #define INVALID_INDEX (uint32_t)(-1)
 
+// each level of detail halves model resolution
+#define XCAM_BOWL_MODEL_MAX_LOD 4
+
 namespace XCam {
 
 enum StitchResMode {
@@ -41,6 +46,35 @@ enum StitchResMode {
     StitchRes4K
 };
 
+enum FeatureMatchSchedule {
+    FMScheduleEveryFrame = 0,
+    FMScheduleInterval,     // once every interval frames
+    FMScheduleOnDiff        // when overlap luma difference exceeds diff_threshold
+};
+
+struct FMSchedulePolicy {
+    FeatureMatchSchedule mode;
+    uint32_t interval;
+    float diff_threshold;   // mean absolute luma difference, [0, 255]
+
+    FMSchedulePolicy ()
+        : mode (FMScheduleEveryFrame)
+        , interval (1)
+        , diff_threshold (8.0f)
+    {}
+};
+
+struct BlendReusePolicy {
+    // most frames a blended overlap is reused before it is blended again, 0 disables reuse
+    uint32_t refresh_interval;
+    float tile_threshold;   // mean absolute difference of 1/8 scaled luma in any tile, [0, 255]
+
+    BlendReusePolicy ()
+        : refresh_interval (0)
+        , tile_threshold (2.0f)
+    {}
+};
+
 struct StitchInfo {
     uint32_t merge_width[XCAM_STITCH_FISHEYE_MAX_NUM];
 
@@ -121,14 +155,25 @@ public:
     };
     typedef std::vector<CopyArea>  CopyAreaArray;
 
+    struct OutputSize {
+        uint32_t width;
+        uint32_t height;
+
+        OutputSize (uint32_t w = 0, uint32_t h = 0) : width (w), height (h) {}
+    };
+
 public:
     explicit Stitcher (uint32_t align_x, uint32_t align_y = 1);
     virtual ~Stitcher ();
     static SmartPtr<Stitcher> create_ocl_stitcher ();
     static SmartPtr<Stitcher> create_soft_stitcher ();
     static SmartPtr<Stitcher> create_gl_stitcher ();
+    static SmartPtr<Stitcher> create_vk_stitcher ();
 
     bool set_bowl_config (const BowlDataConfig &config);
+    // change bowl of a running stitcher, dewarp tables are rebuilt off the stream and swapped in
+    // at a frame boundary. false if not supported, then set_bowl_config and recreate the stitcher
+    virtual bool update_bowl_config (const BowlDataConfig &config);
     const BowlDataConfig &get_bowl_config () {
         return _bowl_config;
     }
@@ -167,15 +212,96 @@ public:
         return _scale_mode;
     }
 
+    // render output columns [start_x, start_x + width) only, width 0 means whole output, set before configure.
+    // copy areas are clipped to the strip, an overlap is blended by the strip its out area starts in
+    bool set_output_strip (uint32_t start_x, uint32_t width);
+    virtual bool is_output_strip_supported () const {
+        return false;
+    }
+    void get_output_strip (uint32_t &start_x, uint32_t &width) const {
+        start_x = _strip_start;
+        width = _strip_width;
+    }
+    uint32_t get_alignment_x () const {
+        return _alignment_x;
+    }
+
+    // blend mode of all overlaps, feather costs a fraction of pyramid blending, set before configure
+    bool set_blend_mode (BlendMode mode);
+    virtual bool is_feather_blend_supported () const {
+        return false;
+    }
+    BlendMode get_blend_mode () const {
+        return _blend_mode;
+    }
+
+    // for static calibrations, load/save dewarp tables through FisheyeTableCache
+    void enable_table_cache (bool enable) {
+        _table_cache = enable;
+    }
+    bool is_table_cache_enabled () const {
+        return _table_cache;
+    }
+    // dewarp tables found in binary calibration are used before FisheyeTableCache
+    void set_calibration_binary (const SmartPtr<CalibrationBinary> &binary) {
+        _calib_binary = binary;
+    }
+    const SmartPtr<CalibrationBinary> &get_calibration_binary () const {
+        return _calib_binary;
+    }
+
+    // when feature match runs on overlaps, matching itself is done off the stitch path
+    bool set_fm_schedule (const FMSchedulePolicy &policy);
+    const FMSchedulePolicy &get_fm_schedule () const {
+        return _fm_schedule;
+    }
+
+    // overlaps whose inputs stay static reuse their last blended result, set before configure
+    bool set_blend_reuse (const BlendReusePolicy &policy);
+    const BlendReusePolicy &get_blend_reuse () const {
+        return _blend_reuse;
+    }
+    virtual bool is_blend_reuse_supported () const {
+        return false;
+    }
+
+    // smaller copies of the whole panorama, e.g. preview and analytics next to the recorded output,
+    // scaled from each stitched output in one pass instead of stitching again. sizes need be even,
+    // set before configure, not with an output strip
+    bool add_extra_output (uint32_t width, uint32_t height);
+    virtual bool is_extra_output_supported () const {
+        return false;
+    }
+    uint32_t get_extra_output_count () const {
+        return _extra_sizes.size ();
+    }
+    const OutputSize &get_extra_output_size (uint32_t idx) const {
+        XCAM_ASSERT (idx < _extra_sizes.size ());
+        return _extra_sizes[idx];
+    }
+
     virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf) = 0;
+    // @extra_bufs is resized to extra output count with outputs of same frame as @out_buf,
+    // empty entries are allocated; cleared when no output is returned
+    XCamReturn stitch_buffers (
+        const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf,
+        std::vector<SmartPtr<VideoBuffer> > &extra_bufs);
 
 protected:
+    // scale a stitched output into extra outputs
+    virtual XCamReturn scale_extra_outputs (
+        const SmartPtr<VideoBuffer> &out_buf, std::vector<SmartPtr<VideoBuffer> > &extra_bufs);
+
     XCamReturn estimate_round_slices ();
     virtual XCamReturn estimate_coarse_crops ();
     XCamReturn mark_centers ();
     XCamReturn estimate_overlap ();
     XCamReturn update_copy_areas ();
 
+    // both true without an output strip
+    bool is_overlap_in_strip (uint32_t idx) const;
+    bool is_camera_in_strip (uint32_t idx) const;
+
     const CenterMark &get_center (uint32_t idx) const {
         return _center_marks[idx];
     }
@@ -193,18 +319,27 @@ protected:
     }
 
 private:
+    void clip_copy_areas_to_strip ();
+
     XCAM_DEAD_COPY (Stitcher);
 
 protected:
     ImageCropInfo               _crop_info[XCAM_STITCH_MAX_CAMERAS];
     bool                        _is_crop_set;
     GeoMapScaleMode             _scale_mode;
+    bool                        _table_cache;
+    SmartPtr<CalibrationBinary> _calib_binary;
+    FMSchedulePolicy            _fm_schedule;
+    BlendReusePolicy            _blend_reuse;
+    BlendMode                   _blend_mode;
     //update after each feature match
     ScaleFactor                 _scale_factors[XCAM_STITCH_MAX_CAMERAS];
 
 private:
     uint32_t                    _alignment_x, _alignment_y;
     uint32_t                    _output_width, _output_height;
+    uint32_t                    _strip_start, _strip_width;
+    std::vector<OutputSize>     _extra_sizes;
     float                       _out_start_angle;
     uint32_t                    _camera_num;
     CameraInfo                  _camera_info[XCAM_STITCH_MAX_CAMERAS];
@@ -227,9 +362,47 @@ public:
     typedef std::vector<PointFloat2> PointMap;
     typedef std::vector<int32_t> IndexVector;
 
+    // triangle strip of a bowl, shared by mesh cache, read only
+    struct VertexModel {
+        VertexMap    vertices;
+        PointMap     texture_points;
+        IndexVector  indices;
+    };
+
+    // rectilinear view from bowl center, angles in degree
+    struct Viewport {
+        float    yaw;     // same direction as bowl image x, 0 at its left edge
+        float    pitch;   // up is positive
+        float    fov;     // horizontal field of view, less than 180
+        float    aspect;  // view width / height
+
+        Viewport () : yaw (0.0f), pitch (0.0f), fov (60.0f), aspect (16.0f / 9.0f) {}
+    };
+
 public:
     BowlModel (const BowlDataConfig &config, const uint32_t image_width, const uint32_t image_height);
+
+    // entries of vertices, texture points and indices in a res_width x res_height model
+    static uint32_t get_vertex_count (uint32_t res_width, uint32_t res_height);
+    // resolution of level lod, at least 2x2
+    static void get_lod_resolution (uint32_t lod, uint32_t &res_width, uint32_t &res_height);
+
+    // models are cached by bowl config, image size, resolution and lod, built once per process
+    SmartPtr<VertexModel> get_bowlview_vertex_model (uint32_t res_width, uint32_t res_height, uint32_t lod = 0);
+    SmartPtr<VertexModel> get_topview_vertex_model (uint32_t res_width, uint32_t res_height, uint32_t lod = 0);
+
+    // fills caller buffers of count entries, allocates nothing
+    bool get_stitch_image_vertex_model (
+        PointFloat3 *vertices, PointFloat2 *texture_points, int32_t *indices, uint32_t count,
+        uint32_t res_width, uint32_t res_height, float vertex_height);
+
     bool get_max_topview_area_mm (float &length_mm, float &width_mm);
+    // texture points of a res_width x res_height grid over the view, [start_x, end_x) are bowl image
+    // columns it reads, whole width when the view crosses the left edge. use output size as grid size
+    // to keep image edge columns from being interpolated with each other
+    bool get_viewport_map (
+        PointMap &texture_points, uint32_t res_width, uint32_t res_height, const Viewport &viewport,
+        uint32_t &start_x, uint32_t &end_x);
     bool get_topview_rect_map (
         PointMap &texture_points,
         uint32_t res_width, uint32_t res_height,
@@ -247,6 +420,10 @@ public:
         VertexMap &vertices, PointMap &texture_points, IndexVector &indeices,
         uint32_t res_width, uint32_t res_height);
 
+private:
+    float get_topview_image_height () const;
+    SmartPtr<VertexModel> get_cached_vertex_model (uint32_t res_width, uint32_t res_height, float vertex_height);
+
 private:
     BowlDataConfig    _config;
     uint32_t          _bowl_img_width, _bowl_img_height;
@@ -0,0 +1,241 @@
+/*
+ * strip_stitcher.cpp - stitch output split into strips over several stitchers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "strip_stitcher.h"
+#include <xcam_mutex.h>
+
+namespace XCam {
+
+class StripTaskGroup
+{
+public:
+    explicit StripTaskGroup (uint32_t count)
+        : _pending (count)
+        , _error (XCAM_RETURN_NO_ERROR)
+    {}
+
+    void finish_one (XCamReturn err) {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (_pending > 0);
+        if (!xcam_ret_is_ok (err) && xcam_ret_is_ok (_error))
+            _error = err;
+        if (--_pending == 0)
+            _cond.broadcast ();
+    }
+    XCamReturn wait () {
+        SmartLock locker (_mutex);
+        while (_pending > 0)
+            _cond.wait (_mutex);
+        return _error;
+    }
+
+private:
+    uint32_t     _pending;
+    XCamReturn   _error;
+    Mutex        _mutex;
+    Cond         _cond;
+};
+
+class StripTask
+    : public ThreadPool::UserData
+{
+public:
+    StripTask (
+        const SmartPtr<StripTaskGroup> &group, const SmartPtr<Stitcher> &stitcher,
+        const VideoBufferList &in_bufs, const SmartPtr<VideoBuffer> &out_buf)
+        : _group (group)
+        , _stitcher (stitcher)
+        , _in_bufs (in_bufs)
+        , _out_buf (out_buf)
+    {}
+
+    virtual XCamReturn run () {
+        SmartPtr<VideoBuffer> buf = _out_buf;
+        XCamReturn ret = _stitcher->stitch_buffers (_in_bufs, buf);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "strip stitcher: sub stitcher failed");
+        XCAM_FAIL_RETURN (
+            ERROR, buf.ptr () == _out_buf.ptr (), XCAM_RETURN_ERROR_PARAM,
+            "strip stitcher: sub stitcher didn't write to the shared output");
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn err) {
+        _group->finish_one (err);
+    }
+
+private:
+    SmartPtr<StripTaskGroup>    _group;
+    SmartPtr<Stitcher>          _stitcher;
+    VideoBufferList             _in_bufs;
+    SmartPtr<VideoBuffer>       _out_buf;
+};
+
+StripStitcher::StripStitcher (uint32_t align_x)
+    : Stitcher (align_x)
+    , _configured (false)
+{
+}
+
+StripStitcher::~StripStitcher ()
+{
+    if (_threads.ptr ())
+        _threads->stop ();
+}
+
+bool
+StripStitcher::add_stitcher (const SmartPtr<Stitcher> &stitcher, uint32_t weight)
+{
+    XCAM_ASSERT (stitcher.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, !_configured, false,
+        "strip stitcher: add stitcher failed, strips already configured");
+    XCAM_FAIL_RETURN (
+        ERROR, stitcher->is_output_strip_supported () && weight > 0, false,
+        "strip stitcher: add stitcher failed, output strip not supported or weight is 0");
+    XCAM_FAIL_RETURN (
+        ERROR, get_alignment_x () % stitcher->get_alignment_x () == 0, false,
+        "strip stitcher: add stitcher failed, alignment(%d) not multiple of stitcher alignment(%d)",
+        get_alignment_x (), stitcher->get_alignment_x ());
+
+    Strip strip;
+    strip.stitcher = stitcher;
+    strip.weight = weight;
+    _strips.push_back (strip);
+    return true;
+}
+
+XCamReturn
+StripStitcher::configure_stitcher (const SmartPtr<Stitcher> &stitcher, uint32_t start_x, uint32_t width)
+{
+    uint32_t out_width = 0, out_height = 0;
+    get_output_size (out_width, out_height);
+
+    XCAM_FAIL_RETURN (
+        ERROR, stitcher->set_camera_num (get_camera_num ()), XCAM_RETURN_ERROR_PARAM,
+        "strip stitcher: set camera num failed");
+    for (uint32_t i = 0; i < get_camera_num (); ++i) {
+        CameraInfo cam_info;
+        get_camera_info (i, cam_info);
+        stitcher->set_camera_info (i, cam_info);
+
+        if (is_crop_info_set ()) {
+            ImageCropInfo crop_info;
+            get_crop_info (i, crop_info);
+            stitcher->set_crop_info (i, crop_info);
+        }
+    }
+    stitcher->set_bowl_config (get_bowl_config ());
+    stitcher->set_output_size (out_width, out_height);
+    stitcher->set_scale_mode (get_scale_mode ());
+    stitcher->enable_table_cache (is_table_cache_enabled ());
+    stitcher->set_calibration_binary (get_calibration_binary ());
+    XCAM_FAIL_RETURN (
+        ERROR, stitcher->set_fm_schedule (get_fm_schedule ()), XCAM_RETURN_ERROR_PARAM,
+        "strip stitcher: set feature match schedule failed");
+
+    XCAM_FAIL_RETURN (
+        ERROR, stitcher->set_output_strip (start_x, width), XCAM_RETURN_ERROR_PARAM,
+        "strip stitcher: set output strip(x:%d, width:%d) failed", start_x, width);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StripStitcher::configure_strips ()
+{
+    uint32_t out_width = 0, out_height = 0;
+    get_output_size (out_width, out_height);
+    XCAM_FAIL_RETURN (
+        ERROR, !_strips.empty () && out_width && out_height, XCAM_RETURN_ERROR_PARAM,
+        "strip stitcher: no stitcher added or output size not set");
+
+    uint32_t align_x = get_alignment_x ();
+    uint32_t total_width = XCAM_ALIGN_UP (out_width, align_x);
+    uint64_t total_weight = 0;
+    for (uint32_t i = 0; i < _strips.size (); ++i)
+        total_weight += _strips[i].weight;
+
+    uint64_t weight = 0;
+    uint32_t start_x = 0;
+    for (uint32_t i = 0; i < _strips.size (); ++i) {
+        weight += _strips[i].weight;
+        uint32_t end_x = (i + 1 == _strips.size ()) ? total_width :
+                         XCAM_ALIGN_DOWN ((uint32_t)(total_width * weight / total_weight), align_x);
+        XCAM_FAIL_RETURN (
+            ERROR, end_x > start_x, XCAM_RETURN_ERROR_PARAM,
+            "strip stitcher: strip(%d) is empty, output width(%d) too small for %d strips",
+            i, out_width, (uint32_t)_strips.size ());
+
+        XCamReturn ret = configure_stitcher (_strips[i].stitcher, start_x, end_x - start_x);
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "strip stitcher: configure strip(%d) failed", i);
+        XCAM_LOG_DEBUG ("strip stitcher: strip(%d) x:%d width:%d", i, start_x, end_x - start_x);
+        start_x = end_x;
+    }
+
+    if (_strips.size () > 1) {
+        _threads = new ThreadPool ("strip_stitcher");
+        _threads->set_threads (_strips.size () - 1, _strips.size () - 1);
+        XCamReturn ret = _threads->start ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "strip stitcher: start threads failed");
+    }
+
+    _configured = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+StripStitcher::stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf)
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    if (!_configured) {
+        ret = configure_strips ();
+        XCAM_FAIL_RETURN (
+            ERROR, xcam_ret_is_ok (ret), ret,
+            "strip stitcher: configure strips failed");
+    }
+
+    if (!out_buf.ptr ()) {
+        XCAM_FAIL_RETURN (
+            ERROR, _out_pool.ptr (), XCAM_RETURN_ERROR_PARAM,
+            "strip stitcher: out_buf empty and no output pool set");
+        out_buf = _out_pool->get_buffer ();
+        XCAM_FAIL_RETURN (
+            ERROR, out_buf.ptr (), XCAM_RETURN_ERROR_MEM,
+            "strip stitcher: get output buffer failed");
+    }
+
+    // strips beyond the first go to threads, the first one runs here
+    SmartPtr<StripTaskGroup> group = new StripTaskGroup (_strips.size ());
+    for (uint32_t i = 1; i < _strips.size (); ++i) {
+        SmartPtr<StripTask> task = new StripTask (group, _strips[i].stitcher, in_bufs, out_buf);
+        if (!xcam_ret_is_ok (_threads->queue (task)))
+            task->done (task->run ());
+    }
+    SmartPtr<StripTask> first = new StripTask (group, _strips[0].stitcher, in_bufs, out_buf);
+    first->done (first->run ());
+
+    return group->wait ();
+}
+
+}
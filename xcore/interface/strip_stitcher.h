@@ -0,0 +1,84 @@
+/*
+ * strip_stitcher.h - stitch output split into strips over several stitchers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_INTERFACE_STRIP_STITCHER_H
+#define XCAM_INTERFACE_STRIP_STITCHER_H
+
+#include <xcam_std.h>
+#include <interface/stitcher.h>
+#include <buffer_pool.h>
+#include <thread_pool.h>
+#include <vector>
+
+#define XCAM_STRIP_STITCHER_ALIGNMENT_X 16
+
+namespace XCam {
+
+/*
+ * StripStitcher, output columns split into strips by weight, each strip
+ * rendered by one sub stitcher (e.g. one per device) into the same host
+ * output buffer, strips run in parallel. cameras, crops, bowl, output size,
+ * scale mode, table cache, calibration binary and feature match schedule
+ * are passed to sub stitchers on first stitch; backend settings are kept.
+ * sub stitchers need output strip support and pipeline depth 1.
+ * feature match runs per strip on its own overlaps only.
+ */
+class StripStitcher
+    : public Stitcher
+{
+    struct Strip {
+        SmartPtr<Stitcher>    stitcher;
+        uint32_t              weight;
+
+        Strip () : weight (1) {}
+    };
+
+public:
+    explicit StripStitcher (uint32_t align_x = XCAM_STRIP_STITCHER_ALIGNMENT_X);
+    virtual ~StripStitcher ();
+
+    // before first stitch, larger weight gets a wider strip
+    bool add_stitcher (const SmartPtr<Stitcher> &stitcher, uint32_t weight = 1);
+    uint32_t get_stitcher_count () const {
+        return _strips.size ();
+    }
+    // empty out_buf of stitch_buffers is taken from pool
+    void set_output_pool (const SmartPtr<BufferPool> &pool) {
+        _out_pool = pool;
+    }
+
+    virtual XCamReturn stitch_buffers (const VideoBufferList &in_bufs, SmartPtr<VideoBuffer> &out_buf);
+
+private:
+    XCamReturn configure_strips ();
+    XCamReturn configure_stitcher (const SmartPtr<Stitcher> &stitcher, uint32_t start_x, uint32_t width);
+
+    XCAM_DEAD_COPY (StripStitcher);
+
+private:
+    std::vector<Strip>      _strips;
+    SmartPtr<BufferPool>    _out_pool;
+    SmartPtr<ThreadPool>    _threads;
+    bool                    _configured;
+};
+
+}
+
+#endif //XCAM_INTERFACE_STRIP_STITCHER_H
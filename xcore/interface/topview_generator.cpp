@@ -0,0 +1,178 @@
+/*
+ * topview_generator.cpp - bird's-eye view of stitched bowl image
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "topview_generator.h"
+
+namespace XCam {
+
+TopViewGenerator::TopViewGenerator (const SmartPtr<GeoMapper> &mapper)
+    : _mapper (mapper)
+    , _stitch_width (0)
+    , _stitch_height (0)
+    , _out_width (0)
+    , _out_height (0)
+    , _length_mm (0.0f)
+    , _width_mm (0.0f)
+    , _table_step (1)
+    , _table_ready (false)
+{
+    XCAM_ASSERT (mapper.ptr ());
+}
+
+TopViewGenerator::~TopViewGenerator ()
+{
+}
+
+bool
+TopViewGenerator::set_bowl (const BowlDataConfig &config, uint32_t stitch_width, uint32_t stitch_height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, stitch_width > 1 && stitch_height > 1, false,
+        "topview generator set bowl failed, invalid stitch size(%dx%d)", stitch_width, stitch_height);
+
+    SmartLock locker (_table_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_table_ready, false,
+        "topview generator set bowl failed, lookup table was already built");
+    _bowl = config;
+    _stitch_width = stitch_width;
+    _stitch_height = stitch_height;
+    return true;
+}
+
+bool
+TopViewGenerator::set_stitcher (const SmartPtr<Stitcher> &stitcher)
+{
+    XCAM_ASSERT (stitcher.ptr ());
+
+    uint32_t width = 0, height = 0;
+    stitcher->get_output_size (width, height);
+    return set_bowl (stitcher->get_bowl_config (), width, height);
+}
+
+bool
+TopViewGenerator::set_output_size (uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, width > 1 && height > 1, false,
+        "topview generator set output size failed, invalid size(%dx%d)", width, height);
+
+    SmartLock locker (_table_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_table_ready, false,
+        "topview generator set output size failed, lookup table was already built");
+    _out_width = width;
+    _out_height = height;
+    return true;
+}
+
+bool
+TopViewGenerator::set_area_mm (float length_mm, float width_mm)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, length_mm >= 0.0f && width_mm >= 0.0f, false,
+        "topview generator set area failed, invalid area(L:%.2fmm, W:%.2fmm)", length_mm, width_mm);
+
+    SmartLock locker (_table_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_table_ready, false,
+        "topview generator set area failed, lookup table was already built");
+    _length_mm = length_mm;
+    _width_mm = width_mm;
+    return true;
+}
+
+bool
+TopViewGenerator::set_table_step (uint32_t step)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, step >= 1, false,
+        "topview generator set table step failed, step need be at least 1");
+
+    SmartLock locker (_table_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_table_ready, false,
+        "topview generator set table step failed, lookup table was already built");
+    _table_step = step;
+    return true;
+}
+
+XCamReturn
+TopViewGenerator::build_table ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _stitch_width && _stitch_height && _out_width && _out_height, XCAM_RETURN_ERROR_PARAM,
+        "topview generator build table failed, bowl or output size was not set");
+
+    uint32_t table_width = (_out_width - 1) / _table_step + 1;
+    uint32_t table_height = (_out_height - 1) / _table_step + 1;
+    table_width = XCAM_MAX (table_width, 2u);
+    table_height = XCAM_MAX (table_height, 2u);
+
+    BowlModel bowl_model (_bowl, _stitch_width, _stitch_height);
+    float length_mm = _length_mm, width_mm = _width_mm;
+    if (XCAM_DOUBLE_EQUAL_AROUND (length_mm, 0.0f) || XCAM_DOUBLE_EQUAL_AROUND (width_mm, 0.0f))
+        bowl_model.get_max_topview_area_mm (length_mm, width_mm);
+
+    BowlModel::PointMap points;
+    XCAM_FAIL_RETURN (
+        ERROR, bowl_model.get_topview_rect_map (points, table_width, table_height, length_mm, width_mm),
+        XCAM_RETURN_ERROR_PARAM,
+        "topview generator build table(%dx%d) failed", table_width, table_height);
+
+    XCAM_FAIL_RETURN (
+        ERROR,
+        _mapper->set_output_size (_out_width, _out_height) &&
+        _mapper->set_lookup_table (points.data (), table_width, table_height),
+        XCAM_RETURN_ERROR_PARAM,
+        "topview generator set lookup table(%dx%d) failed", table_width, table_height);
+
+    XCAM_LOG_DEBUG (
+        "topview generator built table(%dx%d) of area(L:%.2fmm, W:%.2fmm)",
+        table_width, table_height, length_mm, width_mm);
+    _table_ready = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+TopViewGenerator::prepare ()
+{
+    SmartLock locker (_table_mutex);
+    if (_table_ready)
+        return XCAM_RETURN_NO_ERROR;
+    return build_table ();
+}
+
+XCamReturn
+TopViewGenerator::generate (const SmartPtr<VideoBuffer> &stitched, SmartPtr<VideoBuffer> &out_buf)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, stitched.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "topview generator generate failed, stitched buffer is empty");
+
+    XCamReturn ret = prepare ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "topview generator generate failed, lookup table is not ready");
+
+    return _mapper->remap (stitched, out_buf);
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * topview_generator.h - bird's-eye view of stitched bowl image
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_INTERFACE_TOPVIEW_GENERATOR_H
+#define XCAM_INTERFACE_TOPVIEW_GENERATOR_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <interface/stitcher.h>
+#include <interface/geo_mapper.h>
+
+namespace XCam {
+
+/*
+ * TopViewGenerator, remaps stitched bowl images into a top view on the ground with any
+ * GeoMapper backend. lookup table of BowlModel::get_topview_rect_map is built once, on
+ * prepare or first generate, and kept in the mapper, setters need be called before that.
+ * generate can be called from any thread once per frame.
+ */
+class TopViewGenerator
+{
+public:
+    explicit TopViewGenerator (const SmartPtr<GeoMapper> &mapper);
+    virtual ~TopViewGenerator ();
+
+    // bowl config and size of stitched image, same as stitcher
+    bool set_bowl (const BowlDataConfig &config, uint32_t stitch_width, uint32_t stitch_height);
+    bool set_stitcher (const SmartPtr<Stitcher> &stitcher);
+    bool set_output_size (uint32_t width, uint32_t height);
+    void get_output_size (uint32_t &width, uint32_t &height) const {
+        width = _out_width;
+        height = _out_height;
+    }
+    // ground area in mm, zero uses max top view area of bowl
+    bool set_area_mm (float length_mm, float width_mm);
+    // table sampled every @step output pixels, mapper interpolates between, default 1
+    bool set_table_step (uint32_t step);
+
+    const SmartPtr<GeoMapper> &get_mapper () const {
+        return _mapper;
+    }
+
+    // builds lookup table ahead of first frame
+    XCamReturn prepare ();
+    XCamReturn generate (const SmartPtr<VideoBuffer> &stitched, SmartPtr<VideoBuffer> &out_buf);
+
+private:
+    XCamReturn build_table ();
+
+    XCAM_DEAD_COPY (TopViewGenerator);
+
+private:
+    SmartPtr<GeoMapper>    _mapper;
+    BowlDataConfig         _bowl;
+    uint32_t               _stitch_width, _stitch_height;
+    uint32_t               _out_width, _out_height;
+    float                  _length_mm, _width_mm;
+    uint32_t               _table_step;
+
+    Mutex                  _table_mutex;
+    bool                   _table_ready;
+};
+
+}
+
+#endif //XCAM_INTERFACE_TOPVIEW_GENERATOR_H
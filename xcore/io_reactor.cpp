@@ -0,0 +1,206 @@
+/*
+ * io_reactor.cpp - epoll reactor dispatching device fds to a few threads
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "io_reactor.h"
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// threads wake up to check stopping
+#define XCAM_IO_REACTOR_WAIT_TIMEOUT 100 // ms
+
+namespace XCam {
+
+class IoReactorThread
+    : public Thread
+{
+public:
+    IoReactorThread (IoReactor *reactor, const char *name)
+        : Thread (name)
+        , _reactor (reactor)
+    {}
+
+protected:
+    virtual bool loop () {
+        XCamReturn ret = _reactor->wait_and_dispatch ();
+        return (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_ERROR_TIMEOUT);
+    }
+
+private:
+    IoReactor   *_reactor;
+};
+
+IoReactor::IoReactor (const char *name, uint32_t threads)
+    : _name (NULL)
+    , _thread_count (XCAM_MAX (threads, 1u))
+    , _epoll_fd (-1)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+
+    _epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    if (_epoll_fd < 0) {
+        XCAM_LOG_ERROR ("io reactor(%s) create epoll failed", XCAM_STR (_name));
+    }
+}
+
+IoReactor::~IoReactor ()
+{
+    stop ();
+    if (_epoll_fd >= 0)
+        close (_epoll_fd);
+    if (_name)
+        xcam_free (_name);
+}
+
+XCamReturn
+IoReactor::start ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd >= 0 && _threads.empty (), XCAM_RETURN_ERROR_ORDER,
+        "io reactor(%s) start failed, %s", XCAM_STR (_name), (_epoll_fd < 0 ? "no epoll" : "already started"));
+
+    for (uint32_t i = 0; i < _thread_count; ++i) {
+        SmartPtr<Thread> thread = new IoReactorThread (this, _name);
+        thread->set_policy (_policy);
+        if (!thread->start ()) {
+            XCAM_LOG_ERROR ("io reactor(%s) start thread:%d failed", XCAM_STR (_name), i);
+            stop ();
+            return XCAM_RETURN_ERROR_THREAD;
+        }
+        _threads.push_back (thread);
+    }
+
+    XCAM_LOG_INFO ("io reactor(%s) started with %d threads", XCAM_STR (_name), _thread_count);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+IoReactor::stop ()
+{
+    for (size_t i = 0; i < _threads.size (); ++i)
+        _threads[i]->stop ();
+    _threads.clear ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+IoReactor::rearm_unsafe (int fd, const Watch &watch)
+{
+    struct epoll_event event;
+    xcam_mem_clear (event);
+    event.events = watch.events | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl (_epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0) {
+        XCAM_LOG_WARNING ("io reactor(%s) rearm fd:%d failed", XCAM_STR (_name), fd);
+    }
+}
+
+XCamReturn
+IoReactor::add_fd (int fd, uint32_t events, Handler *handler)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd >= 0 && fd >= 0 && handler, XCAM_RETURN_ERROR_PARAM,
+        "io reactor(%s) add fd:%d failed, invalid params", XCAM_STR (_name), fd);
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _watches.find (fd) == _watches.end (), XCAM_RETURN_ERROR_PARAM,
+        "io reactor(%s) fd:%d already added", XCAM_STR (_name), fd);
+
+    Watch &watch = _watches[fd];
+    watch.handler = handler;
+    watch.events = events;
+
+    struct epoll_event event;
+    xcam_mem_clear (event);
+    event.events = events | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        _watches.erase (fd);
+        XCAM_LOG_ERROR ("io reactor(%s) add fd:%d to epoll failed", XCAM_STR (_name), fd);
+        return XCAM_RETURN_ERROR_FILE;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+IoReactor::remove_fd (int fd)
+{
+    SmartLock locker (_mutex);
+    std::map<int, Watch>::iterator i_watch = _watches.find (fd);
+    XCAM_FAIL_RETURN (
+        WARNING, i_watch != _watches.end (), XCAM_RETURN_ERROR_PARAM,
+        "io reactor(%s) remove fd:%d failed, not added", XCAM_STR (_name), fd);
+
+    epoll_ctl (_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+    i_watch->second.removed = true;
+    while (i_watch->second.busy)
+        _idle_cond.wait (_mutex);
+
+    _watches.erase (i_watch);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+IoReactor::wait_and_dispatch ()
+{
+    // one event each time, ready fds spread over threads
+    struct epoll_event event;
+    int count = epoll_wait (_epoll_fd, &event, 1, XCAM_IO_REACTOR_WAIT_TIMEOUT);
+    if (count < 0) {
+        if (errno == EINTR)
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        XCAM_LOG_WARNING ("io reactor(%s) epoll wait failed", XCAM_STR (_name));
+        return XCAM_RETURN_ERROR_FILE;
+    }
+    if (count == 0)
+        return XCAM_RETURN_ERROR_TIMEOUT;
+
+    int fd = event.data.fd;
+    Handler *handler = NULL;
+    {
+        SmartLock locker (_mutex);
+        std::map<int, Watch>::iterator i_watch = _watches.find (fd);
+        if (i_watch == _watches.end () || i_watch->second.removed)
+            return XCAM_RETURN_NO_ERROR;
+        i_watch->second.busy = true;
+        handler = i_watch->second.handler;
+    }
+
+    bool keep = handler->io_ready (fd, event.events);
+
+    SmartLock locker (_mutex);
+    std::map<int, Watch>::iterator i_watch = _watches.find (fd);
+    XCAM_ASSERT (i_watch != _watches.end ());
+    Watch &watch = i_watch->second;
+    watch.busy = false;
+    if (watch.removed) {
+        _idle_cond.broadcast ();
+    } else if (keep) {
+        rearm_unsafe (fd, watch);
+    } else {
+        XCAM_LOG_WARNING ("io reactor(%s) stops watching fd:%d", XCAM_STR (_name), fd);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,108 @@
+/*
+ * io_reactor.h - epoll reactor dispatching device fds to a few threads
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_IO_REACTOR_H
+#define XCAM_IO_REACTOR_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <map>
+#include <vector>
+
+#define XCAM_IO_REACTOR_DEFAULT_THREADS 1
+
+namespace XCam {
+
+class IoReactorThread;
+
+/*
+ * one epoll shared by capture, event and stats fds of all devices.
+ * a fd is dispatched to one thread at a time, so its handler needs no lock of its own.
+ */
+class IoReactor
+    : public RefObj
+{
+    friend class IoReactorThread;
+
+public:
+    class Handler {
+    public:
+        Handler () {}
+        virtual ~Handler () {}
+        // events are EPOLLIN, EPOLLPRI, EPOLLERR or EPOLLHUP; return false to stop watching fd
+        virtual bool io_ready (int fd, uint32_t events) = 0;
+    private:
+        XCAM_DEAD_COPY (Handler);
+    };
+
+private:
+    struct Watch {
+        Handler    *handler;
+        uint32_t    events;
+        bool        busy;
+        bool        removed;
+
+        Watch () : handler (NULL), events (0), busy (false), removed (false) {}
+    };
+
+public:
+    explicit IoReactor (const char *name, uint32_t threads = XCAM_IO_REACTOR_DEFAULT_THREADS);
+    virtual ~IoReactor ();
+
+    const char *get_name () const {
+        return _name;
+    }
+    // set before start
+    void set_thread_policy (const ThreadPolicy &policy) {
+        _policy = policy;
+    }
+
+    XCamReturn start ();
+    XCamReturn stop ();
+    bool is_running () const {
+        return !_threads.empty ();
+    }
+
+    // fds can be added before or after start, handler must be valid till remove_fd returns
+    XCamReturn add_fd (int fd, uint32_t events, Handler *handler);
+    // waits the running handler of fd, don't call it from that handler
+    XCamReturn remove_fd (int fd);
+
+private:
+    XCamReturn wait_and_dispatch ();
+    void rearm_unsafe (int fd, const Watch &watch);
+
+    XCAM_DEAD_COPY (IoReactor);
+
+private:
+    char                                  *_name;
+    uint32_t                               _thread_count;
+    ThreadPolicy                           _policy;
+    std::vector<SmartPtr<Thread> >         _threads;
+    int                                    _epoll_fd;
+    std::map<int, Watch>                   _watches;
+    Mutex                                  _mutex;
+    Cond                                   _idle_cond;
+};
+
+}
+
+#endif // XCAM_IO_REACTOR_H
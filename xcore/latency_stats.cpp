@@ -0,0 +1,78 @@
+/*
+ * latency_stats.cpp - latency percentiles over recent samples
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "latency_stats.h"
+#include <algorithm>
+
+namespace XCam {
+
+LatencyStats::LatencyStats (uint32_t window)
+    : _window (XCAM_MAX (window, 1u))
+    , _next (0)
+    , _total (0)
+{
+    _samples.reserve (_window);
+}
+
+void
+LatencyStats::add (int64_t latency)
+{
+    if (_samples.size () < _window)
+        _samples.push_back (latency);
+    else
+        _samples[_next] = latency;
+
+    _next = (_next + 1) % _window;
+    ++_total;
+}
+
+void
+LatencyStats::reset ()
+{
+    _samples.clear ();
+    _next = 0;
+    _total = 0;
+}
+
+int64_t
+LatencyStats::get_percentile (double percent) const
+{
+    if (_samples.empty ())
+        return 0;
+
+    size_t count = _samples.size ();
+    size_t rank = (size_t) ceil (XCAM_CLAMP (percent, 0.0, 100.0) / 100.0 * count);
+    size_t index = (rank > 0 ? rank - 1 : 0);
+
+    _sorted = _samples;
+    std::nth_element (_sorted.begin (), _sorted.begin () + index, _sorted.end ());
+    return _sorted[index];
+}
+
+int64_t
+LatencyStats::get_max () const
+{
+    if (_samples.empty ())
+        return 0;
+
+    return *std::max_element (_samples.begin (), _samples.end ());
+}
+
+}
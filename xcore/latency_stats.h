@@ -0,0 +1,67 @@
+/*
+ * latency_stats.h - latency percentiles over recent samples
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_LATENCY_STATS_H
+#define XCAM_LATENCY_STATS_H
+
+#include <xcam_std.h>
+#include <vector>
+
+#define XCAM_LATENCY_STATS_DEFAULT_WINDOW 256
+
+namespace XCam {
+
+/*
+ * LatencyStats, percentiles over the latest @window samples, in microseconds.
+ * not thread-safe, feed and read it from one thread.
+ */
+class LatencyStats
+{
+public:
+    explicit LatencyStats (uint32_t window = XCAM_LATENCY_STATS_DEFAULT_WINDOW);
+
+    void add (int64_t latency);
+    void reset ();
+
+    // samples added since reset, including those out of window
+    uint64_t get_total_count () const {
+        return _total;
+    }
+    uint32_t get_sample_count () const {
+        return _samples.size ();
+    }
+    // nearest rank of @percent in [0, 100], 0 without samples
+    int64_t get_percentile (double percent) const;
+    int64_t get_max () const;
+
+private:
+    XCAM_DEAD_COPY (LatencyStats);
+
+private:
+    std::vector<int64_t>            _samples;
+    mutable std::vector<int64_t>    _sorted;
+    uint32_t                        _window;
+    uint32_t                        _next;
+    uint64_t                        _total;
+};
+
+}
+
+#endif //XCAM_LATENCY_STATS_H
@@ -0,0 +1,272 @@
+/*
+ * lossless_codec.cpp - lossless coding of image planes
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "lossless_codec.h"
+
+#define LOSSLESS_BLOCK_SIZE 16
+#define LOSSLESS_K_BITS 3
+#define LOSSLESS_MAX_K 6
+// k code of a block of zero residuals, nothing else is coded for it
+#define LOSSLESS_ZERO_BLOCK 7
+// quotients from this on are sent as 8 raw bits after as many zeros
+#define LOSSLESS_ESCAPE 15
+
+namespace XCam {
+
+static inline uint8_t
+zigzag (uint8_t diff)
+{
+    int32_t s = (int8_t)diff;
+    return (uint8_t)((s << 1) ^ (s >> 7));
+}
+
+static inline uint8_t
+unzigzag (uint8_t z)
+{
+    return (uint8_t)((z >> 1) ^ (uint8_t)(-(int32_t)(z & 1)));
+}
+
+static inline uint8_t
+med_predict (uint8_t a, uint8_t b, uint8_t c)
+{
+    uint8_t max = XCAM_MAX (a, b), min = XCAM_MIN (a, b);
+    if (c >= max)
+        return min;
+    if (c <= min)
+        return max;
+    return (uint8_t)(a + b - c);
+}
+
+// left pixel on first row, upper one on first pixels of other rows
+static void
+get_residuals (const uint8_t *row, const uint8_t *up, uint32_t len, uint32_t ch, uint8_t *res)
+{
+    uint32_t first = XCAM_MIN (ch, len);
+    if (!up) {
+        for (uint32_t i = 0; i < first; ++i)
+            res[i] = zigzag (row[i]);
+        for (uint32_t i = first; i < len; ++i)
+            res[i] = zigzag (row[i] - row[i - ch]);
+        return;
+    }
+
+    for (uint32_t i = 0; i < first; ++i)
+        res[i] = zigzag (row[i] - up[i]);
+    for (uint32_t i = first; i < len; ++i)
+        res[i] = zigzag (row[i] - med_predict (row[i - ch], up[i], up[i - ch]));
+}
+
+static void
+put_residuals (uint8_t *row, const uint8_t *up, uint32_t len, uint32_t ch, const uint8_t *res)
+{
+    uint32_t first = XCAM_MIN (ch, len);
+    if (!up) {
+        for (uint32_t i = 0; i < first; ++i)
+            row[i] = unzigzag (res[i]);
+        for (uint32_t i = first; i < len; ++i)
+            row[i] = row[i - ch] + unzigzag (res[i]);
+        return;
+    }
+
+    for (uint32_t i = 0; i < first; ++i)
+        row[i] = up[i] + unzigzag (res[i]);
+    for (uint32_t i = first; i < len; ++i)
+        row[i] = med_predict (row[i - ch], up[i], up[i - ch]) + unzigzag (res[i]);
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter (std::vector<uint8_t> &out)
+        : _out (out), _acc (0), _bits (0)
+    {}
+
+    // @n up to 32 bits
+    inline void put (uint32_t value, uint32_t n) {
+        _acc = (_acc << n) | value;
+        _bits += n;
+        while (_bits >= 8) {
+            _bits -= 8;
+            _out.push_back ((uint8_t)(_acc >> _bits));
+        }
+    }
+    void flush () {
+        if (_bits)
+            _out.push_back ((uint8_t)(_acc << (8 - _bits)));
+        _bits = 0;
+    }
+
+private:
+    std::vector<uint8_t>   &_out;
+    uint64_t                _acc;
+    uint32_t                _bits;
+};
+
+// msb aligned, reads zeros past the end and counts them
+class BitReader
+{
+public:
+    BitReader (const uint8_t *data, size_t size)
+        : _ptr (data), _end (data + size), _acc (0), _bits (0), _padding (0)
+    {}
+
+    inline void refill () {
+        while (_bits <= 56) {
+            uint64_t byte = 0;
+            if (_ptr < _end)
+                byte = *_ptr++;
+            else
+                ++_padding;
+            _acc |= byte << (56 - _bits);
+            _bits += 8;
+        }
+    }
+    // @n from 1 to 32, refill first
+    inline uint32_t peek (uint32_t n) const {
+        return (uint32_t)(_acc >> (64 - n));
+    }
+    inline void skip (uint32_t n) {
+        _acc <<= n;
+        _bits -= n;
+    }
+    inline uint32_t leading_zeros () const {
+        return _acc ? __builtin_clzll (_acc) : 64;
+    }
+    bool is_overrun () const {
+        return (uint64_t)_padding * 8 > _bits;
+    }
+
+private:
+    const uint8_t    *_ptr;
+    const uint8_t    *_end;
+    uint64_t          _acc;
+    uint32_t          _bits;
+    uint32_t          _padding;
+};
+
+static void
+encode_block (BitWriter &writer, const uint8_t *res, uint32_t n)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; ++i)
+        sum += res[i];
+
+    if (!sum) {
+        writer.put (LOSSLESS_ZERO_BLOCK, LOSSLESS_K_BITS);
+        return;
+    }
+
+    // 2^k around the mean residual
+    uint32_t k = 0;
+    while (k < LOSSLESS_MAX_K && (n << (k + 1)) <= sum)
+        ++k;
+    writer.put (k, LOSSLESS_K_BITS);
+
+    uint32_t mask = (1u << k) - 1;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t q = res[i] >> k;
+        if (q >= LOSSLESS_ESCAPE)
+            writer.put (res[i], LOSSLESS_ESCAPE + 8);
+        else
+            writer.put ((1u << k) | (res[i] & mask), q + 1 + k);
+    }
+}
+
+static bool
+decode_block (BitReader &reader, uint8_t *res, uint32_t n)
+{
+    reader.refill ();
+    uint32_t k = reader.peek (LOSSLESS_K_BITS);
+    reader.skip (LOSSLESS_K_BITS);
+
+    if (k == LOSSLESS_ZERO_BLOCK) {
+        memset (res, 0, n);
+        return true;
+    }
+    if (k > LOSSLESS_MAX_K)
+        return false;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        reader.refill ();
+        uint32_t q = reader.leading_zeros ();
+        if (q >= LOSSLESS_ESCAPE) {
+            reader.skip (LOSSLESS_ESCAPE);
+            res[i] = (uint8_t)reader.peek (8);
+            reader.skip (8);
+            continue;
+        }
+
+        reader.skip (q + 1);
+        uint32_t low = 0;
+        if (k) {
+            low = reader.peek (k);
+            reader.skip (k);
+        }
+        uint32_t value = (q << k) | low;
+        if (value > 0xFF)
+            return false;
+        res[i] = (uint8_t)value;
+    }
+    return true;
+}
+
+void
+LosslessCodec::encode (
+    const uint8_t *src, uint32_t stride, uint32_t row_bytes, uint32_t rows, uint32_t channels,
+    std::vector<uint8_t> &out)
+{
+    XCAM_ASSERT (src && channels);
+    BitWriter writer (out);
+    std::vector<uint8_t> res (row_bytes);
+
+    for (uint32_t y = 0; y < rows; ++y) {
+        const uint8_t *row = src + (size_t)y * stride;
+        get_residuals (row, y ? row - stride : NULL, row_bytes, channels, res.data ());
+
+        for (uint32_t x = 0; x < row_bytes; x += LOSSLESS_BLOCK_SIZE)
+            encode_block (writer, res.data () + x, XCAM_MIN (row_bytes - x, (uint32_t)LOSSLESS_BLOCK_SIZE));
+    }
+    writer.flush ();
+}
+
+bool
+LosslessCodec::decode (
+    const uint8_t *data, size_t size,
+    uint8_t *dst, uint32_t stride, uint32_t row_bytes, uint32_t rows, uint32_t channels)
+{
+    XCAM_ASSERT (data && dst && channels);
+    BitReader reader (data, size);
+    std::vector<uint8_t> res (row_bytes);
+
+    for (uint32_t y = 0; y < rows; ++y) {
+        for (uint32_t x = 0; x < row_bytes; x += LOSSLESS_BLOCK_SIZE) {
+            uint32_t n = XCAM_MIN (row_bytes - x, (uint32_t)LOSSLESS_BLOCK_SIZE);
+            XCAM_FAIL_RETURN (
+                ERROR, decode_block (reader, res.data () + x, n) && !reader.is_overrun (), false,
+                "lossless decode failed at row:%d column:%d, data is broken", y, x);
+        }
+
+        uint8_t *row = dst + (size_t)y * stride;
+        put_residuals (row, y ? row - stride : NULL, row_bytes, channels, res.data ());
+    }
+    return true;
+}
+
+}
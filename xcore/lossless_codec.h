@@ -0,0 +1,51 @@
+/*
+ * lossless_codec.h - lossless coding of image planes
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_LOSSLESS_CODEC_H
+#define XCAM_LOSSLESS_CODEC_H
+
+#include <xcam_std.h>
+#include <vector>
+
+namespace XCam {
+
+/*
+ * LosslessCodec, codes rows of one 8-bit plane bit-exactly.
+ * samples are predicted by the median edge detector of LOCO-I on the same channel of left, upper
+ * and upper-left pixels, residuals are Rice coded in blocks of 16 with a parameter of their own.
+ * rows are coded alone from the first one, so stripes of a plane can be coded in parallel.
+ * 16-bit planes are coded as bytes of @channels, still exact but less compact.
+ */
+class LosslessCodec
+{
+public:
+    // @row_bytes of each of @rows rows, @channels interleaved samples per pixel, appended to @out
+    static void encode (
+        const uint8_t *src, uint32_t stride, uint32_t row_bytes, uint32_t rows, uint32_t channels,
+        std::vector<uint8_t> &out);
+    // false if @data of @size is broken or shorter than coded rows
+    static bool decode (
+        const uint8_t *data, size_t size,
+        uint8_t *dst, uint32_t stride, uint32_t row_bytes, uint32_t rows, uint32_t channels);
+};
+
+}
+
+#endif //XCAM_LOSSLESS_CODEC_H
@@ -0,0 +1,292 @@
+/*
+ * memory_accounting.cpp - memory accounting of handlers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "memory_accounting.h"
+
+namespace XCam {
+
+static __thread uint32_t tls_mem_owner = MemoryAccounting::RootOwner;
+static __thread bool tls_mem_pooled = false;
+
+MemoryUsage::MemoryUsage ()
+    : total (0)
+    , peak (0)
+    , budget (0)
+{
+    xcam_mem_clear (bytes);
+}
+
+MemoryAccounting::Owner::Owner ()
+    : parent (RootOwner)
+    , total (0)
+    , peak (0)
+    , budget (0)
+    , over_budget (false)
+{
+    xcam_mem_clear (bytes);
+}
+
+MemoryAccounting::MemoryAccounting ()
+{
+    _owners.push_back (Owner ());
+}
+
+MemoryAccounting *
+MemoryAccounting::instance ()
+{
+    // never destroyed, memory of static objects may be returned after exit
+    static MemoryAccounting *accounting = new MemoryAccounting;
+    return accounting;
+}
+
+uint32_t
+MemoryAccounting::get_owner_unsafe (uint32_t parent, const char *name)
+{
+    XCAM_ASSERT (parent < _owners.size ());
+
+    std::string path = _owners[parent].name;
+    if (!path.empty ())
+        path += "/";
+    path += XCAM_STR (name);
+
+    OwnerMap::iterator iter = _owner_map.find (path);
+    if (iter != _owner_map.end ())
+        return iter->second;
+
+    Owner owner;
+    owner.name = path;
+    owner.parent = parent;
+    _owners.push_back (owner);
+
+    uint32_t id = _owners.size () - 1;
+    _owner_map[path] = id;
+    return id;
+}
+
+uint32_t
+MemoryAccounting::get_owner (uint32_t parent, const char *name)
+{
+    XCAM_ASSERT (name && name[0]);
+    SmartLock locker (_mutex);
+    if (parent >= _owners.size ())
+        parent = RootOwner;
+    return get_owner_unsafe (parent, name);
+}
+
+uint32_t
+MemoryAccounting::get_owner (const char *path)
+{
+    SmartLock locker (_mutex);
+    uint32_t id = RootOwner;
+    std::string names = XCAM_STR (path);
+
+    size_t start = 0;
+    while (start < names.length ()) {
+        size_t end = names.find ('/', start);
+        if (end == std::string::npos)
+            end = names.length ();
+        if (end > start)
+            id = get_owner_unsafe (id, names.substr (start, end - start).c_str ());
+        start = end + 1;
+    }
+    return id;
+}
+
+void
+MemoryAccounting::charge (uint32_t owner, MemoryKind kind, int64_t bytes)
+{
+    XCAM_ASSERT (kind < MemoryKindCount);
+    if (!bytes)
+        return;
+
+    SmartLock locker (_mutex);
+    XCAM_ASSERT (owner < _owners.size ());
+    if (owner >= _owners.size ())
+        owner = RootOwner;
+
+    _owners[owner].bytes[kind] += bytes;
+    for (uint32_t id = owner; ; id = _owners[id].parent) {
+        Owner &o = _owners[id];
+        o.total += bytes;
+        o.peak = XCAM_MAX (o.peak, o.total);
+
+        if (o.budget && o.total > o.budget && !o.over_budget) {
+            o.over_budget = true;
+            XCAM_LOG_WARNING (
+                "memory of owner(%s) %" PRId64 " bytes is over budget %" PRId64 " bytes",
+                o.name.empty () ? "process" : o.name.c_str (), o.total, o.budget);
+        } else if (o.over_budget && o.total <= o.budget) {
+            o.over_budget = false;
+        }
+
+        if (id == RootOwner)
+            break;
+    }
+}
+
+void
+MemoryAccounting::set_budget (const char *path, int64_t bytes)
+{
+    uint32_t id = get_owner (path);
+
+    SmartLock locker (_mutex);
+    Owner &owner = _owners[id];
+    owner.budget = XCAM_MAX (bytes, 0);
+    owner.over_budget = false;
+}
+
+void
+MemoryAccounting::fill_usage_unsafe (const Owner &owner, MemoryUsage &usage) const
+{
+    usage.owner = owner.name;
+    for (uint32_t i = 0; i < MemoryKindCount; ++i)
+        usage.bytes[i] = owner.bytes[i];
+    usage.total = owner.total;
+    usage.peak = owner.peak;
+    usage.budget = owner.budget;
+}
+
+void
+MemoryAccounting::get_usage (std::vector<MemoryUsage> &usages) const
+{
+    SmartLock locker (_mutex);
+    usages.resize (_owners.size ());
+    for (uint32_t i = 0; i < _owners.size (); ++i)
+        fill_usage_unsafe (_owners[i], usages[i]);
+}
+
+bool
+MemoryAccounting::get_usage (const char *path, MemoryUsage &usage) const
+{
+    SmartLock locker (_mutex);
+    if (!path || !path[0]) {
+        fill_usage_unsafe (_owners[RootOwner], usage);
+        return true;
+    }
+
+    OwnerMap::const_iterator iter = _owner_map.find (path);
+    if (iter == _owner_map.end ())
+        return false;
+
+    fill_usage_unsafe (_owners[iter->second], usage);
+    return true;
+}
+
+int64_t
+MemoryAccounting::get_total () const
+{
+    SmartLock locker (_mutex);
+    return _owners[RootOwner].total;
+}
+
+void
+MemoryAccounting::dump () const
+{
+    std::vector<MemoryUsage> usages;
+    get_usage (usages);
+
+    for (uint32_t i = 0; i < usages.size (); ++i) {
+        const MemoryUsage &usage = usages[i];
+        if (!usage.total && i != RootOwner)
+            continue;
+
+        char kinds[256];
+        int len = 0;
+        for (uint32_t k = 0; k < MemoryKindCount && len < (int)sizeof (kinds); ++k) {
+            if (usage.bytes[k])
+                len += snprintf (
+                           kinds + len, sizeof (kinds) - len, " %s:%" PRId64,
+                           kind_name ((MemoryKind)k), usage.bytes[k]);
+        }
+        kinds[XCAM_MIN (len, (int)sizeof (kinds) - 1)] = '\0';
+
+        XCAM_LOG_INFO (
+            "memory owner(%s) total:%" PRId64 " peak:%" PRId64 " budget:%" PRId64 "%s",
+            usage.owner.empty () ? "process" : usage.owner.c_str (),
+            usage.total, usage.peak, usage.budget, kinds);
+    }
+}
+
+const char *
+MemoryAccounting::kind_name (MemoryKind kind)
+{
+    static const char *names[] = {"host", "pool", "cl", "gl", "vk"};
+    static_assert (sizeof (names) / sizeof (names[0]) == MemoryKindCount, "kind names mismatch");
+    return kind < MemoryKindCount ? names[kind] : "unknown";
+}
+
+MemoryOwnerScope::MemoryOwnerScope (const char *name)
+    : _prev_owner (tls_mem_owner)
+    , _prev_pooled (tls_mem_pooled)
+{
+    if (name && name[0])
+        tls_mem_owner = MemoryAccounting::instance ()->get_owner (_prev_owner, name);
+}
+
+MemoryOwnerScope::MemoryOwnerScope (uint32_t owner, bool pooled)
+    : _prev_owner (tls_mem_owner)
+    , _prev_pooled (tls_mem_pooled)
+{
+    tls_mem_owner = owner;
+    tls_mem_pooled = pooled || _prev_pooled;
+}
+
+MemoryOwnerScope::~MemoryOwnerScope ()
+{
+    tls_mem_owner = _prev_owner;
+    tls_mem_pooled = _prev_pooled;
+}
+
+uint32_t
+MemoryOwnerScope::current ()
+{
+    return tls_mem_owner;
+}
+
+bool
+MemoryOwnerScope::is_pooled ()
+{
+    return tls_mem_pooled;
+}
+
+MemoryCharge::MemoryCharge (MemoryKind kind)
+    : _owner (tls_mem_owner)
+    , _kind (kind)
+    , _bytes (0)
+    , _pooled (tls_mem_pooled)
+{
+}
+
+MemoryCharge::~MemoryCharge ()
+{
+    charge (0);
+}
+
+void
+MemoryCharge::charge (int64_t bytes)
+{
+    if (_pooled || bytes == _bytes)
+        return;
+
+    MemoryAccounting::instance ()->charge (_owner, _kind, bytes - _bytes);
+    _bytes = bytes;
+}
+
+}
@@ -0,0 +1,171 @@
+/*
+ * memory_accounting.h - memory accounting of handlers
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_MEMORY_ACCOUNTING_H
+#define XCAM_MEMORY_ACCOUNTING_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace XCam {
+
+enum MemoryKind {
+    MemoryHost = 0,
+    // data of BufferPool, whatever memory it is made of
+    MemoryPool,
+    MemoryCL,
+    MemoryGL,
+    MemoryVK,
+    MemoryKindCount,
+};
+
+struct MemoryUsage {
+    // owner path, parent names first joined by '/', empty for allocations without owner
+    std::string     owner;
+    // charged to the owner itself
+    int64_t         bytes[MemoryKindCount];
+    // owner and owners under it
+    int64_t         total;
+    int64_t         peak;
+    // 0 means no budget
+    int64_t         budget;
+
+    MemoryUsage ();
+};
+
+/*
+ * MemoryAccounting, bytes allocated by named owners, such as handlers and stitchers.
+ * owners nest by MemoryOwnerScope, usage is kept by owner and memory kind.
+ * budgets are only reported, an owner going over its budget is logged once until back under.
+ * thread-safe.
+ */
+class MemoryAccounting
+{
+    struct Owner {
+        std::string     name;
+        uint32_t        parent;
+        int64_t         bytes[MemoryKindCount];
+        int64_t         total;
+        int64_t         peak;
+        int64_t         budget;
+        bool            over_budget;
+
+        Owner ();
+    };
+    typedef std::map<std::string, uint32_t> OwnerMap;
+
+public:
+    // id 0 is the root, which owns allocations out of any scope and totals all owners
+    static const uint32_t RootOwner = 0;
+
+    static MemoryAccounting *instance ();
+
+    // id of @name under @parent, created on first use
+    uint32_t get_owner (uint32_t parent, const char *name);
+    // id of owner @path, names joined by '/', created on first use
+    uint32_t get_owner (const char *path);
+
+    // negative @bytes returns memory
+    void charge (uint32_t owner, MemoryKind kind, int64_t bytes);
+
+    // budget of @path and owners under it, empty @path sets process budget, 0 removes it
+    void set_budget (const char *path, int64_t bytes);
+
+    // owners ever charged or budgeted, in creation order, the root first
+    void get_usage (std::vector<MemoryUsage> &usages) const;
+    bool get_usage (const char *path, MemoryUsage &usage) const;
+    int64_t get_total () const;
+
+    // logs usage of owners holding memory
+    void dump () const;
+
+    static const char *kind_name (MemoryKind kind);
+
+private:
+    MemoryAccounting ();
+    uint32_t get_owner_unsafe (uint32_t parent, const char *name);
+    void fill_usage_unsafe (const Owner &owner, MemoryUsage &usage) const;
+
+    XCAM_DEAD_COPY (MemoryAccounting);
+
+private:
+    mutable Mutex           _mutex;
+    std::vector<Owner>      _owners;
+    OwnerMap                _owner_map;
+};
+
+/*
+ * MemoryOwnerScope, memory allocated by this thread within the scope is charged to it.
+ * scopes nest, a named scope is an owner under the enclosing one.
+ */
+class MemoryOwnerScope
+{
+public:
+    explicit MemoryOwnerScope (const char *name);
+    // @pooled, memory charged by BufferPool, allocations within the scope are not charged again
+    explicit MemoryOwnerScope (uint32_t owner, bool pooled = false);
+    ~MemoryOwnerScope ();
+
+    static uint32_t current ();
+    static bool is_pooled ();
+
+private:
+    XCAM_DEAD_COPY (MemoryOwnerScope);
+
+private:
+    uint32_t                _prev_owner;
+    bool                    _prev_pooled;
+};
+
+/*
+ * MemoryCharge, held by an object owning memory of @kind,
+ * the owner is caught on construction and the memory is returned on destruction.
+ */
+class MemoryCharge
+{
+public:
+    explicit MemoryCharge (MemoryKind kind);
+    ~MemoryCharge ();
+
+    // memory now held is @bytes
+    void charge (int64_t bytes);
+    int64_t get_bytes () const {
+        return _bytes;
+    }
+    uint32_t get_owner () const {
+        return _owner;
+    }
+
+private:
+    XCAM_DEAD_COPY (MemoryCharge);
+
+private:
+    uint32_t                _owner;
+    MemoryKind              _kind;
+    int64_t                 _bytes;
+    bool                    _pooled;
+};
+
+}
+
+#endif //XCAM_MEMORY_ACCOUNTING_H
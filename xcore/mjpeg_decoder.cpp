@@ -0,0 +1,450 @@
+/*
+ * mjpeg_decoder.cpp - mjpeg decoder
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "mjpeg_decoder.h"
+#include "poll_thread.h"
+#include <stdio.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <vector>
+
+// warn once every so many dropped frames
+#define XCAM_MJPEG_DROP_LOG_INTERVAL 30
+
+namespace XCam {
+
+class MjpegHeapData
+    : public BufferData
+{
+public:
+    explicit MjpegHeapData (uint32_t size)
+        : _mem ((uint8_t *)xcam_malloc0 (size))
+    {
+        XCAM_ASSERT (_mem);
+    }
+    ~MjpegHeapData () {
+        xcam_free (_mem);
+    }
+
+    virtual uint8_t *map () {
+        return _mem;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+
+private:
+    XCAM_DEAD_COPY (MjpegHeapData);
+
+private:
+    uint8_t    *_mem;
+};
+
+class MjpegBufferPool
+    : public BufferPool
+{
+public:
+    explicit MjpegBufferPool () {}
+
+private:
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info) {
+        return new MjpegHeapData (buffer_info.size);
+    }
+
+    XCAM_DEAD_COPY (MjpegBufferPool);
+};
+
+class MjpegDecodeWork
+    : public ThreadPool::UserData
+{
+public:
+    MjpegDecodeWork (
+        MjpegDecoder *decoder, uint32_t seq,
+        const SmartPtr<VideoBuffer> &jpeg, uint32_t size, const SmartPtr<VideoBuffer> &out)
+        : _decoder (decoder)
+        , _seq (seq)
+        , _timestamp (jpeg->get_timestamp ())
+        , _jpeg (jpeg)
+        , _size (size)
+        , _out (out)
+    {}
+
+    virtual XCamReturn run () {
+        uint8_t *data = _jpeg->map ();
+        XCAM_FAIL_RETURN (
+            WARNING, data, XCAM_RETURN_ERROR_MEM,
+            "mjpeg decoder(%s) map jpeg buffer failed", XCAM_STR (_decoder->get_name ()));
+
+        XCamReturn ret = MjpegDecoder::decode (data, _size, _out);
+        _jpeg->unmap ();
+        _out->set_timestamp (_timestamp);
+        FrameLatencyMeta::stamp (_out, "mjpeg-decode");
+        return ret;
+    }
+
+    virtual void done (XCamReturn err) {
+        // give capture buffer back to device before posting
+        _jpeg.release ();
+        _decoder->decode_done (_seq, _timestamp, xcam_ret_is_ok (err) ? _out : NULL);
+        _out.release ();
+    }
+
+private:
+    MjpegDecoder             *_decoder;
+    uint32_t                  _seq;
+    int64_t                   _timestamp;
+    SmartPtr<VideoBuffer>     _jpeg;
+    uint32_t                  _size;
+    SmartPtr<VideoBuffer>     _out;
+};
+
+struct MjpegErrorMgr {
+    struct jpeg_error_mgr  pub;
+    jmp_buf                jump;
+};
+
+static void
+mjpeg_error_exit (j_common_ptr cinfo)
+{
+    char msg[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message) (cinfo, msg);
+    XCAM_LOG_WARNING ("mjpeg decode failed: %s", msg);
+
+    MjpegErrorMgr *err = (MjpegErrorMgr *)cinfo->err;
+    longjmp (err->jump, 1);
+}
+
+// corrupt data warnings are common on USB cameras, keep them in debug log
+static void
+mjpeg_output_message (j_common_ptr cinfo)
+{
+    char msg[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message) (cinfo, msg);
+    XCAM_LOG_DEBUG ("mjpeg decode: %s", msg);
+    XCAM_UNUSED (msg);
+}
+
+// average of 2x2 luma area in chroma plane subsampled by @rx, @ry
+inline static uint8_t
+chroma_at (JSAMPARRAY rows, uint32_t x, uint32_t y, uint32_t rx, uint32_t ry)
+{
+    uint32_t x0 = (2 * x) / rx, x1 = (2 * x + 1) / rx;
+    const JSAMPLE *r0 = rows[(2 * y) / ry];
+    const JSAMPLE *r1 = rows[(2 * y + 1) / ry];
+    return (uint8_t)((r0[x0] + r0[x1] + r1[x0] + r1[x1] + 2) >> 2);
+}
+
+static bool
+decode_raw (
+    struct jpeg_decompress_struct &cinfo, const VideoBufferInfo &info, uint8_t *out_mem,
+    std::vector<JSAMPLE> &scratch)
+{
+    jpeg_read_header (&cinfo, TRUE);
+
+    XCAM_FAIL_RETURN (
+        WARNING, cinfo.image_width == info.width && cinfo.image_height == info.height, false,
+        "mjpeg size(%dx%d) mismatch output(%dx%d)",
+        cinfo.image_width, cinfo.image_height, info.width, info.height);
+    XCAM_FAIL_RETURN (
+        WARNING,
+        (cinfo.num_components == 3 && cinfo.jpeg_color_space == JCS_YCbCr) ||
+        (cinfo.num_components == 1 && cinfo.jpeg_color_space == JCS_GRAYSCALE),
+        false,
+        "mjpeg color space(%d) with %d components unsupported",
+        cinfo.jpeg_color_space, cinfo.num_components);
+
+    XCAM_FAIL_RETURN (
+        WARNING, cinfo.max_v_samp_factor <= 2, false,
+        "mjpeg vertical sampling factor(%d) unsupported", cinfo.max_v_samp_factor);
+
+    jpeg_component_info *comps = cinfo.comp_info;
+    uint32_t rx = 1, ry = 1;
+    if (cinfo.num_components == 3) {
+        XCAM_FAIL_RETURN (
+            WARNING,
+            comps[1].h_samp_factor == comps[2].h_samp_factor &&
+            comps[1].v_samp_factor == comps[2].v_samp_factor &&
+            comps[0].h_samp_factor == cinfo.max_h_samp_factor &&
+            comps[0].v_samp_factor == cinfo.max_v_samp_factor,
+            false,
+            "mjpeg chroma sampling unsupported");
+        rx = comps[0].h_samp_factor / comps[1].h_samp_factor;
+        ry = comps[0].v_samp_factor / comps[1].v_samp_factor;
+        XCAM_FAIL_RETURN (
+            WARNING, (rx == 1 || rx == 2) && (ry == 1 || ry == 2) &&
+            rx * comps[1].h_samp_factor == (uint32_t)comps[0].h_samp_factor &&
+            ry * comps[1].v_samp_factor == (uint32_t)comps[0].v_samp_factor,
+            false,
+            "mjpeg sampling(%dx%d, %dx%d) unsupported",
+            comps[0].h_samp_factor, comps[0].v_samp_factor,
+            comps[1].h_samp_factor, comps[1].v_samp_factor);
+    }
+
+    cinfo.raw_data_out = TRUE;
+    cinfo.do_fancy_upsampling = FALSE;
+    cinfo.dct_method = JDCT_IFAST;
+    jpeg_start_decompress (&cinfo);
+
+    // raw data comes in bands of whole MCU rows, padded to MCU width
+    uint32_t band_rows = cinfo.max_v_samp_factor * DCTSIZE;
+    uint32_t widths[3] = {0, 0, 0};
+    uint32_t rows[3] = {0, 0, 0};
+    uint32_t total = 0;
+    for (int c = 0; c < cinfo.num_components; ++c) {
+        widths[c] = comps[c].width_in_blocks * DCTSIZE;
+        rows[c] = comps[c].v_samp_factor * DCTSIZE;
+        total += widths[c] * rows[c];
+    }
+    scratch.resize (total);
+
+    JSAMPROW plane_rows[3][2 * DCTSIZE];
+    JSAMPARRAY planes[3] = {plane_rows[0], plane_rows[1], plane_rows[2]};
+    JSAMPLE *pos = scratch.data ();
+    for (int c = 0; c < cinfo.num_components; ++c) {
+        for (uint32_t r = 0; r < rows[c]; ++r, pos += widths[c])
+            plane_rows[c][r] = pos;
+    }
+
+    uint8_t *out_y = out_mem + info.offsets[0];
+    uint8_t *out_uv = out_mem + info.offsets[1];
+    uint32_t uv_width = info.width / 2;
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint32_t y0 = cinfo.output_scanline;
+        if (jpeg_read_raw_data (&cinfo, planes, band_rows) != band_rows) {
+            XCAM_LOG_WARNING ("mjpeg read raw data failed at line:%d", y0);
+            return false;
+        }
+
+        uint32_t y_rows = XCAM_MIN (band_rows, info.height - y0);
+        for (uint32_t r = 0; r < y_rows; ++r)
+            memcpy (out_y + (y0 + r) * info.strides[0], plane_rows[0][r], info.width);
+
+        for (uint32_t j = 0; j < y_rows / 2; ++j) {
+            uint8_t *uv = out_uv + (y0 / 2 + j) * info.strides[1];
+            if (cinfo.num_components == 1) {
+                memset (uv, 128, uv_width * 2);
+            } else if (rx == 2 && ry == 2) {
+                const JSAMPLE *cb = plane_rows[1][j], *cr = plane_rows[2][j];
+                for (uint32_t i = 0; i < uv_width; ++i) {
+                    uv[2 * i] = cb[i];
+                    uv[2 * i + 1] = cr[i];
+                }
+            } else {
+                for (uint32_t i = 0; i < uv_width; ++i) {
+                    uv[2 * i] = chroma_at (planes[1], i, j, rx, ry);
+                    uv[2 * i + 1] = chroma_at (planes[2], i, j, rx, ry);
+                }
+            }
+        }
+    }
+
+    jpeg_finish_decompress (&cinfo);
+    return true;
+}
+
+XCamReturn
+MjpegDecoder::decode (const uint8_t *data, uint32_t size, const SmartPtr<VideoBuffer> &out)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, data && size && out.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "mjpeg decode failed on invalid parameters");
+
+    const VideoBufferInfo &info = out->get_video_info ();
+    XCAM_FAIL_RETURN (
+        ERROR, info.format == V4L2_PIX_FMT_NV12 && !(info.width % 2) && !(info.height % 2),
+        XCAM_RETURN_ERROR_PARAM,
+        "mjpeg decode output need be NV12 of even size, but got %s(%dx%d)",
+        xcam_fourcc_to_string (info.format), info.width, info.height);
+
+    uint8_t *out_mem = out->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, out_mem, XCAM_RETURN_ERROR_MEM,
+        "mjpeg decode map output buffer failed");
+
+    struct jpeg_decompress_struct cinfo;
+    MjpegErrorMgr jerr;
+    std::vector<JSAMPLE> scratch;
+    // read after longjmp
+    volatile bool ok = false;
+
+    cinfo.err = jpeg_std_error (&jerr.pub);
+    jerr.pub.error_exit = mjpeg_error_exit;
+    jerr.pub.output_message = mjpeg_output_message;
+    jpeg_create_decompress (&cinfo);
+
+    if (!setjmp (jerr.jump)) {
+        jpeg_mem_src (&cinfo, (unsigned char *)data, size);
+        ok = decode_raw (cinfo, info, out_mem, scratch);
+    }
+
+    jpeg_destroy_decompress (&cinfo);
+    out->unmap ();
+    return ok ? XCAM_RETURN_NO_ERROR : XCAM_RETURN_ERROR_UNKNOWN;
+}
+
+MjpegDecoder::MjpegDecoder (const char *name)
+    : _name (NULL)
+    , _threads (XCAM_MJPEG_DEFAULT_THREADS)
+    , _callback (NULL)
+    , _next_seq (0)
+    , _post_seq (0)
+    , _dropped (0)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+MjpegDecoder::~MjpegDecoder ()
+{
+    stop ();
+    xcam_free (_name);
+}
+
+bool
+MjpegDecoder::set_threads (uint32_t count)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread_pool.ptr () && count, false,
+        "mjpeg decoder(%s) set threads(%d) failed, already started or zero", XCAM_STR (_name), count);
+
+    _threads = count;
+    return true;
+}
+
+bool
+MjpegDecoder::set_buffer_pool (const SmartPtr<BufferPool> &pool)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread_pool.ptr (), false,
+        "mjpeg decoder(%s) set buffer pool failed, already started", XCAM_STR (_name));
+
+    _buf_pool = pool;
+    return true;
+}
+
+bool
+MjpegDecoder::set_callback (PollCallback *callback)
+{
+    _callback = callback;
+    return true;
+}
+
+XCamReturn
+MjpegDecoder::start (uint32_t width, uint32_t height)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_thread_pool.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "mjpeg decoder(%s) already started", XCAM_STR (_name));
+
+    if (!_buf_pool.ptr ()) {
+        VideoBufferInfo info;
+        info.init (V4L2_PIX_FMT_NV12, width, height);
+
+        SmartPtr<BufferPool> pool = new MjpegBufferPool;
+        XCAM_FAIL_RETURN (
+            ERROR, pool->set_video_info (info) && xcam_ret_is_ok (pool->reserve (XCAM_MJPEG_DEFAULT_BUFS)),
+            XCAM_RETURN_ERROR_MEM,
+            "mjpeg decoder(%s) reserve buffers(%dx%d) failed", XCAM_STR (_name), width, height);
+        _buf_pool = pool;
+    }
+
+    _next_seq = 0;
+    _post_seq = 0;
+    _dropped = 0;
+    _decoded.clear ();
+
+    SmartPtr<ThreadPool> thread_pool = new ThreadPool (_name);
+    thread_pool->set_threads (_threads, _threads);
+    XCamReturn ret = thread_pool->start ();
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "mjpeg decoder(%s) start threads failed", XCAM_STR (_name));
+    _thread_pool = thread_pool;
+
+    XCAM_LOG_INFO ("mjpeg decoder(%s) started with %d threads", XCAM_STR (_name), _threads);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MjpegDecoder::stop ()
+{
+    if (_thread_pool.ptr ()) {
+        _thread_pool->stop ();
+        _thread_pool.release ();
+    }
+
+    SmartLock locker (_mutex);
+    _decoded.clear ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MjpegDecoder::push_buffer (const SmartPtr<VideoBuffer> &jpeg, uint32_t size)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _thread_pool.ptr () && jpeg.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "mjpeg decoder(%s) push buffer failed, not started or buffer NULL", XCAM_STR (_name));
+
+    SmartPtr<VideoBuffer> out = _buf_pool->try_get_buffer ();
+    if (!out.ptr ()) {
+        if (_dropped++ % XCAM_MJPEG_DROP_LOG_INTERVAL == 0) {
+            XCAM_LOG_WARNING (
+                "mjpeg decoder(%s) has no free buffer, %d frames dropped", XCAM_STR (_name), _dropped);
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    FrameLatencyMeta::carry (jpeg, out);
+
+    uint32_t seq = 0;
+    {
+        SmartLock locker (_mutex);
+        seq = _next_seq++;
+    }
+
+    SmartPtr<MjpegDecodeWork> work = new MjpegDecodeWork (this, seq, jpeg, size, out);
+    XCamReturn ret = _thread_pool->queue (work);
+    if (!xcam_ret_is_ok (ret)) {
+        XCAM_LOG_WARNING ("mjpeg decoder(%s) queue work failed", XCAM_STR (_name));
+        decode_done (seq, jpeg->get_timestamp (), NULL);
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+MjpegDecoder::decode_done (uint32_t seq, int64_t timestamp, const SmartPtr<VideoBuffer> &out)
+{
+    SmartLock locker (_mutex);
+
+    if (!out.ptr () && _callback)
+        _callback->poll_buffer_failed (timestamp, "mjpeg decode failed");
+
+    _decoded[seq] = out;
+    for (DecodedMap::iterator i = _decoded.find (_post_seq); i != _decoded.end (); i = _decoded.find (_post_seq)) {
+        SmartPtr<VideoBuffer> buf = i->second;
+        _decoded.erase (i);
+        ++_post_seq;
+        if (buf.ptr () && _callback)
+            _callback->poll_buffer_ready (buf);
+    }
+}
+
+};
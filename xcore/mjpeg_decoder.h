@@ -0,0 +1,95 @@
+/*
+ * mjpeg_decoder.h - mjpeg decoder
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_MJPEG_DECODER_H
+#define XCAM_MJPEG_DECODER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <buffer_pool.h>
+#include <thread_pool.h>
+#include <map>
+
+#define XCAM_MJPEG_DEFAULT_THREADS 2
+#define XCAM_MJPEG_DEFAULT_BUFS 6
+
+namespace XCam {
+
+class PollCallback;
+class MjpegDecodeWork;
+
+/*
+ * MjpegDecoder, decodes V4L2_PIX_FMT_MJPEG frames into NV12 buffers with libjpeg(-turbo)
+ * raw data output, which skips upsampling and color conversion.
+ * frames decode in parallel on a small thread pool and reach callback in capture order,
+ * a frame arriving while all output buffers are in flight is dropped.
+ * 4:2:0, 4:2:2, 4:4:0, 4:4:4 and grayscale jpeg are supported.
+ */
+class MjpegDecoder
+{
+    friend class MjpegDecodeWork;
+    typedef std::map<uint32_t, SmartPtr<VideoBuffer> > DecodedMap;
+
+public:
+    explicit MjpegDecoder (const char *name = "MjpegDecoder");
+    ~MjpegDecoder ();
+
+    const char *get_name () const {
+        return _name;
+    }
+
+    // all setters need be called before start
+    bool set_threads (uint32_t count);
+    // NV12 output pool of frame size, default is heap buffers
+    bool set_buffer_pool (const SmartPtr<BufferPool> &pool);
+    bool set_callback (PollCallback *callback);
+
+    XCamReturn start (uint32_t width, uint32_t height);
+    XCamReturn stop ();
+
+    // @size, bytes of jpeg data in @jpeg, which is held until decoded
+    XCamReturn push_buffer (const SmartPtr<VideoBuffer> &jpeg, uint32_t size);
+
+    // decode on caller thread, @out is NV12 of jpeg size
+    static XCamReturn decode (const uint8_t *data, uint32_t size, const SmartPtr<VideoBuffer> &out);
+
+private:
+    // post decoded frames in capture order, NULL @out marks a failed frame
+    void decode_done (uint32_t seq, int64_t timestamp, const SmartPtr<VideoBuffer> &out);
+
+    XCAM_DEAD_COPY (MjpegDecoder);
+
+private:
+    char                    *_name;
+    uint32_t                 _threads;
+    SmartPtr<ThreadPool>     _thread_pool;
+    SmartPtr<BufferPool>     _buf_pool;
+    PollCallback            *_callback;
+
+    Mutex                    _mutex;
+    uint32_t                 _next_seq;
+    uint32_t                 _post_seq;
+    DecodedMap               _decoded;
+    uint32_t                 _dropped;
+};
+
+};
+
+#endif //XCAM_MJPEG_DECODER_H
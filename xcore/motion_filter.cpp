@@ -0,0 +1,116 @@
+/*
+ * motion_filter.cpp - gaussian smoothing of camera motions
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Zong Wei <wei.zong@intel.com>
+ */
+
+#include "motion_filter.h"
+#include <math.h>
+
+namespace XCam {
+
+MotionFilter::MotionFilter (uint32_t radius, float stdev)
+    : _radius (radius),
+      _stdev (stdev)
+{
+    set_filters (radius, stdev);
+}
+
+MotionFilter::~MotionFilter ()
+{
+    _weight.clear ();
+}
+
+void
+MotionFilter::set_filters (uint32_t radius, float stdev)
+{
+    _radius = radius;
+    _stdev = stdev > 0.f ? stdev : std::sqrt (static_cast<float>(radius));
+
+    int scale = 2 * _radius + 1;
+    float dis = 0.0f;
+    float sum = 0.0f;
+
+    _weight.resize (2 * _radius + 1);
+
+    for (int i = 0; i < scale; i++) {
+        dis = ((float)i - radius) * ((float)i - radius);
+        _weight[i] = exp(-dis / (_stdev * _stdev));
+        sum += _weight[i];
+    }
+
+    for (int i = 0; i < scale; i++) {
+        _weight[i] /= sum;
+    }
+
+}
+
+Mat3d
+MotionFilter::cumulate_motion (uint32_t index, uint32_t from, std::list<Mat3d> &motions)
+{
+    Mat3d motion;
+    motion.eye ();
+
+    uint32_t id = 0;
+    std::list<Mat3d>::iterator it;
+
+    if (from < index) {
+        for (id = 0, it = motions.begin (); it != motions.end (); id++, ++it) {
+            if (from <= id && id < index) {
+                motion = (*it) * motion;
+            }
+        }
+        motion = motion.inverse ();
+    } else if (from > index) {
+        for (id = 0, it = motions.begin (); it != motions.end (); id++, ++it) {
+            if (index <= id && id < from) {
+                motion = (*it) * motion;
+            }
+        }
+    }
+
+    return motion;
+}
+
+Mat3d
+MotionFilter::stabilize (int32_t index,
+                         std::list<Mat3d> &motions,
+                         int32_t max)
+{
+    Mat3d res;
+    res.zeros ();
+
+    double sum = 0.0f;
+    int32_t idx_min = XCAM_MAX ((index - _radius), 0);
+    int32_t idx_max = XCAM_MIN ((index + _radius), max);
+
+    for (int32_t i = idx_min; i <= idx_max; ++i)
+    {
+        // weights are centered at index
+        float weight = _weight[i - index + _radius];
+        res = res + cumulate_motion (index, i, motions) * weight;
+        sum += weight;
+    }
+    if (sum > 0.0f) {
+        return res * (1 / sum);
+    }
+    else {
+        return Mat3d ();
+    }
+}
+
+}
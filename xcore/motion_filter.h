@@ -0,0 +1,64 @@
+/*
+ * motion_filter.h - gaussian smoothing of camera motions
+ *
+ *  Copyright (c) 2017 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Zong Wei <wei.zong@intel.com>
+ */
+
+#ifndef XCAM_MOTION_FILTER_H
+#define XCAM_MOTION_FILTER_H
+
+#include <xcam_std.h>
+#include <vec_mat.h>
+#include <list>
+#include <vector>
+
+namespace XCam {
+
+class MotionFilter
+{
+public:
+    MotionFilter (uint32_t radius = 15, float stdev = 10);
+    virtual ~MotionFilter ();
+
+    void set_filters (uint32_t radius, float stdev);
+
+    uint32_t radius () const {
+        return _radius;
+    };
+    float stdev () const {
+        return _stdev;
+    };
+
+    Mat3d stabilize (int32_t index,
+                     std::list<Mat3d> &motions,
+                     int32_t max);
+
+protected:
+    Mat3d cumulate_motion (uint32_t index, uint32_t from, std::list<Mat3d> &motions);
+
+private:
+    XCAM_DEAD_COPY (MotionFilter);
+
+private:
+    int32_t            _radius;
+    float              _stdev;
+    std::vector<float> _weight;
+};
+
+}
+
+#endif //XCAM_MOTION_FILTER_H
@@ -0,0 +1,308 @@
+/*
+ * multi_capture_manager.cpp - synchronized capture of multiple v4l2 devices
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "multi_capture_manager.h"
+#include "v4l2_buffer_proxy.h"
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#define XCAM_MULTI_CAPTURE_POLL_TIMEOUT 100 // ms
+#define XCAM_MULTI_CAPTURE_MAX_EVENTS 16
+
+namespace XCam {
+
+class MultiCapturePollThread
+    : public Thread
+{
+public:
+    explicit MultiCapturePollThread (MultiCaptureManager *manager)
+        : Thread ("multi_capture_poll")
+        , _manager (manager)
+    {}
+
+protected:
+    virtual bool loop () {
+        XCamReturn ret = _manager->poll_devices ();
+        return (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_ERROR_TIMEOUT);
+    }
+
+private:
+    MultiCaptureManager   *_manager;
+};
+
+MultiCaptureManager::MultiCaptureManager ()
+    : _callback (NULL)
+    , _tolerance (XCAM_MULTI_CAPTURE_DEFAULT_TOLERANCE)
+    , _drop_policy (DropOldest)
+    , _max_pending (XCAM_MULTI_CAPTURE_DEFAULT_PENDING)
+    , _epoll_fd (-1)
+    , _started (false)
+    , _dropped (0)
+{
+}
+
+MultiCaptureManager::~MultiCaptureManager ()
+{
+    stop ();
+}
+
+bool
+MultiCaptureManager::add_device (const SmartPtr<V4l2Device> &dev)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && dev.ptr () && dev->is_opened (), false,
+        "multi capture add device failed, %s", (_started ? "already started" : "device not opened"));
+
+    _devices.push_back (dev);
+    return true;
+}
+
+bool
+MultiCaptureManager::set_callback (MultiCaptureCallback *callback)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, false,
+        "multi capture can't set callback after started");
+
+    _callback = callback;
+    return true;
+}
+
+bool
+MultiCaptureManager::set_sync_tolerance (int64_t tolerance)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, tolerance >= 0, false,
+        "multi capture sync tolerance(%" PRId64 ") invalid", tolerance);
+
+    _tolerance = tolerance;
+    return true;
+}
+
+bool
+MultiCaptureManager::set_drop_policy (DropPolicy policy, uint32_t max_pending)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && max_pending > 0, false,
+        "multi capture set drop policy failed, %s", (_started ? "already started" : "max pending is 0"));
+
+    _drop_policy = policy;
+    _max_pending = max_pending;
+    return true;
+}
+
+XCamReturn
+MultiCaptureManager::start ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && !_devices.empty () && _callback, XCAM_RETURN_ERROR_ORDER,
+        "multi capture start failed, %s",
+        (_started ? "already started" : (_callback ? "no device" : "callback not set")));
+
+    _epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    XCAM_FAIL_RETURN (
+        ERROR, _epoll_fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "multi capture create epoll failed");
+
+    _pending.assign (_devices.size (), PendingList ());
+    _dropped = 0;
+
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    uint32_t i = 0;
+    for (; i < _devices.size (); ++i) {
+        ret = _devices[i]->start ();
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_ERROR ("multi capture start device(%s) failed", XCAM_STR (_devices[i]->get_device_name ()));
+            break;
+        }
+
+        struct epoll_event event;
+        xcam_mem_clear (event);
+        event.events = EPOLLIN | EPOLLPRI;
+        event.data.u32 = i;
+        if (epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, _devices[i]->get_fd (), &event) < 0) {
+            XCAM_LOG_ERROR ("multi capture add device(%s) to epoll failed", XCAM_STR (_devices[i]->get_device_name ()));
+            _devices[i]->stop ();
+            ret = XCAM_RETURN_ERROR_FILE;
+            break;
+        }
+    }
+
+    if (xcam_ret_is_ok (ret)) {
+        _thread = new MultiCapturePollThread (this);
+        _thread->set_policy (_thread_policy);
+        if (!_thread->start ()) {
+            XCAM_LOG_ERROR ("multi capture start poll thread failed");
+            _thread.release ();
+            ret = XCAM_RETURN_ERROR_THREAD;
+        }
+    }
+
+    if (!xcam_ret_is_ok (ret)) {
+        while (i > 0)
+            _devices[--i]->stop ();
+        close (_epoll_fd);
+        _epoll_fd = -1;
+        return ret;
+    }
+
+    _started = true;
+    XCAM_LOG_INFO ("multi capture started with %d devices", (uint32_t)_devices.size ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiCaptureManager::stop ()
+{
+    if (!_started)
+        return XCAM_RETURN_NO_ERROR;
+
+    _thread->stop ();
+    _thread.release ();
+
+    // buffers go back to devices before those stop
+    _pending.clear ();
+    for (uint32_t i = 0; i < _devices.size (); ++i)
+        _devices[i]->stop ();
+
+    close (_epoll_fd);
+    _epoll_fd = -1;
+    _started = false;
+
+    XCAM_LOG_INFO ("multi capture stopped, %" PRIu64 " frames dropped", _dropped.load ());
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiCaptureManager::poll_devices ()
+{
+    struct epoll_event events[XCAM_MULTI_CAPTURE_MAX_EVENTS];
+
+    int count = epoll_wait (_epoll_fd, events, XCAM_MULTI_CAPTURE_MAX_EVENTS, XCAM_MULTI_CAPTURE_POLL_TIMEOUT);
+    if (count < 0) {
+        if (errno == EINTR)
+            return XCAM_RETURN_ERROR_TIMEOUT;
+        XCAM_LOG_DEBUG ("multi capture epoll got error but continue");
+        ::usleep (100000); // 100ms
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    if (count == 0) {
+        XCAM_LOG_DEBUG ("multi capture poll timeout and continue");
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    bool captured = false;
+    for (int i = 0; i < count; ++i) {
+        uint32_t index = events[i].data.u32;
+        XCAM_ASSERT (index < _devices.size ());
+
+        if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            XCAM_LOG_DEBUG ("multi capture device(%s) polled error", XCAM_STR (_devices[index]->get_device_name ()));
+            _callback->capture_failed (index, "device polled error");
+            continue;
+        }
+        if (xcam_ret_is_ok (capture_device (index)))
+            captured = true;
+    }
+
+    if (!captured) {
+        // avoid spinning on devices keep reporting errors
+        ::usleep (10000); // 10ms
+        return XCAM_RETURN_ERROR_TIMEOUT;
+    }
+
+    match_sets ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+MultiCaptureManager::capture_device (uint32_t index)
+{
+    SmartPtr<V4l2Buffer> buf;
+    SmartPtr<V4l2Device> &dev = _devices[index];
+
+    XCamReturn ret = dev->dequeue_buffer (buf);
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("multi capture device(%s) capture buffer failed", XCAM_STR (dev->get_device_name ()));
+        _callback->capture_failed (index, "capture buffer failed");
+        return ret;
+    }
+    XCAM_ASSERT (buf.ptr ());
+
+    SmartPtr<VideoBuffer> video_buf = new V4l2BufferProxy (buf, dev);
+    PendingList &pending = _pending[index];
+
+    if (pending.size () >= _max_pending) {
+        ++_dropped;
+        XCAM_LOG_DEBUG (
+            "multi capture device(%s) runs ahead, drop %s frame",
+            XCAM_STR (dev->get_device_name ()), (_drop_policy == DropOldest ? "oldest" : "newest"));
+        if (_drop_policy == DropNewest)
+            return XCAM_RETURN_NO_ERROR;
+        pending.pop_front ();
+    }
+
+    pending.push_back (video_buf);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+MultiCaptureManager::match_sets ()
+{
+    uint32_t count = _pending.size ();
+
+    while (true) {
+        int64_t latest = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (_pending[i].empty ())
+                return;
+            int64_t ts = _pending[i].front ()->get_timestamp ();
+            if (i == 0 || ts > latest)
+                latest = ts;
+        }
+
+        // older heads can't match any frame captured afterwards
+        bool dropped = false;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (latest - _pending[i].front ()->get_timestamp () > _tolerance) {
+                _pending[i].pop_front ();
+                ++_dropped;
+                dropped = true;
+            }
+        }
+        if (dropped)
+            continue;
+
+        VideoBufferList bufs;
+        for (uint32_t i = 0; i < count; ++i) {
+            bufs.push_back (_pending[i].front ());
+            _pending[i].pop_front ();
+        }
+
+        XCamReturn ret = _callback->capture_set_ready (bufs);
+        if (!xcam_ret_is_ok (ret)) {
+            XCAM_LOG_WARNING ("multi capture callback failed on frame set(ts:" XCAM_TIMESTAMP_FORMAT ")",
+                              XCAM_TIMESTAMP_ARGS (latest));
+        }
+    }
+}
+
+}
@@ -0,0 +1,117 @@
+/*
+ * multi_capture_manager.h - synchronized capture of multiple v4l2 devices
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_MULTI_CAPTURE_MANAGER_H
+#define XCAM_MULTI_CAPTURE_MANAGER_H
+
+#include <xcam_std.h>
+#include <xcam_thread.h>
+#include <v4l2_device.h>
+#include <video_buffer.h>
+#include <list>
+#include <vector>
+
+#define XCAM_MULTI_CAPTURE_DEFAULT_TOLERANCE 5000 // us
+#define XCAM_MULTI_CAPTURE_DEFAULT_PENDING 2
+
+namespace XCam {
+
+class MultiCaptureCallback
+{
+public:
+    MultiCaptureCallback () {}
+    virtual ~MultiCaptureCallback () {}
+    // one buffer of each device in the order devices added, ready for Stitcher::stitch_buffers
+    virtual XCamReturn capture_set_ready (VideoBufferList &bufs) = 0;
+    virtual void capture_failed (uint32_t index, const char *msg) {
+        XCAM_UNUSED (index);
+        XCAM_UNUSED (msg);
+    }
+
+private:
+    XCAM_DEAD_COPY (MultiCaptureCallback);
+};
+
+/*
+ * polls all capture devices with one epoll thread and pairs their frames by timestamp.
+ * frames which can't be matched any more are dropped and their buffers go back to drivers.
+ */
+class MultiCaptureManager
+{
+    friend class MultiCapturePollThread;
+    typedef std::list<SmartPtr<VideoBuffer> > PendingList;
+
+public:
+    enum DropPolicy {
+        DropOldest = 0,   // device running ahead drops its oldest pending frame
+        DropNewest,       // device running ahead drops the frame just captured
+    };
+
+public:
+    explicit MultiCaptureManager ();
+    ~MultiCaptureManager ();
+
+    // devices opened and formatted, set before start
+    bool add_device (const SmartPtr<V4l2Device> &dev);
+    uint32_t get_device_count () const {
+        return _devices.size ();
+    }
+    bool set_callback (MultiCaptureCallback *callback);
+    // frames of a set differ in timestamp by tolerance at most, in microseconds
+    bool set_sync_tolerance (int64_t tolerance);
+    // pending frames of each device, must be less than buffer count of devices
+    bool set_drop_policy (DropPolicy policy, uint32_t max_pending = XCAM_MULTI_CAPTURE_DEFAULT_PENDING);
+    // set before start
+    void set_thread_policy (const ThreadPolicy &policy) {
+        _thread_policy = policy;
+    }
+
+    // starts all devices
+    XCamReturn start ();
+    XCamReturn stop ();
+
+    uint64_t get_dropped_count () const {
+        return _dropped;
+    }
+
+private:
+    XCamReturn poll_devices ();
+    XCamReturn capture_device (uint32_t index);
+    void match_sets ();
+
+    XCAM_DEAD_COPY (MultiCaptureManager);
+
+private:
+    std::vector<SmartPtr<V4l2Device> >  _devices;
+    std::vector<PendingList>            _pending;
+    MultiCaptureCallback               *_callback;
+    int64_t                             _tolerance;
+    DropPolicy                          _drop_policy;
+    uint32_t                            _max_pending;
+    ThreadPolicy                        _thread_policy;
+    SmartPtr<Thread>                    _thread;
+    int                                 _epoll_fd;
+    bool                                _started;
+    std::atomic<uint64_t>               _dropped;
+};
+
+}
+
+#endif // XCAM_MULTI_CAPTURE_MANAGER_H
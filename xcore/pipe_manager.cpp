@@ -32,6 +32,8 @@ namespace XCam {
 
 PipeManager::PipeManager ()
     : _is_running (false)
+    , _required_mask (0)
+    , _analyzer_fanout (false)
 {
     _processor_center = new X3aImageProcessCenter;
     XCAM_LOG_DEBUG ("PipeManager construction");
@@ -64,6 +66,43 @@ PipeManager::add_image_processor (SmartPtr<ImageProcessor> processor)
     return _processor_center->insert_processor (processor);
 }
 
+bool
+PipeManager::add_fanout_processor (SmartPtr<ImageProcessor> processor, bool required)
+{
+    if (is_running ())
+        return false;
+
+    XCAM_ASSERT (processor.ptr ());
+    XCAM_FAIL_RETURN (
+        ERROR, _fanout_processors.size () < XCAM_PIPE_MAX_FANOUT_PROCESSORS, false,
+        "pipe manager fan-out processors exceed max count(%d)", XCAM_PIPE_MAX_FANOUT_PROCESSORS);
+
+    if (required)
+        _required_mask |= (1u << (_fanout_processors.size () + 1));
+    _fanout_processors.push_back (processor);
+    return true;
+}
+
+bool
+PipeManager::set_analyzer_fanout (bool enable)
+{
+    if (is_running ())
+        return false;
+
+    _analyzer_fanout = enable;
+    return true;
+}
+
+int32_t
+PipeManager::find_fanout_processor (ImageProcessor *processor) const
+{
+    for (uint32_t i = 0; i < _fanout_processors.size (); ++i) {
+        if (_fanout_processors[i].ptr () == processor)
+            return i;
+    }
+    return -1;
+}
+
 XCamReturn
 PipeManager::start ()
 {
@@ -89,6 +128,13 @@ PipeManager::start ()
     _processor_center->set_image_callback (this);
     XCAM_FAILED_STOP (ret = _processor_center->start (), "3A process center start failed");
 
+    for (uint32_t i = 0; i < _fanout_processors.size (); ++i) {
+        _fanout_processors[i]->set_callback (this);
+        XCAM_FAILED_STOP (
+            ret = _fanout_processors[i]->start (), "fan-out processor(%s) start failed",
+            XCAM_STR (_fanout_processors[i]->get_name ()));
+    }
+
     _is_running = true;
 
     XCAM_LOG_DEBUG ("pipe manager started");
@@ -108,6 +154,14 @@ PipeManager::stop ()
     if (_processor_center.ptr ())
         _processor_center->stop ();
 
+    for (uint32_t i = 0; i < _fanout_processors.size (); ++i)
+        _fanout_processors[i]->stop ();
+
+    {
+        SmartLock locker (_frames_mutex);
+        _frames.clear ();
+    }
+
     XCAM_LOG_DEBUG ("pipe manager stopped");
     return XCAM_RETURN_NO_ERROR;
 }
@@ -117,14 +171,88 @@ PipeManager::push_buffer (SmartPtr<VideoBuffer> &buf)
 {
     // need to add sync mode later
 
+    if (_analyzer_fanout && _smart_analyzer.ptr ()) {
+        if (_smart_analyzer->push_buffer (buf) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_DEBUG ("smart analyzer skipped frame(" XCAM_TIMESTAMP_FORMAT ")",
+                            XCAM_TIMESTAMP_ARGS (buf->get_timestamp ()));
+        }
+    }
+
+    if (!has_fanout ()) {
+        if (_processor_center->put_buffer (buf) == false) {
+            XCAM_LOG_WARNING ("push buffer failed");
+            return XCAM_RETURN_ERROR_UNKNOWN;
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    int64_t ts = buf->get_timestamp ();
+    SmartPtr<FanOutFrame> frame = new FanOutFrame;
+    frame->timestamp = ts;
+    frame->pending = 1u | _required_mask;
+    {
+        SmartLock locker (_frames_mutex);
+        _frames.push_back (frame);
+    }
+
+    for (uint32_t i = 0; i < _fanout_processors.size (); ++i) {
+        uint32_t bit = 1u << (i + 1);
+        if (_fanout_processors[i]->push_buffer (buf) != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING (
+                "fan-out processor(%s) push buffer failed", XCAM_STR (_fanout_processors[i]->get_name ()));
+            if (_required_mask & bit)
+                consumer_done (bit, ts, NULL);
+        }
+    }
+
     if (_processor_center->put_buffer (buf) == false) {
         XCAM_LOG_WARNING ("push buffer failed");
+        consumer_done (1u, ts, NULL);
         return XCAM_RETURN_ERROR_UNKNOWN;
     }
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+PipeManager::consumer_done (uint32_t bit, int64_t ts, const SmartPtr<VideoBuffer> &output)
+{
+    SmartLock locker (_frames_mutex);
+
+    FanOutFrameList::iterator i_frame = _frames.begin ();
+    for (; i_frame != _frames.end (); ++i_frame) {
+        SmartPtr<FanOutFrame> &frame = *i_frame;
+        if (frame->timestamp == ts && (frame->pending & bit))
+            break;
+    }
+    if (i_frame == _frames.end ()) {
+        XCAM_LOG_DEBUG (
+            "pipe manager got late buffer(" XCAM_TIMESTAMP_FORMAT ") of consumer(0x%x)",
+            XCAM_TIMESTAMP_ARGS (ts), bit);
+        return;
+    }
+    (*i_frame)->pending &= ~bit;
+    if (bit == 1u)
+        (*i_frame)->output = output;
+
+    // post in push order, a required fan-out processor lagging too far is not waited for
+    while (!_frames.empty ()) {
+        SmartPtr<FanOutFrame> &head = _frames.front ();
+        if (head->pending && _frames.size () > XCAM_PIPE_MAX_PENDING_FRAMES && !(head->pending & 1u)) {
+            XCAM_LOG_WARNING (
+                "pipe manager posts frame(" XCAM_TIMESTAMP_FORMAT ") without fan-out consumers(0x%x)",
+                XCAM_TIMESTAMP_ARGS (head->timestamp), head->pending);
+            head->pending = 0;
+        }
+        if (head->pending)
+            break;
+
+        if (head->output.ptr ())
+            post_buffer (head->output);
+        _frames.pop_front ();
+    }
+}
+
 XCamReturn
 PipeManager::scaled_image_ready (const SmartPtr<VideoBuffer> &buffer)
 {
@@ -162,13 +290,34 @@ void
 PipeManager::process_buffer_done (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
     ImageProcessCallback::process_buffer_done (processor, buf);
-    post_buffer (buf);
+
+    int32_t index = find_fanout_processor (processor);
+    if (index >= 0) {
+        uint32_t bit = 1u << (index + 1);
+        if (_required_mask & bit)
+            consumer_done (bit, buf->get_timestamp (), NULL);
+        return;
+    }
+
+    if (!has_fanout ()) {
+        post_buffer (buf);
+        return;
+    }
+    consumer_done (1u, buf->get_timestamp (), buf);
 }
 
 void
 PipeManager::process_buffer_failed (ImageProcessor *processor, const SmartPtr<VideoBuffer> &buf)
 {
     ImageProcessCallback::process_buffer_failed (processor, buf);
+    if (!has_fanout ())
+        return;
+
+    // failed chain drops the frame, failed fan-out processor no longer holds it back
+    int32_t index = find_fanout_processor (processor);
+    uint32_t bit = (index >= 0) ? (1u << (index + 1)) : 1u;
+    if (bit == 1u || (_required_mask & bit))
+        consumer_done (bit, buf->get_timestamp (), NULL);
 }
 
 void
@@ -26,6 +26,12 @@
 #include <smart_analyzer.h>
 #include <x3a_image_process_center.h>
 #include <stats_callback_interface.h>
+#include <xcam_mutex.h>
+#include <list>
+#include <vector>
+
+#define XCAM_PIPE_MAX_FANOUT_PROCESSORS 16
+#define XCAM_PIPE_MAX_PENDING_FRAMES 16
 
 namespace XCam {
 
@@ -40,6 +46,16 @@ public:
 
     bool set_smart_analyzer (SmartPtr<SmartAnalyzer> analyzer);
     bool add_image_processor (SmartPtr<ImageProcessor> processor);
+    /*
+     * fan-out processors get each pushed frame by reference, in parallel with the
+     * processor chain and with each other, so they must not write it.
+     * a frame is posted once the chain and all required fan-out processors are done,
+     * a required processor need notify one buffer (e.g. the input) per frame;
+     * optional ones may lag behind or produce nothing.
+     */
+    bool add_fanout_processor (SmartPtr<ImageProcessor> processor, bool required);
+    // push whole frames to smart analyzer in push_buffer, it never holds a frame back
+    bool set_analyzer_fanout (bool enable);
 
     bool is_running () const {
         return _is_running;
@@ -66,12 +82,36 @@ protected:
     virtual void process_image_result_done (ImageProcessor *processor, const SmartPtr<X3aResult> &result);
 
 private:
+    struct FanOutFrame {
+        int64_t                  timestamp;
+        // bit 0 is processor chain, bit i + 1 is fan-out processor i
+        uint32_t                 pending;
+        SmartPtr<VideoBuffer>    output;
+
+        FanOutFrame () : timestamp (0), pending (0) {}
+    };
+    typedef std::list<SmartPtr<FanOutFrame> > FanOutFrameList;
+
+    bool has_fanout () const {
+        return !_fanout_processors.empty ();
+    }
+    int32_t find_fanout_processor (ImageProcessor *processor) const;
+    // clear @bit of first pending frame of @ts, post finished frames in order
+    void consumer_done (uint32_t bit, int64_t ts, const SmartPtr<VideoBuffer> &output);
+
     XCAM_DEAD_COPY (PipeManager);
 
 protected:
     bool                             _is_running;
     SmartPtr<SmartAnalyzer>          _smart_analyzer;
     SmartPtr<X3aImageProcessCenter>  _processor_center;
+
+private:
+    std::vector<SmartPtr<ImageProcessor> >  _fanout_processors;
+    uint32_t                                _required_mask;
+    bool                                    _analyzer_fanout;
+    Mutex                                   _frames_mutex;
+    FanOutFrameList                         _frames;
 };
 
 };
@@ -21,6 +21,10 @@
 #include "poll_thread.h"
 #include "xcam_thread.h"
 #include <unistd.h>
+#include <sys/epoll.h>
+
+// fd keeps reporting errors while no buffers queued, let other fds go on
+#define XCAM_POLL_IO_ERROR_BACKOFF 10000 // us
 
 namespace XCam {
 
@@ -76,12 +80,43 @@ private:
     PollThread   *_poll;
 };
 
+class PollIoHandler
+    : public IoReactor::Handler
+{
+public:
+    PollIoHandler (PollThread *poll, bool capture)
+        : _poll (poll)
+        , _capture (capture)
+    {}
+
+    virtual bool io_ready (int fd, uint32_t events) {
+        XCAM_UNUSED (fd);
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            XCAM_LOG_DEBUG ("poll %s fd got error but continue", (_capture ? "buffer" : "event"));
+            ::usleep (XCAM_POLL_IO_ERROR_BACKOFF);
+            return true;
+        }
+
+        XCamReturn ret = _capture ? _poll->capture_buffer () : _poll->dequeue_subdev_event ();
+        if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_ERROR_TIMEOUT && ret != XCAM_RETURN_ERROR_IOCTL) {
+            XCAM_LOG_WARNING ("poll %s stopped on error:%d", (_capture ? "buffer" : "event"), ret);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    PollThread   *_poll;
+    bool          _capture;
+};
+
 const int PollThread::default_subdev_event_timeout = 100; // ms
 const int PollThread::default_capture_event_timeout = 100; // ms
 
 PollThread::PollThread ()
     : _poll_callback (NULL)
     , _stats_callback (NULL)
+    , _latency_stamps (false)
 {
     SmartPtr<EventPollThread> event_loop = new EventPollThread(this);
     XCAM_ASSERT (event_loop.ptr ());
@@ -133,8 +168,94 @@ PollThread::set_stats_callback (StatsCallback *callback)
     return true;
 }
 
+void
+PollThread::set_thread_policy (const ThreadPolicy &capture, const ThreadPolicy &event)
+{
+    _capture_loop->set_policy (capture);
+    _event_loop->set_policy (event);
+}
+
+bool
+PollThread::set_io_reactor (const SmartPtr<IoReactor> &reactor)
+{
+    XCAM_ASSERT (!_io_reactor.ptr ());
+    _io_reactor = reactor;
+    return true;
+}
+
+#if HAVE_LIBJPEG
+bool
+PollThread::set_mjpeg_decoder (const SmartPtr<MjpegDecoder> &decoder)
+{
+    XCAM_ASSERT (!_mjpeg_decoder.ptr ());
+    _mjpeg_decoder = decoder;
+    return true;
+}
+#endif
+
+XCamReturn
+PollThread::start_io_reactor ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+
+    if (_event_dev.ptr ()) {
+        ret = init_3a_stats_pool ();
+        XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "poll thread init 3a stats pool failed");
+
+        _event_io = new PollIoHandler (this, false);
+        ret = _io_reactor->add_fd (_event_dev->get_fd (), EPOLLPRI, _event_io.ptr ());
+        if (ret != XCAM_RETURN_NO_ERROR) {
+            _event_io.release ();
+            return ret;
+        }
+    }
+
+    if (!capture_pollable ()) {
+        if (_capture_loop->start ())
+            return XCAM_RETURN_NO_ERROR;
+        stop_io_reactor ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    _capture_io = new PollIoHandler (this, true);
+    ret = _io_reactor->add_fd (_capture_dev->get_fd (), EPOLLIN, _capture_io.ptr ());
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        _capture_io.release ();
+        stop_io_reactor ();
+        return ret;
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+PollThread::stop_io_reactor ()
+{
+    if (_capture_io.ptr ()) {
+        _io_reactor->remove_fd (_capture_dev->get_fd ());
+        _capture_io.release ();
+    }
+    if (_event_io.ptr ()) {
+        _io_reactor->remove_fd (_event_dev->get_fd ());
+        _event_io.release ();
+    }
+}
+
 XCamReturn PollThread::start ()
 {
+#if HAVE_LIBJPEG
+    if (_mjpeg_decoder.ptr () && _capture_dev->get_pixel_format () == V4L2_PIX_FMT_MJPEG) {
+        uint32_t width = 0, height = 0;
+        _capture_dev->get_size (width, height);
+        _mjpeg_decoder->set_callback (_poll_callback);
+        XCamReturn ret = _mjpeg_decoder->start (width, height);
+        XCAM_FAIL_RETURN (ERROR, ret == XCAM_RETURN_NO_ERROR, ret, "poll thread start mjpeg decoder failed");
+    }
+#endif
+
+    if (_io_reactor.ptr ())
+        return start_io_reactor ();
+
     if (_event_dev.ptr () && !_event_loop->start ()) {
         return XCAM_RETURN_ERROR_THREAD;
     }
@@ -147,8 +268,15 @@ XCamReturn PollThread::start ()
 
 XCamReturn PollThread::stop ()
 {
+    if (_io_reactor.ptr ())
+        stop_io_reactor ();
+
     _event_loop->stop ();
     _capture_loop->stop ();
+#if HAVE_LIBJPEG
+    if (_mjpeg_decoder.ptr ())
+        _mjpeg_decoder->stop ();
+#endif
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -197,8 +325,6 @@ PollThread::handle_3a_stats_event (struct v4l2_event &event)
 XCamReturn
 PollThread::poll_subdev_event_loop ()
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    struct v4l2_event event;
     int poll_ret = 0;
 
     poll_ret = _event_dev->poll_event (PollThread::default_subdev_event_timeout);
@@ -215,6 +341,15 @@ PollThread::poll_subdev_event_loop ()
         return XCAM_RETURN_ERROR_TIMEOUT;
     }
 
+    return dequeue_subdev_event ();
+}
+
+XCamReturn
+PollThread::dequeue_subdev_event ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    struct v4l2_event event;
+
     xcam_mem_clear (event);
     ret = _event_dev->dequeue_event (event);
     if (ret != XCAM_RETURN_NO_ERROR) {
@@ -229,9 +364,7 @@ PollThread::poll_subdev_event_loop ()
 XCamReturn
 PollThread::poll_buffer_loop ()
 {
-    XCamReturn ret = XCAM_RETURN_NO_ERROR;
     int poll_ret = 0;
-    SmartPtr<V4l2Buffer> buf;
 
     poll_ret = _capture_dev->poll_event (PollThread::default_capture_event_timeout);
 
@@ -247,6 +380,15 @@ PollThread::poll_buffer_loop ()
         return XCAM_RETURN_ERROR_TIMEOUT;
     }
 
+    return capture_buffer ();
+}
+
+XCamReturn
+PollThread::capture_buffer ()
+{
+    XCamReturn ret = XCAM_RETURN_NO_ERROR;
+    SmartPtr<V4l2Buffer> buf;
+
     ret = _capture_dev->dequeue_buffer (buf);
     if (ret != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_WARNING ("capture buffer failed");
@@ -256,6 +398,13 @@ PollThread::poll_buffer_loop ()
     XCAM_ASSERT (_poll_callback);
 
     SmartPtr<VideoBuffer> video_buf = new V4l2BufferProxy (buf, _capture_dev);
+    if (_latency_stamps)
+        FrameLatencyMeta::start (video_buf, "capture");
+
+#if HAVE_LIBJPEG
+    if (_mjpeg_decoder.ptr () && buf->get_format ().fmt.pix.pixelformat == V4L2_PIX_FMT_MJPEG)
+        return _mjpeg_decoder->push_buffer (video_buf, buf->get_buf ().bytesused);
+#endif
 
     if (_poll_callback)
         return _poll_callback->poll_buffer_ready (video_buf);
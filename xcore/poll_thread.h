@@ -23,11 +23,17 @@
 
 #include <xcam_std.h>
 #include <xcam_mutex.h>
+#include <xcam_thread.h>
 #include <x3a_event.h>
 #include <v4l2_buffer_proxy.h>
 #include <x3a_stats_pool.h>
 #include <v4l2_device.h>
 #include <stats_callback_interface.h>
+#include <io_reactor.h>
+#include <frame_latency.h>
+#if HAVE_LIBJPEG
+#include <mjpeg_decoder.h>
+#endif
 
 namespace XCam {
 
@@ -48,12 +54,14 @@ class V4l2Device;
 class V4l2SubDevice;
 class EventPollThread;
 class CapturePollThread;
+class PollIoHandler;
 
 class PollThread
 {
     friend class EventPollThread;
     friend class CapturePollThread;
     friend class FakePollThread;
+    friend class PollIoHandler;
 public:
     explicit PollThread ();
     virtual ~PollThread ();
@@ -62,6 +70,18 @@ public:
     bool set_event_device (SmartPtr<V4l2SubDevice> &sub_dev);
     bool set_poll_callback (PollCallback *callback);
     bool set_stats_callback (StatsCallback *callback);
+    // set before start
+    void set_thread_policy (const ThreadPolicy &capture, const ThreadPolicy &event);
+    // capture and event fds go to reactor instead of own threads, set before start
+    bool set_io_reactor (const SmartPtr<IoReactor> &reactor);
+#if HAVE_LIBJPEG
+    // MJPEG captures are decoded to NV12 before poll callback, set before start
+    bool set_mjpeg_decoder (const SmartPtr<MjpegDecoder> &decoder);
+#endif
+    // captured buffers start FrameLatencyMeta stamps, set before start
+    void set_latency_stamps (bool enable) {
+        _latency_stamps = enable;
+    }
 
     virtual XCamReturn start();
     virtual XCamReturn stop ();
@@ -69,11 +89,20 @@ public:
 protected:
     XCamReturn poll_subdev_event_loop ();
     virtual XCamReturn poll_buffer_loop ();
+    // capture device without fd to poll keeps its own thread
+    virtual bool capture_pollable () const {
+        return true;
+    }
+    XCamReturn capture_buffer ();
+    XCamReturn dequeue_subdev_event ();
 
     virtual XCamReturn handle_events (struct v4l2_event &event);
     XCamReturn handle_3a_stats_event (struct v4l2_event &event);
 
 private:
+    XCamReturn start_io_reactor ();
+    void stop_io_reactor ();
+
     virtual XCamReturn init_3a_stats_pool ();
     virtual XCamReturn capture_3a_stats (SmartPtr<X3aStats> &stats);
 
@@ -92,6 +121,14 @@ private:
 
     PollCallback                    *_poll_callback;
     StatsCallback                   *_stats_callback;
+    bool                             _latency_stamps;
+
+    SmartPtr<IoReactor>              _io_reactor;
+    SmartPtr<PollIoHandler>          _capture_io;
+    SmartPtr<PollIoHandler>          _event_io;
+#if HAVE_LIBJPEG
+    SmartPtr<MjpegDecoder>           _mjpeg_decoder;
+#endif
 };
 
 };
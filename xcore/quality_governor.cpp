@@ -0,0 +1,260 @@
+/*
+ * quality_governor.cpp - trade quality for real-time under load and heat
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "quality_governor.h"
+#include <stdio.h>
+#include <time.h>
+
+#define XCAM_GOVERNOR_MAX_THERMAL_ZONES 16
+
+#define XCAM_GOVERNOR_THERMAL_PATH "/sys/class/thermal/thermal_zone%d/temp"
+#define XCAM_GOVERNOR_CPU_CAP_PATH "/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq"
+#define XCAM_GOVERNOR_CPU_MAX_PATH "/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq"
+#define XCAM_GOVERNOR_GPU_ACT_PATH "/sys/class/drm/card0/gt_act_freq_mhz"
+#define XCAM_GOVERNOR_GPU_REQ_PATH "/sys/class/drm/card0/gt_cur_freq_mhz"
+
+namespace XCam {
+
+static int64_t
+get_governor_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+static bool
+read_sysfs_value (const char *path, int64_t &value)
+{
+    FILE *fp = fopen (path, "r");
+    if (!fp)
+        return false;
+
+    long long v = 0;
+    bool ret = (fscanf (fp, "%lld", &v) == 1);
+    fclose (fp);
+    if (ret)
+        value = v;
+    return ret;
+}
+
+bool
+GovernorSensors::is_throttled () const
+{
+    if (cpu_freq_cap && cpu_max_freq && cpu_freq_cap < cpu_max_freq * XCAM_GOVERNOR_THROTTLE_RATIO)
+        return true;
+    if (gpu_freq && gpu_requested_freq && gpu_freq < gpu_requested_freq * XCAM_GOVERNOR_THROTTLE_RATIO)
+        return true;
+    return false;
+}
+
+QualityGovernor::QualityGovernor ()
+    : _frame_budget (0)
+    , _thermal_limit (XCAM_GOVERNOR_DEFAULT_THERMAL_LIMIT)
+    , _avg_frame_time (0)
+    , _hold_frames (0)
+    , _last_sensor_time (0)
+{
+}
+
+QualityGovernor::~QualityGovernor ()
+{
+    _knobs.clear ();
+    _handlers.clear ();
+}
+
+bool
+QualityGovernor::add_handler (const SmartPtr<ImageHandler> &handler)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, handler.ptr (), false,
+        "quality governor add handler failed, handler is NULL");
+
+    const QualityKnobList &knobs = handler->get_quality_knobs ();
+    if (knobs.empty ()) {
+        XCAM_LOG_DEBUG ("quality governor: handler(%s) has no knob", XCAM_STR (handler->get_name ()));
+        return true;
+    }
+
+    SmartLock locker (_mutex);
+    _handlers.push_back (handler);
+    for (QualityKnobList::const_iterator i = knobs.begin (); i != knobs.end (); ++i)
+        _knobs.push_back (*i);
+
+    return true;
+}
+
+bool
+QualityGovernor::add_knob (const SmartPtr<QualityKnob> &knob)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, knob.ptr () && knob->get_level_count () > 0, false,
+        "quality governor add knob failed, knob invalid");
+
+    SmartLock locker (_mutex);
+    _knobs.push_back (knob);
+    return true;
+}
+
+void
+QualityGovernor::set_frame_budget (int64_t budget_us)
+{
+    SmartLock locker (_mutex);
+    _frame_budget = XCAM_MAX (budget_us, (int64_t)0);
+    _avg_frame_time = 0;
+}
+
+void
+QualityGovernor::set_thermal_limit (int32_t milli_celsius)
+{
+    SmartLock locker (_mutex);
+    _thermal_limit = milli_celsius;
+}
+
+void
+QualityGovernor::read_sensors_unsafe ()
+{
+    GovernorSensors sensors;
+    int64_t value = 0;
+    char path[XCAM_MAX_STR_SIZE];
+
+    for (int32_t i = 0; i < XCAM_GOVERNOR_MAX_THERMAL_ZONES; ++i) {
+        snprintf (path, sizeof (path), XCAM_GOVERNOR_THERMAL_PATH, i);
+        if (!read_sysfs_value (path, value))
+            break;
+        sensors.temperature = XCAM_MAX (sensors.temperature, (int32_t)value);
+    }
+
+    if (read_sysfs_value (XCAM_GOVERNOR_CPU_CAP_PATH, value))
+        sensors.cpu_freq_cap = (uint32_t)value;
+    if (read_sysfs_value (XCAM_GOVERNOR_CPU_MAX_PATH, value))
+        sensors.cpu_max_freq = (uint32_t)value;
+    if (read_sysfs_value (XCAM_GOVERNOR_GPU_ACT_PATH, value))
+        sensors.gpu_freq = (uint32_t)value;
+    if (read_sysfs_value (XCAM_GOVERNOR_GPU_REQ_PATH, value))
+        sensors.gpu_requested_freq = (uint32_t)value;
+
+    _sensors = sensors;
+}
+
+// next knob not at its cheapest level goes one level down in quality
+bool
+QualityGovernor::degrade_unsafe ()
+{
+    for (uint32_t i = 0; i < _knobs.size (); ++i) {
+        SmartPtr<QualityKnob> &knob = _knobs[i];
+        uint32_t level = knob->get_level ();
+        if (level + 1 >= knob->get_level_count ())
+            continue;
+
+        if (!knob->set_level (level + 1))
+            continue;
+        XCAM_LOG_INFO ("quality governor: knob(%s) degraded to level %d", XCAM_STR (knob->get_name ()), level + 1);
+        return true;
+    }
+    return false;
+}
+
+// last knob turned comes back first
+bool
+QualityGovernor::restore_unsafe ()
+{
+    for (uint32_t i = _knobs.size (); i > 0; --i) {
+        SmartPtr<QualityKnob> &knob = _knobs[i - 1];
+        uint32_t level = knob->get_level ();
+        if (!level)
+            continue;
+
+        if (!knob->set_level (level - 1))
+            continue;
+        XCAM_LOG_INFO ("quality governor: knob(%s) restored to level %d", XCAM_STR (knob->get_name ()), level - 1);
+        return true;
+    }
+    return false;
+}
+
+void
+QualityGovernor::frame_done (int64_t process_time)
+{
+    SmartLock locker (_mutex);
+    if (_knobs.empty ())
+        return;
+
+    int64_t now = get_governor_time ();
+    if (!_last_sensor_time || now - _last_sensor_time >= XCAM_GOVERNOR_SENSOR_INTERVAL) {
+        read_sensors_unsafe ();
+        _last_sensor_time = now;
+    }
+
+    // moving average over about 8 frames
+    _avg_frame_time = _avg_frame_time ? (_avg_frame_time * 7 + process_time) / 8 : process_time;
+    if (_hold_frames) {
+        --_hold_frames;
+        return;
+    }
+
+    bool hot = (_sensors.temperature >= 0 && _sensors.temperature >= _thermal_limit);
+    bool cool = (_sensors.temperature < 0 || _sensors.temperature < _thermal_limit - XCAM_GOVERNOR_THERMAL_HYSTERESIS);
+    bool overload = _frame_budget && _avg_frame_time > _frame_budget * XCAM_GOVERNOR_DEGRADE_RATIO;
+    bool idle = !_frame_budget || _avg_frame_time < _frame_budget * XCAM_GOVERNOR_RESTORE_RATIO;
+
+    bool changed = false;
+    if (hot || overload)
+        changed = degrade_unsafe ();
+    else if (idle && cool && !_sensors.is_throttled ())
+        changed = restore_unsafe ();
+
+    if (changed) {
+        XCAM_LOG_DEBUG (
+            "quality governor: frame time %" PRId64 "us, budget %" PRId64 "us, temperature %d",
+            _avg_frame_time, _frame_budget, _sensors.temperature);
+        _hold_frames = XCAM_GOVERNOR_HOLD_FRAMES;
+        _avg_frame_time = 0;
+    }
+}
+
+void
+QualityGovernor::reset ()
+{
+    SmartLock locker (_mutex);
+    for (uint32_t i = 0; i < _knobs.size (); ++i)
+        _knobs[i]->set_level (0);
+    _avg_frame_time = 0;
+    _hold_frames = 0;
+}
+
+void
+QualityGovernor::get_sensors (GovernorSensors &sensors)
+{
+    SmartLock locker (_mutex);
+    sensors = _sensors;
+}
+
+uint32_t
+QualityGovernor::get_degrade_level ()
+{
+    SmartLock locker (_mutex);
+    uint32_t level = 0;
+    for (uint32_t i = 0; i < _knobs.size (); ++i)
+        level += _knobs[i]->get_level ();
+    return level;
+}
+
+}
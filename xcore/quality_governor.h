@@ -0,0 +1,111 @@
+/*
+ * quality_governor.h - trade quality for real-time under load and heat
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_QUALITY_GOVERNOR_H
+#define XCAM_QUALITY_GOVERNOR_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <image_handler.h>
+#include <quality_knob.h>
+#include <vector>
+
+// share of frame budget to turn a knob down or back up, the gap avoids toggling
+#define XCAM_GOVERNOR_DEGRADE_RATIO   0.9
+#define XCAM_GOVERNOR_RESTORE_RATIO   0.6
+// frames to settle after a knob turned before next decision
+#define XCAM_GOVERNOR_HOLD_FRAMES     15
+
+#define XCAM_GOVERNOR_DEFAULT_THERMAL_LIMIT 85000 // milli celsius
+#define XCAM_GOVERNOR_THERMAL_HYSTERESIS    5000  // milli celsius
+// clocks capped below this share mean cooling devices or firmware throttle
+#define XCAM_GOVERNOR_THROTTLE_RATIO  0.7
+#define XCAM_GOVERNOR_SENSOR_INTERVAL 500000 // us
+
+namespace XCam {
+
+struct GovernorSensors {
+    int32_t     temperature;        // milli celsius, hottest thermal zone, -1 unknown
+    uint32_t    cpu_freq_cap;       // kHz, policy limit lowered by cooling devices, 0 unknown
+    uint32_t    cpu_max_freq;       // kHz, hardware max
+    uint32_t    gpu_freq;           // MHz, actual, 0 unknown
+    uint32_t    gpu_requested_freq; // MHz, firmware runs below it while throttling
+
+    GovernorSensors ()
+        : temperature (-1)
+        , cpu_freq_cap (0), cpu_max_freq (0)
+        , gpu_freq (0), gpu_requested_freq (0)
+    {}
+    bool is_throttled () const;
+};
+
+/*
+ * QualityGovernor, keeps processing real-time on boxes that throttle.
+ * frame time over budget or temperature over limit turns the next knob one
+ * level cheaper, knobs in order of adding. once frame time is well under budget,
+ * temperature is back under limit less hysteresis and clocks are not throttled,
+ * knobs are restored in reverse order.
+ * sensors come from thermal, cpufreq and i915 sysfs, missing ones are ignored.
+ */
+class QualityGovernor
+{
+public:
+    explicit QualityGovernor ();
+    ~QualityGovernor ();
+
+    // knobs of @handler in its order, the handler is kept alive by governor
+    bool add_handler (const SmartPtr<ImageHandler> &handler);
+    bool add_knob (const SmartPtr<QualityKnob> &knob);
+
+    // @budget_us 0 means only temperature is watched
+    void set_frame_budget (int64_t budget_us);
+    void set_thermal_limit (int32_t milli_celsius);
+
+    // processing time of a frame, decisions are made in caller thread
+    void frame_done (int64_t process_time);
+    // knob levels back to 0
+    void reset ();
+
+    void get_sensors (GovernorSensors &sensors);
+    // sum of knob levels
+    uint32_t get_degrade_level ();
+
+private:
+    void read_sensors_unsafe ();
+    bool degrade_unsafe ();
+    bool restore_unsafe ();
+
+    XCAM_DEAD_COPY (QualityGovernor);
+
+private:
+    std::vector<SmartPtr<QualityKnob> >     _knobs;
+    std::vector<SmartPtr<ImageHandler> >    _handlers;
+    int64_t                                 _frame_budget;
+    int32_t                                 _thermal_limit;
+    int64_t                                 _avg_frame_time;
+    uint32_t                                _hold_frames;
+    int64_t                                 _last_sensor_time;
+    GovernorSensors                         _sensors;
+    Mutex                                   _mutex;
+};
+
+}
+
+#endif //XCAM_QUALITY_GOVERNOR_H
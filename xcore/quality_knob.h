@@ -0,0 +1,67 @@
+/*
+ * quality_knob.h - quality settings traded for speed at run time
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_QUALITY_KNOB_H
+#define XCAM_QUALITY_KNOB_H
+
+#include <xcam_std.h>
+#include <list>
+
+namespace XCam {
+
+/*
+ * QualityKnob, a setting a handler lets QualityGovernor turn while running.
+ * level 0 is full quality, every higher level is cheaper; set_level may come
+ * from any thread and takes effect from the next frame.
+ */
+class QualityKnob
+{
+public:
+    explicit QualityKnob (const char *name)
+        : _name (NULL)
+    {
+        if (name)
+            _name = strndup (name, XCAM_MAX_STR_SIZE);
+    }
+    virtual ~QualityKnob () {
+        xcam_free (_name);
+    }
+
+    const char *get_name () const {
+        return _name;
+    }
+
+    // at least 1, a knob of 1 level can't be turned
+    virtual uint32_t get_level_count () const = 0;
+    virtual uint32_t get_level () const = 0;
+    virtual bool set_level (uint32_t level) = 0;
+
+private:
+    XCAM_DEAD_COPY (QualityKnob);
+
+private:
+    char    *_name;
+};
+
+typedef std::list<SmartPtr<QualityKnob> > QualityKnobList;
+
+}
+
+#endif //XCAM_QUALITY_KNOB_H
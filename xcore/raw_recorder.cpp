@@ -0,0 +1,535 @@
+/*
+ * raw_recorder.cpp - raw frames of several streams written with writes in flight
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "raw_recorder.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#if HAVE_LINUX_IO_URING_H && defined (__NR_io_uring_setup) && defined (__NR_io_uring_enter)
+#define XCAM_RAW_RECORDER_URING 1
+#else
+#define XCAM_RAW_RECORDER_URING 0
+#endif
+
+// user data of the nop which wakes up the writer thread on stop
+#define XCAM_RAW_RECORDER_STOP_TAG UINT64_MAX
+
+namespace XCam {
+
+#if XCAM_RAW_RECORDER_URING
+struct RawRecorderRing {
+    int                     fd;
+    uint8_t                *sq_ptr;
+    size_t                  sq_size;
+    uint8_t                *cq_ptr;
+    size_t                  cq_size;
+    struct io_uring_sqe    *sqes;
+    size_t                  sqes_size;
+
+    uint32_t               *sq_tail;
+    uint32_t                sq_mask;
+    uint32_t               *sq_array;
+    uint32_t               *cq_head;
+    uint32_t               *cq_tail;
+    uint32_t                cq_mask;
+    struct io_uring_cqe    *cqes;
+
+    RawRecorderRing ()
+        : fd (-1), sq_ptr (NULL), sq_size (0), cq_ptr (NULL), cq_size (0), sqes (NULL), sqes_size (0)
+        , sq_tail (NULL), sq_mask (0), sq_array (NULL), cq_head (NULL), cq_tail (NULL), cq_mask (0), cqes (NULL)
+    {}
+};
+#else
+struct RawRecorderRing {};
+#endif
+
+class RawRecorderThread
+    : public Thread
+{
+public:
+    explicit RawRecorderThread (RawRecorder *recorder, const char *name)
+        : Thread (name)
+        , _recorder (recorder)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _recorder->process_completions ();
+    }
+
+private:
+    RawRecorder   *_recorder;
+};
+
+RawRecorder::RawRecorder (const char *name)
+    : _name (NULL)
+    , _depth (XCAM_RAW_RECORDER_DEFAULT_DEPTH)
+    , _direct_io (true)
+    , _running (false)
+    , _stopping (false)
+    , _ring (NULL)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+RawRecorder::~RawRecorder ()
+{
+    stop ();
+
+    for (uint32_t i = 0; i < _streams.size (); ++i) {
+        Stream &stream = _streams[i];
+        if (stream.direct_fd >= 0)
+            close (stream.direct_fd);
+        if (stream.fd >= 0)
+            close (stream.fd);
+        xcam_free (stream.path);
+    }
+    xcam_free (_name);
+}
+
+bool
+RawRecorder::set_queue_depth (uint32_t depth)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_running && depth, false,
+        "raw recorder(%s) set queue depth:%d failed, %s",
+        XCAM_STR (_name), depth, (_running ? "recorder is running" : "depth is zero"));
+
+    _depth = depth;
+    return true;
+}
+
+XCamReturn
+RawRecorder::add_stream (const char *path, uint32_t &id)
+{
+    XCAM_ASSERT (path);
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, XCAM_RETURN_ERROR_ORDER,
+        "raw recorder(%s) add stream(%s) failed, recorder is running", XCAM_STR (_name), path);
+
+    Stream stream;
+    stream.fd = open (path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    XCAM_FAIL_RETURN (
+        ERROR, stream.fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "raw recorder(%s) open %s failed, errno:%d", XCAM_STR (_name), path, errno);
+
+#ifdef O_DIRECT
+    // file systems like tmpfs refuse O_DIRECT, page cache writes only
+    if (_direct_io) {
+        stream.direct_fd = open (path, O_WRONLY | O_DIRECT | O_CLOEXEC);
+        if (stream.direct_fd < 0) {
+            XCAM_LOG_DEBUG ("raw recorder(%s) %s has no direct io, errno:%d", XCAM_STR (_name), path, errno);
+        }
+    }
+#endif
+
+    stream.path = strndup (path, XCAM_MAX_STR_SIZE);
+    _streams.push_back (stream);
+    id = _streams.size () - 1;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawRecorder::start ()
+{
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, XCAM_RETURN_ERROR_ORDER,
+        "raw recorder(%s) was already started", XCAM_STR (_name));
+
+    _requests.clear ();
+    _requests.resize (_depth);
+    _free_requests.clear ();
+    for (uint32_t i = _depth; i > 0; --i)
+        _free_requests.push_back (i - 1);
+    _pending.clear ();
+    _stopping = false;
+
+    if (!setup_ring ())
+        XCAM_LOG_INFO ("raw recorder(%s) has no io_uring, writes by pwrite thread", XCAM_STR (_name));
+
+    _thread = new RawRecorderThread (this, _name);
+    if (!_thread->start ()) {
+        destroy_ring ();
+        _thread.release ();
+        XCAM_LOG_ERROR ("raw recorder(%s) start writer thread failed", XCAM_STR (_name));
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    _running = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawRecorder::stop ()
+{
+    {
+        SmartLock locker (_mutex);
+        if (!_running)
+            return XCAM_RETURN_NO_ERROR;
+
+        while (_free_requests.size () < _requests.size ())
+            _free_cond.wait (_mutex);
+
+        _stopping = true;
+#if XCAM_RAW_RECORDER_URING
+        if (_ring) {
+            uint32_t tail = *_ring->sq_tail;
+            uint32_t idx = tail & _ring->sq_mask;
+            struct io_uring_sqe *sqe = &_ring->sqes[idx];
+            xcam_mem_clear (*sqe);
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = XCAM_RAW_RECORDER_STOP_TAG;
+            _ring->sq_array[idx] = idx;
+            __atomic_store_n (_ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+            if (syscall (__NR_io_uring_enter, _ring->fd, 1, 0, 0, NULL, 0) < 0)
+                XCAM_LOG_ERROR ("raw recorder(%s) submit stop failed, errno:%d", XCAM_STR (_name), errno);
+        }
+#endif
+        _pending_cond.broadcast ();
+    }
+
+    _thread->stop ();
+    _thread.release ();
+
+    SmartLock locker (_mutex);
+    destroy_ring ();
+    _running = false;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+RawRecorder::write (uint32_t id, const SmartPtr<VideoBuffer> &buf)
+{
+    XCAM_ASSERT (buf.ptr ());
+    uint8_t *ptr = buf->map ();
+    XCAM_FAIL_RETURN (
+        ERROR, ptr, XCAM_RETURN_ERROR_MEM,
+        "raw recorder(%s) map buffer of stream:%d failed", XCAM_STR (_name), id);
+
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, _running && !_stopping && id < _streams.size (), XCAM_RETURN_ERROR_PARAM,
+        "raw recorder(%s) write stream:%d failed, %s",
+        XCAM_STR (_name), id, (id < _streams.size () ? "recorder is not running" : "no such stream"));
+
+    Stream &stream = _streams[id];
+    XCAM_FAIL_RETURN (
+        ERROR, !stream.failed, XCAM_RETURN_ERROR_FILE,
+        "raw recorder(%s) stream(%s) failed on earlier writes", XCAM_STR (_name), XCAM_STR (stream.path));
+
+    while (_free_requests.empty ())
+        _free_cond.wait (_mutex);
+
+    uint32_t index = _free_requests.back ();
+    _free_requests.pop_back ();
+
+    uint32_t size = buf->get_size ();
+    Request &request = _requests[index];
+    request.buf = buf;
+    request.stream = id;
+    request.offset = stream.offset;
+    request.iov.iov_base = ptr;
+    request.iov.iov_len = size;
+    request.direct = stream.direct_fd >= 0 &&
+                     !((uintptr_t)ptr % XCAM_RAW_RECORDER_DIRECT_ALIGN) &&
+                     !(size % XCAM_RAW_RECORDER_DIRECT_ALIGN) &&
+                     !(stream.offset % XCAM_RAW_RECORDER_DIRECT_ALIGN);
+    stream.offset += size;
+
+    if (_ring) {
+        if (!submit_unsafe (index)) {
+            request.buf.release ();
+            _free_requests.push_back (index);
+            stream.failed = true;
+            buf->unmap ();
+            return XCAM_RETURN_ERROR_IOCTL;
+        }
+    } else {
+        _pending.push_back (index);
+        _pending_cond.signal ();
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+uint64_t
+RawRecorder::get_written_bytes (uint32_t id) const
+{
+    SmartLock locker (_mutex);
+    XCAM_FAIL_RETURN (
+        ERROR, id < _streams.size (), 0,
+        "raw recorder(%s) get written bytes failed, no stream:%d", XCAM_STR (_name), id);
+    return _streams[id].written;
+}
+
+bool
+RawRecorder::setup_ring ()
+{
+#if XCAM_RAW_RECORDER_URING
+    XCAM_ASSERT (!_ring);
+
+    struct io_uring_params params;
+    xcam_mem_clear (params);
+    // one more entry for the stop nop
+    int fd = syscall (__NR_io_uring_setup, _depth + 1, &params);
+    if (fd < 0) {
+        XCAM_LOG_DEBUG ("raw recorder(%s) io_uring setup failed, errno:%d", XCAM_STR (_name), errno);
+        return false;
+    }
+
+    RawRecorderRing *ring = new RawRecorderRing;
+    ring->fd = fd;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        ring->sq_size = ring->cq_size = XCAM_MAX (ring->sq_size, ring->cq_size);
+
+    void *ptr = mmap (
+        NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    ring->sq_ptr = (ptr == MAP_FAILED) ? NULL : (uint8_t *)ptr;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else if (ring->sq_ptr) {
+        ptr = mmap (
+            NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        ring->cq_ptr = (ptr == MAP_FAILED) ? NULL : (uint8_t *)ptr;
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof (struct io_uring_sqe);
+    if (ring->cq_ptr) {
+        ptr = mmap (
+            NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        ring->sqes = (ptr == MAP_FAILED) ? NULL : (struct io_uring_sqe *)ptr;
+    }
+
+    _ring = ring;
+    if (!ring->sqes) {
+        XCAM_LOG_WARNING ("raw recorder(%s) map io_uring failed, errno:%d", XCAM_STR (_name), errno);
+        destroy_ring ();
+        return false;
+    }
+
+    ring->sq_tail = (uint32_t *)(ring->sq_ptr + params.sq_off.tail);
+    ring->sq_mask = *(uint32_t *)(ring->sq_ptr + params.sq_off.ring_mask);
+    ring->sq_array = (uint32_t *)(ring->sq_ptr + params.sq_off.array);
+    ring->cq_head = (uint32_t *)(ring->cq_ptr + params.cq_off.head);
+    ring->cq_tail = (uint32_t *)(ring->cq_ptr + params.cq_off.tail);
+    ring->cq_mask = *(uint32_t *)(ring->cq_ptr + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(ring->cq_ptr + params.cq_off.cqes);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+RawRecorder::destroy_ring ()
+{
+#if XCAM_RAW_RECORDER_URING
+    if (!_ring)
+        return;
+
+    if (_ring->sqes)
+        munmap (_ring->sqes, _ring->sqes_size);
+    if (_ring->cq_ptr && _ring->cq_ptr != _ring->sq_ptr)
+        munmap (_ring->cq_ptr, _ring->cq_size);
+    if (_ring->sq_ptr)
+        munmap (_ring->sq_ptr, _ring->sq_size);
+    close (_ring->fd);
+#endif
+    delete _ring;
+    _ring = NULL;
+}
+
+bool
+RawRecorder::submit_unsafe (uint32_t index)
+{
+#if XCAM_RAW_RECORDER_URING
+    XCAM_ASSERT (_ring && index < _requests.size ());
+    Request &request = _requests[index];
+    const Stream &stream = _streams[request.stream];
+
+    // single submitter under _mutex, entries are consumed by io_uring_enter right away
+    uint32_t tail = *_ring->sq_tail;
+    uint32_t idx = tail & _ring->sq_mask;
+    struct io_uring_sqe *sqe = &_ring->sqes[idx];
+    xcam_mem_clear (*sqe);
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = request.direct ? stream.direct_fd : stream.fd;
+    sqe->addr = (uintptr_t)&request.iov;
+    sqe->len = 1;
+    sqe->off = request.offset;
+    sqe->user_data = index;
+    _ring->sq_array[idx] = idx;
+    __atomic_store_n (_ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    int ret = 0;
+    do {
+        ret = syscall (__NR_io_uring_enter, _ring->fd, 1, 0, 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    XCAM_FAIL_RETURN (
+        ERROR, ret == 1, false,
+        "raw recorder(%s) submit write of %s failed, errno:%d",
+        XCAM_STR (_name), XCAM_STR (stream.path), (ret < 0 ? errno : 0));
+    return true;
+#else
+    XCAM_UNUSED (index);
+    return false;
+#endif
+}
+
+bool
+RawRecorder::process_completions ()
+{
+    return _ring ? reap_ring () : write_pending ();
+}
+
+bool
+RawRecorder::reap_ring ()
+{
+#if XCAM_RAW_RECORDER_URING
+    if (syscall (__NR_io_uring_enter, _ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) {
+        XCAM_FAIL_RETURN (
+            ERROR, errno == EINTR, false,
+            "raw recorder(%s) wait io_uring completions failed, errno:%d", XCAM_STR (_name), errno);
+        return true;
+    }
+
+    bool stopped = false;
+    uint32_t head = *_ring->cq_head;
+    uint32_t tail = __atomic_load_n (_ring->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe &cqe = _ring->cqes[head & _ring->cq_mask];
+        uint64_t tag = cqe.user_data;
+        int32_t result = cqe.res;
+        __atomic_store_n (_ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+        if (tag == XCAM_RAW_RECORDER_STOP_TAG)
+            stopped = true;
+        else
+            complete_request ((uint32_t)tag, result);
+    }
+    return !stopped;
+#else
+    return false;
+#endif
+}
+
+bool
+RawRecorder::write_pending ()
+{
+    uint32_t index = 0;
+    {
+        SmartLock locker (_mutex);
+        while (_pending.empty () && !_stopping)
+            _pending_cond.wait (_mutex);
+        if (_pending.empty ())
+            return false;
+
+        index = _pending.front ();
+        _pending.pop_front ();
+    }
+
+    // _requests and _streams are fixed while running
+    const Request &request = _requests[index];
+    const Stream &stream = _streams[request.stream];
+    ssize_t ret = 0;
+    do {
+        ret = pwrite (
+                  request.direct ? stream.direct_fd : stream.fd,
+                  request.iov.iov_base, request.iov.iov_len, request.offset);
+    } while (ret < 0 && errno == EINTR);
+
+    complete_request (index, ret < 0 ? -errno : (int32_t)ret);
+    return true;
+}
+
+void
+RawRecorder::complete_request (uint32_t index, int32_t result)
+{
+    SmartPtr<VideoBuffer> done_buf;
+    {
+        SmartLock locker (_mutex);
+        XCAM_ASSERT (index < _requests.size ());
+        Request &request = _requests[index];
+        Stream &stream = _streams[request.stream];
+
+        bool again = false;
+        if (result == -EINVAL && request.direct) {
+            // device needs larger alignment than XCAM_RAW_RECORDER_DIRECT_ALIGN
+            if (stream.direct_fd >= 0) {
+                XCAM_LOG_WARNING (
+                    "raw recorder(%s) direct write of %s refused, go through page cache",
+                    XCAM_STR (_name), XCAM_STR (stream.path));
+                close (stream.direct_fd);
+                stream.direct_fd = -1;
+            }
+            request.direct = false;
+            again = true;
+        } else if (result < 0) {
+            XCAM_LOG_ERROR (
+                "raw recorder(%s) write %s at offset:%" PRIu64 " failed, errno:%d",
+                XCAM_STR (_name), XCAM_STR (stream.path), request.offset, -result);
+            stream.failed = true;
+        } else if ((size_t)result < request.iov.iov_len) {
+            // short write, the rest goes through page cache since it's no longer aligned
+            stream.written += result;
+            request.iov.iov_base = (uint8_t *)request.iov.iov_base + result;
+            request.iov.iov_len -= result;
+            request.offset += result;
+            request.direct = false;
+            again = (result > 0);
+            if (!again)
+                stream.failed = true;
+        } else {
+            stream.written += result;
+        }
+
+        if (again) {
+            if (!_ring) {
+                _pending.push_front (index);
+                return;
+            }
+            if (submit_unsafe (index))
+                return;
+            stream.failed = true;
+        }
+
+        done_buf = request.buf;
+        request.buf.release ();
+        _free_requests.push_back (index);
+        _free_cond.broadcast ();
+    }
+
+    // returned to its pool outside the lock
+    done_buf->unmap ();
+    done_buf.release ();
+}
+
+}
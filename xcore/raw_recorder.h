@@ -0,0 +1,128 @@
+/*
+ * raw_recorder.h - raw frames of several streams written with writes in flight
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_RAW_RECORDER_H
+#define XCAM_RAW_RECORDER_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <xcam_thread.h>
+#include <video_buffer.h>
+#include <sys/uio.h>
+#include <list>
+#include <vector>
+
+#define XCAM_RAW_RECORDER_DEFAULT_DEPTH 16
+// O_DIRECT alignment of memory, frame size and file offset, logical block of most NVMe drives
+#define XCAM_RAW_RECORDER_DIRECT_ALIGN 512
+
+namespace XCam {
+
+class RawRecorderThread;
+struct RawRecorderRing;
+
+/*
+ * RawRecorder, writes frames of several streams each into a raw file, frames follow one another
+ * as ImageFileHandle reads them. writes go through io_uring, with O_DIRECT where the file system
+ * allows, or through a writer thread with pwrite if io_uring is not available.
+ * O_DIRECT needs frame memory, size and file offset aligned to XCAM_RAW_RECORDER_DIRECT_ALIGN,
+ * e.g. buffers of SoftBufMemShared pools, other frames go through page cache.
+ * buffers are kept till their writes complete, so pooled buffers are returned to pools then.
+ */
+class RawRecorder
+{
+    friend class RawRecorderThread;
+
+    struct Stream {
+        char       *path;
+        int         fd;
+        int         direct_fd;
+        uint64_t    offset;
+        uint64_t    written;
+        bool        failed;
+
+        Stream () : path (NULL), fd (-1), direct_fd (-1), offset (0), written (0), failed (false) {}
+    };
+
+    struct Request {
+        SmartPtr<VideoBuffer>   buf;
+        uint32_t                stream;
+        uint64_t                offset;
+        struct iovec            iov;
+        bool                    direct;
+    };
+
+public:
+    explicit RawRecorder (const char *name = "RawRecorder");
+    ~RawRecorder ();
+
+    // set before start
+    bool set_queue_depth (uint32_t depth);
+    void set_direct_io (bool enable) {
+        _direct_io = enable;
+    }
+
+    // file of @path is truncated, index of the stream returned in @id
+    XCamReturn add_stream (const char *path, uint32_t &id);
+
+    XCamReturn start ();
+    // waits for writes in flight, streams stay open for another start
+    XCamReturn stop ();
+
+    // blocks while all writes of the queue are in flight
+    XCamReturn write (uint32_t id, const SmartPtr<VideoBuffer> &buf);
+
+    uint64_t get_written_bytes (uint32_t id) const;
+    bool is_uring () const {
+        return _ring != NULL;
+    }
+
+private:
+    bool setup_ring ();
+    void destroy_ring ();
+    bool submit_unsafe (uint32_t index);
+    // writer thread, false once stopped
+    bool process_completions ();
+    bool reap_ring ();
+    bool write_pending ();
+    void complete_request (uint32_t index, int32_t result);
+
+    XCAM_DEAD_COPY (RawRecorder);
+
+private:
+    char                          *_name;
+    uint32_t                       _depth;
+    bool                           _direct_io;
+    bool                           _running;
+    bool                           _stopping;
+    std::vector<Stream>            _streams;
+    std::vector<Request>           _requests;
+    std::vector<uint32_t>          _free_requests;
+    std::list<uint32_t>            _pending;
+    RawRecorderRing               *_ring;
+    SmartPtr<Thread>               _thread;
+    mutable Mutex                  _mutex;
+    Cond                           _free_cond;
+    Cond                           _pending_cond;
+};
+
+}
+
+#endif //XCAM_RAW_RECORDER_H
@@ -0,0 +1,103 @@
+/*
+ * row_progress.cpp - rows of a frame filled so far
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "row_progress.h"
+
+namespace XCam {
+
+RowProgress::RowProgress (uint32_t rows)
+    : _total (rows)
+    , _rows (0)
+    , _aborted (false)
+{
+    XCAM_ASSERT (rows);
+}
+
+void
+RowProgress::update (uint32_t rows)
+{
+    SmartLock locker (_mutex);
+    rows = XCAM_MIN (rows, _total);
+    if (rows <= _rows)
+        return;
+
+    _rows = rows;
+    _cond.broadcast ();
+}
+
+void
+RowProgress::complete ()
+{
+    update (_total);
+}
+
+void
+RowProgress::abort ()
+{
+    SmartLock locker (_mutex);
+    _aborted = true;
+    _cond.broadcast ();
+}
+
+uint32_t
+RowProgress::get_rows () const
+{
+    SmartLock locker (_mutex);
+    return _rows;
+}
+
+bool
+RowProgress::is_complete () const
+{
+    SmartLock locker (_mutex);
+    return _rows >= _total;
+}
+
+XCamReturn
+RowProgress::wait (uint32_t rows, int64_t timeout_us)
+{
+    rows = XCAM_MIN (rows, _total);
+
+    SmartLock locker (_mutex);
+    if (_rows >= rows)
+        return XCAM_RETURN_NO_ERROR;
+
+    struct timeval ts;
+    gettimeofday (&ts, NULL);
+    int64_t deadline = XCAM_TIMEVAL_2_USEC (ts) + timeout_us;
+
+    while (_rows < rows) {
+        XCAM_FAIL_RETURN (
+            WARNING, !_aborted, XCAM_RETURN_ERROR_UNKNOWN,
+            "RowProgress wait for %d rows failed, frame aborted at row %d", rows, _rows);
+
+        gettimeofday (&ts, NULL);
+        int64_t remain = deadline - XCAM_TIMEVAL_2_USEC (ts);
+        XCAM_FAIL_RETURN (
+            WARNING, remain > 0, XCAM_RETURN_ERROR_TIMEOUT,
+            "RowProgress wait for %d rows timeout, %d of %d rows ready", rows, _rows, _total);
+
+        _cond.timedwait (_mutex, (uint32_t)XCAM_MIN (remain, (int64_t)1000000));
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * row_progress.h - rows of a frame filled so far
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_ROW_PROGRESS_H
+#define XCAM_ROW_PROGRESS_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <meta_data.h>
+
+namespace XCam {
+
+/*
+ * RowProgress, metadata of a VideoBuffer handed to processing before it is fully captured.
+ * the producer, e.g. capture reporting partial frames or a line-count event, updates rows in
+ * memory from top down and completes or aborts the frame; rows count luma rows, chroma of
+ * those rows included. consumers wait for the rows they read, soft workers do it per range.
+ * thread-safe.
+ */
+class RowProgress
+    : public MetaData
+{
+public:
+    explicit RowProgress (uint32_t rows);
+
+    // rows [0, @rows) are in memory, never goes back
+    void update (uint32_t rows);
+    void complete ();
+    // frame won't be finished, waiters fail
+    void abort ();
+
+    uint32_t get_rows () const;
+    uint32_t get_total_rows () const {
+        return _total;
+    }
+    bool is_complete () const;
+
+    // waits until rows [0, @rows) are in memory, @rows over total waits for the whole frame.
+    // returns XCAM_RETURN_ERROR_TIMEOUT after @timeout_us, XCAM_RETURN_ERROR_UNKNOWN if aborted
+    XCamReturn wait (uint32_t rows, int64_t timeout_us);
+
+private:
+    XCAM_DEAD_COPY (RowProgress);
+
+private:
+    const uint32_t          _total;
+    uint32_t                _rows;
+    bool                    _aborted;
+    mutable Mutex           _mutex;
+    Cond                    _cond;
+};
+
+}
+
+#endif //XCAM_ROW_PROGRESS_H
@@ -25,6 +25,7 @@
 #include <base/xcam_common.h>
 #include <errno.h>
 #include <list>
+#include <utility>
 #include <xcam_mutex.h>
 
 namespace XCam {
@@ -38,6 +39,7 @@ public:
 
     SafeList ()
         : _pop_paused (false)
+        , _waiters (0)
     {}
     ~SafeList () {
     }
@@ -48,6 +50,8 @@ public:
     */
     inline ObjPtr pop (int32_t timeout = -1);
     inline bool push (const ObjPtr &obj);
+    // pushes all @objs under one lock, wakes up to as many waiters, by one broadcast if enough
+    inline bool push_many (const ObjList &objs);
     inline bool erase (const ObjPtr &obj);
     inline ObjPtr front ();
     uint32_t size () {
@@ -77,6 +81,7 @@ protected:
     Mutex             _mutex;
     XCam::Cond        _new_obj_cond;
     volatile bool              _pop_paused;
+    uint32_t          _waiters;
 };
 
 
@@ -88,10 +93,12 @@ SafeList<OBj>::pop (int32_t timeout)
     int code = 0;
 
     while (!_pop_paused && _obj_list.empty() && code == 0) {
+        ++_waiters;
         if (timeout < 0)
             code = _new_obj_cond.wait(_mutex);
         else
             code = _new_obj_cond.timedwait(_mutex, timeout);
+        --_waiters;
     }
 
     if (_pop_paused)
@@ -106,7 +113,7 @@ SafeList<OBj>::pop (int32_t timeout)
         return NULL;
     }
 
-    SafeList<OBj>::ObjPtr obj = *_obj_list.begin ();
+    SafeList<OBj>::ObjPtr obj = std::move (*_obj_list.begin ());
     _obj_list.erase (_obj_list.begin ());
     return obj;
 }
@@ -121,6 +128,26 @@ SafeList<OBj>::push (const SafeList<OBj>::ObjPtr &obj)
     return true;
 }
 
+template<class OBj>
+bool
+SafeList<OBj>::push_many (const SafeList<OBj>::ObjList &objs)
+{
+    if (objs.empty ())
+        return true;
+
+    SmartLock lock (_mutex);
+    _obj_list.insert (_obj_list.end (), objs.begin (), objs.end ());
+
+    uint32_t count = objs.size ();
+    if (count >= _waiters) {
+        _new_obj_cond.broadcast ();
+    } else {
+        for (uint32_t i = 0; i < count; ++i)
+            _new_obj_cond.signal ();
+    }
+    return true;
+}
+
 template<class OBj>
 bool
 SafeList<OBj>::erase (const SafeList<OBj>::ObjPtr &obj)
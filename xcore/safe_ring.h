@@ -0,0 +1,299 @@
+/*
+ * safe_ring.h - lock-free bounded ring template
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SAFE_RING_H
+#define XCAM_SAFE_RING_H
+
+#include <base/xcam_defs.h>
+#include <base/xcam_common.h>
+#include <errno.h>
+#include <atomic>
+#include <xcam_mutex.h>
+
+#define XCAM_SAFE_RING_DEFAULT_CAPACITY 64
+
+namespace XCam {
+
+/*
+ * SafeRing, multi-producer multi-consumer bounded queue.
+ * Same pop/push/pause_pop/resume_pop/wakeup semantics as SafeList, but
+ * elements are kept in a fixed-capacity ring indexed by atomic head and tail,
+ * so push and pop never allocate and only lock when they have to block,
+ * which is when the ring is empty (pop) or full (push).
+ * A full ring makes push fail instead of blocking once pop is paused.
+ */
+template<class OBj>
+class SafeRing {
+public:
+    typedef SmartPtr<OBj> ObjPtr;
+
+    // capacity is rounded up to power of 2
+    explicit SafeRing (uint32_t capacity = XCAM_SAFE_RING_DEFAULT_CAPACITY);
+    ~SafeRing ();
+
+    /*
+     * timeout, -1,  wait until wakeup
+     *         >=0,  wait for @timeout microsseconds
+    */
+    inline ObjPtr pop (int32_t timeout = -1);
+    // unlike SafeList, blocks the caller while the ring is full,
+    // producers which must not stall, such as capture threads, need try_push
+    inline bool push (const ObjPtr &obj, int32_t timeout = -1);
+
+    // never block
+    inline ObjPtr try_pop ();
+    inline bool try_push (const ObjPtr &obj);
+
+    uint32_t get_capacity () const {
+        return _mask + 1;
+    }
+    // approximate value if other threads are pushing or popping
+    uint32_t size () const {
+        return _tail.load () - _head.load ();
+    }
+    bool is_empty () const {
+        return size () == 0;
+    }
+    void wakeup () {
+        SmartLock lock(_mutex);
+        _cond.broadcast ();
+    }
+    void pause_pop () {
+        _pop_paused = true;
+        wakeup ();
+    }
+    void resume_pop () {
+        _pop_paused = false;
+    }
+    inline void clear ();
+
+private:
+    inline bool enqueue (const ObjPtr &obj);
+    inline ObjPtr dequeue ();
+    inline void notify_waiters ();
+
+    XCAM_DEAD_COPY (SafeRing);
+
+private:
+    struct Cell {
+        std::atomic<uint32_t>   seq;
+        ObjPtr                  obj;
+    };
+
+    Cell                       *_cells;
+    uint32_t                    _mask;
+    std::atomic<uint32_t>       _head;
+    std::atomic<uint32_t>       _tail;
+    std::atomic<bool>           _pop_paused;
+    std::atomic<uint32_t>       _waiters;
+    Mutex                       _mutex;
+    XCam::Cond                  _cond;
+};
+
+template<class OBj>
+SafeRing<OBj>::SafeRing (uint32_t capacity)
+    : _cells (NULL)
+    , _mask (0)
+    , _head (0)
+    , _tail (0)
+    , _pop_paused (false)
+    , _waiters (0)
+{
+    uint32_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    _cells = new Cell[size];
+    _mask = size - 1;
+    for (uint32_t i = 0; i < size; ++i)
+        _cells[i].seq.store (i, std::memory_order_relaxed);
+}
+
+template<class OBj>
+SafeRing<OBj>::~SafeRing ()
+{
+    delete [] _cells;
+}
+
+template<class OBj>
+bool
+SafeRing<OBj>::enqueue (const SafeRing<OBj>::ObjPtr &obj)
+{
+    Cell *cell = NULL;
+    uint32_t pos = _tail.load (std::memory_order_relaxed);
+
+    while (true) {
+        cell = &_cells[pos & _mask];
+        uint32_t seq = cell->seq.load (std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (_tail.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false; // full
+        } else {
+            pos = _tail.load (std::memory_order_relaxed);
+        }
+    }
+
+    cell->obj = obj;
+    cell->seq.store (pos + 1, std::memory_order_release);
+    return true;
+}
+
+template<class OBj>
+typename SafeRing<OBj>::ObjPtr
+SafeRing<OBj>::dequeue ()
+{
+    Cell *cell = NULL;
+    uint32_t pos = _head.load (std::memory_order_relaxed);
+
+    while (true) {
+        cell = &_cells[pos & _mask];
+        uint32_t seq = cell->seq.load (std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (_head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return NULL; // empty
+        } else {
+            pos = _head.load (std::memory_order_relaxed);
+        }
+    }
+
+    SafeRing<OBj>::ObjPtr obj = cell->obj;
+    cell->obj.release ();
+    cell->seq.store (pos + _mask + 1, std::memory_order_release);
+    return obj;
+}
+
+template<class OBj>
+bool
+SafeRing<OBj>::try_push (const SafeRing<OBj>::ObjPtr &obj)
+{
+    if (!enqueue (obj))
+        return false;
+
+    notify_waiters ();
+    return true;
+}
+
+template<class OBj>
+typename SafeRing<OBj>::ObjPtr
+SafeRing<OBj>::try_pop ()
+{
+    SafeRing<OBj>::ObjPtr obj = dequeue ();
+    if (obj.ptr ())
+        notify_waiters ();
+    return obj;
+}
+
+template<class OBj>
+void
+SafeRing<OBj>::notify_waiters ()
+{
+    // pairs with the increment of _waiters before the re-check in pop/push
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (!_waiters.load (std::memory_order_relaxed))
+        return;
+
+    SmartLock lock (_mutex);
+    _cond.broadcast ();
+}
+
+template<class OBj>
+typename SafeRing<OBj>::ObjPtr
+SafeRing<OBj>::pop (int32_t timeout)
+{
+    if (_pop_paused)
+        return NULL;
+
+    SafeRing<OBj>::ObjPtr obj = try_pop ();
+    if (obj.ptr ())
+        return obj;
+
+    SmartLock lock (_mutex);
+    int code = 0;
+
+    ++_waiters;
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    while (!_pop_paused && !(obj = dequeue ()).ptr () && code == 0) {
+        if (timeout < 0)
+            code = _cond.wait(_mutex);
+        else
+            code = _cond.timedwait(_mutex, timeout);
+    }
+    --_waiters;
+
+    // _mutex is held, wake up blocked pushers directly
+    if (obj.ptr () && _waiters)
+        _cond.broadcast ();
+
+    if (obj.ptr () || _pop_paused)
+        return obj;
+
+    if (code == ETIMEDOUT) {
+        XCAM_LOG_DEBUG ("safe ring pop timeout");
+    } else {
+        XCAM_LOG_ERROR ("safe ring pop failed, code:%d", code);
+    }
+    return NULL;
+}
+
+template<class OBj>
+bool
+SafeRing<OBj>::push (const SafeRing<OBj>::ObjPtr &obj, int32_t timeout)
+{
+    if (try_push (obj))
+        return true;
+
+    SmartLock lock (_mutex);
+    int code = 0;
+    bool ret = false;
+
+    ++_waiters;
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    while (!_pop_paused && !(ret = enqueue (obj)) && code == 0) {
+        if (timeout < 0)
+            code = _cond.wait(_mutex);
+        else
+            code = _cond.timedwait(_mutex, timeout);
+    }
+    --_waiters;
+
+    // _mutex is held, wake up blocked poppers directly
+    if (ret && _waiters)
+        _cond.broadcast ();
+
+    if (!ret) {
+        XCAM_LOG_WARNING ("safe ring push failed since ring is full, code:%d", code);
+    }
+    return ret;
+}
+
+template<class OBj>
+void SafeRing<OBj>::clear ()
+{
+    while (try_pop ().ptr ());
+}
+
+};
+#endif //XCAM_SAFE_RING_H
@@ -0,0 +1,174 @@
+/*
+ * shared_table_cache.cpp - read only tables shared in process
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "shared_table_cache.h"
+
+namespace XCam {
+
+const uint64_t SharedTableCache::HashSeed;
+
+SharedTableRef::SharedTableRef ()
+    : _kind (SharedSoftLookupTable)
+    , _key (0)
+    , _held (false)
+{
+}
+
+SharedTableRef::~SharedTableRef ()
+{
+    release ();
+}
+
+void
+SharedTableRef::release ()
+{
+    if (_held)
+        SharedTableCache::instance ()->release (*this);
+}
+
+SharedTableCache::SharedTableCache ()
+    : _enabled (true)
+    , _bytes (0)
+{
+    const char *env = std::getenv ("XCAM_SHARED_TABLES");
+    if (env && !strcmp (env, "0")) {
+        _enabled = false;
+        XCAM_LOG_INFO ("shared tables are turned off");
+    }
+}
+
+SharedTableCache *
+SharedTableCache::instance ()
+{
+    // never destroyed, refs of static objects may be released after exit
+    static SharedTableCache *cache = new SharedTableCache;
+    return cache;
+}
+
+SharedTableCache::Holder *
+SharedTableCache::acquire (SharedTableKind kind, uint64_t key, SharedTableRef &ref)
+{
+    XCAM_ASSERT (!ref._held);
+
+    SmartLock locker (_mutex);
+    EntryMap::iterator iter = _entries.find (EntryKey (kind, key));
+    if (iter == _entries.end ())
+        return NULL;
+
+    Entry &entry = iter->second;
+    ++entry.users;
+    ref._kind = kind;
+    ref._key = key;
+    ref._held = true;
+    XCAM_LOG_DEBUG (
+        "shared table(kind:%d key:%" PRIx64 ") found, users:%d",
+        (int)kind, key, entry.users);
+    return entry.holder;
+}
+
+SharedTableCache::Holder *
+SharedTableCache::insert (
+    SharedTableKind kind, uint64_t key, Holder *holder, int64_t bytes, SharedTableRef &ref)
+{
+    XCAM_ASSERT (!ref._held);
+
+    SmartLock locker (_mutex);
+    EntryMap::iterator iter = _entries.find (EntryKey (kind, key));
+    if (iter == _entries.end ()) {
+        Entry entry;
+        entry.holder = holder;
+        entry.users = 0;
+        entry.bytes = bytes;
+        iter = _entries.insert (std::make_pair (EntryKey (kind, key), entry)).first;
+        _bytes += bytes;
+        XCAM_LOG_DEBUG (
+            "shared table(kind:%d key:%" PRIx64 ") added, %" PRId64 " bytes, %d tables %" PRId64 " bytes kept",
+            (int)kind, key, bytes, (int)_entries.size (), _bytes);
+    } else {
+        // built by another user meanwhile, the earlier one is kept
+        delete holder;
+    }
+
+    Entry &entry = iter->second;
+    ++entry.users;
+    ref._kind = kind;
+    ref._key = key;
+    ref._held = true;
+    return entry.holder;
+}
+
+void
+SharedTableCache::release (SharedTableRef &ref)
+{
+    XCAM_ASSERT (ref._held);
+    Holder *holder = NULL;
+
+    {
+        SmartLock locker (_mutex);
+        ref._held = false;
+
+        EntryMap::iterator iter = _entries.find (EntryKey (ref._kind, ref._key));
+        XCAM_ASSERT (iter != _entries.end ());
+        if (iter == _entries.end ())
+            return;
+
+        Entry &entry = iter->second;
+        XCAM_ASSERT (entry.users);
+        if (--entry.users)
+            return;
+
+        holder = entry.holder;
+        _bytes -= entry.bytes;
+        _entries.erase (iter);
+        XCAM_LOG_DEBUG (
+            "shared table(kind:%d key:%" PRIx64 ") dropped, %d tables %" PRId64 " bytes kept",
+            (int)ref._kind, ref._key, (int)_entries.size (), _bytes);
+    }
+
+    // tables may hold buffers releasing in their own way, out of the lock
+    delete holder;
+}
+
+uint32_t
+SharedTableCache::get_count () const
+{
+    SmartLock locker (_mutex);
+    return _entries.size ();
+}
+
+int64_t
+SharedTableCache::get_bytes () const
+{
+    SmartLock locker (_mutex);
+    return _bytes;
+}
+
+uint64_t
+SharedTableCache::hash (uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+}
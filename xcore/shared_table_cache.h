@@ -0,0 +1,173 @@
+/*
+ * shared_table_cache.h - read only tables shared in process
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SHARED_TABLE_CACHE_H
+#define XCAM_SHARED_TABLE_CACHE_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <map>
+
+namespace XCam {
+
+enum SharedTableKind {
+    SharedSoftLookupTable = 0,
+    // full resolution fixed point table expanded from a soft lookup table
+    SharedSoftFixedTable,
+    SharedGLLookupTable,
+    SharedTableKindCount,
+};
+
+class SharedTableCache;
+
+// one use of a shared table, released on destruction
+class SharedTableRef
+{
+    friend class SharedTableCache;
+
+public:
+    SharedTableRef ();
+    ~SharedTableRef ();
+
+    void release ();
+    bool is_held () const {
+        return _held;
+    }
+
+private:
+    XCAM_DEAD_COPY (SharedTableRef);
+
+private:
+    SharedTableKind    _kind;
+    uint64_t           _key;
+    bool               _held;
+};
+
+/*
+ * SharedTableCache, read only tables of the process, such as dewarp lookup tables, keyed by kind
+ * and a hash of everything a table is built from. instances with the same calibration and config
+ * hold one copy, a table is dropped with its last SharedTableRef.
+ * tables must never be changed once added. thread-safe.
+ * env XCAM_SHARED_TABLES=0 turns sharing off.
+ */
+class SharedTableCache
+{
+    friend class SharedTableRef;
+
+    class Holder {
+    public:
+        virtual ~Holder () {}
+    };
+
+    template <typename T>
+    class TypedHolder
+        : public Holder
+    {
+    public:
+        explicit TypedHolder (const SmartPtr<T> &t) : table (t) {}
+        SmartPtr<T>   table;
+    };
+
+    struct Entry {
+        Holder        *holder;
+        uint32_t       users;
+        int64_t        bytes;
+    };
+    typedef std::pair<SharedTableKind, uint64_t> EntryKey;
+    typedef std::map<EntryKey, Entry> EntryMap;
+
+public:
+    static SharedTableCache *instance ();
+
+    bool is_enabled () const {
+        return _enabled;
+    }
+
+    // table of @key held by @ref, NULL if not added yet
+    template <typename T>
+    SmartPtr<T> find (SharedTableKind kind, uint64_t key, SharedTableRef &ref);
+
+    // returns the table kept for @key and held by @ref, which is an earlier one if any
+    template <typename T>
+    SmartPtr<T> add (
+        SharedTableKind kind, uint64_t key, const SmartPtr<T> &table, int64_t bytes, SharedTableRef &ref);
+
+    uint32_t get_count () const;
+    // bytes of tables kept, each counted once
+    int64_t get_bytes () const;
+
+    // FNV-1a of @data continued from @hash
+    static uint64_t hash (uint64_t hash, const void *data, size_t size);
+    static const uint64_t HashSeed = 0xcbf29ce484222325ULL;
+
+private:
+    SharedTableCache ();
+
+    Holder *acquire (SharedTableKind kind, uint64_t key, SharedTableRef &ref);
+    Holder *insert (SharedTableKind kind, uint64_t key, Holder *holder, int64_t bytes, SharedTableRef &ref);
+    void release (SharedTableRef &ref);
+
+    XCAM_DEAD_COPY (SharedTableCache);
+
+private:
+    bool                 _enabled;
+    mutable Mutex        _mutex;
+    EntryMap             _entries;
+    int64_t              _bytes;
+};
+
+template <typename T>
+SmartPtr<T>
+SharedTableCache::find (SharedTableKind kind, uint64_t key, SharedTableRef &ref)
+{
+    ref.release ();
+    if (!_enabled || !key)
+        return NULL;
+
+    TypedHolder<T> *holder = dynamic_cast<TypedHolder<T> *> (acquire (kind, key, ref));
+    if (!holder) {
+        ref.release ();
+        return NULL;
+    }
+    return holder->table;
+}
+
+template <typename T>
+SmartPtr<T>
+SharedTableCache::add (
+    SharedTableKind kind, uint64_t key, const SmartPtr<T> &table, int64_t bytes, SharedTableRef &ref)
+{
+    XCAM_ASSERT (table.ptr ());
+    ref.release ();
+    if (!_enabled || !key)
+        return table;
+
+    Holder *kept = insert (kind, key, new TypedHolder<T> (table), bytes, ref);
+    TypedHolder<T> *holder = dynamic_cast<TypedHolder<T> *> (kept);
+    if (!holder) {
+        ref.release ();
+        return table;
+    }
+    return holder->table;
+}
+
+}
+
+#endif //XCAM_SHARED_TABLE_CACHE_H
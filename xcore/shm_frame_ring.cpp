@@ -0,0 +1,580 @@
+/*
+ * shm_frame_ring.cpp - shared memory ring of output frames
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "shm_frame_ring.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if HAVE_LINUX_UDMABUF_H
+#include <linux/udmabuf.h>
+#endif
+
+// "XRNG" in memory order
+#define SHM_RING_MAGIC 0x474e5258
+#define SHM_RING_VERSION 1
+// reference count of a slot the producer writes into
+#define SHM_SLOT_WRITER 0x80000000u
+#define SHM_SLOT_REFS_MASK 0xffffffffULL
+#define SHM_RING_CLAIM_WAIT 1000
+#define SHM_RING_ACQUIRE_TRIES 4
+
+namespace XCam {
+
+struct ShmRingSlot {
+    // (generation << 32) | references, generation is low 32 bits of seq of the frame in slot
+    std::atomic<uint64_t>   state;
+    uint64_t                offset;
+    uint64_t                size;
+    uint64_t                seq;
+    int64_t                 timestamp;
+    XCamVideoBufferInfo     info;
+};
+
+// first pages of the memfd, slots follow page aligned
+struct ShmRingHeader {
+    uint32_t                magic;
+    uint32_t                version;
+    std::atomic<uint32_t>   slot_count;
+    // bumped on each publish, futex of waiting consumers
+    std::atomic<uint32_t>   published;
+    // (seq << 8) | slot of the latest frame, 0 before first publish
+    std::atomic<uint64_t>   latest;
+    ShmRingSlot             slots[XCAM_SHM_RING_MAX_SLOTS];
+};
+
+struct ShmRingMemory {
+    int                 fd;
+    ShmRingHeader      *header;
+    size_t              header_size;
+    // producer only, -1 without udmabuf
+    int                 udmabuf_dev;
+
+    ShmRingMemory (int memfd, ShmRingHeader *ptr, size_t size)
+        : fd (memfd), header (ptr), header_size (size), udmabuf_dev (-1)
+    {}
+    ~ShmRingMemory () {
+        munmap (header, header_size);
+        ::close (fd);
+        if (udmabuf_dev >= 0)
+            ::close (udmabuf_dev);
+    }
+
+private:
+    XCAM_DEAD_COPY (ShmRingMemory);
+};
+
+static size_t
+get_ring_header_size ()
+{
+    return XCAM_ALIGN_UP (sizeof (ShmRingHeader), (size_t)sysconf (_SC_PAGESIZE));
+}
+
+static int
+create_udmabuf (const SmartPtr<ShmRingMemory> &memory, uint64_t offset, uint64_t size)
+{
+#if HAVE_LINUX_UDMABUF_H
+    if (memory->udmabuf_dev < 0)
+        return -1;
+
+    struct udmabuf_create create;
+    xcam_mem_clear (create);
+    create.memfd = memory->fd;
+    create.flags = UDMABUF_FLAGS_CLOEXEC;
+    create.offset = offset;
+    create.size = size;
+    int fd = ioctl (memory->udmabuf_dev, UDMABUF_CREATE, &create);
+    if (fd < 0) {
+        XCAM_LOG_WARNING ("ShmFrameRing create udmabuf failed, errno:%d, slot is not dma-buf", errno);
+    }
+    return fd;
+#else
+    XCAM_UNUSED (memory);
+    XCAM_UNUSED (offset);
+    XCAM_UNUSED (size);
+    return -1;
+#endif
+}
+
+class ShmSlotData
+    : public BufferData
+{
+public:
+    ShmSlotData (const SmartPtr<ShmRingMemory> &memory, uint32_t index, uint8_t *ptr, size_t size, int dma_fd)
+        : _memory (memory)
+        , _index (index)
+        , _ptr (ptr)
+        , _size (size)
+        , _dma_fd (dma_fd)
+    {}
+    virtual ~ShmSlotData () {
+        munmap (_ptr, _size);
+        if (_dma_fd >= 0)
+            ::close (_dma_fd);
+    }
+
+    const SmartPtr<ShmRingMemory> &get_memory () const {
+        return _memory;
+    }
+    uint32_t get_index () const {
+        return _index;
+    }
+
+    //derive from BufferData
+    virtual uint8_t *map () {
+        return _ptr;
+    }
+    virtual bool unmap () {
+        return true;
+    }
+    virtual int get_fd () {
+        return _dma_fd;
+    }
+
+private:
+    SmartPtr<ShmRingMemory>     _memory;
+    uint32_t                    _index;
+    uint8_t                    *_ptr;
+    size_t                      _size;
+    int                         _dma_fd;
+};
+
+class ShmRingBuffer
+    : public BufferProxy
+{
+public:
+    ShmRingBuffer (const VideoBufferInfo &info, const SmartPtr<BufferData> &data, ShmRingMemory *memory, uint32_t index)
+        : BufferProxy (info, data)
+        , _memory (memory)
+        , _index (index)
+    {}
+
+    const ShmRingMemory *get_memory () const {
+        return _memory;
+    }
+    uint32_t get_index () const {
+        return _index;
+    }
+
+private:
+    ShmRingMemory      *_memory;
+    uint32_t            _index;
+};
+
+ShmFrameRing::ShmFrameRing (const char *name)
+    : _name (strndup (name ? name : "xcam-frames", XCAM_MAX_STR_SIZE))
+    , _slot_count (0)
+    , _seq (0)
+{
+}
+
+ShmFrameRing::~ShmFrameRing ()
+{
+    xcam_free (_name);
+}
+
+int
+ShmFrameRing::get_fd () const
+{
+    return _memory.ptr () ? _memory->fd : -1;
+}
+
+XCamReturn
+ShmFrameRing::init_memory ()
+{
+    int fd = memfd_create (_name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0, XCAM_RETURN_ERROR_MEM,
+        "ShmFrameRing(%s) memfd_create failed, errno:%d", _name, errno);
+
+    size_t header_size = get_ring_header_size ();
+    void *ptr = MAP_FAILED;
+    if (ftruncate (fd, header_size) == 0)
+        ptr = mmap (NULL, header_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        XCAM_LOG_ERROR ("ShmFrameRing(%s) map ring header failed, errno:%d", _name, errno);
+        ::close (fd);
+        return XCAM_RETURN_ERROR_MEM;
+    }
+
+    memset (ptr, 0, header_size);
+    ShmRingHeader *header = (ShmRingHeader *)ptr;
+    header->magic = SHM_RING_MAGIC;
+    header->version = SHM_RING_VERSION;
+    _memory = new ShmRingMemory (fd, header, header_size);
+
+#if HAVE_LINUX_UDMABUF_H
+    // udmabuf needs the memfd never shrinks, growing for later slots is still allowed
+    int dev = open ("/dev/udmabuf", O_RDWR | O_CLOEXEC);
+    if (dev >= 0 && fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK) == 0)
+        _memory->udmabuf_dev = dev;
+    else if (dev >= 0)
+        ::close (dev);
+#endif
+
+    XCAM_LOG_DEBUG ("ShmFrameRing(%s) created, memfd:%d", _name, fd);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+SmartPtr<BufferData>
+ShmFrameRing::allocate_data (const VideoBufferInfo &buffer_info)
+{
+    if (!_memory.ptr () && !xcam_ret_is_ok (init_memory ()))
+        return NULL;
+
+    XCAM_FAIL_RETURN (
+        ERROR, _slot_count < XCAM_SHM_RING_MAX_SLOTS, NULL,
+        "ShmFrameRing(%s) allocate failed, slots are up to %d", _name, XCAM_SHM_RING_MAX_SLOTS);
+
+    ShmRingHeader *header = _memory->header;
+    uint64_t offset = _memory->header_size;
+    if (_slot_count)
+        offset = header->slots[_slot_count - 1].offset + header->slots[_slot_count - 1].size;
+    size_t size = XCAM_ALIGN_UP ((size_t)buffer_info.size, (size_t)sysconf (_SC_PAGESIZE));
+
+    void *ptr = MAP_FAILED;
+    if (ftruncate (_memory->fd, offset + size) == 0)
+        ptr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, _memory->fd, offset);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, NULL,
+        "ShmFrameRing(%s) map slot:%d failed, errno:%d", _name, _slot_count, errno);
+
+    uint32_t index = _slot_count++;
+    ShmRingSlot &slot = header->slots[index];
+    slot.offset = offset;
+    slot.size = size;
+    slot.state.store (0);
+    header->slot_count.store (_slot_count, std::memory_order_release);
+
+    int dma_fd = create_udmabuf (_memory, offset, size);
+    return new ShmSlotData (_memory, index, (uint8_t *)ptr, size, dma_fd);
+}
+
+// waits till consumers left the slot, reclaims it after XCAM_SHM_RING_RECLAIM_TIMEOUT
+static void
+claim_slot (ShmRingSlot &slot, uint32_t index)
+{
+    int64_t waited = 0;
+    uint64_t state = slot.state.load ();
+
+    while (true) {
+        uint32_t refs = (uint32_t)(state & SHM_SLOT_REFS_MASK);
+        uint64_t claimed = (state & ~SHM_SLOT_REFS_MASK) | SHM_SLOT_WRITER;
+        if (refs == 0 || refs == SHM_SLOT_WRITER) {
+            if (slot.state.compare_exchange_weak (state, claimed))
+                return;
+            continue;
+        }
+
+        if (waited >= XCAM_SHM_RING_RECLAIM_TIMEOUT) {
+            XCAM_LOG_WARNING (
+                "ShmFrameRing slot:%d held by %d consumers over %dms, reclaimed",
+                index, refs, XCAM_SHM_RING_RECLAIM_TIMEOUT / 1000);
+            slot.state.store (claimed);
+            return;
+        }
+        usleep (SHM_RING_CLAIM_WAIT);
+        waited += SHM_RING_CLAIM_WAIT;
+        state = slot.state.load ();
+    }
+}
+
+SmartPtr<BufferProxy>
+ShmFrameRing::create_buffer_from_data (SmartPtr<BufferData> &data)
+{
+    SmartPtr<ShmSlotData> slot_data = data.dynamic_cast_ptr<ShmSlotData> ();
+    XCAM_ASSERT (slot_data.ptr ());
+
+    uint32_t index = slot_data->get_index ();
+    claim_slot (_memory->header->slots[index], index);
+    return new ShmRingBuffer (get_video_info (), data, _memory.ptr (), index);
+}
+
+XCamReturn
+ShmFrameRing::publish (const SmartPtr<VideoBuffer> &buf)
+{
+    SmartPtr<ShmRingBuffer> ring_buf = buf.dynamic_cast_ptr<ShmRingBuffer> ();
+    XCAM_FAIL_RETURN (
+        ERROR, ring_buf.ptr () && _memory.ptr () && ring_buf->get_memory () == _memory.ptr (),
+        XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRing(%s) publish failed, buffer is not of this ring", _name);
+
+    ShmRingHeader *header = _memory->header;
+    uint32_t index = ring_buf->get_index ();
+    ShmRingSlot &slot = header->slots[index];
+    uint64_t state = slot.state.load (std::memory_order_relaxed);
+    XCAM_FAIL_RETURN (
+        ERROR, (state & SHM_SLOT_REFS_MASK) == SHM_SLOT_WRITER, XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRing(%s) publish failed, buffer of slot:%d published already", _name, index);
+
+    uint64_t seq = ++_seq;
+    slot.seq = seq;
+    slot.timestamp = buf->get_timestamp ();
+    slot.info = buf->get_video_info ();
+
+    // frame is readable once the generation is set, then it becomes the latest
+    slot.state.store ((uint64_t)(uint32_t)seq << 32, std::memory_order_release);
+    header->latest.store ((seq << 8) | index, std::memory_order_release);
+    header->published.fetch_add (1, std::memory_order_release);
+    syscall (SYS_futex, &header->published, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ShmFrameRing::send_fd (int socket) const
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _memory.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRing(%s) send fd failed, ring is not reserved", _name);
+
+    char byte = 0;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    char control[CMSG_SPACE (sizeof (int))];
+    xcam_mem_clear (control);
+    struct msghdr msg;
+    xcam_mem_clear (msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof (control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &_memory->fd, sizeof (int));
+
+    XCAM_FAIL_RETURN (
+        ERROR, sendmsg (socket, &msg, MSG_NOSIGNAL) == 1, XCAM_RETURN_ERROR_IOCTL,
+        "ShmFrameRing(%s) send fd failed, errno:%d", _name, errno);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+ShmFrameRingClient::ShmFrameRingClient ()
+{
+}
+
+ShmFrameRingClient::~ShmFrameRingClient ()
+{
+    detach ();
+}
+
+XCamReturn
+ShmFrameRingClient::attach (int fd)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, fd >= 0 && !_memory.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient attach failed, invalid fd or attached already");
+
+    size_t header_size = get_ring_header_size ();
+    struct stat st;
+    XCAM_FAIL_RETURN (
+        ERROR, fstat (fd, &st) == 0 && (size_t)st.st_size >= header_size, XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient attach failed, fd:%d is not a frame ring", fd);
+
+    int ring_fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+    XCAM_FAIL_RETURN (
+        ERROR, ring_fd >= 0, XCAM_RETURN_ERROR_FILE,
+        "ShmFrameRingClient attach failed, dup fd:%d errno:%d", fd, errno);
+
+    // header is writable for references, slots are mapped read-only
+    void *ptr = mmap (NULL, header_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    if (ptr == MAP_FAILED) {
+        XCAM_LOG_ERROR ("ShmFrameRingClient map ring header failed, errno:%d", errno);
+        ::close (ring_fd);
+        return XCAM_RETURN_ERROR_MEM;
+    }
+
+    SmartPtr<ShmRingMemory> memory = new ShmRingMemory (ring_fd, (ShmRingHeader *)ptr, header_size);
+    XCAM_FAIL_RETURN (
+        ERROR, memory->header->magic == SHM_RING_MAGIC && memory->header->version == SHM_RING_VERSION,
+        XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient attach failed, fd:%d is not a frame ring of version %d", fd, SHM_RING_VERSION);
+
+    _memory = memory;
+    _slot_ptrs.assign (XCAM_SHM_RING_MAX_SLOTS, NULL);
+    _slot_sizes.assign (XCAM_SHM_RING_MAX_SLOTS, 0);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ShmFrameRingClient::attach_socket (int socket)
+{
+    char byte = 0;
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+
+    char control[CMSG_SPACE (sizeof (int))];
+    xcam_mem_clear (control);
+    struct msghdr msg;
+    xcam_mem_clear (msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof (control);
+
+    XCAM_FAIL_RETURN (
+        ERROR, recvmsg (socket, &msg, MSG_CMSG_CLOEXEC) == 1, XCAM_RETURN_ERROR_IOCTL,
+        "ShmFrameRingClient receive fd failed, errno:%d", errno);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    XCAM_FAIL_RETURN (
+        ERROR, cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS,
+        XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient receive fd failed, no fd in message");
+
+    int fd = -1;
+    memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+    XCamReturn ret = attach (fd);
+    ::close (fd);
+    return ret;
+}
+
+void
+ShmFrameRingClient::detach ()
+{
+    for (uint32_t i = 0; i < _slot_ptrs.size (); ++i) {
+        if (_slot_ptrs[i])
+            munmap (_slot_ptrs[i], _slot_sizes[i]);
+    }
+    _slot_ptrs.clear ();
+    _slot_sizes.clear ();
+    _memory.release ();
+}
+
+const uint8_t *
+ShmFrameRingClient::map_slot (uint32_t slot)
+{
+    if (_slot_ptrs[slot])
+        return _slot_ptrs[slot];
+
+    const ShmRingSlot &desc = _memory->header->slots[slot];
+    void *ptr = mmap (NULL, desc.size, PROT_READ, MAP_SHARED, _memory->fd, desc.offset);
+    XCAM_FAIL_RETURN (
+        ERROR, ptr != MAP_FAILED, NULL,
+        "ShmFrameRingClient map slot:%d failed, errno:%d", slot, errno);
+
+    _slot_ptrs[slot] = (uint8_t *)ptr;
+    _slot_sizes[slot] = desc.size;
+    return _slot_ptrs[slot];
+}
+
+XCamReturn
+ShmFrameRingClient::acquire_latest (ShmRingFrame &frame, uint64_t after_seq)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _memory.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient acquire failed, not attached");
+
+    ShmRingHeader *header = _memory->header;
+    for (uint32_t i = 0; i < SHM_RING_ACQUIRE_TRIES; ++i) {
+        uint64_t latest = header->latest.load (std::memory_order_acquire);
+        uint64_t seq = latest >> 8;
+        uint32_t index = latest & 0xff;
+        if (!latest || seq <= after_seq)
+            return XCAM_RETURN_BYPASS;
+        if (index >= header->slot_count.load (std::memory_order_acquire))
+            return XCAM_RETURN_ERROR_UNKNOWN;
+
+        // takes a reference only if the slot still holds frame @seq
+        ShmRingSlot &slot = header->slots[index];
+        uint64_t state = slot.state.load (std::memory_order_acquire);
+        bool held = false;
+        while ((uint32_t)(state >> 32) == (uint32_t)seq && !(state & SHM_SLOT_WRITER)) {
+            if (slot.state.compare_exchange_weak (state, state + 1, std::memory_order_acquire)) {
+                held = true;
+                break;
+            }
+        }
+        if (!held)
+            continue;
+
+        frame.seq = seq;
+        frame.slot = index;
+        frame.timestamp = slot.timestamp;
+        *(XCamVideoBufferInfo *)&frame.info = slot.info;
+        frame.data = map_slot (index);
+        if (!frame.data) {
+            release (frame);
+            return XCAM_RETURN_ERROR_MEM;
+        }
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    return XCAM_RETURN_BYPASS;
+}
+
+bool
+ShmFrameRingClient::release (const ShmRingFrame &frame)
+{
+    XCAM_ASSERT (_memory.ptr () && frame.slot < XCAM_SHM_RING_MAX_SLOTS);
+
+    ShmRingSlot &slot = _memory->header->slots[frame.slot];
+    uint64_t state = slot.state.load (std::memory_order_relaxed);
+    while (true) {
+        uint32_t refs = (uint32_t)(state & SHM_SLOT_REFS_MASK);
+        if ((uint32_t)(state >> 32) != (uint32_t)frame.seq || !refs || (refs & SHM_SLOT_WRITER))
+            return false;
+        if (slot.state.compare_exchange_weak (state, state - 1, std::memory_order_release))
+            return true;
+    }
+}
+
+XCamReturn
+ShmFrameRingClient::wait_frame (uint64_t after_seq, uint32_t timeout_us)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _memory.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "ShmFrameRingClient wait failed, not attached");
+
+    ShmRingHeader *header = _memory->header;
+    struct timespec start;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    while (true) {
+        uint32_t published = header->published.load (std::memory_order_acquire);
+        if ((header->latest.load (std::memory_order_acquire) >> 8) > after_seq)
+            return XCAM_RETURN_NO_ERROR;
+
+        struct timespec now;
+        clock_gettime (CLOCK_MONOTONIC, &now);
+        int64_t waited = XCAM_TIMESPEC_2_USEC (now) - XCAM_TIMESPEC_2_USEC (start);
+        if (waited >= timeout_us)
+            return XCAM_RETURN_ERROR_TIMEOUT;
+
+        int64_t remain = timeout_us - waited;
+        struct timespec timeout;
+        timeout.tv_sec = remain / 1000000;
+        timeout.tv_nsec = (remain % 1000000) * 1000;
+        syscall (SYS_futex, &header->published, FUTEX_WAIT, published, &timeout, NULL, 0);
+    }
+}
+
+}
@@ -0,0 +1,128 @@
+/*
+ * shm_frame_ring.h - shared memory ring of output frames
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SHM_FRAME_RING_H
+#define XCAM_SHM_FRAME_RING_H
+
+#include <xcam_std.h>
+#include <buffer_pool.h>
+#include <vector>
+
+#define XCAM_SHM_RING_MAX_SLOTS 32
+// longest a consumer may hold a slot the producer waits for, the slot is reclaimed then
+#define XCAM_SHM_RING_RECLAIM_TIMEOUT 100000
+
+namespace XCam {
+
+struct ShmRingMemory;
+
+/*
+ * ShmFrameRing, buffer pool of frames in one memfd shared with other processes.
+ * consumers attach by ShmFrameRingClient and map slots read-only, nothing is copied.
+ * slot recycling is lock free, consumers count references in shared memory and the producer
+ * only writes into a slot none of them holds; a consumer holding a slot longer than
+ * XCAM_SHM_RING_RECLAIM_TIMEOUT loses it, release tells if it was reclaimed.
+ * slots are page aligned, e.g. shared into CL by CL_MEM_USE_HOST_PTR, and also dma-buf
+ * through /dev/udmabuf if present, get_fd of buffers returns it.
+ * used as output pool of handlers, e.g. CLPostImageProcessor::set_output_pool,
+ * or as output buffers given to Stitcher::stitch_buffers.
+ */
+class ShmFrameRing
+    : public BufferPool
+{
+public:
+    explicit ShmFrameRing (const char *name = "xcam-frames");
+    virtual ~ShmFrameRing ();
+
+    // memfd of the ring, valid after reserve
+    int get_fd () const;
+    // passes the ring to a consumer over unix domain @socket
+    XCamReturn send_fd (int socket) const;
+
+    // written @buf of this ring becomes the latest frame, the buffer may be dropped after
+    XCamReturn publish (const SmartPtr<VideoBuffer> &buf);
+    uint64_t get_published_count () const {
+        return _seq;
+    }
+
+protected:
+    virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
+    virtual SmartPtr<BufferProxy> create_buffer_from_data (SmartPtr<BufferData> &data);
+
+private:
+    XCamReturn init_memory ();
+
+    XCAM_DEAD_COPY (ShmFrameRing);
+
+private:
+    char                       *_name;
+    SmartPtr<ShmRingMemory>     _memory;
+    uint32_t                    _slot_count;
+    uint64_t                    _seq;
+};
+
+// frame held by a consumer, data is read-only
+struct ShmRingFrame {
+    uint64_t            seq;
+    uint32_t            slot;
+    int64_t             timestamp;
+    VideoBufferInfo     info;
+    const uint8_t      *data;
+
+    ShmRingFrame () : seq (0), slot (0), timestamp (0), data (NULL) {}
+};
+
+/*
+ * ShmFrameRingClient, consumer side of ShmFrameRing in another process.
+ * frames are taken newest first, a slow consumer skips frames instead of stalling the producer.
+ */
+class ShmFrameRingClient
+{
+public:
+    ShmFrameRingClient ();
+    ~ShmFrameRingClient ();
+
+    // @fd of ShmFrameRing::get_fd, inherited or from /proc/<pid>/fd, duplicated
+    XCamReturn attach (int fd);
+    // receives the ring sent by ShmFrameRing::send_fd
+    XCamReturn attach_socket (int socket);
+    void detach ();
+
+    // newest frame published after @after_seq, BYPASS if none, each acquired frame need be released
+    XCamReturn acquire_latest (ShmRingFrame &frame, uint64_t after_seq = 0);
+    // false if the slot was reclaimed while held, data read from it may be torn
+    bool release (const ShmRingFrame &frame);
+    // waits for a frame published after @after_seq, TIMEOUT if none
+    XCamReturn wait_frame (uint64_t after_seq, uint32_t timeout_us);
+
+private:
+    const uint8_t *map_slot (uint32_t slot);
+
+    XCAM_DEAD_COPY (ShmFrameRingClient);
+
+private:
+    SmartPtr<ShmRingMemory>     _memory;
+    std::vector<uint8_t *>      _slot_ptrs;
+    std::vector<size_t>         _slot_sizes;
+};
+
+}
+
+#endif //XCAM_SHM_FRAME_RING_H
@@ -0,0 +1,99 @@
+/*
+ * small_vector.h - vector with first entries stored inline
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_SMALL_VECTOR_H
+#define XCAM_SMALL_VECTOR_H
+
+#include <xcam_std.h>
+#include <vector>
+
+namespace XCam {
+
+// one address per type, compared instead of dynamic_cast in typed lookups
+template <typename T>
+inline const void *xcam_type_tag ()
+{
+    static const char tag = 0;
+    return &tag;
+}
+
+/*
+ * SmallVector, first N entries live in the object, more spill to heap.
+ * erase keeps order, freed inline slots are reset to T ().
+ */
+template <typename T, uint32_t N>
+class SmallVector
+{
+public:
+    SmallVector () : _size (0) {}
+
+    uint32_t size () const {
+        return _size;
+    }
+    bool empty () const {
+        return _size == 0;
+    }
+
+    T &operator [] (uint32_t i) {
+        XCAM_ASSERT (i < _size);
+        return i < N ? _inline[i] : _spill[i - N];
+    }
+    const T &operator [] (uint32_t i) const {
+        XCAM_ASSERT (i < _size);
+        return i < N ? _inline[i] : _spill[i - N];
+    }
+
+    void push_back (const T &value) {
+        if (_size < N)
+            _inline[_size] = value;
+        else
+            _spill.push_back (value);
+        ++_size;
+    }
+    void pop_back () {
+        XCAM_ASSERT (_size);
+        --_size;
+        if (_size >= N)
+            _spill.pop_back ();
+        else
+            _inline[_size] = T ();
+    }
+    void erase (uint32_t i) {
+        XCAM_ASSERT (i < _size);
+        for (; i + 1 < _size; ++i)
+            (*this)[i] = (*this)[i + 1];
+        pop_back ();
+    }
+    void clear () {
+        for (uint32_t i = 0; i < _size && i < N; ++i)
+            _inline[i] = T ();
+        _spill.clear ();
+        _size = 0;
+    }
+
+private:
+    T                 _inline[N];
+    std::vector<T>    _spill;
+    uint32_t          _size;
+};
+
+}
+
+#endif //XCAM_SMALL_VECTOR_H
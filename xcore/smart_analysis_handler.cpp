@@ -23,9 +23,39 @@
 #include "smart_analyzer_loader.h"
 #include "smart_analyzer.h"
 #include "video_buffer.h"
+#include "xcam_thread.h"
+
+// EMA weight of latency average is 1 / 2^shift
+#define XCAM_SMART_LATENCY_AVG_SHIFT 4
 
 namespace XCam {
 
+class SmartHandlerThread
+    : public Thread
+{
+public:
+    explicit SmartHandlerThread (SmartAnalysisHandler *handler)
+        : Thread (handler->get_name ())
+        , _handler (handler)
+    {}
+
+protected:
+    virtual bool loop () {
+        return _handler->process_pending ();
+    }
+
+private:
+    SmartAnalysisHandler   *_handler;
+};
+
+static int64_t
+get_smart_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
 SmartAnalysisHandler::SmartHandlerMap SmartAnalysisHandler::_handler_map;
 Mutex SmartAnalysisHandler::_handler_map_lock;
 
@@ -36,6 +66,11 @@ SmartAnalysisHandler::SmartAnalysisHandler (XCamSmartAnalysisDescription *desc,
     , _name (NULL)
     , _context (NULL)
     , _async_mode (false)
+    , _async (false)
+    , _max_fps (0.0)
+    , _pending_time (0)
+    , _last_accepted (InvalidTimestamp)
+    , _worker_stopping (false)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -43,6 +78,7 @@ SmartAnalysisHandler::SmartAnalysisHandler (XCamSmartAnalysisDescription *desc,
 
 SmartAnalysisHandler::~SmartAnalysisHandler ()
 {
+    stop_worker ();
     if (is_valid ())
         destroy_context ();
 
@@ -58,6 +94,16 @@ SmartAnalysisHandler::create_context (SmartPtr<SmartAnalysisHandler> &self)
     uint32_t async_mode = 0;
     XCAM_ASSERT (!_context);
     XCAM_ASSERT (self.ptr () == this);
+
+    // deferred handlers open the lib on first use
+    if (!_desc) {
+        XCAM_ASSERT (_loader.ptr ());
+        _desc = _loader->load_description ();
+        XCAM_FAIL_RETURN (
+            WARNING, _desc, XCAM_RETURN_ERROR_UNKNOWN,
+            "smart handler(%s) load lib failed", XCAM_STR(get_name()));
+    }
+
     if ((ret = _desc->create_context (&context, &async_mode, NULL)) != XCAM_RETURN_NO_ERROR) {
         XCAM_LOG_WARNING ("smart handler(%s) lib create context failed", XCAM_STR(get_name()));
         return ret;
@@ -79,6 +125,7 @@ SmartAnalysisHandler::create_context (SmartPtr<SmartAnalysisHandler> &self)
 void
 SmartAnalysisHandler::destroy_context ()
 {
+    SmartLock context_locker (_context_mutex);
     XCamSmartAnalysisContext *context;
     {
         SmartLock locker (_handler_map_lock);
@@ -139,7 +186,10 @@ SmartAnalysisHandler::update_params (XCamSmartAnalysisParam &params)
 {
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
-    XCAM_ASSERT (_context);
+    SmartLock locker (_context_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, _context, XCAM_RETURN_ERROR_ORDER,
+        "smart handler(%s) update parameters failed, no context", XCAM_STR(get_name()));
     ret = _desc->update_params (_context, &params);
     XCAM_FAIL_RETURN (WARNING,
                       ret == XCAM_RETURN_NO_ERROR,
@@ -154,12 +204,18 @@ SmartAnalysisHandler::analyze (const SmartPtr<VideoBuffer> &buffer, X3aResultLis
 {
     XCAM_LOG_DEBUG ("smart handler(%s) analyze", XCAM_STR(get_name()));
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
-    XCamVideoBuffer *video_buffer = convert_to_external_buffer (buffer);
     XCam3aResultHead *res_array[XCAM_3A_MAX_RESULT_COUNT];
     uint32_t res_count = XCAM_3A_MAX_RESULT_COUNT;
+    int64_t start = get_smart_time ();
 
     XCAM_ASSERT (buffer.ptr ());
-    XCAM_ASSERT (_context);
+    // worker thread analyzes while other threads update params or destroy context
+    SmartLock locker (_context_mutex);
+    XCAM_FAIL_RETURN (
+        WARNING, _context, XCAM_RETURN_ERROR_ORDER,
+        "smart handler(%s) analyze failed, no context", XCAM_STR(get_name()));
+
+    XCamVideoBuffer *video_buffer = convert_to_external_buffer (buffer);
     XCAM_ASSERT (video_buffer);
     xcam_mem_clear (res_array);
 
@@ -180,9 +236,133 @@ SmartAnalysisHandler::analyze (const SmartPtr<VideoBuffer> &buffer, X3aResultLis
         _desc->free_results (_context, res_array, res_count);
     }
 
+    // async latency counts from queued in process_pending
+    if (!_async)
+        update_stats (get_smart_time () - start, buffer->get_timestamp ());
+
     return ret;
 }
 
+XCamReturn
+SmartAnalysisHandler::start_worker ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _async && is_valid () && !_worker.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "smart handler(%s) start worker failed, %s", XCAM_STR(get_name()),
+        (!_async ? "not async" : (_worker.ptr () ? "already started" : "no context")));
+
+    {
+        SmartLock locker (_worker_mutex);
+        _worker_stopping = false;
+        _last_accepted = InvalidTimestamp;
+    }
+
+    _worker = new SmartHandlerThread (this);
+    if (!_worker->start ()) {
+        _worker.release ();
+        XCAM_LOG_ERROR ("smart handler(%s) start worker thread failed", XCAM_STR(get_name()));
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    XCAM_LOG_INFO ("smart handler(%s) runs async, max fps:%.2f", XCAM_STR(get_name()), _max_fps);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SmartAnalysisHandler::stop_worker ()
+{
+    if (!_worker.ptr ())
+        return;
+
+    {
+        SmartLock locker (_worker_mutex);
+        _worker_stopping = true;
+        _pending.release ();
+        _worker_cond.broadcast ();
+    }
+    _worker->stop ();
+    _worker.release ();
+}
+
+XCamReturn
+SmartAnalysisHandler::queue_buffer (const SmartPtr<VideoBuffer> &buffer)
+{
+    XCAM_ASSERT (buffer.ptr ());
+    XCAM_FAIL_RETURN (
+        WARNING, _worker.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "smart handler(%s) queue buffer failed, worker not started", XCAM_STR(get_name()));
+
+    int64_t ts = buffer->get_timestamp ();
+    SmartLock locker (_worker_mutex);
+    if (_max_fps > 0.0 && _last_accepted != InvalidTimestamp &&
+            ts > _last_accepted && ts - _last_accepted < (int64_t)(XCAM_SECONDS_2_TIMESTAMP (1) / _max_fps)) {
+        ++_stats.skipped;
+        return XCAM_RETURN_BYPASS;
+    }
+
+    // a slow plugin only sees the newest frame, older ones are dropped
+    if (_pending.ptr ())
+        ++_stats.dropped;
+    _pending = buffer;
+    _pending_time = get_smart_time ();
+    _last_accepted = ts;
+    _worker_cond.signal ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
+bool
+SmartAnalysisHandler::process_pending ()
+{
+    SmartPtr<VideoBuffer> buffer;
+    int64_t queued = 0;
+    {
+        SmartLock locker (_worker_mutex);
+        while (!_pending.ptr () && !_worker_stopping)
+            _worker_cond.wait (_worker_mutex);
+        if (_worker_stopping)
+            return false;
+
+        buffer = _pending;
+        queued = _pending_time;
+        _pending.release ();
+    }
+
+    X3aResultList results;
+    XCamReturn ret = analyze (buffer, results);
+    if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_BYPASS) {
+        XCAM_LOG_WARNING ("smart handler(%s) async analyze failed, stop it", XCAM_STR(get_name()));
+        destroy_context ();
+        return false;
+    }
+
+    update_stats (get_smart_time () - queued, buffer->get_timestamp ());
+    if (!results.empty () && _analyzer)
+        _analyzer->post_smart_results (results, buffer->get_timestamp ());
+
+    return true;
+}
+
+void
+SmartAnalysisHandler::update_stats (int64_t latency, int64_t timestamp)
+{
+    SmartLock locker (_worker_mutex);
+    if (_stats.analyzed == 0)
+        _stats.avg_latency = latency;
+    else
+        _stats.avg_latency += (latency - _stats.avg_latency) >> XCAM_SMART_LATENCY_AVG_SHIFT;
+    ++_stats.analyzed;
+    _stats.last_latency = latency;
+    _stats.max_latency = XCAM_MAX (_stats.max_latency, latency);
+    _stats.last_timestamp = timestamp;
+}
+
+SmartHandlerStats
+SmartAnalysisHandler::get_stats ()
+{
+    SmartLock locker (_worker_mutex);
+    return _stats;
+}
+
 XCamReturn
 SmartAnalysisHandler::convert_results (XCam3aResultHead *from[], uint32_t from_count, X3aResultList &to)
 {
@@ -22,6 +22,7 @@
 #define XCAM_SMART_ANALYSIS_HANDLER_H
 
 #include <xcam_std.h>
+#include <xcam_mutex.h>
 #include <base/xcam_smart_description.h>
 #include <map>
 #include <x3a_result_factory.h>
@@ -32,14 +33,34 @@ class VideoBuffer;
 class SmartAnalysisHandler;
 class SmartAnalyzerLoader;
 class SmartAnalyzer;
+class SmartHandlerThread;
 
 typedef std::list<SmartPtr<SmartAnalysisHandler>> SmartHandlerList;
 
+// latencies in microseconds, from frame queued (or analyze called) to results ready
+struct SmartHandlerStats {
+    uint64_t    analyzed;
+    uint64_t    dropped;          // replaced by a newer frame before analyzed
+    uint64_t    skipped;          // over target rate
+    int64_t     last_latency;
+    int64_t     avg_latency;
+    int64_t     max_latency;
+    int64_t     last_timestamp;   // frame timestamp of last analysis
+
+    SmartHandlerStats ()
+        : analyzed (0), dropped (0), skipped (0)
+        , last_latency (0), avg_latency (0), max_latency (0)
+        , last_timestamp (InvalidTimestamp)
+    {}
+};
+
 class SmartAnalysisHandler
 {
+    friend class SmartHandlerThread;
     typedef std::map<XCamSmartAnalysisContext*, SmartPtr<SmartAnalysisHandler>> SmartHandlerMap;
 
 public:
+    // @desc NULL defers loading the lib of @loader to create_context
     SmartAnalysisHandler (XCamSmartAnalysisDescription *desc, SmartPtr<SmartAnalyzerLoader> &loader, const char *name = "SmartHandler");
     ~SmartAnalysisHandler ();
     void set_analyzer (SmartAnalyzer *analyzer) {
@@ -57,12 +78,33 @@ public:
     const char * get_name () const {
         return _name;
     }
+    // name given by the lib, NULL until the lib is loaded
+    const char * get_analysis_name () const {
+        return _desc ? _desc->name : NULL;
+    }
+    // 0 until the lib is loaded
     uint32_t get_priority () const {
         if (_desc)
             return _desc->priority;
         return 0;
     }
 
+    // async handlers analyze on own thread, newest queued frame wins;
+    // max_fps limits frames accepted by timestamp, 0 means no limit. set before start_worker
+    void set_async (bool enable, double max_fps = 0.0) {
+        _async = enable;
+        _max_fps = max_fps;
+    }
+    bool is_async () const {
+        return _async;
+    }
+    XCamReturn start_worker ();
+    void stop_worker ();
+    // XCAM_RETURN_BYPASS if skipped by target rate
+    XCamReturn queue_buffer (const SmartPtr<VideoBuffer> &buffer);
+
+    SmartHandlerStats get_stats ();
+
 protected:
     XCamReturn post_smart_results (const XCamVideoBuffer *buffer, XCam3aResultHead *results[], uint32_t res_count);
     static XCamReturn post_aync_results (
@@ -72,6 +114,8 @@ protected:
 
 private:
     XCamReturn convert_results (XCam3aResultHead *from[], uint32_t from_count, X3aResultList &to);
+    bool process_pending ();
+    void update_stats (int64_t latency, int64_t timestamp);
     XCAM_DEAD_COPY (SmartAnalysisHandler);
 
 //
@@ -86,6 +130,18 @@ private:
     char                           *_name;
     XCamSmartAnalysisContext       *_context;
     bool                            _async_mode;
+    Mutex                           _context_mutex;
+
+    bool                            _async;
+    double                          _max_fps;
+    SmartPtr<SmartHandlerThread>    _worker;
+    Mutex                           _worker_mutex;
+    Cond                            _worker_cond;
+    SmartPtr<VideoBuffer>           _pending;
+    int64_t                         _pending_time;
+    int64_t                         _last_accepted;
+    bool                            _worker_stopping;
+    SmartHandlerStats               _stats;
 };
 
 }
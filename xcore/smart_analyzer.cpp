@@ -21,11 +21,37 @@
 #include "smart_analyzer_loader.h"
 #include "smart_analyzer.h"
 #include "smart_analysis_handler.h"
+#include "thread_pool.h"
 
 #include "xcam_obj_debug.h"
 
+// plugin libs opened and contexts created at the same time
+#define XCAM_SMART_INIT_THREADS 4
+
 namespace XCam {
 
+class SmartHandlerInit
+    : public ThreadPool::UserData
+{
+public:
+    SmartHandlerInit (SmartAnalyzer *analyzer, const SmartPtr<SmartAnalysisHandler> &handler)
+        : _analyzer (analyzer)
+        , _handler (handler)
+    {}
+
+    virtual XCamReturn run () {
+        return _analyzer->init_handler (_handler);
+    }
+    virtual void done (XCamReturn err) {
+        if (xcam_ret_is_ok (err))
+            _analyzer->handler_ready (_handler);
+    }
+
+private:
+    SmartAnalyzer                   *_analyzer;
+    SmartPtr<SmartAnalysisHandler>   _handler;
+};
+
 SmartAnalyzer::SmartAnalyzer (const char *name)
     : XAnalyzer (name)
 {
@@ -34,6 +60,7 @@ SmartAnalyzer::SmartAnalyzer (const char *name)
 
 SmartAnalyzer::~SmartAnalyzer ()
 {
+    stop_init_threads ();
 }
 
 XCamReturn
@@ -72,26 +99,102 @@ SmartAnalyzer::internal_init (uint32_t width, uint32_t height, double framerate)
     XCAM_UNUSED (width);
     XCAM_UNUSED (height);
     XCAM_UNUSED (framerate);
+
+    uint32_t threads = XCAM_MIN ((uint32_t)_handlers.size (), (uint32_t)XCAM_SMART_INIT_THREADS);
+    if (threads > 1) {
+        SmartPtr<ThreadPool> pool = new ThreadPool ("SmartInit");
+        pool->set_threads (threads, threads);
+        if (xcam_ret_is_ok (pool->start ()))
+            _init_pool = pool;
+        else
+            XCAM_LOG_WARNING ("smart analyzer start init threads failed, init handlers one by one");
+    }
+
     SmartHandlerList::iterator i_handler = _handlers.begin ();
     for (; i_handler != _handlers.end ();  ++i_handler)
     {
         SmartPtr<SmartAnalysisHandler> handler = *i_handler;
-        XCamReturn ret = handler->create_context (handler);
-        if (ret != XCAM_RETURN_NO_ERROR) {
-            XCAM_LOG_WARNING ("smart analyzer initialize handler(%s) context failed", XCAM_STR(handler->get_name()));
-        }
+        if (_init_pool.ptr () &&
+                xcam_ret_is_ok (_init_pool->queue (new SmartHandlerInit (this, handler))))
+            continue;
+
+        if (xcam_ret_is_ok (init_handler (handler)))
+            handler_ready (handler);
     }
 
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+SmartAnalyzer::init_handler (const SmartPtr<SmartAnalysisHandler> &handler)
+{
+    SmartPtr<SmartAnalysisHandler> self = handler;
+    XCamReturn ret = self->create_context (self);
+    if (ret != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("smart analyzer initialize handler(%s) context failed", XCAM_STR(handler->get_name()));
+        return ret;
+    }
+    if (handler->is_async () && (ret = handler->start_worker ()) != XCAM_RETURN_NO_ERROR) {
+        XCAM_LOG_WARNING ("smart analyzer start handler(%s) worker failed", XCAM_STR(handler->get_name()));
+        handler->destroy_context ();
+        return ret;
+    }
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+SmartAnalyzer::handler_ready (const SmartPtr<SmartAnalysisHandler> &handler)
+{
+    SmartLock locker (_ready_mutex);
+    _ready_handlers.push_back (handler);
+}
+
+void
+SmartAnalyzer::collect_ready_handlers ()
+{
+    SmartHandlerList ready;
+    {
+        SmartLock locker (_ready_mutex);
+        if (_ready_handlers.empty ())
+            return;
+        ready.swap (_ready_handlers);
+    }
+
+    for (SmartHandlerList::iterator i_ready = ready.begin (); i_ready != ready.end (); ++i_ready) {
+        SmartHandlerList::iterator i_pos = _active_handlers.begin ();
+        for (; i_pos != _active_handlers.end (); ++i_pos) {
+            if ((*i_ready)->get_priority () < (*i_pos)->get_priority ())
+                break;
+        }
+        _active_handlers.insert (i_pos, *i_ready);
+        XCAM_LOG_DEBUG ("smart analyzer handler(%s) ready", XCAM_STR ((*i_ready)->get_name ()));
+    }
+}
+
+void
+SmartAnalyzer::stop_init_threads ()
+{
+    // waits inits running, queued ones are dropped
+    if (_init_pool.ptr ())
+        _init_pool->stop ();
+    _init_pool.release ();
+}
+
 XCamReturn
 SmartAnalyzer::internal_deinit ()
 {
+    stop_init_threads ();
+    {
+        SmartLock locker (_ready_mutex);
+        _ready_handlers.clear ();
+    }
+    _active_handlers.clear ();
+
     SmartHandlerList::iterator i_handler = _handlers.begin ();
     for (; i_handler != _handlers.end ();  ++i_handler)
     {
         SmartPtr<SmartAnalysisHandler> handler = *i_handler;
+        handler->stop_worker ();
         if (handler->is_valid ())
             handler->destroy_context ();
     }
@@ -142,13 +245,20 @@ SmartAnalyzer::analyze (const SmartPtr<VideoBuffer> &buffer)
         return XCAM_RETURN_ERROR_PARAM;
     }
 
-    SmartHandlerList::iterator i_handler = _handlers.begin ();
-    for (; i_handler != _handlers.end ();  ++i_handler)
+    collect_ready_handlers ();
+
+    SmartHandlerList::iterator i_handler = _active_handlers.begin ();
+    for (; i_handler != _active_handlers.end ();  ++i_handler)
     {
         SmartPtr<SmartAnalysisHandler> handler = *i_handler;
         if (!handler->is_valid ())
             continue;
 
+        if (handler->is_async ()) {
+            handler->queue_buffer (buffer);
+            continue;
+        }
+
         ret = handler->analyze (buffer, results);
         if (ret != XCAM_RETURN_NO_ERROR && ret != XCAM_RETURN_BYPASS) {
             XCAM_LOG_WARNING ("smart analyzer analyze handler(%s) context failed", XCAM_STR(handler->get_name()));
@@ -166,6 +276,59 @@ SmartAnalyzer::analyze (const SmartPtr<VideoBuffer> &buffer)
     return XCAM_RETURN_NO_ERROR;
 }
 
+SmartPtr<SmartAnalysisHandler>
+SmartAnalyzer::find_handler (const char *name)
+{
+    SmartHandlerList::iterator i_handler = _handlers.begin ();
+    for (; i_handler != _handlers.end ();  ++i_handler)
+    {
+        const char *handler_name = (*i_handler)->get_name ();
+        if (handler_name && strcmp (handler_name, name) == 0)
+            return *i_handler;
+
+        handler_name = (*i_handler)->get_analysis_name ();
+        if (handler_name && strcmp (handler_name, name) == 0)
+            return *i_handler;
+    }
+    return NULL;
+}
+
+XCamReturn
+SmartAnalyzer::set_handler_async (const char *name, bool enable, double max_fps)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, max_fps >= 0.0, XCAM_RETURN_ERROR_PARAM,
+        "smart analyzer set handler async failed, max fps(%.2f) invalid", max_fps);
+
+    if (!name) {
+        SmartHandlerList::iterator i_handler = _handlers.begin ();
+        for (; i_handler != _handlers.end ();  ++i_handler)
+            (*i_handler)->set_async (enable, max_fps);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    SmartPtr<SmartAnalysisHandler> handler = find_handler (name);
+    XCAM_FAIL_RETURN (
+        ERROR, handler.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "smart analyzer set handler async failed, handler(%s) not found", name);
+
+    handler->set_async (enable, max_fps);
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+SmartAnalyzer::get_handler_stats (const char *name, SmartHandlerStats &stats)
+{
+    XCAM_ASSERT (name);
+    SmartPtr<SmartAnalysisHandler> handler = find_handler (name);
+    XCAM_FAIL_RETURN (
+        WARNING, handler.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "smart analyzer get handler stats failed, handler(%s) not found", name);
+
+    stats = handler->get_stats ();
+    return XCAM_RETURN_NO_ERROR;
+}
+
 void
 SmartAnalyzer::post_smart_results (X3aResultList &results, int64_t timestamp)
 {
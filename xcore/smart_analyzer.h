@@ -28,10 +28,18 @@
 namespace XCam {
 
 class VideoBuffer;
+class ThreadPool;
+class SmartHandlerInit;
 
+/*
+ * SmartAnalyzer, handler contexts are created in parallel on init without blocking it,
+ * frames are analyzed by handlers ready so far, in priority order.
+ */
 class SmartAnalyzer
     : public XAnalyzer
 {
+    friend class SmartHandlerInit;
+
 public:
     SmartAnalyzer (const char *name = "SmartAnalyzer");
     ~SmartAnalyzer ();
@@ -40,6 +48,11 @@ public:
     XCamReturn update_params (XCamSmartAnalysisParam &params);
     void post_smart_results (X3aResultList &results, int64_t timestamp);
 
+    // name NULL applies to all handlers, set before init.
+    // handlers are named by lib file, names given by libs are also matched once loaded
+    XCamReturn set_handler_async (const char *name, bool enable, double max_fps = 0.0);
+    XCamReturn get_handler_stats (const char *name, SmartHandlerStats &stats);
+
 protected:
     virtual XCamReturn create_handlers ();
     virtual XCamReturn release_handlers ();
@@ -49,12 +62,25 @@ protected:
     virtual XCamReturn analyze (const SmartPtr<VideoBuffer> &buffer);
 
 private:
+    SmartPtr<SmartAnalysisHandler> find_handler (const char *name);
+    XCamReturn init_handler (const SmartPtr<SmartAnalysisHandler> &handler);
+    void handler_ready (const SmartPtr<SmartAnalysisHandler> &handler);
+    void collect_ready_handlers ();
+    void stop_init_threads ();
+
     XCAM_DEAD_COPY (SmartAnalyzer);
 
 private:
     SmartHandlerList   _handlers;
     X3aResultList      _results;
 
+    SmartPtr<ThreadPool>    _init_pool;
+    // handlers initialized but not picked up by analyze yet
+    SmartHandlerList        _ready_handlers;
+    Mutex                   _ready_mutex;
+    // handlers analyzing frames, only touched by analyze thread after init
+    SmartHandlerList        _active_handlers;
+
     XCAM_OBJ_PROFILING_DEFINES;
 
 };
@@ -31,6 +31,7 @@ namespace XCam {
 SmartAnalyzerLoader::SmartAnalyzerLoader (const char *lib_path, const char *name, const char *symbol)
     : AnalyzerLoader (lib_path, symbol)
     , _name (NULL)
+    , _desc (NULL)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -43,7 +44,6 @@ SmartAnalyzerLoader::~SmartAnalyzerLoader ()
 }
 
 SmartHandlerList
-
 SmartAnalyzerLoader::load_smart_handlers (const char *dir_path)
 {
     SmartHandlerList ret_handers;
@@ -51,17 +51,10 @@ SmartAnalyzerLoader::load_smart_handlers (const char *dir_path)
     for (AnalyzerLoaderList::iterator i_loader = loaders.begin ();
             i_loader != loaders.end (); ++i_loader)
     {
-        SmartPtr<SmartAnalysisHandler> handler = (*i_loader)->load_smart_handler(*i_loader);
-        if (!handler.ptr ())
-            continue;
-
-        SmartHandlerList::iterator i_pos = ret_handers.begin ();
-        for (; i_pos != ret_handers.end (); ++i_pos)
-        {
-            if (handler->get_priority() < (*i_pos)->get_priority ())
-                break;
-        }
-        ret_handers.insert (i_pos, handler);
+        // priority is unknown until the lib is opened, SmartAnalyzer orders handlers when ready
+        SmartPtr<SmartAnalysisHandler> handler = new SmartAnalysisHandler (NULL, *i_loader, (*i_loader)->_name);
+        XCAM_LOG_DEBUG ("smart handler(%s) deferred from lib", XCAM_STR (handler->get_name ()));
+        ret_handers.push_back (handler);
     }
     return ret_handers;
 }
@@ -96,27 +89,23 @@ SmartAnalyzerLoader::create_analyzer_loader (const char *dir_path)
     return loader_list;
 }
 
-SmartPtr<SmartAnalysisHandler>
-SmartAnalyzerLoader::load_smart_handler (SmartPtr<SmartAnalyzerLoader> &self)
+XCamSmartAnalysisDescription *
+SmartAnalyzerLoader::load_description ()
 {
-    XCAM_ASSERT (self.ptr () == this);
-
-    SmartPtr<SmartAnalysisHandler> handler;
-    XCamSmartAnalysisDescription *desc = (XCamSmartAnalysisDescription*)load_library (get_lib_path ());
-    if (NULL == desc) {
-        XCAM_LOG_WARNING ("load smart handler lib symbol failed");
-        return NULL;
-    }
+    SmartLock locker (_desc_mutex);
+    if (_desc)
+        return _desc;
 
-    handler = new SmartAnalysisHandler (desc, self, (desc->name ? desc->name : _name));
-    if (!handler.ptr ()) {
-        XCAM_LOG_WARNING ("create smart handler failed");
-        close_handle ();
+    _desc = (XCamSmartAnalysisDescription*)load_library (get_lib_path ());
+    if (NULL == _desc) {
+        XCAM_LOG_WARNING ("load smart handler lib(%s) symbol failed", XCAM_STR (get_lib_path ()));
         return NULL;
     }
 
-    XCAM_LOG_INFO ("smart handler(%s) created from lib", XCAM_STR (handler->get_name()));
-    return handler;
+    XCAM_LOG_INFO (
+        "smart handler lib(%s) loaded, analysis(%s)",
+        XCAM_STR (get_lib_path ()), XCAM_STR (_desc->name));
+    return _desc;
 }
 
 void *
@@ -25,6 +25,7 @@
 #include <analyzer_loader.h>
 #include <smart_analysis_handler.h>
 #include <base/xcam_smart_description.h>
+#include <xcam_mutex.h>
 #include <list>
 
 namespace XCam {
@@ -43,11 +44,14 @@ public:
     SmartAnalyzerLoader (const char *lib_path, const char *name = NULL, const char *symbol = XCAM_SMART_ANALYSIS_LIB_DESCRIPTION);
     virtual ~SmartAnalyzerLoader ();
 
+    // handlers named by lib file, libs are not opened until handler contexts are created
     static SmartHandlerList load_smart_handlers (const char *dir_path);
 
+    // opens the lib on first call
+    XCamSmartAnalysisDescription *load_description ();
+
 protected:
     static AnalyzerLoaderList create_analyzer_loader (const char *dir_path);
-    SmartPtr<SmartAnalysisHandler> load_smart_handler (SmartPtr<SmartAnalyzerLoader> &self);
 
 protected:
     virtual void *load_symbol (void* handle);
@@ -56,7 +60,9 @@ private:
     XCAM_DEAD_COPY (SmartAnalyzerLoader);
 
 private:
-    char *_name;
+    char                            *_name;
+    XCamSmartAnalysisDescription    *_desc;
+    Mutex                            _desc_mutex;
 };
 
 };
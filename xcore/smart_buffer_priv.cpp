@@ -37,6 +37,9 @@ public:
     bool is_valid () const {
         return _buf_ptr.ptr ();
     }
+    const SmartPtr<VideoBuffer> &get_video_buf () const {
+        return _buf_ptr;
+    }
 
     static void     buf_ref (XCamVideoBuffer *data);
     static void     buf_unref (XCamVideoBuffer *data);
@@ -165,4 +168,16 @@ convert_to_external_buffer (const SmartPtr<VideoBuffer> &buf)
     return NULL;
 }
 
+SmartPtr<VideoBuffer>
+external_buf_to_video_buf (XCamVideoBuffer *buf)
+{
+    XCAM_ASSERT (buf);
+
+    // ref function tells buffers wrapped by convert_to_external_buffer from other private ones
+    if (buf->mem_type != XCAM_MEM_TYPE_PRIVATE_BO || buf->unref != SmartBufferPriv::buf_unref)
+        return NULL;
+
+    return ((SmartBufferPriv *)buf)->get_video_buf ();
+}
+
 }
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <atomic>
 #include <type_traits>
+#include <utility>
 #include <base/xcam_defs.h>
 
 namespace XCam {
@@ -61,6 +62,31 @@ public:
     virtual bool is_a_object () const {
         return false;
     }
+    // object lives in the same allocation and is destroyed with it
+    virtual bool is_object_embedded () const {
+        return false;
+    }
+};
+
+// one allocation for counter and object, see make_smart
+template<typename Obj>
+class RefCountBlock
+    : public RefCount
+{
+public:
+    template<typename... Args>
+    explicit RefCountBlock (Args&&... args)
+        : _obj (std::forward<Args> (args)...)
+    {}
+    Obj *get () {
+        return &_obj;
+    }
+    virtual bool is_object_embedded () const {
+        return true;
+    }
+
+private:
+    Obj    _obj;
 };
 
 template<typename Obj>
@@ -77,10 +103,13 @@ RefCount* generate_ref_count (Obj *, std::false_type)
     return new RefCount;
 }
 
+template <typename Obj> struct SmartPtrMaker;
+
 template <typename Obj>
 class SmartPtr {
 private:
     template<typename ObjDerive> friend class SmartPtr;
+    friend struct SmartPtrMaker<Obj>;
 public:
     SmartPtr (Obj *obj = NULL)
         : _ptr (obj), _ref(NULL)
@@ -117,6 +146,22 @@ public:
         }
     }
 
+    // move keeps reference count untouched
+    SmartPtr (SmartPtr<Obj> &&obj)
+        : _ptr(obj._ptr), _ref(obj._ref)
+    {
+        obj._ptr = NULL;
+        obj._ref = NULL;
+    }
+
+    template <typename ObjDerive>
+    SmartPtr (SmartPtr<ObjDerive> &&obj)
+        : _ptr(obj._ptr), _ref(obj._ref)
+    {
+        obj._ptr = NULL;
+        obj._ref = NULL;
+    }
+
     ~SmartPtr () {
         release();
     }
@@ -136,15 +181,47 @@ public:
     }
 
     SmartPtr<Obj> & operator = (const SmartPtr<Obj> &obj) {
+        // take the new reference first, self assignment must not free the object
+        Obj *ptr = obj._ptr;
+        RefObj *ref = obj._ref;
+        if (ref)
+            ref->ref ();
         release ();
-        set_pointer (obj._ptr, obj._ref);
+        _ptr = ptr;
+        _ref = ref;
         return *this;
     }
 
     template <typename ObjDerive>
     SmartPtr<Obj> & operator = (const SmartPtr<ObjDerive> &obj) {
+        Obj *ptr = obj._ptr;
+        RefObj *ref = obj._ref;
+        if (ref)
+            ref->ref ();
+        release ();
+        _ptr = ptr;
+        _ref = ref;
+        return *this;
+    }
+
+    SmartPtr<Obj> & operator = (SmartPtr<Obj> &&obj) {
+        if (this == &obj)
+            return *this;
         release ();
-        set_pointer (obj._ptr, obj._ref);
+        _ptr = obj._ptr;
+        _ref = obj._ref;
+        obj._ptr = NULL;
+        obj._ref = NULL;
+        return *this;
+    }
+
+    template <typename ObjDerive>
+    SmartPtr<Obj> & operator = (SmartPtr<ObjDerive> &&obj) {
+        release ();
+        _ptr = obj._ptr;
+        _ref = obj._ref;
+        obj._ptr = NULL;
+        obj._ref = NULL;
         return *this;
     }
 
@@ -164,11 +241,14 @@ public:
         if (!_ref->unref()) {
             if (!_ref->is_a_object ()) {
                 XCAM_ASSERT (dynamic_cast<RefCount*>(_ref));
+                bool embedded = static_cast<RefCount*>(_ref)->is_object_embedded ();
                 delete _ref;
+                if (!embedded)
+                    delete _ptr;
             } else {
                 XCAM_ASSERT (dynamic_cast<Obj*>(_ref) == _ptr);
+                delete _ptr;
             }
-            delete _ptr;
         }
         _ptr = NULL;
         _ref = NULL;
@@ -187,6 +267,17 @@ public:
         return ret;
     }
 
+    // for a type known by caller, no RTTI lookup and checked in debug build only
+    template <typename ObjDerive>
+    SmartPtr<ObjDerive> static_cast_ptr () const {
+        SmartPtr<ObjDerive> ret(NULL);
+        if (!_ref)
+            return ret;
+        XCAM_ASSERT (dynamic_cast<ObjDerive*>(_ptr));
+        ret.set_pointer (static_cast<ObjDerive*>(_ptr), _ref);
+        return ret;
+    }
+
 private:
     template <typename ObjD>
     void set_pointer (ObjD *obj, RefObj *ref) {
@@ -216,5 +307,33 @@ private:
     mutable RefObj   *_ref;
 };
 
+template <typename Obj>
+struct SmartPtrMaker {
+    template<typename... Args>
+    static SmartPtr<Obj> make (std::true_type, Args&&... args) {
+        return SmartPtr<Obj> (new Obj (std::forward<Args> (args)...));
+    }
+
+    template<typename... Args>
+    static SmartPtr<Obj> make (std::false_type, Args&&... args) {
+        RefCountBlock<Obj> *block = new RefCountBlock<Obj> (std::forward<Args> (args)...);
+        SmartPtr<Obj> ret;
+        ret._ptr = block->get ();
+        ret._ref = block;
+        return ret;
+    }
+};
+
+/*
+ * make_smart, constructs Obj with @args, a type not derived from RefObj gets
+ * its counter in the same allocation instead of a separate RefCount.
+ */
+template <typename Obj, typename... Args>
+SmartPtr<Obj> make_smart (Args&&... args)
+{
+    typedef std::is_base_of<RefObj, Obj> BaseCheck;
+    return SmartPtrMaker<Obj>::make (BaseCheck (), std::forward<Args> (args)...);
+}
+
 }; // end namespace
 #endif //XCAM_SMARTPTR_H
\ No newline at end of file
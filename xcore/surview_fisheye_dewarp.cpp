@@ -20,11 +20,80 @@
 
 #include "surview_fisheye_dewarp.h"
 #include "xcam_utils.h"
+#include "thread_pool.h"
+#include <unistd.h>
+
+#define XCAM_FISHEYE_DEWARP_MAX_THREADS 8
+// more jobs than threads, so rows of the wall and the ground even out
+#define XCAM_FISHEYE_DEWARP_JOBS_PER_THREAD 4
 
 namespace XCam {
 
+class DewarpRowsSync {
+public:
+    explicit DewarpRowsSync (uint32_t count)
+        : _remain (count)
+    {}
+    void done () {
+        SmartLock locker (_mutex);
+        if (--_remain == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (DewarpRowsSync);
+
+private:
+    uint32_t          _remain;
+    Mutex             _mutex;
+    XCam::Cond        _cond;
+};
+
+class DewarpRowsWork
+    : public ThreadPool::UserData
+{
+public:
+    DewarpRowsWork (
+        SurViewFisheyeDewarp *dewarp, SurViewFisheyeDewarp::MapTable &map_table,
+        uint32_t row_start, uint32_t row_end,
+        const SurViewFisheyeDewarp::DewarpContext &context, const SmartPtr<DewarpRowsSync> &sync)
+        : _dewarp (dewarp)
+        , _map_table (map_table)
+        , _row_start (row_start)
+        , _row_end (row_end)
+        , _context (context)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _dewarp->dewarp_rows (_map_table, _row_start, _row_end, _context);
+        return XCAM_RETURN_NO_ERROR;
+    }
+    virtual void done (XCamReturn err) {
+        XCAM_UNUSED (err);
+        _sync->done ();
+    }
+
+private:
+    SurViewFisheyeDewarp                        *_dewarp;
+    SurViewFisheyeDewarp::MapTable              &_map_table;
+    uint32_t                                     _row_start;
+    uint32_t                                     _row_end;
+    const SurViewFisheyeDewarp::DewarpContext   &_context;
+    SmartPtr<DewarpRowsSync>                     _sync;
+};
+
 SurViewFisheyeDewarp::SurViewFisheyeDewarp ()
+    : _threads (1)
 {
+    long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+    if (cpus > 1)
+        _threads = XCAM_MIN ((uint32_t)cpus, (uint32_t)XCAM_FISHEYE_DEWARP_MAX_THREADS);
 }
 SurViewFisheyeDewarp::~SurViewFisheyeDewarp ()
 {
@@ -60,13 +129,14 @@ SurViewFisheyeDewarp::get_extrinsic_param()
 }
 
 void
-SurViewFisheyeDewarp::fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h, const BowlDataConfig &bowl_config)
+SurViewFisheyeDewarp::set_threads (uint32_t threads)
 {
-    PointFloat3 world_coord;
-    PointFloat3 cam_coord;
-    PointFloat3 cam_world_coord;
-    PointFloat2 image_coord;
+    _threads = XCAM_MAX (threads, 1u);
+}
 
+void
+SurViewFisheyeDewarp::fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h, const BowlDataConfig &bowl_config)
+{
     XCAM_LOG_DEBUG ("fisheye-dewarp:\n table(%dx%d), out_size(%dx%d)"
                     "bowl(start:%.1f, end:%.1f, ground:%.2f, wall:%.2f, a:%.2f, b:%.2f, c:%.2f, center_z:%.2f )",
                     table_w, table_h, image_w, image_h,
@@ -74,24 +144,50 @@ SurViewFisheyeDewarp::fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint
                     bowl_config.wall_height, bowl_config.ground_length,
                     bowl_config.a, bowl_config.b, bowl_config.c, bowl_config.center_z);
 
-    float scale_factor_w = (float)image_w / table_w;
-    float scale_factor_h = (float)image_h / table_h;
+    DewarpContext context;
+    context.table_w = table_w;
+    context.image_w = image_w;
+    context.image_h = image_h;
+    context.scale_w = (float)image_w / table_w;
+    context.scale_h = (float)image_h / table_h;
+    context.bowl_config = bowl_config;
+    init_world2cam (context);
 
-    for(uint32_t row = 0; row < table_h; row++) {
-        for(uint32_t col = 0; col < table_w; col++) {
-            PointFloat2 out_pos (col * scale_factor_w, row * scale_factor_h);
-            world_coord = bowl_view_image_to_world (bowl_config, image_w, image_h, out_pos);
-            cal_cam_world_coord(world_coord, cam_world_coord);
-            world_coord2cam(cam_world_coord, cam_coord);
-            cal_image_coord(cam_coord, image_coord);
+    uint32_t threads = XCAM_MIN (_threads, table_h);
+    SmartPtr<ThreadPool> pool;
+    if (threads > 1) {
+        pool = new ThreadPool ("FisheyeDewarp");
+        pool->set_threads (threads, threads);
+        if (pool->start () != XCAM_RETURN_NO_ERROR) {
+            XCAM_LOG_WARNING ("fisheye-dewarp start thread pool failed, dewarp in one thread");
+            pool.release ();
+        }
+    }
+
+    if (!pool.ptr ()) {
+        dewarp_rows (map_table, 0, table_h, context);
+        return;
+    }
+
+    uint32_t job_count = XCAM_MIN (threads * XCAM_FISHEYE_DEWARP_JOBS_PER_THREAD, table_h);
+    uint32_t job_rows = xcam_ceil (table_h, job_count) / job_count;
+    job_count = xcam_ceil (table_h, job_rows) / job_rows;
 
-            map_table[row * table_w + col] = image_coord;
+    SmartPtr<DewarpRowsSync> sync = new DewarpRowsSync (job_count);
+    for (uint32_t row = 0; row < table_h; row += job_rows) {
+        uint32_t row_end = XCAM_MIN (row + job_rows, table_h);
+        SmartPtr<DewarpRowsWork> work = new DewarpRowsWork (this, map_table, row, row_end, context, sync);
+        if (pool->queue (work) != XCAM_RETURN_NO_ERROR) {
+            work->run ();
+            work->done (XCAM_RETURN_NO_ERROR);
         }
     }
+    sync->wait ();
+    pool->stop ();
 }
 
 void
-SurViewFisheyeDewarp::cal_cam_world_coord(const PointFloat3 &world_coord, PointFloat3 &cam_world_coord)
+SurViewFisheyeDewarp::init_world2cam (DewarpContext &context)
 {
     Mat4f rotation_mat = generate_rotation_matrix( degree2radian (_extrinsic_param.roll),
                          degree2radian (_extrinsic_param.pitch),
@@ -101,16 +197,33 @@ SurViewFisheyeDewarp::cal_cam_world_coord(const PointFloat3 &world_coord, PointF
     rotation_tran_mat(1, 3) = _extrinsic_param.trans_y;
     rotation_tran_mat(2, 3) = _extrinsic_param.trans_z;
 
-    Mat4f world_coord_mat(Vec4f(1.0f, 0.0f, 0.0f, world_coord.x),
-                          Vec4f(0.0f, 1.0f, 0.0f, world_coord.y),
-                          Vec4f(0.0f, 0.0f, 1.0f, world_coord.z),
-                          Vec4f(0.0f, 0.0f, 0.0f, 1.0f));
+    // camera axes: x = -world y, y = -world z, z = -world x
+    Mat4f axes_mat (
+        Vec4f (0.0f, -1.0f, 0.0f, 0.0f),
+        Vec4f (0.0f, 0.0f, -1.0f, 0.0f),
+        Vec4f (-1.0f, 0.0f, 0.0f, 0.0f),
+        Vec4f (0.0f, 0.0f, 0.0f, 1.0f));
+    context.world2cam = axes_mat * rotation_tran_mat.inverse();
+}
+
+void
+SurViewFisheyeDewarp::dewarp_rows (
+    MapTable &map_table, uint32_t row_start, uint32_t row_end, const DewarpContext &context)
+{
+    const uint32_t table_w = context.table_w;
+    Vec3fArray world_coords (table_w), cam_coords (table_w);
 
-    Mat4f cam_world_coord_mat = rotation_tran_mat.inverse() * world_coord_mat;
+    for(uint32_t row = row_start; row < row_end; row++) {
+        for(uint32_t col = 0; col < table_w; col++) {
+            PointFloat2 out_pos (col * context.scale_w, row * context.scale_h);
+            world_coords.set (col, bowl_view_image_to_world (
+                                  context.bowl_config, context.image_w, context.image_h, out_pos));
+        }
 
-    cam_world_coord.x = cam_world_coord_mat(0, 3);
-    cam_world_coord.y = cam_world_coord_mat(1, 3);
-    cam_world_coord.z = cam_world_coord_mat(2, 3);
+        transform_points (context.world2cam, world_coords, cam_coords);
+        cal_image_coords (
+            cam_coords.x (), cam_coords.y (), cam_coords.z (), &map_table[row * table_w], table_w);
+    }
 }
 
 Mat4f
@@ -135,18 +248,49 @@ SurViewFisheyeDewarp::generate_rotation_matrix(float roll, float pitch, float ya
 }
 
 void
-SurViewFisheyeDewarp::world_coord2cam(const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord)
+SurViewFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord)
 {
-    cam_coord.x = -cam_world_coord.y;
-    cam_coord.y = -cam_world_coord.z;
-    cam_coord.z = -cam_world_coord.x;
+    image_coord.x = cam_coord.x;
+    image_coord.y = cam_coord.y;
 }
 
 void
-SurViewFisheyeDewarp::cal_image_coord(const PointFloat3 &cam_coord, PointFloat2 &image_coord)
+SurViewFisheyeDewarp::cal_image_coords (
+    const float *cam_x, const float *cam_y, const float *cam_z,
+    PointFloat2 *image_coords, uint32_t count)
 {
-    image_coord.x = cam_coord.x;
-    image_coord.y = cam_coord.y;
+    for (uint32_t i = 0; i < count; ++i)
+        cal_image_coord (PointFloat3 (cam_x[i], cam_y[i], cam_z[i]), image_coords[i]);
+}
+
+void
+PolyFisheyeDewarp::cal_image_coords (
+    const float *cam_x, const float *cam_y, const float *cam_z,
+    PointFloat2 *image_coords, uint32_t count)
+{
+    const IntrinsicParameter intrinsic_param = get_intrinsic_param();
+    const uint32_t poly_length = intrinsic_param.poly_length;
+    const float *coeff = intrinsic_param.poly_coeff;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        float dist2center = sqrtf (cam_x[i] * cam_x[i] + cam_y[i] * cam_y[i]);
+        if (dist2center == 0.0f) {
+            image_coords[i].x = intrinsic_param.xc;
+            image_coords[i].y = intrinsic_param.yc;
+            continue;
+        }
+
+        float angle = atanf (cam_z[i] / dist2center);
+        float poly_sum = 0.0f;
+        for (uint32_t k = poly_length; k > 0; --k)
+            poly_sum = poly_sum * angle + coeff[k - 1];
+
+        float image_x = cam_x[i] * poly_sum / dist2center;
+        float image_y = cam_y[i] * poly_sum / dist2center;
+
+        image_coords[i].x = image_x * intrinsic_param.c + image_y * intrinsic_param.d + intrinsic_param.xc;
+        image_coords[i].y = image_x * intrinsic_param.e + image_y + intrinsic_param.yc;
+    }
 }
 
 void
@@ -27,8 +27,11 @@
 
 namespace XCam {
 
+class DewarpRowsWork;
+
 class SurViewFisheyeDewarp
 {
+    friend class DewarpRowsWork;
 
 public:
     typedef std::vector<PointFloat2> MapTable;
@@ -36,6 +39,8 @@ public:
     explicit SurViewFisheyeDewarp ();
     virtual ~SurViewFisheyeDewarp ();
 
+    // table rows are split over threads, default is online cpu count
+    void set_threads (uint32_t threads);
     void fisheye_dewarp(MapTable &map_table, uint32_t table_w, uint32_t table_h, uint32_t image_w, uint32_t image_h, const BowlDataConfig &bowl_config);
 
     void set_intrinsic_param(const IntrinsicParameter &intrinsic_param);
@@ -45,18 +50,34 @@ public:
     ExtrinsicParameter get_extrinsic_param();
 
 private:
+    // shared by all rows of one fisheye_dewarp
+    struct DewarpContext {
+        uint32_t         table_w;
+        uint32_t         image_w;
+        uint32_t         image_h;
+        float            scale_w;
+        float            scale_h;
+        BowlDataConfig   bowl_config;
+        Mat4f            world2cam;
+    };
+
     XCAM_DEAD_COPY (SurViewFisheyeDewarp);
 
     virtual void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord);
+    // camera coords of count points in SoA layout
+    virtual void cal_image_coords (
+        const float *cam_x, const float *cam_y, const float *cam_z,
+        PointFloat2 *image_coords, uint32_t count);
 
-    void cal_cam_world_coord (const PointFloat3 &world_coord, PointFloat3 &cam_world_coord);
-    void world_coord2cam (const PointFloat3 &cam_world_coord, PointFloat3 &cam_coord);
+    void init_world2cam (DewarpContext &context);
+    void dewarp_rows (MapTable &map_table, uint32_t row_start, uint32_t row_end, const DewarpContext &context);
 
     Mat4f generate_rotation_matrix(float roll, float pitch, float yaw);
 
 private:
     IntrinsicParameter _intrinsic_param;
     ExtrinsicParameter _extrinsic_param;
+    uint32_t           _threads;
 };
 
 class PolyFisheyeDewarp : public SurViewFisheyeDewarp
@@ -67,6 +88,9 @@ public:
 
 private:
     void cal_image_coord (const PointFloat3 &cam_coord, PointFloat2 &image_coord);
+    void cal_image_coords (
+        const float *cam_x, const float *cam_y, const float *cam_z,
+        PointFloat2 *image_coords, uint32_t count);
 
 };
 
@@ -0,0 +1,300 @@
+/*
+ * task_graph.cpp - task graph of dependent stages
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "task_graph.h"
+
+namespace XCam {
+
+class TaskNodeWork
+    : public ThreadPool::UserData
+{
+public:
+    TaskNodeWork (const SmartPtr<TaskRun> &run, TaskGraph::NodeId id)
+        : _run (run)
+        , _id (id)
+    {}
+
+    virtual XCamReturn run () {
+        _run->execute_node (_id);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+private:
+    SmartPtr<TaskRun>     _run;
+    TaskGraph::NodeId     _id;
+};
+
+TaskGraph::TaskGraph (const char *name)
+    : _name (NULL)
+    , _sealed (false)
+{
+    if (name)
+        _name = strndup (name, XCAM_MAX_STR_SIZE);
+}
+
+TaskGraph::~TaskGraph ()
+{
+    xcam_mem_clear (_name);
+}
+
+TaskGraph::NodeId
+TaskGraph::add_node (const SmartPtr<Task> &task, bool async)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, task.ptr () && !_sealed, XCAM_TASK_GRAPH_INVALID_NODE,
+        "task graph(%s) add node failed, %s", XCAM_STR (_name), (_sealed ? "already sealed" : "task is NULL"));
+
+    Node node;
+    node.task = task;
+    node.async = async;
+    _nodes.push_back (node);
+    return _nodes.size () - 1;
+}
+
+bool
+TaskGraph::add_edge (NodeId from, NodeId to)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_sealed && from < _nodes.size () && to < _nodes.size () && from != to, false,
+        "task graph(%s) add edge(%d -> %d) failed", XCAM_STR (_name), from, to);
+
+    std::vector<NodeId> &next = _nodes[from].next;
+    for (size_t i = 0; i < next.size (); ++i) {
+        if (next[i] == to)
+            return true;
+    }
+    next.push_back (to);
+    ++_nodes[to].prev_num;
+    return true;
+}
+
+XCamReturn
+TaskGraph::seal ()
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_sealed, XCAM_RETURN_ERROR_ORDER,
+        "task graph(%s) already sealed", XCAM_STR (_name));
+
+    // topological walk, a cycle leaves nodes unvisited
+    std::vector<uint32_t> joins (_nodes.size ());
+    std::vector<NodeId> ready;
+    for (NodeId i = 0; i < _nodes.size (); ++i) {
+        joins[i] = _nodes[i].prev_num;
+        if (!joins[i])
+            ready.push_back (i);
+    }
+    std::vector<NodeId> roots = ready;
+
+    uint32_t visited = 0;
+    while (!ready.empty ()) {
+        NodeId id = ready.back ();
+        ready.pop_back ();
+        ++visited;
+
+        const std::vector<NodeId> &next = _nodes[id].next;
+        for (size_t i = 0; i < next.size (); ++i) {
+            if (--joins[next[i]] == 0)
+                ready.push_back (next[i]);
+        }
+    }
+    XCAM_FAIL_RETURN (
+        ERROR, visited == _nodes.size (), XCAM_RETURN_ERROR_PARAM,
+        "task graph(%s) has a cycle, %d of %d nodes reachable",
+        XCAM_STR (_name), visited, (uint32_t)_nodes.size ());
+
+    _roots = roots;
+    _sealed = true;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+TaskGraph::launch (const SmartPtr<TaskRun> &run)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, _sealed, XCAM_RETURN_ERROR_ORDER,
+        "task graph(%s) launch failed, graph is not sealed", XCAM_STR (_name));
+    XCAM_FAIL_RETURN (
+        ERROR, run.ptr (), XCAM_RETURN_ERROR_PARAM,
+        "task graph(%s) launch failed, run is NULL", XCAM_STR (_name));
+
+    return run->start (this);
+}
+
+TaskRun::TaskRun ()
+    : _joins (NULL)
+    , _finished (NULL)
+    , _remaining (0)
+    , _error (XCAM_RETURN_NO_ERROR)
+    , _done (false)
+{
+}
+
+TaskRun::~TaskRun ()
+{
+    delete [] _joins;
+    delete [] _finished;
+}
+
+XCamReturn
+TaskRun::start (const SmartPtr<TaskGraph> &graph)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_graph.ptr (), XCAM_RETURN_ERROR_ORDER,
+        "task graph(%s) run was already launched", XCAM_STR (graph->get_name ()));
+
+    uint32_t count = graph->_nodes.size ();
+    _graph = graph;
+    _joins = new std::atomic<int32_t>[count];
+    _finished = new std::atomic<bool>[count];
+    for (uint32_t i = 0; i < count; ++i) {
+        _joins[i] = graph->_nodes[i].prev_num;
+        _finished[i] = false;
+    }
+    _remaining = count;
+
+    if (!count) {
+        finish ();
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    // the run may be done and released by its owner before dispatching returns
+    SmartPtr<TaskRun> self = this;
+    const std::vector<TaskGraph::NodeId> &roots = graph->_roots;
+    for (size_t i = 0; i < roots.size (); ++i)
+        dispatch_node (roots[i]);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+TaskRun::dispatch_node (TaskGraph::NodeId id)
+{
+    const TaskGraph::Node &node = _graph->_nodes[id];
+    const SmartPtr<ThreadPool> &pool = _graph->_pool;
+
+    // async nodes only start work, not worth a thread switch
+    if (!node.async && pool.ptr ()) {
+        XCamReturn ret = pool->queue (new TaskNodeWork (this, id));
+        if (xcam_ret_is_ok (ret))
+            return;
+        XCAM_LOG_WARNING (
+            "task graph(%s) queue node:%d to pool failed, run it in place", XCAM_STR (_graph->get_name ()), id);
+    }
+
+    execute_node (id);
+}
+
+void
+TaskRun::execute_node (TaskGraph::NodeId id)
+{
+    SmartPtr<TaskRun> self = this;
+
+    // continues with one released successor in this thread
+    while (id != XCAM_TASK_GRAPH_INVALID_NODE) {
+        const TaskGraph::Node &node = _graph->_nodes[id];
+
+        XCamReturn ret = XCAM_RETURN_BYPASS;
+        bool skipped = is_broken ();
+        if (!skipped)
+            ret = node.task->run (self, id);
+
+        if (!skipped && node.async && xcam_ret_is_ok (ret))
+            return;
+
+        TaskGraph::NodeId next;
+        if (!complete_node (id, ret, next))
+            return;
+        id = next;
+    }
+}
+
+bool
+TaskRun::complete_node (TaskGraph::NodeId id, XCamReturn error, TaskGraph::NodeId &next)
+{
+    next = XCAM_TASK_GRAPH_INVALID_NODE;
+
+    bool finished = false;
+    if (!_finished[id].compare_exchange_strong (finished, true)) {
+        XCAM_LOG_WARNING ("task graph(%s) node:%d completed twice", XCAM_STR (_graph->get_name ()), id);
+        return false;
+    }
+
+    if (!xcam_ret_is_ok (error)) {
+        int32_t no_error = XCAM_RETURN_NO_ERROR;
+        _error.compare_exchange_strong (no_error, error);
+    }
+
+    const std::vector<TaskGraph::NodeId> &succs = _graph->_nodes[id].next;
+    for (size_t i = 0; i < succs.size (); ++i) {
+        if (--_joins[succs[i]] != 0)
+            continue;
+
+        if (next == XCAM_TASK_GRAPH_INVALID_NODE)
+            next = succs[i];
+        else
+            dispatch_node (succs[i]);
+    }
+
+    if (--_remaining == 0)
+        finish ();
+
+    return next != XCAM_TASK_GRAPH_INVALID_NODE;
+}
+
+void
+TaskRun::node_done (TaskGraph::NodeId id, XCamReturn error)
+{
+    if (!_graph.ptr () || id >= _graph->_nodes.size () || !_graph->_nodes[id].async) {
+        XCAM_LOG_ERROR ("task graph run node_done failed, node:%d is not an async node", id);
+        return;
+    }
+
+    SmartPtr<TaskRun> self = this;
+    TaskGraph::NodeId next;
+    if (complete_node (id, error, next))
+        execute_node (next);
+}
+
+void
+TaskRun::finish ()
+{
+    run_done (get_error ());
+
+    SmartLock locker (_mutex);
+    _done = true;
+    _cond.broadcast ();
+}
+
+XCamReturn
+TaskRun::wait (int64_t timeout)
+{
+    SmartLock locker (_mutex);
+    while (!_done) {
+        if (timeout < 0) {
+            _cond.wait (_mutex);
+        } else if (_cond.timedwait (_mutex, timeout) != 0) {
+            if (!_done)
+                return XCAM_RETURN_ERROR_TIMEOUT;
+        }
+    }
+    return get_error ();
+}
+
+}
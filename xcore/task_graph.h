@@ -0,0 +1,162 @@
+/*
+ * task_graph.h - task graph of dependent stages
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_TASK_GRAPH_H
+#define XCAM_TASK_GRAPH_H
+
+#include <xcam_std.h>
+#include <xcam_mutex.h>
+#include <thread_pool.h>
+
+#define XCAM_TASK_GRAPH_INVALID_NODE ((uint32_t)(-1))
+
+namespace XCam {
+
+class TaskRun;
+
+/*
+ * nodes and edges are declared once, then every launch() runs the whole graph.
+ * a node starts when all its predecessors are done, independent nodes run concurrently.
+ */
+class TaskGraph
+    : public RefObj
+{
+    friend class TaskRun;
+
+public:
+    typedef uint32_t NodeId;
+
+    class Task {
+    public:
+        Task () {}
+        virtual ~Task () {}
+        // sync node returns its result, async node starts work and reports by TaskRun::node_done,
+        // an error returned by async node completes it at once.
+        virtual XCamReturn run (const SmartPtr<TaskRun> &run, NodeId id) = 0;
+    private:
+        XCAM_DEAD_COPY (Task);
+    };
+
+private:
+    struct Node {
+        SmartPtr<Task>         task;
+        bool                   async;
+        std::vector<NodeId>    next;
+        uint32_t               prev_num;
+
+        Node () : async (false), prev_num (0) {}
+    };
+
+public:
+    explicit TaskGraph (const char *name);
+    virtual ~TaskGraph ();
+
+    const char *get_name () const {
+        return _name;
+    }
+    // sync nodes run in pool threads, or in caller and completing threads without a pool
+    void set_thread_pool (const SmartPtr<ThreadPool> &pool) {
+        _pool = pool;
+    }
+
+    // returns XCAM_TASK_GRAPH_INVALID_NODE on failure
+    NodeId add_node (const SmartPtr<Task> &task, bool async = false);
+    bool add_edge (NodeId from, NodeId to);
+    // checks the graph is acyclic, no nodes or edges can be added afterwards
+    XCamReturn seal ();
+    bool is_sealed () const {
+        return _sealed;
+    }
+    uint32_t get_node_count () const {
+        return _nodes.size ();
+    }
+
+    XCamReturn launch (const SmartPtr<TaskRun> &run);
+
+private:
+    XCAM_DEAD_COPY (TaskGraph);
+
+private:
+    char                        *_name;
+    std::vector<Node>            _nodes;
+    std::vector<NodeId>          _roots;
+    SmartPtr<ThreadPool>         _pool;
+    bool                         _sealed;
+};
+
+/*
+ * state of one launch, derive it to carry per-run data.
+ * once a node fails, nodes which are not started yet are skipped.
+ */
+class TaskRun
+    : public RefObj
+{
+    friend class TaskGraph;
+    friend class TaskNodeWork;
+
+public:
+    TaskRun ();
+    virtual ~TaskRun ();
+
+    // completes an async node
+    void node_done (TaskGraph::NodeId id, XCamReturn error);
+
+    bool is_done () const {
+        return _done;
+    }
+    bool is_broken () const {
+        return !xcam_ret_is_ok ((XCamReturn)_error.load ());
+    }
+    // first error of nodes
+    XCamReturn get_error () const {
+        return (XCamReturn)_error.load ();
+    }
+    // timeout in microseconds, -1 waits forever
+    XCamReturn wait (int64_t timeout = -1);
+
+protected:
+    // called once after all nodes done or skipped
+    virtual void run_done (XCamReturn error) {
+        XCAM_UNUSED (error);
+    }
+
+private:
+    XCamReturn start (const SmartPtr<TaskGraph> &graph);
+    void execute_node (TaskGraph::NodeId id);
+    bool complete_node (TaskGraph::NodeId id, XCamReturn error, TaskGraph::NodeId &next);
+    void dispatch_node (TaskGraph::NodeId id);
+    void finish ();
+
+    XCAM_DEAD_COPY (TaskRun);
+
+private:
+    SmartPtr<TaskGraph>          _graph;
+    std::atomic<int32_t>        *_joins;
+    std::atomic<bool>           *_finished;
+    std::atomic<uint32_t>        _remaining;
+    std::atomic<int32_t>         _error;
+    std::atomic<bool>            _done;
+    Mutex                        _mutex;
+    Cond                         _cond;
+};
+
+}
+
+#endif // XCAM_TASK_GRAPH_H
@@ -19,19 +19,85 @@
  */
 
 #include "thread_pool.h"
+#include <safe_ring.h>
+#include <unistd.h>
 
 #define XCAM_POOL_MIN_THREADS 2
 #define XCAM_POOL_MAX_THREADS 1024
 
+// parked threads re-check the deques in case of missing wakeup, in microseconds
+#define XCAM_POOL_PARK_TIMEOUT 10000
+
+// spin budget never shrinks below this after misses
+#define XCAM_POOL_MIN_SPINS 16
+
+// items per thread ring in work-stealing mode, more are spilled into the overflow queue
+#define XCAM_POOL_DEQUE_CAPACITY 256
+
 namespace XCam {
 
+// pool and deque index of current thread, only valid in work-stealing user threads
+static __thread ThreadPool *tls_thread_pool = NULL;
+static __thread uint32_t tls_deque_index = 0;
+
+static inline void
+cpu_relax ()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause ();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__ ("yield" ::: "memory");
+#else
+    __asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+/*
+ * per-thread bounded ring of SafeRing, lock-free by its atomic head and tail,
+ * owner and thieves both take the oldest item from the head,
+ * push fails on a full ring and the item is spilled into the overflow queue
+ */
+class WorkDeque
+{
+public:
+    typedef SmartPtr<ThreadPool::UserData> DataPtr;
+
+    WorkDeque ()
+        : _ring (XCAM_POOL_DEQUE_CAPACITY)
+    {}
+
+    bool push (const DataPtr &data) {
+        return _ring.try_push (data);
+    }
+
+    DataPtr pop () {
+        return _ring.try_pop ();
+    }
+
+    uint32_t clear () {
+        uint32_t count = 0;
+        while (_ring.try_pop ().ptr ())
+            ++count;
+        return count;
+    }
+
+private:
+    XCAM_DEAD_COPY (WorkDeque);
+
+private:
+    SafeRing<ThreadPool::UserData>   _ring;
+};
+
 class UserThread
     : public Thread
 {
 public:
-    UserThread (const SmartPtr<ThreadPool> &pool, const char *name)
+    UserThread (const SmartPtr<ThreadPool> &pool, const char *name, uint32_t index)
         : Thread (name)
         , _pool (pool)
+        , _index (index)
+        , _seed (index * 2654435761u + 1)
+        , _spins (pool->_max_spins)
     {}
 
 protected:
@@ -41,6 +107,9 @@ protected:
 
 private:
     SmartPtr<ThreadPool> _pool;
+    uint32_t             _index;
+    uint32_t             _seed;
+    uint32_t             _spins;
 };
 
 bool
@@ -48,6 +117,10 @@ UserThread::started ()
 {
     XCAM_ASSERT (_pool.ptr ());
     SmartLock lock (_pool->_mutex);
+    if (_pool->_mode == ThreadPool::ScheduleWorkStealing) {
+        tls_thread_pool = _pool.ptr ();
+        tls_deque_index = _index;
+    }
     return true;
 }
 
@@ -61,17 +134,35 @@ bool
 UserThread::loop ()
 {
     XCAM_ASSERT (_pool.ptr ());
+    if (_pool->_mode == ThreadPool::ScheduleWorkStealing) {
+        SmartPtr<ThreadPool::UserData> data = _pool->fetch_from_deques (_index, _seed, _spins);
+        if (!data.ptr ()) {
+            XCAM_LOG_DEBUG ("user thread(%s) fetch null data, need stop", XCAM_STR (_pool->get_name ()));
+            return false;
+        }
+
+        XCAM_ASSERT (_pool->_free_threads > 0);
+        --_pool->_free_threads;
+        bool ret = _pool->dispatch (data);
+        ++_pool->_free_threads;
+        return ret;
+    }
+
     {
         SmartLock lock (_pool->_mutex);
         if (!_pool->_running)
             return false;
     }
 
+    // pop still sleeps if spinning missed or other threads took the data
+    _pool->spin_for_data (_spins);
+
     SmartPtr<ThreadPool::UserData> data = _pool->_data_queue.pop ();
     if (!data.ptr ()) {
         XCAM_LOG_DEBUG ("user thread(%s) get null data, need stop", XCAM_STR (_pool->get_name ()));
         return false;
     }
+    --_pool->_pending_items;
 
     {
         SmartLock lock (_pool->_mutex);
@@ -106,6 +197,12 @@ ThreadPool::ThreadPool (const char *name)
     , _allocated_threads (0)
     , _free_threads (0)
     , _running (false)
+    , _mode (ScheduleSharedQueue)
+    , _max_spins (0)
+    , _pending_items (0)
+    , _next_deque (0)
+    , _parked_threads (0)
+    , _overflow_items (0)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -138,6 +235,46 @@ ThreadPool::set_threads (uint32_t min, uint32_t max)
     return true;
 }
 
+bool
+ThreadPool::set_schedule_mode (ScheduleMode mode)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, false,
+        "ThreadPool(%s) set schedule mode failed, need stop the pool first", XCAM_STR(get_name ()));
+
+    _mode = mode;
+    return true;
+}
+
+bool
+ThreadPool::set_thread_policy (const ThreadPolicy &policy)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, false,
+        "ThreadPool(%s) set thread policy failed, need stop the pool first", XCAM_STR(get_name ()));
+
+    SmartLock locker(_mutex);
+    _thread_policy = policy;
+    return true;
+}
+
+bool
+ThreadPool::set_spin_count (uint32_t max_spins)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_running, false,
+        "ThreadPool(%s) set spin count failed, need stop the pool first", XCAM_STR(get_name ()));
+
+    // spinning only steals cpu from the producer on a single core
+    if (max_spins && sysconf (_SC_NPROCESSORS_ONLN) < 2) {
+        XCAM_LOG_DEBUG ("ThreadPool(%s) spinning disabled on single cpu", XCAM_STR(get_name ()));
+        max_spins = 0;
+    }
+
+    _max_spins = max_spins;
+    return true;
+}
+
 bool
 ThreadPool::is_running ()
 {
@@ -154,8 +291,19 @@ ThreadPool::start ()
 
     _free_threads = 0;
     _allocated_threads = 0;
+    _pending_items = 0;
     _data_queue.resume_pop ();
 
+    if (_mode == ScheduleWorkStealing) {
+        // deques are never resized while running, so they can be accessed without _mutex
+        _deques.clear ();
+        for (uint32_t i = 0; i < _max_threads; ++i)
+            _deques.push_back (new WorkDeque);
+        _next_deque = 0;
+        _parked_threads = 0;
+        _overflow_items = 0;
+    }
+
     for (uint32_t i = 0; i < _min_threads; ++i) {
         XCamReturn ret = create_user_thread_unsafe ();
         XCAM_FAIL_RETURN (
@@ -192,6 +340,7 @@ ThreadPool::stop ()
 
     _data_queue.pause_pop ();
     _data_queue.clear ();
+    wakeup_parked (XCAM_POOL_MAX_THREADS);
 
     for (UserThreadList::iterator i = threads.begin (); i != threads.end (); ++i)
     {
@@ -205,6 +354,9 @@ ThreadPool::stop ()
         _free_threads = 0;
         _allocated_threads = 0;
     }
+    clear_deques ();
+    if (_mode == ScheduleSharedQueue)
+        _pending_items = 0;
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -213,9 +365,11 @@ XCamReturn
 ThreadPool::create_user_thread_unsafe ()
 {
     char name[256];
-    snprintf (name, 255, "%s-%d", XCAM_STR (get_name()), _allocated_threads);
-    SmartPtr<UserThread> thread = new UserThread (this, name);
+    uint32_t index = _allocated_threads;
+    snprintf (name, 255, "%s-%d", XCAM_STR (get_name()), index);
+    SmartPtr<UserThread> thread = new UserThread (this, name, index);
     XCAM_ASSERT (thread.ptr ());
+    thread->set_policy (_thread_policy);
     XCAM_FAIL_RETURN (
         ERROR, thread.ptr () && thread->start (), XCAM_RETURN_ERROR_THREAD,
         "ThreadPool(%s) create user thread failed by starting error", XCAM_STR (get_name()));
@@ -233,19 +387,26 @@ XCamReturn
 ThreadPool::queue (const SmartPtr<UserData> &data)
 {
     XCAM_ASSERT (data.ptr ());
+    if (_mode == ScheduleWorkStealing)
+        return queue_to_deque (data);
+
     {
         SmartLock locker (_mutex);
         if (!_running)
             return XCAM_RETURN_ERROR_THREAD;
     }
 
-    if (!_data_queue.push (data))
+    ++_pending_items;
+    if (!_data_queue.push (data)) {
+        --_pending_items;
         return XCAM_RETURN_ERROR_THREAD;
+    }
 
     do {
         SmartLock locker(_mutex);
         if (!_running) {
-            _data_queue.erase (data);
+            if (_data_queue.erase (data))
+                --_pending_items;
             return XCAM_RETURN_ERROR_THREAD;
         }
 
@@ -270,4 +431,240 @@ ThreadPool::queue (const SmartPtr<UserData> &data)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+ThreadPool::queue_to_deque (const SmartPtr<UserData> &data)
+{
+    if (!_running)
+        return XCAM_RETURN_ERROR_THREAD;
+
+    // items queued inside a user thread stay local, others are spread round-robin
+    uint32_t index = 0;
+    if (tls_thread_pool == this)
+        index = tls_deque_index;
+    else
+        index = _next_deque++ % _allocated_threads;
+
+    push_to_deque (index, data);
+    ++_pending_items;
+
+    if (_parked_threads) {
+        wakeup_parked (1);
+        return XCAM_RETURN_NO_ERROR;
+    }
+
+    if (_free_threads || _allocated_threads >= _max_threads)
+        return XCAM_RETURN_NO_ERROR;
+
+    // slow path, all threads are busy
+    SmartLock locker (_mutex);
+    if (!_running) {
+        // rings can not erase one item, nothing queued after stop is run anyway
+        clear_deques ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    if (_free_threads || _allocated_threads >= _max_threads)
+        return XCAM_RETURN_NO_ERROR;
+
+    XCamReturn err = create_user_thread_unsafe ();
+    if (!xcam_ret_is_ok (err)) {
+        XCAM_LOG_WARNING (
+            "thread pool(%s) create new thread failed but queue data can continue", XCAM_STR (get_name()));
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ThreadPool::queue_many (const UserDataList &datas)
+{
+    if (datas.empty ())
+        return XCAM_RETURN_NO_ERROR;
+    if (_mode == ScheduleWorkStealing)
+        return queue_many_to_deques (datas);
+
+    {
+        SmartLock locker (_mutex);
+        if (!_running)
+            return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    _pending_items += datas.size ();
+    if (!_data_queue.push_many (datas)) {
+        _pending_items -= datas.size ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    SmartLock locker(_mutex);
+    if (!_running) {
+        for (UserDataList::const_iterator i = datas.begin (); i != datas.end (); ++i) {
+            if (_data_queue.erase (*i))
+                --_pending_items;
+        }
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    // same growth as queue, one thread at most
+    if (_allocated_threads < _max_threads && _free_threads) {
+        XCamReturn err = create_user_thread_unsafe ();
+        if (!xcam_ret_is_ok (err)) {
+            XCAM_LOG_WARNING (
+                "thread pool(%s) create new thread failed but queue data can continue", XCAM_STR (get_name()));
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+ThreadPool::queue_many_to_deques (const UserDataList &datas)
+{
+    if (!_running)
+        return XCAM_RETURN_ERROR_THREAD;
+
+    bool local = (tls_thread_pool == this);
+    for (UserDataList::const_iterator i = datas.begin (); i != datas.end (); ++i) {
+        uint32_t index = local ? tls_deque_index : _next_deque++ % _allocated_threads;
+        push_to_deque (index, *i);
+    }
+    _pending_items += datas.size ();
+
+    if (_parked_threads)
+        wakeup_parked (datas.size ());
+
+    if (_free_threads >= datas.size () || _allocated_threads >= _max_threads)
+        return XCAM_RETURN_NO_ERROR;
+
+    SmartLock locker (_mutex);
+    if (!_running) {
+        clear_deques ();
+        return XCAM_RETURN_ERROR_THREAD;
+    }
+
+    // threads not woken above are created, up to max threads
+    uint32_t count = datas.size ();
+    while (_free_threads < count && _allocated_threads < _max_threads) {
+        XCamReturn err = create_user_thread_unsafe ();
+        if (!xcam_ret_is_ok (err)) {
+            XCAM_LOG_WARNING (
+                "thread pool(%s) create new thread failed but queue data can continue", XCAM_STR (get_name()));
+            break;
+        }
+    }
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+void
+ThreadPool::push_to_deque (uint32_t index, const SmartPtr<UserData> &data)
+{
+    XCAM_ASSERT (index < _deques.size ());
+    if (_deques[index]->push (data))
+        return;
+
+    // counted first, so fetching threads never miss a spilled item
+    ++_overflow_items;
+    _data_queue.push (data);
+}
+
+SmartPtr<ThreadPool::UserData>
+ThreadPool::steal_from_others (uint32_t index, uint32_t &seed)
+{
+    uint32_t count = _allocated_threads;
+    if (count <= 1)
+        return NULL;
+
+    // xorshift to pick a random victim, then walk through all the others
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    uint32_t victim = seed % count;
+
+    for (uint32_t i = 0; i < count; ++i, victim = (victim + 1) % count) {
+        if (victim == index)
+            continue;
+
+        SmartPtr<UserData> data = _deques[victim]->pop ();
+        if (data.ptr ())
+            return data;
+    }
+    return NULL;
+}
+
+SmartPtr<ThreadPool::UserData>
+ThreadPool::fetch_from_deques (uint32_t index, uint32_t &seed, uint32_t &spins)
+{
+    XCAM_ASSERT (index < _deques.size ());
+
+    while (_running) {
+        SmartPtr<UserData> data = _deques[index]->pop ();
+        if (!data.ptr ())
+            data = steal_from_others (index, seed);
+        if (!data.ptr () && _overflow_items > 0) {
+            data = _data_queue.pop (0);
+            if (data.ptr ())
+                --_overflow_items;
+        }
+
+        if (data.ptr ()) {
+            --_pending_items;
+            return data;
+        }
+
+        if (spin_for_data (spins))
+            continue;
+
+        SmartLock locker (_park_mutex);
+        ++_parked_threads;
+        if (_running && _pending_items <= 0)
+            _park_cond.timedwait (_park_mutex, XCAM_POOL_PARK_TIMEOUT);
+        --_parked_threads;
+    }
+
+    return NULL;
+}
+
+bool
+ThreadPool::spin_for_data (uint32_t &spins)
+{
+    if (!_max_spins)
+        return false;
+
+    for (uint32_t i = 0; i < spins; ++i) {
+        if (_pending_items > 0 || !_running) {
+            spins = XCAM_MIN (spins * 2, _max_spins);
+            return true;
+        }
+        cpu_relax ();
+    }
+
+    spins = XCAM_MAX (spins / 2, XCAM_MIN ((uint32_t)XCAM_POOL_MIN_SPINS, _max_spins));
+    return false;
+}
+
+void
+ThreadPool::wakeup_parked (uint32_t count)
+{
+    SmartLock locker (_park_mutex);
+    if (count >= _parked_threads) {
+        _park_cond.broadcast ();
+    } else {
+        for (uint32_t i = 0; i < count; ++i)
+            _park_cond.signal ();
+    }
+}
+
+void
+ThreadPool::clear_deques ()
+{
+    for (WorkDequeArray::iterator i = _deques.begin (); i != _deques.end (); ++i) {
+        int32_t count = (*i)->clear ();
+        _pending_items -= count;
+    }
+
+    int32_t spilled = _overflow_items.exchange (0);
+    _data_queue.clear ();
+    _pending_items -= spilled;
+}
+
 }
@@ -28,12 +28,14 @@
 namespace XCam {
 
 class UserThread;
+class WorkDeque;
 
 class ThreadPool
     : public RefObj
 {
     friend class UserThread;
     typedef std::list<SmartPtr<UserThread> > UserThreadList;
+    typedef std::vector<SmartPtr<WorkDeque> > WorkDequeArray;
 
 public:
     class UserData {
@@ -46,10 +48,26 @@ public:
         XCAM_DEAD_COPY (UserData);
     };
 
+    typedef std::list<SmartPtr<UserData> > UserDataList;
+
+    enum ScheduleMode {
+        ScheduleSharedQueue = 0,  // all threads pop from one locked queue
+        ScheduleWorkStealing,     // per-thread lock-free ring, idle threads steal from others
+    };
+
 public:
     explicit ThreadPool (const char *name);
     virtual ~ThreadPool ();
     bool set_threads (uint32_t min, uint32_t max);
+    bool set_schedule_mode (ScheduleMode mode);
+    // applies to threads created afterwards, set before start
+    bool set_thread_policy (const ThreadPolicy &policy);
+    // idle threads poll for new data up to @max_spins pause loops before sleeping, 0 disables,
+    // each thread halves its budget on a miss and doubles it back on a hit, set before start
+    bool set_spin_count (uint32_t max_spins);
+    ScheduleMode get_schedule_mode () const {
+        return _mode;
+    }
     const char *get_name () const {
         return _name;
     }
@@ -58,11 +76,25 @@ public:
     XCamReturn start ();
     XCamReturn stop ();
     XCamReturn queue (const SmartPtr<UserData> &data);
+    // queues all @datas at once, sleeping threads are woken together
+    XCamReturn queue_many (const UserDataList &datas);
 
 protected:
     bool dispatch (const SmartPtr<UserData> &data);
     XCamReturn create_user_thread_unsafe ();
 
+private:
+    XCamReturn queue_to_deque (const SmartPtr<UserData> &data);
+    XCamReturn queue_many_to_deques (const UserDataList &datas);
+    // pushes into ring @index, spills into the overflow queue when the ring is full
+    void push_to_deque (uint32_t index, const SmartPtr<UserData> &data);
+    SmartPtr<UserData> fetch_from_deques (uint32_t index, uint32_t &seed, uint32_t &spins);
+    SmartPtr<UserData> steal_from_others (uint32_t index, uint32_t &seed);
+    bool spin_for_data (uint32_t &spins);
+    // wakes up to @count parked threads, all of them if @count is not less than parked ones
+    void wakeup_parked (uint32_t count);
+    void clear_deques ();
+
 private:
     XCAM_DEAD_COPY (ThreadPool);
 
@@ -70,13 +102,27 @@ private:
     char                   *_name;
     uint32_t                _min_threads;
     uint32_t                _max_threads;
-    uint32_t                _allocated_threads;
-    uint32_t                _free_threads;
-    bool                    _running;
+    std::atomic<uint32_t>   _allocated_threads;
+    std::atomic<uint32_t>   _free_threads;
+    std::atomic<bool>       _running;
+    ScheduleMode            _mode;
+    ThreadPolicy            _thread_policy;
+    uint32_t                _max_spins;
     UserThreadList          _thread_list;
     Mutex                   _mutex;
 
+    // shared mode queue, also the overflow of full rings in work-stealing mode
     SafeList<UserData>      _data_queue;
+    // queued but not yet fetched, polled by spinning threads
+    std::atomic<int32_t>    _pending_items;
+
+    // work-stealing mode
+    WorkDequeArray          _deques;
+    std::atomic<uint32_t>   _next_deque;
+    std::atomic<uint32_t>   _parked_threads;
+    std::atomic<int32_t>    _overflow_items;
+    Mutex                   _park_mutex;
+    Cond                    _park_cond;
 };
 
 }
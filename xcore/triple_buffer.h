@@ -0,0 +1,123 @@
+/*
+ * triple_buffer.h - lock-free latest object hand-over template
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_TRIPLE_BUFFER_H
+#define XCAM_TRIPLE_BUFFER_H
+
+#include <xcam_std.h>
+#include <atomic>
+
+namespace XCam {
+
+/*
+ * TripleBuffer, single-producer single-consumer hand-over of the latest object.
+ * Three slots are owned by producer, consumer and latest, ownership moves by one
+ * atomic exchange, so neither side ever waits for the other.
+ * An object put before the consumer took the previous one replaces it and
+ * the replaced one is released in producer, e.g. buffer goes back to its pool.
+ */
+template<class OBj>
+class TripleBuffer {
+public:
+    typedef SmartPtr<OBj> ObjPtr;
+
+    explicit TripleBuffer ()
+        : _producer (0)
+        , _consumer (1)
+        , _latest (2)
+        , _dropped (0)
+    {}
+
+    // producer only
+    inline void put (const ObjPtr &obj);
+    // consumer only, NULL if nothing new since last take
+    inline ObjPtr take_latest ();
+
+    bool has_new () const {
+        return (_latest.load (std::memory_order_acquire) & FreshFlag) != 0;
+    }
+    // objects replaced before consumer took them
+    uint64_t get_dropped_count () const {
+        return _dropped.load ();
+    }
+    // neither side running
+    inline void clear ();
+
+private:
+    XCAM_DEAD_COPY (TripleBuffer);
+
+private:
+    enum {
+        IndexMask = 0x3,
+        FreshFlag = 0x4,
+    };
+
+    ObjPtr                      _slots[3];
+    uint32_t                    _producer;
+    uint32_t                    _consumer;
+    std::atomic<uint32_t>       _latest;
+    std::atomic<uint64_t>       _dropped;
+};
+
+template<class OBj>
+void
+TripleBuffer<OBj>::put (const TripleBuffer<OBj>::ObjPtr &obj)
+{
+    _slots[_producer] = obj;
+    uint32_t prev = _latest.exchange (_producer | FreshFlag, std::memory_order_acq_rel);
+    _producer = prev & IndexMask;
+
+    // consumer hands back emptied slots, a filled one was never taken
+    if (prev & FreshFlag) {
+        ++_dropped;
+        _slots[_producer].release ();
+    }
+}
+
+template<class OBj>
+typename TripleBuffer<OBj>::ObjPtr
+TripleBuffer<OBj>::take_latest ()
+{
+    // only consumer clears the flag, safe to check before exchange
+    if (!has_new ())
+        return NULL;
+
+    uint32_t prev = _latest.exchange (_consumer, std::memory_order_acq_rel);
+    _consumer = prev & IndexMask;
+
+    TripleBuffer<OBj>::ObjPtr obj = _slots[_consumer];
+    _slots[_consumer].release ();
+    return obj;
+}
+
+template<class OBj>
+void
+TripleBuffer<OBj>::clear ()
+{
+    for (uint32_t i = 0; i < 3; ++i)
+        _slots[i].release ();
+    _producer = 0;
+    _consumer = 1;
+    _latest = 2;
+}
+
+};
+
+#endif //XCAM_TRIPLE_BUFFER_H
@@ -20,9 +20,11 @@
 
 #include "v4l2_buffer_proxy.h"
 #include "v4l2_device.h"
+#include <unistd.h>
 
 namespace XCam {
 V4l2Buffer::V4l2Buffer (const struct v4l2_buffer &buf, const struct v4l2_format &format)
+    : _export_fd (-1)
 {
     _buf = buf;
     _format = format;
@@ -30,6 +32,8 @@ V4l2Buffer::V4l2Buffer (const struct v4l2_buffer &buf, const struct v4l2_format
 
 V4l2Buffer::~V4l2Buffer ()
 {
+    if (_export_fd >= 0)
+        close (_export_fd);
 }
 
 uint8_t *
@@ -49,6 +53,8 @@ V4l2Buffer::unmap ()
 int
 V4l2Buffer::get_fd ()
 {
+    if (_export_fd >= 0)
+        return _export_fd;
     if (_buf.memory == V4L2_MEMORY_MMAP)
         return -1;
     return _buf.m.fd;
@@ -110,6 +116,12 @@ V4l2BufferProxy::v4l2_format_to_video_info (
         info.offsets[0] = 0;
         info.aligned_width = info.strides [0] / 2;
         break;
+    case V4L2_PIX_FMT_MJPEG: // compressed, bytesused of v4l2 buffer is data size
+        info.components = 1;
+        info.strides [0] = format.fmt.pix.bytesperline;
+        info.offsets[0] = 0;
+        info.aligned_width = info.width;
+        break;
     case V4L2_PIX_FMT_SBGGR10:
     case V4L2_PIX_FMT_SGBRG10:
     case V4L2_PIX_FMT_SGRBG10:
@@ -128,6 +140,26 @@ V4l2BufferProxy::v4l2_format_to_video_info (
         info.strides [0] = format.fmt.pix.bytesperline;
         info.offsets[0] = 0;
         break;
+    case V4L2_PIX_FMT_SBGGR10P:
+    case V4L2_PIX_FMT_SGBRG10P:
+    case V4L2_PIX_FMT_SGRBG10P:
+    case V4L2_PIX_FMT_SRGGB10P:
+        info.color_bits = 10;
+        info.components = 1;
+        info.strides [0] = format.fmt.pix.bytesperline;
+        info.offsets[0] = 0;
+        info.aligned_width = info.strides [0] * 4 / 5;
+        break;
+    case V4L2_PIX_FMT_SBGGR12P:
+    case V4L2_PIX_FMT_SGBRG12P:
+    case V4L2_PIX_FMT_SGRBG12P:
+    case V4L2_PIX_FMT_SRGGB12P:
+        info.color_bits = 12;
+        info.components = 1;
+        info.strides [0] = format.fmt.pix.bytesperline;
+        info.offsets[0] = 0;
+        info.aligned_width = info.strides [0] * 2 / 3;
+        break;
     default:
         XCAM_LOG_WARNING (
             "unknown v4l2 format(%s) to video info",
@@ -67,6 +67,12 @@ public:
         return _format;
     }
 
+    // dma-buf fd exported from MMAP buffer, closed with buffer
+    void set_export_fd (int fd) {
+        XCAM_ASSERT (_export_fd < 0);
+        _export_fd = fd;
+    }
+
     // derived from BufferData
     virtual uint8_t *map ();
     virtual bool unmap ();
@@ -78,6 +84,7 @@ private:
 private:
     struct v4l2_buffer  _buf;
     struct v4l2_format  _format;
+    int                 _export_fd;
 };
 
 class V4l2BufferProxy
@@ -33,6 +33,8 @@
 namespace XCam {
 
 #define XCAM_V4L2_DEFAULT_BUFFER_COUNT  6
+// one buffer being filled and one queued, so driver never waits for downstream
+#define XCAM_V4L2_DRIVER_BUFFER_COUNT   2
 
 V4l2Device::V4l2Device (const char *name)
     : _name (NULL)
@@ -45,6 +47,11 @@ V4l2Device::V4l2Device (const char *name)
     , _fps_d (0)
     , _active (false)
     , _buf_count (XCAM_V4L2_DEFAULT_BUFFER_COUNT)
+    , _min_buf_count (0)
+    , _max_buf_count (0)
+    , _buf_in_use (0)
+    , _peak_buf_in_use (0)
+    , _dma_export (false)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -137,6 +144,29 @@ V4l2Device::set_buffer_count (uint32_t buf_count)
     return true;
 }
 
+bool
+V4l2Device::set_buffer_count_range (uint32_t min_count, uint32_t max_count)
+{
+    XCAM_FAIL_RETURN (
+        WARNING, !is_activated () && min_count > 0 && min_count <= max_count, false,
+        "device(%s) set buffer count range(%d, %d) failed", XCAM_STR (_name), min_count, max_count);
+
+    _min_buf_count = min_count;
+    _max_buf_count = max_count;
+    _buf_count = XCAM_CLAMP (_buf_count, min_count, max_count);
+    return true;
+}
+
+bool
+V4l2Device::set_dma_export (bool enable)
+{
+    if (is_activated ()) {
+        XCAM_LOG_WARNING ("device(%s) set dma export failed", XCAM_STR (_name));
+        return false;
+    }
+    _dma_export = enable;
+    return true;
+}
 
 XCamReturn
 V4l2Device::open ()
@@ -407,6 +437,8 @@ V4l2Device::start ()
         "device(%s) start failed", XCAM_STR (_name));
 
     //queue all buffers
+    _buf_in_use = _buf_count;
+    _peak_buf_in_use = 0;
     for (uint32_t i = 0; i < _buf_count; ++i) {
         SmartPtr<V4l2Buffer> &buf = _buf_pool [i];
         XCAM_ASSERT (buf.ptr());
@@ -443,6 +475,7 @@ V4l2Device::stop ()
             XCAM_LOG_WARNING ("device(%s) steamoff failed", XCAM_STR (_name));
         }
         _active = false;
+        adapt_buffer_count ();
     }
 
     fini_buffer_pool ();
@@ -451,6 +484,22 @@ V4l2Device::stop ()
     return XCAM_RETURN_NO_ERROR;
 }
 
+void
+V4l2Device::adapt_buffer_count ()
+{
+    if (!_max_buf_count || !_peak_buf_in_use)
+        return;
+
+    uint32_t count = XCAM_CLAMP (
+        _peak_buf_in_use + XCAM_V4L2_DRIVER_BUFFER_COUNT, _min_buf_count, _max_buf_count);
+    if (count != _buf_count) {
+        XCAM_LOG_INFO (
+            "device(%s) peak buffers in use:%d, buffer count %d -> %d on next start",
+            XCAM_STR (_name), _peak_buf_in_use.load (), _buf_count, count);
+        _buf_count = count;
+    }
+}
+
 XCamReturn
 V4l2Device::request_buffer ()
 {
@@ -484,6 +533,7 @@ V4l2Device::allocate_buffer (
     const uint32_t index)
 {
     struct v4l2_buffer v4l2_buf;
+    int export_fd = -1;
 
     xcam_mem_clear (v4l2_buf);
     v4l2_buf.index = index;
@@ -523,6 +573,19 @@ V4l2Device::allocate_buffer (
             return XCAM_RETURN_ERROR_MEM;
         }
         v4l2_buf.m.userptr = (uintptr_t) pointer;
+
+        if (_dma_export) {
+            struct v4l2_exportbuffer expbuf;
+            xcam_mem_clear (expbuf);
+            expbuf.type = _capture_buf_type;
+            expbuf.index = index;
+            expbuf.flags = O_CLOEXEC | O_RDWR;
+            if (io_control (VIDIOC_EXPBUF, &expbuf) < 0) {
+                XCAM_LOG_WARNING ("device(%s) export buf(%d) failed, buffer can only be mapped", XCAM_STR (_name), index);
+            } else {
+                export_fd = expbuf.fd;
+            }
+        }
     }
     break;
     case V4L2_MEMORY_USERPTR:
@@ -535,6 +598,8 @@ V4l2Device::allocate_buffer (
     }
 
     buf = new V4l2Buffer (v4l2_buf, _format);
+    if (export_fd >= 0)
+        buf->set_export_fd (export_fd);
 
     return XCAM_RETURN_NO_ERROR;
 }
@@ -607,6 +672,10 @@ V4l2Device::dequeue_buffer(SmartPtr<V4l2Buffer> &buf)
             XCAM_STR (_name), v4l2_buf.index);
         return XCAM_RETURN_ERROR_ISP;
     }
+    uint32_t in_use = ++_buf_in_use;
+    if (in_use > _peak_buf_in_use)
+        _peak_buf_in_use = in_use;
+
     buf = _buf_pool [v4l2_buf.index];
     buf->set_timestamp (v4l2_buf.timestamp);
     buf->set_timecode (v4l2_buf.timecode);
@@ -629,6 +698,7 @@ V4l2Device::queue_buffer (SmartPtr<V4l2Buffer> &buf)
         XCAM_LOG_ERROR("fail to enqueue buffer index:%d.", v4l2_buf.index);
         return XCAM_RETURN_ERROR_IOCTL;
     }
+    --_buf_in_use;
     return XCAM_RETURN_NO_ERROR;
 }
 
@@ -23,6 +23,7 @@
 
 #include <xcam_std.h>
 #include <linux/videodev2.h>
+#include <atomic>
 #include <list>
 #include <vector>
 
@@ -80,6 +81,13 @@ public:
     }
 
     bool set_buffer_count (uint32_t buf_count);
+    // buffer count of next start follows peak buffers held downstream, clamped in [min, max]
+    bool set_buffer_count_range (uint32_t min_count, uint32_t max_count);
+    uint32_t get_peak_buffers_in_use () const {
+        return _peak_buf_in_use;
+    }
+    // export MMAP buffers by VIDIOC_EXPBUF, VideoBuffer::get_fd returns dma-buf fd for import
+    bool set_dma_export (bool enable);
 
     // set_framerate must before set_format
     bool set_framerate (uint32_t n, uint32_t d);
@@ -120,6 +128,7 @@ private:
     XCamReturn request_buffer ();
     XCamReturn init_buffer_pool ();
     XCamReturn fini_buffer_pool ();
+    void adapt_buffer_count ();
 
     XCAM_DEAD_COPY (V4l2Device);
 
@@ -140,6 +149,11 @@ protected:
     // buffer pool
     BufferPool          _buf_pool;
     uint32_t            _buf_count;
+    uint32_t            _min_buf_count;
+    uint32_t            _max_buf_count;
+    std::atomic<uint32_t>  _buf_in_use;
+    std::atomic<uint32_t>  _peak_buf_in_use;
+    bool                _dma_export;
 
     XCamReturn buffer_new();
     XCamReturn buffer_del();
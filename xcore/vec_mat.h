@@ -22,7 +22,9 @@
 #define XCAM_VECTOR_MATRIX_H
 
 #include <xcam_std.h>
+#include <interface/data_types.h>
 #include <cmath>
+#include <stdlib.h>
 
 
 namespace XCam {
@@ -69,6 +71,7 @@ public:
 
     Vector2 () : x(0), y(0) {};
     Vector2 (T _x, T _y) : x(_x), y(_y) {};
+    Vector2 (const Vector2<T>& rhs) : x(rhs.x), y(rhs.y) {};
 
     template <typename New>
     Vector2<New> convert_to () const {
@@ -147,6 +150,7 @@ public:
     VectorN (T x, T y, T z);
     VectorN (T x, T y, T z, T w);
     VectorN (VectorN<T, 3> vec3, T w);
+    VectorN (const VectorN<T, N>& rhs);
 
     inline VectorN<T, N>& operator = (const VectorN<T, N>& rhs);
     inline VectorN<T, N> operator - () const;
@@ -247,6 +251,13 @@ VectorN<T, N>::VectorN (VectorN<T, 3> vec3, T w) {
     }
 }
 
+template<class T, uint32_t N> inline
+VectorN<T, N>::VectorN (const VectorN<T, N>& rhs) {
+    for (uint32_t i = 0; i < N; i++) {
+        data[i] = rhs.data[i];
+    }
+}
+
 template<class T, uint32_t N> inline
 VectorN<T, N>& VectorN<T, N>::operator = (const VectorN<T, N>& rhs) {
     for (uint32_t i = 0; i < N; i++) {
@@ -512,6 +523,7 @@ public:
     MatrixN (VectorN<T, 2> a, VectorN<T, 2> b);
     MatrixN (VectorN<T, 3> a, VectorN<T, 3> b, VectorN<T, 3> c);
     MatrixN (VectorN<T, 4> a, VectorN<T, 4> b, VectorN<T, 4> c, VectorN<T, 4> d);
+    MatrixN (const MatrixN<T, N>& rhs);
 
     inline void zeros ();
     inline void eye ();
@@ -628,6 +640,13 @@ void MatrixN<T, N>::eye () {
     }
 }
 
+template<class T, uint32_t N>
+MatrixN<T, N>::MatrixN (const MatrixN<T, N>& rhs) {
+    for (uint32_t i = 0; i < N * N; i++) {
+        data[i] = rhs.data[i];
+    }
+}
+
 template<class T, uint32_t N> inline
 MatrixN<T, N>& MatrixN<T, N>::operator = (const MatrixN<T, N>& rhs) {
     for (uint32_t i = 0; i < N * N; i++) {
@@ -703,7 +722,7 @@ VectorN<T, N> MatrixN<T, N>::operator * (const VectorN<T, N>& rhs) const {
     VectorN<T, N> result;
     for (uint32_t i = 0; i < N; i++) {  // row
         for (uint32_t j = 0; j < N; j++) {  // col
-            result.data[i] = data[i * N + j] * rhs.data[j];
+            result[i] += data[i * N + j] * rhs[j];
         }
     }
     return result;
@@ -948,6 +967,190 @@ typedef VectorN<float, 4> Vec4f;
 typedef MatrixN<float, 3> Mat3f;
 typedef MatrixN<float, 4> Mat4f;
 
+// bytes, one AVX register
+#define XCAM_SOA_ALIGNMENT 32
+
+/*
+ * 3D points in SoA layout for batch math, x, y and z are separate aligned arrays
+ * padded to XCAM_SOA_ALIGNMENT, so the loops below compile to vector instructions.
+ */
+class Vec3fArray
+{
+public:
+    explicit Vec3fArray (uint32_t count = 0)
+        : _buf (NULL), _count (0), _stride (0)
+    {
+        resize (count);
+    }
+    ~Vec3fArray () {
+        free (_buf);
+    }
+
+    inline bool resize (uint32_t count);
+    uint32_t size () const {
+        return _count;
+    }
+
+    float *x () {
+        return _buf;
+    }
+    float *y () {
+        return _buf + _stride;
+    }
+    float *z () {
+        return _buf + _stride * 2;
+    }
+    const float *x () const {
+        return _buf;
+    }
+    const float *y () const {
+        return _buf + _stride;
+    }
+    const float *z () const {
+        return _buf + _stride * 2;
+    }
+
+    void set (uint32_t i, const PointFloat3 &point) {
+        XCAM_ASSERT (i < _count);
+        x ()[i] = point.x;
+        y ()[i] = point.y;
+        z ()[i] = point.z;
+    }
+    PointFloat3 get (uint32_t i) const {
+        XCAM_ASSERT (i < _count);
+        return PointFloat3 (x ()[i], y ()[i], z ()[i]);
+    }
+
+    // from and to PointFloat3 arrays of size () points
+    inline void load (const PointFloat3 *points);
+    inline void store (PointFloat3 *points) const;
+
+private:
+    XCAM_DEAD_COPY (Vec3fArray);
+
+private:
+    float        *_buf;
+    uint32_t      _count;
+    uint32_t      _stride;
+};
+
+bool
+Vec3fArray::resize (uint32_t count)
+{
+    if (count == _count)
+        return true;
+
+    free (_buf);
+    _buf = NULL;
+    _count = _stride = 0;
+    if (!count)
+        return true;
+
+    uint32_t stride = XCAM_ALIGN_UP (count, XCAM_SOA_ALIGNMENT / sizeof (float));
+    void *buf = NULL;
+    XCAM_FAIL_RETURN (
+        ERROR, posix_memalign (&buf, XCAM_SOA_ALIGNMENT, stride * 3 * sizeof (float)) == 0, false,
+        "Vec3fArray allocate %d points failed", count);
+
+    _buf = (float *) buf;
+    _count = count;
+    _stride = stride;
+    return true;
+}
+
+void
+Vec3fArray::load (const PointFloat3 *points)
+{
+    float *px = x (), *py = y (), *pz = z ();
+    for (uint32_t i = 0; i < _count; ++i) {
+        px[i] = points[i].x;
+        py[i] = points[i].y;
+        pz[i] = points[i].z;
+    }
+}
+
+void
+Vec3fArray::store (PointFloat3 *points) const
+{
+    const float *px = x (), *py = y (), *pz = z ();
+    for (uint32_t i = 0; i < _count; ++i) {
+        points[i].x = px[i];
+        points[i].y = py[i];
+        points[i].z = pz[i];
+    }
+}
+
+// out = mat * in, in and out have same size and may be the same array
+inline void
+transform_points (const Mat3f &mat, const Vec3fArray &in, Vec3fArray &out)
+{
+    XCAM_ASSERT (in.size () == out.size ());
+    const float m00 = mat (0, 0), m01 = mat (0, 1), m02 = mat (0, 2);
+    const float m10 = mat (1, 0), m11 = mat (1, 1), m12 = mat (1, 2);
+    const float m20 = mat (2, 0), m21 = mat (2, 1), m22 = mat (2, 2);
+    const float *ix = in.x (), *iy = in.y (), *iz = in.z ();
+    float *ox = out.x (), *oy = out.y (), *oz = out.z ();
+
+    for (uint32_t i = 0; i < in.size (); ++i) {
+        float px = ix[i], py = iy[i], pz = iz[i];
+        ox[i] = m00 * px + m01 * py + m02 * pz;
+        oy[i] = m10 * px + m11 * py + m12 * pz;
+        oz[i] = m20 * px + m21 * py + m22 * pz;
+    }
+}
+
+// affine transform with w = 1, last row of mat is ignored
+inline void
+transform_points (const Mat4f &mat, const Vec3fArray &in, Vec3fArray &out)
+{
+    XCAM_ASSERT (in.size () == out.size ());
+    const float m00 = mat (0, 0), m01 = mat (0, 1), m02 = mat (0, 2), m03 = mat (0, 3);
+    const float m10 = mat (1, 0), m11 = mat (1, 1), m12 = mat (1, 2), m13 = mat (1, 3);
+    const float m20 = mat (2, 0), m21 = mat (2, 1), m22 = mat (2, 2), m23 = mat (2, 3);
+    const float *ix = in.x (), *iy = in.y (), *iz = in.z ();
+    float *ox = out.x (), *oy = out.y (), *oz = out.z ();
+
+    for (uint32_t i = 0; i < in.size (); ++i) {
+        float px = ix[i], py = iy[i], pz = iz[i];
+        ox[i] = m00 * px + m01 * py + m02 * pz + m03;
+        oy[i] = m10 * px + m11 * py + m12 * pz + m13;
+        oz[i] = m20 * px + m21 * py + m22 * pz + m23;
+    }
+}
+
+// pinhole projection, (u, v) = (mat * in).xy / (mat * in).z; points with z == 0 get (0, 0)
+inline void
+project_points (const Mat3f &mat, const Vec3fArray &in, float *u, float *v)
+{
+    const float m00 = mat (0, 0), m01 = mat (0, 1), m02 = mat (0, 2);
+    const float m10 = mat (1, 0), m11 = mat (1, 1), m12 = mat (1, 2);
+    const float m20 = mat (2, 0), m21 = mat (2, 1), m22 = mat (2, 2);
+    const float *ix = in.x (), *iy = in.y (), *iz = in.z ();
+
+    for (uint32_t i = 0; i < in.size (); ++i) {
+        float px = ix[i], py = iy[i], pz = iz[i];
+        float w = m20 * px + m21 * py + m22 * pz;
+        float inv_w = (w != 0.0f) ? 1.0f / w : 0.0f;
+        u[i] = (m00 * px + m01 * py + m02 * pz) * inv_w;
+        v[i] = (m10 * px + m11 * py + m12 * pz) * inv_w;
+    }
+}
+
+// unit length in place, zero vectors stay zero
+inline void
+normalize_points (Vec3fArray &vecs)
+{
+    float *px = vecs.x (), *py = vecs.y (), *pz = vecs.z ();
+
+    for (uint32_t i = 0; i < vecs.size (); ++i) {
+        float len = sqrtf (px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+        float inv_len = (len > 0.0f) ? 1.0f / len : 0.0f;
+        px[i] *= inv_len;
+        py[i] *= inv_len;
+        pz[i] *= inv_len;
+    }
+}
+
 template<class T>
 class Quaternion
 {
@@ -83,18 +83,25 @@ VideoBuffer::~VideoBuffer ()
 bool
 VideoBuffer::attach_buffer (const SmartPtr<VideoBuffer>& buf)
 {
-    _attached_bufs.push_back (buf);
+    return attach_tagged (buf, xcam_type_tag<VideoBuffer> ());
+}
+
+bool
+VideoBuffer::attach_tagged (const SmartPtr<VideoBuffer>& buf, const void *tag)
+{
+    AttachEntry entry;
+    entry.buf = buf;
+    entry.tag = tag;
+    _attached_bufs.push_back (entry);
     return true;
 }
 
 bool
 VideoBuffer::detach_buffer (const SmartPtr<VideoBuffer>& buf)
 {
-    for (VideoBufferList::iterator iter = _attached_bufs.begin ();
-            iter != _attached_bufs.end (); ++iter) {
-        SmartPtr<VideoBuffer>& current = *iter;
-        if (current.ptr () == buf.ptr ()) {
-            _attached_bufs.erase (iter);
+    for (uint32_t i = 0; i < _attached_bufs.size (); ++i) {
+        if (_attached_bufs[i].buf.ptr () == buf.ptr ()) {
+            _attached_bufs.erase (i);
             return true;
         }
     }
@@ -106,8 +113,9 @@ VideoBuffer::detach_buffer (const SmartPtr<VideoBuffer>& buf)
 bool
 VideoBuffer::copy_attaches (const SmartPtr<VideoBuffer>& buf)
 {
-    _attached_bufs.insert (
-        _attached_bufs.end (), buf->_attached_bufs.begin (), buf->_attached_bufs.end ());
+    const AttachArray &attaches = buf->_attached_bufs;
+    for (uint32_t i = 0; i < attaches.size (); ++i)
+        _attached_bufs.push_back (attaches[i]);
     return true;
 }
 
@@ -120,18 +128,25 @@ VideoBuffer::clear_attached_buffers ()
 bool
 VideoBuffer::add_metadata (const SmartPtr<MetaData>& data)
 {
-    _metadata_list.push_back (data);
+    return add_tagged_metadata (data, xcam_type_tag<MetaData> ());
+}
+
+bool
+VideoBuffer::add_tagged_metadata (const SmartPtr<MetaData>& data, const void *tag)
+{
+    MetaEntry entry;
+    entry.data = data;
+    entry.tag = tag;
+    _metadata_list.push_back (entry);
     return true;
 }
 
 bool
 VideoBuffer::remove_metadata (const SmartPtr<MetaData>& data)
 {
-    for (MetaDataList::iterator iter = _metadata_list.begin ();
-            iter != _metadata_list.end (); ++iter) {
-        SmartPtr<MetaData>& current = *iter;
-        if (current.ptr () == data.ptr ()) {
-            _metadata_list.erase (iter);
+    for (uint32_t i = 0; i < _metadata_list.size (); ++i) {
+        if (_metadata_list[i].data.ptr () == data.ptr ()) {
+            _metadata_list.erase (i);
             return true;
         }
     }
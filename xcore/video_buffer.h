@@ -23,9 +23,13 @@
 
 #include <xcam_std.h>
 #include <meta_data.h>
+#include <small_vector.h>
 #include <base/xcam_buffer.h>
 #include <list>
 
+// attachments and metadata kept inline before spilling to heap
+#define XCAM_VIDEO_BUFFER_INLINE_ATTACHES 4
+
 namespace XCam {
 
 class VideoBuffer;
@@ -53,6 +57,22 @@ struct VideoBufferInfo
 };
 
 class VideoBuffer {
+    // tag is the static type given at attach, matched before falling back to dynamic_cast
+    struct AttachEntry {
+        SmartPtr<VideoBuffer>    buf;
+        const void              *tag;
+
+        AttachEntry () : tag (NULL) {}
+    };
+    struct MetaEntry {
+        SmartPtr<MetaData>       data;
+        const void              *tag;
+
+        MetaEntry () : tag (NULL) {}
+    };
+    typedef SmallVector<AttachEntry, XCAM_VIDEO_BUFFER_INLINE_ATTACHES> AttachArray;
+    typedef SmallVector<MetaEntry, XCAM_VIDEO_BUFFER_INLINE_ATTACHES> MetaArray;
+
 public:
     explicit VideoBuffer (int64_t timestamp = InvalidTimestamp)
         : _timestamp (timestamp)
@@ -91,6 +111,10 @@ public:
     }
 
     bool attach_buffer (const SmartPtr<VideoBuffer>& buf);
+    template <typename BufType>
+    bool attach_buffer (const SmartPtr<BufType>& buf) {
+        return attach_tagged (buf, xcam_type_tag<BufType> ());
+    }
     bool detach_buffer (const SmartPtr<VideoBuffer>& buf);
     bool copy_attaches (const SmartPtr<VideoBuffer>& buf);
     void clear_attached_buffers ();
@@ -99,6 +123,10 @@ public:
     SmartPtr<BufType> find_typed_attach ();
 
     bool add_metadata (const SmartPtr<MetaData>& data);
+    template <typename MetaType>
+    bool add_metadata (const SmartPtr<MetaType>& data) {
+        return add_tagged_metadata (data, xcam_type_tag<MetaType> ());
+    }
     bool remove_metadata (const SmartPtr<MetaData>& data);
     void clear_all_metadata ();
 
@@ -106,11 +134,14 @@ public:
     SmartPtr<MetaType> find_typed_metadata ();
 
 private:
+    bool attach_tagged (const SmartPtr<VideoBuffer>& buf, const void *tag);
+    bool add_tagged_metadata (const SmartPtr<MetaData>& data, const void *tag);
+
     XCAM_DEAD_COPY (VideoBuffer);
 
 protected:
-    VideoBufferList           _attached_bufs;
-    MetaDataList              _metadata_list;
+    AttachArray               _attached_bufs;
+    MetaArray                 _metadata_list;
 
 private:
     VideoBufferInfo           _videoinfo;
@@ -122,9 +153,13 @@ private:
 template <typename BufType>
 SmartPtr<BufType> VideoBuffer::find_typed_attach ()
 {
-    for (VideoBufferList::iterator iter = _attached_bufs.begin ();
-            iter != _attached_bufs.end (); ++iter) {
-        SmartPtr<BufType> buf = (*iter).dynamic_cast_ptr<BufType> ();
+    const void *tag = xcam_type_tag<BufType> ();
+    for (uint32_t i = 0; i < _attached_bufs.size (); ++i) {
+        const AttachEntry &entry = _attached_bufs[i];
+        if (entry.tag == tag)
+            return entry.buf.static_cast_ptr<BufType> ();
+
+        SmartPtr<BufType> buf = entry.buf.dynamic_cast_ptr<BufType> ();
         if (buf.ptr ())
             return buf;
     }
@@ -135,17 +170,23 @@ SmartPtr<BufType> VideoBuffer::find_typed_attach ()
 template <typename MetaType>
 SmartPtr<MetaType> VideoBuffer::find_typed_metadata ()
 {
-    for (MetaDataList::iterator iter = _metadata_list.begin ();
-            iter != _metadata_list.end (); ++iter) {
-        SmartPtr<MetaType> buf = (*iter).dynamic_cast_ptr<MetaType> ();
-        if (buf.ptr ())
-            return buf;
+    const void *tag = xcam_type_tag<MetaType> ();
+    for (uint32_t i = 0; i < _metadata_list.size (); ++i) {
+        const MetaEntry &entry = _metadata_list[i];
+        if (entry.tag == tag)
+            return entry.data.static_cast_ptr<MetaType> ();
+
+        SmartPtr<MetaType> data = entry.data.dynamic_cast_ptr<MetaType> ();
+        if (data.ptr ())
+            return data;
     }
 
     return NULL;
 }
 
 XCamVideoBuffer *convert_to_external_buffer (const SmartPtr<VideoBuffer> &buf);
+// VideoBuffer wrapped by convert_to_external_buffer, NULL for other external buffers
+SmartPtr<VideoBuffer> external_buf_to_video_buf (XCamVideoBuffer *buf);
 
 };
 
@@ -21,9 +21,82 @@
 #include "xcam_analyzer.h"
 #include "x3a_analyzer.h"
 #include "x3a_stats_pool.h"
+#include "thread_pool.h"
+#include <math.h>
+
+#define XCAM_3A_HANDLER_COUNT 4
 
 namespace XCam {
 
+static const char *handler_failures[XCAM_3A_HANDLER_COUNT] = {
+    "ae calculation failed",
+    "awb calculation failed",
+    "af calculation failed",
+    "3a other calculation failed"
+};
+
+class HandlerSync {
+public:
+    explicit HandlerSync (uint32_t count)
+        : _remain (count)
+    {}
+    void done () {
+        SmartLock locker (_mutex);
+        if (--_remain == 0)
+            _cond.broadcast ();
+    }
+    void wait () {
+        SmartLock locker (_mutex);
+        while (_remain)
+            _cond.wait (_mutex);
+    }
+
+private:
+    XCAM_DEAD_COPY (HandlerSync);
+
+private:
+    uint32_t          _remain;
+    Mutex             _mutex;
+    XCam::Cond        _cond;
+};
+
+class HandlerWork
+    : public ThreadPool::UserData
+{
+public:
+    HandlerWork (
+        AnalyzerHandler *handler, X3aResultList &results, XCamReturn &ret, const SmartPtr<HandlerSync> &sync)
+        : _handler (handler)
+        , _results (results)
+        , _ret (ret)
+        , _sync (sync)
+    {}
+
+    virtual XCamReturn run () {
+        _ret = _handler->analyze (_results);
+        return _ret;
+    }
+    virtual void done (XCamReturn err) {
+        XCAM_UNUSED (err);
+        _sync->done ();
+    }
+
+private:
+    AnalyzerHandler         *_handler;
+    X3aResultList           &_results;
+    XCamReturn              &_ret;
+    SmartPtr<HandlerSync>    _sync;
+};
+
+// keeps the latest ratio going on, value never changes sign
+static double
+extrapolate_value (double prev, double latest, double ratio)
+{
+    if (prev <= 0.0 || latest <= 0.0)
+        return latest;
+    return latest * pow (latest / prev, ratio);
+}
+
 X3aAnalyzer::X3aAnalyzer (const char *name)
     : XAnalyzer (name)
     , _brightness_level_param (0.0)
@@ -31,11 +104,20 @@ X3aAnalyzer::X3aAnalyzer (const char *name)
     , _awb_handler (NULL)
     , _af_handler (NULL)
     , _common_handler (NULL)
+    , _extrapolate (false)
+    , _exposure_bases (0)
+    , _exposure_process_type (XCAM_IMAGE_PROCESS_ALWAYS)
+    , _wb_bases (0)
+    , _wb_process_type (XCAM_IMAGE_PROCESS_ALWAYS)
 {
+    xcam_mem_clear (_exposure);
+    xcam_mem_clear (_wb);
 }
 
 X3aAnalyzer::~X3aAnalyzer()
 {
+    if (_handler_pool.ptr ())
+        _handler_pool->stop ();
 }
 
 XCamReturn
@@ -93,12 +175,140 @@ X3aAnalyzer::analyze (const SmartPtr<VideoBuffer> &buffer)
     return analyze_3a_statistics (stats);
 }
 
+XCamReturn
+X3aAnalyzer::skip (const SmartPtr<VideoBuffer> &buffer, uint32_t frames_since)
+{
+    if (!_extrapolate || (_exposure_bases < 2 && _wb_bases < 2))
+        return XCAM_RETURN_BYPASS;
+
+    X3aResultList results;
+    double ratio = (double)frames_since / get_analysis_interval ();
+
+    if (_exposure_bases >= 2) {
+        const XCam3aResultExposure &prev = _exposure[0];
+        const XCam3aResultExposure &latest = _exposure[1];
+        XCam3aResultExposure exposure = latest;
+        exposure.exposure_time = (int32_t) (extrapolate_value (prev.exposure_time, latest.exposure_time, ratio) + 0.5);
+        exposure.analog_gain = extrapolate_value (prev.analog_gain, latest.analog_gain, ratio);
+        exposure.digital_gain = extrapolate_value (prev.digital_gain, latest.digital_gain, ratio);
+
+        SmartPtr<X3aExposureResult> result =
+            new X3aExposureResult (XCAM_3A_RESULT_EXPOSURE, _exposure_process_type);
+        result->set_standard_result (exposure);
+        results.push_back (result);
+    }
+
+    if (_wb_bases >= 2) {
+        const XCam3aResultWhiteBalance &prev = _wb[0];
+        const XCam3aResultWhiteBalance &latest = _wb[1];
+        XCam3aResultWhiteBalance wb = latest;
+        wb.r_gain = extrapolate_value (prev.r_gain, latest.r_gain, ratio);
+        wb.gr_gain = extrapolate_value (prev.gr_gain, latest.gr_gain, ratio);
+        wb.gb_gain = extrapolate_value (prev.gb_gain, latest.gb_gain, ratio);
+        wb.b_gain = extrapolate_value (prev.b_gain, latest.b_gain, ratio);
+
+        SmartPtr<X3aWhiteBalanceResult> result =
+            new X3aWhiteBalanceResult (XCAM_3A_RESULT_WHITE_BALANCE, _wb_process_type);
+        result->set_standard_result (wb);
+        results.push_back (result);
+    }
+
+    set_results_timestamp (results, buffer->get_timestamp ());
+    notify_calculation_done (results);
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 X3aAnalyzer::push_3a_stats (const SmartPtr<X3aStats> &stats)
 {
     return XAnalyzer::push_buffer (stats);
 }
 
+bool
+X3aAnalyzer::set_results_extrapolation (bool enable)
+{
+    _extrapolate = enable;
+    _exposure_bases = 0;
+    _wb_bases = 0;
+    return true;
+}
+
+bool
+X3aAnalyzer::set_parallel_handlers (bool enable)
+{
+    if (!enable) {
+        if (_handler_pool.ptr ())
+            _handler_pool->stop ();
+        _handler_pool.release ();
+        return true;
+    }
+
+    XCAM_FAIL_RETURN (
+        WARNING, handlers_independent (), false,
+        "analyzer(%s) handlers share state, can't run in parallel", XCAM_STR (get_name ()));
+    if (_handler_pool.ptr ())
+        return true;
+
+    // analyzer thread runs ae itself
+    SmartPtr<ThreadPool> pool = new ThreadPool ("X3aHandlers");
+    pool->set_threads (XCAM_3A_HANDLER_COUNT - 1, XCAM_3A_HANDLER_COUNT - 1);
+    XCAM_FAIL_RETURN (
+        WARNING, xcam_ret_is_ok (pool->start ()), false,
+        "analyzer(%s) start handler threads failed", XCAM_STR (get_name ()));
+
+    _handler_pool = pool;
+    return true;
+}
+
+void
+X3aAnalyzer::run_handlers_parallel (
+    AnalyzerHandler **handlers, X3aResultList *results, XCamReturn *rets, uint32_t count)
+{
+    SmartPtr<HandlerSync> sync = new HandlerSync (count - 1);
+
+    for (uint32_t i = 1; i < count; ++i) {
+        SmartPtr<ThreadPool::UserData> work = new HandlerWork (handlers[i], results[i], rets[i], sync);
+        if (!xcam_ret_is_ok (_handler_pool->queue (work))) {
+            rets[i] = handlers[i]->analyze (results[i]);
+            sync->done ();
+        }
+    }
+
+    rets[0] = handlers[0]->analyze (results[0]);
+    sync->wait ();
+}
+
+void
+X3aAnalyzer::keep_extrapolation_bases (X3aResultList &results)
+{
+    SmartPtr<X3aExposureResult> exposure;
+    SmartPtr<X3aWhiteBalanceResult> wb;
+
+    for (X3aResultList::iterator i_res = results.begin (); i_res != results.end (); ++i_res) {
+        if ((*i_res)->get_type () == XCAM_3A_RESULT_EXPOSURE)
+            exposure = (*i_res).dynamic_cast_ptr<X3aExposureResult> ();
+        else if ((*i_res)->get_type () == XCAM_3A_RESULT_WHITE_BALANCE)
+            wb = (*i_res).dynamic_cast_ptr<X3aWhiteBalanceResult> ();
+    }
+
+    // no new result means converged, nothing to extrapolate
+    if (exposure.ptr ()) {
+        _exposure[0] = _exposure[1];
+        _exposure[1] = exposure->get_standard_result ();
+        _exposure_process_type = exposure->get_process_type ();
+        _exposure_bases = XCAM_MIN (_exposure_bases + 1, 2u);
+    } else
+        _exposure_bases = 0;
+
+    if (wb.ptr ()) {
+        _wb[0] = _wb[1];
+        _wb[1] = wb->get_standard_result ();
+        _wb_process_type = wb->get_process_type ();
+        _wb_bases = XCAM_MIN (_wb_bases + 1, 2u);
+    } else
+        _wb_bases = 0;
+}
+
 
 XCamReturn
 X3aAnalyzer::analyze_3a_statistics (SmartPtr<X3aStats> &stats)
@@ -113,32 +323,29 @@ X3aAnalyzer::analyze_3a_statistics (SmartPtr<X3aStats> &stats)
         return ret;
     }
 
-    ret = _ae_handler->analyze (results);
-    if (ret != XCAM_RETURN_NO_ERROR) {
-        notify_calculation_failed(
-            _ae_handler.ptr(), stats->get_timestamp (), "ae calculation failed");
-        return ret;
-    }
-
-    ret = _awb_handler->analyze (results);
-    if (ret != XCAM_RETURN_NO_ERROR) {
-        notify_calculation_failed(
-            _awb_handler.ptr(), stats->get_timestamp (), "awb calculation failed");
-        return ret;
-    }
-
-    ret = _af_handler->analyze (results);
-    if (ret != XCAM_RETURN_NO_ERROR) {
-        notify_calculation_failed(
-            _af_handler.ptr(), stats->get_timestamp (), "af calculation failed");
-        return ret;
+    AnalyzerHandler *handlers[XCAM_3A_HANDLER_COUNT] = {
+        _ae_handler.ptr (), _awb_handler.ptr (), _af_handler.ptr (), _common_handler.ptr ()
+    };
+    X3aResultList handler_results[XCAM_3A_HANDLER_COUNT];
+    XCamReturn rets[XCAM_3A_HANDLER_COUNT];
+
+    if (_handler_pool.ptr ()) {
+        run_handlers_parallel (handlers, handler_results, rets, XCAM_3A_HANDLER_COUNT);
+    } else {
+        for (uint32_t i = 0; i < XCAM_3A_HANDLER_COUNT; ++i) {
+            rets[i] = handlers[i]->analyze (handler_results[i]);
+            if (rets[i] != XCAM_RETURN_NO_ERROR)
+                break;
+        }
     }
 
-    ret = _common_handler->analyze (results);
-    if (ret != XCAM_RETURN_NO_ERROR) {
-        notify_calculation_failed(
-            _common_handler.ptr(), stats->get_timestamp (), "3a other calculation failed");
-        return ret;
+    // same order as serial run whichever handler finished first
+    for (uint32_t i = 0; i < XCAM_3A_HANDLER_COUNT; ++i) {
+        if (rets[i] != XCAM_RETURN_NO_ERROR) {
+            notify_calculation_failed (handlers[i], stats->get_timestamp (), handler_failures[i]);
+            return rets[i];
+        }
+        results.splice (results.end (), handler_results[i]);
     }
 
     ret = post_3a_analyze (results);
@@ -148,6 +355,9 @@ X3aAnalyzer::analyze_3a_statistics (SmartPtr<X3aStats> &stats)
         return ret;
     }
 
+    if (_extrapolate && get_analysis_interval () > 1)
+        keep_extrapolation_bases (results);
+
     if (!results.empty ()) {
         set_results_timestamp(results, stats->get_timestamp ());
         notify_calculation_done (results);
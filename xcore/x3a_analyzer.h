@@ -30,6 +30,7 @@ namespace XCam {
 class X3aStats;
 class AnalyzerThread;
 class VideoBuffer;
+class ThreadPool;
 
 class X3aAnalyzer
     : public XAnalyzer
@@ -41,6 +42,12 @@ public:
 
     /* analyze 3A statistics */
     XCamReturn push_3a_stats (const SmartPtr<X3aStats> &stats);
+    // stats skipped by analysis interval get AE and AWB results extrapolated
+    // from the last two analyzed results, set before start
+    bool set_results_extrapolation (bool enable);
+    // runs ae, awb, af and common handlers concurrently if handlers_independent (),
+    // results are merged in that order, set before start
+    bool set_parallel_handlers (bool enable);
 
     /* AWB */
     bool set_awb_mode (XCamAwbMode mode);
@@ -110,6 +117,7 @@ protected:
     virtual XCamReturn release_handlers ();
     virtual XCamReturn configure ();
     virtual XCamReturn analyze (const SmartPtr<VideoBuffer> &buffer);
+    virtual XCamReturn skip (const SmartPtr<VideoBuffer> &buffer, uint32_t frames_since);
 
     virtual SmartPtr<AeHandler> create_ae_handler () = 0;
     virtual SmartPtr<AwbHandler> create_awb_handler () = 0;
@@ -124,9 +132,16 @@ protected:
     virtual XCamReturn pre_3a_analyze (SmartPtr<X3aStats> &stats) = 0;
     // @param[out]  results,   new 3a results merged into \c results
     virtual XCamReturn post_3a_analyze (X3aResultList &results) = 0;
+    // handlers share no state and may run in different threads
+    virtual bool handlers_independent () const {
+        return false;
+    }
 
 private:
     XCamReturn analyze_3a_statistics (SmartPtr<X3aStats> &stats);
+    void keep_extrapolation_bases (X3aResultList &results);
+    void run_handlers_parallel (
+        AnalyzerHandler **handlers, X3aResultList *results, XCamReturn *rets, uint32_t count);
 
     XCAM_DEAD_COPY (X3aAnalyzer);
 
@@ -138,6 +153,16 @@ private:
     SmartPtr<AwbHandler>     _awb_handler;
     SmartPtr<AfHandler>      _af_handler;
     SmartPtr<CommonHandler>  _common_handler;
+    SmartPtr<ThreadPool>     _handler_pool;
+
+    // [0] previous, [1] latest analyzed results
+    bool                     _extrapolate;
+    uint32_t                 _exposure_bases;
+    XCam3aResultExposure     _exposure[2];
+    XCamImageProcessType     _exposure_process_type;
+    uint32_t                 _wb_bases;
+    XCam3aResultWhiteBalance _wb[2];
+    XCamImageProcessType     _wb_process_type;
 };
 
 }
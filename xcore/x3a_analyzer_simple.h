@@ -58,6 +58,9 @@ protected:
     virtual XCamReturn configure_3a ();
     virtual XCamReturn pre_3a_analyze (SmartPtr<X3aStats> &stats);
     virtual XCamReturn post_3a_analyze (X3aResultList &results);
+    virtual bool handlers_independent () const {
+        return true;
+    }
 
 public:
     XCamReturn analyze_ae (X3aResultList &output);
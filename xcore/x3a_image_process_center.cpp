@@ -125,6 +125,7 @@ X3aImageProcessCenter::put_3a_results (X3aResultList &results)
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     XCAM_FAIL_RETURN (ERROR, !results.empty(), XCAM_RETURN_ERROR_PARAM, "results empty");
+    ImageProcessor::coalesce_results (results);
 
     for (ImageProcessorIter i_pro = _image_processors.begin();
             i_pro != _image_processors.end(); i_pro++) {
@@ -19,9 +19,91 @@
  */
 
 #include "x3a_result.h"
+#include "xcam_mutex.h"
+#include <vector>
+
+// free objects kept of each size, result types are few and sizes fixed
+#define XCAM_3A_RESULT_RECYCLE_COUNT 16
 
 namespace XCam {
 
+class X3aResultRecycler
+{
+    struct Bucket {
+        size_t               size;
+        std::vector<void *>  free_list;
+    };
+
+public:
+    static X3aResultRecycler *instance () {
+        // never destroyed, static results may be released at exit
+        static X3aResultRecycler *recycler = new X3aResultRecycler;
+        return recycler;
+    }
+
+    void *get (size_t size) {
+        {
+            SmartLock locker (_mutex);
+            Bucket *bucket = find_bucket (size);
+            if (bucket && !bucket->free_list.empty ()) {
+                void *ptr = bucket->free_list.back ();
+                bucket->free_list.pop_back ();
+                return ptr;
+            }
+        }
+        return ::operator new (size);
+    }
+
+    void put (void *ptr, size_t size) {
+        {
+            SmartLock locker (_mutex);
+            Bucket *bucket = find_bucket (size);
+            if (!bucket) {
+                _buckets.push_back (Bucket ());
+                bucket = &_buckets.back ();
+                bucket->size = size;
+                bucket->free_list.reserve (XCAM_3A_RESULT_RECYCLE_COUNT);
+            }
+            if (bucket->free_list.size () < XCAM_3A_RESULT_RECYCLE_COUNT) {
+                bucket->free_list.push_back (ptr);
+                return;
+            }
+        }
+        ::operator delete (ptr);
+    }
+
+private:
+    X3aResultRecycler () {}
+
+    Bucket *find_bucket (size_t size) {
+        for (size_t i = 0; i < _buckets.size (); ++i) {
+            if (_buckets[i].size == size)
+                return &_buckets[i];
+        }
+        return NULL;
+    }
+
+    XCAM_DEAD_COPY (X3aResultRecycler);
+
+private:
+    std::vector<Bucket>    _buckets;
+    Mutex                  _mutex;
+};
+
+void *
+X3aResult::operator new (size_t size)
+{
+    return X3aResultRecycler::instance ()->get (size);
+}
+
+void
+X3aResult::operator delete (void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+    X3aResultRecycler::instance ()->put (ptr, size);
+}
+
 void
 x3a_list_remove_result (X3aResultList &list, uint32_t type)
 {
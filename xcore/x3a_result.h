@@ -28,7 +28,11 @@
 
 namespace XCam {
 
+/* !
+ * objects are recycled by size once released, so steady 3a loops don't go to heap.
+ */
 class X3aResult
+    : public RefObj
 {
 protected:
     explicit X3aResult (
@@ -46,6 +50,9 @@ protected:
 public:
     virtual ~X3aResult() {}
 
+    static void *operator new (size_t size);
+    static void operator delete (void *ptr, size_t size);
+
     void *get_ptr () const {
         return _ptr;
     }
@@ -105,10 +112,13 @@ class X3aStandardResultT
 public:
     explicit X3aStandardResultT (uint32_t type, XCamImageProcessType process_type = XCAM_IMAGE_PROCESS_ALWAYS, uint32_t extra_size = 0)
         : X3aResult (type, process_type)
-        , _result (NULL)
+        , _result (&_inline_result)
         , _extra_size (extra_size)
     {
-        _result = (StandardResult *) xcam_malloc0 (sizeof (StandardResult) + _extra_size);
+        // only variable sized results need payload from heap
+        xcam_mem_clear (_inline_result);
+        if (_extra_size)
+            _result = (StandardResult *) xcam_malloc0 (sizeof (StandardResult) + _extra_size);
         XCAM_ASSERT (_result);
         set_ptr ((void*) _result);
         _result->head.type = (XCam3aResultType) type;
@@ -116,7 +126,8 @@ public:
         _result->head.version = xcam_version ();
     }
     ~X3aStandardResultT () {
-        xcam_free (_result);
+        if (_result != &_inline_result)
+            xcam_free (_result);
     }
 
     void set_standard_result (StandardResult &res) {
@@ -143,6 +154,7 @@ public:
 private:
     StandardResult *_result;
     uint32_t        _extra_size;
+    StandardResult  _inline_result;
 };
 
 typedef X3aStandardResultT<XCam3aResultWhiteBalance>   X3aWhiteBalanceResult;
@@ -30,6 +30,11 @@ X3aStatsData::X3aStatsData (XCam3AStats *data)
     XCAM_ASSERT (_data);
 }
 
+X3aStatsData::X3aStatsData ()
+    : _data (NULL)
+{
+}
+
 X3aStatsData::~X3aStatsData ()
 {
     if (_data)
@@ -95,23 +100,33 @@ X3aStatsPool::fixate_video_info (VideoBufferInfo &info)
     return true;
 }
 
+uint32_t
+X3aStatsPool::get_stats_size (const XCam3AStatsInfo &info)
+{
+    return sizeof (XCam3AStats) +
+           sizeof (XCamHistogram) * info.histogram_bins +
+           sizeof (uint32_t) * info.histogram_bins +
+           sizeof (XCamGridStat) * info.aligned_width * info.aligned_height;
+}
+
+void
+X3aStatsPool::init_stats (XCam3AStats *stats, const XCam3AStatsInfo &info)
+{
+    XCAM_ASSERT (stats);
+    stats->info = info;
+    stats->hist_rgb = (XCamHistogram *) (stats->stats + info.aligned_width * info.aligned_height);
+    stats->hist_y = (uint32_t *) (stats->hist_rgb + info.histogram_bins);
+}
+
 SmartPtr<BufferData>
 X3aStatsPool::allocate_data (const VideoBufferInfo &buffer_info)
 {
     XCAM_UNUSED (buffer_info);
 
     XCam3AStats *stats = NULL;
-    stats =
-        (XCam3AStats *) xcam_malloc0 (
-            sizeof (XCam3AStats) +
-            sizeof (XCamHistogram) * _stats_info.histogram_bins +
-            sizeof (uint32_t) * _stats_info.histogram_bins +
-            sizeof (XCamGridStat) * _stats_info.aligned_width * _stats_info.aligned_height);
+    stats = (XCam3AStats *) xcam_malloc0 (get_stats_size (_stats_info));
     XCAM_ASSERT (stats);
-    stats->info = _stats_info;
-    stats->hist_rgb = (XCamHistogram *) (stats->stats +
-                                         _stats_info.aligned_width * _stats_info.aligned_height);
-    stats->hist_y = (uint32_t *) (stats->hist_rgb + _stats_info.histogram_bins);
+    init_stats (stats, _stats_info);
     return new X3aStatsData (stats);
 }
 
@@ -31,6 +31,7 @@ class X3aStatsData
     : public BufferData
 {
 public:
+    // data is freed by xcam_free
     explicit X3aStatsData (XCam3AStats *data);
     ~X3aStatsData ();
     XCam3AStats *get_stats () {
@@ -40,6 +41,14 @@ public:
     virtual uint8_t *map ();
     virtual bool unmap ();
 
+protected:
+    // for stats in memory owned by derived class, e.g. mapped device memory,
+    // derived class resets data to NULL before it is released
+    X3aStatsData ();
+    void set_stats (XCam3AStats *data) {
+        _data = data;
+    }
+
 private:
     XCAM_DEAD_COPY (X3aStatsData);
 private:
@@ -72,6 +81,11 @@ public:
     }
     void set_stats_info (const XCam3AStatsInfo &info);
 
+    // bytes of XCam3AStats with grids and histograms behind it
+    static uint32_t get_stats_size (const XCam3AStatsInfo &info);
+    // sets info and histogram pointers of stats in memory of get_stats_size
+    static void init_stats (XCam3AStats *stats, const XCam3AStatsInfo &info);
+
 protected:
     virtual bool fixate_video_info (VideoBufferInfo &info);
     virtual SmartPtr<BufferData> allocate_data (const VideoBufferInfo &buffer_info);
@@ -68,12 +68,20 @@ AnalyzerThread::loop ()
         XCAM_LOG_DEBUG ("analyzer thread got empty stats, stop thread");
         return false;
     }
-    //while ((latest_stats = _stats_queue.pop (0)).ptr ()) {
-    //    stats = latest_stats;
-    //    XCAM_LOG_WARNING ("lost 3a stats since 3a analyzer too slow");
-    //}
 
-    XCamReturn ret = _analyzer->analyze (stats);
+    uint32_t dropped = 0;
+    if (_analyzer->_latest_only) {
+        while ((latest_stats = _stats_queue.pop (0)).ptr ()) {
+            stats = latest_stats;
+            ++dropped;
+        }
+        if (dropped) {
+            XCAM_LOG_DEBUG (
+                "analyzer(%s) dropped %d stale stats", XCAM_STR(_analyzer->get_name()), dropped);
+        }
+    }
+
+    XCamReturn ret = _analyzer->process_stats (stats, dropped);
     if (ret == XCAM_RETURN_NO_ERROR || ret == XCAM_RETURN_BYPASS)
         return true;
 
@@ -114,6 +122,9 @@ XAnalyzer::XAnalyzer (const char *name)
     , _height (0)
     , _framerate (30.0)
     , _callback (NULL)
+    , _analysis_interval (1)
+    , _frames_since (0)
+    , _latest_only (false)
 {
     if (name)
         _name = strndup (name, XCAM_MAX_STR_SIZE);
@@ -192,9 +203,35 @@ XAnalyzer::set_sync_mode (bool sync)
     return XCAM_RETURN_NO_ERROR;
 }
 
+XCamReturn
+XAnalyzer::set_analysis_interval (uint32_t interval)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started && interval > 0, XCAM_RETURN_ERROR_PARAM,
+        "analyzer(%s) set analysis interval(%d) failed, %s",
+        XCAM_STR(get_name()), interval, (_started ? "already started" : "interval is 0"));
+
+    _analysis_interval = interval;
+    return XCAM_RETURN_NO_ERROR;
+}
+
+XCamReturn
+XAnalyzer::set_latest_stats_only (bool latest_only)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, !_started, XCAM_RETURN_ERROR_PARAM,
+        "analyzer(%s) can't set latest stats only after started", XCAM_STR(get_name()));
+
+    _latest_only = latest_only;
+    return XCAM_RETURN_NO_ERROR;
+}
+
 XCamReturn
 XAnalyzer::start ()
 {
+    // first stats after start are always analyzed
+    _frames_since = _analysis_interval - 1;
+
     if (_sync) {
         XCamReturn ret = configure ();
         if (ret != XCAM_RETURN_NO_ERROR) {
@@ -235,7 +272,7 @@ XAnalyzer::push_buffer (const SmartPtr<VideoBuffer> &buffer)
     XCamReturn ret = XCAM_RETURN_NO_ERROR;
 
     if (get_sync_mode ()) {
-        ret = analyze (buffer);
+        ret = process_stats (buffer, 0);
     }
     else {
         if (!_analyzer_thread->is_running())
@@ -248,6 +285,18 @@ XAnalyzer::push_buffer (const SmartPtr<VideoBuffer> &buffer)
     return ret;
 }
 
+XCamReturn
+XAnalyzer::process_stats (const SmartPtr<VideoBuffer> &buffer, uint32_t dropped)
+{
+    // dropped stats still count for the interval
+    _frames_since += dropped + 1;
+    if (_frames_since < _analysis_interval)
+        return skip (buffer, _frames_since);
+
+    _frames_since = 0;
+    return analyze (buffer);
+}
+
 void
 XAnalyzer::set_results_timestamp (X3aResultList &results, int64_t timestamp)
 {
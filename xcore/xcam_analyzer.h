@@ -86,6 +86,13 @@ public:
     bool get_sync_mode () const {
         return _sync;
     };
+    // analyzes one of every interval stats, others go to skip (); set before start
+    XCamReturn set_analysis_interval (uint32_t interval);
+    uint32_t get_analysis_interval () const {
+        return _analysis_interval;
+    }
+    // async mode only, drops queued stats once newer stats arrive
+    XCamReturn set_latest_stats_only (bool latest_only);
     XCamReturn start ();
     XCamReturn stop ();
     XCamReturn push_buffer (const SmartPtr<VideoBuffer> &buffer);
@@ -114,6 +121,12 @@ protected:
     // in analyzer thread
     virtual XCamReturn configure () = 0;
     virtual XCamReturn analyze (const SmartPtr<VideoBuffer> &buffer) = 0;
+    // stats between analyzed ones, frames_since is counted from the last analyzed stats
+    virtual XCamReturn skip (const SmartPtr<VideoBuffer> &buffer, uint32_t frames_since) {
+        XCAM_UNUSED (buffer);
+        XCAM_UNUSED (frames_since);
+        return XCAM_RETURN_BYPASS;
+    }
 
 protected:
     void notify_calculation_done (X3aResultList &results);
@@ -121,6 +134,7 @@ protected:
     void set_results_timestamp (X3aResultList &results, int64_t timestamp);
 
 private:
+    XCamReturn process_stats (const SmartPtr<VideoBuffer> &buffer, uint32_t dropped);
 
     XCAM_DEAD_COPY (XAnalyzer);
 
@@ -135,6 +149,9 @@ private:
     uint32_t                 _height;
     double                   _framerate;
     AnalyzerCallback        *_callback;
+    uint32_t                 _analysis_interval;
+    uint32_t                 _frames_since;
+    bool                     _latest_only;
 };
 
 }
@@ -62,6 +62,26 @@ xcam_video_buffer_info_reset (
         info->offsets [1] = info->offsets [0] + info->strides [0] * aligned_height;
         image_size = info->strides [0] * aligned_height + info->strides [1] * aligned_height / 2;
         break;
+    case V4L2_PIX_FMT_P010:
+        info->color_bits = 16;
+        info->components = 2;
+        info->strides [0] = aligned_width * 2;
+        info->strides [1] = info->strides [0];
+        info->offsets [0] = 0;
+        info->offsets [1] = info->offsets [0] + info->strides [0] * aligned_height;
+        image_size = info->strides [0] * aligned_height + info->strides [1] * aligned_height / 2;
+        break;
+    case V4L2_PIX_FMT_YUV420:
+        info->color_bits = 8;
+        info->components = 3;
+        info->strides [0] = aligned_width;
+        info->strides [1] = aligned_width / 2;
+        info->strides [2] = aligned_width / 2;
+        info->offsets [0] = 0;
+        info->offsets [1] = info->offsets [0] + info->strides [0] * aligned_height;
+        info->offsets [2] = info->offsets [1] + info->strides [1] * aligned_height / 2;
+        image_size = info->offsets [2] + info->strides [2] * aligned_height / 2;
+        break;
     case V4L2_PIX_FMT_YUYV:
         info->color_bits = 8;
         info->components = 1;
@@ -147,6 +167,28 @@ xcam_video_buffer_info_reset (
         image_size = info->strides [0] * aligned_height;
         break;
 
+    case V4L2_PIX_FMT_SBGGR10P:
+    case V4L2_PIX_FMT_SGBRG10P:
+    case V4L2_PIX_FMT_SGRBG10P:
+    case V4L2_PIX_FMT_SRGGB10P:
+        info->color_bits = 10;
+        info->components = 1;
+        info->strides [0] = XCAM_ALIGN_UP (aligned_width, 4) * 5 / 4;
+        info->offsets [0] = 0;
+        image_size = info->strides [0] * aligned_height;
+        break;
+
+    case V4L2_PIX_FMT_SBGGR12P:
+    case V4L2_PIX_FMT_SGBRG12P:
+    case V4L2_PIX_FMT_SGRBG12P:
+    case V4L2_PIX_FMT_SRGGB12P:
+        info->color_bits = 12;
+        info->components = 1;
+        info->strides [0] = XCAM_ALIGN_UP (aligned_width, 2) * 3 / 2;
+        info->offsets [0] = 0;
+        image_size = info->strides [0] * aligned_height;
+        break;
+
     case V4L2_PIX_FMT_SBGGR16:
     case XCAM_PIX_FMT_SGRBG16:
         info->color_bits = 16;
@@ -223,14 +265,22 @@ xcam_video_buffer_get_planar_info (
 
     switch (buf_info->format) {
     case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_P010:
         XCAM_ASSERT (index <= 1);
         if (index == 1) {
             planar_info->height = buf_info->height / 2;
         }
         break;
 
+    case V4L2_PIX_FMT_YUV420:
+        XCAM_ASSERT (index <= 2);
+        if (index >= 1) {
+            planar_info->width = buf_info->width / 2;
+            planar_info->height = buf_info->height / 2;
+        }
+        break;
+
     case V4L2_PIX_FMT_GREY:
-    case V4L2_PIX_FMT_YUYV:
     case V4L2_PIX_FMT_RGB565:
     case V4L2_PIX_FMT_SBGGR8:
     case V4L2_PIX_FMT_SGBRG8:
@@ -254,6 +304,31 @@ xcam_video_buffer_get_planar_info (
         planar_info->pixel_bytes = 3;
         break;
 
+    // two bytes per pixel, Y and one of U/V
+    case V4L2_PIX_FMT_YUYV:
+        XCAM_ASSERT (index <= 0);
+        planar_info->pixel_bytes = 2;
+        break;
+
+    // packed rows counted in bytes
+    case V4L2_PIX_FMT_SBGGR10P:
+    case V4L2_PIX_FMT_SGBRG10P:
+    case V4L2_PIX_FMT_SGRBG10P:
+    case V4L2_PIX_FMT_SRGGB10P:
+        XCAM_ASSERT (index <= 0);
+        planar_info->width = XCAM_ALIGN_UP (buf_info->width, 4) * 5 / 4;
+        planar_info->pixel_bytes = 1;
+        break;
+
+    case V4L2_PIX_FMT_SBGGR12P:
+    case V4L2_PIX_FMT_SGBRG12P:
+    case V4L2_PIX_FMT_SGRBG12P:
+    case V4L2_PIX_FMT_SRGGB12P:
+        XCAM_ASSERT (index <= 0);
+        planar_info->width = XCAM_ALIGN_UP (buf_info->width, 2) * 3 / 2;
+        planar_info->pixel_bytes = 1;
+        break;
+
     case V4L2_PIX_FMT_RGBA32:
     case V4L2_PIX_FMT_XBGR32:
     case V4L2_PIX_FMT_ABGR32:
@@ -27,9 +27,49 @@
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <stdarg.h>
+#include <time.h>
+#include <atomic>
+
+#define XCAM_LOG_RING_CAPACITY 128
+#define XCAM_LOG_RING_MASK (XCAM_LOG_RING_CAPACITY - 1)
+#define XCAM_LOG_MSG_SIZE 512
+// threads beyond it log synchronously
+#define XCAM_LOG_MAX_RINGS 64
+#define XCAM_LOG_FLUSH_INTERVAL 10 // ms
+#define XCAM_LOG_ASYNC_ENV_VAR "XCAM_LOG_ASYNC"
 
 static char log_file_name[XCAM_MAX_STR_SIZE] = {0};
 
+static_assert ((XCAM_LOG_RING_CAPACITY & XCAM_LOG_RING_MASK) == 0, "log ring capacity must be power of 2");
+
+/*
+ * messages of one thread, only the owner writes and only the drain reads.
+ * rings are never freed, ones of exited threads are reused once drained.
+ */
+struct XCamLogRing {
+    char                    msgs[XCAM_LOG_RING_CAPACITY][XCAM_LOG_MSG_SIZE];
+    std::atomic<uint32_t>   write;
+    std::atomic<uint32_t>   read;
+    std::atomic<uint32_t>   dropped;
+    std::atomic<bool>       in_use;
+
+    XCamLogRing () : write (0), read (0), dropped (0), in_use (true) {}
+};
+
+static std::atomic<bool> log_async (false);
+static XCamLogRing *log_rings[XCAM_LOG_MAX_RINGS];
+static std::atomic<uint32_t> log_ring_count (0);
+static pthread_mutex_t log_rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t log_drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t log_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_ring_key;
+static __thread XCamLogRing *tls_log_ring = NULL;
+
+static pthread_mutex_t log_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_thread_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t log_thread;
+static bool log_thread_running = false;
+
 uint32_t xcam_version ()
 {
     return XCAM_VERSION;
@@ -90,7 +130,198 @@ xcam_fourcc_to_string (uint32_t fourcc)
     return str;
 }
 
+static void
+release_log_ring (void *ring)
+{
+    tls_log_ring = NULL;
+    ((XCamLogRing *) ring)->in_use.store (false, std::memory_order_release);
+}
+
+static void
+create_log_ring_key ()
+{
+    pthread_key_create (&log_ring_key, release_log_ring);
+}
+
+static XCamLogRing *
+get_log_ring ()
+{
+    if (tls_log_ring)
+        return tls_log_ring;
+
+    pthread_once (&log_key_once, create_log_ring_key);
+
+    XCamLogRing *ring = NULL;
+    pthread_mutex_lock (&log_rings_mutex);
+    uint32_t count = log_ring_count.load (std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i) {
+        XCamLogRing *free_ring = log_rings[i];
+        if (!free_ring->in_use.load (std::memory_order_acquire) &&
+                free_ring->read.load (std::memory_order_acquire) == free_ring->write.load (std::memory_order_relaxed)) {
+            free_ring->in_use.store (true, std::memory_order_relaxed);
+            ring = free_ring;
+            break;
+        }
+    }
+    if (!ring && count < XCAM_LOG_MAX_RINGS) {
+        ring = new XCamLogRing;
+        log_rings[count] = ring;
+        log_ring_count.store (count + 1, std::memory_order_release);
+    }
+    pthread_mutex_unlock (&log_rings_mutex);
+
+    if (ring) {
+        pthread_setspecific (log_ring_key, ring);
+        tls_log_ring = ring;
+    }
+    return ring;
+}
+
+// false if calling thread has no ring
+static bool
+push_log_async (const char *format, va_list args)
+{
+    XCamLogRing *ring = get_log_ring ();
+    if (!ring)
+        return false;
+
+    uint32_t pos = ring->write.load (std::memory_order_relaxed);
+    if (pos - ring->read.load (std::memory_order_acquire) >= XCAM_LOG_RING_CAPACITY) {
+        ring->dropped.fetch_add (1, std::memory_order_relaxed);
+        return true;
+    }
+
+    char *msg = ring->msgs[pos & XCAM_LOG_RING_MASK];
+    int len = vsnprintf (msg, XCAM_LOG_MSG_SIZE, format, args);
+    if (len >= XCAM_LOG_MSG_SIZE)
+        msg[XCAM_LOG_MSG_SIZE - 2] = '\n';
+    ring->write.store (pos + 1, std::memory_order_release);
+
+    // wake log thread early on bursts, cond signal without mutex may be missed but never blocks
+    if (pos - ring->read.load (std::memory_order_relaxed) == XCAM_LOG_RING_CAPACITY / 2)
+        pthread_cond_signal (&log_thread_cond);
+    return true;
+}
+
+void xcam_flush_log () {
+    pthread_mutex_lock (&log_drain_mutex);
+
+    FILE *file = NULL;
+    uint32_t count = log_ring_count.load (std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i) {
+        XCamLogRing *ring = log_rings[i];
+        uint32_t end = ring->write.load (std::memory_order_acquire);
+        uint32_t pos = ring->read.load (std::memory_order_relaxed);
+        uint32_t dropped = ring->dropped.exchange (0, std::memory_order_relaxed);
+        if (pos == end && !dropped)
+            continue;
+
+        // open once for all pending messages instead of once per message
+        if (!file && strlen (log_file_name) > 0)
+            file = fopen (log_file_name, "ab+");
+        FILE *out = file ? file : stdout;
+
+        if (dropped)
+            fprintf (out, "XCAM WARNING async log ring full, %u messages dropped\n", dropped);
+        for (; pos != end; ++pos)
+            fputs (ring->msgs[pos & XCAM_LOG_RING_MASK], out);
+        ring->read.store (end, std::memory_order_release);
+    }
+
+    if (file)
+        fclose (file);
+    else
+        fflush (stdout);
+
+    pthread_mutex_unlock (&log_drain_mutex);
+}
+
+static void *
+log_thread_func (void *data)
+{
+    XCAM_UNUSED (data);
+
+    pthread_mutex_lock (&log_thread_mutex);
+    while (log_thread_running) {
+        pthread_mutex_unlock (&log_thread_mutex);
+        xcam_flush_log ();
+        pthread_mutex_lock (&log_thread_mutex);
+        if (!log_thread_running)
+            break;
+
+        struct timespec ts;
+        clock_gettime (CLOCK_REALTIME, &ts);
+        ts.tv_nsec += XCAM_LOG_FLUSH_INTERVAL * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait (&log_thread_cond, &log_thread_mutex, &ts);
+    }
+    pthread_mutex_unlock (&log_thread_mutex);
+
+    return NULL;
+}
+
+static void
+stop_log_thread_at_exit ()
+{
+    xcam_set_log_async (0);
+}
+
+void xcam_set_log_async (int enable) {
+    static bool exit_registered = false;
+
+    pthread_mutex_lock (&log_thread_mutex);
+    if (enable && !log_thread_running) {
+        if (pthread_create (&log_thread, NULL, log_thread_func, NULL) == 0) {
+            log_thread_running = true;
+            log_async.store (true, std::memory_order_relaxed);
+            if (!exit_registered) {
+                atexit (stop_log_thread_at_exit);
+                exit_registered = true;
+            }
+        }
+        pthread_mutex_unlock (&log_thread_mutex);
+        return;
+    }
+
+    if (!enable && log_thread_running) {
+        log_async.store (false, std::memory_order_relaxed);
+        log_thread_running = false;
+        pthread_cond_signal (&log_thread_cond);
+        pthread_mutex_unlock (&log_thread_mutex);
+
+        pthread_join (log_thread, NULL);
+        xcam_flush_log ();
+        return;
+    }
+    pthread_mutex_unlock (&log_thread_mutex);
+}
+
+static bool
+init_log_async_from_env ()
+{
+    const char *env = getenv (XCAM_LOG_ASYNC_ENV_VAR);
+    if (!env || strcmp (env, "1"))
+        return false;
+
+    xcam_set_log_async (1);
+    return true;
+}
+
+static bool log_async_from_env = init_log_async_from_env ();
+
 void xcam_print_log (const char* format, ...) {
+    if (log_async.load (std::memory_order_relaxed)) {
+        va_list args;
+        va_start (args, format);
+        bool pushed = push_log_async (format, args);
+        va_end (args);
+        if (pushed)
+            return;
+    }
+
     char buffer[XCAM_MAX_STR_SIZE] = {0};
 
     va_list va_list;
@@ -21,6 +21,7 @@
 #include "xcam_thread.h"
 #include "xcam_mutex.h"
 #include <errno.h>
+#include <sched.h>
 
 namespace XCam {
 
@@ -110,9 +111,54 @@ bool Thread::start ()
     }
 #endif
 
+    // new thread waits on _mutex in thread_func, so it runs under the policy from the start
+    apply_policy_unsafe ();
+
     return true;
 }
 
+void
+Thread::set_policy (const ThreadPolicy &policy)
+{
+    SmartLock locker(_mutex);
+    _policy = policy;
+}
+
+void
+Thread::apply_policy_unsafe ()
+{
+    int ret = 0;
+
+#ifdef __USE_GNU
+    if (_policy.cpu_mask) {
+        cpu_set_t cpu_set;
+        CPU_ZERO (&cpu_set);
+        for (uint32_t i = 0; i < 64 && i < CPU_SETSIZE; ++i) {
+            if (_policy.cpu_mask & (1ULL << i))
+                CPU_SET (i, &cpu_set);
+        }
+        ret = pthread_setaffinity_np (_thread_id, sizeof (cpu_set), &cpu_set);
+        if (ret != 0) {
+            XCAM_LOG_WARNING (
+                "Thread(%s) set affinity(0x%" PRIx64 ") failed.(%d, %s)",
+                XCAM_STR(_name), _policy.cpu_mask, ret, strerror(ret));
+        }
+    }
+#endif
+
+    if (_policy.sched_policy != SCHED_OTHER || _policy.priority) {
+        struct sched_param param;
+        xcam_mem_clear (param);
+        param.sched_priority = _policy.priority;
+        ret = pthread_setschedparam (_thread_id, _policy.sched_policy, &param);
+        if (ret != 0) {
+            XCAM_LOG_WARNING (
+                "Thread(%s) set sched policy:%d priority:%d failed.(%d, %s)",
+                XCAM_STR(_name), _policy.sched_policy, _policy.priority, ret, strerror(ret));
+        }
+    }
+}
+
 bool
 Thread::emit_stop ()
 {
@@ -26,6 +26,23 @@
 
 namespace XCam {
 
+/*
+ * scheduling of a thread, applied when it starts.
+ * bit n of cpu_mask allows cpu n, 0 keeps the inherited affinity.
+ * SCHED_FIFO/SCHED_RR with priority need CAP_SYS_NICE, failures only warn.
+ */
+struct ThreadPolicy {
+    uint64_t    cpu_mask;
+    int32_t     sched_policy;
+    int32_t     priority;
+
+    ThreadPolicy ()
+        : cpu_mask (0)
+        , sched_policy (SCHED_OTHER)
+        , priority (0)
+    {}
+};
+
 class Thread {
 public:
     Thread (const char *name = NULL);
@@ -39,6 +56,12 @@ public:
         return _name;
     }
 
+    // takes effect on next start
+    void set_policy (const ThreadPolicy &policy);
+    const ThreadPolicy &get_policy () const {
+        return _policy;
+    }
+
 protected:
     // return true to start loop, else the thread stopped
     virtual bool started ();
@@ -51,6 +74,7 @@ private:
 
 private:
     static int thread_func (void *user_data);
+    void apply_policy_unsafe ();
 
 private:
     char           *_name;
@@ -59,6 +83,7 @@ private:
     XCam::Cond      _exit_cond;
     bool            _started;
     bool            _stopped;
+    ThreadPolicy    _policy;
 };
 
 };
@@ -0,0 +1,298 @@
+/*
+ * xcam_trace.cpp - runtime per-stage latency tracing
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#include "xcam_trace.h"
+#include "xcam_mutex.h"
+#include "file_handle.h"
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define XCAM_TRACE_RING_MASK (XCAM_TRACE_RING_CAPACITY - 1)
+#define XCAM_TRACE_THREAD_NAME_SIZE 16
+// tracks are exported as threads with ids above real ones
+#define XCAM_TRACE_TRACK_TID_BASE 0x40000000u
+
+namespace XCam {
+
+static_assert ((XCAM_TRACE_RING_CAPACITY & XCAM_TRACE_RING_MASK) == 0, "trace ring capacity must be power of 2");
+
+struct TraceEvent {
+    char        name[XCAM_TRACE_NAME_SIZE];
+    int64_t     ts;
+    int64_t     frame_ts;
+    int64_t     dur;
+    char        phase;
+};
+
+/*
+ * only the owner thread writes, export reads up to the published write position.
+ * rings are never freed, threads of pools may still run at exit.
+ */
+class TraceRing {
+public:
+    TraceRing ()
+        : _write (0)
+        , _start (0)
+        , _frame_ts (InvalidTimestamp)
+    {
+        _tid = (uint32_t) syscall (SYS_gettid);
+        xcam_mem_clear (_thread_name);
+        if (pthread_getname_np (pthread_self (), _thread_name, sizeof (_thread_name)) != 0)
+            _thread_name[0] = '\0';
+    }
+
+    void push (char phase, const char *name, int64_t ts, int64_t frame_ts, int64_t dur = 0) {
+        uint64_t pos = _write.load (std::memory_order_relaxed);
+        TraceEvent &event = _events[pos & XCAM_TRACE_RING_MASK];
+        strncpy (event.name, XCAM_STR (name), XCAM_TRACE_NAME_SIZE - 1);
+        event.name[XCAM_TRACE_NAME_SIZE - 1] = '\0';
+        event.ts = ts;
+        event.frame_ts = frame_ts;
+        event.dur = dur;
+        event.phase = phase;
+        _write.store (pos + 1, std::memory_order_release);
+    }
+
+    TraceEvent         _events[XCAM_TRACE_RING_CAPACITY];
+    std::atomic<uint64_t>  _write;
+    std::atomic<uint64_t>  _start;
+    uint32_t           _tid;
+    char               _thread_name[XCAM_TRACE_THREAD_NAME_SIZE];
+
+    // frame timestamp stack of nested scopes
+    int64_t            _frame_ts;
+    std::vector<int64_t> _frame_ts_stack;
+};
+
+static __thread TraceRing *tls_trace_ring = NULL;
+
+static Mutex &
+get_rings_mutex ()
+{
+    static Mutex *mutex = new Mutex;
+    return *mutex;
+}
+
+static std::vector<TraceRing *> &
+get_rings ()
+{
+    static std::vector<TraceRing *> *rings = new std::vector<TraceRing *>;
+    return *rings;
+}
+
+static TraceRing *
+get_thread_ring ()
+{
+    if (!tls_trace_ring) {
+        TraceRing *ring = new TraceRing;
+        SmartLock locker (get_rings_mutex ());
+        get_rings ().push_back (ring);
+        tls_trace_ring = ring;
+    }
+    return tls_trace_ring;
+}
+
+static int64_t
+get_trace_time ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return XCAM_TIMESPEC_2_USEC (ts);
+}
+
+// track rings are written by any thread under the rings mutex
+static TraceRing *
+get_track_ring_unsafe (const char *track)
+{
+    static std::vector<TraceRing *> *tracks = new std::vector<TraceRing *>;
+    for (size_t i = 0; i < tracks->size (); ++i) {
+        if (!strncmp ((*tracks)[i]->_thread_name, track, XCAM_TRACE_THREAD_NAME_SIZE - 1))
+            return (*tracks)[i];
+    }
+
+    TraceRing *ring = new TraceRing;
+    ring->_tid = XCAM_TRACE_TRACK_TID_BASE + tracks->size ();
+    strncpy (ring->_thread_name, track, XCAM_TRACE_THREAD_NAME_SIZE - 1);
+    ring->_thread_name[XCAM_TRACE_THREAD_NAME_SIZE - 1] = '\0';
+    tracks->push_back (ring);
+    get_rings ().push_back (ring);
+    return ring;
+}
+
+static const char *
+get_env_trace_file ()
+{
+    const char *file_name = getenv (XCAM_TRACE_ENV_VAR);
+    return (file_name && file_name[0]) ? file_name : NULL;
+}
+
+static void
+export_trace_at_exit ()
+{
+    Tracer::export_chrome_trace (get_env_trace_file ());
+}
+
+static bool
+init_enabled_from_env ()
+{
+    if (!get_env_trace_file ())
+        return false;
+
+    atexit (export_trace_at_exit);
+    return true;
+}
+
+std::atomic<bool> Tracer::_enabled (init_enabled_from_env ());
+
+void
+Tracer::begin (const char *name, int64_t frame_ts)
+{
+    TraceRing *ring = get_thread_ring ();
+
+    ring->_frame_ts_stack.push_back (ring->_frame_ts);
+    if (frame_ts != InvalidTimestamp)
+        ring->_frame_ts = frame_ts;
+
+    ring->push ('B', name, get_trace_time (), ring->_frame_ts);
+}
+
+void
+Tracer::end (const char *name)
+{
+    TraceRing *ring = get_thread_ring ();
+    ring->push ('E', name, get_trace_time (), ring->_frame_ts);
+
+    if (!ring->_frame_ts_stack.empty ()) {
+        ring->_frame_ts = ring->_frame_ts_stack.back ();
+        ring->_frame_ts_stack.pop_back ();
+    }
+}
+
+int64_t
+Tracer::get_frame_ts ()
+{
+    return tls_trace_ring ? tls_trace_ring->_frame_ts : InvalidTimestamp;
+}
+
+void
+Tracer::add_complete (const char *track, const char *name, int64_t ts, int64_t dur, int64_t frame_ts)
+{
+    XCAM_ASSERT (track && track[0]);
+    SmartLock locker (get_rings_mutex ());
+    get_track_ring_unsafe (track)->push ('X', name, ts, frame_ts, dur);
+}
+
+int64_t
+Tracer::now ()
+{
+    return get_trace_time ();
+}
+
+void
+Tracer::clear ()
+{
+    SmartLock locker (get_rings_mutex ());
+    std::vector<TraceRing *> &rings = get_rings ();
+    for (size_t i = 0; i < rings.size (); ++i)
+        rings[i]->_start.store (rings[i]->_write.load (std::memory_order_acquire));
+}
+
+static void
+write_json_string (FileHandle &file, const char *str)
+{
+    char buf[XCAM_TRACE_NAME_SIZE + 2];
+    uint32_t len = 0;
+
+    buf[len++] = '"';
+    for (; *str && len < XCAM_TRACE_NAME_SIZE; ++str)
+        buf[len++] = (*str == '"' || *str == '\\' || (uint8_t)*str < 0x20) ? '_' : *str;
+    buf[len++] = '"';
+    file.write_file (buf, len);
+}
+
+XCamReturn
+Tracer::export_chrome_trace (const char *file_name)
+{
+    XCAM_FAIL_RETURN (
+        ERROR, file_name, XCAM_RETURN_ERROR_PARAM,
+        "export trace failed, file name is empty");
+
+    FileHandle file;
+    XCamReturn ret = file.open (file_name, "wb");
+    XCAM_FAIL_RETURN (
+        ERROR, xcam_ret_is_ok (ret), ret,
+        "export trace failed, open %s failed", file_name);
+
+    char line[256];
+    int len = 0;
+    uint32_t pid = (uint32_t) getpid ();
+    bool first = true;
+
+    const char *head = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    file.write_file (head, strlen (head));
+
+    SmartLock locker (get_rings_mutex ());
+    std::vector<TraceRing *> &rings = get_rings ();
+    for (size_t i = 0; i < rings.size (); ++i) {
+        TraceRing *ring = rings[i];
+
+        if (ring->_thread_name[0]) {
+            len = snprintf (
+                line, sizeof (line), "%s\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %u, \"tid\": %u, \"args\": {\"name\": ",
+                first ? "" : ",", pid, ring->_tid);
+            file.write_file (line, len);
+            write_json_string (file, ring->_thread_name);
+            file.write_file ("}}", 2);
+            first = false;
+        }
+
+        uint64_t end = ring->_write.load (std::memory_order_acquire);
+        uint64_t begin = ring->_start.load (std::memory_order_relaxed);
+        if (end - begin > XCAM_TRACE_RING_CAPACITY)
+            begin = end - XCAM_TRACE_RING_CAPACITY;
+
+        for (uint64_t pos = begin; pos < end; ++pos) {
+            const TraceEvent &event = ring->_events[pos & XCAM_TRACE_RING_MASK];
+            len = snprintf (line, sizeof (line), "%s\n{\"name\": ", first ? "" : ",");
+            file.write_file (line, len);
+            write_json_string (file, event.name);
+            len = snprintf (line, sizeof (line), ", \"ph\": \"%c\", \"ts\": %" PRId64, event.phase, event.ts);
+            // complete events carry their duration
+            if (event.phase == 'X')
+                len += snprintf (line + len, sizeof (line) - len, ", \"dur\": %" PRId64, event.dur);
+            len += snprintf (
+                line + len, sizeof (line) - len,
+                ", \"pid\": %u, \"tid\": %u, \"args\": {\"frame_ts\": %" PRId64 "}}",
+                pid, ring->_tid, event.frame_ts);
+            file.write_file (line, len);
+            first = false;
+        }
+    }
+
+    const char *tail = "\n]}\n";
+    file.write_file (tail, strlen (tail));
+    XCAM_LOG_INFO ("trace exported to %s", file_name);
+
+    return XCAM_RETURN_NO_ERROR;
+}
+
+};
@@ -0,0 +1,96 @@
+/*
+ * xcam_trace.h - runtime per-stage latency tracing
+ *
+ *  Copyright (c) 2026 agent
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: agent <agent@local>
+ */
+
+#ifndef XCAM_TRACE_H
+#define XCAM_TRACE_H
+
+#include <xcam_std.h>
+#include <atomic>
+
+// events kept per thread, older ones are overwritten
+#define XCAM_TRACE_RING_CAPACITY 4096
+#define XCAM_TRACE_NAME_SIZE 40
+
+// setting env XCAM_TRACE to a file name enables tracing and exports to it at exit
+#define XCAM_TRACE_ENV_VAR "XCAM_TRACE"
+
+namespace XCam {
+
+/*
+ * Tracer, begin/end events of processing stages.
+ * Every thread writes its own ring without locks, it costs one atomic load when disabled.
+ * frame_ts is the timestamp of the frame in process, InvalidTimestamp means
+ * the one of the enclosing scope on this thread.
+ */
+class Tracer {
+public:
+    static void enable (bool enable) {
+        _enabled.store (enable, std::memory_order_relaxed);
+    }
+    static bool is_enabled () {
+        return _enabled.load (std::memory_order_relaxed);
+    }
+
+    static void begin (const char *name, int64_t frame_ts = InvalidTimestamp);
+    static void end (const char *name);
+    static int64_t get_frame_ts ();
+
+    // event of @dur microseconds on @track, such as a device queue, from any thread
+    static void add_complete (const char *track, const char *name, int64_t ts, int64_t dur, int64_t frame_ts);
+    // monotonic time in microseconds events are stamped with
+    static int64_t now ();
+
+    // Chrome trace event format, also loaded by Perfetto UI
+    // events written during export may be torn, export when processing is idle
+    static XCamReturn export_chrome_trace (const char *file_name);
+    static void clear ();
+
+private:
+    static std::atomic<bool>   _enabled;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope (const char *name, int64_t frame_ts = InvalidTimestamp)
+        : _name (NULL)
+    {
+        if (Tracer::is_enabled ()) {
+            _name = name;
+            Tracer::begin (name, frame_ts);
+        }
+    }
+    ~TraceScope () {
+        if (_name)
+            Tracer::end (_name);
+    }
+
+private:
+    XCAM_DEAD_COPY (TraceScope);
+
+private:
+    const char   *_name;
+};
+
+#define XCAM_TRACE_SCOPE(name, frame_ts) \
+    ::XCam::TraceScope xcam_trace_scope ((name), (frame_ts))
+
+};
+
+#endif //XCAM_TRACE_H